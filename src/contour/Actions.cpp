@@ -50,7 +50,11 @@ optional<Action> fromString(string const& _name)
         mapAction<actions::CopySelection>("CopySelection"),
         mapAction<actions::DecreaseFontSize>("DecreaseFontSize"),
         mapAction<actions::DecreaseOpacity>("DecreaseOpacity"),
+        mapAction<actions::DumpCacheStatistics>("DumpCacheStatistics"),
+        mapAction<actions::DumpMemoryUsage>("DumpMemoryUsage"),
+        mapAction<actions::FocusNextPane>("FocusNextPane"),
         mapAction<actions::FollowHyperlink>("FollowHyperlink"),
+        mapAction<actions::HintMode>("HintMode"),
         mapAction<actions::IncreaseFontSize>("IncreaseFontSize"),
         mapAction<actions::IncreaseOpacity>("IncreaseOpacity"),
         mapAction<actions::NewTerminal>("NewTerminal"),
@@ -62,6 +66,7 @@ optional<Action> fromString(string const& _name)
         mapAction<actions::ReloadConfig>("ReloadConfig"),
         mapAction<actions::ResetConfig>("ResetConfig"),
         mapAction<actions::ResetFontSize>("ResetFontSize"),
+        mapAction<actions::RunBenchmark>("RunBenchmark"),
         mapAction<actions::ScreenshotVT>("ScreenshotVT"),
         mapAction<actions::ScrollDown>("ScrollDown"),
         mapAction<actions::ScrollMarkDown>("ScrollMarkDown"),
@@ -74,8 +79,11 @@ optional<Action> fromString(string const& _name)
         mapAction<actions::ScrollToTop>("ScrollToTop"),
         mapAction<actions::ScrollUp>("ScrollUp"),
         mapAction<actions::SendChars>("SendChars"),
+        mapAction<actions::SplitHorizontally>("SplitHorizontally"),
+        mapAction<actions::SplitVertically>("SplitVertically"),
         mapAction<actions::ToggleAllKeyMaps>("ToggleAllKeyMaps"),
         mapAction<actions::ToggleFullscreen>("ToggleFullscreen"),
+        mapAction<actions::ToggleMetricsOverlay>("ToggleMetricsOverlay"),
         mapAction<actions::ToggleTitleBar>("ToggleTitleBar"),
         mapAction<actions::ViNormalMode>("ViNormalMode"),
         mapAction<actions::WriteScreen>("WriteScreen"),
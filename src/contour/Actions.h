@@ -30,7 +30,11 @@ struct CopyPreviousMarkRange{};
 struct CopySelection{};
 struct DecreaseFontSize{};
 struct DecreaseOpacity{};
+struct DumpCacheStatistics{};
+struct DumpMemoryUsage{};
+struct FocusNextPane{};
 struct FollowHyperlink{};
+struct HintMode{};
 struct IncreaseFontSize{};
 struct IncreaseOpacity{};
 struct NewTerminal{ std::optional<std::string> profileName; };
@@ -42,6 +46,7 @@ struct Quit{};
 struct ReloadConfig{ std::optional<std::string> profileName; };
 struct ResetConfig{};
 struct ResetFontSize{};
+struct RunBenchmark{};
 struct ScreenshotVT{};
 struct ScrollDown{};
 struct ScrollMarkDown{};
@@ -54,8 +59,11 @@ struct ScrollToBottom{};
 struct ScrollToTop{};
 struct ScrollUp{};
 struct SendChars{ std::string chars; };
+struct SplitHorizontally{};
+struct SplitVertically{};
 struct ToggleAllKeyMaps{};
 struct ToggleFullscreen{};
+struct ToggleMetricsOverlay{};
 struct ToggleTitleBar{};
 struct ViNormalMode{};
 struct WriteScreen{ std::string chars; }; // "\033[2J\033[3J"
@@ -72,7 +80,11 @@ using Action = std::variant<CancelSelection,
                             CopySelection,
                             DecreaseFontSize,
                             DecreaseOpacity,
+                            DumpCacheStatistics,
+                            DumpMemoryUsage,
+                            FocusNextPane,
                             FollowHyperlink,
+                            HintMode,
                             IncreaseFontSize,
                             IncreaseOpacity,
                             NewTerminal,
@@ -84,6 +96,7 @@ using Action = std::variant<CancelSelection,
                             ReloadConfig,
                             ResetConfig,
                             ResetFontSize,
+                            RunBenchmark,
                             ScreenshotVT,
                             ScrollDown,
                             ScrollMarkDown,
@@ -96,8 +109,11 @@ using Action = std::variant<CancelSelection,
                             ScrollToTop,
                             ScrollUp,
                             SendChars,
+                            SplitHorizontally,
+                            SplitVertically,
                             ToggleAllKeyMaps,
                             ToggleFullscreen,
+                            ToggleMetricsOverlay,
                             ToggleTitleBar,
                             ViNormalMode,
                             WriteScreen>;
@@ -133,7 +149,11 @@ DECLARE_ACTION_FMT(CopyPreviousMarkRange)
 DECLARE_ACTION_FMT(CopySelection)
 DECLARE_ACTION_FMT(DecreaseFontSize)
 DECLARE_ACTION_FMT(DecreaseOpacity)
+DECLARE_ACTION_FMT(DumpCacheStatistics)
+DECLARE_ACTION_FMT(DumpMemoryUsage)
+DECLARE_ACTION_FMT(FocusNextPane)
 DECLARE_ACTION_FMT(FollowHyperlink)
+DECLARE_ACTION_FMT(HintMode)
 DECLARE_ACTION_FMT(IncreaseFontSize)
 DECLARE_ACTION_FMT(IncreaseOpacity)
 DECLARE_ACTION_FMT(NewTerminal)
@@ -145,6 +165,7 @@ DECLARE_ACTION_FMT(Quit)
 DECLARE_ACTION_FMT(ReloadConfig)
 DECLARE_ACTION_FMT(ResetConfig)
 DECLARE_ACTION_FMT(ResetFontSize)
+DECLARE_ACTION_FMT(RunBenchmark)
 DECLARE_ACTION_FMT(ScreenshotVT)
 DECLARE_ACTION_FMT(ScrollDown)
 DECLARE_ACTION_FMT(ScrollMarkDown)
@@ -157,8 +178,11 @@ DECLARE_ACTION_FMT(ScrollToBottom)
 DECLARE_ACTION_FMT(ScrollToTop)
 DECLARE_ACTION_FMT(ScrollUp)
 DECLARE_ACTION_FMT(SendChars)
+DECLARE_ACTION_FMT(SplitHorizontally)
+DECLARE_ACTION_FMT(SplitVertically)
 DECLARE_ACTION_FMT(ToggleAllKeyMaps)
 DECLARE_ACTION_FMT(ToggleFullscreen)
+DECLARE_ACTION_FMT(ToggleMetricsOverlay)
 DECLARE_ACTION_FMT(ToggleTitleBar)
 DECLARE_ACTION_FMT(ViNormalMode)
 DECLARE_ACTION_FMT(WriteScreen)
@@ -192,7 +216,11 @@ struct formatter<contour::actions::Action>
         HANDLE_ACTION(CopySelection);
         HANDLE_ACTION(DecreaseFontSize);
         HANDLE_ACTION(DecreaseOpacity);
+        HANDLE_ACTION(DumpCacheStatistics);
+        HANDLE_ACTION(DumpMemoryUsage);
+        HANDLE_ACTION(FocusNextPane);
         HANDLE_ACTION(FollowHyperlink);
+        HANDLE_ACTION(HintMode);
         HANDLE_ACTION(IncreaseFontSize);
         HANDLE_ACTION(IncreaseOpacity);
         HANDLE_ACTION(NewTerminal);
@@ -204,6 +232,7 @@ struct formatter<contour::actions::Action>
         HANDLE_ACTION(ReloadConfig);
         HANDLE_ACTION(ResetConfig);
         HANDLE_ACTION(ResetFontSize);
+        HANDLE_ACTION(RunBenchmark);
         HANDLE_ACTION(ScreenshotVT);
         HANDLE_ACTION(ScrollDown);
         HANDLE_ACTION(ScrollMarkDown);
@@ -216,8 +245,11 @@ struct formatter<contour::actions::Action>
         HANDLE_ACTION(ScrollToTop);
         HANDLE_ACTION(ScrollUp);
         HANDLE_ACTION(SendChars);
+        HANDLE_ACTION(SplitHorizontally);
+        HANDLE_ACTION(SplitVertically);
         HANDLE_ACTION(ToggleAllKeyMaps);
         HANDLE_ACTION(ToggleFullscreen);
+        HANDLE_ACTION(ToggleMetricsOverlay);
         HANDLE_ACTION(ToggleTitleBar);
         HANDLE_ACTION(ViNormalMode);
         HANDLE_ACTION(WriteScreen);
@@ -0,0 +1,161 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/Clipboard.h>
+#include <contour/helper.h>
+
+#include <QtGui/QGuiApplication>
+
+#include <exception>
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+
+namespace contour
+{
+
+namespace
+{
+    auto const Utf8MimeType = QStringLiteral("text/plain;charset=utf-8");
+    auto const TextMimeType = QStringLiteral("text/plain");
+
+    void setMimeData(QClipboard::Mode _mode, shared_ptr<ClipboardBuffer const> _buffer)
+    {
+        QClipboard* clipboard = QGuiApplication::clipboard();
+        if (!clipboard)
+            SessionLog()("Could not access clipboard.");
+        else if (_mode != QClipboard::Selection || clipboard->supportsSelection())
+            clipboard->setMimeData(new ClipboardMimeData(std::move(_buffer)), _mode);
+    }
+} // namespace
+
+// {{{ ClipboardBuffer
+void ClipboardBuffer::append(string_view _chunk)
+{
+    auto const _ = std::lock_guard { lock_ };
+    if (!cancelled_)
+        text_ += _chunk;
+}
+
+void ClipboardBuffer::finish()
+{
+    {
+        auto const _ = std::lock_guard { lock_ };
+        finished_ = true;
+    }
+    completed_.notify_all();
+}
+
+void ClipboardBuffer::cancel()
+{
+    auto const _ = std::lock_guard { lock_ };
+    cancelled_ = true;
+}
+
+bool ClipboardBuffer::finished() const
+{
+    auto const _ = std::lock_guard { lock_ };
+    return finished_;
+}
+
+string const& ClipboardBuffer::wait() const
+{
+    auto lock = std::unique_lock { lock_ };
+    completed_.wait(lock, [this]() { return finished_; });
+    return text_;
+}
+// }}}
+
+// {{{ ClipboardMimeData
+ClipboardMimeData::ClipboardMimeData(shared_ptr<ClipboardBuffer const> _buffer):
+    buffer_ { std::move(_buffer) }
+{
+}
+
+QStringList ClipboardMimeData::formats() const
+{
+    return QStringList { Utf8MimeType, TextMimeType };
+}
+
+bool ClipboardMimeData::hasFormat(QString const& _mimeType) const
+{
+    return _mimeType == Utf8MimeType || _mimeType == TextMimeType;
+}
+
+QVariant ClipboardMimeData::retrieveData(QString const& _mimeType, RetrieveType _type) const
+{
+    if (!hasFormat(_mimeType))
+        return QMimeData::retrieveData(_mimeType, _type);
+
+    auto const& text = buffer_->wait();
+    if (_mimeType == Utf8MimeType)
+        return QByteArray(text.data(), static_cast<int>(text.size()));
+
+    if (!text_)
+        text_ = QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+    return *text_;
+}
+// }}}
+
+// {{{ ClipboardWriter
+ClipboardWriter::~ClipboardWriter()
+{
+    for (Job& job: jobs_)
+    {
+        job.buffer->cancel();
+        job.thread.join();
+    }
+}
+
+void ClipboardWriter::copy(QClipboard::Mode _mode, Producer _producer)
+{
+    // Reaps the threads of the texts produced meanwhile.
+    for (auto i = jobs_.begin(); i != jobs_.end();)
+    {
+        if (!i->buffer->finished())
+        {
+            ++i;
+            continue;
+        }
+        i->thread.join();
+        i = jobs_.erase(i);
+    }
+
+    auto buffer = make_shared<ClipboardBuffer>();
+    auto thread = std::thread([buffer, producer = std::move(_producer)]() {
+        try
+        {
+            producer([&](string_view _chunk) { buffer->append(_chunk); });
+        }
+        catch (std::exception const& e)
+        {
+            errorlog()("Failed to produce the text to copy into the clipboard. {}", e.what());
+        }
+        buffer->finish();
+    });
+    jobs_.emplace_back(Job { buffer, std::move(thread) });
+    setMimeData(_mode, std::move(buffer));
+}
+
+void ClipboardWriter::copy(QClipboard::Mode _mode, string _text)
+{
+    auto buffer = make_shared<ClipboardBuffer>();
+    buffer->append(_text);
+    buffer->finish();
+    setMimeData(_mode, std::move(buffer));
+}
+// }}}
+
+} // namespace contour
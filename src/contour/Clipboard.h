@@ -0,0 +1,120 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <QtCore/QMimeData>
+#include <QtGui/QClipboard>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace contour
+{
+
+/// Text to be copied into the clipboard, appended to chunk by chunk while being produced.
+class ClipboardBuffer
+{
+  public:
+    /// Appends @p _chunk, unless cancelled.
+    void append(std::string_view _chunk);
+
+    /// Marks the text as complete, waking up anyone waiting for it.
+    void finish();
+
+    /// Drops any text still being appended, e.g. because its producer is about to become unavailable.
+    void cancel();
+
+    [[nodiscard]] bool finished() const;
+
+    /// Waits for the text to be complete.
+    [[nodiscard]] std::string const& wait() const;
+
+  private:
+    mutable std::mutex lock_;
+    mutable std::condition_variable completed_;
+    std::string text_;
+    bool finished_ = false;
+    bool cancelled_ = false;
+};
+
+/**
+ * Clipboard contents whose text is only retrieved once being pasted, e.g. by another application,
+ * waiting for it to be produced if need be.
+ *
+ * The text is provided as UTF-8 as is, and only converted (once) if requested as a QString.
+ */
+class ClipboardMimeData: public QMimeData
+{
+  public:
+    explicit ClipboardMimeData(std::shared_ptr<ClipboardBuffer const> _buffer);
+
+    [[nodiscard]] QStringList formats() const override;
+    [[nodiscard]] bool hasFormat(QString const& _mimeType) const override;
+
+  protected:
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    using RetrieveType = QMetaType;
+#else
+    using RetrieveType = QVariant::Type;
+#endif
+    QVariant retrieveData(QString const& _mimeType, RetrieveType _type) const override;
+
+  private:
+    std::shared_ptr<ClipboardBuffer const> buffer_;
+    mutable std::optional<QString> text_;
+};
+
+/**
+ * Copies text into the platform clipboard without holding up the GUI thread with large texts,
+ * such as a selection of the whole history.
+ *
+ * The clipboard is handed a ClipboardMimeData right away, while its text is being produced
+ * on a thread of its own.
+ */
+class ClipboardWriter
+{
+  public:
+    using Sink = std::function<void(std::string_view)>;
+    using Producer = std::function<void(Sink const&)>;
+
+    ClipboardWriter() = default;
+    ClipboardWriter(ClipboardWriter const&) = delete;
+    ClipboardWriter& operator=(ClipboardWriter const&) = delete;
+
+    /// Waits for the texts still being produced, dropping what they have not produced yet.
+    ~ClipboardWriter();
+
+    /// Copies the text passed to the sink by @p _producer, which is invoked on a thread of its own.
+    void copy(QClipboard::Mode _mode, Producer _producer);
+
+    /// Copies the already produced @p _text.
+    static void copy(QClipboard::Mode _mode, std::string _text);
+
+  private:
+    struct Job
+    {
+        std::shared_ptr<ClipboardBuffer> buffer;
+        std::thread thread;
+    };
+    std::vector<Job> jobs_;
+};
+
+} // namespace contour
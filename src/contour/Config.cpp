@@ -25,6 +25,8 @@
 #include <crispy/stdfs.h>
 #include <crispy/utils.h>
 
+#include <unicode/convert.h>
+
 #include <yaml-cpp/ostream_wrapper.h>
 #include <yaml-cpp/yaml.h>
 
@@ -855,6 +857,45 @@ namespace // {{{ helper
 } // namespace
 // }}}
 
+namespace
+{
+    string describeInput(terminal::Key _key)
+    {
+        return fmt::format("{}", _key);
+    }
+
+    string describeInput(char32_t _ch)
+    {
+        return unicode::convert_to<char>(_ch);
+    }
+
+    string describeInput(terminal::MouseButton _button)
+    {
+        return fmt::format("{}", _button);
+    }
+
+    template <typename Input>
+    void buildInputIndex(vector<terminal::InputBinding<Input, ActionList>> const& _mappings,
+                         terminal::InputBindingIndex<Input, ActionList>& _index)
+    {
+        for (auto const i: _index.build(_mappings))
+        {
+            auto const& mapping = _mappings[i];
+            errorlog()("Input mapping {} {} {} is shadowed by earlier mappings and never applies.",
+                       mapping.modes,
+                       mapping.modifier,
+                       describeInput(mapping.input));
+        }
+    }
+} // namespace
+
+void InputMappings::buildIndex()
+{
+    buildInputIndex(keyMappings, keyIndex);
+    buildInputIndex(charMappings, charIndex);
+    buildInputIndex(mouseMappings, mouseIndex);
+}
+
 std::string defaultConfigFilePath()
 {
     return (configHome() / "contour.yml").string();
@@ -1217,6 +1258,8 @@ TerminalProfile loadTerminalProfile(UsedKeys& _usedKeys,
     tryLoadChildRelative(
         _usedKeys, _profile, basePath, "copy_last_mark_range_offset", profile.copyLastMarkRangeOffset);
     tryLoadChildRelative(_usedKeys, _profile, basePath, "show_title_bar", profile.show_title_bar);
+    tryLoadChildRelative(_usedKeys, _profile, basePath, "predictive_echo", profile.predictiveEcho);
+    tryLoadChildRelative(_usedKeys, _profile, basePath, "restore_session", profile.restoreSession);
     tryLoadChildRelative(
         _usedKeys, _profile, basePath, "draw_bold_text_with_bright_colors", profile.colors.useBrightColors);
     tryLoadChildRelative(_usedKeys, _profile, basePath, "wm_class", profile.wmClass);
@@ -1330,6 +1373,13 @@ TerminalProfile loadTerminalProfile(UsedKeys& _usedKeys,
             profile.permissions.changeFont = x.value();
     }
 
+    strValue = "deny";
+    if (tryLoadChildRelative(_usedKeys, _profile, basePath, "permissions.read_image_files", strValue))
+    {
+        if (auto x = toPermission(strValue))
+            profile.permissions.readImageFiles = x.value();
+    }
+
     if (tryLoadChildRelative(_usedKeys, _profile, basePath, "font.size", profile.fonts.size.pt))
     {
         if (profile.fonts.size < MinimumFontSize)
@@ -1343,7 +1393,13 @@ TerminalProfile loadTerminalProfile(UsedKeys& _usedKeys,
 
     tryLoadChildRelative(
         _usedKeys, _profile, basePath, "font.builtin_box_drawing", profile.fonts.builtinBoxDrawing);
+    tryLoadChildRelative(_usedKeys,
+                         _profile,
+                         basePath,
+                         "font.signed_distance_fields",
+                         profile.fonts.signedDistanceFields);
     tryLoadChildRelative(_usedKeys, _profile, basePath, "font.dpi_scale", profile.fonts.dpiScale);
+    tryLoadChildRelative(_usedKeys, _profile, basePath, "font.glyph_cache", profile.fonts.glyphCache);
 
     auto constexpr NativeTextShapingEngine =
 #if defined(_WIN32)
@@ -1471,12 +1527,16 @@ TerminalProfile loadTerminalProfile(UsedKeys& _usedKeys,
     else
         errorlog()("Invalid render_mode \"{}\" in configuration.", strValue);
 
-    auto intValue = profile.maxHistoryLineCount;
-    tryLoadChildRelative(_usedKeys, _profile, basePath, "history.limit", intValue);
-    if (unbox<int>(intValue) < 0)
-        profile.maxHistoryLineCount = LineCount(0);
+    // An infinite history keeps a bounded number of lines in memory and spills the rest into a file.
+    strValue = fmt::format("{}", profile.maxHistoryLineCount);
+    tryLoadChildRelative(_usedKeys, _profile, basePath, "history.limit", strValue);
+    profile.infiniteHistory = toLower(strValue) == "infinite" || strValue == "-1";
+    if (profile.infiniteHistory)
+        profile.maxHistoryLineCount = LineCount(1000);
+    else if (auto const limit = crispy::to_integer<10, int>(string_view(strValue)); limit.has_value())
+        profile.maxHistoryLineCount = LineCount(*limit);
     else
-        profile.maxHistoryLineCount = intValue;
+        errorlog()("Invalid history limit \"{}\" in configuration.", strValue);
 
     strValue = fmt::format("{}", ScrollBarPosition::Right);
     if (tryLoadChildRelative(_usedKeys, _profile, basePath, "scrollbar.position", strValue))
@@ -1498,6 +1558,10 @@ TerminalProfile loadTerminalProfile(UsedKeys& _usedKeys,
         _usedKeys, _profile, basePath, "history.auto_scroll_on_update", profile.autoScrollOnUpdate);
     tryLoadChildRelative(
         _usedKeys, _profile, basePath, "history.scroll_multiplier", profile.historyScrollMultiplier);
+    tryLoadChildRelative(
+        _usedKeys, _profile, basePath, "history.search_index", profile.historySearchIndex);
+    tryLoadChildRelative(
+        _usedKeys, _profile, basePath, "history.smooth_scrolling", profile.smoothScrolling);
 
     float floatValue = 1.0;
     tryLoadChildRelative(_usedKeys, _profile, basePath, "background.opacity", floatValue);
@@ -1571,6 +1635,30 @@ void loadConfigFromFile(Config& _config, FileSystem::path const& _fileName)
         opt.has_value())
         _config.mouseBlockSelectionModifier = opt.value();
 
+    auto mouseCoalescingWindow = _config.mouseCoalescingWindow.count();
+    tryLoadValue(usedKeys, doc, "mouse_coalescing_window", mouseCoalescingWindow);
+    _config.mouseCoalescingWindow = chrono::milliseconds(mouseCoalescingWindow);
+
+    auto synchronizedOutputTimeout = _config.synchronizedOutputTimeout.count();
+    tryLoadValue(usedKeys, doc, "synchronized_output_timeout", synchronizedOutputTimeout);
+    if (synchronizedOutputTimeout > 0)
+        _config.synchronizedOutputTimeout = chrono::milliseconds(synchronizedOutputTimeout);
+    else
+        errorlog()("Invalid value for config entry {}: {}",
+                   "synchronized_output_timeout",
+                   synchronizedOutputTimeout);
+
+    auto alternateScreenReleaseTimeout = _config.alternateScreenReleaseTimeout.count();
+    tryLoadValue(usedKeys, doc, "alternate_screen_release_timeout", alternateScreenReleaseTimeout);
+    if (alternateScreenReleaseTimeout >= 0)
+        _config.alternateScreenReleaseTimeout = chrono::milliseconds(alternateScreenReleaseTimeout);
+    else
+        errorlog()("Invalid value for config entry {}: {}",
+                   "alternate_screen_release_timeout",
+                   alternateScreenReleaseTimeout);
+
+    tryLoadValue(usedKeys, doc, "scrollback_memory_budget", _config.scrollbackMemoryBudget);
+
     if (doc["on_mouse_select"].IsDefined())
     {
         usedKeys.emplace("on_mouse_select");
@@ -1625,6 +1713,8 @@ void loadConfigFromFile(Config& _config, FileSystem::path const& _fileName)
     tryLoadValue(usedKeys, doc, "images.sixel_register_count", _config.maxImageColorRegisters);
     tryLoadValue(usedKeys, doc, "images.max_width", _config.maxImageSize.width);
     tryLoadValue(usedKeys, doc, "images.max_height", _config.maxImageSize.height);
+    tryLoadValue(usedKeys, doc, "images.max_memory", _config.maxImageMemory);
+    tryLoadValue(usedKeys, doc, "images.max_gpu_memory", _config.maxImageGpuMemory);
 
     if (auto colorschemes = doc["color_schemes"]; colorschemes)
     {
@@ -1655,7 +1745,12 @@ void loadConfigFromFile(Config& _config, FileSystem::path const& _fileName)
 
     tryLoadValue(usedKeys, doc, "renderer.tile_hashtable_slots", _config.textureAtlasHashtableSlots.value);
     tryLoadValue(usedKeys, doc, "renderer.tile_cache_count", _config.textureAtlasTileCount.value);
+    tryLoadValue(usedKeys, doc, "renderer.cache_growth_limit", _config.cacheGrowthLimit);
     tryLoadValue(usedKeys, doc, "renderer.tile_direct_mapping", _config.textureAtlasDirectMapping);
+    tryLoadValue(usedKeys, doc, "renderer.glyph_rasterization_budget", _config.glyphRasterizationBudget);
+    tryLoadValue(usedKeys, doc, "renderer.image_textures", _config.imageTextures);
+    tryLoadValue(usedKeys, doc, "renderer.image_texture_compression", _config.imageTextureCompression);
+    tryLoadValue(usedKeys, doc, "renderer.threaded", _config.threadedRendering);
 
     if (doc["mock_font_locator"].IsSequence())
     {
@@ -1690,6 +1785,8 @@ void loadConfigFromFile(Config& _config, FileSystem::path const& _fileName)
         _config.ptyBufferObjectSize = 1024 * 256;
     }
 
+    tryLoadValue(usedKeys, doc, "parallel_parsing", _config.parallelParsing);
+
     tryLoadValue(usedKeys, doc, "reflow_on_resize", _config.reflowOnResize);
 
     if (auto profiles = doc["profiles"]; profiles)
@@ -1724,6 +1821,7 @@ void loadConfigFromFile(Config& _config, FileSystem::path const& _fileName)
                 parseInputMapping(usedKeys, prefix, _config, mapping[i]);
             }
     }
+    _config.inputMappings.buildIndex();
 
     checkForSuperfluousKeys(doc, usedKeys);
 }
@@ -73,6 +73,14 @@ struct InputMappings
     std::vector<KeyInputMapping> keyMappings;
     std::vector<CharInputMapping> charMappings;
     std::vector<MouseInputMapping> mouseMappings;
+
+    // Lookup tables compiled from the mappings above, see buildIndex().
+    terminal::InputBindingIndex<terminal::Key, ActionList> keyIndex;
+    terminal::InputBindingIndex<char32_t, ActionList> charIndex;
+    terminal::InputBindingIndex<terminal::MouseButton, ActionList> mouseIndex;
+
+    /// Compiles the lookup tables, reporting mappings that are shadowed by earlier ones.
+    void buildIndex();
 };
 
 namespace helper
@@ -126,6 +134,24 @@ std::vector<actions::Action> const* apply(
     return nullptr;
 }
 
+/// Looks up the mapping via its precompiled index, falling back to scanning the mappings
+/// if they have been changed since the index was built.
+template <typename Input>
+std::vector<actions::Action> const* apply(
+    std::vector<terminal::InputBinding<Input, ActionList>> const& _mappings,
+    terminal::InputBindingIndex<Input, ActionList> const& _index,
+    Input _input,
+    terminal::Modifier _modifier,
+    uint8_t _actualModeFlags)
+{
+    if (!_index.builtFor(_mappings))
+        return apply(_mappings, _input, _modifier, _actualModeFlags);
+
+    if (auto const i = _index.find(_actualModeFlags, _modifier, _input))
+        return &_mappings[*i].binding;
+    return nullptr;
+}
+
 using opengl::ShaderConfig;
 
 struct CursorConfig
@@ -155,18 +181,25 @@ struct TerminalProfile
     terminal::VTType terminalId = terminal::VTType::VT525;
 
     terminal::LineCount maxHistoryLineCount;
+    bool infiniteHistory = false; // spills what exceeds maxHistoryLineCount into a file
     terminal::LineCount historyScrollMultiplier = terminal::LineCount(3);
+    bool historySearchIndex = false;
+    bool smoothScrolling = true;
     ScrollBarPosition scrollbarPosition = ScrollBarPosition::Right;
     bool hideScrollbarInAltScreen = true;
 
     bool autoScrollOnUpdate;
 
+    bool predictiveEcho = false;
+    bool restoreSession = false;
+
     terminal::renderer::FontDescriptions fonts;
 
     struct
     {
         Permission captureBuffer = Permission::Ask;
         Permission changeFont = Permission::Ask;
+        Permission readImageFiles = Permission::Deny; // Ask is not supported and means Deny.
     } permissions;
 
     bool drawBoldTextWithBrightColors = false;
@@ -228,6 +261,23 @@ struct Config
     /// This value is automatically adjusted if too small.
     crispy::LRUCapacity textureAtlasTileCount = crispy::LRUCapacity { 4000 };
 
+    /// Multiple of their configured size the texture atlas and text shaping cache may grow to.
+    unsigned cacheGrowthLimit = 8;
+
+    /// Maximum number of glyphs to be rasterized per frame, or 0 for no limit.
+    ///
+    /// Glyphs beyond that budget are rendered with one of the next frames.
+    unsigned glyphRasterizationBudget = 0;
+
+    /// Renders images from one texture each instead of per grid cell tiles in the texture atlas.
+    bool imageTextures = false;
+
+    /// Compresses the textures of large images, if imageTextures is enabled.
+    bool imageTextureCompression = false;
+
+    /// Renders the frames of each window on a thread of its own instead of the GUI thread.
+    bool threadedRendering = false;
+
     // Configures the size of the PTY read buffer.
     // Changing this value may result in better or worse throughput performance.
     //
@@ -239,6 +289,9 @@ struct Config
     // Defaults to 1 MB, that's roughly 10k lines when column count is 100.
     size_t ptyBufferObjectSize = 1024u * 1024u;
 
+    // Validates and decodes large PTY reads on multiple threads ahead of parsing them.
+    bool parallelParsing = false;
+
     bool reflowOnResize = true;
 
     std::unordered_map<std::string, terminal::ColorPalette> colorschemes;
@@ -267,6 +320,9 @@ struct Config
     terminal::Modifier bypassMouseProtocolModifier = terminal::Modifier::Shift;
     SelectionAction onMouseSelection = SelectionAction::CopyToSelectionClipboard;
     terminal::Modifier mouseBlockSelectionModifier = terminal::Modifier::Control;
+    std::chrono::milliseconds mouseCoalescingWindow {}; // 0 reports every mouse event immediately.
+    std::chrono::milliseconds synchronizedOutputTimeout { 1000 };
+    std::chrono::milliseconds alternateScreenReleaseTimeout { 60000 }; // 0 never releases it.
 
     // input mapping
     InputMappings inputMappings;
@@ -277,6 +333,9 @@ struct Config
     bool sixelCursorConformance = true;
     terminal::ImageSize maxImageSize = {}; // default to runtime system screen size.
     unsigned maxImageColorRegisters = 4096;
+    unsigned maxImageMemory = 256; // in MiB, 0 for unlimited.
+    unsigned maxImageGpuMemory = 512; // in MiB, 0 for unlimited.
+    unsigned scrollbackMemoryBudget = 0; // in MiB, for all sessions, 0 for unlimited.
 
     std::set<std::string> experimentalFeatures;
 };
@@ -14,6 +14,7 @@
 #include <contour/CaptureScreen.h>
 #include <contour/Config.h>
 #include <contour/ContourApp.h>
+#include <contour/RemoteScreen.h>
 
 #include <terminal/Capabilities.h>
 #include <terminal/Parser.h>
@@ -27,8 +28,11 @@
 
 #include <QtCore/QFile>
 
+#include <cerrno>
 #include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -36,11 +40,16 @@
 #include <signal.h>
 
 #if !defined(_WIN32)
+    #include <fcntl.h>
     #include <unistd.h>
 
     #include <sys/ioctl.h>
 #endif
 
+#if defined(__linux__)
+    #include <sys/sendfile.h>
+#endif
+
 #if defined(_WIN32)
     #include <Windows.h>
 #endif
@@ -121,6 +130,62 @@ namespace
         abort();
     }
 #endif
+
+#if !defined(_WIN32)
+    /// Returns the file descriptor of the stdout fast pipe if the terminal offers one, or stdout otherwise.
+    int stdoutFastPipeOrStdout()
+    {
+        if (auto const* value = getenv("STDOUT_FASTPIPE"); value && *value)
+        {
+            auto const fd = atoi(value);
+            if (fd > 2 && fcntl(fd, F_GETFD) != -1)
+                return fd;
+        }
+        return STDOUT_FILENO;
+    }
+
+    bool copyFile(int _source, int _target)
+    {
+    #if defined(__linux__)
+        // Let the kernel move the file contents into the pipe without copying them through user space.
+        for (;;)
+        {
+            auto const rv = sendfile(_target, _source, nullptr, 1024 * 1024);
+            if (rv == 0)
+                return true;
+            if (rv < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EINVAL || errno == ENOSYS)
+                    break; // Not supported for this kind of source or target, fall back to read/write.
+                return false;
+            }
+        }
+    #endif
+        char buffer[64 * 1024];
+        for (;;)
+        {
+            auto const n = ::read(_source, buffer, sizeof(buffer));
+            if (n == 0)
+                return true;
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            for (auto i = ssize_t(0); i < n;)
+            {
+                auto const written = ::write(_target, buffer + i, static_cast<size_t>(n - i));
+                if (written < 0 && errno != EINTR)
+                    return false;
+                if (written > 0)
+                    i += written;
+            }
+        }
+    }
+#endif
 } // namespace
 // }}}
 
@@ -168,6 +233,8 @@ ContourApp::ContourApp(): App("contour", "Contour Terminal Emulator", CONTOUR_VE
     link("contour.generate.terminfo", bind(&ContourApp::terminfoAction, this));
     link("contour.generate.config", bind(&ContourApp::configAction, this));
     link("contour.generate.integration", bind(&ContourApp::integrationAction, this));
+    link("contour.cat", bind(&ContourApp::catAction, this));
+    link("contour.remote", bind(&ContourApp::remoteAction, this));
 }
 
 template <typename Callback>
@@ -240,6 +307,41 @@ int ContourApp::captureAction()
         return EXIT_FAILURE;
 }
 
+int ContourApp::catAction()
+{
+#if !defined(_WIN32)
+    auto const fileName = parameters().get<string>("contour.cat.file");
+    auto const source = fileName == "-" ? STDIN_FILENO : ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (source < 0)
+    {
+        cerr << fmt::format("Could not open file {}. {}\n", fileName, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    auto const success = copyFile(source, stdoutFastPipeOrStdout());
+    if (!success)
+        cerr << fmt::format("Failed to write {}. {}\n", fileName, strerror(errno));
+
+    if (source != STDIN_FILENO)
+        ::close(source);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+    cerr << "The cat command is not supported on this platform.\n";
+    return EXIT_FAILURE;
+#endif
+}
+
+int ContourApp::remoteAction()
+{
+    auto settings = contour::RemoteScreenSettings {};
+    settings.refreshRate = parameters().get<double>("contour.remote.refresh-rate");
+    for (auto const argument: parameters().verbatim)
+        settings.program.emplace_back(argument);
+
+    return contour::runRemoteScreen(settings);
+}
+
 int ContourApp::parserTableAction()
 {
     terminal::parser::dot(std::cout, terminal::parser::ParserTable::get());
@@ -342,6 +444,30 @@ crispy::cli::Command ContourApp::parameterDefinition() const
                                   "FILE",
                                   CLI::Presence::Required },
                 } },
+            CLI::Command {
+                "cat",
+                "Writes the given file to the terminal, bypassing the TTY line discipline via the stdout "
+                "fast pipe if the terminal provides one.",
+                CLI::OptionList {
+                    CLI::Option { "file",
+                                  CLI::Value { "-"s },
+                                  "File to write to the terminal. If - (dash) is given, standard input is "
+                                  "written instead.",
+                                  "FILE" } } },
+            CLI::Command {
+                "remote",
+                "Runs a program in a headless terminal and mirrors its screen onto this terminal, sending "
+                "only the lines that changed since the previous update. Meant to be run on the remote end "
+                "of a slow connection, e.g. ssh -t HOST contour remote.",
+                CLI::OptionList {
+                    CLI::Option { "refresh-rate",
+                                  CLI::Value { 30.0 },
+                                  "Maximum number of screen updates per second.",
+                                  "RATE" } },
+                CLI::CommandList {},
+                CLI::CommandSelect::Explicit,
+                CLI::Verbatim { "PROGRAM ARGS...",
+                                "Program to run instead of the login shell, with its arguments." } },
             CLI::Command {
                 "set",
                 "Sets various aspects of the connected terminal.",
@@ -36,6 +36,8 @@ class ContourApp: public crispy::App
     int terminfoAction();
     int configAction();
     int integrationAction();
+    int catAction();
+    int remoteAction();
 };
 
 } // namespace contour
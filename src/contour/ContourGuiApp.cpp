@@ -13,20 +13,38 @@
  */
 #include <contour/Config.h>
 #include <contour/ContourGuiApp.h>
+#include <contour/MemoryBudget.h>
 #include <contour/TerminalWindow.h>
+#include <contour/opengl/OffscreenRenderer.h>
 #include <contour/opengl/TerminalWidget.h>
 
 #include <terminal/Process.h>
 
 #include <text_shaper/font_locator.h>
 
+#include <crispy/PerfTrace.h>
+#include <crispy/StartupTrace.h>
 #include <crispy/logstore.h>
 
+#include <QtCore/QDir>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
 #include <QtCore/QProcess>
+#include <QtCore/QStandardPaths>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
 #include <QtGui/QSurfaceFormat>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
 #include <QtWidgets/QApplication>
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 using std::bind;
@@ -34,9 +52,12 @@ using std::cerr;
 using std::get;
 using std::holds_alternative;
 using std::make_unique;
+using std::max;
+using std::min;
 using std::prev;
 using std::string;
 using std::string_view;
+using std::unique_ptr;
 using std::vector;
 
 using terminal::Process;
@@ -48,10 +69,30 @@ namespace CLI = crispy::cli;
 namespace contour
 {
 
+namespace
+{
+    /// Returns the name of the local socket a single-instance contour process
+    /// accepts window requests on.
+    ///
+    /// The socket lives in the user's runtime directory ($XDG_RUNTIME_DIR, or a directory
+    /// only accessible by the user that Qt falls back to), rather than in a namespace shared
+    /// with other users, who could otherwise take the name first.
+    QString windowRequestSocketName()
+    {
+#if defined(_WIN32)
+        // Named pipes have no directories. Their access is restricted by QLocalServer::UserAccessOption.
+        return "contour-" + qEnvironmentVariable("USERNAME", "user");
+#else
+        return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + "/contour.sock";
+#endif
+    }
+} // namespace
+
 ContourGuiApp::ContourGuiApp()
 {
     link("contour.terminal", bind(&ContourGuiApp::terminalGuiAction, this));
     link("contour.font-locator", bind(&ContourGuiApp::fontConfigAction, this));
+    link("contour.render", bind(&ContourGuiApp::renderAction, this));
 }
 
 ContourGuiApp::~ContourGuiApp()
@@ -70,6 +111,51 @@ crispy::cli::Command ContourGuiApp::parameterDefinition() const
 {
     auto command = ContourApp::parameterDefinition();
 
+    command.children.insert(
+        command.children.begin(),
+        CLI::Command {
+            "render",
+            "Renders application output (e.g. CI logs) into PNG images, without a window.",
+            CLI::OptionList {
+                CLI::Option { "config",
+                              CLI::Value { contour::config::defaultConfigFilePath() },
+                              "Path to configuration file to load at startup.",
+                              "FILE" },
+                CLI::Option {
+                    "profile", CLI::Value { ""s }, "Terminal Profile to load (overriding config).", "NAME" },
+                CLI::Option { "debug",
+                              CLI::Value { ""s },
+                              "Enables debug logging, using a comma (,) seperated list of tags.",
+                              "TAGS" },
+                CLI::Option { "to",
+                              CLI::Value { "."s },
+                              "Directory to write the images to, one FILE.png per input file.",
+                              "DIRECTORY" },
+                CLI::Option { "columns",
+                              CLI::Value { 0u },
+                              "Page width (overriding the profile's terminal size).",
+                              "COUNT" },
+                CLI::Option { "lines",
+                              CLI::Value { 0u },
+                              "Page height (overriding the profile's terminal size).",
+                              "COUNT" },
+                CLI::Option { "frame-bytes",
+                              CLI::Value { 0u },
+                              "Writes a numbered frame FILE-NNNN.png after every given number of bytes "
+                              "instead of only the final screen.",
+                              "BYTES" },
+                CLI::Option { "jobs",
+                              CLI::Value { 1u },
+                              "Number of input files to render in parallel, each with its own OpenGL "
+                              "context.",
+                              "COUNT" },
+                CLI::Option {
+                    "platform", CLI::Value { ""s }, "Sets the QPA platform.", "PLATFORM[:OPTIONS]" },
+            },
+            CLI::CommandList {},
+            CLI::CommandSelect::Explicit,
+            CLI::Verbatim { "FILE...", "Files with the output to render, or - for standard input." } });
+
     command.children.insert(
         command.children.begin(),
         CLI::Command {
@@ -106,6 +192,35 @@ crispy::cli::Command ContourGuiApp::parameterDefinition() const
                               "Enables debug logging, using a comma (,) seperated list of tags.",
                               "TAGS" },
                 CLI::Option { "live-config", CLI::Value { false }, "Enables live config reloading." },
+                CLI::Option { "single-instance",
+                              CLI::Value { false },
+                              "Opens the new window in an already running contour instance (that was "
+                              "started with this flag, too), or else becomes that instance." },
+                CLI::Option { "trace-startup",
+                              CLI::Value { ""s },
+                              "Writes a Chrome trace (JSON) of the time spent in each startup phase up "
+                              "until the first frame has been presented into the given file.",
+                              "FILE" },
+#if defined(CONTOUR_PERF_TRACING)
+                CLI::Option { "perf-trace",
+                              CLI::Value { ""s },
+                              "Writes a Chrome trace (JSON) of the time spent in hot code paths of all "
+                              "threads into the given file at exit, to be viewed in Perfetto or Tracy.",
+                              "FILE" },
+#endif
+                CLI::Option { "record-output",
+                              CLI::Value { ""s },
+                              "Records the output of the terminal's application, with timing, into the "
+                              "given file, e.g. for replaying it with bench-headless.",
+                              "FILE" },
+                CLI::Option { "measure-input-latency",
+                              CLI::Value { false },
+                              "Measures keypress-to-photon latency per stage, reporting P50/P90/P99 "
+                              "percentiles as part of the state dump." },
+                CLI::Option { "report-memory-at-exit",
+                              CLI::Value { false },
+                              "Prints a breakdown of the memory held by each terminal session (grid "
+                              "lines, buffers, images, hyperlinks, texture atlas) when it terminates." },
                 CLI::Option {
                     "dump-state-at-exit",
                     CLI::Value { ""s },
@@ -177,6 +292,24 @@ std::optional<FileSystem::path> ContourGuiApp::dumpStateAtExit() const
     return FileSystem::path(path);
 }
 
+bool ContourGuiApp::reportMemoryAtExit() const
+{
+    return parameters().get<bool>("contour.terminal.report-memory-at-exit");
+}
+
+std::optional<FileSystem::path> ContourGuiApp::outputRecordingPath() const
+{
+    auto const path = parameters().get<std::string>("contour.terminal.record-output");
+    if (path.empty())
+        return std::nullopt;
+    return FileSystem::path(path);
+}
+
+bool ContourGuiApp::measureInputLatency() const
+{
+    return parameters().get<bool>("contour.terminal.measure-input-latency");
+}
+
 void ContourGuiApp::onExit(TerminalSession& _session)
 {
     auto const* localProcess = dynamic_cast<terminal::Process const*>(&_session.terminal().device());
@@ -204,6 +337,7 @@ bool ContourGuiApp::loadConfig(string const& target)
 
     auto const configPath = QString::fromStdString(flags.get<string>(prefix + "config"));
 
+    auto const _ = crispy::StartupTrace::Scope { "config load" };
     config_ = configPath.isEmpty() ? contour::config::loadConfig()
                                    : contour::config::loadConfigFromFile(configPath.toStdString());
 
@@ -275,8 +409,150 @@ int ContourGuiApp::fontConfigAction()
     return EXIT_SUCCESS;
 }
 
+int ContourGuiApp::renderAction()
+{
+    if (!loadConfig("render"))
+        return EXIT_FAILURE;
+
+    auto const& flags = parameters();
+    auto const name = flags.get<string>("contour.render.profile");
+    auto const* profile = config_.profile(name.empty() ? profileName() : name);
+    if (!profile)
+    {
+        errorlog()("Could not access configuration profile.");
+        return EXIT_FAILURE;
+    }
+
+    auto inputs = vector<string>(flags.verbatim.begin(), flags.verbatim.end());
+    if (inputs.empty())
+        inputs.emplace_back("-");
+
+    auto pageSize = profile->terminalSize;
+    if (auto const columns = flags.get<unsigned>("contour.render.columns"); columns != 0)
+        pageSize.columns = terminal::ColumnCount::cast_from(columns);
+    if (auto const lines = flags.get<unsigned>("contour.render.lines"); lines != 0)
+        pageSize.lines = terminal::LineCount::cast_from(lines);
+
+    auto const platform = flags.get<string>("contour.render.platform");
+    vector<char const*> qtArgsPtr;
+    qtArgsPtr.push_back(argv_[0]);
+    if (!platform.empty())
+    {
+        qtArgsPtr.push_back("-platform");
+        qtArgsPtr.push_back(platform.c_str());
+    }
+    auto qtArgsCount = static_cast<int>(qtArgsPtr.size());
+    QGuiApplication app(qtArgsCount, (char**) qtArgsPtr.data());
+
+    QSurfaceFormat::setDefaultFormat(contour::opengl::TerminalWidget::surfaceFormat());
+
+    memoryBudget_ = make_unique<MemoryBudget>(size_t(config_.scrollbackMemoryBudget) * 1024 * 1024);
+
+    auto jobs = min(max(size_t { 1 }, size_t { flags.get<unsigned>("contour.render.jobs") }), inputs.size());
+    if (jobs > 1 && !QOpenGLContext::supportsThreadedOpenGL())
+    {
+        errorlog()("OpenGL rendering on multiple threads is not supported. Rendering one file at a time.");
+        jobs = 1;
+    }
+
+    // Offscreen surfaces must be created on the GUI thread, the contexts rendering into them are not.
+    auto surfaces = vector<unique_ptr<QOffscreenSurface>>();
+    for (size_t i = 0; i < jobs; ++i)
+    {
+        auto& surface = surfaces.emplace_back(make_unique<QOffscreenSurface>());
+        surface->setFormat(QSurfaceFormat::defaultFormat());
+        surface->create();
+    }
+
+    auto nextInput = std::atomic<size_t> { 0 };
+    auto failures = std::atomic<size_t> { 0 };
+    auto const worker = [&](QOffscreenSurface& surface) {
+        for (auto i = nextInput++; i < inputs.size(); i = nextInput++)
+            if (!renderLog(inputs[i], *profile, pageSize, surface))
+                ++failures;
+    };
+
+    auto threads = vector<std::thread>();
+    for (size_t i = 1; i < jobs; ++i)
+        threads.emplace_back(worker, std::ref(*surfaces[i]));
+    worker(*surfaces[0]);
+    for (auto& thread: threads)
+        thread.join();
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+bool ContourGuiApp::renderLog(string const& _input,
+                              config::TerminalProfile const& _profile,
+                              terminal::PageSize _pageSize,
+                              QOffscreenSurface& _surface) const
+{
+    auto const& flags = parameters();
+    auto const targetDir = FileSystem::path(flags.get<string>("contour.render.to"));
+    auto const frameBytes = size_t { flags.get<unsigned>("contour.render.frame-bytes") };
+    auto const stem = _input == "-" ? "stdin"s : FileSystem::path(_input).stem().string();
+
+    auto file = std::ifstream();
+    if (_input != "-")
+    {
+        file.open(_input, std::ios::binary);
+        if (!file.good())
+        {
+            errorlog()("Could not open {}.", _input);
+            return false;
+        }
+    }
+    std::istream& in = _input == "-" ? std::cin : file;
+
+    auto renderer = contour::opengl::OffscreenRenderer(config_, _profile, _pageSize, _surface);
+    if (!renderer.valid())
+        return false;
+
+    auto frameCount = 0;
+    auto const saveFrame = [&]() {
+        auto const fileName =
+            targetDir / (frameBytes ? fmt::format("{}-{:04}.png", stem, ++frameCount) : stem + ".png");
+        if (renderer.render().save(QString::fromStdString(fileName.string())))
+            return true;
+        errorlog()("Could not write {}.", fileName.string());
+        return false;
+    };
+
+    auto buffer = vector<char>(frameBytes ? min(frameBytes, size_t { 64 * 1024 }) : 64 * 1024);
+    auto bytesSinceFrame = size_t { 0 };
+    while (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0)
+    {
+        auto const count = static_cast<size_t>(in.gcount());
+        renderer.write(string_view(buffer.data(), count));
+        bytesSinceFrame += count;
+        if (frameBytes && bytesSinceFrame >= frameBytes)
+        {
+            if (!saveFrame())
+                return false;
+            bytesSinceFrame = 0;
+        }
+    }
+
+    // The final screen, unless it just got written as the last frame.
+    if (frameBytes && frameCount && !bytesSinceFrame)
+        return true;
+    return saveFrame();
+}
+
 int ContourGuiApp::terminalGuiAction()
 {
+    auto const singleInstance = parameters().get<bool>("contour.terminal.single-instance");
+    if (singleInstance && requestWindowFromRunningInstance())
+        return EXIT_SUCCESS;
+
+    if (auto const traceFile = parameters().get<string>("contour.terminal.trace-startup"); !traceFile.empty())
+        crispy::StartupTrace::enable(traceFile);
+
+#if defined(CONTOUR_PERF_TRACING)
+    if (auto const traceFile = parameters().get<string>("contour.terminal.perf-trace"); !traceFile.empty())
+        crispy::PerfTrace::enable(traceFile);
+#endif
+
     if (!loadConfig("terminal"))
         return EXIT_FAILURE;
 
@@ -293,6 +569,9 @@ int ContourGuiApp::terminalGuiAction()
             break;
     }
 
+    // Split panes each have an OpenGL context of their own, which are to share their resources.
+    QGuiApplication::setAttribute(Qt::AA_ShareOpenGLContexts, true);
+
     auto const* profile = config_.profile(profileName());
     if (!profile)
     {
@@ -350,10 +629,17 @@ int ContourGuiApp::terminalGuiAction()
         return EXIT_FAILURE;
     }
 
+    if (singleInstance)
+        listenForWindowRequests();
+
     auto rv = app.exec();
 
+    windowRequestServer_.reset();
+    memoryBudget_.reset();
     terminalWindows_.clear();
 
+    crispy::PerfTrace::finish();
+
     if (exitStatus_.has_value())
     {
         if (holds_alternative<Process::NormalExit>(*exitStatus_))
@@ -390,6 +676,18 @@ TerminalWindow* ContourGuiApp::newWindow(contour::config::Config const& _config)
     return terminalWindows_.back();
 }
 
+TerminalWindow* ContourGuiApp::newWindow(contour::config::Config const& _config,
+                                         std::string const& _profileName)
+{
+    auto const liveConfig = parameters().get<bool>("contour.terminal.live-config");
+    auto mainWindow =
+        new TerminalWindow(earlyExitThreshold(), _config, liveConfig, _profileName, argv_[0], *this);
+    mainWindow->show();
+
+    terminalWindows_.emplace_back(mainWindow);
+    return terminalWindows_.back();
+}
+
 TerminalWindow* ContourGuiApp::newWindow()
 {
     auto const liveConfig = parameters().get<bool>("contour.terminal.live-config");
@@ -401,6 +699,118 @@ TerminalWindow* ContourGuiApp::newWindow()
     return terminalWindows_.back();
 }
 
+// {{{ single-instance mode
+// A contour process started with --single-instance listens on a local socket. Subsequent
+// invocations with that flag hand their window request over to it (one JSON object per line,
+// answered with "ok" or an error message) and exit, instead of starting another GUI process.
+
+bool ContourGuiApp::requestWindowFromRunningInstance() const
+{
+    auto socket = QLocalSocket {};
+    socket.connectToServer(windowRequestSocketName());
+    if (!socket.waitForConnected(500))
+        return false;
+
+    auto request = QJsonObject {};
+    request["profile"] = QString::fromStdString(parameters().get<string>("contour.terminal.profile"));
+    if (auto const wd = parameters().get<string>("contour.terminal.working-directory"); !wd.empty())
+        request["working-directory"] = QDir(QString::fromStdString(wd)).absolutePath();
+
+    auto program = QJsonArray {};
+    if (auto const exe = parameters().get<string>("contour.terminal.execute"); !exe.empty())
+        program.append(QString::fromStdString(exe));
+    for (auto const arg: parameters().verbatim)
+        program.append(QString::fromStdString(string(arg)));
+    request["program"] = program;
+
+    auto const requestLine = QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n';
+    if (socket.write(requestLine) != requestLine.size())
+        return false;
+
+    // Once written, the request may be served regardless of how quickly that is acknowledged.
+    // Only if the running instance reports to have failed, a window is opened here instead,
+    // as there would be two windows otherwise.
+    if (!socket.waitForBytesWritten(1000) || !socket.waitForReadyRead(5000))
+    {
+        cerr << "Running contour instance did not acknowledge the window request in time.\n";
+        return true;
+    }
+
+    auto const reply = socket.readLine().trimmed().toStdString();
+    if (reply != "ok")
+    {
+        cerr << "Running contour instance failed to open a window. " << reply << '\n';
+        return false;
+    }
+    return true;
+}
+
+void ContourGuiApp::listenForWindowRequests()
+{
+    auto const socketName = windowRequestSocketName();
+    windowRequestServer_ = make_unique<QLocalServer>();
+    windowRequestServer_->setSocketOptions(QLocalServer::UserAccessOption);
+    QLocalServer::removeServer(socketName); // stale socket of a previous instance
+    if (!windowRequestServer_->listen(socketName))
+    {
+        errorlog()("Cannot listen for window requests on {}. {}",
+                   socketName.toStdString(),
+                   windowRequestServer_->errorString().toStdString());
+        windowRequestServer_.reset();
+        return;
+    }
+
+    QObject::connect(windowRequestServer_.get(), &QLocalServer::newConnection, [this]() {
+        while (QLocalSocket* socket = windowRequestServer_->nextPendingConnection())
+        {
+            QObject::connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+            QObject::connect(socket, &QLocalSocket::readyRead, socket, [this, socket]() {
+                if (!socket->canReadLine())
+                    return;
+                auto const request = socket->readLine().toStdString();
+                auto const error = openRequestedWindow(request);
+                socket->write(error.empty() ? "ok\n" : QByteArray::fromStdString(error + "\n"));
+                socket->disconnectFromServer();
+            });
+        }
+    });
+}
+
+std::string ContourGuiApp::openRequestedWindow(std::string_view _request)
+{
+    auto const document =
+        QJsonDocument::fromJson(QByteArray(_request.data(), static_cast<int>(_request.size())));
+    if (!document.isObject())
+        return "Malformed window request.";
+    auto const request = document.object();
+
+    auto config = config_;
+    auto profileName = request["profile"].toString().toStdString();
+    if (profileName.empty())
+        profileName = this->profileName();
+
+    config::TerminalProfile* profile = config.profile(profileName);
+    if (!profile)
+        return fmt::format("No profile with name '{}' found.", profileName);
+
+    if (auto const wd = request["working-directory"].toString().toStdString(); !wd.empty())
+        profile->shell.workingDirectory = FileSystem::path(wd);
+
+    if (auto const program = request["program"].toArray(); !program.isEmpty())
+    {
+        profile->shell.program = program.first().toString().toStdString();
+        profile->shell.arguments.clear();
+        for (int i = 1; i < program.size(); ++i)
+            profile->shell.arguments.emplace_back(program.at(i).toString().toStdString());
+    }
+
+    if (!newWindow(config, profileName))
+        return "Could not spawn terminal window.";
+
+    return {};
+}
+// }}}
+
 void ContourGuiApp::showNotification(std::string_view _title, std::string_view _content)
 {
     // systrayIcon_->showMessage(
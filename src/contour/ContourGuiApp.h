@@ -23,6 +23,9 @@
 #include <optional>
 #include <string_view>
 
+class QLocalServer;
+class QOffscreenSurface;
+
 namespace contour
 {
 
@@ -31,6 +34,7 @@ namespace config
     struct Config;
 }
 
+class MemoryBudget;
 class TerminalSession;
 class TerminalWindow;
 
@@ -46,6 +50,7 @@ class ContourGuiApp: public ContourApp
 
     TerminalWindow* newWindow();
     TerminalWindow* newWindow(contour::config::Config const& _config);
+    TerminalWindow* newWindow(contour::config::Config const& _config, std::string const& _profileName);
     void showNotification(std::string_view _title, std::string_view _content);
 
     std::string profileName() const;
@@ -53,14 +58,32 @@ class ContourGuiApp: public ContourApp
     std::optional<terminal::Process::ExitStatus> exitStatus() const noexcept { return exitStatus_; }
 
     std::optional<FileSystem::path> dumpStateAtExit() const;
+    bool reportMemoryAtExit() const;
+    bool measureInputLatency() const;
+    std::optional<FileSystem::path> outputRecordingPath() const;
 
     void onExit(TerminalSession& _session);
 
+    /// @returns the memory budget shared by all sessions, or nullptr if not running the GUI.
+    MemoryBudget* memoryBudget() noexcept { return memoryBudget_.get(); }
+
   private:
     bool loadConfig(std::string const& target);
     int terminalGuiAction();
     int fontConfigAction();
+    int renderAction();
+    bool renderLog(std::string const& _input,
+                   config::TerminalProfile const& _profile,
+                   terminal::PageSize _pageSize,
+                   QOffscreenSurface& _surface) const;
     std::chrono::seconds earlyExitThreshold() const;
+
+    // {{{ single-instance mode
+    bool requestWindowFromRunningInstance() const;
+    void listenForWindowRequests();
+    std::string openRequestedWindow(std::string_view _request);
+    // }}}
+
     config::Config config_;
 
     int argc_ = 0;
@@ -68,6 +91,11 @@ class ContourGuiApp: public ContourApp
     std::optional<terminal::Process::ExitStatus> exitStatus_;
 
     std::list<TerminalWindow*> terminalWindows_;
+
+    // Accepts window requests from other contour invocations (single-instance mode).
+    std::unique_ptr<QLocalServer> windowRequestServer_;
+
+    std::unique_ptr<MemoryBudget> memoryBudget_;
 };
 
 } // namespace contour
@@ -0,0 +1,272 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/LiveBenchmark.h>
+#include <contour/TerminalSession.h>
+#include <contour/helper.h>
+
+#include <crispy/App.h>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+#if defined(CONTOUR_BENCHMARK)
+    #include <libtermbench/termbench.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+using std::chrono::duration;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+namespace contour
+{
+
+namespace
+{
+    // Time to wait for the output of a test to be parsed, before taking it as is.
+    constexpr auto ParseTimeout = std::chrono::seconds(10);
+
+    double milliseconds(LiveBenchmark::Clock::duration _time) noexcept
+    {
+        return static_cast<double>(duration_cast<microseconds>(_time).count()) / 1000.0;
+    }
+
+    double megabytesPerSecond(uint64_t _bytes, LiveBenchmark::Clock::duration _time) noexcept
+    {
+        auto const seconds = duration<double>(_time).count();
+        return seconds > 0.0 ? static_cast<double>(_bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+
+    LiveBenchmark::Clock::duration percentile(std::vector<LiveBenchmark::Clock::duration> _samples,
+                                              unsigned _percentile)
+    {
+        if (_samples.empty())
+            return {};
+
+        auto const nth =
+            _samples.begin() + static_cast<std::ptrdiff_t>((_samples.size() - 1) * _percentile / 100);
+        std::nth_element(_samples.begin(), nth, _samples.end());
+        return *nth;
+    }
+} // namespace
+
+LiveBenchmark::LiveBenchmark(TerminalSession& _session,
+                             std::string _system,
+                             std::function<void()> _finished):
+    session_ { _session }, system_ { std::move(_system) }, finishedCallback_ { std::move(_finished) }
+{
+    thread_ = std::thread { [this]() { run(); } };
+}
+
+LiveBenchmark::~LiveBenchmark()
+{
+    stopping_ = true;
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void LiveBenchmark::frameRendered(Clock::duration _frameTime)
+{
+    auto const _ = std::lock_guard { lock_ };
+    if (recording_)
+        results_.back().frameTimes.push_back(_frameTime);
+}
+
+void LiveBenchmark::run()
+{
+#if defined(CONTOUR_BENCHMARK)
+    auto slave = session_.pty().openSlave();
+    if (!slave)
+    {
+        report("Cannot write into the PTY.");
+        return;
+    }
+
+    SessionLog()("Running benchmark ({} MB per test).", TestSizeMB);
+    auto const pageSize = session_.terminal().pageSize();
+    auto bytesWritten = uint64_t { 0 };
+    auto tbp = termbench::Benchmark(
+        [&](char const* _data, size_t _size) -> bool {
+            while (_size != 0 && !stopping_)
+            {
+                auto const rv = slave->write(std::string_view(_data, _size));
+                if (rv < 0 && errno == EINTR)
+                    continue;
+                if (rv < 0)
+                    return false;
+                _data += rv;
+                _size -= static_cast<size_t>(rv);
+                bytesWritten += static_cast<uint64_t>(rv);
+            }
+            return !stopping_;
+        },
+        TestSizeMB,
+        unbox<unsigned>(pageSize.columns),
+        unbox<unsigned>(pageSize.lines),
+        [&](termbench::Test const& _test) {
+            if (!results_.empty())
+                endTest(std::exchange(bytesWritten, 0));
+            beginTest(fmt::format("{}", _test.name));
+        });
+
+    tbp.add(termbench::tests::many_lines());
+    tbp.add(termbench::tests::long_lines());
+    tbp.add(termbench::tests::sgr_fg_lines());
+    tbp.add(termbench::tests::sgr_fgbg_lines());
+    tbp.runAll();
+    if (stopping_)
+        return;
+
+    if (!results_.empty())
+        endTest(bytesWritten);
+
+    // Resets the colors the last test has left behind.
+    (void) slave->write("\033[m\r\n");
+
+    report({});
+#else
+    report("Not built with termbench.");
+#endif
+}
+
+void LiveBenchmark::beginTest(std::string _name)
+{
+    auto& terminal = session_.terminal();
+    auto const frameStats = terminal.frameScheduler().stats(Clock::now());
+    bytesParsedAtStart_ = terminal.statistics().bytesParsed.load();
+    framesAtStart_ = frameStats.frames;
+    skippedFramesAtStart_ = frameStats.skippedFrames;
+
+    auto const _ = std::lock_guard { lock_ };
+    results_.emplace_back(TestResult { std::move(_name) });
+    recording_ = true;
+    testStart_ = Clock::now();
+}
+
+void LiveBenchmark::endTest(uint64_t _bytesWritten)
+{
+    // The test ends once all of its output went through the parser, not when it was written,
+    // as writes complete as soon as they fit into the PTY's buffer.
+    auto& terminal = session_.terminal();
+    auto const deadline = Clock::now() + ParseTimeout;
+    while (terminal.statistics().bytesParsed.load() - bytesParsedAtStart_ < _bytesWritten
+           && Clock::now() < deadline && !stopping_)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto const now = Clock::now();
+    auto const frameStats = terminal.frameScheduler().stats(now);
+
+    auto const _ = std::lock_guard { lock_ };
+    auto& result = results_.back();
+    result.bytes = _bytesWritten;
+    result.duration = now - testStart_;
+    result.frames = frameStats.frames - framesAtStart_;
+    result.skippedFrames = frameStats.skippedFrames - skippedFramesAtStart_;
+}
+
+void LiveBenchmark::report(std::string const& _error)
+{
+    {
+        auto const _ = std::lock_guard { lock_ };
+        recording_ = false;
+    }
+
+    if (!_error.empty())
+    {
+        errorlog()("Benchmark failed. {}", _error);
+        lines_.emplace_back(fmt::format("Benchmark     : failed. {}", _error));
+    }
+    else
+    {
+        lines_.emplace_back(fmt::format("Benchmark     : {} MB per test, {} cells, {}",
+                                        TestSizeMB,
+                                        session_.terminal().pageSize(),
+                                        system_));
+        for (TestResult const& result: results_)
+            lines_.emplace_back(
+                fmt::format("{:<14}: {:.2f} MB/s, {} frames ({} skipped), P50 {:.2f} ms, P99 {:.2f} ms",
+                            result.name,
+                            megabytesPerSecond(result.bytes, result.duration),
+                            result.frames,
+                            result.skippedFrames,
+                            milliseconds(percentile(result.frameTimes, 50)),
+                            milliseconds(percentile(result.frameTimes, 99))));
+
+        if (auto const path = saveReport(); !path.empty())
+            lines_.emplace_back(fmt::format("Saved to      : {}", path));
+    }
+
+    for (auto const& line: lines_)
+        SessionLog()("{}", line);
+
+    finished_ = true;
+    if (finishedCallback_)
+        finishedCallback_();
+}
+
+std::string LiveBenchmark::saveReport() const
+{
+    auto tests = QJsonArray {};
+    for (TestResult const& result: results_)
+    {
+        auto test = QJsonObject {};
+        test["name"] = QString::fromStdString(result.name);
+        test["bytes"] = static_cast<qint64>(result.bytes);
+        test["seconds"] = duration<double>(result.duration).count();
+        test["megabytesPerSecond"] = megabytesPerSecond(result.bytes, result.duration);
+        test["frames"] = static_cast<qint64>(result.frames);
+        test["skippedFrames"] = static_cast<qint64>(result.skippedFrames);
+        test["frameTimeP50Ms"] = milliseconds(percentile(result.frameTimes, 50));
+        test["frameTimeP99Ms"] = milliseconds(percentile(result.frameTimes, 99));
+        tests.append(test);
+    }
+
+    auto const pageSize = session_.terminal().pageSize();
+    auto report = QJsonObject {};
+    report["version"] = QString::fromUtf8(CONTOUR_VERSION_STRING);
+    report["system"] = QString::fromStdString(system_);
+    report["columns"] = unbox<int>(pageSize.columns);
+    report["lines"] = unbox<int>(pageSize.lines);
+    report["testSizeMB"] = static_cast<int>(TestSizeMB);
+    report["tests"] = tests;
+
+    auto const directory = crispy::App::instance()->localStateDir() / "benchmark";
+    auto const path =
+        directory / fmt::format("benchmark-{:%Y-%m-%d-%H-%M-%S}.json", std::chrono::system_clock::now());
+    try
+    {
+        FileSystem::create_directories(directory);
+        auto file = std::ofstream(path.string(), std::ios::trunc);
+        file << QJsonDocument(report).toJson().toStdString();
+        if (!file)
+            throw std::runtime_error("Write failed.");
+    }
+    catch (std::exception const& e)
+    {
+        errorlog()("Failed to save benchmark report to {}. {}", path.string(), e.what());
+        return {};
+    }
+    return path.string();
+}
+
+} // namespace contour
@@ -0,0 +1,112 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace contour
+{
+
+class TerminalSession;
+
+/**
+ * Runs termbench tests end to end inside a live terminal session.
+ *
+ * The tests' output is written into the slave side of the session's PTY by a thread of its own,
+ * so that it takes the same path as any application's output: through the PTY's line discipline,
+ * the parser and the render buffer up to the rendered frames.
+ *
+ * For every test, the throughput is measured until all of its output has been parsed, along with
+ * the frames rendered and skipped meanwhile and their render times. The results are formatted
+ * as text lines to be shown on top of the terminal and saved as a JSON report.
+ *
+ * @see actions::RunBenchmark
+ */
+class LiveBenchmark
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Number of megabytes written by each test.
+    static constexpr unsigned TestSizeMB = 32;
+
+    /// Starts running the tests.
+    ///
+    /// @param _session  the session to run the tests in.
+    /// @param _system   description of the rendering system (e.g. the OpenGL renderer) for the report.
+    /// @param _finished invoked on the benchmark's thread once finished().
+    LiveBenchmark(TerminalSession& _session, std::string _system, std::function<void()> _finished);
+
+    /// Stops running the tests, waiting for the test being run to end.
+    ~LiveBenchmark();
+
+    LiveBenchmark(LiveBenchmark const&) = delete;
+    LiveBenchmark& operator=(LiveBenchmark const&) = delete;
+
+    /// Records the time it took to render a single frame.
+    ///
+    /// This may be called from any thread.
+    void frameRendered(Clock::duration _frameTime);
+
+    /// Tests whether all tests have been run (or running them failed), and lines() are available.
+    [[nodiscard]] bool finished() const noexcept { return finished_.load(); }
+
+    /// The results, once finished().
+    [[nodiscard]] std::vector<std::string> const& lines() const noexcept { return lines_; }
+
+  private:
+    struct TestResult
+    {
+        std::string name;
+        uint64_t bytes = 0;          // written into the PTY
+        Clock::duration duration {}; // until all written bytes have been parsed
+        uint64_t frames = 0;
+        uint64_t skippedFrames = 0;
+        std::vector<Clock::duration> frameTimes {};
+    };
+
+    void run();
+    void beginTest(std::string _name);
+    void endTest(uint64_t _bytesWritten);
+    void report(std::string const& _error);
+    [[nodiscard]] std::string saveReport() const;
+
+    TerminalSession& session_;
+    std::string system_;
+    std::function<void()> finishedCallback_;
+
+    std::mutex lock_; // guards results_ and recording_
+    std::vector<TestResult> results_;
+    bool recording_ = false; // whether rendered frames are recorded for the current test
+
+    // Counters of the terminal as of the start of the current test.
+    Clock::time_point testStart_;
+    uint64_t bytesParsedAtStart_ = 0;
+    uint64_t framesAtStart_ = 0;
+    uint64_t skippedFramesAtStart_ = 0;
+
+    std::vector<std::string> lines_;
+    std::atomic<bool> stopping_ = false;
+    std::atomic<bool> finished_ = false;
+    std::thread thread_;
+};
+
+} // namespace contour
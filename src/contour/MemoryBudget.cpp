@@ -0,0 +1,246 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/MemoryBudget.h>
+#include <contour/TerminalSession.h>
+#include <contour/helper.h>
+
+#include <terminal/Grid.h>
+
+#include <crispy/utils.h>
+
+#include <QtCore/QSocketNotifier>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <cstring>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+#elif defined(__APPLE__)
+    #include <dispatch/dispatch.h>
+#endif
+
+using std::chrono::steady_clock;
+using std::string_view;
+
+namespace contour
+{
+
+namespace
+{
+    constexpr auto EnforcementInterval = std::chrono::seconds(10);
+
+    // Time without output after which a session's grown caches are shrunk again.
+    constexpr auto IdleCacheReleaseDelay = std::chrono::minutes(5);
+
+#if defined(__linux__)
+    // Signals a stall of 500ms within any 2s window, in which some tasks waited for memory.
+    // Unprivileged processes may only use windows of multiples of 2s.
+    constexpr auto PressureTrigger = string_view("some 500000 2000000");
+#endif
+} // namespace
+
+MemoryBudget::MemoryBudget(size_t _scrollbackBytes): scrollbackBytes_ { _scrollbackBytes }
+{
+    QObject::connect(&timer_, &QTimer::timeout, [this]() {
+        if (scrollbackBytes_)
+            enforce(scrollbackBytes_);
+        releaseIdleCaches();
+    });
+    timer_.setInterval(std::chrono::duration_cast<std::chrono::milliseconds>(EnforcementInterval));
+    timer_.start();
+
+    watchMemoryPressure();
+}
+
+MemoryBudget::~MemoryBudget()
+{
+#if defined(__linux__)
+    pressureNotifier_.reset();
+    if (pressureFd_ != -1)
+        ::close(pressureFd_);
+#elif defined(__APPLE__)
+    if (pressureSource_)
+    {
+        auto source = static_cast<dispatch_source_t>(pressureSource_);
+        dispatch_source_cancel(source);
+        dispatch_release(source);
+    }
+#endif
+}
+
+void MemoryBudget::watchMemoryPressure()
+{
+#if defined(__linux__)
+    pressureFd_ = ::open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (pressureFd_ == -1
+        || ::write(pressureFd_, PressureTrigger.data(), PressureTrigger.size() + 1) == -1)
+    {
+        SessionLog()("Memory pressure stall information unavailable. {}", strerror(errno));
+        if (pressureFd_ != -1)
+            ::close(pressureFd_);
+        pressureFd_ = -1;
+        return;
+    }
+
+    // PSI triggers are signalled as POLLPRI events.
+    pressureNotifier_ = std::make_unique<QSocketNotifier>(pressureFd_, QSocketNotifier::Exception);
+    QObject::connect(pressureNotifier_.get(), &QSocketNotifier::activated, [this]() {
+        SessionLog()("Memory pressure signalled by the system.");
+        releaseMemory();
+    });
+#elif defined(__APPLE__)
+    auto source = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE,
+                                         0,
+                                         DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+                                         dispatch_get_main_queue());
+    if (!source)
+        return;
+
+    dispatch_set_context(source, this);
+    dispatch_source_set_event_handler_f(source, [](void* _context) {
+        SessionLog()("Memory pressure signalled by the system.");
+        static_cast<MemoryBudget*>(_context)->releaseMemory();
+    });
+    dispatch_resume(source);
+    pressureSource_ = source;
+#endif
+}
+
+void MemoryBudget::add(TerminalSession& _session)
+{
+    auto const bytesParsed = _session.terminal().statistics().bytesParsed.load();
+    sessions_.emplace_back(Entry { &_session, bytesParsed, steady_clock::now(), 0 });
+}
+
+void MemoryBudget::remove(TerminalSession& _session)
+{
+    sessions_.erase(std::remove_if(sessions_.begin(),
+                                   sessions_.end(),
+                                   [&](Entry const& _entry) { return _entry.session == &_session; }),
+                    sessions_.end());
+}
+
+void MemoryBudget::updateActivity()
+{
+    auto const now = steady_clock::now();
+    for (Entry& entry: sessions_)
+    {
+        auto const bytesParsed = entry.session->terminal().statistics().bytesParsed.load();
+        if (bytesParsed != entry.bytesParsed)
+        {
+            entry.bytesParsed = bytesParsed;
+            entry.lastActive = now;
+        }
+    }
+
+    // The sessions idle the longest come first, and of these the oldest ones.
+    std::stable_sort(sessions_.begin(), sessions_.end(), [](Entry const& a, Entry const& b) {
+        if (a.lastActive != b.lastActive)
+            return a.lastActive < b.lastActive;
+        return a.session->startTime() < b.session->startTime();
+    });
+}
+
+void MemoryBudget::enforce(size_t _bytes)
+{
+    updateActivity();
+
+    auto usage = size_t { 0 };
+    for (Entry const& entry: sessions_)
+        usage += entry.session->terminal().historyMemoryUsage();
+    if (usage <= _bytes)
+        return;
+
+    SessionLog()("Scrollback memory usage of {} exceeds {}.",
+                 crispy::humanReadableBytes(usage),
+                 crispy::humanReadableBytes(_bytes));
+
+    // Compacting keeps all lines in the scrollback, so it is tried for all sessions first.
+    for (Entry& entry: sessions_)
+    {
+        if (entry.compactedAt == entry.bytesParsed)
+            continue;
+
+        auto& terminal = entry.session->terminal();
+        auto const before = terminal.historyMemoryUsage();
+        auto const bytesSaved = terminal.compactHistory();
+        auto const after = terminal.historyMemoryUsage();
+        entry.compactedAt = entry.bytesParsed;
+        usage -= std::min(usage, before - std::min(before, after));
+        SessionLog()("Compacted history of session started {} ago, saving {}.",
+                     std::chrono::duration_cast<std::chrono::seconds>(steady_clock::now()
+                                                                       - entry.session->startTime()),
+                     crispy::humanReadableBytes(bytesSaved));
+        if (usage <= _bytes)
+            return;
+    }
+
+    // Spilling keeps the history lines that are not part of the cold history tier yet.
+    for (Entry& entry: sessions_)
+    {
+        auto& terminal = entry.session->terminal();
+        auto const keep = terminal::LineCount::cast_from(
+            unbox<int>(terminal.pageSize().lines) * terminal::Grid<terminal::Cell>::ColdHistoryPageCount);
+        if (terminal.primaryScreen().historyLineCount() <= keep)
+            continue;
+
+        {
+            auto const _l = std::scoped_lock { terminal };
+            if (!entry.session->enableHistoryArchive())
+                return;
+        }
+
+        auto const before = terminal.historyMemoryUsage();
+        terminal.spillHistory(keep);
+        auto const after = terminal.historyMemoryUsage();
+        usage -= std::min(usage, before - std::min(before, after));
+        if (usage <= _bytes)
+            return;
+    }
+}
+
+void MemoryBudget::releaseMemory()
+{
+    updateActivity();
+
+    for (Entry& entry: sessions_)
+    {
+        auto& terminal = entry.session->terminal();
+        terminal.trimMemory();
+        terminal.releaseAlternateScreen();
+        if (auto* display = entry.session->display())
+            display->trimMemory();
+    }
+
+    if (scrollbackBytes_)
+        enforce(scrollbackBytes_ / 2);
+}
+
+void MemoryBudget::releaseIdleCaches()
+{
+    updateActivity();
+
+    auto const now = steady_clock::now();
+    for (Entry const& entry: sessions_)
+        if (now - entry.lastActive >= IdleCacheReleaseDelay)
+            if (auto* display = entry.session->display())
+                display->releaseGrownCaches();
+}
+
+} // namespace contour
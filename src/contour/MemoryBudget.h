@@ -0,0 +1,95 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <QtCore/QTimer>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class QSocketNotifier;
+
+namespace contour
+{
+
+class TerminalSession;
+
+/**
+ * Keeps the scrollback memory of all terminal sessions of this process within a global budget,
+ * and releases memory when the operating system signals memory pressure.
+ *
+ * When over budget, the history of the sessions that have been idle the longest is
+ * compacted first (as in the cold history tier). If that does not suffice, their oldest
+ * history lines are spilled into history archive files.
+ *
+ * Memory pressure is signalled by pressure stall information (PSI) on Linux and by a
+ * memory pressure dispatch source on macOS. It trims the caches of all sessions (texture atlas,
+ * text shaping caches, image pixels), releases unused alternate screens, and enforces
+ * half the budget.
+ *
+ * Sessions idle for a few minutes give back the memory of caches grown on heavy output.
+ *
+ * Lives on the GUI thread.
+ */
+class MemoryBudget
+{
+  public:
+    /// @param _scrollbackBytes the budget for the lines of all sessions, or 0 for unlimited.
+    explicit MemoryBudget(size_t _scrollbackBytes);
+    ~MemoryBudget();
+
+    MemoryBudget(MemoryBudget const&) = delete;
+    MemoryBudget& operator=(MemoryBudget const&) = delete;
+
+    void add(TerminalSession& _session);
+    void remove(TerminalSession& _session);
+
+    /// Brings the scrollback memory of all sessions down to @p _bytes, as far as possible.
+    void enforce(size_t _bytes);
+
+    /// Releases as much memory as possible without losing any visible state.
+    void releaseMemory();
+
+    /// Shrinks the grown caches of the sessions that have been idle for a while.
+    void releaseIdleCaches();
+
+  private:
+    using Timestamp = std::chrono::steady_clock::time_point;
+
+    struct Entry
+    {
+        TerminalSession* session;
+        uint64_t bytesParsed;   // output processed as of lastActive
+        Timestamp lastActive;   // last time output was seen
+        uint64_t compactedAt;   // bytesParsed at the last compaction, to not redo it while idle
+    };
+
+    void updateActivity();
+    void watchMemoryPressure();
+
+    size_t scrollbackBytes_;
+    std::vector<Entry> sessions_;
+    QTimer timer_;
+
+#if defined(__linux__)
+    int pressureFd_ = -1;
+    std::unique_ptr<QSocketNotifier> pressureNotifier_;
+#elif defined(__APPLE__)
+    void* pressureSource_ = nullptr; // dispatch_source_t
+#endif
+};
+
+} // namespace contour
@@ -0,0 +1,174 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/MetricsOverlay.h>
+
+#include <terminal/Image.h>
+
+#include <crispy/utils.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string_view>
+
+using std::chrono::duration;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+namespace contour
+{
+
+namespace
+{
+    double hitRate(crispy::LRUHashtableStats const& _stats) noexcept
+    {
+        auto const lookups = _stats.hits + _stats.misses;
+        return lookups ? 100.0 * static_cast<double>(_stats.hits) / static_cast<double>(lookups) : 100.0;
+    }
+
+    double milliseconds(MetricsOverlay::Clock::duration _time) noexcept
+    {
+        return static_cast<double>(duration_cast<microseconds>(_time).count()) / 1000.0;
+    }
+
+    /// Formats the contention of a lock within the last @p _seconds.
+    std::string lockContention(std::string_view _name,
+                               crispy::LockStats const& _current,
+                               crispy::LockStats const& _last,
+                               double _seconds)
+    {
+        auto const acquisitions = static_cast<double>(_current.acquisitions - _last.acquisitions);
+        auto const contended = static_cast<double>(_current.contended - _last.contended);
+        return fmt::format("{:<14}: {:.0f}/s, {:.1f}% contended, waited {:.2f} ms/s (max {:.2f} ms), "
+                           "held {:.0f}%",
+                           _name,
+                           acquisitions / _seconds,
+                           acquisitions > 0 ? 100.0 * contended / acquisitions : 0.0,
+                           milliseconds(_current.waitTime - _last.waitTime) / _seconds,
+                           milliseconds(_current.maxWaitTime),
+                           100.0 * duration<double>(_current.holdTime - _last.holdTime).count() / _seconds);
+    }
+} // namespace
+
+void MetricsOverlay::frameRendered(Clock::duration _frameTime) noexcept
+{
+    frameTimes_[frameCount_ % frameTimes_.size()] = _frameTime;
+    ++frameCount_;
+}
+
+void MetricsOverlay::displayShown(Clock::duration _latency) noexcept
+{
+    showLatency_ = _latency;
+    maxShowLatency_ = std::max(maxShowLatency_, _latency);
+}
+
+MetricsOverlay::Clock::duration MetricsOverlay::frameTimePercentile(unsigned _percentile) const
+{
+    auto const count = static_cast<size_t>(std::min(frameCount_, uint64_t { frameTimes_.size() }));
+    if (!count)
+        return {};
+
+    auto samples = std::vector<Clock::duration>(frameTimes_.begin(), frameTimes_.begin() + count);
+    auto const nth = samples.begin() + static_cast<std::ptrdiff_t>((count - 1) * _percentile / 100);
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+void MetricsOverlay::update(terminal::Terminal& _terminal,
+                            terminal::renderer::Renderer& _renderer,
+                            Clock::time_point _now)
+{
+    if (lastUpdate_ && _now - *lastUpdate_ < UpdateInterval)
+        return;
+
+    auto const& statistics = _terminal.statistics();
+    auto const frameStats = _terminal.frameScheduler().fetchAndClearStats(_now);
+    auto const counters = Counters { statistics.bytesParsed.load(),
+                                     statistics.renderBufferRefreshes.load(),
+                                     statistics.renderBufferSwaps.load(),
+                                     statistics.renderBufferSkips.load(),
+                                     frameCount_,
+                                     frameStats.skippedFrames,
+                                     statistics.synchronizedUpdates.load(),
+                                     statistics.synchronizedUpdateTimeouts.load(),
+                                     statistics.synchronizedUpdateBytes.load(),
+                                     statistics.synchronizedUpdateTime.load(),
+                                     _terminal.lockStats(),
+                                     _terminal.renderBufferLockStats(),
+                                     _renderer.imageDiscardLockStats() };
+    auto const cacheMetrics = _renderer.fetchAndClearCacheMetrics();
+
+    if (lastUpdate_)
+    {
+        auto const seconds = duration<double>(_now - *lastUpdate_).count();
+        auto const perSecond = [&](uint64_t _current, uint64_t _last) {
+            return static_cast<double>(_current - _last) / seconds;
+        };
+        auto const syncUpdates =
+            static_cast<double>(counters.synchronizedUpdates - lastCounters_.synchronizedUpdates);
+        auto const perSyncUpdate = [&](uint64_t _current, uint64_t _last) {
+            return syncUpdates > 0 ? static_cast<double>(_current - _last) / syncUpdates : 0.0;
+        };
+
+        lines_ = {
+            fmt::format("Parse         : {:.2f} MB/s",
+                        perSecond(counters.bytesParsed, lastCounters_.bytesParsed) / (1024.0 * 1024.0)),
+            fmt::format("Render buffer : {:.0f} refreshes/s, {:.0f} swaps/s, {:.0f} skips/s",
+                        perSecond(counters.renderBufferRefreshes, lastCounters_.renderBufferRefreshes),
+                        perSecond(counters.renderBufferSwaps, lastCounters_.renderBufferSwaps),
+                        perSecond(counters.renderBufferSkips, lastCounters_.renderBufferSkips)),
+            fmt::format("Frames        : {:.0f} fps, P50 {:.2f} ms, P99 {:.2f} ms",
+                        perSecond(counters.frames, lastCounters_.frames),
+                        milliseconds(frameTimePercentile(50)),
+                        milliseconds(frameTimePercentile(99))),
+            fmt::format("Frame pacing  : {}, budget {:.2f} ms, latency {:.2f} ms (max {:.2f}), {} skipped",
+                        frameStats.mode,
+                        milliseconds(frameStats.frameBudget),
+                        milliseconds(frameStats.lastLatency),
+                        milliseconds(frameStats.maxLatency),
+                        frameStats.skippedFrames - lastCounters_.skippedFrames),
+            fmt::format("Sync updates  : {:.0f}/s, avg {:.2f} ms, {:.0f} bytes, {} timed out",
+                        perSecond(counters.synchronizedUpdates, lastCounters_.synchronizedUpdates),
+                        perSyncUpdate(counters.synchronizedUpdateTime, lastCounters_.synchronizedUpdateTime)
+                            / 1000.0,
+                        perSyncUpdate(counters.synchronizedUpdateBytes,
+                                      lastCounters_.synchronizedUpdateBytes),
+                        counters.synchronizedUpdateTimeouts - lastCounters_.synchronizedUpdateTimeouts),
+            fmt::format("Texture atlas : {}/{} tiles, {:.1f}% occupied, {:.1f}% hit rate",
+                        cacheMetrics.atlasTiles,
+                        cacheMetrics.atlasCapacity,
+                        cacheMetrics.atlasOccupancy * 100.0,
+                        hitRate(cacheMetrics.atlas)),
+            fmt::format("Text shaping  : {:.1f}% hit rate", hitRate(cacheMetrics.shaping)),
+            fmt::format("Images        : {} resident",
+                        crispy::humanReadableBytes(
+                            static_cast<long double>(terminal::ImageStats::get().residentBytes))),
+            lockContention("Terminal lock", counters.terminalLock, lastCounters_.terminalLock, seconds),
+            lockContention(
+                "Frame lock", counters.renderBufferLock, lastCounters_.renderBufferLock, seconds),
+            lockContention(
+                "Image discard", counters.imageDiscardLock, lastCounters_.imageDiscardLock, seconds),
+        };
+
+        if (showLatency_)
+            lines_.emplace_back(fmt::format("Shown         : first frame after {:.2f} ms (max {:.2f} ms)",
+                                            milliseconds(*showLatency_),
+                                            milliseconds(maxShowLatency_)));
+    }
+
+    lastUpdate_ = _now;
+    lastCounters_ = counters;
+}
+
+} // namespace contour
@@ -0,0 +1,89 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Terminal.h>
+
+#include <terminal_renderer/Renderer.h>
+
+#include <crispy/InstrumentedMutex.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace contour
+{
+
+/**
+ * Gathers live performance metrics of a terminal and its renderer,
+ * formatted as text lines to be shown on top of the terminal.
+ *
+ * @see actions::ToggleMetricsOverlay
+ */
+class MetricsOverlay
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Interval at which the shown metrics are updated, keeping the numbers readable.
+    static constexpr auto UpdateInterval = std::chrono::milliseconds(500);
+
+    /// Records the time it took to render a single frame.
+    void frameRendered(Clock::duration _frameTime) noexcept;
+
+    /// Records the time it took from the display being shown again until its first frame was rendered.
+    void displayShown(Clock::duration _latency) noexcept;
+
+    /// Samples the counters of @p _terminal and @p _renderer, updating the shown metrics
+    /// if the last update is at least UpdateInterval ago.
+    void update(terminal::Terminal& _terminal,
+                terminal::renderer::Renderer& _renderer,
+                Clock::time_point _now);
+
+    [[nodiscard]] std::vector<std::string> const& lines() const noexcept { return lines_; }
+
+  private:
+    struct Counters
+    {
+        uint64_t bytesParsed = 0;
+        uint64_t renderBufferRefreshes = 0;
+        uint64_t renderBufferSwaps = 0;
+        uint64_t renderBufferSkips = 0;
+        uint64_t frames = 0;
+        uint64_t skippedFrames = 0;
+        uint64_t synchronizedUpdates = 0;
+        uint64_t synchronizedUpdateTimeouts = 0;
+        uint64_t synchronizedUpdateBytes = 0;
+        uint64_t synchronizedUpdateTime = 0;
+        crispy::LockStats terminalLock {};
+        crispy::LockStats renderBufferLock {};
+        crispy::LockStats imageDiscardLock {};
+    };
+
+    [[nodiscard]] Clock::duration frameTimePercentile(unsigned _percentile) const;
+
+    std::array<Clock::duration, 256> frameTimes_ {}; // ring buffer of the most recent frame times
+    uint64_t frameCount_ = 0;
+    std::optional<Clock::duration> showLatency_;
+    Clock::duration maxShowLatency_ {};
+    std::optional<Clock::time_point> lastUpdate_;
+    Counters lastCounters_ {};
+    std::vector<std::string> lines_;
+};
+
+} // namespace contour
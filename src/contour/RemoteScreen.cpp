@@ -0,0 +1,222 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/RemoteScreen.h>
+
+#include <terminal/Cell.h>
+#include <terminal/GridDiff.h>
+#include <terminal/Process.h>
+#include <terminal/Terminal.h>
+#include <terminal/VTWriter.h>
+#include <terminal/pty/Pty.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <variant>
+
+#if !defined(_WIN32)
+    #include <sys/ioctl.h>
+
+    #include <cerrno>
+    #include <poll.h>
+    #include <termios.h>
+    #include <unistd.h>
+#endif
+
+using namespace terminal;
+using std::make_unique;
+using std::nullopt;
+using std::vector;
+
+namespace contour
+{
+
+#if !defined(_WIN32)
+namespace
+{
+    constexpr size_t PtyBufferObjectSize = 1024u * 1024u;
+    constexpr size_t PtyReadBufferSize = 16384;
+
+    PageSize outputPageSize()
+    {
+        auto size = winsize {};
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row && size.ws_col)
+            return PageSize { LineCount(size.ws_row), ColumnCount(size.ws_col) };
+        return PageSize { LineCount(25), ColumnCount(80) };
+    }
+
+    bool writeToStdout(char const* _data, size_t _size)
+    {
+        while (_size != 0)
+        {
+            auto const n = ::write(STDOUT_FILENO, _data, _size);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                return false;
+            _data += n;
+            _size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    MirroredModes mirroredModes(Terminal const& _terminal)
+    {
+        auto modes = MirroredModes {};
+        modes.applicationCursorKeys = _terminal.isModeEnabled(DECMode::UseApplicationCursorKeys);
+        modes.applicationKeypad = _terminal.applicationKeypad();
+        modes.visibleCursor = _terminal.isModeEnabled(DECMode::VisibleCursor);
+        modes.bracketedPaste = _terminal.isModeEnabled(DECMode::BracketedPaste);
+        modes.focusTracking = _terminal.isModeEnabled(DECMode::FocusTracking);
+        for (size_t i = 0; i < MirroredModes::MouseModes.size(); ++i)
+            modes.mouseModes[i] = _terminal.isModeEnabled(MirroredModes::MouseModes[i]);
+        return modes;
+    }
+
+    /// Puts the TTY at standard input into raw mode for its lifetime, so that all input
+    /// is passed through to the remote program.
+    class RawInputMode
+    {
+      public:
+        RawInputMode()
+        {
+            if (tcgetattr(STDIN_FILENO, &saved_) != 0)
+                return;
+            auto raw = saved_;
+            cfmakeraw(&raw);
+            active_ = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+
+        ~RawInputMode()
+        {
+            if (active_)
+                tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+        }
+
+        RawInputMode(RawInputMode const&) = delete;
+        RawInputMode& operator=(RawInputMode const&) = delete;
+
+      private:
+        termios saved_ {};
+        bool active_ = false;
+    };
+} // namespace
+
+int runRemoteScreen(RemoteScreenSettings const& _settings)
+{
+    auto const program = _settings.program.empty() ? Process::loginShell() : _settings.program;
+    auto exec = Process::ExecInfo {};
+    exec.program = program.front();
+    exec.arguments.assign(program.begin() + 1, program.end());
+    exec.workingDirectory = FileSystem::current_path();
+
+    auto pageSize = outputPageSize();
+    auto events = Terminal::Events {};
+    auto terminal = Terminal { make_unique<Process>(exec, createPty(pageSize, nullopt)),
+                               PtyBufferObjectSize,
+                               PtyReadBufferSize,
+                               events };
+
+    auto const rawInputMode = RawInputMode {};
+    auto closed = std::atomic<bool> { false };   // the program's output ended
+    auto stopping = std::atomic<bool> { false }; // the screen is not mirrored anymore
+
+    auto outputThread = std::thread([&]() {
+        while (!stopping && terminal.processInputOnce())
+            ;
+        closed = true;
+    });
+
+    auto inputThread = std::thread([&]() {
+        char buffer[4096];
+        auto input = pollfd { STDIN_FILENO, POLLIN, 0 };
+        while (!stopping)
+        {
+            if (poll(&input, 1, 100) <= 0)
+                continue;
+            auto const n = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (n <= 0)
+                break;
+            terminal.device().write(buffer, static_cast<size_t>(n));
+        }
+    });
+
+    // The screen is sampled at the refresh rate, sending the latest state of its lines only.
+    auto const interval = std::chrono::duration<double>(1.0 / std::max(_settings.refreshRate, 1.0));
+    auto diff = GridDiffWriter<Cell> {};
+    auto output = vector<char> {};
+    auto writer = VTWriter(output);
+    auto lastCursor = CellLocation { LineOffset(-1), ColumnOffset(-1) };
+    for (auto done = false; !done;)
+    {
+        done = closed;
+
+        if (auto const newPageSize = outputPageSize(); newPageSize != pageSize)
+        {
+            pageSize = newPageSize;
+            terminal.resizeScreen(pageSize);
+        }
+
+        {
+            auto const _ = std::lock_guard { terminal };
+            auto const& grid = terminal.isPrimaryScreen() ? terminal.primaryScreen().grid()
+                                                          : terminal.alternateScreen().grid();
+            auto const cursor = terminal.realCursorPosition();
+            auto const modesChanged = diff.writeModes(mirroredModes(terminal), writer);
+            if (diff.write(grid, cursor, writer) == 0 && cursor == lastCursor && !modesChanged)
+                output.clear();
+            lastCursor = cursor;
+        }
+
+        if (!output.empty() && !writeToStdout(output.data(), output.size()))
+            break;
+        output.clear();
+
+        if (!done)
+            std::this_thread::sleep_for(interval);
+    }
+
+    // Leaves the terminal at standard output with its input modes reset.
+    output.clear();
+    diff.writeModes(MirroredModes {}, writer);
+    writeToStdout(output.data(), output.size());
+
+    stopping = true;
+    terminal.device().wakeupReader();
+    outputThread.join();
+    inputThread.join();
+    terminal.device().close();
+
+    auto const* process = dynamic_cast<Process const*>(&terminal.device());
+    auto const status = process ? process->checkStatus() : nullopt;
+    if (status && std::holds_alternative<Process::NormalExit>(*status))
+        return std::get<Process::NormalExit>(*status).exitCode;
+    return EXIT_FAILURE;
+}
+#else
+int runRemoteScreen(RemoteScreenSettings const& /*_settings*/)
+{
+    std::cerr << "The remote command is not supported on this platform.\n";
+    return EXIT_FAILURE;
+}
+#endif
+
+} // namespace contour
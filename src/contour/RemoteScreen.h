@@ -0,0 +1,39 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace contour
+{
+
+struct RemoteScreenSettings
+{
+    std::vector<std::string> program; // program and its arguments, or empty for the login shell
+    double refreshRate = 30.0;        // maximum number of screen updates per second
+};
+
+/// Runs a program in a headless terminal and mirrors its screen onto the terminal connected to
+/// standard output, such as a local contour on the other end of an SSH connection.
+///
+/// Only the lines that changed since the previous screen update are sent (see GridDiffWriter),
+/// so that output floods on the remote host do not saturate a slow link. Standard input
+/// is forwarded to the program as is, while the program's input modes are mirrored
+/// (see MirroredModes), so that the local terminal encodes keys and mouse as the program expects.
+///
+/// @returns the exit code of the program.
+int runRemoteScreen(RemoteScreenSettings const& _settings);
+
+} // namespace contour
@@ -25,6 +25,7 @@
 
 #include <chrono>
 #include <functional>
+#include <iosfwd>
 
 namespace contour
 {
@@ -62,9 +63,13 @@ class TerminalDisplay
     virtual void bell() = 0;
     virtual void copyToClipboard(std::string_view _data) = 0;
     virtual void inspect() = 0;
+    virtual void inspectMemoryUsage(std::ostream& _os) = 0;
+    virtual void trimMemory() = 0; // releases caches, such as when the system runs low on memory
+    virtual void releaseGrownCaches() = 0; // shrinks caches grown on heavy output, such as when idle
     virtual void notify(std::string_view _title, std::string_view _body) = 0;
     virtual void resizeWindow(terminal::LineCount, terminal::ColumnCount) = 0;
     virtual void resizeWindow(terminal::Width, terminal::Height) = 0;
+    virtual void runBenchmark() = 0; // runs termbench tests, or hides the results of the last run
     virtual void setBlurBehind(bool _enabled) = 0;
     virtual void setBackgroundImage(std::shared_ptr<terminal::BackgroundImage const> const&) = 0;
     virtual void setFonts(terminal::renderer::FontDescriptions _fontDescriptions) = 0;
@@ -76,6 +81,7 @@ class TerminalDisplay
     virtual void setWindowNormal() = 0;
     virtual void setWindowTitle(std::string_view _title) = 0;
     virtual void toggleFullScreen() = 0;
+    virtual void toggleMetricsOverlay() = 0;
     virtual void toggleTitleBar() = 0;
     virtual void setBackgroundOpacity(terminal::Opacity _opacity) = 0;
 
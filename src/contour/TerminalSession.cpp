@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include <contour/ContourGuiApp.h>
+#include <contour/MemoryBudget.h>
 #include <contour/TerminalSession.h>
 #include <contour/helper.h>
 
@@ -21,10 +22,15 @@
 #include <terminal/ViCommands.h>
 #include <terminal/pty/Pty.h>
 
+#include <crispy/App.h>
+#include <crispy/CacheRegistry.h>
+#include <crispy/PerfTrace.h>
 #include <crispy/StackTrace.h>
+#include <crispy/overloaded.h>
 
 #include <range/v3/all.hpp>
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
 #include <QtCore/QFileInfo>
 #include <QtCore/QMetaObject>
@@ -32,6 +38,7 @@
 #include <QtCore/QProcess>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
+#include <QtCore/QUuid>
 #include <QtGui/QClipboard>
 #include <QtGui/QDesktopServices>
 #include <QtGui/QKeyEvent>
@@ -41,7 +48,10 @@
 #include <QtWidgets/QMessageBox>
 
 #include <algorithm>
+#include <array>
 #include <fstream>
+#include <iostream>
+#include <utility>
 
 #include <QtNetwork/QHostInfo>
 
@@ -79,12 +89,30 @@ namespace
 
     void setThreadName(char const* name)
     {
+        CONTOUR_PERF_TRACE_THREAD(name);
 #if defined(__APPLE__)
         pthread_setname_np(name);
 #elif !defined(_WIN32)
         pthread_setname_np(pthread_self(), name);
 #endif
     }
+
+    constexpr auto SessionSnapshotInterval = std::chrono::seconds(30);
+
+    FileSystem::path sessionSnapshotDirectory()
+    {
+        auto const dataHome = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+        return FileSystem::path(dataHome.toStdString()) / "sessions";
+    }
+
+    /// Returns the lock that the session saving the snapshot at @p _path holds while it is running.
+    unique_ptr<QLockFile> sessionSnapshotLock(FileSystem::path const& _path)
+    {
+        auto lock = make_unique<QLockFile>(QString::fromStdString(_path.string() + ".lock"));
+        // Such a lock is stale once its process is gone, however long it was held.
+        lock->setStaleLockTime(0);
+        return lock;
+    }
 } // namespace
 
 TerminalSession::TerminalSession(unique_ptr<Pty> _pty,
@@ -138,14 +166,56 @@ TerminalSession::TerminalSession(unique_ptr<Pty> _pty,
 
     profile_ = *config_.profile(profileName_); // XXX do it again. but we've to be more efficient here
     configureTerminal();
+    terminal_.inputLatency().setEnabled(app_.measureInputLatency());
+
+    if (auto* memoryBudget = app_.memoryBudget())
+        memoryBudget->add(*this);
+
+    if (profile_.restoreSession)
+    {
+        restoreSessionSnapshot();
+        startSessionSnapshots();
+    }
+
+    if (auto const recordingPath = app_.outputRecordingPath())
+    {
+        try
+        {
+            terminal_.startOutputRecording(*recordingPath);
+        }
+        catch (exception const& e)
+        {
+            errorlog()("Failed to start output recording. {}", e.what());
+        }
+    }
 }
 
 TerminalSession::~TerminalSession()
 {
-    terminating_ = true;
+    if (auto* memoryBudget = app_.memoryBudget())
+        memoryBudget->remove(*this);
+
+    {
+        auto const _l = lock_guard { snapshotMutex_ };
+        terminating_ = true;
+    }
+    snapshotCondition_.notify_all();
     terminal_.device().wakeupReader();
     if (screenUpdateThread_)
         screenUpdateThread_->join();
+    if (snapshotThread_)
+        snapshotThread_->join();
+
+    if (snapshotLock_)
+    {
+        // Only sessions that are closed while their shell is still running are worth restoring.
+        auto ec = FileSystemError {};
+        if (!terminal_.device().isClosed())
+            saveSessionSnapshot();
+        else
+            FileSystem::remove(sessionSnapshotPath(), ec);
+        snapshotLock_.reset();
+    }
 }
 
 void TerminalSession::setDisplay(unique_ptr<TerminalDisplay> _display)
@@ -198,6 +268,127 @@ void TerminalSession::mainLoop()
     onClosed();
 }
 
+FileSystem::path TerminalSession::sessionSnapshotPath() const
+{
+    return sessionSnapshotDirectory() / fmt::format("{}.{}.vt", profileName_, sessionId_);
+}
+
+void TerminalSession::restoreSessionSnapshot()
+{
+    auto snapshots = vector<FileSystem::path> {};
+    auto ec = FileSystemError {};
+    for (auto const& entry: FileSystem::directory_iterator(sessionSnapshotDirectory(), ec))
+    {
+        auto const fileName = entry.path().filename().string();
+        auto const prefix = profileName_ + '.';
+        if (fileName.rfind(prefix, 0) == 0 && fileName.find('.', prefix.size()) == fileName.size() - 3
+            && entry.path().extension() == ".vt")
+            snapshots.push_back(entry.path());
+    }
+
+    for (auto const& path: snapshots)
+    {
+        // Snapshots of sessions that are still running are locked by them.
+        auto const lock = sessionSnapshotLock(path);
+        if (!lock->tryLock(0))
+            continue;
+
+        auto file = ifstream(path.string(), ios::binary);
+        if (!file.good())
+            continue;
+        auto const snapshot = string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        file.close();
+
+        // A snapshot is restored only once, such that other sessions of the same profile start anew.
+        FileSystem::remove(path, ec);
+
+        SessionLog()("Restoring session snapshot {} ({} bytes).", path.string(), snapshot.size());
+        terminal_.writeToScreen(snapshot);
+        return;
+    }
+}
+
+void TerminalSession::startSessionSnapshots()
+{
+    // Snapshots hold everything the terminal showed, so they are private to the user.
+    auto const directory = sessionSnapshotDirectory();
+    auto ec = FileSystemError {};
+    FileSystem::create_directories(directory, ec);
+    if (!ec)
+        FileSystem::permissions(directory, FileSystem::perms::owner_all, ec);
+    if (ec)
+    {
+        errorlog()(
+            "Failed to create directory for session snapshots {}. {}", directory.string(), ec.message());
+        return;
+    }
+
+    sessionId_ = QUuid::createUuid().toString(QUuid::WithoutBraces).toStdString();
+    snapshotLock_ = sessionSnapshotLock(sessionSnapshotPath());
+    if (!snapshotLock_->tryLock(0))
+    {
+        errorlog()("Failed to lock session snapshot {}.", sessionSnapshotPath().string());
+        snapshotLock_.reset();
+        return;
+    }
+
+    snapshotThread_ = make_unique<std::thread>(bind(&TerminalSession::sessionSnapshotLoop, this));
+}
+
+void TerminalSession::sessionSnapshotLoop()
+{
+    setThreadName("Terminal.Snapshot");
+
+    // Saved periodically rather than only when closing, so that a crash does not lose the session,
+    // but only if there was any output since, so that idle sessions do not cause any writes.
+    auto savedBytes = terminal_.statistics().bytesParsed.load(std::memory_order_relaxed);
+    auto lock = unique_lock { snapshotMutex_ };
+    while (!snapshotCondition_.wait_for(lock, SessionSnapshotInterval, [this]() { return terminating_; }))
+    {
+        auto const bytes = terminal_.statistics().bytesParsed.load(std::memory_order_relaxed);
+        if (bytes == savedBytes)
+            continue;
+        savedBytes = bytes;
+
+        lock.unlock();
+        saveSessionSnapshot();
+        lock.lock();
+    }
+}
+
+void TerminalSession::saveSessionSnapshot()
+{
+    auto const path = sessionSnapshotPath();
+    auto const snapshot = [this]() {
+        auto const _l = lock_guard { terminal_ };
+        return terminal_.primaryScreen().snapshot();
+    }();
+
+    // Written aside and moved over the previous snapshot, which is thus never seen half written.
+    auto const temporaryPath = FileSystem::path(path.string() + ".tmp");
+    auto ec = FileSystemError {};
+    auto written = false;
+    {
+        auto file = ofstream(temporaryPath.string(), ios::binary | ios::trunc);
+        FileSystem::permissions(
+            temporaryPath, FileSystem::perms::owner_read | FileSystem::perms::owner_write, ec);
+        file.write(snapshot.data(), static_cast<streamsize>(snapshot.size()));
+        written = file.good() && !ec;
+    }
+    if (!written)
+    {
+        errorlog()("Failed to write session snapshot {}.", path.string());
+        FileSystem::remove(temporaryPath, ec);
+        return;
+    }
+
+    FileSystem::rename(temporaryPath, path, ec);
+    if (ec)
+        errorlog()("Failed to write session snapshot {}. {}", path.string(), ec.message());
+    else
+        SessionLog()("Saved session snapshot {} ({} bytes).", path.string(), snapshot.size());
+}
+
 void TerminalSession::terminate()
 {
     if (!display_)
@@ -206,6 +397,96 @@ void TerminalSession::terminate()
     display_->closeDisplay();
 }
 
+// {{{ display events
+void TerminalSession::postEvent(DisplayEvent _event)
+{
+    if (!display_)
+        return;
+
+    auto const overflow = [&]() {
+        auto const _l = std::lock_guard { displayEventsOverflowLock_ };
+        if (!displayEventsOverflowing_ && displayEvents_.tryPush(std::move(_event)))
+            return;
+        displayEventsOverflow_.emplace_back(std::move(_event));
+        displayEventsOverflowing_ = true;
+    };
+
+    // The display's thread is far behind if the queue is full. The event is then queued behind
+    // the others rather than lost.
+    if (displayEventsOverflowing_ || !displayEvents_.tryPush(std::move(_event)))
+        overflow();
+
+    if (!displayEventsPosted_.exchange(true))
+        display_->post([this]() { drainEvents(); });
+}
+
+void TerminalSession::drainEvents()
+{
+    // Events pushed from here on are drained by another invocation.
+    displayEventsPosted_.store(false);
+
+    auto events = vector<DisplayEvent> {};
+    while (auto event = displayEvents_.tryPop())
+        events.emplace_back(std::move(*event));
+
+    if (displayEventsOverflowing_)
+    {
+        // Events pushed before the overflow started may have arrived meanwhile and go first.
+        auto const _l = std::lock_guard { displayEventsOverflowLock_ };
+        while (auto event = displayEvents_.tryPop())
+            events.emplace_back(std::move(*event));
+        for (auto& event: displayEventsOverflow_)
+            events.emplace_back(std::move(event));
+        displayEventsOverflow_.clear();
+        displayEventsOverflowing_ = false;
+    }
+
+    // Of the events that replace the effect of the previous ones of their kind, only the latest
+    // is handled, such as of a burst of window title changes.
+    auto const replacing = [](DisplayEvent const& _event) {
+        return !holds_alternative<CaptureBufferEvent>(_event) && !holds_alternative<SetFontDefEvent>(_event)
+               && !holds_alternative<CopyToClipboardEvent>(_event);
+    };
+    auto seen = array<bool, variant_size_v<DisplayEvent>> {};
+    auto superseded = vector<bool>(events.size());
+    for (auto i = events.size(); i-- > 0;)
+    {
+        if (!replacing(events[i]))
+            continue;
+        superseded[i] = seen[events[i].index()];
+        seen[events[i].index()] = true;
+    }
+
+    for (size_t i = 0; i < events.size(); ++i)
+        if (!superseded[i])
+            handleEvent(events[i]);
+}
+
+void TerminalSession::handleEvent(DisplayEvent const& _event)
+{
+    visit(overloaded { [&](BufferChangedEvent const& _e) { display_->bufferChanged(_e.screenType); },
+                       [&](FlushInputEvent const&) { flushInput(); },
+                       [&](CaptureBufferEvent const& _e) {
+                           if (display_->requestPermission(profile_.permissions.captureBuffer,
+                                                           "capture screen buffer"))
+                           {
+                               terminal_.primaryScreen().captureBuffer(_e.lineCount, _e.logical);
+                               DisplayLog()("requestCaptureBuffer: Finished. Waking up I/O thread.");
+                               flushInput();
+                           }
+                       },
+                       [&](SetFontDefEvent const& _e) { applyFontDef(_e.fontDef); },
+                       [&](CopyToClipboardEvent const& _e) { display_->copyToClipboard(_e.text); },
+                       [&](ResizeWindowEvent const& _e) { display_->resizeWindow(_e.lines, _e.columns); },
+                       [&](ResizeWindowPixelsEvent const& _e) {
+                           display_->resizeWindow(_e.width, _e.height);
+                       },
+                       [&](SetWindowTitleEvent const& _e) { display_->setWindowTitle(_e.title); },
+                       [&](ActivateProfileEvent const& _e) { activateProfile(_e.profileName); } },
+          _event);
+}
+// }}}
+
 // {{{ Events implementations
 void TerminalSession::bell()
 {
@@ -217,7 +498,7 @@ void TerminalSession::bell()
 
 void TerminalSession::bufferChanged(terminal::ScreenType _type)
 {
-    display_->post([this, _type]() { display_->bufferChanged(_type); });
+    postEvent(BufferChangedEvent { _type });
 }
 
 void TerminalSession::screenUpdated()
@@ -227,7 +508,7 @@ void TerminalSession::screenUpdated()
         terminal().viewport().scrollToBottom();
 
     if (terminal().hasInput())
-        display_->post(bind(&TerminalSession::flushInput, this));
+        postEvent(FlushInputEvent {});
 
     scheduleRedraw();
 }
@@ -236,7 +517,7 @@ void TerminalSession::flushInput()
 {
     terminal().flushInput();
     if (terminal().hasInput())
-        display_->post(bind(&TerminalSession::flushInput, this));
+        postEvent(FlushInputEvent {});
 }
 
 void TerminalSession::renderBufferUpdated()
@@ -249,14 +530,7 @@ void TerminalSession::renderBufferUpdated()
 
 void TerminalSession::requestCaptureBuffer(LineCount lines, bool logical)
 {
-    display_->post([this, lines, logical]() {
-        if (display_->requestPermission(profile_.permissions.captureBuffer, "capture screen buffer"))
-        {
-            terminal_.primaryScreen().captureBuffer(lines, logical);
-            DisplayLog()("requestCaptureBuffer: Finished. Waking up I/O thread.");
-            flushInput();
-        }
-    });
+    postEvent(CaptureBufferEvent { lines, logical });
 }
 
 terminal::FontDef TerminalSession::getFontDef()
@@ -266,49 +540,49 @@ terminal::FontDef TerminalSession::getFontDef()
 
 void TerminalSession::setFontDef(terminal::FontDef const& _fontDef)
 {
-    display_->post([this, spec = terminal::FontDef(_fontDef)]() {
-        if (!display_->requestPermission(profile_.permissions.changeFont, "changing font"))
-            return;
+    postEvent(SetFontDefEvent { _fontDef });
+}
 
-        auto const& currentFonts = profile_.fonts;
-        terminal::renderer::FontDescriptions newFonts = currentFonts;
+void TerminalSession::applyFontDef(terminal::FontDef const& spec)
+{
+    if (!display_->requestPermission(profile_.permissions.changeFont, "changing font"))
+        return;
 
-        if (spec.size != 0.0)
-            newFonts.size = text::font_size { spec.size };
+    auto const& currentFonts = profile_.fonts;
+    terminal::renderer::FontDescriptions newFonts = currentFonts;
 
-        if (!spec.regular.empty())
-            newFonts.regular = text::font_description::parse(spec.regular);
+    if (spec.size != 0.0)
+        newFonts.size = text::font_size { spec.size };
 
-        auto const styledFont = [&](string_view _font) -> text::font_description {
-            // if a styled font is "auto" then infer froom regular font"
-            if (_font == "auto"sv)
-                return currentFonts.regular;
-            else
-                return text::font_description::parse(_font);
-        };
+    if (!spec.regular.empty())
+        newFonts.regular = text::font_description::parse(spec.regular);
 
-        if (!spec.bold.empty())
-            newFonts.bold = styledFont(spec.bold);
+    auto const styledFont = [&](string_view _font) -> text::font_description {
+        // if a styled font is "auto" then infer froom regular font"
+        if (_font == "auto"sv)
+            return currentFonts.regular;
+        else
+            return text::font_description::parse(_font);
+    };
 
-        if (!spec.italic.empty())
-            newFonts.italic = styledFont(spec.italic);
+    if (!spec.bold.empty())
+        newFonts.bold = styledFont(spec.bold);
 
-        if (!spec.boldItalic.empty())
-            newFonts.boldItalic = styledFont(spec.boldItalic);
+    if (!spec.italic.empty())
+        newFonts.italic = styledFont(spec.italic);
 
-        if (!spec.emoji.empty() && spec.emoji != "auto"sv)
-            newFonts.emoji = text::font_description::parse(spec.emoji);
+    if (!spec.boldItalic.empty())
+        newFonts.boldItalic = styledFont(spec.boldItalic);
 
-        display_->setFonts(newFonts);
-    });
+    if (!spec.emoji.empty() && spec.emoji != "auto"sv)
+        newFonts.emoji = text::font_description::parse(spec.emoji);
+
+    display_->setFonts(newFonts);
 }
 
 void TerminalSession::copyToClipboard(std::string_view _data)
 {
-    if (!display_)
-        return;
-
-    display_->post([this, data = string(_data)]() { display_->copyToClipboard(data); });
+    postEvent(CopyToClipboardEvent { string(_data) });
 }
 
 void TerminalSession::inspect()
@@ -329,6 +603,40 @@ void TerminalSession::notify(string_view _title, string_view _content)
     display_->notify(_title, _content);
 }
 
+void TerminalSession::inspectMemoryUsage(std::ostream& _os)
+{
+    _os << fmt::format("Memory usage of terminal session (profile: {}, page size: {}, max history: {})\n\n",
+                       profileName_,
+                       terminal_.pageSize(),
+                       terminal_.maxHistoryLineCount());
+    terminal_.inspectMemoryUsage(_os);
+    if (display_)
+        display_->inspectMemoryUsage(_os);
+}
+
+bool TerminalSession::enableHistoryArchive()
+{
+    if (terminal_.primaryScreen().grid().historyArchive())
+        return true;
+
+    auto const directory = crispy::App::instance()->localStateDir() / "history";
+    auto const fileName = fmt::format("{}-{}.vt",
+                                      QCoreApplication::applicationPid(),
+                                      QUuid::createUuid().toString(QUuid::WithoutBraces).toStdString());
+    auto const path = directory / fileName;
+    try
+    {
+        FileSystem::create_directories(directory);
+        terminal_.enableHistoryArchive(path);
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        errorlog()("Failed to create history archive at {}. {}", path.string(), e.what());
+        return false;
+    }
+}
+
 void TerminalSession::onClosed()
 {
     auto const now = steady_clock::now();
@@ -346,6 +654,9 @@ void TerminalSession::onClosed()
     else
         SessionLog()("Process terminated after {} seconds.", diff.count());
 
+    if (app_.reportMemoryAtExit() && display_)
+        display_->post([this]() { inspectMemoryUsage(std::cout); });
+
     if (onExit_)
         onExit_();
 
@@ -394,27 +705,26 @@ void TerminalSession::pasteFromClipboard(unsigned count)
         SessionLog()("Could not access clipboard.");
 }
 
+void TerminalSession::copySelectionToClipboard(QClipboard::Mode _mode)
+{
+    // The selection is extracted while the clipboard already holds it, as it may take a while
+    // with a selection spanning the history. What is being copied is fixed right here though,
+    // as the selection may well be changed or cleared in the meantime.
+    auto const selection =
+        make_shared<terminal::Terminal::SelectionSnapshot const>(terminal_.snapshotSelection());
+    clipboardWriter_.copy(_mode, [this, selection](ClipboardWriter::Sink const& _sink) {
+        terminal_.extractSelectionText(*selection, _sink);
+    });
+}
+
 void TerminalSession::onSelectionCompleted()
 {
     switch (config_.onMouseSelection)
     {
         case config::SelectionAction::CopyToSelectionClipboard:
-            if (QClipboard* clipboard = QGuiApplication::clipboard();
-                clipboard != nullptr && clipboard->supportsSelection())
-            {
-                string const text = terminal().extractSelectionText();
-                clipboard->setText(QString::fromUtf8(text.c_str(), static_cast<int>(text.size())),
-                                   QClipboard::Selection);
-            }
-            break;
-        case config::SelectionAction::CopyToClipboard:
-            if (QClipboard* clipboard = QGuiApplication::clipboard(); clipboard != nullptr)
-            {
-                string const text = terminal().extractSelectionText();
-                clipboard->setText(QString::fromUtf8(text.c_str(), static_cast<int>(text.size())),
-                                   QClipboard::Clipboard);
-            }
+            copySelectionToClipboard(QClipboard::Selection);
             break;
+        case config::SelectionAction::CopyToClipboard: copySelectionToClipboard(QClipboard::Clipboard); break;
         case config::SelectionAction::Nothing: break;
     }
 }
@@ -425,7 +735,7 @@ void TerminalSession::resizeWindow(LineCount _lines, ColumnCount _columns)
         return;
 
     SessionLog()("Application request to resize window: {}x{} px", _columns, _lines);
-    display_->post([this, _lines, _columns]() { display_->resizeWindow(_lines, _columns); });
+    postEvent(ResizeWindowEvent { _lines, _columns });
 }
 
 void TerminalSession::resizeWindow(Width _width, Height _height)
@@ -434,23 +744,17 @@ void TerminalSession::resizeWindow(Width _width, Height _height)
         return;
 
     SessionLog()("Application request to resize window: {}x{} px", _width, _height);
-    display_->post([this, _width, _height]() { display_->resizeWindow(_width, _height); });
+    postEvent(ResizeWindowPixelsEvent { _width, _height });
 }
 
 void TerminalSession::setWindowTitle(string_view _title)
 {
-    if (!display_)
-        return;
-
-    display_->post([this, terminalTitle = string(_title)]() { display_->setWindowTitle(terminalTitle); });
+    postEvent(SetWindowTitleEvent { string(_title) });
 }
 
 void TerminalSession::setTerminalProfile(string const& _configProfileName)
 {
-    if (!display_)
-        return;
-
-    display_->post([this, name = string(_configProfileName)]() { activateProfile(name); });
+    postEvent(ActivateProfileEvent { _configProfileName });
 }
 
 void TerminalSession::discardImage(terminal::Image const& _image)
@@ -475,6 +779,15 @@ void TerminalSession::inputModeChanged(terminal::ViMode mode)
     }
 }
 
+void TerminalSession::hintPicked(terminal::Hint const& _hint)
+{
+    // URLs are opened, whereas paths and git hashes are most useful when pasted into a command line.
+    if (_hint.kind == terminal::HintKind::Url)
+        followHyperlink(terminal::HyperlinkInfo { {}, _hint.text });
+    else
+        copyToClipboard(_hint.text);
+}
+
 // }}}
 // {{{ Input Events
 void TerminalSession::sendKeyPressEvent(Key _key, Modifier _modifier, Timestamp _now)
@@ -489,8 +802,9 @@ void TerminalSession::sendKeyPressEvent(Key _key, Modifier _modifier, Timestamp
 
     display_->setMouseCursorShape(MouseCursorShape::Hidden);
 
+    auto const& mappings = config_.inputMappings;
     if (auto const* actions =
-            config::apply(config_.inputMappings.keyMappings, _key, _modifier, matchModeFlags()))
+            config::apply(mappings.keyMappings, mappings.keyIndex, _key, _modifier, matchModeFlags()))
         executeAllActions(*actions);
     else
         terminal().sendKeyPressEvent(_key, _modifier, _now);
@@ -511,8 +825,9 @@ void TerminalSession::sendCharPressEvent(char32_t _value, Modifier _modifier, Ti
 
     display_->setMouseCursorShape(MouseCursorShape::Hidden);
 
+    auto const& mappings = config_.inputMappings;
     if (auto const* actions =
-            config::apply(config_.inputMappings.charMappings, _value, _modifier, matchModeFlags()))
+            config::apply(mappings.charMappings, mappings.charIndex, _value, _modifier, matchModeFlags()))
         executeAllActions(*actions);
     else
         terminal().sendCharPressEvent(_value, _modifier, _now); // TODO: get rid of Event{} struct here, too!
@@ -532,8 +847,9 @@ void TerminalSession::sendMousePressEvent(Modifier _modifier,
         return;
     }
 
+    auto const& mappings = config_.inputMappings;
     if (auto const* actions =
-            config::apply(config_.inputMappings.mouseMappings, _button, _modifier, matchModeFlags()))
+            config::apply(mappings.mouseMappings, mappings.mouseIndex, _button, _modifier, matchModeFlags()))
     {
         if (executeAllActions(*actions))
             return;
@@ -546,6 +862,17 @@ void TerminalSession::sendMousePressEvent(Modifier _modifier,
     scheduleRedraw();
 }
 
+bool TerminalSession::sendPixelScrollEvent(Modifier _modifier, int _pixels)
+{
+    // Applications tracking the mouse, and modified wheel events, get the usual wheel events.
+    if (!profile_.smoothScrolling || !display_ || !_modifier.none() || !terminal().isPrimaryScreen()
+        || terminal().state().inputGenerator.mouseProtocol().has_value())
+        return false;
+
+    terminal().viewport().scrollPixels(_pixels, unbox<int>(display_->cellSize().height));
+    return true;
+}
+
 void TerminalSession::sendMouseMoveEvent(terminal::Modifier _modifier,
                                          terminal::CellLocation _pos,
                                          terminal::PixelCoordinate _pixelPosition,
@@ -644,7 +971,7 @@ bool TerminalSession::operator()(actions::CopyPreviousMarkRange)
 
 bool TerminalSession::operator()(actions::CopySelection)
 {
-    copyToClipboard(terminal().extractSelectionText());
+    copySelectionToClipboard(QClipboard::Clipboard);
     return true;
 }
 
@@ -668,6 +995,24 @@ bool TerminalSession::operator()(actions::DecreaseOpacity)
     return true;
 }
 
+bool TerminalSession::operator()(actions::DumpCacheStatistics)
+{
+    crispy::CacheRegistry::get().inspect(std::cout);
+    return true;
+}
+
+bool TerminalSession::operator()(actions::DumpMemoryUsage)
+{
+    inspectMemoryUsage(std::cout);
+    return true;
+}
+
+bool TerminalSession::operator()(actions::FocusNextPane)
+{
+    emit focusNextPaneRequested();
+    return true;
+}
+
 bool TerminalSession::operator()(actions::FollowHyperlink)
 {
     auto const _l = scoped_lock { terminal() };
@@ -679,6 +1024,11 @@ bool TerminalSession::operator()(actions::FollowHyperlink)
     return false;
 }
 
+bool TerminalSession::operator()(actions::HintMode)
+{
+    return terminal().startHintMode();
+}
+
 bool TerminalSession::operator()(actions::IncreaseFontSize)
 {
     auto constexpr OnePt = text::font_size { 1.0 };
@@ -770,6 +1120,13 @@ bool TerminalSession::operator()(actions::ResetFontSize)
     return true;
 }
 
+bool TerminalSession::operator()(actions::RunBenchmark)
+{
+    if (display_)
+        display_->runBenchmark();
+    return true;
+}
+
 bool TerminalSession::operator()(actions::ScreenshotVT)
 {
     auto _l = lock_guard { terminal() };
@@ -853,6 +1210,18 @@ bool TerminalSession::operator()(actions::SendChars const& _event)
     return true;
 }
 
+bool TerminalSession::operator()(actions::SplitHorizontally)
+{
+    emit splitRequested(Qt::Horizontal);
+    return true;
+}
+
+bool TerminalSession::operator()(actions::SplitVertically)
+{
+    emit splitRequested(Qt::Vertical);
+    return true;
+}
+
 bool TerminalSession::operator()(actions::ToggleAllKeyMaps)
 {
     allowKeyMappings_ = !allowKeyMappings_;
@@ -867,6 +1236,13 @@ bool TerminalSession::operator()(actions::ToggleFullscreen)
     return true;
 }
 
+bool TerminalSession::operator()(actions::ToggleMetricsOverlay)
+{
+    if (display_)
+        display_->toggleMetricsOverlay();
+    return true;
+}
+
 bool TerminalSession::operator()(actions::ToggleTitleBar)
 {
     if (display_)
@@ -952,18 +1328,21 @@ bool TerminalSession::executeAction(actions::Action const& _action)
     return visit(*this, _action);
 }
 
-void TerminalSession::spawnNewTerminal(string const& _profileName)
+string TerminalSession::currentWorkingDirectory()
 {
-    auto const wd = [this]() -> string {
 #if defined(__APPLE__)
-        if (auto const* ptyProcess = dynamic_cast<Process const*>(&terminal_.device()))
-            return ptyProcess->workingDirectory();
+    if (auto const* ptyProcess = dynamic_cast<Process const*>(&terminal_.device()))
+        return ptyProcess->workingDirectory();
 #else
-        auto const _l = scoped_lock { terminal_ };
-        return terminal_.currentWorkingDirectory();
+    auto const _l = scoped_lock { terminal_ };
+    return terminal_.currentWorkingDirectory();
 #endif
-        return "."s;
-    }();
+    return "."s;
+}
+
+void TerminalSession::spawnNewTerminal(string const& _profileName)
+{
+    auto const wd = currentWorkingDirectory();
 
     if (config_.spawnNewProcess)
     {
@@ -988,19 +1367,26 @@ void TerminalSession::activateProfile(string const& _newProfileName)
 
     SessionLog()("Changing profile to {}.", _newProfileName);
     profileName_ = _newProfileName;
-    profile_ = *newProfile;
-    configureTerminal();
-    configureDisplay();
+    auto const previousProfile = std::exchange(profile_, *newProfile);
+
+    // Only re-apply what actually changed, so that e.g. a color change on config reload
+    // does neither reset the window state nor any font or glyph caches.
+    configureTerminal(&previousProfile);
+    configureDisplay(&previousProfile);
 }
 
-void TerminalSession::configureTerminal()
+void TerminalSession::configureTerminal(config::TerminalProfile const* _previousProfile)
 {
     auto const _l = scoped_lock { terminal_ };
     SessionLog()("Configuring terminal.");
 
     terminal_.setWordDelimiters(config_.wordDelimiters);
+    terminal_.setParallelParsing(config_.parallelParsing);
     terminal_.setMouseProtocolBypassModifier(config_.bypassMouseProtocolModifier);
     terminal_.setMouseBlockSelectionModifier(config_.mouseBlockSelectionModifier);
+    terminal_.setMouseCoalescingWindow(config_.mouseCoalescingWindow);
+    terminal_.setSynchronizedOutputTimeout(config_.synchronizedOutputTimeout);
+    terminal_.setAlternateScreenReleaseTimeout(config_.alternateScreenReleaseTimeout);
     terminal_.setLastMarkRangeOffset(profile_.copyLastMarkRangeOffset);
 
     SessionLog()("Setting terminal ID to {}.", profile_.terminalId);
@@ -1008,6 +1394,8 @@ void TerminalSession::configureTerminal()
     terminal_.setSixelCursorConformance(config_.sixelCursorConformance);
     terminal_.setMaxImageColorRegisters(config_.maxImageColorRegisters);
     terminal_.setMaxImageSize(config_.maxImageSize);
+    terminal_.setMaxImageMemory(size_t(config_.maxImageMemory) * 1024 * 1024);
+    terminal_.setKittyGraphicsFileAccess(profile_.permissions.readImageFiles == config::Permission::Allow);
     terminal_.setMode(terminal::DECMode::SixelScrolling, config_.sixelScrolling);
     SessionLog()("maxImageSize={}, sixelScrolling={}", config_.maxImageSize, config_.sixelScrolling);
 
@@ -1016,9 +1404,20 @@ void TerminalSession::configureTerminal()
     //     return;
 
     configureCursor(profile_.inputModes.insert.cursor);
-    terminal_.colorPalette() = profile_.colors;
-    terminal_.defaultColorPalette() = profile_.colors;
-    terminal_.setMaxHistoryLineCount(profile_.maxHistoryLineCount);
+
+    if (!_previousProfile || _previousProfile->colors != profile_.colors)
+    {
+        terminal_.colorPalette() = profile_.colors;
+        terminal_.defaultColorPalette() = profile_.colors;
+    }
+
+    if (!_previousProfile || _previousProfile->maxHistoryLineCount != profile_.maxHistoryLineCount)
+        terminal_.setMaxHistoryLineCount(profile_.maxHistoryLineCount);
+    if (profile_.infiniteHistory)
+        enableHistoryArchive();
+
+    terminal_.setSearchIndexEnabled(profile_.historySearchIndex);
+    terminal_.predictiveEcho().setEnabled(profile_.predictiveEcho);
 }
 
 void TerminalSession::configureCursor(config::CursorConfig const& cursorConfig)
@@ -1028,22 +1427,30 @@ void TerminalSession::configureCursor(config::CursorConfig const& cursorConfig)
     terminal_.setCursorShape(cursorConfig.cursorShape);
 }
 
-void TerminalSession::configureDisplay()
+void TerminalSession::configureDisplay(config::TerminalProfile const* _previousProfile)
 {
     if (!display_)
         return;
 
     SessionLog()("Configuring display.");
-    display_->setBlurBehind(profile_.backgroundBlur);
+    if (!_previousProfile || _previousProfile->backgroundBlur != profile_.backgroundBlur)
+        display_->setBlurBehind(profile_.backgroundBlur);
 
-    display_->setBackgroundImage(profile_.colors.backgroundImage);
+    if (!_previousProfile
+        || !terminal::equalBackgroundImages(_previousProfile->colors.backgroundImage,
+                                            profile_.colors.backgroundImage))
+        display_->setBackgroundImage(profile_.colors.backgroundImage);
 
-    if (profile_.maximized)
-        display_->setWindowMaximized();
-    else
-        display_->setWindowNormal();
+    if (!_previousProfile || _previousProfile->maximized != profile_.maximized)
+    {
+        if (profile_.maximized)
+            display_->setWindowMaximized();
+        else
+            display_->setWindowNormal();
+    }
 
-    if (profile_.fullscreen != display_->isFullScreen())
+    if ((!_previousProfile || _previousProfile->fullscreen != profile_.fullscreen)
+        && profile_.fullscreen != display_->isFullScreen())
         display_->toggleFullScreen();
 
     terminal_.setRefreshRate(display_->refreshRate());
@@ -1173,7 +1580,8 @@ void TerminalSession::followHyperlink(terminal::HyperlinkInfo const& _hyperlink)
     else if (isLocal)
         QDesktopServices::openUrl(QUrl::fromLocalFile(QString::fromUtf8(string(_hyperlink.path()).c_str())));
     else
-        QDesktopServices::openUrl(QString::fromUtf8(_hyperlink.uri.c_str()));
+        QDesktopServices::openUrl(
+            QString::fromUtf8(_hyperlink.uri.data(), static_cast<int>(_hyperlink.uri.size())));
 }
 
 bool TerminalSession::requestPermission(config::Permission _allowedByConfig, string_view _topicText)
@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include <contour/Clipboard.h>
 #include <contour/Config.h>
 #include <contour/TerminalDisplay.h>
 
@@ -20,12 +21,20 @@
 
 #include <terminal_renderer/Renderer.h>
 
+#include <crispy/MPSCQueue.h>
 #include <crispy/point.h>
 
 #include <QtCore/QFileSystemWatcher>
+#include <QtCore/QLockFile>
+#include <QtCore/Qt>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <mutex>
 #include <thread>
+#include <variant>
 
 namespace contour
 {
@@ -80,6 +89,17 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
     terminal::Terminal const& terminal() const noexcept { return terminal_; }
     terminal::ScreenType currentScreenType() const noexcept { return currentScreenType_; }
 
+    /// Writes a breakdown of the memory held by this session's terminal and display into @p _os.
+    ///
+    /// Must be called from within the display's thread.
+    void inspectMemoryUsage(std::ostream& _os);
+
+    /// Lets the lines leaving the primary screen's history spill over into a file of this session,
+    /// where they can still be scrolled back to, unless this is the case already.
+    ///
+    /// Must be called with the terminal locked. Returns false if the file could not be created.
+    bool enableHistoryArchive();
+
     TerminalDisplay* display() noexcept { return display_; }
     TerminalDisplay const* display() const noexcept { return display_; }
     void setDisplay(std::unique_ptr<TerminalDisplay> _display);
@@ -106,6 +126,7 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
     void setTerminalProfile(std::string const& _configProfileName) override;
     void discardImage(terminal::Image const&) override;
     void inputModeChanged(terminal::ViMode mode) override;
+    void hintPicked(terminal::Hint const& _hint) override;
 
     // Input Events
     using Timestamp = std::chrono::steady_clock::time_point;
@@ -116,6 +137,12 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
                              terminal::MouseButton _button,
                              terminal::PixelCoordinate _pixelPosition,
                              Timestamp _now);
+
+    /// Scrolls the history by the given number of pixels, as reported by touchpads.
+    ///
+    /// @returns false if the event is to be handled as a mouse wheel event instead.
+    bool sendPixelScrollEvent(terminal::Modifier _modifier, int _pixels);
+
     void sendMouseMoveEvent(terminal::Modifier _modifier,
                             terminal::CellLocation _pos,
                             terminal::PixelCoordinate _pixelPosition,
@@ -136,7 +163,11 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
     bool operator()(actions::CopySelection);
     bool operator()(actions::DecreaseFontSize);
     bool operator()(actions::DecreaseOpacity);
+    bool operator()(actions::DumpCacheStatistics);
+    bool operator()(actions::DumpMemoryUsage);
+    bool operator()(actions::FocusNextPane);
     bool operator()(actions::FollowHyperlink);
+    bool operator()(actions::HintMode);
     bool operator()(actions::IncreaseFontSize);
     bool operator()(actions::IncreaseOpacity);
     bool operator()(actions::NewTerminal const&);
@@ -148,6 +179,7 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
     bool operator()(actions::ReloadConfig const&);
     bool operator()(actions::ResetConfig);
     bool operator()(actions::ResetFontSize);
+    bool operator()(actions::RunBenchmark);
     bool operator()(actions::ScreenshotVT);
     bool operator()(actions::ScrollDown);
     bool operator()(actions::ScrollMarkDown);
@@ -160,8 +192,11 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
     bool operator()(actions::ScrollToTop);
     bool operator()(actions::ScrollUp);
     bool operator()(actions::SendChars const& _event);
+    bool operator()(actions::SplitHorizontally);
+    bool operator()(actions::SplitVertically);
     bool operator()(actions::ToggleAllKeyMaps);
     bool operator()(actions::ToggleFullscreen);
+    bool operator()(actions::ToggleMetricsOverlay);
     bool operator()(actions::ToggleTitleBar);
     bool operator()(actions::ViNormalMode);
     bool operator()(actions::WriteScreen const& _event);
@@ -186,10 +221,46 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
         return uptimeSecs;
     }
 
+    /// @returns the working directory of the application running in this session, as far as known.
+    std::string currentWorkingDirectory();
+
+  Q_SIGNALS:
+    /// Asks the window to split this session's pane, putting a new session next to it.
+    void splitRequested(Qt::Orientation _orientation);
+    void focusNextPaneRequested();
+
   public Q_SLOTS:
     void onConfigReload();
 
   private:
+    // {{{ display events
+    // Terminal events to be handled on the display's thread.
+    struct BufferChangedEvent { terminal::ScreenType screenType; };
+    struct FlushInputEvent {};
+    struct CaptureBufferEvent { terminal::LineCount lineCount; bool logical; };
+    struct SetFontDefEvent { terminal::FontDef fontDef; };
+    struct CopyToClipboardEvent { std::string text; };
+    struct ResizeWindowEvent { terminal::LineCount lines; terminal::ColumnCount columns; };
+    struct ResizeWindowPixelsEvent { terminal::Width width; terminal::Height height; };
+    struct SetWindowTitleEvent { std::string title; };
+    struct ActivateProfileEvent { std::string profileName; };
+
+    using DisplayEvent = std::variant<BufferChangedEvent,
+                                      FlushInputEvent,
+                                      CaptureBufferEvent,
+                                      SetFontDefEvent,
+                                      CopyToClipboardEvent,
+                                      ResizeWindowEvent,
+                                      ResizeWindowPixelsEvent,
+                                      SetWindowTitleEvent,
+                                      ActivateProfileEvent>;
+
+    /// Queues up @p _event for the display's thread, which drains all queued events at once.
+    void postEvent(DisplayEvent _event);
+    void drainEvents();
+    void handleEvent(DisplayEvent const& _event);
+    // }}}
+
     // helpers
     bool reloadConfig(config::Config _newConfig, std::string const& _profileName);
     int executeAllActions(std::vector<actions::Action> const& _actions);
@@ -199,15 +270,22 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
     bool reloadConfigWithProfile(std::string const& _profileName);
     bool resetConfig();
     void followHyperlink(terminal::HyperlinkInfo const& _hyperlink);
+    void copySelectionToClipboard(QClipboard::Mode _mode);
     bool requestPermission(config::Permission _allowedByConfig, std::string_view _topicText);
     void setFontSize(text::font_size _size);
     void setDefaultCursor();
-    void configureTerminal();
+    void configureTerminal(config::TerminalProfile const* _previousProfile = nullptr);
     void configureCursor(config::CursorConfig const& cursorConfig);
-    void configureDisplay();
+    void configureDisplay(config::TerminalProfile const* _previousProfile = nullptr);
     uint8_t matchModeFlags() const;
     void flushInput();
+    void applyFontDef(terminal::FontDef const& _fontDef);
     void mainLoop();
+    FileSystem::path sessionSnapshotPath() const;
+    void restoreSessionSnapshot();
+    void startSessionSnapshots();
+    void saveSessionSnapshot();
+    void sessionSnapshotLoop();
 
     // private data
     //
@@ -223,15 +301,32 @@ class TerminalSession: public QObject, public terminal::Terminal::Events
     std::function<void()> onExit_;
 
     terminal::Terminal terminal_;
+    ClipboardWriter clipboardWriter_; // destroyed first, as it extracts text from terminal_
     bool terminatedAndWaitingForKeyPress_ = false;
     TerminalDisplay* display_ = nullptr;
 
+    crispy::MPSCQueue<DisplayEvent> displayEvents_ { 256 };
+    std::atomic<bool> displayEventsPosted_ = false; // whether draining them is pending
+
+    // Events that did not fit into displayEvents_, drained after them. While there are any,
+    // all further events are queued here as well, so that events are handled in order.
+    std::mutex displayEventsOverflowLock_;
+    std::deque<DisplayEvent> displayEventsOverflow_;
+    std::atomic<bool> displayEventsOverflowing_ = false;
+
     std::unique_ptr<QFileSystemWatcher> configFileChangeWatcher_;
 
     bool terminating_ = false;
     std::thread::id mainLoopThreadID_ {};
     std::unique_ptr<std::thread> screenUpdateThread_;
 
+    // Session snapshots (see TerminalProfile::restoreSession), saved periodically while running.
+    std::string sessionId_;                   // unique across processes, names the snapshot file
+    std::unique_ptr<QLockFile> snapshotLock_; // held while this session saves snapshots
+    std::unique_ptr<std::thread> snapshotThread_;
+    std::mutex snapshotMutex_;                   // guards terminating_ for snapshotThread_
+    std::condition_variable snapshotCondition_; // notified when terminating_ is set
+
     // state vars
     //
     terminal::ScreenType currentScreenType_ = terminal::ScreenType::Primary;
@@ -26,6 +26,8 @@
 #include <terminal/Metrics.h>
 #include <terminal/pty/Pty.h>
 
+#include <crispy/StartupTrace.h>
+
 #include <qnamespace.h>
 
 #if defined(_MSC_VER)
@@ -39,12 +41,14 @@
 #include <QtGui/QScreen>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QMainWindow>
+#include <QtWidgets/QSplitter>
 #include <QtWidgets/QVBoxLayout>
 
 #if defined(CONTOUR_BLUR_PLATFORM_KWIN)
     #include <KWindowEffects>
 #endif
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <stdexcept>
@@ -77,7 +81,8 @@ TerminalWindow::TerminalWindow(std::chrono::seconds _earlyExitThreshold,
     liveConfig_ { _liveConfig },
     profileName_ { std::move(_profileName) },
     programPath_ { std::move(_programPath) },
-    app_ { _app }
+    app_ { _app },
+    earlyExitThreshold_ { _earlyExitThreshold }
 {
     // connect(this, SIGNAL(screenChanged(QScreen*)), this, SLOT(onScreenChanged(QScreen*)));
 
@@ -108,7 +113,25 @@ TerminalWindow::TerminalWindow(std::chrono::seconds _earlyExitThreshold,
         config_.maxImageSize.height = defaultMaxImageSize.height;
     // }}}
 
+    auto& pane = createPane(nullopt);
+    setCentralWidget(pane.container);
+    pane.widget->setFocus();
+
+    // statusBar()->showMessage("blurb");
+
+    pane.session->start();
+}
+
+TerminalWindow::~TerminalWindow()
+{
+    DisplayLog()("~TerminalWindow");
+}
+
+TerminalWindow::Pane& TerminalWindow::createPane(optional<string> _workingDirectory)
+{
     auto shell = profile().shell;
+    if (_workingDirectory)
+        shell.workingDirectory = FileSystem::path(*_workingDirectory);
 #if defined(__APPLE__) || defined(_WIN32)
     {
         auto const path = FileSystem::path(programPath_).parent_path();
@@ -120,65 +143,171 @@ TerminalWindow::TerminalWindow(std::chrono::seconds _earlyExitThreshold,
     }
 #endif
 
-    terminalSession_ = make_unique<TerminalSession>(
-        make_unique<terminal::Process>(shell, terminal::createPty(profile().terminalSize, nullopt)),
-        _earlyExitThreshold,
+    auto process = [&]() {
+        auto const _ = crispy::StartupTrace::Scope { "PTY spawn" };
+        return make_unique<terminal::Process>(shell, terminal::createPty(profile().terminalSize, nullopt));
+    }();
+
+    auto* pane = panes_.emplace_back(make_unique<Pane>()).get();
+    pane->session = make_unique<TerminalSession>(
+        move(process),
+        earlyExitThreshold_,
         config_,
         liveConfig_,
         profileName_,
         programPath_,
         app_,
         unique_ptr<TerminalDisplay> {},
-        [this]() {
+        [pane]() {
     // NB: This is invoked whenever the newly assigned display
     //     has finished initialization.
 #if defined(CONTOUR_SCROLLBAR)
-            scrollableDisplay_->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+            pane->scrollableDisplay->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
 #else
-            (void) this;
+            (void) pane;
 #endif
         },
-        [this]() { app_.onExit(*terminalSession_); });
+        [this, pane]() { app_.onExit(*pane->session); });
 
-    terminalSession_->setDisplay(make_unique<opengl::TerminalWidget>(
-        *terminalSession_,
+    pane->session->setDisplay(make_unique<opengl::TerminalWidget>(
+        *pane->session,
         [this]() {
             centralWidget()->updateGeometry();
             update();
         },
         [this](bool _enable) { BlurBehind::setEnabled(windowHandle(), _enable); }));
-    terminalWidget_ = static_cast<opengl::TerminalWidget*>(terminalSession_->display());
+    pane->widget = static_cast<opengl::TerminalWidget*>(pane->session->display());
+
+    // Sessions may request these from their own threads, and the handlers may delete a pane.
+    connect(
+        pane->widget,
+        &opengl::TerminalWidget::terminated,
+        this,
+        [this, pane]() {
+            if (hasPane(pane))
+                closePane(*pane);
+        },
+        Qt::QueuedConnection);
+    connect(
+        pane->session.get(),
+        &TerminalSession::splitRequested,
+        this,
+        [this, pane](Qt::Orientation _orientation) {
+            if (hasPane(pane))
+                splitPane(*pane, _orientation);
+        },
+        Qt::QueuedConnection);
+    connect(
+        pane->session.get(),
+        &TerminalSession::focusNextPaneRequested,
+        this,
+        [this, pane]() {
+            if (hasPane(pane))
+                focusNextPane(*pane);
+        },
+        Qt::QueuedConnection);
 
-    connect(terminalWidget_, SIGNAL(terminated()), this, SLOT(onTerminalClosed()));
-    connect(terminalWidget_,
-            SIGNAL(terminalBufferChanged(terminal::ScreenType)),
+    connect(pane->widget,
+            &opengl::TerminalWidget::terminalBufferChanged,
             this,
-            SLOT(terminalBufferChanged(terminal::ScreenType)));
+            [this, pane](terminal::ScreenType _type) { terminalBufferChanged(*pane, _type); });
 
 #if defined(CONTOUR_SCROLLBAR)
-    scrollableDisplay_ = new ScrollableDisplay(nullptr, *terminalSession_, terminalWidget_);
-    setCentralWidget(scrollableDisplay_);
-    connect(terminalWidget_, SIGNAL(terminalBufferUpdated()), scrollableDisplay_, SLOT(updateValues()));
+    pane->scrollableDisplay = new ScrollableDisplay(nullptr, *pane->session, pane->widget);
+    pane->container = pane->scrollableDisplay;
+    connect(pane->widget, SIGNAL(terminalBufferUpdated()), pane->scrollableDisplay, SLOT(updateValues()));
 #else
-    setCentralWidget(terminalWidget_);
+    pane->container = pane->widget;
 #endif
 
-    terminalWidget_->setFocus();
+    return *pane;
+}
 
-    // statusBar()->showMessage("blurb");
+void TerminalWindow::splitPane(Pane& _pane, Qt::Orientation _orientation)
+{
+    auto& newPane = createPane(_pane.session->currentWorkingDirectory());
+    auto* const target = _pane.container;
 
-    terminalSession_->start();
+    if (auto* parent = qobject_cast<QSplitter*>(target->parentWidget());
+        parent && parent->orientation() == _orientation)
+    {
+        parent->insertWidget(parent->indexOf(target) + 1, newPane.container);
+        auto sizes = parent->sizes();
+        std::fill(sizes.begin(), sizes.end(), 1);
+        parent->setSizes(sizes);
+    }
+    else
+    {
+        auto* splitter = new QSplitter(_orientation);
+        splitter->setChildrenCollapsible(false);
+        if (parent)
+            parent->replaceWidget(parent->indexOf(target), splitter);
+        else
+        {
+            takeCentralWidget();
+            setCentralWidget(splitter);
+        }
+        splitter->addWidget(target);
+        splitter->addWidget(newPane.container);
+        splitter->setSizes({ 1, 1 });
+        target->show();
+    }
+
+    DisplayLog()("Split pane {}, now {} panes.",
+                 _orientation == Qt::Horizontal ? "horizontally" : "vertically",
+                 panes_.size());
+
+    newPane.widget->setFocus();
+    newPane.session->start();
 }
 
-TerminalWindow::~TerminalWindow()
+void TerminalWindow::closePane(Pane& _pane)
 {
-    DisplayLog()("~TerminalWindow");
+    DisplayLog()("terminal closed: {}", _pane.session->terminal().windowTitle());
+
+    if (panes_.size() == 1)
+    {
+        close();
+        return;
+    }
+
+    // The session goes first, as its threads may still be using the widget.
+    auto* container = _pane.container;
+    auto* splitter = qobject_cast<QSplitter*>(container->parentWidget());
+    panes_.erase(std::find_if(
+        panes_.begin(), panes_.end(), [&](auto const& _candidate) { return _candidate.get() == &_pane; }));
+    delete container;
+
+    // A splitter left with a single child is replaced by that child.
+    if (splitter && splitter->count() == 1)
+    {
+        auto* remaining = splitter->widget(0);
+        if (auto* outer = qobject_cast<QSplitter*>(splitter->parentWidget()))
+            outer->replaceWidget(outer->indexOf(splitter), remaining);
+        else
+        {
+            takeCentralWidget();
+            setCentralWidget(remaining);
+        }
+        remaining->show();
+        splitter->deleteLater();
+    }
+
+    panes_.front()->widget->setFocus();
 }
 
-void TerminalWindow::onTerminalClosed()
+void TerminalWindow::focusNextPane(Pane& _pane)
 {
-    DisplayLog()("terminal closed: {}", terminalSession_->terminal().windowTitle());
-    close();
+    auto const i = std::find_if(
+        panes_.begin(), panes_.end(), [&](auto const& _candidate) { return _candidate.get() == &_pane; });
+    auto const next = std::next(i) != panes_.end() ? std::next(i) : panes_.begin();
+    (*next)->widget->setFocus();
+}
+
+bool TerminalWindow::hasPane(Pane const* _pane) const noexcept
+{
+    return std::any_of(
+        panes_.begin(), panes_.end(), [&](auto const& _candidate) { return _candidate.get() == _pane; });
 }
 
 void TerminalWindow::setBlurBehind([[maybe_unused]] bool _enable)
@@ -189,24 +318,29 @@ void TerminalWindow::setBlurBehind([[maybe_unused]] bool _enable)
 void TerminalWindow::profileChanged()
 {
 #if defined(CONTOUR_SCROLLBAR)
-    scrollableDisplay_->updatePosition();
+    for (auto const& pane: panes_)
+    {
+        pane->scrollableDisplay->updatePosition();
 
-    if (terminalSession_->terminal().isPrimaryScreen())
-        scrollableDisplay_->showScrollBar(profile().scrollbarPosition != config::ScrollBarPosition::Hidden);
-    else
-        scrollableDisplay_->showScrollBar(!profile().hideScrollbarInAltScreen);
+        if (pane->session->terminal().isPrimaryScreen())
+            pane->scrollableDisplay->showScrollBar(profile().scrollbarPosition
+                                                   != config::ScrollBarPosition::Hidden);
+        else
+            pane->scrollableDisplay->showScrollBar(!profile().hideScrollbarInAltScreen);
+    }
 #endif
 }
 
-void TerminalWindow::terminalBufferChanged(terminal::ScreenType _type)
+void TerminalWindow::terminalBufferChanged([[maybe_unused]] Pane& _pane,
+                                           [[maybe_unused]] terminal::ScreenType _type)
 {
 #if defined(CONTOUR_SCROLLBAR)
     DisplayLog()("Screen buffer type has changed to {}.", _type);
-    scrollableDisplay_->showScrollBar(_type == terminal::ScreenType::Primary
-                                      || !profile().hideScrollbarInAltScreen);
+    _pane.scrollableDisplay->showScrollBar(_type == terminal::ScreenType::Primary
+                                           || !profile().hideScrollbarInAltScreen);
 
-    scrollableDisplay_->updatePosition();
-    scrollableDisplay_->updateValues();
+    _pane.scrollableDisplay->updatePosition();
+    _pane.scrollableDisplay->updateValues();
 #endif
 }
 
@@ -41,6 +41,8 @@
 #include <atomic>
 #include <fstream>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace contour
 {
@@ -50,8 +52,8 @@ class ScrollableDisplay;
 
 // XXX Maybe just now a main window and maybe later just a TerminalWindow.
 //
-// It currently just handles one terminal inside, but ideally later it can handle
-// multiple terminals in tabbed views as well tiled.
+// It handles one or more terminals, tiled into split panes, but ideally later it can handle
+// multiple terminals in tabbed views as well.
 class TerminalWindow: public QMainWindow
 {
     Q_OBJECT
@@ -78,12 +80,34 @@ class TerminalWindow: public QMainWindow
     }
 
   public Q_SLOTS:
-    void terminalBufferChanged(terminal::ScreenType);
     void profileChanged();
-    void onTerminalClosed();
     void setBlurBehind(bool _enable);
 
   private:
+    /// A terminal session along with the widget it is displayed in.
+    struct Pane
+    {
+        std::unique_ptr<TerminalSession> session;
+        opengl::TerminalWidget* widget = nullptr;
+        QWidget* container = nullptr; // the widget as placed into the window (or its splitters)
+#if defined(CONTOUR_SCROLLBAR)
+        ScrollableDisplay* scrollableDisplay = nullptr;
+#endif
+    };
+
+    /// Creates a pane with a new terminal session, not yet placed into the window.
+    Pane& createPane(std::optional<std::string> _workingDirectory);
+
+    /// Places a new pane next to @p _pane, splitting the space along @p _orientation.
+    void splitPane(Pane& _pane, Qt::Orientation _orientation);
+
+    /// Removes the pane of a terminated session, closing the window along with its last pane.
+    void closePane(Pane& _pane);
+
+    void focusNextPane(Pane& _pane);
+    void terminalBufferChanged(Pane& _pane, terminal::ScreenType _type);
+    bool hasPane(Pane const* _pane) const noexcept;
+
     // data members
     //
     config::Config config_;
@@ -91,13 +115,9 @@ class TerminalWindow: public QMainWindow
     std::string profileName_;
     std::string programPath_;
     ContourGuiApp& app_;
+    std::chrono::seconds earlyExitThreshold_;
 
-#if defined(CONTOUR_SCROLLBAR)
-    ScrollableDisplay* scrollableDisplay_ = nullptr;
-#endif
-
-    std::unique_ptr<TerminalSession> terminalSession_;
-    opengl::TerminalWidget* terminalWidget_ = nullptr;
+    std::vector<std::unique_ptr<Pane>> panes_;
 };
 
 } // namespace contour
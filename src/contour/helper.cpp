@@ -267,6 +267,14 @@ bool sendKeyEvent(QKeyEvent* _event, TerminalSession& _session)
 
 void sendWheelEvent(QWheelEvent* _event, TerminalSession& _session)
 {
+    // Touchpads report how far they moved in pixels, which the viewport can follow smoothly.
+    if (auto const pixels = _event->pixelDelta().y(); pixels != 0)
+    {
+        auto const devicePixels = static_cast<int>(pixels * _session.contentScale());
+        if (_session.sendPixelScrollEvent(makeModifier(_event->modifiers()), devicePixels))
+            return;
+    }
+
     auto const yDelta = mouseWheelDelta(_event);
 
     if (yDelta)
@@ -465,9 +473,8 @@ void applyResize(terminal::ImageSize _newPixelSize,
     terminal::Terminal& terminal = _session.terminal();
     terminal::ImageSize cellSize = _renderer.gridMetrics().cellSize;
 
-    _renderer.renderTarget().setRenderSize(_newPixelSize);
     _renderer.setPageSize(newPageSize);
-    _renderer.setMargin(computeMargin(_renderer.gridMetrics().cellSize, newPageSize, _newPixelSize));
+    applyRenderSize(_newPixelSize, newPageSize, _renderer);
 
     if (newPageSize == terminal.pageSize())
         return;
@@ -477,4 +484,12 @@ void applyResize(terminal::ImageSize _newPixelSize,
     terminal.clearSelection();
 }
 
+void applyRenderSize(terminal::ImageSize _newPixelSize,
+                     terminal::PageSize _pageSize,
+                     terminal::renderer::Renderer& _renderer)
+{
+    _renderer.renderTarget().setRenderSize(_newPixelSize);
+    _renderer.setMargin(computeMargin(_renderer.gridMetrics().cellSize, _pageSize, _newPixelSize));
+}
+
 } // namespace contour
@@ -189,6 +189,11 @@ void applyResize(terminal::ImageSize _newPixelSize,
                  TerminalSession& _session,
                  terminal::renderer::Renderer& _renderer);
 
+/// Adapts the renderer to a new render target size while still rendering a page of @p _pageSize.
+void applyRenderSize(terminal::ImageSize _newPixelSize,
+                     terminal::PageSize _pageSize,
+                     terminal::renderer::Renderer& _renderer);
+
 bool applyFontDescription(terminal::ImageSize _cellSize,
                           terminal::PageSize _pageSize,
                           terminal::ImageSize _pixelSize,
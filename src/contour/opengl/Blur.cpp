@@ -161,7 +161,9 @@ QImage Blur::blurDualKawase(QImage imageToBlur, int offset, int iterations)
     glBeginQuery(GL_TIME_ELAPSED, gpuTimerQuery);
 
     CPUTimer.start();
+    m_shaderKawaseDown->bind();
     m_shaderKawaseDown->setUniformValue("u_offset", QVector2D((float) offset, (float) offset));
+    m_shaderKawaseUp->bind();
     m_shaderKawaseUp->setUniformValue("u_offset", QVector2D((float) offset, (float) offset));
 
     // Initial downsample
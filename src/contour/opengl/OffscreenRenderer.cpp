@@ -0,0 +1,127 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/helper.h>
+#include <contour/opengl/OffscreenRenderer.h>
+#include <contour/opengl/OpenGLRenderer.h>
+#include <contour/opengl/ShaderConfig.h>
+
+#include <mutex>
+
+using std::make_unique;
+using std::string_view;
+
+// Defined in TerminalWidget.cpp, must be in global namespace.
+void initializeResourcesForContourFrontendOpenGL();
+
+namespace contour::opengl
+{
+
+namespace
+{
+    terminal::renderer::FontDescriptions fontsOf(config::TerminalProfile const& profile)
+    {
+        // There is no screen to take the DPI from.
+        return sanitizeFontDescription(profile.fonts, text::DPI { 96, 96 });
+    }
+} // namespace
+
+OffscreenRenderer::OffscreenRenderer(config::Config const& config,
+                                     config::TerminalProfile const& profile,
+                                     terminal::PageSize pageSize,
+                                     QOffscreenSurface& surface):
+    surface_ { surface },
+    vt_ { pageSize, terminal::LineCount(0), 1024 * 1024 },
+    renderer_ { pageSize,
+                fontsOf(profile),
+                vt_.terminal.colorPalette(),
+                profile.backgroundOpacity,
+                config.textureAtlasHashtableSlots,
+                config.textureAtlasTileCount,
+                config.textureAtlasDirectMapping,
+                profile.hyperlinkDecoration.normal,
+                profile.hyperlinkDecoration.hover }
+{
+    static auto resourcesInitialized = std::once_flag {};
+    std::call_once(resourcesInitialized, []() { initializeResourcesForContourFrontendOpenGL(); });
+
+    vt_.terminal.colorPalette() = profile.colors;
+    vt_.terminal.setMode(terminal::DECMode::AutoWrap, true);
+
+    context_.setFormat(surface_.format());
+    if (!context_.create() || !context_.makeCurrent(&surface_))
+    {
+        errorlog()("Could not create an OpenGL context for offscreen rendering.");
+        return;
+    }
+
+    auto const pixelSize = renderer_.cellSize() * pageSize;
+    framebuffer_ = make_unique<QOpenGLFramebufferObject>(unbox<int>(pixelSize.width),
+                                                         unbox<int>(pixelSize.height));
+
+    renderTarget_ = make_unique<OpenGLRenderer>(
+        profile.textShader.value_or(builtinShaderConfig(ShaderClass::Text)),
+        profile.backgroundShader.value_or(builtinShaderConfig(ShaderClass::Background)),
+        profile.backgroundImageShader.value_or(builtinShaderConfig(ShaderClass::BackgroundImage)),
+        pixelSize,
+        renderer_.cellSize(),
+        terminal::renderer::PageMargin {});
+    renderer_.setRenderTarget(*renderTarget_);
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    if (!context_.isValid())
+        return;
+
+    context_.makeCurrent(&surface_);
+    renderTarget_.reset();
+    framebuffer_.reset();
+    context_.doneCurrent();
+}
+
+void OffscreenRenderer::write(string_view output)
+{
+    // Applies the TTY's output processing (ONLCR), so that plain log files do not staircase.
+    crlfBuffer_.clear();
+    for (char const ch: output)
+    {
+        if (ch == '\n')
+            crlfBuffer_.push_back('\r');
+        crlfBuffer_.push_back(ch);
+    }
+
+    auto& pty = vt_.mockPty();
+    pty.setReadData(crlfBuffer_);
+    while (!pty.isClosed() && !pty.stdoutBuffer().empty())
+        vt_.terminal.processInputOnce();
+}
+
+QImage OffscreenRenderer::render()
+{
+    vt_.terminal.refreshRenderBuffer();
+
+    framebuffer_->bind();
+    context_.functions()->glViewport(0, 0, framebuffer_->width(), framebuffer_->height());
+
+    auto const& colors = vt_.terminal.colorPalette();
+    auto const opacity = uint8_t(renderer_.backgroundOpacity());
+    renderTarget_->clear(vt_.terminal.isModeEnabled(terminal::DECMode::ReverseVideo)
+                             ? terminal::RGBAColor(colors.defaultForeground, opacity)
+                             : terminal::RGBAColor(colors.defaultBackground, opacity));
+    renderer_.render(vt_.terminal, false);
+
+    return framebuffer_->toImage();
+}
+
+} // namespace contour::opengl
@@ -0,0 +1,82 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <contour/Config.h>
+
+#include <terminal/MockTerm.h>
+#include <terminal/pty/MockViewPty.h>
+
+#include <terminal_renderer/Renderer.h>
+
+#include <QtGui/QImage>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    #include <QtOpenGL/QOpenGLFramebufferObject>
+#else
+    #include <QtGui/QOpenGLFramebufferObject>
+#endif
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace contour::opengl
+{
+
+class OpenGLRenderer;
+
+/// Renders application output into images, without any window or PTY.
+///
+/// The output is fed through a Terminal as if it was read from a PTY (with the TTY's
+/// LF to CRLF translation applied) and rendered into an offscreen framebuffer.
+///
+/// An instance owns its own OpenGL context, which is current on the calling thread
+/// for the instance's whole lifetime, so distinct instances may render on distinct threads.
+/// The given @p surface must have been created on the GUI thread and outlive the instance.
+class OffscreenRenderer
+{
+  public:
+    OffscreenRenderer(config::Config const& config,
+                      config::TerminalProfile const& profile,
+                      terminal::PageSize pageSize,
+                      QOffscreenSurface& surface);
+    ~OffscreenRenderer();
+
+    OffscreenRenderer(OffscreenRenderer const&) = delete;
+    OffscreenRenderer(OffscreenRenderer&&) = delete;
+    OffscreenRenderer& operator=(OffscreenRenderer const&) = delete;
+    OffscreenRenderer& operator=(OffscreenRenderer&&) = delete;
+
+    /// Tests whether the OpenGL context could be created.
+    [[nodiscard]] bool valid() const noexcept { return renderTarget_ != nullptr; }
+
+    /// Feeds the given application output into the terminal.
+    void write(std::string_view output);
+
+    /// Renders the current screen contents.
+    [[nodiscard]] QImage render();
+
+  private:
+    QOffscreenSurface& surface_;
+    QOpenGLContext context_;
+    terminal::MockTerm<terminal::MockViewPty> vt_;
+    terminal::renderer::Renderer renderer_;
+    std::unique_ptr<QOpenGLFramebufferObject> framebuffer_;
+    std::unique_ptr<OpenGLRenderer> renderTarget_;
+    std::string crlfBuffer_;
+};
+
+} // namespace contour::opengl
@@ -18,6 +18,8 @@
 
 #include <terminal_renderer/TextureAtlas.h>
 
+#include <crispy/PerfTrace.h>
+#include <crispy/TextureCompression.h>
 #include <crispy/algorithm.h>
 #include <crispy/assert.h>
 #include <crispy/utils.h>
@@ -26,11 +28,14 @@
 
 #include <QtCore/QtGlobal>
 #include <QtGui/QImage>
+#include <QtGui/QOpenGLContext>
 
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstring>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -55,6 +60,10 @@ using terminal::Width;
 namespace chrono = std::chrono;
 namespace atlas = terminal::renderer::atlas;
 
+#if !defined(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 #if !defined(_WIN32)
     #define CRISPY_PACKED __attribute__((packed))
 #else
@@ -66,6 +75,15 @@ namespace contour::opengl
 
 namespace
 {
+    // Number of floats per tile in instanced text rendering (target rect, texture rect, color, selector).
+    constexpr size_t TextInstanceFloatCount = 4 + 4 + 4 + 1;
+
+    // Number of floats per vertex in per-vertex text rendering (XYZ, XYIU, RGBA), with six vertices per tile.
+    constexpr size_t TextVertexFloatCount = 3 + 4 + 4;
+
+    // Smaller images are not worth compressing, e.g. 256x256 pixels.
+    constexpr size_t MinCompressedImageSize = 256 * 1024;
+
     struct CRISPY_PACKED vec2
     {
         float x;
@@ -196,11 +214,16 @@ namespace
 } // namespace
 
 /**
- * Text rendering input:
- *  - vec3 screenCoord    (x/y/z)
- *  - vec4 textureCoord   (x/y and w/h)
+ * Text rendering input, one instance per tile:
+ *  - vec4 targetRect     (x/y and w/h)
+ *  - vec4 textureRect    (x/y and w/h)
  *  - vec4 textColor      (r/g/b/a)
+ *  - float selector      (fragment shader selector)
  *
+ * Text shaders without the vs_instanceRect attribute are fed six vertices per tile instead:
+ *  - vec3 screenCoord    (x/y/z)
+ *  - vec4 textureCoord   (x/y, unused, selector)
+ *  - vec4 textColor      (r/g/b/a)
  */
 
 OpenGLRenderer::OpenGLRenderer(ShaderConfig const& textShaderConfig,
@@ -221,6 +244,7 @@ OpenGLRenderer::OpenGLRenderer(ShaderConfig const& textShaderConfig,
     _textShader { createShader(textShaderConfig) },
     _textProjectionLocation { _textShader->uniformLocation("vs_projection") },
     _textTimeLocation { _textShader->uniformLocation("u_time") },
+    _textInstanced { _textShader->attributeLocation("vs_instanceRect") != -1 },
     _backgroundShader { createShader(backgroundImageShaderConfig) },
     _rectShader { createShader(rectShaderConfig) },
     _rectProjectionLocation { _rectShader->uniformLocation("u_projection") },
@@ -235,7 +259,6 @@ OpenGLRenderer::OpenGLRenderer(ShaderConfig const& textShaderConfig,
     CHECKED_GL(glEnable(GL_BLEND));
     CHECKED_GL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE));
     // glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
-    //  //glBlendFunc(GL_SRC1_COLOR, GL_ONE_MINUS_SRC1_COLOR);
 
     bound(*_textShader, [&]() {
         CHECKED_GL(_textShader->setUniformValue("fs_textureAtlas", 0)); // GL_TEXTURE0?
@@ -297,15 +320,28 @@ void OpenGLRenderer::initializeTextureRendering()
     CHECKED_GL(glGenVertexArrays(1, &_textVAO));
     CHECKED_GL(glBindVertexArray(_textVAO));
 
+    CHECKED_GL(glGenBuffers(1, &_textVBO));
+    CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _textVBO));
+    CHECKED_GL(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW));
+
+    CHECKED_GL(glGenBuffers(1, &_uploadPBO));
+
+    if (_textInstanced)
+    {
+        // The attribute pointers are set for each frame, as they point into the streamed segment.
+        for (GLuint location = 0; location < 4; ++location)
+        {
+            CHECKED_GL(glEnableVertexAttribArray(location));
+            CHECKED_GL(glVertexAttribDivisor(location, 1));
+        }
+        return;
+    }
+
     auto constexpr BufferStride = (3 + 4 + 4) * sizeof(GLfloat);
     auto constexpr VertexOffset = (void const*) 0;
     auto const TexCoordOffset = (void const*) (3 * sizeof(GLfloat));
     auto const ColorOffset = (void const*) (7 * sizeof(GLfloat));
 
-    CHECKED_GL(glGenBuffers(1, &_textVBO));
-    CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _textVBO));
-    CHECKED_GL(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW));
-
     // 0 (vec3): vertex buffer
     CHECKED_GL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset));
     CHECKED_GL(glEnableVertexAttribArray(0));
@@ -323,8 +359,26 @@ void OpenGLRenderer::initializeTextureRendering()
     // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
     // static const GLuint indices[6] = { 0, 1, 3, 1, 2, 3 };
     // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+}
+
+void OpenGLRenderer::setTextInstanceAttributes(GLsizeiptr _offset)
+{
+    auto constexpr InstanceStride = TextInstanceFloatCount * sizeof(GLfloat);
+    auto const offset = [&](size_t floatIndex) {
+        return (void const*) (_offset + static_cast<GLsizeiptr>(floatIndex * sizeof(GLfloat)));
+    };
+
+    // 0 (vec4): target rectangle
+    CHECKED_GL(glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, InstanceStride, offset(0)));
+
+    // 1 (vec4): texture rectangle
+    CHECKED_GL(glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, InstanceStride, offset(4)));
 
-    // glVertexAttribDivisor(0, 1); // TODO: later for instanced rendering
+    // 2 (vec4): color
+    CHECKED_GL(glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, InstanceStride, offset(8)));
+
+    // 3 (float): fragment shader selector
+    CHECKED_GL(glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, InstanceStride, offset(12)));
 }
 
 OpenGLRenderer::~OpenGLRenderer()
@@ -332,9 +386,18 @@ OpenGLRenderer::~OpenGLRenderer()
     DisplayLog()("~OpenGLRenderer");
     CHECKED_GL(glDeleteVertexArrays(1, &_rectVAO));
     CHECKED_GL(glDeleteBuffers(1, &_rectVBO));
+    destroyStreamingBuffer(_rectStream);
+    destroyStreamingBuffer(_textStream);
+    CHECKED_GL(glDeleteBuffers(1, &_uploadPBO));
+    destroyStreamingBuffer(_uploadStream);
 
     if (_backgroundImageTexture)
         CHECKED_GL(glDeleteTextures(1, &_backgroundImageTexture));
+
+    cancelImageCompression();
+    for (auto const& [imageId, texture]: _imageTextures)
+        if (texture.textureId)
+            CHECKED_GL(glDeleteTextures(1, &texture.textureId));
 }
 
 void OpenGLRenderer::initialize()
@@ -348,6 +411,12 @@ void OpenGLRenderer::initialize()
 
 void OpenGLRenderer::clearCache()
 {
+    cancelImageCompression();
+    for (auto const& [imageId, texture]: _imageTextures)
+        if (texture.textureId)
+            CHECKED_GL(glDeleteTextures(1, &texture.textureId));
+    _imageTextures.clear();
+    _imageTextureBytes = 0;
 }
 
 int OpenGLRenderer::maxTextureDepth()
@@ -434,8 +503,19 @@ void OpenGLRenderer::renderTile(atlas::RenderTile tile)
     GLfloat const cb = tile.color[2];
     GLfloat const ca = tile.color[3];
 
+    batch.renderTiles.emplace_back(tile);
+
+    if (_textInstanced)
+    {
+        GLfloat const instance[TextInstanceFloatCount] = {
+            x, y, r, s, nx, ny, nw, nh, cr, cg, cb, ca, u,
+        };
+        crispy::copy(instance, back_inserter(batch.buffer));
+        return;
+    }
+
     // clang-format off
-    GLfloat const vertices[6 * 11] = {
+    GLfloat const vertices[6 * TextVertexFloatCount] = {
         // first triangle
     // <X      Y      Z> <X        Y        I  U>  <R   G   B   A>
         x,     y + s, z,  nx,      ny + nh, i, u,  cr, cg, cb, ca, // left top
@@ -454,7 +534,6 @@ void OpenGLRenderer::renderTile(atlas::RenderTile tile)
     };
     // clang-format on
 
-    batch.renderTiles.emplace_back(tile);
     crispy::copy(vertices, back_inserter(batch.buffer));
 }
 // }}}
@@ -475,6 +554,8 @@ ImageSize OpenGLRenderer::renderBufferSize()
 
 void OpenGLRenderer::execute()
 {
+    CONTOUR_PERF_TRACE("OpenGLRenderer::execute");
+
     static auto lastSize = crispy::ImageSize {};
     if (lastSize != _renderTargetSize)
     {
@@ -483,11 +564,30 @@ void OpenGLRenderer::execute()
     }
     _currentTextureId = std::numeric_limits<GLuint>::max();
 
-    // FIXME
-    // glEnable(GL_BLEND);
-    // glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
-    // glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
-    // glBlendFunc(GL_SRC1_COLOR, GL_ONE_MINUS_SRC1_COLOR);
+    collectCompressedImages();
+
+    // Background images and filled rects are alpha-blended, whereas the text shader
+    // emits a second (per-channel) blending factor, see executeRenderTextures().
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+
+    // Only the damaged area is cleared and drawn, the rest of the framebuffer keeps the previous frame.
+    if (_damage)
+    {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(_damage->x, _damage->y, _damage->width, _damage->height);
+    }
+
+    if (_pendingClear)
+    {
+        if (*_pendingClear != _renderStateCache.backgroundColor)
+        {
+            auto const clearColor = atlas::normalize(*_pendingClear);
+            glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+            _renderStateCache.backgroundColor = *_pendingClear;
+        }
+        glClear(GL_COLOR_BUFFER_BIT);
+        _pendingClear.reset();
+    }
 
     auto const timeValue = uptime();
 
@@ -506,17 +606,21 @@ void OpenGLRenderer::execute()
 
             glBindVertexArray(_rectVAO);
             glBindBuffer(GL_ARRAY_BUFFER, _rectVBO);
-            glBufferData(GL_ARRAY_BUFFER,
-                         static_cast<GLsizeiptr>(_rectBuffer.size() * sizeof(GLfloat)),
-                         _rectBuffer.data(),
-                         GL_STREAM_DRAW);
+            auto const firstVertex = streamVertices(
+                _rectStream, _rectBuffer.data(), _rectBuffer.size() * sizeof(GLfloat), 7 * sizeof(GLfloat));
 
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_rectBuffer.size() / 7));
+            glDrawArrays(GL_TRIANGLES, firstVertex, static_cast<GLsizei>(_rectBuffer.size() / 7));
+            fenceStream(_rectStream);
             glBindVertexArray(0);
         });
         _rectBuffer.clear();
     }
 
+    // render images that have textures of their own
+    //
+    if (!_scheduledImages.empty())
+        bound(*_backgroundShader, [&]() { executeRenderImages(timeValue); });
+
     // render textures
     //
     bound(*_textShader, [&]() {
@@ -526,6 +630,12 @@ void OpenGLRenderer::execute()
         executeRenderTextures();
     });
 
+    if (_damage)
+    {
+        glDisable(GL_SCISSOR_TEST);
+        _damage.reset();
+    }
+
     if (_pendingScreenshotCallback)
     {
         auto result = takeScreenshot();
@@ -541,8 +651,8 @@ void OpenGLRenderer::executeRenderTextures()
         executeConfigureAtlas(*_scheduledExecutions.configureAtlas);
 
     // potentially upload any new textures
-    for (auto const& params: _scheduledExecutions.uploadTiles)
-        executeUploadTile(params);
+    if (!_scheduledExecutions.uploadTiles.empty())
+        executeUploadTiles(_scheduledExecutions.uploadTiles);
 
     // upload vertices and render
     RenderBatch& batch = _scheduledExecutions.renderBatch;
@@ -552,21 +662,104 @@ void OpenGLRenderer::executeRenderTextures()
         bindTexture(_textureAtlas.textureId);
         glBindVertexArray(_textVAO);
 
+        // Dual source blending: LCD glyphs blend each color channel with its own subpixel coverage,
+        // straight from the RGB bitmap in the atlas.
+        glBlendFuncSeparate(GL_SRC1_COLOR, GL_ONE_MINUS_SRC1_COLOR, GL_ONE, GL_ONE);
+
         // upload buffer
         // clang-format off
         glBindBuffer(GL_ARRAY_BUFFER, _textVBO);
-        glBufferData(GL_ARRAY_BUFFER,
-                     static_cast<GLsizei>(batch.buffer.size() * sizeof(GLfloat)),
-                     batch.buffer.data(), GL_STREAM_DRAW);
-        glDrawArrays(GL_TRIANGLES,
-                     0,
-                     static_cast<GLsizei>(batch.renderTiles.size() * 6));
+        auto const floatCount = _textInstanced ? TextInstanceFloatCount : TextVertexFloatCount;
+        auto const stride = floatCount * sizeof(GLfloat);
+        auto const first =
+            streamVertices(_textStream, batch.buffer.data(), batch.buffer.size() * sizeof(GLfloat), stride);
+        if (_textInstanced)
+        {
+            setTextInstanceAttributes(static_cast<GLsizeiptr>(first) * static_cast<GLsizeiptr>(stride));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(batch.renderTiles.size()));
+        }
+        else
+            glDrawArrays(GL_TRIANGLES,
+                         first,
+                         static_cast<GLsizei>(batch.renderTiles.size() * 6));
+        fenceStream(_textStream);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
         // clang-format on
     }
 
     _scheduledExecutions.clear();
 }
 
+GLint OpenGLRenderer::streamVertices(StreamingBuffer& _buffer,
+                                     void const* _data,
+                                     size_t _size,
+                                     size_t _stride)
+{
+    return static_cast<GLint>(streamData(GL_ARRAY_BUFFER, _buffer, _data, _size, _stride)
+                              / static_cast<GLsizeiptr>(_stride));
+}
+
+GLsizeiptr OpenGLRenderer::streamData(
+    GLenum _target, StreamingBuffer& _buffer, void const* _data, size_t _size, size_t _stride)
+{
+    auto const size = static_cast<GLsizeiptr>(_size);
+    auto const stride = static_cast<GLsizeiptr>(_stride);
+
+    if (size > _buffer.segmentSize)
+    {
+        // Grow with some headroom, so that slightly larger frames do not reallocate again.
+        destroyStreamingBuffer(_buffer);
+        _buffer.segmentSize = (size / stride + size / stride / 2 + 1) * stride;
+        _buffer.currentSegment = 0;
+        CHECKED_GL(glBufferData(_target,
+                                _buffer.segmentSize * static_cast<GLsizeiptr>(StreamingBuffer::SegmentCount),
+                                nullptr,
+                                GL_STREAM_DRAW));
+    }
+    else
+        _buffer.currentSegment = (_buffer.currentSegment + 1) % StreamingBuffer::SegmentCount;
+
+    // This only blocks if the GPU is lagging behind by more than SegmentCount - 1 frames.
+    GLsync& fence = _buffer.fences[_buffer.currentSegment];
+    if (fence)
+    {
+        auto constexpr FenceTimeout = GLuint64 { 1'000'000'000 }; // 1 second, in nanoseconds
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    auto const offset = _buffer.segmentSize * static_cast<GLsizeiptr>(_buffer.currentSegment);
+
+    // The segment is known to be unused by the GPU, so no implicit synchronization is needed.
+    auto constexpr MapFlags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    void* target = glMapBufferRange(_target, offset, size, MapFlags);
+    if (target)
+        std::memcpy(target, _data, _size);
+    if (!target || !glUnmapBuffer(_target))
+        CHECKED_GL(glBufferSubData(_target, offset, size, _data));
+
+    return offset;
+}
+
+void OpenGLRenderer::fenceStream(StreamingBuffer& _buffer)
+{
+    GLsync& fence = _buffer.fences[_buffer.currentSegment];
+    if (fence)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void OpenGLRenderer::destroyStreamingBuffer(StreamingBuffer& _buffer)
+{
+    for (GLsync& fence: _buffer.fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
 void OpenGLRenderer::executeConfigureAtlas(atlas::ConfigureAtlas const& param)
 {
     if (_textureAtlas.textureId)
@@ -642,33 +835,83 @@ void OpenGLRenderer::executeConfigureAtlas(atlas::ConfigureAtlas const& param)
                             stub.data()));
 }
 
-void OpenGLRenderer::executeUploadTile(atlas::UploadTile const& param)
+void OpenGLRenderer::executeUploadTiles(vector<atlas::UploadTile> const& tiles)
 {
-    auto const textureId = _textureAtlas.textureId;
-
-    auto constexpr target = GL_TEXTURE_2D;
-    auto constexpr LevelOfDetail = 0;
-    auto constexpr BitmapType = GL_UNSIGNED_BYTE;
+    // A run of tiles that are adjacent within the same atlas row, uploaded with a single call.
+    struct Upload
+    {
+        int x;
+        int y;
+        ImageSize size;
+        atlas::Format format;
+        size_t offset; // into the staging buffer
+    };
 
-    // clang-format off
-    // DisplayLog()("-> uploadTile: tex {} location {} format {} size {}",
-    //              textureId, param.location, param.bitmapFormat, param.bitmapSize);
-    // clang-format on
+    // Pack the tiles' pixels tightly, interleaving the rows of adjacent tiles, so that each run
+    // is a single rectangle in the pixel unpack buffer.
+    auto uploads = vector<Upload> {};
+    _uploadStaging.clear();
+    for (size_t first = 0; first < tiles.size();)
+    {
+        auto const& head = tiles[first];
+        auto width = unbox<int>(head.bitmapSize.width);
+        auto last = first + 1;
+        while (last < tiles.size() && tiles[last].location.y.value == head.location.y.value
+               && tiles[last].location.x.value == head.location.x.value + width
+               && tiles[last].bitmapSize.height == head.bitmapSize.height
+               && tiles[last].bitmapFormat == head.bitmapFormat)
+            width += unbox<int>(tiles[last++].bitmapSize.width);
+
+        auto const height = unbox<size_t>(head.bitmapSize.height);
+        auto const elementCount = atlas::element_count(head.bitmapFormat);
+        uploads.emplace_back(Upload { head.location.x.value,
+                                      head.location.y.value,
+                                      ImageSize { Width::cast_from(width), head.bitmapSize.height },
+                                      head.bitmapFormat,
+                                      _uploadStaging.size() });
+        _uploadStaging.resize(_uploadStaging.size() + height * static_cast<size_t>(width) * elementCount);
+        auto target = _uploadStaging.data() + uploads.back().offset;
+        for (size_t row = 0; row < height; ++row)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto const& tile = tiles[i];
+                auto const rowSize = unbox<size_t>(tile.bitmapSize.width) * elementCount;
+                auto const alignment = static_cast<size_t>(tile.rowAlignment);
+                auto const pitch = (rowSize + alignment - 1) / alignment * alignment;
+                std::memcpy(target, tile.bitmap.data() + row * pitch, rowSize);
+                target += rowSize;
+            }
+        }
+        first = last;
+    }
 
-    bindTexture(textureId);
+    if (_uploadStaging.empty())
+        return;
 
-    // Image row alignment is 1 byte (OpenGL defaults to 4).
-    CHECKED_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, param.rowAlignment));
+    CHECKED_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _uploadPBO));
+    auto const base =
+        streamData(GL_PIXEL_UNPACK_BUFFER, _uploadStream, _uploadStaging.data(), _uploadStaging.size(), 1);
 
-    CHECKED_GL(glTexSubImage2D(target,
-                               LevelOfDetail,
-                               param.location.x.value,
-                               param.location.y.value,
-                               unbox<GLsizei>(param.bitmapSize.width),
-                               unbox<GLsizei>(param.bitmapSize.height),
-                               glFormat(param.bitmapFormat),
-                               BitmapType,
-                               param.bitmap.data()));
+    bindTexture(_textureAtlas.textureId);
+    CHECKED_GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    for (auto const& upload: uploads)
+    {
+        auto constexpr LevelOfDetail = 0;
+        auto constexpr BitmapType = GL_UNSIGNED_BYTE;
+        auto const pixels = reinterpret_cast<void const*>(base + static_cast<GLsizeiptr>(upload.offset));
+        CHECKED_GL(glTexSubImage2D(GL_TEXTURE_2D,
+                                   LevelOfDetail,
+                                   upload.x,
+                                   upload.y,
+                                   unbox<GLsizei>(upload.size.width),
+                                   unbox<GLsizei>(upload.size.height),
+                                   glFormat(upload.format),
+                                   BitmapType,
+                                   pixels));
+    }
+    fenceStream(_uploadStream);
+    CHECKED_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
 }
 
 void OpenGLRenderer::executeDestroyAtlas()
@@ -712,6 +955,39 @@ void OpenGLRenderer::renderRectangle(int ix, int iy, Width width, Height height,
     crispy::copy(vertices, back_inserter(_rectBuffer));
 }
 
+void OpenGLRenderer::renderImage(shared_ptr<terminal::Image const> const& image,
+                                 terminal::renderer::PixelRect imageRect,
+                                 terminal::renderer::PixelRect clipRect)
+{
+    _scheduledImages.emplace_back(ScheduledImage { image, imageRect, clipRect });
+}
+
+void OpenGLRenderer::discardImage(terminal::ImageId imageId)
+{
+    auto const i = _imageTextures.find(imageId);
+    if (i == _imageTextures.end())
+        return;
+
+    if (i->second.textureId)
+    {
+        CHECKED_GL(glDeleteTextures(1, &i->second.textureId));
+        _currentTextureId = std::numeric_limits<GLuint>::max(); // the deleted name may be reused
+    }
+    _imageTextureBytes -= i->second.bytes;
+    _imageTextures.erase(i);
+
+    _pendingImageCompressions.erase(std::remove_if(_pendingImageCompressions.begin(),
+                                                   _pendingImageCompressions.end(),
+                                                   [&](auto const& job) { return job->imageId == imageId; }),
+                                    _pendingImageCompressions.end());
+    if (_imageCompression && _imageCompression->imageId == imageId)
+    {
+        _imageCompression->cancelled = true;
+        _imageCompression.reset();
+        startImageCompression();
+    }
+}
+
 optional<terminal::renderer::AtlasTextureScreenshot> OpenGLRenderer::readAtlas()
 {
     // NB: to get all atlas pages, call this from instance base id up to and including current
@@ -769,20 +1045,38 @@ pair<ImageSize, vector<uint8_t>> OpenGLRenderer::takeScreenshot()
 
 void OpenGLRenderer::clear(terminal::RGBAColor fillColor)
 {
-    if (fillColor != _renderStateCache.backgroundColor)
-    {
-        auto const clearColor = atlas::normalize(fillColor);
-        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
-        _renderStateCache.backgroundColor = fillColor;
-    }
+    _pendingClear = fillColor;
+}
 
-    glClear(GL_COLOR_BUFFER_BIT);
+void OpenGLRenderer::setDamage(optional<terminal::renderer::PixelRect> damage)
+{
+    _damage = damage;
 }
 
 // }}}
 
-void OpenGLRenderer::inspect(std::ostream& /*output*/) const
+void OpenGLRenderer::inspect(std::ostream& output) const
 {
+    output << fmt::format("OpenGLRenderer\n");
+    output << fmt::format("------------------------\n");
+    output << fmt::format(
+        "background blurs   : {} ({} reused)\n", _blurStats.blurCount, _blurStats.reuseCount);
+    output << fmt::format("last blur          : {:.3}ms CPU, {:.3}ms GPU\n",
+                          _blurStats.lastCPUTime,
+                          _blurStats.lastGPUTime);
+    output << fmt::format("total blur GPU time: {:.3}ms\n", _blurStats.totalGPUTime);
+    output << fmt::format("image textures     : {} ({:.1f} MB, limit {})\n",
+                          _imageTextures.size(),
+                          double(_imageTextureBytes) / (1024.0 * 1024.0),
+                          _imageTextureMemoryLimit
+                              ? fmt::format("{:.1f} MB", double(_imageTextureMemoryLimit) / (1024.0 * 1024.0))
+                              : string("none"));
+    if (_imageTextureCompression)
+        output << fmt::format("compressed images  : {} ({:.1f} MB saved, {} pending)\n",
+                              _imageCompressionStats.count,
+                              double(_imageCompressionStats.bytesSaved) / (1024.0 * 1024.0),
+                              _pendingImageCompressions.size() + (_imageCompression ? 1 : 0));
+    output << '\n';
 }
 
 // {{{ background (image)
@@ -832,14 +1126,22 @@ void OpenGLRenderer::initializeBackgroundRendering()
 
 void OpenGLRenderer::setBackgroundImage(shared_ptr<terminal::BackgroundImage const> const& backgroundImageOpt)
 {
-    if (!backgroundImageOpt || backgroundImageOpt->hash != _renderStateCache.backgroundImageHash)
+    if (backgroundImageOpt && _backgroundImageTexture
+        && backgroundImageOpt->hash == _renderStateCache.backgroundImageHash
+        && backgroundImageOpt->blur == _renderStateCache.backgroundImageBlur)
+    {
+        // Same backdrop as before; keep the (possibly blurred) texture we already have.
+        _renderStateCache.backgroundImageOpacity = backgroundImageOpt->opacity;
+        if (backgroundImageOpt->blur)
+            ++_blurStats.reuseCount;
+        return;
+    }
+
+    if (_backgroundImageTexture)
     {
         _renderStateCache.backgroundImageOpacity = 1.0f;
-        if (_backgroundImageTexture)
-        {
-            glDeleteTextures(1, &_backgroundImageTexture);
-            _backgroundImageTexture = 0;
-        }
+        glDeleteTextures(1, &_backgroundImageTexture);
+        _backgroundImageTexture = 0;
     }
 
     if (!backgroundImageOpt)
@@ -857,16 +1159,19 @@ void OpenGLRenderer::setBackgroundImage(shared_ptr<terminal::BackgroundImage con
 
         if (backgroundImage.blur)
         {
+            // Dual Kawase works on successively halved render targets, so its cost stays
+            // low even on 4K images, unlike a full resolution gaussian kernel.
+            auto constexpr BlurOffset = 3;
+            auto constexpr BlurIterations = 4;
             auto const contextGuard = OpenGLContextGuard {};
             auto blur = Blur {};
-            // auto const offsetStr = qgetenv("CONTOUR_BLUR_OFFSET").toStdString();
-            // auto const iterStr = qgetenv("CONTOUR_BLUR_ITERATIONS").toStdString();
-            // auto const offset = offsetStr.empty() ? 5 : std::stoi(offsetStr);
-            // auto const iterations = iterStr.empty() ? 5 : std::stoi(iterStr);
-            // qImage = blur.blurDualKawase(move(qImage), offset, iterations);
-            qImage = blur.blurGaussian(move(qImage));
-
-            DisplayLog()("blur performance: {:.3}s CPU, {:.3}s GPU", blur.getCPUTime(), blur.getGPUTime());
+            qImage = blur.blurDualKawase(move(qImage), BlurOffset, BlurIterations);
+
+            ++_blurStats.blurCount;
+            _blurStats.lastCPUTime = blur.getCPUTime();
+            _blurStats.lastGPUTime = blur.getGPUTime();
+            _blurStats.totalGPUTime += _blurStats.lastGPUTime;
+            DisplayLog()("blur performance: {:.3}ms CPU, {:.3}ms GPU", blur.getCPUTime(), blur.getGPUTime());
         }
 
         qImage = qImage.convertToFormat(QImage::Format_RGBA8888);
@@ -880,7 +1185,7 @@ void OpenGLRenderer::setBackgroundImage(shared_ptr<terminal::BackgroundImage con
         auto const imageFormat = terminal::ImageFormat::RGBA;
         auto const rowAlignment = 4; // This is default. Can it be any different?
         DisplayLog()("Background image from disk: {}x{} {}", qImage.width(), qImage.height(), imageFormat);
-        _renderStateCache.backgroundImageHash = crispy::StrongHash::compute(filePath.string());
+        _renderStateCache.backgroundImageHash = backgroundImage.hash;
         _renderStateCache.backgroundResolution = qImage.size();
         _backgroundImageTexture =
             createAndUploadImage(qImage.size(), imageFormat, rowAlignment, qImage.constBits());
@@ -926,6 +1231,23 @@ GLuint OpenGLRenderer::createAndUploadImage(QSize imageSize,
     auto const textureWidth = static_cast<GLsizei>(imageSize.width());
     auto const textureHeight = static_cast<GLsizei>(imageSize.height());
 
+    auto const elementCount = size_t { format == terminal::ImageFormat::RGBA ? 4u : 3u };
+    auto const alignment = static_cast<size_t>(rowAlignment);
+    auto const rowSize = static_cast<size_t>(textureWidth) * elementCount;
+    auto const pitch = (rowSize + alignment - 1) / alignment * alignment;
+    auto const byteCount = pitch * static_cast<size_t>(textureHeight);
+
+    // Large images (e.g. background images) would bloat the upload ring for good, so they
+    // are uploaded from client memory instead.
+    auto constexpr MaxStreamedImageSize = size_t { 4 * 1024 * 1024 };
+    auto const streamed = byteCount <= MaxStreamedImageSize;
+    if (streamed)
+    {
+        CHECKED_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _uploadPBO));
+        auto const offset = streamData(GL_PIXEL_UNPACK_BUFFER, _uploadStream, pixels, byteCount, 1);
+        pixels = reinterpret_cast<uint8_t const*>(offset);
+    }
+
     CHECKED_GL(glTexImage2D(target,
                             levelOfDetail,
                             internalFormat,
@@ -935,6 +1257,12 @@ GLuint OpenGLRenderer::createAndUploadImage(QSize imageSize,
                             imageFormat,
                             type,
                             pixels));
+
+    if (streamed)
+    {
+        fenceStream(_uploadStream);
+        CHECKED_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    }
     return textureId;
 }
 
@@ -988,6 +1316,237 @@ void OpenGLRenderer::executeRenderBackground(float timeValue)
     CHECKED_GL(glDrawArrays(GL_TRIANGLES, 0, 6 * ElementCount));
     // clang-format on
 }
+
+GLuint OpenGLRenderer::getOrCreateImageTexture(terminal::Image const& image)
+{
+    if (auto const i = _imageTextures.find(image.id()); i != _imageTextures.end())
+    {
+        i->second.lastFrame = _imageFrame;
+        return i->second.textureId;
+    }
+
+    // Pixels evicted from host memory are loaded again for (re-)uploading.
+    auto texture = ImageTexture { 0, 0, _imageFrame };
+    auto const pixels = image.load();
+    auto const width = unbox<int>(image.width());
+    auto const height = unbox<int>(image.height());
+    if (!pixels)
+        DisplayLog()("Not uploading image {}: pixels have been lost on eviction.", image.id());
+    else if (width > maxTextureSize() || height > maxTextureSize())
+        DisplayLog()("Not uploading image {}: {}x{} exceeds the maximum texture size.",
+                     image.id(),
+                     width,
+                     height);
+    else
+    {
+        texture.textureId = createAndUploadImage(QSize(width, height), image.format(), 1, pixels->data());
+        texture.bytes = pixels->size();
+
+        // Rendered uncompressed until compressed, as compressing takes longer than a frame.
+        if (_imageTextureCompression && image.format() == terminal::ImageFormat::RGBA
+            && pixels->size() >= MinCompressedImageSize)
+        {
+            auto job = make_shared<ImageCompression>();
+            job->imageId = image.id();
+            job->size = image.size();
+            job->pixels = pixels;
+            _pendingImageCompressions.emplace_back(std::move(job));
+            if (!_imageCompression)
+                startImageCompression();
+        }
+    }
+
+    _imageTextureBytes += texture.bytes;
+    _imageTextures.emplace(image.id(), texture);
+    return texture.textureId;
+}
+
+void OpenGLRenderer::enforceImageTextureMemoryLimit()
+{
+    if (!_imageTextureMemoryLimit || _imageTextureBytes <= _imageTextureMemoryLimit)
+        return;
+
+    auto candidates = vector<pair<uint64_t, terminal::ImageId>> {};
+    for (auto const& [imageId, texture]: _imageTextures)
+        if (texture.lastFrame != _imageFrame && texture.bytes)
+            candidates.emplace_back(texture.lastFrame, imageId);
+    std::sort(candidates.begin(), candidates.end());
+
+    for (auto const& [lastFrame, imageId]: candidates)
+    {
+        if (_imageTextureBytes <= _imageTextureMemoryLimit)
+            break;
+        discardImage(imageId);
+    }
+}
+
+void OpenGLRenderer::setImageTextureCompression(bool enabled)
+{
+    auto const* context = QOpenGLContext::currentContext();
+    if (enabled && !(context && context->hasExtension("GL_EXT_texture_compression_s3tc")))
+    {
+        DisplayLog()("Not compressing image textures: S3TC is not supported.");
+        enabled = false;
+    }
+    if (!enabled)
+        cancelImageCompression();
+    _imageTextureCompression = enabled;
+}
+
+void OpenGLRenderer::startImageCompression()
+{
+    if (_pendingImageCompressions.empty())
+        return;
+
+    auto job = std::move(_pendingImageCompressions.front());
+    _pendingImageCompressions.erase(_pendingImageCompressions.begin());
+    _imageCompression = job;
+
+    std::thread([job]() {
+        try
+        {
+            if (!job->cancelled)
+                job->blocks = crispy::compressBC3(
+                    job->pixels->data(), unbox<size_t>(job->size.width), unbox<size_t>(job->size.height));
+        }
+        catch (...)
+        {
+            job->blocks.clear();
+        }
+        job->finished = true;
+    }).detach();
+}
+
+void OpenGLRenderer::collectCompressedImages()
+{
+    if (!_imageCompression || !_imageCompression->finished)
+        return;
+
+    auto const job = std::move(_imageCompression);
+    _imageCompression.reset();
+
+    auto const i = _imageTextures.find(job->imageId);
+    if (i != _imageTextures.end() && i->second.textureId && !job->blocks.empty())
+    {
+        CHECKED_GL(glDeleteTextures(1, &i->second.textureId));
+        _currentTextureId = std::numeric_limits<GLuint>::max(); // the deleted name may be reused
+
+        auto textureId = GLuint {};
+        CHECKED_GL(glGenTextures(1, &textureId));
+        CHECKED_GL(bindTexture(textureId));
+        CHECKED_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+        CHECKED_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+        CHECKED_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+        CHECKED_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+        CHECKED_GL(glCompressedTexImage2D(GL_TEXTURE_2D,
+                                          0,
+                                          GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+                                          unbox<GLsizei>(job->size.width),
+                                          unbox<GLsizei>(job->size.height),
+                                          0,
+                                          static_cast<GLsizei>(job->blocks.size()),
+                                          job->blocks.data()));
+        i->second.textureId = textureId;
+        _imageTextureBytes -= i->second.bytes;
+        i->second.bytes = job->blocks.size();
+        _imageTextureBytes += i->second.bytes;
+
+        ++_imageCompressionStats.count;
+        _imageCompressionStats.bytesSaved += job->pixels->size() - job->blocks.size();
+    }
+
+    startImageCompression();
+}
+
+void OpenGLRenderer::cancelImageCompression()
+{
+    if (_imageCompression)
+        _imageCompression->cancelled = true;
+    _imageCompression.reset();
+    _pendingImageCompressions.clear();
+}
+
+void OpenGLRenderer::executeRenderImages(float timeValue)
+{
+    auto const qViewportSize =
+        QSize(unbox<int>(_renderTargetSize.width), unbox<int>(_renderTargetSize.height));
+    _backgroundShader->setUniformValue(_backgroundUniformLocations.projection, _projectionMatrix);
+    _backgroundShader->setUniformValue(_backgroundUniformLocations.viewportResolution, qViewportSize);
+    _backgroundShader->setUniformValue(_backgroundUniformLocations.blur, 0.0f);
+    _backgroundShader->setUniformValue(_backgroundUniformLocations.opacity, 1.0f);
+    _backgroundShader->setUniformValue(_backgroundUniformLocations.time, timeValue);
+
+    ++_imageFrame;
+    auto vertices = vector<BackgroundShaderParams> {};
+    auto textures = vector<GLuint> {};
+    vertices.reserve(_scheduledImages.size() * 6);
+    textures.reserve(_scheduledImages.size());
+
+    for (ScheduledImage const& scheduled: _scheduledImages)
+    {
+        auto const& image = scheduled.imageRect;
+        auto const& clip = scheduled.clipRect;
+        auto const x0 = std::max(image.x, clip.x);
+        auto const y0 = std::max(image.y, clip.y);
+        auto const x1 = std::min(image.x + image.width, clip.x + clip.width);
+        auto const y1 = std::min(image.y + image.height, clip.y + clip.height);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        auto const textureId = getOrCreateImageTexture(*scheduled.image);
+        if (!textureId)
+            continue;
+
+        // Texture rows are stored top-down, whereas the render target's Y axis points upwards.
+        auto const u0 = float(x0 - image.x) / float(image.width);
+        auto const u1 = float(x1 - image.x) / float(image.width);
+        auto const t0 = float(image.y + image.height - y0) / float(image.height);
+        auto const t1 = float(image.y + image.height - y1) / float(image.height);
+        auto const left = float(x0);
+        auto const right = float(x1);
+        auto const bottom = float(y0);
+        auto const top = float(y1);
+
+        // clang-format off
+        vertices.insert(vertices.end(), {
+            BackgroundShaderParams { vec3 { left,  bottom, 0.0f }, vec2 { u0, t0 } }, // bottom left
+            BackgroundShaderParams { vec3 { right, bottom, 0.0f }, vec2 { u1, t0 } }, // bottom right
+            BackgroundShaderParams { vec3 { right, top,    0.0f }, vec2 { u1, t1 } }, // top right
+            BackgroundShaderParams { vec3 { right, top,    0.0f }, vec2 { u1, t1 } }, // top right
+            BackgroundShaderParams { vec3 { left,  top,    0.0f }, vec2 { u0, t1 } }, // top left
+            BackgroundShaderParams { vec3 { left,  bottom, 0.0f }, vec2 { u0, t0 } }, // bottom left
+        });
+        // clang-format on
+        textures.push_back(textureId);
+    }
+    _scheduledImages.clear();
+    enforceImageTextureMemoryLimit();
+
+    if (textures.empty())
+        return;
+
+    CHECKED_GL(glActiveTexture(GL_TEXTURE0));
+    CHECKED_GL(glBindVertexArray(_backgroundVAO));
+    CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _backgroundVBO));
+    CHECKED_GL(glBufferData(GL_ARRAY_BUFFER,
+                            static_cast<GLsizeiptr>(vertices.size() * sizeof(BackgroundShaderParams)),
+                            vertices.data(),
+                            GL_STREAM_DRAW));
+
+    // Consecutive images of the same texture (e.g. the parts of an image that is partly
+    // overwritten by text) are drawn at once.
+    for (size_t i = 0; i < textures.size();)
+    {
+        auto end = i + 1;
+        while (end < textures.size() && textures[end] == textures[i])
+            ++end;
+        CHECKED_GL(bindTexture(textures[i]));
+        CHECKED_GL(
+            glDrawArrays(GL_TRIANGLES, static_cast<GLint>(i * 6), static_cast<GLsizei>((end - i) * 6)));
+        i = end;
+    }
+    CHECKED_GL(glBindVertexArray(0));
+}
 // }}}
 
 } // namespace contour::opengl
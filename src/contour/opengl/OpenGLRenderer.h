@@ -28,10 +28,13 @@
     #include <QtGui/QOpenGLShaderProgram>
 #endif
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace contour::opengl
 {
@@ -84,7 +87,12 @@ class OpenGLRenderer final:
     void setBackgroundImage(
         std::shared_ptr<terminal::BackgroundImage const> const& _backgroundImage) override;
     void renderRectangle(int x, int y, Width, Height, RGBAColor color) override;
+    void renderImage(std::shared_ptr<terminal::Image const> const& _image,
+                     terminal::renderer::PixelRect _imageRect,
+                     terminal::renderer::PixelRect _clipRect) override;
+    void discardImage(terminal::ImageId _imageId) override;
     void clear(terminal::RGBAColor _fillColor) override;
+    void setDamage(std::optional<terminal::renderer::PixelRect> _damage) override;
     void execute() override;
 
     std::pair<crispy::ImageSize, std::vector<uint8_t>> takeScreenshot();
@@ -93,6 +101,19 @@ class OpenGLRenderer final:
 
     void inspect(std::ostream& output) const override;
 
+    /// Compresses the textures of large images (see RenderTarget::renderImage()) into S3TC (DXT5),
+    /// a quarter of their size, if the GPU supports it.
+    ///
+    /// Images are compressed on a worker thread, one at a time, and rendered uncompressed until then.
+    void setImageTextureCompression(bool _enabled);
+
+    /// Limits the GPU memory the textures of images (see RenderTarget::renderImage()) may occupy.
+    ///
+    /// When exceeded, the textures of the least recently rendered images are deleted, to be uploaded
+    /// again when being rendered the next time. Textures rendered in the current frame are kept.
+    /// A value of 0 means unlimited.
+    void setImageTextureMemoryLimit(size_t _bytes) noexcept { _imageTextureMemoryLimit = _bytes; }
+
     void setTime(std::chrono::steady_clock::time_point value) { _now = value; }
 
     float uptime() noexcept
@@ -109,6 +130,7 @@ class OpenGLRenderer final:
     void initialize();
     void initializeBackgroundRendering();
     void initializeTextureRendering();
+    void setTextInstanceAttributes(GLsizeiptr _offset);
     void initializeRectRendering();
     int maxTextureDepth();
     int maxTextureSize();
@@ -121,14 +143,46 @@ class OpenGLRenderer final:
                                 uint8_t const* pixels);
 
     void executeRenderBackground(float timeValue);
+    void executeRenderImages(float timeValue);
+    GLuint getOrCreateImageTexture(terminal::Image const& _image);
+    void startImageCompression();
+    void collectCompressedImages();
+    void cancelImageCompression();
+    void enforceImageTextureMemoryLimit();
     void executeRenderTextures();
     void executeConfigureAtlas(ConfigureAtlas const& _param);
-    void executeUploadTile(UploadTile const& _param);
+    void executeUploadTiles(std::vector<UploadTile> const& _tiles);
     void executeRenderTile(RenderTile const& _param);
     void executeDestroyAtlas();
 
     //? void renderRectangle(int _x, int _y, int _width, int _height, QVector4D const& _color);
 
+    // Streaming state of a buffer object (vertices or pixels) that is written to as a ring of equally
+    // sized segments, one per frame, so that the CPU can fill the next segment while the GPU is still
+    // reading from the previous ones. The buffer storage is only reallocated when it must grow.
+    struct StreamingBuffer
+    {
+        static constexpr size_t SegmentCount = 3;
+
+        GLsizeiptr segmentSize = 0; // in bytes, a multiple of the element stride
+        size_t currentSegment = 0;
+        std::array<GLsync, SegmentCount> fences {};
+    };
+
+    /// Uploads @p _size bytes into the next ring segment of the buffer currently bound to @p _target
+    /// and returns the segment's offset in bytes.
+    GLsizeiptr streamData(
+        GLenum _target, StreamingBuffer& _buffer, void const* _data, size_t _size, size_t _stride);
+
+    /// Uploads @p _size bytes of vertices into the next ring segment of the currently bound
+    /// GL_ARRAY_BUFFER and returns the index of the first uploaded vertex.
+    GLint streamVertices(StreamingBuffer& _buffer, void const* _data, size_t _size, size_t _stride);
+
+    /// Marks the current ring segment as in use by the command(s) issued since streamData().
+    void fenceStream(StreamingBuffer& _buffer);
+
+    void destroyStreamingBuffer(StreamingBuffer& _buffer);
+
     void bindTexture(GLuint _textureId);
 
     // -------------------------------------------------------------------------------------------
@@ -182,6 +236,17 @@ class OpenGLRenderer final:
     //
     GLuint _textVAO {}; // Vertex Array Object, covering all buffer objects
     GLuint _textVBO {}; // Buffer containing the vertex coordinates
+    StreamingBuffer _textStream {};
+
+    // Pixel unpack buffer that the atlas tiles and images are uploaded from, so that the driver
+    // copies them into the textures asynchronously instead of stalling on client memory.
+    GLuint _uploadPBO {};
+    StreamingBuffer _uploadStream {};
+    std::vector<uint8_t> _uploadStaging; // tiles of the current frame, packed row by row
+
+    // Whether the text shader expands one instance per tile (see text.vert) rather than
+    // consuming six vertices per tile (as custom text shaders written before may do).
+    bool _textInstanced = false;
     // TODO: GLuint ebo_{};
 
     // currently bound texture ID during execution
@@ -202,6 +267,44 @@ class OpenGLRenderer final:
         int time;
     } _backgroundUniformLocations {};
 
+    // images rendered from textures of their own (see RenderTarget::renderImage())
+    struct ScheduledImage
+    {
+        std::shared_ptr<terminal::Image const> image;
+        terminal::renderer::PixelRect imageRect;
+        terminal::renderer::PixelRect clipRect;
+    };
+    std::vector<ScheduledImage> _scheduledImages;
+    struct ImageTexture
+    {
+        GLuint textureId = 0;   // 0 if the image cannot be uploaded
+        size_t bytes = 0;       // GPU memory occupied by the texture
+        uint64_t lastFrame = 0; // value of _imageFrame when last rendered
+    };
+    std::unordered_map<terminal::ImageId, ImageTexture> _imageTextures;
+    size_t _imageTextureBytes = 0;       // sum of bytes of all _imageTextures
+    size_t _imageTextureMemoryLimit = 0; // 0 for unlimited
+    uint64_t _imageFrame = 0;            // number of frames rendering images
+
+    // Image textures to be replaced by compressed ones, see setImageTextureCompression().
+    struct ImageCompression
+    {
+        terminal::ImageId imageId;
+        ImageSize size;
+        std::shared_ptr<terminal::Image::Data const> pixels;
+        std::atomic<bool> cancelled { false };
+        std::atomic<bool> finished { false };
+        std::vector<uint8_t> blocks {}; // owned by the worker until finished
+    };
+    bool _imageTextureCompression = false;
+    std::vector<std::shared_ptr<ImageCompression>> _pendingImageCompressions;
+    std::shared_ptr<ImageCompression> _imageCompression; // the one being compressed
+    struct
+    {
+        unsigned count = 0;    // number of textures compressed
+        uint64_t bytesSaved = 0;
+    } _imageCompressionStats;
+
     // index equals AtlasID
     struct AtlasAttributes
     {
@@ -219,9 +322,14 @@ class OpenGLRenderer final:
     int _rectTimeLocation;
     GLuint _rectVAO {};
     GLuint _rectVBO {};
+    StreamingBuffer _rectStream {};
 
     std::optional<ScreenshotCallback> _pendingScreenshotCallback;
 
+    // Clearing and the damaged area of the next execute(), see clear() and setDamage().
+    std::optional<terminal::RGBAColor> _pendingClear;
+    std::optional<terminal::renderer::PixelRect> _damage;
+
     // render state cache
     struct
     {
@@ -231,6 +339,16 @@ class OpenGLRenderer final:
         QSize backgroundResolution;
         crispy::StrongHash backgroundImageHash;
     } _renderStateCache;
+
+    // Cost of blurring the background image, as shown by inspect().
+    struct
+    {
+        unsigned blurCount = 0;    // number of images blurred
+        unsigned reuseCount = 0;   // number of times an already blurred image was reused
+        float lastCPUTime = 0.0f;  // in milliseconds
+        float lastGPUTime = 0.0f;  // in milliseconds
+        float totalGPUTime = 0.0f; // in milliseconds
+    } _blurStats;
 };
 
 } // namespace contour::opengl
@@ -0,0 +1,118 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/opengl/RenderThread.h>
+
+#include <QtCore/QMetaObject>
+#include <QtGui/QOpenGLContext>
+
+using std::function;
+using std::lock_guard;
+using std::move;
+using std::mutex;
+using std::unique_lock;
+
+namespace contour::opengl
+{
+
+RenderThread::RenderThread(QOpenGLWidget& widget, function<void()> renderFrame):
+    widget_ { widget }, renderFrame_ { move(renderFrame) }
+{
+    setObjectName("Render");
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+unique_lock<mutex> RenderThread::lock()
+{
+    auto l = unique_lock { lock_ };
+    handOver_.wait(l, [this]() { return !contextHandedOver_; });
+    return l;
+}
+
+void RenderThread::requestFrame()
+{
+    auto const _l = lock_guard { requestLock_ };
+    if (frameRequested_)
+        return;
+    frameRequested_ = true;
+    requestCondition_.notify_all();
+}
+
+void RenderThread::stop()
+{
+    exiting_ = true;
+    {
+        auto const _l = lock_guard { requestLock_ };
+        requestCondition_.notify_all();
+    }
+    {
+        auto const _l = lock_guard { lock_ };
+        handOver_.notify_all();
+    }
+    wait();
+}
+
+void RenderThread::handOverContext()
+{
+    auto const _l = lock_guard { lock_ };
+    if (exiting_)
+        return;
+
+    // A context must not be current on two threads at once.
+    if (QOpenGLContext::currentContext() == widget_.context())
+        widget_.doneCurrent();
+
+    widget_.context()->moveToThread(this);
+    contextHandedOver_ = true;
+    handOver_.notify_all();
+}
+
+void RenderThread::run()
+{
+    while (!exiting_)
+    {
+        {
+            auto l = unique_lock { requestLock_ };
+            requestCondition_.wait(l, [this]() { return exiting_ || frameRequested_; });
+            frameRequested_ = false;
+        }
+
+        auto l = unique_lock { lock_ };
+        if (exiting_)
+            return;
+
+        // Only the thread that the context lives in may make it current.
+        QMetaObject::invokeMethod(
+            &widget_, [this]() { handOverContext(); }, Qt::QueuedConnection);
+        handOver_.wait(l, [this]() { return exiting_ || contextHandedOver_; });
+        if (!contextHandedOver_)
+            return;
+
+        widget_.makeCurrent();
+        renderFrame_();
+        widget_.doneCurrent();
+
+        widget_.context()->moveToThread(widget_.thread());
+        contextHandedOver_ = false;
+        handOver_.notify_all();
+
+        // Composes the rendered frame into the window.
+        QMetaObject::invokeMethod(&widget_, "update", Qt::QueuedConnection);
+    }
+}
+
+} // namespace contour::opengl
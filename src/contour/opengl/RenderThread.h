@@ -0,0 +1,81 @@
+/**
+ * This file is part of the "contour" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <QtCore/QThread>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    #include <QtOpenGLWidgets/QOpenGLWidget>
+#else
+    #include <QtWidgets/QOpenGLWidget>
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace contour::opengl
+{
+
+/// Renders the frames of a QOpenGLWidget on a thread of its own, keeping the GUI thread
+/// free for event processing.
+///
+/// For every frame, the widget's OpenGL context is handed over from the GUI thread to the
+/// render thread, which renders into the widget's framebuffer and hands the context back.
+/// The GUI thread then composes the framebuffer into the window.
+///
+/// Whoever holds lock() owns the context (and everything the frame renders from), which is
+/// the GUI thread whenever the render thread is not rendering. The GUI thread must therefore
+/// hold it while composing or resizing the widget's framebuffer and while changing renderer state.
+class RenderThread: public QThread
+{
+  public:
+    /// @param widget      the widget to render the frames of, already initialized.
+    /// @param renderFrame renders a single frame, with the widget's context current.
+    RenderThread(QOpenGLWidget& widget, std::function<void()> renderFrame);
+    ~RenderThread() override;
+
+    /// Grants exclusive access to the widget's context, blocking while a frame is being rendered.
+    [[nodiscard]] std::unique_lock<std::mutex> lock();
+
+    /// Requests a frame to be rendered. Requests are coalesced until the frame has started.
+    ///
+    /// This never blocks on a frame in flight and may be called from any thread.
+    void requestFrame();
+
+    /// Stops rendering and waits for the thread to finish.
+    void stop();
+
+  protected:
+    void run() override;
+
+  private:
+    /// Moves the widget's context over to the render thread, invoked on the GUI thread.
+    void handOverContext();
+
+    QOpenGLWidget& widget_;
+    std::function<void()> renderFrame_;
+
+    std::mutex requestLock_;
+    std::condition_variable requestCondition_;
+    bool frameRequested_ = false;
+
+    std::mutex lock_;                  // guards the context ownership
+    std::condition_variable handOver_; // signals the context changing threads
+    bool contextHandedOver_ = false;   // whether the render thread owns the context
+
+    std::atomic<bool> exiting_ = false;
+};
+
+} // namespace contour::opengl
@@ -14,6 +14,8 @@
 #include <contour/helper.h>
 #include <contour/opengl/ShaderConfig.h>
 
+#include <crispy/StartupTrace.h>
+
 #include <QtCore/QFile>
 
 #include <iostream>
@@ -67,15 +69,19 @@ ShaderConfig builtinShaderConfig(ShaderClass shaderClass)
 
 std::unique_ptr<QOpenGLShaderProgram> createShader(ShaderConfig const& _shaderConfig)
 {
+    auto const _ = crispy::StartupTrace::Scope { "shader compilation" };
     auto shader = std::make_unique<QOpenGLShaderProgram>();
 
     auto extractShaderSource = [](ShaderSource const& source) -> tuple<string, string> {
         return { source.location.toStdString(), source.contents.toStdString() };
     };
 
+    // Cacheable shaders are only compiled if no program binary (keyed by the GL driver
+    // and the shader sources) is found in Qt's on-disk shader cache. Compile errors are
+    // therefore reported by link() instead.
     auto [vertexLocation, vertexSource] = extractShaderSource(_shaderConfig.vertexShader);
     DisplayLog()("Loading vertex shader: {}", vertexLocation);
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexSource.c_str()))
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertexSource.c_str()))
     {
         errorlog()("Compiling vertex shader {} failed. {}", vertexLocation, shader->log().toStdString());
         qDebug() << shader->log();
@@ -84,7 +90,7 @@ std::unique_ptr<QOpenGLShaderProgram> createShader(ShaderConfig const& _shaderCo
 
     auto [fragmentLocation, fragmentSource] = extractShaderSource(_shaderConfig.fragmentShader);
     DisplayLog()("Loading fragment shader: {}", fragmentLocation);
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource.c_str()))
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource.c_str()))
     {
         errorlog()("Compiling fragment shader {} failed. {}", fragmentLocation, shader->log().toStdString());
         qDebug() << shader->log();
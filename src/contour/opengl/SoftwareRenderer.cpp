@@ -0,0 +1,583 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <contour/helper.h>
+#include <contour/opengl/SoftwareRenderer.h>
+
+#include <terminal/ColorPalette.h>
+
+#include <crispy/PerfTrace.h>
+#include <crispy/PixelBlend.h>
+
+#include <QtGui/QImage>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+using std::get;
+using std::holds_alternative;
+using std::max;
+using std::min;
+using std::move;
+using std::nullopt;
+using std::optional;
+using std::shared_ptr;
+using std::vector;
+
+using terminal::Height;
+using terminal::ImageSize;
+using terminal::RGBAColor;
+using terminal::Width;
+using terminal::renderer::PixelRect;
+
+namespace atlas = terminal::renderer::atlas;
+
+namespace contour::opengl
+{
+
+namespace
+{
+    /// Returns the RGBA pixel of the given channels, as stored in memory.
+    uint32_t pixel(unsigned r, unsigned g, unsigned b, unsigned a) noexcept
+    {
+        uint8_t const bytes[4] = { uint8_t(r), uint8_t(g), uint8_t(b), uint8_t(a) };
+        auto result = uint32_t {};
+        std::memcpy(&result, bytes, sizeof(result));
+        return result;
+    }
+
+    /// Returns @p _value scaled by @p _factor, both in [0, 255].
+    constexpr unsigned scaled(unsigned _value, unsigned _factor) noexcept
+    {
+        return crispy::divideBy255(_value * _factor);
+    }
+
+    constexpr unsigned toByte(float _value) noexcept
+    {
+        return static_cast<unsigned>(std::clamp(_value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    constexpr bool isEmpty(PixelRect const& _rect) noexcept
+    {
+        return _rect.width <= 0 || _rect.height <= 0;
+    }
+
+    constexpr PixelRect intersection(PixelRect const& a, PixelRect const& b) noexcept
+    {
+        auto const x0 = max(a.x, b.x);
+        auto const y0 = max(a.y, b.y);
+        auto const x1 = min(a.x + a.width, b.x + b.width);
+        auto const y1 = min(a.y + a.height, b.y + b.height);
+        return PixelRect { x0, y0, max(0, x1 - x0), max(0, y1 - y0) };
+    }
+
+    constexpr PixelRect boundingRect(PixelRect const& a, PixelRect const& b) noexcept
+    {
+        auto const x0 = min(a.x, b.x);
+        auto const y0 = min(a.y, b.y);
+        auto const x1 = max(a.x + a.width, b.x + b.width);
+        auto const y1 = max(a.y + a.height, b.y + b.height);
+        return PixelRect { x0, y0, x1 - x0, y1 - y0 };
+    }
+
+    /// Converts pixels of the given format (with rows padded to @p _rowAlignment bytes)
+    /// into RGBA, the way OpenGL expands them into an RGBA texture.
+    void convertToRGBA(uint8_t* _target,
+                       uint8_t const* _source,
+                       ImageSize _size,
+                       size_t _elementCount,
+                       size_t _rowAlignment,
+                       size_t _targetPitch)
+    {
+        auto const width = unbox<size_t>(_size.width);
+        auto const rowSize = width * _elementCount;
+        auto const pitch = (rowSize + _rowAlignment - 1) / _rowAlignment * _rowAlignment;
+        for (size_t row = 0; row < unbox<size_t>(_size.height); ++row)
+        {
+            auto const* source = _source + row * pitch;
+            auto* target = _target + row * _targetPitch;
+            if (_elementCount == 4)
+            {
+                std::memcpy(target, source, rowSize);
+                continue;
+            }
+            for (size_t x = 0; x < width; ++x, source += _elementCount, target += 4)
+            {
+                target[0] = source[0];
+                target[1] = _elementCount == 3 ? source[1] : 0;
+                target[2] = _elementCount == 3 ? source[2] : 0;
+                target[3] = 0xFF;
+            }
+        }
+    }
+} // namespace
+
+SoftwareRenderer::SoftwareRenderer(crispy::ImageSize renderSize, terminal::renderer::PageMargin margin):
+    _margin { margin }
+{
+    setRenderSize(renderSize);
+}
+
+// {{{ AtlasBackend impl
+ImageSize SoftwareRenderer::atlasSize() const noexcept
+{
+    return _scheduledAtlas ? _scheduledAtlas->size : _atlas.size;
+}
+
+void SoftwareRenderer::configureAtlas(ConfigureAtlas atlas)
+{
+    DisplayLog()("configureAtlas: {} {}", atlas.size, atlas.properties.format);
+    _atlasProperties = atlas.properties;
+    _scheduledAtlas.emplace(atlas);
+}
+
+void SoftwareRenderer::uploadTile(UploadTile tile)
+{
+    _scheduledUploads.emplace_back(move(tile));
+}
+
+void SoftwareRenderer::renderTile(RenderTile tile)
+{
+    _scheduledTiles.emplace_back(tile);
+}
+// }}}
+
+// {{{ RenderTarget impl
+void SoftwareRenderer::setRenderSize(ImageSize size)
+{
+    DisplayLog()("setRenderSize: {}", size);
+    if (size == _frameSize)
+        return;
+
+    // The previous frame does not fit anymore, the next execute() redraws it in full.
+    _frameSize = size;
+    _frameBuffer.assign(size.area() * 4, 0);
+    _damage.reset();
+    _updatedArea.reset();
+}
+
+void SoftwareRenderer::setMargin(terminal::renderer::PageMargin margin) noexcept
+{
+    _margin = margin;
+}
+
+atlas::AtlasBackend& SoftwareRenderer::textureScheduler()
+{
+    return *this;
+}
+
+optional<terminal::renderer::AtlasTextureScreenshot> SoftwareRenderer::readAtlas()
+{
+    auto output = terminal::renderer::AtlasTextureScreenshot {};
+    output.atlasInstanceId = 0;
+    output.size = _atlas.size;
+    output.format = atlas::Format::RGBA;
+    output.buffer = _atlas.pixels;
+    return { move(output) };
+}
+
+void SoftwareRenderer::scheduleScreenshot(ScreenshotCallback callback)
+{
+    _pendingScreenshotCallback = move(callback);
+}
+
+void SoftwareRenderer::setBackgroundImage(
+    shared_ptr<terminal::BackgroundImage const> const& backgroundImageOpt)
+{
+    if (backgroundImageOpt && !_backgroundImage.pixels.empty()
+        && backgroundImageOpt->hash == _backgroundImageHash)
+    {
+        _backgroundImageOpacity = backgroundImageOpt->opacity;
+        return;
+    }
+
+    _backgroundImage = Bitmap {};
+    _backgroundImageOpacity = 1.0f;
+
+    if (!backgroundImageOpt)
+        return;
+
+    auto const& backgroundImage = *backgroundImageOpt;
+    _backgroundImageOpacity = backgroundImage.opacity;
+    _backgroundImageHash = backgroundImage.hash;
+
+    // Blurring is done on the GPU (see Blur), which is what this render target goes without.
+    if (backgroundImage.blur)
+        DisplayLog()("Background image blur is not supported by the software renderer.");
+
+    if (holds_alternative<FileSystem::path>(backgroundImage.location))
+    {
+        auto const filePath = get<FileSystem::path>(backgroundImage.location);
+        auto const qImage =
+            QImage(QString::fromStdString(filePath.string())).convertToFormat(QImage::Format_RGBA8888);
+        if (qImage.isNull())
+        {
+            errorlog()("Could not load background image at {}.", filePath.string());
+            return;
+        }
+        _backgroundImage.size =
+            ImageSize { Width::cast_from(qImage.width()), Height::cast_from(qImage.height()) };
+        _backgroundImage.pixels.resize(_backgroundImage.size.area() * 4);
+        convertToRGBA(_backgroundImage.pixels.data(),
+                      qImage.constBits(),
+                      _backgroundImage.size,
+                      4,
+                      static_cast<size_t>(qImage.bytesPerLine()),
+                      unbox<size_t>(_backgroundImage.size.width) * 4);
+    }
+    else if (holds_alternative<terminal::ImageDataPtr>(backgroundImage.location))
+    {
+        auto const& imageData = *get<terminal::ImageDataPtr>(backgroundImage.location);
+        _backgroundImage.size = imageData.size;
+        _backgroundImage.pixels.resize(_backgroundImage.size.area() * 4);
+        convertToRGBA(_backgroundImage.pixels.data(),
+                      imageData.pixels.data(),
+                      imageData.size,
+                      imageData.format == terminal::ImageFormat::RGBA ? 4 : 3,
+                      static_cast<size_t>(imageData.rowAlignment),
+                      unbox<size_t>(imageData.size.width) * 4);
+    }
+    DisplayLog()("Background image: {}", _backgroundImage.size);
+}
+
+void SoftwareRenderer::renderRectangle(int x, int y, Width width, Height height, RGBAColor color)
+{
+    _scheduledRectangles.emplace_back(
+        ScheduledRectangle { PixelRect { x, y, unbox<int>(width), unbox<int>(height) }, color });
+}
+
+void SoftwareRenderer::renderImage(shared_ptr<terminal::Image const> const& image,
+                                   PixelRect imageRect,
+                                   PixelRect clipRect)
+{
+    _scheduledImages.emplace_back(ScheduledImage { image, imageRect, clipRect });
+}
+
+void SoftwareRenderer::discardImage(terminal::ImageId)
+{
+    // Images are sampled from their own pixels, nothing to release.
+}
+
+void SoftwareRenderer::clear(terminal::RGBAColor fillColor)
+{
+    _pendingClear = fillColor;
+}
+
+void SoftwareRenderer::setDamage(optional<PixelRect> damage)
+{
+    _damage = damage;
+}
+
+void SoftwareRenderer::execute()
+{
+    CONTOUR_PERF_TRACE("SoftwareRenderer::execute");
+
+    auto const frame = PixelRect { 0, 0, unbox<int>(_frameSize.width), unbox<int>(_frameSize.height) };
+    _clip = _damage ? intersection(*_damage, frame) : frame;
+    _damage.reset();
+
+    if (_pendingClear)
+    {
+        executeClear(*_pendingClear);
+        _pendingClear.reset();
+    }
+
+    if (!_backgroundImage.pixels.empty())
+        executeRenderBackground();
+
+    for (auto const& rectangle: _scheduledRectangles)
+        executeRenderRectangle(rectangle);
+    _scheduledRectangles.clear();
+
+    for (auto const& image: _scheduledImages)
+        executeRenderImage(image);
+    _scheduledImages.clear();
+
+    if (_scheduledAtlas)
+    {
+        _atlas.size = _scheduledAtlas->size;
+        _atlas.pixels.assign(_atlas.size.area() * 4, 0);
+        _scheduledAtlas.reset();
+    }
+
+    for (auto const& tile: _scheduledUploads)
+        executeUploadTile(tile);
+    _scheduledUploads.clear();
+
+    for (auto const& tile: _scheduledTiles)
+        executeRenderTile(tile);
+    _scheduledTiles.clear();
+
+    if (!isEmpty(_clip))
+        _updatedArea = _updatedArea ? boundingRect(*_updatedArea, _clip) : _clip;
+
+    if (_pendingScreenshotCallback)
+    {
+        DisplayLog()("Capture screenshot ({}).", _frameSize);
+        _pendingScreenshotCallback.value()(takeScreenshot(), _frameSize);
+        _pendingScreenshotCallback.reset();
+    }
+}
+
+void SoftwareRenderer::clearCache()
+{
+}
+
+void SoftwareRenderer::inspect(std::ostream& output) const
+{
+    output << fmt::format("SoftwareRenderer\n");
+    output << fmt::format("------------------------\n");
+    output << fmt::format("framebuffer        : {}\n", _frameSize);
+    output << fmt::format("texture atlas      : {}\n", _atlas.size);
+    output << fmt::format("background image   : {}\n", _backgroundImage.size);
+    output << '\n';
+}
+
+optional<PixelRect> SoftwareRenderer::takeUpdatedArea() noexcept
+{
+    return std::exchange(_updatedArea, nullopt);
+}
+// }}}
+
+// {{{ executor impl
+uint8_t* SoftwareRenderer::frameRow(int y) noexcept
+{
+    auto const row = unbox<size_t>(_frameSize.height) - 1 - static_cast<size_t>(y);
+    return _frameBuffer.data() + row * unbox<size_t>(_frameSize.width) * 4;
+}
+
+PixelRect SoftwareRenderer::clipped(PixelRect rect) const noexcept
+{
+    return intersection(rect, _clip);
+}
+
+void SoftwareRenderer::executeClear(RGBAColor color)
+{
+    _backgroundColor = color;
+    if (isEmpty(_clip))
+        return;
+
+    auto const value = pixel(color.red(), color.green(), color.blue(), color.alpha());
+    auto* const first = frameRow(_clip.y) + _clip.x * 4;
+    for (int x = 0; x < _clip.width; ++x)
+        std::memcpy(first + x * 4, &value, sizeof(value));
+
+    auto const rowSize = static_cast<size_t>(_clip.width) * 4;
+    for (int y = _clip.y + 1; y < _clip.y + _clip.height; ++y)
+        std::memcpy(frameRow(y) + _clip.x * 4, first, rowSize);
+}
+
+void SoftwareRenderer::executeRenderBackground()
+{
+    if (isEmpty(_clip))
+        return;
+
+    // The image is stretched over the whole render target, faded by both the background color's
+    // alpha and the image's opacity, as by the background image shader.
+    auto const opacity = toByte(float(_backgroundColor.alpha()) / 255.0f * _backgroundImageOpacity);
+    auto const frameWidth = unbox<size_t>(_frameSize.width);
+    auto const frameHeight = unbox<size_t>(_frameSize.height);
+    auto const imageWidth = unbox<size_t>(_backgroundImage.size.width);
+    auto const imageHeight = unbox<size_t>(_backgroundImage.size.height);
+
+    auto const count = static_cast<size_t>(_clip.width);
+    _sourceRow.resize(count * 4);
+    _maskRow.resize(count * 4);
+    for (int y = _clip.y; y < _clip.y + _clip.height; ++y)
+    {
+        // Both the image and the framebuffer are stored top-down.
+        auto const frameRowIndex = frameHeight - 1 - static_cast<size_t>(y);
+        auto const* imageRow =
+            _backgroundImage.row(static_cast<int>(frameRowIndex * imageHeight / frameHeight));
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto const* texel = imageRow + (static_cast<size_t>(_clip.x) + i) * imageWidth / frameWidth * 4;
+            auto const alpha = scaled(texel[3], opacity);
+            auto const source =
+                pixel(scaled(texel[0], opacity), scaled(texel[1], opacity), scaled(texel[2], opacity), alpha);
+            auto const mask = pixel(alpha, alpha, alpha, 0);
+            std::memcpy(_sourceRow.data() + i * 4, &source, 4);
+            std::memcpy(_maskRow.data() + i * 4, &mask, 4);
+        }
+        crispy::blendPixels(frameRow(y) + _clip.x * 4, _sourceRow.data(), _maskRow.data(), count);
+    }
+}
+
+void SoftwareRenderer::executeRenderRectangle(ScheduledRectangle const& rectangle)
+{
+    auto const rect = clipped(rectangle.rect);
+    if (isEmpty(rect))
+        return;
+
+    auto const& color = rectangle.color;
+    auto const source = pixel(color.red(), color.green(), color.blue(), color.alpha());
+    auto const mask = pixel(color.alpha(), color.alpha(), color.alpha(), 0);
+    for (int y = rect.y; y < rect.y + rect.height; ++y)
+        crispy::blendSolid(frameRow(y) + rect.x * 4, source, mask, static_cast<size_t>(rect.width));
+}
+
+void SoftwareRenderer::executeRenderImage(ScheduledImage const& scheduled)
+{
+    auto const& imageRect = scheduled.imageRect;
+    auto const rect = clipped(intersection(imageRect, scheduled.clipRect));
+    if (isEmpty(rect))
+        return;
+
+    auto const& image = *scheduled.image;
+    auto const pixels = image.data();
+    if (!pixels)
+        return;
+
+    auto const elementCount = size_t { image.format() == terminal::ImageFormat::RGBA ? 4u : 3u };
+    auto const width = unbox<size_t>(image.width());
+    auto const height = unbox<size_t>(image.height());
+    if (pixels->size() < width * height * elementCount)
+        return;
+
+    auto const count = static_cast<size_t>(rect.width);
+    _sourceRow.resize(count * 4);
+    _maskRow.resize(count * 4);
+    for (int y = rect.y; y < rect.y + rect.height; ++y)
+    {
+        // Image rows are stored top-down, whereas the render target's Y axis points upwards.
+        auto const row = static_cast<size_t>(imageRect.y + imageRect.height - 1 - y) * height
+                         / static_cast<size_t>(imageRect.height);
+        auto const* imageRow = pixels->data() + row * width * elementCount;
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto const column = static_cast<size_t>(rect.x - imageRect.x) + i;
+            auto const* texel =
+                imageRow + column * width / static_cast<size_t>(imageRect.width) * elementCount;
+            auto const alpha = elementCount == 4 ? texel[3] : 0xFFu;
+            auto const source = pixel(texel[0], texel[1], texel[2], alpha);
+            auto const mask = pixel(alpha, alpha, alpha, 0);
+            std::memcpy(_sourceRow.data() + i * 4, &source, 4);
+            std::memcpy(_maskRow.data() + i * 4, &mask, 4);
+        }
+        crispy::blendPixels(frameRow(y) + rect.x * 4, _sourceRow.data(), _maskRow.data(), count);
+    }
+}
+
+void SoftwareRenderer::executeUploadTile(UploadTile const& tile)
+{
+    auto const x = static_cast<size_t>(tile.location.x.value);
+    auto const y = static_cast<size_t>(tile.location.y.value);
+    if (x + unbox<size_t>(tile.bitmapSize.width) > unbox<size_t>(_atlas.size.width)
+        || y + unbox<size_t>(tile.bitmapSize.height) > unbox<size_t>(_atlas.size.height))
+        return;
+
+    convertToRGBA(_atlas.row(static_cast<int>(y)) + x * 4,
+                  tile.bitmap.data(),
+                  tile.bitmapSize,
+                  atlas::element_count(tile.bitmapFormat),
+                  static_cast<size_t>(tile.rowAlignment),
+                  unbox<size_t>(_atlas.size.width) * 4);
+}
+
+void SoftwareRenderer::executeRenderTile(RenderTile const& tile)
+{
+    auto const bitmapWidth = unbox<int>(tile.bitmapSize.width);
+    auto const bitmapHeight = unbox<int>(tile.bitmapSize.height);
+    auto const targetWidth =
+        unbox<int>(tile.targetSize.width) ? unbox<int>(tile.targetSize.width) : bitmapWidth;
+    auto const targetHeight =
+        unbox<int>(tile.targetSize.height) ? unbox<int>(tile.targetSize.height) : bitmapHeight;
+
+    auto const rect = clipped(PixelRect { tile.x.value, tile.y.value, targetWidth, targetHeight });
+    if (isEmpty(rect))
+        return;
+
+    auto const atlasX = tile.tileLocation.x.value;
+    auto const atlasY = tile.tileLocation.y.value;
+    if (atlasX + bitmapWidth > unbox<int>(_atlas.size.width)
+        || atlasY + bitmapHeight > unbox<int>(_atlas.size.height))
+        return;
+
+    auto const r = toByte(tile.color[0]);
+    auto const g = toByte(tile.color[1]);
+    auto const b = toByte(tile.color[2]);
+    auto const a = toByte(tile.color[3]);
+
+    // The blending factors of each fragment shader selector, see text.frag.
+    auto const shade = [&](uint8_t const* texel, uint8_t* source, uint8_t* mask) {
+        auto coverage = 0u;
+        switch (tile.fragmentShaderSelector)
+        {
+            case FRAGMENT_SELECTOR_IMAGE_BGRA:
+                std::memcpy(source, texel, 4);
+                mask[0] = mask[1] = mask[2] = texel[3];
+                return;
+            case FRAGMENT_SELECTOR_GLYPH_LCD_SIMPLE:
+                coverage = (texel[0] + texel[1] + texel[2]) / 3u;
+                source[0] = uint8_t(scaled(texel[0], r));
+                source[1] = uint8_t(scaled(texel[1], g));
+                source[2] = uint8_t(scaled(texel[2], b));
+                source[3] = mask[0] = mask[1] = mask[2] = uint8_t(coverage);
+                return;
+            case FRAGMENT_SELECTOR_GLYPH_LCD:
+                // Each subpixel's coverage is its own blending factor.
+                source[0] = uint8_t(r);
+                source[1] = uint8_t(g);
+                source[2] = uint8_t(b);
+                source[3] = uint8_t(scaled((texel[0] + texel[1] + texel[2]) / 3u, a));
+                mask[0] = uint8_t(scaled(texel[0], a));
+                mask[1] = uint8_t(scaled(texel[1], a));
+                mask[2] = uint8_t(scaled(texel[2], a));
+                return;
+            case FRAGMENT_SELECTOR_GLYPH_SDF: {
+                auto const distance = (float(texel[0]) / 255.0f - 0.5f) * 2.0f * float(GLYPH_SDF_SPREAD);
+                coverage = toByte(distance + 0.5f);
+                break;
+            }
+            case FRAGMENT_SELECTOR_GLYPH_ALPHA:
+            default: coverage = texel[0]; break;
+        }
+        auto const alpha = uint8_t(scaled(coverage, a));
+        source[0] = uint8_t(r);
+        source[1] = uint8_t(g);
+        source[2] = uint8_t(b);
+        source[3] = mask[0] = mask[1] = mask[2] = alpha;
+    };
+
+    auto const count = static_cast<size_t>(rect.width);
+    _sourceRow.resize(count * 4);
+    _maskRow.resize(count * 4);
+    for (int y = rect.y; y < rect.y + rect.height; ++y)
+    {
+        // The bitmap's first row is rendered at the tile's bottom.
+        auto const* atlasRow = _atlas.row(atlasY + (y - tile.y.value) * bitmapHeight / targetHeight);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto const column = (rect.x - tile.x.value + static_cast<int>(i)) * bitmapWidth / targetWidth;
+            shade(atlasRow + (atlasX + column) * 4, _sourceRow.data() + i * 4, _maskRow.data() + i * 4);
+        }
+        crispy::blendPixels(frameRow(y) + rect.x * 4, _sourceRow.data(), _maskRow.data(), count);
+    }
+}
+
+vector<uint8_t> SoftwareRenderer::takeScreenshot() const
+{
+    // Screenshots are read bottom-up, as from an OpenGL framebuffer.
+    auto const rowSize = unbox<size_t>(_frameSize.width) * 4;
+    auto const height = unbox<size_t>(_frameSize.height);
+    auto buffer = vector<uint8_t>(_frameBuffer.size());
+    for (size_t row = 0; row < height; ++row)
+        std::memcpy(
+            buffer.data() + row * rowSize, _frameBuffer.data() + (height - 1 - row) * rowSize, rowSize);
+    return buffer;
+}
+// }}}
+
+} // namespace contour::opengl
@@ -0,0 +1,163 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Image.h>
+
+#include <terminal_renderer/RenderTarget.h>
+#include <terminal_renderer/TextureAtlas.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace contour::opengl
+{
+
+/// Render target compositing the frames on the CPU into an RGBA framebuffer in host memory,
+/// for machines without a (usable) GPU.
+///
+/// Glyph tiles are kept in an RGBA texture atlas in host memory as well and are blended into
+/// the framebuffer row by row with SIMD instructions (see crispy/PixelBlend.h), following
+/// the blending of the OpenGL text shader, so that both targets render the same frames.
+///
+/// Only the damaged area is cleared and drawn, like with OpenGLRenderer. The area that has been
+/// updated since it was last asked for is to be copied to the screen by the caller, see
+/// takeUpdatedArea().
+class SoftwareRenderer final:
+    public terminal::renderer::RenderTarget,
+    public terminal::renderer::atlas::AtlasBackend
+{
+    using ImageSize = terminal::ImageSize;
+    using PixelRect = terminal::renderer::PixelRect;
+
+    using AtlasTextureScreenshot = terminal::renderer::AtlasTextureScreenshot;
+
+    using ConfigureAtlas = terminal::renderer::atlas::ConfigureAtlas;
+    using UploadTile = terminal::renderer::atlas::UploadTile;
+    using RenderTile = terminal::renderer::atlas::RenderTile;
+
+  public:
+    SoftwareRenderer(crispy::ImageSize renderSize, terminal::renderer::PageMargin margin);
+
+    // AtlasBackend implementation
+    ImageSize atlasSize() const noexcept override;
+    void configureAtlas(ConfigureAtlas atlas) override;
+    void uploadTile(UploadTile tile) override;
+    void renderTile(RenderTile tile) override;
+
+    // RenderTarget implementation
+    void setRenderSize(crispy::ImageSize _size) override;
+    void setMargin(terminal::renderer::PageMargin _margin) noexcept override;
+    std::optional<AtlasTextureScreenshot> readAtlas() override;
+    AtlasBackend& textureScheduler() override;
+    void scheduleScreenshot(ScreenshotCallback _callback) override;
+    void setBackgroundImage(
+        std::shared_ptr<terminal::BackgroundImage const> const& _backgroundImage) override;
+    void renderRectangle(int x, int y, Width, Height, RGBAColor color) override;
+    void renderImage(std::shared_ptr<terminal::Image const> const& _image,
+                     PixelRect _imageRect,
+                     PixelRect _clipRect) override;
+    void discardImage(terminal::ImageId _imageId) override;
+    void clear(terminal::RGBAColor _fillColor) override;
+    void setDamage(std::optional<PixelRect> _damage) override;
+    void execute() override;
+    void clearCache() override;
+    void inspect(std::ostream& output) const override;
+
+    /// Size of the framebuffer in pixels.
+    [[nodiscard]] ImageSize frameSize() const noexcept { return _frameSize; }
+
+    /// RGBA pixels of the framebuffer, with rows stored top-down (unlike the render target's
+    /// coordinates), so that it can be handed to image APIs as is.
+    [[nodiscard]] uint8_t const* frameBuffer() const noexcept { return _frameBuffer.data(); }
+
+    /// Returns the bounding rectangle of the areas drawn by execute() since the previous call,
+    /// in render target coordinates, or std::nullopt if nothing has been drawn.
+    [[nodiscard]] std::optional<PixelRect> takeUpdatedArea() noexcept;
+
+  private:
+    // RGBA pixels with rows stored top-down.
+    struct Bitmap
+    {
+        ImageSize size {};
+        std::vector<uint8_t> pixels {};
+
+        [[nodiscard]] uint8_t* row(int y) noexcept
+        {
+            return pixels.data() + static_cast<size_t>(y) * unbox<size_t>(size.width) * 4;
+        }
+    };
+
+    struct ScheduledRectangle
+    {
+        PixelRect rect;
+        RGBAColor color;
+    };
+
+    struct ScheduledImage
+    {
+        std::shared_ptr<terminal::Image const> image;
+        PixelRect imageRect;
+        PixelRect clipRect;
+    };
+
+    /// Returns the row of the framebuffer at render target coordinate @p y.
+    [[nodiscard]] uint8_t* frameRow(int y) noexcept;
+
+    /// Returns the part of @p _rect within the current clipping rectangle.
+    [[nodiscard]] PixelRect clipped(PixelRect _rect) const noexcept;
+
+    void executeClear(RGBAColor _color);
+    void executeRenderBackground();
+    void executeRenderRectangle(ScheduledRectangle const& _rectangle);
+    void executeRenderImage(ScheduledImage const& _scheduled);
+    void executeUploadTile(UploadTile const& _tile);
+    void executeRenderTile(RenderTile const& _tile);
+
+    std::vector<uint8_t> takeScreenshot() const;
+
+    ImageSize _frameSize;
+    std::vector<uint8_t> _frameBuffer;
+    terminal::renderer::PageMargin _margin {};
+
+    Bitmap _atlas;
+    terminal::renderer::atlas::AtlasProperties _atlasProperties {};
+
+    // Background image, converted to RGBA, and its opacity.
+    Bitmap _backgroundImage;
+    float _backgroundImageOpacity = 1.0f;
+    crispy::StrongHash _backgroundImageHash;
+
+    // {{{ scheduling data, executed in this order
+    std::optional<RGBAColor> _pendingClear;
+    std::vector<ScheduledRectangle> _scheduledRectangles;
+    std::vector<ScheduledImage> _scheduledImages;
+    std::optional<ConfigureAtlas> _scheduledAtlas;
+    std::vector<UploadTile> _scheduledUploads;
+    std::vector<RenderTile> _scheduledTiles;
+    std::optional<ScreenshotCallback> _pendingScreenshotCallback;
+    // }}}
+
+    RGBAColor _backgroundColor {};
+    std::optional<PixelRect> _damage;
+    PixelRect _clip {}; // area being drawn by the current execute()
+    std::optional<PixelRect> _updatedArea;
+
+    // One row of source and mask pixels each, to blend into the framebuffer at once.
+    std::vector<uint8_t> _sourceRow;
+    std::vector<uint8_t> _maskRow;
+};
+
+} // namespace contour::opengl
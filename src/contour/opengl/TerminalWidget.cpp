@@ -12,9 +12,11 @@
  * limitations under the License.
  */
 #include <contour/Actions.h>
+#include <contour/Clipboard.h>
 #include <contour/ContourGuiApp.h>
 #include <contour/helper.h>
 #include <contour/opengl/OpenGLRenderer.h>
+#include <contour/opengl/SoftwareRenderer.h>
 #include <contour/opengl/TerminalWidget.h>
 
 #include <terminal/Color.h>
@@ -22,6 +24,9 @@
 #include <terminal/pty/Pty.h>
 
 #include <crispy/App.h>
+#include <crispy/CacheRegistry.h>
+#include <crispy/PerfTrace.h>
+#include <crispy/StartupTrace.h>
 #include <crispy/logstore.h>
 #include <crispy/stdfs.h>
 
@@ -36,7 +41,14 @@
 #include <QtGui/QClipboard>
 #include <QtGui/QDesktopServices>
 #include <QtGui/QGuiApplication>
+#include <QtGui/QFontDatabase>
 #include <QtGui/QKeyEvent>
+#include <QtGui/QPainter>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    #include <QtOpenGL/QOpenGLPaintDevice>
+#else
+    #include <QtGui/QOpenGLPaintDevice>
+#endif
 #include <QtGui/QScreen>
 #include <QtGui/QWindow>
 #include <QtWidgets/QApplication>
@@ -109,6 +121,10 @@ using actions::Action;
 // {{{ helper
 namespace
 {
+    // Minimum time between two page resizes while the window is being resized interactively,
+    // which is also the time the window size must be stable before the final page resize.
+    constexpr auto ResizeInterval = chrono::milliseconds(100);
+
 #if !defined(NDEBUG) && defined(GL_DEBUG_OUTPUT) && defined(CONTOUR_DEBUG_OPENGL)
     void glMessageCallback(GLenum _source,
                            GLenum _type,
@@ -270,6 +286,9 @@ TerminalWidget::TerminalWidget(TerminalSession& session,
 {
     initializeResourcesForContourFrontendOpenGL();
     session_.setContentScale(contentScale());
+    renderer_.setGlyphRasterizationBudget(session_.config().glyphRasterizationBudget);
+    renderer_.setCacheGrowthLimit(session_.config().cacheGrowthLimit);
+    renderer_.setImageTextureMode(session_.config().imageTextures);
 
     setMouseTracking(true);
     setFormat(surfaceFormat());
@@ -277,18 +296,46 @@ TerminalWidget::TerminalWidget(TerminalSession& session,
     setAttribute(Qt::WA_InputMethodEnabled, true);
     setAttribute(Qt::WA_OpaquePaintEvent);
 
+    // Keep the previous frame in the framebuffer, so that only damaged lines need to be redrawn.
+    setUpdateBehavior(QOpenGLWidget::PartialUpdate);
+
     // setAttribute(Qt::WA_TranslucentBackground);
     // setAttribute(Qt::WA_NoSystemBackground, false);
 
     updateTimer_.setSingleShot(true);
     connect(&updateTimer_, &QTimer::timeout, [this]() { scheduleRedraw(); });
 
+    frameTimer_.setSingleShot(true);
+    connect(&frameTimer_, &QTimer::timeout, [this]() { requestFrame(); });
+
+    resizeTimer_.setSingleShot(true);
+    resizeTimer_.setInterval(ResizeInterval);
+    connect(&resizeTimer_, &QTimer::timeout, [this]() { applyPendingResize(); });
+
+    if (session_.config().threadedRendering)
+    {
+        // The framebuffer is rendered into by the render thread, so it must not be touched by it
+        // while being composed into the window or recreated. See initializeGL().
+        connect(this, &QOpenGLWidget::aboutToCompose, [this]() {
+            if (renderThread_)
+                composeLock_ = renderThread_->lock();
+        });
+        connect(this, &QOpenGLWidget::aboutToResize, [this]() {
+            if (renderThread_)
+                composeLock_ = renderThread_->lock();
+        });
+        connect(this, &QOpenGLWidget::resized, [this]() { composeLock_ = {}; });
+        connect(this, &QOpenGLWidget::frameSwapped, [this]() { composeLock_ = {}; });
+    }
+
     connect(this, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
 }
 
 TerminalWidget::~TerminalWidget()
 {
     DisplayLog()("~TerminalWidget");
+    if (renderThread_)
+        renderThread_->stop();
     makeCurrent(); // XXX must be called.
     renderTarget_.reset();
     doneCurrent();
@@ -378,9 +425,11 @@ void TerminalWidget::applyFontDPI()
 
     DisplayLog()("Applying DPI {}.", newFontDPI);
     lastFontDPI_ = newFontDPI;
-    auto fd = renderer_.fontDescriptions();
-    fd.dpi = newFontDPI;
-    renderer_.setFonts(fd);
+    withRenderer([&]() {
+        auto fd = renderer_.fontDescriptions();
+        fd.dpi = newFontDPI;
+        renderer_.setFonts(fd);
+    });
     logDisplayInfo();
 
     session_.setContentScale(contentScale());
@@ -388,7 +437,7 @@ void TerminalWidget::applyFontDPI()
     auto const newPixelSize = terminal::ImageSize { Width::cast_from(width()), Height::cast_from(height()) };
 
     // Apply resize on same window metrics propagates proper recalculations and repaint.
-    applyResize(newPixelSize, session_, renderer_);
+    withRenderer([&]() { applyResize(newPixelSize, session_, renderer_); });
 }
 
 void TerminalWidget::logDisplayTopInfo()
@@ -492,6 +541,8 @@ using opengl::ShaderClass;
 
 void TerminalWidget::initializeGL()
 {
+    auto const _ = crispy::StartupTrace::Scope { "GL initialization" };
+    CONTOUR_PERF_TRACE_THREAD("Render");
     DisplayLog()("initializeGL: size={}x{}, scale={}", size().width(), size().height(), contentScale());
     initializeOpenGLFunctions();
     configureScreenHooks();
@@ -507,13 +558,23 @@ void TerminalWidget::initializeGL()
         return uiSize * contentScale();
     }();
 
-    renderTarget_ = make_unique<OpenGLRenderer>(
-        profile().textShader.value_or(builtinShaderConfig(ShaderClass::Text)),
-        profile().backgroundShader.value_or(builtinShaderConfig(ShaderClass::Background)),
-        profile().backgroundImageShader.value_or(builtinShaderConfig(ShaderClass::BackgroundImage)),
-        precalculatedVieewSize,
-        textureTileSize,
-        viewportMargin);
+    // The software renderer composes the frames on the CPU, leaving OpenGL (possibly a software
+    // implementation of it, see ContourGuiApp) with nothing but copying them to the screen.
+    if (session_.config().renderingBackend == config::RenderingBackend::Software)
+        renderTarget_ = make_unique<SoftwareRenderer>(precalculatedVieewSize, viewportMargin);
+    else
+    {
+        auto openGLRenderer = make_unique<OpenGLRenderer>(
+            profile().textShader.value_or(builtinShaderConfig(ShaderClass::Text)),
+            profile().backgroundShader.value_or(builtinShaderConfig(ShaderClass::Background)),
+            profile().backgroundImageShader.value_or(builtinShaderConfig(ShaderClass::BackgroundImage)),
+            precalculatedVieewSize,
+            textureTileSize,
+            viewportMargin);
+        openGLRenderer->setImageTextureCompression(session_.config().imageTextureCompression);
+        openGLRenderer->setImageTextureMemoryLimit(size_t(session_.config().maxImageGpuMemory) * 1024 * 1024);
+        renderTarget_ = std::move(openGLRenderer);
+    }
 
     renderer_.setRenderTarget(*renderTarget_);
 
@@ -529,6 +590,13 @@ void TerminalWidget::initializeGL()
     CHECKED_GL(glDebugMessageCallback(&glMessageCallback, this));
 #endif
 
+    if (session_.config().threadedRendering)
+    {
+        renderThread_ = make_unique<RenderThread>(*this, [this]() { renderFrame(); });
+        renderThread_->start();
+        requestFrame();
+    }
+
     session_.displayInitialized();
 }
 
@@ -539,10 +607,63 @@ void TerminalWidget::resizeGL(int _width, int _height)
         terminal::ImageSize { Width::cast_from(_width), Height::cast_from(_height) };
     auto const newPixelSize = qtBaseWidgetSize * contentScale();
     DisplayLog()("resizeGL: {}x{} ({})", _width, _height, newPixelSize);
-    applyResize(newPixelSize, session_, renderer_);
+
+    pendingResize_ = newPixelSize;
+    if (steady_clock::now() - lastResize_ >= ResizeInterval)
+    {
+        applyPendingResize();
+        return;
+    }
+
+    // Until then, the current page is rendered into the resized framebuffer as is.
+    withRenderer([&]() {
+        applyRenderSize(newPixelSize, renderer_.gridMetrics().pageSize, renderer_);
+        renderer_.invalidate();
+    });
+    resizeTimer_.start();
+
+    // The recreated framebuffer is blank and only the render thread can fill it.
+    if (renderThread_)
+        requestFrame();
+}
+
+void TerminalWidget::applyPendingResize()
+{
+    resizeTimer_.stop();
+    if (!pendingResize_)
+        return;
+
+    auto const newPixelSize = *pendingResize_;
+    pendingResize_.reset();
+    lastResize_ = steady_clock::now();
+    withRenderer([&]() {
+        applyResize(newPixelSize, session_, renderer_);
+        renderer_.invalidate();
+    });
+    requestFrame();
+}
+
+void TerminalWidget::paintEvent(QPaintEvent* _event)
+{
+    // The frames are rendered by the render thread, which then schedules their composition.
+    if (!renderThread_)
+        QOpenGLWidget::paintEvent(_event);
 }
 
 void TerminalWidget::paintGL()
+{
+    renderFrame();
+}
+
+void TerminalWidget::requestFrame()
+{
+    if (renderThread_)
+        renderThread_->requestFrame();
+    else
+        update();
+}
+
+void TerminalWidget::renderFrame()
 {
     // We consider *this* the true initial start-time.
     // That shouldn't be significantly different from the object construction
@@ -554,6 +675,10 @@ void TerminalWidget::paintGL()
     {
         [[maybe_unused]] auto const lastState = state_.fetchAndClear();
 
+        auto const frameStart = steady_clock::now();
+        terminal().frameScheduler().frameStarted(frameStart);
+        renderingPressure_ = terminal().frameScheduler().underPressure(frameStart);
+
 #if defined(CONTOUR_PERF_STATS)
         {
             ++renderCount_;
@@ -569,13 +694,57 @@ void TerminalWidget::paintGL()
         }
 #endif
 
-        static_cast<OpenGLRenderer*>(renderTarget_.get())->setTime(steady_clock::now());
+        if (auto* openGLRenderer = dynamic_cast<OpenGLRenderer*>(renderTarget_.get()))
+            openGLRenderer->setTime(steady_clock::now());
+
+        // The overlays are painted on top of the frame, so the frame below must be drawn in full.
+        auto const showsBenchmarkResults = benchmark_ && benchmark_->finished();
+        if (metricsOverlay_ || showsBenchmarkResults)
+            renderer_.invalidate();
 
         renderTarget_->clear(
             terminal().isModeEnabled(terminal::DECMode::ReverseVideo)
                 ? RGBAColor(profile().colors.defaultForeground, uint8_t(renderer_.backgroundOpacity()))
                 : RGBAColor(profile().colors.defaultBackground, uint8_t(renderer_.backgroundOpacity())));
+        auto const renderStart = steady_clock::now();
         renderer_.render(terminal(), renderingPressure_);
+
+        if (auto* softwareRenderer = dynamic_cast<SoftwareRenderer*>(renderTarget_.get()))
+            presentSoftwareFrame(*softwareRenderer);
+
+        auto const renderEnd = steady_clock::now();
+        if (benchmark_)
+            benchmark_->frameRendered(renderEnd - renderStart);
+
+        if (shownAt_)
+        {
+            auto const latency = steady_clock::now() - *shownAt_;
+            shownAt_.reset();
+            DisplayLog()("First frame rendered {} after being shown.",
+                         std::chrono::duration_cast<std::chrono::microseconds>(latency));
+            if (metricsOverlay_)
+                metricsOverlay_->displayShown(latency);
+        }
+
+        if (metricsOverlay_)
+        {
+            metricsOverlay_->frameRendered(renderEnd - renderStart);
+            metricsOverlay_->update(terminal(), renderer_, renderEnd);
+        }
+
+        if (metricsOverlay_ || showsBenchmarkResults)
+        {
+            auto lines = metricsOverlay_ ? metricsOverlay_->lines() : vector<string> {};
+            if (showsBenchmarkResults)
+                lines.insert(lines.end(), benchmark_->lines().begin(), benchmark_->lines().end());
+            auto device = QOpenGLPaintDevice(size() * devicePixelRatioF());
+            device.setDevicePixelRatio(devicePixelRatioF());
+            paintOverlay(device, lines);
+        }
+
+        // Render again for the glyphs that exceeded this frame's rasterization budget.
+        if (renderer_.hasDeferredGlyphs())
+            setScreenDirty();
     }
     catch (exception const& e)
     {
@@ -583,6 +752,60 @@ void TerminalWidget::paintGL()
     }
 }
 
+void TerminalWidget::paintOverlay(QPaintDevice& _device, vector<string> const& _lines)
+{
+    if (_lines.empty())
+        return;
+
+    auto constexpr Padding = 8;
+
+    QPainter painter(&_device);
+    painter.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    auto const fontMetrics = painter.fontMetrics();
+    auto textWidth = 0;
+    for (auto const& line: _lines)
+        textWidth = max(textWidth, fontMetrics.horizontalAdvance(QString::fromStdString(line)));
+    auto const textHeight = fontMetrics.height() * static_cast<int>(_lines.size());
+
+    painter.fillRect(QRect(Padding, Padding, textWidth + 2 * Padding, textHeight + 2 * Padding),
+                     QColor(0, 0, 0, 0xC0));
+    painter.setPen(Qt::white);
+    for (size_t i = 0; i < _lines.size(); ++i)
+        painter.drawText(2 * Padding,
+                         2 * Padding + fontMetrics.ascent() + fontMetrics.height() * static_cast<int>(i),
+                         QString::fromStdString(_lines[i]));
+    painter.end();
+
+    // QPainter leaves its own OpenGL state behind, whereas the renderer relies on the one it
+    // has set up once at initialization.
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+}
+
+void TerminalWidget::presentSoftwareFrame(SoftwareRenderer& _renderTarget)
+{
+    auto const area = _renderTarget.takeUpdatedArea();
+    if (!area)
+        return;
+
+    // The framebuffer's rows are stored top-down, so the updated ones are a slice of it.
+    // They are copied as they are (rather than blended), as OpenGLRenderer would have drawn them.
+    auto const frameSize = _renderTarget.frameSize();
+    auto const width = unbox<int>(frameSize.width);
+    auto const top = unbox<int>(frameSize.height) - area->y - area->height;
+    auto const bytesPerLine = width * 4;
+    auto const image = QImage(_renderTarget.frameBuffer() + top * bytesPerLine,
+                              width,
+                              area->height,
+                              bytesPerLine,
+                              QImage::Format_RGBA8888_Premultiplied);
+
+    auto device = QOpenGLPaintDevice(size() * devicePixelRatioF());
+    QPainter painter(&device);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(QPoint(0, top), image);
+}
+
 float TerminalWidget::uptime() const noexcept
 {
     using namespace std::chrono;
@@ -594,10 +817,29 @@ float TerminalWidget::uptime() const noexcept
 
 void TerminalWidget::onFrameSwapped()
 {
+    auto const now = steady_clock::now();
+    terminal().inputLatency().framePresented(now);
+    terminal().frameScheduler().framePresented(now);
+
+    if (crispy::StartupTrace::enabled())
+    {
+        crispy::StartupTrace::mark("first frame swapped");
+        crispy::StartupTrace::finish();
+    }
+
     if (!state_.finish())
-        update();
+    {
+        // More changes came in meanwhile, so render them as soon as the frame pacing allows.
+        auto const delay = terminal().frameScheduler().nextFrameDelay(now);
+        if (delay == steady_clock::duration::zero())
+            requestFrame();
+        else
+            frameTimer_.start(std::chrono::ceil<std::chrono::milliseconds>(delay));
+    }
     else if (auto timeout = terminal().nextRender(); timeout.has_value())
         updateTimer_.start(timeout.value());
+    else if (metricsOverlay_)
+        updateTimer_.start(MetricsOverlay::UpdateInterval);
 }
 // }}}
 
@@ -698,6 +940,13 @@ bool TerminalWidget::event(QEvent* _event)
             session_.pty().close();
             emit terminated();
         }
+        else if (_event->type() == QEvent::Hide)
+            terminal().setHidden(true);
+        else if (_event->type() == QEvent::Show && terminal().hidden())
+        {
+            withRenderer([&]() { shownAt_ = steady_clock::now(); });
+            terminal().setHidden(false);
+        }
 
         return QOpenGLWidget::event(_event);
     }
@@ -833,8 +1082,8 @@ void TerminalWidget::bell()
 
 void TerminalWidget::copyToClipboard(std::string_view _data)
 {
-    if (QClipboard* clipboard = QGuiApplication::clipboard(); clipboard != nullptr)
-        clipboard->setText(QString::fromUtf8(_data.data(), static_cast<int>(_data.size())));
+    // The text is only converted for the platform clipboard once pasted.
+    ClipboardWriter::copy(QClipboard::Clipboard, std::string(_data));
 }
 
 void TerminalWidget::inspect()
@@ -842,8 +1091,24 @@ void TerminalWidget::inspect()
     post([this]() { doDumpState(); });
 }
 
+void TerminalWidget::inspectMemoryUsage(std::ostream& _os)
+{
+    withRenderer([&]() { renderer_.inspectMemoryUsage(_os); });
+}
+
+void TerminalWidget::trimMemory()
+{
+    withRenderer([&]() { renderer_.trimMemory(); });
+}
+
+void TerminalWidget::releaseGrownCaches()
+{
+    withRenderer([&]() { renderer_.releaseGrownCaches(); });
+}
+
 void TerminalWidget::doDumpState()
 {
+    auto const _l = renderThread_ ? renderThread_->lock() : std::unique_lock<std::mutex> {};
     makeCurrent();
 
     // clang-format off
@@ -871,6 +1136,12 @@ void TerminalWidget::doDumpState()
             auto os = std::stringstream {};
             terminal().currentScreen().inspect("Screen state dump.", os);
             renderer_.inspect(os);
+            terminal().inspectMemoryUsage(os);
+            terminal().inspectLocks(os);
+            renderer_.inspectMemoryUsage(os);
+            crispy::CacheRegistry::get().inspect(os);
+            if (terminal().inputLatency().enabled())
+                terminal().inputLatency().inspect(os);
             return os.str();
         }();
 
@@ -970,7 +1241,7 @@ void TerminalWidget::doDumpState()
         });
 
     // force an update to actually render the screenshot
-    update();
+    requestFrame();
 }
 
 void TerminalWidget::notify(std::string_view /*_title*/, std::string_view /*_body*/)
@@ -997,7 +1268,7 @@ void TerminalWidget::resizeWindow(terminal::Width _width, terminal::Height _heig
 
     // setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
     const_cast<config::TerminalProfile&>(profile()).terminalSize = requestedPageSize;
-    renderer_.setPageSize(requestedPageSize);
+    withRenderer([&]() { renderer_.setPageSize(requestedPageSize); });
     auto const pixels =
         terminal::ImageSize { terminal::Width::cast_from(unbox<int>(requestedPageSize.columns)
                                                          * unbox<int>(gridMetrics().cellSize.width)),
@@ -1024,7 +1295,7 @@ void TerminalWidget::resizeWindow(terminal::LineCount _lines, terminal::ColumnCo
 
     // setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
     const_cast<config::TerminalProfile&>(profile()).terminalSize = requestedPageSize;
-    renderer_.setPageSize(requestedPageSize);
+    withRenderer([&]() { renderer_.setPageSize(requestedPageSize); });
     auto const pixels = terminal::ImageSize {
         terminal::Width(unbox<unsigned>(requestedPageSize.columns) * *gridMetrics().cellSize.width),
         terminal::Height(unbox<unsigned>(requestedPageSize.lines) * *gridMetrics().cellSize.height)
@@ -1036,27 +1307,37 @@ void TerminalWidget::resizeWindow(terminal::LineCount _lines, terminal::ColumnCo
 
 void TerminalWidget::setFonts(terminal::renderer::FontDescriptions fonts)
 {
-    if (applyFontDescription(gridMetrics().cellSize, pageSize(), pixelSize(), fontDPI(), renderer_, fonts))
-    {
+    auto const applied = withRenderer([&]() {
+        if (!applyFontDescription(
+                gridMetrics().cellSize, pageSize(), pixelSize(), fontDPI(), renderer_, fonts))
+            return false;
         // resize widget (same pixels, but adjusted terminal rows/columns and margin)
         applyResize(pixelSize(), session_, renderer_);
+        return true;
+    });
+    if (applied)
         logDisplayInfo();
-    }
 }
 
 bool TerminalWidget::setFontSize(text::font_size _size)
 {
     DisplayLog()("Setting display font size and recompute metrics: {}pt", _size.pt);
 
-    if (!renderer_.setFontSize(_size))
+    auto const applied = withRenderer([&]() {
+        if (!renderer_.setFontSize(_size))
+            return false;
+
+        auto const qtBaseWidgetSize =
+            ImageSize { terminal::Width::cast_from(width()), terminal::Height::cast_from(height()) };
+        renderer_.setMargin(computeMargin(gridMetrics().cellSize, pageSize(), qtBaseWidgetSize));
+        // resize widget (same pixels, but adjusted terminal rows/columns and margin)
+        auto const actualWidgetSize = qtBaseWidgetSize * contentScale();
+        applyResize(actualWidgetSize, session_, renderer_);
+        return true;
+    });
+    if (!applied)
         return false;
 
-    auto const qtBaseWidgetSize =
-        ImageSize { terminal::Width::cast_from(width()), terminal::Height::cast_from(height()) };
-    renderer_.setMargin(computeMargin(gridMetrics().cellSize, pageSize(), qtBaseWidgetSize));
-    // resize widget (same pixels, but adjusted terminal rows/columns and margin)
-    auto const actualWidgetSize = qtBaseWidgetSize * contentScale();
-    applyResize(actualWidgetSize, session_, renderer_);
     updateMinimumSize();
     logDisplayInfo();
     return true;
@@ -1070,7 +1351,7 @@ bool TerminalWidget::setPageSize(PageSize _newPageSize)
     auto const viewSize =
         ImageSize { Width(*gridMetrics().cellSize.width * unbox<unsigned>(profile().terminalSize.columns)),
                     Height(*gridMetrics().cellSize.width * unbox<unsigned>(profile().terminalSize.columns)) };
-    renderer_.setPageSize(_newPageSize);
+    withRenderer([&]() { renderer_.setPageSize(_newPageSize); });
     terminal().resizeScreen(_newPageSize, viewSize);
     return true;
 }
@@ -1120,7 +1401,10 @@ void TerminalWidget::setBlurBehind(bool _enable)
 void TerminalWidget::setBackgroundImage(
     std::shared_ptr<terminal::BackgroundImage const> const& backgroundImage)
 {
-    renderTarget_->setBackgroundImage(backgroundImage);
+    withRenderer([&]() {
+        renderTarget_->setBackgroundImage(backgroundImage);
+        renderer_.invalidate();
+    });
 }
 
 void TerminalWidget::toggleFullScreen()
@@ -1143,6 +1427,51 @@ void TerminalWidget::toggleFullScreen()
     //     window_.setVisibility(QWindow::FullScreen);
 }
 
+void TerminalWidget::toggleMetricsOverlay()
+{
+    withRenderer([&]() {
+        if (metricsOverlay_)
+            metricsOverlay_.reset();
+        else
+            metricsOverlay_.emplace();
+        renderer_.invalidate();
+    });
+    scheduleRedraw();
+}
+
+void TerminalWidget::runBenchmark()
+{
+    // Invoked again, the results of the last run are hidden, or the running one is stopped.
+    if (benchmark_)
+    {
+        // Stopping waits for the benchmark's thread, which must not hold up the render thread.
+        auto const benchmark = withRenderer([&]() {
+            renderer_.invalidate();
+            return std::move(benchmark_);
+        });
+        scheduleRedraw();
+        return;
+    }
+
+    auto const system = withRenderer([&]() -> string {
+        if (dynamic_cast<SoftwareRenderer*>(renderTarget_.get()))
+            return fmt::format("software renderer, {}", QGuiApplication::platformName().toStdString());
+        return fmt::format("{} {}, {}",
+                           QOpenGLContext::currentContext()->isOpenGLES() ? "OpenGL/ES" : "OpenGL",
+                           (char const*) glGetString(GL_RENDERER),
+                           QGuiApplication::platformName().toStdString());
+    });
+
+    // The results are shown once finished, with the next frame.
+    auto benchmark = make_unique<LiveBenchmark>(session_, system, [this]() {
+        post([this]() {
+            withRenderer([&]() { renderer_.invalidate(); });
+            scheduleRedraw();
+        });
+    });
+    withRenderer([&]() { benchmark_ = std::move(benchmark); });
+}
+
 void TerminalWidget::toggleTitleBar()
 {
     bool fullscreenState = window()->isFullScreen();
@@ -1167,12 +1496,15 @@ void TerminalWidget::toggleTitleBar()
 void TerminalWidget::setHyperlinkDecoration(terminal::renderer::Decorator _normal,
                                             terminal::renderer::Decorator _hover)
 {
-    renderer_.setHyperlinkDecoration(_normal, _hover);
+    withRenderer([&]() { renderer_.setHyperlinkDecoration(_normal, _hover); });
 }
 
 void TerminalWidget::setBackgroundOpacity(terminal::Opacity _opacity)
 {
-    renderer_.setBackgroundOpacity(_opacity);
+    withRenderer([&]() {
+        renderer_.setBackgroundOpacity(_opacity);
+        renderer_.invalidate();
+    });
     session_.terminal().breakLoopAndRefreshRenderBuffer();
 }
 // }}}
@@ -1182,7 +1514,7 @@ void TerminalWidget::scheduleRedraw()
 {
     if (setScreenDirty())
     {
-        update(); // QCoreApplication::postEvent(this, new QEvent(QEvent::UpdateRequest));
+        requestFrame();
 
         emit terminalBufferUpdated(); // TODO: should not be invoked, as it's not guarranteed to be updated.
     }
@@ -15,9 +15,12 @@
 
 #include <contour/Actions.h>
 #include <contour/Config.h>
+#include <contour/LiveBenchmark.h>
+#include <contour/MetricsOverlay.h>
 #include <contour/TerminalDisplay.h>
 #include <contour/TerminalSession.h>
 #include <contour/helper.h>
+#include <contour/opengl/RenderThread.h>
 
 #include <terminal/Color.h>
 #include <terminal/Metrics.h>
@@ -42,14 +45,19 @@
 #include <QtWidgets/QSystemTrayIcon>
 
 #include <atomic>
+#include <chrono>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <vector>
 
 namespace contour::opengl
 {
 
+class SoftwareRenderer;
+
 // It currently just handles one terminal inside, but ideally later it can handle
 // multiple terminals in tabbed views as well tiled.
 class TerminalWidget: public QOpenGLWidget, public TerminalDisplay, private QOpenGLExtraFunctions
@@ -70,6 +78,7 @@ class TerminalWidget: public QOpenGLWidget, public TerminalDisplay, private QOpe
     void initializeGL() override;
     void resizeGL(int _width, int _height) override;
     void paintGL() override;
+    void paintEvent(QPaintEvent* _event) override;
     // }}}
 
     // {{{ Input handling
@@ -104,10 +113,14 @@ class TerminalWidget: public QOpenGLWidget, public TerminalDisplay, private QOpe
     void bell() override;
     void copyToClipboard(std::string_view /*_data*/) override;
     void inspect() override;
+    void inspectMemoryUsage(std::ostream& _os) override;
+    void trimMemory() override;
+    void releaseGrownCaches() override;
     void doDumpState();
     void notify(std::string_view /*_title*/, std::string_view /*_body*/) override;
     void resizeWindow(terminal::LineCount, terminal::ColumnCount) override;
     void resizeWindow(terminal::Width, terminal::Height) override;
+    void runBenchmark() override;
     void setFonts(terminal::renderer::FontDescriptions _fontDescriptions) override;
     bool setFontSize(text::font_size _size) override;
     bool setPageSize(terminal::PageSize _newPageSize) override;
@@ -119,6 +132,7 @@ class TerminalWidget: public QOpenGLWidget, public TerminalDisplay, private QOpe
     void setBlurBehind(bool _enable) override;
     void setBackgroundImage(std::shared_ptr<terminal::BackgroundImage const> const& backgroundImage) override;
     void toggleFullScreen() override;
+    void toggleMetricsOverlay() override;
     void toggleTitleBar() override;
     void setHyperlinkDecoration(terminal::renderer::Decorator _normal,
                                 terminal::renderer::Decorator _hover) override;
@@ -168,6 +182,29 @@ class TerminalWidget: public QOpenGLWidget, public TerminalDisplay, private QOpe
 
     void statsSummary();
     void doResize(crispy::Size _size);
+    void applyPendingResize();
+    void renderFrame();
+    void paintOverlay(QPaintDevice& _device, std::vector<std::string> const& _lines);
+
+    /// Copies the area of the software renderer's framebuffer updated by the last frame(s)
+    /// into the widget's framebuffer.
+    void presentSoftwareFrame(SoftwareRenderer& _renderTarget);
+
+    /// Requests the next frame to be rendered, by the render thread if rendering is threaded.
+    void requestFrame();
+
+    /// Runs @p _fn with exclusive access to the renderer and the OpenGL context,
+    /// which belong to the render thread while it renders a frame.
+    template <typename F>
+    decltype(auto) withRenderer(F&& _fn)
+    {
+        if (!renderThread_)
+            return _fn();
+
+        auto const _l = renderThread_->lock();
+        makeCurrent();
+        return _fn();
+    }
 
     terminal::renderer::GridMetrics const& gridMetrics() const noexcept { return renderer_.gridMetrics(); }
 
@@ -196,14 +233,37 @@ class TerminalWidget: public QOpenGLWidget, public TerminalDisplay, private QOpe
     PermissionCache rememberedPermissions_ {};
     bool maximizedState_ = false;
     bool titleBarState_ = !profile().show_title_bar;
+    std::optional<MetricsOverlay> metricsOverlay_;
+
+    // Time the widget was shown again after having been hidden, until its first frame is rendered.
+    // While hidden, the renderer keeps its presented frame and caches, so that only the damage
+    // accumulated meanwhile is drawn then. Guarded like the renderer, see withRenderer().
+    std::optional<std::chrono::steady_clock::time_point> shownAt_;
+
+    // The benchmark being run, or the last one run while its results are shown.
+    std::unique_ptr<LiveBenchmark> benchmark_;
 
     // update() timer used to animate the blinking cursor.
     QTimer updateTimer_;
 
+    // update() timer used to delay frames, as decided by the terminal's FrameScheduler.
+    QTimer frameTimer_;
+
+    // While the window is being resized interactively, the page is resized (reflowing the grid
+    // and signalling the application) at a bounded rate, and once more when the size settled.
+    QTimer resizeTimer_;
+    std::optional<terminal::ImageSize> pendingResize_;
+    std::chrono::steady_clock::time_point lastResize_;
+
     RenderStateManager state_;
 
     QFileSystemWatcher filesystemWatcher_;
 
+    // Renders the frames if rendering is threaded, with composeLock_ held while the GUI thread
+    // composes or resizes the framebuffer that the render thread renders into.
+    std::unique_ptr<RenderThread> renderThread_;
+    std::unique_lock<std::mutex> composeLock_;
+
     // ======================================================================
 
 #if defined(CONTOUR_PERF_STATS)
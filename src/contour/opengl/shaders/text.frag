@@ -6,9 +6,11 @@ in vec4 fs_TexCoord;
 in vec4 fs_textColor;
 
 // Dual source blending (since OpenGL 3.3)
-// layout (location = 0, index = 0) out vec4 color;
-// layout (location = 0, index = 1) out vec4 colorMask;
-out vec4 fragColor;
+//
+// The framebuffer is blended as `fragColor * fragColorMask + dst * (1 - fragColorMask)`,
+// which allows LCD glyphs to contribute their coverage per color channel.
+layout (location = 0, index = 0) out vec4 fragColor;
+layout (location = 0, index = 1) out vec4 fragColorMask;
 
 const vec4 TEST_PIXEL = vec4(1.0, 0.0, 0.0, 1.0); // test pixel for debugging
 
@@ -23,6 +25,16 @@ void renderGrayscaleGlyph()
     vec4 pixel = texture(fs_textureAtlas, fs_TexCoord.xy);
     vec4 sampled = vec4(1.0, 1.0, 1.0, pixel.r);
     fragColor = sampled * fs_textColor;
+    fragColorMask = vec4(fragColor.a);
+}
+
+// Renders a glyph from its signed distance field, the outline being at 0.5 in the red channel.
+void renderSdfGlyph()
+{
+    float distance = (texture(fs_textureAtlas, fs_TexCoord.xy).r - 0.5) * 2.0 * float(GLYPH_SDF_SPREAD);
+    float coverage = clamp(distance + 0.5, 0.0, 1.0);
+    fragColor = vec4(1.0, 1.0, 1.0, coverage) * fs_textColor;
+    fragColorMask = vec4(fragColor.a);
 }
 
 // Renders an RGBA texture. This is used to render images (such as Sixel graphics or Emoji).
@@ -32,6 +44,7 @@ void renderColoredRGBA()
     vec4 v = texture(fs_textureAtlas, fs_TexCoord.xy);
     //v = TEST_PIXEL;
     fragColor = v;
+    fragColorMask = vec4(fragColor.a);
 }
 
 // Simple LCD subpixel rendering will cause color fringes on the left/right side of the glyph
@@ -45,6 +58,7 @@ void renderLcdGlyphSimple()
     float a = (v.r + v.g + v.b) / 3.0;
 
     fragColor = vec4(v.rgb * fs_textColor.rgb, a);
+    fragColorMask = vec4(fragColor.a);
 }
 
 // Calcualtes subpixel shifting.
@@ -116,22 +130,12 @@ void renderLcdGlyph()
     const float shift = 0.0;
     vec3 shifted = lcdPixelShift(current.rgb, previous.rgb, shift);
 
-    float r = shifted.r;
-    float g = shifted.g;
-    float b = shifted.b;
+    // Each subpixel's coverage is used as its own blending factor, so the text color is
+    // mixed into the background per color channel by the blending stage.
+    float alpha = (shifted.r + shifted.g + shifted.b) / 3.0 * fs_textColor.a;
 
-    float rgbAvg = (r + g + b) / 3.0;
-    float rgbMin = min(min(r, g), b);
-    float rgbMax = max(max(r, g), b);
-    float rgbMaxNormComplement = 1.0 - rgbMax;
-
-    vec4 colorContribution = vec4(fs_textColor.rgb, rgbAvg) * rgbMax;
-    vec4 glyphContribution = vec4(r, g, b, rgbMin)          * rgbMaxNormComplement;
-    vec4 color = glyphContribution + colorContribution;
-
-    float alpha = color.a * fs_textColor.a;
-
-    fragColor = vec4(color.rgb, alpha);
+    fragColor = vec4(fs_textColor.rgb, alpha);
+    fragColorMask = vec4(shifted * fs_textColor.a, alpha);
 }
 
 void main()
@@ -149,6 +153,9 @@ void main()
         case FRAGMENT_SELECTOR_IMAGE_BGRA:
             renderColoredRGBA();
             break;
+        case FRAGMENT_SELECTOR_GLYPH_SDF:
+            renderSdfGlyph();
+            break;
         case FRAGMENT_SELECTOR_GLYPH_ALPHA:
         default:
             renderGrayscaleGlyph();
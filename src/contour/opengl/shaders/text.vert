@@ -1,16 +1,24 @@
-uniform mat4 vs_projection;                 // projection matrix (flips around the coordinate system)
+uniform mat4 vs_projection; // projection matrix (flips around the coordinate system)
 
-layout (location = 0) in vec3 vs_vertex;    // target vertex coordinates
-layout (location = 1) in vec4 vs_texCoords; // 2D-atlas texture coordinates
-layout (location = 2) in vec4 vs_colors;    // custom foreground colors
+// One instance per rendered tile; the quad's six vertices are expanded from gl_VertexID.
+layout (location = 0) in vec4 vs_instanceRect;      // target rectangle (x, y, width, height)
+layout (location = 1) in vec4 vs_instanceTexRect;   // 2D-atlas texture rectangle (x, y, width, height)
+layout (location = 2) in vec4 vs_colors;            // custom foreground colors
+layout (location = 3) in float vs_instanceSelector; // fragment shader selector
 
 out vec4 fs_TexCoord;
 out vec4 fs_textColor;
 
+// Corners of the two triangles: left top, left bottom, right bottom, left top, right bottom, right top.
+const vec2 corners[6] = vec2[6](vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0),
+                                vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0));
+
 void main()
 {
-    gl_Position = vs_projection * vec4(vs_vertex.xyz, 1.0);
+    vec2 corner = corners[gl_VertexID];
+
+    gl_Position = vs_projection * vec4(vs_instanceRect.xy + corner * vs_instanceRect.zw, 0.0, 1.0);
 
-    fs_TexCoord = vs_texCoords;
+    fs_TexCoord = vec4(vs_instanceTexRect.xy + corner * vs_instanceTexRect.zw, 0.0, vs_instanceSelector);
     fs_textColor = vs_colors;
 }
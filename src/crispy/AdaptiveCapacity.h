@@ -0,0 +1,110 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/StrongLRUHashtable.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+namespace crispy
+{
+
+/// Bounds within which AdaptiveCapacity moves the capacity of a cache.
+struct CapacityBounds
+{
+    uint32_t minimum;
+    uint32_t maximum;
+};
+
+/**
+ * Decides on the capacity of a cache from the lookups observed at safe points of its user,
+ * such as between two frames, at which the cache can be recreated with another capacity.
+ *
+ * The capacity doubles once the cache evicted more than an eighth of its entries at each of
+ * GrowAfter consecutive samples, i.e. its working set does not fit (e.g. heavy Unicode output),
+ * and halves again once it did not evict anything for ShrinkAfter consecutive samples.
+ * The much longer period to shrink avoids oscillating, as the working set might only just fit.
+ */
+class AdaptiveCapacity
+{
+  public:
+    static constexpr unsigned GrowAfter = 3;
+    static constexpr unsigned ShrinkAfter = 3600; // about a minute of frames at 60 Hz
+
+    AdaptiveCapacity(uint32_t _capacity, CapacityBounds _bounds) noexcept:
+        bounds_ { _bounds.minimum, std::max(_bounds.minimum, _bounds.maximum) },
+        capacity_ { std::clamp(_capacity, bounds_.minimum, bounds_.maximum) }
+    {
+    }
+
+    [[nodiscard]] uint32_t capacity() const noexcept { return capacity_; }
+    [[nodiscard]] CapacityBounds bounds() const noexcept { return bounds_; }
+
+    /// Tests whether the capacity is above its minimum, i.e. the cache has grown.
+    [[nodiscard]] bool grown() const noexcept { return capacity_ > bounds_.minimum; }
+
+    /// Caps the capacity to at most @p _maximum, e.g. because the cache cannot grow beyond it.
+    void limit(uint32_t _maximum) noexcept
+    {
+        bounds_.maximum = std::max(bounds_.minimum, std::min(bounds_.maximum, _maximum));
+        capacity_ = std::min(capacity_, bounds_.maximum);
+    }
+
+    /// Samples the lookups of the cache since the last sample.
+    ///
+    /// @returns the capacity to recreate the cache with, if it is to change.
+    std::optional<uint32_t> update(LRUHashtableStats const& _stats) noexcept
+    {
+        if (_stats.recycles > capacity_ / 8)
+        {
+            calmSamples_ = 0;
+            if (++thrashingSamples_ < GrowAfter || capacity_ >= bounds_.maximum)
+                return std::nullopt;
+            return resize(capacity_ * 2);
+        }
+
+        thrashingSamples_ = 0;
+        if (_stats.recycles != 0 || ++calmSamples_ < ShrinkAfter || !grown())
+            return std::nullopt;
+        return resize(capacity_ / 2);
+    }
+
+    /// Shrinks the capacity back to its minimum, e.g. when the cache's user went idle.
+    ///
+    /// @returns the capacity to recreate the cache with, if it is to change.
+    std::optional<uint32_t> release() noexcept
+    {
+        if (!grown())
+            return std::nullopt;
+        return resize(bounds_.minimum);
+    }
+
+  private:
+    uint32_t resize(uint32_t _capacity) noexcept
+    {
+        capacity_ = std::clamp(_capacity, bounds_.minimum, bounds_.maximum);
+        thrashingSamples_ = 0;
+        calmSamples_ = 0;
+        return capacity_;
+    }
+
+    CapacityBounds bounds_;
+    uint32_t capacity_;
+    unsigned thrashingSamples_ = 0; // consecutive samples evicting too many entries
+    unsigned calmSamples_ = 0;      // consecutive samples not evicting any entry
+};
+
+} // namespace crispy
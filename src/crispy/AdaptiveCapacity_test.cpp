@@ -0,0 +1,101 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/AdaptiveCapacity.h>
+
+#include <catch2/catch.hpp>
+
+using crispy::AdaptiveCapacity;
+using crispy::CapacityBounds;
+using crispy::LRUHashtableStats;
+
+namespace
+{
+
+constexpr auto Thrashing = LRUHashtableStats { 500, 500, 500 }; // evicts more than an eighth of 1000 to 3000
+constexpr auto Calm = LRUHashtableStats { 200, 0, 0 };
+
+} // namespace
+
+TEST_CASE("AdaptiveCapacity.clamps", "[AdaptiveCapacity]")
+{
+    auto const capacity = AdaptiveCapacity(10, CapacityBounds { 100, 50 });
+    CHECK(capacity.capacity() == 100);
+    CHECK(capacity.bounds().maximum == 100);
+    CHECK(!capacity.grown());
+}
+
+TEST_CASE("AdaptiveCapacity.grow", "[AdaptiveCapacity]")
+{
+    auto capacity = AdaptiveCapacity(1000, CapacityBounds { 1000, 3000 });
+
+    for (unsigned i = 1; i < AdaptiveCapacity::GrowAfter; ++i)
+        CHECK(!capacity.update(Thrashing));
+    CHECK(capacity.update(Thrashing) == 2000);
+    CHECK(capacity.grown());
+
+    // A single calm sample restarts counting.
+    for (unsigned i = 1; i < AdaptiveCapacity::GrowAfter; ++i)
+        CHECK(!capacity.update(Thrashing));
+    CHECK(!capacity.update(Calm));
+    for (unsigned i = 1; i < AdaptiveCapacity::GrowAfter; ++i)
+        CHECK(!capacity.update(Thrashing));
+    CHECK(capacity.update(Thrashing) == 3000);
+
+    // The maximum is not exceeded.
+    for (unsigned i = 0; i < 2 * AdaptiveCapacity::GrowAfter; ++i)
+        CHECK(!capacity.update(Thrashing));
+    CHECK(capacity.capacity() == 3000);
+}
+
+TEST_CASE("AdaptiveCapacity.shrink", "[AdaptiveCapacity]")
+{
+    auto capacity = AdaptiveCapacity(4000, CapacityBounds { 1000, 8000 });
+
+    for (unsigned i = 1; i < AdaptiveCapacity::ShrinkAfter; ++i)
+        REQUIRE(!capacity.update(Calm));
+    CHECK(capacity.update(Calm) == 2000);
+
+    // Any eviction restarts counting.
+    for (unsigned i = 1; i < AdaptiveCapacity::ShrinkAfter; ++i)
+        REQUIRE(!capacity.update(Calm));
+    CHECK(!capacity.update(LRUHashtableStats { 100, 1, 1 }));
+    CHECK(capacity.capacity() == 2000);
+
+    // The minimum is not undercut.
+    for (unsigned i = 0; i < 3 * AdaptiveCapacity::ShrinkAfter; ++i)
+        (void) capacity.update(Calm);
+    CHECK(capacity.capacity() == 1000);
+}
+
+TEST_CASE("AdaptiveCapacity.release", "[AdaptiveCapacity]")
+{
+    auto capacity = AdaptiveCapacity(1000, CapacityBounds { 1000, 8000 });
+    CHECK(!capacity.release());
+
+    for (unsigned i = 0; i < 2 * AdaptiveCapacity::GrowAfter; ++i)
+        (void) capacity.update(Thrashing);
+    CHECK(capacity.capacity() == 4000);
+    CHECK(capacity.release() == 1000);
+    CHECK(!capacity.grown());
+}
+
+TEST_CASE("AdaptiveCapacity.limit", "[AdaptiveCapacity]")
+{
+    auto capacity = AdaptiveCapacity(4000, CapacityBounds { 1000, 8000 });
+    capacity.limit(2000);
+    CHECK(capacity.capacity() == 2000);
+    CHECK(capacity.bounds().maximum == 2000);
+    capacity.limit(10);
+    CHECK(capacity.capacity() == 1000);
+}
@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include <crispy/App.h>
+#include <crispy/AsyncLogSink.h>
 #include <crispy/indexed.h>
 #include <crispy/logstore.h>
 #include <crispy/utils.h>
@@ -252,6 +253,18 @@ void App::customizeLogStoreOutput()
 {
     logstore::Sink::console().set_enabled(true);
 
+    // Debug logging is formatted and written on a background thread, so that enabling chatty
+    // categories does not slow down the logging threads. Errors are still written synchronously,
+    // in order to not lose them upon a crash.
+    struct AsyncConsole
+    {
+        logstore::AsyncSink sink { true, std::cout };
+        ~AsyncConsole() { logstore::set_sink(logstore::Sink::console()); }
+    };
+    static auto asyncConsole = AsyncConsole {};
+    logstore::set_sink(asyncConsole.sink);
+    logstore::ErrorLog.set_sink(logstore::Sink::console());
+
     // A curated list of colors.
     static const bool colorized =
 #if !defined(_WIN32)
@@ -293,12 +306,12 @@ void App::customizeLogStoreOutput()
             else
             {
                 // clang-format off
-                auto const now = chrono::system_clock::now();
+                auto const now = _msg.time();
                 auto const micros =
                     duration_cast<chrono::microseconds>(now.time_since_epoch()).count() % 1'000'000;
                 result += sgrTag;
                 result += fmt::format("[{:%Y-%m-%d %H:%M:%S}.{:06}] [{}]",
-                                      chrono::system_clock::now(),
+                                      now,
                                       micros,
                                       _msg.category().name());
                 result += sgrReset;
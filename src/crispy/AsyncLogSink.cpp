@@ -0,0 +1,316 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/AsyncLogSink.h>
+#include <crispy/utils.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::unique_lock;
+
+namespace logstore
+{
+
+namespace
+{
+    // Binary record as stored in a ring buffer, directly followed by the message text,
+    // padded up to the alignment of the next record.
+    struct RecordHeader
+    {
+        Category const* category; // nullptr for padding up to the end of the ring buffer
+        char const* fileName;
+        char const* functionName;
+        int64_t time; // system clock ticks
+        int line;
+        uint32_t textLength;
+    };
+
+    constexpr size_t RecordAlignment = alignof(RecordHeader);
+
+    constexpr size_t alignedSize(size_t _size) noexcept
+    {
+        return (_size + RecordAlignment - 1) & ~(RecordAlignment - 1);
+    }
+
+    std::atomic<uint64_t> nextSinkId = 1;
+} // namespace
+
+struct AsyncSink::Ring
+{
+    explicit Ring(size_t _size): storage(_size) {}
+
+    // Positions are monotonically increasing byte offsets, taken modulo the storage size.
+    std::vector<uint8_t> storage;
+    alignas(64) std::atomic<uint64_t> head = 0; // written by the producer
+    alignas(64) std::atomic<uint64_t> tail = 0; // written by the consumer
+    std::atomic<bool> retired = false;          // set once the producing thread has exited
+
+    /// Appends a record, or returns false if it does not fit.
+    bool push(MessageBuilder const& _message)
+    {
+        auto const size = storage.size();
+        auto const text = std::string_view(_message.text());
+        auto const recordSize = alignedSize(sizeof(RecordHeader) + text.size());
+        auto position = head.load(memory_order_relaxed);
+        auto const offset = position % size;
+        auto const spaceToEnd = size - offset;
+        auto const paddingSize = recordSize <= spaceToEnd ? 0 : spaceToEnd;
+
+        if (position + paddingSize + recordSize - tail.load(memory_order_acquire) > size)
+            return false;
+
+        if (paddingSize)
+        {
+            if (paddingSize >= sizeof(RecordHeader))
+                new (&storage[offset]) RecordHeader { nullptr, nullptr, nullptr, 0, 0, 0 };
+            position += paddingSize;
+        }
+
+        auto* header = new (&storage[position % size])
+            RecordHeader { &_message.category(),
+                           _message.location().file_name(),
+                           _message.location().function_name(),
+                           _message.time().time_since_epoch().count(),
+                           _message.location().line(),
+                           static_cast<uint32_t>(text.size()) };
+        std::memcpy(header + 1, text.data(), text.size());
+
+        head.store(position + recordSize, memory_order_release);
+        return true;
+    }
+
+    /// Passes all available records to @p _consume, returning whether there were any.
+    template <typename Consumer>
+    bool consume(Consumer _consume)
+    {
+        auto const size = storage.size();
+        auto const end = head.load(memory_order_acquire);
+        auto position = tail.load(memory_order_relaxed);
+        if (position == end)
+            return false;
+
+        while (position != end)
+        {
+            auto const offset = position % size;
+            auto const spaceToEnd = size - offset;
+            if (spaceToEnd < sizeof(RecordHeader))
+            {
+                position += spaceToEnd;
+                continue;
+            }
+
+            auto const* header = reinterpret_cast<RecordHeader const*>(&storage[offset]);
+            if (!header->category)
+            {
+                position += spaceToEnd;
+                continue;
+            }
+
+            auto const* text = reinterpret_cast<char const*>(header + 1);
+            _consume(*header, std::string_view(text, header->textLength));
+            position += alignedSize(sizeof(RecordHeader) + header->textLength);
+        }
+
+        tail.store(position, memory_order_release);
+        return true;
+    }
+};
+
+AsyncSink::AsyncSink(bool _enabled, Writer _writer, size_t _ringSize):
+    Sink(_enabled, std::move(_writer)),
+    id_ { nextSinkId++ },
+    ringSize_ { std::max(crispy::nextPowerOfTwo(static_cast<uint32_t>(_ringSize)), 4096u) },
+    thread_ { [this]() { main(); } }
+{
+}
+
+AsyncSink::AsyncSink(bool _enabled, std::ostream& _output, size_t _ringSize):
+    AsyncSink(
+        _enabled,
+        [out = &_output](std::string_view text) {
+            *out << text;
+            out->flush();
+        },
+        _ringSize)
+{
+}
+
+AsyncSink::~AsyncSink()
+{
+    {
+        auto const _ = lock_guard { mutex_ };
+        terminating_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+AsyncSink::Ring& AsyncSink::localRing()
+{
+    // Owns the rings of the calling thread, retiring them when the thread exits,
+    // so that the background thread frees them once it has drained them.
+    // Sinks are identified by ID rather than address, as a sink may be created at the
+    // address of a destroyed one.
+    struct LocalRings
+    {
+        std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+
+        ~LocalRings()
+        {
+            for (auto const& [_, ring]: rings)
+                ring->retired.store(true, memory_order_release);
+        }
+    };
+    thread_local LocalRings localRings;
+
+    for (auto const& [id, ring]: localRings.rings)
+        if (id == id_)
+            return *ring;
+
+    // Rings no longer shared with any sink belong to sinks that have been destroyed.
+    auto& rings = localRings.rings;
+    rings.erase(
+        std::remove_if(rings.begin(), rings.end(), [](auto const& x) { return x.second.use_count() == 1; }),
+        rings.end());
+
+    auto const _ = lock_guard { ringsMutex_ };
+    auto& ring = rings_.emplace_back(std::make_shared<Ring>(ringSize_));
+    rings.emplace_back(id_, ring);
+    return *ring;
+}
+
+size_t AsyncSink::ringCount()
+{
+    auto const _ = lock_guard { ringsMutex_ };
+    return rings_.size();
+}
+
+void AsyncSink::write(MessageBuilder const& _message)
+{
+    if (!enabled_ || !_message.category().is_enabled())
+        return;
+
+    if (localRing().push(_message))
+        notify();
+    else
+        dropped_.fetch_add(1, memory_order_relaxed);
+}
+
+void AsyncSink::notify()
+{
+    // Only wake up the background thread if it is (about to go) sleeping,
+    // so that logging costs no system call while the background thread is busy anyway.
+    if (sleeping_.load() && sleeping_.exchange(false))
+    {
+        auto const _ = lock_guard { mutex_ };
+        wakeup_.notify_one();
+    }
+}
+
+void AsyncSink::flush()
+{
+    auto lock = unique_lock { mutex_ };
+    // Waits for two full drain passes, as one might have been in progress already.
+    auto const target = drainCount_ + 2;
+    while (drainCount_ < target && !terminating_)
+    {
+        sleeping_ = false;
+        wakeup_.notify_one();
+        drained_.wait(lock);
+    }
+}
+
+bool AsyncSink::drain()
+{
+    auto rings = std::vector<Ring*> {};
+    {
+        auto const _ = lock_guard { ringsMutex_ };
+        rings.reserve(rings_.size());
+        for (auto const& ring: rings_)
+            rings.push_back(ring.get());
+    }
+
+    auto any = false;
+    auto drainedRings = std::vector<Ring*> {};
+    for (Ring* ring: rings)
+    {
+        // Nothing is pushed into a retired ring anymore, so it is empty for good once drained below.
+        if (ring->retired.load(memory_order_acquire))
+            drainedRings.push_back(ring);
+
+        any |= ring->consume([&](RecordHeader const& _header, std::string_view _text) {
+            using clock = MessageBuilder::clock;
+            auto const location = source_location(_header.fileName, _header.line, _header.functionName);
+            auto const time = clock::time_point(clock::duration(_header.time));
+            auto message = MessageBuilder(*_header.category, location, time);
+            message.append(_text);
+            auto const text = message.message();
+            message.discard();
+            if (writer_)
+                writer_(text);
+        });
+    }
+
+    if (!drainedRings.empty())
+    {
+        auto const _ = lock_guard { ringsMutex_ };
+        rings_.erase(std::remove_if(rings_.begin(),
+                                    rings_.end(),
+                                    [&](auto const& ring) {
+                                        return std::find(drainedRings.begin(), drainedRings.end(), ring.get())
+                                               != drainedRings.end();
+                                    }),
+                     rings_.end());
+    }
+    return any;
+}
+
+void AsyncSink::main()
+{
+    for (;;)
+    {
+        auto const any = drain();
+
+        auto lock = unique_lock { mutex_ };
+        ++drainCount_;
+        drained_.notify_all();
+
+        if (any)
+            continue;
+
+        if (terminating_)
+            break;
+
+        // Announce going to sleep before checking for records once more,
+        // so that a concurrently logging thread either sees the announcement and wakes us up,
+        // or its record is seen here.
+        sleeping_ = true;
+        lock.unlock();
+        if (drain())
+        {
+            sleeping_ = false;
+            continue;
+        }
+        lock.lock();
+        wakeup_.wait(lock, [&]() { return !sleeping_ || terminating_; });
+        sleeping_ = false;
+    }
+}
+
+} // namespace logstore
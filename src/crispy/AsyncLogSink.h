@@ -0,0 +1,90 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/logstore.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logstore
+{
+
+/// Logging sink that takes the cost of formatting and writing log messages off the
+/// logging threads.
+///
+/// Each logging thread appends binary records (category, source location, timestamp and
+/// message text) to its own lock-free single-producer/single-consumer ring buffer.
+/// A background thread drains all ring buffers, applies the category's formatter, and
+/// passes the result on to the writer.
+///
+/// Logging never blocks: if a thread's ring buffer is full, the record is dropped and counted.
+/// A thread's ring buffer is freed once the thread has exited and its records have been written.
+class AsyncSink: public Sink
+{
+  public:
+    static constexpr size_t DefaultRingSize = 256 * 1024;
+
+    /// @param _ringSize size in bytes of each logging thread's ring buffer, rounded up to a power of two.
+    AsyncSink(bool _enabled, Writer _writer, size_t _ringSize = DefaultRingSize);
+    AsyncSink(bool _enabled, std::ostream& _output, size_t _ringSize = DefaultRingSize);
+
+    /// Writes all pending records and stops the background thread.
+    ~AsyncSink() override;
+
+    AsyncSink(AsyncSink const&) = delete;
+    AsyncSink& operator=(AsyncSink const&) = delete;
+
+    void write(MessageBuilder const& _message) override;
+
+    /// Blocks until all records logged so far have been passed to the writer.
+    void flush();
+
+    /// Number of records dropped so far due to full ring buffers.
+    [[nodiscard]] uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+    /// Number of ring buffers currently allocated, one per logging thread still running or not drained yet.
+    [[nodiscard]] size_t ringCount();
+
+  private:
+    struct Ring;
+
+    Ring& localRing();
+    bool drain();
+    void notify();
+    void main();
+
+    uint64_t const id_;
+    size_t const ringSize_;
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<Ring>> rings_; // shared with the logging threads' thread_local owners
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::condition_variable drained_;
+    std::atomic<bool> sleeping_ = false;
+    bool terminating_ = false;
+    uint64_t drainCount_ = 0;
+    std::atomic<uint64_t> dropped_ = 0;
+
+    std::thread thread_;
+};
+
+} // namespace logstore
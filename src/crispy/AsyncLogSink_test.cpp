@@ -0,0 +1,140 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/AsyncLogSink.h>
+
+#include <catch2/catch.hpp>
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+struct Collector
+{
+    mutex lock;
+    vector<string> lines;
+
+    logstore::Sink::Writer writer()
+    {
+        return [this](string_view text) {
+            auto const _ = lock_guard { lock };
+            lines.emplace_back(text);
+        };
+    }
+};
+} // namespace
+
+TEST_CASE("AsyncSink.multiple_threads", "[logstore]")
+{
+    auto category = logstore::Category("test.async", "", logstore::Category::State::Enabled);
+    auto collector = Collector {};
+    auto sink = logstore::AsyncSink(true, collector.writer());
+    category.set_sink(sink);
+
+    auto constexpr ThreadCount = 4;
+    auto constexpr MessageCount = 1000;
+    auto threads = vector<thread> {};
+    for (int t = 0; t < ThreadCount; ++t)
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < MessageCount; ++i)
+                category()("{} {}", t, i);
+        });
+    for (auto& thread: threads)
+        thread.join();
+
+    sink.flush();
+
+    REQUIRE(sink.dropped() == 0);
+    REQUIRE(collector.lines.size() == ThreadCount * MessageCount);
+
+    // Messages of each thread arrive in order.
+    auto next = vector<int>(ThreadCount, 0);
+    for (auto const& line: collector.lines)
+    {
+        auto const t = stoi(line.substr(0, line.find(' ')));
+        auto const i = stoi(line.substr(line.find(' ') + 1));
+        REQUIRE(i == next[t]);
+        ++next[t];
+    }
+}
+
+TEST_CASE("AsyncSink.exited_threads", "[logstore]")
+{
+    auto category = logstore::Category("test.async.exited", "", logstore::Category::State::Enabled);
+    auto collector = Collector {};
+    auto sink = logstore::AsyncSink(true, collector.writer(), 4096);
+    category.set_sink(sink);
+
+    // The rings of exited threads are freed once drained, rather than piling up.
+    for (int i = 0; i < 100; ++i)
+        thread([&]() { category()("{}", i); }).join();
+    sink.flush();
+
+    CHECK(collector.lines.size() == 100);
+    CHECK(sink.ringCount() == 0);
+}
+
+TEST_CASE("AsyncSink.formatter", "[logstore]")
+{
+    auto category = logstore::Category("test.async.formatter", "", logstore::Category::State::Enabled);
+    auto collector = Collector {};
+    auto sink = logstore::AsyncSink(true, collector.writer());
+    category.set_sink(sink);
+    category.set_formatter([](logstore::MessageBuilder const& _message) {
+        return fmt::format("[{}] {}", _message.category().name(), _message.text());
+    });
+
+    category()("hello");
+    sink.flush();
+
+    REQUIRE(collector.lines.size() == 1);
+    CHECK(collector.lines[0] == "[test.async.formatter] hello");
+}
+
+TEST_CASE("AsyncSink.drop_oversized", "[logstore]")
+{
+    auto category = logstore::Category("test.async.drop", "", logstore::Category::State::Enabled);
+    auto collector = Collector {};
+    auto sink = logstore::AsyncSink(true, collector.writer(), 4096);
+    category.set_sink(sink);
+
+    category()(string(8192, 'x'));
+    category()("small");
+    sink.flush();
+
+    CHECK(sink.dropped() == 1);
+    REQUIRE(collector.lines.size() == 1);
+    CHECK(collector.lines[0] == "small\n");
+}
+
+TEST_CASE("AsyncSink.disabled_category", "[logstore]")
+{
+    auto category = logstore::Category("test.async.disabled", "");
+    auto collector = Collector {};
+    auto sink = logstore::AsyncSink(true, collector.writer());
+    category.set_sink(sink);
+
+    {
+        auto message = category();
+        message("not {}", "formatted");
+        CHECK(message.text().empty());
+    }
+    sink.flush();
+
+    CHECK(collector.lines.empty());
+}
@@ -17,6 +17,12 @@
 #include <fmt/format.h>
 
 #include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+#endif
 
 using std::destroy_n;
 using std::move;
@@ -31,6 +37,36 @@ auto const inline BufferObjectLog = logstore::Category("BufferObject",
                                                        logstore::Category::State::Disabled,
                                                        logstore::Category::Visibility::Hidden);
 
+namespace
+{
+    void* allocateStorage(size_t size, [[maybe_unused]] bool hugePages)
+    {
+#if defined(__linux__)
+        // size is a power of two, hence a multiple of the huge page size if not smaller.
+        if (hugePages && size >= HugePageSize)
+        {
+            if (void* storage = aligned_alloc(HugePageSize, size))
+            {
+                if (madvise(storage, size, MADV_HUGEPAGE) != 0 && BufferObjectLog)
+                    BufferObjectLog()("Huge pages unavailable for BufferObject: {}", strerror(errno));
+                return storage;
+            }
+        }
+#endif
+        return malloc(size);
+    }
+
+    void destroyBufferObject(BufferObject* ptr)
+    {
+#if defined(BUFFER_OBJECT_INLINE)
+        destroy_n(ptr, 1);
+        free(ptr);
+#else
+        delete ptr;
+#endif
+    }
+} // namespace
+
 BufferFragment::BufferFragment(BufferObjectPtr buffer, size_t offset, size_t size) noexcept:
     buffer_ { move(buffer) }, region_ { buffer_->data() + offset, size }
 {
@@ -66,12 +102,17 @@ BufferObject::~BufferObject()
 #endif
 }
 
-BufferObjectPtr BufferObject::create(size_t capacity, BufferObjectRelease release)
+BufferObjectPtr BufferObject::create(size_t capacity,
+                                     BufferObjectRelease release,
+                                     [[maybe_unused]] bool hugePages)
 {
+    if (!release)
+        release = destroyBufferObject;
+
 #if defined(BUFFER_OBJECT_INLINE)
     auto const totalCapacity = nextPowerOfTwo(static_cast<uint32_t>(sizeof(BufferObject) + capacity));
     auto const nettoCapacity = totalCapacity - sizeof(BufferObject);
-    auto ptr = (BufferObject*) malloc(totalCapacity);
+    auto ptr = (BufferObject*) allocateStorage(totalCapacity, hugePages);
     new (ptr) BufferObject(nettoCapacity);
     return BufferObjectPtr(ptr, move(release));
 #else
@@ -86,7 +127,8 @@ string_view BufferObject::writeAtEnd(string_view data) noexcept
     return string_view { hotEnd_, data.size() };
 }
 
-BufferObjectPool::BufferObjectPool(size_t bufferSize): bufferSize_ { bufferSize }
+BufferObjectPool::BufferObjectPool(size_t bufferSize, bool hugePages):
+    bufferSize_ { bufferSize }, hugePages_ { hugePages }
 {
     BufferObjectLog()("Creating BufferObject pool with chunk size {}",
                       crispy::humanReadableBytes(bufferSize));
@@ -95,6 +137,7 @@ BufferObjectPool::BufferObjectPool(size_t bufferSize): bufferSize_ { bufferSize
 BufferObjectPool::~BufferObjectPool()
 {
     reuseBuffers_ = false;
+    releaseUnusedBuffers();
 }
 
 size_t BufferObjectPool::unusedBuffers() const noexcept
@@ -104,21 +147,28 @@ size_t BufferObjectPool::unusedBuffers() const noexcept
 
 void BufferObjectPool::releaseUnusedBuffers()
 {
-    reuseBuffers_ = false;
+    for (BufferObject* buffer: unusedBuffers_)
+        destroyBufferObject(buffer);
     unusedBuffers_.clear();
-    reuseBuffers_ = true;
 }
 
 BufferObjectPtr BufferObjectPool::allocateBufferObject()
 {
+    stats_.live++;
+    stats_.peak = std::max(stats_.peak, stats_.live);
+
     if (unusedBuffers_.empty())
-        return BufferObject::create(bufferSize_, [this](auto p) { release(p); });
+    {
+        stats_.allocated++;
+        return BufferObject::create(bufferSize_, [this](auto p) { release(p); }, hugePages_);
+    }
 
-    BufferObjectPtr buffer = move(unusedBuffers_.front());
+    stats_.recycled++;
+    BufferObject* buffer = unusedBuffers_.front();
     if (BufferObjectLog)
-        BufferObjectLog()("Recycling BufferObject from pool: @{}.", (void*) buffer.get());
+        BufferObjectLog()("Recycling BufferObject from pool: @{}.", (void*) buffer);
     unusedBuffers_.pop_front();
-    return buffer;
+    return BufferObjectPtr(buffer, [this](auto p) { release(p); });
 }
 
 void BufferObject::reset() noexcept
@@ -128,22 +178,17 @@ void BufferObject::reset() noexcept
 
 void BufferObjectPool::release(BufferObject* ptr)
 {
+    // Only buffer objects in use are released, unused ones are destroyed by the pool directly.
+    stats_.live--;
     if (reuseBuffers_)
     {
         if (BufferObjectLog)
             BufferObjectLog()("Releasing BufferObject from pool: @{}", (void*) ptr);
         ptr->reset();
-        unusedBuffers_.emplace_back(ptr, [this](auto p) { release(p); });
+        unusedBuffers_.emplace_back(ptr);
     }
     else
-    {
-#if defined(BUFFER_OBJECT_INLINE)
-        destroy_n(ptr, 1);
-        free(ptr);
-#else
-        delete ptr;
-#endif
-    }
+        destroyBufferObject(ptr);
 }
 
 } // namespace crispy
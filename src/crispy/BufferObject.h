@@ -36,6 +36,9 @@ class BufferFragment;
 using BufferObjectRelease = std::function<void(BufferObject*)>;
 using BufferObjectPtr = std::shared_ptr<BufferObject>;
 
+/// Size of a transparent huge page, the granularity of huge page backed buffer objects.
+constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
 /**
  * BufferObject is the buffer object a Pty's read-call will use to store
  * the read data.
@@ -57,7 +60,11 @@ class BufferObject: public std::enable_shared_from_this<BufferObject>
     explicit BufferObject(size_t capacity) noexcept;
     ~BufferObject();
 
-    static BufferObjectPtr create(size_t capacity, BufferObjectRelease release = {});
+    /// Creates a new BufferObject of at least the given capacity.
+    ///
+    /// @param hugePages if true and @p capacity spans at least a huge page, the storage is aligned
+    ///                  to huge pages and the kernel is advised to back it with huge pages (Linux only).
+    static BufferObjectPtr create(size_t capacity, BufferObjectRelease release = {}, bool hugePages = false);
 
     void reset() noexcept;
 
@@ -110,6 +117,14 @@ class BufferObject: public std::enable_shared_from_this<BufferObject>
     friend class BufferFragment;
 };
 
+struct BufferObjectPoolStats
+{
+    size_t live = 0;      // number of buffer objects currently in use
+    size_t peak = 0;      // maximum number of buffer objects in use at the same time
+    size_t allocated = 0; // number of buffer objects allocated from the system
+    size_t recycled = 0;  // number of allocations served from unused buffer objects
+};
+
 /**
  * BufferObjectPool manages reusable BufferObject objects.
  *
@@ -120,19 +135,24 @@ class BufferObject: public std::enable_shared_from_this<BufferObject>
 class BufferObjectPool
 {
   public:
-    explicit BufferObjectPool(size_t bufferSize = 4096);
+    explicit BufferObjectPool(size_t bufferSize = 4096, bool hugePages = false);
     ~BufferObjectPool();
 
     void releaseUnusedBuffers();
     [[nodiscard]] size_t unusedBuffers() const noexcept;
     [[nodiscard]] BufferObjectPtr allocateBufferObject();
 
+    [[nodiscard]] BufferObjectPoolStats const& stats() const noexcept { return stats_; }
+    [[nodiscard]] size_t bufferSize() const noexcept { return bufferSize_; }
+
   private:
     void release(BufferObject* ptr);
 
     bool reuseBuffers_ = true;
     size_t bufferSize_;
-    std::list<BufferObjectPtr> unusedBuffers_;
+    bool hugePages_;
+    std::list<BufferObject*> unusedBuffers_; // owned by the pool until handed out again
+    BufferObjectPoolStats stats_;
 };
 
 /**
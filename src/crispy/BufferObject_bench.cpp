@@ -0,0 +1,63 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/BufferObject.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using crispy::BufferObjectPool;
+using crispy::BufferObjectPtr;
+
+// Allocates a buffer object and releases it right away, i.e. recycling it through the pool.
+static void BM_BufferObjectPool_allocate(benchmark::State& state)
+{
+    auto pool = BufferObjectPool(static_cast<size_t>(state.range(0)));
+    for (auto _: state)
+        benchmark::DoNotOptimize(pool.allocateBufferObject());
+}
+BENCHMARK(BM_BufferObjectPool_allocate)->Arg(4096)->Arg(1024 * 1024);
+
+// Allocates a batch of buffer objects before releasing them again, as when output is being
+// retained by the grid's lines.
+static void BM_BufferObjectPool_allocate_batch(benchmark::State& state)
+{
+    auto constexpr BatchSize = 64;
+    auto pool = BufferObjectPool(static_cast<size_t>(state.range(0)));
+    auto buffers = std::vector<BufferObjectPtr> {};
+    buffers.reserve(BatchSize);
+    for (auto _: state)
+    {
+        for (int i = 0; i < BatchSize; ++i)
+            buffers.emplace_back(pool.allocateBufferObject());
+        buffers.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * BatchSize);
+}
+BENCHMARK(BM_BufferObjectPool_allocate_batch)->Arg(4096)->Arg(1024 * 1024);
+
+static void BM_BufferObject_writeAtEnd(benchmark::State& state)
+{
+    auto const chunk = std::string(static_cast<size_t>(state.range(0)), 'x');
+    auto pool = BufferObjectPool(1024 * 1024);
+    auto buffer = pool.allocateBufferObject();
+    for (auto _: state)
+    {
+        if (buffer->bytesAvailable() < chunk.size())
+            buffer = pool.allocateBufferObject();
+        benchmark::DoNotOptimize(buffer->writeAtEnd(chunk));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferObject_writeAtEnd)->Arg(16)->Arg(4096);
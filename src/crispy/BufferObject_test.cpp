@@ -20,3 +20,55 @@ TEST_CASE("BufferObject", "[BufferObject]")
 {
     // TODO
 }
+
+TEST_CASE("BufferObjectPool.recycling", "[BufferObject]")
+{
+    auto pool = crispy::BufferObjectPool(1024);
+
+    auto a = pool.allocateBufferObject();
+    auto b = pool.allocateBufferObject();
+    CHECK(pool.stats().live == 2);
+    CHECK(pool.stats().peak == 2);
+    CHECK(pool.stats().allocated == 2);
+    CHECK(pool.stats().recycled == 0);
+
+    // A buffer object still referenced by a fragment is not returned to the pool.
+    a->advance(a->writeAtEnd("Hello").size());
+    auto fragment = a->ref(0, 5);
+    a.reset();
+    CHECK(pool.unusedBuffers() == 0);
+    CHECK(pool.stats().live == 2);
+
+    fragment = {};
+    CHECK(pool.unusedBuffers() == 1);
+    CHECK(pool.stats().live == 1);
+
+    auto c = pool.allocateBufferObject();
+    CHECK(c->bytesUsed() == 0);
+    CHECK(pool.unusedBuffers() == 0);
+    CHECK(pool.stats().live == 2);
+    CHECK(pool.stats().peak == 2);
+    CHECK(pool.stats().allocated == 2);
+    CHECK(pool.stats().recycled == 1);
+
+    b.reset();
+    c.reset();
+    CHECK(pool.stats().live == 0);
+    CHECK(pool.unusedBuffers() == 2);
+
+    auto d = pool.allocateBufferObject();
+    pool.releaseUnusedBuffers();
+    CHECK(pool.unusedBuffers() == 0);
+    CHECK(pool.stats().live == 1);
+    d.reset();
+    CHECK(pool.stats().live == 0);
+    CHECK(pool.unusedBuffers() == 1);
+}
+
+TEST_CASE("BufferObject.hugePages", "[BufferObject]")
+{
+    auto buffer = crispy::BufferObject::create(crispy::HugePageSize, {}, true);
+    REQUIRE(buffer->capacity() >= crispy::HugePageSize - sizeof(crispy::BufferObject));
+    auto const text = buffer->writeAtEnd("text");
+    CHECK(text == "text");
+}
@@ -0,0 +1,82 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/CacheRegistry.h>
+#include <crispy/utils.h>
+
+#include <fmt/format.h>
+
+using std::lock_guard;
+using std::vector;
+
+namespace crispy
+{
+
+CacheRegistry& CacheRegistry::get()
+{
+    static CacheRegistry registry;
+    return registry;
+}
+
+CacheRegistry::Id CacheRegistry::add(Reporter _reporter)
+{
+    auto const _ = lock_guard { mutex_ };
+    auto const id = nextId_++;
+    reporters_.emplace(id, std::move(_reporter));
+    return id;
+}
+
+void CacheRegistry::remove(Id _id)
+{
+    auto const _ = lock_guard { mutex_ };
+    reporters_.erase(_id);
+}
+
+vector<CacheReport> CacheRegistry::reports() const
+{
+    auto const _ = lock_guard { mutex_ };
+    auto result = vector<CacheReport> {};
+    result.reserve(reporters_.size());
+    for (auto const& [id, reporter]: reporters_)
+        result.emplace_back(reporter());
+    return result;
+}
+
+void CacheRegistry::inspect(std::ostream& _output) const
+{
+    _output << "Cache statistics:\n";
+    _output << fmt::format("{:<40} {:>15} {:>9} {:>12} {:>12} {:>12} {:>10}\n",
+                           "name",
+                           "entries",
+                           "hit rate",
+                           "hits",
+                           "misses",
+                           "evictions",
+                           "memory");
+    for (auto const& report: reports())
+    {
+        auto const lookups = report.hits + report.misses;
+        auto const hitRate =
+            lookups ? 100.0 * static_cast<double>(report.hits) / static_cast<double>(lookups) : 0.0;
+        _output << fmt::format("{:<40} {:>15} {:>8.2f}% {:>12} {:>12} {:>12} {:>10}\n",
+                               report.name,
+                               fmt::format("{}/{}", report.size, report.capacity),
+                               hitRate,
+                               report.hits,
+                               report.misses,
+                               report.evictions,
+                               humanReadableBytes(report.storageSize));
+    }
+}
+
+} // namespace crispy
@@ -0,0 +1,76 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace crispy
+{
+
+/// Statistics of a single cache, as reported to the CacheRegistry.
+struct CacheReport
+{
+    std::string name;
+    size_t size = 0;        // number of entries currently held
+    size_t capacity = 0;    // maximum number of entries
+    size_t storageSize = 0; // bytes of memory used by the cache itself
+    uint64_t hits = 0;      // lookups that found an entry, since creation
+    uint64_t misses = 0;    // lookups that did not find an entry, since creation
+    uint64_t evictions = 0; // entries evicted to make room for new ones, since creation
+};
+
+/**
+ * Process wide registry of named caches, for dumping their statistics in one place,
+ * e.g. in order to tune cache sizes from data.
+ *
+ * Caches register themselves for as long as they are alive.
+ *
+ * @see StrongLRUHashtable
+ */
+class CacheRegistry
+{
+  public:
+    using Id = uint64_t;
+    using Reporter = std::function<CacheReport()>;
+
+    static CacheRegistry& get();
+
+    /// Registers a cache, whose statistics are retrieved by invoking @p _reporter.
+    ///
+    /// @returns an identifier for unregistering the cache again.
+    Id add(Reporter _reporter);
+
+    /// Unregisters the cache of the given identifier.
+    void remove(Id _id);
+
+    /// @returns the statistics of all registered caches, in order of registration.
+    [[nodiscard]] std::vector<CacheReport> reports() const;
+
+    /// Writes a human readable table of all registered caches' statistics.
+    void inspect(std::ostream& _output) const;
+
+  private:
+    mutable std::mutex mutex_;
+    std::map<Id, Reporter> reporters_;
+    Id nextId_ = 1;
+};
+
+} // namespace crispy
@@ -0,0 +1,331 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/CacheRegistry.h>
+#include <crispy/StrongHash.h>
+#include <crispy/StrongLRUHashtable.h>
+#include <crispy/assert.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace crispy
+{
+
+// Number of independently locked shards of a ConcurrentStrongLRUHashtable.
+struct ShardCount
+{
+    uint32_t value;
+};
+
+/// Thread-safe LRU hashtable, sharded into independently locked StrongLRUHashtable instances.
+///
+/// A hash key always maps to the same shard, so that threads only contend
+/// when looking up keys of the same shard. Each shard evicts in LRU order on its own.
+///
+/// As opposed to StrongLRUHashtable, values are returned by copy, because a reference
+/// into a shard could be invalidated by another thread evicting the entry at any time.
+/// Values should therefore be cheap to copy, e.g. std::shared_ptr<T const>.
+///
+/// Value construction (see get_or_emplace()) happens while holding the shard's lock,
+/// so concurrent lookups of the same missing key construct its value only once.
+template <typename Value>
+class ConcurrentStrongLRUHashtable
+{
+  public:
+    using Ptr = std::unique_ptr<ConcurrentStrongLRUHashtable>;
+
+    static constexpr ShardCount DefaultShardCount { 16 };
+
+    /// @param hashCount  total number of hash slots, distributed evenly across all shards.
+    /// @param entryCount total number of entries, distributed evenly across all shards.
+    ConcurrentStrongLRUHashtable(StrongHashtableSize hashCount,
+                                 LRUCapacity entryCount,
+                                 std::string name,
+                                 ShardCount shardCount);
+    ~ConcurrentStrongLRUHashtable();
+
+    ConcurrentStrongLRUHashtable(ConcurrentStrongLRUHashtable const&) = delete;
+    ConcurrentStrongLRUHashtable(ConcurrentStrongLRUHashtable&&) = delete;
+    ConcurrentStrongLRUHashtable& operator=(ConcurrentStrongLRUHashtable const&) = delete;
+    ConcurrentStrongLRUHashtable& operator=(ConcurrentStrongLRUHashtable&&) = delete;
+
+    static Ptr create(StrongHashtableSize hashCount,
+                      LRUCapacity entryCount,
+                      std::string name = "",
+                      ShardCount shardCount = DefaultShardCount);
+
+    [[nodiscard]] size_t shardCount() const noexcept { return _shardCount; }
+
+    /// Returns the actual number of entries currently hold in this hashtable.
+    [[nodiscard]] size_t size() const;
+
+    /// Returns the maximum number of entries that can be stored in this hashtable.
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    /// Returns the total storage sized used by this object.
+    [[nodiscard]] size_t storageSize() const;
+
+    /// Returns gathered stats of all shards and clears them to start counting from zero again.
+    LRUHashtableStats fetchAndClearStats();
+
+    /// Returns the stats accumulated since construction, summed up over all shards.
+    [[nodiscard]] CacheReport report() const;
+
+    /// Clears all entries from the hashtable.
+    void clear();
+
+    // Deletes the hash entry and its associated value from the hashtable.
+    void remove(StrongHash const& hash);
+
+    /// Tests for the exitence of the given hash key in this hash table.
+    [[nodiscard]] bool contains(StrongHash const& hash) const;
+
+    /// Returns a copy of the value for the given hash key if found, std::nullopt otherwise.
+    [[nodiscard]] std::optional<Value> try_get(StrongHash const& hash);
+
+    /// Assignes the given value to the given hash key.
+    /// If the hash key was not found, it is being created,
+    /// otherwise the value will be re-assigned with the new value.
+    void emplace(StrongHash const& hash, Value value);
+
+    /// Always returns either a copy of the existing item by the given hash key, if found,
+    /// or of a newly created one by invoking constructValue(entryIndex).
+    ///
+    /// The entry index is only unique within the hash key's shard.
+    template <typename ValueConstructFn>
+    [[nodiscard]] Value get_or_emplace(StrongHash const& hash, ValueConstructFn constructValue);
+
+    /// Like get_or_emplace but allows failure in @p constructValue (by returning std::nullopt)
+    /// to cause the hash entry not to be created, in which case std::nullopt is returned.
+    template <typename ValueConstructFn>
+    [[nodiscard]] std::optional<Value> get_or_try_emplace(StrongHash const& hash,
+                                                          ValueConstructFn constructValue);
+
+    void inspect(std::ostream& output) const;
+
+  private:
+    using Hashtable = StrongLRUHashtable<Value>;
+
+    // Each shard on its own cache line(s), so that locking one does not slow down its neighbours.
+    struct alignas(64) Shard
+    {
+        mutable std::mutex lock;
+        typename Hashtable::Ptr table;
+    };
+
+    // Uses other bits of the hash than StrongLRUHashtable's hash slot selection,
+    // so that the keys of one shard still spread across all of its hash slots.
+    [[nodiscard]] Shard& shardOf(StrongHash const& hash) const noexcept
+    {
+        auto const bits = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(hash.value, 8)));
+        return _shards[bits % _shardCount];
+    }
+
+    uint32_t _shardCount;
+    std::unique_ptr<Shard[]> _shards;
+    std::string _name;
+    CacheRegistry::Id _registryId = 0;
+};
+
+// {{{ implementation
+template <typename Value>
+ConcurrentStrongLRUHashtable<Value>::ConcurrentStrongLRUHashtable(StrongHashtableSize hashCount,
+                                                                  LRUCapacity entryCount,
+                                                                  std::string name,
+                                                                  ShardCount shardCount):
+    _shardCount { shardCount.value },
+    _shards { std::make_unique<Shard[]>(shardCount.value) },
+    _name { std::move(name) }
+{
+    Require(shardCount.value >= 1);
+
+    auto const hashesPerShard = std::max(hashCount.value / shardCount.value, 1u);
+    auto const entriesPerShard = std::max((entryCount.value + shardCount.value - 1) / shardCount.value, 2u);
+    for (uint32_t i = 0; i < _shardCount; ++i)
+        _shards[i].table =
+            Hashtable::create(StrongHashtableSize { hashesPerShard }, LRUCapacity { entriesPerShard });
+
+    // The object never moves (see create()), so it is safe to capture this here.
+    if (!_name.empty())
+        _registryId = CacheRegistry::get().add([this]() { return report(); });
+}
+
+template <typename Value>
+ConcurrentStrongLRUHashtable<Value>::~ConcurrentStrongLRUHashtable()
+{
+    if (_registryId)
+        CacheRegistry::get().remove(_registryId);
+}
+
+template <typename Value>
+auto ConcurrentStrongLRUHashtable<Value>::create(StrongHashtableSize hashCount,
+                                                 LRUCapacity entryCount,
+                                                 std::string name,
+                                                 ShardCount shardCount) -> Ptr
+{
+    return std::make_unique<ConcurrentStrongLRUHashtable>(hashCount, entryCount, std::move(name), shardCount);
+}
+
+template <typename Value>
+size_t ConcurrentStrongLRUHashtable<Value>::size() const
+{
+    auto result = size_t { 0 };
+    for (uint32_t i = 0; i < _shardCount; ++i)
+    {
+        auto const _ = std::lock_guard { _shards[i].lock };
+        result += _shards[i].table->size();
+    }
+    return result;
+}
+
+template <typename Value>
+size_t ConcurrentStrongLRUHashtable<Value>::capacity() const noexcept
+{
+    // Shard capacities are immutable, so no locking needed.
+    return _shardCount * _shards[0].table->capacity();
+}
+
+template <typename Value>
+size_t ConcurrentStrongLRUHashtable<Value>::storageSize() const
+{
+    auto result = sizeof(ConcurrentStrongLRUHashtable) + _shardCount * sizeof(Shard);
+    for (uint32_t i = 0; i < _shardCount; ++i)
+        result += _shards[i].table->storageSize();
+    return result;
+}
+
+template <typename Value>
+LRUHashtableStats ConcurrentStrongLRUHashtable<Value>::fetchAndClearStats()
+{
+    auto result = LRUHashtableStats {};
+    for (uint32_t i = 0; i < _shardCount; ++i)
+    {
+        auto const _ = std::lock_guard { _shards[i].lock };
+        auto const stats = _shards[i].table->fetchAndClearStats();
+        result.hits += stats.hits;
+        result.misses += stats.misses;
+        result.recycles += stats.recycles;
+    }
+    return result;
+}
+
+template <typename Value>
+CacheReport ConcurrentStrongLRUHashtable<Value>::report() const
+{
+    auto result = CacheReport {};
+    result.name = _name;
+    result.storageSize = sizeof(ConcurrentStrongLRUHashtable) + _shardCount * sizeof(Shard);
+    for (uint32_t i = 0; i < _shardCount; ++i)
+    {
+        auto const _ = std::lock_guard { _shards[i].lock };
+        auto const shardReport = _shards[i].table->report();
+        result.size += shardReport.size;
+        result.capacity += shardReport.capacity;
+        result.storageSize += shardReport.storageSize;
+        result.hits += shardReport.hits;
+        result.misses += shardReport.misses;
+        result.evictions += shardReport.evictions;
+    }
+    return result;
+}
+
+template <typename Value>
+void ConcurrentStrongLRUHashtable<Value>::clear()
+{
+    for (uint32_t i = 0; i < _shardCount; ++i)
+    {
+        auto const _ = std::lock_guard { _shards[i].lock };
+        _shards[i].table->clear();
+    }
+}
+
+template <typename Value>
+void ConcurrentStrongLRUHashtable<Value>::remove(StrongHash const& hash)
+{
+    Shard& shard = shardOf(hash);
+    auto const _ = std::lock_guard { shard.lock };
+    shard.table->remove(hash);
+}
+
+template <typename Value>
+bool ConcurrentStrongLRUHashtable<Value>::contains(StrongHash const& hash) const
+{
+    Shard& shard = shardOf(hash);
+    auto const _ = std::lock_guard { shard.lock };
+    return shard.table->contains(hash);
+}
+
+template <typename Value>
+std::optional<Value> ConcurrentStrongLRUHashtable<Value>::try_get(StrongHash const& hash)
+{
+    Shard& shard = shardOf(hash);
+    auto const _ = std::lock_guard { shard.lock };
+    if (Value const* value = shard.table->try_get(hash))
+        return *value;
+    return std::nullopt;
+}
+
+template <typename Value>
+void ConcurrentStrongLRUHashtable<Value>::emplace(StrongHash const& hash, Value value)
+{
+    Shard& shard = shardOf(hash);
+    auto const _ = std::lock_guard { shard.lock };
+    shard.table->emplace(hash, std::move(value));
+}
+
+template <typename Value>
+template <typename ValueConstructFn>
+Value ConcurrentStrongLRUHashtable<Value>::get_or_emplace(StrongHash const& hash,
+                                                          ValueConstructFn constructValue)
+{
+    Shard& shard = shardOf(hash);
+    auto const _ = std::lock_guard { shard.lock };
+    return shard.table->get_or_emplace(hash, std::move(constructValue));
+}
+
+template <typename Value>
+template <typename ValueConstructFn>
+std::optional<Value> ConcurrentStrongLRUHashtable<Value>::get_or_try_emplace(StrongHash const& hash,
+                                                                             ValueConstructFn constructValue)
+{
+    Shard& shard = shardOf(hash);
+    auto const _ = std::lock_guard { shard.lock };
+    if (Value const* value = shard.table->get_or_try_emplace(hash, std::move(constructValue)))
+        return *value;
+    return std::nullopt;
+}
+
+template <typename Value>
+void ConcurrentStrongLRUHashtable<Value>::inspect(std::ostream& output) const
+{
+    auto const r = report();
+    output << fmt::format("=============================================================\n");
+    output << fmt::format("Concurrent hashtable: {}\n", _name);
+    output << fmt::format("-------------------------------------------------------------\n");
+    output << fmt::format("shards              : {}\n", _shardCount);
+    output << fmt::format("entry count         : {}\n", r.size);
+    output << fmt::format("entry capacity      : {}\n", r.capacity);
+    output << fmt::format("hits / misses       : {} / {}\n", r.hits, r.misses);
+    output << fmt::format("evictions           : {}\n", r.evictions);
+    output << fmt::format("-------------------------------------------------------------\n");
+}
+// }}}
+
+} // namespace crispy
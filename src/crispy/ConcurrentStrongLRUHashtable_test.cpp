@@ -0,0 +1,106 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/ConcurrentStrongLRUHashtable.h>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace crispy;
+using namespace std;
+
+TEST_CASE("ConcurrentStrongLRUHashtable.basics")
+{
+    auto cache = ConcurrentStrongLRUHashtable<int>::create(
+        StrongHashtableSize { 256 }, LRUCapacity { 64 }, "", ShardCount { 4 });
+    CHECK(cache->shardCount() == 4);
+    CHECK(cache->capacity() == 64);
+
+    auto const a = StrongHash::compute("a");
+    auto const b = StrongHash::compute("b");
+
+    CHECK(cache->get_or_emplace(a, [](auto) { return 1; }) == 1);
+    CHECK(cache->get_or_emplace(a, [](auto) { return 2; }) == 1);
+    CHECK(cache->get_or_try_emplace(b, [](auto) { return optional<int> {}; }) == nullopt);
+    CHECK(!cache->contains(b));
+    CHECK(cache->get_or_try_emplace(b, [](auto) { return optional<int> { 3 }; }) == 3);
+    CHECK(cache->try_get(b) == 3);
+    CHECK(cache->size() == 2);
+
+    cache->emplace(b, 4);
+    CHECK(cache->try_get(b) == 4);
+
+    cache->remove(a);
+    CHECK(cache->try_get(a) == nullopt);
+    CHECK(cache->size() == 1);
+
+    cache->clear();
+    CHECK(cache->size() == 0);
+}
+
+TEST_CASE("ConcurrentStrongLRUHashtable.eviction")
+{
+    // One shard behaves exactly like a single StrongLRUHashtable.
+    auto cache = ConcurrentStrongLRUHashtable<int>::create(
+        StrongHashtableSize { 8 }, LRUCapacity { 2 }, "", ShardCount { 1 });
+    cache->emplace(StrongHash::compute(1), 1);
+    cache->emplace(StrongHash::compute(2), 2);
+    (void) cache->try_get(StrongHash::compute(1));
+    cache->emplace(StrongHash::compute(3), 3);
+    CHECK(cache->contains(StrongHash::compute(1)));
+    CHECK(!cache->contains(StrongHash::compute(2)));
+    CHECK(cache->contains(StrongHash::compute(3)));
+    CHECK(cache->fetchAndClearStats().recycles == 1);
+}
+
+TEST_CASE("ConcurrentStrongLRUHashtable.threads")
+{
+    auto constexpr ThreadCount = 4;
+    auto constexpr KeyCount = 512;
+    auto constexpr Rounds = 20;
+
+    auto cache = ConcurrentStrongLRUHashtable<shared_ptr<int const>>::create(
+        StrongHashtableSize { 4096 }, LRUCapacity { 1024 });
+    auto constructions = atomic<int> { 0 };
+    auto mismatches = atomic<int> { 0 };
+
+    auto threads = vector<thread> {};
+    for (int t = 0; t < ThreadCount; ++t)
+        threads.emplace_back([&]() {
+            for (int round = 0; round < Rounds; ++round)
+                for (int key = 0; key < KeyCount; ++key)
+                {
+                    auto const value = cache->get_or_emplace(StrongHash::compute(key), [&](auto) {
+                        ++constructions;
+                        return make_shared<int const>(key);
+                    });
+                    if (*value != key)
+                        ++mismatches;
+                }
+        });
+    for (auto& thread: threads)
+        thread.join();
+
+    CHECK(mismatches == 0);
+    // Capacity suffices for all keys, so every key is constructed exactly once.
+    CHECK(constructions == KeyCount);
+    CHECK(cache->size() == KeyCount);
+
+    auto const stats = cache->fetchAndClearStats();
+    CHECK(stats.misses == KeyCount);
+    CHECK(stats.hits == ThreadCount * Rounds * KeyCount - KeyCount);
+}
@@ -0,0 +1,139 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/InstrumentedMutex.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::memory_order_relaxed;
+
+namespace crispy
+{
+
+namespace
+{
+    double milliseconds(nanoseconds _time) noexcept
+    {
+        return static_cast<double>(_time.count()) / 1e6;
+    }
+} // namespace
+
+void InstrumentedMutex::lock()
+{
+    if (mutex_.try_lock())
+    {
+        acquired(Clock::now());
+        return;
+    }
+
+    auto const waitStart = Clock::now();
+    mutex_.lock();
+    auto const now = Clock::now();
+    acquired(now);
+
+    auto const waited = duration_cast<nanoseconds>(now - waitStart).count();
+    contended_.fetch_add(1, memory_order_relaxed);
+    waitTime_.fetch_add(waited, memory_order_relaxed);
+    if (waited > maxWaitTime_.load(memory_order_relaxed))
+        maxWaitTime_.store(waited, memory_order_relaxed);
+}
+
+bool InstrumentedMutex::try_lock()
+{
+    if (!mutex_.try_lock())
+        return false;
+
+    acquired(Clock::now());
+    return true;
+}
+
+void InstrumentedMutex::acquired(Clock::time_point _now) noexcept
+{
+    lockedAt_ = _now;
+    acquisitions_.fetch_add(1, memory_order_relaxed);
+}
+
+void InstrumentedMutex::unlock()
+{
+    auto const held = duration_cast<nanoseconds>(Clock::now() - lockedAt_);
+    holdTime_.fetch_add(held.count(), memory_order_relaxed);
+
+    auto const thread = std::this_thread::get_id();
+    auto owner = std::find_if(owners_.begin(), owners_.end(), [&](LockOwnerStats const& _owner) {
+        return _owner.thread == thread || _owner.thread == std::thread::id {};
+    });
+    if (owner == owners_.end())
+        owner = std::prev(owners_.end());
+    else
+        owner->thread = thread;
+    owner->acquisitions++;
+    owner->holdTime += held;
+
+    mutex_.unlock();
+}
+
+LockStats InstrumentedMutex::stats() const noexcept
+{
+    return LockStats { acquisitions_.load(memory_order_relaxed),
+                       contended_.load(memory_order_relaxed),
+                       nanoseconds(waitTime_.load(memory_order_relaxed)),
+                       nanoseconds(maxWaitTime_.load(memory_order_relaxed)),
+                       nanoseconds(holdTime_.load(memory_order_relaxed)) };
+}
+
+std::vector<LockOwnerStats> InstrumentedMutex::ownerStats() const
+{
+    auto const _l = std::lock_guard { mutex_ };
+    auto result = std::vector<LockOwnerStats> {};
+    for (LockOwnerStats const& owner: owners_)
+        if (owner.acquisitions)
+            result.push_back(owner);
+    return result;
+}
+
+void InstrumentedMutex::inspect(std::string_view _name, std::ostream& _os) const
+{
+    auto const total = stats();
+    auto const contendedShare =
+        total.acquisitions ? 100.0 * double(total.contended) / double(total.acquisitions) : 0.0;
+    _os << fmt::format("{:<21}: {} acquisitions, {} contended ({:.1f}%)\n",
+                       _name,
+                       total.acquisitions,
+                       total.contended,
+                       contendedShare);
+    _os << fmt::format("{:<21}: waited {:.3f} ms (max {:.3f} ms), held {:.3f} ms\n",
+                       "",
+                       milliseconds(total.waitTime),
+                       milliseconds(total.maxWaitTime),
+                       milliseconds(total.holdTime));
+
+    for (LockOwnerStats const& owner: ownerStats())
+    {
+        auto thread = std::ostringstream {};
+        thread << owner.thread;
+        _os << fmt::format("{:<21}: thread {}: {} acquisitions, held {:.3f} ms\n",
+                           "",
+                           thread.str(),
+                           owner.acquisitions,
+                           milliseconds(owner.holdTime));
+    }
+}
+
+} // namespace crispy
@@ -0,0 +1,97 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace crispy
+{
+
+/// Running totals of the acquisitions of an InstrumentedMutex.
+struct LockStats
+{
+    uint64_t acquisitions = 0;               // total number of acquisitions
+    uint64_t contended = 0;                  // of those, the ones that had to wait for another owner
+    std::chrono::nanoseconds waitTime {};    // total time spent waiting in contended acquisitions
+    std::chrono::nanoseconds maxWaitTime {}; // longest wait of a single contended acquisition
+    std::chrono::nanoseconds holdTime {};    // total time the lock was held
+};
+
+/// Acquisitions of an InstrumentedMutex by a single thread.
+struct LockOwnerStats
+{
+    std::thread::id thread {};
+    uint64_t acquisitions = 0;
+    std::chrono::nanoseconds holdTime {};
+};
+
+/// Mutex that counts its acquisitions, how many of them had to wait for another owner and
+/// for how long, and how long each thread held it.
+///
+/// Uncontended acquisitions cost two clock reads (when acquiring and when releasing).
+/// All counters are only ever written with the mutex held, and may be read at any time.
+class InstrumentedMutex
+{
+  public:
+    /// Maximum number of distinct owner threads accounted for separately.
+    /// Acquisitions by any further threads are accounted to the last one.
+    static constexpr size_t MaxOwnerThreads = 8;
+
+    InstrumentedMutex() = default;
+    InstrumentedMutex(InstrumentedMutex const&) = delete;
+    InstrumentedMutex& operator=(InstrumentedMutex const&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    [[nodiscard]] LockStats stats() const noexcept;
+
+    /// @returns the acquisitions and hold times of each thread that has owned this mutex.
+    ///
+    /// Acquires the mutex (without accounting for it), so this must not be called while owning it.
+    [[nodiscard]] std::vector<LockOwnerStats> ownerStats() const;
+
+    /// Writes the statistics of this mutex, named @p _name, into @p _os.
+    ///
+    /// Acquires the mutex (without accounting for it), so this must not be called while owning it.
+    void inspect(std::string_view _name, std::ostream& _os) const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    void acquired(Clock::time_point _now) noexcept;
+
+    std::mutex mutable mutex_;
+
+    std::atomic<uint64_t> acquisitions_ = 0;
+    std::atomic<uint64_t> contended_ = 0;
+    std::atomic<int64_t> waitTime_ = 0;    // in nanoseconds
+    std::atomic<int64_t> maxWaitTime_ = 0; // in nanoseconds
+    std::atomic<int64_t> holdTime_ = 0;    // in nanoseconds
+
+    // Guarded by mutex_.
+    Clock::time_point lockedAt_ {};
+    std::array<LockOwnerStats, MaxOwnerThreads> owners_ {};
+};
+
+} // namespace crispy
@@ -0,0 +1,79 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/InstrumentedMutex.h>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std::chrono_literals;
+using crispy::InstrumentedMutex;
+
+TEST_CASE("InstrumentedMutex.uncontended", "[InstrumentedMutex]")
+{
+    auto mutex = InstrumentedMutex {};
+    for (int i = 0; i < 3; ++i)
+    {
+        auto const _l = std::lock_guard { mutex };
+    }
+    REQUIRE(mutex.try_lock());
+    mutex.unlock();
+
+    auto const stats = mutex.stats();
+    CHECK(stats.acquisitions == 4);
+    CHECK(stats.contended == 0);
+    CHECK(stats.waitTime == 0ns);
+
+    auto const owners = mutex.ownerStats();
+    REQUIRE(owners.size() == 1);
+    CHECK(owners[0].thread == std::this_thread::get_id());
+    CHECK(owners[0].acquisitions == 4);
+    CHECK(owners[0].holdTime == stats.holdTime);
+}
+
+TEST_CASE("InstrumentedMutex.contended", "[InstrumentedMutex]")
+{
+    auto mutex = InstrumentedMutex {};
+    auto locked = std::atomic<bool> { false };
+
+    auto owner = std::thread([&]() {
+        auto const _l = std::lock_guard { mutex };
+        locked = true;
+        std::this_thread::sleep_for(20ms);
+    });
+    while (!locked)
+        std::this_thread::yield();
+
+    CHECK_FALSE(mutex.try_lock());
+    {
+        auto const _l = std::lock_guard { mutex };
+    }
+    owner.join();
+
+    auto const stats = mutex.stats();
+    CHECK(stats.acquisitions == 2);
+    CHECK(stats.contended == 1);
+    CHECK(stats.waitTime > 0ns);
+    CHECK(stats.maxWaitTime == stats.waitTime);
+    CHECK(stats.holdTime >= 20ms);
+    CHECK(mutex.ownerStats().size() == 2);
+
+    auto output = std::ostringstream {};
+    mutex.inspect("test lock", output);
+    CHECK(output.str().find("2 acquisitions, 1 contended (50.0%)") != std::string::npos);
+}
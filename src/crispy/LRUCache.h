@@ -154,8 +154,8 @@ class LRUCache
 
     void erase(iterator _iter)
     {
-        items_.erase(_iter);
         itemByKeyMapping_.erase(_iter->key);
+        items_.erase(_iter);
     }
 
     void erase(Key const& _key)
@@ -0,0 +1,117 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace crispy
+{
+
+/// Bounded lock-free queue that any number of threads push to, and a single thread pops from.
+///
+/// Each slot carries a sequence number telling whether it is free to be written to for the given
+/// position, or holds the value for the given position. Producers claim positions by advancing
+/// the shared head, and the consumer hands slots back by advancing their sequence number by
+/// the capacity.
+template <typename T>
+class MPSCQueue
+{
+  public:
+    /// @param _capacity maximum number of values queued, rounded up to a power of two.
+    explicit MPSCQueue(size_t _capacity): mask_ { roundUpToPowerOfTwo(_capacity) - 1 }
+    {
+        slots_ = std::make_unique<Slot[]>(mask_ + 1);
+        for (size_t i = 0; i <= mask_; ++i)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MPSCQueue(MPSCQueue const&) = delete;
+    MPSCQueue& operator=(MPSCQueue const&) = delete;
+
+    [[nodiscard]] size_t capacity() const noexcept { return mask_ + 1; }
+
+    /// Appends @p _value, unless the queue is full.
+    ///
+    /// May be invoked by any thread.
+    ///
+    /// @retval true the value was moved into the queue.
+    /// @retval false the queue is full, and @p _value was left alone.
+    bool tryPush(T&& _value)
+    {
+        auto position = head_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& slot = slots_[position & mask_];
+            auto const sequence = slot.sequence.load(std::memory_order_acquire);
+            auto const lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0)
+            {
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.value.emplace(std::move(_value));
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0)
+                return false; // The consumer has not popped the value of the previous round yet.
+            else
+                position = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    /// Removes the oldest value, if any.
+    ///
+    /// Must only be invoked by the consumer thread. Values pushed concurrently may show up
+    /// only by the next invocation.
+    std::optional<T> tryPop()
+    {
+        auto& slot = slots_[tail_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1)
+            return std::nullopt;
+
+        auto value = std::move(slot.value);
+        slot.value.reset();
+        slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+        ++tail_;
+        return value;
+    }
+
+  private:
+    static size_t roundUpToPowerOfTwo(size_t _value) noexcept
+    {
+        auto result = size_t { 1 };
+        while (result < _value)
+            result <<= 1;
+        return result;
+    }
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence = 0;
+        std::optional<T> value;
+    };
+
+    size_t const mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> head_ = 0; // next position to push to, shared by the producers
+    alignas(64) size_t tail_ = 0;              // next position to pop from, owned by the consumer
+};
+
+} // namespace crispy
@@ -0,0 +1,85 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/MPSCQueue.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using crispy::MPSCQueue;
+using std::string;
+
+TEST_CASE("MPSCQueue.capacity", "[MPSCQueue]")
+{
+    CHECK(MPSCQueue<int>(1).capacity() == 1);
+    CHECK(MPSCQueue<int>(5).capacity() == 8);
+    CHECK(MPSCQueue<int>(8).capacity() == 8);
+}
+
+TEST_CASE("MPSCQueue.order", "[MPSCQueue]")
+{
+    auto queue = MPSCQueue<string>(4);
+    CHECK(!queue.tryPop());
+
+    // Going around the ring a few times.
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 4; ++i)
+            CHECK(queue.tryPush(std::to_string(i)));
+
+        auto rejected = string("full");
+        CHECK(!queue.tryPush(std::move(rejected)));
+        CHECK(rejected == "full");
+
+        for (int i = 0; i < 4; ++i)
+            CHECK(queue.tryPop() == std::to_string(i));
+        CHECK(!queue.tryPop());
+    }
+}
+
+TEST_CASE("MPSCQueue.producers", "[MPSCQueue]")
+{
+    constexpr int ProducerCount = 4;
+    constexpr int ValueCount = 10000;
+    auto queue = MPSCQueue<int>(64);
+
+    auto producers = std::vector<std::thread> {};
+    for (int producer = 0; producer < ProducerCount; ++producer)
+        producers.emplace_back([&, producer]() {
+            for (int i = 0; i < ValueCount; ++i)
+                while (!queue.tryPush(producer * ValueCount + i))
+                    std::this_thread::yield();
+        });
+
+    // Each producer's values arrive in the order they were pushed.
+    auto nextValues = std::vector<int>(ProducerCount, 0);
+    for (int received = 0; received < ProducerCount * ValueCount;)
+    {
+        auto const value = queue.tryPop();
+        if (!value)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        auto const producer = *value / ValueCount;
+        CHECK(*value % ValueCount == nextValues[static_cast<size_t>(producer)]++);
+        ++received;
+    }
+
+    for (auto& producer: producers)
+        producer.join();
+    CHECK(!queue.tryPop());
+}
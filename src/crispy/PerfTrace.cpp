@@ -0,0 +1,201 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/PerfTrace.h>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::string;
+
+namespace crispy
+{
+
+namespace
+{
+    // Caps the memory spent per thread (about 40 MB), dropping any events beyond.
+    constexpr size_t MaxEventsPerThread = 1024 * 1024;
+
+    struct TraceEvent
+    {
+        char const* name;
+        int64_t startMicros;
+        int64_t durationMicros;
+        char phase; // 'X' (complete slice), 's' (flow begin), 'f' (flow end)
+        uint64_t flowId;
+    };
+
+    // Each thread records into its own buffer, so that recording threads do not contend.
+    // The mutex is only ever contended while finish() writes the trace.
+    struct ThreadBuffer
+    {
+        std::mutex mutex;
+        size_t threadId = 0;
+        char const* threadName = nullptr;
+        std::vector<TraceEvent> events;
+        size_t droppedEvents = 0;
+    };
+
+    struct TraceState
+    {
+        std::atomic<bool> enabled = false;
+        std::mutex mutex;
+        string filePath;
+        std::vector<std::unique_ptr<ThreadBuffer>> threads; // outlives the threads it belongs to
+    };
+
+    PerfTrace::clock::time_point const epoch = PerfTrace::clock::now();
+
+    TraceState& state()
+    {
+        static TraceState instance;
+        return instance;
+    }
+
+    ThreadBuffer& localBuffer()
+    {
+        thread_local ThreadBuffer* buffer = []() {
+            auto& trace = state();
+            auto const _ = std::lock_guard { trace.mutex };
+            auto& newBuffer = trace.threads.emplace_back(std::make_unique<ThreadBuffer>());
+            newBuffer->threadId = trace.threads.size();
+            return newBuffer.get();
+        }();
+        return *buffer;
+    }
+
+    int64_t microsSinceEpoch(PerfTrace::clock::time_point _time) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(_time - epoch).count();
+    }
+
+    void addEvent(TraceEvent const& _event)
+    {
+        auto& buffer = localBuffer();
+        auto const _ = std::lock_guard { buffer.mutex };
+        if (buffer.events.size() < MaxEventsPerThread)
+            buffer.events.emplace_back(_event);
+        else
+            ++buffer.droppedEvents;
+    }
+} // namespace
+
+PerfTrace::Scope::Scope(char const* _name) noexcept:
+    name_ { _name }, start_ { PerfTrace::enabled() ? clock::now() : clock::time_point {} }
+{
+}
+
+PerfTrace::Scope::~Scope()
+{
+    if (start_ == clock::time_point {} || !PerfTrace::enabled())
+        return;
+
+    auto const start = microsSinceEpoch(start_);
+    addEvent(TraceEvent { name_, start, microsSinceEpoch(clock::now()) - start, 'X', 0 });
+}
+
+void PerfTrace::enable(string _filePath)
+{
+    auto& trace = state();
+    auto const _ = std::lock_guard { trace.mutex };
+    trace.filePath = std::move(_filePath);
+    trace.enabled = true;
+}
+
+bool PerfTrace::enabled() noexcept
+{
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+void PerfTrace::setThreadName(char const* _name)
+{
+    auto& buffer = localBuffer();
+    auto const _ = std::lock_guard { buffer.mutex };
+    buffer.threadName = _name;
+}
+
+void PerfTrace::flowBegin(char const* _name, uint64_t _id)
+{
+    if (enabled())
+        addEvent(TraceEvent { _name, microsSinceEpoch(clock::now()), 0, 's', _id });
+}
+
+void PerfTrace::flowEnd(char const* _name, uint64_t _id)
+{
+    if (enabled())
+        addEvent(TraceEvent { _name, microsSinceEpoch(clock::now()), 0, 'f', _id });
+}
+
+void PerfTrace::finish()
+{
+    auto& trace = state();
+    auto const _ = std::lock_guard { trace.mutex };
+    if (!trace.enabled)
+        return;
+    trace.enabled = false;
+
+    auto file = std::ofstream(trace.filePath, std::ios::trunc);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    auto separator = "";
+    for (auto const& buffer: trace.threads)
+    {
+        auto const _l = std::lock_guard { buffer->mutex };
+        if (buffer->threadName)
+        {
+            file << separator
+                 << fmt::format(
+                        R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+                        buffer->threadId,
+                        buffer->threadName);
+            separator = ",";
+        }
+        for (TraceEvent const& event: buffer->events)
+        {
+            file << separator;
+            separator = ",";
+            if (event.phase == 'X')
+                file << fmt::format(R"({{"name":"{}","ph":"X","ts":{},"dur":{},"pid":1,"tid":{}}})",
+                                    event.name,
+                                    event.startMicros,
+                                    event.durationMicros,
+                                    buffer->threadId);
+            else
+                file << fmt::format(
+                    R"({{"name":"{}","cat":"flow","ph":"{}","bp":"e","id":{},"ts":{},"pid":1,"tid":{}}})",
+                    event.name,
+                    event.phase,
+                    event.flowId,
+                    event.startMicros,
+                    buffer->threadId);
+        }
+        if (buffer->droppedEvents)
+        {
+            file << separator
+                 << fmt::format(R"({{"name":"{} events dropped","ph":"i","s":"t","ts":{},"pid":1,"tid":{}}})",
+                                buffer->droppedEvents,
+                                buffer->events.empty() ? 0 : buffer->events.back().startMicros,
+                                buffer->threadId);
+            separator = ",";
+        }
+        buffer->events.clear();
+        buffer->droppedEvents = 0;
+    }
+    file << "]}\n";
+}
+
+} // namespace crispy
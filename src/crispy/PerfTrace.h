@@ -0,0 +1,99 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace crispy
+{
+
+/**
+ * Low overhead tracing of hot code paths across threads, written as a Chrome trace event
+ * JSON file (to be loaded into https://ui.perfetto.dev, chrome://tracing, or Tracy via
+ * its chrome trace importer).
+ *
+ * This is only meant to be used via the CONTOUR_PERF_TRACE* macros below, which expand to
+ * nothing unless built with CONTOUR_PERF_TRACING.
+ *
+ * All names passed in must be string literals, as only their pointers are recorded.
+ */
+class PerfTrace
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /// Records the time between its construction and destruction as a named slice.
+    class Scope
+    {
+      public:
+        explicit Scope(char const* _name) noexcept;
+        ~Scope();
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+
+      private:
+        char const* name_;
+        clock::time_point start_;
+    };
+
+    /// Enables recording; the trace is written to the given file path upon finish().
+    static void enable(std::string _filePath);
+
+    [[nodiscard]] static bool enabled() noexcept;
+
+    /// Names the calling thread in the trace.
+    static void setThreadName(char const* _name);
+
+    /// Starts an arrow from the enclosing slice on the calling thread to the slice that
+    /// ends the flow of the same @p _id, e.g. on another thread.
+    static void flowBegin(char const* _name, uint64_t _id);
+
+    /// Ends the flow of the given @p _id in the enclosing slice on the calling thread.
+    static void flowEnd(char const* _name, uint64_t _id);
+
+    /// Writes all recorded events to the trace file and disables further recording.
+    static void finish();
+};
+
+} // namespace crispy
+
+#if defined(CONTOUR_PERF_TRACING)
+    #define CONTOUR_PERF_TRACE_CONCAT_(a, b) a##b
+    #define CONTOUR_PERF_TRACE_CONCAT(a, b)  CONTOUR_PERF_TRACE_CONCAT_(a, b)
+    #define CONTOUR_PERF_TRACE(name) \
+        ::crispy::PerfTrace::Scope const CONTOUR_PERF_TRACE_CONCAT(_perfTraceScope, __LINE__) { name }
+    #define CONTOUR_PERF_TRACE_THREAD(name)         ::crispy::PerfTrace::setThreadName(name)
+    #define CONTOUR_PERF_TRACE_FLOW_BEGIN(name, id) ::crispy::PerfTrace::flowBegin(name, id)
+    #define CONTOUR_PERF_TRACE_FLOW_END(name, id)   ::crispy::PerfTrace::flowEnd(name, id)
+#else
+    #define CONTOUR_PERF_TRACE(name) \
+        do                           \
+        {                            \
+        } while (0)
+    #define CONTOUR_PERF_TRACE_THREAD(name) \
+        do                                  \
+        {                                   \
+        } while (0)
+    #define CONTOUR_PERF_TRACE_FLOW_BEGIN(name, id) \
+        do                                          \
+        {                                           \
+        } while (0)
+    #define CONTOUR_PERF_TRACE_FLOW_END(name, id) \
+        do                                        \
+        {                                         \
+        } while (0)
+#endif
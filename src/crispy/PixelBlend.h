@@ -0,0 +1,127 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+    #include <immintrin.h>
+#elif defined(__aarch64__)
+    #include <crispy/sse2neon.h>
+#endif
+
+namespace crispy
+{
+
+// Blending of RGBA pixels (8 bits per channel) on the CPU, as done by a GPU with a per-channel
+// blending factor (dual source blending):
+//
+//     target.rgb = source.rgb * mask.rgb + target.rgb * (1 - mask.rgb)
+//     target.a   = source.a + target.a   (saturating)
+//
+// The mask's alpha channel is not used. Plain alpha blending is done by passing the source
+// alpha as mask for all three color channels.
+
+/// Returns round(_value / 255) for _value in [0, 255 * 255], e.g. to scale a channel by another.
+constexpr unsigned divideBy255(unsigned _value) noexcept
+{
+    _value += 128;
+    return (_value + (_value >> 8)) >> 8;
+}
+
+namespace detail
+{
+    inline void blendPixel(uint8_t* _target, uint8_t const* _source, uint8_t const* _mask) noexcept
+    {
+        for (int i = 0; i < 3; ++i)
+            _target[i] = static_cast<uint8_t>(
+                divideBy255(unsigned(_source[i]) * _mask[i] + unsigned(_target[i]) * (255u - _mask[i])));
+        _target[3] = static_cast<uint8_t>(std::min(255u, unsigned(_source[3]) + _target[3]));
+    }
+
+#if defined(__SSE2__) || defined(__aarch64__)
+    /// Blends the 16-bit channels of two pixels, rounding exactly as divideBy255().
+    inline __m128i blendChannels(__m128i _target, __m128i _source, __m128i _mask) noexcept
+    {
+        auto const inverse = _mm_sub_epi16(_mm_set1_epi16(255), _mask);
+        auto value = _mm_add_epi16(_mm_mullo_epi16(_source, _mask), _mm_mullo_epi16(_target, inverse));
+        value = _mm_add_epi16(value, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+    }
+
+    /// Blends four pixels.
+    inline __m128i blendPixels4(__m128i _target, __m128i _source, __m128i _mask) noexcept
+    {
+        auto const zero = _mm_setzero_si128();
+        auto const low = blendChannels(_mm_unpacklo_epi8(_target, zero),
+                                       _mm_unpacklo_epi8(_source, zero),
+                                       _mm_unpacklo_epi8(_mask, zero));
+        auto const high = blendChannels(_mm_unpackhi_epi8(_target, zero),
+                                        _mm_unpackhi_epi8(_source, zero),
+                                        _mm_unpackhi_epi8(_mask, zero));
+        auto const color = _mm_packus_epi16(low, high);
+
+        auto const alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        auto const alpha =
+            _mm_adds_epu8(_mm_and_si128(_source, alphaMask), _mm_and_si128(_target, alphaMask));
+        return _mm_or_si128(_mm_andnot_si128(alphaMask, color), alpha);
+    }
+#endif
+} // namespace detail
+
+/// Blends @p _count consecutive RGBA pixels of @p _source into @p _target, weighted by
+/// the pixels of @p _mask.
+inline void blendPixels(uint8_t* _target,
+                        uint8_t const* _source,
+                        uint8_t const* _mask,
+                        size_t _count) noexcept
+{
+#if defined(__SSE2__) || defined(__aarch64__)
+    for (; _count >= 4; _count -= 4, _target += 16, _source += 16, _mask += 16)
+    {
+        auto const target = _mm_loadu_si128(reinterpret_cast<__m128i const*>(_target));
+        auto const source = _mm_loadu_si128(reinterpret_cast<__m128i const*>(_source));
+        auto const mask = _mm_loadu_si128(reinterpret_cast<__m128i const*>(_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(_target), detail::blendPixels4(target, source, mask));
+    }
+#endif
+    for (; _count != 0; --_count, _target += 4, _source += 4, _mask += 4)
+        detail::blendPixel(_target, _source, _mask);
+}
+
+/// Blends the RGBA pixel @p _source into @p _count consecutive pixels at @p _target,
+/// weighted by the pixel @p _mask, e.g. to fill a rectangle with a translucent color.
+inline void blendSolid(uint8_t* _target, uint32_t _source, uint32_t _mask, size_t _count) noexcept
+{
+#if defined(__SSE2__) || defined(__aarch64__)
+    auto const source = _mm_set1_epi32(static_cast<int>(_source));
+    auto const mask = _mm_set1_epi32(static_cast<int>(_mask));
+    for (; _count >= 4; _count -= 4, _target += 16)
+    {
+        auto const target = _mm_loadu_si128(reinterpret_cast<__m128i const*>(_target));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(_target), detail::blendPixels4(target, source, mask));
+    }
+#endif
+    uint8_t sourcePixel[4];
+    uint8_t maskPixel[4];
+    std::memcpy(sourcePixel, &_source, sizeof(sourcePixel));
+    std::memcpy(maskPixel, &_mask, sizeof(maskPixel));
+    for (; _count != 0; --_count, _target += 4)
+        detail::blendPixel(_target, sourcePixel, maskPixel);
+}
+
+} // namespace crispy
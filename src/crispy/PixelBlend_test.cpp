@@ -0,0 +1,98 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/PixelBlend.h>
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+using std::array;
+using std::vector;
+
+namespace
+{
+
+using Pixel = array<uint8_t, 4>;
+
+uint32_t packed(Pixel _pixel)
+{
+    auto value = uint32_t {};
+    std::memcpy(&value, _pixel.data(), sizeof(value));
+    return value;
+}
+
+/// Reference blending of a single pixel, in floating point.
+Pixel expectedBlend(Pixel _target, Pixel _source, Pixel _mask)
+{
+    auto result = Pixel {};
+    for (size_t i = 0; i < 3; ++i)
+    {
+        auto const mask = _mask[i] / 255.0;
+        result[i] = static_cast<uint8_t>(_source[i] * mask + _target[i] * (1.0 - mask) + 0.5);
+    }
+    result[3] = static_cast<uint8_t>(std::min(255, _source[3] + _target[3]));
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("PixelBlend.blendPixels", "[PixelBlend]")
+{
+    // An odd count, so that both the vectorized loop and the remainder are exercised.
+    auto constexpr Count = size_t { 11 };
+    auto target = vector<uint8_t>(Count * 4);
+    auto source = vector<uint8_t>(Count * 4);
+    auto mask = vector<uint8_t>(Count * 4);
+    for (size_t i = 0; i < target.size(); ++i)
+    {
+        target[i] = static_cast<uint8_t>(i * 37 + 11);
+        source[i] = static_cast<uint8_t>(i * 91 + 3);
+        mask[i] = static_cast<uint8_t>(i * 53);
+    }
+    auto const original = target;
+
+    crispy::blendPixels(target.data(), source.data(), mask.data(), Count);
+
+    for (size_t i = 0; i < Count; ++i)
+    {
+        auto const at = [&](vector<uint8_t> const& _pixels) {
+            return Pixel { _pixels[i * 4], _pixels[i * 4 + 1], _pixels[i * 4 + 2], _pixels[i * 4 + 3] };
+        };
+        INFO("pixel " << i);
+        CHECK(at(target) == expectedBlend(at(original), at(source), at(mask)));
+    }
+}
+
+TEST_CASE("PixelBlend.blendSolid", "[PixelBlend]")
+{
+    auto constexpr Count = size_t { 7 };
+    auto const background = Pixel { 10, 200, 30, 128 };
+    auto target = vector<uint8_t>();
+    for (size_t i = 0; i < Count; ++i)
+        target.insert(target.end(), background.begin(), background.end());
+
+    // Fully opaque masks replace the color, and empty ones keep it.
+    crispy::blendSolid(target.data(), packed({ 255, 0, 0, 200 }), packed({ 255, 255, 255, 0 }), 2);
+    crispy::blendSolid(target.data() + 8, packed({ 255, 0, 0, 0 }), packed({ 0, 0, 0, 0 }), 2);
+    crispy::blendSolid(target.data() + 16, packed({ 255, 0, 0, 64 }), packed({ 64, 128, 192, 0 }), 3);
+
+    CHECK(Pixel { target[0], target[1], target[2], target[3] } == Pixel { 255, 0, 0, 255 });
+    CHECK(Pixel { target[4], target[5], target[6], target[7] } == Pixel { 255, 0, 0, 255 });
+    CHECK(Pixel { target[8], target[9], target[10], target[11] } == background);
+    for (size_t i = 4; i < Count; ++i)
+        CHECK(Pixel { target[i * 4], target[i * 4 + 1], target[i * 4 + 2], target[i * 4 + 3] }
+              == expectedBlend(background, Pixel { 255, 0, 0, 64 }, Pixel { 64, 128, 192, 0 }));
+}
@@ -0,0 +1,182 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace crispy
+{
+
+/// Packs rectangles of individual sizes into a fixed area, such as a texture atlas.
+///
+/// The area is divided into horizontal shelves from top to bottom, each as high as the first
+/// rectangle placed in it (rounded up to ShelfGranularity), and filled from left to right.
+/// Rectangles only go into shelves not much higher than themselves, so that little space is lost
+/// above them.
+///
+/// Released rectangles leave free spans on their shelf, which are merged with their neighbours
+/// and reused by later rectangles. Shelves becoming empty at the bottom are given back to
+/// the free area below the shelves, and other empty shelves take rectangles of any lower height.
+class ShelfPacker
+{
+  public:
+    /// Shelf heights are multiples of this, so that rectangles of similar heights share shelves.
+    static constexpr uint32_t ShelfGranularity = 4;
+
+    struct Region
+    {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    ShelfPacker(uint32_t _width, uint32_t _height) noexcept: width_ { _width }, height_ { _height } {}
+
+    [[nodiscard]] uint32_t width() const noexcept { return width_; }
+    [[nodiscard]] uint32_t height() const noexcept { return height_; }
+
+    /// Number of pixels covered by the currently allocated regions.
+    [[nodiscard]] size_t usedArea() const noexcept { return usedArea_; }
+
+    [[nodiscard]] size_t shelfCount() const noexcept { return shelves_.size(); }
+
+    /// Allocates a region of the given size.
+    ///
+    /// @returns the region, or nothing if no free space is large enough.
+    [[nodiscard]] std::optional<Region> allocate(uint32_t _width, uint32_t _height)
+    {
+        if (_width == 0 || _height == 0 || _width > width_ || _height > height_)
+            return std::nullopt;
+
+        // The best fitting span is the one on the lowest shelf high enough, as to waste the least space.
+        auto const maxShelfHeight = roundUp(_height) + roundUp(_height) / 2;
+        Shelf* bestShelf = nullptr;
+        size_t bestSpan = 0;
+        for (Shelf& shelf: shelves_)
+        {
+            if (shelf.height < _height || (shelf.height > maxShelfHeight && !shelf.empty(width_)))
+                continue;
+            if (bestShelf && bestShelf->height <= shelf.height)
+                continue;
+            for (size_t i = 0; i < shelf.freeSpans.size(); ++i)
+            {
+                if (shelf.freeSpans[i].width >= _width)
+                {
+                    bestShelf = &shelf;
+                    bestSpan = i;
+                    break;
+                }
+            }
+        }
+
+        if (!bestShelf)
+        {
+            auto const shelfY = shelves_.empty() ? 0 : shelves_.back().y + shelves_.back().height;
+            auto const shelfHeight = std::min(roundUp(_height), height_ - shelfY);
+            if (shelfHeight < _height)
+                return std::nullopt;
+            shelves_.emplace_back(Shelf { shelfY, shelfHeight, { Span { 0, width_ } } });
+            bestShelf = &shelves_.back();
+            bestSpan = 0;
+        }
+
+        Span& span = bestShelf->freeSpans[bestSpan];
+        auto const region = Region { span.x, bestShelf->y, _width, _height };
+        span.x += _width;
+        span.width -= _width;
+        if (span.width == 0)
+            bestShelf->freeSpans.erase(bestShelf->freeSpans.begin() + static_cast<ptrdiff_t>(bestSpan));
+
+        usedArea_ += size_t(_width) * _height;
+        return region;
+    }
+
+    /// Releases a region previously returned by allocate().
+    void release(Region const& _region)
+    {
+        auto const shelf =
+            std::lower_bound(shelves_.begin(), shelves_.end(), _region.y, [](Shelf const& a, uint32_t y) {
+                return a.y < y;
+            });
+        if (shelf == shelves_.end() || shelf->y != _region.y)
+            return;
+
+        auto& spans = shelf->freeSpans;
+        auto next = std::lower_bound(
+            spans.begin(), spans.end(), _region.x, [](Span const& a, uint32_t x) { return a.x < x; });
+        next = spans.insert(next, Span { _region.x, _region.width });
+        if (next + 1 != spans.end() && next->x + next->width == (next + 1)->x)
+        {
+            next->width += (next + 1)->width;
+            spans.erase(next + 1);
+        }
+        if (next != spans.begin() && (next - 1)->x + (next - 1)->width == next->x)
+        {
+            (next - 1)->width += next->width;
+            spans.erase(next);
+        }
+
+        usedArea_ -= size_t(_region.width) * _region.height;
+
+        while (!shelves_.empty() && shelves_.back().empty(width_))
+            shelves_.pop_back();
+    }
+
+    void clear() noexcept
+    {
+        shelves_.clear();
+        usedArea_ = 0;
+    }
+
+  private:
+    struct Span
+    {
+        uint32_t x;
+        uint32_t width;
+    };
+
+    struct Shelf
+    {
+        uint32_t y;
+        uint32_t height;
+        std::vector<Span> freeSpans; // ordered by their X-offset
+
+        [[nodiscard]] bool empty(uint32_t _width) const noexcept
+        {
+            return freeSpans.size() == 1 && freeSpans[0].width == _width;
+        }
+    };
+
+    static constexpr uint32_t roundUp(uint32_t _height) noexcept
+    {
+        return (_height + ShelfGranularity - 1) / ShelfGranularity * ShelfGranularity;
+    }
+
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<Shelf> shelves_; // ordered by their Y-offset, without gaps between them
+    size_t usedArea_ = 0;
+};
+
+constexpr bool operator==(ShelfPacker::Region const& a, ShelfPacker::Region const& b) noexcept
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+} // namespace crispy
@@ -0,0 +1,88 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/ShelfPacker.h>
+
+#include <catch2/catch.hpp>
+
+using crispy::ShelfPacker;
+using Region = ShelfPacker::Region;
+
+TEST_CASE("ShelfPacker.allocate", "[ShelfPacker]")
+{
+    auto packer = ShelfPacker(64, 32);
+    CHECK(!packer.allocate(0, 8));
+    CHECK(!packer.allocate(65, 8));
+    CHECK(!packer.allocate(8, 33));
+
+    // Rectangles of similar heights share a shelf.
+    CHECK(*packer.allocate(20, 10) == Region { 0, 0, 20, 10 });
+    CHECK(*packer.allocate(30, 12) == Region { 20, 0, 30, 12 });
+    CHECK(packer.shelfCount() == 1);
+
+    // Too wide for the remaining span, and lower rectangles open a shelf of their own.
+    CHECK(*packer.allocate(20, 12) == Region { 0, 12, 20, 12 });
+    CHECK(*packer.allocate(10, 4) == Region { 0, 24, 10, 4 });
+    CHECK(*packer.allocate(14, 12) == Region { 50, 0, 14, 12 });
+    CHECK(packer.shelfCount() == 3);
+    CHECK(packer.usedArea() == 20 * 10 + 30 * 12 + 20 * 12 + 10 * 4 + 14 * 12);
+
+    // Out of space.
+    CHECK(!packer.allocate(64, 8));
+    CHECK(*packer.allocate(64, 4) == Region { 0, 28, 64, 4 });
+}
+
+TEST_CASE("ShelfPacker.release", "[ShelfPacker]")
+{
+    auto packer = ShelfPacker(64, 16);
+    auto const a = *packer.allocate(16, 8);
+    auto const b = *packer.allocate(16, 8);
+    CHECK(packer.allocate(32, 8));
+    auto const d = *packer.allocate(64, 8);
+    CHECK(!packer.allocate(8, 8));
+
+    // Released spans are reused, and merged with their free neighbours.
+    packer.release(b);
+    CHECK(!packer.allocate(24, 8));
+    packer.release(a);
+    CHECK(*packer.allocate(24, 8) == Region { 0, 0, 24, 8 });
+    CHECK(*packer.allocate(8, 8) == Region { 24, 0, 8, 8 });
+
+    // Empty shelves at the bottom become free space for shelves of any height.
+    packer.release(d);
+    CHECK(packer.shelfCount() == 1);
+    CHECK(*packer.allocate(4, 5) == Region { 0, 8, 4, 5 });
+
+    packer.clear();
+    CHECK(packer.usedArea() == 0);
+    CHECK(*packer.allocate(64, 16) == Region { 0, 0, 64, 16 });
+}
+
+TEST_CASE("ShelfPacker.reuse_empty_shelf", "[ShelfPacker]")
+{
+    auto packer = ShelfPacker(32, 20);
+    auto const tall = *packer.allocate(32, 16);
+    auto const low = *packer.allocate(32, 4);
+    packer.release(tall);
+    CHECK(packer.shelfCount() == 2);
+
+    // An empty shelf takes rectangles much lower than itself.
+    CHECK(*packer.allocate(8, 4) == Region { 0, 0, 8, 4 });
+
+    // Once used, it only takes rectangles of similar heights.
+    CHECK(!packer.allocate(8, 2));
+    CHECK(*packer.allocate(8, 12) == Region { 8, 0, 8, 12 });
+
+    packer.release(low);
+    CHECK(packer.usedArea() == 8 * 4 + 8 * 12);
+}
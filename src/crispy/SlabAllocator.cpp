@@ -0,0 +1,160 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/SlabAllocator.h>
+#include <crispy/assert.h>
+
+#include <algorithm>
+
+using std::align_val_t;
+using std::max_align_t;
+
+namespace crispy
+{
+
+namespace
+{
+    constexpr size_t roundUpBlockSize(size_t bytes) noexcept
+    {
+        auto constexpr Alignment = alignof(max_align_t);
+        return std::max((bytes + Alignment - 1) & ~(Alignment - 1), sizeof(void*));
+    }
+} // namespace
+
+SlabPool::SlabPool(size_t blockSize, size_t chunkSize):
+    blockSize_ { roundUpBlockSize(blockSize) }, chunkSize_ { chunkSize }
+{
+    Require(chunkSize_ >= 4096 && (chunkSize_ & (chunkSize_ - 1)) == 0);
+}
+
+SlabPool::~SlabPool()
+{
+    for (auto& chunk: chunks_)
+        ::operator delete(chunk->base, align_val_t { chunkSize_ });
+    if (spare_)
+        ::operator delete(spare_, align_val_t { chunkSize_ });
+}
+
+void SlabPool::setBlockSize(size_t blockSize) noexcept
+{
+    blockSize_ = roundUpBlockSize(blockSize);
+}
+
+size_t SlabPool::storageSize() const noexcept
+{
+    return (chunks_.size() + (spare_ ? 1 : 0)) * chunkSize_;
+}
+
+bool SlabPool::isSlabSize(size_t bytes) const noexcept
+{
+    // Very large blocks would leave too much of a chunk unused.
+    return roundUpBlockSize(bytes) == blockSize_ && blockSize_ <= chunkSize_ / 8;
+}
+
+void* SlabPool::allocate(size_t bytes)
+{
+    if (!isSlabSize(bytes))
+        return ::operator new(bytes);
+
+    auto guard = concurrent_ ? std::unique_lock { lock_ } : std::unique_lock<std::mutex> {};
+    if (!current_ || current_->blockSize != blockSize_ || !current_->hasRoom())
+        current_ = &acquireChunk();
+
+    Chunk& chunk = *current_;
+    void* block = nullptr;
+    if (chunk.freeList)
+    {
+        block = chunk.freeList;
+        chunk.freeList = *static_cast<void**>(block);
+    }
+    else
+        block = chunk.base + chunk.blockSize * chunk.carved++;
+
+    ++chunk.used;
+    ++blocksInUse_;
+    return block;
+}
+
+void SlabPool::deallocate(void* p, size_t bytes) noexcept
+{
+    if (!p)
+        return;
+
+    auto guard = concurrent_ ? std::unique_lock { lock_ } : std::unique_lock<std::mutex> {};
+    Chunk* chunk = findChunk(p);
+    if (!chunk)
+    {
+        ::operator delete(p, bytes);
+        return;
+    }
+
+    *static_cast<void**>(p) = chunk->freeList;
+    chunk->freeList = p;
+    --chunk->used;
+    --blocksInUse_;
+
+    if (chunk->used != 0)
+        return;
+
+    if (chunk != current_)
+        releaseChunk(chunk);
+    else
+    {
+        // Start carving from the front again, in order to keep subsequent blocks adjacent.
+        chunk->carved = 0;
+        chunk->freeList = nullptr;
+    }
+}
+
+auto SlabPool::findChunk(void const* p) noexcept -> Chunk*
+{
+    auto const base = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(p) & ~(chunkSize_ - 1));
+    auto const i = std::lower_bound(
+        chunks_.begin(), chunks_.end(), base, [](auto const& chunk, char* b) { return chunk->base < b; });
+    if (i != chunks_.end() && (*i)->base == base)
+        return i->get();
+    return nullptr;
+}
+
+auto SlabPool::acquireChunk() -> Chunk&
+{
+    for (auto& chunk: chunks_)
+        if (chunk->blockSize == blockSize_ && chunk->hasRoom())
+            return *chunk;
+
+    char* base = spare_;
+    spare_ = nullptr;
+    if (!base)
+        base = static_cast<char*>(::operator new(chunkSize_, align_val_t { chunkSize_ }));
+
+    auto chunk = std::make_unique<Chunk>(Chunk { base, blockSize_, chunkSize_ / blockSize_ });
+    auto const i = std::lower_bound(
+        chunks_.begin(), chunks_.end(), base, [](auto const& c, char* b) { return c->base < b; });
+    return **chunks_.insert(i, std::move(chunk));
+}
+
+void SlabPool::releaseChunk(Chunk* chunk) noexcept
+{
+    auto const i = std::find_if(
+        chunks_.begin(), chunks_.end(), [chunk](auto const& c) { return c.get() == chunk; });
+    Require(i != chunks_.end());
+
+    if (!spare_)
+        spare_ = chunk->base;
+    else
+        ::operator delete(chunk->base, align_val_t { chunkSize_ });
+
+    chunks_.erase(i);
+}
+
+} // namespace crispy
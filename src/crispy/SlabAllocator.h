@@ -0,0 +1,169 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace crispy
+{
+
+/**
+ * Pool of equally sized memory blocks, carved out of large chunks.
+ *
+ * Blocks are handed out in allocation order from the current chunk,
+ * so that consecutively allocated blocks (such as the cells of sibling grid lines)
+ * are adjacent in memory. Released blocks are reused before carving new ones,
+ * and a chunk whose blocks are all released is returned to the system,
+ * except for one spare chunk that is kept for reuse.
+ *
+ * Allocations of any other size than blockSize() are forwarded to the global operator new.
+ *
+ * Chunks are aligned to their size, which is a power of two and at least a memory page.
+ *
+ * Not thread-safe, unless temporarily made so by setConcurrent().
+ */
+class SlabPool
+{
+  public:
+    static constexpr size_t DefaultChunkSize = 256 * 1024;
+
+    explicit SlabPool(size_t blockSize, size_t chunkSize = DefaultChunkSize);
+    ~SlabPool();
+
+    SlabPool(SlabPool const&) = delete;
+    SlabPool(SlabPool&&) = delete;
+    SlabPool& operator=(SlabPool const&) = delete;
+    SlabPool& operator=(SlabPool&&) = delete;
+
+    /// Changes the block size for subsequent allocations.
+    ///
+    /// Blocks of the previous size remain valid and are released into their own chunks.
+    void setBlockSize(size_t blockSize) noexcept;
+    [[nodiscard]] size_t blockSize() const noexcept { return blockSize_; }
+    [[nodiscard]] size_t chunkSize() const noexcept { return chunkSize_; }
+
+    /// Serializes allocations and deallocations while enabled, so that multiple threads
+    /// may share the pool for a while, such as when reflowing grid lines concurrently.
+    ///
+    /// Must not be toggled while other threads use the pool.
+    void setConcurrent(bool enabled) noexcept { concurrent_ = enabled; }
+    [[nodiscard]] bool concurrent() const noexcept { return concurrent_; }
+
+    [[nodiscard]] void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes) noexcept;
+
+    /// Number of chunks in use, not counting the spare chunk.
+    [[nodiscard]] size_t chunkCount() const noexcept { return chunks_.size(); }
+
+    /// Number of blocks currently handed out.
+    [[nodiscard]] size_t blocksInUse() const noexcept { return blocksInUse_; }
+
+    /// Bytes of memory held by this pool, including the spare chunk.
+    [[nodiscard]] size_t storageSize() const noexcept;
+
+  private:
+    struct Chunk
+    {
+        char* base;
+        size_t blockSize;
+        size_t blockCount;
+        size_t carved = 0; // number of blocks handed out from the bump region so far
+        size_t used = 0;
+        void* freeList = nullptr;
+
+        [[nodiscard]] bool hasRoom() const noexcept { return freeList || carved < blockCount; }
+    };
+
+    [[nodiscard]] bool isSlabSize(size_t bytes) const noexcept;
+    [[nodiscard]] Chunk* findChunk(void const* p) noexcept;
+    Chunk& acquireChunk();
+    void releaseChunk(Chunk* chunk) noexcept;
+
+    size_t blockSize_;
+    size_t chunkSize_;
+    size_t blocksInUse_ = 0;
+    std::vector<std::unique_ptr<Chunk>> chunks_; // ordered by base address
+    Chunk* current_ = nullptr;
+    char* spare_ = nullptr;
+    bool concurrent_ = false;
+    std::mutex lock_; // guards all of the above while concurrent_
+};
+
+/// Standard allocator handing out memory from a SlabPool,
+/// or from the global operator new if not bound to any pool.
+///
+/// The allocator shares ownership of its pool, so that containers may outlive the pool's creator.
+template <typename T>
+class SlabAllocator
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t));
+
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    SlabAllocator() noexcept = default;
+    // Moving copies, so that a moved-from container stays bound to the same pool.
+    SlabAllocator(SlabAllocator const&) noexcept = default;
+    SlabAllocator& operator=(SlabAllocator const&) noexcept = default;
+    explicit SlabAllocator(std::shared_ptr<SlabPool> pool) noexcept: pool_ { std::move(pool) } {}
+
+    template <typename U>
+    SlabAllocator(SlabAllocator<U> const& other) noexcept: pool_ { other.sharedPool() }
+    {
+    }
+
+    [[nodiscard]] T* allocate(size_t n)
+    {
+        if (pool_)
+            return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        if (pool_)
+            pool_->deallocate(p, n * sizeof(T));
+        else
+            ::operator delete(p);
+    }
+
+    [[nodiscard]] SlabPool* pool() const noexcept { return pool_.get(); }
+    [[nodiscard]] std::shared_ptr<SlabPool> const& sharedPool() const noexcept { return pool_; }
+
+  private:
+    std::shared_ptr<SlabPool> pool_;
+};
+
+template <typename T, typename U>
+bool operator==(SlabAllocator<T> const& a, SlabAllocator<U> const& b) noexcept
+{
+    return a.pool() == b.pool();
+}
+
+template <typename T, typename U>
+bool operator!=(SlabAllocator<T> const& a, SlabAllocator<U> const& b) noexcept
+{
+    return !(a == b);
+}
+
+} // namespace crispy
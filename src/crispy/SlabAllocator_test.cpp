@@ -0,0 +1,148 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/SlabAllocator.h>
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace crispy;
+using namespace std;
+
+namespace
+{
+struct Item
+{
+    uint64_t a = 0;
+    uint64_t b = 0;
+    uint32_t c = 0;
+};
+
+using ItemVector = vector<Item, SlabAllocator<Item>>;
+
+constexpr size_t ChunkSize = 4096;
+} // namespace
+
+TEST_CASE("SlabPool.adjacent_blocks")
+{
+    auto pool = make_shared<SlabPool>(10 * sizeof(Item), ChunkSize);
+    auto const allocator = SlabAllocator<Item>(pool);
+
+    auto a = ItemVector(10, Item {}, allocator);
+    auto b = ItemVector(10, Item {}, allocator);
+    CHECK(pool->blocksInUse() == 2);
+    CHECK(pool->chunkCount() == 1);
+
+    // Consecutively allocated blocks are adjacent, in allocation order.
+    auto const distance = reinterpret_cast<uintptr_t>(b.data()) - reinterpret_cast<uintptr_t>(a.data());
+    CHECK(distance == pool->blockSize());
+    CHECK(reinterpret_cast<uintptr_t>(a.data()) % ChunkSize == 0);
+}
+
+TEST_CASE("SlabPool.reuse_and_release")
+{
+    auto pool = make_shared<SlabPool>(10 * sizeof(Item), ChunkSize);
+    auto const allocator = SlabAllocator<Item>(pool);
+    auto const blocksPerChunk = ChunkSize / pool->blockSize();
+
+    auto vectors = vector<ItemVector> {};
+    for (size_t i = 0; i < 3 * blocksPerChunk; ++i)
+        vectors.emplace_back(10, Item {}, allocator);
+    CHECK(pool->chunkCount() == 3);
+    CHECK(pool->storageSize() == 3 * ChunkSize);
+
+    // Released blocks are reused before carving new ones.
+    auto const* released = vectors[1].data();
+    vectors[1] = ItemVector(allocator);
+    vectors[1].resize(10);
+    CHECK(vectors[1].data() == released);
+
+    // Fully released chunks are returned, except for the current chunk (the one that served the
+    // reallocation above) and one spare chunk.
+    vectors.erase(vectors.begin(), vectors.begin() + static_cast<ptrdiff_t>(2 * blocksPerChunk));
+    CHECK(pool->blocksInUse() == blocksPerChunk);
+    CHECK(pool->chunkCount() == 2);
+    CHECK(pool->storageSize() == 3 * ChunkSize);
+
+    // The emptied current chunk is carved from its front again.
+    auto const v = ItemVector(10, Item {}, allocator);
+    CHECK(reinterpret_cast<uintptr_t>(v.data()) % ChunkSize == 0);
+}
+
+TEST_CASE("SlabPool.other_sizes")
+{
+    auto pool = make_shared<SlabPool>(10 * sizeof(Item), ChunkSize);
+    auto const allocator = SlabAllocator<Item>(pool);
+
+    auto v = ItemVector(7, Item {}, allocator); // not the block size
+    CHECK(pool->blocksInUse() == 0);
+    v.resize(100);
+    CHECK(pool->blocksInUse() == 0);
+
+    pool->setBlockSize(7 * sizeof(Item));
+    auto w = ItemVector(7, Item {}, allocator);
+    CHECK(pool->blocksInUse() == 1);
+}
+
+TEST_CASE("SlabPool.concurrent")
+{
+    auto pool = make_shared<SlabPool>(10 * sizeof(Item), ChunkSize);
+    auto const allocator = SlabAllocator<Item>(pool);
+    pool->setConcurrent(true);
+
+    auto constexpr ThreadCount = 4;
+    auto constexpr VectorCount = 1000;
+    auto results = vector<vector<ItemVector>>(ThreadCount);
+    auto threads = vector<thread>();
+    for (size_t i = 0; i < ThreadCount; ++i)
+        threads.emplace_back([&, i]() {
+            for (auto k = 0; k < VectorCount; ++k)
+            {
+                results[i].emplace_back(10, Item { i, uint64_t(k), 0 }, allocator);
+                if (k % 3 == 0)
+                    results[i].erase(results[i].begin());
+            }
+        });
+    for (auto& thread: threads)
+        thread.join();
+    pool->setConcurrent(false);
+
+    auto blocks = size_t { 0 };
+    for (size_t i = 0; i < ThreadCount; ++i)
+    {
+        blocks += results[i].size();
+        for (auto const& v: results[i])
+            CHECK(v.back().a == i);
+    }
+    CHECK(pool->blocksInUse() == blocks);
+}
+
+TEST_CASE("SlabAllocator.outlives_owner")
+{
+    auto v = ItemVector {};
+    {
+        auto pool = make_shared<SlabPool>(4 * sizeof(Item), ChunkSize);
+        v = ItemVector(4, Item { 1, 2, 3 }, SlabAllocator<Item>(pool));
+    }
+    // The vector keeps the pool alive.
+    CHECK(v.get_allocator().pool() != nullptr);
+    CHECK(v.back().c == 3);
+
+    auto heap = ItemVector(4, Item {});
+    CHECK(heap.get_allocator().pool() == nullptr);
+    CHECK(heap.get_allocator() != v.get_allocator());
+}
@@ -0,0 +1,159 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/StartupTrace.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+namespace crispy
+{
+
+namespace
+{
+    struct TraceEvent
+    {
+        string name;
+        int64_t startMicros;
+        int64_t durationMicros; // negative for instant events
+        size_t threadId;
+    };
+
+    struct TraceState
+    {
+        std::atomic<bool> enabled = false;
+        std::mutex mutex;
+        string filePath;
+        std::vector<TraceEvent> events;
+        std::vector<std::thread::id> threads; // index is the thread ID used in the trace
+    };
+
+    // Timestamps are relative to this, which is initialized close to process start.
+    StartupTrace::clock::time_point const epoch = StartupTrace::clock::now();
+
+    TraceState& state()
+    {
+        static TraceState instance;
+        return instance;
+    }
+
+    int64_t microsSinceEpoch(StartupTrace::clock::time_point _time) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(_time - epoch).count();
+    }
+
+    string escapeJson(string_view _text)
+    {
+        string result;
+        result.reserve(_text.size());
+        for (char const ch: _text)
+        {
+            if (ch == '"' || ch == '\\')
+                result.push_back('\\');
+            result.push_back(ch);
+        }
+        return result;
+    }
+
+    void addEvent(string_view _name, int64_t _startMicros, int64_t _durationMicros)
+    {
+        auto& trace = state();
+        auto const _ = std::lock_guard { trace.mutex };
+        if (!trace.enabled)
+            return;
+        auto const thread = std::find(trace.threads.begin(), trace.threads.end(), std::this_thread::get_id());
+        auto const threadId = static_cast<size_t>(std::distance(trace.threads.begin(), thread));
+        if (thread == trace.threads.end())
+            trace.threads.emplace_back(std::this_thread::get_id());
+        trace.events.emplace_back(TraceEvent { string(_name), _startMicros, _durationMicros, threadId });
+    }
+} // namespace
+
+StartupTrace::Scope::Scope(string_view _name): name_ { _name }, start_ { clock::now() }
+{
+}
+
+StartupTrace::Scope::~Scope()
+{
+    if (StartupTrace::enabled())
+        StartupTrace::record(name_, start_, clock::now());
+}
+
+void StartupTrace::enable(string _filePath)
+{
+    auto& trace = state();
+    auto const _ = std::lock_guard { trace.mutex };
+    trace.filePath = std::move(_filePath);
+    trace.enabled = true;
+}
+
+bool StartupTrace::enabled() noexcept
+{
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+void StartupTrace::record(string_view _name, clock::time_point _start, clock::time_point _end)
+{
+    if (enabled())
+        addEvent(_name, microsSinceEpoch(_start), microsSinceEpoch(_end) - microsSinceEpoch(_start));
+}
+
+void StartupTrace::mark(string_view _name)
+{
+    if (enabled())
+        addEvent(_name, microsSinceEpoch(clock::now()), -1);
+}
+
+void StartupTrace::finish()
+{
+    auto& trace = state();
+    auto const _ = std::lock_guard { trace.mutex };
+    if (!trace.enabled)
+        return;
+    trace.enabled = false;
+
+    auto file = std::ofstream(trace.filePath, std::ios::trunc);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < trace.events.size(); ++i)
+    {
+        TraceEvent const& event = trace.events[i];
+        if (i != 0)
+            file << ',';
+        if (event.durationMicros < 0)
+            file << fmt::format(R"({{"name":"{}","ph":"i","s":"p","ts":{},"pid":1,"tid":{}}})",
+                                escapeJson(event.name),
+                                event.startMicros,
+                                event.threadId);
+        else
+            file << fmt::format(R"({{"name":"{}","ph":"X","ts":{},"dur":{},"pid":1,"tid":{}}})",
+                                escapeJson(event.name),
+                                event.startMicros,
+                                event.durationMicros,
+                                event.threadId);
+    }
+    file << "]}\n";
+    trace.events.clear();
+}
+
+} // namespace crispy
@@ -0,0 +1,65 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+namespace crispy
+{
+
+/**
+ * Records how long the individual phases of application startup take
+ * and writes them as a Chrome trace event JSON file
+ * (to be loaded into chrome://tracing or https://ui.perfetto.dev).
+ *
+ * Tracing is disabled, and recording is a no-op, unless enabled with a trace file path.
+ */
+class StartupTrace
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    /// Records the time between its construction and destruction as a named phase.
+    class Scope
+    {
+      public:
+        explicit Scope(std::string_view _name);
+        ~Scope();
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+
+      private:
+        std::string_view name_;
+        clock::time_point start_;
+    };
+
+    /// Enables recording; the trace is written to the given file path upon finish().
+    static void enable(std::string _filePath);
+
+    [[nodiscard]] static bool enabled() noexcept;
+
+    /// Records a named phase that started and ended at the given times.
+    static void record(std::string_view _name, clock::time_point _start, clock::time_point _end);
+
+    /// Records a named point in time, such as the first frame being presented.
+    static void mark(std::string_view _name);
+
+    /// Writes all recorded events to the trace file and disables further recording.
+    static void finish();
+};
+
+} // namespace crispy
@@ -0,0 +1,111 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/StrongHash.h>
+
+#if defined(__x86_64__) && defined(CRISPY_STRONG_HASH_AES) && (defined(__GNUC__) || defined(__clang__))
+    #define CRISPY_STRONG_HASH_VAES 1
+#endif
+
+namespace crispy::detail
+{
+
+namespace
+{
+    // Initial lane states, so that equal chunks in different lanes do not cancel each other out.
+    void initializeLanes(__m128i hash, __m128i (&lanes)[4]) noexcept
+    {
+        for (int i = 0; i < 4; ++i)
+            lanes[i] = _mm_xor_si128(hash, _mm_set_epi32(0, 0, 0, i));
+    }
+
+    __m128i foldLanes(__m128i const (&lanes)[4]) noexcept
+    {
+        auto hash = lanes[0];
+        for (int i = 1; i < 4; ++i)
+            hash = mixChunk(hash, lanes[i]);
+        return hash;
+    }
+
+#if defined(CRISPY_STRONG_HASH_VAES)
+    __attribute__((target("avx2,vaes"))) __m128i hashBlocksVAES(__m128i hash,
+                                                                 void const* data,
+                                                                 size_t blockCount) noexcept
+    {
+        __m128i lanes[4];
+        initializeLanes(hash, lanes);
+
+        auto const zero = _mm256_setzero_si256();
+        auto lo = _mm256_set_m128i(lanes[1], lanes[0]);
+        auto hi = _mm256_set_m128i(lanes[3], lanes[2]);
+
+        auto const* input = static_cast<char const*>(data);
+        for (size_t i = 0; i < blockCount; ++i, input += HashBlockSize)
+        {
+            lo = _mm256_xor_si256(lo, _mm256_loadu_si256((__m256i const*) input));
+            hi = _mm256_xor_si256(hi, _mm256_loadu_si256((__m256i const*) (input + 32)));
+            lo = _mm256_aesdec_epi128(lo, zero);
+            hi = _mm256_aesdec_epi128(hi, zero);
+            lo = _mm256_aesdec_epi128(lo, zero);
+            hi = _mm256_aesdec_epi128(hi, zero);
+            lo = _mm256_aesdec_epi128(lo, zero);
+            hi = _mm256_aesdec_epi128(hi, zero);
+            lo = _mm256_aesdec_epi128(lo, zero);
+            hi = _mm256_aesdec_epi128(hi, zero);
+        }
+
+        lanes[0] = _mm256_castsi256_si128(lo);
+        lanes[1] = _mm256_extracti128_si256(lo, 1);
+        lanes[2] = _mm256_castsi256_si128(hi);
+        lanes[3] = _mm256_extracti128_si256(hi, 1);
+        return foldLanes(lanes);
+    }
+#endif
+
+    using HashBlocksFn = __m128i (*)(__m128i, void const*, size_t) noexcept;
+
+    HashBlocksFn selectHashBlocks() noexcept
+    {
+#if defined(CRISPY_STRONG_HASH_VAES)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("vaes"))
+            return &hashBlocksVAES;
+#endif
+        return &hashBlocksGeneric;
+    }
+} // namespace
+
+__m128i hashBlocksGeneric(__m128i hash, void const* data, size_t blockCount) noexcept
+{
+    __m128i lanes[4];
+    initializeLanes(hash, lanes);
+
+    auto const* input = static_cast<char const*>(data);
+    for (size_t i = 0; i < blockCount; ++i, input += HashBlockSize)
+    {
+        lanes[0] = mixChunk(lanes[0], _mm_loadu_si128((__m128i const*) input));
+        lanes[1] = mixChunk(lanes[1], _mm_loadu_si128((__m128i const*) (input + 16)));
+        lanes[2] = mixChunk(lanes[2], _mm_loadu_si128((__m128i const*) (input + 32)));
+        lanes[3] = mixChunk(lanes[3], _mm_loadu_si128((__m128i const*) (input + 48)));
+    }
+
+    return foldLanes(lanes);
+}
+
+__m128i hashBlocks(__m128i hash, void const* data, size_t blockCount) noexcept
+{
+    static HashBlocksFn const impl = selectHashBlocks();
+    return impl(hash, data, blockCount);
+}
+
+} // namespace crispy::detail
@@ -26,28 +26,90 @@
 
     #if defined(__AES__)
         #include <wmmintrin.h>
+        #define CRISPY_STRONG_HASH_AES 1
     #endif
 #elif defined(__aarch64__)
     #include <crispy/sse2neon.h>
-    // The following inline functions were borrowed from:
-    // https://github.com/f1ed/emp/blob/master/emp-tool/utils/block.h
-    inline __m128i _mm_aesimc_si128(__m128i a) noexcept
+
+    #if defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO)
+        #define CRISPY_STRONG_HASH_AES 1
+    #endif
+#endif
+
+namespace crispy
+{
+
+// {{{ details
+namespace detail
+{
+#if defined(CRISPY_STRONG_HASH_AES)
+    // Performs one AES decryption round with an all-zero round key, i.e. _mm_aesdec_si128(v, 0).
+    inline __m128i aesDecryptRound(__m128i v) noexcept
     {
-        return vreinterpretq_m128i_u8(vaesimcq_u8(vreinterpretq_u8_m128i(a)));
+    #if defined(__aarch64__)
+        // AESD applies the round key before the inverse cipher steps rather than after,
+        // so with a zero key, AESIMC(AESD(v, 0)) is exactly what x86's AESDEC computes.
+        return vreinterpretq_m128i_u8(vaesimcq_u8(vaesdq_u8(vreinterpretq_u8_m128i(v), vdupq_n_u8(0))));
+    #else
+        return _mm_aesdec_si128(v, _mm_setzero_si128());
+    #endif
     }
-    inline __m128i _mm_aesdec_si128 (__m128i a, __m128i RoundKey) noexcept
+#endif
+
+    // Multiplies the 32-bit lanes of a and b, keeping the lower 32 bits of each product (SSE2 only).
+    inline __m128i multiplyLanes(__m128i a, __m128i b) noexcept
     {
-        return vreinterpretq_m128i_u8(vaesimcq_u8(vaesdq_u8(vreinterpretq_u8_m128i(a), vdupq_n_u8(0)) ^ vreinterpretq_u8_m128i(RoundKey)));
+        auto const even = _mm_mul_epu32(a, b);
+        auto const odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
     }
 
-    inline __m128i _mm_aesdeclast_si128 (__m128i a, __m128i RoundKey) noexcept
+    // Integer mixing round for targets without AES instructions:
+    // a 32-bit finalizer on each lane, followed by adding the neighbouring lane for cross-lane diffusion.
+    inline __m128i softwareMixRound(__m128i v) noexcept
     {
-        return vreinterpretq_m128i_u8(vaesdq_u8(vreinterpretq_u8_m128i(a), vdupq_n_u8(0)) ^ vreinterpretq_u8_m128i(RoundKey));
+        v = _mm_xor_si128(v, _mm_srli_epi32(v, 16));
+        v = multiplyLanes(v, _mm_set1_epi32(0x7feb352d));
+        v = _mm_xor_si128(v, _mm_srli_epi32(v, 15));
+        v = multiplyLanes(v, _mm_set1_epi32(static_cast<int>(0x846ca68bu)));
+        v = _mm_xor_si128(v, _mm_srli_epi32(v, 16));
+        return _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 3, 2, 1)));
     }
+
+    // Folds a 16-byte chunk into the given hash value.
+    inline __m128i mixChunk(__m128i hash, __m128i chunk) noexcept
+    {
+        hash = _mm_xor_si128(hash, chunk);
+#if defined(CRISPY_STRONG_HASH_AES)
+        hash = aesDecryptRound(hash);
+        hash = aesDecryptRound(hash);
+        hash = aesDecryptRound(hash);
+        hash = aesDecryptRound(hash);
+#else
+        hash = softwareMixRound(hash);
+        hash = softwareMixRound(hash);
+        hash = softwareMixRound(hash);
+        hash = softwareMixRound(hash);
 #endif
+        return hash;
+    }
 
-namespace crispy
-{
+    // Number of bytes hashBlocks() consumes per iteration, as four independent 16-byte lanes.
+    constexpr size_t HashBlockSize = 64;
+
+    // Folds blockCount blocks of HashBlockSize bytes into the given hash value.
+    //
+    // The four lanes of a block are hashed in independent chains and only combined at the end,
+    // so that the AES rounds of different lanes can overlap in the pipeline.
+    // Dispatches at runtime to an AVX2/VAES implementation, if the CPU supports it,
+    // with identical results.
+    __m128i hashBlocks(__m128i hash, void const* data, size_t blockCount) noexcept;
+
+    // Portable implementation of hashBlocks(), without runtime dispatch.
+    __m128i hashBlocksGeneric(__m128i hash, void const* data, size_t blockCount) noexcept;
+} // namespace detail
+// }}}
 
 struct StrongHash
 {
@@ -103,16 +165,7 @@ inline bool operator!=(StrongHash a, StrongHash b) noexcept
 
 inline StrongHash operator*(StrongHash const& a, StrongHash const& b) noexcept
 {
-    // TODO AES-NI fallback
-    __m128i hashValue = a.value;
-
-    hashValue = _mm_xor_si128(hashValue, b.value);
-    hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-    hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-    hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-    hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-
-    return StrongHash { hashValue };
+    return StrongHash { detail::mixChunk(a.value, b.value) };
 }
 
 inline StrongHash operator*(StrongHash a, uint32_t b) noexcept
@@ -150,39 +203,31 @@ StrongHash StrongHash::compute(T const& value) noexcept
 
 inline StrongHash StrongHash::compute(void const* data, size_t n) noexcept
 {
-    // TODO AES-NI fallback
-
     static_assert(sizeof(__m128i) == 16);
-    auto constexpr ChunkSize = static_cast<int>(sizeof(__m128i));
+    auto constexpr ChunkSize = sizeof(__m128i);
 
     __m128i hashValue = _mm_cvtsi64_si128(static_cast<long long>(n));
     hashValue = _mm_xor_si128(hashValue, _mm_loadu_si128((__m128i const*) DefaultSeed.data()));
 
     char const* inputPtr = (char const*) data;
-    for (int chunkIndex = 0; chunkIndex < static_cast<int>(n) / ChunkSize; chunkIndex++)
+    if (auto const blockCount = n / detail::HashBlockSize; blockCount != 0)
     {
-        __m128i chunk = _mm_loadu_si128((__m128i const*) inputPtr);
-
-        hashValue = _mm_xor_si128(hashValue, chunk);
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
+        hashValue = detail::hashBlocks(hashValue, inputPtr, blockCount);
+        inputPtr += blockCount * detail::HashBlockSize;
+    }
 
+    auto const remainingByteCount = n % detail::HashBlockSize;
+    for (size_t chunkIndex = 0; chunkIndex < remainingByteCount / ChunkSize; chunkIndex++)
+    {
+        hashValue = detail::mixChunk(hashValue, _mm_loadu_si128((__m128i const*) inputPtr));
         inputPtr += ChunkSize;
     }
 
-    auto const remainingByteCount = n % ChunkSize;
-    if (remainingByteCount)
+    if (auto const tailByteCount = n % ChunkSize; tailByteCount != 0)
     {
         char lastChunk[ChunkSize] { 0 };
-        std::memcpy(lastChunk + ChunkSize - remainingByteCount, inputPtr, remainingByteCount);
-        __m128i chunk = _mm_loadu_si128((__m128i*) lastChunk);
-        hashValue = _mm_xor_si128(hashValue, chunk);
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
-        hashValue = _mm_aesdec_si128(hashValue, _mm_setzero_si128());
+        std::memcpy(lastChunk + ChunkSize - tailByteCount, inputPtr, tailByteCount);
+        hashValue = detail::mixChunk(hashValue, _mm_loadu_si128((__m128i const*) lastChunk));
     }
 
     return StrongHash { hashValue };
@@ -262,6 +307,18 @@ struct StrongHasher<std::basic_string_view<U>>
 
 } // namespace crispy
 
+namespace std
+{
+template <>
+struct hash<crispy::StrongHash>
+{
+    size_t operator()(crispy::StrongHash const& _hash) const noexcept
+    {
+        return static_cast<uint32_t>(crispy::to_integer(_hash));
+    }
+};
+} // namespace std
+
 namespace fmt
 {
 template <>
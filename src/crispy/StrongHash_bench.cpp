@@ -0,0 +1,60 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/StrongHash.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+using crispy::StrongHash;
+
+static void BM_StrongHash_compute(benchmark::State& state)
+{
+    auto const text = std::string(static_cast<size_t>(state.range(0)), 'x');
+    for (auto _: state)
+        benchmark::DoNotOptimize(StrongHash::compute(text));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StrongHash_compute)->RangeMultiplier(4)->Range(4, 4096);
+
+static void BM_StrongHash_compute_u32(benchmark::State& state)
+{
+    auto const text = std::u32string(static_cast<size_t>(state.range(0)), U'x');
+    for (auto _: state)
+        benchmark::DoNotOptimize(StrongHash::compute(text));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 4);
+}
+BENCHMARK(BM_StrongHash_compute_u32)->RangeMultiplier(4)->Range(1, 1024);
+
+static void BM_StrongHash_compute_bytes(benchmark::State& state)
+{
+    auto const data = std::vector<char>(static_cast<size_t>(state.range(0)), 'x');
+    for (auto _: state)
+        benchmark::DoNotOptimize(StrongHash::compute(data.data(), data.size()));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StrongHash_compute_bytes)->RangeMultiplier(8)->Range(16, 1 << 18);
+
+// Bulk hashing without runtime dispatch, for comparison with the AVX2/VAES path taken by compute().
+static void BM_StrongHash_hashBlocksGeneric(benchmark::State& state)
+{
+    auto const data = std::vector<char>(static_cast<size_t>(state.range(0)), 'x');
+    auto const blockCount = data.size() / crispy::detail::HashBlockSize;
+    for (auto _: state)
+        benchmark::DoNotOptimize(
+            crispy::detail::hashBlocksGeneric(_mm_setzero_si128(), data.data(), blockCount));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StrongHash_hashBlocksGeneric)->RangeMultiplier(8)->Range(64, 1 << 18);
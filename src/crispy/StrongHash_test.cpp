@@ -0,0 +1,107 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/StrongHash.h>
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <vector>
+
+using namespace crispy;
+using namespace std;
+
+namespace
+{
+vector<char> makeInput(size_t n)
+{
+    auto data = vector<char>(n);
+    for (size_t i = 0; i < n; ++i)
+        data[i] = static_cast<char>((i * 131) ^ (i >> 3));
+    return data;
+}
+
+bool equal(__m128i a, __m128i b) noexcept
+{
+    return StrongHash { a } == StrongHash { b };
+}
+} // namespace
+
+TEST_CASE("StrongHash.compute.deterministic")
+{
+    for (size_t const n: { 0u, 1u, 15u, 16u, 17u, 63u, 64u, 65u, 200u, 4096u })
+    {
+        INFO("n = " << n);
+        auto const data = makeInput(n);
+        CHECK(StrongHash::compute(data.data(), n) == StrongHash::compute(data.data(), n));
+    }
+}
+
+TEST_CASE("StrongHash.compute.every_byte_matters")
+{
+    // Covers bytes in the 64-byte block part, in the 16-byte chunk part and in the tail.
+    auto constexpr N = size_t { 64 * 3 + 16 * 2 + 7 };
+    auto data = makeInput(N);
+    auto const reference = StrongHash::compute(data.data(), N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        INFO("i = " << i);
+        data[i] ^= 1;
+        CHECK(StrongHash::compute(data.data(), N) != reference);
+        data[i] ^= 1;
+    }
+}
+
+TEST_CASE("StrongHash.compute.lane_order_matters")
+{
+    // Swapping two 16-byte lanes of a block must change the hash.
+    auto data = makeInput(64);
+    auto const reference = StrongHash::compute(data.data(), data.size());
+    char tmp[16];
+    std::memcpy(tmp, data.data(), 16);
+    std::memcpy(data.data(), data.data() + 16, 16);
+    std::memcpy(data.data() + 16, tmp, 16);
+    CHECK(StrongHash::compute(data.data(), data.size()) != reference);
+}
+
+TEST_CASE("StrongHash.hashBlocks.dispatch")
+{
+    // Whichever implementation is dispatched to must match the portable one.
+    auto const seed = StrongHash::compute("seed").value;
+    for (size_t const blockCount: { 1u, 2u, 3u, 17u })
+    {
+        INFO("blockCount = " << blockCount);
+        auto const data = makeInput(blockCount * detail::HashBlockSize);
+        CHECK(equal(detail::hashBlocks(seed, data.data(), blockCount),
+                    detail::hashBlocksGeneric(seed, data.data(), blockCount)));
+    }
+}
+
+TEST_CASE("StrongHash.softwareMixRound")
+{
+    auto const a = _mm_set_epi32(0, 0, 0, 1);
+    auto const b = _mm_set_epi32(0, 0, 0, 2);
+    CHECK(!equal(detail::softwareMixRound(a), detail::softwareMixRound(b)));
+    CHECK(!equal(detail::softwareMixRound(_mm_setzero_si128()), detail::softwareMixRound(a)));
+
+    // multiplyLanes() must match scalar 32-bit multiplication in every lane.
+    auto const x = _mm_set_epi32(3, -7, 0x12345678, static_cast<int>(0xFFFFFFFFu));
+    auto const y = _mm_set1_epi32(0x7feb352d);
+    uint32_t xs[4];
+    uint32_t products[4];
+    std::memcpy(xs, &x, sizeof(xs));
+    auto const z = detail::multiplyLanes(x, y);
+    std::memcpy(products, &z, sizeof(products));
+    for (int i = 0; i < 4; ++i)
+        CHECK(products[i] == xs[i] * 0x7feb352du);
+}
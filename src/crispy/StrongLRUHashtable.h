@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include <crispy/CacheRegistry.h>
 #include <crispy/StrongHash.h>
 #include <crispy/assert.h>
 #include <crispy/utils.h>
@@ -136,6 +137,10 @@ class StrongLRUHashtable
     /// counting from zero again.
     LRUHashtableStats fetchAndClearStats() noexcept;
 
+    /// Returns the stats accumulated since construction, regardless of fetchAndClearStats(),
+    /// along with this hashtable's name, size, capacity and storage size.
+    [[nodiscard]] CacheReport report() const;
+
     /// Clears all entries from the hashtable.
     void clear();
 
@@ -273,6 +278,8 @@ class StrongLRUHashtable
     // }}}
 
     LRUHashtableStats _stats;
+    CacheReport _clearedStats; // stats already handed out via fetchAndClearStats()
+    CacheRegistry::Id _registryId;
     uint32_t _hashMask;
     StrongHashtableSize _hashCount;
     uint32_t _size;
@@ -295,6 +302,8 @@ StrongLRUHashtable<Value>::StrongLRUHashtable(StrongHashtableSize hashCount,
                                               LRUCapacity entryCount,
                                               std::string name):
     _stats {},
+    _clearedStats {},
+    _registryId { 0 },
     _hashMask { hashCount.value - 1 },
     _hashCount { hashCount },
     _size { 0 },
@@ -324,11 +333,17 @@ StrongLRUHashtable<Value>::StrongLRUHashtable(StrongHashtableSize hashCount,
         new (entry) Entry(NextWithSameHash(entryIndex + 1));
     }
     new (_entries + entryCount.value) Entry(NextWithSameHash(0));
+
+    // The object never moves (see create()), so it is safe to capture this here.
+    if (!_name.empty())
+        _registryId = CacheRegistry::get().add([this]() { return report(); });
 }
 
 template <typename Value>
 StrongLRUHashtable<Value>::~StrongLRUHashtable()
 {
+    if (_registryId)
+        CacheRegistry::get().remove(_registryId);
     std::destroy_n(_entries, 1 + _capacity.value);
 }
 
@@ -418,10 +433,27 @@ template <typename Value>
 LRUHashtableStats StrongLRUHashtable<Value>::fetchAndClearStats() noexcept
 {
     auto st = _stats;
+    _clearedStats.hits += st.hits;
+    _clearedStats.misses += st.misses;
+    _clearedStats.evictions += st.recycles;
     _stats = LRUHashtableStats {};
     return st;
 }
 
+template <typename Value>
+CacheReport StrongLRUHashtable<Value>::report() const
+{
+    auto result = CacheReport {};
+    result.name = _name;
+    result.size = size();
+    result.capacity = capacity();
+    result.storageSize = storageSize();
+    result.hits = _clearedStats.hits + _stats.hits;
+    result.misses = _clearedStats.misses + _stats.misses;
+    result.evictions = _clearedStats.evictions + _stats.recycles;
+    return result;
+}
+
 template <typename Value>
 void StrongLRUHashtable<Value>::clear()
 {
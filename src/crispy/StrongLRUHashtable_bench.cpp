@@ -0,0 +1,146 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/StrongLRUHashtable.h>
+#include <crispy/StrongSetAssociativeHashtable.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using crispy::LRUCapacity;
+using crispy::StrongHash;
+using crispy::StrongHashtableSize;
+using crispy::StrongLRUHashtable;
+using crispy::StrongSetAssociativeHashtable;
+
+namespace
+{
+// Creates a sequence of hashes of keys out of the given key space, following a Zipf distribution
+// with the given exponent, i.e. alike the glyphs being looked up in a text shaping cache.
+std::vector<StrongHash> zipfHashes(size_t _count, uint32_t _keySpace, double _exponent)
+{
+    auto cdf = std::vector<double>(_keySpace);
+    auto sum = 0.0;
+    for (uint32_t k = 0; k < _keySpace; ++k)
+    {
+        sum += 1.0 / std::pow(static_cast<double>(k + 1), _exponent);
+        cdf[k] = sum;
+    }
+
+    auto rng = std::mt19937 { 42 };
+    auto uniform = std::uniform_real_distribution<double> { 0.0, sum };
+    auto hashes = std::vector<StrongHash> {};
+    hashes.reserve(_count);
+    for (size_t i = 0; i < _count; ++i)
+    {
+        auto const key = static_cast<uint32_t>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng))
+                                               - cdf.begin());
+        hashes.emplace_back(StrongHash::compute(key));
+    }
+    return hashes;
+}
+} // namespace
+
+// Arguments: cache capacity, Zipf exponent (in hundredths).
+static void BM_StrongLRUHashtable_get_or_emplace_zipf(benchmark::State& state)
+{
+    auto const capacity = static_cast<uint32_t>(state.range(0));
+    auto const exponent = static_cast<double>(state.range(1)) / 100.0;
+    auto const hashes = zipfHashes(1 << 16, 1 << 16, exponent);
+
+    auto cache =
+        StrongLRUHashtable<int>::create(StrongHashtableSize { capacity * 4 }, LRUCapacity { capacity });
+
+    auto i = size_t { 0 };
+    for (auto _: state)
+    {
+        benchmark::DoNotOptimize(cache->get_or_emplace(hashes[i], [](auto) { return 42; }));
+        i = (i + 1) % hashes.size();
+    }
+
+    auto const stats = cache->fetchAndClearStats();
+    state.counters["hit_rate"] =
+        static_cast<double>(stats.hits) / static_cast<double>(std::max(stats.hits + stats.misses, 1u));
+}
+BENCHMARK(BM_StrongLRUHashtable_get_or_emplace_zipf)
+    ->ArgsProduct({ { 256, 4096 }, { 80, 100, 120 } })
+    ->ArgNames({ "capacity", "zipf" });
+
+static void BM_StrongLRUHashtable_hit(benchmark::State& state)
+{
+    auto constexpr Capacity = 1024u;
+    auto cache =
+        StrongLRUHashtable<int>::create(StrongHashtableSize { Capacity * 4 }, LRUCapacity { Capacity });
+    auto hashes = std::vector<StrongHash> {};
+    for (uint32_t k = 0; k < Capacity; ++k)
+    {
+        hashes.emplace_back(StrongHash::compute(k));
+        cache->emplace(hashes.back(), static_cast<int>(k));
+    }
+
+    auto i = size_t { 0 };
+    for (auto _: state)
+    {
+        benchmark::DoNotOptimize(cache->try_get(hashes[i]));
+        i = (i + 1) % hashes.size();
+    }
+}
+BENCHMARK(BM_StrongLRUHashtable_hit);
+
+// Same workload as BM_StrongLRUHashtable_get_or_emplace_zipf, for comparing hit rate and lookup cost.
+static void BM_StrongSetAssociativeHashtable_get_or_emplace_zipf(benchmark::State& state)
+{
+    auto const capacity = static_cast<uint32_t>(state.range(0));
+    auto const exponent = static_cast<double>(state.range(1)) / 100.0;
+    auto const hashes = zipfHashes(1 << 16, 1 << 16, exponent);
+
+    auto cache = StrongSetAssociativeHashtable<int>::create(LRUCapacity { capacity });
+
+    auto i = size_t { 0 };
+    for (auto _: state)
+    {
+        benchmark::DoNotOptimize(cache->get_or_emplace(hashes[i], [](auto) { return 42; }));
+        i = (i + 1) % hashes.size();
+    }
+
+    auto const stats = cache->fetchAndClearStats();
+    state.counters["hit_rate"] =
+        static_cast<double>(stats.hits) / static_cast<double>(std::max(stats.hits + stats.misses, 1u));
+}
+BENCHMARK(BM_StrongSetAssociativeHashtable_get_or_emplace_zipf)
+    ->ArgsProduct({ { 256, 4096 }, { 80, 100, 120 } })
+    ->ArgNames({ "capacity", "zipf" });
+
+static void BM_StrongSetAssociativeHashtable_hit(benchmark::State& state)
+{
+    auto constexpr Capacity = 1024u;
+    auto cache = StrongSetAssociativeHashtable<int>::create(LRUCapacity { Capacity * 2 });
+    auto hashes = std::vector<StrongHash> {};
+    for (uint32_t k = 0; k < Capacity; ++k)
+    {
+        hashes.emplace_back(StrongHash::compute(k));
+        cache->emplace(hashes.back(), static_cast<int>(k));
+    }
+
+    auto i = size_t { 0 };
+    for (auto _: state)
+    {
+        benchmark::DoNotOptimize(cache->try_get(hashes[i]));
+        i = (i + 1) % hashes.size();
+    }
+}
+BENCHMARK(BM_StrongSetAssociativeHashtable_hit);
@@ -16,6 +16,7 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <string_view>
 
@@ -422,3 +423,43 @@ TEST_CASE("StrongLRUHashtable.peek", "")
         REQUIRE(joinHumanReadable(cache.hashes()) == sh(4, 3, 2, 1));
     }
 }
+
+TEST_CASE("StrongLRUHashtable.CacheRegistry", "[lrucache]")
+{
+    auto const countNamed = [](string_view name) {
+        auto const reports = CacheRegistry::get().reports();
+        return count_if(reports.begin(), reports.end(), [&](auto const& r) { return r.name == name; });
+    };
+
+    {
+        auto cachePtr = StrongLRUHashtable<int>::create(StrongHashtableSize { 4 }, LRUCapacity { 2 }, "test");
+        auto& cache = *cachePtr;
+        REQUIRE(countNamed("test") == 1);
+
+        cache.get_or_emplace(h(2), [](auto) { return 4; }); // miss
+        cache.get_or_emplace(h(2), [](auto) { return 4; }); // hit
+        auto const stats = cache.fetchAndClearStats();
+        CHECK(stats.hits == 1);
+        CHECK(stats.misses == 1);
+
+        cache.get_or_emplace(h(3), [](auto) { return 6; }); // miss
+        cache.get_or_emplace(h(4), [](auto) { return 8; }); // miss, evicts h(2)
+
+        // The report is cumulative, i.e. not affected by fetchAndClearStats().
+        auto const report = cache.report();
+        CHECK(report.name == "test");
+        CHECK(report.size == 2);
+        CHECK(report.capacity == 2);
+        CHECK(report.storageSize == cache.storageSize());
+        CHECK(report.hits == 1);
+        CHECK(report.misses == 3);
+        CHECK(report.evictions == 1);
+    }
+
+    CHECK(countNamed("test") == 0);
+
+    // Anonymous caches are not registered.
+    auto const before = CacheRegistry::get().reports().size();
+    auto anonymous = StrongLRUHashtable<int>::create(StrongHashtableSize { 4 }, LRUCapacity { 2 });
+    CHECK(CacheRegistry::get().reports().size() == before);
+}
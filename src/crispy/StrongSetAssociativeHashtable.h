@@ -0,0 +1,491 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/CacheRegistry.h>
+#include <crispy/StrongHash.h>
+#include <crispy/StrongLRUHashtable.h>
+#include <crispy/assert.h>
+#include <crispy/utils.h>
+
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__)
+    #include <immintrin.h>
+#elif defined(__aarch64__)
+    #include <crispy/sse2neon.h>
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace crispy
+{
+
+// {{{ details
+namespace detail
+{
+    inline uint32_t countTrailingZeroBits(uint32_t value) noexcept
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward(&index, value);
+        return static_cast<uint32_t>(index);
+#else
+        return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+    }
+} // namespace detail
+// }}}
+
+/// Set-associative hashtable, keyed by StrongHash, with approximate LRU (CLOCK) eviction.
+///
+/// Unlike StrongLRUHashtable, a lookup does not chase a collision chain:
+/// the hash selects exactly one bucket of @p Ways slots, and the bucket holds nothing but
+/// a 32-bit tag per slot along with the occupancy and CLOCK state, all within one cache line.
+/// The slots' full hashes and values live in a separate entry table, so that a lookup touches
+/// the tag bucket plus (on a tag match) exactly one entry.
+///
+/// When a bucket is full, the CLOCK hand of that bucket selects the victim:
+/// recently referenced slots get a second chance, the first unreferenced one is evicted.
+///
+/// Entry indices passed to value constructors are stable for as long as the entry is not evicted,
+/// but are zero-based, as opposed to StrongLRUHashtable.
+template <typename Value, uint32_t Ways = 8>
+class StrongSetAssociativeHashtable
+{
+    static_assert(Ways == 4 || Ways == 8, "Only 4-way and 8-way buckets are supported.");
+
+  public:
+    using Ptr = std::unique_ptr<StrongSetAssociativeHashtable>;
+
+    StrongSetAssociativeHashtable(LRUCapacity entryCount, std::string name);
+    ~StrongSetAssociativeHashtable();
+
+    StrongSetAssociativeHashtable(StrongSetAssociativeHashtable const&) = delete;
+    StrongSetAssociativeHashtable(StrongSetAssociativeHashtable&&) = delete;
+    StrongSetAssociativeHashtable& operator=(StrongSetAssociativeHashtable const&) = delete;
+    StrongSetAssociativeHashtable& operator=(StrongSetAssociativeHashtable&&) = delete;
+
+    /// Constructs a hashtable that can hold at least @p entryCount entries.
+    ///
+    /// The capacity is rounded up to a power of two number of buckets.
+    static Ptr create(LRUCapacity entryCount, std::string name = "");
+
+    /// Returns the actual number of entries currently hold in this hashtable.
+    [[nodiscard]] size_t size() const noexcept { return _size; }
+
+    /// Returns the maximum number of entries that can be stored in this hashtable.
+    [[nodiscard]] size_t capacity() const noexcept { return _entries.size(); }
+
+    /// Returns the number of buckets, each of which holds up to Ways entries.
+    [[nodiscard]] size_t bucketCount() const noexcept { return _buckets.size(); }
+
+    /// Returns the total storage sized used by this object.
+    [[nodiscard]] size_t storageSize() const noexcept;
+
+    /// Returns gathered stats and clears the local stats state to start
+    /// counting from zero again.
+    LRUHashtableStats fetchAndClearStats() noexcept;
+
+    /// Returns the stats accumulated since construction, regardless of fetchAndClearStats(),
+    /// along with this hashtable's name, size, capacity and storage size.
+    [[nodiscard]] CacheReport report() const;
+
+    /// Clears all entries from the hashtable.
+    void clear();
+
+    // Deletes the hash entry and its associated value from the hashtable.
+    void remove(StrongHash const& hash);
+
+    /// Tests for the exitence of the given hash key in this hash table.
+    [[nodiscard]] bool contains(StrongHash const& hash) const noexcept;
+
+    /// Returns the value for the given hash key if found, nullptr otherwise.
+    [[nodiscard]] Value* try_get(StrongHash const& hash) noexcept;
+    [[nodiscard]] Value const* try_get(StrongHash const& hash) const noexcept;
+
+    /// Returns the value for the given hash key,
+    /// throwing std::out_of_range if hash key was not found.
+    [[nodiscard]] Value& at(StrongHash const& hash);
+
+    /// Assignes the given value to the given hash key.
+    /// If the hash key was not found, it is being created,
+    /// otherwise the value will be re-assigned with the new value.
+    Value& emplace(StrongHash const& hash, Value value);
+
+    /// Always returns either the existing item by the given hash key, if found,
+    /// or a newly created one by invoking constructValue(entryIndex).
+    template <typename ValueConstructFn>
+    [[nodiscard]] Value& get_or_emplace(StrongHash const& hash, ValueConstructFn constructValue);
+
+    /// Like get_or_emplace but allows failure in @p constructValue (by returning std::nullopt)
+    /// to cause the hash entry not to be created, in which case nullptr is returned.
+    template <typename ValueConstructFn>
+    [[nodiscard]] Value* get_or_try_emplace(StrongHash const& hash, ValueConstructFn constructValue);
+
+    void inspect(std::ostream& output) const;
+
+    // {{{ public detail
+    // One cache line of tags. Slot i is in use iff bit i of occupied is set.
+    struct alignas(64) TagBucket
+    {
+        uint32_t tags[Ways] {};
+        uint8_t occupied = 0;
+        uint8_t referenced = 0; // CLOCK reference bits
+        uint8_t hand = 0;       // CLOCK hand, next slot to consider for eviction
+    };
+    static_assert(sizeof(TagBucket) == 64);
+
+    struct Entry
+    {
+        StrongHash hashValue {};
+        std::optional<Value> value = std::nullopt;
+    };
+    // }}}
+
+  private:
+    // {{{ details
+    static constexpr uint32_t AllSlots = (1u << Ways) - 1;
+
+    [[nodiscard]] uint32_t bucketIndexOf(StrongHash const& hash) const noexcept
+    {
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(hash.value)) & _bucketMask;
+    }
+
+    [[nodiscard]] static uint32_t tagOf(StrongHash const& hash) noexcept
+    {
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(hash.value, 4)));
+    }
+
+    // Returns a bit mask of the occupied slots in the given bucket whose tag matches.
+    [[nodiscard]] static uint32_t matchingSlots(TagBucket const& bucket, uint32_t tag) noexcept;
+
+    // Returns the entry index of the given hash, or -1 if not found, without updating any state.
+    [[nodiscard]] int findSlot(uint32_t bucketIndex, StrongHash const& hash) const noexcept;
+
+    // Marks the given slot as recently used.
+    void touchSlot(uint32_t bucketIndex, uint32_t entryIndex) noexcept;
+
+    // Returns the entry index of a slot in the given bucket to store the given hash in,
+    // evicting an older entry if the bucket is full.
+    uint32_t allocateSlot(uint32_t bucketIndex, StrongHash const& hash);
+
+    void releaseSlot(uint32_t bucketIndex, uint32_t entryIndex) noexcept;
+    // }}}
+
+    LRUHashtableStats _stats {};
+    CacheReport _clearedStats {}; // stats already handed out via fetchAndClearStats()
+    CacheRegistry::Id _registryId = 0;
+    uint32_t _bucketMask;
+    uint32_t _size = 0;
+    std::string _name;
+
+    std::vector<TagBucket> _buckets;
+    std::vector<Entry> _entries; // Ways entries per bucket, in bucket order.
+};
+
+// {{{ implementation
+template <typename Value, uint32_t Ways>
+StrongSetAssociativeHashtable<Value, Ways>::StrongSetAssociativeHashtable(LRUCapacity entryCount,
+                                                                          std::string name):
+    _bucketMask { 0 }, _name { std::move(name) }
+{
+    Require(entryCount.value >= 1);
+
+    auto bucketCount = (entryCount.value + Ways - 1) / Ways;
+    if (!detail::isPowerOfTwo(bucketCount))
+        bucketCount = nextPowerOfTwo(bucketCount);
+
+    _bucketMask = bucketCount - 1;
+    _buckets.resize(bucketCount);
+    _entries.resize(bucketCount * Ways);
+
+    // The object never moves (see create()), so it is safe to capture this here.
+    if (!_name.empty())
+        _registryId = CacheRegistry::get().add([this]() { return report(); });
+}
+
+template <typename Value, uint32_t Ways>
+StrongSetAssociativeHashtable<Value, Ways>::~StrongSetAssociativeHashtable()
+{
+    if (_registryId)
+        CacheRegistry::get().remove(_registryId);
+}
+
+template <typename Value, uint32_t Ways>
+auto StrongSetAssociativeHashtable<Value, Ways>::create(LRUCapacity entryCount, std::string name) -> Ptr
+{
+    return std::make_unique<StrongSetAssociativeHashtable>(entryCount, std::move(name));
+}
+
+template <typename Value, uint32_t Ways>
+size_t StrongSetAssociativeHashtable<Value, Ways>::storageSize() const noexcept
+{
+    return sizeof(StrongSetAssociativeHashtable) + _buckets.size() * sizeof(TagBucket)
+           + _entries.size() * sizeof(Entry);
+}
+
+template <typename Value, uint32_t Ways>
+LRUHashtableStats StrongSetAssociativeHashtable<Value, Ways>::fetchAndClearStats() noexcept
+{
+    auto st = _stats;
+    _clearedStats.hits += st.hits;
+    _clearedStats.misses += st.misses;
+    _clearedStats.evictions += st.recycles;
+    _stats = LRUHashtableStats {};
+    return st;
+}
+
+template <typename Value, uint32_t Ways>
+CacheReport StrongSetAssociativeHashtable<Value, Ways>::report() const
+{
+    auto result = CacheReport {};
+    result.name = _name;
+    result.size = size();
+    result.capacity = capacity();
+    result.storageSize = storageSize();
+    result.hits = _clearedStats.hits + _stats.hits;
+    result.misses = _clearedStats.misses + _stats.misses;
+    result.evictions = _clearedStats.evictions + _stats.recycles;
+    return result;
+}
+
+template <typename Value, uint32_t Ways>
+void StrongSetAssociativeHashtable<Value, Ways>::clear()
+{
+    for (TagBucket& bucket: _buckets)
+        bucket = TagBucket {};
+    for (Entry& entry: _entries)
+        entry.value.reset();
+    _size = 0;
+}
+
+template <typename Value, uint32_t Ways>
+void StrongSetAssociativeHashtable<Value, Ways>::remove(StrongHash const& hash)
+{
+    auto const bucketIndex = bucketIndexOf(hash);
+    auto const entryIndex = findSlot(bucketIndex, hash);
+    if (entryIndex >= 0)
+        releaseSlot(bucketIndex, static_cast<uint32_t>(entryIndex));
+}
+
+template <typename Value, uint32_t Ways>
+bool StrongSetAssociativeHashtable<Value, Ways>::contains(StrongHash const& hash) const noexcept
+{
+    return findSlot(bucketIndexOf(hash), hash) >= 0;
+}
+
+template <typename Value, uint32_t Ways>
+Value* StrongSetAssociativeHashtable<Value, Ways>::try_get(StrongHash const& hash) noexcept
+{
+    auto const bucketIndex = bucketIndexOf(hash);
+    auto const entryIndex = findSlot(bucketIndex, hash);
+    if (entryIndex < 0)
+    {
+        ++_stats.misses;
+        return nullptr;
+    }
+    ++_stats.hits;
+    touchSlot(bucketIndex, static_cast<uint32_t>(entryIndex));
+    return &*_entries[static_cast<size_t>(entryIndex)].value;
+}
+
+template <typename Value, uint32_t Ways>
+Value const* StrongSetAssociativeHashtable<Value, Ways>::try_get(StrongHash const& hash) const noexcept
+{
+    return const_cast<StrongSetAssociativeHashtable*>(this)->try_get(hash);
+}
+
+template <typename Value, uint32_t Ways>
+Value& StrongSetAssociativeHashtable<Value, Ways>::at(StrongHash const& hash)
+{
+    if (Value* value = try_get(hash))
+        return *value;
+    throw std::out_of_range("hash not in table");
+}
+
+template <typename Value, uint32_t Ways>
+Value& StrongSetAssociativeHashtable<Value, Ways>::emplace(StrongHash const& hash, Value value)
+{
+    auto const bucketIndex = bucketIndexOf(hash);
+    auto entryIndex = findSlot(bucketIndex, hash);
+    if (entryIndex >= 0)
+        touchSlot(bucketIndex, static_cast<uint32_t>(entryIndex));
+    else
+        entryIndex = static_cast<int>(allocateSlot(bucketIndex, hash));
+    return _entries[static_cast<size_t>(entryIndex)].value.emplace(std::move(value));
+}
+
+template <typename Value, uint32_t Ways>
+template <typename ValueConstructFn>
+Value& StrongSetAssociativeHashtable<Value, Ways>::get_or_emplace(StrongHash const& hash,
+                                                                  ValueConstructFn constructValue)
+{
+    auto const bucketIndex = bucketIndexOf(hash);
+    if (auto const entryIndex = findSlot(bucketIndex, hash); entryIndex >= 0)
+    {
+        ++_stats.hits;
+        touchSlot(bucketIndex, static_cast<uint32_t>(entryIndex));
+        return *_entries[static_cast<size_t>(entryIndex)].value;
+    }
+
+    ++_stats.misses;
+    auto const entryIndex = allocateSlot(bucketIndex, hash);
+    return _entries[entryIndex].value.emplace(constructValue(entryIndex)); // TODO: not yet exception safe
+}
+
+template <typename Value, uint32_t Ways>
+template <typename ValueConstructFn>
+Value* StrongSetAssociativeHashtable<Value, Ways>::get_or_try_emplace(StrongHash const& hash,
+                                                                      ValueConstructFn constructValue)
+{
+    auto const bucketIndex = bucketIndexOf(hash);
+    if (auto const entryIndex = findSlot(bucketIndex, hash); entryIndex >= 0)
+    {
+        ++_stats.hits;
+        touchSlot(bucketIndex, static_cast<uint32_t>(entryIndex));
+        return &*_entries[static_cast<size_t>(entryIndex)].value;
+    }
+
+    ++_stats.misses;
+    auto const entryIndex = allocateSlot(bucketIndex, hash);
+    std::optional<Value> constructedValue = constructValue(entryIndex);
+    if (!constructedValue)
+    {
+        releaseSlot(bucketIndex, entryIndex);
+        return nullptr;
+    }
+
+    _entries[entryIndex].value = std::move(constructedValue);
+    return &*_entries[entryIndex].value;
+}
+
+template <typename Value, uint32_t Ways>
+void StrongSetAssociativeHashtable<Value, Ways>::inspect(std::ostream& output) const
+{
+    auto fullBuckets = size_t { 0 };
+    for (TagBucket const& bucket: _buckets)
+        if (bucket.occupied == AllSlots)
+            ++fullBuckets;
+
+    output << fmt::format("=============================================================\n");
+    output << fmt::format("Hashtable: {}\n", _name);
+    output << fmt::format("-------------------------------------------------------------\n");
+    output << fmt::format("stats               : {}\n", _stats);
+    output << fmt::format(
+        "buckets             : {} x {} ways ({} full)\n", _buckets.size(), Ways, fullBuckets);
+    output << fmt::format("entry count         : {}\n", _size);
+    output << fmt::format("entry capacity      : {}\n", capacity());
+    output << fmt::format("-------------------------------------------------------------\n");
+}
+
+// {{{ helpers
+template <typename Value, uint32_t Ways>
+inline uint32_t StrongSetAssociativeHashtable<Value, Ways>::matchingSlots(TagBucket const& bucket,
+                                                                          uint32_t tag) noexcept
+{
+    auto const needle = _mm_set1_epi32(static_cast<int>(tag));
+    auto const lo = _mm_cmpeq_epi32(_mm_load_si128((__m128i const*) bucket.tags), needle);
+    auto mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(lo)));
+    if constexpr (Ways == 8)
+    {
+        auto const hi = _mm_cmpeq_epi32(_mm_load_si128((__m128i const*) (bucket.tags + 4)), needle);
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(hi))) << 4;
+    }
+    return mask & bucket.occupied;
+}
+
+template <typename Value, uint32_t Ways>
+inline int StrongSetAssociativeHashtable<Value, Ways>::findSlot(uint32_t bucketIndex,
+                                                                StrongHash const& hash) const noexcept
+{
+    auto candidates = matchingSlots(_buckets[bucketIndex], tagOf(hash));
+    while (candidates)
+    {
+        auto const way = detail::countTrailingZeroBits(candidates);
+        auto const entryIndex = bucketIndex * Ways + way;
+        if (_entries[entryIndex].hashValue == hash)
+            return static_cast<int>(entryIndex);
+        candidates &= candidates - 1;
+    }
+    return -1;
+}
+
+template <typename Value, uint32_t Ways>
+inline void StrongSetAssociativeHashtable<Value, Ways>::touchSlot(uint32_t bucketIndex,
+                                                                  uint32_t entryIndex) noexcept
+{
+    _buckets[bucketIndex].referenced |= static_cast<uint8_t>(1u << (entryIndex % Ways));
+}
+
+template <typename Value, uint32_t Ways>
+uint32_t StrongSetAssociativeHashtable<Value, Ways>::allocateSlot(uint32_t bucketIndex,
+                                                                 StrongHash const& hash)
+{
+    TagBucket& bucket = _buckets[bucketIndex];
+
+    uint32_t way = 0;
+    if (bucket.occupied != AllSlots)
+    {
+        way = detail::countTrailingZeroBits(~uint32_t(bucket.occupied) & AllSlots);
+        ++_size;
+    }
+    else
+    {
+        // CLOCK: give referenced slots a second chance, evict the first unreferenced one.
+        while (bucket.referenced & (1u << bucket.hand))
+        {
+            bucket.referenced &= static_cast<uint8_t>(~(1u << bucket.hand));
+            bucket.hand = static_cast<uint8_t>((bucket.hand + 1) % Ways);
+        }
+        way = bucket.hand;
+        bucket.hand = static_cast<uint8_t>((bucket.hand + 1) % Ways);
+        ++_stats.recycles;
+    }
+
+    auto const bit = static_cast<uint8_t>(1u << way);
+    bucket.tags[way] = tagOf(hash);
+    bucket.occupied |= bit;
+    bucket.referenced &= static_cast<uint8_t>(~bit);
+
+    auto const entryIndex = bucketIndex * Ways + way;
+    Entry& entry = _entries[entryIndex];
+    entry.hashValue = hash;
+    entry.value.reset();
+    return entryIndex;
+}
+
+template <typename Value, uint32_t Ways>
+void StrongSetAssociativeHashtable<Value, Ways>::releaseSlot(uint32_t bucketIndex,
+                                                             uint32_t entryIndex) noexcept
+{
+    TagBucket& bucket = _buckets[bucketIndex];
+    auto const bit = static_cast<uint8_t>(1u << (entryIndex % Ways));
+    Require(bucket.occupied & bit);
+    bucket.occupied &= static_cast<uint8_t>(~bit);
+    bucket.referenced &= static_cast<uint8_t>(~bit);
+    _entries[entryIndex].value.reset();
+    --_size;
+}
+// }}}
+
+// }}}
+
+} // namespace crispy
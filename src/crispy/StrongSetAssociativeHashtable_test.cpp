@@ -0,0 +1,151 @@
+/**
+ * This file is part of the "contour" project.
+ *   Copyright (c) 2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/StrongSetAssociativeHashtable.h>
+#include <crispy/utils.h>
+
+#include <catch2/catch.hpp>
+
+#include <optional>
+
+using namespace crispy;
+using namespace std;
+
+namespace
+{
+// Hashes that all map to the same bucket (lane 0 is the bucket index) but carry distinct tags.
+StrongHash sameBucket(uint32_t v) noexcept
+{
+    return StrongHash(0, 0, v, 0);
+}
+
+// Hashes that share bucket and tag, and only differ in the remaining bits.
+StrongHash sameTag(uint32_t v) noexcept
+{
+    return StrongHash(v, 0, 0, 0);
+}
+} // namespace
+
+TEST_CASE("nextPowerOfTwo")
+{
+    CHECK(nextPowerOfTwo(1u) == 1);
+    CHECK(nextPowerOfTwo(3u) == 4);
+    CHECK(nextPowerOfTwo(500u) == 512);
+    CHECK(nextPowerOfTwo(1025u) == 2048);
+    CHECK(nextPowerOfTwo(70000u) == 131072);
+}
+
+TEST_CASE("StrongSetAssociativeHashtable.create")
+{
+    auto cache = StrongSetAssociativeHashtable<int>::create(LRUCapacity { 4000 });
+    CHECK(cache->bucketCount() == 512);
+    CHECK(cache->capacity() == 4096);
+    CHECK(cache->size() == 0);
+    CHECK(sizeof(StrongSetAssociativeHashtable<int>::TagBucket) == 64);
+    CHECK(alignof(StrongSetAssociativeHashtable<int>::TagBucket) == 64);
+}
+
+TEST_CASE("StrongSetAssociativeHashtable.get_or_emplace")
+{
+    auto cache = StrongSetAssociativeHashtable<int>::create(LRUCapacity { 64 });
+    auto const a = StrongHash::compute("a");
+    auto const b = StrongHash::compute("b");
+
+    CHECK(cache->get_or_emplace(a, [](auto) { return 1; }) == 1);
+    CHECK(cache->get_or_emplace(b, [](auto) { return 2; }) == 2);
+    CHECK(cache->get_or_emplace(a, [](auto) { return 3; }) == 1);
+    CHECK(cache->size() == 2);
+    CHECK(cache->contains(a));
+    CHECK(!cache->contains(StrongHash::compute("c")));
+
+    auto const stats = cache->fetchAndClearStats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 2);
+    CHECK(stats.recycles == 0);
+}
+
+TEST_CASE("StrongSetAssociativeHashtable.tag_collision")
+{
+    auto cache = StrongSetAssociativeHashtable<int>::create(LRUCapacity { 64 });
+    cache->emplace(sameTag(1), 1);
+    cache->emplace(sameTag(2), 2);
+    CHECK(cache->size() == 2);
+    CHECK(*cache->try_get(sameTag(1)) == 1);
+    CHECK(*cache->try_get(sameTag(2)) == 2);
+    CHECK(cache->try_get(sameTag(3)) == nullptr);
+}
+
+TEST_CASE("StrongSetAssociativeHashtable.clock_eviction")
+{
+    auto cache = StrongSetAssociativeHashtable<int, 4>::create(LRUCapacity { 4 });
+    REQUIRE(cache->bucketCount() == 1);
+
+    for (uint32_t i = 1; i <= 4; ++i)
+        cache->emplace(sameBucket(i), static_cast<int>(i));
+    CHECK(cache->size() == 4);
+
+    // Reference all but the second entry, which thus is the one to be evicted.
+    (void) cache->try_get(sameBucket(1));
+    (void) cache->try_get(sameBucket(3));
+    (void) cache->try_get(sameBucket(4));
+
+    cache->emplace(sameBucket(5), 5);
+    CHECK(cache->size() == 4);
+    CHECK(cache->contains(sameBucket(1)));
+    CHECK(!cache->contains(sameBucket(2)));
+    CHECK(cache->contains(sameBucket(3)));
+    CHECK(cache->contains(sameBucket(4)));
+    CHECK(cache->contains(sameBucket(5)));
+
+    // The first entry's reference bit was cleared by the previous sweep, so after giving the third
+    // and fourth entry another chance, the hand wraps around and evicts the first one.
+    cache->emplace(sameBucket(6), 6);
+    CHECK(!cache->contains(sameBucket(1)));
+    CHECK(cache->contains(sameBucket(3)));
+    CHECK(cache->contains(sameBucket(4)));
+    CHECK(cache->fetchAndClearStats().recycles == 2);
+}
+
+TEST_CASE("StrongSetAssociativeHashtable.remove")
+{
+    auto cache = StrongSetAssociativeHashtable<int>::create(LRUCapacity { 8 });
+    cache->emplace(sameBucket(1), 1);
+    cache->emplace(sameBucket(2), 2);
+    cache->remove(sameBucket(1));
+    CHECK(cache->size() == 1);
+    CHECK(!cache->contains(sameBucket(1)));
+    CHECK(cache->contains(sameBucket(2)));
+
+    cache->remove(sameBucket(1)); // no-op
+    CHECK(cache->size() == 1);
+
+    cache->clear();
+    CHECK(cache->size() == 0);
+    CHECK(!cache->contains(sameBucket(2)));
+}
+
+TEST_CASE("StrongSetAssociativeHashtable.get_or_try_emplace")
+{
+    auto cache = StrongSetAssociativeHashtable<int>::create(LRUCapacity { 8 });
+    auto const a = StrongHash::compute("a");
+
+    CHECK(cache->get_or_try_emplace(a, [](auto) { return optional<int> {}; }) == nullptr);
+    CHECK(cache->size() == 0);
+    CHECK(!cache->contains(a));
+
+    auto* value = cache->get_or_try_emplace(a, [](auto) { return optional<int> { 42 }; });
+    REQUIRE(value != nullptr);
+    CHECK(*value == 42);
+    CHECK(cache->size() == 1);
+    CHECK_THROWS_AS(cache->at(StrongHash::compute("b")), std::out_of_range);
+}
@@ -0,0 +1,252 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/TextureCompression.h>
+
+#include <algorithm>
+#include <array>
+
+using std::array;
+using std::max;
+using std::min;
+
+namespace crispy
+{
+
+namespace
+{
+    using Block = array<array<uint8_t, 4>, 16>; // RGBA of 4x4 pixels
+
+    Block loadBlock(uint8_t const* _pixels, size_t _width, size_t _height, size_t _x, size_t _y) noexcept
+    {
+        auto block = Block {};
+        for (size_t i = 0; i < 16; ++i)
+        {
+            auto const x = min(_x + i % 4, _width - 1);
+            auto const y = min(_y + i / 4, _height - 1);
+            auto const* pixel = _pixels + (y * _width + x) * 4;
+            std::copy_n(pixel, 4, block[i].begin());
+        }
+        return block;
+    }
+
+    constexpr uint16_t toRGB565(unsigned _r, unsigned _g, unsigned _b) noexcept
+    {
+        // Rounds to the closest value, rather than truncating, so that endpoints do not collapse.
+        return static_cast<uint16_t>((((_r * 31 + 127) / 255) << 11) | (((_g * 63 + 127) / 255) << 5)
+                                     | ((_b * 31 + 127) / 255));
+    }
+
+    constexpr array<unsigned, 3> fromRGB565(uint16_t _value) noexcept
+    {
+        auto const r = (_value >> 11) & 0x1F;
+        auto const g = (_value >> 5) & 0x3F;
+        auto const b = _value & 0x1F;
+        return { static_cast<unsigned>((r << 3) | (r >> 2)),
+                 static_cast<unsigned>((g << 2) | (g >> 4)),
+                 static_cast<unsigned>((b << 3) | (b >> 2)) };
+    }
+
+    array<array<unsigned, 3>, 4> colorPalette(uint16_t _color0, uint16_t _color1) noexcept
+    {
+        auto palette = array<array<unsigned, 3>, 4> {};
+        palette[0] = fromRGB565(_color0);
+        palette[1] = fromRGB565(_color1);
+        for (size_t c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        return palette;
+    }
+
+    array<unsigned, 8> alphaPalette(unsigned _alpha0, unsigned _alpha1) noexcept
+    {
+        auto palette = array<unsigned, 8> { _alpha0, _alpha1 };
+        if (_alpha0 > _alpha1)
+        {
+            for (unsigned i = 1; i < 7; ++i)
+                palette[i + 1] = ((7 - i) * _alpha0 + i * _alpha1) / 7;
+        }
+        else
+        {
+            for (unsigned i = 1; i < 5; ++i)
+                palette[i + 1] = ((5 - i) * _alpha0 + i * _alpha1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        return palette;
+    }
+
+    template <typename Palette, typename Distance>
+    unsigned closest(Palette const& _palette, Distance _distance) noexcept
+    {
+        auto best = 0u;
+        auto bestDistance = _distance(_palette[0]);
+        for (unsigned i = 1; i < _palette.size(); ++i)
+        {
+            if (auto const distance = _distance(_palette[i]); distance < bestDistance)
+            {
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        return best;
+    }
+
+    void encodeAlpha(Block const& _block, uint8_t* _out) noexcept
+    {
+        auto low = 255u;
+        auto high = 0u;
+        for (auto const& pixel: _block)
+        {
+            low = min(low, unsigned(pixel[3]));
+            high = max(high, unsigned(pixel[3]));
+        }
+
+        // Moves the endpoints slightly inwards, as the extremes are rarer than the values in between.
+        auto const inset = (high - low) / 32;
+        high -= inset;
+        low += inset;
+
+        _out[0] = static_cast<uint8_t>(high);
+        _out[1] = static_cast<uint8_t>(low);
+
+        auto const palette = alphaPalette(high, low);
+        auto indices = uint64_t { 0 };
+        for (size_t i = 0; i < 16; ++i)
+        {
+            auto const alpha = int(_block[i][3]);
+            auto const index = closest(palette, [&](unsigned _value) { return std::abs(int(_value) - alpha); });
+            indices |= uint64_t { index } << (3 * i);
+        }
+        for (size_t i = 0; i < 6; ++i)
+            _out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+    }
+
+    void encodeColor(Block const& _block, uint8_t* _out) noexcept
+    {
+        auto low = array<unsigned, 3> { 255, 255, 255 };
+        auto high = array<unsigned, 3> { 0, 0, 0 };
+        for (auto const& pixel: _block)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                low[c] = min(low[c], unsigned(pixel[c]));
+                high[c] = max(high[c], unsigned(pixel[c]));
+            }
+        }
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            auto const inset = (high[c] - low[c]) / 16;
+            high[c] -= inset;
+            low[c] += inset;
+        }
+
+        // The endpoints span the diagonal of the bounding box along which the colors vary,
+        // i.e. channels decreasing while the one of the largest range increases are swapped.
+        auto main = size_t { 0 };
+        for (size_t c = 1; c < 3; ++c)
+            if (high[c] - low[c] > high[main] - low[main])
+                main = c;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            auto covariance = 0;
+            for (auto const& pixel: _block)
+                covariance += (2 * int(pixel[main]) - int(high[main] + low[main]))
+                              * (2 * int(pixel[c]) - int(high[c] + low[c]));
+            if (covariance < 0)
+                std::swap(high[c], low[c]);
+        }
+
+        auto const color0 = toRGB565(high[0], high[1], high[2]);
+        auto const color1 = toRGB565(low[0], low[1], low[2]);
+        _out[0] = static_cast<uint8_t>(color0);
+        _out[1] = static_cast<uint8_t>(color0 >> 8);
+        _out[2] = static_cast<uint8_t>(color1);
+        _out[3] = static_cast<uint8_t>(color1 >> 8);
+
+        auto const palette = colorPalette(color0, color1);
+        auto indices = uint32_t { 0 };
+        for (size_t i = 0; i < 16; ++i)
+        {
+            auto const& pixel = _block[i];
+            auto const index = closest(palette, [&](array<unsigned, 3> const& _color) {
+                auto distance = 0;
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    auto const delta = int(_color[c]) - int(pixel[c]);
+                    distance += delta * delta;
+                }
+                return distance;
+            });
+            indices |= index << (2 * i);
+        }
+        for (size_t i = 0; i < 4; ++i)
+            _out[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+    }
+} // namespace
+
+std::vector<uint8_t> compressBC3(uint8_t const* _pixels, size_t _width, size_t _height)
+{
+    auto blocks = std::vector<uint8_t>(bc3CompressedSize(_width, _height));
+    auto* out = blocks.data();
+    for (size_t y = 0; y < _height; y += 4)
+    {
+        for (size_t x = 0; x < _width; x += 4)
+        {
+            auto const block = loadBlock(_pixels, _width, _height, x, y);
+            encodeAlpha(block, out);
+            encodeColor(block, out + 8);
+            out += BC3BlockSize;
+        }
+    }
+    return blocks;
+}
+
+std::vector<uint8_t> decompressBC3(uint8_t const* _blocks, size_t _width, size_t _height)
+{
+    auto pixels = std::vector<uint8_t>(_width * _height * 4);
+    for (size_t y = 0; y < _height; y += 4)
+    {
+        for (size_t x = 0; x < _width; x += 4)
+        {
+            auto const alphas = alphaPalette(_blocks[0], _blocks[1]);
+            auto alphaIndices = uint64_t { 0 };
+            for (size_t i = 0; i < 6; ++i)
+                alphaIndices |= uint64_t { _blocks[2 + i] } << (8 * i);
+
+            auto const colors = colorPalette(static_cast<uint16_t>(_blocks[8] | (_blocks[9] << 8)),
+                                             static_cast<uint16_t>(_blocks[10] | (_blocks[11] << 8)));
+            auto colorIndices = uint32_t { 0 };
+            for (size_t i = 0; i < 4; ++i)
+                colorIndices |= uint32_t { _blocks[12 + i] } << (8 * i);
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                if (x + i % 4 >= _width || y + i / 4 >= _height)
+                    continue;
+                auto* pixel = pixels.data() + ((y + i / 4) * _width + x + i % 4) * 4;
+                auto const& color = colors[(colorIndices >> (2 * i)) & 3];
+                for (size_t c = 0; c < 3; ++c)
+                    pixel[c] = static_cast<uint8_t>(color[c]);
+                pixel[3] = static_cast<uint8_t>(alphas[(alphaIndices >> (3 * i)) & 7]);
+            }
+            _blocks += BC3BlockSize;
+        }
+    }
+    return pixels;
+}
+
+} // namespace crispy
@@ -0,0 +1,53 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crispy
+{
+
+// Compression of RGBA pixels (8 bits per channel) into BC3 blocks, also known as DXT5 or S3TC,
+// which GPUs sample from directly. Every block encodes 4x4 pixels in 16 bytes, a quarter of
+// their uncompressed size:
+//
+//     bytes  0..1   alpha endpoints
+//     bytes  2..7   3 bit alpha index per pixel, selecting one of 8 levels between the endpoints
+//     bytes  8..11  color endpoints, RGB 5:6:5 (little endian)
+//     bytes 12..15  2 bit color index per pixel, selecting one of 4 colors between the endpoints
+//
+// Blocks are stored row by row, pixels within a block as well.
+
+/// Number of bytes a block of 4x4 pixels is compressed into.
+constexpr size_t BC3BlockSize = 16;
+
+/// Returns the number of bytes an image of the given size in pixels is compressed into.
+constexpr size_t bc3CompressedSize(size_t _width, size_t _height) noexcept
+{
+    return (_width + 3) / 4 * ((_height + 3) / 4) * BC3BlockSize;
+}
+
+/// Compresses the RGBA pixels of an image with rows stored without padding.
+///
+/// The encoder favors speed over quality: the endpoints of a block are the corners of the
+/// bounding box of its colors (and alphas), and each pixel picks the closest color in between.
+/// Blocks exceeding the image's right or bottom edge repeat its last column or row.
+[[nodiscard]] std::vector<uint8_t> compressBC3(uint8_t const* _pixels, size_t _width, size_t _height);
+
+/// Decompresses BC3 blocks into the RGBA pixels of an image of the given size.
+[[nodiscard]] std::vector<uint8_t> decompressBC3(uint8_t const* _blocks, size_t _width, size_t _height);
+
+} // namespace crispy
@@ -0,0 +1,72 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/TextureCompression.h>
+
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+using crispy::bc3CompressedSize;
+using crispy::compressBC3;
+using crispy::decompressBC3;
+using std::vector;
+
+namespace
+{
+
+int maxError(vector<uint8_t> const& _a, vector<uint8_t> const& _b)
+{
+    auto error = 0;
+    for (size_t i = 0; i < _a.size(); ++i)
+        error = std::max(error, std::abs(int(_a[i]) - int(_b[i])));
+    return error;
+}
+
+} // namespace
+
+TEST_CASE("TextureCompression.size", "[TextureCompression]")
+{
+    CHECK(bc3CompressedSize(4, 4) == 16);
+    CHECK(bc3CompressedSize(5, 4) == 32);
+    CHECK(bc3CompressedSize(8, 9) == 96);
+    CHECK(compressBC3(vector<uint8_t>(7 * 3 * 4).data(), 7, 3).size() == 32);
+}
+
+TEST_CASE("TextureCompression.solid", "[TextureCompression]")
+{
+    // Colors representable in RGB 5:6:5 survive unchanged.
+    auto pixels = vector<uint8_t>();
+    for (size_t i = 0; i < 6 * 6; ++i)
+        pixels.insert(pixels.end(), { 0xFF, 0x00, 0x84, 0x80 });
+
+    auto const blocks = compressBC3(pixels.data(), 6, 6);
+    CHECK(decompressBC3(blocks.data(), 6, 6) == pixels);
+}
+
+TEST_CASE("TextureCompression.gradient", "[TextureCompression]")
+{
+    auto constexpr Width = 32;
+    auto constexpr Height = 16;
+    // Colors (and alphas) of every block lie along a line, as blocks can only represent those.
+    auto pixels = vector<uint8_t>();
+    for (size_t y = 0; y < Height; ++y)
+        for (size_t x = 0; x < Width; ++x)
+            pixels.insert(pixels.end(),
+                          { uint8_t(x * 8), uint8_t(x * 4), uint8_t(255 - x * 8), uint8_t(y * 16) });
+
+    auto const blocks = compressBC3(pixels.data(), Width, Height);
+    REQUIRE(blocks.size() == bc3CompressedSize(Width, Height));
+    CHECK(maxError(decompressBC3(blocks.data(), Width, Height), pixels) <= 16);
+}
@@ -0,0 +1,133 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/WorkerPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace crispy
+{
+
+namespace
+{
+    /// State of one parallelFor() call, shared with the jobs working on it.
+    ///
+    /// Jobs may only start after all indices have been claimed, in which case they return right away.
+    struct Batch
+    {
+        std::function<void(size_t)> const* task;
+        size_t count;
+        std::atomic<size_t> next = 0;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr error;
+
+        void work()
+        {
+            for (auto i = next++; i < count; i = next++)
+            {
+                auto error = std::exception_ptr {};
+                try
+                {
+                    (*task)(i);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                auto const _l = std::lock_guard { mutex };
+                if (error && !this->error)
+                    this->error = error;
+                if (++done == count)
+                    finished.notify_all();
+            }
+        }
+    };
+} // namespace
+
+WorkerPool::WorkerPool(size_t _threadCount)
+{
+    threads_.reserve(_threadCount);
+    for (size_t i = 0; i < _threadCount; ++i)
+        threads_.emplace_back([this]() { main(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        auto const _l = std::lock_guard { mutex_ };
+        terminating_ = true;
+    }
+    wakeup_.notify_all();
+    for (auto& thread: threads_)
+        thread.join();
+}
+
+WorkerPool& WorkerPool::shared()
+{
+    static auto pool = WorkerPool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+void WorkerPool::parallelFor(size_t _count, std::function<void(size_t)> const& _task)
+{
+    if (_count == 0)
+        return;
+
+    auto batch = std::make_shared<Batch>();
+    batch->task = &_task;
+    batch->count = _count;
+
+    auto const helpers = std::min(threads_.size(), _count - 1);
+    if (helpers)
+    {
+        {
+            auto const _l = std::lock_guard { mutex_ };
+            for (size_t i = 0; i < helpers; ++i)
+                jobs_.emplace_back([batch]() { batch->work(); });
+        }
+        wakeup_.notify_all();
+    }
+
+    batch->work();
+
+    auto _l = std::unique_lock { batch->mutex };
+    batch->finished.wait(_l, [&]() { return batch->done == _count; });
+    if (batch->error)
+        std::rethrow_exception(batch->error);
+}
+
+void WorkerPool::main()
+{
+    for (;;)
+    {
+        auto job = std::function<void()> {};
+        {
+            auto _l = std::unique_lock { mutex_ };
+            wakeup_.wait(_l, [this]() { return terminating_ || !jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+} // namespace crispy
@@ -0,0 +1,61 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crispy
+{
+
+/// Fixed set of threads that are started once and reused for running work in parallel,
+/// so that work recurring at a high rate (e.g. every frame) does not pay for starting threads.
+class WorkerPool
+{
+  public:
+    explicit WorkerPool(size_t _threadCount);
+
+    /// Waits for the running work to finish and stops all threads.
+    ~WorkerPool();
+
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+
+    [[nodiscard]] size_t threadCount() const noexcept { return threads_.size(); }
+
+    /// Invokes @p _task for every index in [0, @p _count), spread across the pool's threads and the
+    /// calling thread, which also works on them. Returns once all have been invoked.
+    ///
+    /// If a task throws, the first exception is rethrown once all others have finished.
+    void parallelFor(size_t _count, std::function<void(size_t)> const& _task);
+
+    /// @returns the process-wide pool, with a thread per CPU core besides the calling thread.
+    static WorkerPool& shared();
+
+  private:
+    void main();
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<std::function<void()>> jobs_;
+    bool terminating_ = false;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace crispy
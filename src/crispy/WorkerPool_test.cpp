@@ -0,0 +1,69 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/WorkerPool.h>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using crispy::WorkerPool;
+
+TEST_CASE("WorkerPool.parallelFor", "[WorkerPool]")
+{
+    auto pool = WorkerPool(3);
+    CHECK(pool.threadCount() == 3);
+
+    // Run a few times, reusing the same threads.
+    for (size_t count: { 0u, 1u, 2u, 100u, 1000u })
+    {
+        auto invocations = std::vector<std::atomic<int>>(count);
+        pool.parallelFor(count, [&](size_t i) { ++invocations[i]; });
+        for (auto const& n: invocations)
+            CHECK(n == 1);
+    }
+}
+
+TEST_CASE("WorkerPool.parallelFor.withoutThreads", "[WorkerPool]")
+{
+    auto pool = WorkerPool(0);
+    auto const caller = std::this_thread::get_id();
+    auto sum = size_t { 0 };
+    pool.parallelFor(10, [&](size_t i) {
+        CHECK(std::this_thread::get_id() == caller);
+        sum += i;
+    });
+    CHECK(sum == 45);
+}
+
+TEST_CASE("WorkerPool.parallelFor.exception", "[WorkerPool]")
+{
+    auto pool = WorkerPool(2);
+    auto invocations = std::atomic<int> { 0 };
+    CHECK_THROWS_AS(pool.parallelFor(8,
+                                     [&](size_t i) {
+                                         ++invocations;
+                                         if (i == 3)
+                                             throw std::runtime_error("failed");
+                                     }),
+                    std::runtime_error);
+    CHECK(invocations == 8);
+
+    // The pool is still usable afterwards.
+    auto count = std::atomic<int> { 0 };
+    pool.parallelFor(4, [&](size_t) { ++count; });
+    CHECK(count == 4);
+}
@@ -14,8 +14,16 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
 #include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__)
+    #include <immintrin.h>
+#elif defined(__aarch64__)
+    #include <crispy/sse2neon.h>
+#endif
 
 namespace crispy::base64
 {
@@ -49,6 +57,70 @@ namespace detail
     };
     // clang-format on
 
+    /// Decodes the leading blocks of 16 characters of @p input that consist of alphabet characters only
+    /// (no padding), writing 12 bytes per block to @p output.
+    ///
+    /// @returns the number of input characters decoded, always a multiple of 16.
+    inline size_t decodeBlocks(char const* input, size_t size, char* output) noexcept
+    {
+        auto const begin = input;
+
+#if defined(__SSE2__) || defined(__aarch64__)
+        // Signed comparisons: bytes >= 0x80 are negative and thus outside of all ranges.
+        auto const inRange = [](__m128i batch, char first, char last) {
+            return _mm_and_si128(_mm_cmpgt_epi8(batch, _mm_set1_epi8(static_cast<char>(first - 1))),
+                                 _mm_cmplt_epi8(batch, _mm_set1_epi8(static_cast<char>(last + 1))));
+        };
+        auto const offsetIf = [](__m128i mask, char offset) {
+            return _mm_and_si128(mask, _mm_set1_epi8(offset));
+        };
+
+        while (size >= 16)
+        {
+            auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+            auto const upper = inRange(batch, 'A', 'Z');
+            auto const lower = inRange(batch, 'a', 'z');
+            auto const digit = inRange(batch, '0', '9');
+            auto const plus = _mm_cmpeq_epi8(batch, _mm_set1_epi8('+'));
+            auto const slash = _mm_cmpeq_epi8(batch, _mm_set1_epi8('/'));
+            auto const valid =
+                _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash));
+            if (_mm_movemask_epi8(valid) != 0xFFFF)
+                break;
+
+            // Maps each character to its 6-bit value.
+            auto const offsets = _mm_or_si128(
+                _mm_or_si128(offsetIf(upper, -'A'), offsetIf(lower, 26 - 'a')),
+                _mm_or_si128(offsetIf(digit, 52 - '0'),
+                             _mm_or_si128(offsetIf(plus, 62 - '+'), offsetIf(slash, 63 - '/'))));
+            auto const values = _mm_add_epi8(batch, offsets);
+
+            // Merges the four 6-bit values of each 32-bit lane into its lower 24 bits.
+            auto const pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 6),
+                                            _mm_srli_epi16(values, 8));
+            auto const quads = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0xFFFF)), 12),
+                                            _mm_srli_epi32(pairs, 16));
+
+            alignas(16) uint32_t lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), quads);
+            for (uint32_t const lane: lanes)
+            {
+                *output++ = static_cast<char>(lane >> 16);
+                *output++ = static_cast<char>(lane >> 8);
+                *output++ = static_cast<char>(lane);
+            }
+
+            input += 16;
+            size -= 16;
+        }
+#else
+        (void) size;
+        (void) output;
+#endif
+
+        return static_cast<size_t>(input - begin);
+    }
+
     template <typename T, size_t N>
     std::string& operator+=(std::string& s, std::array<T, N> v)
     {
@@ -243,13 +315,24 @@ size_t decode(Iterator begin, Iterator end, Output output)
 template <typename Output>
 size_t decode(std::string_view input, Output output)
 {
-    return decode(input.begin(), input.end(), output);
+    if constexpr (std::is_pointer_v<Output> && sizeof(std::remove_pointer_t<Output>) == 1)
+    {
+        // Bulk-decodes the leading blocks, leaving the tail (and anything after the first
+        // non-alphabet character) to the generic decoder.
+        auto const blockChars =
+            detail::decodeBlocks(input.data(), input.size(), reinterpret_cast<char*>(output));
+        auto const blockBytes = blockChars / 4 * 3;
+        return blockBytes + decode(input.begin() + blockChars, input.end(), output + blockBytes);
+    }
+    else
+        return decode(input.begin(), input.end(), output);
 }
 
 inline std::string decode(std::string_view input)
 {
+    // Upper bound of the decoded length, saving a scan over the input.
     std::string output;
-    output.resize(decodeLength(input));
+    output.resize((input.size() + 3) / 4 * 3);
     output.resize(decode(input, &output[0]));
     return output;
 }
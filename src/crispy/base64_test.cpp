@@ -34,3 +34,20 @@ TEST_CASE("base64.decode", "[base64]")
     CHECK("abcd" == base64::decode("YWJjZA=="));
     CHECK("foo:bar" == base64::decode("Zm9vOmJhcg=="));
 }
+
+TEST_CASE("base64.decode.blocks", "[base64]")
+{
+    // Long enough for bulk decoding of multiple blocks, followed by a tail of every length.
+    auto data = std::string();
+    for (int i = 0; i < 100; ++i)
+    {
+        auto const encoded = base64::encode(data);
+        INFO(encoded);
+        CHECK(data == base64::decode(encoded));
+        data += static_cast<char>(i * 37 + 11);
+    }
+
+    // Decoding stops at the first character outside of the alphabet, also within a block.
+    CHECK("abcdefghijkl" == base64::decode("YWJjZGVmZ2hpamts"));
+    CHECK("abcdefghi" == base64::decode("YWJjZGVmZ2hp!mts"));
+}
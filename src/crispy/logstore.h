@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <iterator>
@@ -77,46 +78,65 @@ using source_location = SourceLocation;
 
 class MessageBuilder
 {
+  public:
+    using clock = std::chrono::system_clock;
+
   private:
     Category const& _category;
     source_location _location;
+    clock::time_point _time;
     std::string _buffer;
+    bool _enabled;
 
   public:
     explicit MessageBuilder(Category const& cat, source_location loc = source_location::current());
+    MessageBuilder(Category const& cat, source_location loc, clock::time_point time);
 
     [[nodiscard]] Category const& category() const noexcept { return _category; }
     [[nodiscard]] source_location const& location() const noexcept { return _location; }
 
+    /// Time at which the message was created.
+    [[nodiscard]] clock::time_point time() const noexcept { return _time; }
+
     [[nodiscard]] std::string const& text() const noexcept { return _buffer; }
 
+    // NB: Messages of disabled categories are not formatted at all, so that unguarded
+    // log statements cost no more than a single branch.
+
     MessageBuilder& append(std::string_view msg)
     {
-        _buffer += msg;
+        if (_enabled)
+            _buffer += msg;
         return *this;
     }
 
     template <typename... T>
     MessageBuilder& append(fmt::format_string<T...> fmt, T&&... args)
     {
-        _buffer += fmt::vformat(fmt, fmt::make_format_args(args...));
+        if (_enabled)
+            _buffer += fmt::vformat(fmt, fmt::make_format_args(args...));
         return *this;
     }
 
     MessageBuilder& operator()(std::string const& msg)
     {
-        _buffer += msg;
+        if (_enabled)
+            _buffer += msg;
         return *this;
     }
     template <typename... T>
     MessageBuilder& operator()(fmt::format_string<T...> fmt, T&&... args)
     {
-        _buffer += fmt::vformat(fmt, fmt::make_format_args(args...));
+        if (_enabled)
+            _buffer += fmt::vformat(fmt, fmt::make_format_args(args...));
         return *this;
     }
 
     [[nodiscard]] std::string message() const;
 
+    /// Drops this message, i.e. it will not be written to the category's sink upon destruction.
+    void discard() noexcept { _enabled = false; }
+
     ~MessageBuilder();
 };
 
@@ -193,6 +213,7 @@ class Sink
     using Writer = std::function<void(std::string_view const&)>;
 
     Sink(bool _enabled, Writer _writer): enabled_ { _enabled }, writer_ { std::move(_writer) } {}
+    virtual ~Sink() = default;
 
     Sink(bool _enabled, std::ostream& _output):
         Sink(_enabled, [out = &_output](std::string_view text) {
@@ -205,9 +226,10 @@ class Sink
     void set_writer(Writer _writer);
 
     /// Writes given built message to this sink.
-    void write(MessageBuilder const& _message);
+    virtual void write(MessageBuilder const& _message);
 
     void set_enabled(bool enabled) { enabled_ = enabled; }
+    [[nodiscard]] bool enabled() const noexcept { return enabled_; }
 
     /// Retrieves reference to standard debug-logging sink.
     static inline Sink& console()
@@ -222,7 +244,7 @@ class Sink
         return instance;
     }
 
-  private:
+  protected:
     bool enabled_;
     Writer writer_;
 };
@@ -311,13 +333,24 @@ inline void configure(std::string_view filterString)
 }
 
 inline MessageBuilder::MessageBuilder(logstore::Category const& cat, source_location location):
-    _category { cat }, _location { location }
+    _category { cat },
+    _location { location },
+    _time { cat.is_enabled() ? clock::now() : clock::time_point {} },
+    _enabled { cat.is_enabled() }
+{
+}
+
+inline MessageBuilder::MessageBuilder(logstore::Category const& cat,
+                                      source_location location,
+                                      clock::time_point time):
+    _category { cat }, _location { location }, _time { time }, _enabled { true }
 {
 }
 
 inline MessageBuilder::~MessageBuilder()
 {
-    _category.sink().write(*this);
+    if (_enabled)
+        _category.sink().write(*this);
 }
 
 inline Category::Category(std::string_view name,
@@ -20,16 +20,124 @@
 #include <cassert>
 #include <iterator>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace crispy
 {
 
-template <typename T, typename Vector>
+template <typename T, typename Ring>
 struct RingIterator;
-template <typename T, typename Vector>
+template <typename T, typename Ring>
 struct RingReverseIterator;
 
+/**
+ * A range of ring elements as at most two contiguous memory regions.
+ *
+ * The range wraps around the end of the ring's storage at most once,
+ * so walking it boils down to at most two linear memory scans.
+ */
+template <typename T>
+struct ring_spans
+{
+    gsl::span<T> first;  //!< elements from the start of the range up to the end of the storage, at most
+    gsl::span<T> second; //!< elements that wrapped around to the beginning of the storage, if any
+
+    [[nodiscard]] std::size_t size() const noexcept { return first.size() + second.size(); }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    class iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+        iterator(T* current, T* firstEnd, T* secondBegin, bool inSecond) noexcept:
+            _current { current },
+            _firstEnd { firstEnd },
+            _secondBegin { secondBegin },
+            _inSecond { inSecond }
+        {
+            if (!_inSecond && _current == _firstEnd)
+                enterSecond();
+        }
+
+        reference operator*() const noexcept { return *_current; }
+        pointer operator->() const noexcept { return _current; }
+
+        iterator& operator++() noexcept
+        {
+            if (++_current == _firstEnd && !_inSecond)
+                enterSecond();
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            auto old = *this;
+            ++(*this);
+            return old;
+        }
+
+        // The phase is compared, too, as a range spanning the whole storage ends where it begins.
+        bool operator==(iterator const& rhs) const noexcept
+        {
+            return _current == rhs._current && _inSecond == rhs._inSecond;
+        }
+        bool operator!=(iterator const& rhs) const noexcept { return !(*this == rhs); }
+
+      private:
+        void enterSecond() noexcept
+        {
+            _current = _secondBegin;
+            _inSecond = true;
+        }
+
+        T* _current = nullptr;
+        T* _firstEnd = nullptr;
+        T* _secondBegin = nullptr;
+        bool _inSecond = false;
+    };
+
+    iterator begin() const noexcept { return iterator { first.data(), firstEnd(), second.data(), false }; }
+    iterator end() const noexcept
+    {
+        return iterator { second.data() + second.size(), firstEnd(), second.data(), true };
+    }
+
+  private:
+    T* firstEnd() const noexcept { return first.data() + first.size(); }
+};
+
+namespace detail
+{
+    /// Splits @p count elements starting at storage index @p start into at most two spans.
+    template <typename T>
+    ring_spans<T> makeRingSpans(T* data,
+                                std::size_t storageSize,
+                                std::size_t start,
+                                std::size_t count) noexcept
+    {
+        auto const firstCount = std::min(count, storageSize - start);
+        auto const first = gsl::span<T>(data + start, firstCount);
+        if (firstCount == count)
+            return ring_spans<T> { first, gsl::span<T>(data + start + firstCount, 0) };
+        return ring_spans<T> { first, gsl::span<T>(data, count - firstCount) };
+    }
+
+    constexpr std::size_t powerOfTwoCapacity(std::size_t minimumCapacity) noexcept
+    {
+        auto capacity = std::size_t { 1 };
+        while (capacity < minimumCapacity)
+            capacity <<= 1;
+        return capacity;
+    }
+} // namespace detail
+
 /**
  * Implements an efficient ring buffer over type T
  * and the underlying storage Vector.
@@ -39,10 +147,10 @@ class basic_ring
 {
   public:
     using value_type = T;
-    using iterator = RingIterator<value_type, Vector>;
-    using const_iterator = RingIterator<value_type const, Vector>;
-    using reverse_iterator = RingReverseIterator<value_type, Vector>;
-    using const_reverse_iterator = RingReverseIterator<value_type const, Vector>;
+    using iterator = RingIterator<value_type, basic_ring>;
+    using const_iterator = RingIterator<value_type const, basic_ring const>;
+    using reverse_iterator = RingReverseIterator<value_type, basic_ring>;
+    using const_reverse_iterator = RingReverseIterator<value_type const, basic_ring const>;
     using difference_type = long;
     using offset_type = long;
 
@@ -51,26 +159,31 @@ class basic_ring
     basic_ring& operator=(basic_ring const&) = default;
     basic_ring(basic_ring&&) noexcept = default;
     basic_ring& operator=(basic_ring&&) noexcept = default;
-    virtual ~basic_ring() = default;
+    ~basic_ring() = default;
 
     explicit basic_ring(Vector storage): _storage(std::move(storage)) {}
 
-    value_type const& operator[](offset_type i) const noexcept
-    {
-        return _storage[size_t(offset_type(_zero + size()) + i) % size()];
-    }
-    value_type& operator[](offset_type i) noexcept
-    {
-        return _storage[size_t(offset_type(_zero + size()) + i) % size()];
-    }
+    value_type const& operator[](offset_type i) const noexcept { return _storage[storage_index(i)]; }
+    value_type& operator[](offset_type i) noexcept { return _storage[storage_index(i)]; }
 
-    value_type const& at(offset_type i) const noexcept
-    {
-        return _storage[size_t(_zero + size() + i) % size()];
-    }
-    value_type& at(offset_type i) noexcept
+    value_type const& at(offset_type i) const noexcept { return _storage[storage_index(i)]; }
+    value_type& at(offset_type i) noexcept { return _storage[storage_index(i)]; }
+
+    /// Maps the ring offset @p i to its index into the underlying storage.
+    ///
+    /// Offsets within [-size(), size()), which is what element accesses use,
+    /// are wrapped around without resorting to an integer division.
+    [[nodiscard]] std::size_t storage_index(offset_type i) const noexcept
     {
-        return _storage[size_t(offset_type(_zero + size()) + i) % size()];
+        auto const n = static_cast<offset_type>(size());
+        auto k = static_cast<offset_type>(_zero) + i;
+        if (k >= n)
+            k -= n;
+        else if (k < 0)
+            k += n;
+        if (0 <= k && k < n)
+            return static_cast<std::size_t>(k);
+        return static_cast<std::size_t>((k % n + n) % n);
     }
 
     Vector& storage() noexcept { return _storage; }
@@ -111,14 +224,10 @@ class basic_ring
     iterator begin() noexcept { return iterator { this, 0 }; }
     iterator end() noexcept { return iterator { this, static_cast<difference_type>(size()) }; }
 
-    const_iterator cbegin() const noexcept
-    {
-        return const_iterator { (basic_ring<value_type const, Vector>*) this, 0 };
-    }
+    const_iterator cbegin() const noexcept { return const_iterator { this, 0 }; }
     const_iterator cend() const noexcept
     {
-        return const_iterator { (basic_ring<value_type const, Vector>*) this,
-                                static_cast<difference_type>(size()) };
+        return const_iterator { this, static_cast<difference_type>(size()) };
     }
 
     const_iterator begin() const noexcept { return cbegin(); }
@@ -144,6 +253,25 @@ class basic_ring
         return gsl::make_span(a, b);
     }
 
+    /// Returns the @p count elements starting at ring offset @p start as at most two contiguous spans.
+    ///
+    /// @p count must not exceed size().
+    ring_spans<value_type> spans(offset_type start, std::size_t count) noexcept
+    {
+        assert(count <= size());
+        if (!count)
+            return {};
+        return detail::makeRingSpans(_storage.data(), size(), storage_index(start), count);
+    }
+
+    ring_spans<value_type const> spans(offset_type start, std::size_t count) const noexcept
+    {
+        assert(count <= size());
+        if (!count)
+            return {};
+        return detail::makeRingSpans(_storage.data(), size(), storage_index(start), count);
+    }
+
   protected:
     Vector _storage;
     std::size_t _zero = 0;
@@ -194,8 +322,104 @@ class ring: public basic_ring<T, Container<T, Allocator>>
 template <typename T, std::size_t N>
 using fixed_size_ring = basic_ring<T, std::array<T, N>>;
 
+/**
+ * Implements a ring buffer over type T whose size is a power of two.
+ *
+ * Ring offsets are mapped to storage indices by bit masking, so element access
+ * costs no more than indexing into a plain vector.
+ * The size is fixed at construction time, rounded up to the next power of two.
+ */
+template <typename T>
+class pow2_ring
+{
+  public:
+    using value_type = T;
+    using iterator = RingIterator<value_type, pow2_ring>;
+    using const_iterator = RingIterator<value_type const, pow2_ring const>;
+    using reverse_iterator = RingReverseIterator<value_type, pow2_ring>;
+    using const_reverse_iterator = RingReverseIterator<value_type const, pow2_ring const>;
+    using difference_type = long;
+    using offset_type = long;
+
+    pow2_ring() = default;
+
+    explicit pow2_ring(std::size_t minimumCapacity, T const& value = T {}):
+        _storage(detail::powerOfTwoCapacity(minimumCapacity), value), _mask { _storage.size() - 1 }
+    {
+    }
+
+    value_type const& operator[](offset_type i) const noexcept { return _storage[storage_index(i)]; }
+    value_type& operator[](offset_type i) noexcept { return _storage[storage_index(i)]; }
+
+    /// Maps the ring offset @p i to its index into the underlying storage.
+    ///
+    /// This also works for negative offsets, as 2^64 is a multiple of any power of two.
+    [[nodiscard]] std::size_t storage_index(offset_type i) const noexcept
+    {
+        return (_zero + static_cast<std::size_t>(i)) & _mask;
+    }
+
+    std::vector<T>& storage() noexcept { return _storage; }
+    std::vector<T> const& storage() const noexcept { return _storage; }
+    std::size_t zero_index() const noexcept { return _zero; }
+    std::size_t size() const noexcept { return _storage.size(); }
+
+    // positvie count rotates right, negative count rotates left
+    void rotate(int count) noexcept { _zero = (_zero - static_cast<std::size_t>(count)) & _mask; }
+    void rotate_left(std::size_t count) noexcept { _zero = (_zero + count) & _mask; }
+    void rotate_right(std::size_t count) noexcept { _zero = (_zero - count) & _mask; }
+
+    value_type& front() noexcept { return (*this)[0]; }
+    value_type const& front() const noexcept { return (*this)[0]; }
+    value_type& back() noexcept { return (*this)[-1]; }
+    value_type const& back() const noexcept { return (*this)[-1]; }
+
+    iterator begin() noexcept { return iterator { this, 0 }; }
+    iterator end() noexcept { return iterator { this, static_cast<difference_type>(size()) }; }
+    const_iterator begin() const noexcept { return const_iterator { this, 0 }; }
+    const_iterator end() const noexcept
+    {
+        return const_iterator { this, static_cast<difference_type>(size()) };
+    }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator { this, 0 }; }
+    reverse_iterator rend() noexcept
+    {
+        return reverse_iterator { this, static_cast<difference_type>(size()) };
+    }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator { this, 0 }; }
+    const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator { this, static_cast<difference_type>(size()) };
+    }
+
+    /// Returns the @p count elements starting at ring offset @p start as at most two contiguous spans.
+    ///
+    /// @p count must not exceed size().
+    ring_spans<value_type> spans(offset_type start, std::size_t count) noexcept
+    {
+        assert(count <= size());
+        if (!count)
+            return {};
+        return detail::makeRingSpans(_storage.data(), size(), storage_index(start), count);
+    }
+
+    ring_spans<value_type const> spans(offset_type start, std::size_t count) const noexcept
+    {
+        assert(count <= size());
+        if (!count)
+            return {};
+        return detail::makeRingSpans(_storage.data(), size(), storage_index(start), count);
+    }
+
+  private:
+    std::vector<T> _storage;
+    std::size_t _mask = 0;
+    std::size_t _zero = 0;
+};
+
 // {{{ iterator
-template <typename T, typename Vector>
+template <typename T, typename Ring>
 struct RingIterator
 {
     using iterator_category = std::random_access_iterator_tag;
@@ -204,10 +428,10 @@ struct RingIterator
     using pointer = T*;
     using reference = T&;
 
-    basic_ring<T, Vector>* ring {};
+    Ring* ring {};
     difference_type current {};
 
-    RingIterator(basic_ring<T, Vector>* aRing, difference_type aCurrent): ring { aRing }, current { aCurrent }
+    RingIterator(Ring* aRing, difference_type aCurrent): ring { aRing }, current { aCurrent }
     {
     }
 
@@ -286,7 +510,7 @@ struct RingIterator
 // }}}
 
 // {{{ reverse iterator
-template <typename T, typename Vector>
+template <typename T, typename Ring>
 struct RingReverseIterator
 {
     using iterator_category = std::random_access_iterator_tag;
@@ -295,10 +519,10 @@ struct RingReverseIterator
     using pointer = T*;
     using reference = T&;
 
-    basic_ring<T, Vector>* ring;
+    Ring* ring;
     difference_type current;
 
-    RingReverseIterator(basic_ring<T, Vector>* _ring, difference_type _current):
+    RingReverseIterator(Ring* _ring, difference_type _current):
         ring { _ring }, current { _current }
     {
     }
@@ -383,20 +607,19 @@ typename basic_ring<T, Vector>::reverse_iterator basic_ring<T, Vector>::rbegin()
 template <typename T, typename Vector>
 typename basic_ring<T, Vector>::reverse_iterator basic_ring<T, Vector>::rend() noexcept
 {
-    return reverse_iterator { this, size() };
+    return reverse_iterator { this, static_cast<difference_type>(size()) };
 }
 
 template <typename T, typename Vector>
 typename basic_ring<T, Vector>::const_reverse_iterator basic_ring<T, Vector>::rbegin() const noexcept
 {
-    return const_reverse_iterator { (basic_ring<T const, Vector>*) this, 0 };
+    return const_reverse_iterator { this, 0 };
 }
 
 template <typename T, typename Vector>
 typename basic_ring<T, Vector>::const_reverse_iterator basic_ring<T, Vector>::rend() const noexcept
 {
-    return const_reverse_iterator { (basic_ring<T const, Vector>*) this,
-                                    static_cast<difference_type>(size()) };
+    return const_reverse_iterator { this, static_cast<difference_type>(size()) };
 }
 
 template <typename T, typename Vector>
@@ -0,0 +1,67 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <crispy/ring.h>
+
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+
+using crispy::ring;
+
+static void BM_ring_rotate(benchmark::State& state)
+{
+    auto r = ring<int>(static_cast<size_t>(state.range(0)));
+    for (auto _: state)
+    {
+        r.rotate(1);
+        benchmark::DoNotOptimize(r.zero_index());
+    }
+}
+BENCHMARK(BM_ring_rotate)->Arg(25)->Arg(1024)->Arg(100'000);
+
+static void BM_ring_iterate(benchmark::State& state)
+{
+    auto const size = static_cast<size_t>(state.range(0));
+    auto r = ring<int>(size);
+    std::iota(r.begin(), r.end(), 0);
+    r.rotate(static_cast<int>(size / 3));
+
+    for (auto _: state)
+    {
+        auto sum = int64_t { 0 };
+        for (int const value: r)
+            sum += value;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ring_iterate)->Arg(25)->Arg(1024)->Arg(100'000);
+
+static void BM_ring_index(benchmark::State& state)
+{
+    auto const size = static_cast<size_t>(state.range(0));
+    auto r = ring<int>(size);
+    std::iota(r.begin(), r.end(), 0);
+    r.rotate(static_cast<int>(size / 3));
+
+    for (auto _: state)
+    {
+        auto sum = int64_t { 0 };
+        for (size_t i = 0; i < size; ++i)
+            sum += r[i];
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ring_index)->Arg(25)->Arg(1024)->Arg(100'000);
@@ -18,6 +18,8 @@
 #include <catch2/catch.hpp>
 
 #include <array>
+#include <numeric>
+#include <vector>
 
 using crispy::fixed_size_ring;
 using crispy::ring;
@@ -174,3 +176,66 @@ TEST_CASE("ring.offset_negative")
     REQUIRE(r[-2] == 'b');
     REQUIRE(r[-3] == 'a');
 }
+
+TEST_CASE("ring.storage_index")
+{
+    ring<int> r(5);
+    r.rotate_left(3);
+    CHECK(r.storage_index(0) == 3);
+    CHECK(r.storage_index(2) == 0);
+    CHECK(r.storage_index(4) == 2);
+    CHECK(r.storage_index(-1) == 2);
+    CHECK(r.storage_index(-5) == 3);
+    CHECK(r.storage_index(7) == 0);
+    CHECK(r.storage_index(-12) == 1);
+}
+
+TEST_CASE("ring.spans")
+{
+    ring<int> r(5);
+    std::iota(r.storage().begin(), r.storage().end(), 0);
+    r.rotate_left(3); // logical order: 3, 4, 0, 1, 2
+
+    auto const contiguous = r.spans(2, 3);
+    CHECK(contiguous.first.size() == 3);
+    CHECK(contiguous.second.empty());
+    CHECK(std::vector<int>(contiguous.begin(), contiguous.end()) == std::vector<int> { 0, 1, 2 });
+
+    auto const wrapped = r.spans(0, 5);
+    CHECK(wrapped.first.size() == 2);
+    CHECK(wrapped.second.size() == 3);
+    CHECK(std::vector<int>(wrapped.begin(), wrapped.end()) == std::vector<int> { 3, 4, 0, 1, 2 });
+
+    auto const fromBack = r.spans(-1, 2);
+    CHECK(std::vector<int>(fromBack.begin(), fromBack.end()) == std::vector<int> { 2, 3 });
+
+    CHECK(r.spans(1, 0).empty());
+    CHECK(r.spans(1, 0).begin() == r.spans(1, 0).end());
+}
+
+TEST_CASE("pow2_ring")
+{
+    auto r = crispy::pow2_ring<int>(5);
+    REQUIRE(r.size() == 8);
+    std::iota(r.storage().begin(), r.storage().end(), 0);
+
+    r.rotate_left(6);
+    CHECK(r[0] == 6);
+    CHECK(r[1] == 7);
+    CHECK(r[2] == 0);
+    CHECK(r[-1] == 5);
+    CHECK(r.front() == 6);
+    CHECK(r.back() == 5);
+
+    r.rotate(2); // rotates right
+    CHECK(r[0] == 4);
+    r.rotate_right(5);
+    CHECK(r[0] == 7);
+
+    auto const spans = r.spans(0, 3);
+    CHECK(spans.first.size() == 1);
+    CHECK(spans.second.size() == 2);
+    CHECK(std::vector<int>(spans.begin(), spans.end()) == std::vector<int> { 7, 0, 1 });
+    CHECK(std::vector<int>(r.begin(), r.end()) == std::vector<int> { 7, 0, 1, 2, 3, 4, 5, 6 });
+    CHECK(std::vector<int>(r.rbegin(), r.rend()) == std::vector<int> { 6, 5, 4, 3, 2, 1, 0, 7 });
+}
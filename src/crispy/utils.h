@@ -440,11 +440,11 @@ constexpr T nextPowerOfTwo(T v) noexcept
     v |= v >> 1;
     v |= v >> 2;
     v |= v >> 4;
-    if constexpr (sizeof(T) >= 16)
+    if constexpr (sizeof(T) >= 2)
         v |= v >> 8;
-    if constexpr (sizeof(T) >= 32)
+    if constexpr (sizeof(T) >= 4)
         v |= v >> 16;
-    if constexpr (sizeof(T) >= 64)
+    if constexpr (sizeof(T) >= 8)
         v |= v >> 32;
     v++;
     return v;
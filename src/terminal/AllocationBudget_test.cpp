@@ -0,0 +1,272 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Terminal.h>
+#include <terminal/pty/MockPty.h>
+
+#include <catch2/catch.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+
+// Guards the allocations of the hot paths (parsing output, refreshing the render buffer), which are
+// meant to be served from pools and recycled buffers once warmed up, rather than from the heap.
+//
+// All heap allocations by operator new of this test binary are counted, on any thread, while
+// an AllocationCounter is alive. Allocations by C libraries calling malloc() directly are not seen.
+
+namespace
+{
+
+std::atomic<bool> countingAllocations { false };
+std::atomic<size_t> allocationCount { 0 };
+
+void* allocate(size_t _size)
+{
+    if (countingAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(_size ? _size : 1);
+}
+
+} // namespace
+
+// {{{ global allocator hooks
+void* operator new(size_t _size)
+{
+    if (void* p = allocate(_size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t _size)
+{
+    if (void* p = allocate(_size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t _size, std::nothrow_t const&) noexcept
+{
+    return allocate(_size);
+}
+
+void* operator new[](size_t _size, std::nothrow_t const&) noexcept
+{
+    return allocate(_size);
+}
+
+void operator delete(void* _p) noexcept
+{
+    std::free(_p);
+}
+
+void operator delete[](void* _p) noexcept
+{
+    std::free(_p);
+}
+
+void operator delete(void* _p, size_t) noexcept
+{
+    std::free(_p);
+}
+
+void operator delete[](void* _p, size_t) noexcept
+{
+    std::free(_p);
+}
+
+void operator delete(void* _p, std::nothrow_t const&) noexcept
+{
+    std::free(_p);
+}
+
+void operator delete[](void* _p, std::nothrow_t const&) noexcept
+{
+    std::free(_p);
+}
+// }}}
+
+using namespace terminal;
+using std::string;
+using std::string_view;
+
+namespace
+{
+
+// Budgets of the steady state, i.e. after warming up the buffer object pool, the grid's
+// slab pool and the render buffers.
+//
+// Plain text is stored in trivially styled lines, referencing the buffer objects the output
+// was read into.
+constexpr auto PlainTextAllocationsPerMB = 16.0;
+
+// Each styled line inflates into cells of its own, which are taken from the grid's slab pool,
+// but owned by a shared buffer (copy-on-write), costing one allocation.
+constexpr auto StyledTextAllocationsPerLine = 2.0;
+
+// A frame allocates its list of captured lines. Anything scaling with the number of lines
+// or cells is beyond budget.
+constexpr auto AllocationsPerFrame = 4.0;
+
+/// Counts the heap allocations within its lifetime.
+class AllocationCounter
+{
+  public:
+    AllocationCounter() noexcept
+    {
+        allocationCount.store(0);
+        countingAllocations.store(true);
+    }
+
+    ~AllocationCounter() { countingAllocations.store(false); }
+
+    AllocationCounter(AllocationCounter const&) = delete;
+    AllocationCounter& operator=(AllocationCounter const&) = delete;
+
+    [[nodiscard]] size_t count() const noexcept { return allocationCount.load(); }
+};
+
+/// A terminal fed by a mock PTY, with its render buffer refreshed as by the render thread.
+class Session: public Terminal::Events
+{
+  public:
+    explicit Session(PageSize _pageSize):
+        terminal_ { std::make_unique<MockPty>(_pageSize),
+                    1024 * 1024, // PTY buffer object size
+                    1024,        // PTY read buffer size
+                    *this,
+                    LineCount(500) },
+        pty_ { static_cast<MockPty&>(terminal_.device()) }
+    {
+    }
+
+    /// Queues output for the terminal, without parsing it yet.
+    void queue(string_view _output) { pty_.appendStdOutBuffer(_output); }
+
+    /// Parses all queued output.
+    void parse()
+    {
+        while (pty_.isStdoutDataAvailable())
+            terminal_.processInputOnce();
+    }
+
+    void refresh() { terminal_.refreshRenderBuffer(); }
+
+  private:
+    Terminal terminal_;
+    MockPty& pty_;
+};
+
+/// Returns @p _lineCount lines of output, formatted by @p _format with the line number.
+string makeOutput(int _lineCount, fmt::format_string<int> _format)
+{
+    auto output = string {};
+    for (int i = 0; i < _lineCount; ++i)
+        output += fmt::format(_format, i);
+    return output;
+}
+
+struct Usage
+{
+    size_t allocations;
+    size_t bytes;
+    int frames;
+};
+
+/// Writes @p _output repeatedly into the session, refreshing the render buffer after each write,
+/// and returns the allocations of the last @p _measuredRounds rounds.
+Usage run(Session& _session, string_view _output, int _warmupRounds, int _measuredRounds)
+{
+    for (int i = 0; i < _warmupRounds; ++i)
+    {
+        _session.queue(_output);
+        _session.parse();
+        _session.refresh();
+    }
+
+    auto allocations = size_t { 0 };
+    for (int i = 0; i < _measuredRounds; ++i)
+    {
+        // Queueing copies the output into the mock PTY, which is not part of the measurement.
+        _session.queue(_output);
+        auto const counter = AllocationCounter {};
+        _session.parse();
+        _session.refresh();
+        allocations += counter.count();
+    }
+
+    return Usage { allocations, _output.size() * static_cast<size_t>(_measuredRounds), _measuredRounds };
+}
+
+/// Returns the number of allocations allowed for parsing @p _usage's output at @p _perMB
+/// and refreshing its frames.
+double budget(Usage const& _usage, double _perMB)
+{
+    auto const megabytes = static_cast<double>(_usage.bytes) / (1024.0 * 1024.0);
+    return _perMB * megabytes + AllocationsPerFrame * _usage.frames;
+}
+
+} // namespace
+
+TEST_CASE("AllocationBudget.counter", "[allocation]")
+{
+    auto const counter = AllocationCounter {};
+    auto const p = std::make_unique<int>(42);
+    auto const count = counter.count();
+    CHECK(count == 1);
+}
+
+TEST_CASE("AllocationBudget.plain_text", "[allocation]")
+{
+    auto session = Session { PageSize { LineCount(25), ColumnCount(80) } };
+    auto const output =
+        makeOutput(1000, "{:05} The quick brown fox jumps over the lazy dog, again and again.\r\n");
+
+    auto const usage = run(session, output, 8, 32);
+    INFO(fmt::format(
+        "{} allocations for {} bytes in {} frames", usage.allocations, usage.bytes, usage.frames));
+    CHECK(static_cast<double>(usage.allocations) <= budget(usage, PlainTextAllocationsPerMB));
+}
+
+TEST_CASE("AllocationBudget.styled_text", "[allocation]")
+{
+    auto session = Session { PageSize { LineCount(25), ColumnCount(80) } };
+    auto constexpr OutputLineCount = 1000;
+    auto const output = makeOutput(
+        OutputLineCount, "\033[1;32mok\033[m {:05} \033[33mwarning:\033[m unused variable [-Wunused]\r\n");
+
+    auto const usage = run(session, output, 8, 32);
+    INFO(fmt::format(
+        "{} allocations for {} bytes in {} frames", usage.allocations, usage.bytes, usage.frames));
+    auto const linesPerMB = OutputLineCount * 1024.0 * 1024.0 / static_cast<double>(output.size());
+    CHECK(static_cast<double>(usage.allocations) <= budget(usage, StyledTextAllocationsPerLine * linesPerMB));
+}
+
+TEST_CASE("AllocationBudget.frames", "[allocation]")
+{
+    // Typing at a prompt: a frame per key stroke.
+    auto session = Session { PageSize { LineCount(25), ColumnCount(80) } };
+    for (int i = 0; i < 25; ++i)
+        session.queue("$ make -j8 && ./build/terminal_test\r\n");
+    session.parse();
+
+    auto const usage = run(session, "x", 100, 1000);
+    INFO(fmt::format("{} allocations in {} frames", usage.allocations, usage.frames));
+    CHECK(static_cast<double>(usage.allocations) <= budget(usage, 0.0));
+}
@@ -15,12 +15,7 @@
 
 #include <crispy/escape.h>
 
-#include <range/v3/action/sort.hpp>
-#include <range/v3/action/transform.hpp>
-#include <range/v3/algorithm/copy.hpp>
-#include <range/v3/view/concat.hpp>
-#include <range/v3/view/transform.hpp>
-
+#include <algorithm>
 #include <sstream>
 
 using std::nullopt;
@@ -423,7 +418,7 @@ namespace
         // {{{ Extensions originally introduced by tmux.
         //
         String { "Ss"_tcap, "Ss"sv, "\033[%p1%d q" }, // Set cursor style.
-        String { "Se"_tcap, "Ss"sv, "\033[ q" },      // Reset cursor style.
+        String { "Se"_tcap, "Se"sv, "\033[ q" },      // Reset cursor style.
 
         // Set cursor color.
         String { "Cs"_tcap, "Cs"sv, "\033]12;%p1%s\033\\"sv },
@@ -448,111 +443,157 @@ namespace
         // Only a terminfo name is provided, since termcap applica-
         // tions cannot use this information
         String { Undefined, "RGB"sv, "8/8/8"sv }); // }}}
+
+    // {{{ lookup tables
+    // The capabilities sorted by code and by name at compile time, for binary search at runtime.
+
+    constexpr auto lessByCode = [](auto const& a, auto const& b) {
+        return a.code.code < b.code.code;
+    };
+    constexpr auto lessByName = [](auto const& a, auto const& b) {
+        return a.name < b.name;
+    };
+
+    template <typename T, size_t N, typename Less>
+    constexpr std::array<T, N> sorted(std::array<T, N> _caps, Less _less)
+    {
+        // Insertion sort, because std::sort is not constexpr in C++17. It is also stable,
+        // such that the first definition wins for duplicate keys.
+        for (size_t i = 1; i < N; ++i)
+        {
+            for (size_t j = i; j > 0 && _less(_caps[j], _caps[j - 1]); --j)
+            {
+                auto const t = _caps[j];
+                _caps[j] = _caps[j - 1];
+                _caps[j - 1] = t;
+            }
+        }
+        return _caps;
+    }
+
+    constexpr inline auto booleanCapsByCode = sorted(booleanCaps, lessByCode);
+    constexpr inline auto numericalCapsByCode = sorted(numericalCaps, lessByCode);
+    constexpr inline auto stringCapsByCode = sorted(stringCaps, lessByCode);
+
+    constexpr inline auto booleanCapsByName = sorted(booleanCaps, lessByName);
+    constexpr inline auto numericalCapsByName = sorted(numericalCaps, lessByName);
+    constexpr inline auto stringCapsByName = sorted(stringCaps, lessByName);
+
+    template <typename T, size_t N>
+    Cap<T> const* findByCode(std::array<Cap<T>, N> const& _caps, Code _code)
+    {
+        if (_code == Undefined)
+            return nullptr;
+
+        auto const i = std::lower_bound(
+            _caps.begin(), _caps.end(), _code.code, [](auto const& cap, uint16_t code) {
+                return cap.code.code < code;
+            });
+        if (i == _caps.end() || i->code != _code)
+            return nullptr;
+        return &*i;
+    }
+
+    template <typename T, size_t N>
+    Cap<T> const* findByName(std::array<Cap<T>, N> const& _caps, string_view _name)
+    {
+        auto const i = std::lower_bound(
+            _caps.begin(), _caps.end(), _name, [](auto const& cap, string_view name) {
+                return cap.name < name;
+            });
+        if (i == _caps.end() || i->name != _name)
+            return nullptr;
+        return &*i;
+    }
+
+    /// Finds a capability by its terminfo name or, failing that, by its termcap code.
+    template <typename T, size_t N>
+    Cap<T> const* find(std::array<Cap<T>, N> const& _byName,
+                       std::array<Cap<T>, N> const& _byCode,
+                       string_view _cap)
+    {
+        if (auto const* cap = findByName(_byName, _cap))
+            return cap;
+        if (_cap.size() == 2)
+            return findByCode(_byCode, Code(_cap));
+        return nullptr;
+    }
+    // }}}
 } // namespace
 
 bool StaticDatabase::booleanCapability(Code _cap) const
 {
-    for (auto const& cap: booleanCaps)
-        if (cap.code.code == _cap.code)
-            return cap.value;
-
-    return false;
+    auto const* cap = findByCode(booleanCapsByCode, _cap);
+    return cap ? cap->value : false;
 }
 
 unsigned StaticDatabase::numericCapability(Code _cap) const
 {
-    for (auto const& cap: numericalCaps)
-        if (cap.code.code == _cap.code)
-            return cap.value;
-
-    return npos;
+    auto const* cap = findByCode(numericalCapsByCode, _cap);
+    return cap ? cap->value : npos;
 }
 
 string_view StaticDatabase::stringCapability(Code _cap) const
 {
-    for (auto const& cap: stringCaps)
-        if (cap.code.code == _cap.code)
-            return cap.value;
-
-    return {};
+    auto const* cap = findByCode(stringCapsByCode, _cap);
+    return cap ? cap->value : string_view {};
 }
 
 bool StaticDatabase::booleanCapability(string_view _cap) const
 {
-    for (auto const tcap: booleanCaps)
-        if (tcap.name == _cap || tcap.code == _cap)
-            return tcap.value;
-
-    return false;
+    auto const* cap = find(booleanCapsByName, booleanCapsByCode, _cap);
+    return cap ? cap->value : false;
 }
 
 unsigned StaticDatabase::numericCapability(string_view _cap) const
 {
-    for (auto const tcap: numericalCaps)
-        if (tcap.name == _cap || tcap.code == _cap)
-            return tcap.value;
-
-    return npos;
+    auto const* cap = find(numericalCapsByName, numericalCapsByCode, _cap);
+    return cap ? cap->value : npos;
 }
 
 string_view StaticDatabase::stringCapability(string_view _cap) const
 {
-    for (auto const tcap: stringCaps)
-        if (tcap.name == _cap || tcap.code == _cap)
-            return tcap.value;
-
-    return {};
+    auto const* cap = find(stringCapsByName, stringCapsByCode, _cap);
+    return cap ? cap->value : string_view {};
 }
 
 optional<Code> StaticDatabase::codeFromName(string_view _name) const
 {
-    for (auto const& cap: numericalCaps)
-        if (cap.name == _name)
-            return cap.code;
-
-    for (auto const& cap: booleanCaps)
-        if (cap.name == _name)
-            return cap.code;
+    if (auto const* cap = findByName(numericalCapsByName, _name))
+        return cap->code;
 
-    for (auto const& cap: stringCaps)
-        if (cap.name == _name)
-            return cap.code;
+    if (auto const* cap = findByName(booleanCapsByName, _name))
+        return cap->code;
 
-    // using ranges::views::concat;
-    // using ranges::views::transform;
-    // auto const tr = transform([](auto cap) { return std::pair { cap.name, cap.code }; });
-    // for (auto const cap: concat(numericalCaps | tr, booleanCaps | tr, stringCaps | tr))
-    //     if (cap.first == _name)
-    //         return cap.second;
+    if (auto const* cap = findByName(stringCapsByName, _name))
+        return cap->code;
 
     return nullopt;
 }
 
 string StaticDatabase::terminfo() const
 {
-    using namespace ranges;
-
-    auto booleans = copy(booleanCaps);
-    auto numbers = copy(numericalCaps);
-    auto strings = copy(stringCaps);
+    static auto const source = []() {
+        std::stringstream output;
 
-    std::stringstream output;
+        output << "contour|contour-latest|Contour Terminal Emulator,\n";
 
-    output << "contour|contour-latest|Contour Terminal Emulator,\n";
+        for (auto const& cap: booleanCapsByName)
+            if (!cap.name.empty() && cap.value)
+                output << "    " << cap.name << ",\n";
 
-    for (auto const& cap: move(booleans) | actions::sort)
-        if (!cap.name.empty() && cap.value)
-            output << "    " << cap.name << ",\n";
+        for (auto const& cap: numericalCapsByName)
+            if (!cap.name.empty())
+                output << "    " << cap.name << "#" << cap.value << ",\n";
 
-    for (auto const& cap: move(numbers) | actions::sort)
-        if (!cap.name.empty())
-            output << "    " << cap.name << "#" << cap.value << ",\n";
+        for (auto const& cap: stringCapsByName)
+            if (!cap.name.empty())
+                output << "    " << cap.name << "=" << crispy::escape(cap.value) << ",\n";
 
-    for (auto const& cap: move(strings) | actions::sort)
-        if (!cap.name.empty())
-            output << "    " << cap.name << "=" << crispy::escape(cap.value) << ",\n";
+        return output.str();
+    }();
 
-    return output.str();
+    return source;
 }
 
 } // namespace terminal::capabilities
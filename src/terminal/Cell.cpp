@@ -18,32 +18,30 @@ namespace terminal
 
 std::u32string Cell::codepoints() const
 {
-    std::u32string s;
-    if (codepoint_)
-    {
-        s += codepoint_;
-        if (extra_)
-        {
-            for (char32_t const cp: extra_->codepoints)
-            {
-                s += cp;
-            }
-        }
-    }
-    return s;
+    auto result = std::u32string {};
+    if (GraphemeClusterTable::isCluster(codepoint_))
+        result = GraphemeClusterTable::get().at(codepoint_).text();
+    else if (codepoint_)
+        result = std::u32string(1, codepoint_);
+
+    if (extra_)
+        result += extra_->codepoints;
+
+    return result;
 }
 
 std::string Cell::toUtf8() const
 {
+    if (extra_ && !extra_->codepoints.empty())
+        return unicode::convert_to<char>(std::u32string_view(codepoints()));
+
+    if (GraphemeClusterTable::isCluster(codepoint_))
+        return unicode::convert_to<char>(GraphemeClusterTable::get().at(codepoint_).text());
+
     if (!codepoint_)
         return {};
 
-    std::string text;
-    text += unicode::convert_to<char>(codepoint_);
-    if (extra_)
-        for (char32_t const cp: extra_->codepoints)
-            text += unicode::convert_to<char>(cp);
-    return text;
+    return unicode::convert_to<char>(codepoint_);
 }
 
 } // namespace terminal
@@ -15,6 +15,7 @@
 
 #include <terminal/CellFlags.h>
 #include <terminal/ColorPalette.h>
+#include <terminal/GraphemeClusterTable.h>
 #include <terminal/GraphicsAttributes.h>
 #include <terminal/Hyperlink.h>
 #include <terminal/Image.h>
@@ -71,7 +72,7 @@ struct CONTOUR_PACKED Owned
     Owned(Owned&& v) noexcept: ptr_ { v.release() } {}
     Owned& operator=(Owned&& v) noexcept
     {
-        ptr_ = v.release();
+        reset(v.release());
         return *this;
     }
 
@@ -81,15 +82,18 @@ struct CONTOUR_PACKED Owned
 
 /// Rarely needed extra cell data.
 ///
+/// Style flags and the cell width are stored inline in the Cell,
+/// so that styled text does not require any extra allocation.
+///
 /// @see Cell
 struct CellExtra
 {
-    std::u32string codepoints = {};
     Color underlineColor = DefaultColor();
     HyperlinkId hyperlink = {};
     std::shared_ptr<ImageFragment> imageFragment = nullptr;
-    CellFlags flags = CellFlags::None;
-    uint8_t width = 1;
+
+    /// Codepoints appended to the cell's text after the GraphemeClusterTable ran full.
+    std::u32string codepoints = {};
 };
 
 /// Grid cell with character and graphics rendition information.
@@ -99,7 +103,7 @@ struct CellExtra
 class CONTOUR_PACKED Cell
 {
   public:
-    static int constexpr MaxCodepoints = 7;
+    static int constexpr MaxCodepoints = static_cast<int>(GraphemeClusterTable::MaxCodepoints);
 
     Cell() noexcept;
     Cell(Cell const& v) noexcept;
@@ -120,6 +124,14 @@ class CONTOUR_PACKED Cell
                uint8_t _width,
                HyperlinkId _hyperlink) noexcept;
 
+    /// Tests whether write() with the given arguments would leave this cell unchanged.
+    ///
+    /// A blank cell as left behind by reset() holds the codepoint 0 at a width of 1.
+    [[nodiscard]] bool holds(GraphicsAttributes const& _attributes,
+                             char32_t _ch,
+                             uint8_t _width,
+                             HyperlinkId _hyperlink) const noexcept;
+
     std::u32string codepoints() const;
     char32_t codepoint(size_t i) const noexcept;
     std::size_t codepointCount() const noexcept;
@@ -135,18 +147,14 @@ class CONTOUR_PACKED Cell
 
     bool isFlagEnabled(CellFlags testFlags) const noexcept { return styles() & testFlags; }
 
-    void resetFlags() noexcept
-    {
-        if (extra_)
-            extra_->flags = CellFlags::None;
-    }
+    void resetFlags() noexcept { flags_ = CellFlags::None; }
 
-    void setFlags(CellFlags flags, bool enable = true)
+    void setFlags(CellFlags flags, bool enable = true) noexcept
     {
         if (enable)
-            extra().flags = extra().flags | flags;
+            flags_ = flags_ | flags;
         else
-            extra().flags = CellFlags(int(extra().flags) & ~int(flags));
+            flags_ = CellFlags(int(flags_) & ~int(flags));
     }
 
     void setGraphicsRendition(GraphicsRendition sgr) noexcept;
@@ -175,15 +183,20 @@ class CONTOUR_PACKED Cell
     void setHyperlink(HyperlinkId _hyperlink);
 
     CellExtra& extra() noexcept;
+    [[nodiscard]] bool hasExtra() const noexcept { return extra_; }
 
   private:
     template <typename... Args>
     void createExtra(Args... args) noexcept;
 
     // Cell data
-    char32_t codepoint_ = 0; /// Primary Unicode codepoint to be displayed.
+    /// Unicode codepoint to be displayed, or an interned grapheme cluster
+    /// if GraphemeClusterTable::ClusterBit is set.
+    char32_t codepoint_ = 0;
     Color foregroundColor_ = DefaultColor();
     Color backgroundColor_ = DefaultColor();
+    CellFlags flags_ = CellFlags::None;
+    uint8_t width_ = 1;
     Owned<CellExtra> extra_ = {};
     // TODO(perf) ^^ use CellExtraId = boxed<int24_t> into pre-alloc'ed vector<CellExtra>.
 };
@@ -202,30 +215,25 @@ inline void Cell::createExtra(Args... args) noexcept
     }
 }
 
-inline Cell::Cell() noexcept
-{
-    setWidth(1);
-}
+inline Cell::Cell() noexcept = default;
 
-inline Cell::Cell(GraphicsAttributes const& _attributes, HyperlinkId hyperlink) noexcept
+inline Cell::Cell(GraphicsAttributes const& _attributes, HyperlinkId hyperlink) noexcept:
+    foregroundColor_ { _attributes.foregroundColor },
+    backgroundColor_ { _attributes.backgroundColor },
+    flags_ { _attributes.styles }
 {
-    setWidth(1);
     setHyperlink(hyperlink);
 
-    foregroundColor_ = _attributes.foregroundColor;
-    backgroundColor_ = _attributes.backgroundColor;
-
     if (_attributes.underlineColor != DefaultColor() || extra_)
         extra().underlineColor = _attributes.underlineColor;
-
-    if (_attributes.styles != CellFlags::None || extra_)
-        extra().flags = _attributes.styles;
 }
 
 inline Cell::Cell(Cell const& v) noexcept:
     codepoint_ { v.codepoint_ },
     foregroundColor_ { v.foregroundColor_ },
-    backgroundColor_ { v.backgroundColor_ }
+    backgroundColor_ { v.backgroundColor_ },
+    flags_ { v.flags_ },
+    width_ { v.width_ }
 {
     if (v.extra_)
         createExtra(*v.extra_);
@@ -236,8 +244,12 @@ inline Cell& Cell::operator=(Cell const& v) noexcept
     codepoint_ = v.codepoint_;
     foregroundColor_ = v.foregroundColor_;
     backgroundColor_ = v.backgroundColor_;
+    flags_ = v.flags_;
+    width_ = v.width_;
     if (v.extra_)
         createExtra(*v.extra_);
+    else
+        extra_.reset();
     return *this;
 }
 // }}}
@@ -247,6 +259,8 @@ inline void Cell::reset() noexcept
     codepoint_ = 0;
     foregroundColor_ = DefaultColor();
     backgroundColor_ = DefaultColor();
+    flags_ = CellFlags::None;
+    width_ = 1;
     extra_.reset();
 }
 
@@ -255,9 +269,9 @@ inline void Cell::reset(GraphicsAttributes const& _attributes) noexcept
     codepoint_ = 0;
     foregroundColor_ = _attributes.foregroundColor;
     backgroundColor_ = _attributes.backgroundColor;
+    flags_ = _attributes.styles;
+    width_ = 1;
     extra_.reset();
-    if (_attributes.styles != CellFlags::None)
-        extra().flags = _attributes.styles;
     if (_attributes.underlineColor != DefaultColor())
         extra().underlineColor = _attributes.underlineColor;
 }
@@ -269,18 +283,15 @@ inline void Cell::write(GraphicsAttributes const& _attributes, char32_t _ch, uin
     codepoint_ = _ch;
     if (extra_)
     {
-        extra_->codepoints.clear();
         extra_->imageFragment = {};
+        extra_->codepoints.clear();
     }
 
     foregroundColor_ = _attributes.foregroundColor;
     backgroundColor_ = _attributes.backgroundColor;
+    flags_ = _attributes.styles;
 
-    if (_attributes.styles != CellFlags::None || extra_)
-        extra().flags = _attributes.styles;
-
-    if (_attributes.underlineColor != DefaultColor())
-        extra().underlineColor = _attributes.underlineColor;
+    setUnderlineColor(_attributes.underlineColor);
 }
 
 inline void Cell::write(GraphicsAttributes const& _attributes,
@@ -293,34 +304,44 @@ inline void Cell::write(GraphicsAttributes const& _attributes,
     codepoint_ = _ch;
     if (extra_)
     {
-        extra_->codepoints.clear();
         extra_->imageFragment = {};
+        extra_->codepoints.clear();
     }
 
     foregroundColor_ = _attributes.foregroundColor;
     backgroundColor_ = _attributes.backgroundColor;
+    flags_ = _attributes.styles;
 
-    if (_attributes.styles != CellFlags::None || extra_ || _attributes.underlineColor != DefaultColor()
-        || !!_hyperlink)
+    if (extra_ || _attributes.underlineColor != DefaultColor() || !!_hyperlink)
     {
         CellExtra& ext = extra();
         ext.underlineColor = _attributes.underlineColor;
         ext.hyperlink = _hyperlink;
-        ext.flags = _attributes.styles;
     }
 }
 
+inline bool Cell::holds(GraphicsAttributes const& _attributes,
+                        char32_t _ch,
+                        uint8_t _width,
+                        HyperlinkId _hyperlink) const noexcept
+{
+    return codepoint_ == _ch && width_ == _width && foregroundColor_ == _attributes.foregroundColor
+           && backgroundColor_ == _attributes.backgroundColor && flags_ == _attributes.styles
+           && underlineColor() == _attributes.underlineColor && hyperlink() == _hyperlink
+           && !(extra_ && (extra_->imageFragment || !extra_->codepoints.empty()));
+}
+
 inline void Cell::reset(GraphicsAttributes const& _attributes, HyperlinkId _hyperlink) noexcept
 {
     codepoint_ = 0;
     foregroundColor_ = _attributes.foregroundColor;
     backgroundColor_ = _attributes.backgroundColor;
+    flags_ = _attributes.styles;
+    width_ = 1;
 
     extra_.reset();
     if (_attributes.underlineColor != DefaultColor())
         extra().underlineColor = _attributes.underlineColor;
-    if (_attributes.styles != CellFlags::None)
-        extra().flags = _attributes.styles;
     if (_hyperlink != HyperlinkId())
         extra().hyperlink = _hyperlink;
 }
@@ -328,17 +349,13 @@ inline void Cell::reset(GraphicsAttributes const& _attributes, HyperlinkId _hype
 // {{{ impl: character
 inline constexpr uint8_t Cell::width() const noexcept
 {
-    return !extra_ ? 1 : extra_->width;
-    // return static_cast<int>((codepoint_ >> 21) & 0x03); //return width_;
+    return width_;
 }
 
 inline void Cell::setWidth(uint8_t _width) noexcept
 {
     assert(_width < MaxCodepoints);
-    // codepoint_ = codepoint_ | ((_width << 21) & 0x03);
-    if (_width > 1 || extra_)
-        extra().width = _width;
-    // TODO(perf) use u32_unused_bit_mask()
+    width_ = _width;
 }
 
 inline void Cell::setCharacter(char32_t _codepoint, uint8_t _width) noexcept
@@ -349,12 +366,10 @@ inline void Cell::setCharacter(char32_t _codepoint, uint8_t _width) noexcept
 
     if (extra_)
     {
-        extra_->codepoints.clear();
         extra_->imageFragment = {};
-        extra_->width = _width;
+        extra_->codepoints.clear();
     }
-    else
-        setWidth(_width);
+    setWidth(_width);
 }
 
 inline void Cell::setCharacter(char32_t _codepoint) noexcept
@@ -362,8 +377,8 @@ inline void Cell::setCharacter(char32_t _codepoint) noexcept
     codepoint_ = _codepoint;
     if (extra_)
     {
-        extra_->codepoints.clear();
         extra_->imageFragment = {};
+        extra_->codepoints.clear();
     }
     if (_codepoint)
         setWidth(static_cast<uint8_t>(std::max(unicode::width(_codepoint), 1)));
@@ -375,42 +390,48 @@ inline int Cell::appendCharacter(char32_t _codepoint) noexcept
 {
     assert(_codepoint != 0);
 
-    CellExtra& ext = extra();
-    if (ext.codepoints.size() < MaxCodepoints - 1)
+    if (!codepoint_)
+        return 0;
+
+    if (extra_ && !extra_->codepoints.empty())
     {
-        ext.codepoints.push_back(_codepoint);
+        if (codepointCount() < GraphemeClusterTable::MaxCodepoints)
+            extra_->codepoints.push_back(_codepoint);
+        return 0;
+    }
 
-        constexpr bool AllowWidthChange = false; // TODO: make configurable
+    auto& clusters = GraphemeClusterTable::get();
+    auto const cluster = clusters.append(codepoint_, _codepoint);
+    if (!cluster)
+    {
+        // The table is full, so the cell keeps the codepoint on its own instead of dropping it.
+        if (codepointCount() < GraphemeClusterTable::MaxCodepoints)
+            extra().codepoints.push_back(_codepoint);
+        return 0;
+    }
 
-        auto const w = [&]() {
-            switch (_codepoint)
-            {
-                case 0xFE0E: return 1;
-                case 0xFE0F: return 2;
-                default: return unicode::width(_codepoint);
-            }
-        }();
+    codepoint_ = *cluster;
 
-        if (w != width() && AllowWidthChange)
-        {
-            int const diff = w - width();
-            setWidth(static_cast<uint8_t>(w));
-            return diff;
-        }
+    constexpr bool AllowWidthChange = false; // TODO: make configurable
+
+    auto const w = clusters.at(codepoint_).width;
+    if (w != width() && AllowWidthChange)
+    {
+        int const diff = w - width();
+        setWidth(w);
+        return diff;
     }
     return 0;
 }
 
 inline std::size_t Cell::codepointCount() const noexcept
 {
-    if (codepoint_)
-    {
-        if (!extra_)
-            return 1;
+    auto const extraCount = extra_ ? extra_->codepoints.size() : 0;
 
-        return 1 + extra_->codepoints.size();
-    }
-    return 0;
+    if (GraphemeClusterTable::isCluster(codepoint_))
+        return GraphemeClusterTable::get().at(codepoint_).size + extraCount;
+
+    return codepoint_ ? 1 + extraCount : 0;
 }
 
 inline bool Cell::compareText(char codepoint) const noexcept
@@ -423,23 +444,27 @@ inline bool Cell::compareText(char codepoint) const noexcept
 
 inline char32_t Cell::codepoint(size_t i) const noexcept
 {
-    if (i == 0)
+    if (GraphemeClusterTable::isCluster(codepoint_))
+    {
+        auto const& cluster = GraphemeClusterTable::get().at(codepoint_);
+        if (i < cluster.size)
+            return cluster.codepoints[i];
+        i -= cluster.size;
+    }
+    else if (i == 0)
         return codepoint_;
+    else
+        --i;
 
-    if (!extra_)
-        return 0;
-
-#if !defined(NDEBUG)
-    return extra_->codepoints.at(i - 1);
-#else
-    return extra_->codepoints[i - 1];
-#endif
+    return extra_ && i < extra_->codepoints.size() ? extra_->codepoints[i] : 0;
 }
 // }}}
 // {{{ attrs
 inline bool Cell::empty() const noexcept
 {
-    return (codepointCount() == 0 || codepoint(0) == 0x20) && !imageFragment();
+    // Avoids copying the image fragment's shared_ptr, as this is called for every cell of a trimmed line.
+    auto const first = GraphemeClusterTable::isCluster(codepoint_) ? codepoint(0) : codepoint_;
+    return (first == 0 || first == 0x20) && !(extra_ && extra_->imageFragment);
 }
 
 inline CellExtra& Cell::extra() noexcept
@@ -452,10 +477,7 @@ inline CellExtra& Cell::extra() noexcept
 
 inline CellFlags Cell::styles() const noexcept
 {
-    if (!extra_)
-        return CellFlags::None;
-    else
-        return const_cast<Cell*>(this)->extra_->flags;
+    return flags_;
 }
 
 inline Color Cell::foregroundColor() const noexcept
@@ -580,33 +602,33 @@ inline void Cell::setGraphicsRendition(GraphicsRendition _rendition) noexcept
     // 3.) clear some bits &= ~
     switch (_rendition)
     {
-        case GraphicsRendition::Reset: extra().flags = {}; break;
-        case GraphicsRendition::Bold: extra().flags |= CellFlags::Bold; break;
-        case GraphicsRendition::Faint: extra().flags |= CellFlags::Faint; break;
-        case GraphicsRendition::Italic: extra().flags |= CellFlags::Italic; break;
-        case GraphicsRendition::Underline: extra().flags |= CellFlags::Underline; break;
-        case GraphicsRendition::Blinking: extra().flags |= CellFlags::Blinking; break;
-        case GraphicsRendition::Inverse: extra().flags |= CellFlags::Inverse; break;
-        case GraphicsRendition::Hidden: extra().flags |= CellFlags::Hidden; break;
-        case GraphicsRendition::CrossedOut: extra().flags |= CellFlags::CrossedOut; break;
-        case GraphicsRendition::DoublyUnderlined: extra().flags |= CellFlags::DoublyUnderlined; break;
-        case GraphicsRendition::CurlyUnderlined: extra().flags |= CellFlags::CurlyUnderlined; break;
-        case GraphicsRendition::DottedUnderline: extra().flags |= CellFlags::DottedUnderline; break;
-        case GraphicsRendition::DashedUnderline: extra().flags |= CellFlags::DashedUnderline; break;
-        case GraphicsRendition::Framed: extra().flags |= CellFlags::Framed; break;
-        case GraphicsRendition::Overline: extra().flags |= CellFlags::Overline; break;
-        case GraphicsRendition::Normal: extra().flags &= ~(CellFlags::Bold | CellFlags::Faint); break;
-        case GraphicsRendition::NoItalic: extra().flags &= ~CellFlags::Italic; break;
+        case GraphicsRendition::Reset: flags_ = {}; break;
+        case GraphicsRendition::Bold: flags_ |= CellFlags::Bold; break;
+        case GraphicsRendition::Faint: flags_ |= CellFlags::Faint; break;
+        case GraphicsRendition::Italic: flags_ |= CellFlags::Italic; break;
+        case GraphicsRendition::Underline: flags_ |= CellFlags::Underline; break;
+        case GraphicsRendition::Blinking: flags_ |= CellFlags::Blinking; break;
+        case GraphicsRendition::Inverse: flags_ |= CellFlags::Inverse; break;
+        case GraphicsRendition::Hidden: flags_ |= CellFlags::Hidden; break;
+        case GraphicsRendition::CrossedOut: flags_ |= CellFlags::CrossedOut; break;
+        case GraphicsRendition::DoublyUnderlined: flags_ |= CellFlags::DoublyUnderlined; break;
+        case GraphicsRendition::CurlyUnderlined: flags_ |= CellFlags::CurlyUnderlined; break;
+        case GraphicsRendition::DottedUnderline: flags_ |= CellFlags::DottedUnderline; break;
+        case GraphicsRendition::DashedUnderline: flags_ |= CellFlags::DashedUnderline; break;
+        case GraphicsRendition::Framed: flags_ |= CellFlags::Framed; break;
+        case GraphicsRendition::Overline: flags_ |= CellFlags::Overline; break;
+        case GraphicsRendition::Normal: flags_ &= ~(CellFlags::Bold | CellFlags::Faint); break;
+        case GraphicsRendition::NoItalic: flags_ &= ~CellFlags::Italic; break;
         case GraphicsRendition::NoUnderline:
-            extra().flags &= ~(CellFlags::Underline | CellFlags::DoublyUnderlined | CellFlags::CurlyUnderlined
+            flags_ &= ~(CellFlags::Underline | CellFlags::DoublyUnderlined | CellFlags::CurlyUnderlined
                                | CellFlags::DottedUnderline | CellFlags::DashedUnderline);
             break;
-        case GraphicsRendition::NoBlinking: extra().flags &= ~CellFlags::Blinking; break;
-        case GraphicsRendition::NoInverse: extra().flags &= ~CellFlags::Inverse; break;
-        case GraphicsRendition::NoHidden: extra().flags &= ~CellFlags::Hidden; break;
-        case GraphicsRendition::NoCrossedOut: extra().flags &= ~CellFlags::CrossedOut; break;
-        case GraphicsRendition::NoFramed: extra().flags &= ~CellFlags::Framed; break;
-        case GraphicsRendition::NoOverline: extra().flags &= ~CellFlags::Overline; break;
+        case GraphicsRendition::NoBlinking: flags_ &= ~CellFlags::Blinking; break;
+        case GraphicsRendition::NoInverse: flags_ &= ~CellFlags::Inverse; break;
+        case GraphicsRendition::NoHidden: flags_ &= ~CellFlags::Hidden; break;
+        case GraphicsRendition::NoCrossedOut: flags_ &= ~CellFlags::CrossedOut; break;
+        case GraphicsRendition::NoFramed: flags_ &= ~CellFlags::Framed; break;
+        case GraphicsRendition::NoOverline: flags_ &= ~CellFlags::Overline; break;
     }
 }
 
@@ -71,7 +71,7 @@ class CharsetMapping
         // TODO: could surely be implemented branchless with a jump-table and computed goto.
         if (_code < 127)
         {
-            auto result = map(shift_, static_cast<char>(_code));
+            auto result = isUSASCII(shift_) ? _code : map(shift_, static_cast<char>(_code));
             shift_ = selected_;
             return result;
         }
@@ -105,19 +105,36 @@ class CharsetMapping
 
     [[nodiscard]] bool isSelected(CharsetId _id) const noexcept { return isSelected(currentTable(), _id); }
 
+    /// Tests whether the upcoming characters are mapped onto themselves, that is,
+    /// no single shift is pending and the selected table is US-ASCII.
+    ///
+    /// This holds for almost all sessions and lets bulk text skip the per-character mapping.
+    [[nodiscard]] constexpr bool isIdentity() const noexcept
+    {
+        return shift_ == selected_ && isUSASCII(selected_);
+    }
+
     void select(CharsetTable _table, CharsetId _id) noexcept
     {
         tables_[static_cast<size_t>(_table)] = charsetMap(_id);
+        auto const bit = 1u << static_cast<unsigned>(_table);
+        usasciiTables_ = _id == CharsetId::USASCII ? usasciiTables_ | bit : usasciiTables_ & ~bit;
     }
 
     constexpr CharsetTable currentTable() const noexcept { return shift_; }
 
   private:
+    [[nodiscard]] constexpr bool isUSASCII(CharsetTable _table) const noexcept
+    {
+        return usasciiTables_ & (1u << static_cast<unsigned>(_table));
+    }
+
     CharsetTable shift_ = CharsetTable::G0;
     CharsetTable selected_ = CharsetTable::G0;
 
     using Tables = std::array<CharsetMap const*, 4>;
     Tables tables_;
+    unsigned usasciiTables_ = 0b1111; // bit N is set if table GN is US-ASCII
 };
 
 } // namespace terminal
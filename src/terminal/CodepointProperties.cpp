@@ -0,0 +1,96 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CodepointProperties.h>
+
+#include <unicode/grapheme_segmenter.h>
+#include <unicode/width.h>
+
+#include <algorithm>
+#include <mutex>
+
+namespace terminal
+{
+
+namespace
+{
+    std::mutex blocksLock;            // guards filling in blocks
+    std::atomic<uint16_t> blocksUsed; // distinct blocks, including the unused one at index 0
+
+    constexpr bool isControl(char32_t _codepoint) noexcept
+    {
+        return _codepoint < 0x20 || (0x7F <= _codepoint && _codepoint < 0xA0);
+    }
+
+    uint8_t propertiesOf(char32_t _codepoint) noexcept
+    {
+        using unicode::grapheme_segmenter;
+
+        auto properties = uint8_t { 0 };
+        auto const width = unicode::width(_codepoint);
+        if (0 <= width && width <= 2)
+            properties |= static_cast<uint8_t>(width);
+        else
+            properties |= CodepointProperties::IrregularWidth;
+
+        // Against any ordinary letter, a codepoint must neither extend it (Extend, ZWJ, SpacingMark)
+        // nor be extended by it (Prepend), and it must not join with itself (Hangul jamo,
+        // regional indicators). Then it does not join with any other such codepoint either.
+        constexpr auto Letter = U'A';
+        if (!isControl(_codepoint) && grapheme_segmenter::breakable(Letter, _codepoint)
+            && grapheme_segmenter::breakable(_codepoint, Letter)
+            && grapheme_segmenter::breakable(_codepoint, _codepoint))
+            properties |= CodepointProperties::Independent;
+
+        return properties;
+    }
+} // namespace
+
+std::array<std::atomic<uint16_t>, CodepointProperties::BlockCount> CodepointProperties::_blockIndices {};
+std::array<CodepointProperties::Block, CodepointProperties::BlockCount + 1> CodepointProperties::_blocks {};
+
+uint16_t CodepointProperties::fillBlock(char32_t _blockNumber) noexcept
+{
+    auto const _ = std::lock_guard { blocksLock };
+    if (auto const index = _blockIndices[_blockNumber].load(std::memory_order_relaxed); index != 0)
+        return index;
+
+    auto block = Block {};
+    auto const first = _blockNumber << BlockBits;
+    for (size_t i = 0; i < BlockSize; ++i)
+        block[i] = propertiesOf(first + static_cast<char32_t>(i));
+
+    auto const used = std::max(blocksUsed.load(std::memory_order_relaxed), uint16_t { 1 });
+    auto const existing = std::find(_blocks.begin() + 1, _blocks.begin() + used, block);
+    auto const index = static_cast<uint16_t>(existing - _blocks.begin());
+    if (index == used)
+    {
+        _blocks[index] = block;
+        blocksUsed.store(static_cast<uint16_t>(used + 1), std::memory_order_relaxed);
+    }
+
+    _blockIndices[_blockNumber].store(index, std::memory_order_release);
+    return index;
+}
+
+int CodepointProperties::irregularWidth(char32_t _codepoint) noexcept
+{
+    return unicode::width(_codepoint);
+}
+
+size_t CodepointProperties::blockCount() noexcept
+{
+    return std::max(blocksUsed.load(std::memory_order_relaxed), uint16_t { 1 }) - size_t { 1 };
+}
+
+} // namespace terminal
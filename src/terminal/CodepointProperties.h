@@ -0,0 +1,92 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace terminal
+{
+
+/// Process-wide two-level table of the codepoint properties needed for writing text
+/// to the screen: the width, and whether a codepoint ever joins a grapheme cluster with
+/// its neighbours.
+///
+/// The first level maps each block of 256 codepoints to a block of properties, one byte each.
+/// Identical blocks (e.g. of CJK ideographs or of unassigned codepoints) are shared,
+/// so that the table for most text stays within a few kilobytes.
+///
+/// Blocks are filled in from libunicode upon first use, as its property queries cannot
+/// be evaluated at compile time. Filled in blocks are read without locking.
+class CodepointProperties
+{
+  public:
+    static constexpr char32_t MaxCodepoint = 0x10FFFF;
+    static constexpr unsigned BlockBits = 8;
+    static constexpr size_t BlockSize = size_t(1) << BlockBits;
+    static constexpr size_t BlockCount = (MaxCodepoint + 1) / BlockSize;
+
+    static constexpr uint8_t WidthMask = 0x03;
+
+    /// Neither starts nor continues a grapheme cluster, so that there is always a cluster boundary
+    /// between two of these codepoints.
+    static constexpr uint8_t Independent = 0x04;
+
+    /// The width is not within 0..2 and must be asked libunicode for.
+    static constexpr uint8_t IrregularWidth = 0x08;
+
+    /// @returns the properties of @p _codepoint.
+    [[nodiscard]] static uint8_t get(char32_t _codepoint) noexcept
+    {
+        if (_codepoint > MaxCodepoint)
+            return IrregularWidth;
+
+        auto const index = _blockIndices[_codepoint >> BlockBits].load(std::memory_order_acquire);
+        auto const block = index ? index : fillBlock(_codepoint >> BlockBits);
+        return _blocks[block][_codepoint & (BlockSize - 1)];
+    }
+
+    /// @returns the width of @p _codepoint in grid cells, just as unicode::width() does.
+    [[nodiscard]] static int width(char32_t _codepoint) noexcept
+    {
+        auto const properties = get(_codepoint);
+        if (properties & IrregularWidth)
+            return irregularWidth(_codepoint);
+        return properties & WidthMask;
+    }
+
+    /// Tests whether there is a grapheme cluster boundary between @p a and @p b for sure,
+    /// sparing most pairs of codepoints the query of the grapheme segmenter.
+    [[nodiscard]] static bool independent(char32_t a, char32_t b) noexcept
+    {
+        return get(a) & get(b) & Independent;
+    }
+
+    /// @returns the number of distinct blocks of properties filled in so far.
+    [[nodiscard]] static size_t blockCount() noexcept;
+
+  private:
+    using Block = std::array<uint8_t, BlockSize>;
+
+    static uint16_t fillBlock(char32_t _blockNumber) noexcept;
+    static int irregularWidth(char32_t _codepoint) noexcept;
+
+    // Index 0 stands for a block that has not been filled in yet.
+    static std::array<std::atomic<uint16_t>, BlockCount> _blockIndices;
+    static std::array<Block, BlockCount + 1> _blocks;
+};
+
+} // namespace terminal
@@ -0,0 +1,67 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CodepointProperties.h>
+
+#include <unicode/grapheme_segmenter.h>
+#include <unicode/width.h>
+
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+using namespace terminal;
+
+TEST_CASE("CodepointProperties.width", "[unicode]")
+{
+    auto mismatches = std::vector<uint32_t> {};
+    for (char32_t codepoint = 0; codepoint <= 0x2FFFF; ++codepoint)
+        if (CodepointProperties::width(codepoint) != unicode::width(codepoint))
+            mismatches.push_back(static_cast<uint32_t>(codepoint));
+    CHECK(mismatches.empty());
+}
+
+TEST_CASE("CodepointProperties.shared_blocks", "[unicode]")
+{
+    // The blocks of CJK ideographs are all alike.
+    (void) CodepointProperties::get(0x4E00);
+    auto const blockCount = CodepointProperties::blockCount();
+    for (char32_t codepoint = 0x4F00; codepoint < 0x9F00; codepoint += CodepointProperties::BlockSize)
+        CHECK(CodepointProperties::get(codepoint) == CodepointProperties::get(0x4E00));
+    CHECK(CodepointProperties::blockCount() == blockCount);
+}
+
+TEST_CASE("CodepointProperties.independent", "[unicode]")
+{
+    auto const samples = std::vector<char32_t> {
+        U'A',   U' ',    0x00E4, 0x0301, 0x0903, 0x094D, 0x0915, 0x0E33, 0x1100, 0x1161,
+        0x11A8, 0xAC00, 0xAC01, 0x200D, 0x2764, 0xFE0F, 0x4E00, 0x1F1E6, 0x1F1E9, 0x1F3FB,
+        0x1F600, 0x1F468, 0x110BD, 0x0600, 0x000A, 0x0085,
+    };
+
+    // Pairs told apart by the table agree with the grapheme segmenter.
+    for (char32_t const a: samples)
+        for (char32_t const b: samples)
+            if (CodepointProperties::independent(a, b))
+            {
+                INFO(static_cast<uint32_t>(a) << " " << static_cast<uint32_t>(b));
+                CHECK(unicode::grapheme_segmenter::breakable(a, b));
+            }
+
+    CHECK(CodepointProperties::independent(U'A', 0x4E00));
+    CHECK(CodepointProperties::independent(0x1F600, 0xAC00));
+    CHECK(!CodepointProperties::independent(U'e', 0x0301));     // combining mark
+    CHECK(!CodepointProperties::independent(0x1F1E6, 0x1F1E9)); // regional indicators
+    CHECK(!CodepointProperties::independent(0x1100, 0x1161));   // Hangul jamo
+    CHECK(!CodepointProperties::independent(0x200D, 0x2764));   // ZWJ
+}
@@ -22,6 +22,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <optional>
 #include <ostream>
@@ -243,6 +244,9 @@ struct CONTOUR_PACKED Color
     }
 };
 
+// Colors are compared, hashed, and resolved per cell, so they must stay a single word.
+static_assert(sizeof(Color) == sizeof(uint32_t));
+
 constexpr bool operator==(Color a, Color b) noexcept
 {
     return a.content == b.content;
@@ -317,12 +321,27 @@ struct CellBackgroundColor
 };
 using CellRGBColor = std::variant<RGBColor, CellForegroundColor, CellBackgroundColor>;
 
+constexpr bool operator==(CellForegroundColor, CellForegroundColor) noexcept
+{
+    return true;
+}
+
+constexpr bool operator==(CellBackgroundColor, CellBackgroundColor) noexcept
+{
+    return true;
+}
+
 struct CursorColor
 {
     CellRGBColor color = CellForegroundColor {};
     CellRGBColor textOverrideColor = CellBackgroundColor {};
 };
 
+inline bool operator==(CursorColor const& a, CursorColor const& b) noexcept
+{
+    return a.color == b.color && a.textOverrideColor == b.textOverrideColor;
+}
+
 // {{{ Opacity
 enum class Opacity : uint8_t
 {
@@ -345,6 +364,15 @@ constexpr Opacity& operator--(Opacity& _value) noexcept
 
 } // namespace terminal
 
+namespace std
+{
+template <>
+struct hash<terminal::Color>
+{
+    size_t operator()(terminal::Color _color) const noexcept { return hash<uint32_t>()(_color.content); }
+};
+} // namespace std
+
 namespace fmt // {{{
 {
 template <>
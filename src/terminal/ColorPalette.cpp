@@ -59,32 +59,22 @@ void ImageData::updateHash() noexcept
     // clang-format on
 }
 
-RGBColor apply(ColorPalette const& _profile, Color _color, ColorTarget _target, ColorMode mode) noexcept
+bool operator==(ColorPalette const& a, ColorPalette const& b) noexcept
 {
     // clang-format off
-    switch (_color.type())
-    {
-        case ColorType::RGB:
-            return _color.rgb();
-        case ColorType::Indexed:
-        {
-            auto const index = static_cast<size_t>(_color.index());
-            if (mode == ColorMode::Bright && index < 8)
-                return _profile.brightColor(index);
-            else if (mode == ColorMode::Dimmed && index < 8)
-                return _profile.dimColor(index);
-            else
-                return _profile.indexedColor(index);
-            break;
-        }
-        case ColorType::Bright:
-            return _profile.brightColor(static_cast<size_t>(_color.index()));
-        case ColorType::Undefined:
-        case ColorType::Default:
-            break;
-    }
+    return a.useBrightColors == b.useBrightColors
+        && a.palette == b.palette
+        && a.defaultForeground == b.defaultForeground
+        && a.defaultBackground == b.defaultBackground
+        && a.selectionForeground == b.selectionForeground
+        && a.selectionBackground == b.selectionBackground
+        && a.cursor == b.cursor
+        && a.mouseForeground == b.mouseForeground
+        && a.mouseBackground == b.mouseBackground
+        && a.hyperlinkDecoration.normal == b.hyperlinkDecoration.normal
+        && a.hyperlinkDecoration.hover == b.hyperlinkDecoration.hover
+        && equalBackgroundImages(a.backgroundImage, b.backgroundImage);
     // clang-format on
-    return _target == ColorTarget::Foreground ? _profile.defaultForeground : _profile.defaultBackground;
 }
 
 } // namespace terminal
@@ -62,6 +62,18 @@ struct BackgroundImage
     bool blur = false;
 };
 
+inline bool operator==(BackgroundImage const& a, BackgroundImage const& b) noexcept
+{
+    return a.hash == b.hash && a.opacity == b.opacity && a.blur == b.blur;
+}
+
+/// Tests whether both (optional) background images are either unset or configured equally.
+inline bool equalBackgroundImages(std::shared_ptr<BackgroundImage const> const& a,
+                                  std::shared_ptr<BackgroundImage const> const& b) noexcept
+{
+    return a == b || (a && b && *a == *b);
+}
+
 struct ColorPalette
 {
     using Palette = std::array<RGBColor, 256 + 8>;
@@ -129,13 +141,13 @@ struct ColorPalette
     [[nodiscard]] RGBColor normalColor(size_t _index) const noexcept
     {
         assert(_index < 8);
-        return palette.at(_index);
+        return palette[_index];
     }
 
     [[nodiscard]] RGBColor brightColor(size_t _index) const noexcept
     {
         assert(_index < 8);
-        return palette.at(_index + 8);
+        return palette[_index + 8];
     }
 
     [[nodiscard]] RGBColor dimColor(size_t _index) const noexcept
@@ -147,7 +159,7 @@ struct ColorPalette
     [[nodiscard]] RGBColor indexedColor(size_t _index) const noexcept
     {
         assert(_index < 256);
-        return palette.at(_index);
+        return palette[_index];
     }
 
     RGBColor defaultForeground = 0xD0D0D0_rgb;
@@ -169,6 +181,13 @@ struct ColorPalette
     std::shared_ptr<BackgroundImage const> backgroundImage;
 };
 
+bool operator==(ColorPalette const& a, ColorPalette const& b) noexcept;
+
+inline bool operator!=(ColorPalette const& a, ColorPalette const& b) noexcept
+{
+    return !(a == b);
+}
+
 enum class ColorTarget
 {
     Foreground,
@@ -182,7 +201,30 @@ enum class ColorMode
     Bright
 };
 
-RGBColor apply(ColorPalette const& profile, Color color, ColorTarget target, ColorMode mode) noexcept;
+/// Resolves the given color against the palette.
+///
+/// This is invoked for every cell's foreground and background on every frame,
+/// and is therefore defined inline, with a single palette load per resolved color.
+inline RGBColor apply(ColorPalette const& profile, Color color, ColorTarget target, ColorMode mode) noexcept
+{
+    switch (color.type())
+    {
+        case ColorType::RGB: return color.rgb();
+        case ColorType::Indexed:
+        {
+            auto const index = static_cast<size_t>(color.index());
+            if (index < 8 && mode == ColorMode::Bright)
+                return profile.brightColor(index);
+            if (index < 8 && mode == ColorMode::Dimmed)
+                return profile.dimColor(index);
+            return profile.indexedColor(index);
+        }
+        case ColorType::Bright: return profile.brightColor(static_cast<size_t>(color.index()) & 7);
+        case ColorType::Undefined:
+        case ColorType::Default: break;
+    }
+    return target == ColorTarget::Foreground ? profile.defaultForeground : profile.defaultBackground;
+}
 
 [[deprecated]] inline RGBColor apply(ColorPalette const& profile,
                                      Color color,
@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include <terminal/Color.h>
+#include <terminal/ColorPalette.h>
 
 #include <catch2/catch.hpp>
 
@@ -45,3 +46,28 @@ TEST_CASE("Color.RGB", "[Color]")
     CHECK(rgb.green == 0x34);
     CHECK(rgb.blue == 0x56);
 }
+
+TEST_CASE("ColorPalette.equality", "[Color]")
+{
+    auto a = ColorPalette {};
+    auto b = ColorPalette {};
+    CHECK(a == b);
+
+    b.palette[3] = RGBColor { 0x12, 0x34, 0x56 };
+    CHECK(a != b);
+
+    b = a;
+    b.cursor.color = RGBColor { 0xFF, 0x00, 0x00 };
+    CHECK(a != b);
+
+    b = a;
+    auto image = BackgroundImage {};
+    image.hash = crispy::StrongHash::compute("background.png");
+    a.backgroundImage = std::make_shared<BackgroundImage const>(image);
+    b.backgroundImage = std::make_shared<BackgroundImage const>(image);
+    CHECK(a == b); // equal by contents, not by identity
+
+    image.opacity = 0.5f;
+    b.backgroundImage = std::make_shared<BackgroundImage const>(image);
+    CHECK(a != b);
+}
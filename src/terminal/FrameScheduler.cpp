@@ -0,0 +1,147 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/FrameScheduler.h>
+
+#include <crispy/assert.h>
+
+#include <algorithm>
+
+using std::chrono::duration;
+using std::chrono::duration_cast;
+
+namespace terminal
+{
+
+namespace
+{
+    // Output or frames older than this many frame intervals do not count as sustained anymore.
+    constexpr int SustainedIntervals = 2;
+
+    FrameScheduler::Duration intervalOf(double refreshRate)
+    {
+        Require(refreshRate > 0.0);
+        return duration_cast<FrameScheduler::Duration>(duration<double>(1.0 / refreshRate));
+    }
+} // namespace
+
+FrameScheduler::FrameScheduler(double refreshRate, bool variableRefreshRate):
+    interval_ { intervalOf(refreshRate) }, variableRefreshRate_ { variableRefreshRate }
+{
+}
+
+void FrameScheduler::setRefreshRate(double refreshRate, bool variableRefreshRate)
+{
+    auto const _ = std::lock_guard { lock_ };
+    interval_ = intervalOf(refreshRate);
+    variableRefreshRate_ = variableRefreshRate;
+}
+
+auto FrameScheduler::frameInterval() const -> Duration
+{
+    auto const _ = std::lock_guard { lock_ };
+    return interval_;
+}
+
+void FrameScheduler::contentChanged(Timestamp now)
+{
+    auto const _ = std::lock_guard { lock_ };
+    if (!firstChange_)
+        firstChange_ = now;
+}
+
+void FrameScheduler::outputParsed(Timestamp now, bool saturated)
+{
+    auto const _ = std::lock_guard { lock_ };
+    if (saturated)
+        lastSaturation_ = now;
+    else
+        lastSaturation_.reset();
+}
+
+void FrameScheduler::frameStarted(Timestamp now)
+{
+    auto const _ = std::lock_guard { lock_ };
+    lastFrameStart_ = now;
+    frameFirstChange_ = firstChange_.value_or(now);
+    firstChange_.reset();
+}
+
+void FrameScheduler::framePresented(Timestamp now)
+{
+    auto const _ = std::lock_guard { lock_ };
+    if (!frameFirstChange_)
+        return;
+
+    auto const latency = now - *frameFirstChange_;
+    frameFirstChange_.reset();
+    ++stats_.frames;
+    stats_.lastLatency = latency;
+    stats_.maxLatency = std::max(stats_.maxLatency, latency);
+}
+
+auto FrameScheduler::nextFrameDelay(Timestamp now) -> Duration
+{
+    auto const _ = std::lock_guard { lock_ };
+    switch (modeLocked(now))
+    {
+        case Mode::Idle: break;
+        case Mode::Paced:
+            if (variableRefreshRate_)
+                return std::max(Duration::zero(), *lastFrameStart_ + interval_ - now);
+            break;
+        case Mode::Saturated: {
+            auto const delay = std::max(Duration::zero(), *lastFrameStart_ + 2 * interval_ - now);
+            if (delay > Duration::zero())
+                ++stats_.skippedFrames;
+            return delay;
+        }
+    }
+    return Duration::zero();
+}
+
+auto FrameScheduler::mode(Timestamp now) const -> Mode
+{
+    auto const _ = std::lock_guard { lock_ };
+    return modeLocked(now);
+}
+
+auto FrameScheduler::modeLocked(Timestamp now) const noexcept -> Mode
+{
+    if (!lastFrameStart_ || now - *lastFrameStart_ >= SustainedIntervals * interval_)
+        return Mode::Idle;
+
+    if (lastSaturation_ && now - *lastSaturation_ < SustainedIntervals * interval_)
+        return Mode::Saturated;
+
+    return Mode::Paced;
+}
+
+auto FrameScheduler::stats(Timestamp now) const -> Stats
+{
+    auto const _ = std::lock_guard { lock_ };
+    auto result = stats_;
+    result.mode = modeLocked(now);
+    result.frameBudget = interval_;
+    return result;
+}
+
+auto FrameScheduler::fetchAndClearStats(Timestamp now) -> Stats
+{
+    auto result = stats(now);
+    auto const _ = std::lock_guard { lock_ };
+    stats_.maxLatency = {};
+    return result;
+}
+
+} // namespace terminal
@@ -0,0 +1,141 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace terminal
+{
+
+/// Decides when to render the next frame, trading latency against throughput.
+///
+/// - The first content change after being idle is rendered right away, so that typing
+///   is echoed with the lowest possible latency.
+/// - Under sustained output, frames are paced at the display's refresh rate.
+///   On fixed refresh rate displays the buffer swap waits for vsync already, so the next frame
+///   may start right after the previous one got presented. On variable refresh rate displays
+///   nothing blocks, so frames are spaced by the minimal frame interval instead.
+/// - While the parser is saturated (the PTY keeps delivering full reads),
+///   every other frame is skipped, leaving more time to the parser.
+///
+/// The content side (contentChanged(), outputParsed()) is invoked from the terminal's I/O thread,
+/// the frame side (frameStarted(), framePresented(), nextFrameDelay()) from the render thread.
+class FrameScheduler
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Timestamp = Clock::time_point;
+    using Duration = Clock::duration;
+
+    enum class Mode
+    {
+        Idle,      //!< No frame recently, render the next change immediately.
+        Paced,     //!< Sustained output, render at the refresh rate.
+        Saturated, //!< Parser saturated, render at half the refresh rate.
+    };
+
+    struct Stats
+    {
+        Mode mode = Mode::Idle;
+        Duration frameBudget {}; // time available for rendering a single frame
+        Duration lastLatency {}; // first content change until presentation, of the last frame
+        Duration maxLatency {};  // maximum latency since the last fetchAndClearStats()
+        uint64_t frames = 0;
+        uint64_t skippedFrames = 0;
+    };
+
+    explicit FrameScheduler(double refreshRate = 60.0, bool variableRefreshRate = false);
+
+    /// Sets the display's refresh rate, in Hz.
+    ///
+    /// @param variableRefreshRate whether the display presents frames as they come
+    ///                            (and @p refreshRate is its maximum refresh rate).
+    void setRefreshRate(double refreshRate, bool variableRefreshRate = false);
+
+    [[nodiscard]] Duration frameInterval() const;
+
+    /// Records that the screen contents changed and need to be presented.
+    void contentChanged(Timestamp now);
+
+    /// Records that a chunk of PTY output has been parsed.
+    ///
+    /// @param saturated whether more output was pending already (e.g. the read filled the buffer).
+    void outputParsed(Timestamp now, bool saturated);
+
+    /// Records that a frame with all contents changed so far started rendering.
+    void frameStarted(Timestamp now);
+
+    /// Records that the last started frame has been presented on screen.
+    void framePresented(Timestamp now);
+
+    /// Returns how long to wait before rendering pending contents, zero meaning immediately.
+    [[nodiscard]] Duration nextFrameDelay(Timestamp now);
+
+    [[nodiscard]] Mode mode(Timestamp now) const;
+
+    /// Tests whether the renderer should cut corners (e.g. defer glyph rasterization).
+    [[nodiscard]] bool underPressure(Timestamp now) const { return mode(now) == Mode::Saturated; }
+
+    /// Returns the frame statistics.
+    [[nodiscard]] Stats stats(Timestamp now) const;
+
+    /// Returns the frame statistics and clears the maximum latency to start measuring anew.
+    Stats fetchAndClearStats(Timestamp now);
+
+  private:
+    [[nodiscard]] Mode modeLocked(Timestamp now) const noexcept;
+
+    mutable std::mutex lock_;
+    Duration interval_;
+    bool variableRefreshRate_;
+
+    std::optional<Timestamp> firstChange_;      // first change not yet picked up by a frame
+    std::optional<Timestamp> frameFirstChange_; // first change that the frame in flight presents
+    std::optional<Timestamp> lastFrameStart_;
+    std::optional<Timestamp> lastSaturation_;
+
+    Stats stats_ {};
+};
+
+} // namespace terminal
+
+namespace fmt // {{{
+{
+template <>
+struct formatter<terminal::FrameScheduler::Mode>
+{
+    template <typename ParseContext>
+    auto parse(ParseContext& ctx)
+    {
+        return ctx.begin();
+    }
+    template <typename FormatContext>
+    auto format(terminal::FrameScheduler::Mode _mode, FormatContext& ctx) const
+    {
+        switch (_mode)
+        {
+            case terminal::FrameScheduler::Mode::Idle: return format_to(ctx.out(), "idle");
+            case terminal::FrameScheduler::Mode::Paced: return format_to(ctx.out(), "paced");
+            case terminal::FrameScheduler::Mode::Saturated: return format_to(ctx.out(), "saturated");
+        }
+        return format_to(ctx.out(), "({})", static_cast<unsigned>(_mode));
+    }
+};
+} // namespace fmt
+// }}}
@@ -0,0 +1,104 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/FrameScheduler.h>
+
+#include <catch2/catch.hpp>
+
+using namespace std::chrono_literals;
+using terminal::FrameScheduler;
+
+namespace
+{
+// A start time far enough from the clock's epoch to subtract intervals from.
+auto const T0 = FrameScheduler::Timestamp {} + 1h;
+} // namespace
+
+TEST_CASE("FrameScheduler.idle", "[FrameScheduler]")
+{
+    auto scheduler = FrameScheduler { 100.0 };
+    CHECK(scheduler.frameInterval() == 10ms);
+    CHECK(scheduler.mode(T0) == FrameScheduler::Mode::Idle);
+
+    // The first change after a long pause is rendered immediately.
+    scheduler.contentChanged(T0);
+    CHECK(scheduler.nextFrameDelay(T0) == FrameScheduler::Duration::zero());
+
+    // After a frame, the scheduler falls back to idle once output stopped for a while.
+    scheduler.frameStarted(T0);
+    CHECK(scheduler.mode(T0 + 5ms) == FrameScheduler::Mode::Paced);
+    CHECK(scheduler.mode(T0 + 20ms) == FrameScheduler::Mode::Idle);
+}
+
+TEST_CASE("FrameScheduler.paced", "[FrameScheduler]")
+{
+    SECTION("fixed refresh rate")
+    {
+        // Buffer swaps block on vsync, so the next frame may start right away.
+        auto scheduler = FrameScheduler { 100.0 };
+        scheduler.frameStarted(T0);
+        scheduler.outputParsed(T0 + 1ms, false);
+        CHECK(scheduler.nextFrameDelay(T0 + 2ms) == FrameScheduler::Duration::zero());
+    }
+
+    SECTION("variable refresh rate")
+    {
+        // Nothing blocks, so frames are spaced by the frame interval.
+        auto scheduler = FrameScheduler { 100.0, true };
+        scheduler.frameStarted(T0);
+        scheduler.outputParsed(T0 + 1ms, false);
+        CHECK(scheduler.nextFrameDelay(T0 + 2ms) == 8ms);
+        CHECK(scheduler.nextFrameDelay(T0 + 12ms) == FrameScheduler::Duration::zero());
+    }
+}
+
+TEST_CASE("FrameScheduler.saturated", "[FrameScheduler]")
+{
+    auto scheduler = FrameScheduler { 100.0 };
+    scheduler.frameStarted(T0);
+    scheduler.outputParsed(T0 + 1ms, true);
+    CHECK(scheduler.mode(T0 + 2ms) == FrameScheduler::Mode::Saturated);
+    CHECK(scheduler.underPressure(T0 + 2ms));
+
+    // Every other frame is skipped.
+    CHECK(scheduler.nextFrameDelay(T0 + 2ms) == 18ms);
+    CHECK(scheduler.fetchAndClearStats(T0 + 2ms).skippedFrames == 1);
+
+    // A read that did not fill the buffer ends saturation.
+    scheduler.outputParsed(T0 + 3ms, false);
+    CHECK(scheduler.mode(T0 + 4ms) == FrameScheduler::Mode::Paced);
+    CHECK_FALSE(scheduler.underPressure(T0 + 4ms));
+}
+
+TEST_CASE("FrameScheduler.latency", "[FrameScheduler]")
+{
+    auto scheduler = FrameScheduler { 100.0 };
+
+    scheduler.contentChanged(T0);
+    scheduler.contentChanged(T0 + 1ms); // Only the first change of a frame counts.
+    scheduler.frameStarted(T0 + 2ms);
+    scheduler.framePresented(T0 + 5ms);
+
+    scheduler.contentChanged(T0 + 6ms);
+    scheduler.frameStarted(T0 + 7ms);
+    scheduler.framePresented(T0 + 8ms);
+
+    auto const stats = scheduler.fetchAndClearStats(T0 + 9ms);
+    CHECK(stats.mode == FrameScheduler::Mode::Paced);
+    CHECK(stats.frameBudget == 10ms);
+    CHECK(stats.frames == 2);
+    CHECK(stats.lastLatency == 2ms);
+    CHECK(stats.maxLatency == 5ms);
+
+    CHECK(scheduler.fetchAndClearStats(T0 + 9ms).maxLatency == FrameScheduler::Duration::zero());
+}
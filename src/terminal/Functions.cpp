@@ -25,9 +25,13 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <numeric>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 using crispy::for_each;
 using crispy::times;
@@ -44,7 +48,132 @@ using std::stringstream;
 namespace terminal
 {
 
+namespace
+{
+    /// Direct-indexed FunctionDefinition lookup table.
+    ///
+    /// C0, ESC, CSI and DCS functions are addressed by their (category, leader, intermediate)
+    /// prefix, which maps to a row that is then indexed by the final symbol.
+    /// OSC functions are addressed by their numeric code.
+    ///
+    /// Every entry stores the offset into functions() plus one, or 0 if unassigned.
+    /// Functions sharing the same prefix and final symbol (such as SCOSC and DECSLRM) are
+    /// adjacent in functions(), so the entry points to the first of them.
+    class FunctionIndex
+    {
+      public:
+        // clang-format off
+        static constexpr size_t CategoryCount     = 5;    // C0, ESC, CSI, OSC, DCS
+        static constexpr size_t LeaderCount       = 5;    // none, 0x3C..0x3F
+        static constexpr size_t IntermediateCount = 17;   // none, 0x20..0x2F
+        static constexpr size_t FinalCount        = 128;  // 0x00..0x7F
+        static constexpr size_t OscCodeCount      = 1024; // 10 bits (FunctionDefinition::maximumParameters)
+        // clang-format on
+
+        static_assert(std::tuple_size_v<std::decay_t<decltype(functions())>> < 0xFF,
+                      "Function table offsets must fit into uint8_t.");
+
+        FunctionIndex()
+        {
+            auto const& funcs = functions();
+            for (size_t i = 0; i < funcs.size(); ++i)
+            {
+                auto const& f = funcs[i];
+                auto const entry = static_cast<uint8_t>(i + 1);
+                if (f.category == FunctionCategory::OSC)
+                {
+                    assert(f.maximumParameters < OscCodeCount);
+                    osc_[f.maximumParameters] = entry;
+                    continue;
+                }
+
+                auto const p = prefixOf(f.category, f.leader, f.intermediate);
+                auto const finalSymbol = static_cast<uint8_t>(f.finalSymbol);
+                assert(p.has_value() && finalSymbol < FinalCount);
+                auto& row = prefixes_[*p];
+                if (!row)
+                {
+                    finals_.emplace_back();
+                    row = static_cast<uint8_t>(finals_.size());
+                }
+                if (auto& slot = finals_[row - 1u][finalSymbol]; !slot)
+                    slot = entry;
+            }
+        }
+
+        [[nodiscard]] FunctionDefinition const* select(FunctionSelector const& _selector) const noexcept
+        {
+            auto const& funcs = functions();
+
+            if (_selector.category == FunctionCategory::OSC)
+            {
+                if (_selector.argc < 0 || static_cast<size_t>(_selector.argc) >= OscCodeCount)
+                    return nullptr;
+                auto const entry = osc_[static_cast<size_t>(_selector.argc)];
+                return entry ? &funcs[entry - 1u] : nullptr;
+            }
+
+            auto const p = prefixOf(_selector.category, _selector.leader, _selector.intermediate);
+            auto const finalSymbol = static_cast<uint8_t>(_selector.finalSymbol);
+            if (!p || finalSymbol >= FinalCount || !prefixes_[*p])
+                return nullptr;
+
+            auto const entry = finals_[prefixes_[*p] - 1u][finalSymbol];
+            if (!entry)
+                return nullptr;
+
+            // Candidates only differ in their parameter count requirements.
+            for (auto i = size_t(entry - 1u); i < funcs.size(); ++i)
+            {
+                if (funcs[i].finalSymbol != _selector.finalSymbol)
+                    break;
+                if (compare(_selector, funcs[i]) == 0)
+                    return &funcs[i];
+            }
+
+            return nullptr;
+        }
+
+      private:
+        static std::optional<size_t> prefixOf(FunctionCategory _category,
+                                              char _leader,
+                                              char _intermediate) noexcept
+        {
+            auto const leader = static_cast<uint8_t>(_leader);
+            auto const intermediate = static_cast<uint8_t>(_intermediate);
+
+            size_t leaderSlot = 0;
+            if (leader >= 0x3C && leader <= 0x3F)
+                leaderSlot = 1u + leader - 0x3C;
+            else if (leader != 0)
+                return std::nullopt;
+
+            size_t intermediateSlot = 0;
+            if (intermediate >= 0x20 && intermediate <= 0x2F)
+                intermediateSlot = 1u + intermediate - 0x20;
+            else if (intermediate != 0)
+                return std::nullopt;
+
+            auto const category = static_cast<size_t>(_category);
+            if (category >= CategoryCount)
+                return std::nullopt;
+
+            return (category * LeaderCount + leaderSlot) * IntermediateCount + intermediateSlot;
+        }
+
+        std::array<uint8_t, CategoryCount * LeaderCount * IntermediateCount> prefixes_ {};
+        std::vector<std::array<uint8_t, FinalCount>> finals_;
+        std::array<uint8_t, OscCodeCount> osc_ {};
+    };
+} // namespace
+
 FunctionDefinition const* select(FunctionSelector const& _selector) noexcept
+{
+    auto static const index = FunctionIndex {};
+    return index.select(_selector);
+}
+
+FunctionDefinition const* selectBySearch(FunctionSelector const& _selector) noexcept
 {
     auto static const& funcs = functions();
 
@@ -352,6 +352,7 @@ constexpr inline auto STP         = detail::DCS(std::nullopt, 0, 0, '$', 'p', VT
 constexpr inline auto DECRQSS     = detail::DCS(std::nullopt, 0, 0, '$', 'q', VTType::VT420, "DECRQSS", "Request Status String");
 constexpr inline auto DECSIXEL    = detail::DCS(std::nullopt, 0, 3, std::nullopt, 'q', VTType::VT330, "DECSIXEL", "Sixel Graphics Image");
 constexpr inline auto XTGETTCAP   = detail::DCS(std::nullopt, 0, 0, '+', 'q', VTType::VT100, "XTGETTCAP", "Request Termcap/Terminfo String");
+constexpr inline auto TMUXCC      = detail::DCS(std::nullopt, 1, 1, std::nullopt, 'p', VTType::VT100, "TMUXCC", "Enter tmux control mode");
 
 // OSC
 constexpr inline auto SETTITLE      = detail::OSC(0, "SETINICON", "Change Window & Icon Title");
@@ -495,6 +496,7 @@ inline auto const& functions() noexcept
             DECRQSS,
             DECSIXEL,
             XTGETTCAP,
+            TMUXCC,
 
             // OSC
             SETICON,
@@ -544,6 +546,13 @@ inline auto const& functions() noexcept
 /// @return the matching FunctionDefinition or nullptr if none matched.
 FunctionDefinition const* select(FunctionSelector const& _selector) noexcept;
 
+/// Selects a FunctionDefinition based on a FunctionSelector by binary-searching functions().
+///
+/// This yields the same results as select() and mainly exists for verification and benchmarking.
+///
+/// @return the matching FunctionDefinition or nullptr if none matched.
+FunctionDefinition const* selectBySearch(FunctionSelector const& _selector) noexcept;
+
 /// Selects a FunctionDefinition based on given input Escape sequence fields.
 ///
 /// @p _intermediate an optional intermediate character between (0x20 .. 0x2F)
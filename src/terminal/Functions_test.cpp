@@ -72,3 +72,42 @@ TEST_CASE("Functions.OSC777", "[Functions]")
     REQUIRE(osc);
     CHECK(*osc == NOTIFY);
 }
+
+TEST_CASE("Functions.select_matches_search", "[Functions]")
+{
+    // The direct-indexed lookup must agree with the binary search over the sorted function table.
+    for (auto const& f: functions())
+    {
+        INFO(fmt::format("function: {}", f));
+        if (f.category == FunctionCategory::OSC)
+        {
+            auto const selector = FunctionSelector { f.category, 0, f.maximumParameters, 0, 0 };
+            CHECK(select(selector) == &f);
+            continue;
+        }
+        for (int argc = 0; argc <= 16; ++argc)
+        {
+            auto const selector =
+                FunctionSelector { f.category, f.leader, argc, f.intermediate, f.finalSymbol };
+            CHECK(select(selector) == selectBySearch(selector));
+        }
+    }
+
+    for (auto const category: { FunctionCategory::ESC, FunctionCategory::CSI, FunctionCategory::DCS })
+        for (char const leader: { '\0', '<', '=', '>', '?' })
+            for (char const intermediate: { '\0', ' ', '!', '"', '$', '(', '*', '+' })
+                for (int finalSymbol = 0x30; finalSymbol < 0x7F; ++finalSymbol)
+                    for (int argc = 0; argc <= 3; ++argc)
+                    {
+                        auto const selector = FunctionSelector {
+                            category, leader, argc, intermediate, static_cast<char>(finalSymbol)
+                        };
+                        CHECK(select(selector) == selectBySearch(selector));
+                    }
+
+    for (int code = -1; code <= 1100; ++code)
+    {
+        auto const selector = FunctionSelector { FunctionCategory::OSC, 0, code, 0, 0 };
+        CHECK(select(selector) == selectBySearch(selector));
+    }
+}
@@ -0,0 +1,228 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/CodepointProperties.h>
+#include <terminal/GraphemeClusterTable.h>
+
+#include <unicode/grapheme_segmenter.h>
+
+#include <algorithm>
+
+using std::array;
+using std::nullopt;
+using std::optional;
+
+namespace terminal
+{
+
+namespace
+{
+    constexpr char32_t MaxCodepoint = 0x10FFFF;
+
+    template <size_t Bits>
+    constexpr size_t slotOf(uint64_t key) noexcept
+    {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15llu) >> (64 - Bits));
+    }
+
+    // Direct-mapped per-thread memo of grapheme cluster boundaries.
+    // An entry packs both codepoints (21 bits each), a valid bit and the result bit.
+    struct BreakableCache
+    {
+        static constexpr size_t Bits = 10;
+        static constexpr uint64_t ValidBit = uint64_t(1) << 62;
+        static constexpr uint64_t ResultBit = uint64_t(1) << 63;
+
+        array<uint64_t, size_t(1) << Bits> entries {};
+    };
+
+    // Direct-mapped per-thread front cache of GraphemeClusterTable::append() transitions,
+    // so that repeated text does not need to take the table's lock.
+    // It belongs to the table it was last used with and is cleared when used with another one.
+    struct TransitionCache
+    {
+        static constexpr size_t Bits = 8;
+
+        uint64_t owner = 0;
+
+        struct Entry
+        {
+            uint64_t key = 0;
+            char32_t cluster = 0; // 0 if unused, a cluster always has ClusterBit set.
+        };
+
+        array<Entry, size_t(1) << Bits> entries {};
+    };
+
+    TransitionCache& transitionCache(uint64_t owner) noexcept
+    {
+        thread_local TransitionCache cache {};
+        if (cache.owner != owner)
+        {
+            cache = TransitionCache {};
+            cache.owner = owner;
+        }
+        return cache;
+    }
+
+    std::atomic<uint64_t> nextTableId = 1;
+} // namespace
+
+GraphemeClusterTable& GraphemeClusterTable::get()
+{
+    static GraphemeClusterTable instance;
+    return instance;
+}
+
+GraphemeClusterTable::GraphemeClusterTable(uint32_t capacity):
+    _id { nextTableId.fetch_add(1, std::memory_order_relaxed) }, _capacity { std::min(capacity, MaxClusters) }
+{
+    _registryId = crispy::CacheRegistry::get().add([this]() { return report(); });
+}
+
+GraphemeClusterTable::~GraphemeClusterTable()
+{
+    crispy::CacheRegistry::get().remove(_registryId);
+    for (auto& chunk: _chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+bool GraphemeClusterTable::breakable(char32_t a, char32_t b) noexcept
+{
+    // Most pairs of codepoints are told apart by their properties alone.
+    if (CodepointProperties::independent(a, b))
+        return true;
+
+    if (a > MaxCodepoint || b > MaxCodepoint)
+        return unicode::grapheme_segmenter::breakable(a, b);
+
+    thread_local BreakableCache cache {};
+
+    auto const key = (uint64_t(a) << 21) | uint64_t(b);
+    auto& entry = cache.entries[slotOf<BreakableCache::Bits>(key)];
+    if ((entry & ~BreakableCache::ResultBit) == (key | BreakableCache::ValidBit))
+        return entry & BreakableCache::ResultBit;
+
+    bool const result = unicode::grapheme_segmenter::breakable(a, b);
+    entry = key | BreakableCache::ValidBit | (result ? BreakableCache::ResultBit : 0);
+    return result;
+}
+
+auto GraphemeClusterTable::makeCluster(char32_t text, char32_t next) const noexcept -> Cluster
+{
+    auto cluster = Cluster {};
+    if (isCluster(text))
+        cluster = at(text);
+    else
+    {
+        cluster.codepoints[0] = text;
+        cluster.size = 1;
+        cluster.width = static_cast<uint8_t>(CodepointProperties::width(text));
+    }
+
+    cluster.codepoints[cluster.size++] = next;
+    switch (next)
+    {
+        case 0xFE0E: cluster.width = 1; break; // VS15: text presentation
+        case 0xFE0F: cluster.width = 2; break; // VS16: emoji presentation
+        default:
+            cluster.width =
+                static_cast<uint8_t>(std::max(int(cluster.width), CodepointProperties::width(next)));
+            break;
+    }
+    return cluster;
+}
+
+auto GraphemeClusterTable::findTransition(uint64_t key) noexcept -> Transition&
+{
+    auto const mask = _transitions.size() - 1;
+    auto const hash = key * 0x9E3779B97F4A7C15llu;
+    auto i = static_cast<size_t>(hash ^ (hash >> 32)) & mask;
+    while (_transitions[i].used && _transitions[i].key != key)
+        i = (i + 1) & mask;
+    return _transitions[i];
+}
+
+void GraphemeClusterTable::growTransitions()
+{
+    auto old = std::vector<Transition>(std::max(_transitions.size() * 2, size_t(2 * ClustersPerChunk)));
+    std::swap(old, _transitions);
+    for (Transition const& transition: old)
+        if (transition.used)
+            findTransition(transition.key) = transition;
+}
+
+optional<char32_t> GraphemeClusterTable::append(char32_t text, char32_t next)
+{
+    if (isCluster(text) && at(text).size == MaxCodepoints)
+        return nullopt;
+
+    auto const key = (uint64_t(text) << 32) | uint64_t(next);
+    auto& cached = transitionCache(_id).entries[slotOf<TransitionCache::Bits>(key)];
+    if (cached.cluster && cached.key == key)
+    {
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        return cached.cluster;
+    }
+
+    auto const _ = std::lock_guard { _lock };
+
+    if (_transitions.empty())
+        growTransitions();
+
+    if (Transition const& transition = findTransition(key); transition.used)
+    {
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        cached = { key, ClusterBit | transition.id };
+        return cached.cluster;
+    }
+
+    _misses.fetch_add(1, std::memory_order_relaxed);
+
+    auto const id = _size.load(std::memory_order_relaxed);
+    if (id == _capacity)
+        return nullopt;
+
+    auto& chunk = _chunks[id / ClustersPerChunk];
+    if (!chunk.load(std::memory_order_relaxed))
+        chunk.store(new Cluster[ClustersPerChunk], std::memory_order_release);
+
+    chunk.load(std::memory_order_relaxed)[id % ClustersPerChunk] = makeCluster(text, next);
+    _size.store(id + 1, std::memory_order_relaxed);
+
+    // Grows at most once per chunk, so all allocations happen for only one in ClustersPerChunk clusters.
+    if (2 * (id + 1) > _transitions.size())
+        growTransitions();
+    findTransition(key) = Transition { key, id, true };
+
+    cached = { key, ClusterBit | id };
+    return cached.cluster;
+}
+
+crispy::CacheReport GraphemeClusterTable::report() const
+{
+    auto const _ = std::lock_guard { _lock };
+    auto const chunkCount = (size() + ClustersPerChunk - 1) / ClustersPerChunk;
+
+    auto result = crispy::CacheReport {};
+    result.name = "Grapheme cluster table";
+    result.size = size();
+    result.capacity = _capacity;
+    result.storageSize = sizeof(GraphemeClusterTable) + chunkCount * ClustersPerChunk * sizeof(Cluster)
+                         + _transitions.size() * sizeof(Transition);
+    result.hits = _hits.load(std::memory_order_relaxed);
+    result.misses = _misses.load(std::memory_order_relaxed);
+    return result;
+}
+
+} // namespace terminal
@@ -0,0 +1,123 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <crispy/CacheRegistry.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace terminal
+{
+
+/// Process-wide table of interned multi-codepoint grapheme clusters.
+///
+/// A grid cell holds its text in a single char32_t, which is either a plain Unicode codepoint
+/// or, if ClusterBit is set, the ID of a grapheme cluster in this table.
+/// That way cells with complex text (emoji ZWJ sequences, combining marks, Indic conjuncts)
+/// do not need to allocate, and copying such a cell is as cheap as copying any other cell.
+///
+/// Clusters are only ever appended and never removed, so that an ID stays valid
+/// for the lifetime of the process and can be read without locking.
+/// Once the table is full, append() fails and Cell keeps any further codepoints
+/// in its own CellExtra instead.
+/// Each cluster is built incrementally from its base codepoint, and every
+/// (cluster, codepoint) transition as well as the resulting cluster width is memoized,
+/// so that repeated text does not hit the Unicode property lookups again.
+class GraphemeClusterTable
+{
+  public:
+    static constexpr char32_t ClusterBit = 0x8000'0000;
+    static constexpr size_t MaxCodepoints = 7;
+    static constexpr uint32_t ClustersPerChunk = 4096;
+    static constexpr uint32_t MaxChunks = 256;
+    static constexpr uint32_t MaxClusters = ClustersPerChunk * MaxChunks;
+
+    struct Cluster
+    {
+        std::array<char32_t, MaxCodepoints> codepoints {};
+        uint8_t size = 0;
+        uint8_t width = 0;
+
+        [[nodiscard]] std::u32string_view text() const noexcept { return { codepoints.data(), size }; }
+    };
+
+    static GraphemeClusterTable& get();
+
+    explicit GraphemeClusterTable(uint32_t capacity = MaxClusters);
+    ~GraphemeClusterTable();
+
+    GraphemeClusterTable(GraphemeClusterTable const&) = delete;
+    GraphemeClusterTable(GraphemeClusterTable&&) = delete;
+    GraphemeClusterTable& operator=(GraphemeClusterTable const&) = delete;
+    GraphemeClusterTable& operator=(GraphemeClusterTable&&) = delete;
+
+    [[nodiscard]] static constexpr bool isCluster(char32_t text) noexcept { return text & ClusterBit; }
+
+    /// Tests whether a grapheme cluster boundary lies between @p a and @p b (memoized).
+    [[nodiscard]] static bool breakable(char32_t a, char32_t b) noexcept;
+
+    /// Returns the cluster that results from appending @p next to @p text,
+    /// which is either a single codepoint or a cluster previously returned by this function.
+    ///
+    /// @returns the new cluster (with ClusterBit set), or std::nullopt if the cluster
+    ///          would exceed MaxCodepoints or the table is full.
+    [[nodiscard]] std::optional<char32_t> append(char32_t text, char32_t next);
+
+    /// Returns the cluster for the given @p text, which must have ClusterBit set.
+    [[nodiscard]] Cluster const& at(char32_t text) const noexcept
+    {
+        auto const id = static_cast<uint32_t>(text & ~ClusterBit);
+        return _chunks[id / ClustersPerChunk].load(std::memory_order_acquire)[id % ClustersPerChunk];
+    }
+
+    /// Returns the number of interned clusters.
+    [[nodiscard]] size_t size() const noexcept { return _size.load(std::memory_order_relaxed); }
+
+    /// Returns the number of clusters that can be interned at most.
+    [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+
+    [[nodiscard]] crispy::CacheReport report() const;
+
+  private:
+    // Slot of the open-addressing (cluster, codepoint) -> cluster index.
+    // Kept flat, so that interning a new cluster does not allocate a node.
+    struct Transition
+    {
+        uint64_t key = 0;
+        uint32_t id = 0;
+        bool used = false;
+    };
+
+    [[nodiscard]] Cluster makeCluster(char32_t text, char32_t next) const noexcept;
+    [[nodiscard]] Transition& findTransition(uint64_t key) noexcept;
+    void growTransitions();
+
+    uint64_t const _id;
+    uint32_t const _capacity;
+    mutable std::mutex _lock;
+    std::vector<Transition> _transitions; // power-of-two sized, at most half full
+    std::array<std::atomic<Cluster*>, MaxChunks> _chunks {};
+    std::atomic<uint32_t> _size = 0;
+    std::atomic<uint64_t> _hits = 0;
+    std::atomic<uint64_t> _misses = 0;
+    crispy::CacheRegistry::Id _registryId = 0;
+};
+
+} // namespace terminal
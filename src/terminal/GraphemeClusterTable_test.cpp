@@ -0,0 +1,138 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/GraphemeClusterTable.h>
+
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+using namespace std;
+using namespace terminal;
+
+TEST_CASE("GraphemeClusterTable.append", "[GraphemeClusterTable]")
+{
+    auto& clusters = GraphemeClusterTable::get();
+
+    auto const a = clusters.append(U'e', 0x0301); // e + COMBINING ACUTE ACCENT
+    REQUIRE(a.has_value());
+    CHECK(GraphemeClusterTable::isCluster(*a));
+    CHECK(clusters.at(*a).text() == U"é"sv);
+    CHECK(clusters.at(*a).width == 1);
+
+    // Interning: the same sequence always maps to the same cluster.
+    auto const sizeBefore = clusters.size();
+    CHECK(clusters.append(U'e', 0x0301) == a);
+    CHECK(clusters.size() == sizeBefore);
+
+    auto const b = clusters.append(*a, 0x0302);
+    REQUIRE(b.has_value());
+    CHECK(*b != *a);
+    CHECK(clusters.at(*b).text() == U"é̂"sv);
+}
+
+TEST_CASE("GraphemeClusterTable.grow", "[GraphemeClusterTable]")
+{
+    auto& clusters = GraphemeClusterTable::get();
+
+    // Intern more clusters than fit into one chunk, then look them all up again.
+    auto constexpr Count = char32_t { GraphemeClusterTable::ClustersPerChunk + 1000 };
+    auto ids = vector<char32_t> {};
+    for (char32_t base = 0x4E00; base < 0x4E00 + Count; ++base)
+        ids.push_back(clusters.append(base, 0x0301).value());
+
+    auto const sizeAfter = clusters.size();
+    for (char32_t i = 0; i < Count; ++i)
+    {
+        REQUIRE(clusters.append(0x4E00 + i, 0x0301) == ids[i]);
+        REQUIRE(clusters.at(ids[i]).codepoints[0] == 0x4E00 + i);
+    }
+    CHECK(clusters.size() == sizeAfter);
+}
+
+TEST_CASE("GraphemeClusterTable.width", "[GraphemeClusterTable]")
+{
+    auto& clusters = GraphemeClusterTable::get();
+
+    auto const emoji = clusters.append(0x2764, 0xFE0F); // HEAVY BLACK HEART + VS16
+    REQUIRE(emoji.has_value());
+    CHECK(clusters.at(*emoji).width == 2);
+
+    auto const text = clusters.append(0x2764, 0xFE0E); // HEAVY BLACK HEART + VS15
+    REQUIRE(text.has_value());
+    CHECK(clusters.at(*text).width == 1);
+}
+
+TEST_CASE("GraphemeClusterTable.MaxCodepoints", "[GraphemeClusterTable]")
+{
+    auto& clusters = GraphemeClusterTable::get();
+
+    auto cluster = optional<char32_t> { U'a' };
+    for (size_t i = 1; i < GraphemeClusterTable::MaxCodepoints; ++i)
+    {
+        cluster = clusters.append(*cluster, 0x0300);
+        REQUIRE(cluster.has_value());
+    }
+    CHECK(clusters.at(*cluster).size == GraphemeClusterTable::MaxCodepoints);
+    CHECK_FALSE(clusters.append(*cluster, 0x0300).has_value());
+}
+
+TEST_CASE("GraphemeClusterTable.full", "[GraphemeClusterTable]")
+{
+    auto clusters = GraphemeClusterTable { 2 };
+
+    auto const a = clusters.append(U'a', 0x0301);
+    auto const b = clusters.append(U'b', 0x0301);
+    REQUIRE(a.has_value());
+    REQUIRE(b.has_value());
+    CHECK(clusters.size() == clusters.capacity());
+
+    // Known clusters are still found, but no new one is interned.
+    CHECK(clusters.append(U'a', 0x0301) == a);
+    CHECK_FALSE(clusters.append(U'c', 0x0301).has_value());
+    CHECK(clusters.size() == 2);
+}
+
+TEST_CASE("GraphemeClusterTable.breakable", "[GraphemeClusterTable]")
+{
+    // Asking twice must yield the same (memoized) answer.
+    for (int i = 0; i < 2; ++i)
+    {
+        CHECK(GraphemeClusterTable::breakable(U'a', U'b'));
+        CHECK_FALSE(GraphemeClusterTable::breakable(U'e', 0x0301));
+        CHECK_FALSE(GraphemeClusterTable::breakable(0x1F468, 0x200D)); // MAN + ZWJ
+    }
+}
+
+TEST_CASE("GraphemeClusterTable.Cell", "[GraphemeClusterTable]")
+{
+    auto cell = Cell {};
+    cell.write(GraphicsAttributes {}, U'e', 1);
+    cell.appendCharacter(0x0301);
+
+    CHECK(cell.codepointCount() == 2);
+    CHECK(cell.codepoint(0) == U'e');
+    CHECK(cell.codepoint(1) == 0x0301);
+    CHECK(cell.codepoint(2) == 0);
+    CHECK(cell.codepoints() == U"é");
+    CHECK(cell.toUtf8() == "e\xCC\x81");
+    CHECK_FALSE(cell.hasExtra());
+
+    auto const copy = cell;
+    CHECK(copy.codepoints() == U"é");
+
+    cell.write(GraphicsAttributes {}, U'x', 1);
+    CHECK(cell.codepointCount() == 1);
+    CHECK(cell.codepoints() == U"x");
+}
@@ -14,13 +14,16 @@
 #include <terminal/Cell.h>
 #include <terminal/Grid.h>
 
+#include <crispy/PerfTrace.h>
 #include <crispy/assert.h>
 #include <crispy/logstore.h>
 
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <future>
 #include <iostream>
+#include <thread>
 
 using std::max;
 using std::min;
@@ -43,29 +46,20 @@ namespace detail
 #endif
     }
 
-    template <typename Cell>
-    gsl::span<Cell> trimRight(gsl::span<Cell> cells)
-    {
-        size_t n = cells.size();
-        while (n && cells[n - 1].empty())
-            --n;
-        return cells.subspan(0, n);
-    }
-
     template <typename Cell>
     Lines<Cell> createLines(PageSize _pageSize,
-                            LineCount _maxHistoryLineCount,
                             bool _reflowOnResize,
-                            GraphicsAttributes _initialSGR)
+                            GraphicsAttributes _initialSGR,
+                            typename Line<Cell>::Allocator const& _allocator)
     {
         auto const defaultLineFlags = _reflowOnResize ? LineFlags::Wrappable : LineFlags::None;
-        auto const totalLineCount = unbox<size_t>(_pageSize.lines + _maxHistoryLineCount);
+        auto const totalLineCount = unbox<size_t>(_pageSize.lines);
 
         Lines<Cell> lines;
         lines.reserve(totalLineCount);
 
         for ([[maybe_unused]] auto const _: ranges::views::iota(0u, totalLineCount))
-            lines.emplace_back(defaultLineFlags, _pageSize.columns, _initialSGR);
+            lines.emplace_back(defaultLineFlags, _pageSize.columns, _initialSGR, _allocator);
 
         return lines;
     }
@@ -100,7 +94,8 @@ namespace detail
             auto from = _logicalLineBuffer.begin();
             auto to = from + _newColumnCount.as<std::ptrdiff_t>();
             auto const wrappedFlag = i == 0 && _initialNoWrap ? LineFlags::None : LineFlags::Wrapped;
-            _targetLines.emplace_back(_baseFlags | wrappedFlag, LineBuffer(from, to));
+            _targetLines.emplace_back(_baseFlags | wrappedFlag,
+                                      LineBuffer(from, to, _logicalLineBuffer.get_allocator()));
             _logicalLineBuffer.erase(from, to);
             ++i;
         }
@@ -122,8 +117,8 @@ Grid<Cell>::Grid(PageSize _pageSize, bool _reflowOnResize, LineCount _maxHistory
     pageSize_ { _pageSize },
     reflowOnResize_ { _reflowOnResize },
     maxHistoryLineCount_ { _maxHistoryLineCount },
-    lines_ { detail::createLines<Cell>(
-        _pageSize, _maxHistoryLineCount, _reflowOnResize, GraphicsAttributes {}) },
+    cellPool_ { std::make_shared<crispy::SlabPool>(unbox<size_t>(_pageSize.columns) * sizeof(Cell)) },
+    lines_ { detail::createLines<Cell>(_pageSize, _reflowOnResize, GraphicsAttributes {}, cellAllocator()) },
     linesUsed_ { _pageSize.lines }
 {
     verifyState();
@@ -133,10 +128,22 @@ template <typename Cell>
 void Grid<Cell>::setMaxHistoryLineCount(LineCount _maxHistoryLineCount)
 {
     verifyState();
-    rezeroBuffers();
-    lines_.resize(unbox<size_t>(pageSize_.lines + _maxHistoryLineCount));
-    linesUsed_ = min(linesUsed_, pageSize_.lines + _maxHistoryLineCount);
+
+    // The lines for the history are created as it fills up, so only shrinking takes effect here.
+    auto const newTotalLineCount = pageSize_.lines + _maxHistoryLineCount;
+    if (LineCount::cast_from(lines_.size()) > newTotalLineCount)
+    {
+        // Keeps the newest history lines, by making the oldest kept one the first of the buffer,
+        // which leaves the dropped history lines and the unused lines at its end.
+        auto const keptHistoryLineCount = std::min(historyLineCount(), _maxHistoryLineCount);
+        rotateBuffersRight(keptHistoryLineCount);
+        rezeroBuffers();
+        lines_.resize(unbox<size_t>(newTotalLineCount));
+        rotateBuffersLeft(keptHistoryLineCount);
+        linesUsed_ = pageSize_.lines + keptHistoryLineCount;
+    }
     maxHistoryLineCount_ = _maxHistoryLineCount;
+    rebuildHistoryIndex();
     verifyState();
 }
 
@@ -144,6 +151,11 @@ template <typename Cell>
 void Grid<Cell>::clearHistory()
 {
     linesUsed_ = pageSize_.lines;
+    if (historyArchive_)
+        historyArchive_->clear();
+    clearArchivedLines();
+    markedHistoryLines_.clear();
+    logicalLineStarts_.clear();
     verifyState();
 }
 
@@ -151,8 +163,6 @@ template <typename Cell>
 void Grid<Cell>::verifyState() const
 {
 #if !defined(NDEBUG)
-    // maxHistoryLineCount_ + pageSize_.lines
-    Require(LineCount::cast_from(lines_.size()) >= totalLineCount());
     Require(LineCount::cast_from(lines_.size()) >= linesUsed_);
     Require(linesUsed_ >= pageSize_.lines);
 #endif
@@ -220,37 +230,29 @@ Cell const& Grid<Cell>::at(LineOffset _line, ColumnOffset _column) const noexcep
 }
 
 template <typename Cell>
-gsl::span<Line<Cell>> Grid<Cell>::pageAtScrollOffset(ScrollOffset _scrollOffset)
+crispy::ring_spans<Line<Cell>> Grid<Cell>::pageAtScrollOffset(ScrollOffset _scrollOffset)
 {
     Require(unbox<LineCount>(_scrollOffset) <= historyLineCount());
 
-    int const offset = -*_scrollOffset;
-    Line<Cell>* startLine = &lines_[offset];
-    auto const count = unbox<size_t>(pageSize_.lines);
-
-    return gsl::span<Line<Cell>> { startLine, count };
+    return lines_.spans(-*_scrollOffset, unbox<size_t>(pageSize_.lines));
 }
 
 template <typename Cell>
-gsl::span<Line<Cell> const> Grid<Cell>::pageAtScrollOffset(ScrollOffset _scrollOffset) const
+crispy::ring_spans<Line<Cell> const> Grid<Cell>::pageAtScrollOffset(ScrollOffset _scrollOffset) const
 {
     Require(unbox<LineCount>(_scrollOffset) <= historyLineCount());
 
-    int const offset = -*_scrollOffset;
-    Line<Cell> const* startLine = &lines_[offset];
-    auto const count = unbox<size_t>(pageSize_.lines);
-
-    return gsl::span<Line<Cell> const> { startLine, count };
+    return lines_.spans(-*_scrollOffset, unbox<size_t>(pageSize_.lines));
 }
 
 template <typename Cell>
-gsl::span<Line<Cell> const> Grid<Cell>::mainPage() const
+crispy::ring_spans<Line<Cell> const> Grid<Cell>::mainPage() const
 {
     return pageAtScrollOffset({});
 }
 
 template <typename Cell>
-gsl::span<Line<Cell>> Grid<Cell>::mainPage()
+crispy::ring_spans<Line<Cell>> Grid<Cell>::mainPage()
 {
     return pageAtScrollOffset({});
 }
@@ -259,22 +261,38 @@ gsl::span<Line<Cell>> Grid<Cell>::mainPage()
 template <typename Cell>
 gsl::span<Cell const> Grid<Cell>::lineBufferRightTrimmed(LineOffset _line) const noexcept
 {
-    return detail::trimRight(lineBuffer(_line));
+    return lineAt(_line).trim_blank_right();
 }
 
 template <typename Cell>
 std::string Grid<Cell>::lineText(LineOffset _line) const
 {
-    std::string line;
-    line.reserve(unbox<size_t>(pageSize_.columns));
-
-    for (Cell const& cell: lineBuffer(_line))
-        if (cell.codepointCount())
-            line += cell.toUtf8();
-        else
-            line += ' '; // fill character
+    // Compacted history lines are not inflated just to read them.
+    return lineAt(_line).toUtf8();
+}
 
-    return line;
+template <typename Cell>
+Line<Cell> const& Grid<Cell>::scrollbackLineAt(LineOffset _line) const
+{
+    auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+    if (_line >= historyTop)
+        return lineAt(_line);
+
+    Require(historyTop - _line <= boxed_cast<LineOffset>(archivedLineCount()));
+    auto const index = archiveIndex(_line);
+    if (auto const i = archivedLines_.find(index); i != archivedLines_.end())
+        return i->second;
+
+    // A few pages' worth of lines, so that scrolling back and forth does not decode them again.
+    auto const capacity = std::max(size_t { 256 }, 4 * unbox<size_t>(pageSize_.lines));
+    while (archivedLineOrder_.size() >= capacity)
+    {
+        archivedLines_.erase(archivedLineOrder_.front());
+        archivedLineOrder_.pop_front();
+    }
+    archivedLineOrder_.push_back(index);
+    return archivedLines_.emplace(index, historyArchive_->decode<Cell>(index, pageSize_.columns))
+        .first->second;
 }
 
 template <typename Cell>
@@ -311,54 +329,51 @@ void Grid<Cell>::setLineText(LineOffset _line, std::string_view _text)
 template <typename Cell>
 bool Grid<Cell>::isLineBlank(LineOffset _line) const noexcept
 {
-    auto const is_blank = [](auto const& _cell) noexcept {
-        return _cell.empty();
-    };
-
-    auto const line = lineBuffer(_line);
-    return std::all_of(line.begin(), line.end(), is_blank);
+    return lineAt(_line).usedColumns() == ColumnCount(0);
 }
 
 /**
  * Computes the relative line number for the bottom-most @p _n logical lines.
+ *
+ * Only the main page is scanned, the logical lines beginning in the history are looked up
+ * in the logical line index instead.
  */
 template <typename Cell>
 int Grid<Cell>::computeLogicalLineNumberFromBottom(LineCount _n) const noexcept
 {
-    int logicalLineCount = 0;
-    auto outputRelativePhysicalLine = *pageSize_.lines - 1;
-
-    auto i = lines_.rbegin();
-    while (i != lines_.rend())
-    {
-        if (!i->wrapped())
-            logicalLineCount++;
-        outputRelativePhysicalLine--;
-        ++i;
-        if (logicalLineCount == *_n)
-            break;
-    }
-
-    // XXX If the top-most logical line is reached, we still need to traverse upwards until the
-    // beginning of the top-most logical line (the one that does not have the wrapped-flag set).
-    while (i != lines_.rend() && i->wrapped())
-    {
-        // printf("further upwards: l %d, p %d\n", logicalLineCount, outputRelativePhysicalLine);
-        outputRelativePhysicalLine--;
-        ++i;
-    }
-
-    return outputRelativePhysicalLine;
+    auto remaining = unbox<int64_t>(_n);
+    if (remaining <= 0)
+        return unbox<int>(pageSize_.lines);
+
+    for (auto line = boxed_cast<LineOffset>(pageSize_.lines) - 1; line >= LineOffset(0); --line)
+        if (!lineAt(line).wrapped() && --remaining == 0)
+            return unbox<int>(line);
+
+    // The logical line that line 0 may be continuing is the newest one in the index.
+    auto const historyStarts = static_cast<int64_t>(logicalLineStarts_.size());
+    if (remaining > historyStarts)
+        return -unbox<int>(historyLineCount());
+    return static_cast<int>(logicalLineStarts_[static_cast<size_t>(historyStarts - remaining)]
+                            - historyLineBase_);
 }
 // }}}
 // {{{ Grid impl: scrolling
 template <typename Cell>
 LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttributes _defaultAttributes) noexcept
 {
+    CONTOUR_PERF_TRACE("Grid::scrollUp");
     verifyState();
+
+    // Grows the buffer geometrically as the history fills, up to its maximum size.
+    auto const currentLineCount = LineCount::cast_from(lines_.size());
+    auto const neededLineCount = linesUsed_ + linesCountToScrollUp;
+    if (neededLineCount > currentLineCount && currentLineCount < totalLineCount())
+        growBuffers(std::min(totalLineCount(), std::max(neededLineCount, currentLineCount * 2)));
+
     if (unbox<size_t>(linesUsed_) == lines_.size()) // with all grid lines in-use
     {
         // TODO: ensure explicit test for this case
+        archiveOldestLines(linesCountToScrollUp);
         rotateBuffersLeft(linesCountToScrollUp);
 
         // Initialize (/reset) new lines.
@@ -367,6 +382,8 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
              ++y)
             lineAt(y).reset(defaultLineFlags(), _defaultAttributes);
 
+        indexScrolledLines(linesCountToScrollUp);
+        compactColdHistory(linesCountToScrollUp);
         return linesCountToScrollUp;
     }
     else
@@ -386,12 +403,13 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
             Require(unbox<size_t>(linesUsed_) <= lines_.size());
             fill_n(next(lines_.begin(), *pageSize_.lines),
                    unbox<size_t>(linesAppendCount),
-                   Line<Cell> { defaultLineFlags(), pageSize_.columns, _defaultAttributes });
+                   Line<Cell> { defaultLineFlags(), pageSize_.columns, _defaultAttributes, cellAllocator() });
             rotateBuffersLeft(linesAppendCount);
         }
         if (linesAppendCount < linesCountToScrollUp)
         {
             auto const incrementCount = linesCountToScrollUp - linesAppendCount;
+            archiveOldestLines(incrementCount);
             rotateBuffersLeft(incrementCount);
 
             // Initialize (/reset) new lines.
@@ -400,13 +418,268 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
                  ++y)
                 lineAt(y).reset(defaultLineFlags(), _defaultAttributes);
         }
+        indexScrolledLines(linesCountToScrollUp);
+        compactColdHistory(linesCountToScrollUp);
         return LineCount::cast_from(linesAppendCount);
     }
 }
 
+template <typename Cell>
+void Grid<Cell>::growBuffers(LineCount _newLineCount)
+{
+    Require(LineCount::cast_from(lines_.size()) <= _newLineCount);
+
+    // Makes the oldest history line the first of the buffer, so that appending
+    // puts the new lines behind the unused ones, which follow the main page.
+    auto const historyLines = historyLineCount();
+    rotateBuffersRight(historyLines);
+    rezeroBuffers();
+    lines_.reserve(unbox<size_t>(_newLineCount));
+    while (LineCount::cast_from(lines_.size()) < _newLineCount)
+        lines_.emplace_back(defaultLineFlags(), pageSize_.columns, GraphicsAttributes {}, cellAllocator());
+    rotateBuffersLeft(historyLines);
+}
+
+template <typename Cell>
+void Grid<Cell>::archiveOldestLines(LineCount _n)
+{
+    if (!historyArchive_)
+        return;
+
+    auto const oldestLine = -boxed_cast<LineOffset>(historyLineCount());
+    auto const count = std::min(_n, historyLineCount());
+    for (auto line = oldestLine; line < oldestLine + boxed_cast<LineOffset>(count); ++line)
+        historyArchive_->append(lineAt(line));
+}
+
+template <typename Cell>
+void Grid<Cell>::compactColdHistory(LineCount _n)
+{
+    auto const coldDistance = unbox<int>(pageSize_.lines) * ColdHistoryPageCount;
+    auto const lastDistance = std::min(coldDistance + unbox<int>(_n), unbox<int>(historyLineCount()));
+    compactHistoryLines(coldDistance + 1, lastDistance);
+}
+
+template <typename Cell>
+size_t Grid<Cell>::compactHistory()
+{
+    return compactHistoryLines(1, unbox<int>(historyLineCount()));
+}
+
+template <typename Cell>
+size_t Grid<Cell>::compactHistoryLines(int _nearestDistance, int _farthestDistance)
+{
+    auto constexpr ColdTextBufferSize = size_t { 64 * 1024 };
+
+    auto totalBytesSaved = size_t { 0 };
+    for (auto distance = _nearestDistance; distance <= _farthestDistance; ++distance)
+    {
+        Line<Cell>& line = lineAt(LineOffset::cast_from(-distance));
+        if (!line.isInflatedBuffer())
+            continue;
+
+        if (!coldTextBuffer_ || coldTextBuffer_->bytesAvailable() < unbox<size_t>(pageSize_.columns))
+            coldTextBuffer_ = crispy::BufferObject::create(ColdTextBufferSize);
+
+        if (auto const bytesSaved = line.deflate(*coldTextBuffer_); bytesSaved != 0)
+        {
+            ++coldHistoryStats_.linesCompacted;
+            coldHistoryStats_.bytesSaved += bytesSaved;
+            totalBytesSaved += bytesSaved;
+        }
+    }
+    return totalBytesSaved;
+}
+
+template <typename Cell>
+LineCount Grid<Cell>::spillHistory(LineCount _n)
+{
+    if (!historyArchive_)
+        return LineCount(0);
+
+    auto const count = std::min(_n, historyLineCount());
+    archiveOldestLines(count);
+
+    // Releases the cells of the spilled lines, which are left behind as unused lines.
+    auto const oldestLine = -boxed_cast<LineOffset>(historyLineCount());
+    for (auto line = oldestLine; line < oldestLine + boxed_cast<LineOffset>(count); ++line)
+        lineAt(line).reset(defaultLineFlags(), GraphicsAttributes {});
+
+    linesUsed_ -= count;
+    pruneHistoryIndex();
+    verifyState();
+    return count;
+}
+
+// }}}
+// {{{ Grid impl: marker and logical line index
+template <typename Cell>
+std::optional<LineOffset> Grid<Cell>::findMarkerUpwards(LineOffset _line) const
+{
+    // The main page is small and mutable, so it is scanned rather than indexed.
+    for (auto i = _line - 1; i >= LineOffset(0); --i)
+        if (lineAt(i).marked())
+            return i;
+
+    auto const limit = historyLineId(std::min(_line, LineOffset(0)));
+    auto const i = std::lower_bound(markedHistoryLines_.begin(), markedHistoryLines_.end(), limit);
+    if (i == markedHistoryLines_.begin())
+        return std::nullopt;
+
+    auto const line = LineOffset::cast_from(*std::prev(i) - historyLineBase_);
+    if (line < -boxed_cast<LineOffset>(historyLineCount()))
+        return std::nullopt;
+    return line;
+}
+
+template <typename Cell>
+std::optional<LineOffset> Grid<Cell>::findMarkerDownwards(LineOffset _line, LineOffset _bottom) const
+{
+    if (_line < LineOffset(-1))
+    {
+        auto const oldest = historyLineId(-boxed_cast<LineOffset>(historyLineCount()));
+        auto const limit = std::max(historyLineId(_line), oldest - 1);
+        auto const i = std::upper_bound(markedHistoryLines_.begin(), markedHistoryLines_.end(), limit);
+        if (i != markedHistoryLines_.end())
+        {
+            if (auto const line = LineOffset::cast_from(*i - historyLineBase_); line <= _bottom)
+                return line;
+            return std::nullopt;
+        }
+    }
+
+    for (auto i = std::max(_line + 1, LineOffset(0)); i <= _bottom; ++i)
+        if (lineAt(i).marked())
+            return i;
+
+    return std::nullopt;
+}
+
+template <typename Cell>
+LineOffset Grid<Cell>::logicalLineTop(LineOffset _line) const noexcept
+{
+    auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+    if (_line < historyTop)
+    {
+        // Archived lines are walked along their flags, just like the oldest history line begins
+        // a logical line in any case, the newest archived line ends one.
+        auto const archiveTop = historyTop - boxed_cast<LineOffset>(archivedLineCount());
+        _line = std::max(_line, archiveTop);
+        while (_line > archiveTop && archivedLineWrapped(_line))
+            --_line;
+        return _line;
+    }
+
+    while (_line >= LineOffset(0) && _line > historyTop && lineAt(_line).wrapped())
+        --_line;
+    if (_line >= LineOffset(0) || _line <= historyTop)
+        return std::max(_line, historyTop);
+
+    auto const i =
+        std::upper_bound(logicalLineStarts_.begin(), logicalLineStarts_.end(), historyLineId(_line));
+    if (i == logicalLineStarts_.begin())
+        return historyTop;
+    return std::max(LineOffset::cast_from(*std::prev(i) - historyLineBase_), historyTop);
+}
+
+template <typename Cell>
+LineOffset Grid<Cell>::logicalLineBottom(LineOffset _line) const noexcept
+{
+    if (auto const historyTop = -boxed_cast<LineOffset>(historyLineCount()); _line < historyTop)
+    {
+        while (_line + 1 < historyTop && archivedLineWrapped(_line + 1))
+            ++_line;
+        return _line;
+    }
+
+    if (_line < LineOffset(-1))
+    {
+        auto const i =
+            std::upper_bound(logicalLineStarts_.begin(), logicalLineStarts_.end(), historyLineId(_line));
+        if (i != logicalLineStarts_.end())
+            return LineOffset::cast_from(*i - historyLineBase_) - 1;
+
+        // The logical line continues up to the newest history line at least.
+        _line = LineOffset(-1);
+    }
+
+    auto const pageBottom = boxed_cast<LineOffset>(pageSize_.lines) - 1;
+    while (_line < pageBottom && lineAt(_line + 1).wrapped())
+        ++_line;
+    return _line;
+}
+
+template <typename Cell>
+void Grid<Cell>::indexScrolledLines(LineCount _n)
+{
+    historyLineBase_ += unbox<int64_t>(_n);
+
+    auto const count = std::min(_n, historyLineCount());
+    for (auto line = -boxed_cast<LineOffset>(count); line < LineOffset(0); ++line)
+    {
+        if (lineAt(line).marked())
+            markedHistoryLines_.push_back(historyLineId(line));
+        if (!lineAt(line).wrapped())
+            logicalLineStarts_.push_back(historyLineId(line));
+    }
+
+    pruneHistoryIndex();
+}
+
+template <typename Cell>
+void Grid<Cell>::unindexScrolledLines(LineCount _n)
+{
+    historyLineBase_ -= unbox<int64_t>(_n);
+
+    // The newest history lines moved back into the main page.
+    for (auto* index: { &markedHistoryLines_, &logicalLineStarts_ })
+        while (!index->empty() && index->back() >= historyLineBase_)
+            index->pop_back();
+
+    // The oldest history positions now hold lines that have not been indexed yet.
+    auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+    auto const count = std::min(_n, historyLineCount());
+    auto const firstKnownId = historyLineId(historyTop + boxed_cast<LineOffset>(count));
+    for (auto* index: { &markedHistoryLines_, &logicalLineStarts_ })
+        while (!index->empty() && index->front() < firstKnownId)
+            index->pop_front();
+    for (auto line = historyTop + boxed_cast<LineOffset>(count) - 1; line >= historyTop; --line)
+    {
+        if (lineAt(line).marked())
+            markedHistoryLines_.push_front(historyLineId(line));
+        if (!lineAt(line).wrapped())
+            logicalLineStarts_.push_front(historyLineId(line));
+    }
+}
+
+template <typename Cell>
+void Grid<Cell>::pruneHistoryIndex()
+{
+    auto const oldestId = historyLineId(-boxed_cast<LineOffset>(historyLineCount()));
+    for (auto* index: { &markedHistoryLines_, &logicalLineStarts_ })
+        while (!index->empty() && index->front() < oldestId)
+            index->pop_front();
+}
+
+template <typename Cell>
+void Grid<Cell>::rebuildHistoryIndex()
+{
+    markedHistoryLines_.clear();
+    logicalLineStarts_.clear();
+    for (auto line = -boxed_cast<LineOffset>(historyLineCount()); line < LineOffset(0); ++line)
+    {
+        if (lineAt(line).marked())
+            markedHistoryLines_.push_back(historyLineId(line));
+        if (!lineAt(line).wrapped())
+            logicalLineStarts_.push_back(historyLineId(line));
+    }
+}
+// }}}
+// {{{ Grid impl: margin scrolling
 template <typename Cell>
 LineCount Grid<Cell>::scrollUp(LineCount _n, GraphicsAttributes _defaultAttributes, Margin _margin) noexcept
 {
+    CONTOUR_PERF_TRACE("Grid::scrollUp (margin)");
     verifyState();
     Require(0 <= *_margin.horizontal.from && *_margin.horizontal.to < *pageSize_.columns);
     Require(0 <= *_margin.vertical.from && *_margin.vertical.to < *pageSize_.lines);
@@ -457,10 +730,12 @@ LineCount Grid<Cell>::scrollUp(LineCount _n, GraphicsAttributes _defaultAttribut
         for (LineOffset targetLineOffset = topTargetLineOffset; targetLineOffset <= bottomTargetLineOffset;
              ++targetLineOffset)
         {
+            // Source cells are either moved again or reset afterwards,
+            // so they can be moved rather than copied.
             auto const sourceLineOffset = targetLineOffset + *n;
             auto t = &useCellAt(targetLineOffset, _margin.horizontal.from);
             auto s = &at(sourceLineOffset, _margin.horizontal.from);
-            std::copy_n(s, columnsToMove, t);
+            std::move(s, s + columnsToMove, t);
         }
 
         for (LineOffset line = _margin.vertical.to - *n + 1; line <= _margin.vertical.to; ++line)
@@ -507,8 +782,9 @@ void Grid<Cell>::scrollDown(LineCount v_n,
         // bottom N lines are wiped out
 
         rotateBuffersRight(n);
+        unindexScrolledLines(n);
 
-        for (Line<Cell>& line: mainPage().subspan(0, unbox<size_t>(n)))
+        for (Line<Cell>& line: lines_.spans(0, unbox<size_t>(n)))
             line.reset(defaultLineFlags(), _defaultAttributes);
         return;
     }
@@ -528,11 +804,13 @@ void Grid<Cell>::scrollDown(LineCount v_n,
         // a full "inside" scroll-down
         if (n <= _margin.vertical.length())
         {
-            for (LineOffset line = _margin.vertical.to; line >= _margin.vertical.to - *n; --line)
+            // Source cells are either moved again or reset afterwards,
+            // so they can be moved rather than copied.
+            for (LineOffset line = _margin.vertical.to; line >= _margin.vertical.from + *n; --line)
             {
                 auto s = &at(line - *n, _margin.horizontal.from);
                 auto t = &at(line, _margin.horizontal.from);
-                std::copy_n(s, unbox<size_t>(_margin.horizontal.length()), t);
+                std::move(s, s + unbox<size_t>(_margin.horizontal.length()), t);
             }
 
             for (LineOffset line = _margin.vertical.from; line < _margin.vertical.from + *n; ++line)
@@ -575,6 +853,8 @@ void Grid<Cell>::reset()
     lines_.rotate_right(lines_.zero_index());
     for (int i = 0; i < unbox<int>(pageSize_.lines); ++i)
         lines_[i].reset(defaultLineFlags(), GraphicsAttributes {});
+    markedHistoryLines_.clear();
+    logicalLineStarts_.clear();
     verifyState();
 }
 
@@ -600,28 +880,97 @@ CellLocation Grid<Cell>::growLines(LineCount _newHeight, CellLocation _cursor)
         cursorMove.line += boxed_cast<LineOffset>(linesToTakeFromSavedLines);
     }
 
-    auto const wrappableFlag = lines_.back().wrappableFlag();
     auto const totalLinesToExtend = _newHeight - pageSize_.lines;
     Require(*totalLinesToExtend >= 0);
     // ? Require(linesToTakeFromSavedLines == LineCount(0));
 
-    auto const newTotalLineCount = maxHistoryLineCount_ + _newHeight;
-    auto const currentTotalLineCount = LineCount::cast_from(lines_.size());
-    auto const linesToFill = max(0, *newTotalLineCount - *currentTotalLineCount);
-
-    for ([[maybe_unused]] auto const _: ranges::views::iota(0, linesToFill))
-        lines_.emplace_back(wrappableFlag, pageSize_.columns, GraphicsAttributes {});
+    if (auto const neededLineCount = linesUsed_ + totalLinesToExtend;
+        LineCount::cast_from(lines_.size()) < neededLineCount)
+        growBuffers(neededLineCount);
 
     pageSize_.lines += totalLinesToExtend;
     linesUsed_ = min(linesUsed_ + totalLinesToExtend, LineCount::cast_from(lines_.size()));
 
     Ensures(pageSize_.lines == _newHeight);
-    Ensures(lines_.size() >= unbox<size_t>(maxHistoryLineCount_ + pageSize_.lines));
+    Ensures(lines_.size() >= unbox<size_t>(linesUsed_));
     verifyState();
 
     return cursorMove;
 }
 
+namespace
+{
+    /// Minimum number of lines for a reflow to be split across multiple threads.
+    constexpr auto ParallelReflowLineThreshold = 8192;
+
+    /// Minimum number of lines per reflow range, keeping thread handoff cheap in relation to work.
+    constexpr auto MinReflowRangeLines = 2048;
+
+    constexpr auto MaxReflowRanges = 8;
+} // namespace
+
+template <typename Cell>
+template <typename ReflowRange>
+Lines<Cell> Grid<Cell>::reflowLogicalLines(ReflowRange const& _reflowRange)
+{
+    auto const first = -unbox<int>(historyLineCount());
+    auto const last = unbox<int>(pageSize_.lines);
+    auto const lineCount = last - first;
+    auto const threadCount = min({ static_cast<int>(std::thread::hardware_concurrency()),
+                                   lineCount / MinReflowRangeLines,
+                                   MaxReflowRanges });
+
+    if (lineCount < ParallelReflowLineThreshold || threadCount < 2)
+    {
+        Lines<Cell> output;
+        output.reserve(static_cast<size_t>(lineCount));
+        _reflowRange(first, last, output);
+        return output;
+    }
+
+    // Every range but the first one begins at the beginning of a logical line, that is the first
+    // one at or below an equal share of lines. The page lines are not indexed and scanned instead.
+    auto const rangeCount = static_cast<size_t>(threadCount);
+    auto bounds = vector<int>(rangeCount + 1, last);
+    bounds.front() = first;
+    for (size_t i = 1; i < rangeCount; ++i)
+    {
+        auto const share = first + lineCount * static_cast<int>(i) / threadCount;
+        auto bound = max(unbox<int>(logicalLineBottom(LineOffset(share - 1))) + 1, bounds[i - 1]);
+        while (bound < last && lines_[bound].wrapped())
+            ++bound;
+        bounds[i] = bound;
+    }
+
+    auto outputs = vector<Lines<Cell>>(rangeCount);
+    auto const reflowRange = [&](size_t _range) {
+        outputs[_range].reserve(static_cast<size_t>(bounds[_range + 1] - bounds[_range]));
+        _reflowRange(bounds[_range], bounds[_range + 1], outputs[_range]);
+    };
+
+    // The ranges' cells are (re-)allocated from the slab pool by all threads at the same time.
+    cellPool_->setConcurrent(true);
+    auto workers = vector<std::future<void>>();
+    workers.reserve(rangeCount - 1);
+    for (size_t i = 1; i < rangeCount; ++i)
+        workers.emplace_back(std::async(std::launch::async, reflowRange, i));
+    reflowRange(0);
+    for (auto& worker: workers)
+        worker.get();
+    cellPool_->setConcurrent(false);
+
+    auto totalLineCount = size_t { 0 };
+    for (auto const& output: outputs)
+        totalLineCount += output.size();
+
+    Lines<Cell> lines;
+    lines.reserve(totalLineCount);
+    for (auto& output: outputs)
+        for (auto& line: output)
+            lines.emplace_back(std::move(line));
+    return lines;
+}
+
 template <typename Cell>
 CellLocation Grid<Cell>::resize(PageSize _newSize, CellLocation _currentCursorPos, bool _wrapPending)
 {
@@ -630,6 +979,10 @@ CellLocation Grid<Cell>::resize(PageSize _newSize, CellLocation _currentCursorPo
 
     GridLog()("resize {} -> {} (cursor {})", pageSize_, _newSize, _currentCursorPos);
 
+    // Lines of the new width are carved out of the slab pool from now on.
+    cellPool_->setBlockSize(unbox<size_t>(_newSize.columns) * sizeof(Cell));
+    clearArchivedLines();
+
     // Growing in line count with scrollback lines present will move
     // the scrollback lines into the visible area.
     //
@@ -709,55 +1062,73 @@ CellLocation Grid<Cell>::resize(PageSize _newSize, CellLocation _currentCursorPo
             auto const extendCount = _newColumnCount - pageSize_.columns;
             Require(*extendCount > 0);
 
-            Lines<Cell> grownLines;
-            LineBuffer
-                logicalLineBuffer; // Temporary state, representing wrapped columns from the line "below".
-            LineFlags logicalLineFlags = LineFlags::None;
+            auto const reflowRange = [&](int _first, int _last, Lines<Cell>& grownLines) {
+                // Temporary state, representing wrapped columns from the line "below".
+                LineBuffer logicalLineBuffer { cellAllocator() };
+                LineFlags logicalLineFlags = LineFlags::None;
 
-            auto const appendToLogicalLine = [&logicalLineBuffer](gsl::span<Cell const> cells) {
-                for (auto const& cell: cells)
-                    logicalLineBuffer.push_back(cell);
-            };
+                auto const appendToLogicalLine = [&logicalLineBuffer](gsl::span<Cell const> cells) {
+                    for (auto const& cell: cells)
+                        logicalLineBuffer.push_back(cell);
+                };
 
-            auto const flushLogicalLine =
-                [_newColumnCount, &grownLines, &logicalLineBuffer, &logicalLineFlags]() {
-                    if (!logicalLineBuffer.empty())
+                auto const flushLogicalLine =
+                    [_newColumnCount, &grownLines, &logicalLineBuffer, &logicalLineFlags]() {
+                        if (!logicalLineBuffer.empty())
+                        {
+                            detail::addNewWrappedLines(grownLines,
+                                                       _newColumnCount,
+                                                       move(logicalLineBuffer),
+                                                       logicalLineFlags,
+                                                       true);
+                            logicalLineBuffer.clear();
+                        }
+                    };
+
+                [[maybe_unused]] auto const logLogicalLine =
+                    [&logicalLineBuffer]([[maybe_unused]] LineFlags lineFlags,
+                                         [[maybe_unused]] std::string_view msg) {
+                        GridLog()("{} |> \"{}\"", msg, Line<Cell>(lineFlags, logicalLineBuffer).toUtf8());
+                    };
+
+                for (int i = _first; i < _last; ++i)
+                {
+                    auto& line = lines_[i];
+                    // logLogicalLine(line.flags(), fmt::format("Line[{:>2}]: next line: \"{}\"", i,
+                    // line.toUtf8()));
+                    Require(line.size() >= pageSize_.columns);
+
+                    // The range ends in front of a logical line's beginning, if not at the bottom.
+                    auto const isSingleLine = !line.wrapped() && (i + 1 == _last || !lines_[i + 1].wrapped());
+                    if (isSingleLine && line.isTrivialBuffer())
                     {
-                        detail::addNewWrappedLines(
-                            grownLines, _newColumnCount, move(logicalLineBuffer), logicalLineFlags, true);
-                        logicalLineBuffer.clear();
+                        // Fast path: a trivial line not being part of a wrapped logical line
+                        // does not need to be unpacked for being reflowed.
+                        flushLogicalLine();
+                        line.resize(_newColumnCount);
+                        grownLines.emplace_back(std::move(line));
+                        continue;
                     }
-                };
-
-            [[maybe_unused]] auto const logLogicalLine =
-                [&logicalLineBuffer]([[maybe_unused]] LineFlags lineFlags,
-                                     [[maybe_unused]] std::string_view msg) {
-                    GridLog()("{} |> \"{}\"", msg, Line<Cell>(lineFlags, logicalLineBuffer).toUtf8());
-                };
-
-            for (int i = -*historyLineCount(); i < *pageSize_.lines; ++i)
-            {
-                auto& line = lines_[i];
-                // logLogicalLine(line.flags(), fmt::format("Line[{:>2}]: next line: \"{}\"", i,
-                // line.toUtf8()));
-                Require(line.size() >= pageSize_.columns);
 
-                if (line.wrapped())
-                {
-                    // logLogicalLine(line.flags(), fmt::format(" - appending: \"{}\"",
-                    // line.toUtf8Trimmed()));
-                    appendToLogicalLine(line.trim_blank_right());
-                }
-                else // line is not wrapped
-                {
-                    flushLogicalLine();
-                    // logLogicalLine(line.flags(), " - start new logical line");
-                    appendToLogicalLine(line.cells());
-                    logicalLineFlags = line.flags() & ~LineFlags::Wrapped;
+                    if (line.wrapped())
+                    {
+                        // logLogicalLine(line.flags(), fmt::format(" - appending: \"{}\"",
+                        // line.toUtf8Trimmed()));
+                        appendToLogicalLine(line.trim_blank_right());
+                    }
+                    else // line is not wrapped
+                    {
+                        flushLogicalLine();
+                        // logLogicalLine(line.flags(), " - start new logical line");
+                        appendToLogicalLine(line.cells());
+                        logicalLineFlags = line.flags() & ~LineFlags::Wrapped;
+                    }
                 }
-            }
 
-            flushLogicalLine(); // Flush last (bottom) line, if anything pending.
+                flushLogicalLine(); // Flush last (bottom) line, if anything pending.
+            };
+
+            auto grownLines = reflowLogicalLines(reflowRange);
 
             // auto diff = int(lines_.size()) - unbox<int>(pageSize_.lines);
             auto cy = LineCount(0);
@@ -767,18 +1138,14 @@ CellLocation Grid<Cell>::resize(PageSize _newSize, CellLocation _currentCursorPo
                 // so fill the gap until we have a full page.
                 cy = pageSize_.lines - LineCount::cast_from(grownLines.size());
                 while (LineCount::cast_from(grownLines.size()) < pageSize_.lines)
-                    grownLines.emplace_back(defaultLineFlags(), _newColumnCount, GraphicsAttributes {});
+                    grownLines.emplace_back(
+                        defaultLineFlags(), _newColumnCount, GraphicsAttributes {}, cellAllocator());
 
                 Ensures(LineCount::cast_from(grownLines.size()) == pageSize_.lines);
             }
 
+            // Further lines for the history are created as it fills up again.
             linesUsed_ = LineCount::cast_from(grownLines.size());
-
-            // Fill scrollback lines.
-            auto const totalLineCount = unbox<size_t>(pageSize_.lines + maxHistoryLineCount_);
-            while (grownLines.size() < totalLineCount)
-                grownLines.emplace_back(defaultLineFlags(), _newColumnCount, GraphicsAttributes {});
-
             lines_ = move(grownLines);
             pageSize_.columns = _newColumnCount;
 
@@ -832,55 +1199,49 @@ CellLocation Grid<Cell>::resize(PageSize _newSize, CellLocation _currentCursorPo
             // "e "     Wrapped
             // }}}
 
-            Lines<Cell> shrinkedLines;
-            LineBuffer wrappedColumns;
-            LineFlags previousFlags = lines_.front().inheritableFlags();
-
-            auto const totalLineCount = unbox<size_t>(pageSize_.lines + maxHistoryLineCount_);
-            shrinkedLines.reserve(totalLineCount);
-            Require(totalLineCount == unbox<size_t>(this->totalLineCount()));
-
-            auto numLinesWritten = LineCount(0);
-            for (auto i = -*historyLineCount(); i < *pageSize_.lines; ++i)
-            {
-                auto& line = lines_[i];
+            auto const reflowRange = [&](int _first, int _last, Lines<Cell>& shrinkedLines) {
+                LineBuffer wrappedColumns;
+                LineFlags previousFlags = LineFlags::None; // assigned by the first line
 
-                // do we have previous columns carried?
-                if (!wrappedColumns.empty())
+                for (auto i = _first; i < _last; ++i)
                 {
-                    if (line.wrapped() && line.inheritableFlags() == previousFlags)
+                    auto& line = lines_[i];
+
+                    // do we have previous columns carried?
+                    if (!wrappedColumns.empty())
                     {
-                        // Prepend previously wrapped columns into current line.
-                        auto& editable = line.inflatedBuffer();
-                        editable.insert(editable.begin(), wrappedColumns.begin(), wrappedColumns.end());
+                        if (line.wrapped() && line.inheritableFlags() == previousFlags)
+                        {
+                            // Prepend previously wrapped columns into current line.
+                            auto& editable = line.inflatedBuffer();
+                            editable.insert(editable.begin(), wrappedColumns.begin(), wrappedColumns.end());
+                        }
+                        else
+                        {
+                            // Insert NEW line(s) between previous and this line with previously wrapped
+                            // columns.
+                            detail::addNewWrappedLines(
+                                shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
+                            previousFlags = line.inheritableFlags();
+                        }
                     }
                     else
                     {
-                        // Insert NEW line(s) between previous and this line with previously wrapped columns.
-                        auto const numLinesInserted = detail::addNewWrappedLines(
-                            shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
-                        numLinesWritten += numLinesInserted;
                         previousFlags = line.inheritableFlags();
                     }
-                }
-                else
-                {
-                    previousFlags = line.inheritableFlags();
-                }
 
-                wrappedColumns = line.reflow(_newColumnCount);
+                    wrappedColumns = line.reflow(_newColumnCount);
 
-                shrinkedLines.emplace_back(std::move(line));
-                numLinesWritten++;
-                Ensures(shrinkedLines.back().size() >= _newColumnCount);
-            }
-            numLinesWritten += detail::addNewWrappedLines(
-                shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
-            Require(unbox<size_t>(numLinesWritten) == shrinkedLines.size());
-            Require(numLinesWritten >= pageSize_.lines);
+                    shrinkedLines.emplace_back(std::move(line));
+                    Ensures(shrinkedLines.back().size() >= _newColumnCount);
+                }
+                detail::addNewWrappedLines(
+                    shrinkedLines, _newColumnCount, move(wrappedColumns), previousFlags, false);
+            };
 
-            while (shrinkedLines.size() < totalLineCount)
-                shrinkedLines.emplace_back(LineFlags::None, _newColumnCount, GraphicsAttributes {});
+            auto shrinkedLines = reflowLogicalLines(reflowRange);
+            auto const numLinesWritten = LineCount::cast_from(shrinkedLines.size());
+            Require(numLinesWritten >= pageSize_.lines);
 
             shrinkedLines.rotate_left(
                 unbox<size_t>(numLinesWritten - pageSize_.lines)); // maybe to be done outisde?
@@ -922,6 +1283,7 @@ CellLocation Grid<Cell>::resize(PageSize _newSize, CellLocation _currentCursorPo
     }
 
     Ensures(pageSize_ == _newSize);
+    rebuildHistoryIndex();
     verifyState();
 
     return cursor;
@@ -956,7 +1318,9 @@ void Grid<Cell>::appendNewLines(LineCount _count, GraphicsAttributes _attr)
     if (auto const n = std::min(_count, pageSize_.lines); *n > 0)
     {
         generate_n(
-            back_inserter(lines_), *n, [&]() { return Line<Cell>(wrappableFlag, pageSize_.columns, _attr); });
+            back_inserter(lines_), *n, [&]() {
+                return Line<Cell>(wrappableFlag, pageSize_.columns, _attr, cellAllocator());
+            });
         clampHistory();
     }
 }
@@ -987,6 +1351,34 @@ std::ostream& dumpGrid(std::ostream& os, Grid<Cell> const& grid)
     return os;
 }
 
+template <typename Cell>
+GridMemoryUsage Grid<Cell>::memoryUsage() const
+{
+    auto usage = GridMemoryUsage {};
+    usage.lines = lines_.size();
+    usage.bytes = lines_.size() * sizeof(Line<Cell>);
+    for (Line<Cell> const& line: lines_.storage())
+    {
+        if (line.isTrivialBuffer())
+        {
+            ++usage.trivialLines;
+            usage.textBytes += line.trivialBuffer().text.size();
+            continue;
+        }
+
+        auto const& cells = line.inflatedBuffer();
+        ++usage.inflatedLines;
+        usage.cells += cells.size();
+        usage.bytes += cells.capacity() * sizeof(Cell);
+        for (Cell const& cell: cells)
+            if (cell.hasExtra())
+                ++usage.cellExtras;
+    }
+    usage.bytes += usage.cellExtras * sizeof(CellExtra);
+    usage.cellPoolBytes = cellPool_->storageSize();
+    return usage;
+}
+
 template <typename Cell>
 std::string dumpGrid(Grid<Cell> const& grid)
 {
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <terminal/GraphicsAttributes.h>
+#include <terminal/HistoryArchive.h>
 #include <terminal/Line.h>
 #include <terminal/primitives.h>
 
@@ -32,9 +33,13 @@
 
 #include <algorithm>
 #include <array>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 
 namespace terminal
@@ -373,6 +378,27 @@ struct ReverseLogicalLines
  *       1                          pageSize.columns
  * </pre>
  */
+/// Accumulated statistics about history lines that have been compacted
+/// into the cold history tier.
+struct ColdHistoryStats
+{
+    size_t linesCompacted = 0;
+    size_t bytesSaved = 0;
+};
+
+/// Breakdown of the memory held by a grid's lines, including the scrollback.
+struct GridMemoryUsage
+{
+    size_t lines = 0;         //!< number of allocated lines, including unused scrollback lines
+    size_t trivialLines = 0;  //!< lines stored as trivially styled text
+    size_t inflatedLines = 0; //!< lines stored as one Cell per column
+    size_t cells = 0;         //!< number of cells allocated by inflated lines
+    size_t cellExtras = 0;    //!< number of cells with a CellExtra allocated
+    size_t textBytes = 0;     //!< bytes of text referenced by trivial lines (held by buffer objects)
+    size_t bytes = 0;         //!< estimated bytes held by the lines, excluding textBytes
+    size_t cellPoolBytes = 0; //!< bytes reserved by the grid's cell slab pool, used or not
+};
+
 template <typename Cell>
 class Grid
 {
@@ -395,6 +421,105 @@ class Grid
         return std::min(maxHistoryLineCount_, linesUsed_ - pageSize_.lines);
     }
 
+    /// Number of pages a history line must be away from the main page
+    /// before it is compacted into the cold history tier.
+    static constexpr int ColdHistoryPageCount = 2;
+
+    [[nodiscard]] ColdHistoryStats const& coldHistoryStats() const noexcept { return coldHistoryStats_; }
+
+    /// Computes the memory held by all lines of this grid.
+    ///
+    /// This visits every cell of every inflated line and is meant for diagnostics only.
+    [[nodiscard]] GridMemoryUsage memoryUsage() const;
+
+    /// Estimates the memory held by this grid's lines in constant time, that is,
+    /// the line objects and the storage reserved for their cells.
+    [[nodiscard]] size_t estimatedMemoryUsage() const noexcept
+    {
+        return lines_.size() * sizeof(Line<Cell>) + cellPool_->storageSize();
+    }
+
+    /// Compacts all history lines into trivially styled lines where possible,
+    /// regardless of their distance to the main page.
+    ///
+    /// @returns the number of bytes saved.
+    size_t compactHistory();
+
+    /// Moves the @p _n oldest history lines out of the scrollback into the history archive.
+    ///
+    /// @returns the number of lines spilled, which is 0 if no archive is attached.
+    LineCount spillHistory(LineCount _n);
+
+    /// Attaches an archive that history lines are appended to when being evicted
+    /// from the scrollback, rather than dropping them.
+    void setHistoryArchive(std::shared_ptr<HistoryArchive> _archive) noexcept
+    {
+        historyArchive_ = std::move(_archive);
+        clearArchivedLines();
+    }
+    [[nodiscard]] HistoryArchive const* historyArchive() const noexcept { return historyArchive_.get(); }
+
+    /// @returns the number of lines evicted from the scrollback into the history archive.
+    [[nodiscard]] LineCount archivedLineCount() const noexcept
+    {
+        return historyArchive_ ? LineCount::cast_from(historyArchive_->size()) : LineCount(0);
+    }
+
+    /// @returns the number of lines above the main page that can be scrolled to,
+    ///          that is, the history lines and the archived lines above them.
+    [[nodiscard]] LineCount scrollbackLineCount() const noexcept
+    {
+        return historyLineCount() + archivedLineCount();
+    }
+
+    /// Gets the line at @p _line, which may also be an archived line above the history,
+    /// down to -scrollbackLineCount().
+    ///
+    /// The archive's line index makes any archived line accessible in constant time. Archived lines
+    /// are decoded on first access, and the most recently decoded ones are kept for the next frames.
+    [[nodiscard]] Line<Cell> const& scrollbackLineAt(LineOffset _line) const;
+
+    /// Finds the closest marked line above @p _line.
+    ///
+    /// Marked history lines are looked up in an index, so this takes logarithmic time
+    /// in the number of marked history lines, rather than linear time in the history size.
+    [[nodiscard]] std::optional<LineOffset> findMarkerUpwards(LineOffset _line) const;
+
+    /// Finds the closest marked line below @p _line, up to and including @p _bottom.
+    [[nodiscard]] std::optional<LineOffset> findMarkerDownwards(LineOffset _line, LineOffset _bottom) const;
+
+    /// Returns the top-most line of the logical line that @p _line is part of.
+    ///
+    /// The beginnings of logical lines in the history are looked up in an index, so this takes
+    /// logarithmic time in the number of history lines at most, no matter how long the logical line is.
+    [[nodiscard]] LineOffset logicalLineTop(LineOffset _line) const noexcept;
+
+    /// Returns the bottom-most line of the logical line that @p _line is part of.
+    [[nodiscard]] LineOffset logicalLineBottom(LineOffset _line) const noexcept;
+
+    /// Invokes @p _visit with the hyperlink ID of every cell in the history and main page that has one.
+    ///
+    /// This is how HyperlinkStorage learns which hyperlinks are still referred to.
+    template <typename Visitor>
+    void forEachHyperlink(Visitor&& _visit) const
+    {
+        for (auto line = -boxed_cast<LineOffset>(historyLineCount());
+             line < boxed_cast<LineOffset>(pageSize_.lines);
+             ++line)
+        {
+            auto const& lineBuffer = lineAt(line);
+            if (lineBuffer.isTrivialBuffer())
+            {
+                if (auto const id = lineBuffer.trivialBuffer().hyperlink; !!id)
+                    _visit(id);
+                continue;
+            }
+            for (Cell const& cell: lineBuffer.cells())
+                if (auto const id = cell.hyperlink(); !!id)
+                    _visit(id);
+        }
+    }
+
     [[nodiscard]] bool reflowOnResize() const noexcept { return reflowOnResize_; }
     void setReflowOnResize(bool _enabled) { reflowOnResize_ = _enabled; }
 
@@ -442,10 +567,14 @@ class Grid
     [[nodiscard]] Cell const& at(LineOffset _line, ColumnOffset _column) const noexcept;
 
     // page view API
-    gsl::span<Line<Cell>> pageAtScrollOffset(ScrollOffset _scrollOffset);
-    gsl::span<Line<Cell> const> pageAtScrollOffset(ScrollOffset _scrollOffset) const;
-    gsl::span<Line<Cell>> mainPage();
-    gsl::span<Line<Cell> const> mainPage() const;
+    //
+    // A page may wrap around the end of the line buffer, so it is returned as up to two
+    // contiguous spans of lines. Pages reaching into the history archive are not contiguous at all,
+    // so these are to be walked using scrollbackLineAt() instead (see scrollbackLineCount()).
+    crispy::ring_spans<Line<Cell>> pageAtScrollOffset(ScrollOffset _scrollOffset);
+    crispy::ring_spans<Line<Cell> const> pageAtScrollOffset(ScrollOffset _scrollOffset) const;
+    crispy::ring_spans<Line<Cell>> mainPage();
+    crispy::ring_spans<Line<Cell> const> mainPage() const;
 
     LogicalLines<Cell> logicalLines()
     {
@@ -492,6 +621,18 @@ class Grid
     template <typename RendererT>
     void render(RendererT&& _render, ScrollOffset _scrollOffset = {}) const;
 
+    /// Renders the screen lines [_first, _last) by passing their grid cells to the callback.
+    ///
+    /// Unlike render(), the callback's finish() is not invoked, so that disjoint line ranges
+    /// of the same frame can be rendered independently (and concurrently) of one another.
+    ///
+    /// When scrolled into the history, this may include the line(s) below the page.
+    template <typename RendererT>
+    void renderLines(RendererT&& _render,
+                     ScrollOffset _scrollOffset,
+                     LineOffset _first,
+                     LineOffset _last) const;
+
     /// Takes text-screenshot of the main page.
     [[nodiscard]] std::string renderMainPageText() const;
 
@@ -512,6 +653,60 @@ class Grid
     void appendNewLines(LineCount _count, GraphicsAttributes _attr);
     void clampHistory();
 
+    /// Compacts the @p _n history lines that just crossed the cold history boundary
+    /// back into trivially styled lines, where possible.
+    ///
+    /// Compacted lines are transparently inflated again when being accessed.
+    void compactColdHistory(LineCount _n);
+
+    /// Compacts the history lines between the given distances to the main page, inclusive.
+    size_t compactHistoryLines(int _nearestDistance, int _farthestDistance);
+
+    /// Appends the @p _n oldest history lines to the history archive, if one is attached,
+    /// as they are about to be evicted from the scrollback.
+    void archiveOldestLines(LineCount _n);
+
+    /// @returns the archive index of the archived line at @p _line, above the history.
+    [[nodiscard]] size_t archiveIndex(LineOffset _line) const noexcept
+    {
+        auto const historyTop = -boxed_cast<LineOffset>(historyLineCount());
+        return historyArchive_->size() - unbox<size_t>(historyTop - _line);
+    }
+
+    /// Tests whether the archived line at @p _line, above the history, continues the line above it.
+    [[nodiscard]] bool archivedLineWrapped(LineOffset _line) const noexcept
+    {
+        return (historyArchive_->flags(archiveIndex(_line)) & LineFlags::Wrapped) != LineFlags::None;
+    }
+
+    /// Drops the archived lines decoded by scrollbackLineAt().
+    void clearArchivedLines() noexcept
+    {
+        archivedLines_.clear();
+        archivedLineOrder_.clear();
+    }
+
+    // {{{ history index helpers
+    /// Identifies the history line at offset @p _line (which is negative) independently of its offset.
+    [[nodiscard]] int64_t historyLineId(LineOffset _line) const noexcept
+    {
+        return historyLineBase_ + unbox<int64_t>(_line);
+    }
+
+    /// Adds the @p _n lines that just scrolled into the history to the marker and logical line indices.
+    void indexScrolledLines(LineCount _n);
+
+    /// Removes the @p _n newest history lines, that were just moved back into the main page,
+    /// from the indices, and indexes the lines that took over the oldest history positions.
+    void unindexScrolledLines(LineCount _n);
+
+    /// Drops index entries of lines no longer in the history.
+    void pruneHistoryIndex();
+
+    /// Re-populates the indices from scratch, for when history offsets changed in arbitrary ways.
+    void rebuildHistoryIndex();
+    // }}}
+
     // {{{ buffer helpers
     void resizeBuffers(PageSize _newSize)
     {
@@ -520,6 +715,25 @@ class Grid
         pageSize_ = _newSize;
     }
 
+    [[nodiscard]] typename Line<Cell>::Allocator cellAllocator() const
+    {
+        return typename Line<Cell>::Allocator { cellPool_ };
+    }
+
+    /// Rewraps the lines of the history and the main page, returning the rewrapped lines.
+    ///
+    /// @p _reflowRange(first, last, output) rewraps the lines in [first, last), which always
+    /// span whole logical lines, appending the results to output. Large grids are split into
+    /// ranges located with the logical line index, which are rewrapped concurrently and then
+    /// spliced together in order.
+    template <typename ReflowRange>
+    [[nodiscard]] Lines<Cell> reflowLogicalLines(ReflowRange const& _reflowRange);
+
+    /// Grows the buffer to @p _newLineCount lines, keeping the order of the used lines.
+    ///
+    /// The new lines are unused ones, placed right below the main page.
+    void growBuffers(LineCount _newLineCount);
+
     void rezeroBuffers() noexcept { lines_.rezero(); }
 
     void rotateBuffers(int offset) noexcept { lines_.rotate(offset); }
@@ -535,13 +749,39 @@ class Grid
     bool reflowOnResize_ = false;
     LineCount maxHistoryLineCount_;
 
-    // Number of lines is at least the sum of maxHistoryLineCount_ + pageSize_.lines,
-    // because shrinking the page height does not necessarily
-    // have to resize the array (as optimization).
+    // Slab pool the cells of inflated lines are allocated from, one line-sized block each.
+    // Declared before lines_, as the lines are created with it.
+    std::shared_ptr<crispy::SlabPool> cellPool_;
+
+    // Lines are created as the history fills up, growing the buffer geometrically
+    // up to maxHistoryLineCount_ + pageSize_.lines. Shrinking the page height
+    // does not necessarily have to resize the array (as optimization).
     Lines<Cell> lines_;
 
     // Number of lines used in the Lines buffer.
     LineCount linesUsed_;
+
+    // Text storage of history lines that have been compacted into the cold history tier.
+    crispy::BufferObjectPtr coldTextBuffer_;
+    ColdHistoryStats coldHistoryStats_;
+
+    std::shared_ptr<HistoryArchive> historyArchive_;
+
+    // Archived lines decoded by scrollbackLineAt(), by archive index, and their indices in the
+    // order they were decoded in, so that the least recently decoded ones are dropped first.
+    mutable std::unordered_map<size_t, Line<Cell>> archivedLines_;
+    mutable std::deque<size_t> archivedLineOrder_;
+
+    // The history line at offset -N is identified as (historyLineBase_ - N), so scrolling lines
+    // into the history just increments the base, without touching any identifiers.
+    int64_t historyLineBase_ = 0;
+
+    // Identifiers of the marked history lines (see historyLineId()) in ascending order.
+    std::deque<int64_t> markedHistoryLines_;
+
+    // Identifiers of the history lines beginning a logical line, i.e. not being wrapped,
+    // in ascending order. The oldest history line begins one in any case.
+    std::deque<int64_t> logicalLineStarts_;
 };
 
 template <typename Cell>
@@ -566,32 +806,57 @@ constexpr LineCount Grid<Cell>::linesUsed() const noexcept
 template <typename Cell>
 bool Grid<Cell>::isLineWrapped(LineOffset _line) const noexcept
 {
-    return _line >= -boxed_cast<LineOffset>(historyLineCount())
-           && boxed_cast<LineCount>(_line) < pageSize_.lines && lineAt(_line).wrapped();
+    if (_line < -boxed_cast<LineOffset>(historyLineCount()))
+        return _line >= -boxed_cast<LineOffset>(scrollbackLineCount()) && archivedLineWrapped(_line);
+
+    return boxed_cast<LineCount>(_line) < pageSize_.lines && lineAt(_line).wrapped();
 }
 
 template <typename Cell>
 template <typename RendererT>
 void Grid<Cell>::render(RendererT&& _render, ScrollOffset _scrollOffset) const
 {
-    assert(!_scrollOffset || unbox<LineCount>(_scrollOffset) <= historyLineCount());
+    renderLines(_render, _scrollOffset, LineOffset(0), boxed_cast<LineOffset>(pageSize_.lines));
+    _render.finish();
+}
 
-    auto y = LineOffset(0);
-    for (int i = -*_scrollOffset, e = i + *pageSize_.lines; i != e; ++i, ++y)
-    {
+template <typename Cell>
+template <typename RendererT>
+void Grid<Cell>::renderLines(RendererT&& _render,
+                             ScrollOffset _scrollOffset,
+                             LineOffset _first,
+                             LineOffset _last) const
+{
+    assert(!_scrollOffset || unbox<LineCount>(_scrollOffset) <= scrollbackLineCount());
+    assert(LineOffset(0) <= _first && _first <= _last);
+    assert(_last - boxed_cast<LineOffset>(_scrollOffset) <= boxed_cast<LineOffset>(pageSize_.lines));
+
+    auto const renderLine = [&](Line<Cell> const& _line, LineOffset _y) {
         auto x = ColumnOffset(0);
-        Line<Cell> const& line = lines_[i];
-        if (line.isTrivialBuffer())
-            _render.renderTrivialLine(line.trivialBuffer(), y);
+        if (_render.tryReuseLine(_y, _line.generation()))
+            return;
+        if (_line.isTrivialBuffer())
+            _render.renderTrivialLine(_line.trivialBuffer(), _y);
         else
         {
-            _render.startLine(y);
-            for (Cell const& cell: line.cells())
-                _render.renderCell(cell, y, x++);
+            _render.startLine(_y);
+            for (Cell const& cell: _line.cells())
+                _render.renderCell(cell, _y, x++);
             _render.endLine();
         }
+    };
+
+    // Lines reaching above the history into the archive are looked up one by one.
+    if (_first - boxed_cast<LineOffset>(_scrollOffset) < -boxed_cast<LineOffset>(historyLineCount()))
+    {
+        for (auto y = _first; y != _last; ++y)
+            renderLine(scrollbackLineAt(y - boxed_cast<LineOffset>(_scrollOffset)), y);
+        return;
     }
-    _render.finish();
+
+    auto nextLine = _first;
+    for (Line<Cell> const& line: lines_.spans(*_first - *_scrollOffset, unbox<size_t>(_last - _first)))
+        renderLine(line, nextLine++);
 }
 // }}}
 
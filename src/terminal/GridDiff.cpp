@@ -0,0 +1,118 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/GridDiff.h>
+
+#include <algorithm>
+
+using std::vector;
+
+namespace terminal
+{
+
+namespace
+{
+    /// Returns by how many lines the page scrolled up since @p _previous, or 0 if it did not.
+    ///
+    /// A page line that was on the page before, further down, moved up by that distance.
+    size_t scrolledLineCount(vector<uint64_t> const& _previous, vector<uint64_t> const& _current)
+    {
+        for (size_t line = 0; line < _current.size(); ++line)
+        {
+            auto const i = std::find(_previous.begin(), _previous.end(), _current[line]);
+            if (i == _previous.end())
+                continue;
+
+            auto const previousLine = static_cast<size_t>(std::distance(_previous.begin(), i));
+            return previousLine > line ? previousLine - line : 0;
+        }
+        return 0;
+    }
+} // namespace
+
+template <typename Cell>
+size_t GridDiffWriter<Cell>::write(Grid<Cell> const& _grid, CellLocation _cursor, VTWriter& _writer)
+{
+    auto const pageLines = unbox<size_t>(_grid.pageSize().lines);
+
+    auto current = vector<uint64_t>(pageLines);
+    for (size_t line = 0; line < pageLines; ++line)
+        current[line] = _grid.lineAt(LineOffset::cast_from(line)).generation();
+
+    if (generations_.size() != pageLines)
+    {
+        // Reset margins and start over on a blank page.
+        _writer.write("\033[m\033[r\033[H\033[2J");
+        generations_.assign(pageLines, 0);
+    }
+    else if (auto const scrolled = scrolledLineCount(generations_, current); scrolled != 0)
+    {
+        _writer.write("\033[{}S", scrolled);
+        auto const distance = static_cast<ptrdiff_t>(scrolled);
+        std::rotate(generations_.begin(), generations_.begin() + distance, generations_.end());
+        std::fill(generations_.end() - distance, generations_.end(), 0);
+    }
+
+    auto writtenLineCount = size_t { 0 };
+    for (size_t line = 0; line < pageLines; ++line)
+    {
+        if (generations_[line] == current[line])
+            continue;
+
+        // Erasing the line first keeps the last column intact if the line fills it,
+        // as the cursor is left pending to wrap there.
+        _writer.write("\033[{}H\033[2K", line + 1);
+        _writer.write(_grid.lineAt(LineOffset::cast_from(line)));
+        generations_[line] = current[line];
+        ++writtenLineCount;
+    }
+
+    _writer.write("\033[{};{}H", unbox<int>(_cursor.line) + 1, unbox<int>(_cursor.column) + 1);
+    return writtenLineCount;
+}
+
+template <typename Cell>
+bool GridDiffWriter<Cell>::writeModes(MirroredModes const& _modes, VTWriter& _writer)
+{
+    if (modes_ == _modes)
+        return false;
+
+    auto const all = !modes_.has_value();
+    auto const previous = modes_.value_or(_modes);
+    auto const writeMode = [&](DECMode _mode, bool _enabled, bool _previous) {
+        if (all || _enabled != _previous)
+            _writer.write("\033[?{}{}", toDECModeNum(_mode), _enabled ? 'h' : 'l');
+    };
+
+    writeMode(
+        DECMode::UseApplicationCursorKeys, _modes.applicationCursorKeys, previous.applicationCursorKeys);
+    if (all || _modes.applicationKeypad != previous.applicationKeypad)
+        _writer.write(std::string_view(_modes.applicationKeypad ? "\033=" : "\033>"));
+    writeMode(DECMode::VisibleCursor, _modes.visibleCursor, previous.visibleCursor);
+    writeMode(DECMode::BracketedPaste, _modes.bracketedPaste, previous.bracketedPaste);
+    writeMode(DECMode::FocusTracking, _modes.focusTracking, previous.focusTracking);
+
+    // Mouse modes are disabled before any is enabled, as enabling one may replace another.
+    for (auto const enable: { false, true })
+        for (size_t i = 0; i < MirroredModes::MouseModes.size(); ++i)
+            if (_modes.mouseModes[i] == enable)
+                writeMode(MirroredModes::MouseModes[i], enable, previous.mouseModes[i]);
+
+    modes_ = _modes;
+    return true;
+}
+
+} // namespace terminal
+
+template class terminal::GridDiffWriter<terminal::Cell>;
@@ -0,0 +1,103 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Grid.h>
+#include <terminal/VTWriter.h>
+#include <terminal/primitives.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace terminal
+{
+
+/// Modes of the mirrored terminal that the receiving terminal must share, as they decide how it
+/// shows the cursor and how it encodes keyboard, mouse, focus and paste input for the program.
+///
+/// A default constructed instance holds the modes of a terminal after a reset.
+struct MirroredModes
+{
+    /// Mouse tracking (DECSET 9, 1000-1003), alternate scroll (1007) and the mouse encodings.
+    static constexpr std::array<DECMode, 10> MouseModes = {
+        DECMode::MouseProtocolX10,
+        DECMode::MouseProtocolNormalTracking,
+        DECMode::MouseProtocolHighlightTracking,
+        DECMode::MouseProtocolButtonTracking,
+        DECMode::MouseProtocolAnyEventTracking,
+        DECMode::MouseAlternateScroll,
+        DECMode::MouseExtended,
+        DECMode::MouseSGR,
+        DECMode::MouseURXVT,
+        DECMode::MouseSGRPixels,
+    };
+
+    bool applicationCursorKeys = false; // DECCKM
+    bool applicationKeypad = false;     // DECKPAM, DECKPNM
+    bool visibleCursor = true;          // DECTCEM
+    bool bracketedPaste = false;
+    bool focusTracking = false;
+    std::array<bool, MouseModes.size()> mouseModes {}; // indexed like MouseModes
+
+    bool operator==(MirroredModes const&) const noexcept = default;
+};
+
+/// Writes the page of a grid as a VT stream to another terminal (e.g. across a slow link),
+/// sending only the lines that changed since the previous write.
+///
+/// Lines are told apart by their generation, so neither the text of the page nor the output
+/// that led to it needs to be kept around. Output that was overwritten or scrolled off the page
+/// between two writes is never sent, which bounds the stream by the page size per write rather
+/// than by the amount of output.
+///
+/// When the page scrolled, the receiving page is scrolled up (SU) as well, so that only
+/// the new lines are written.
+///
+/// The modes that affect input (see MirroredModes) are mirrored as well, so that the program
+/// receives input from the other terminal as if that terminal was its own.
+template <typename Cell>
+class GridDiffWriter
+{
+  public:
+    /// Makes the next write() repaint the whole page and the next writeModes() write all modes,
+    /// e.g. when the receiver got attached.
+    void invalidate() noexcept
+    {
+        generations_.clear();
+        modes_.reset();
+    }
+
+    /// Writes the modes of @p _modes that changed since the previous call, or all of them
+    /// on the first call.
+    ///
+    /// @returns whether anything was written.
+    bool writeModes(MirroredModes const& _modes, VTWriter& _writer);
+
+    /// Writes the changes of @p _grid's page since the previous call, followed by moving
+    /// the cursor to @p _cursor.
+    ///
+    /// @returns the number of lines written.
+    size_t write(Grid<Cell> const& _grid, CellLocation _cursor, VTWriter& _writer);
+
+  private:
+    /// Generations of the page lines as of the previous write, top to bottom, or empty.
+    std::vector<uint64_t> generations_;
+
+    /// Modes as of the previous writeModes(), if any.
+    std::optional<MirroredModes> modes_;
+};
+
+} // namespace terminal
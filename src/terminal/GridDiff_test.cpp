@@ -0,0 +1,159 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/GridDiff.h>
+
+#include <crispy/escape.h>
+
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace terminal;
+using crispy::escape;
+
+namespace
+{
+
+struct Diff
+{
+    size_t lineCount;
+    string output;
+};
+
+Diff writeDiff(GridDiffWriter<Cell>& _diff, Grid<Cell> const& _grid, CellLocation _cursor = {})
+{
+    auto output = std::stringstream {};
+    auto writer = VTWriter(output);
+    auto const lineCount = _diff.write(_grid, _cursor, writer);
+    return Diff { lineCount, output.str() };
+}
+
+} // namespace
+
+TEST_CASE("GridDiffWriter.changed_lines", "[GridDiff]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(8) }, false, LineCount(10));
+    grid.setLineText(LineOffset(0), "one");
+    grid.setLineText(LineOffset(1), "two");
+
+    auto diff = GridDiffWriter<Cell> {};
+    auto const initial = writeDiff(diff, grid);
+    CHECK(initial.lineCount == 3);
+    CHECK(escape(initial.output)
+          == escape("\033[m\033[r\033[H\033[2J"
+                    "\033[1H\033[2Kone"
+                    "\033[2H\033[2Ktwo"
+                    "\033[3H\033[2K"
+                    "\033[1;1H"));
+
+    auto const unchanged = writeDiff(diff, grid, CellLocation { LineOffset(1), ColumnOffset(3) });
+    CHECK(unchanged.lineCount == 0);
+    CHECK(escape(unchanged.output) == escape("\033[2;4H"));
+
+    // Only the latest state of a line is written, however often it changed.
+    grid.setLineText(LineOffset(1), "twice");
+    grid.setLineText(LineOffset(1), "thrice");
+    auto const changed = writeDiff(diff, grid);
+    CHECK(changed.lineCount == 1);
+    CHECK(escape(changed.output) == escape("\033[2H\033[2Kthrice\033[1;1H"));
+
+    diff.invalidate();
+    CHECK(writeDiff(diff, grid).lineCount == 3);
+}
+
+TEST_CASE("GridDiffWriter.scrolled_page", "[GridDiff]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(8) }, false, LineCount(10));
+    grid.setLineText(LineOffset(0), "one");
+    grid.setLineText(LineOffset(1), "two");
+    grid.setLineText(LineOffset(2), "three");
+
+    auto diff = GridDiffWriter<Cell> {};
+    (void) writeDiff(diff, grid);
+
+    // Lines still on the page are scrolled by the receiver, rather than written again.
+    grid.scrollUp(LineCount(2));
+    grid.setLineText(LineOffset(1), "four");
+    grid.setLineText(LineOffset(2), "five");
+    auto const scrolled = writeDiff(diff, grid);
+    CHECK(scrolled.lineCount == 2);
+    CHECK(escape(scrolled.output)
+          == escape("\033[2S"
+                    "\033[2H\033[2Kfour"
+                    "\033[3H\033[2Kfive"
+                    "\033[1;1H"));
+
+    // Lines that scrolled off the page in between are not written at all.
+    for (auto const* text: { "six", "seven", "eight", "nine" })
+    {
+        grid.scrollUp(LineCount(1));
+        grid.setLineText(LineOffset(2), text);
+    }
+    auto const flooded = writeDiff(diff, grid);
+    CHECK(flooded.lineCount == 3);
+    CHECK(flooded.output.find("six") == string::npos);
+    CHECK(flooded.output.find("nine") != string::npos);
+}
+
+TEST_CASE("GridDiffWriter.resize", "[GridDiff]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(8) }, false, LineCount(10));
+    auto diff = GridDiffWriter<Cell> {};
+    (void) writeDiff(diff, grid);
+
+    (void) grid.resize(PageSize { LineCount(3), ColumnCount(8) }, CellLocation {}, false);
+    auto const resized = writeDiff(diff, grid);
+    CHECK(resized.lineCount == 3);
+    CHECK(resized.output.find("\033[2J") != string::npos);
+}
+
+TEST_CASE("GridDiffWriter.modes", "[GridDiff]")
+{
+    auto diff = GridDiffWriter<Cell> {};
+    auto const writeModes = [&](MirroredModes const& _modes) {
+        auto output = std::stringstream {};
+        auto writer = VTWriter(output);
+        diff.writeModes(_modes, writer);
+        return output.str();
+    };
+
+    // All modes are written on connect, even those in their default state.
+    auto modes = MirroredModes {};
+    modes.applicationCursorKeys = true;
+    auto const initial = writeModes(modes);
+    CHECK(initial.find("\033[?1h") != string::npos);
+    CHECK(initial.find("\033>") != string::npos);
+    CHECK(initial.find("\033[?25h") != string::npos);
+    CHECK(initial.find("\033[?2004l") != string::npos);
+    CHECK(initial.find("\033[?1000l") != string::npos);
+
+    CHECK(writeModes(modes).empty());
+
+    // Only changes are written afterwards, disabling mouse modes before enabling others.
+    modes.applicationKeypad = true;
+    modes.visibleCursor = false;
+    modes.mouseModes[1] = true; // normal tracking
+    modes.mouseModes[7] = true; // SGR
+    CHECK(escape(writeModes(modes)) == escape("\033=\033[?25l\033[?1000h\033[?1006h"));
+
+    modes.mouseModes[1] = false;
+    modes.mouseModes[4] = true; // any event tracking
+    CHECK(escape(writeModes(modes)) == escape("\033[?1000l\033[?1003h"));
+
+    diff.invalidate();
+    CHECK(writeModes(modes).find("\033[?1006h") != string::npos);
+}
@@ -0,0 +1,91 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/Grid.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+using namespace terminal;
+
+namespace
+{
+Grid<Cell> setupGrid(PageSize pageSize, bool reflowOnResize, LineCount maxHistoryLineCount)
+{
+    auto grid = Grid<Cell>(pageSize, reflowOnResize, maxHistoryLineCount);
+    auto const text = std::string(unbox<size_t>(pageSize.columns), 'X');
+    for (auto line = LineOffset(0); line < pageSize.lines.as<LineOffset>(); ++line)
+        grid.setLineText(line, text);
+    return grid;
+}
+
+constexpr Margin fullPageMargin(PageSize pageSize)
+{
+    return Margin { Margin::Vertical { LineOffset(0), pageSize.lines.as<LineOffset>() - 1 },
+                    Margin::Horizontal { ColumnOffset(0), pageSize.columns.as<ColumnOffset>() - 1 } };
+}
+} // namespace
+
+static void BM_Grid_scrollUp_fullPage(benchmark::State& state)
+{
+    auto const pageSize = PageSize { LineCount(50), ColumnCount(200) };
+    auto grid = setupGrid(pageSize, false, LineCount::cast_from(state.range(0)));
+    auto const margin = fullPageMargin(pageSize);
+    for (auto _: state)
+        benchmark::DoNotOptimize(grid.scrollUp(LineCount(1), GraphicsAttributes {}, margin));
+}
+BENCHMARK(BM_Grid_scrollUp_fullPage)->Arg(0)->Arg(10'000);
+
+// Vertical margins only, such as a status line at the bottom of a full-screen application.
+static void BM_Grid_scrollUp_verticalMargin(benchmark::State& state)
+{
+    auto const pageSize = PageSize { LineCount(50), ColumnCount(200) };
+    auto grid = setupGrid(pageSize, false, LineCount(0));
+    auto const margin = Margin { Margin::Vertical { LineOffset(1), LineOffset(47) },
+                                 Margin::Horizontal { ColumnOffset(0), ColumnOffset(199) } };
+    for (auto _: state)
+        benchmark::DoNotOptimize(grid.scrollUp(LineCount(1), GraphicsAttributes {}, margin));
+}
+BENCHMARK(BM_Grid_scrollUp_verticalMargin);
+
+// Vertical and horizontal margins, such as a split pane within a terminal multiplexer.
+static void BM_Grid_scrollUp_boxMargin(benchmark::State& state)
+{
+    auto const pageSize = PageSize { LineCount(50), ColumnCount(200) };
+    auto grid = setupGrid(pageSize, false, LineCount(0));
+    auto const margin = Margin { Margin::Vertical { LineOffset(1), LineOffset(47) },
+                                 Margin::Horizontal { ColumnOffset(10), ColumnOffset(109) } };
+    for (auto _: state)
+        benchmark::DoNotOptimize(grid.scrollUp(LineCount(1), GraphicsAttributes {}, margin));
+}
+BENCHMARK(BM_Grid_scrollUp_boxMargin);
+
+// Shrinks and grows the page width back and forth, reflowing the lines, including the history.
+static void BM_Grid_resize_reflow(benchmark::State& state)
+{
+    auto const wide = PageSize { LineCount(50), ColumnCount(200) };
+    auto const narrow = PageSize { LineCount(50), ColumnCount(120) };
+    auto grid = setupGrid(wide, true, LineCount::cast_from(state.range(0)));
+    for (int i = 0; i < state.range(0) / 50; ++i)
+        grid.scrollUp(LineCount(50));
+
+    auto cursor = CellLocation {};
+    for (auto _: state)
+    {
+        cursor = grid.resize(narrow, cursor, false);
+        cursor = grid.resize(wide, cursor, false);
+    }
+}
+BENCHMARK(BM_Grid_resize_reflow)->Arg(0)->Arg(1000)->Unit(benchmark::kMicrosecond);
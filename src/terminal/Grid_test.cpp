@@ -20,6 +20,7 @@
 #include <catch2/catch.hpp>
 
 #include <iostream>
+#include <utility>
 
 using namespace terminal;
 using namespace std::string_literals;
@@ -165,6 +166,273 @@ TEST_CASE("Grid.writeAndScrollUp", "[grid]")
     CHECK(grid.lineText(LineOffset(1)) == "     ");
 }
 
+TEST_CASE("Grid.coldHistory", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(5) }, true, LineCount(10));
+    auto const coldDistance = Grid<Cell>::ColdHistoryPageCount * 2;
+
+    grid.setLineText(LineOffset(0), "line0");
+    grid.setLineText(LineOffset(1), "line1");
+    for (int i = 2; i <= coldDistance + 3; ++i)
+    {
+        grid.scrollUp(LineCount(1));
+        grid.setLineText(LineOffset(1), fmt::format("line{}", i));
+    }
+    logGridText(grid, "final state");
+
+    // The two lines beyond the cold history boundary have been compacted.
+    CHECK(grid.coldHistoryStats().linesCompacted == 2);
+    CHECK(grid.coldHistoryStats().bytesSaved > 0);
+    CHECK(grid.lineAt(LineOffset(-coldDistance - 2)).isTrivialBuffer());
+    CHECK(grid.lineAt(LineOffset(-coldDistance - 1)).isTrivialBuffer());
+    CHECK(grid.lineAt(LineOffset(-coldDistance)).isInflatedBuffer());
+
+    // Compacted lines are transparently inflated on access.
+    CHECK(grid.lineText(LineOffset(-coldDistance - 2)) == "line0");
+    CHECK(grid.lineAt(LineOffset(-coldDistance - 1)).cells()[4].codepoint(0) == '1');
+    CHECK(grid.lineAt(LineOffset(-coldDistance - 1)).isInflatedBuffer());
+}
+
+TEST_CASE("Grid.historyArchive", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(5) }, true, LineCount(2));
+    auto const archivePath = FileSystem::temp_directory_path() / "libterminal-Grid_test-historyArchive";
+    grid.setHistoryArchive(std::make_shared<HistoryArchive>(archivePath));
+    CHECK((FileSystem::status(archivePath).permissions() & FileSystem::perms::all)
+          == (FileSystem::perms::owner_read | FileSystem::perms::owner_write));
+
+    grid.setLineText(LineOffset(0), "line0");
+    grid.setLineText(LineOffset(1), "line1");
+    for (int i = 2; i <= 5; ++i)
+    {
+        grid.scrollUp(LineCount(1));
+        grid.setLineText(LineOffset(1), fmt::format("line{}", i));
+    }
+    logGridText(grid, "final state");
+
+    // line0 and line1 have been evicted from the scrollback into the archive.
+    REQUIRE(grid.historyArchive()->size() == 2);
+    CHECK(grid.historyArchive()->line(0).find("line0") != string::npos);
+    CHECK(grid.historyArchive()->line(1).find("line1") != string::npos);
+    CHECK(grid.historyArchive()->text(0) == "line0");
+    CHECK(grid.historyArchive()->text(1) == "line1");
+    CHECK(grid.lineText(LineOffset(-2)) == "line2");
+
+    grid.clearHistory();
+    CHECK(grid.historyArchive()->empty());
+
+    for (int i = 0; i < 3; ++i)
+        grid.scrollUp(LineCount(1));
+    REQUIRE(grid.historyArchive()->size() == 1);
+    CHECK(grid.historyArchive()->text(0) == "line4");
+}
+
+TEST_CASE("Grid.compactHistory", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(5) }, true, LineCount(10));
+    grid.setLineText(LineOffset(0), "line0");
+    grid.setLineText(LineOffset(1), "line1");
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "line2");
+    REQUIRE(grid.lineAt(LineOffset(-1)).isInflatedBuffer());
+
+    // Unlike the cold history, this includes the history lines right above the main page.
+    CHECK(grid.compactHistory() > 0);
+    CHECK(grid.lineAt(LineOffset(-1)).isTrivialBuffer());
+    CHECK(grid.lineAt(LineOffset(0)).isInflatedBuffer());
+    CHECK(grid.lineText(LineOffset(-1)) == "line0");
+    CHECK(grid.compactHistory() == 0);
+}
+
+TEST_CASE("Grid.spillHistory", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(5) }, true, LineCount(10));
+    CHECK(grid.spillHistory(LineCount(1)) == LineCount(0));
+
+    auto const archivePath = FileSystem::temp_directory_path() / "libterminal-Grid_test-spillHistory";
+    grid.setHistoryArchive(std::make_shared<HistoryArchive>(archivePath));
+    grid.setLineText(LineOffset(0), "line0");
+    grid.setLineText(LineOffset(1), "line1");
+    for (int i = 2; i <= 4; ++i)
+    {
+        grid.scrollUp(LineCount(1));
+        grid.setLineText(LineOffset(1), fmt::format("line{}", i));
+    }
+    REQUIRE(grid.historyLineCount() == LineCount(3));
+
+    // The oldest lines go first.
+    CHECK(grid.spillHistory(LineCount(2)) == LineCount(2));
+    CHECK(grid.historyLineCount() == LineCount(1));
+    CHECK(grid.lineText(LineOffset(-1)) == "line2");
+    REQUIRE(grid.historyArchive()->size() == 2);
+    CHECK(grid.historyArchive()->line(0).find("line0") != string::npos);
+    CHECK(grid.historyArchive()->line(1).find("line1") != string::npos);
+
+    // The scrollback fills up again as usual.
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "line5");
+    CHECK(grid.historyLineCount() == LineCount(2));
+    CHECK(grid.lineText(LineOffset(-2)) == "line2");
+    CHECK(grid.lineText(LineOffset(-1)) == "line3");
+    CHECK(grid.spillHistory(LineCount(5)) == LineCount(2));
+    CHECK(grid.historyLineCount() == LineCount(0));
+}
+
+TEST_CASE("Grid.scrollbackLineAt", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(5) }, true, LineCount(2));
+    auto const archivePath = FileSystem::temp_directory_path() / "libterminal-Grid_test-scrollbackLineAt";
+    grid.setHistoryArchive(std::make_shared<HistoryArchive>(archivePath));
+
+    auto attributes = GraphicsAttributes {};
+    attributes.foregroundColor = Color::Indexed(IndexedColor::Red);
+    attributes.styles |= CellFlags::Bold;
+    grid.setLineText(LineOffset(0), "line0");
+    grid.setLineText(LineOffset(1), "line1");
+    grid.useCellAt(LineOffset(0), ColumnOffset(0)).write(attributes, 'L', 1);
+    grid.lineAt(LineOffset(1)).setWrapped(true);
+    for (int i = 2; i <= 5; ++i)
+    {
+        grid.scrollUp(LineCount(1));
+        grid.setLineText(LineOffset(1), fmt::format("line{}", i));
+        grid.lineAt(LineOffset(1)).setWrapped(i == 2);
+    }
+    logGridText(grid, "final state");
+
+    // line0 and line1 have been evicted into the archive, and are read back from there.
+    REQUIRE(grid.historyArchive()->size() == 2);
+    REQUIRE(grid.archivedLineCount() == LineCount(2));
+    REQUIRE(grid.scrollbackLineCount() == LineCount(4));
+    CHECK(grid.scrollbackLineAt(LineOffset(-4)).toUtf8() == "Line0");
+    CHECK(grid.scrollbackLineAt(LineOffset(-3)).toUtf8() == "line1");
+    CHECK(grid.scrollbackLineAt(LineOffset(-2)).toUtf8() == "line2");
+    CHECK(grid.scrollbackLineAt(LineOffset(-4)).size() == ColumnCount(5));
+
+    auto const& styled = grid.scrollbackLineAt(LineOffset(-4)).inflatedBuffer().at(0);
+    CHECK(styled.foregroundColor() == Color::Indexed(IndexedColor::Red));
+    CHECK(styled.isFlagEnabled(CellFlags::Bold));
+    CHECK(!grid.scrollbackLineAt(LineOffset(-4)).inflatedBuffer().at(1).isFlagEnabled(CellFlags::Bold));
+
+    // Logical lines span archived lines, but not the boundary to the lines still in memory.
+    CHECK(grid.isLineWrapped(LineOffset(-3)));
+    CHECK(grid.isLineWrapped(LineOffset(-2)));
+    CHECK(grid.logicalLineTop(LineOffset(-3)) == LineOffset(-4));
+    CHECK(grid.logicalLineBottom(LineOffset(-4)) == LineOffset(-3));
+    CHECK(grid.logicalLineTop(LineOffset(-2)) == LineOffset(-2));
+
+    grid.clearHistory();
+    CHECK(grid.scrollbackLineCount() == LineCount(0));
+}
+
+TEST_CASE("Grid.memoryUsage", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(5) }, false, LineCount(2));
+    auto const initial = grid.memoryUsage();
+    CHECK(initial.lines == 3);
+    CHECK(initial.trivialLines == 3);
+    CHECK(initial.inflatedLines == 0);
+    CHECK(initial.cellExtras == 0);
+
+    grid.useCellAt(LineOffset(1), ColumnOffset(2)).setHyperlink(HyperlinkId(1));
+    auto const usage = grid.memoryUsage();
+    CHECK(usage.lines == 3);
+    CHECK(usage.trivialLines == 2);
+    CHECK(usage.inflatedLines == 1);
+    CHECK(usage.cells == 5);
+    CHECK(usage.cellExtras == 1);
+    CHECK(usage.bytes >= initial.bytes + 5 * sizeof(Cell) + sizeof(CellExtra));
+}
+
+TEST_CASE("Grid.historyGrowth", "[grid]")
+{
+    // Only the main page is allocated up front.
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(6) }, false, LineCount(10));
+    CHECK(grid.memoryUsage().lines == 2);
+
+    grid.setLineText(LineOffset(0), "line0");
+    grid.setLineText(LineOffset(1), "line1");
+    auto const scrollUpAndWrite = [&](int _first, int _last) {
+        for (int i = _first; i <= _last; ++i)
+        {
+            grid.scrollUp(LineCount(1));
+            grid.setLineText(LineOffset(1), fmt::format("line{}", i));
+        }
+    };
+
+    // The buffer grows geometrically as the history fills.
+    scrollUpAndWrite(2, 2);
+    CHECK(grid.memoryUsage().lines == 4);
+    scrollUpAndWrite(3, 4);
+    CHECK(grid.memoryUsage().lines == 8);
+    CHECK(grid.historyLineCount() == LineCount(3));
+    CHECK(grid.lineTextTrimmed(LineOffset(-3)) == "line0");
+    CHECK(grid.lineTextTrimmed(LineOffset(-1)) == "line2");
+    CHECK(grid.lineTextTrimmed(LineOffset(1)) == "line4");
+
+    // ...up to the maximum history, from where on the oldest lines are recycled.
+    scrollUpAndWrite(5, 14);
+    CHECK(grid.memoryUsage().lines == 12);
+    CHECK(grid.historyLineCount() == LineCount(10));
+    CHECK(grid.lineTextTrimmed(LineOffset(-10)) == "line3");
+    CHECK(grid.lineTextTrimmed(LineOffset(-1)) == "line12");
+    CHECK(grid.lineTextTrimmed(LineOffset(1)) == "line14");
+
+    // Shrinking the maximum history keeps the newest lines.
+    grid.setMaxHistoryLineCount(LineCount(3));
+    CHECK(grid.memoryUsage().lines == 5);
+    CHECK(grid.historyLineCount() == LineCount(3));
+    CHECK(grid.lineTextTrimmed(LineOffset(-3)) == "line10");
+    CHECK(grid.lineTextTrimmed(LineOffset(-1)) == "line12");
+    CHECK(grid.lineTextTrimmed(LineOffset(0)) == "line13");
+    scrollUpAndWrite(15, 15);
+    CHECK(grid.lineTextTrimmed(LineOffset(-3)) == "line11");
+    CHECK(grid.lineTextTrimmed(LineOffset(1)) == "line15");
+}
+
+TEST_CASE("Grid.cellPool", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(5) }, false, LineCount(2));
+    CHECK(grid.memoryUsage().cellPoolBytes == 0);
+
+    // Sibling lines being inflated get adjacent cell storage.
+    grid.useCellAt(LineOffset(0), ColumnOffset(0)).setHyperlink(HyperlinkId(1));
+    grid.useCellAt(LineOffset(1), ColumnOffset(0)).setHyperlink(HyperlinkId(1));
+    auto const* first = grid.lineAt(LineOffset(0)).inflatedBuffer().data();
+    auto const* second = grid.lineAt(LineOffset(1)).inflatedBuffer().data();
+    CHECK(grid.lineAt(LineOffset(0)).inflatedBuffer().get_allocator().pool() != nullptr);
+    CHECK(second > first);
+    CHECK(reinterpret_cast<char const*>(second) - reinterpret_cast<char const*>(first)
+          < static_cast<ptrdiff_t>(2 * 5 * sizeof(Cell)));
+    CHECK(grid.memoryUsage().cellPoolBytes == crispy::SlabPool::DefaultChunkSize);
+
+    // Resetting the lines returns the cells to the pool, to be reused by the next inflated line.
+    grid.lineAt(LineOffset(1)).reset(LineFlags::None, GraphicsAttributes {});
+    grid.useCellAt(LineOffset(2), ColumnOffset(0)).setHyperlink(HyperlinkId(1));
+    CHECK(grid.lineAt(LineOffset(2)).inflatedBuffer().data() == second);
+}
+
+TEST_CASE("Grid.copyOnWrite", "[grid]")
+{
+    auto grid = setupGrid5x2();
+    auto const* cells = std::as_const(grid).lineAt(LineOffset(0)).inflatedBuffer().data();
+
+    // A snapshot shares the cells of all lines.
+    auto const snapshot = grid;
+    CHECK(snapshot.lineAt(LineOffset(0)).inflatedBuffer().data() == cells);
+    CHECK(std::as_const(grid).lineAt(LineOffset(0)).isSharedBuffer());
+
+    // Writing to the grid clones the line, leaving the snapshot untouched.
+    grid.setLineText(LineOffset(0), "xyz");
+    CHECK(grid.lineText(LineOffset(0)) == "xyzDE");
+    CHECK(snapshot.lineText(LineOffset(0)) == "ABCDE");
+    CHECK(snapshot.lineAt(LineOffset(0)).inflatedBuffer().data() == cells);
+    CHECK_FALSE(snapshot.lineAt(LineOffset(0)).isSharedBuffer());
+
+    // Untouched lines remain shared.
+    CHECK(snapshot.lineAt(LineOffset(1)).isSharedBuffer());
+    CHECK(snapshot.lineText(LineOffset(1)) == "abcde");
+}
+
 TEST_CASE("iteratorAt", "[grid]")
 {
     auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(3) }, true, LineCount(0));
@@ -663,6 +931,30 @@ TEST_CASE("Grid.reflow", "[grid]")
     }
 }
 
+TEST_CASE("Grid.reflow.trivial", "[grid]")
+{
+    auto constexpr text = "ABC"sv;
+    auto pool = crispy::BufferObjectPool(16);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(text);
+
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(5) }, true, LineCount(0));
+    grid.lineAt(LineOffset(0))
+        .reset(GraphicsAttributes {}, HyperlinkId {}, bufferObject->ref(0, 3), ColumnCount(3));
+    grid.setLineText(LineOffset(1), "abcd");
+
+    // Growing does not inflate trivial lines.
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(8) }, CellLocation {}, false);
+    CHECK(grid.lineAt(LineOffset(0)).isTrivialBuffer());
+    CHECK(grid.lineText(LineOffset(1)) == "abcd    ");
+    CHECK(grid.lineAt(LineOffset(0)).toUtf8() == "ABC     ");
+
+    // Shrinking does not inflate trivial lines whose text still fits.
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(4) }, CellLocation {}, false);
+    CHECK(grid.lineAt(LineOffset(0)).isTrivialBuffer());
+    CHECK(grid.lineAt(LineOffset(0)).toUtf8() == "ABC ");
+}
+
 TEST_CASE("Grid.reflow.shrink_many", "[grid]")
 {
     auto grid = setupGrid5x2();
@@ -845,4 +1137,216 @@ TEST_CASE("Grid.reflow.tripple", "[grid]")
         // }}}
     }
 }
+
+TEST_CASE("Grid.reflow.many_lines", "[grid]")
+{
+    // Enough lines for the grid to be rewrapped in multiple ranges concurrently,
+    // which have to be spliced together in the order of the logical lines.
+    auto constexpr LogicalLineCount = 12000;
+    auto const pageSize = PageSize { LineCount(10), ColumnCount(20) };
+    auto grid = Grid<Cell>(pageSize, true, LineCount(3 * LogicalLineCount));
+
+    auto const logicalLineText = [](int _line) {
+        return fmt::format("{:05}{}", _line, string(static_cast<size_t>(_line % 16), char('a' + _line % 26)));
+    };
+    auto wrappedLineCount = 0;
+    for (int i = 0; i < LogicalLineCount; ++i)
+    {
+        auto const line = std::min(i, 9);
+        if (i > 9)
+            grid.scrollUp(LineCount(1));
+        grid.setLineText(LineOffset(line), logicalLineText(i));
+        wrappedLineCount += (static_cast<int>(logicalLineText(i).size()) + 7) / 8;
+    }
+    REQUIRE(grid.historyLineCount() == LineCount(LogicalLineCount - 10));
+
+    (void) grid.resize(PageSize { LineCount(10), ColumnCount(8) }, CellLocation {}, false);
+    REQUIRE(grid.historyLineCount() == LineCount(wrappedLineCount - 10));
+
+    auto line = -unbox<int>(grid.historyLineCount());
+    for (int i = 0; i < LogicalLineCount; ++i)
+    {
+        INFO(fmt::format("logical line {} at {}", i, line));
+        REQUIRE(!grid.lineAt(LineOffset(line)).wrapped());
+        auto text = grid.lineTextTrimmed(LineOffset(line++));
+        while (line < 10 && grid.lineAt(LineOffset(line)).wrapped())
+            text += grid.lineTextTrimmed(LineOffset(line++));
+        REQUIRE(text == logicalLineText(i));
+    }
+
+    (void) grid.resize(pageSize, CellLocation {}, false);
+    REQUIRE(grid.historyLineCount() == LineCount(LogicalLineCount - 10));
+    for (int i = 0; i < LogicalLineCount; ++i)
+    {
+        auto const offset = LineOffset(i - LogicalLineCount + 10);
+        INFO(fmt::format("logical line {}", i));
+        REQUIRE(!grid.lineAt(offset).wrapped());
+        REQUIRE(grid.lineTextTrimmed(offset) == logicalLineText(i));
+    }
+}
 // }}}
+
+namespace
+{
+std::optional<LineOffset> scanMarkerUpwards(Grid<Cell> const& _grid, LineOffset _line)
+{
+    for (auto i = _line - 1; i >= -boxed_cast<LineOffset>(_grid.historyLineCount()); --i)
+        if (_grid.lineAt(i).marked())
+            return i;
+    return std::nullopt;
+}
+
+std::optional<LineOffset> scanMarkerDownwards(Grid<Cell> const& _grid, LineOffset _line, LineOffset _bottom)
+{
+    for (auto i = _line + 1; i <= _bottom; ++i)
+        if (_grid.lineAt(i).marked())
+            return i;
+    return std::nullopt;
+}
+
+/// Verifies the marker index against a full scan, starting from every line of the grid.
+void checkMarkerIndex(Grid<Cell> const& _grid)
+{
+    auto const top = -boxed_cast<LineOffset>(_grid.historyLineCount());
+    auto const bottom = boxed_cast<LineOffset>(_grid.pageSize().lines) - 1;
+    for (auto line = top; line <= bottom; ++line)
+    {
+        INFO(fmt::format("line {}", line));
+        CHECK(_grid.findMarkerUpwards(line) == scanMarkerUpwards(_grid, line));
+        CHECK(_grid.findMarkerDownwards(line, bottom) == scanMarkerDownwards(_grid, line, bottom));
+        CHECK(_grid.findMarkerDownwards(line, LineOffset(0))
+              == scanMarkerDownwards(_grid, line, LineOffset(0)));
+    }
+}
+} // namespace
+
+TEST_CASE("Grid.findMarker", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(3));
+    auto const markAndScroll = [&](bool _marked) {
+        grid.lineAt(LineOffset(0)).setMarked(_marked);
+        grid.scrollUp(LineCount(1));
+    };
+
+    markAndScroll(true); // falls off the history eventually
+    markAndScroll(false);
+    markAndScroll(true);
+    markAndScroll(false);
+    markAndScroll(false);
+    grid.lineAt(LineOffset(1)).setMarked(true);
+
+    // history (max 3): -3 marked, -2 unmarked, -1 unmarked; main page: 0 unmarked, 1 marked
+    REQUIRE(grid.historyLineCount() == LineCount(3));
+    CHECK(grid.findMarkerUpwards(LineOffset(2)) == LineOffset(1));
+    CHECK(grid.findMarkerUpwards(LineOffset(1)) == LineOffset(-3));
+    CHECK(grid.findMarkerUpwards(LineOffset(-3)) == std::nullopt);
+    CHECK(grid.findMarkerDownwards(LineOffset(-3), LineOffset(1)) == LineOffset(1));
+    CHECK(grid.findMarkerDownwards(LineOffset(-3), LineOffset(0)) == std::nullopt);
+    checkMarkerIndex(grid);
+
+    SECTION("scroll down")
+    {
+        auto const fullScreen = Margin { Margin::Vertical { LineOffset(0), LineOffset(1) },
+                                         Margin::Horizontal { ColumnOffset(0), ColumnOffset(3) } };
+        grid.scrollDown(LineCount(1), GraphicsAttributes {}, fullScreen);
+        checkMarkerIndex(grid);
+        grid.scrollDown(LineCount(2), GraphicsAttributes {}, fullScreen);
+        checkMarkerIndex(grid);
+        markAndScroll(true);
+        checkMarkerIndex(grid);
+    }
+
+    SECTION("resize")
+    {
+        (void) grid.resize(PageSize { LineCount(1), ColumnCount(4) }, CellLocation {}, false);
+        checkMarkerIndex(grid);
+        (void) grid.resize(PageSize { LineCount(3), ColumnCount(4) }, CellLocation {}, false);
+        checkMarkerIndex(grid);
+    }
+
+    SECTION("clear history")
+    {
+        grid.clearHistory();
+        CHECK(grid.findMarkerUpwards(LineOffset(1)) == std::nullopt);
+        checkMarkerIndex(grid);
+    }
+}
+
+namespace
+{
+/// Verifies the logical line index against a full scan, starting from every line of the grid.
+void checkLogicalLineIndex(Grid<Cell> const& _grid)
+{
+    auto const top = -boxed_cast<LineOffset>(_grid.historyLineCount());
+    auto const bottom = boxed_cast<LineOffset>(_grid.pageSize().lines) - 1;
+    auto tops = std::vector<LineOffset> {};
+    for (auto line = top; line <= bottom; ++line)
+    {
+        auto lineTop = line;
+        while (lineTop > top && _grid.lineAt(lineTop).wrapped())
+            --lineTop;
+        auto lineBottom = line;
+        while (lineBottom < bottom && _grid.lineAt(lineBottom + 1).wrapped())
+            ++lineBottom;
+
+        INFO(fmt::format("line {}", line));
+        CHECK(_grid.logicalLineTop(line) == lineTop);
+        CHECK(_grid.logicalLineBottom(line) == lineBottom);
+        if (lineTop == line)
+            tops.push_back(line);
+    }
+
+    for (size_t n = 1; n <= tops.size(); ++n)
+    {
+        INFO(fmt::format("logical line {} from bottom", n));
+        CHECK(_grid.computeLogicalLineNumberFromBottom(LineCount::cast_from(n))
+              == unbox<int>(tops[tops.size() - n]));
+    }
+    CHECK(_grid.computeLogicalLineNumberFromBottom(LineCount::cast_from(tops.size() + 1)) == unbox<int>(top));
+}
+} // namespace
+
+TEST_CASE("Grid.logicalLineIndex", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(5));
+    auto const writeAndScroll = [&](bool _wrapped) {
+        grid.lineAt(LineOffset(1)).setWrapped(_wrapped);
+        grid.scrollUp(LineCount(1));
+    };
+
+    // The oldest logical line is cut off at the history top once its first line fell off.
+    for (auto const wrapped: { false, true, true, false, true, false, true, true })
+        writeAndScroll(wrapped);
+    REQUIRE(grid.historyLineCount() == LineCount(5));
+    CHECK(grid.lineAt(LineOffset(-5)).wrapped());
+    CHECK(grid.logicalLineTop(LineOffset(-5)) == LineOffset(-5));
+    CHECK(grid.logicalLineTop(LineOffset(-3)) == LineOffset(-4));
+    CHECK(grid.logicalLineBottom(LineOffset(-2)) == LineOffset(0));
+    checkLogicalLineIndex(grid);
+
+    SECTION("scroll down")
+    {
+        auto const fullScreen = Margin { Margin::Vertical { LineOffset(0), LineOffset(1) },
+                                         Margin::Horizontal { ColumnOffset(0), ColumnOffset(3) } };
+        grid.scrollDown(LineCount(1), GraphicsAttributes {}, fullScreen);
+        checkLogicalLineIndex(grid);
+        grid.scrollDown(LineCount(2), GraphicsAttributes {}, fullScreen);
+        checkLogicalLineIndex(grid);
+        writeAndScroll(true);
+        checkLogicalLineIndex(grid);
+    }
+
+    SECTION("resize")
+    {
+        (void) grid.resize(PageSize { LineCount(1), ColumnCount(4) }, CellLocation {}, false);
+        checkLogicalLineIndex(grid);
+        (void) grid.resize(PageSize { LineCount(3), ColumnCount(4) }, CellLocation {}, false);
+        checkLogicalLineIndex(grid);
+    }
+
+    SECTION("clear history")
+    {
+        grid.clearHistory();
+        checkLogicalLineIndex(grid);
+    }
+}
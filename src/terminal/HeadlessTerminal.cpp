@@ -0,0 +1,70 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/HeadlessTerminal.h>
+
+using namespace std;
+
+namespace terminal
+{
+
+HeadlessTerminal::HeadlessTerminal(PageSize _pageSize,
+                                   LineCount _maxHistoryLineCount,
+                                   size_t _bufferObjectSize):
+    terminal_ {
+        make_unique<MockPty>(_pageSize), _bufferObjectSize, _bufferObjectSize, *this, _maxHistoryLineCount
+    }
+{
+}
+
+vector<string> HeadlessTerminal::logicalLines() const
+{
+    auto const& grid = this->grid();
+    auto const top = -boxed_cast<LineOffset>(grid.historyLineCount());
+    auto const bottom = boxed_cast<LineOffset>(grid.pageSize().lines) - 1;
+
+    auto const trimmed = [](string _text) {
+        while (!_text.empty() && _text.back() == ' ')
+            _text.pop_back();
+        return _text;
+    };
+
+    auto lines = vector<string> {};
+    auto pending = string {};
+    for (auto line = top; line <= bottom; ++line)
+    {
+        pending += grid.lineAt(line).toUtf8();
+        if (line == bottom || !grid.lineAt(line + 1).wrapped())
+        {
+            lines.emplace_back(trimmed(move(pending)));
+            pending.clear();
+        }
+    }
+
+    while (!lines.empty() && lines.back().empty())
+        lines.pop_back();
+    return lines;
+}
+
+string HeadlessTerminal::text() const
+{
+    auto output = string {};
+    for (string const& line: logicalLines())
+    {
+        output += line;
+        output += '\n';
+    }
+    return output;
+}
+
+} // namespace terminal
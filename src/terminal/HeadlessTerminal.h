@@ -0,0 +1,75 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Terminal.h>
+#include <terminal/pty/MockPty.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace terminal
+{
+
+/// A terminal without PTY, display, and render thread, turning recorded output (such as build logs)
+/// into screen contents.
+///
+/// Output is parsed directly from the given buffers, without locking and without maintaining
+/// a render buffer. An instance must only be used by one thread at a time, but any number of
+/// instances may be used in parallel, e.g. on a thread pool.
+class HeadlessTerminal: private Terminal::Events
+{
+  public:
+    /// The size of the buffer objects the output is copied into, which also holds the text of the lines.
+    static constexpr size_t DefaultBufferObjectSize = 64 * 1024;
+
+    explicit HeadlessTerminal(PageSize _pageSize,
+                              LineCount _maxHistoryLineCount = LineCount(0),
+                              size_t _bufferObjectSize = DefaultBufferObjectSize);
+
+    HeadlessTerminal(HeadlessTerminal const&) = delete;
+    HeadlessTerminal& operator=(HeadlessTerminal const&) = delete;
+
+    /// Processes the given output, which may end anywhere, even within a UTF-8 or VT sequence.
+    void write(std::string_view _output) { terminal_.ingest(_output); }
+
+    [[nodiscard]] PageSize pageSize() const noexcept { return terminal_.pageSize(); }
+
+    /// The primary screen's grid, including the history lines.
+    [[nodiscard]] Grid<Cell> const& grid() const noexcept { return terminal_.primaryScreen().grid(); }
+
+    /// Returns the text of the primary screen's logical lines, that is, lines joined with the lines
+    /// they wrapped into, from the oldest history line down to the last non-empty line.
+    ///
+    /// Trailing whitespace is trimmed off each logical line.
+    [[nodiscard]] std::vector<std::string> logicalLines() const;
+
+    /// Returns the logical lines, each terminated by a line feed.
+    [[nodiscard]] std::string text() const;
+
+    [[nodiscard]] std::string const& windowTitle() const noexcept { return windowTitle_; }
+
+    /// Gives access to the underlying terminal, e.g. to configure it before writing to it.
+    [[nodiscard]] Terminal& terminal() noexcept { return terminal_; }
+    [[nodiscard]] Terminal const& terminal() const noexcept { return terminal_; }
+
+  private:
+    void setWindowTitle(std::string_view _title) override { windowTitle_ = _title; }
+
+    std::string windowTitle_;
+    Terminal terminal_;
+};
+
+} // namespace terminal
@@ -0,0 +1,67 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/HeadlessTerminal.h>
+
+#include <catch2/catch.hpp>
+
+#include <future>
+#include <string>
+#include <vector>
+
+using namespace terminal;
+using std::string;
+using std::vector;
+
+TEST_CASE("HeadlessTerminal.logicalLines", "[headless]")
+{
+    auto term = HeadlessTerminal(PageSize { LineCount(3), ColumnCount(5) }, LineCount(10));
+    term.write("\033]2;build\033\\");
+    term.write("abc  \r\n0123456789ab\r\n\033[1mbo");
+    term.write("ld\033[m x\r\n");
+
+    CHECK(term.windowTitle() == "build");
+    CHECK(term.logicalLines() == vector<string> { "abc", "0123456789ab", "bold x" });
+    CHECK(term.text() == "abc\n0123456789ab\nbold x\n");
+    CHECK(term.grid().historyLineCount() == LineCount(4));
+}
+
+TEST_CASE("HeadlessTerminal.discards_replies", "[headless]")
+{
+    auto term = HeadlessTerminal(PageSize { LineCount(2), ColumnCount(10) });
+    term.write("\033[c\033[6nok");
+    CHECK(!term.terminal().hasInput());
+    CHECK(term.text() == "ok\n");
+}
+
+TEST_CASE("HeadlessTerminal.parallel", "[headless]")
+{
+    auto const process = [](int _index) {
+        auto term = HeadlessTerminal(PageSize { LineCount(4), ColumnCount(20) }, LineCount(100));
+        for (int i = 0; i < 50; ++i)
+            term.write("log " + std::to_string(_index) + ":" + std::to_string(i) + "\r\n");
+        return term.logicalLines();
+    };
+
+    auto results = vector<std::future<vector<string>>> {};
+    for (int i = 0; i < 4; ++i)
+        results.emplace_back(std::async(std::launch::async, process, i));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        auto const lines = results[static_cast<size_t>(i)].get();
+        REQUIRE(lines.size() == 50);
+        CHECK(lines.front() == "log " + std::to_string(i) + ":0");
+        CHECK(lines.back() == "log " + std::to_string(i) + ":49");
+    }
+}
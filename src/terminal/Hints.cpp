@@ -0,0 +1,235 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hints.h>
+#include <terminal/ParserScanner.h>
+
+using namespace std;
+
+namespace terminal
+{
+
+namespace
+{
+    constexpr size_t MinGitHashLength = 7;
+
+    constexpr bool isHexDigit(char _ch) noexcept
+    {
+        return ('0' <= _ch && _ch <= '9') || ('a' <= _ch && _ch <= 'f') || ('A' <= _ch && _ch <= 'F');
+    }
+
+    constexpr bool isDigit(char _ch) noexcept
+    {
+        return '0' <= _ch && _ch <= '9';
+    }
+
+    /// Strips trailing punctuation off a URL or path, as in "see https://example.com/a)."
+    size_t trimmedLength(string_view _text) noexcept
+    {
+        auto const unbalanced = [&](char _open, char _close) {
+            return count(_text.begin(), _text.end(), _close) > count(_text.begin(), _text.end(), _open);
+        };
+
+        while (!_text.empty())
+        {
+            auto const last = _text.back();
+            auto const strip = last == '.' || last == ',' || last == ';' || last == ':' || last == '!'
+                               || last == '?' || last == '\'' || last == '"'
+                               || (last == ')' && unbalanced('(', ')'))
+                               || (last == ']' && unbalanced('[', ']'))
+                               || (last == '}' && unbalanced('{', '}'));
+            if (!strip)
+                break;
+            _text.remove_suffix(1);
+        }
+        return _text.size();
+    }
+
+    template <typename Callback>
+    void forEachRegexMatch(string_view _text, regex const& _regex, Callback&& _callback)
+    {
+        auto const end = cregex_iterator {};
+        for (auto i = cregex_iterator(_text.data(), _text.data() + _text.size(), _regex); i != end; ++i)
+            if (i->length() != 0)
+                _callback(TextMatch { static_cast<size_t>(i->position()), static_cast<size_t>(i->length()) });
+    }
+} // namespace
+
+// {{{ HintMatcher
+HintMatcher::HintMatcher():
+    url_ { R"([A-Za-z][A-Za-z0-9+.-]*://[^\s<>"'`]+)", regex::ECMAScript | regex::optimize },
+    path_ { R"((?:[\w.~@+-]*/)+[\w.~@+-]+)", regex::ECMAScript | regex::optimize },
+    gitHash_ { R"(\b[0-9a-f]{7,40}\b)", regex::ECMAScript | regex::optimize }
+{
+}
+
+bool HintMatcher::mayContainHints(string_view _text) noexcept
+{
+    auto input = _text.data();
+    auto const end = input + _text.size();
+    auto hexRun = size_t { 0 }; // number of hex digits immediately preceding input
+
+#if defined(__SSE2__) || defined(__aarch64__)
+    // Case folding maps 'A'..'F' onto 'a'..'f' and keeps the digits, whose 0x20 bit is set already.
+    // Signed comparison: bytes >= 0x80 are negative and thus never hex digits.
+    auto const slash = _mm_set1_epi8('/');
+    auto const caseBit = _mm_set1_epi8(0x20);
+    auto const beforeDigits = _mm_set1_epi8('0' - 1);
+    auto const afterDigits = _mm_set1_epi8('9' + 1);
+    auto const beforeLetters = _mm_set1_epi8('a' - 1);
+    auto const afterLetters = _mm_set1_epi8('f' + 1);
+    while (end - input >= 16)
+    {
+        auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(batch, slash)) != 0)
+            return true;
+
+        auto const folded = _mm_or_si128(batch, caseBit);
+        auto const isDigit16 =
+            _mm_and_si128(_mm_cmpgt_epi8(folded, beforeDigits), _mm_cmplt_epi8(folded, afterDigits));
+        auto const isLetter16 =
+            _mm_and_si128(_mm_cmpgt_epi8(folded, beforeLetters), _mm_cmplt_epi8(folded, afterLetters));
+        auto const hexMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(isDigit16, isLetter16)));
+        input += 16;
+
+        if (hexMask == 0xFFFF)
+        {
+            hexRun += 16;
+            if (hexRun >= MinGitHashLength)
+                return true;
+            continue;
+        }
+
+        // The run carried over from the previous bytes, continued by this batch's lowest bits.
+        if (hexRun + parser::detail::countTrailingZeros(~hexMask) >= MinGitHashLength)
+            return true;
+
+        // Runs within this batch.
+        auto runs = hexMask;
+        for (size_t i = 1; i < MinGitHashLength; ++i)
+            runs &= runs >> 1;
+        if (runs != 0)
+            return true;
+
+        // The run reaching up to this batch's highest bit, carried over to the next bytes.
+        hexRun = 0;
+        while (hexRun < 16 && (hexMask & (0x8000u >> hexRun)))
+            ++hexRun;
+    }
+#endif
+
+    for (; input != end; ++input)
+    {
+        if (*input == '/')
+            return true;
+        if (!isHexDigit(*input))
+            hexRun = 0;
+        else if (++hexRun >= MinGitHashLength)
+            return true;
+    }
+    return false;
+}
+
+vector<pair<HintKind, TextMatch>> HintMatcher::find(string_view _text) const
+{
+    auto hints = vector<pair<HintKind, TextMatch>> {};
+    auto const overlapping = [&](TextMatch _match) {
+        return any_of(hints.begin(), hints.end(), [&](auto const& _hint) {
+            return _match.offset < _hint.second.offset + _hint.second.length
+                   && _hint.second.offset < _match.offset + _match.length;
+        });
+    };
+
+    if (_text.find('/') != string_view::npos)
+    {
+        forEachRegexMatch(_text, url_, [&](TextMatch _match) {
+            _match.length = trimmedLength(_text.substr(_match.offset, _match.length));
+            hints.emplace_back(HintKind::Url, _match);
+        });
+
+        forEachRegexMatch(_text, path_, [&](TextMatch _match) {
+            _match.length = trimmedLength(_text.substr(_match.offset, _match.length));
+            if (_match.length != 0 && !overlapping(_match))
+                hints.emplace_back(HintKind::Path, _match);
+        });
+    }
+
+    forEachRegexMatch(_text, gitHash_, [&](TextMatch _match) {
+        // Plain numbers and words made of the letters a to f are hardly ever meant as hashes.
+        auto const hash = _text.substr(_match.offset, _match.length);
+        if (any_of(hash.begin(), hash.end(), isDigit) && !all_of(hash.begin(), hash.end(), isDigit)
+            && !overlapping(_match))
+            hints.emplace_back(HintKind::GitHash, _match);
+    });
+
+    sort(hints.begin(), hints.end(), [](auto const& a, auto const& b) {
+        return a.second.offset < b.second.offset;
+    });
+    return hints;
+}
+// }}}
+
+// {{{ HintCache
+vector<Hint> const* HintCache::find(uint64_t _key) noexcept
+{
+    auto const i = entries_.find(_key);
+    if (i == entries_.end())
+        return nullptr;
+
+    i->second.epoch = epoch_;
+    return &i->second.hints;
+}
+
+vector<Hint> const& HintCache::insert(uint64_t _key, vector<Hint> _hints)
+{
+    auto& entry = entries_[_key];
+    entry.hints = move(_hints);
+    entry.epoch = epoch_;
+    return entry.hints;
+}
+
+void HintCache::sweep()
+{
+    for (auto i = entries_.begin(); i != entries_.end();)
+    {
+        if (i->second.epoch != epoch_)
+            i = entries_.erase(i);
+        else
+            ++i;
+    }
+    ++epoch_;
+}
+// }}}
+
+vector<string> hintLabels(size_t _count, string_view _alphabet)
+{
+    auto labels = vector<string> {};
+    if (_alphabet.empty())
+        return labels;
+
+    auto length = size_t { 1 };
+    for (auto capacity = _alphabet.size(); capacity < _count && _alphabet.size() > 1; ++length)
+        capacity *= _alphabet.size();
+
+    labels.reserve(_count);
+    for (size_t i = 0; i < _count; ++i)
+    {
+        auto label = string(length, _alphabet[0]);
+        for (auto n = i, k = length; n != 0 && k != 0; n /= _alphabet.size())
+            label[--k] = _alphabet[n % _alphabet.size()];
+        labels.emplace_back(move(label));
+    }
+    return labels;
+}
+
+} // namespace terminal
@@ -0,0 +1,154 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Search.h>
+#include <terminal/primitives.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace terminal
+{
+
+/// Kinds of text that can be picked from the screen by keyboard in hint mode.
+enum class HintKind
+{
+    Url,
+    Path,
+    GitHash,
+};
+
+/// A piece of text on the screen that can be picked in hint mode.
+struct Hint
+{
+    HintKind kind = HintKind::Url;
+    SearchMatch range {};
+    std::string text;
+};
+
+/// Finds URLs, file paths and git commit hashes in UTF-8 text.
+class HintMatcher
+{
+  public:
+    HintMatcher();
+
+    /// Tests whether the text may contain any hint at all, that is, a '/' (as URLs and paths do)
+    /// or a run of at least 7 hexadecimal digits.
+    ///
+    /// This inspects 16 bytes per iteration (SSE2, NEON) where available, sparing most lines
+    /// the regular expressions.
+    [[nodiscard]] static bool mayContainHints(std::string_view _text) noexcept;
+
+    /// Finds the hints in the given text, ordered by their offset.
+    ///
+    /// Hints do not overlap, URLs taking precedence over paths, and paths over git hashes.
+    [[nodiscard]] std::vector<std::pair<HintKind, TextMatch>> find(std::string_view _text) const;
+
+  private:
+    std::regex url_;
+    std::regex path_;
+    std::regex gitHash_;
+};
+
+/// Hints of logical lines, by a key that changes whenever the lines' contents change.
+///
+/// Positions are relative to the logical line's top line (line 0), and thus remain valid
+/// while the line scrolls.
+class HintCache
+{
+  public:
+    [[nodiscard]] size_t size() const noexcept { return entries_.size(); }
+
+    /// @returns the hints of the logical line identified by @p _key, or nullptr if not scanned yet.
+    [[nodiscard]] std::vector<Hint> const* find(uint64_t _key) noexcept;
+
+    std::vector<Hint> const& insert(uint64_t _key, std::vector<Hint> _hints);
+
+    /// Forgets about all lines that have not been looked up since the previous sweep.
+    void sweep();
+
+    void clear() { entries_.clear(); }
+
+  private:
+    struct Entry
+    {
+        std::vector<Hint> hints;
+        uint64_t epoch = 0;
+    };
+
+    std::unordered_map<uint64_t, Entry> entries_;
+    uint64_t epoch_ = 1;
+};
+
+/// Returns @p _count distinct labels to pick hints by, made up of the characters of @p _alphabet.
+///
+/// All labels are of the same length, so that none is the prefix of another.
+[[nodiscard]] std::vector<std::string> hintLabels(size_t _count, std::string_view _alphabet = "asdfghjkl");
+
+/// Collects the hints in the logical lines intersecting the lines [_first, _last].
+///
+/// Logical lines are looked up in (and added to) @p _cache, so that only lines that changed
+/// since they were last passed are scanned.
+template <typename GridT>
+std::vector<Hint> collectHints(
+    GridT const& _grid, HintMatcher const& _matcher, LineOffset _first, LineOffset _last, HintCache& _cache)
+{
+    auto const top = -boxed_cast<LineOffset>(_grid.scrollbackLineCount());
+    auto const bottom = boxed_cast<LineOffset>(_grid.pageSize().lines) - 1;
+    _last = std::min(_last, bottom);
+
+    auto lineTop = _grid.logicalLineTop(std::max(_first, top));
+
+    auto hints = std::vector<Hint> {};
+    auto text = detail::LogicalLineText {};
+    while (lineTop <= _last)
+    {
+        auto const lineBottom = _grid.logicalLineBottom(lineTop);
+
+        auto const key = detail::logicalLineKey(_grid, lineTop, lineBottom);
+        auto const* lineHints = _cache.find(key);
+        if (!lineHints)
+        {
+            text.clear();
+            for (auto line = lineTop; line <= lineBottom; ++line)
+                text.append(_grid.scrollbackLineAt(line), line - lineTop);
+
+            auto found = std::vector<Hint> {};
+            if (HintMatcher::mayContainHints(text.text))
+                for (auto const& [kind, match]: _matcher.find(text.text))
+                    found.push_back(
+                        Hint { kind, text.locate(match), text.text.substr(match.offset, match.length) });
+            lineHints = &_cache.insert(key, std::move(found));
+        }
+
+        for (Hint const& hint: *lineHints)
+        {
+            auto& output = hints.emplace_back(hint);
+            output.range.start.line += lineTop;
+            output.range.end.line += lineTop;
+        }
+
+        lineTop = lineBottom + 1;
+    }
+    return hints;
+}
+
+} // namespace terminal
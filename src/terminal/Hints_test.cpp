@@ -0,0 +1,140 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/Grid.h>
+#include <terminal/Hints.h>
+#include <terminal/test_grid.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace terminal;
+using namespace terminal::test;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace
+{
+
+/// Returns the text and kind of each hint found in the given text.
+vector<std::pair<HintKind, string>> hintsOf(string_view _text)
+{
+    auto result = vector<std::pair<HintKind, string>> {};
+    for (auto const& [kind, match]: HintMatcher().find(_text))
+        result.emplace_back(kind, string(_text.substr(match.offset, match.length)));
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("HintMatcher.mayContainHints", "[hints]")
+{
+    CHECK(!HintMatcher::mayContainHints(""));
+    CHECK(!HintMatcher::mayContainHints("hello world, nothing to see here at all"));
+    CHECK(!HintMatcher::mayContainHints("abc123 is too short: 123456"));
+    CHECK(HintMatcher::mayContainHints("see the docs at https://example.com"));
+    CHECK(HintMatcher::mayContainHints("a/b"));
+    CHECK(HintMatcher::mayContainHints("commit 1a2b3c4"));
+
+    // Runs of hex digits across (and within) the 16-byte batches.
+    auto const padding = string(13, ' ');
+    CHECK(HintMatcher::mayContainHints(padding + "DEADbeef" + padding));
+    CHECK(!HintMatcher::mayContainHints(padding + "123 456" + padding + padding));
+    CHECK(HintMatcher::mayContainHints(string(32, '0')));
+    CHECK(!HintMatcher::mayContainHints(string(40, 'x')));
+    CHECK(HintMatcher::mayContainHints(string(40, 'x') + "/"));
+}
+
+TEST_CASE("HintMatcher.find", "[hints]")
+{
+    using Hints = vector<std::pair<HintKind, string>>;
+
+    CHECK(hintsOf("nothing here") == Hints {});
+    CHECK(hintsOf("see https://example.com/a_(b) and (https://example.com/c).")
+          == Hints { { HintKind::Url, "https://example.com/a_(b)" },
+                     { HintKind::Url, "https://example.com/c" } });
+    CHECK(hintsOf("src/terminal/Hints.cpp:42: error")
+          == Hints { { HintKind::Path, "src/terminal/Hints.cpp" } });
+    CHECK(hintsOf("cd ~/work/contour.") == Hints { { HintKind::Path, "~/work/contour" } });
+    CHECK(hintsOf("51e4743 Upload atlas tiles") == Hints { { HintKind::GitHash, "51e4743" } });
+
+    // Numbers and hex words are not considered hashes.
+    CHECK(hintsOf("1234567 effaced") == Hints {});
+
+    // Hashes within URLs and paths belong to these.
+    CHECK(hintsOf("https://github.com/contour-terminal/contour/commit/51e4743 /tmp/51e4743")
+          == Hints { { HintKind::Url, "https://github.com/contour-terminal/contour/commit/51e4743" },
+                     { HintKind::Path, "/tmp/51e4743" } });
+}
+
+TEST_CASE("hintLabels", "[hints]")
+{
+    CHECK(hintLabels(0, "ab") == vector<string> {});
+    CHECK(hintLabels(2, "ab") == vector<string> { "a", "b" });
+    CHECK(hintLabels(3, "ab") == vector<string> { "aa", "ab", "ba" });
+    CHECK(hintLabels(5, "ab") == vector<string> { "aaa", "aab", "aba", "abb", "baa" });
+    CHECK(hintLabels(9).size() == 9);
+    CHECK(hintLabels(10).front() == "aa");
+}
+
+TEST_CASE("collectHints", "[hints]")
+{
+    auto const grid = setupGrid(PageSize { LineCount(3), ColumnCount(20) },
+                                { "git show 51e4743", "nothing", "open /etc/hosts", "x", "https://a.io/b" });
+    auto const matcher = HintMatcher();
+    auto cache = HintCache();
+
+    auto const hints = collectHints(grid, matcher, LineOffset(-2), LineOffset(2), cache);
+    REQUIRE(hints.size() == 3);
+    CHECK(hints[0].kind == HintKind::GitHash);
+    CHECK(hints[0].text == "51e4743");
+    CHECK(hints[0].range == SearchMatch { at(-2, 9), at(-2, 15) });
+    CHECK(hints[1].kind == HintKind::Path);
+    CHECK(hints[1].text == "/etc/hosts");
+    CHECK(hints[1].range == SearchMatch { at(0, 5), at(0, 14) });
+    CHECK(hints[2].kind == HintKind::Url);
+    CHECK(hints[2].range == SearchMatch { at(2, 0), at(2, 13) });
+    CHECK(cache.size() == 5);
+
+    // Only the viewport.
+    auto const visible = collectHints(grid, matcher, LineOffset(0), LineOffset(2), cache);
+    REQUIRE(visible.size() == 2);
+    CHECK(visible[0].text == "/etc/hosts");
+    CHECK(cache.size() == 5);
+
+    // Lines that have not been looked up since the previous sweep are dropped.
+    cache.sweep();
+    (void) collectHints(grid, matcher, LineOffset(0), LineOffset(2), cache);
+    cache.sweep();
+    CHECK(cache.size() == 3);
+}
+
+TEST_CASE("collectHints.rescan_changed_lines", "[hints]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(20) }, { "/usr/bin", "plain" });
+    auto const matcher = HintMatcher();
+    auto cache = HintCache();
+
+    CHECK(collectHints(grid, matcher, LineOffset(0), LineOffset(1), cache).size() == 1);
+
+    grid.setLineText(LineOffset(1), "/usr/lib");
+    auto const hints = collectHints(grid, matcher, LineOffset(0), LineOffset(1), cache);
+    REQUIRE(hints.size() == 2);
+    CHECK(hints[1].text == "/usr/lib");
+    CHECK(hints[1].range == SearchMatch { at(1, 0), at(1, 7) });
+}
@@ -0,0 +1,323 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/HistoryArchive.h>
+#include <terminal/VTWriter.h>
+
+#include <fmt/format.h>
+
+#include <unicode/grapheme_segmenter.h>
+#include <unicode/utf8.h>
+#include <unicode/width.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <optional>
+#include <stdexcept>
+#include <variant>
+
+using std::optional;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace terminal
+{
+
+namespace
+{
+    constexpr auto LineTerminator = string_view("\r\n");
+
+    constexpr auto writeMode = std::ios::out | std::ios::binary | std::ios::trunc;
+    constexpr auto readMode = std::ios::in | std::ios::binary;
+
+    /// Number of bytes in the UTF-8 sequence starting with @p _lead.
+    size_t utf8Length(char _lead) noexcept
+    {
+        auto const lead = static_cast<uint8_t>(_lead);
+        return lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+    }
+
+    /// Reads the extended color (5;n or 2;r;g;b) following the SGR parameter at @p _i,
+    /// advancing @p _i to its last parameter.
+    Color extendedColor(vector<unsigned> const& _params, size_t& _i) noexcept
+    {
+        if (_i + 2 < _params.size() && _params[_i + 1] == 5)
+        {
+            _i += 2;
+            return Color::Indexed(static_cast<uint8_t>(_params[_i]));
+        }
+        if (_i + 4 < _params.size() && _params[_i + 1] == 2)
+        {
+            _i += 4;
+            return RGBColor { static_cast<uint8_t>(_params[_i - 2]),
+                              static_cast<uint8_t>(_params[_i - 1]),
+                              static_cast<uint8_t>(_params[_i]) };
+        }
+        return DefaultColor();
+    }
+
+    /// Applies the SGR parameters as written by VTWriter for archived lines.
+    void applySGR(GraphicsAttributes& _attributes, vector<unsigned> const& _params) noexcept
+    {
+        if (_params.empty())
+            _attributes = {};
+
+        for (size_t i = 0; i < _params.size(); ++i)
+        {
+            auto const value = _params[i];
+            if (value == 0)
+                _attributes = {};
+            else if (value == 1)
+                _attributes.styles |= CellFlags::Bold;
+            else if (value == 22)
+                _attributes.styles &= ~CellFlags::Bold;
+            else if (30 <= value && value <= 37)
+                _attributes.foregroundColor = Color::Indexed(static_cast<uint8_t>(value - 30));
+            else if (value == 38)
+                _attributes.foregroundColor = extendedColor(_params, i);
+            else if (value == 39)
+                _attributes.foregroundColor = DefaultColor();
+            else if (40 <= value && value <= 47)
+                _attributes.backgroundColor = Color::Indexed(static_cast<uint8_t>(value - 40));
+            else if (value == 48)
+                _attributes.backgroundColor = extendedColor(_params, i);
+            else if (value == 49)
+                _attributes.backgroundColor = DefaultColor();
+            else if (90 <= value && value <= 97)
+                _attributes.foregroundColor = Color::Bright(static_cast<uint8_t>(value - 90));
+            else if (100 <= value && value <= 107)
+                _attributes.backgroundColor = Color::Bright(static_cast<uint8_t>(value - 100));
+        }
+    }
+} // namespace
+
+HistoryArchive::HistoryArchive(FileSystem::path _path):
+    path_ { std::move(_path) }, file_ { path_.string(), writeMode }
+{
+    if (!file_.is_open())
+        throw std::runtime_error(fmt::format("Could not open history archive file {}.", path_.string()));
+
+    // The archived lines are as private as the terminal's screen, so only the owner may read them.
+    auto ec = FileSystemError {};
+    FileSystem::permissions(path_, FileSystem::perms::owner_read | FileSystem::perms::owner_write, ec);
+    if (ec)
+        throw std::runtime_error(fmt::format(
+            "Could not restrict permissions of history archive file {}. {}", path_.string(), ec.message()));
+
+    writer_ = std::thread { [this]() { writeLoop(); } };
+}
+
+HistoryArchive::~HistoryArchive()
+{
+    {
+        auto const _ = std::lock_guard { lock_ };
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    writer_.join();
+
+    file_.close();
+    reader_.close();
+    auto ec = FileSystemError {};
+    FileSystem::remove(path_, ec);
+}
+
+void HistoryArchive::writeLoop()
+{
+    auto buffer = vector<char> {};
+    auto lock = std::unique_lock { lock_ };
+    while (true)
+    {
+        changed_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+        if (pending_.empty())
+            return; // stopping, with everything written
+
+        swap(buffer, pending_);
+        writing_ = true;
+        lock.unlock();
+
+        file_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        file_.flush();
+
+        lock.lock();
+        writing_ = false;
+        writtenBytes_ += buffer.size();
+        buffer.clear();
+        changed_.notify_all();
+    }
+}
+
+void HistoryArchive::waitUntilWritten(uint64_t _offset) const
+{
+    auto lock = std::unique_lock { lock_ };
+    changed_.wait(lock, [&]() { return writtenBytes_ >= _offset; });
+}
+
+template <typename Cell>
+void HistoryArchive::append(Line<Cell> const& _line)
+{
+    auto buffer = vector<char> {};
+    auto writer = VTWriter(buffer);
+    writer.write(_line);
+    writer.sgrFlush();
+    buffer.insert(buffer.end(), LineTerminator.begin(), LineTerminator.end());
+
+    offsets_.push_back(offsets_.back() + buffer.size());
+    flags_.push_back(_line.flags());
+
+    {
+        auto const _ = std::lock_guard { lock_ };
+        pending_.insert(pending_.end(), buffer.begin(), buffer.end());
+    }
+    changed_.notify_all();
+}
+
+string HistoryArchive::line(size_t _index) const
+{
+    assert(_index < size());
+
+    auto const offset = offsets_[_index];
+    auto const length = offsets_[_index + 1] - offset - LineTerminator.size();
+    waitUntilWritten(offsets_[_index + 1]);
+
+    if (!reader_.is_open())
+        reader_.open(path_.string(), readMode);
+    reader_.clear();
+
+    auto text = string(length, '\0');
+    reader_.seekg(static_cast<std::streamoff>(offset));
+    reader_.read(text.data(), static_cast<std::streamsize>(length));
+    return text;
+}
+
+string HistoryArchive::text(size_t _index) const
+{
+    // The stream consists of UTF-8 text, SGR sequences and REP sequences repeating the last
+    // character (see VTWriter).
+    auto const stream = line(_index);
+    auto text = string {};
+    auto lastCharacter = string_view {};
+    for (size_t i = 0; i < stream.size();)
+    {
+        if (stream[i] != '\033')
+        {
+            auto const length = std::min(utf8Length(stream[i]), stream.size() - i);
+            lastCharacter = string_view(stream).substr(i, length);
+            text += lastCharacter;
+            i += length;
+            continue;
+        }
+
+        auto count = size_t { 0 };
+        auto end = i + 2; // behind CSI
+        for (; end < stream.size() && (stream[end] < 0x40 || stream[end] > 0x7E); ++end)
+            if (std::isdigit(static_cast<unsigned char>(stream[end])))
+                count = count * 10 + static_cast<size_t>(stream[end] - '0');
+        if (end < stream.size() && stream[end] == 'b')
+            for (size_t k = 0; k < std::max(count, size_t { 1 }); ++k)
+                text += lastCharacter;
+        i = end + 1;
+    }
+    return text;
+}
+
+template <typename Cell>
+Line<Cell> HistoryArchive::decode(size_t _index, ColumnCount _columns) const
+{
+    // The stream consists of UTF-8 text, SGR sequences and REP sequences repeating the last
+    // character (see VTWriter).
+    auto const stream = line(_index);
+    auto const width = unbox<size_t>(_columns);
+
+    auto cells = InflatedLineBuffer<Cell> {};
+    cells.reserve(width);
+    auto attributes = GraphicsAttributes {};
+    auto lastCell = optional<size_t> {}; // index of the cell holding the last character written
+    auto lastChar = char32_t { 0 };
+    auto utf8DecoderState = unicode::utf8_decoder_state {};
+
+    auto const writeCell = [&](Cell const& _cell) {
+        lastCell = cells.size();
+        cells.emplace_back(_cell);
+        for (int i = 1; i < _cell.width(); ++i)
+            cells.emplace_back(Cell { attributes });
+    };
+
+    for (size_t i = 0; i < stream.size() && cells.size() < width;)
+    {
+        if (stream[i] != '\033')
+        {
+            auto const result = unicode::from_utf8(utf8DecoderState, static_cast<uint8_t>(stream[i++]));
+            if (!std::holds_alternative<unicode::Success>(result))
+                continue;
+
+            auto const nextChar = std::get<unicode::Success>(result).value;
+            if (lastCell && lastChar && !unicode::grapheme_segmenter::breakable(lastChar, nextChar))
+                cells[*lastCell].appendCharacter(nextChar);
+            else
+            {
+                auto cell = Cell {};
+                cell.write(attributes, nextChar, static_cast<uint8_t>(std::max(unicode::width(nextChar), 1)));
+                writeCell(cell);
+            }
+            lastChar = nextChar;
+            continue;
+        }
+
+        auto params = vector<unsigned> { 0 };
+        auto end = i + 2; // behind CSI
+        for (; end < stream.size() && (stream[end] < 0x40 || stream[end] > 0x7E); ++end)
+            if (std::isdigit(static_cast<unsigned char>(stream[end])))
+                params.back() = params.back() * 10 + static_cast<unsigned>(stream[end] - '0');
+            else if (stream[end] == ';')
+                params.push_back(0);
+
+        if (end < stream.size() && stream[end] == 'm')
+            applySGR(attributes, end == i + 2 ? vector<unsigned> {} : params);
+        else if (end < stream.size() && stream[end] == 'b' && lastCell)
+        {
+            auto const cell = cells[*lastCell];
+            for (unsigned k = 0; k < std::max(params[0], 1u) && cells.size() < width; ++k)
+                writeCell(cell);
+        }
+        i = end + 1;
+    }
+
+    cells.resize(width, Cell { attributes });
+    return Line<Cell>(flags(_index), std::move(cells));
+}
+
+void HistoryArchive::clear()
+{
+    {
+        // Lines being written right now are truncated right after.
+        auto lock = std::unique_lock { lock_ };
+        pending_.clear();
+        changed_.wait(lock, [this]() { return !writing_; });
+        file_.close();
+        file_.open(path_.string(), writeMode);
+        writtenBytes_ = 0;
+    }
+    reader_.close();
+    offsets_.resize(1);
+    flags_.clear();
+}
+
+} // namespace terminal
+
+#include <terminal/Cell.h>
+template void terminal::HistoryArchive::append<terminal::Cell>(Line<Cell> const&);
+template terminal::Line<terminal::Cell> terminal::HistoryArchive::decode<terminal::Cell>(size_t,
+                                                                                        ColumnCount) const;
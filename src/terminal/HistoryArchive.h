@@ -0,0 +1,110 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Line.h>
+
+#include <crispy/stdfs.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace terminal
+{
+
+/**
+ * Append-only, disk-backed storage of history lines that have been evicted from the Grid.
+ *
+ * Each line is stored as a VT sequence stream (text and SGR), terminated by CR LF,
+ * so that the archive file itself can be viewed with any VT compatible pager.
+ *
+ * Appending a line only serializes it, the file is written by a thread of the archive's own,
+ * so that evicting lines does not block on disk I/O. Reading an archived line back waits for
+ * it to be written.
+ *
+ * An in-memory index of line offsets provides O(1) access to any archived line.
+ * The archive file is removed when the archive is destroyed.
+ *
+ * All member functions are to be called from the thread owning the archive.
+ */
+class HistoryArchive
+{
+  public:
+    /// Creates (or truncates) the archive file at @p _path.
+    ///
+    /// @throws std::runtime_error if the file could not be opened for writing.
+    explicit HistoryArchive(FileSystem::path _path);
+    ~HistoryArchive();
+
+    HistoryArchive(HistoryArchive const&) = delete;
+    HistoryArchive& operator=(HistoryArchive const&) = delete;
+
+    [[nodiscard]] FileSystem::path const& path() const noexcept { return path_; }
+
+    /// @returns the number of archived lines.
+    [[nodiscard]] size_t size() const noexcept { return flags_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return flags_.empty(); }
+
+    /// @returns the number of bytes the archived lines occupy on disk.
+    [[nodiscard]] uint64_t bytesUsed() const noexcept { return offsets_.back(); }
+
+    /// Appends the given line to the end of the archive.
+    template <typename Cell>
+    void append(Line<Cell> const& _line);
+
+    /// @returns the VT sequence stream of the archived line at @p _index, with 0 being the oldest line.
+    [[nodiscard]] std::string line(size_t _index) const;
+
+    /// @returns the text of the archived line at @p _index without any VT sequences (UTF-8),
+    ///          e.g. for searching the archive.
+    [[nodiscard]] std::string text(size_t _index) const;
+
+    /// @returns the line flags of the archived line at @p _index, with 0 being the oldest line.
+    [[nodiscard]] LineFlags flags(size_t _index) const noexcept { return flags_[_index]; }
+
+    /// Decodes the archived line at @p _index back into a line of @p _columns columns,
+    /// e.g. for showing it in the viewport once it scrolled out of the Grid.
+    ///
+    /// Only what append() writes is restored, that is, the text along with its colors and boldness.
+    template <typename Cell>
+    [[nodiscard]] Line<Cell> decode(size_t _index, ColumnCount _columns) const;
+
+    /// Drops all archived lines.
+    void clear();
+
+  private:
+    void writeLoop();
+    void waitUntilWritten(uint64_t _offset) const;
+
+    FileSystem::path path_;
+    std::vector<uint64_t> offsets_ { 0 };
+    std::vector<LineFlags> flags_;
+
+    mutable std::mutex lock_;
+    mutable std::condition_variable changed_;
+    std::vector<char> pending_;  // serialized lines not yet handed to the writer thread
+    uint64_t writtenBytes_ = 0;  // bytes written to the file (and flushed)
+    bool writing_ = false;       // whether the writer thread is writing outside of the lock
+    bool stopping_ = false;
+    std::ofstream file_;         // only used by the writer thread while writing_
+    mutable std::ifstream reader_;
+    std::thread writer_;
+};
+
+} // namespace terminal
@@ -0,0 +1,303 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/HtmlWriter.h>
+
+#include <unicode/convert.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+using std::string;
+using std::string_view;
+
+namespace terminal
+{
+
+namespace
+{
+    constexpr auto Underlines = CellFlags::Underline | CellFlags::DoublyUnderlined
+                                | CellFlags::CurlyUnderlined | CellFlags::DottedUnderline
+                                | CellFlags::DashedUnderline;
+
+    constexpr auto Decorations =
+        Underlines | CellFlags::CrossedOut | CellFlags::Overline | CellFlags::Framed | CellFlags::Encircled;
+
+    /// Tests whether cells without text of the given style can be told apart from unstyled ones.
+    constexpr bool hasVisibleBackground(GraphicsAttributes const& style) noexcept
+    {
+        return !isDefaultColor(style.backgroundColor) || (style.styles & CellFlags::Inverse);
+    }
+
+    /// Tests whether spaces within a span of the given style would be visible.
+    constexpr bool showsBlanks(GraphicsAttributes const& style) noexcept
+    {
+        return hasVisibleBackground(style) || (style.styles & Decorations);
+    }
+
+    string cssOf(GraphicsAttributes const& style, ColorPalette const& palette)
+    {
+        auto const flags = style.styles;
+        auto const inverse = flags & CellFlags::Inverse;
+        auto const [fg, bg] = makeColors(palette, flags, false, style.foregroundColor, style.backgroundColor);
+
+        auto css = string {};
+        if (inverse || !isDefaultColor(style.foregroundColor))
+            css += fmt::format("color:{};", to_string(fg));
+        if (inverse || !isDefaultColor(style.backgroundColor))
+            css += fmt::format("background-color:{};", to_string(bg));
+        if (flags & CellFlags::Bold)
+            css += "font-weight:bold;";
+        if (flags & CellFlags::Faint)
+            css += "opacity:0.5;";
+        if (flags & CellFlags::Italic)
+            css += "font-style:italic;";
+        if (flags & CellFlags::Hidden)
+            css += "visibility:hidden;";
+        if (flags & (CellFlags::Framed | CellFlags::Encircled))
+            css += "outline:1px solid;";
+
+        auto lines = string {};
+        if (flags & Underlines)
+            lines += " underline";
+        if (flags & CellFlags::Overline)
+            lines += " overline";
+        if (flags & CellFlags::CrossedOut)
+            lines += " line-through";
+        if (!lines.empty())
+        {
+            css += "text-decoration:";
+            css += lines.substr(1);
+            if (flags & CellFlags::DoublyUnderlined)
+                css += " double";
+            else if (flags & CellFlags::CurlyUnderlined)
+                css += " wavy";
+            else if (flags & CellFlags::DottedUnderline)
+                css += " dotted";
+            else if (flags & CellFlags::DashedUnderline)
+                css += " dashed";
+            css += ';';
+        }
+        if ((flags & Underlines) && !isDefaultColor(style.underlineColor))
+            css += fmt::format(
+                "text-decoration-color:{};",
+                to_string(apply(palette, style.underlineColor, ColorTarget::Foreground, ColorMode::Normal)));
+
+        return css;
+    }
+} // namespace
+
+HtmlWriter::HtmlWriter(Writer writer, ColorPalette palette):
+    writer_ { std::move(writer) }, palette_ { std::move(palette) }
+{
+    buffer_.reserve(BufferSize * 2);
+}
+
+HtmlWriter::HtmlWriter(std::ostream& output, ColorPalette palette):
+    HtmlWriter { [&](char const* d, size_t n) { output.write(d, static_cast<std::streamsize>(n)); },
+                 std::move(palette) }
+{
+}
+
+HtmlWriter::~HtmlWriter()
+{
+    closeSpan();
+    flush();
+}
+
+void HtmlWriter::flush()
+{
+    if (buffer_.empty())
+        return;
+
+    writer_(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void HtmlWriter::flushIfFull()
+{
+    if (buffer_.size() >= BufferSize)
+        flush();
+}
+
+void HtmlWriter::setStyle(GraphicsAttributes const& style)
+{
+    if (style == currentStyle_)
+        return;
+
+    closeSpan();
+    currentStyle_ = style;
+    if (style == GraphicsAttributes {})
+        return;
+
+    buffer_ += "<span style=\"";
+    buffer_ += cssOf(style, palette_);
+    buffer_ += "\">";
+}
+
+void HtmlWriter::closeSpan()
+{
+    if (currentStyle_ == GraphicsAttributes {})
+        return;
+
+    buffer_ += "</span>";
+    currentStyle_ = {};
+}
+
+void HtmlWriter::writeText(string_view text)
+{
+    auto constexpr isSpecial = [](char ch) {
+        return ch == '<' || ch == '>' || ch == '&';
+    };
+
+    while (!text.empty())
+    {
+        auto const n = static_cast<size_t>(std::find_if(text.begin(), text.end(), isSpecial) - text.begin());
+        buffer_.append(text.data(), n);
+        if (n == text.size())
+            break;
+
+        switch (text[n])
+        {
+            case '<': buffer_ += "&lt;"; break;
+            case '>': buffer_ += "&gt;"; break;
+            default: buffer_ += "&amp;"; break;
+        }
+        text.remove_prefix(n + 1);
+    }
+}
+
+void HtmlWriter::writeCodepoint(char32_t codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        auto const ch = static_cast<char>(codepoint);
+        writeText(string_view(&ch, 1));
+        return;
+    }
+
+    char buf[4];
+    auto enc = unicode::encoder<char> {};
+    auto const count = std::distance(buf, enc(codepoint, buf));
+    buffer_.append(buf, static_cast<size_t>(count));
+}
+
+void HtmlWriter::writeBlanks(GraphicsAttributes const& style, size_t count)
+{
+    if (!count)
+        return;
+
+    if (!hasVisibleBackground(style))
+    {
+        pendingBlanks_ += count;
+        return;
+    }
+
+    writePendingBlanks();
+    setStyle(style);
+    buffer_.append(count, ' ');
+}
+
+void HtmlWriter::writePendingBlanks()
+{
+    if (!pendingBlanks_)
+        return;
+
+    if (showsBlanks(currentStyle_))
+        closeSpan();
+    buffer_.append(pendingBlanks_, ' ');
+    pendingBlanks_ = 0;
+}
+
+void HtmlWriter::endLine()
+{
+    closeSpan();
+    pendingBlanks_ = 0;
+    buffer_ += '\n';
+    flushIfFull();
+}
+
+template <typename Cell>
+void HtmlWriter::write(Line<Cell> const& line)
+{
+    if (line.isTrivialBuffer())
+    {
+        TriviallyStyledLineBuffer const& lineBuffer = line.trivialBuffer();
+        auto text = lineBuffer.text.view();
+        auto blanks = unbox<size_t>(lineBuffer.displayWidth - lineBuffer.usedColumns);
+
+        // Trailing spaces are handled like blanks, so that they are omitted at the end of a logical line.
+        while (!text.empty() && text.back() == ' ')
+        {
+            text.remove_suffix(1);
+            ++blanks;
+        }
+
+        if (!text.empty())
+        {
+            writePendingBlanks();
+            setStyle(lineBuffer.attributes);
+            writeText(text);
+        }
+        writeBlanks(lineBuffer.attributes, blanks);
+    }
+    else
+    {
+        auto const& cells = line.inflatedBuffer();
+        for (size_t i = 0; i < cells.size();)
+        {
+            Cell const& cell = cells[i];
+            auto const style = GraphicsAttributes {
+                cell.foregroundColor(), cell.backgroundColor(), cell.underlineColor(), cell.styles()
+            };
+
+            if (!cell.codepointCount())
+            {
+                writeBlanks(style, 1);
+                ++i;
+                continue;
+            }
+
+            writePendingBlanks();
+            setStyle(style);
+            for (size_t k = 0; k < cell.codepointCount(); ++k)
+                writeCodepoint(cell.codepoint(k));
+            i += std::max(size_t { 1 }, size_t { cell.width() });
+        }
+    }
+
+    flushIfFull();
+}
+
+template <typename Cell>
+void HtmlWriter::write(Grid<Cell> const& grid)
+{
+    auto const top = -boxed_cast<LineOffset>(grid.historyLineCount());
+    auto bottom = boxed_cast<LineOffset>(grid.pageSize().lines) - 1;
+    while (bottom >= top && grid.lineAt(bottom).empty() && !grid.lineAt(bottom).wrapped())
+        --bottom;
+
+    for (auto line = top; line <= bottom; ++line)
+    {
+        write(grid.lineAt(line));
+        if (line == bottom || !grid.lineAt(line + 1).wrapped())
+            endLine();
+    }
+}
+
+} // namespace terminal
+
+template void terminal::HtmlWriter::write<terminal::Cell>(Line<Cell> const&);
+template void terminal::HtmlWriter::write<terminal::Cell>(Grid<Cell> const&);
@@ -0,0 +1,81 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/ColorPalette.h>
+#include <terminal/GraphicsAttributes.h>
+#include <terminal/Grid.h>
+#include <terminal/Line.h>
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace terminal
+{
+
+// Serializes lines into HTML, to be placed within a <pre> element.
+//
+// Consecutive cells of the same style are written as one <span> with an inline style,
+// even across the lines a logical line is wrapped into, and unstyled text as is.
+// Trailing blanks of a logical line are omitted unless they have a background color.
+//
+// Output is buffered and passed on to the writer in chunks, so that arbitrarily long
+// histories are exported in bounded memory.
+class HtmlWriter
+{
+  public:
+    using Writer = std::function<void(char const*, size_t)>;
+
+    static constexpr inline size_t BufferSize = 64 * 1024;
+
+    explicit HtmlWriter(Writer writer, ColorPalette palette = {});
+    explicit HtmlWriter(std::ostream& output, ColorPalette palette = {});
+    ~HtmlWriter();
+
+    HtmlWriter(HtmlWriter const&) = delete;
+    HtmlWriter& operator=(HtmlWriter const&) = delete;
+
+    // Writes the given Line<> as a continuation of the current logical line.
+    template <typename Cell>
+    void write(Line<Cell> const& line);
+
+    // Ends the current logical line.
+    void endLine();
+
+    // Writes the logical lines of the grid, from its oldest history line down to the last non-empty line.
+    template <typename Cell>
+    void write(Grid<Cell> const& grid);
+
+    // Passes all buffered output on to the writer.
+    void flush();
+
+  private:
+    void setStyle(GraphicsAttributes const& style);
+    void writeText(std::string_view text);
+    void writeCodepoint(char32_t codepoint);
+    void writeBlanks(GraphicsAttributes const& style, size_t count);
+    void writePendingBlanks();
+    void closeSpan();
+    void flushIfFull();
+
+    Writer writer_;
+    ColorPalette palette_;
+    std::string buffer_;
+    GraphicsAttributes currentStyle_ {}; // style of the open <span>, or the default if none is open
+    size_t pendingBlanks_ = 0;           // invisible blanks, only written if followed by anything visible
+};
+
+} // namespace terminal
@@ -0,0 +1,118 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/Grid.h>
+#include <terminal/HeadlessTerminal.h>
+#include <terminal/HtmlWriter.h>
+#include <terminal/test_grid.h>
+
+#include <crispy/BufferObject.h>
+
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace terminal;
+using namespace terminal::test;
+
+namespace
+{
+
+template <typename T>
+string toHtml(T const& _gridOrLine)
+{
+    auto output = std::stringstream {};
+    {
+        auto writer = HtmlWriter(output);
+        writer.write(_gridOrLine);
+    }
+    return output.str();
+}
+
+} // namespace
+
+TEST_CASE("HtmlWriter.styleRuns", "[HtmlWriter]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(12) }, false, LineCount(0));
+    auto red = GraphicsAttributes {};
+    red.foregroundColor = RGBColor(0xFF0000);
+    auto bold = GraphicsAttributes {};
+    bold.styles |= CellFlags::Bold;
+
+    writeText(grid, 0, "a<b");
+    writeText(grid, 3, "red", red);
+    writeText(grid, 7, "&b", bold);
+    CHECK(toHtml(grid)
+          == "a&lt;b<span style=\"color:#FF0000;\">red </span>"
+             "<span style=\"font-weight:bold;\">&amp;b</span>\n");
+}
+
+TEST_CASE("HtmlWriter.blanks", "[HtmlWriter]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(1), ColumnCount(12) }, false, LineCount(0));
+    auto underlined = GraphicsAttributes {};
+    underlined.styles |= CellFlags::Underline;
+    auto blue = GraphicsAttributes {};
+    blue.backgroundColor = RGBColor(0x0000FF);
+
+    // Blanks would be underlined within the span, and trailing blanks are omitted.
+    writeText(grid, 0, "ab", underlined);
+    writeText(grid, 3, "cd", underlined);
+    CHECK(toHtml(grid)
+          == "<span style=\"text-decoration:underline;\">ab</span> "
+             "<span style=\"text-decoration:underline;\">cd</span>\n");
+
+    // Blanks with a background are visible.
+    grid.useCellAt(LineOffset(0), ColumnOffset(10)).reset(blue, {});
+    CHECK(toHtml(grid)
+          == "<span style=\"text-decoration:underline;\">ab</span> "
+             "<span style=\"text-decoration:underline;\">cd</span>     "
+             "<span style=\"background-color:#0000FF;\"> </span>\n");
+}
+
+TEST_CASE("HtmlWriter.trivialLine", "[HtmlWriter]")
+{
+    auto pool = crispy::BufferObjectPool(16);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd("x > y  ");
+
+    auto sgr = GraphicsAttributes {};
+    sgr.styles |= CellFlags::Italic;
+    auto line = Line<Cell>(LineFlags::None, ColumnCount(10), sgr);
+    line.setBuffer(TriviallyStyledLineBuffer {
+        ColumnCount(10), sgr, HyperlinkId {}, ColumnCount(7), bufferObject->ref(0, 7) });
+    REQUIRE(line.isTrivialBuffer());
+
+    auto output = std::stringstream {};
+    {
+        auto writer = HtmlWriter(output);
+        writer.write(line);
+        writer.write(line);
+        writer.endLine();
+    }
+    CHECK(output.str() == "<span style=\"font-style:italic;\">x &gt; y     x &gt; y</span>\n");
+}
+
+TEST_CASE("HtmlWriter.headless", "[HtmlWriter]")
+{
+    auto term = HeadlessTerminal(PageSize { LineCount(3), ColumnCount(8) }, LineCount(10));
+    term.write("one\r\n\033[31mwrapped text\033[m\r\nthree\r\n");
+
+    auto palette = ColorPalette {};
+    auto const red = to_string(palette.indexedColor(1));
+    CHECK(toHtml(term.grid())
+          == "one\n<span style=\"color:" + red + ";\">wrapped text</span>\nthree\n");
+}
@@ -0,0 +1,121 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+
+#include <crispy/FNV.h>
+
+using namespace std;
+
+namespace terminal
+{
+
+uint64_t HyperlinkStorage::hashOf(string_view _userId, string_view _uri) noexcept
+{
+    auto const fnv = crispy::FNV<char, uint64_t>();
+    auto hash = fnv(fnv.basis(), _userId);
+    hash = fnv(hash, '\0');
+    return fnv(hash, _uri);
+}
+
+HyperlinkId HyperlinkStorage::intern(string_view _userId, string_view _uri)
+{
+    // Only links with an explicit ID are shared, links without one are distinct per emission.
+    auto const interned = !_userId.empty();
+    auto const hash = interned ? hashOf(_userId, _uri) : 0;
+    if (interned)
+    {
+        auto const [first, last] = index_.equal_range(hash);
+        for (auto i = first; i != last; ++i)
+        {
+            auto const& info = slots_[unbox<size_t>(i->second) - 1].info;
+            if (info.userId == _userId && info.uri == _uri)
+                return i->second;
+        }
+    }
+
+    // Texts of small hyperlinks share an arena buffer, that lives as long as any of them.
+    auto const textSize = _userId.size() + _uri.size();
+    auto buffer = arena_;
+    if (textSize > ArenaSize)
+        buffer = crispy::BufferObject::create(textSize);
+    else if (!arena_ || arena_->bytesAvailable() < textSize)
+        buffer = arena_ = crispy::BufferObject::create(ArenaSize);
+
+    auto const userId = buffer->writeAtEnd(_userId);
+    buffer->advance(_userId.size());
+    auto const uri = buffer->writeAtEnd(_uri);
+    buffer->advance(_uri.size());
+
+    auto index = size_t { 0 };
+    if (!freeSlots_.empty())
+    {
+        index = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+    else
+    {
+        index = slots_.size();
+        slots_.emplace_back();
+    }
+
+    auto& slot = slots_[index];
+    slot.info = HyperlinkInfo { userId, uri };
+    slot.text = crispy::BufferFragment(move(buffer), string_view(userId.data(), textSize));
+    slot.hash = hash;
+
+    auto const id = HyperlinkId::cast_from(index + 1);
+    if (interned)
+        index_.emplace(hash, id);
+    return id;
+}
+
+void HyperlinkStorage::release(size_t _index)
+{
+    auto& slot = slots_[_index];
+    auto const id = HyperlinkId::cast_from(_index + 1);
+    auto const [first, last] = index_.equal_range(slot.hash);
+    for (auto i = first; i != last && !slot.info.userId.empty(); ++i)
+    {
+        if (i->second == id)
+        {
+            index_.erase(i);
+            break;
+        }
+    }
+
+    slot = Slot {};
+    freeSlots_.push_back(static_cast<uint32_t>(_index));
+}
+
+size_t HyperlinkStorage::memoryUsage() const noexcept
+{
+    // Hash nodes of the index are approximated by their value plus a next pointer and cached hash.
+    auto bytes = slots_.size() * sizeof(Slot) + freeSlots_.capacity() * sizeof(uint32_t)
+                 + index_.bucket_count() * sizeof(void*)
+                 + index_.size() * (sizeof(decltype(index_)::value_type) + 2 * sizeof(void*));
+    for (auto const& slot: slots_)
+        bytes += slot.text.size();
+    return bytes;
+}
+
+void HyperlinkStorage::clear()
+{
+    slots_.clear();
+    freeSlots_.clear();
+    index_.clear();
+    arena_.reset();
+    collectionThreshold_ = MinCollectionThreshold;
+}
+
+} // namespace terminal
@@ -13,13 +13,16 @@
  */
 #pragma once
 
-#include <crispy/LRUCache.h>
+#include <crispy/BufferObject.h>
 #include <crispy/boxed.h>
 
-#include <list>
-#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace terminal
 {
@@ -39,9 +42,9 @@ enum class HyperlinkState
 using URI = std::string;
 
 struct HyperlinkInfo
-{                       // TODO: rename to Hyperlink
-    std::string userId; //!< application provied ID
-    URI uri;
+{                            // TODO: rename to Hyperlink
+    std::string_view userId; //!< application provied ID
+    std::string_view uri;
     mutable HyperlinkState state = HyperlinkState::Inactive;
 
     bool isLocal() const noexcept { return uri.size() >= 7 && uri.substr(0, 7) == "file://"; }
@@ -59,7 +62,7 @@ struct HyperlinkInfo
     {
         if (auto const i = uri.find("://"); i != uri.npos)
             if (auto const j = uri.find('/', i + 3); j != uri.npos)
-                return std::string_view { uri.data() + j };
+                return uri.substr(j);
 
         return "";
     }
@@ -79,45 +82,99 @@ namespace detail
     {
     };
 } // namespace detail
-using HyperlinkId = crispy::boxed<uint16_t, detail::HyperlinkTag>;
+using HyperlinkId = crispy::boxed<uint32_t, detail::HyperlinkTag>;
 
 bool is_local(HyperlinkInfo const& _hyperlink);
 
-using HyperlinkCache = crispy::LRUCache<HyperlinkId, std::shared_ptr<HyperlinkInfo>>;
-
-struct HyperlinkStorage
+/// Stores the hyperlinks that grid cells refer to by their HyperlinkId.
+///
+/// Hyperlinks with a user ID are interned: emitting the same user ID and URI again yields the
+/// same ID, so that the cells of that link are recognized as one, wherever they are. Hyperlinks
+/// without a user ID get a new ID each time, as neighbouring links to the same URI are distinct.
+/// Their texts are packed into shared arena buffers rather than allocated one by one.
+/// Hyperlinks stay valid for as long as any cell refers to them, which is determined by
+/// collectGarbage(), rather than being evicted after a fixed number of newer hyperlinks.
+class HyperlinkStorage
 {
-    HyperlinkCache cache { 1024 };
-    HyperlinkId nextHyperlinkId = HyperlinkId(1);
+  public:
+    /// @returns the hyperlink of the given ID, or nullptr if there is none.
+    ///
+    /// The returned pointer stays valid until the next call to collectGarbage().
+    [[nodiscard]] HyperlinkInfo* hyperlinkById(HyperlinkId _id) noexcept;
+    [[nodiscard]] HyperlinkInfo const* hyperlinkById(HyperlinkId _id) const noexcept;
 
-    std::shared_ptr<HyperlinkInfo> hyperlinkById(HyperlinkId _id) noexcept
-    {
-        if (!!_id)
-            if (auto href = cache.try_get(_id))
-                return *href;
-        return {};
-    }
+    /// @returns the ID of the hyperlink with the given user ID and URI, creating it if needed
+    ///          or if @p _userId is empty.
+    HyperlinkId intern(std::string_view _userId, std::string_view _uri);
 
-    std::shared_ptr<HyperlinkInfo const> hyperlinkById(HyperlinkId _id) const noexcept
-    {
-        if (!!_id)
-            if (auto href = cache.try_get(_id))
-                return *href;
-        return {};
-    }
+    /// @returns the number of stored hyperlinks.
+    [[nodiscard]] size_t size() const noexcept { return slots_.size() - freeSlots_.size(); }
 
-    HyperlinkId hyperlinkIdByUserId(std::string const& _id) noexcept
+    /// @returns the estimated number of bytes held by the stored hyperlinks and their index.
+    [[nodiscard]] size_t memoryUsage() const noexcept;
+
+    /// Tests whether enough hyperlinks were added since the last collection for another one to pay off.
+    [[nodiscard]] bool needsCollection() const noexcept { return size() >= collectionThreshold_; }
+
+    /// Removes all hyperlinks that are not marked as used.
+    ///
+    /// @param _markUsed is invoked with a callable that is to be called with each hyperlink ID
+    ///                  that is still referenced, e.g. by a grid cell or a cursor.
+    template <typename MarkUsed>
+    void collectGarbage(MarkUsed&& _markUsed);
+
+    void clear();
+
+  private:
+    struct Slot
     {
-        for (auto& href: cache)
-        {
-            if (href.value->userId == _id)
-            {
-                cache.touch(href.key);
-                return href.key;
-            }
-        }
-        return HyperlinkId {};
-    }
+        HyperlinkInfo info {};
+        crispy::BufferFragment text {}; // keeps the arena buffer holding userId and uri alive
+        uint64_t hash = 0;
+    };
+
+    static uint64_t hashOf(std::string_view _userId, std::string_view _uri) noexcept;
+    void release(size_t _index);
+
+    static constexpr size_t MinCollectionThreshold = 1024;
+    static constexpr size_t ArenaSize = 64 * 1024;
+
+    std::deque<Slot> slots_;          // slot of a hyperlink ID is at index (ID - 1)
+    std::vector<uint32_t> freeSlots_; // indices of unused slots
+    std::unordered_multimap<uint64_t, HyperlinkId> index_;
+    crispy::BufferObjectPtr arena_;
+    size_t collectionThreshold_ = MinCollectionThreshold;
 };
 
+// {{{ HyperlinkStorage impl
+inline HyperlinkInfo* HyperlinkStorage::hyperlinkById(HyperlinkId _id) noexcept
+{
+    if (!_id || unbox<size_t>(_id) > slots_.size())
+        return nullptr;
+    auto& slot = slots_[unbox<size_t>(_id) - 1];
+    return slot.info.uri.empty() ? nullptr : &slot.info;
+}
+
+inline HyperlinkInfo const* HyperlinkStorage::hyperlinkById(HyperlinkId _id) const noexcept
+{
+    return const_cast<HyperlinkStorage*>(this)->hyperlinkById(_id);
+}
+
+template <typename MarkUsed>
+void HyperlinkStorage::collectGarbage(MarkUsed&& _markUsed)
+{
+    auto used = std::vector<bool>(slots_.size());
+    _markUsed([&](HyperlinkId _id) {
+        if (!!_id && unbox<size_t>(_id) <= used.size())
+            used[unbox<size_t>(_id) - 1] = true;
+    });
+
+    for (size_t i = 0; i < slots_.size(); ++i)
+        if (!used[i] && !slots_[i].info.uri.empty())
+            release(i);
+
+    collectionThreshold_ = std::max(MinCollectionThreshold, 2 * size());
+}
+// }}}
+
 } // namespace terminal
@@ -0,0 +1,101 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Hyperlink.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using namespace terminal;
+using std::string;
+
+TEST_CASE("HyperlinkStorage.intern", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage {};
+    auto const a = storage.intern("", "file://host/a");
+    auto const b = storage.intern("", "file://host/b");
+    auto const c = storage.intern("id1", "file://host/a");
+
+    CHECK(!!a);
+    CHECK(a != b);
+    CHECK(a != c);
+    CHECK(storage.intern("id1", "file://host/a") == c);
+    CHECK(storage.size() == 3);
+
+    // Links without an ID are distinct, even when they are emitted next to each other.
+    CHECK(storage.intern("", "file://host/a") != a);
+    CHECK(storage.size() == 4);
+
+    auto const* href = storage.hyperlinkById(c);
+    REQUIRE(href != nullptr);
+    CHECK(href->userId == "id1");
+    CHECK(href->uri == "file://host/a");
+    CHECK(href->host() == "host");
+    CHECK(href->path() == "/a");
+
+    CHECK(storage.hyperlinkById(HyperlinkId {}) == nullptr);
+    CHECK(storage.hyperlinkById(HyperlinkId(42)) == nullptr);
+
+    // URIs larger than an arena buffer are stored as well.
+    auto const longUri = "https://example.com/" + string(100'000, 'x');
+    auto const d = storage.intern("", longUri);
+    REQUIRE(storage.hyperlinkById(d) != nullptr);
+    CHECK(storage.hyperlinkById(d)->uri == longUri);
+}
+
+TEST_CASE("HyperlinkStorage.collectGarbage", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage {};
+    auto const a = storage.intern("", "https://a");
+    auto const b = storage.intern("b", "https://b");
+    auto const c = storage.intern("", "https://c");
+
+    storage.collectGarbage([&](auto _markUsed) {
+        _markUsed(a);
+        _markUsed(c);
+        _markUsed(HyperlinkId {});
+    });
+
+    CHECK(storage.size() == 2);
+    CHECK(storage.hyperlinkById(a)->uri == "https://a");
+    CHECK(storage.hyperlinkById(b) == nullptr);
+    CHECK(storage.hyperlinkById(c)->uri == "https://c");
+
+    // Released IDs are reused, and the released hyperlink is no longer found by its URI.
+    auto const d = storage.intern("", "https://d");
+    CHECK(d == b);
+    CHECK(storage.intern("b", "https://b") != b);
+    CHECK(storage.size() == 4);
+
+    storage.clear();
+    CHECK(storage.size() == 0);
+    CHECK(storage.hyperlinkById(a) == nullptr);
+}
+
+TEST_CASE("HyperlinkStorage.needsCollection", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage {};
+    auto count = 0;
+    while (!storage.needsCollection())
+        storage.intern("", "https://host/" + std::to_string(count++));
+    CHECK(count == 1024);
+
+    // With all hyperlinks still in use, the next collection is deferred until the storage doubled.
+    storage.collectGarbage([&](auto _markUsed) {
+        for (auto id = 1; id <= count; ++id)
+            _markUsed(HyperlinkId::cast_from(id));
+    });
+    CHECK(storage.size() == 1024);
+    CHECK_FALSE(storage.needsCollection());
+}
@@ -14,7 +14,12 @@
 #include <terminal/Image.h>
 
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <vector>
 
 using std::copy;
 using std::make_shared;
@@ -25,6 +30,7 @@ using std::shared_ptr;
 using std::string;
 
 using crispy::LRUCapacity;
+using crispy::StrongHash;
 using crispy::StrongHashtableSize;
 
 namespace terminal
@@ -42,6 +48,40 @@ Image::~Image()
     onImageRemove_(this);
 }
 
+void Image::evict() noexcept
+{
+    auto const pixels = data();
+    if (!pixels)
+        return;
+
+    auto spilled = make_shared<SpilledData>(std::tmpfile());
+    if (spilled->file
+        && std::fwrite(pixels->data(), 1, pixels->size(), spilled->file.get()) == pixels->size()
+        && std::fflush(spilled->file.get()) == 0)
+        std::atomic_store(&spilled_, move(spilled));
+
+    std::atomic_store(&data_, shared_ptr<Data const> {});
+}
+
+shared_ptr<Image::Data const> Image::load() const
+{
+    if (auto pixels = data())
+        return pixels;
+
+    auto const spilled = std::atomic_load(&spilled_);
+    if (!spilled)
+        return nullptr;
+
+    auto const _l = std::lock_guard { spilled->lock };
+    auto pixels = make_shared<Data>(byteCount_);
+    std::rewind(spilled->file.get());
+    if (std::fread(pixels->data(), 1, pixels->size(), spilled->file.get()) != pixels->size())
+        return nullptr;
+
+    ++ImageStats::get().reloaded;
+    return pixels;
+}
+
 RasterizedImage::~RasterizedImage()
 {
     --ImageStats::get().rasterized;
@@ -57,86 +97,316 @@ ImagePool::ImagePool(OnImageRemove _onImageRemove, ImageId _nextImageId):
     imageNameToImageCache_ { StrongHashtableSize { 1024 },
                              LRUCapacity { 100 },
                              "ImagePool name-to-image mappings" },
+    imagesByContent_ { ContentToImageCache::create(StrongHashtableSize { 1024 },
+                                                   LRUCapacity { 256 },
+                                                   "ImagePool content-to-image mappings") },
     onImageRemove_ { move(_onImageRemove) }
 {
 }
 
-Image::Data RasterizedImage::fragment(CellLocation _pos) const
+ImagePlacement RasterizedImage::placement() const noexcept
+{
+    auto const sourceWidth = unbox<int>(image_->width());
+    auto const sourceHeight = unbox<int>(image_->height());
+    auto const targetWidth = unbox<int>(cellSpan_.columns) * unbox<int>(cellSize_.width);
+    auto const targetHeight = unbox<int>(cellSpan_.lines) * unbox<int>(cellSize_.height);
+
+    auto placement = ImagePlacement { 0, 0, sourceWidth, sourceHeight };
+    if (sourceWidth && sourceHeight)
+    {
+        auto const scaleX = double(targetWidth) / double(sourceWidth);
+        auto const scaleY = double(targetHeight) / double(sourceHeight);
+        switch (resizePolicy_)
+        {
+            case ImageResize::NoResize: break;
+            case ImageResize::ResizeToFit:
+            case ImageResize::ResizeToFill: {
+                auto const scale = resizePolicy_ == ImageResize::ResizeToFit ? std::min(scaleX, scaleY)
+                                                                             : std::max(scaleX, scaleY);
+                placement.width = std::max(1, int(sourceWidth * scale));
+                placement.height = std::max(1, int(sourceHeight * scale));
+                break;
+            }
+            case ImageResize::StretchToFill:
+                placement.width = targetWidth;
+                placement.height = targetHeight;
+                break;
+        }
+    }
+
+    auto const gapX = targetWidth - placement.width;
+    auto const gapY = targetHeight - placement.height;
+    switch (alignmentPolicy_)
+    {
+        case ImageAlignment::TopStart:
+        case ImageAlignment::MiddleStart:
+        case ImageAlignment::BottomStart: break;
+        case ImageAlignment::TopCenter:
+        case ImageAlignment::MiddleCenter:
+        case ImageAlignment::BottomCenter: placement.x = gapX / 2; break;
+        case ImageAlignment::TopEnd:
+        case ImageAlignment::MiddleEnd:
+        case ImageAlignment::BottomEnd: placement.x = gapX; break;
+    }
+    switch (alignmentPolicy_)
+    {
+        case ImageAlignment::TopStart:
+        case ImageAlignment::TopCenter:
+        case ImageAlignment::TopEnd: break;
+        case ImageAlignment::MiddleStart:
+        case ImageAlignment::MiddleCenter:
+        case ImageAlignment::MiddleEnd: placement.y = gapY / 2; break;
+        case ImageAlignment::BottomStart:
+        case ImageAlignment::BottomCenter:
+        case ImageAlignment::BottomEnd: placement.y = gapY; break;
+    }
+    return placement;
+}
+
+size_t RasterizedImage::byteCount() const noexcept
+{
+    return (unbox<size_t>(cellSpan_.columns) * unbox<size_t>(cellSpan_.lines) + 1) * cellSize_.area() * 4;
+}
+
+shared_ptr<Image::Data const> RasterizedImage::rasterize() const
 {
-    // TODO: respect alignment hint
-    // TODO: respect resize hint
+    auto const cellWidth = unbox<int>(cellSize_.width);
+    auto const cellHeight = unbox<int>(cellSize_.height);
+    auto const columns = unbox<int>(cellSpan_.columns);
+    auto const lines = unbox<int>(cellSpan_.lines);
+    auto const targetWidth = columns * cellWidth;
+    auto const tilePixels = cellSize_.area();
 
-    auto const xOffset = _pos.column * unbox<int>(cellSize_.width);
-    auto const yOffset = _pos.line * unbox<int>(cellSize_.height);
-    auto const pixelOffset = CellLocation { yOffset, xOffset };
+    auto defaultPixel = uint32_t {};
+    auto const defaultBytes = std::array<uint8_t, 4> {
+        defaultColor_.red(), defaultColor_.green(), defaultColor_.blue(), defaultColor_.alpha()
+    };
+    std::memcpy(&defaultPixel, defaultBytes.data(), sizeof(defaultPixel));
 
-    Image::Data fragData;
-    fragData.resize(cellSize_.area() * 4); // RGBA
-    auto const availableWidth =
-        min(unbox<int>(image_->width()) - *pixelOffset.column, unbox<int>(cellSize_.width));
-    auto const availableHeight =
-        min(unbox<int>(image_->height()) - *pixelOffset.line, unbox<int>(cellSize_.height));
+    // One tile per grid cell, plus a trailing default-color tile for out-of-span access.
+    auto fragments = make_shared<Image::Data>(byteCount());
+    auto const tiles = reinterpret_cast<uint32_t*>(fragments->data());
+    std::fill(tiles, tiles + size_t(columns * lines + 1) * tilePixels, defaultPixel);
 
-    // auto const availableSize = Size{availableWidth, availableHeight};
-    // std::cout << fmt::format(
-    //     "RasterizedImage.fragment({}): pixelOffset={}, cellSize={}/{}\n",
-    //     _pos,
-    //     pixelOffset,
-    //     cellSize_,
-    //     availableSize
-    // );
+    auto const pixels = image_->load();
+    if (!pixels || pixels->size() < image_->size().area() * 4 || !cellWidth || !cellHeight)
+        return fragments;
 
-    // auto const fitsWidth = pixelOffset.column + cellSize_.width < image_.get().width();
-    // auto const fitsHeight = pixelOffset.line + cellSize_.height < image_.get().height();
-    // if (!fitsWidth || !fitsHeight)
-    //     std::cout << fmt::format("ImageFragment: out of bounds{}{} ({}x{}); {}\n",
-    //             fitsWidth ? "" : " (width)",
-    //             fitsHeight ? "" : " (height)",
-    //             availableWidth,
-    //             availableHeight,
-    //             *this);
+    auto const sourceWidth = unbox<int>(image_->width());
+    auto const sourceHeight = unbox<int>(image_->height());
+    auto const placement = this->placement();
 
-    // TODO: if input format is (RGB | PNG), transform to RGBA
+    // Visible horizontal range of the scaled image in target pixel coordinates.
+    auto const x0 = std::max(0, placement.x);
+    auto const x1 = std::min(targetWidth, placement.x + placement.width);
+    if (x0 >= x1)
+        return fragments;
 
-    auto target = &fragData[0];
+    // Source column for each visible target column (nearest neighbour).
+    auto const identityX = placement.width == sourceWidth;
+    auto sourceColumns = std::vector<int>();
+    if (!identityX)
+    {
+        sourceColumns.resize(size_t(x1 - x0));
+        for (int x = x0; x < x1; ++x)
+            sourceColumns[size_t(x - x0)] = int(int64_t(x - placement.x) * sourceWidth / placement.width);
+    }
 
-    // fill horizontal gap at the bottom
-    for (auto y = availableHeight * unbox<int>(cellSize_.width); y < int(cellSize_.area()); ++y)
+    auto const source = reinterpret_cast<uint32_t const*>(pixels->data());
+    auto const y0 = std::max(0, placement.y);
+    auto const y1 = std::min(lines * cellHeight, placement.y + placement.height);
+    for (int y = y0; y < y1; ++y)
     {
-        *target++ = defaultColor_.red();
-        *target++ = defaultColor_.green();
-        *target++ = defaultColor_.blue();
-        *target++ = defaultColor_.alpha();
+        auto const sourceY = int(int64_t(y - placement.y) * sourceHeight / placement.height);
+        auto const sourceRow = source + size_t(sourceY) * size_t(sourceWidth);
+        auto const line = y / cellHeight;
+        // Rows within a fragment are stored bottom-up.
+        auto const rowInTile = cellHeight - 1 - y % cellHeight;
+
+        for (int x = x0; x < x1;)
+        {
+            auto const column = x / cellWidth;
+            auto const spanEnd = std::min(x1, (column + 1) * cellWidth);
+            auto const target = tiles + size_t(line * columns + column) * tilePixels
+                                + size_t(rowInTile * cellWidth + x % cellWidth);
+            if (identityX)
+                std::copy(sourceRow + (x - placement.x), sourceRow + (spanEnd - placement.x), target);
+            else
+                for (int i = x; i < spanEnd; ++i)
+                    target[i - x] = sourceRow[sourceColumns[size_t(i - x0)]];
+            x = spanEnd;
+        }
     }
+    return fragments;
+}
 
-    for (int y = 0; y < availableHeight; ++y)
+RasterizedImage::Fragment RasterizedImage::fragment(CellLocation _pos) const
+{
+    auto fragments = std::atomic_load(&fragments_);
+    if (!fragments)
     {
-        auto const startOffset =
-            static_cast<size_t>(((*pixelOffset.line + (availableHeight - 1 - y)) * unbox<int>(image_->width())
-                                 + *pixelOffset.column)
-                                * 4);
-        auto const source = &image_->data()[startOffset];
-        target = copy(source, source + static_cast<ptrdiff_t>(availableWidth) * 4, target);
-
-        // fill vertical gap on right
-        for (int x = availableWidth; x < unbox<int>(cellSize_.width); ++x)
+        auto const _l = std::lock_guard { rasterizeLock_ };
+        fragments = std::atomic_load(&fragments_);
+        if (!fragments)
         {
-            *target++ = defaultColor_.red();
-            *target++ = defaultColor_.green();
-            *target++ = defaultColor_.blue();
-            *target++ = defaultColor_.alpha();
+            fragments = rasterize();
+            std::atomic_store(&fragments_, fragments);
         }
     }
 
-    return fragData;
+    auto const tileBytes = cellSize_.area() * 4;
+    auto const inside = 0 <= *_pos.line && *_pos.line < unbox<int>(cellSpan_.lines) && 0 <= *_pos.column
+                        && *_pos.column < unbox<int>(cellSpan_.columns);
+    auto const tile = inside ? size_t(*_pos.line * unbox<int>(cellSpan_.columns) + *_pos.column)
+                             : size_t(unbox<int>(cellSpan_.lines) * unbox<int>(cellSpan_.columns));
+    auto const pixels = gsl::span<uint8_t const>(fragments->data() + tile * tileBytes, tileBytes);
+    return Fragment { move(fragments), pixels };
 }
 
 shared_ptr<Image const> ImagePool::create(ImageFormat _format, ImageSize _size, Image::Data&& _data)
 {
-    // TODO: This operation should be idempotent, i.e. if that image has been created already, return a
-    // reference to that.
+    // Tools like timg or imgcat in a loop tend to send the very same image again and again.
+    auto const hash = StrongHash::compute(_data.data(), _data.size()) * StrongHash::compute(_format)
+                      * StrongHash::compute(_size);
+    if (auto const* entry = imagesByContent_->try_get(hash))
+    {
+        if (auto existing = entry->lock())
+        {
+            auto const pixels = existing->data();
+            if (pixels && *pixels == _data && existing->format() == _format && existing->size() == _size)
+            {
+                ++ImageStats::get().deduplicated;
+                touch(*existing);
+                return existing;
+            }
+        }
+    }
+
     auto const id = nextImageId_++;
-    return make_shared<Image>(id, _format, move(_data), _size, onImageRemove_);
+    auto image = make_shared<Image>(id, _format, move(_data), _size, onImageRemove_);
+    imagesByContent_->emplace(hash, std::weak_ptr<Image>(image));
+
+    residentImages_.emplace_back(ResidentImage { id, image, image->byteCount() });
+    residentBytes_ += image->byteCount();
+    enforceMemoryLimit(id);
+
+    return image;
+}
+
+void ImagePool::touch(Image const& _image)
+{
+    if (!residentImages_.empty() && residentImages_.back().id == _image.id())
+        return;
+
+    auto const i = std::find_if(residentImages_.begin(), residentImages_.end(), [&](auto const& entry) {
+        return entry.id == _image.id();
+    });
+    if (i != residentImages_.end())
+        residentImages_.splice(residentImages_.end(), residentImages_, i);
+}
+
+void ImagePool::setMemoryLimit(size_t _bytes)
+{
+    memoryLimit_ = _bytes;
+    enforceMemoryLimit(ImageId(0));
+}
+
+void ImagePool::trim(size_t _bytes)
+{
+    evictResidentImages(_bytes, ImageId(0));
+}
+
+void ImagePool::enforceMemoryLimit(ImageId _keep)
+{
+    if (memoryLimit_)
+        evictResidentImages(memoryLimit_, _keep);
+    else
+        evictResidentImages(std::numeric_limits<size_t>::max(), _keep);
+}
+
+size_t ImagePool::residentBytes() const noexcept
+{
+    auto bytes = residentBytes_;
+    for (auto const& rasterizedImage: rasterizedImages_)
+        if (auto const raster = rasterizedImage.lock())
+            bytes += raster->residentBytes();
+    return bytes;
+}
+
+size_t ImagePool::collectRasterizedImages()
+{
+    // Rasterized images are rasterized lazily by the renderer, so their size is looked at anew.
+    auto bytes = size_t { 0 };
+    for (auto i = rasterizedImages_.begin(); i != rasterizedImages_.end();)
+    {
+        if (auto const raster = i->lock())
+        {
+            bytes += raster->residentBytes();
+            ++i;
+        }
+        else
+            i = rasterizedImages_.erase(i);
+    }
+    return bytes;
+}
+
+void ImagePool::evictResidentImages(size_t _limit, ImageId _keep)
+{
+    auto& stats = ImageStats::get();
+    stats.residentBytes -= residentBytes_ + rasterBytes_;
+
+    // Forget about images that do not exist anymore.
+    for (auto i = residentImages_.begin(); i != residentImages_.end();)
+    {
+        if (i->image.expired())
+        {
+            residentBytes_ -= i->bytes;
+            i = residentImages_.erase(i);
+        }
+        else
+            ++i;
+    }
+
+    // Release the fragments of least recently placed images first, as they can be rasterized again.
+    rasterBytes_ = collectRasterizedImages();
+    auto const overLimit = [&]() { return residentBytes_ + rasterBytes_ > _limit; };
+
+    // Images being shown stay, as they would be loaded again right away. Only looked up when needed.
+    auto visible = std::optional<std::vector<ImageId>> {};
+    auto const evictable = [&](ImageId _id) {
+        if (_id == _keep)
+            return false;
+        if (!visible)
+            visible = visibleImages_ ? visibleImages_() : std::vector<ImageId> {};
+        return std::find(visible->begin(), visible->end(), _id) == visible->end();
+    };
+    for (auto i = rasterizedImages_.begin(); overLimit() && i != rasterizedImages_.end(); ++i)
+    {
+        auto const raster = i->lock();
+        if (!raster || !raster->residentBytes() || !evictable(raster->image().id()))
+            continue;
+        rasterBytes_ -= raster->residentBytes();
+        raster->releaseFragments();
+    }
+
+    // Evict least recently placed images until we are within the limit again.
+    for (auto i = residentImages_.begin(); overLimit() && i != residentImages_.end();)
+    {
+        if (!evictable(i->id))
+        {
+            ++i;
+            continue;
+        }
+        if (auto image = i->image.lock())
+        {
+            image->evict();
+            ++stats.evicted;
+        }
+        residentBytes_ -= i->bytes;
+        i = residentImages_.erase(i);
+    }
+
+    stats.residentBytes += residentBytes_ + rasterBytes_;
 }
 
 shared_ptr<RasterizedImage> ImagePool::rasterize(shared_ptr<Image const> _image,
@@ -146,8 +416,12 @@ shared_ptr<RasterizedImage> ImagePool::rasterize(shared_ptr<Image const> _image,
                                                  GridSize _cellSpan,
                                                  ImageSize _cellSize)
 {
-    return make_shared<RasterizedImage>(
+    touch(*_image);
+    auto raster = make_shared<RasterizedImage>(
         move(_image), _alignmentPolicy, _resizePolicy, _defaultColor, _cellSpan, _cellSize);
+    rasterizedImages_.emplace_back(raster);
+    enforceMemoryLimit(raster->image().id());
+    return raster;
 }
 
 void ImagePool::link(string const& _name, shared_ptr<Image const> _imageRef)
@@ -171,12 +445,17 @@ void ImagePool::unlink(string const& _name)
 void ImagePool::clear()
 {
     imageNameToImageCache_.clear();
+    imagesByContent_->clear();
 }
 
 void ImagePool::inspect(ostream& os) const
 {
     os << "Image pool:\n";
     os << fmt::format("global image stats: {}\n", ImageStats::get());
+    os << fmt::format("resident: {} bytes in {} images (limit: {} bytes)\n",
+                      residentBytes_,
+                      residentImages_.size(),
+                      memoryLimit_);
     imageNameToImageCache_.inspect(os);
 }
 
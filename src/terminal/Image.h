@@ -21,11 +21,15 @@
 
 #include <fmt/format.h>
 
+#include <gsl/span>
+
 #include <cstdint>
+#include <cstdio>
 #include <functional>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace terminal
@@ -53,6 +57,11 @@ struct ImageStats
     uint32_t instances = 0;
     uint32_t rasterized = 0;
     uint32_t fragments = 0;
+    uint64_t residentBytes = 0; //!< bytes of image pixels and rasters held in host memory by the pools
+    uint32_t evicted = 0;       //!< images whose pixels got evicted due to a memory limit
+    uint32_t reloaded = 0;      //!< evicted images whose pixels got loaded again to be rendered
+    uint32_t uploads = 0;       //!< image fragments uploaded to the GPU (including re-uploads)
+    uint32_t deduplicated = 0;  //!< images created with the same content as an existing one
 
     static ImageStats& get();
 };
@@ -72,7 +81,8 @@ class Image: public std::enable_shared_from_this<Image>
     Image(ImageId _id, ImageFormat _format, Data _data, ImageSize _pixelSize, OnImageRemove remover):
         id_ { _id },
         format_ { _format },
-        data_ { move(_data) },
+        byteCount_ { _data.size() },
+        data_ { std::make_shared<Data const>(move(_data)) },
         size_ { _pixelSize },
         onImageRemove_ { std::move(remover) }
     {
@@ -88,15 +98,42 @@ class Image: public std::enable_shared_from_this<Image>
 
     constexpr ImageId id() const noexcept { return id_; }
     constexpr ImageFormat format() const noexcept { return format_; }
-    Data const& data() const noexcept { return data_; }
+    /// @returns the image's pixels, or nullptr if they have been evicted from host memory.
+    ///
+    /// Placeholders of images that are still being decoded have no pixels, i.e. empty data.
+    std::shared_ptr<Data const> data() const noexcept { return std::atomic_load(&data_); }
+    /// @returns the image's pixels, loading them from where they have been spilled to if evicted,
+    /// or nullptr if they could not be spilled.
+    ///
+    /// Loaded pixels are not kept by the image, but by the caller, e.g. for rendering.
+    std::shared_ptr<Data const> load() const;
+    /// @returns the number of bytes the pixels occupy in host memory (before eviction).
+    size_t byteCount() const noexcept { return byteCount_; }
     constexpr ImageSize size() const noexcept { return size_; }
     constexpr Width width() const noexcept { return size_.width; }
     constexpr Height height() const noexcept { return size_.height; }
 
+    /// Releases the image's pixels to free host memory, spilling them into an anonymous temporary file
+    /// to be loaded from on demand.
+    ///
+    /// The image stays valid (and placed). If the pixels cannot be spilled, it is rendered in its
+    /// default color from then on.
+    void evict() noexcept;
+
   private:
+    struct SpilledData
+    {
+        explicit SpilledData(std::FILE* _file): file { _file, &std::fclose } {}
+
+        std::mutex lock;
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> file;
+    };
+
     ImageId id_;
     ImageFormat format_;
-    Data data_;
+    size_t byteCount_;
+    std::shared_ptr<Data const> data_; // accessed atomically, as the renderer may read it concurrently
+    std::shared_ptr<SpilledData> spilled_; // accessed atomically, set before data_ gets evicted
     ImageSize size_;
     OnImageRemove onImageRemove_;
 };
@@ -125,6 +162,15 @@ enum class ImageAlignment
     BottomEnd
 };
 
+/// Pixel rectangle a (scaled) image occupies relative to the top left of its rasterized grid area.
+struct ImagePlacement
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
 /**
  * RasterizedImage wraps an Image into a fixed-size grid with some additional graphical properties for
  * rasterization.
@@ -132,6 +178,16 @@ enum class ImageAlignment
 class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
 {
   public:
+    /// The pixels of one grid cell, keeping the buffer they are viewed from alive.
+    struct Fragment
+    {
+        std::shared_ptr<Image::Data const> buffer;
+        gsl::span<uint8_t const> pixels;
+
+        [[nodiscard]] uint8_t operator[](size_t _index) const noexcept { return pixels[_index]; }
+        [[nodiscard]] size_t size() const noexcept { return pixels.size(); }
+    };
+
     RasterizedImage(std::shared_ptr<Image const> _image,
                     ImageAlignment _alignmentPolicy,
                     ImageResize _resizePolicy,
@@ -165,16 +221,47 @@ class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
     GridSize cellSpan() const noexcept { return cellSpan_; }
     ImageSize cellSize() const noexcept { return cellSize_; }
 
+    /// @returns where the image is placed within its grid area after applying resize and alignment
+    /// policies. The result may exceed the grid area, in which case the image is cropped.
+    ImagePlacement placement() const noexcept;
+
     /// @returns an RGBA buffer for a grid cell at given coordinate @p _pos of the rasterized image.
-    Image::Data fragment(CellLocation _pos) const;
+    ///
+    /// The whole image is rasterized on first access and each fragment is a view into that buffer.
+    /// If the buffer has been released meanwhile, the image is rasterized again.
+    Fragment fragment(CellLocation _pos) const;
+
+    /// @returns the number of bytes the rasterized fragments take.
+    [[nodiscard]] size_t byteCount() const noexcept;
+
+    /// @returns the number of bytes the rasterized fragments currently take in host memory.
+    [[nodiscard]] size_t residentBytes() const noexcept
+    {
+        return std::atomic_load(&fragments_) ? byteCount() : 0;
+    }
+
+    /// Releases the rasterized fragments, e.g. to free host memory.
+    ///
+    /// Fragments handed out before stay valid.
+    void releaseFragments() noexcept
+    {
+        std::atomic_store(&fragments_, std::shared_ptr<Image::Data const> {});
+    }
 
   private:
+    [[nodiscard]] std::shared_ptr<Image::Data const> rasterize() const;
+
     std::shared_ptr<Image const> const image_; //!< Reference to the Image to be rasterized.
     ImageAlignment const alignmentPolicy_;     //!< Alignment policy of the image inside the raster size.
     ImageResize const resizePolicy_;           //!< Image resize policy
     RGBAColor const defaultColor_;             //!< Default color to be applied at corners when needed.
     GridSize const cellSpan_;                  //!< Number of grid cells to span the pixel image onto.
     ImageSize const cellSize_; //!< number of pixels in X and Y dimension one grid cell has to fill.
+
+    mutable std::mutex rasterizeLock_;
+    // RGBA fragments of all grid cells, followed by a default-color one. Accessed atomically, as the
+    // renderer rasterizes while the image pool may release them.
+    mutable std::shared_ptr<Image::Data const> fragments_;
 };
 
 /// An ImageFragment holds a graphical image that ocupies one full grid cell.
@@ -204,8 +291,15 @@ class ImageFragment
     /// @returns offset of this image fragment in pixels into the underlying image.
     CellLocation offset() const noexcept { return offset_; }
 
+    /// @returns a view to the pixels of this fragment that are to be rendered.
+    [[nodiscard]] RasterizedImage::Fragment pixels() const { return rasterizedImage_->fragment(offset_); }
+
     /// Extracts the data from the image that is to be rendered.
-    [[nodiscard]] Image::Data data() const { return rasterizedImage_->fragment(offset_); }
+    [[nodiscard]] Image::Data data() const
+    {
+        auto const fragment = pixels();
+        return Image::Data(fragment.pixels.begin(), fragment.pixels.end());
+    }
 
   private:
     std::shared_ptr<RasterizedImage const> rasterizedImage_;
@@ -242,11 +336,15 @@ class ImagePool
 {
   public:
     using OnImageRemove = std::function<void(Image const*)>;
+    using VisibleImages = std::function<std::vector<ImageId>()>;
 
     ImagePool(
         OnImageRemove _onImageRemove = [](auto) {}, ImageId _nextImageId = ImageId(1));
 
     /// Creates an RGBA image of given size in pixels.
+    ///
+    /// If an image with identical content is still alive, that one is returned instead,
+    /// sharing its pixels and any GPU resources associated with its ID.
     std::shared_ptr<Image const> create(ImageFormat _format, ImageSize _pixelSize, Image::Data&& _data);
 
     /// Rasterizes an Image.
@@ -267,16 +365,56 @@ class ImagePool
 
     void clear();
 
+    /// Limits the number of bytes the pixels of all images and their rasterized fragments may
+    /// occupy in host memory.
+    ///
+    /// When exceeded, the fragments of least recently placed rasterized images are released first,
+    /// as they can be rasterized again from the image's pixels, followed by the pixels of least
+    /// recently placed images, which are spilled to disk and loaded again when being rendered.
+    /// Images currently shown are never evicted. A value of 0 means unlimited.
+    void setMemoryLimit(size_t _bytes);
+    [[nodiscard]] size_t memoryLimit() const noexcept { return memoryLimit_; }
+    [[nodiscard]] size_t residentBytes() const noexcept;
+
+    /// Evicts fragments and pixels of least recently placed images until they occupy at most
+    /// @p _bytes, such as when the system runs low on memory.
+    void trim(size_t _bytes);
+
+    /// Sets the query for the IDs of the images currently shown, which are exempt from eviction.
+    void setVisibleImages(VisibleImages _visibleImages) { visibleImages_ = std::move(_visibleImages); }
+
   private:
     void removeRasterizedImage(RasterizedImage* _image); //!< Removes a rasterized image from pool.
+    void touch(Image const& _image);
+    void enforceMemoryLimit(ImageId _keep);
+    void evictResidentImages(size_t _limit, ImageId _keep);
+
+    struct ResidentImage
+    {
+        ImageId id;
+        std::weak_ptr<Image> image;
+        size_t bytes;
+    };
+
+    /// Drops the rasterized images that do not exist anymore.
+    /// @returns the number of bytes the fragments of the remaining ones occupy.
+    size_t collectRasterizedImages();
 
     using NameToImageIdCache = crispy::StrongLRUCache<std::string, std::shared_ptr<Image const>>;
+    using ContentToImageCache = crispy::StrongLRUHashtable<std::weak_ptr<Image>>;
 
     // data members
     //
+    std::list<ResidentImage> residentImages_;  //!< images with pixels in host memory, least recent first
+    size_t residentBytes_ = 0;                 //!< sum of bytes of all residentImages_
+    std::list<std::weak_ptr<RasterizedImage>> rasterizedImages_; //!< least recently placed first
+    size_t rasterBytes_ = 0;                   //!< bytes of rasterized fragments as of the last eviction
+    size_t memoryLimit_ = 0;                   //!< maximum of all resident bytes, or 0 if unlimited
     ImageId nextImageId_;                      //!< ID for next image to be put into the pool
     NameToImageIdCache imageNameToImageCache_; //!< keeps mapping from name to raw image
+    ContentToImageCache::Ptr imagesByContent_; //!< maps content hashes to (weak) images
     OnImageRemove const onImageRemove_;        //!< Callback to be invoked when image gets removed from pool.
+    VisibleImages visibleImages_;              //!< IDs of the images currently shown
 };
 
 } // namespace terminal
@@ -318,10 +456,16 @@ struct formatter<terminal::ImageStats>
     auto format(terminal::ImageStats stats, FormatContext& ctx)
     {
         return format_to(ctx.out(),
-                         "{} instances, {} raster, {} fragments",
+                         "{} instances, {} raster, {} fragments, {} bytes resident, {} evicted, {} reloaded, "
+                         "{} uploads, {} deduplicated",
                          stats.instances,
                          stats.rasterized,
-                         stats.fragments);
+                         stats.fragments,
+                         stats.residentBytes,
+                         stats.evicted,
+                         stats.reloaded,
+                         stats.uploads,
+                         stats.deduplicated);
     }
 };
 
@@ -0,0 +1,265 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Image.h>
+
+#include <catch2/catch.hpp>
+
+using namespace terminal;
+
+namespace
+{
+auto constexpr PixelSize = ImageSize { Width(4), Height(4) };
+auto constexpr ByteCount = 4 * 4 * 4;
+
+std::shared_ptr<Image const> createImage(ImagePool& _pool, uint8_t _value)
+{
+    return _pool.create(ImageFormat::RGBA, PixelSize, Image::Data(ByteCount, _value));
+}
+} // namespace
+
+TEST_CASE("ImagePool.create.deduplicate", "[image]")
+{
+    auto pool = ImagePool {};
+    auto const a = createImage(pool, 1);
+    auto const b = createImage(pool, 1);
+    auto const c = createImage(pool, 2);
+    CHECK(a == b);
+    CHECK(a->id() == b->id());
+    CHECK(a != c);
+    CHECK(pool.residentBytes() == 2 * ByteCount);
+
+    // Same pixels, different dimensions.
+    auto const d =
+        pool.create(ImageFormat::RGBA, ImageSize { Width(8), Height(2) }, Image::Data(ByteCount, 1));
+    CHECK(a != d);
+}
+
+TEST_CASE("ImagePool.create.deduplicateOnlyLiveImages", "[image]")
+{
+    auto pool = ImagePool {};
+    auto const firstId = createImage(pool, 1)->id();
+    auto const second = createImage(pool, 1);
+    CHECK(second->id() != firstId);
+}
+
+TEST_CASE("ImagePool.memoryLimit.unlimited", "[image]")
+{
+    auto pool = ImagePool {};
+    auto const a = createImage(pool, 1);
+    auto const b = createImage(pool, 2);
+    CHECK(pool.residentBytes() == 2 * ByteCount);
+    CHECK(a->data());
+    CHECK(b->data());
+}
+
+TEST_CASE("ImagePool.memoryLimit.evictLeastRecentlyUsed", "[image]")
+{
+    auto pool = ImagePool {};
+    pool.setMemoryLimit(2 * ByteCount);
+
+    auto const a = createImage(pool, 1);
+    auto const b = createImage(pool, 2);
+
+    // Placing a makes b the least recently used one.
+    auto const cellSize = ImageSize { Width(4), Height(4) };
+    auto const rasterized = pool.rasterize(
+        a, ImageAlignment::TopStart, ImageResize::NoResize, RGBAColor {}, GridSize {}, cellSize);
+
+    auto const c = createImage(pool, 3);
+    CHECK(pool.residentBytes() == 2 * ByteCount);
+    CHECK(a->data());
+    CHECK(!b->data());
+    CHECK(c->data());
+}
+
+TEST_CASE("ImagePool.trim", "[image]")
+{
+    auto pool = ImagePool {};
+    auto const a = createImage(pool, 1);
+    auto const b = createImage(pool, 2);
+
+    pool.trim(ByteCount);
+    CHECK(pool.residentBytes() == ByteCount);
+    CHECK(!a->data());
+    CHECK(b->data());
+
+    // Trimming does not impose a lasting limit.
+    auto const c = createImage(pool, 3);
+    CHECK(c->data());
+    CHECK(pool.residentBytes() == 2 * ByteCount);
+}
+
+TEST_CASE("ImagePool.memoryLimit.rasterizedFragments", "[image]")
+{
+    auto pool = ImagePool {};
+    auto const a = createImage(pool, 1);
+    auto const b = createImage(pool, 2);
+    auto const cellSpan = GridSize { LineCount(1), ColumnCount(1) };
+    auto const rasterize = [&](std::shared_ptr<Image const> const& _image) {
+        return pool.rasterize(
+            _image, ImageAlignment::TopStart, ImageResize::NoResize, RGBAColor {}, cellSpan, PixelSize);
+    };
+
+    // Fragments are rasterized on first access, one for the cell plus the default-color one.
+    auto const rasterizedA = rasterize(a);
+    CHECK(pool.residentBytes() == 2 * ByteCount);
+    CHECK(rasterizedA->fragment(CellLocation {})[0] == 1);
+    CHECK(rasterizedA->residentBytes() == 2 * ByteCount);
+    CHECK(pool.residentBytes() == 4 * ByteCount);
+
+    // Releasing the fragments of a goes first, as they can be rasterized again from its pixels.
+    auto const rasterizedB = rasterize(b);
+    CHECK(rasterizedB->fragment(CellLocation {})[0] == 2);
+    pool.setMemoryLimit(4 * ByteCount);
+    CHECK(rasterizedA->residentBytes() == 0);
+    CHECK(rasterizedB->residentBytes() == 2 * ByteCount);
+    CHECK(a->data());
+    CHECK(b->data());
+    CHECK(pool.residentBytes() == 4 * ByteCount);
+    CHECK(rasterizedA->fragment(CellLocation {})[0] == 1);
+}
+
+TEST_CASE("ImagePool.memoryLimit.evictedImageIsLoadedAgain", "[image]")
+{
+    auto pool = ImagePool {};
+    auto const image = createImage(pool, 0xFF);
+    auto const cellSize = ImageSize { Width(4), Height(4) };
+    auto const cellSpan = GridSize { LineCount(1), ColumnCount(1) };
+    auto const before = pool.rasterize(
+        image, ImageAlignment::TopStart, ImageResize::NoResize, RGBAColor {}, cellSpan, cellSize);
+    auto const handedOut = before->fragment(CellLocation {});
+    CHECK(handedOut[0] == 0xFF);
+
+    pool.setMemoryLimit(1);
+    REQUIRE(!image->data());
+    CHECK(before->residentBytes() == 0);
+    CHECK(pool.residentBytes() == 0);
+
+    // Fragments handed out before stay valid.
+    CHECK(handedOut[0] == 0xFF);
+
+    // The evicted pixels are loaded again on demand, without becoming resident again.
+    auto const pixels = image->load();
+    REQUIRE(pixels);
+    CHECK(*pixels == Image::Data(ByteCount, 0xFF));
+    CHECK(!image->data());
+
+    auto const after = pool.rasterize(
+        image, ImageAlignment::TopStart, ImageResize::NoResize, RGBAColor {}, cellSpan, cellSize);
+    CHECK(after->fragment(CellLocation {})[0] == 0xFF);
+    CHECK(before->fragment(CellLocation {})[0] == 0xFF);
+}
+
+TEST_CASE("ImagePool.memoryLimit.keepVisibleImages", "[image]")
+{
+    auto pool = ImagePool {};
+    auto visible = std::vector<ImageId> {};
+    pool.setVisibleImages([&]() { return visible; });
+
+    auto const a = createImage(pool, 1);
+    auto const b = createImage(pool, 2);
+    visible.push_back(a->id());
+
+    pool.trim(0);
+    CHECK(a->data());
+    CHECK(!b->data());
+    CHECK(pool.residentBytes() == ByteCount);
+
+    // Once scrolled out of view, it can be evicted as well.
+    visible.clear();
+    pool.trim(0);
+    CHECK(!a->data());
+    CHECK(pool.residentBytes() == 0);
+}
+
+TEST_CASE("RasterizedImage.fragment.placeholderRastersDefaultColor", "[image]")
+{
+    // Placeholders reserve the cells of images being decoded without allocating their pixels.
+    auto pool = ImagePool {};
+    auto const placeholder = pool.create(ImageFormat::RGBA, PixelSize, Image::Data {});
+    auto const defaultColor = RGBAColor { 0x10, 0x20, 0x30, 0x40 };
+    auto const rasterized = pool.rasterize(placeholder,
+                                           ImageAlignment::TopStart,
+                                           ImageResize::NoResize,
+                                           defaultColor,
+                                           GridSize { LineCount(1), ColumnCount(1) },
+                                           PixelSize);
+    auto const fragment = rasterized->fragment(CellLocation {});
+    REQUIRE(fragment.size() == ByteCount);
+    CHECK(fragment[0] == 0x10);
+    CHECK(fragment[ByteCount - 1] == 0x40);
+}
+
+TEST_CASE("RasterizedImage.fragment.layout", "[image]")
+{
+    // 3x2 image, each pixel's red channel encoding its position (10 * y + x).
+    auto pool = ImagePool {};
+    auto data = Image::Data(3 * 2 * 4, 0);
+    for (uint8_t y = 0; y < 2; ++y)
+        for (uint8_t x = 0; x < 3; ++x)
+            data[(y * 3u + x) * 4u] = uint8_t(10 * y + x);
+    auto const image = pool.create(ImageFormat::RGBA, ImageSize { Width(3), Height(2) }, move(data));
+
+    // Two cells of 2x2 pixels, leaving the rightmost column of the second cell uncovered.
+    auto const defaultColor = RGBAColor { 0xEE, 0, 0, 0 };
+    auto const rasterized = pool.rasterize(image,
+                                           ImageAlignment::TopStart,
+                                           ImageResize::NoResize,
+                                           defaultColor,
+                                           GridSize { LineCount(1), ColumnCount(2) },
+                                           ImageSize { Width(2), Height(2) });
+
+    auto const red = [](RasterizedImage::Fragment const& _fragment, int _x, int _y) {
+        // Fragment rows are stored bottom-up.
+        return _fragment[size_t(((1 - _y) * 2 + _x) * 4)];
+    };
+
+    auto const first = rasterized->fragment(CellLocation { LineOffset(0), ColumnOffset(0) });
+    CHECK(red(first, 0, 0) == 0);
+    CHECK(red(first, 1, 0) == 1);
+    CHECK(red(first, 0, 1) == 10);
+    CHECK(red(first, 1, 1) == 11);
+
+    auto const second = rasterized->fragment(CellLocation { LineOffset(0), ColumnOffset(1) });
+    CHECK(red(second, 0, 0) == 2);
+    CHECK(red(second, 1, 0) == 0xEE);
+    CHECK(red(second, 0, 1) == 12);
+    CHECK(red(second, 1, 1) == 0xEE);
+
+    // Cells outside of the span are filled with the default color.
+    auto const outside = rasterized->fragment(CellLocation { LineOffset(1), ColumnOffset(0) });
+    REQUIRE(outside.size() == 2 * 2 * 4);
+    CHECK(red(outside, 0, 0) == 0xEE);
+}
+
+TEST_CASE("RasterizedImage.fragment.resizeAndAlign", "[image]")
+{
+    // 1x1 image stretched into a 2x2 cell span, centered horizontally inside 4 columns.
+    auto pool = ImagePool {};
+    auto const image =
+        pool.create(ImageFormat::RGBA, ImageSize { Width(1), Height(1) }, Image::Data(4, 0x42));
+    auto const rasterized = pool.rasterize(image,
+                                           ImageAlignment::MiddleCenter,
+                                           ImageResize::ResizeToFit,
+                                           RGBAColor {},
+                                           GridSize { LineCount(2), ColumnCount(4) },
+                                           ImageSize { Width(1), Height(1) });
+
+    CHECK(rasterized->fragment(CellLocation { LineOffset(0), ColumnOffset(0) })[0] == 0);
+    CHECK(rasterized->fragment(CellLocation { LineOffset(0), ColumnOffset(1) })[0] == 0x42);
+    CHECK(rasterized->fragment(CellLocation { LineOffset(0), ColumnOffset(2) })[0] == 0x42);
+    CHECK(rasterized->fragment(CellLocation { LineOffset(1), ColumnOffset(0) })[0] == 0);
+    CHECK(rasterized->fragment(CellLocation { LineOffset(0), ColumnOffset(3) })[0] == 0);
+    CHECK(rasterized->fragment(CellLocation { LineOffset(1), ColumnOffset(1) })[0] == 0x42);
+}
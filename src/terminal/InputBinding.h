@@ -18,6 +18,11 @@
 
 #include <fmt/format.h>
 
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
 namespace terminal
 {
 
@@ -67,6 +72,82 @@ bool operator<(InputBinding<I, O> const& a, InputBinding<I, O> const& b) noexcep
     return false;
 }
 
+/**
+ * Precompiled lookup of the binding to apply for an input event.
+ *
+ * Bindings match on mode patterns rather than on the actual mode flags, so the index resolves,
+ * for every combination of actual mode flags, which binding wins for a given modifier and input.
+ * As with a linear scan, the first matching binding in the list takes precedence.
+ *
+ * The index refers to bindings by their position, so it stays valid when copied along with them.
+ */
+template <typename Input, typename Binding>
+class InputBindingIndex
+{
+  public:
+    using Bindings = std::vector<InputBinding<Input, Binding>>;
+
+    /// Number of distinct actual mode flag combinations (all MatchModes::Flag bits).
+    static constexpr unsigned ModeFlagCombinations = 0x20;
+
+    /// (Re)builds the index for the given bindings.
+    ///
+    /// @returns the positions of bindings that are shadowed by earlier ones in all modes,
+    ///          and thus never apply.
+    std::vector<size_t> build(Bindings const& _bindings)
+    {
+        index_.clear();
+        bindingCount_ = _bindings.size();
+
+        auto applied = std::vector<bool>(_bindings.size(), false);
+        for (size_t i = 0; i < _bindings.size(); ++i)
+        {
+            auto const& binding = _bindings[i];
+            for (unsigned flags = 0; flags < ModeFlagCombinations; ++flags)
+            {
+                if (!binding.modes.matches(static_cast<uint8_t>(flags)))
+                    continue;
+                auto const key = makeKey(static_cast<uint8_t>(flags), binding.modifier, binding.input);
+                if (index_.emplace(key, static_cast<uint32_t>(i)).second)
+                    applied[i] = true;
+            }
+        }
+
+        auto shadowed = std::vector<size_t> {};
+        for (size_t i = 0; i < applied.size(); ++i)
+            if (!applied[i])
+                shadowed.push_back(i);
+        return shadowed;
+    }
+
+    /// @returns whether the index has been built for the given bindings.
+    [[nodiscard]] bool builtFor(Bindings const& _bindings) const noexcept
+    {
+        return bindingCount_ == _bindings.size();
+    }
+
+    /// @returns the position of the binding to apply, if any.
+    [[nodiscard]] std::optional<size_t> find(uint8_t _actualModeFlags,
+                                             Modifier _modifier,
+                                             Input _input) const noexcept
+    {
+        auto const i = index_.find(makeKey(_actualModeFlags, _modifier, _input));
+        if (i == index_.end())
+            return std::nullopt;
+        return i->second;
+    }
+
+  private:
+    static constexpr uint64_t makeKey(uint8_t _actualModeFlags, Modifier _modifier, Input _input) noexcept
+    {
+        return (uint64_t(_actualModeFlags % ModeFlagCombinations) << 40)
+               | (uint64_t(_modifier.value() & 0xFF) << 32) | uint64_t(static_cast<uint32_t>(_input));
+    }
+
+    std::unordered_map<uint64_t, uint32_t> index_;
+    size_t bindingCount_ = 0;
+};
+
 } // namespace terminal
 
 namespace fmt
@@ -0,0 +1,77 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/InputBinding.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace terminal;
+using std::nullopt;
+using std::string;
+using std::vector;
+
+namespace
+{
+MatchModes modes(MatchModes::Flag _enabled, MatchModes::Flag _disabled = MatchModes::Default)
+{
+    auto result = MatchModes {};
+    if (_enabled != MatchModes::Default)
+        result.enable(_enabled);
+    if (_disabled != MatchModes::Default)
+        result.disable(_disabled);
+    return result;
+}
+
+using Binding = InputBinding<Key, string>;
+} // namespace
+
+TEST_CASE("InputBindingIndex.find", "[input]")
+{
+    auto const bindings = vector<Binding> {
+        Binding { modes(MatchModes::AlternateScreen), Modifier::Shift, Key::PageUp, "alt" },
+        Binding {
+            modes(MatchModes::Default, MatchModes::Insert), Modifier::Shift, Key::PageUp, "not-insert" },
+        Binding { MatchModes {}, Modifier::Shift, Key::PageUp, "any" },
+        Binding { MatchModes {}, Modifier::Control, Key::PageUp, "ctrl" },
+    };
+
+    auto index = InputBindingIndex<Key, string> {};
+    CHECK(index.build(bindings).empty());
+    CHECK(index.builtFor(bindings));
+
+    // The first binding matching the actual modes wins, as with a linear scan.
+    CHECK(index.find(MatchModes::AlternateScreen | MatchModes::Insert, Modifier::Shift, Key::PageUp) == 0);
+    CHECK(index.find(MatchModes::Default, Modifier::Shift, Key::PageUp) == 1);
+    CHECK(index.find(MatchModes::Insert, Modifier::Shift, Key::PageUp) == 2);
+    CHECK(index.find(MatchModes::Insert, Modifier::Control, Key::PageUp) == 3);
+    CHECK(index.find(MatchModes::Insert, Modifier::Alt, Key::PageUp) == nullopt);
+    CHECK(index.find(MatchModes::Insert, Modifier::Shift, Key::PageDown) == nullopt);
+}
+
+TEST_CASE("InputBindingIndex.shadowed", "[input]")
+{
+    auto const bindings = vector<Binding> {
+        Binding { MatchModes {}, Modifier::Shift, Key::Home, "any" },
+        Binding { modes(MatchModes::AppCursor), Modifier::Shift, Key::Home, "shadowed" },
+        Binding { modes(MatchModes::AppCursor), Modifier::Shift, Key::End, "end" },
+    };
+
+    auto index = InputBindingIndex<Key, string> {};
+    CHECK(index.build(bindings) == vector<size_t> { 1 });
+    CHECK(index.find(MatchModes::AppCursor, Modifier::Shift, Key::Home) == 0);
+    CHECK(index.find(MatchModes::AppCursor, Modifier::Shift, Key::End) == 2);
+    CHECK(index.find(MatchModes::Default, Modifier::Shift, Key::End) == nullopt);
+}
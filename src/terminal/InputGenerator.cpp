@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <iterator>
 #include <mutex>
 #include <string_view>
@@ -289,6 +290,7 @@ void InputGenerator::reset()
     mouseProtocol_ = std::nullopt;
     mouseTransport_ = MouseTransport::Default;
     mouseWheelMode_ = MouseWheelMode::Default;
+    pendingMouseEvent_.reset();
 
     // pendingSequence_ = {};
     // currentlyPressedMouseButtons_ = {};
@@ -326,6 +328,8 @@ bool InputGenerator::generate(u32string const& _characterEvent, Modifier _modifi
 
 bool InputGenerator::generate(char32_t _characterEvent, Modifier _modifier)
 {
+    flushPendingMouseEvent();
+
     char const chr = static_cast<char>(_characterEvent);
 
     // See section "Alt and Meta Keys" in ctlseqs.txt from xterm.
@@ -380,6 +384,8 @@ bool InputGenerator::generate(Key _key, Modifier _modifier)
         return success;
     };
 
+    flushPendingMouseEvent();
+
     if (_modifier)
     {
         if (auto mapping = tryMap(mappings::functionKeysWithModifiers, _key); mapping)
@@ -407,6 +413,8 @@ void InputGenerator::generatePaste(std::string_view const& _text)
     if (_text.empty())
         return;
 
+    flushPendingMouseEvent();
+
     if (bracketedPaste_)
         append("\033[200~"sv);
 
@@ -472,6 +480,9 @@ bool InputGenerator::generateRaw(std::string_view const& _raw)
 // {{{ mouse handling
 void InputGenerator::setMouseProtocol(MouseProtocol _mouseProtocol, bool _enabled)
 {
+    // Events coalesced so far are still reported as requested at the time they happened.
+    flushPendingMouseEvent();
+
     if (_enabled)
     {
         mouseWheelMode_ = MouseWheelMode::Default;
@@ -483,6 +494,7 @@ void InputGenerator::setMouseProtocol(MouseProtocol _mouseProtocol, bool _enable
 
 void InputGenerator::setMouseTransport(MouseTransport _mouseTransport)
 {
+    flushPendingMouseEvent();
     mouseTransport_ = _mouseTransport;
 }
 
@@ -491,6 +503,11 @@ void InputGenerator::setMouseWheelMode(MouseWheelMode _mode) noexcept
     mouseWheelMode_ = _mode;
 }
 
+void InputGenerator::setMouseCoalescingWindow(chrono::milliseconds _window) noexcept
+{
+    mouseCoalescingWindow_ = _window;
+}
+
 namespace
 {
     constexpr uint8_t modifierBits(Modifier _modifier) noexcept
@@ -699,7 +716,8 @@ bool InputGenerator::mouseTransportURXVT(MouseEventType _eventType,
 bool InputGenerator::generateMousePress(Modifier _modifier,
                                         MouseButton _button,
                                         CellLocation _pos,
-                                        PixelCoordinate _pixelPosition)
+                                        PixelCoordinate _pixelPosition,
+                                        Timestamp _now)
 {
     auto const logged = [=](bool success) -> bool {
         if (success)
@@ -712,33 +730,49 @@ bool InputGenerator::generateMousePress(Modifier _modifier,
     if (!mouseProtocol_.has_value())
         return false;
 
+    if (isMouseWheel(_button))
+    {
+        // Highlight tracking does not report button presses, leaving the wheel to the terminal.
+        if (mouseWheelMode() == MouseWheelMode::Default
+            && mouseProtocol_.value() == MouseProtocol::HighlightTracking)
+            return false;
+
+        auto const delta = _button == MouseButton::WheelUp ? 1 : -1;
+        auto const event =
+            PendingMouseEvent { MouseEventType::Press, _modifier, _button, _pos, _pixelPosition, delta };
+        return coalesceMouseEvent(event, _now);
+    }
+
+    flushPendingMouseEvent();
+
+    if (!currentlyPressedMouseButtons_.count(_button))
+        currentlyPressedMouseButtons_.insert(_button);
+
+    return logged(
+        generateMouse(MouseEventType::Press, _modifier, _button, currentMousePosition_, _pixelPosition));
+}
+
+bool InputGenerator::generateMouseWheel(Modifier _modifier,
+                                        MouseButton _button,
+                                        CellLocation _pos,
+                                        PixelCoordinate _pixelPosition)
+{
+    auto const logged = [=](bool success) -> bool {
+        if (success)
+            InputLog()("Sending mouse press {} {} at {}.", _button, _modifier, _pos);
+        return success;
+    };
+
     switch (mouseWheelMode())
     {
         case MouseWheelMode::NormalCursorKeys:
-            switch (_button)
-            {
-                case MouseButton::WheelUp: return logged(append("\033[A"));
-                case MouseButton::WheelDown: return logged(append("\033[B"));
-                default: break;
-            }
-            break;
+            return logged(append(_button == MouseButton::WheelUp ? "\033[A"sv : "\033[B"sv));
         case MouseWheelMode::ApplicationCursorKeys:
-            switch (_button)
-            {
-                case MouseButton::WheelUp: return logged(append("\033OA"));
-                case MouseButton::WheelDown: return logged(append("\033OB"));
-                default: break;
-            }
-            break;
+            return logged(append(_button == MouseButton::WheelUp ? "\033OA"sv : "\033OB"sv));
         case MouseWheelMode::Default: break;
     }
 
-    if (!isMouseWheel(_button))
-        if (!currentlyPressedMouseButtons_.count(_button))
-            currentlyPressedMouseButtons_.insert(_button);
-
-    return logged(
-        generateMouse(MouseEventType::Press, _modifier, _button, currentMousePosition_, _pixelPosition));
+    return logged(generateMouse(MouseEventType::Press, _modifier, _button, _pos, _pixelPosition));
 }
 
 bool InputGenerator::generateMouseRelease(Modifier _modifier,
@@ -754,6 +788,8 @@ bool InputGenerator::generateMouseRelease(Modifier _modifier,
 
     currentMousePosition_ = _pos;
 
+    flushPendingMouseEvent();
+
     if (auto i = currentlyPressedMouseButtons_.find(_button); i != currentlyPressedMouseButtons_.end())
         currentlyPressedMouseButtons_.erase(i);
 
@@ -761,21 +797,11 @@ bool InputGenerator::generateMouseRelease(Modifier _modifier,
         generateMouse(MouseEventType::Release, _modifier, _button, currentMousePosition_, _pixelPosition));
 }
 
-bool InputGenerator::generateMouseMove(Modifier _modifier, CellLocation _pos, PixelCoordinate _pixelPosition)
+bool InputGenerator::generateMouseMove(Modifier _modifier,
+                                       CellLocation _pos,
+                                       PixelCoordinate _pixelPosition,
+                                       Timestamp _now)
 {
-    auto const logged = [&](bool success) -> bool {
-        if (success)
-        {
-            InputLog()("[{}:{}] Sending mouse move at {} ({}:{}).",
-                       mouseProtocol_.value(),
-                       mouseTransport_,
-                       _pos,
-                       _pixelPosition.x.value,
-                       _pixelPosition.y.value);
-        }
-        return success;
-    };
-
     currentMousePosition_ = _pos;
 
     if (!mouseProtocol_.has_value())
@@ -787,16 +813,101 @@ bool InputGenerator::generateMouseMove(Modifier _modifier, CellLocation _pos, Pi
                         || mouseProtocol_.value() == MouseProtocol::AnyEventTracking;
 
     if (report)
-        return logged(generateMouse(
-            MouseEventType::Drag,
-            _modifier,
-            buttonsPressed ? *currentlyPressedMouseButtons_.begin() // what if multiple are pressed?
-                           : MouseButton::Release,
-            _pos,
-            _pixelPosition));
+        return coalesceMouseEvent(
+            PendingMouseEvent { MouseEventType::Drag,
+                                _modifier,
+                                buttonsPressed ? *currentlyPressedMouseButtons_.begin() // what if multiple?
+                                               : MouseButton::Release,
+                                _pos,
+                                _pixelPosition },
+            _now);
 
     return false;
 }
+
+bool InputGenerator::coalesceMouseEvent(PendingMouseEvent const& _event, Timestamp _now)
+{
+    if (mouseCoalescingWindow_ == chrono::milliseconds::zero())
+        return reportMouseEvent(_event);
+
+    auto const mergeable =
+        pendingMouseEvent_ && pendingMouseEvent_->type == _event.type
+        && pendingMouseEvent_->modifier == _event.modifier
+        && (_event.type == MouseEventType::Press || pendingMouseEvent_->button == _event.button);
+
+    if (!mergeable)
+    {
+        flushPendingMouseEvent();
+        pendingMouseEvent_ = _event;
+    }
+    else
+    {
+        // Motion only needs to report where the pointer ended up, and wheel ticks add up, with
+        // opposite directions cancelling each other out.
+        pendingMouseEvent_->position = _event.position;
+        pendingMouseEvent_->pixelPosition = _event.pixelPosition;
+        pendingMouseEvent_->wheelDelta += _event.wheelDelta;
+    }
+
+    tick(_now);
+    return true;
+}
+
+bool InputGenerator::tick(Timestamp _now)
+{
+    if (!pendingMouseEvent_ || _now - lastMouseReport_ < mouseCoalescingWindow_)
+        return false;
+
+    auto const pendingBytes = pendingSequence_.size();
+    flushPendingMouseEvent();
+    lastMouseReport_ = _now;
+    return pendingSequence_.size() != pendingBytes;
+}
+
+optional<chrono::milliseconds> InputGenerator::nextMouseReport(Timestamp _now) const noexcept
+{
+    if (!pendingMouseEvent_)
+        return nullopt;
+
+    auto const passed = chrono::duration_cast<chrono::milliseconds>(_now - lastMouseReport_);
+    return passed < mouseCoalescingWindow_ ? mouseCoalescingWindow_ - passed : chrono::milliseconds::zero();
+}
+
+void InputGenerator::flushPendingMouseEvent()
+{
+    if (!pendingMouseEvent_)
+        return;
+
+    auto const event = *pendingMouseEvent_;
+    pendingMouseEvent_.reset();
+    reportMouseEvent(event);
+}
+
+bool InputGenerator::reportMouseEvent(PendingMouseEvent const& _event)
+{
+    if (_event.type == MouseEventType::Press)
+    {
+        // Mouse protocols have no notion of a scroll count, so the ticks are reported one by one,
+        // yet all of them in the same write.
+        auto const button = _event.wheelDelta > 0 ? MouseButton::WheelUp : MouseButton::WheelDown;
+        bool success = true;
+        for (int i = 0; i < abs(_event.wheelDelta); ++i)
+            success = generateMouseWheel(_event.modifier, button, _event.position, _event.pixelPosition)
+                      && success;
+        return success;
+    }
+
+    auto const success =
+        generateMouse(_event.type, _event.modifier, _event.button, _event.position, _event.pixelPosition);
+    if (success)
+        InputLog()("[{}:{}] Sending mouse move at {} ({}:{}).",
+                   mouseProtocol_.value(),
+                   mouseTransport_,
+                   _event.position,
+                   _event.pixelPosition.x.value,
+                   _event.pixelPosition.y.value);
+    return success;
+}
 // }}}
 
 } // namespace terminal
@@ -20,6 +20,7 @@
 
 #include <unicode/convert.h>
 
+#include <chrono>
 #include <mutex>
 #include <optional>
 #include <set>
@@ -285,6 +286,26 @@ class InputGenerator
     void setMouseWheelMode(MouseWheelMode _mode) noexcept;
     [[nodiscard]] MouseWheelMode mouseWheelMode() const noexcept { return mouseWheelMode_; }
 
+    using Timestamp = std::chrono::steady_clock::time_point;
+
+    /// Sets the time window within which mouse motion and wheel events are coalesced before being
+    /// reported to the application. The first event after a quiet period is reported right away,
+    /// later ones are merged into one pending event until the window has passed.
+    /// A zero window (the default) reports every event immediately.
+    void setMouseCoalescingWindow(std::chrono::milliseconds _window) noexcept;
+    [[nodiscard]] std::chrono::milliseconds mouseCoalescingWindow() const noexcept
+    {
+        return mouseCoalescingWindow_;
+    }
+
+    /// Reports the pending coalesced mouse event, if its coalescing window has passed by @p _now.
+    ///
+    /// @retval true  input has been generated and is ready to be flushed.
+    bool tick(Timestamp _now);
+
+    /// @returns the time left until the pending coalesced mouse event is due, if any.
+    [[nodiscard]] std::optional<std::chrono::milliseconds> nextMouseReport(Timestamp _now) const noexcept;
+
     void setGenerateFocusEvents(bool _enable) noexcept { generateFocusEvents_ = _enable; }
     [[nodiscard]] bool generateFocusEvents() const noexcept { return generateFocusEvents_; }
 
@@ -295,8 +316,12 @@ class InputGenerator
     bool generateMousePress(Modifier _modifier,
                             MouseButton _button,
                             CellLocation _pos,
-                            PixelCoordinate _pixelPosition);
-    bool generateMouseMove(Modifier _modifier, CellLocation _pos, PixelCoordinate _pixelPosition);
+                            PixelCoordinate _pixelPosition,
+                            Timestamp _now);
+    bool generateMouseMove(Modifier _modifier,
+                           CellLocation _pos,
+                           PixelCoordinate _pixelPosition,
+                           Timestamp _now);
     bool generateMouseRelease(Modifier _modifier,
                               MouseButton _button,
                               CellLocation _pos,
@@ -338,6 +363,25 @@ class InputGenerator
     void reset();
 
   private:
+    /// A mouse motion, or a burst of wheel ticks, not yet reported to the application.
+    struct PendingMouseEvent
+    {
+        MouseEventType type; // Drag for motion, Press for wheel ticks.
+        Modifier modifier;
+        MouseButton button;
+        CellLocation position;
+        PixelCoordinate pixelPosition;
+        int wheelDelta = 0; // Wheel ticks, positive upwards, negative downwards.
+    };
+
+    bool coalesceMouseEvent(PendingMouseEvent const& _event, Timestamp _now);
+    bool reportMouseEvent(PendingMouseEvent const& _event);
+    void flushPendingMouseEvent();
+    bool generateMouseWheel(Modifier _modifier,
+                            MouseButton _button,
+                            CellLocation _pos,
+                            PixelCoordinate _pixelPosition);
+
     bool generateMouse(MouseEventType _eventType,
                        Modifier _modifier,
                        MouseButton _button,
@@ -375,6 +419,10 @@ class InputGenerator
 
     std::set<MouseButton> currentlyPressedMouseButtons_ {};
     CellLocation currentMousePosition_ {}; // current mouse position
+
+    std::chrono::milliseconds mouseCoalescingWindow_ {};
+    std::optional<PendingMouseEvent> pendingMouseEvent_ {};
+    Timestamp lastMouseReport_ {};
 };
 
 inline std::string to_string(InputGenerator::MouseEventType _value)
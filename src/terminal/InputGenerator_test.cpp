@@ -20,6 +20,7 @@
 #include <catch2/catch.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iterator>
 #include <string>
@@ -122,3 +123,50 @@ TEST_CASE("InputGenerator.all(Ctrl + A..Z)", "[terminal,input]")
         REQUIRE(escape(input.peek()) == escape(c0));
     }
 }
+
+TEST_CASE("InputGenerator.MouseCoalescing", "[terminal,input]")
+{
+    using namespace std::chrono_literals;
+    using terminal::CellLocation;
+    using terminal::MouseButton;
+
+    auto const at = [](int _line, int _column) {
+        return CellLocation { terminal::LineOffset(_line), terminal::ColumnOffset(_column) };
+    };
+    auto const pixels = terminal::PixelCoordinate {};
+    auto const now = InputGenerator::Timestamp {} + 1s;
+
+    auto input = InputGenerator {};
+    input.setMouseProtocol(terminal::MouseProtocol::AnyEventTracking, true);
+    input.setMouseTransport(terminal::MouseTransport::SGR);
+    input.setMouseCoalescingWindow(10ms);
+
+    // The first motion is reported right away, the following ones only by their final position.
+    CHECK(input.generateMouseMove(Modifier::None, at(0, 0), pixels, now));
+    CHECK(input.peek() == "\033[<35;1;1M"sv);
+    input.consume(static_cast<int>(input.peek().size()));
+
+    CHECK(input.generateMouseMove(Modifier::None, at(0, 1), pixels, now + 2ms));
+    CHECK(input.generateMouseMove(Modifier::None, at(0, 2), pixels, now + 4ms));
+    CHECK(input.peek().empty());
+    CHECK(input.nextMouseReport(now + 4ms) == 6ms);
+    CHECK(!input.tick(now + 9ms));
+    CHECK(input.tick(now + 10ms));
+    CHECK(input.peek() == "\033[<35;3;1M"sv);
+    CHECK(!input.nextMouseReport(now + 10ms));
+    input.consume(static_cast<int>(input.peek().size()));
+
+    // Wheel ticks add up, opposite directions cancelling out, and get reported in one go.
+    for (auto const button: { MouseButton::WheelUp, MouseButton::WheelUp, MouseButton::WheelDown,
+                              MouseButton::WheelUp, MouseButton::WheelUp })
+        CHECK(input.generateMousePress(Modifier::None, button, at(1, 1), pixels, now + 12ms));
+    CHECK(input.peek().empty());
+    CHECK(input.tick(now + 20ms));
+    CHECK(input.peek() == "\033[<64;2;2M\033[<64;2;2M\033[<64;2;2M"sv);
+    input.consume(static_cast<int>(input.peek().size()));
+
+    // Any other input reports the pending event first, preserving the order of events.
+    CHECK(input.generateMouseMove(Modifier::None, at(2, 2), pixels, now + 21ms));
+    input.generate('x', Modifier::None);
+    CHECK(input.peek() == "\033[<35;3;3Mx"sv);
+}
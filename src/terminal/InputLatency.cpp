@@ -0,0 +1,195 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/InputLatency.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace terminal
+{
+
+namespace
+{
+    // Key presses the application never echoes must not pile up.
+    constexpr size_t MaxInflightSamples = 256;
+
+    constexpr string_view stageName(LatencyStage _stage) noexcept
+    {
+        switch (_stage)
+        {
+            case LatencyStage::PtyWrite: return "pty write";
+            case LatencyStage::Echo: return "echo";
+            case LatencyStage::Render: return "render";
+            case LatencyStage::Present: return "present";
+            case LatencyStage::Total: return "total";
+        }
+        return "unknown";
+    }
+
+    uint32_t microsBetween(InputLatency::Timestamp _from, InputLatency::Timestamp _to) noexcept
+    {
+        auto const micros = chrono::duration_cast<chrono::microseconds>(_to - _from).count();
+        return static_cast<uint32_t>(clamp<int64_t>(micros, 0, numeric_limits<uint32_t>::max()));
+    }
+} // namespace
+
+void InputLatency::setEnabled(bool _enabled)
+{
+    auto const _ = lock_guard { mutex_ };
+    enabled_ = _enabled;
+    inflight_.clear();
+}
+
+void InputLatency::keyPressed(Timestamp _now)
+{
+    if (!enabled())
+        return;
+
+    auto const _ = lock_guard { mutex_ };
+    if (inflight_.size() == MaxInflightSamples)
+        inflight_.pop_front();
+    inflight_.emplace_back().pressed = _now;
+}
+
+void InputLatency::inputWritten(Timestamp _now)
+{
+    if (!enabled())
+        return;
+
+    auto const _ = lock_guard { mutex_ };
+    for (Sample& sample: inflight_)
+        if (!sample.written)
+            sample.written = _now;
+}
+
+void InputLatency::outputParsed(Timestamp _now)
+{
+    if (!enabled())
+        return;
+
+    auto const _ = lock_guard { mutex_ };
+    for (Sample& sample: inflight_)
+        if (sample.written && !sample.parsed)
+            sample.parsed = _now;
+}
+
+void InputLatency::frameBuilt(uint64_t _frameID)
+{
+    if (!enabled())
+        return;
+
+    auto const _ = lock_guard { mutex_ };
+    for (Sample& sample: inflight_)
+        if (sample.parsed && !sample.frameID)
+            sample.frameID = _frameID;
+}
+
+void InputLatency::frameSwapped(uint64_t _frameID, Timestamp _now)
+{
+    if (!enabled())
+        return;
+
+    auto const _ = lock_guard { mutex_ };
+    for (Sample& sample: inflight_)
+        if (sample.frameID && sample.frameID <= _frameID && !sample.swapped)
+            sample.swapped = _now;
+}
+
+void InputLatency::framePresented(Timestamp _now)
+{
+    if (!enabled())
+        return;
+
+    auto const _ = lock_guard { mutex_ };
+    auto const presented = [](Sample const& _sample) {
+        return _sample.swapped.has_value();
+    };
+    for (Sample const& sample: inflight_)
+        if (presented(sample))
+            record(sample, _now);
+    inflight_.erase(remove_if(inflight_.begin(), inflight_.end(), presented), inflight_.end());
+}
+
+void InputLatency::record(Sample const& _sample, Timestamp _presented)
+{
+    auto const durations = array<uint32_t, LatencyStageCount> {
+        microsBetween(_sample.pressed, *_sample.written),
+        microsBetween(*_sample.written, *_sample.parsed),
+        microsBetween(*_sample.parsed, *_sample.swapped),
+        microsBetween(*_sample.swapped, _presented),
+        microsBetween(_sample.pressed, _presented),
+    };
+
+    auto const slot = sampleCount_ % WindowSize;
+    for (size_t stage = 0; stage < LatencyStageCount; ++stage)
+    {
+        auto& window = durations_[stage];
+        if (window.size() < WindowSize)
+            window.push_back(durations[stage]);
+        else
+            window[slot] = durations[stage];
+    }
+    ++sampleCount_;
+}
+
+optional<chrono::microseconds> InputLatency::percentile(LatencyStage _stage, double _percentile) const
+{
+    auto sorted = [&]() {
+        auto const _ = lock_guard { mutex_ };
+        return durations_[static_cast<size_t>(_stage)];
+    }();
+    if (sorted.empty())
+        return nullopt;
+
+    auto const rank = static_cast<size_t>(ceil(_percentile / 100.0 * static_cast<double>(sorted.size())));
+    auto const nth = sorted.begin() + static_cast<ptrdiff_t>(clamp<size_t>(rank, 1, sorted.size()) - 1);
+    nth_element(sorted.begin(), nth, sorted.end());
+    return chrono::microseconds(*nth);
+}
+
+uint64_t InputLatency::sampleCount() const
+{
+    auto const _ = lock_guard { mutex_ };
+    return sampleCount_;
+}
+
+void InputLatency::inspect(std::ostream& _os) const
+{
+    auto const count = sampleCount();
+    _os << fmt::format("Input latency ({} key presses measured):\n", count);
+    if (!count)
+        return;
+
+    auto const formatted = [](optional<chrono::microseconds> _value) {
+        auto const micros = _value.value_or(chrono::microseconds(0)).count();
+        return fmt::format("{:.2f}ms", static_cast<double>(micros) / 1000.0);
+    };
+
+    for (size_t stage = 0; stage < LatencyStageCount; ++stage)
+    {
+        auto const id = static_cast<LatencyStage>(stage);
+        _os << fmt::format("  {:<10} P50 {:>9}  P90 {:>9}  P99 {:>9}\n",
+                           stageName(id),
+                           formatted(percentile(id, 50)),
+                           formatted(percentile(id, 90)),
+                           formatted(percentile(id, 99)));
+    }
+}
+
+} // namespace terminal
@@ -0,0 +1,111 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace terminal
+{
+
+/// The phases a key press passes through until its echo is visible on screen.
+enum class LatencyStage
+{
+    PtyWrite, //!< From the key event entering the input generator until written into the PTY.
+    Echo,     //!< From the PTY write until the next PTY output has been parsed.
+    Render,   //!< From parsing the echo until the render buffer holding it has been swapped in.
+    Present,  //!< From that render buffer swap until the frame has been presented.
+    Total,    //!< From the key event until the frame has been presented.
+};
+
+constexpr size_t LatencyStageCount = 5;
+
+/**
+ * Measures keypress-to-photon latency, split into the stages a key press passes through.
+ *
+ * Each key event starts a sample, which is then stamped by the terminal and the frontend as
+ * the input is written, echoed back, rendered, and presented. Stamps apply to all samples
+ * that have completed the previous stage, so a burst of keys shares the frame presenting it.
+ * The PTY output parsed after a write is taken to be its echo.
+ *
+ * Measuring is disabled by default, leaving every hook to be a single flag test.
+ */
+class InputLatency
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Timestamp = Clock::time_point;
+
+    /// Number of most recent measurements per stage that percentiles are computed over.
+    static constexpr size_t WindowSize = 4096;
+
+    void setEnabled(bool _enabled);
+    [[nodiscard]] bool enabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /// A key event entered the input generator.
+    void keyPressed(Timestamp _now);
+
+    /// Pending input has been written into the PTY.
+    void inputWritten(Timestamp _now);
+
+    /// PTY output has been parsed.
+    void outputParsed(Timestamp _now);
+
+    /// The render buffer frame @p _frameID has been built from the current screen state.
+    void frameBuilt(uint64_t _frameID);
+
+    /// The render buffer frame @p _frameID has been swapped to the front.
+    void frameSwapped(uint64_t _frameID, Timestamp _now);
+
+    /// The frontend has presented the front render buffer.
+    void framePresented(Timestamp _now);
+
+    /// @returns the given percentile (0..100) of the measured stage durations, if any.
+    [[nodiscard]] std::optional<std::chrono::microseconds> percentile(LatencyStage _stage,
+                                                                      double _percentile) const;
+
+    /// @returns the number of key presses measured all the way through.
+    [[nodiscard]] uint64_t sampleCount() const;
+
+    /// Writes a P50/P90/P99 summary of all stages.
+    void inspect(std::ostream& _os) const;
+
+  private:
+    /// The times a single key event reached each stage, as far as it did.
+    struct Sample
+    {
+        Timestamp pressed;
+        std::optional<Timestamp> written;
+        std::optional<Timestamp> parsed;
+        uint64_t frameID = 0;
+        std::optional<Timestamp> swapped;
+    };
+
+    void record(Sample const& _sample, Timestamp _presented);
+
+    std::atomic<bool> enabled_ = false;
+    mutable std::mutex mutex_;
+    std::deque<Sample> inflight_;
+    std::array<std::vector<uint32_t>, LatencyStageCount> durations_; // in µs, ring of WindowSize.
+    uint64_t sampleCount_ = 0;
+};
+
+} // namespace terminal
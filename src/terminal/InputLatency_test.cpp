@@ -0,0 +1,74 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/InputLatency.h>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <sstream>
+
+using namespace std::chrono_literals;
+using terminal::InputLatency;
+using terminal::LatencyStage;
+
+TEST_CASE("InputLatency.disabled", "[latency]")
+{
+    auto latency = InputLatency {};
+    auto const t = InputLatency::Timestamp {};
+    latency.keyPressed(t);
+    latency.inputWritten(t);
+    latency.outputParsed(t);
+    latency.frameBuilt(1);
+    latency.frameSwapped(1, t);
+    latency.framePresented(t);
+    CHECK(latency.sampleCount() == 0);
+    CHECK(!latency.percentile(LatencyStage::Total, 50));
+}
+
+TEST_CASE("InputLatency.stages", "[latency]")
+{
+    auto latency = InputLatency {};
+    latency.setEnabled(true);
+    auto const t = InputLatency::Timestamp {} + 1s;
+
+    // Two keys echoed by the same frame.
+    latency.keyPressed(t);
+    latency.inputWritten(t + 1ms);
+    latency.keyPressed(t + 2ms);
+    latency.inputWritten(t + 3ms);
+    latency.outputParsed(t + 5ms);
+
+    // Frames are matched by ID, swapping an older frame does not present the echo.
+    latency.frameBuilt(7);
+    latency.frameSwapped(6, t + 6ms);
+    latency.framePresented(t + 7ms);
+    CHECK(latency.sampleCount() == 0);
+
+    latency.frameSwapped(7, t + 8ms);
+    latency.framePresented(t + 10ms);
+    REQUIRE(latency.sampleCount() == 2);
+
+    CHECK(latency.percentile(LatencyStage::PtyWrite, 50) == 1ms);
+    CHECK(latency.percentile(LatencyStage::PtyWrite, 100) == 1ms);
+    CHECK(latency.percentile(LatencyStage::Echo, 50) == 2ms);
+    CHECK(latency.percentile(LatencyStage::Echo, 99) == 4ms);
+    CHECK(latency.percentile(LatencyStage::Render, 50) == 3ms);
+    CHECK(latency.percentile(LatencyStage::Present, 50) == 2ms);
+    CHECK(latency.percentile(LatencyStage::Total, 50) == 8ms);
+    CHECK(latency.percentile(LatencyStage::Total, 99) == 10ms);
+
+    auto os = std::ostringstream {};
+    latency.inspect(os);
+    CHECK(os.str().find("2 key presses measured") != std::string::npos);
+}
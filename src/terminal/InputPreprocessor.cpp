@@ -0,0 +1,109 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/InputPreprocessor.h>
+#include <terminal/ParserScanner.h>
+
+#include <crispy/WorkerPool.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+using namespace std;
+
+namespace terminal
+{
+
+namespace
+{
+    /// @returns the length of the segment to be cut off the front of @p _input.
+    size_t segmentLength(string_view _input, size_t _segmentSize) noexcept
+    {
+        if (_input.size() <= _segmentSize)
+            return _input.size();
+
+        auto const lineEnd = _input.rfind('\n', _segmentSize - 1);
+        if (lineEnd != string_view::npos)
+            return lineEnd + 1;
+
+        // No line break within reach, so the segment is cut in front of the UTF-8 sequence in between.
+        using parser::detail::isContinuationByte;
+        auto length = _segmentSize;
+        while (length > _segmentSize - 3 && isContinuationByte(static_cast<uint8_t>(_input[length])))
+            --length;
+        return length;
+    }
+} // namespace
+
+InputSegment preprocessInputSegment(string_view _bytes)
+{
+    auto segment = InputSegment {};
+    segment.bytes = _bytes;
+    segment.codepoints.resize(_bytes.size());
+    auto codepointCount = size_t { 0 };
+
+    for (size_t i = 0; i < _bytes.size();)
+    {
+        auto const ch = static_cast<uint8_t>(_bytes[i]);
+        if (ch < 0x80)
+        {
+            // These may leave the ground state (or abort a UTF-8 sequence, if CAN or SUB).
+            if (ch == 0x1B || ch == 0x18 || ch == 0x1A)
+                return InputSegment { _bytes, false, {}, {} };
+            if (segment.runs.empty() || segment.runs.back().decoded)
+                segment.runs.emplace_back(InputSegment::Run { false, i, 0 });
+            ++segment.runs.back().length;
+            ++i;
+            continue;
+        }
+
+        auto const [byteCount, decodedCount] = parser::decodeUtf8Text(
+            _bytes.data() + i, _bytes.data() + _bytes.size(), segment.codepoints.data() + codepointCount);
+        if (!byteCount)
+            return InputSegment { _bytes, false, {}, {} };
+        segment.runs.emplace_back(InputSegment::Run { true, codepointCount, decodedCount });
+        codepointCount += decodedCount;
+        i += byteCount;
+    }
+
+    segment.codepoints.resize(codepointCount);
+    segment.plain = true;
+    return segment;
+}
+
+vector<InputSegment> preprocessInput(string_view _input, size_t _segmentSize, size_t _maxThreads)
+{
+    auto boundaries = vector<string_view> {};
+    for (auto pending = _input; !pending.empty();)
+    {
+        auto const length = segmentLength(pending, max(_segmentSize, size_t { 4 }));
+        boundaries.emplace_back(pending.substr(0, length));
+        pending.remove_prefix(length);
+    }
+
+    auto segments = vector<InputSegment>(boundaries.size());
+    auto const threadCount =
+        min({ static_cast<size_t>(max(thread::hardware_concurrency(), 1u)), _maxThreads, segments.size() });
+    auto const processRange = [&](size_t _thread) {
+        auto const end = segments.size() * (_thread + 1) / threadCount;
+        for (auto i = segments.size() * _thread / threadCount; i < end; ++i)
+            segments[i] = preprocessInputSegment(boundaries[i]);
+    };
+
+    crispy::WorkerPool::shared().parallelFor(threadCount, processRange);
+
+    return segments;
+}
+
+} // namespace terminal
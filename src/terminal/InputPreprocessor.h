@@ -0,0 +1,61 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace terminal
+{
+
+/// A piece of PTY output, pre-processed independently of the terminal's state.
+///
+/// Plain segments contain nothing but text and C0 controls other than ESC, CAN and SUB,
+/// and are valid UTF-8. Starting in the parser's ground state, they are applied without any
+/// state transition, and their non-ASCII text can be written to the screen as decoded here.
+struct InputSegment
+{
+    /// A run of either bytes (US-ASCII text and C0 controls) or decoded text, starting with
+    /// a non-ASCII codepoint.
+    struct Run
+    {
+        bool decoded = false;
+        size_t offset = 0; // into bytes, or into codepoints if decoded
+        size_t length = 0;
+    };
+
+    std::string_view bytes;
+    bool plain = false;
+    std::vector<Run> runs;      // empty unless plain
+    std::u32string codepoints;  // storage of the decoded runs
+};
+
+/// Pre-processes a single segment of PTY output.
+///
+/// UTF-8 is decoded strictly (see parser::decodeUtf8Text()), rejecting overlong forms,
+/// surrogates, and truncated sequences, so that whatever is decoded here is decoded the same
+/// way by the parser.
+[[nodiscard]] InputSegment preprocessInputSegment(std::string_view _bytes);
+
+/// Splits @p _input into segments of about @p _segmentSize bytes and pre-processes them,
+/// spread across up to @p _maxThreads threads of the shared worker pool (see crispy::WorkerPool).
+///
+/// Segments end right after a line feed where possible, and at a UTF-8 sequence boundary otherwise.
+[[nodiscard]] std::vector<InputSegment> preprocessInput(std::string_view _input,
+                                                        size_t _segmentSize,
+                                                        size_t _maxThreads);
+
+} // namespace terminal
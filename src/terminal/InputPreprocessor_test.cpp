@@ -0,0 +1,119 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/InputPreprocessor.h>
+#include <terminal/MockTerm.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace terminal;
+using namespace std::string_view_literals;
+using std::string;
+using std::string_view;
+using std::u32string;
+using std::vector;
+
+namespace
+{
+
+/// Joins the runs of a plain segment back into text, tagging decoded runs with brackets.
+u32string joinRuns(InputSegment const& _segment)
+{
+    auto text = u32string {};
+    for (InputSegment::Run const& run: _segment.runs)
+    {
+        if (!run.decoded)
+            for (char const ch: _segment.bytes.substr(run.offset, run.length))
+                text += static_cast<char32_t>(ch);
+        else
+            text += U'[' + _segment.codepoints.substr(run.offset, run.length) + U']';
+    }
+    return text;
+}
+
+} // namespace
+
+TEST_CASE("InputPreprocessor.plain", "[input]")
+{
+    auto const segment = preprocessInputSegment("a\tb\xC3\xB6\xE2\x82\xAC\r\n\xF0\x9F\x98\x80!");
+    CHECK(segment.plain);
+    CHECK(joinRuns(segment) == U"a\tb[ö€]\r\n[\U0001F600!]");
+}
+
+TEST_CASE("InputPreprocessor.not_plain", "[input]")
+{
+    CHECK(preprocessInputSegment("").plain);
+    CHECK(!preprocessInputSegment("a\033[mb").plain);
+    CHECK(!preprocessInputSegment("a\x18").plain);
+    CHECK(!preprocessInputSegment("a\x1A").plain);
+
+    // Invalid and incomplete UTF-8 is left to the parser.
+    CHECK(!preprocessInputSegment("\x80").plain);
+    CHECK(!preprocessInputSegment("\xC0\x80").plain);         // overlong
+    CHECK(!preprocessInputSegment("\xED\xA0\x80").plain);     // surrogate
+    CHECK(!preprocessInputSegment("\xF4\x90\x80\x80").plain); // beyond U+10FFFF
+    CHECK(!preprocessInputSegment("\xE2\x82").plain);
+    CHECK(!preprocessInputSegment("\xE2\x82\r").plain);
+}
+
+TEST_CASE("InputPreprocessor.segments", "[input]")
+{
+    auto const input = "line 1\nline 2\nline three\n\xE2\x82\xAC\xE2\x82\xAC\xE2\x82\xAC"sv;
+    auto const segments = preprocessInput(input, 16, 4);
+
+    auto bytes = vector<string_view> {};
+    for (auto const& segment: segments)
+    {
+        CHECK(segment.plain);
+        bytes.push_back(segment.bytes);
+    }
+
+    // Cut after line feeds where possible, and in between UTF-8 sequences otherwise.
+    CHECK(bytes
+          == vector<string_view> { "line 1\nline 2\n", "line three\n", input.substr(25) });
+    CHECK(preprocessInput(string(20, 'x') + "\xE2\x82\xAC", 21, 1).front().bytes == string(20, 'x'));
+}
+
+TEST_CASE("InputPreprocessor.terminal", "[input]")
+{
+    // Large enough for the terminal to pre-process it in parallel.
+    auto input = string {};
+    for (int i = 0; input.size() < 256 * 1024; ++i)
+    {
+        input += "plain text \xC3\xA4\xC3\xB6\xC3\xBC \xE2\x82\xAC ";
+        input += std::to_string(i);
+        if (i % 7 == 0)
+            input += "\033[1mbold\033[m";
+        if (i % 11 == 0)
+            input += "\t\xF0\x9F\x98\x80";
+        input += "\r\n";
+    }
+
+    auto const pageSize = PageSize { LineCount(10), ColumnCount(40) };
+    auto serial = MockTerm { pageSize, LineCount(0), 1024 * 1024 };
+    auto parallel = MockTerm { pageSize, LineCount(0), 1024 * 1024 };
+    parallel.terminal.setParallelParsing(true);
+
+    serial.writeToScreen(input);
+    parallel.writeToScreen(input);
+
+    for (auto line = LineOffset(0); line < boxed_cast<LineOffset>(pageSize.lines); ++line)
+        CHECK(parallel.terminal.primaryScreen().grid().lineText(line)
+              == serial.terminal.primaryScreen().grid().lineText(line));
+    CHECK(parallel.state().cursor.position == serial.state().cursor.position);
+    CHECK(parallel.state().instructionCounter == serial.state().instructionCounter);
+}
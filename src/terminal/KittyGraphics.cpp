@@ -0,0 +1,321 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/KittyGraphics.h>
+#include <terminal/PngDecoder.h>
+
+#include <crispy/base64.h>
+#include <crispy/stdfs.h>
+
+#include <fmt/format.h>
+
+#include <fstream>
+#include <limits>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::string_view;
+using std::variant;
+
+namespace terminal
+{
+
+namespace
+{
+    optional<size_t> parseNumber(string_view _value) noexcept
+    {
+        if (_value.empty())
+            return nullopt;
+        auto result = size_t { 0 };
+        for (auto const ch: _value)
+        {
+            if (ch < '0' || ch > '9')
+                return nullopt;
+            result = result * 10 + static_cast<size_t>(ch - '0');
+        }
+        return result;
+    }
+
+    variant<Image::Data, string> readFile(FileSystem::path const& _path,
+                                          size_t _offset,
+                                          size_t _size,
+                                          size_t _maxSize)
+    {
+        auto ec = FileSystemError {};
+        auto const status = FileSystem::status(_path, ec);
+        if (ec || !FileSystem::exists(status))
+            return string("ENOENT:could not read image data");
+        if (!FileSystem::is_regular_file(status))
+            return string("EBADF:not a regular file");
+
+        auto file = std::ifstream(_path.string(), std::ios::binary | std::ios::ate);
+        if (!file.good())
+            return string("ENOENT:could not read image data");
+
+        auto const fileSize = static_cast<size_t>(file.tellg());
+        if (_offset > fileSize)
+            return Image::Data {};
+
+        auto const size = _size ? std::min(_size, fileSize - _offset) : fileSize - _offset;
+        if (size > _maxSize)
+            return string("EFBIG:image data too large");
+
+        auto data = Image::Data(size);
+        file.seekg(static_cast<std::streamoff>(_offset));
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        data.resize(static_cast<size_t>(file.gcount()));
+        return data;
+    }
+
+    /// Temporary files are only deleted after reading when they are obviously meant
+    /// for the graphics protocol and live in a temporary directory.
+    bool isDeletableTemporaryFile(FileSystem::path const& _path)
+    {
+        if (_path.filename().string().find("tty-graphics-protocol") == string::npos)
+            return false;
+
+        auto ec = FileSystemError {};
+        auto const directory = FileSystem::weakly_canonical(_path, ec).parent_path().string();
+        if (ec)
+            return false;
+
+        auto const tempDirectory = FileSystem::temp_directory_path(ec).string();
+        return (!ec && directory == tempDirectory) || directory == "/tmp" || directory == "/dev/shm";
+    }
+
+    optional<Image::Data> readSharedMemory(string const& _name, size_t _offset, size_t _size, size_t _maxSize)
+    {
+#if defined(_WIN32)
+        (void) _name;
+        (void) _offset;
+        (void) _size;
+        (void) _maxSize;
+        return nullopt;
+#else
+        auto const fd = shm_open(_name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return nullopt;
+
+        auto data = optional<Image::Data> {};
+        struct stat st;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= _offset)
+        {
+            auto const mappedSize = static_cast<size_t>(st.st_size);
+            auto const length = _size ? std::min(_size, mappedSize - _offset) : mappedSize - _offset;
+            if (!length || length > _maxSize)
+                data = Image::Data {};
+            else if (void* mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+                     mapped != MAP_FAILED)
+            {
+                auto const* begin = static_cast<uint8_t const*>(mapped) + _offset;
+                data = Image::Data(begin, begin + length);
+                munmap(mapped, mappedSize);
+            }
+        }
+        close(fd);
+
+        // The terminal takes ownership of the shared memory object, as per specification.
+        shm_unlink(_name.c_str());
+        return data;
+#endif
+    }
+} // namespace
+
+optional<KittyGraphicsCommand> KittyGraphicsCommand::parse(string_view _data)
+{
+    auto command = KittyGraphicsCommand {};
+
+    auto const payloadStart = _data.find(';');
+    auto controlData = _data.substr(0, payloadStart);
+    if (payloadStart != string_view::npos)
+        command.payload = string(_data.substr(payloadStart + 1));
+
+    while (!controlData.empty())
+    {
+        auto const comma = controlData.find(',');
+        auto const keyValue = controlData.substr(0, comma);
+        controlData = comma == string_view::npos ? string_view {} : controlData.substr(comma + 1);
+
+        if (keyValue.size() < 3 || keyValue[1] != '=')
+            return nullopt;
+
+        auto const key = keyValue[0];
+        auto const value = keyValue.substr(2);
+        auto const number = parseNumber(value);
+
+        switch (key)
+        {
+            case 'a':
+                switch (value[0])
+                {
+                    case 't': command.action = Action::Transmit; break;
+                    case 'T': command.action = Action::TransmitAndDisplay; break;
+                    case 'q': command.action = Action::Query; break;
+                    case 'p': command.action = Action::Put; break;
+                    case 'd': command.action = Action::Delete; break;
+                    default: return nullopt;
+                }
+                break;
+            case 't':
+                switch (value[0])
+                {
+                    case 'd': command.medium = Medium::Direct; break;
+                    case 'f': command.medium = Medium::File; break;
+                    case 't': command.medium = Medium::TemporaryFile; break;
+                    case 's': command.medium = Medium::SharedMemory; break;
+                    default: return nullopt;
+                }
+                break;
+            case 'o': command.compressed = value == "z"; break;
+            case 'd': command.deleteTarget = value[0]; break;
+            default:
+                if (!number || *number > std::numeric_limits<unsigned>::max())
+                    return nullopt;
+                switch (key)
+                {
+                    case 'f': command.format = static_cast<unsigned>(*number); break;
+                    case 's': command.width = Width::cast_from(*number); break;
+                    case 'v': command.height = Height::cast_from(*number); break;
+                    case 'i': command.imageId = static_cast<unsigned>(*number); break;
+                    case 'm': command.more = *number != 0; break;
+                    case 'S': command.dataSize = *number; break;
+                    case 'O': command.dataOffset = *number; break;
+                    case 'q': command.quiet = static_cast<unsigned>(*number); break;
+                    case 'C': command.moveCursor = *number == 0; break;
+                    default: break; // Ignore keys we do not support (yet).
+                }
+                break;
+        }
+    }
+
+    return command;
+}
+
+size_t maxKittyImageDataSize(ImageSize _maxImageSize) noexcept
+{
+    // RGBA pixels, or a PNG file with a filter byte per row and its chunks around the pixels.
+    return _maxImageSize.area() * 4 + unbox<size_t>(_maxImageSize.height) + 64 * 1024;
+}
+
+size_t maxKittyPayloadSize(ImageSize _maxImageSize) noexcept
+{
+    return (maxKittyImageDataSize(_maxImageSize) + 2) / 3 * 4;
+}
+
+variant<KittyImage, string> loadKittyImage(KittyGraphicsCommand const& _command,
+                                           ImageSize _maxImageSize,
+                                           bool _allowFiles)
+{
+    using Medium = KittyGraphicsCommand::Medium;
+
+    if (_command.oversized)
+        return string("EFBIG:image data too large");
+
+    auto const png = _command.format == 100;
+    if (png && !isPngSupported())
+        return string("EINVAL:PNG images are not supported");
+    if (!png && _command.format != 24 && _command.format != 32)
+        return fmt::format("EINVAL:unsupported format {}", _command.format);
+    if (_command.compressed)
+        return string("EINVAL:compressed images are not supported");
+    if (!png && (!*_command.width || !*_command.height))
+        return string("EINVAL:image width and height are required");
+    if (_command.width > _maxImageSize.width || _command.height > _maxImageSize.height)
+        return string("EINVAL:image too large");
+
+    auto const maxDataSize = maxKittyImageDataSize(_maxImageSize);
+    auto data = optional<Image::Data> {};
+    switch (_command.medium)
+    {
+        case Medium::Direct:
+            if (_command.payload.size() > maxKittyPayloadSize(_maxImageSize))
+                return string("EFBIG:image data too large");
+            data = Image::Data(crispy::base64::decodeLength(_command.payload));
+            data->resize(crispy::base64::decode(_command.payload, data->data()));
+            break;
+        case Medium::File:
+        case Medium::TemporaryFile: {
+            if (!_allowFiles)
+                return string("EPERM:reading images from files is not permitted");
+            auto const path = FileSystem::path(crispy::base64::decode(_command.payload));
+            auto file = readFile(path, _command.dataOffset, _command.dataSize, maxDataSize);
+            if (auto const* error = std::get_if<string>(&file))
+                return *error;
+            data = std::move(std::get<Image::Data>(file));
+            if (_command.medium == Medium::TemporaryFile && isDeletableTemporaryFile(path))
+            {
+                auto ec = FileSystemError {};
+                FileSystem::remove(path, ec);
+            }
+            break;
+        }
+        case Medium::SharedMemory:
+            // Same as with files, as the client could otherwise make the terminal read (and unlink)
+            // any shared memory object that the user has access to.
+            if (!_allowFiles)
+                return string("EPERM:reading images from shared memory is not permitted");
+            data = readSharedMemory(crispy::base64::decode(_command.payload),
+                                    _command.dataOffset,
+                                    _command.dataSize,
+                                    maxDataSize);
+            break;
+    }
+
+    if (!data)
+        return string("ENOENT:could not read image data");
+
+    if (png)
+    {
+        auto const size =
+            pngImageSize(string_view(reinterpret_cast<char const*>(data->data()), data->size()));
+        if (!size)
+            return string("EBADPNG:not a PNG image");
+        if (size->width > _maxImageSize.width || size->height > _maxImageSize.height)
+            return string("EINVAL:image too large");
+        return KittyImage { *size, std::move(*data), true };
+    }
+
+    auto const size = ImageSize { _command.width, _command.height };
+    auto const bytesPerPixel = _command.format / 8;
+    auto const pixelCount = unbox<size_t>(size.width) * unbox<size_t>(size.height);
+    if (data->size() < pixelCount * bytesPerPixel)
+        return string("ENODATA:insufficient image data");
+
+    if (bytesPerPixel == 4)
+    {
+        data->resize(pixelCount * 4);
+        return KittyImage { size, std::move(*data) };
+    }
+
+    // Images are kept in RGBA format only.
+    auto rgba = Image::Data(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        rgba[i * 4 + 0] = (*data)[i * 3 + 0];
+        rgba[i * 4 + 1] = (*data)[i * 3 + 1];
+        rgba[i * 4 + 2] = (*data)[i * 3 + 2];
+        rgba[i * 4 + 3] = 0xFF;
+    }
+    return KittyImage { size, std::move(rgba) };
+}
+
+} // namespace terminal
@@ -0,0 +1,104 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Image.h>
+#include <terminal/primitives.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace terminal
+{
+
+/// A command of the kitty graphics protocol: APC G <control data> ; <payload> ST
+///
+/// Besides transmitting the pixels base64 encoded through the PTY, the client may also
+/// let the terminal read them from a (temporary) file or a POSIX shared memory object,
+/// passing only its name then.
+///
+/// @see https://sw.kovidgoyal.net/kitty/graphics-protocol/
+struct KittyGraphicsCommand
+{
+    enum class Action
+    {
+        Transmit,           // a=t
+        TransmitAndDisplay, // a=T
+        Query,              // a=q
+        Put,                // a=p
+        Delete,             // a=d
+    };
+
+    enum class Medium
+    {
+        Direct,        // t=d
+        File,          // t=f
+        TemporaryFile, // t=t
+        SharedMemory,  // t=s
+    };
+
+    Action action = Action::Transmit;
+    Medium medium = Medium::Direct;
+    unsigned format = 32;    // f: 24 (RGB), 32 (RGBA), or 100 (PNG)
+    bool compressed = false; // o=z
+    Width width {};          // s
+    Height height {};        // v
+    unsigned imageId = 0;    // i
+    bool more = false;       // m: more chunks of payload are following
+    size_t dataSize = 0;     // S: number of bytes to read from file or shared memory
+    size_t dataOffset = 0;   // O: offset to start reading at in file or shared memory
+    unsigned quiet = 0;      // q: 1 suppresses OK responses, 2 also error responses
+    bool moveCursor = true;  // C=1 leaves the cursor where it is after displaying
+    char deleteTarget = 'a'; // d
+    std::string payload;     // base64 encoded pixels, file name, or shared memory object name
+    bool oversized = false;  // the chunked payload exceeded maxKittyPayloadSize() and was dropped
+
+    /// Parses the control data and payload of a graphics command, excluding the leading 'G'.
+    static std::optional<KittyGraphicsCommand> parse(std::string_view _data);
+};
+
+/// An image as loaded from a transmit command.
+struct KittyImage
+{
+    ImageSize size;
+    Image::Data data; // RGBA pixels, or the PNG file if png is set
+    bool png = false;
+};
+
+/// @returns the maximum number of bytes an image of at most @p _maxImageSize is read from,
+///          which leaves room for the overhead of a PNG file that barely compresses.
+size_t maxKittyImageDataSize(ImageSize _maxImageSize) noexcept;
+
+/// @returns the maximum size of the (base64 encoded) payload of a possibly chunked command.
+size_t maxKittyPayloadSize(ImageSize _maxImageSize) noexcept;
+
+/// Loads the image that the given (complete) transmit command refers to.
+///
+/// Raw pixels are converted to RGBA right away, whereas PNG images are left to be decoded
+/// by the caller (see decodePng()), possibly off the terminal thread. Their size is taken
+/// from the PNG header.
+///
+/// Images are only read from (temporary) files or shared memory if @p _allowFiles is set,
+/// and only from regular files then, as the client could otherwise make the terminal read any file
+/// that the user has access to, or block on a FIFO or device.
+///
+/// @returns the image, or an error message in the protocol's format (such as "ENOENT:..."),
+///          to be sent back to the client.
+std::variant<KittyImage, std::string> loadKittyImage(KittyGraphicsCommand const& _command,
+                                                     ImageSize _maxImageSize,
+                                                     bool _allowFiles);
+
+} // namespace terminal
@@ -0,0 +1,176 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/KittyGraphics.h>
+#include <terminal/PngDecoder.h>
+
+#include <crispy/base64.h>
+#include <crispy/stdfs.h>
+
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <string>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace terminal;
+using Action = KittyGraphicsCommand::Action;
+using Medium = KittyGraphicsCommand::Medium;
+
+namespace
+{
+auto constexpr MaxImageSize = ImageSize { Width(100), Height(100) };
+}
+
+TEST_CASE("KittyGraphics.parse", "[kitty]")
+{
+    auto const command = KittyGraphicsCommand::parse("a=T,f=24,s=2,v=1,i=7,m=1,q=1;AAAA");
+    REQUIRE(command.has_value());
+    CHECK(command->action == Action::TransmitAndDisplay);
+    CHECK(command->medium == Medium::Direct);
+    CHECK(command->format == 24);
+    CHECK(command->width == Width(2));
+    CHECK(command->height == Height(1));
+    CHECK(command->imageId == 7);
+    CHECK(command->more);
+    CHECK(command->quiet == 1);
+    CHECK(command->payload == "AAAA");
+
+    CHECK(KittyGraphicsCommand::parse("a=t,t=s,S=16,O=4;bmFtZQ==")->medium == Medium::SharedMemory);
+    CHECK_FALSE(KittyGraphicsCommand::parse("a=x").has_value());
+    CHECK_FALSE(KittyGraphicsCommand::parse("s=abc").has_value());
+    CHECK_FALSE(KittyGraphicsCommand::parse("s").has_value());
+}
+
+TEST_CASE("KittyGraphics.load_direct", "[kitty]")
+{
+    // A 2x1 RGB image, converted to RGBA.
+    auto command = *KittyGraphicsCommand::parse("a=t,f=24,s=2,v=1");
+    command.payload = crispy::base64::encode(std::string("\x01\x02\x03\x04\x05\x06", 6));
+
+    auto const result = loadKittyImage(command, MaxImageSize, true);
+    REQUIRE(std::holds_alternative<KittyImage>(result));
+    CHECK(std::get<KittyImage>(result).size == ImageSize { Width(2), Height(1) });
+    CHECK(std::get<KittyImage>(result).data == Image::Data { 1, 2, 3, 0xFF, 4, 5, 6, 0xFF });
+
+    command.width = Width(3);
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, true)).rfind("ENODATA:", 0) == 0);
+
+    command.width = Width(200);
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, true)).rfind("EINVAL:", 0) == 0);
+
+    command.width = Width(2);
+    command.oversized = true;
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, true)).rfind("EFBIG:", 0) == 0);
+}
+
+TEST_CASE("KittyGraphics.load_file", "[kitty]")
+{
+    auto const path = FileSystem::temp_directory_path() / "contour-kitty-graphics-test.rgba";
+    {
+        auto file = std::ofstream(path.string(), std::ios::binary);
+        file << std::string("skip") << std::string("\x10\x20\x30\x40", 4);
+    }
+
+    auto command = *KittyGraphicsCommand::parse("a=t,t=f,f=32,s=1,v=1,O=4");
+    command.payload = crispy::base64::encode(path.string());
+
+    auto const result = loadKittyImage(command, MaxImageSize, true);
+    REQUIRE(std::holds_alternative<KittyImage>(result));
+    CHECK(std::get<KittyImage>(result).data == Image::Data { 0x10, 0x20, 0x30, 0x40 });
+
+    // Regular files are never deleted, even if passed as temporary file.
+    command.medium = Medium::TemporaryFile;
+    (void) loadKittyImage(command, MaxImageSize, true);
+    CHECK(FileSystem::exists(path));
+
+    // Files are only read when permitted.
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, false)).rfind("EPERM:", 0) == 0);
+
+    // Files are read no further than the largest image could take.
+    command.medium = Medium::File;
+    command.dataOffset = 0;
+    command.dataSize = maxKittyImageDataSize(MaxImageSize) + 1;
+    FileSystem::resize_file(path, command.dataSize);
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, true)).rfind("EFBIG:", 0) == 0);
+    FileSystem::remove(path);
+
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, true)).rfind("ENOENT:", 0) == 0);
+
+    // Only regular files are read, rather than e.g. directories, FIFOs or devices.
+    command.payload = crispy::base64::encode(FileSystem::temp_directory_path().string());
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, true)).rfind("EBADF:", 0) == 0);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("KittyGraphics.load_shared_memory", "[kitty]")
+{
+    auto const name = std::string("/contour-kitty-graphics-test");
+    auto const fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, "\x10\x20\x30\x40", 4) == 4);
+    close(fd);
+
+    auto command = *KittyGraphicsCommand::parse("a=t,t=s,f=32,s=1,v=1");
+    command.payload = crispy::base64::encode(name);
+
+    // Shared memory is neither read nor unlinked unless permitted.
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, false)).rfind("EPERM:", 0) == 0);
+
+    auto const result = loadKittyImage(command, MaxImageSize, true);
+    REQUIRE(std::holds_alternative<KittyImage>(result));
+    CHECK(std::get<KittyImage>(result).data == Image::Data { 0x10, 0x20, 0x30, 0x40 });
+    CHECK(shm_open(name.c_str(), O_RDONLY, 0) < 0);
+}
+#endif
+
+TEST_CASE("KittyGraphics.load_png", "[kitty]")
+{
+    // A 2x1 RGBA image.
+    auto constexpr Png = "iVBORw0KGgoAAAANSUhEUgAAAAIAAAABCAYAAAD0In+KAAAAEUlEQVR4nGNgZGJmYWVj5wAAAIEA"
+                         "JZh10J8AAAAASUVORK5CYII=";
+    auto const png = crispy::base64::decode(Png);
+    CHECK(pngImageSize(png) == ImageSize { Width(2), Height(1) });
+    CHECK_FALSE(pngImageSize(png.substr(0, 16)).has_value());
+    CHECK_FALSE(pngImageSize("\x01\x02\x03\x04\x05\x06\x07\x08").has_value());
+
+    auto command = *KittyGraphicsCommand::parse("a=T,f=100");
+    command.payload = Png;
+    auto const result = loadKittyImage(command, MaxImageSize, true);
+    if (!isPngSupported())
+    {
+        CHECK(std::get<std::string>(result).rfind("EINVAL:", 0) == 0);
+        CHECK_FALSE(decodePng(png, ImageSize { Width(2), Height(1) }).has_value());
+        return;
+    }
+
+    // PNG images are left encoded, sized by their header.
+    REQUIRE(std::holds_alternative<KittyImage>(result));
+    auto const& image = std::get<KittyImage>(result);
+    CHECK(image.png);
+    CHECK(image.size == ImageSize { Width(2), Height(1) });
+    CHECK(image.data.size() == png.size());
+
+    CHECK(decodePng(png, image.size) == Image::Data { 1, 2, 3, 4, 5, 6, 7, 8 });
+    CHECK_FALSE(decodePng(png, ImageSize { Width(1), Height(1) }).has_value());
+    CHECK_FALSE(decodePng(png.substr(0, png.size() - 20), image.size).has_value());
+
+    command.payload = crispy::base64::encode("not a PNG image");
+    CHECK(std::get<std::string>(loadKittyImage(command, MaxImageSize, true)).rfind("EBADPNG:", 0) == 0);
+}
@@ -29,8 +29,15 @@ template <typename Cell>
 typename Line<Cell>::InflatedBuffer Line<Cell>::reflow(ColumnCount _newColumnCount)
 {
     using crispy::Comparison;
+
+    if (isTrivialBuffer() && trivialBuffer().usedColumns <= _newColumnCount)
+    {
+        // Nothing to be wrapped, so the line can stay trivial.
+        trivialBuffer().displayWidth = _newColumnCount;
+        return {};
+    }
+
     auto& buffer = inflatedBuffer();
-    // TODO: Efficiently handle TrivialBuffer-case.
     switch (crispy::strongCompare(_newColumnCount, size()))
     {
         case Comparison::Equal: break;
@@ -100,13 +107,7 @@ inline void Line<Cell>::resize(ColumnCount _count)
 template <typename Cell>
 gsl::span<Cell const> Line<Cell>::trim_blank_right() const noexcept
 {
-    auto i = inflatedBuffer().data();
-    auto e = inflatedBuffer().data() + inflatedBuffer().size();
-
-    while (i != e && (e - 1)->empty())
-        --e;
-
-    return gsl::make_span(i, e);
+    return gsl::span<Cell const>(inflatedBuffer().data(), unbox<size_t>(usedColumns()));
 }
 
 template <typename Cell>
@@ -142,11 +143,12 @@ std::string Line<Cell>::toUtf8Trimmed() const
 }
 
 template <typename Cell>
-InflatedLineBuffer<Cell> inflate(TriviallyStyledLineBuffer const& input)
+InflatedLineBuffer<Cell> inflate(TriviallyStyledLineBuffer const& input,
+                                 crispy::SlabAllocator<Cell> allocator)
 {
     static constexpr char32_t ReplacementCharacter { 0xFFFD };
 
-    auto columns = InflatedLineBuffer<Cell> {};
+    auto columns = InflatedLineBuffer<Cell>(allocator);
     columns.reserve(unbox<size_t>(input.displayWidth));
     // fmt::print("Inflating {}/{}\n", input.text.size(), input.displayWidth);
 
@@ -195,6 +197,62 @@ InflatedLineBuffer<Cell> inflate(TriviallyStyledLineBuffer const& input)
     return columns;
 }
 
+template <typename Cell>
+size_t Line<Cell>::deflate(crispy::BufferObject& _textBuffer)
+{
+    if (!isInflatedBuffer())
+        return 0;
+
+    auto const& cells = *std::get<SharedBuffer>(storage_);
+    if (cells.empty())
+        return 0;
+
+    auto const attributesOf = [](Cell const& cell) noexcept {
+        return GraphicsAttributes {
+            cell.foregroundColor(), cell.backgroundColor(), cell.underlineColor(), cell.styles()
+        };
+    };
+
+    auto const attributes = attributesOf(cells.front());
+    auto const hyperlink = cells.front().hyperlink();
+
+    auto usedColumns = size_t { 0 };
+    while (usedColumns < cells.size() && cells[usedColumns].codepointCount() != 0)
+        ++usedColumns;
+
+    if (_textBuffer.bytesAvailable() < usedColumns)
+        return 0;
+
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        Cell const& cell = cells[i];
+        if (cell.width() != 1 || cell.imageFragment() || attributesOf(cell) != attributes)
+            return 0;
+
+        if (i < usedColumns)
+        {
+            auto const codepoint = cell.codepoint(0);
+            if (cell.codepointCount() != 1 || codepoint < 0x20 || codepoint >= 0x7F
+                || cell.hyperlink() != hyperlink)
+                return 0;
+        }
+        else if (cell.codepointCount() != 0 || !!cell.hyperlink())
+            return 0;
+    }
+
+    char* const text = _textBuffer.hotEnd();
+    for (size_t i = 0; i < usedColumns; ++i)
+        text[i] = static_cast<char>(cells[i].codepoint(0));
+    _textBuffer.advance(usedColumns);
+
+    auto const bytesSaved = cells.capacity() * sizeof(Cell) - usedColumns;
+    reset(attributes,
+          usedColumns ? hyperlink : HyperlinkId {},
+          crispy::BufferFragment { _textBuffer.shared_from_this(), std::string_view(text, usedColumns) },
+          ColumnCount::cast_from(usedColumns));
+    return bytesSaved;
+}
+
 template <typename Cell>
 void Line<Cell>::fillRemainingCells(GraphicsAttributes const& _sgr, HyperlinkId hyperlink)
 {
@@ -19,12 +19,16 @@
 
 #include <crispy/BufferObject.h>
 #include <crispy/Comparison.h>
+#include <crispy/SlabAllocator.h>
 #include <crispy/assert.h>
 
 #include <gsl/span>
 #include <gsl/span_ext>
 
+#include <algorithm>
+#include <atomic>
 #include <iterator>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -69,20 +73,42 @@ struct TriviallyStyledLineBuffer
     }
 };
 
+/// Cells of a line, allocated from the owning Grid's slab pool (or the heap, if not bound to any).
 template <typename Cell>
-using InflatedLineBuffer = std::vector<Cell>;
+using InflatedLineBuffer = std::vector<Cell, crispy::SlabAllocator<Cell>>;
 
 /// Unpacks a TriviallyStyledLineBuffer into an InflatedLineBuffer<Cell>.
 template <typename Cell>
-InflatedLineBuffer<Cell> inflate(TriviallyStyledLineBuffer const& input);
+InflatedLineBuffer<Cell> inflate(TriviallyStyledLineBuffer const& input,
+                                 crispy::SlabAllocator<Cell> allocator = {});
 
+/// Inflated cells are shared between copies of a line and only cloned on mutable access
+/// (copy-on-write), so that copying a line, or a whole grid, does not copy any cells.
 template <typename Cell>
-using LineStorage = std::variant<TriviallyStyledLineBuffer, InflatedLineBuffer<Cell>>;
+using SharedInflatedLineBuffer = std::shared_ptr<InflatedLineBuffer<Cell>>;
+
+template <typename Cell>
+using LineStorage = std::variant<TriviallyStyledLineBuffer, SharedInflatedLineBuffer<Cell>>;
+
+namespace detail
+{
+    /// Returns a new, process-wide unique line generation stamp (never 0).
+    inline uint64_t nextLineGeneration() noexcept
+    {
+        static std::atomic<uint64_t> counter { 0 };
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+} // namespace detail
 
 /**
  * Line<Cell> API.
  *
- * TODO: Use custom allocator for ensuring cache locality of Cells to sibling lines.
+ * A line remembers the allocator it was created with, so that its cells are allocated
+ * from the owning Grid's slab pool whenever the line gets inflated.
+ *
+ * Copies of a line share their inflated cells until either copy is accessed mutably,
+ * so that taking a snapshot of a grid only costs one reference count increment per line.
+ *
  * TODO: Make the line optimization work.
  */
 template <typename Cell>
@@ -95,27 +121,35 @@ class Line
     Line& operator=(Line const&) = default;
     Line& operator=(Line&&) noexcept = default;
 
+    using Allocator = crispy::SlabAllocator<Cell>;
     using TrivialBuffer = TriviallyStyledLineBuffer;
     using InflatedBuffer = InflatedLineBuffer<Cell>;
+    using SharedBuffer = SharedInflatedLineBuffer<Cell>;
     using Storage = LineStorage<Cell>;
     using value_type = Cell;
     using iterator = typename InflatedBuffer::iterator;
     using reverse_iterator = typename InflatedBuffer::reverse_iterator;
     using const_iterator = typename InflatedBuffer::const_iterator;
 
-    Line(LineFlags _flags, ColumnCount _width, GraphicsAttributes _templateSGR):
-        storage_ { TrivialBuffer { _width, _templateSGR } }, flags_ { static_cast<unsigned>(_flags) }
+    Line(LineFlags _flags, ColumnCount _width, GraphicsAttributes _templateSGR, Allocator _allocator = {}):
+        allocator_ { _allocator },
+        storage_ { TrivialBuffer { _width, _templateSGR } },
+        flags_ { static_cast<unsigned>(_flags) }
     {
     }
 
     Line(LineFlags _flags, InflatedBuffer _buffer):
-        storage_ { std::move(_buffer) }, flags_ { static_cast<unsigned>(_flags) }
+        allocator_ { _buffer.get_allocator() },
+        storage_ { std::make_shared<InflatedBuffer>(std::move(_buffer)) },
+        flags_ { static_cast<unsigned>(_flags) }
     {
     }
 
     void reset(LineFlags _flags, GraphicsAttributes _attributes) noexcept
     {
         flags_ = static_cast<unsigned>(_flags);
+        if (isErased(ColumnOffset(0), size(), _attributes))
+            return;
         if (isTrivialBuffer())
             trivialBuffer().reset(_attributes);
         else
@@ -133,12 +167,124 @@ class Line
         else
         {
             flags_ = static_cast<unsigned>(_flags);
-            for (Cell& cell: inflatedBuffer())
+            auto templateCell = Cell {};
+            templateCell.write(_attributes, _codepoint, _width);
+            auto& buffer = inflatedBuffer();
+            std::fill(buffer.begin(), buffer.end(), templateCell);
+        }
+    }
+
+    /// Resets @p _count cells starting at @p _start to empty cells with the given attributes.
+    ///
+    /// The cheapest way is picked automatically: erasing the whole line, or the tail of a
+    /// trivial line with the same attributes, keeps (or turns) the line trivial in O(1).
+    /// Only otherwise the line is inflated and its cells are overwritten with a template cell.
+    void erase(ColumnOffset _start, ColumnCount _count, GraphicsAttributes const& _attributes)
+    {
+        if (isErased(_start, _count, _attributes))
+            return;
+
+        auto const width = unbox<size_t>(size());
+        auto const start = std::min(unbox<size_t>(_start), width);
+        auto const end = std::min(start + unbox<size_t>(_count), width);
+
+        if (start == 0 && end == width)
+        {
+            reset(flags(), _attributes);
+            return;
+        }
+
+        if (isTrivialBuffer() && end == width)
+        {
+            auto& buffer = trivialBuffer();
+            // Only if one byte of text maps to one column, it can be cut off at a column.
+            if (buffer.attributes == _attributes && buffer.text.size() == unbox<size_t>(buffer.usedColumns))
             {
-                cell.reset();
-                cell.write(_attributes, _codepoint, _width);
+                if (start < buffer.text.size())
+                {
+                    auto const text = buffer.text.view().substr(0, start);
+                    buffer.text = crispy::BufferFragment(buffer.text.owner(), text);
+                    buffer.usedColumns = ColumnCount::cast_from(start);
+                }
+                return;
             }
         }
+
+        auto const templateCell = Cell { _attributes };
+        auto& buffer = inflatedBuffer();
+        std::fill(buffer.begin() + long(start), buffer.begin() + long(end), templateCell);
+    }
+
+    /// Tests whether the @p _count cells starting at @p _start are blank cells with the given
+    /// attributes already, as erase() would leave them.
+    ///
+    /// Erasing and writing leave the generation stamp alone if nothing changes, so that screens
+    /// repainted with the same contents (as full-screen applications frequently do) are not
+    /// rendered again.
+    [[nodiscard]] bool isErased(ColumnOffset _start,
+                                ColumnCount _count,
+                                GraphicsAttributes const& _attributes) const noexcept
+    {
+        auto const width = unbox<size_t>(size());
+        auto const start = std::min(unbox<size_t>(_start), width);
+        auto const end = std::min(start + unbox<size_t>(_count), width);
+
+        if (auto const* buffer = std::get_if<TrivialBuffer>(&storage_))
+            return buffer->attributes == _attributes
+                   && (start == end
+                       || start >= std::max(buffer->text.size(), unbox<size_t>(buffer->usedColumns)));
+
+        auto const cells = gsl::span<Cell const>(inflatedBuffer()).subspan(start, end - start);
+        return std::all_of(cells.begin(), cells.end(), [&](Cell const& _cell) {
+            return _cell.holds(_attributes, 0, 1, HyperlinkId {});
+        });
+    }
+
+    /// Tests whether writing the US-ASCII text @p _text at @p _start would leave the cells unchanged.
+    [[nodiscard]] bool holdsText(ColumnOffset _start,
+                                 std::string_view _text,
+                                 GraphicsAttributes const& _attributes,
+                                 HyperlinkId _hyperlink) const noexcept
+    {
+        auto const start = unbox<size_t>(_start);
+        if (auto const* buffer = std::get_if<TrivialBuffer>(&storage_))
+        {
+            // Only if one byte of text maps to one column, columns can be compared bytewise.
+            auto const text = buffer->text.view();
+            return buffer->attributes == _attributes && buffer->hyperlink == _hyperlink
+                   && text.size() == unbox<size_t>(buffer->usedColumns) && start + _text.size() <= text.size()
+                   && text.substr(start, _text.size()) == _text;
+        }
+
+        auto const& cells = inflatedBuffer();
+        if (start + _text.size() > cells.size())
+            return false;
+        for (size_t i = 0; i < _text.size(); ++i)
+            if (!cells[start + i].holds(_attributes, static_cast<char32_t>(_text[i]), 1, _hyperlink))
+                return false;
+        return true;
+    }
+
+    /// Tests whether writing the given character at @p _column would leave the cell unchanged.
+    [[nodiscard]] bool holdsCharacter(ColumnOffset _column,
+                                      GraphicsAttributes const& _attributes,
+                                      char32_t _ch,
+                                      uint8_t _width,
+                                      HyperlinkId _hyperlink) const noexcept
+    {
+        if (_column < ColumnOffset(0) || _column >= ColumnOffset::cast_from(size()))
+            return false;
+
+        if (isTrivialBuffer())
+        {
+            if (_ch == 0)
+                return _width == 1 && !_hyperlink && isErased(_column, ColumnCount(1), _attributes);
+            auto const ch = static_cast<char>(_ch);
+            return _ch < 0x80 && _width == 1
+                   && holdsText(_column, std::string_view(&ch, 1), _attributes, _hyperlink);
+        }
+
+        return inflatedBuffer()[unbox<size_t>(_column)].holds(_attributes, _ch, _width, _hyperlink);
     }
 
     /// Tests if all cells are empty.
@@ -147,12 +293,15 @@ class Line
         if (isTrivialBuffer())
             return trivialBuffer().text.empty();
 
-        for (auto const& cell: inflatedBuffer())
-            if (!cell.empty())
-                return false;
-        return true;
+        return usedColumns() == ColumnCount(0);
     }
 
+    /// Returns the number of columns up to and including the last non-empty cell.
+    ///
+    /// The result is cached along with the line's generation stamp, so that repeatedly
+    /// trimming an unmodified line (reflow, copy, render setup) does not rescan its cells.
+    [[nodiscard]] ColumnCount usedColumns() const noexcept;
+
     /**
      * Fills this line with the given content.
      *
@@ -288,7 +437,11 @@ class Line
     InflatedBuffer& inflatedBuffer();
     InflatedBuffer const& inflatedBuffer() const;
 
-    [[nodiscard]] TrivialBuffer& trivialBuffer() noexcept { return std::get<TrivialBuffer>(storage_); }
+    [[nodiscard]] TrivialBuffer& trivialBuffer() noexcept
+    {
+        touch();
+        return std::get<TrivialBuffer>(storage_);
+    }
     [[nodiscard]] TrivialBuffer const& trivialBuffer() const noexcept
     {
         return std::get<TrivialBuffer>(storage_);
@@ -303,20 +456,59 @@ class Line
         return !std::holds_alternative<TrivialBuffer>(storage_);
     }
 
-    void setBuffer(TrivialBuffer const& buffer) noexcept { storage_ = buffer; }
-    void setBuffer(InflatedBuffer buffer) { storage_ = std::move(buffer); }
+    void setBuffer(TrivialBuffer const& buffer) noexcept
+    {
+        touch();
+        storage_ = buffer;
+    }
+    void setBuffer(InflatedBuffer buffer)
+    {
+        touch();
+        storage_ = std::make_shared<InflatedBuffer>(std::move(buffer));
+    }
+
+    /// Tests whether this line's cells are shared with a copy of this line,
+    /// i.e. they will be cloned upon the next mutable access.
+    [[nodiscard]] bool isSharedBuffer() const noexcept
+    {
+        auto const* buffer = std::get_if<SharedBuffer>(&storage_);
+        return buffer && buffer->use_count() > 1;
+    }
 
     void reset(GraphicsAttributes attributes,
                HyperlinkId hyperlink,
                crispy::BufferFragment text,
                ColumnCount columnsUsed)
     {
+        touch();
         storage_ = TrivialBuffer { size(), attributes, hyperlink, columnsUsed, std::move(text) };
     }
 
+    /// Converts an inflated line back into a trivially styled line, storing its text into
+    /// @p _textBuffer.
+    ///
+    /// This is only possible if all cells share the same graphics attributes and contain
+    /// single-width US-ASCII text only, where the text cells also share the same hyperlink.
+    ///
+    /// @returns the number of bytes saved, or 0 if the line could not be deflated.
+    size_t deflate(crispy::BufferObject& _textBuffer);
+
+    /// Stamp that changes whenever this line's contents may have been modified.
+    ///
+    /// Every mutable access to the line's cells assigns a new stamp, so renderers can
+    /// skip lines whose stamp did not change since they were last rendered.
+    /// The stamp travels with the contents when the line is copied or moved.
+    [[nodiscard]] uint64_t generation() const noexcept { return generation_; }
+
   private:
+    void touch() noexcept { generation_ = detail::nextLineGeneration(); }
+
+    Allocator allocator_;
     Storage storage_;
     unsigned flags_ = 0;
+    uint64_t generation_ = detail::nextLineGeneration();
+    mutable uint64_t usedColumnsGeneration_ = 0; // generation_ that usedColumns_ was computed for
+    mutable size_t usedColumns_ = 0;
 };
 
 constexpr LineFlags operator|(LineFlags a, LineFlags b) noexcept
@@ -337,15 +529,53 @@ constexpr LineFlags operator&(LineFlags a, LineFlags b) noexcept
 template <typename Cell>
 inline typename Line<Cell>::InflatedBuffer& Line<Cell>::inflatedBuffer()
 {
+    touch();
     if (std::holds_alternative<TrivialBuffer>(storage_))
-        storage_ = inflate<Cell>(std::get<TrivialBuffer>(storage_));
-    return std::get<InflatedBuffer>(storage_);
+        storage_ =
+            std::make_shared<InflatedBuffer>(inflate<Cell>(std::get<TrivialBuffer>(storage_), allocator_));
+
+    auto& buffer = std::get<SharedBuffer>(storage_);
+    if (buffer.use_count() > 1)
+        buffer = std::make_shared<InflatedBuffer>(*buffer); // Copy on write.
+    return *buffer;
 }
 
 template <typename Cell>
 inline typename Line<Cell>::InflatedBuffer const& Line<Cell>::inflatedBuffer() const
 {
-    return const_cast<Line<Cell>*>(this)->inflatedBuffer();
+    // Unpacking does not change the line's contents, so the generation stamp is kept.
+    if (std::holds_alternative<TrivialBuffer>(storage_))
+        const_cast<Storage&>(storage_) =
+            std::make_shared<InflatedBuffer>(inflate<Cell>(std::get<TrivialBuffer>(storage_), allocator_));
+    return *std::get<SharedBuffer>(storage_);
+}
+
+template <typename Cell>
+ColumnCount Line<Cell>::usedColumns() const noexcept
+{
+    if (usedColumnsGeneration_ == generation_)
+        return ColumnCount::cast_from(usedColumns_);
+
+    auto n = size_t { 0 };
+    if (isTrivialBuffer() && trivialBuffer().text.size() == unbox<size_t>(trivialBuffer().usedColumns))
+    {
+        // US-ASCII only, so that each byte is a cell.
+        auto const text = trivialBuffer().text.view();
+        n = text.size();
+        while (n && text[n - 1] == ' ')
+            --n;
+    }
+    else
+    {
+        auto const& cells = inflatedBuffer();
+        n = cells.size();
+        while (n && cells[n - 1].empty())
+            --n;
+    }
+
+    usedColumns_ = n;
+    usedColumnsGeneration_ = generation_;
+    return ColumnCount::cast_from(n);
 }
 
 } // namespace terminal
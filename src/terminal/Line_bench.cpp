@@ -0,0 +1,41 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/Line.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+using namespace terminal;
+using namespace crispy;
+
+static void BM_Line_inflate(benchmark::State& state)
+{
+    auto const columns = ColumnCount::cast_from(state.range(0));
+    auto const text = std::string(unbox<size_t>(columns), 'A');
+    auto pool = BufferObjectPool(4096);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(text);
+
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    auto const fragment = bufferObject->ref(0, text.size());
+    auto const trivial = TriviallyStyledLineBuffer { columns, sgr, HyperlinkId {}, columns, fragment };
+
+    for (auto _: state)
+        benchmark::DoNotOptimize(inflate<Cell>(trivial));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Line_inflate)->Arg(80)->Arg(200)->Arg(1000);
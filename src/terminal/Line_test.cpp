@@ -66,3 +66,156 @@ TEST_CASE("Line.inflate", "[Line]")
         CHECK(char(cell.codepoint(0)) == testText[i]);
     }
 }
+
+TEST_CASE("Line.erase", "[Line]")
+{
+    auto constexpr testText = "0123456789"sv;
+    auto pool = BufferObjectPool(16);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(testText);
+
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+
+    auto line = Line<Cell>(LineFlags::None, ColumnCount(10), sgr);
+    line.reset(sgr, HyperlinkId {}, bufferObject->ref(0, 10), ColumnCount(10));
+
+    SECTION("tail of trivial line with same attributes")
+    {
+        line.erase(ColumnOffset(6), ColumnCount(4), sgr);
+        REQUIRE(line.isTrivialBuffer());
+        CHECK(line.trivialBuffer().text.view() == "012345"sv);
+        CHECK(line.trivialBuffer().usedColumns == ColumnCount(6));
+        CHECK(line.toUtf8() == "012345    ");
+    }
+
+    SECTION("tail of trivial line with other attributes")
+    {
+        auto other = sgr;
+        other.backgroundColor = Color::Indexed(IndexedColor::Blue);
+        line.erase(ColumnOffset(6), ColumnCount(4), other);
+        REQUIRE(line.isInflatedBuffer());
+        CHECK(line.toUtf8() == "012345    ");
+        CHECK(line.inflatedBuffer()[5].backgroundColor() == sgr.backgroundColor);
+        CHECK(line.inflatedBuffer()[6].backgroundColor() == other.backgroundColor);
+        CHECK(line.inflatedBuffer()[9].backgroundColor() == other.backgroundColor);
+    }
+
+    SECTION("middle of line")
+    {
+        line.erase(ColumnOffset(2), ColumnCount(3), sgr);
+        REQUIRE(line.isInflatedBuffer());
+        CHECK(line.toUtf8() == "01   56789");
+        CHECK(line.inflatedBuffer()[2].codepointCount() == 0);
+        CHECK(line.inflatedBuffer()[2].foregroundColor() == sgr.foregroundColor);
+    }
+
+    SECTION("whole line")
+    {
+        (void) line.inflatedBuffer();
+        line.erase(ColumnOffset(0), ColumnCount(10), GraphicsAttributes {});
+        REQUIRE(line.isTrivialBuffer());
+        CHECK(line.trivialBuffer().text.empty());
+        CHECK(line.trivialBuffer().attributes == GraphicsAttributes {});
+        CHECK(line.size() == ColumnCount(10));
+    }
+
+    SECTION("count beyond line end")
+    {
+        line.erase(ColumnOffset(8), ColumnCount(100), sgr);
+        CHECK(line.toUtf8() == "01234567  ");
+    }
+}
+
+TEST_CASE("Line.fill", "[Line]")
+{
+    auto line = Line<Cell>(LineFlags::None, ColumnCount(4), GraphicsAttributes {});
+    line.fill(LineFlags::None, GraphicsAttributes {}, U'E', 1);
+    REQUIRE(line.isInflatedBuffer());
+    CHECK(line.toUtf8() == "EEEE");
+    for (auto const& cell: line.inflatedBuffer())
+        CHECK(cell.width() == 1);
+}
+
+TEST_CASE("Line.usedColumns", "[Line]")
+{
+    auto constexpr testText = "0123  "sv;
+    auto pool = BufferObjectPool(16);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(testText);
+
+    auto line = Line<Cell>(LineFlags::None, ColumnCount(10), GraphicsAttributes {});
+    line.reset(GraphicsAttributes {}, HyperlinkId {}, bufferObject->ref(0, 6), ColumnCount(6));
+    CHECK(line.usedColumns() == ColumnCount(4));
+    CHECK(line.trim_blank_right().size() == 4);
+
+    // Mutating the line must not return the previously cached value.
+    line.useCellAt(ColumnOffset(7)).setCharacter(U'X');
+    CHECK(line.usedColumns() == ColumnCount(8));
+
+    line.useCellAt(ColumnOffset(7)).reset();
+    CHECK(line.usedColumns() == ColumnCount(4));
+
+    line.reset(LineFlags::None, GraphicsAttributes {});
+    CHECK(line.usedColumns() == ColumnCount(0));
+    CHECK(line.trim_blank_right().empty());
+}
+
+TEST_CASE("Line.unchangedWritesKeepGeneration", "[Line]")
+{
+    auto constexpr testText = "0123456789"sv;
+    auto pool = BufferObjectPool(16);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(testText);
+
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    auto other = sgr;
+    other.styles |= CellFlags::Bold;
+
+    auto line = Line<Cell>(LineFlags::None, ColumnCount(12), sgr);
+    line.reset(sgr, HyperlinkId {}, bufferObject->ref(0, 10), ColumnCount(10));
+    auto const generation = line.generation();
+
+    CHECK(line.holdsText(ColumnOffset(2), "234", sgr, HyperlinkId {}));
+    CHECK(!line.holdsText(ColumnOffset(2), "235", sgr, HyperlinkId {}));
+    CHECK(!line.holdsText(ColumnOffset(2), "234", other, HyperlinkId {}));
+    CHECK(!line.holdsText(ColumnOffset(2), "234", sgr, HyperlinkId(1)));
+    CHECK(!line.holdsText(ColumnOffset(9), "9 ", sgr, HyperlinkId {}));
+    CHECK(line.holdsCharacter(ColumnOffset(9), sgr, U'9', 1, HyperlinkId {}));
+    CHECK(line.holdsCharacter(ColumnOffset(10), sgr, 0, 1, HyperlinkId {}));
+    CHECK(!line.holdsCharacter(ColumnOffset(12), sgr, 0, 1, HyperlinkId {}));
+
+    // Erasing blank cells again.
+    line.erase(ColumnOffset(10), ColumnCount(2), sgr);
+    CHECK(line.generation() == generation);
+    line.erase(ColumnOffset(10), ColumnCount(2), other);
+    CHECK(line.generation() != generation);
+
+    SECTION("inflated")
+    {
+        line.erase(ColumnOffset(10), ColumnCount(2), sgr);
+        auto& cells = line.inflatedBuffer();
+        cells[3].write(other, U'ä', 1, HyperlinkId(1));
+        auto const inflatedGeneration = line.generation();
+
+        CHECK(line.holdsText(ColumnOffset(0), "012", sgr, HyperlinkId {}));
+        CHECK(line.holdsCharacter(ColumnOffset(3), other, U'ä', 1, HyperlinkId(1)));
+        CHECK(!line.holdsCharacter(ColumnOffset(3), other, U'ä', 1, HyperlinkId {}));
+        CHECK(!line.holdsCharacter(ColumnOffset(3), other, U'ä', 2, HyperlinkId(1)));
+        CHECK(line.isErased(ColumnOffset(10), ColumnCount(2), sgr));
+        CHECK(!line.isErased(ColumnOffset(9), ColumnCount(2), sgr));
+
+        line.erase(ColumnOffset(10), ColumnCount(2), sgr);
+        CHECK(line.generation() == inflatedGeneration);
+    }
+
+    SECTION("whole line")
+    {
+        line.reset(LineFlags::None, other);
+        auto const erasedGeneration = line.generation();
+        line.reset(LineFlags::Wrapped, other);
+        CHECK(line.generation() == erasedGeneration);
+        CHECK(line.wrapped());
+    }
+}
@@ -85,6 +85,12 @@ class MatchModes
 
     constexpr bool any() const noexcept { return enabled_ || disabled_; }
 
+    /// Tests whether the actually active mode flags satisfy all enabled and disabled modes.
+    constexpr bool matches(uint8_t _actualModeFlags) const noexcept
+    {
+        return (_actualModeFlags & enabled_) == enabled_ && (_actualModeFlags & disabled_) == 0;
+    }
+
     constexpr uint16_t hashcode() const noexcept { return static_cast<uint16_t>(enabled_ << 8 | disabled_); }
 
   private:
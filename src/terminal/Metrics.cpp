@@ -0,0 +1,62 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2020 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Metrics.h>
+
+#include <algorithm>
+#include <numeric>
+
+using std::vector;
+
+namespace terminal
+{
+
+namespace
+{
+    template <typename Less>
+    vector<Metrics::Entry> sortedEntries(
+        std::unordered_map<FunctionDefinition::id_type, Metrics::Entry> const& _entries, Less _less)
+    {
+        auto result = vector<Metrics::Entry> {};
+        result.reserve(_entries.size());
+        for (auto const& [id, entry]: _entries)
+            result.emplace_back(entry);
+        std::sort(result.begin(), result.end(), [&](auto const& a, auto const& b) {
+            if (_less(b, a))
+                return true;
+            if (_less(a, b))
+                return false;
+            return a.function->mnemonic < b.function->mnemonic;
+        });
+        return result;
+    }
+} // namespace
+
+vector<Metrics::Entry> Metrics::ordered() const
+{
+    return sortedEntries(entries_, [](auto const& a, auto const& b) { return a.count < b.count; });
+}
+
+vector<Metrics::Entry> Metrics::mostExpensive() const
+{
+    return sortedEntries(entries_, [](auto const& a, auto const& b) { return a.cycles < b.cycles; });
+}
+
+uint64_t Metrics::totalCycles() const noexcept
+{
+    return std::accumulate(entries_.begin(), entries_.end(), uint64_t { 0 }, [](uint64_t sum, auto const& e) {
+        return sum + e.second.cycles;
+    });
+}
+
+} // namespace terminal
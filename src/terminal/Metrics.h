@@ -13,39 +13,81 @@
  */
 #pragma once
 
-#include <terminal/Sequencer.h> // Sequence
+#include <terminal/Functions.h>
 
-#include <algorithm>
-#include <map>
-#include <string>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#endif
 
 namespace terminal
 {
 
-/// Used for collecting VT sequence usage metrics.
-struct Metrics
+/// @returns a cheap, monotonically increasing counter for measuring short durations, that is,
+///          CPU cycles (time stamp counter) on x86-64 and nanoseconds elsewhere.
+inline uint64_t cycleCount() noexcept
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+/// Unit of cycleCount(), for reporting.
+constexpr std::string_view cycleCountUnit() noexcept
 {
-    // XXX Too bad the key is a string.
-    std::map<std::string, uint64_t> sequences;
+#if defined(__x86_64__) || defined(_M_X64)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
 
-    void operator()(Sequence const& _seq) { sequences[_seq.text()]++; }
+/// Collects VT sequence usage and cost metrics, that is, how often each VT function has been
+/// invoked and how many cycles have been spent in it, from Sequencer dispatch to Screen application.
+class Metrics
+{
+  public:
+    struct Entry
+    {
+        FunctionDefinition const* function;
+        uint64_t count;
+        uint64_t cycles;
+    };
 
-    /// @returns an ordered list of collected metrics, with highest frequencey first.
-    std::vector<std::pair<std::string, uint64_t>> ordered() const
+    void record(FunctionDefinition const& _function, uint64_t _cycles)
     {
-        std::vector<std::pair<std::string, uint64_t>> vec;
-        for (auto const& [name, freq]: sequences)
-            vec.emplace_back(std::pair { name, freq });
-
-        std::sort(vec.begin(), vec.end(), [](auto const& a, auto const& b) {
-            if (a.second > b.second)
-                return true;
-            if (a.second == b.second)
-                return a.first > b.first;
-            return false;
-        });
-        return vec;
+        auto& entry = entries_[_function.id()];
+        entry.function = &_function;
+        entry.count++;
+        entry.cycles += _cycles;
     }
+
+    void clear() { entries_.clear(); }
+
+    /// @returns collected metrics, with the most frequently invoked functions first.
+    [[nodiscard]] std::vector<Entry> ordered() const;
+
+    /// @returns collected metrics, with the functions having the most cycles spent in first.
+    [[nodiscard]] std::vector<Entry> mostExpensive() const;
+
+    /// @returns the total number of cycles spent in all functions.
+    [[nodiscard]] uint64_t totalCycles() const noexcept;
+
+  private:
+    std::unordered_map<FunctionDefinition::id_type, Entry> entries_;
 };
 
 } // namespace terminal
@@ -0,0 +1,67 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Functions.h>
+#include <terminal/Metrics.h>
+#include <terminal/MockTerm.h>
+
+#include <catch2/catch.hpp>
+
+using terminal::ColumnCount;
+using terminal::LineCount;
+using terminal::Metrics;
+using terminal::PageSize;
+
+TEST_CASE("Metrics.ordered", "[metrics]")
+{
+    auto metrics = Metrics {};
+    metrics.record(terminal::CUP, 10);
+    metrics.record(terminal::SGR, 5);
+    metrics.record(terminal::SGR, 3);
+    metrics.record(terminal::ED, 100);
+
+    auto const byCount = metrics.ordered();
+    REQUIRE(byCount.size() == 3);
+    CHECK(byCount[0].function->mnemonic == "SGR");
+    CHECK(byCount[0].count == 2);
+    CHECK(byCount[0].cycles == 8);
+
+    auto const byCost = metrics.mostExpensive();
+    REQUIRE(byCost.size() == 3);
+    CHECK(byCost[0].function->mnemonic == "ED");
+    CHECK(byCost[1].function->mnemonic == "CUP");
+    CHECK(byCost[2].function->mnemonic == "SGR");
+
+    CHECK(metrics.totalCycles() == 118);
+}
+
+TEST_CASE("Metrics.Terminal", "[metrics]")
+{
+    auto mock = terminal::MockTerm { PageSize { LineCount(5), ColumnCount(10) } };
+    CHECK(mock.terminal.sequenceMetrics() == nullptr);
+
+    mock.terminal.setSequenceProfiling(true);
+    mock.writeToScreen("\033[1;31mA\033[mB\033[2;3H\033[?25l");
+
+    auto const metrics = mock.terminal.sequenceMetrics();
+    REQUIRE(metrics != nullptr);
+    auto const entries = metrics->ordered();
+    REQUIRE(entries.size() == 3);
+    CHECK(entries[0].function->mnemonic == "SGR");
+    CHECK(entries[0].count == 2);
+    CHECK(entries[1].count == 1);
+    CHECK(entries[2].count == 1);
+
+    mock.terminal.setSequenceProfiling(false);
+    CHECK(mock.terminal.sequenceMetrics() == nullptr);
+}
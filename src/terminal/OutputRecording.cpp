@@ -0,0 +1,173 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/OutputRecording.h>
+
+#include <fmt/format.h>
+
+#include <iterator>
+#include <stdexcept>
+
+using std::string_view;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+namespace terminal
+{
+
+namespace
+{
+    constexpr auto Magic = string_view("CREC\x01", 5);
+    constexpr char OutputRecord = 'O';
+    constexpr char ResizeRecord = 'R';
+
+    class Reader
+    {
+      public:
+        explicit Reader(vector<char> const& _bytes):
+            current_ { _bytes.data() }, end_ { _bytes.data() + _bytes.size() }
+        {
+        }
+
+        [[nodiscard]] bool atEnd() const noexcept { return current_ == end_; }
+
+        char byte()
+        {
+            if (atEnd())
+                throw std::runtime_error("Truncated output recording.");
+            return *current_++;
+        }
+
+        uint64_t number()
+        {
+            auto value = uint64_t { 0 };
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                auto const b = static_cast<uint8_t>(byte());
+                value |= uint64_t { b & 0x7Fu } << shift;
+                if (!(b & 0x80))
+                    return value;
+            }
+            throw std::runtime_error("Malformed number in output recording.");
+        }
+
+        string_view bytes(uint64_t _count)
+        {
+            if (_count > static_cast<uint64_t>(end_ - current_))
+                throw std::runtime_error("Truncated output recording.");
+            auto const result = string_view(current_, static_cast<size_t>(_count));
+            current_ += static_cast<std::ptrdiff_t>(_count);
+            return result;
+        }
+
+        PageSize pageSize()
+        {
+            auto const columns = ColumnCount::cast_from(number());
+            auto const lines = LineCount::cast_from(number());
+            return PageSize { lines, columns };
+        }
+
+      private:
+        char const* current_;
+        char const* end_;
+    };
+} // namespace
+
+// {{{ OutputRecorder
+OutputRecorder::OutputRecorder(FileSystem::path const& _path, PageSize _pageSize):
+    file_ { _path.string(), std::ios::out | std::ios::binary | std::ios::trunc }
+{
+    if (!file_.is_open())
+        throw std::runtime_error(fmt::format("Could not open output recording file {}.", _path.string()));
+
+    file_.write(Magic.data(), static_cast<std::streamsize>(Magic.size()));
+    writeNumber(unbox<uint64_t>(_pageSize.columns));
+    writeNumber(unbox<uint64_t>(_pageSize.lines));
+}
+
+void OutputRecorder::output(string_view _data, Timestamp _now)
+{
+    auto const _ = std::lock_guard { mutex_ };
+    beginRecord(OutputRecord, _now);
+    writeNumber(_data.size());
+    file_.write(_data.data(), static_cast<std::streamsize>(_data.size()));
+}
+
+void OutputRecorder::resize(PageSize _pageSize, Timestamp _now)
+{
+    auto const _ = std::lock_guard { mutex_ };
+    beginRecord(ResizeRecord, _now);
+    writeNumber(unbox<uint64_t>(_pageSize.columns));
+    writeNumber(unbox<uint64_t>(_pageSize.lines));
+}
+
+void OutputRecorder::beginRecord(char _type, Timestamp _now)
+{
+    auto const delay = lastRecord_ ? duration_cast<microseconds>(_now - *lastRecord_) : microseconds(0);
+    lastRecord_ = _now;
+    file_.put(_type);
+    writeNumber(static_cast<uint64_t>(delay.count()));
+}
+
+void OutputRecorder::writeNumber(uint64_t _value)
+{
+    while (_value >= 0x80)
+    {
+        file_.put(static_cast<char>((_value & 0x7F) | 0x80));
+        _value >>= 7;
+    }
+    file_.put(static_cast<char>(_value));
+}
+// }}}
+
+// {{{ OutputRecording
+OutputRecording OutputRecording::load(FileSystem::path const& _path)
+{
+    auto file = std::ifstream(_path.string(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error(fmt::format("Could not open output recording file {}.", _path.string()));
+
+    return OutputRecording(
+        vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+}
+
+OutputRecording::OutputRecording(vector<char> _bytes): bytes_ { std::move(_bytes) }
+{
+    auto reader = Reader(bytes_);
+    if (reader.bytes(Magic.size()) != Magic)
+        throw std::runtime_error("Not an output recording.");
+
+    pageSize_ = reader.pageSize();
+
+    while (!reader.atEnd())
+    {
+        auto record = Record {};
+        auto const type = reader.byte();
+        record.delay = microseconds(reader.number());
+        switch (type)
+        {
+            case OutputRecord:
+                record.data = reader.bytes(reader.number());
+                outputSize_ += record.data.size();
+                break;
+            case ResizeRecord: record.pageSize = reader.pageSize(); break;
+            default: throw std::runtime_error(fmt::format("Unknown output recording record type {}.", type));
+        }
+        duration_ += record.delay;
+        records_.emplace_back(record);
+    }
+}
+// }}}
+
+} // namespace terminal
@@ -0,0 +1,112 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/primitives.h>
+
+#include <crispy/stdfs.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace terminal
+{
+
+/**
+ * Records the raw output of a PTY, along with when it was read, into a compact file.
+ *
+ * The file starts with a header carrying the page size, followed by one record per PTY read
+ * or screen resize, each prefixed with the time elapsed since the previous record.
+ * Integers are stored as LEB128 variable length integers.
+ *
+ * @see OutputRecording
+ */
+class OutputRecorder
+{
+  public:
+    using Timestamp = std::chrono::steady_clock::time_point;
+
+    /// Creates (or truncates) the recording file at @p _path.
+    ///
+    /// @throws std::runtime_error if the file could not be opened for writing.
+    OutputRecorder(FileSystem::path const& _path, PageSize _pageSize);
+
+    /// Records a chunk of PTY output, as read at @p _now.
+    void output(std::string_view _data, Timestamp _now);
+
+    /// Records the screen having been resized to @p _pageSize at @p _now.
+    void resize(PageSize _pageSize, Timestamp _now);
+
+  private:
+    void beginRecord(char _type, Timestamp _now);
+    void writeNumber(uint64_t _value);
+
+    std::mutex mutex_;
+    std::ofstream file_;
+    std::optional<Timestamp> lastRecord_;
+};
+
+/**
+ * A recording of PTY output, as written by OutputRecorder, loaded for replaying it.
+ */
+class OutputRecording
+{
+  public:
+    struct Record
+    {
+        std::chrono::microseconds delay;  // time elapsed since the previous record
+        std::string_view data;            // PTY output, empty for resize records
+        std::optional<PageSize> pageSize; // new page size for resize records
+    };
+
+    /// Loads the recording at @p _path.
+    ///
+    /// @throws std::runtime_error if the file could not be read or is not a valid recording.
+    static OutputRecording load(FileSystem::path const& _path);
+
+    /// Parses a recording from its file contents.
+    ///
+    /// @throws std::runtime_error if @p _bytes is not a valid recording.
+    explicit OutputRecording(std::vector<char> _bytes);
+
+    OutputRecording(OutputRecording&&) = default;
+    OutputRecording& operator=(OutputRecording&&) = default;
+    OutputRecording(OutputRecording const&) = delete;
+    OutputRecording& operator=(OutputRecording const&) = delete;
+
+    /// @returns the page size the recording started with.
+    [[nodiscard]] PageSize pageSize() const noexcept { return pageSize_; }
+
+    [[nodiscard]] std::vector<Record> const& records() const noexcept { return records_; }
+
+    /// @returns the number of bytes of PTY output in this recording.
+    [[nodiscard]] uint64_t outputSize() const noexcept { return outputSize_; }
+
+    /// @returns the time span from the first to the last record.
+    [[nodiscard]] std::chrono::microseconds duration() const noexcept { return duration_; }
+
+  private:
+    std::vector<char> bytes_; // file contents, referenced by the records
+    PageSize pageSize_ {};
+    std::vector<Record> records_;
+    uint64_t outputSize_ = 0;
+    std::chrono::microseconds duration_ {};
+};
+
+} // namespace terminal
@@ -0,0 +1,71 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/OutputRecording.h>
+
+#include <crispy/stdfs.h>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using terminal::ColumnCount;
+using terminal::LineCount;
+using terminal::OutputRecorder;
+using terminal::OutputRecording;
+using terminal::PageSize;
+
+TEST_CASE("OutputRecording.roundtrip", "[recording]")
+{
+    auto const path = FileSystem::temp_directory_path() / "libterminal-OutputRecording_test-roundtrip";
+    auto const t = OutputRecorder::Timestamp {} + 1s;
+    auto const longText = std::string(300, 'x'); // size does not fit into a single LEB128 byte
+
+    {
+        auto recorder = OutputRecorder(path, PageSize { LineCount(25), ColumnCount(80) });
+        recorder.output("Hello\r\n", t);
+        recorder.resize(PageSize { LineCount(30), ColumnCount(100) }, t + 5ms);
+        recorder.output(longText, t + 1s);
+    }
+
+    auto const recording = OutputRecording::load(path);
+    FileSystem::remove(path);
+
+    CHECK(recording.pageSize() == PageSize { LineCount(25), ColumnCount(80) });
+    CHECK(recording.outputSize() == 7 + longText.size());
+    CHECK(recording.duration() == 1s);
+
+    auto const& records = recording.records();
+    REQUIRE(records.size() == 3);
+    CHECK(records[0].delay == 0us);
+    CHECK(records[0].data == "Hello\r\n");
+    CHECK(!records[0].pageSize);
+    CHECK(records[1].delay == 5ms);
+    CHECK(records[1].data.empty());
+    CHECK(records[1].pageSize == PageSize { LineCount(30), ColumnCount(100) });
+    CHECK(records[2].delay == 995ms);
+    CHECK(records[2].data == longText);
+}
+
+TEST_CASE("OutputRecording.malformed", "[recording]")
+{
+    CHECK_THROWS_AS(OutputRecording(std::vector<char> { 'n', 'o', 'p', 'e', '!' }), std::runtime_error);
+
+    // Valid header, followed by an output record claiming more bytes than there are.
+    auto truncated = std::vector<char> { 'C', 'R', 'E', 'C', '\x01', 80, 25, 'O', 0, 10, 'a', 'b' };
+    CHECK_THROWS_AS(OutputRecording(std::move(truncated)), std::runtime_error);
+}
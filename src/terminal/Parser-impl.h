@@ -16,12 +16,15 @@
 #include <terminal/Parser.h>
 #include <terminal/logging.h>
 
+#include <crispy/PerfTrace.h>
 #include <crispy/assert.h>
 #include <crispy/escape.h>
 #include <crispy/utils.h>
 
 #include <unicode/scan.h>
 
+#include <algorithm>
+
 namespace terminal::parser
 {
 
@@ -226,9 +229,63 @@ constexpr ParserTable ParserTable::get() // {{{
     return t;
 } // }}}
 
+constexpr ParserDispatchTable ParserDispatchTable::build(ParserTable const& _table) // {{{
+{
+    auto const behavesEqual = [&](uint8_t a, uint8_t b) constexpr {
+        for (size_t s = 0; s < std::numeric_limits<State>::size(); ++s)
+            if (_table.transitions[s][a] != _table.transitions[s][b]
+                || _table.events[s][a] != _table.events[s][b])
+                return false;
+        return true;
+    };
+
+    auto dispatch = ParserDispatchTable {};
+    auto representatives = std::array<uint8_t, MaxByteClasses> {};
+
+    for (unsigned input = 0; input < 256; ++input)
+    {
+        auto const ch = static_cast<uint8_t>(input);
+
+        // Most bytes reside in contiguous ranges, so try the previous byte's class first.
+        size_t byteClass = input != 0 ? dispatch.byteClasses[input - 1] : 0;
+        if (input == 0 || !behavesEqual(representatives[byteClass], ch))
+        {
+            byteClass = 0;
+            while (byteClass < dispatch.byteClassCount && !behavesEqual(representatives[byteClass], ch))
+                ++byteClass;
+            if (byteClass == dispatch.byteClassCount)
+            {
+                representatives.at(byteClass) = ch;
+                ++dispatch.byteClassCount;
+            }
+        }
+        dispatch.byteClasses[input] = static_cast<uint8_t>(byteClass);
+    }
+
+    for (size_t s = 0; s < std::numeric_limits<State>::size(); ++s)
+    {
+        for (size_t byteClass = 0; byteClass < dispatch.byteClassCount; ++byteClass)
+        {
+            auto const ch = representatives[byteClass];
+            auto& transition = dispatch.transitions[s][byteClass];
+            transition.event = _table.events[s][ch];
+            transition.target = _table.transitions[s][ch];
+            if (transition.target != State::Undefined)
+            {
+                transition.exit = _table.exitEvents[s];
+                transition.entry = _table.entryEvents[static_cast<size_t>(transition.target)];
+            }
+        }
+    }
+
+    return dispatch;
+} // }}}
+
 template <typename EventListener, bool TraceStateChanges>
 void Parser<EventListener, TraceStateChanges>::parseFragment(std::string_view const _data)
 {
+    CONTOUR_PERF_TRACE("Parser::parseFragment");
+
     auto input = _data.data();
     auto const end = _data.data() + _data.size();
 
@@ -241,7 +298,11 @@ void Parser<EventListener, TraceStateChanges>::parseFragment(std::string_view co
             if (VTTraceParserLog)
                 VTTraceParserLog()("scan_for_text(max={}, data=\"{}\")", maxCharCount, crispy::escape(chunk));
 #endif
-            if (auto const cellCount = unicode::scan_for_text_ascii(chunk, maxCharCount); cellCount > 0)
+            auto const cellCount =
+                vectorizedScan
+                    ? scanPrintableAscii(input, input + std::min(maxCharCount, chunk.size()))
+                    : unicode::scan_for_text_ascii(chunk, maxCharCount);
+            if (cellCount > 0)
             {
                 auto const next = input + cellCount;
                 auto const byteCount = static_cast<size_t>(std::distance(input, next));
@@ -275,23 +336,55 @@ void Parser<EventListener, TraceStateChanges>::parseFragment(std::string_view co
                 }
                 continue;
             }
+
+            if (vectorizedScan && static_cast<uint8_t>(*input) >= 0x80)
+            {
+                auto const decodeEnd = input + std::min(chunk.size(), decodedText_.size());
+                auto const [byteCount, codepointCount] =
+                    decodeUtf8Text(input, decodeEnd, decodedText_.data());
+                if (byteCount > 0)
+                {
+                    eventListener_.print(std::u32string_view(decodedText_.data(), codepointCount));
+                    input += byteCount;
+                    continue;
+                }
+            }
+        }
+        else if (vectorizedScan && state_ == State::CSI_Entry)
+        {
+            if (auto const byteCount = parseControlSequence(input, end); byteCount > 0)
+            {
+                input += byteCount;
+                continue;
+            }
+        }
+        else if (vectorizedScan && isStringPayloadState(state_))
+        {
+            // Bulk-forward string payload bytes (OSC, DCS, APC, PM) without going
+            // through the state table for each byte.
+            if (auto const byteCount = scanPrintableAscii(input, end); byteCount > 0)
+            {
+                putStringPayload(input, input + byteCount);
+                input += byteCount;
+                continue;
+            }
         }
 
         auto const ch = static_cast<uint8_t>(*input++);
-        auto const s = static_cast<size_t>(state_);
         ParserTable static constexpr table = ParserTable::get();
+        ParserDispatchTable static constexpr dispatchTable = ParserDispatchTable::build(table);
+        ParserTransition const t = dispatchTable.at(state_, ch);
 
-        if (auto const t = table.transitions[s][static_cast<uint8_t>(ch)]; t != State::Undefined)
+        if (t.target != State::Undefined)
         {
-            // fmt::print("VTParser: Transitioning from {} to {}", state_, t);
-            // handle(_actionClass, _action, currentChar());
-            handle(ActionClass::Leave, table.exitEvents[s], ch);
-            handle(ActionClass::Transition, table.events[s][static_cast<size_t>(ch)], ch);
-            state_ = t;
-            handle(ActionClass::Enter, table.entryEvents[static_cast<size_t>(t)], ch);
+            // fmt::print("VTParser: Transitioning from {} to {}", state_, t.target);
+            handle(ActionClass::Leave, t.exit, ch);
+            handle(ActionClass::Transition, t.event, ch);
+            state_ = t.target;
+            handle(ActionClass::Enter, t.entry, ch);
         }
-        else if (Action const a = table.events[s][ch]; a != Action::Undefined)
-            handle(ActionClass::Event, a, ch);
+        else if (t.event != Action::Undefined)
+            handle(ActionClass::Event, t.event, ch);
         else
             eventListener_.error(
                 fmt::format("Parser Error: Unknown action for state/input pair ({}, '{}' 0x{:02X})",
@@ -301,6 +394,70 @@ void Parser<EventListener, TraceStateChanges>::parseFragment(std::string_view co
     } while (input != end);
 }
 
+template <typename EventListener, bool TraceStateChanges>
+size_t Parser<EventListener, TraceStateChanges>::parseControlSequence(char const* _begin, char const* _end)
+{
+    auto const inRange = [](char ch, uint8_t first, uint8_t last) {
+        return first <= static_cast<uint8_t>(ch) && static_cast<uint8_t>(ch) <= last;
+    };
+
+    auto input = _begin;
+    if (input == _end)
+        return 0;
+
+    auto const leader = inRange(*input, 0x3C, 0x3F) ? *input++ : '\0';
+    if (!leader && *input == ':')
+        return 0; // ignored sequence, see CSI_Ignore
+
+    // The state machine takes the very same route through CSI_Param and CSI_Intermediate,
+    // but byte by byte, which this spares in particular SGR sequences with many parameters.
+    auto const parameters = std::string_view(input, scanParameterBytes(input, _end));
+    input += parameters.size();
+
+    auto const intermediates = input;
+    while (input != _end && inRange(*input, 0x20, 0x2F))
+        ++input;
+
+    if (input == _end || !inRange(*input, 0x40, 0x7E))
+        return 0; // incomplete, or containing bytes to be executed or ignored
+
+    if (leader)
+        eventListener_.collectLeader(leader);
+    if (!parameters.empty())
+        eventListener_.params(parameters);
+    for (auto i = intermediates; i != input; ++i)
+        eventListener_.collect(*i);
+    eventListener_.dispatchCSI(*input++);
+    state_ = State::Ground;
+
+    return static_cast<size_t>(input - _begin);
+}
+
+template <typename EventListener, bool TraceStateChanges>
+void Parser<EventListener, TraceStateChanges>::putStringPayload(char const* begin, char const* end)
+{
+    // All bytes passed in here are printable US-ASCII and therefore known to not cause
+    // any state transition but just the payload's Put action.
+    switch (state_)
+    {
+        case State::OSC_String:
+            eventListener_.putOSC(std::string_view(begin, static_cast<size_t>(end - begin)));
+            break;
+        case State::DCS_PassThrough:
+            eventListener_.put(std::string_view(begin, static_cast<size_t>(end - begin)));
+            break;
+        case State::APC_String:
+            for (auto i = begin; i != end; ++i)
+                eventListener_.putAPC(*i);
+            break;
+        case State::PM_String:
+            for (auto i = begin; i != end; ++i)
+                eventListener_.putPM(*i);
+            break;
+        default: break;
+    }
+}
+
 template <typename EventListener, bool TraceStateChanges>
 void Parser<EventListener, TraceStateChanges>::handle(ActionClass _actionClass,
                                                       Action _action,
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <terminal/ControlCode.h>
+#include <terminal/ParserScanner.h>
 
 #include <crispy/overloaded.h>
 #include <crispy/range.h>
@@ -616,6 +617,51 @@ struct ParserTable
     // }}}
 };
 
+/// A single (state, input) entry of the ParserDispatchTable, packing the action for the
+/// input along with the exit and entry actions and the target state of a state change.
+struct ParserTransition
+{
+    //! action to be invoked for the given input
+    Action event = Action::Undefined;
+
+    //! action to be invoked upon leaving the current state (only if target is set)
+    Action exit = Action::Undefined;
+
+    //! action to be invoked upon entering the target state (only if target is set)
+    Action entry = Action::Undefined;
+
+    //! target state, or State::Undefined if the input does not cause a state change
+    State target = State::Undefined;
+};
+
+/// Compact dispatch form of the ParserTable, as used by the Parser's hot loop.
+///
+/// Input bytes that behave identically in every state are folded into the same byte class,
+/// so that every (state, byte class) pair maps to exactly one ParserTransition and handling
+/// an input byte requires a single table load.
+struct ParserDispatchTable
+{
+    static constexpr size_t MaxByteClasses = 32;
+
+    //! Maps each input byte to its byte class.
+    std::array<uint8_t, 256> byteClasses {};
+
+    //! Number of distinct byte classes in use.
+    size_t byteClassCount = 0;
+
+    //! Packed transition map from (State, byte class) to ParserTransition.
+    std::array<std::array<ParserTransition, MaxByteClasses>, std::numeric_limits<State>::size()>
+        transitions {};
+
+    constexpr ParserTransition const& at(State _state, uint8_t _input) const noexcept
+    {
+        return transitions[static_cast<size_t>(_state)][byteClasses[_input]];
+    }
+
+    //! Computes the dispatch table from the given (expanded) parser table.
+    static constexpr ParserDispatchTable build(ParserTable const& _table);
+};
+
 /**
  * Terminal Parser.
  *
@@ -651,13 +697,36 @@ class Parser
 
     size_t maxCharCount = 0;
 
+    /// Uses the vectorized scanner (see ParserScanner.h) for the printable text fast path
+    /// in Ground state, including decoding non-ASCII text in bulk, for forwarding string
+    /// payloads (OSC, DCS, APC, PM) in bulk, as well as for parsing control sequences that are
+    /// complete within the fragment at once. Disabling it falls back to
+    /// the plain per-byte state machine (and libunicode's text scanner for Ground state),
+    /// which is mostly useful for benchmarking.
+    bool vectorizedScan = true;
+
   private:
+    static constexpr bool isStringPayloadState(State _state) noexcept
+    {
+        return _state == State::OSC_String || _state == State::DCS_PassThrough
+               || _state == State::APC_String || _state == State::PM_String;
+    }
+
+    void putStringPayload(char const* _begin, char const* _end);
+
+    /// Parses the control sequence following the CSI at the start of [_begin, _end) at once,
+    /// provided it is complete and well-formed, i.e. consists of an optional leader, a parameter
+    /// string, optional intermediate characters and the final character only.
+    ///
+    /// @returns the number of bytes parsed, or 0 if the sequence is to be parsed byte by byte.
+    size_t parseControlSequence(char const* _begin, char const* _end);
     void handle(ActionClass _actionClass, Action _action, uint8_t _char);
 
     // private properties
     //
     State state_ = State::Ground;
     EventListener& eventListener_;
+    std::array<char32_t, 256> decodedText_ {}; // non-ASCII text passed to print() in bulk
 };
 
 /// @returns parsed tuple with OSC code and offset to first data parameter byte.
@@ -48,6 +48,13 @@ class ParserEvents
      */
     virtual void print(std::string_view _chars, size_t cellCount) = 0;
 
+    /**
+     * Optimization that passes in runs of non-ASCII text, decoded from UTF-8 in bulk.
+     *
+     * The text consists of printable codepoints only, that is, no C0 control codes.
+     */
+    virtual void print(std::u32string_view _chars) = 0;
+
     /**
      * The C0 or C1 control function should be executed, which may have any one of a variety of
      * effects, including changing the cursor position, suspending or resuming communications or
@@ -92,6 +99,13 @@ class ParserEvents
     virtual void paramSeparator() = 0;
     virtual void paramSubSeparator() = 0;
 
+    /**
+     * Collects a control sequence's whole parameter string at once, consisting of the digits 0-9,
+     * the colon (sub-parameter separator) and the semicolon only, which is equivalent to
+     * invoking paramDigit(), paramSubSeparator() and paramSeparator() for each of its characters.
+     */
+    virtual void params(std::string_view _parameters) = 0;
+
     /**
      * The final character of an escape sequence has arrived, so determined the control function
      * to be executed from the intermediate character(s) and final character, and execute it.
@@ -123,6 +137,11 @@ class ParserEvents
      */
     virtual void putOSC(char _char) = 0;
 
+    /**
+     * Optimization that passes in a run of printable US-ASCII characters of the control string at once.
+     */
+    virtual void putOSC(std::string_view _chars) = 0;
+
     /**
      * This action is called when the OSC string is terminated by ST, CAN, SUB or ESC,
      * to allow the OSC handler to finish neatly.
@@ -146,6 +165,11 @@ class ParserEvents
      */
     virtual void put(char _char) = 0;
 
+    /**
+     * Optimization that passes in a run of printable US-ASCII characters of the data string at once.
+     */
+    virtual void put(std::string_view _chars) = 0;
+
     /**
      * When a device control string is terminated by ST, CAN, SUB or ESC, this action calls the
      * previously selected handler function with an “end of data” parameter. This allows the
@@ -168,6 +192,7 @@ class BasicParserEvents: public ParserEvents
     void error(std::string_view const&) override {}
     void print(char) override {}
     void print(std::string_view, size_t) override {}
+    void print(std::u32string_view) override {}
     void execute(char) override {}
     void clear() override {}
     void collect(char) override {}
@@ -176,13 +201,27 @@ class BasicParserEvents: public ParserEvents
     void paramDigit(char /*_char*/) override {}
     void paramSeparator() override {}
     void paramSubSeparator() override {}
+    void params(std::string_view _parameters) override
+    {
+        for (char const ch: _parameters)
+        {
+            if (ch == ';')
+                paramSeparator();
+            else if (ch == ':')
+                paramSubSeparator();
+            else
+                paramDigit(ch);
+        }
+    }
     void dispatchESC(char) override {}
     void dispatchCSI(char) override {}
     void startOSC() override {}
     void putOSC(char) override {}
+    void putOSC(std::string_view) override {}
     void dispatchOSC() override {}
     void hook(char) override {}
     void put(char) override {}
+    void put(std::string_view) override {}
     void unhook() override {}
     void startAPC() override {}
     void putAPC(char) override {}
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace terminal
 {
@@ -18,6 +19,13 @@ class ParserExtension
 
     virtual void pass(char _char) = 0;
     virtual void finalize() = 0;
+
+    /// Passes a run of characters at once, sparing a virtual call per character where overridden.
+    virtual void pass(std::string_view _chars)
+    {
+        for (char const ch: _chars)
+            pass(ch);
+    }
 };
 
 class SimpleStringCollector: public ParserExtension
@@ -26,6 +34,7 @@ class SimpleStringCollector: public ParserExtension
     explicit SimpleStringCollector(std::function<void(std::string_view)> _done): done_ { std::move(_done) } {}
 
     void pass(char _char) override { data_.push_back(_char); }
+    void pass(std::string_view _chars) override { data_.append(_chars); }
 
     void finalize() override
     {
@@ -0,0 +1,354 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    #include <immintrin.h>
+#elif defined(__aarch64__)
+    #include <crispy/sse2neon.h>
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace terminal::parser
+{
+
+namespace detail
+{
+    inline unsigned countTrailingZeros(uint32_t value) noexcept
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanForward(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+    }
+
+    constexpr bool isPrintableAscii(uint8_t ch) noexcept
+    {
+        return 0x20 <= ch && ch < 0x7F;
+    }
+
+    /// Tests for the bytes of a control sequence's parameter string, i.e. digits, ':' and ';'.
+    constexpr bool isParameterByte(uint8_t ch) noexcept
+    {
+        return 0x30 <= ch && ch <= 0x3B;
+    }
+
+    constexpr bool isContinuationByte(uint8_t ch) noexcept
+    {
+        return (ch & 0xC0) == 0x80;
+    }
+
+    /// Decodes the UTF-8 sequence at the start of [begin, end), whose first byte is non-ASCII.
+    ///
+    /// Overlong forms, surrogates, codepoints beyond U+10FFFF, and incomplete sequences are rejected.
+    ///
+    /// @returns the length of the sequence, or 0 if it is invalid.
+    inline size_t decodeUtf8Sequence(char const* begin, char const* end, char32_t& codepoint) noexcept
+    {
+        auto const byte = [&](size_t i) {
+            return static_cast<uint8_t>(begin[i]);
+        };
+
+        auto const lead = byte(0);
+        auto length = size_t { 0 };
+        auto lowest = uint8_t { 0x80 }; // bounds of the second byte
+        auto highest = uint8_t { 0xBF };
+        if (0xC2 <= lead && lead <= 0xDF)
+        {
+            length = 2;
+            codepoint = lead & 0x1F;
+        }
+        else if (0xE0 <= lead && lead <= 0xEF)
+        {
+            length = 3;
+            codepoint = lead & 0x0F;
+            if (lead == 0xE0)
+                lowest = 0xA0; // overlong
+            else if (lead == 0xED)
+                highest = 0x9F; // surrogates
+        }
+        else if (0xF0 <= lead && lead <= 0xF4)
+        {
+            length = 4;
+            codepoint = lead & 0x07;
+            if (lead == 0xF0)
+                lowest = 0x90; // overlong
+            else if (lead == 0xF4)
+                highest = 0x8F; // beyond U+10FFFF
+        }
+        else
+            return 0;
+
+        if (static_cast<size_t>(end - begin) < length || byte(1) < lowest || byte(1) > highest)
+            return 0;
+
+        for (size_t i = 1; i < length; ++i)
+        {
+            if (!isContinuationByte(byte(i)))
+                return 0;
+            codepoint = (codepoint << 6) | (byte(i) & 0x3F);
+        }
+        return length;
+    }
+
+    /// Decodes the sequences in [begin, begin + length), which are known to be valid UTF-8.
+    inline char32_t* decodeValidUtf8(char const* begin, size_t length, char32_t* output) noexcept
+    {
+        for (size_t i = 0; i < length;)
+        {
+            auto const lead = static_cast<uint8_t>(begin[i]);
+            auto const continuation = [&](size_t k) {
+                return static_cast<char32_t>(static_cast<uint8_t>(begin[i + k]) & 0x3F);
+            };
+            if (lead < 0x80)
+            {
+                *output++ = lead;
+                i += 1;
+            }
+            else if (lead < 0xE0)
+            {
+                *output++ = (static_cast<char32_t>(lead & 0x1F) << 6) | continuation(1);
+                i += 2;
+            }
+            else if (lead < 0xF0)
+            {
+                *output++ =
+                    (static_cast<char32_t>(lead & 0x0F) << 12) | (continuation(1) << 6) | continuation(2);
+                i += 3;
+            }
+            else
+            {
+                *output++ = (static_cast<char32_t>(lead & 0x07) << 18) | (continuation(1) << 12)
+                            | (continuation(2) << 6) | continuation(3);
+                i += 4;
+            }
+        }
+        return output;
+    }
+
+#if defined(__SSE2__) || defined(__aarch64__)
+    /// Validates the UTF-8 text at the start of the 16 bytes at @p input, of which 17 must be readable.
+    ///
+    /// @returns the number of leading bytes that make up complete sequences of printable text,
+    ///          up to the first C0 control byte or a sequence that continues beyond the 16 bytes,
+    ///          or -1 if the text is not valid UTF-8 or consists of US-ASCII only.
+    inline int validateUtf8Batch(char const* input) noexcept
+    {
+        // Signed comparison: the bytes 0x80..0xFF are negative and classified by ranges of these.
+        auto const set = [](int ch) {
+            return _mm_set1_epi8(static_cast<char>(ch));
+        };
+        auto const between = [](__m128i batch, __m128i below, __m128i above) {
+            return _mm_and_si128(_mm_cmpgt_epi8(batch, below), _mm_cmplt_epi8(batch, above));
+        };
+        auto const mask = [](__m128i bytes) {
+            return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+        };
+
+        auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+        auto const nonAscii = mask(batch);
+        if (nonAscii == 0)
+            return -1;
+
+        auto const control = mask(_mm_cmplt_epi8(batch, set(0x20))) & ~nonAscii;
+        auto const continuation = mask(_mm_cmplt_epi8(batch, set(0xC0)));
+        auto const lead2 = mask(between(batch, set(0xC1), set(0xE0)));
+        auto const lead3 = mask(between(batch, set(0xDF), set(0xF0)));
+        auto const lead4 = mask(between(batch, set(0xEF), set(0xF5)));
+        auto const leads = lead2 | lead3 | lead4;
+
+        // Stop in front of the first control byte, or in front of a sequence not ending within the batch.
+        auto length = control ? countTrailingZeros(control) : 16u;
+        auto const spilling = ((lead2 << 1) | (lead3 << 2) | (lead4 << 3)) >> 16;
+        if (spilling)
+            for (auto lead = leads; lead != 0; lead &= lead - 1)
+                if (countTrailingZeros(lead) >= 13)
+                    length = std::min(length, countTrailingZeros(lead));
+        auto const taken = (1u << length) - 1;
+
+        // Each lead byte is followed by exactly the continuation bytes it announces.
+        auto const expected =
+            ((leads & taken) << 1) | (((lead3 | lead4) & taken) << 2) | ((lead4 & taken) << 3);
+        auto const ascii = ~nonAscii & ~control;
+        if (expected != (continuation & taken) || ((ascii | continuation | leads) & taken) != taken)
+            return -1;
+
+        // Lead bytes that restrict the range of the following byte.
+        auto const next = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + 1));
+        auto const restricted = [&](int lead, __m128i nextIsInvalid) {
+            return _mm_and_si128(_mm_cmpeq_epi8(batch, set(lead)), nextIsInvalid);
+        };
+        auto const invalid =
+            _mm_or_si128(_mm_or_si128(restricted(0xE0, _mm_cmplt_epi8(next, set(0xA0))),
+                                      restricted(0xED, _mm_cmpgt_epi8(next, set(0x9F)))),
+                         _mm_or_si128(restricted(0xF0, _mm_cmplt_epi8(next, set(0x90))),
+                                      restricted(0xF4, _mm_cmpgt_epi8(next, set(0x8F)))));
+        if (mask(invalid) & taken)
+            return -1;
+
+        return static_cast<int>(length);
+    }
+#endif
+} // namespace detail
+
+/// Counts the number of leading printable US-ASCII bytes (0x20..0x7E) in [begin, end).
+///
+/// The scan stops at the first C0 control byte (including ESC), at DEL, or at
+/// the first byte of a non-ASCII (UTF-8) sequence, inspecting 32 (AVX2) or
+/// 16 (SSE2, NEON) bytes per iteration where available.
+///
+/// @returns the number of bytes up to the first byte that is not printable US-ASCII.
+inline size_t scanPrintableAscii(char const* begin, char const* end) noexcept
+{
+    auto input = begin;
+
+#if defined(__AVX2__)
+    // Signed comparison: bytes >= 0x80 are negative and thus also below 0x20.
+    auto const controlBound = _mm256_set1_epi8(0x20);
+    auto const deleteChar = _mm256_set1_epi8(0x7F);
+    while (end - input >= 32)
+    {
+        auto const batch = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input));
+        auto const isControl = _mm256_cmpgt_epi8(controlBound, batch);
+        auto const isDelete = _mm256_cmpeq_epi8(batch, deleteChar);
+        auto const mask =
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(isControl, isDelete)));
+        if (mask != 0)
+            return static_cast<size_t>(input - begin) + detail::countTrailingZeros(mask);
+        input += 32;
+    }
+#endif
+
+#if defined(__SSE2__) || defined(__aarch64__)
+    auto const controlBound16 = _mm_set1_epi8(0x20);
+    auto const deleteChar16 = _mm_set1_epi8(0x7F);
+    while (end - input >= 16)
+    {
+        auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+        auto const isControl = _mm_cmplt_epi8(batch, controlBound16);
+        auto const isDelete = _mm_cmpeq_epi8(batch, deleteChar16);
+        auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(isControl, isDelete)));
+        if (mask != 0)
+            return static_cast<size_t>(input - begin) + detail::countTrailingZeros(mask);
+        input += 16;
+    }
+#endif
+
+    while (input != end && detail::isPrintableAscii(static_cast<uint8_t>(*input)))
+        ++input;
+
+    return static_cast<size_t>(input - begin);
+}
+
+/// Counts the number of leading bytes in [begin, end) that make up a control sequence's parameter
+/// string, i.e. the digits 0-9 and the separators ':' and ';' (0x30..0x3B), inspecting 16 bytes
+/// (SSE2, NEON) per iteration where available.
+inline size_t scanParameterBytes(char const* begin, char const* end) noexcept
+{
+    auto input = begin;
+
+#if defined(__SSE2__) || defined(__aarch64__)
+    // Signed comparison: bytes >= 0x80 are negative and thus also below 0x30.
+    auto const lowerBound = _mm_set1_epi8(0x2F);
+    auto const upperBound = _mm_set1_epi8(0x3C);
+    while (end - input >= 16)
+    {
+        auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+        auto const isParameter =
+            _mm_and_si128(_mm_cmpgt_epi8(batch, lowerBound), _mm_cmplt_epi8(batch, upperBound));
+        auto const mask = ~static_cast<uint32_t>(_mm_movemask_epi8(isParameter)) & 0xFFFFu;
+        if (mask != 0)
+            return static_cast<size_t>(input - begin) + detail::countTrailingZeros(mask);
+        input += 16;
+    }
+#endif
+
+    while (input != end && detail::isParameterByte(static_cast<uint8_t>(*input)))
+        ++input;
+
+    return static_cast<size_t>(input - begin);
+}
+
+/// Outcome of decodeUtf8Text().
+struct Utf8DecodeResult
+{
+    size_t byteCount;
+    size_t codepointCount;
+};
+
+/// Decodes the leading run of printable UTF-8 text in [begin, end) into @p output,
+/// which must have room for (end - begin) codepoints.
+///
+/// The run ends at the first C0 control byte, at the first invalid or incomplete UTF-8 sequence
+/// (see detail::decodeUtf8Sequence), or in front of 16 bytes of US-ASCII, which scanPrintableAscii()
+/// takes on faster. Where available, the text is validated 16 bytes (SSE2, NEON) per iteration,
+/// and then decoded without any further checks.
+inline Utf8DecodeResult decodeUtf8Text(char const* begin, char const* end, char32_t* output) noexcept
+{
+    auto input = begin;
+    auto const outputBegin = output;
+
+    while (input != end)
+    {
+#if defined(__SSE2__) || defined(__aarch64__)
+        if (end - input > 16)
+        {
+            auto const length = detail::validateUtf8Batch(input);
+            if (length == 0)
+                break; // a control byte
+            if (length > 0)
+            {
+                output = detail::decodeValidUtf8(input, static_cast<size_t>(length), output);
+                input += length;
+                if (length < 16 && static_cast<uint8_t>(*input) < 0x20)
+                    break;
+                continue;
+            }
+            if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(input))) == 0)
+                break; // US-ASCII only
+        }
+#endif
+
+        // One sequence at a time, e.g. in front of an invalid one, or at the end of the input.
+        auto const ch = static_cast<uint8_t>(*input);
+        if (ch < 0x20)
+            break;
+        if (ch < 0x80)
+        {
+            *output++ = ch;
+            ++input;
+            continue;
+        }
+        auto codepoint = char32_t { 0 };
+        auto const length = detail::decodeUtf8Sequence(input, end, codepoint);
+        if (!length)
+            break;
+        *output++ = codepoint;
+        input += length;
+    }
+
+    return { static_cast<size_t>(input - begin), static_cast<size_t>(output - outputBegin) };
+}
+
+} // namespace terminal::parser
@@ -13,11 +13,20 @@
  */
 #include <terminal/Parser.h>
 #include <terminal/ParserEvents.h>
+#include <terminal/ParserScanner.h>
+
+#include <crispy/escape.h>
 
 #include <unicode/convert.h>
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <random>
+#include <string>
+
 using namespace std;
 using namespace terminal;
 
@@ -27,18 +36,33 @@ class MockParserEvents: public terminal::BasicParserEvents
     std::string text;
     std::string apc;
     std::string pm;
+    std::string osc;
+    std::string csi;
 
     void error(string_view const& _msg) override { INFO(fmt::format("Parser error received. {}", _msg)); }
     void print(char ch) override { text += ch; }
     void print(std::string_view s, size_t /*cellCount*/) override { text += s; }
+    void print(std::u32string_view s) override { text += unicode::convert_to<char>(s); }
 
     void startAPC() override { apc += "{"; }
     void putAPC(char ch) override { apc += ch; }
     void dispatchAPC() override { apc += "}"; }
 
+    void startOSC() override { osc += "{"; }
+    void putOSC(char ch) override { osc += ch; }
+    void putOSC(std::string_view s) override { osc += s; }
+    void dispatchOSC() override { osc += "}"; }
+
     void startPM() override { pm += "{"; }
     void putPM(char ch) override { pm += ch; }
     void dispatchPM() override { pm += "}"; }
+
+    void collectLeader(char ch) override { csi += ch; }
+    void collect(char ch) override { csi += ch; }
+    void paramDigit(char ch) override { csi += ch; }
+    void paramSeparator() override { csi += ';'; }
+    void paramSubSeparator() override { csi += ':'; }
+    void dispatchCSI(char ch) override { csi += fmt::format("{}|", ch); }
 };
 
 TEST_CASE("Parser.utf8_single", "[Parser]")
@@ -73,3 +97,216 @@ TEST_CASE("Parser.APC")
     REQUIRE(listener.apc == "{Gi=1,a=q;}");
     REQUIRE(listener.text == "ABCDEF");
 }
+
+TEST_CASE("Parser.scanPrintableAscii", "[Parser]")
+{
+    // Place each kind of stop byte at every position of buffers of various lengths
+    // in order to exercise the vectorized as well as the scalar tail loop.
+    for (size_t length = 0; length < 80; ++length)
+    {
+        for (size_t pos = 0; pos <= length; ++pos)
+        {
+            for (char const stopByte: { '\x00', '\x07', '\x1B', '\x1F', '\x7F', '\x80', '\xC3', '\xFF' })
+            {
+                auto text = std::string(length, 'A');
+                if (pos < length)
+                    text[pos] = stopByte;
+                auto const count = parser::scanPrintableAscii(text.data(), text.data() + text.size());
+                INFO(fmt::format("length {}, position {}, stop byte 0x{:02X}",
+                                 length,
+                                 pos,
+                                 static_cast<unsigned>(static_cast<uint8_t>(stopByte))));
+                CHECK(count == pos);
+            }
+        }
+    }
+}
+
+TEST_CASE("Parser.scanParameterBytes", "[Parser]")
+{
+    for (size_t length = 0; length < 80; ++length)
+    {
+        for (size_t pos = 0; pos <= length; ++pos)
+        {
+            for (char const stopByte: { '\x00', '\x1B', ' ', '/', '<', '?', 'm', '\x7F', '\x80', '\xFF' })
+            {
+                auto text = std::string {};
+                for (size_t i = 0; i < length; ++i)
+                    text += "0123456789:;"[i % 12];
+                if (pos < length)
+                    text[pos] = stopByte;
+                auto const count = parser::scanParameterBytes(text.data(), text.data() + text.size());
+                INFO(fmt::format("length {}, position {}, stop byte 0x{:02X}",
+                                 length,
+                                 pos,
+                                 static_cast<unsigned>(static_cast<uint8_t>(stopByte))));
+                CHECK(count == pos);
+            }
+        }
+    }
+}
+
+TEST_CASE("Parser.decodeUtf8Text", "[Parser]")
+{
+    // Valid and invalid pieces of text, combined at random into buffers of various lengths
+    // in order to exercise the vectorized as well as the scalar decoding.
+    auto const pieces = std::array {
+        "A"sv,
+        "0123456789abcdef"sv,
+        "\x7F"sv,
+        "\r\n"sv,
+        "\033"sv,
+        "\xC3\xB6"sv,
+        "\xE2\x82\xAC"sv,
+        "\xE6\x97\xA5"sv,
+        "\xED\x9F\xBF"sv,      // highest below the surrogates
+        "\xE0\xA0\x80"sv,      // lowest 3-byte sequence
+        "\xF0\x90\x80\x80"sv,  // lowest 4-byte sequence
+        "\xF4\x8F\xBF\xBF"sv,  // U+10FFFF
+        "\x80"sv,              // stray continuation byte
+        "\xC0\x80"sv,          // overlong
+        "\xC3"sv,              // incomplete
+        "\xE2\x82"sv,          // incomplete
+        "\xE0\x9F\xBF"sv,      // overlong
+        "\xED\xA0\x80"sv,      // surrogate
+        "\xF0\x8F\xBF\xBF"sv,  // overlong
+        "\xF4\x90\x80\x80"sv,  // beyond U+10FFFF
+        "\xF5\x80\x80\x80"sv,  // beyond U+10FFFF
+    };
+
+    // Decodes one sequence after another, or nothing at all if any of them is invalid.
+    auto const decodeStrictly = [](std::string_view _text) -> std::optional<std::u32string> {
+        auto decoded = std::u32string {};
+        for (size_t i = 0; i < _text.size();)
+        {
+            auto const ch = static_cast<uint8_t>(_text[i]);
+            auto codepoint = char32_t { ch };
+            auto const length = ch < 0x80 ? size_t { ch >= 0x20 }
+                                          : parser::detail::decodeUtf8Sequence(
+                                              _text.data() + i, _text.data() + _text.size(), codepoint);
+            if (!length)
+                return std::nullopt;
+            decoded += codepoint;
+            i += length;
+        }
+        return decoded;
+    };
+
+    auto random = std::mt19937 { 42 };
+    for (int round = 0; round < 20000; ++round)
+    {
+        auto text = std::string {};
+        for (auto n = random() % 24; n != 0; --n)
+            text += pieces[random() % pieces.size()];
+
+        auto output = std::u32string(text.size(), U'\0');
+        auto const [byteCount, codepointCount] =
+            parser::decodeUtf8Text(text.data(), text.data() + text.size(), output.data());
+        output.resize(codepointCount);
+        INFO(crispy::escape(text));
+        INFO(byteCount);
+
+        // Exactly the text that can be decoded is decoded.
+        auto const expected = decodeStrictly(text.substr(0, byteCount));
+        REQUIRE(expected.has_value());
+        CHECK(output == *expected);
+
+        // The run ends in front of a control byte, an invalid sequence, or plenty of US-ASCII.
+        if (byteCount < text.size())
+        {
+            auto const rest = std::string_view(text).substr(byteCount);
+            auto const isAscii = [](char ch) {
+                return static_cast<uint8_t>(ch) < 0x80;
+            };
+            auto const prefixLength = std::min(rest.size(), size_t { 4 });
+            auto validPrefix = false;
+            for (size_t length = 1; length <= prefixLength; ++length)
+                validPrefix = validPrefix || decodeStrictly(rest.substr(0, length)).has_value();
+            auto const plentyOfAscii =
+                rest.size() > 16 && std::all_of(rest.begin(), rest.begin() + 16, isAscii);
+            CHECK((!validPrefix || plentyOfAscii));
+        }
+    }
+}
+
+TEST_CASE("Parser.vectorizedScan", "[Parser]")
+{
+    auto const input = "Hello, World! 0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n"
+                       "\033]2;some window title that is longer than sixteen bytes\033\\"
+                       "\033_Gi=1,a=q,f=32,s=1,v=1;AAAAAAAAAAAAAAAAAAAAAAAA\033\\"
+                       "\033^private message payload \xE2\x9C\x85 spanning a few vector widths\033\\"
+                       "Trailing text with UTF-8 \xC3\xB6 in it."sv;
+
+    auto const parseWith = [&](bool vectorized) {
+        MockParserEvents listener;
+        auto p = parser::Parser(listener);
+        p.vectorizedScan = vectorized;
+        p.maxCharCount = 20;
+        p.parseFragment(input);
+        CHECK(p.state() == parser::State::Ground);
+        return std::tuple { listener.text, listener.osc, listener.apc, listener.pm };
+    };
+
+    auto const [text, osc, apc, pm] = parseWith(true);
+    CHECK(osc == "{2;some window title that is longer than sixteen bytes}");
+    CHECK(apc == "{Gi=1,a=q,f=32,s=1,v=1;AAAAAAAAAAAAAAAAAAAAAAAA}");
+    CHECK(pm == "{private message payload \xE2\x9C\x85 spanning a few vector widths}");
+    CHECK(parseWith(false) == std::tuple { text, osc, apc, pm });
+}
+
+TEST_CASE("Parser.controlSequences", "[Parser]")
+{
+    // Control sequences parsed at once as well as byte by byte, including malformed ones.
+    auto const input = "\033[mA"
+                       "\033[38;2;255;128;0;48:2::0:64:255;1;3;4;9;53mB"
+                       "\033[?1049h\033[>4;2m\033[2 q\033[=c"
+                       "\033[:5mC\033[?1;?2hD\033[1 2mE"
+                       "\033[1;2\r3H\033[1\x7F;2H\033[3\033[4mF"
+                       "\033[0123456789;0123456789:0123456789;1;2;3;4;5;6;7;8;9;10;11;12;13;14X"sv;
+
+    auto const parse = [](std::string_view _input, bool _vectorized, size_t _fragmentSize) {
+        MockParserEvents listener;
+        auto p = parser::Parser(listener);
+        p.vectorizedScan = _vectorized;
+        p.maxCharCount = 80;
+        for (size_t i = 0; i < _input.size(); i += _fragmentSize)
+            p.parseFragment(_input.substr(i, _fragmentSize));
+        CHECK(p.state() == parser::State::Ground);
+        return std::pair { listener.csi, listener.text };
+    };
+
+    auto const expected = parse(input, false, 1);
+    CHECK(expected.second == "ABCDEF");
+    for (size_t fragmentSize = 1; fragmentSize <= input.size(); ++fragmentSize)
+    {
+        INFO(fmt::format("fragment size {}", fragmentSize));
+        CHECK(parse(input, true, fragmentSize) == expected);
+    }
+}
+
+TEST_CASE("Parser.ParserDispatchTable", "[Parser]")
+{
+    static constexpr auto table = parser::ParserTable::get();
+    static constexpr auto dispatchTable = parser::ParserDispatchTable::build(table);
+
+    CHECK(dispatchTable.byteClassCount <= parser::ParserDispatchTable::MaxByteClasses);
+
+    for (auto state = std::numeric_limits<parser::State>::min();
+         state <= std::numeric_limits<parser::State>::max();
+         ++state)
+    {
+        auto const s = static_cast<size_t>(state);
+        for (unsigned input = 0; input < 256; ++input)
+        {
+            INFO(fmt::format("state {}, input 0x{:02X}", state, input));
+            auto const& t = dispatchTable.at(state, static_cast<uint8_t>(input));
+            CHECK(t.event == table.events[s][input]);
+            CHECK(t.target == table.transitions[s][input]);
+            if (t.target != parser::State::Undefined)
+            {
+                CHECK(t.exit == table.exitEvents[s]);
+                CHECK(t.entry == table.entryEvents[static_cast<size_t>(t.target)]);
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PngDecoder.h>
+
+#if defined(LIBTERMINAL_PNG)
+    #include <png.h>
+#endif
+
+#include <cstdint>
+
+using std::nullopt;
+using std::optional;
+using std::string_view;
+
+namespace terminal
+{
+
+namespace
+{
+    uint32_t readBigEndian32(string_view _data, size_t _offset) noexcept
+    {
+        auto const byte = [&](size_t i) {
+            return static_cast<uint32_t>(static_cast<uint8_t>(_data[_offset + i]));
+        };
+        return (byte(0) << 24) | (byte(1) << 16) | (byte(2) << 8) | byte(3);
+    }
+} // namespace
+
+bool isPngSupported() noexcept
+{
+#if defined(LIBTERMINAL_PNG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+optional<ImageSize> pngImageSize(string_view _data) noexcept
+{
+    // The signature is followed by the IHDR chunk: length, type, width, height, ...
+    auto constexpr Signature = string_view("\x89PNG\r\n\x1a\n", 8);
+    auto constexpr HeaderSize = 8 + 4 + 4 + 4 + 4;
+
+    if (_data.size() < HeaderSize || _data.substr(0, 8) != Signature || _data.substr(12, 4) != "IHDR")
+        return nullopt;
+
+    auto const width = readBigEndian32(_data, 16);
+    auto const height = readBigEndian32(_data, 20);
+    if (!width || !height || width > 0x7FFFFFFF || height > 0x7FFFFFFF)
+        return nullopt;
+
+    return ImageSize { Width::cast_from(width), Height::cast_from(height) };
+}
+
+optional<Image::Data> decodePng(string_view _data, ImageSize _size)
+{
+#if defined(LIBTERMINAL_PNG)
+    auto image = png_image {};
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&image, _data.data(), _data.size()))
+        return nullopt;
+
+    if (image.width != unbox<uint32_t>(_size.width) || image.height != unbox<uint32_t>(_size.height))
+    {
+        png_image_free(&image);
+        return nullopt;
+    }
+
+    image.format = PNG_FORMAT_RGBA;
+    auto pixels = Image::Data(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr))
+    {
+        png_image_free(&image);
+        return nullopt;
+    }
+
+    return pixels;
+#else
+    (void) _data;
+    (void) _size;
+    return nullopt;
+#endif
+}
+
+} // namespace terminal
@@ -0,0 +1,41 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Image.h>
+#include <terminal/primitives.h>
+
+#include <optional>
+#include <string_view>
+
+namespace terminal
+{
+
+/// Tells whether PNG images can be decoded, i.e. whether libterminal was built with libpng.
+bool isPngSupported() noexcept;
+
+/// Determines the size of the PNG image @p _data, by looking at its header only.
+///
+/// @returns the image size or std::nullopt if @p _data does not start like a PNG file.
+std::optional<ImageSize> pngImageSize(std::string_view _data) noexcept;
+
+/// Decodes the PNG image @p _data into RGBA pixels.
+///
+/// The pixels are written right into the returned buffer, without any intermediate copy.
+///
+/// @returns the RGBA pixels or std::nullopt if the image is broken, is not of @p _size,
+///          or PNG images are not supported.
+std::optional<Image::Data> decodePng(std::string_view _data, ImageSize _size);
+
+} // namespace terminal
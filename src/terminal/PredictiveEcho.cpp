@@ -0,0 +1,66 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PredictiveEcho.h>
+
+namespace terminal
+{
+
+void PredictiveEcho::setEnabled(bool _enabled)
+{
+    enabled_.store(_enabled, std::memory_order_relaxed);
+    if (!_enabled)
+        reset();
+}
+
+bool PredictiveEcho::predict(char32_t _codepoint,
+                             CellLocation _cursor,
+                             ColumnCount _pageWidth,
+                             Timestamp _now)
+{
+    if (!enabled())
+        return false;
+
+    auto position = _cursor;
+    if (!pending_.empty() && pending_.back().epoch == epoch_)
+    {
+        position = pending_.back().position;
+        position.column++;
+    }
+
+    // Predicting auto-wrap is not worth it, it also depends on the application's notion of the line.
+    if (position.column >= boxed_cast<ColumnOffset>(_pageWidth))
+    {
+        newEpoch();
+        return false;
+    }
+
+    pending_.emplace_back(Prediction { position, _codepoint, _now, epoch_ });
+    return true;
+}
+
+void PredictiveEcho::reset()
+{
+    pending_.clear();
+    newEpoch();
+}
+
+std::optional<PredictiveEcho::Duration> PredictiveEcho::nextTimeout(Timestamp _now) const noexcept
+{
+    if (pending_.empty())
+        return std::nullopt;
+
+    return std::max(Duration::zero(), pending_.front().time + Timeout - _now);
+}
+
+} // namespace terminal
@@ -0,0 +1,133 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/primitives.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace terminal
+{
+
+/**
+ * Predicts the echo of typed characters, to hide the round trip time of high-latency sessions.
+ *
+ * Similar to mosh, each printable key press is tentatively predicted to be echoed at the cursor,
+ * or right after the previous prediction. Predictions are reconciled with the screen contents
+ * as PTY output arrives: a prediction is confirmed once the predicted character shows up at its
+ * position, and all predictions are rolled back as soon as a different character shows up there,
+ * or if the echo does not show up in time.
+ *
+ * Predictions are only shown once an echo of their epoch of typing has been confirmed.
+ * A new epoch starts with every key whose echo cannot be predicted (such as Enter),
+ * so that for example the password typed into a freshly appearing prompt is never shown.
+ *
+ * Predictions are made from the input thread and reconciled from the terminal's I/O thread,
+ * both with the terminal lock held. Only enabled() may be tested without holding it.
+ */
+class PredictiveEcho
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Timestamp = Clock::time_point;
+    using Duration = Clock::duration;
+
+    /// Time after which a prediction whose echo did not show up is considered wrong.
+    static constexpr Duration Timeout = std::chrono::seconds(1);
+
+    struct Prediction
+    {
+        CellLocation position;
+        char32_t codepoint = 0;
+        Timestamp time;
+        uint64_t epoch = 0;
+    };
+
+    void setEnabled(bool _enabled);
+    [[nodiscard]] bool enabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /// Predicts the echo of @p _codepoint, right after the pending predictions of the current epoch,
+    /// or at @p _cursor if there are none.
+    ///
+    /// @returns true if the prediction has been made, false if the echo would not fit into the line,
+    ///          in which case a new epoch is started.
+    bool predict(char32_t _codepoint, CellLocation _cursor, ColumnCount _pageWidth, Timestamp _now);
+
+    /// Starts a new epoch, keeping the pending predictions.
+    void newEpoch() noexcept { ++epoch_; }
+
+    /// Drops all pending predictions and starts a new epoch.
+    void reset();
+
+    /// Reconciles the pending predictions with the screen contents.
+    ///
+    /// @param _codepointAt returns the codepoint at the given screen position, or 0 if the cell is empty.
+    template <typename CodepointAt>
+    void reconcile(CodepointAt const& _codepointAt, Timestamp _now);
+
+    /// Tests whether the given pending prediction is to be shown.
+    [[nodiscard]] bool visible(Prediction const& _prediction) const noexcept
+    {
+        return _prediction.epoch <= confirmedEpoch_;
+    }
+
+    /// Tests whether there are any predictions to be shown.
+    [[nodiscard]] bool visible() const noexcept { return !pending_.empty() && visible(pending_.front()); }
+
+    [[nodiscard]] std::deque<Prediction> const& predictions() const noexcept { return pending_; }
+
+    /// Returns the time left until the oldest pending prediction times out, if any.
+    [[nodiscard]] std::optional<Duration> nextTimeout(Timestamp _now) const noexcept;
+
+    [[nodiscard]] uint64_t confirmedCount() const noexcept { return confirmedCount_; }
+    [[nodiscard]] uint64_t rolledBackCount() const noexcept { return rolledBackCount_; }
+
+  private:
+    std::atomic<bool> enabled_ = false;
+    uint64_t epoch_ = 1;
+    uint64_t confirmedEpoch_ = 0; // most recent epoch with a confirmed prediction
+    std::deque<Prediction> pending_;
+    uint64_t confirmedCount_ = 0;
+    uint64_t rolledBackCount_ = 0;
+};
+
+template <typename CodepointAt>
+void PredictiveEcho::reconcile(CodepointAt const& _codepointAt, Timestamp _now)
+{
+    while (!pending_.empty())
+    {
+        auto const& prediction = pending_.front();
+        auto const actual = _codepointAt(prediction.position);
+        if (actual == prediction.codepoint)
+        {
+            confirmedEpoch_ = std::max(confirmedEpoch_, prediction.epoch);
+            pending_.pop_front();
+            ++confirmedCount_;
+        }
+        else if (actual != 0 || _now - prediction.time >= Timeout)
+        {
+            rolledBackCount_ += pending_.size();
+            reset();
+        }
+        else
+            break;
+    }
+}
+
+} // namespace terminal
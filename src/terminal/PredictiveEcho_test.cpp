@@ -0,0 +1,175 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PredictiveEcho.h>
+
+#include <catch2/catch.hpp>
+
+#include <map>
+
+using namespace std::chrono_literals;
+using namespace terminal;
+
+namespace
+{
+auto const T0 = PredictiveEcho::Timestamp {} + 1h;
+
+// Minimal stand-in for the screen contents that predictions are reconciled with.
+struct FakeScreen
+{
+    std::map<std::pair<int, int>, char32_t> cells;
+
+    void write(CellLocation _pos, char32_t _codepoint)
+    {
+        cells[{ unbox<int>(_pos.line), unbox<int>(_pos.column) }] = _codepoint;
+    }
+
+    char32_t operator()(CellLocation _pos) const
+    {
+        auto const i = cells.find({ unbox<int>(_pos.line), unbox<int>(_pos.column) });
+        return i != cells.end() ? i->second : 0;
+    }
+};
+
+CellLocation at(int _line, int _column)
+{
+    return CellLocation { LineOffset(_line), ColumnOffset(_column) };
+}
+} // namespace
+
+TEST_CASE("PredictiveEcho.disabled", "[PredictiveEcho]")
+{
+    auto echo = PredictiveEcho {};
+    CHECK_FALSE(echo.predict(U'a', at(0, 0), ColumnCount(80), T0));
+    CHECK(echo.predictions().empty());
+}
+
+TEST_CASE("PredictiveEcho.confirm", "[PredictiveEcho]")
+{
+    auto echo = PredictiveEcho {};
+    echo.setEnabled(true);
+    auto screen = FakeScreen {};
+
+    // Nothing is shown until the echo of the current epoch has been confirmed.
+    REQUIRE(echo.predict(U'l', at(2, 5), ColumnCount(80), T0));
+    CHECK_FALSE(echo.visible());
+
+    screen.write(at(2, 5), U'l');
+    echo.reconcile(screen, T0 + 100ms);
+    CHECK(echo.predictions().empty());
+    CHECK(echo.confirmedCount() == 1);
+
+    // Subsequent predictions are placed at the cursor, then after each other, and shown right away.
+    REQUIRE(echo.predict(U's', at(2, 6), ColumnCount(80), T0 + 200ms));
+    REQUIRE(echo.predict(U' ', at(2, 6), ColumnCount(80), T0 + 210ms));
+    CHECK(echo.visible());
+    REQUIRE(echo.predictions().size() == 2);
+    CHECK(echo.predictions()[1].position == at(2, 7));
+
+    // A partial echo confirms only what has arrived.
+    screen.write(at(2, 6), U's');
+    echo.reconcile(screen, T0 + 300ms);
+    REQUIRE(echo.predictions().size() == 1);
+    CHECK(echo.predictions()[0].codepoint == U' ');
+    CHECK(echo.visible());
+}
+
+TEST_CASE("PredictiveEcho.rollback", "[PredictiveEcho]")
+{
+    auto echo = PredictiveEcho {};
+    echo.setEnabled(true);
+    auto screen = FakeScreen {};
+
+    REQUIRE(echo.predict(U'a', at(0, 0), ColumnCount(80), T0));
+    screen.write(at(0, 0), U'a');
+    echo.reconcile(screen, T0);
+
+    SECTION("mismatch")
+    {
+        REQUIRE(echo.predict(U'b', at(0, 1), ColumnCount(80), T0));
+        REQUIRE(echo.predict(U'c', at(0, 1), ColumnCount(80), T0));
+        screen.write(at(0, 1), U'B');
+        echo.reconcile(screen, T0 + 10ms);
+        CHECK(echo.predictions().empty());
+        CHECK(echo.rolledBackCount() == 2);
+
+        // The next epoch must be confirmed again before predictions are shown.
+        REQUIRE(echo.predict(U'd', at(0, 2), ColumnCount(80), T0 + 20ms));
+        CHECK_FALSE(echo.visible());
+    }
+
+    SECTION("timeout")
+    {
+        REQUIRE(echo.predict(U'b', at(0, 1), ColumnCount(80), T0));
+        CHECK(echo.nextTimeout(T0 + 400ms) == PredictiveEcho::Timeout - 400ms);
+
+        echo.reconcile(screen, T0 + PredictiveEcho::Timeout - 1ms);
+        CHECK(echo.visible());
+
+        echo.reconcile(screen, T0 + PredictiveEcho::Timeout);
+        CHECK(echo.predictions().empty());
+        CHECK(echo.rolledBackCount() == 1);
+        CHECK_FALSE(echo.nextTimeout(T0 + PredictiveEcho::Timeout).has_value());
+    }
+
+    SECTION("end of line")
+    {
+        REQUIRE(echo.predict(U'x', at(0, 78), ColumnCount(80), T0));
+        REQUIRE(echo.predict(U'y', at(0, 78), ColumnCount(80), T0));
+        CHECK_FALSE(echo.predict(U'z', at(0, 78), ColumnCount(80), T0));
+        CHECK(echo.predictions().size() == 2);
+
+        // Typing continues in a new epoch, at the cursor.
+        REQUIRE(echo.predict(U'z', at(1, 0), ColumnCount(80), T0));
+        CHECK(echo.predictions().back().position == at(1, 0));
+        CHECK_FALSE(echo.visible(echo.predictions().back()));
+    }
+
+    SECTION("reset")
+    {
+        REQUIRE(echo.predict(U'b', at(0, 1), ColumnCount(80), T0));
+        CHECK(echo.visible());
+        echo.reset();
+        CHECK(echo.predictions().empty());
+        REQUIRE(echo.predict(U'c', at(0, 1), ColumnCount(80), T0));
+        CHECK_FALSE(echo.visible());
+    }
+}
+
+TEST_CASE("PredictiveEcho.newEpoch", "[PredictiveEcho]")
+{
+    auto echo = PredictiveEcho {};
+    echo.setEnabled(true);
+    auto screen = FakeScreen {};
+
+    REQUIRE(echo.predict(U'l', at(0, 2), ColumnCount(80), T0));
+    screen.write(at(0, 2), U'l');
+    echo.reconcile(screen, T0);
+    REQUIRE(echo.predict(U's', at(0, 3), ColumnCount(80), T0));
+
+    // Pressing Enter keeps the pending predictions, but hides the ones typed after it.
+    echo.newEpoch();
+    REQUIRE(echo.predict(U'x', at(1, 0), ColumnCount(80), T0));
+    REQUIRE(echo.predictions().size() == 2);
+    CHECK(echo.visible(echo.predictions()[0]));
+    CHECK_FALSE(echo.visible(echo.predictions()[1]));
+
+    // The first confirmed echo of the new epoch reveals the rest of it.
+    REQUIRE(echo.predict(U'y', at(1, 0), ColumnCount(80), T0));
+    CHECK(echo.predictions().back().position == at(1, 1));
+    screen.write(at(0, 3), U's');
+    screen.write(at(1, 0), U'x');
+    echo.reconcile(screen, T0 + 100ms);
+    REQUIRE(echo.predictions().size() == 1);
+    CHECK(echo.visible());
+}
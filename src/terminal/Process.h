@@ -102,6 +102,7 @@ class [[nodiscard]] Process: public Pty
     void wakeupReader() override { return pty().wakeupReader(); }
     int write(char const* buf, size_t size) override { return pty().write(buf, size); }
     PageSize pageSize() const noexcept override { return pty().pageSize(); }
+    bool echoDisabled() const noexcept override { return pty().echoDisabled(); }
     void resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels = std::nullopt) override { pty().resizeScreen(_cells, _pixels); }
     // clang-format on
 
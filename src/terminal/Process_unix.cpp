@@ -50,8 +50,17 @@
     #include <pty.h>
 #endif
 
+#if defined(__GLIBC__)
+    #if __GLIBC_PREREQ(2, 34)
+        // glibc spawns through a shared address space (like vfork) and has all the extensions we need.
+        #define LIBTERMINAL_POSIX_SPAWN 1
+        #include <spawn.h>
+    #endif
+#endif
+
 #include <csignal>
 
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
 
@@ -106,6 +115,96 @@ namespace
         while (dup2(a, b) == -1 && (errno == EBUSY || errno == EINTR))
             ;
     }
+
+#if defined(LIBTERMINAL_POSIX_SPAWN)
+    /// Spawns the process without duplicating our own address space, as fork() does,
+    /// which gets slower the more memory (sessions, GPU mappings) the terminal has.
+    ///
+    /// The child becomes a session leader (POSIX_SPAWN_SETSID), so that opening the PTY slave
+    /// as its standard input makes it the controlling terminal.
+    ///
+    /// @returns the child's PID, or -1 with errno set if it could not be spawned.
+    pid_t spawnProcess(string const& _path,
+                       vector<string> const& _args,
+                       string const& _cwd,
+                       vector<string> const& _env,
+                       SystemPty& _pty)
+    {
+        char slaveName[128];
+        if (ptsname_r(unbox<int>(_pty.handle()), slaveName, sizeof(slaveName)) != 0)
+            return -1;
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, slaveName, O_RDWR, 0);
+        posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO);
+        auto const hasFastPipe = _pty.stdoutFastPipe().writer() != -1;
+        if (hasFastPipe)
+            posix_spawn_file_actions_adddup2(&actions, _pty.stdoutFastPipe().writer(), StdoutFastPipeFd);
+        if (!_cwd.empty())
+            posix_spawn_file_actions_addchdir_np(&actions, _cwd.c_str());
+        // Without a fast pipe, the descriptor it would have taken is closed as well.
+        posix_spawn_file_actions_addclosefrom_np(&actions,
+                                                 hasFastPipe ? StdoutFastPipeFd + 1 : StdoutFastPipeFd);
+
+        // reset signal(s) to default that may have been changed in the parent process.
+        sigset_t defaultSignals;
+        sigemptyset(&defaultSignals);
+        sigaddset(&defaultSignals, SIGPIPE);
+        sigset_t signalMask;
+        sigemptyset(&signalMask);
+
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        posix_spawnattr_setflags(&attributes,
+                                 POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+        posix_spawnattr_setsigdefault(&attributes, &defaultSignals);
+        posix_spawnattr_setsigmask(&attributes, &signalMask);
+
+        auto argv = vector<char*> {};
+        argv.push_back(const_cast<char*>(_path.c_str()));
+        for (auto const& arg: _args)
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        auto envp = vector<char*> {};
+        for (auto const& entry: _env)
+            envp.push_back(const_cast<char*>(entry.c_str()));
+        envp.push_back(nullptr);
+
+        pid_t pid = -1;
+        auto const rv = posix_spawnp(&pid, argv[0], &actions, &attributes, argv.data(), envp.data());
+
+        posix_spawnattr_destroy(&attributes);
+        posix_spawn_file_actions_destroy(&actions);
+
+        if (rv != 0)
+        {
+            errno = rv;
+            return -1;
+        }
+        return pid;
+    }
+
+    /// Constructs the child's environment: ours, with the given variables added or replaced.
+    vector<string> childEnvironment(Process::Environment const& _env, bool _stdoutFastPipe)
+    {
+        auto result = vector<string> {};
+        for (char** entry = environ; *entry; ++entry)
+        {
+            auto const definition = string_view(*entry);
+            auto const name = string(definition.substr(0, definition.find('=')));
+            if (!_env.count(name) && !(_stdoutFastPipe && name == StdoutFastPipeEnvironmentName))
+                result.emplace_back(definition);
+        }
+        for (auto&& [name, value]: _env)
+            result.emplace_back(fmt::format("{}={}", name, value));
+        if (_stdoutFastPipe)
+            result.emplace_back(fmt::format("{}={}", StdoutFastPipeEnvironmentName, StdoutFastPipeFd));
+        return result;
+    }
+#endif
 } // anonymous namespace
 
 struct Process::Private
@@ -125,21 +224,41 @@ Process::Process(string const& _path,
                  unique_ptr<Pty> _pty):
     d(new Private {}, [](Private* p) { delete p; })
 {
+#if defined(LIBTERMINAL_POSIX_SPAWN)
+    if (auto* pty = dynamic_cast<SystemPty*>(_pty.get()); pty && !isFlatpak())
+    {
+        // Terminal settings belong to the device, so they can be applied from here.
+        (void) pty->slave().configure();
+
+        auto const env = childEnvironment(_env, true);
+        d->pid = spawnProcess(_path, _args, _cwd.generic_string(), env, *pty);
+        if (d->pid != -1)
+        {
+            d->pty = move(_pty);
+            pty->slave().close();
+            pty->stdoutFastPipe().closeWriter();
+            pty->watchChildProcess(d->pid);
+            return;
+        }
+        // Let the forked child report the failure and try the login shell.
+    }
+#endif
+
     d->pid = fork();
     d->pty = move(_pty);
 
-    UnixPipe* stdoutFastPipe = [this]() -> UnixPipe* {
-        if (auto* p = dynamic_cast<SystemPty*>(d->pty.get()))
-            return &p->stdoutFastPipe();
-        return nullptr;
-    }();
+    auto* const systemPty = dynamic_cast<SystemPty*>(d->pty.get());
+    UnixPipe* stdoutFastPipe = systemPty ? &systemPty->stdoutFastPipe() : nullptr;
 
     switch (d->pid)
     {
         default: // in parent
             d->pty->slave().close();
-            if (stdoutFastPipe)
-                stdoutFastPipe->closeWriter();
+            if (systemPty)
+            {
+                systemPty->stdoutFastPipe().closeWriter();
+                systemPty->watchChildProcess(d->pid);
+            }
             break;
         case -1: // fork error
             throw runtime_error { getLastErrorAsString() };
@@ -188,19 +307,21 @@ Process::Process(string const& _path,
                 return createArgv("/usr/bin/flatpak-spawn", realArgs, 0);
             }();
 
+            auto firstLeakedFd = StdoutFastPipeFd;
             if (auto pty = dynamic_cast<SystemPty*>(d->pty.get()))
             {
                 if (pty->stdoutFastPipe().writer() != -1)
                 {
                     saveDup2(pty->stdoutFastPipe().writer(), StdoutFastPipeFd);
                     pty->stdoutFastPipe().close();
+                    firstLeakedFd = StdoutFastPipeFd + 1;
                 }
             }
 
             // maybe close any leaked/inherited file descriptors from parent process
             // TODO: But be a little bit more clever in iterating only over those that are actually still
             // open.
-            for (int i = StdoutFastPipeFd + 1; i < 256; ++i)
+            for (int i = firstLeakedFd; i < 256; ++i)
                 ::close(i);
 
             // reset signal(s) to default that may have been changed in the parent process.
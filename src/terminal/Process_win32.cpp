@@ -157,7 +157,7 @@ struct Process::Private
     mutable HANDLE pid {};
     mutable std::mutex exitStatusMutex {};
     mutable std::optional<Process::ExitStatus> exitStatus {};
-    std::optional<std::thread> exitWatcher;
+    HANDLE exitWait {}; // registered with the thread pool's wait threads, each waiting on up to 63 objects
 
     std::unique_ptr<Pty> pty {};
 
@@ -221,11 +221,16 @@ Process::Process(string const& _path,
     if (!success)
         throw runtime_error { "Could not create process. "s + getLastErrorAsString() };
 
-    d->exitWatcher = std::thread([this]() {
-        wait();
-        PtyLog()("Process terminated with exit code {}.", checkStatus().value());
-        d->pty->close();
-    });
+    // Rather than one thread per process, the system's wait threads (WaitForMultipleObjects)
+    // watch the processes of all sessions for exit.
+    auto const onExit = [](void* _process, BOOLEAN /*_timedOut*/) {
+        auto& process = *static_cast<Process*>(_process);
+        PtyLog()("Process terminated with exit code {}.", process.checkStatus().value());
+        process.d->pty->close();
+    };
+    if (!RegisterWaitForSingleObject(
+            &d->exitWait, d->processInfo.hProcess, onExit, this, INFINITE, WT_EXECUTEONLYONCE))
+        throw runtime_error { "Could not watch process for exit. "s + getLastErrorAsString() };
 }
 
 Pty& Process::pty() noexcept
@@ -240,8 +245,11 @@ Pty const& Process::pty() const noexcept
 
 Process::~Process()
 {
-    if (d->exitWatcher)
-        d->exitWatcher.value().join();
+    if (d->exitWait)
+    {
+        (void) wait();
+        UnregisterWaitEx(d->exitWait, INVALID_HANDLE_VALUE); // also waits for onExit to complete
+    }
 
     CloseHandle(d->processInfo.hThread);
     CloseHandle(d->processInfo.hProcess);
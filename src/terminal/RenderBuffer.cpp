@@ -20,26 +20,32 @@
 namespace terminal
 {
 
-bool RenderDoubleBuffer::swapBuffers(std::chrono::steady_clock::time_point _now) noexcept
+RenderBufferRef RenderDoubleBuffer::frontBuffer() const
 {
-    // If the terminal thread (writer) cannot try_lock (w/o wait time)
-    // the front buffer, it'll just flush back buffer instead of swapping
-    // buffers as the front buffer is apparently still in use by the
-    // renderer thread and we want to avoid render-thread imposed
-    // wait times in the terminal thread as much as possible.
-
-    if (!readerLock.try_lock())
-        return false;
+    readerLock.lock();
 
-    auto const _l = std::lock_guard<decltype(readerLock)>(readerLock, std::adopt_lock);
-
-    for (;;)
+    if (pendingBufferIndex_.load(std::memory_order_relaxed) & FreshFrameFlag)
     {
-        auto current = currentBackBufferIndex.load();
-        if (currentBackBufferIndex.compare_exchange_weak(current, (current + 1) % 2))
-            break;
+        auto const fresh = pendingBufferIndex_.exchange(static_cast<uint8_t>(frontBufferIndex_),
+                                                        std::memory_order_acq_rel);
+        frontBufferIndex_ = fresh & ~FreshFrameFlag;
     }
 
+    return RenderBufferRef(buffers[frontBufferIndex_], readerLock, std::adopt_lock);
+}
+
+bool RenderDoubleBuffer::swapBuffers(std::chrono::steady_clock::time_point _now) noexcept
+{
+    // The back buffer becomes the pending buffer, and whatever buffer was pending before
+    // (either an unread frame or one the reader has released) becomes the new back buffer.
+    auto const previous = pendingBufferIndex_.exchange(
+        static_cast<uint8_t>(backBufferIndex_ | FreshFrameFlag), std::memory_order_acq_rel);
+    backBufferIndex_ = previous & ~FreshFrameFlag;
+
+    ++publishedFrames;
+    if (previous & FreshFrameFlag)
+        ++skippedFrames;
+
     lastUpdate = _now;
     state = RenderBufferState::WaitingForRefresh;
     return true;
@@ -19,10 +19,14 @@
 #include <terminal/Image.h>
 #include <terminal/primitives.h>
 
+#include <crispy/InstrumentedMutex.h>
+
 #include <atomic>
 #include <chrono>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace terminal
@@ -30,7 +34,8 @@ namespace terminal
 
 struct RenderCell
 {
-    std::u32string codepoints;
+    /// The cell's grapheme cluster, pointing into RenderBuffer::codepoints.
+    std::u32string_view codepoints;
     std::shared_ptr<ImageFragment> image;
     CellLocation position;
     CellFlags flags;
@@ -41,6 +46,31 @@ struct RenderCell
 
     bool groupStart = false;
     bool groupEnd = false;
+
+    /// Offset and length of this cell's grapheme cluster in RenderBuffer::codepoints.
+    uint32_t codepointOffset = 0;
+    uint32_t codepointCount = 0;
+};
+
+/// A horizontal run of cells on a single line that share their colors and flags.
+///
+/// Trivially styled lines of US-ASCII text are rendered into runs rather than into one RenderCell
+/// per column, split up only where the block cursor or the selection changes the colors.
+/// Each of the run's leading columns holds one codepoint of @c text, the remaining ones are blank.
+struct RenderRun
+{
+    /// The run's text, pointing into RenderBuffer::codepoints.
+    std::u32string_view text;
+    CellLocation start;
+    ColumnCount length;
+    CellFlags flags;
+    RGBColor foregroundColor;
+    RGBColor backgroundColor;
+    RGBColor decorationColor;
+
+    /// Offset and length of @c text in RenderBuffer::codepoints.
+    uint32_t codepointOffset = 0;
+    uint32_t codepointCount = 0;
 };
 
 struct RenderCursor
@@ -50,16 +80,85 @@ struct RenderCursor
     int width = 1;
 };
 
+/// Describes the ranges of RenderBuffer::runs and RenderBuffer::cells that a single screen line
+/// has been rendered into.
+struct RenderLine
+{
+    /// The Line<Cell>::generation() of the rendered grid line, combined with the transient state
+    /// drawn into it (block cursor, selection), or 0 if the line must not be reused.
+    ///
+    /// Moving the cursor or the selection thus only changes the keys of the lines concerned.
+    uint64_t generation = 0;
+    size_t cellOffset = 0;
+    size_t cellCount = 0;
+    size_t runOffset = 0;
+    size_t runCount = 0;
+};
+
+/// Text of a line right outside of the viewport, in the direction it is being scrolled to,
+/// to be shaped by the renderer before the line scrolls in (see RenderBuffer::prefetchRuns).
+///
+/// Each column takes one codepoint, U+0020 for those not holding exactly one.
+struct PrefetchRun
+{
+    /// Offset and length of the run's text in RenderBuffer::prefetchText.
+    size_t textOffset = 0;
+    size_t textLength = 0;
+
+    CellFlags flags {};
+};
+
 struct RenderBuffer
 {
     std::vector<RenderCell> cells {};
+    std::vector<RenderRun> runs {};
     std::optional<RenderCursor> cursor {};
     uint64_t frameID {};
 
+    /// Storage of all grapheme clusters of @c cells and the text of @c runs, in line order.
+    ///
+    /// Sharing one buffer across all cells avoids an allocation per cell, and as its
+    /// capacity carries over to the next frame, refreshing the buffer is allocation free once warmed up.
+    std::vector<char32_t> codepoints {};
+
+    /// Run and cell ranges of each screen line, indexed by screen line offset.
+    ///
+    /// While scrolled by a fraction of a line, this includes the line below the page,
+    /// which becomes partially visible.
+    std::vector<RenderLine> lines {};
+
+    /// Number of pixels the lines are to be moved up by, see Viewport::pixelOffset().
+    int pixelOffset = 0;
+
+    /// Runs, cells and line ranges of the frame previously rendered into this buffer.
+    ///
+    /// Lines that did not change since are moved from here into @c runs and @c cells instead of being
+    /// rendered again.
+    std::vector<RenderCell> previousCells {};
+    std::vector<RenderRun> previousRuns {};
+    std::vector<RenderLine> previousLines {};
+    std::vector<char32_t> previousCodepoints {};
+
+    /// Fingerprint of the render state (viewport, colors, modes) the lines were rendered with,
+    /// or 0 if they cannot be reused at all.
+    uint64_t contextFingerprint {};
+
+    /// Text of the lines the viewport is about to scroll to, judging by its scroll velocity,
+    /// or none if it is not being scrolled.
+    std::u32string prefetchText {};
+    std::vector<PrefetchRun> prefetchRuns {};
+
     void clear()
     {
         cells.clear();
+        runs.clear();
         cursor.reset();
+        codepoints.clear();
+        lines.clear();
+        pixelOffset = 0;
+        contextFingerprint = 0;
+        prefetchText.clear();
+        prefetchRuns.clear();
     }
 };
 
@@ -69,15 +168,21 @@ struct RenderBuffer
 struct RenderBufferRef
 {
     RenderBuffer const& buffer;
-    std::mutex& guard;
+    crispy::InstrumentedMutex& guard;
 
     [[nodiscard]] RenderBuffer const& get() const noexcept { return buffer; }
 
-    RenderBufferRef(RenderBuffer const& _buf, std::mutex& _lock): buffer { _buf }, guard { _lock }
+    RenderBufferRef(RenderBuffer const& _buf, crispy::InstrumentedMutex& _lock):
+        buffer { _buf }, guard { _lock }
     {
         guard.lock();
     }
 
+    RenderBufferRef(RenderBuffer const& _buf, crispy::InstrumentedMutex& _lock, std::adopt_lock_t):
+        buffer { _buf }, guard { _lock }
+    {
+    }
+
     ~RenderBufferRef() { guard.unlock(); }
 };
 
@@ -101,28 +206,47 @@ constexpr std::string_view to_string(RenderBufferState _state) noexcept
     return "INVALID";
 }
 
+/// Triple-buffered RenderBuffer, shared between the terminal thread (writer)
+/// and the render thread (reader).
+///
+/// The writer renders into the back buffer and publishes it by atomically exchanging it
+/// with the pending buffer, while the reader exchanges its front buffer with the pending
+/// buffer whenever a newer frame has been published. Neither side ever waits for the other,
+/// and the reader always gets the most recently completed frame.
+///
+/// The reader lock only serializes concurrent readers and is never taken by the writer.
 struct RenderDoubleBuffer
 {
-    std::mutex mutable readerLock;
-    std::atomic<size_t> currentBackBufferIndex = 0;
-    std::array<RenderBuffer, 2> buffers {};
+    crispy::InstrumentedMutex mutable readerLock;
+    std::array<RenderBuffer, 3> buffers {};
     std::atomic<RenderBufferState> state = RenderBufferState::WaitingForRefresh;
     std::chrono::steady_clock::time_point lastUpdate {};
 
-    RenderBuffer& backBuffer() noexcept { return buffers[currentBackBufferIndex]; }
+    /// Number of frames published by the writer.
+    std::atomic<uint64_t> publishedFrames = 0;
 
-    RenderBufferRef frontBuffer() const
-    {
-        // if (state == RenderBufferState::TrySwapBuffers)
-        //     const_cast<RenderDoubleBuffer*>(this)->swapBuffers(lastUpdate);
-        RenderBuffer const& frontBuffer = buffers.at((currentBackBufferIndex + 1) % 2);
-        return RenderBufferRef(frontBuffer, readerLock);
-    }
+    /// Number of published frames that were replaced by a newer one before the reader got to see them.
+    std::atomic<uint64_t> skippedFrames = 0;
+
+    RenderBuffer& backBuffer() noexcept { return buffers[backBufferIndex_]; }
+
+    /// Acquires the most recently published frame for reading.
+    RenderBufferRef frontBuffer() const;
 
     void clear() { backBuffer().clear(); }
 
-    // Swaps front with back buffer. May only be invoked by the writer thread.
+    /// Publishes the back buffer to the reader. May only be invoked by the writer thread.
+    ///
+    /// This call never blocks and always succeeds.
     bool swapBuffers(std::chrono::steady_clock::time_point _now) noexcept;
+
+  private:
+    /// Set on the pending buffer index when it holds a frame the reader has not seen yet.
+    static constexpr uint8_t FreshFrameFlag = 0x80;
+
+    size_t backBufferIndex_ = 0;                          // owned by the writer
+    size_t mutable frontBufferIndex_ = 1;                 // owned by the reader
+    std::atomic<uint8_t> mutable pendingBufferIndex_ = 2; // exchanged between both
 };
 
 } // namespace terminal
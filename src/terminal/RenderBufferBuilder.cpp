@@ -3,9 +3,14 @@
 #include <terminal/ColorPalette.h>
 #include <terminal/RenderBufferBuilder.h>
 
+#include <crispy/FNV.h>
+
 #include <unicode/convert.h>
 #include <unicode/utf8_grapheme_segmenter.h>
 
+#include <algorithm>
+#include <array>
+#include <iterator>
 #include <tuple>
 
 using namespace std;
@@ -34,6 +39,13 @@ namespace
         return get<RGBColor>(cellColor);
     }
 
+    template <typename T>
+    uint64_t hashBytes(uint64_t _memory, T const& _value) noexcept
+    {
+        auto const bytes = string_view(reinterpret_cast<char const*>(&_value), sizeof(_value));
+        return crispy::FNV<char, uint64_t>()(_memory, bytes);
+    }
+
     constexpr RGBColor average(RGBColor a, RGBColor b) noexcept
     {
         return RGBColor(static_cast<uint8_t>((a.red + b.red) / 2),
@@ -93,41 +105,360 @@ namespace
 } // namespace
 
 template <typename Cell>
-RenderBufferBuilder<Cell>::RenderBufferBuilder(Terminal const& _terminal, RenderBuffer& _output):
+RenderBufferBuilder<Cell>::RenderBufferBuilder(Terminal const& _terminal,
+                                               Grid<Cell> const& _grid,
+                                               RenderBuffer& _output):
     output { _output },
-    terminal { _terminal },
+    cells { _output.cells },
+    runs { _output.runs },
+    codepoints { _output.codepoints },
+    pageSize { _terminal.pageSize() },
+    // The line below the page is partially visible while scrolled by a fraction of a line.
+    lineCount { pageSize.lines + LineCount(_terminal.viewport().pixelOffset() ? 1 : 0) },
+    scrollOffset { _terminal.viewport().scrollOffset() },
+    colorPalette { _terminal.colorPalette() },
+    reverseVideo { _terminal.isModeEnabled(DECMode::ReverseVideo) },
     cursorPosition { _terminal.inputHandler().mode() == ViMode::Insert
                          ? _terminal.realCursorPosition()
-                         : _terminal.state().viCommands.cursorPosition }
+                         : _terminal.state().viCommands.cursorPosition },
+    cursorScreenLine { cursorPosition.line + boxed_cast<LineOffset>(scrollOffset) },
+    lines { make_shared<vector<CapturedLine>>() }
 {
-    output.clear();
+    if (auto const gridPosition = _terminal.currentMouseGridPosition())
+        hoveringHyperlink = _terminal.currentScreen().hyperlinkIdAt(*gridPosition);
+
+    // Keep the previous frame around, so that unchanged lines can be moved over from it.
+    auto const fingerprint = renderContextFingerprint(_terminal);
+    auto const reusable = fingerprint != 0 && fingerprint == output.contextFingerprint;
+
+    swap(output.cells, output.previousCells);
+    swap(output.runs, output.previousRuns);
+    swap(output.lines, output.previousLines);
+    swap(output.codepoints, output.previousCodepoints);
+    output.cells.clear();
+    output.runs.clear();
+    output.cells.reserve(unbox<size_t>(pageSize.lines) * unbox<size_t>(pageSize.columns));
+    output.codepoints.clear();
+    output.pixelOffset = _terminal.viewport().pixelOffset();
+    output.lines.assign(unbox<size_t>(lineCount), RenderLine {});
+    if (!reusable)
+        output.previousLines.clear();
+
+    output.contextFingerprint = fingerprint;
     output.frameID = _terminal.lastFrameID();
-    output.cursor = renderCursor();
+    output.cursor = renderCursor(_terminal);
+
+    if (auto const* selection = _terminal.selector(); selection && _terminal.isSelectionAvailable())
+    {
+        auto const topLine = -boxed_cast<LineOffset>(scrollOffset);
+        selectedRanges.reserve(unbox<size_t>(lineCount));
+        for (auto line = topLine; line < topLine + boxed_cast<LineOffset>(lineCount); ++line)
+            selectedRanges.emplace_back(selection->containedRangeAt(line));
+    }
+
+    // Predictions are drawn on top of the page, and only on the primary screen's main page.
+    auto const& echo = _terminal.predictiveEcho();
+    if (echo.visible() && _terminal.isPrimaryScreen() && !_terminal.viewport().scrolled())
+        for (auto const& prediction: echo.predictions())
+        {
+            if (!echo.visible(prediction))
+                break;
+            predictions.push_back(prediction);
+        }
+
+    // Hint labels are drawn on top of the page, at the start of the hints that are still matched.
+    if (auto const* hintMode = _terminal.hintMode())
+        for (size_t i = 0; i < hintMode->hints.size(); ++i)
+        {
+            auto const& label = hintMode->labels[i];
+            if (string_view(label).substr(0, hintMode->typed.size()) != hintMode->typed)
+                continue;
+            auto const position = hintMode->hints[i].range.start;
+            auto const line = position.line + boxed_cast<LineOffset>(scrollOffset);
+            if (line >= LineOffset(0) && line < boxed_cast<LineOffset>(lineCount))
+                hintLabels.emplace_back(CellLocation { line, position.column },
+                                        label.substr(hintMode->typed.size()));
+        }
+
+    captureLines(_grid);
+}
+
+template <typename Cell>
+RenderBufferBuilder<Cell>::RenderBufferBuilder(RenderBufferBuilder& _frame, RenderBufferSlice& _slice):
+    output { _frame.output },
+    cells { _slice.cells },
+    runs { _slice.runs },
+    codepoints { _slice.codepoints },
+    pageSize { _frame.pageSize },
+    lineCount { _frame.lineCount },
+    scrollOffset { _frame.scrollOffset },
+    colorPalette { _frame.colorPalette },
+    reverseVideo { _frame.reverseVideo },
+    hoveringHyperlink { _frame.hoveringHyperlink },
+    cursorPosition { _frame.cursorPosition },
+    cursorScreenLine { _frame.cursorScreenLine },
+    lines { _frame.lines },
+    selectedRanges { _frame.selectedRanges }
+{
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::captureLines(Grid<Cell> const& _grid)
+{
+    assert(!scrollOffset || unbox<LineCount>(scrollOffset) <= _grid.scrollbackLineCount());
+    assert(lineCount - unbox<LineCount>(scrollOffset) <= _grid.pageSize().lines);
+
+    // Lines that are reused from the previous frame are not captured, sparing the parser
+    // to clone them when written to before this frame has been rendered.
+    lines->resize(unbox<size_t>(lineCount));
+    for (auto y = LineOffset(0); y < boxed_cast<LineOffset>(lineCount); ++y)
+    {
+        auto const& line = _grid.scrollbackLineAt(y - boxed_cast<LineOffset>(scrollOffset));
+        auto& captured = (*lines)[unbox<size_t>(y)];
+        captured.generation = line.generation();
+        if (!canReuseLine(y, captured.generation))
+            captured.line = line;
+    }
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::renderLines(LineOffset _first, LineOffset _last)
+{
+    assert(LineOffset(0) <= _first && _first <= _last && _last <= boxed_cast<LineOffset>(lineCount));
+
+    for (auto y = _first; y != _last; ++y)
+    {
+        auto const& captured = (*lines)[unbox<size_t>(y)];
+        if (tryReuseLine(y, captured.generation))
+            continue;
+
+        assert(captured.line.has_value());
+        auto const& line = *captured.line;
+        if (line.isTrivialBuffer())
+            renderTrivialLine(line.trivialBuffer(), y);
+        else
+        {
+            auto x = ColumnOffset(0);
+            startLine(y);
+            for (Cell const& cell: line.cells())
+                renderCell(cell, y, x++);
+            endLine();
+        }
+    }
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::appendSlice(RenderBufferSlice&& _slice, LineOffset _first, LineOffset _last)
+{
+    // The slice's line ranges and codepoint offsets are relative to the slice's own storage.
+    auto const cellBase = output.cells.size();
+    auto const runBase = output.runs.size();
+    auto const codepointBase = static_cast<uint32_t>(output.codepoints.size());
+
+    for (auto line = _first; line != _last; ++line)
+    {
+        output.lines[unbox<size_t>(line)].cellOffset += cellBase;
+        output.lines[unbox<size_t>(line)].runOffset += runBase;
+    }
+
+    for (RenderCell& cell: _slice.cells)
+    {
+        cell.codepointOffset += codepointBase;
+        output.cells.emplace_back(move(cell));
+    }
+    for (RenderRun& run: _slice.runs)
+    {
+        run.codepointOffset += codepointBase;
+        output.runs.emplace_back(run);
+    }
+    output.codepoints.insert(output.codepoints.end(), _slice.codepoints.begin(), _slice.codepoints.end());
+}
+
+template <typename Cell>
+uint64_t RenderBufferBuilder<Cell>::renderContextFingerprint(Terminal const& _terminal) const noexcept
+{
+    // The selection is part of each line's key, whereas hovering changes the decoration
+    // of a hyperlink that may span any number of lines.
+    auto hash = crispy::FNV<char, uint64_t>().basis();
+    hash = hashBytes(hash, hoveringHyperlink);
+    hash = hashBytes(hash, _terminal.isPrimaryScreen());
+    hash = hashBytes(hash, pageSize);
+    hash = hashBytes(hash, scrollOffset);
+    hash = hashBytes(hash, reverseVideo);
+    hash = hashBytes(hash, colorPalette.useBrightColors);
+    hash = hashBytes(hash, colorPalette.palette);
+    hash = hashBytes(hash, colorPalette.defaultForeground);
+    hash = hashBytes(hash, colorPalette.defaultBackground);
+    hash = hashBytes(hash, colorPalette.hyperlinkDecoration.normal);
+    hash = hashBytes(hash, colorPalette.hyperlinkDecoration.hover);
+    return hash ? hash : 1;
+}
+
+template <typename Cell>
+uint64_t RenderBufferBuilder<Cell>::lineKey(LineOffset _line, uint64_t _generation) const noexcept
+{
+    auto const row = unbox<size_t>(_line);
+    auto const hasBlockCursor =
+        _line == cursorScreenLine && output.cursor && output.cursor->shape == CursorShape::Block;
+    auto const hasSelection =
+        row < selectedRanges.size() && selectedRanges[row].fromColumn <= selectedRanges[row].toColumn;
+
+    if (!_generation || (!hasBlockCursor && !hasSelection))
+        return _generation;
+
+    auto hash = hashBytes(crispy::FNV<char, uint64_t>().basis(), _generation);
+    if (hasBlockCursor)
+        hash = hashBytes(hash, cursorPosition.column);
+    if (hasSelection)
+        hash = hashBytes(hash, selectedRanges[row]);
+    return hash ? hash : 1;
+}
+
+template <typename Cell>
+bool RenderBufferBuilder<Cell>::canReuseLine(LineOffset _line, uint64_t _generation) const noexcept
+{
+    auto const row = unbox<size_t>(_line);
+    auto const key = lineKey(_line, _generation);
+    return key && row < output.previousLines.size() && output.previousLines[row].generation == key;
+}
+
+template <typename Cell>
+bool RenderBufferBuilder<Cell>::tryReuseLine(LineOffset _line, uint64_t _generation)
+{
+    auto const row = unbox<size_t>(_line);
+    auto const key = lineKey(_line, _generation);
+
+    if (canReuseLine(_line, _generation))
+    {
+        auto const& previous = output.previousLines[row];
+        output.lines[row] =
+            RenderLine { key, cells.size(), previous.cellCount, runs.size(), previous.runCount };
+        for (size_t i = 0; i < previous.runCount; ++i)
+        {
+            RenderRun& run = runs.emplace_back(output.previousRuns[previous.runOffset + i]);
+            run.codepointOffset = static_cast<uint32_t>(codepoints.size());
+            codepoints.insert(codepoints.end(), run.text.begin(), run.text.end());
+        }
+        auto const first = next(output.previousCells.begin(), static_cast<ptrdiff_t>(previous.cellOffset));
+        for (auto i = first, e = next(first, static_cast<ptrdiff_t>(previous.cellCount)); i != e; ++i)
+        {
+            RenderCell& cell = cells.emplace_back(move(*i));
+            appendCodepoints(cell, cell.codepoints);
+        }
+        return true;
+    }
+
+    output.lines[row] = RenderLine { key, cells.size(), 0, runs.size(), 0 };
+    return false;
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::appendCodepoints(RenderCell& _cell, u32string_view _codepoints)
+{
+    _cell.codepointOffset = static_cast<uint32_t>(codepoints.size());
+    _cell.codepointCount = static_cast<uint32_t>(_codepoints.size());
+    codepoints.insert(codepoints.end(), _codepoints.begin(), _codepoints.end());
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::renderPredictedEcho()
+{
+    // Predictions are drawn on top of the page, underlined, and the cursor is shown right after them.
+    auto const& colors = colorPalette;
+    for (auto const& prediction: predictions)
+    {
+        auto& cell = cells.emplace_back(makeRenderCellExplicit(colors,
+                                                               prediction.codepoint,
+                                                               CellFlags::Underline,
+                                                               colors.defaultForeground,
+                                                               colors.defaultBackground,
+                                                               DefaultColor(),
+                                                               prediction.position.line,
+                                                               prediction.position.column));
+        cell.groupStart = true;
+        cell.groupEnd = true;
+
+        auto const next = prediction.position.column + ColumnOffset(1);
+        if (output.cursor && next < boxed_cast<ColumnOffset>(pageSize.columns))
+            output.cursor->position = CellLocation { prediction.position.line, next };
+    }
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::renderHintLabels()
+{
+    auto const& colors = colorPalette;
+    for (auto const& [position, label]: hintLabels)
+        for (size_t i = 0; i < label.size(); ++i)
+        {
+            auto const column = position.column + ColumnOffset::cast_from(i);
+            if (column >= boxed_cast<ColumnOffset>(pageSize.columns))
+                break;
+            auto& cell = cells.emplace_back(makeRenderCellExplicit(colors,
+                                                                   static_cast<char32_t>(label[i]),
+                                                                   CellFlags::Bold,
+                                                                   colors.defaultBackground,
+                                                                   colors.normalColor(3),
+                                                                   DefaultColor(),
+                                                                   position.line,
+                                                                   column));
+            cell.groupStart = true;
+            cell.groupEnd = true;
+        }
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::finish() noexcept
+{
+    renderPredictedEcho();
+    renderHintLabels();
+
+    // The codepoint storage may have been reallocated while rendering, so the views into it
+    // are only assigned once all runs and cells are known.
+    auto const* const base = codepoints.data();
+    for (RenderCell& cell: cells)
+        cell.codepoints = u32string_view(base + cell.codepointOffset, cell.codepointCount);
+    for (RenderRun& run: runs)
+        run.text = u32string_view(base + run.codepointOffset, run.codepointCount);
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::updateLineCellCount(LineOffset _line) noexcept
+{
+    auto& line = output.lines[unbox<size_t>(_line)];
+    line.cellCount = cells.size() - line.cellOffset;
+}
+
+template <typename Cell>
+bool RenderBufferBuilder<Cell>::isSelected(CellLocation _gridPosition) const noexcept
+{
+    if (selectedRanges.empty())
+        return false;
+
+    auto const row = unbox<long>(_gridPosition.line - selectedRanges.front().line);
+    return 0 <= row && row < static_cast<long>(selectedRanges.size())
+           && selectedRanges[static_cast<size_t>(row)].contains(_gridPosition.column);
 }
 
 template <typename Cell>
-optional<RenderCursor> RenderBufferBuilder<Cell>::renderCursor() const
+optional<RenderCursor> RenderBufferBuilder<Cell>::renderCursor(Terminal const& _terminal) const
 {
-    if (!terminal.cursorCurrentlyVisible() || !terminal.viewport().isLineVisible(cursorPosition.line))
+    if (!_terminal.cursorCurrentlyVisible() || !_terminal.viewport().isLineVisible(cursorPosition.line))
         return nullopt;
 
     // TODO: check if CursorStyle has changed, and update render context accordingly.
 
     auto constexpr InactiveCursorShape = CursorShape::Rectangle; // TODO configurable
-    auto const shape = terminal.state().focused ? terminal.cursorShape() : InactiveCursorShape;
-
-    auto const cursorScreenPosition =
-        CellLocation { cursorPosition.line + boxed_cast<LineOffset>(terminal.viewport().scrollOffset()),
-                       cursorPosition.column };
-
-    auto const cellWidth = terminal.currentScreen().cellWithAt(cursorPosition);
+    auto const shape = _terminal.state().focused ? _terminal.cursorShape() : InactiveCursorShape;
+    auto const cursorScreenPosition = CellLocation { cursorScreenLine, cursorPosition.column };
+    auto const cellWidth = _terminal.currentScreen().cellWithAt(cursorPosition);
 
     return RenderCursor { cursorScreenPosition, shape, cellWidth };
 }
 
 template <typename Cell>
 RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const& _colorPalette,
-                                                             u32string graphemeCluster,
+                                                             u32string_view graphemeCluster,
                                                              ColumnCount width,
                                                              CellFlags flags,
                                                              RGBColor fg,
@@ -144,7 +475,7 @@ RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const&
     renderCell.position.column = _column;
     renderCell.flags = flags;
     renderCell.width = unbox<uint8_t>(width);
-    renderCell.codepoints = move(graphemeCluster);
+    appendCodepoints(renderCell, graphemeCluster);
     return renderCell;
 }
 
@@ -166,14 +497,15 @@ RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const&
     renderCell.position.column = _column;
     renderCell.flags = flags;
     renderCell.width = 1;
+    renderCell.codepointOffset = static_cast<uint32_t>(codepoints.size());
+    renderCell.codepointCount = codepoint ? 1 : 0;
     if (codepoint)
-        renderCell.codepoints.push_back(codepoint);
+        codepoints.push_back(codepoint);
     return renderCell;
 }
 
 template <typename Cell>
 RenderCell RenderBufferBuilder<Cell>::makeRenderCell(ColorPalette const& _colorPalette,
-                                                     HyperlinkStorage const& _hyperlinks,
                                                      Cell const& screenCell,
                                                      RGBColor fg,
                                                      RGBColor bg,
@@ -189,21 +521,22 @@ RenderCell RenderBufferBuilder<Cell>::makeRenderCell(ColorPalette const& _colorP
     renderCell.flags = screenCell.styles();
     renderCell.width = screenCell.width();
 
-    if (screenCell.codepointCount() != 0)
-    {
-        for (size_t i = 0; i < screenCell.codepointCount(); ++i)
-            renderCell.codepoints.push_back(screenCell.codepoint(i));
-    }
+    renderCell.codepointOffset = static_cast<uint32_t>(codepoints.size());
+    renderCell.codepointCount = static_cast<uint32_t>(screenCell.codepointCount());
+    for (size_t i = 0; i < screenCell.codepointCount(); ++i)
+        codepoints.push_back(screenCell.codepoint(i));
 
     renderCell.image = screenCell.imageFragment();
 
-    if (auto href = _hyperlinks.hyperlinkById(screenCell.hyperlink()))
+    // Hyperlinks referenced by grid cells are never collected, so any hyperlink ID is valid.
+    if (auto const hyperlink = screenCell.hyperlink(); !!hyperlink)
     {
-        auto const& color = href->state == HyperlinkState::Hover ? _colorPalette.hyperlinkDecoration.hover
-                                                                 : _colorPalette.hyperlinkDecoration.normal;
+        auto const hover = hyperlink == hoveringHyperlink;
+        auto const& color =
+            hover ? _colorPalette.hyperlinkDecoration.hover : _colorPalette.hyperlinkDecoration.normal;
         // TODO(decoration): Move property into Terminal.
         auto const decoration =
-            href->state == HyperlinkState::Hover
+            hover
                 ? CellFlags::Underline        // TODO: decorationRenderer_.hyperlinkHover()
                 : CellFlags::DottedUnderline; // TODO: decorationRenderer_.hyperlinkNormal();
         renderCell.flags |= decoration;       // toCellStyle(decoration);
@@ -228,15 +561,26 @@ std::tuple<RGBColor, RGBColor> RenderBufferBuilder<Cell>::makeColorsForCell(Cell
             && output.cursor->shape == CursorShape::Block;
     // clang-format on
 
-    auto const selected = terminal.isSelected(CellLocation { gridPosition.line, gridPosition.column });
-
-    return makeColors(terminal.colorPalette(),
-                      cellFlags,
-                      reverseVideo,
-                      foregroundColor,
-                      backgroundColor,
-                      selected,
-                      paintCursor);
+    auto const selected = isSelected(gridPosition);
+
+    // Most cells of a page share few distinct attributes, so resolve each combination only once.
+    auto const colors = (uint64_t(foregroundColor.content) << 32) | backgroundColor.content;
+    auto const state = static_cast<uint32_t>(cellFlags) | (uint32_t(selected) << 16)
+                       | (uint32_t(paintCursor) << 17) | (1u << 18);
+    auto const slot = ((colors ^ state) * 0x9E3779B97F4A7C15llu) >> 58;
+    auto& memo = resolvedColors[slot];
+    if (memo.colors == colors && memo.state == state)
+        return { memo.foreground, memo.background };
+
+    auto const [fg, bg] = makeColors(colorPalette,
+                                     cellFlags,
+                                     reverseVideo,
+                                     foregroundColor,
+                                     backgroundColor,
+                                     selected,
+                                     paintCursor);
+    memo = ResolvedColors { colors, state, fg, bg };
+    return { fg, bg };
 }
 
 template <typename Cell>
@@ -249,11 +593,21 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TriviallyStyledLineBuffer cons
     //            lineBuffer.displayWidth,
     //            lineBuffer.text.view());
 
-    auto const frontIndex = output.cells.size();
+    auto const text = lineBuffer.text.view();
+    auto const isPrintableAscii = [](char ch) {
+        return 0x20 <= ch && ch < 0x7F;
+    };
+    if (all_of(text.begin(), text.end(), isPrintableAscii))
+    {
+        renderTrivialLineRuns(lineBuffer, lineOffset);
+        return;
+    }
 
-    auto const textMargin = min(boxed_cast<ColumnOffset>(terminal.pageSize().columns),
+    auto const frontIndex = cells.size();
+
+    auto const textMargin = min(boxed_cast<ColumnOffset>(pageSize.columns),
                                 ColumnOffset::cast_from(lineBuffer.usedColumns));
-    auto const pageColumnsEnd = boxed_cast<ColumnOffset>(terminal.pageSize().columns);
+    auto const pageColumnsEnd = boxed_cast<ColumnOffset>(pageSize.columns);
 
     // {{{ render text
     auto graphemeClusterSegmenter = unicode::utf8_grapheme_segmenter(lineBuffer.text.view());
@@ -261,22 +615,22 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TriviallyStyledLineBuffer cons
     for (u32string const& graphemeCluster: graphemeClusterSegmenter)
     {
         auto const pos = CellLocation { lineOffset, columnOffset };
-        auto const gridPosition = terminal.viewport().translateScreenToGridCoordinate(pos);
+        auto const gridPosition = gridPositionOf(pos);
         auto const [fg, bg] = makeColorsForCell(gridPosition,
                                                 lineBuffer.attributes.styles,
                                                 lineBuffer.attributes.foregroundColor,
                                                 lineBuffer.attributes.backgroundColor);
         auto const width = graphemeClusterWidth(graphemeCluster);
 
-        output.cells.emplace_back(makeRenderCellExplicit(terminal.colorPalette(),
-                                                         graphemeCluster,
-                                                         width,
-                                                         lineBuffer.attributes.styles,
-                                                         fg,
-                                                         bg,
-                                                         lineBuffer.attributes.underlineColor,
-                                                         lineOffset,
-                                                         columnOffset));
+        cells.emplace_back(makeRenderCellExplicit(colorPalette,
+                                                  graphemeCluster,
+                                                  width,
+                                                  lineBuffer.attributes.styles,
+                                                  fg,
+                                                  bg,
+                                                  lineBuffer.attributes.underlineColor,
+                                                  lineOffset,
+                                                  columnOffset));
 
         columnOffset += ColumnOffset::cast_from(width);
         lineNr = lineOffset;
@@ -289,27 +643,97 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TriviallyStyledLineBuffer cons
     for (auto columnOffset = textMargin; columnOffset < pageColumnsEnd; ++columnOffset)
     {
         auto const pos = CellLocation { lineOffset, columnOffset };
-        auto const gridPosition = terminal.viewport().translateScreenToGridCoordinate(pos);
+        auto const gridPosition = gridPositionOf(pos);
         auto const [fg, bg] = makeColorsForCell(gridPosition,
                                                 lineBuffer.attributes.styles,
                                                 lineBuffer.attributes.foregroundColor,
                                                 lineBuffer.attributes.backgroundColor);
 
-        output.cells.emplace_back(makeRenderCellExplicit(terminal.colorPalette(),
-                                                         char32_t { 0 },
-                                                         lineBuffer.attributes.styles,
-                                                         fg,
-                                                         bg,
-                                                         lineBuffer.attributes.underlineColor,
-                                                         lineOffset,
-                                                         columnOffset));
+        cells.emplace_back(makeRenderCellExplicit(colorPalette,
+                                                  char32_t { 0 },
+                                                  lineBuffer.attributes.styles,
+                                                  fg,
+                                                  bg,
+                                                  lineBuffer.attributes.underlineColor,
+                                                  lineOffset,
+                                                  columnOffset));
     }
     // }}}
 
-    auto const backIndex = output.cells.size() - 1;
+    auto const backIndex = cells.size() - 1;
+
+    cells[frontIndex].groupStart = true;
+    cells[backIndex].groupEnd = true;
 
-    output.cells[frontIndex].groupStart = true;
-    output.cells[backIndex].groupEnd = true;
+    updateLineCellCount(lineOffset);
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::renderTrivialLineRuns(TriviallyStyledLineBuffer const& lineBuffer,
+                                                      LineOffset lineOffset)
+{
+    auto const row = unbox<size_t>(lineOffset);
+    auto const columnCount = unbox<int>(pageSize.columns);
+    auto const text = lineBuffer.text.view().substr(0, unbox<size_t>(pageSize.columns));
+    auto const& attributes = lineBuffer.attributes;
+
+    // All columns share the line's attributes, so the colors only change at the block cursor
+    // and at the selection's boundaries.
+    auto bounds = array<int, 5> {};
+    auto boundCount = size_t { 0 };
+    auto const addBound = [&](int column) {
+        if (0 < column && column < columnCount)
+            bounds[boundCount++] = column;
+    };
+    if (lineOffset == cursorScreenLine)
+    {
+        addBound(unbox<int>(cursorPosition.column));
+        addBound(unbox<int>(cursorPosition.column) + 1);
+    }
+    if (row < selectedRanges.size() && selectedRanges[row].fromColumn <= selectedRanges[row].toColumn)
+    {
+        addBound(unbox<int>(selectedRanges[row].fromColumn));
+        addBound(unbox<int>(selectedRanges[row].toColumn) + 1);
+    }
+    bounds[boundCount++] = columnCount;
+    sort(bounds.begin(), next(bounds.begin(), static_cast<ptrdiff_t>(boundCount)));
+
+    lineNr = lineOffset;
+    prevWidth = 0;
+    prevHasCursor = false;
+
+    auto start = 0;
+    for (auto const end: gsl::span(bounds.data(), boundCount))
+    {
+        if (end <= start)
+            continue;
+
+        auto const position = CellLocation { lineOffset, ColumnOffset(start) };
+        auto const [fg, bg] = makeColorsForCell(gridPositionOf(position),
+                                                attributes.styles,
+                                                attributes.foregroundColor,
+                                                attributes.backgroundColor);
+
+        auto& run = runs.emplace_back();
+        run.start = position;
+        run.length = ColumnCount(end - start);
+        run.flags = attributes.styles;
+        run.foregroundColor = fg;
+        run.backgroundColor = bg;
+        run.decorationColor =
+            getUnderlineColor(colorPalette, attributes.styles, fg, attributes.underlineColor);
+
+        auto const runText = text.substr(min(static_cast<size_t>(start), text.size()),
+                                         static_cast<size_t>(end - start));
+        run.codepointOffset = static_cast<uint32_t>(codepoints.size());
+        run.codepointCount = static_cast<uint32_t>(runText.size());
+        codepoints.insert(codepoints.end(), runText.begin(), runText.end());
+
+        start = end;
+    }
+
+    auto& line = output.lines[row];
+    line.runCount = runs.size() - line.runOffset;
 }
 
 template <typename Cell>
@@ -324,17 +748,19 @@ void RenderBufferBuilder<Cell>::startLine(LineOffset _line) noexcept
 template <typename Cell>
 void RenderBufferBuilder<Cell>::endLine() noexcept
 {
-    if (!output.cells.empty())
+    if (!cells.empty())
     {
-        output.cells.back().groupEnd = true;
+        cells.back().groupEnd = true;
     }
+
+    updateLineCellCount(lineNr);
 }
 
 template <typename Cell>
 void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset _line, ColumnOffset _column)
 {
     auto const pos = CellLocation { _line, _column };
-    auto const gridPosition = terminal.viewport().translateScreenToGridCoordinate(pos);
+    auto const gridPosition = gridPositionOf(pos);
     auto const [fg, bg] = makeColorsForCell(
         gridPosition, screenCell.styles(), screenCell.foregroundColor(), screenCell.backgroundColor());
 
@@ -342,7 +768,7 @@ void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset _l
     prevHasCursor = gridPosition == cursorPosition;
 
     auto const cellEmpty = screenCell.empty();
-    auto const customBackground = bg != terminal.colorPalette().defaultBackground || !!screenCell.styles();
+    auto const customBackground = bg != colorPalette.defaultBackground || !!screenCell.styles();
 
     switch (state)
     {
@@ -350,26 +776,24 @@ void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset _l
             if (!cellEmpty || customBackground)
             {
                 state = State::Sequence;
-                output.cells.emplace_back(makeRenderCell(terminal.colorPalette(),
-                                                         terminal.state().hyperlinks,
+                cells.emplace_back(makeRenderCell(colorPalette,
                                                          screenCell,
                                                          fg,
                                                          bg,
                                                          _line,
                                                          _column));
-                output.cells.back().groupStart = true;
+                cells.back().groupStart = true;
             }
             break;
         case State::Sequence:
             if (cellEmpty && !customBackground)
             {
-                output.cells.back().groupEnd = true;
+                cells.back().groupEnd = true;
                 state = State::Gap;
             }
             else
             {
-                output.cells.emplace_back(makeRenderCell(terminal.colorPalette(),
-                                                         terminal.state().hyperlinks,
+                cells.emplace_back(makeRenderCell(colorPalette,
                                                          screenCell,
                                                          fg,
                                                          bg,
@@ -377,7 +801,7 @@ void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset _l
                                                          _column));
 
                 if (isNewLine)
-                    output.cells.back().groupStart = true;
+                    cells.back().groupStart = true;
             }
             break;
     }
@@ -3,19 +3,70 @@
 #include <terminal/RenderBuffer.h>
 #include <terminal/Terminal.h>
 
+#include <array>
+#include <memory>
 #include <optional>
+#include <vector>
 
 namespace terminal
 {
 
+/// Runs, cells and grapheme clusters of a range of screen lines, rendered apart from the rest of the page.
+///
+/// @see RenderBufferBuilder::appendSlice()
+struct RenderBufferSlice
+{
+    std::vector<RenderCell> cells {};
+    std::vector<RenderRun> runs {};
+    std::vector<char32_t> codepoints {};
+};
+
 /**
  * RenderBufferBuilder<Cell> renders the current screen state into a RenderBuffer.
+ *
+ * Building a frame happens in two phases. The constructor captures everything that is needed
+ * to render the frame, and must thus be invoked with the terminal locked: the cursor, selection,
+ * colors, and a snapshot of each visible grid line that changed since the previous frame.
+ * Grid lines share their cells with their snapshots copy-on-write, so capturing a line merely
+ * increments a reference count, and the parser clones a line's cells only if it writes to it
+ * while its snapshot is still being rendered.
+ *
+ * Rendering the captured lines by renderLines() and finish() does not access the terminal anymore,
+ * and may thus happen after the terminal has been unlocked, so that the parser is not held up
+ * by the rendering of the frame. Only releasing the captured lines requires the lock again.
  */
 template <typename Cell>
 class RenderBufferBuilder
 {
   public:
-    RenderBufferBuilder(Terminal const& terminal, RenderBuffer& output);
+    /// Captures the frame of the given grid, which is the terminal's current screen's grid.
+    RenderBufferBuilder(Terminal const& terminal, Grid<Cell> const& grid, RenderBuffer& output);
+
+    /// Constructs a builder that renders a range of lines of @p _frame's page into @p _slice.
+    ///
+    /// Builders of disjoint line ranges of the same frame may run concurrently. Their slices are
+    /// then merged back into the frame using appendSlice(), in page order, before calling finish().
+    RenderBufferBuilder(RenderBufferBuilder& _frame, RenderBufferSlice& _slice);
+
+    /// Appends the runs and cells of the rendered screen lines [_first, _last) in @p _slice to the frame.
+    void appendSlice(RenderBufferSlice&& _slice, LineOffset _first, LineOffset _last);
+
+    /// Renders the captured screen lines [_first, _last).
+    void renderLines(LineOffset _first, LineOffset _last);
+
+    /// @returns the number of screen lines captured, including the partially visible one below
+    ///          the page while scrolled by a fraction of a line.
+    [[nodiscard]] LineCount renderedLineCount() const noexcept { return lineCount; }
+    [[nodiscard]] ColumnCount columnCount() const noexcept { return pageSize.columns; }
+
+    /// Reuses the previously rendered cells of the given screen line if the grid line's
+    /// @p _generation stamp did not change since then.
+    ///
+    /// This call is guaranteed to be invoked for every line, before it is rendered
+    /// using either renderCell() or renderTrivialLine().
+    ///
+    /// @returns true if the line has been reused and thus must not be rendered again.
+    bool tryReuseLine(LineOffset _line, uint64_t _generation);
 
     /// Renders a single grid cell.
     /// This call is guaranteed to be invoked sequencially, from top line
@@ -35,65 +86,138 @@ class RenderBufferBuilder
     /// As this function is only invoked for trivial lines, all other lines
     /// with their grid cells are to be rendered using renderCell().
     ///
+    /// Lines of printable US-ASCII text are rendered into a few RenderRun objects,
+    /// any other trivial line into one RenderCell per grapheme cluster and blank column.
+    ///
     /// @see renderCell
     void renderTrivialLine(TriviallyStyledLineBuffer const& _lineBuffer, LineOffset _lineNo);
 
     /// This call is guaranteed to be invoked when the the full page has been rendered.
-    void finish() noexcept {}
+    void finish() noexcept;
+
+    /// Releases the captured lines.
+    ///
+    /// Cells are returned to their grid's slab pool, which is not thread-safe, when the last copy
+    /// of a line is gone. This must therefore be called with the terminal locked again.
+    void releaseLines() noexcept { lines->clear(); }
 
   private:
-    std::optional<RenderCursor> renderCursor() const;
-
-    static RenderCell makeRenderCellExplicit(ColorPalette const& _colorPalette,
-                                             std::u32string graphemeCluster,
-                                             ColumnCount width,
-                                             CellFlags flags,
-                                             RGBColor fg,
-                                             RGBColor bg,
-                                             Color ul,
-                                             LineOffset _line,
-                                             ColumnOffset _column);
-
-    static RenderCell makeRenderCellExplicit(ColorPalette const& _colorPalette,
-                                             char32_t codepoint,
-                                             CellFlags flags,
-                                             RGBColor fg,
-                                             RGBColor bg,
-                                             Color ul,
-                                             LineOffset _line,
-                                             ColumnOffset _column);
+    std::optional<RenderCursor> renderCursor(Terminal const& _terminal) const;
+    void renderPredictedEcho();
+    void renderHintLabels();
+    bool isSelected(CellLocation _gridPosition) const noexcept;
+    uint64_t renderContextFingerprint(Terminal const& _terminal) const noexcept;
+    void captureLines(Grid<Cell> const& _grid);
+
+    [[nodiscard]] CellLocation gridPositionOf(CellLocation _screenPosition) const noexcept
+    {
+        return CellLocation { _screenPosition.line - boxed_cast<LineOffset>(scrollOffset),
+                              _screenPosition.column };
+    }
+
+    /// Tests whether the previously rendered cells of the given screen line are still valid.
+    bool canReuseLine(LineOffset _line, uint64_t _generation) const noexcept;
+
+    /// Combines the line's generation with the transient state drawn into it.
+    uint64_t lineKey(LineOffset _line, uint64_t _generation) const noexcept;
+    void updateLineCellCount(LineOffset _line) noexcept;
+
+    /// Renders a trivial line of printable US-ASCII text, one run per span of equally colored columns.
+    void renderTrivialLineRuns(TriviallyStyledLineBuffer const& _lineBuffer, LineOffset _lineNo);
+
+    /// Appends @p _codepoints to the output's codepoint storage on behalf of @p _cell.
+    void appendCodepoints(RenderCell& _cell, std::u32string_view _codepoints);
+
+    RenderCell makeRenderCellExplicit(ColorPalette const& _colorPalette,
+                                      std::u32string_view graphemeCluster,
+                                      ColumnCount width,
+                                      CellFlags flags,
+                                      RGBColor fg,
+                                      RGBColor bg,
+                                      Color ul,
+                                      LineOffset _line,
+                                      ColumnOffset _column);
+
+    RenderCell makeRenderCellExplicit(ColorPalette const& _colorPalette,
+                                      char32_t codepoint,
+                                      CellFlags flags,
+                                      RGBColor fg,
+                                      RGBColor bg,
+                                      Color ul,
+                                      LineOffset _line,
+                                      ColumnOffset _column);
 
     /// Constructs a RenderCell for the given screen Cell.
-    static RenderCell makeRenderCell(ColorPalette const& _colorPalette,
-                                     HyperlinkStorage const& _hyperlinks,
-                                     Cell const& _cell,
-                                     RGBColor fg,
-                                     RGBColor bg,
-                                     LineOffset _line,
-                                     ColumnOffset _column);
+    RenderCell makeRenderCell(ColorPalette const& _colorPalette,
+                              Cell const& _cell,
+                              RGBColor fg,
+                              RGBColor bg,
+                              LineOffset _line,
+                              ColumnOffset _column);
 
     /// Constructs the final foreground/background colors to be displayed on the screen.
     ///
     /// This call takes cursor-position, hyperlink-states, selection, and reverse-video mode into account.
     std::tuple<RGBColor, RGBColor> makeColorsForCell(CellLocation,
-                                                     CellFlags cellFlags,
-                                                     Color foregroundColor,
-                                                     Color backgroundColor);
+                                              CellFlags cellFlags,
+                                              Color foregroundColor,
+                                              Color backgroundColor);
+
+    /// Memoized result of makeColorsForCell() for one combination of its inputs.
+    struct ResolvedColors
+    {
+        uint64_t colors = 0; // foreground and background Color of the cell
+        uint32_t state = 0;  // cell flags, selection and cursor state; zero if unused
+        RGBColor foreground {};
+        RGBColor background {};
+    };
+
+    /// A screen line as captured for this frame.
+    struct CapturedLine
+    {
+        uint64_t generation = 0;
+        std::optional<Line<Cell>> line {}; // none if reused from the previous frame
+    };
 
     // clang-format off
     enum class State { Gap, Sequence };
     // clang-format on
 
     RenderBuffer& output;
-    Terminal const& terminal;
+    std::vector<RenderCell>& cells;
+    std::vector<RenderRun>& runs;
+    std::vector<char32_t>& codepoints;
+
+    // State of the terminal, as captured at construction.
+    PageSize pageSize;
+    LineCount lineCount;
+    ScrollOffset scrollOffset;
+    ColorPalette colorPalette;
+    bool reverseVideo;
+    HyperlinkId hoveringHyperlink {};
     CellLocation cursorPosition;
+    LineOffset cursorScreenLine;
+    std::vector<PredictiveEcho::Prediction> predictions {};
+
+    /// The untyped rest of the labels of the hints still to be picked from, by screen position.
+    std::vector<std::pair<CellLocation, std::string>> hintLabels {};
+
+    /// Captured screen lines, shared with the builders of the frame's slices.
+    std::shared_ptr<std::vector<CapturedLine>> lines;
 
-    bool reverseVideo = terminal.isModeEnabled(terminal::DECMode::ReverseVideo);
     int prevWidth = 0;
     bool prevHasCursor = false;
     State state = State::Gap;
     LineOffset lineNr = LineOffset(0);
     bool isNewLine = false;
+
+    /// Colors resolved in this frame, indexed by a hash of their inputs.
+    ///
+    /// The builder lives for a single frame only, so palette and mode changes never outdate it.
+    std::array<ResolvedColors, 64> resolvedColors {};
+
+    /// Selected columns of each screen line, computed once per frame; empty without a selection.
+    std::vector<Selection::Range> selectedRanges {};
 };
 
 } // namespace terminal
@@ -11,16 +11,21 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <terminal/CodepointProperties.h>
 #include <terminal/ControlCode.h>
+#include <terminal/GraphemeClusterTable.h>
 #include <terminal/InputGenerator.h>
+#include <terminal/PngDecoder.h>
 #include <terminal/Screen.h>
 #include <terminal/Terminal.h>
+#include <terminal/TextWidth.h>
 #include <terminal/VTType.h>
 #include <terminal/VTWriter.h>
 #include <terminal/logging.h>
 
 #include <crispy/App.h>
 #include <crispy/Comparison.h>
+#include <crispy/PerfTrace.h>
 #include <crispy/algorithm.h>
 #include <crispy/base64.h>
 #include <crispy/escape.h>
@@ -30,7 +35,6 @@
 
 #include <unicode/convert.h>
 #include <unicode/emoji_segmenter.h>
-#include <unicode/grapheme_segmenter.h>
 #include <unicode/word_segmenter.h>
 
 #include <range/v3/view.hpp>
@@ -79,6 +83,7 @@ using std::shared_ptr;
 using std::string;
 using std::string_view;
 using std::tuple;
+using std::u32string_view;
 using std::unique_ptr;
 using std::vector;
 
@@ -202,6 +207,18 @@ namespace // {{{ helper
         return output;
     }
 
+    /// Tests whether VTWriter::write() omits the last column of @p _line, as it is blank.
+    template <typename Cell>
+    bool lastColumnOmitted(Line<Cell> const& _line)
+    {
+        if (_line.isTrivialBuffer())
+            return _line.trivialBuffer().text.size() < unbox<size_t>(_line.size())
+                   && isDefaultColor(_line.trivialBuffer().attributes.backgroundColor);
+
+        auto const& lastCell = _line.inflatedBuffer().back();
+        return !lastCell.codepointCount() && isDefaultColor(lastCell.backgroundColor());
+    }
+
     template <typename T, typename U>
     std::optional<crispy::boxed<T, U>> decr(std::optional<crispy::boxed<T, U>> v)
     {
@@ -280,7 +297,7 @@ string_view Screen<Cell, TheScreenType>::tryEmplaceChars(string_view _chars, siz
     // optimization can be applied.
     // Unless we're storing the charset in the TriviallyStyledLineBuffer, too.
     // But for now that's too rare to be beneficial.
-    if (!_state.cursor.charsets.isSelected(CharsetId::USASCII))
+    if (!_state.cursor.charsets.isIdentity())
         return _chars;
 
     crlfIfWrapPending();
@@ -320,6 +337,21 @@ string_view Screen<Cell, TheScreenType>::tryEmplaceChars(string_view _chars, siz
         return _chars;
     }
 
+    if (canAppendToTrivialLine())
+    {
+        // The text is not contiguous to the line's text in the PTY buffer (e.g. a redundant SGR was
+        // in between), so the line's text is relocated rather than inflating the line.
+        auto const charsToWrite = static_cast<size_t>(min(columnsAvailable, static_cast<int>(_chars.size())));
+        auto& lineBuffer = currentLine().trivialBuffer();
+        lineBuffer.text = _terminal.appendLineText(lineBuffer.text, _chars.substr(0, charsToWrite));
+        lineBuffer.usedColumns += ColumnCount::cast_from(charsToWrite);
+        advanceCursorAfterWrite(ColumnCount::cast_from(charsToWrite));
+        _chars.remove_prefix(charsToWrite);
+        _chars = tryEmplaceContinuousChars(_chars, cellCount);
+        _terminal.currentPtyBuffer()->advanceHotEndUntil(_chars.data());
+        return _chars;
+    }
+
     return _chars;
 }
 
@@ -407,9 +439,24 @@ bool Screen<Cell, TheScreenType>::canResumeEmplace(std::string_view continuation
            && buffer.text.owner() == _terminal.currentPtyBuffer();
 }
 
+template <typename Cell, ScreenType TheScreenType>
+bool Screen<Cell, TheScreenType>::canAppendToTrivialLine() const noexcept
+{
+    auto& line = currentLine();
+    if (!line.isTrivialBuffer())
+        return false;
+    TriviallyStyledLineBuffer const& buffer = line.trivialBuffer();
+    return !buffer.text.empty() && unbox<size_t>(buffer.usedColumns) == buffer.text.size()
+           && *buffer.usedColumns == *_state.cursor.position.column
+           && buffer.attributes == _state.cursor.graphicsRendition
+           && buffer.hyperlink == _state.cursor.hyperlink;
+}
+
 template <typename Cell, ScreenType TheScreenType>
 void Screen<Cell, TheScreenType>::writeText(string_view _chars, size_t cellCount)
 {
+    CONTOUR_PERF_TRACE("Screen::writeText");
+
 #if defined(LIBTERMINAL_LOG_TRACE)
     if (VTTraceSequenceLog)
         VTTraceSequenceLog()("text({} bytes): \"{}\"", _chars.size(), _chars);
@@ -421,17 +468,109 @@ void Screen<Cell, TheScreenType>::writeText(string_view _chars, size_t cellCount
         return;
 #endif
 
-    for (char const ch: _chars)
-        writeTextInternal(static_cast<char32_t>(ch));
+    // The first character may still need to be joined with the preceding (non US-ASCII) one.
+    if (precedingGraphicCharacter() >= 128)
+    {
+        writeTextInternal(static_cast<char32_t>(_chars.front()));
+        _chars.remove_prefix(1);
+    }
+
+    while (!_chars.empty())
+    {
+        auto const n = writeTextIntoCurrentLine(_chars);
+        if (!n)
+            break;
+        _chars.remove_prefix(n);
+        if (!_state.cursor.autoWrap)
+            break;
+    }
+
+    if (isSimpleWriteConfiguration())
+        for (char const ch: _chars)
+            writeTextInternal<true>(static_cast<char32_t>(ch), nullopt);
+    else
+        for (char const ch: _chars)
+            writeTextInternal<false>(static_cast<char32_t>(ch), nullopt);
+}
+
+template <typename Cell, ScreenType TheScreenType>
+size_t Screen<Cell, TheScreenType>::writeTextIntoCurrentLine(string_view _chars)
+{
+    // In case the charset has been altered, each character must be mapped individually.
+    if (!_state.cursor.charsets.isIdentity())
+        return 0;
+
+    crlfIfWrapPending();
+
+    bool const cursorInsideMargin =
+        _terminal.isModeEnabled(DECMode::LeftRightMargin) && _terminal.isCursorInsideMargins();
+    auto const lastColumn =
+        cursorInsideMargin ? *_state.margin.horizontal.to : *_state.pageSize.columns - 1;
+    auto const startColumn = *_state.cursor.position.column;
+    if (startColumn > lastColumn)
+        return 0;
+
+    auto count = min(static_cast<size_t>(lastColumn - startColumn + 1), _chars.size());
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (static_cast<uint8_t>(_chars[i]) >= 0x80)
+        {
+            count = i;
+            break;
+        }
+    }
+    if (!count)
+        return 0;
+
+    // Repainting the same text, as full-screen applications frequently do, leaves the line untouched.
+    auto& lineBuffer = currentLine();
+    if (!lineBuffer.holdsText(ColumnOffset(startColumn),
+                              _chars.substr(0, count),
+                              _state.cursor.graphicsRendition,
+                              _state.cursor.hyperlink))
+    {
+        auto constexpr AsciiWidth = uint8_t { 1 };
+        auto cells = lineBuffer.useRange(ColumnOffset(startColumn), ColumnCount::cast_from(count));
+        for (size_t i = 0; i < count; ++i)
+            cells[i].write(_state.cursor.graphicsRendition,
+                           static_cast<char32_t>(_chars[i]),
+                           AsciiWidth,
+                           _state.cursor.hyperlink);
+    }
+
+    auto const line = _state.cursor.position.line;
+    auto const endColumn = startColumn + static_cast<int>(count) - 1;
+    _state.lastCursorPosition = CellLocation { line, ColumnOffset(endColumn) };
+    if (endColumn < lastColumn)
+        _state.cursor.position.column = ColumnOffset(endColumn + 1);
+    else
+    {
+        _state.cursor.position.column = ColumnOffset(lastColumn);
+        if (_state.cursor.autoWrap)
+            _state.wrapPending = true;
+    }
+
+    _terminal.markRegionDirty(Rect { Top(*line), Left(startColumn), Bottom(*line), Right(endColumn) });
+    resetInstructionCounter();
+
+    return count;
+}
+
+template <typename Cell, ScreenType TheScreenType>
+void Screen<Cell, TheScreenType>::crlfIfWrapPending()
+{
+    crlfIfWrapPending<false>();
 }
 
 template <typename Cell, ScreenType TheScreenType>
+template <bool Simple>
 void Screen<Cell, TheScreenType>::crlfIfWrapPending()
 {
-    if (_state.wrapPending && _state.cursor.autoWrap) // && !_terminal.isModeEnabled(DECMode::TextReflow))
+    // && !_terminal.isModeEnabled(DECMode::TextReflow))
+    if (_state.wrapPending && (Simple || _state.cursor.autoWrap))
     {
         bool const lineWrappable = currentLine().wrappable();
-        crlf();
+        linefeed<Simple>(_state.margin.horizontal.from);
         if (lineWrappable)
             currentLine().setFlag(LineFlags::Wrappable | LineFlags::Wrapped, true);
     }
@@ -449,9 +588,63 @@ void Screen<Cell, TheScreenType>::writeText(char32_t _char)
 }
 
 template <typename Cell, ScreenType TheScreenType>
-void Screen<Cell, TheScreenType>::writeTextInternal(char32_t _char)
+void Screen<Cell, TheScreenType>::writeText(u32string_view _chars)
 {
-    crlfIfWrapPending();
+    CONTOUR_PERF_TRACE("Screen::writeText");
+
+#if defined(LIBTERMINAL_LOG_TRACE)
+    if (VTTraceSequenceLog)
+        VTTraceSequenceLog()("text({} codepoints): \"{}\"", _chars.size(), unicode::convert_to<char>(_chars));
+#endif
+
+    if (isSimpleWriteConfiguration())
+        writeTextRun<true>(_chars);
+    else
+        writeTextRun<false>(_chars);
+}
+
+template <typename Cell, ScreenType TheScreenType>
+template <bool Simple>
+void Screen<Cell, TheScreenType>::writeTextRun(u32string_view _chars)
+{
+    // Widths are looked up in batches ahead of writing, sparing most text the Unicode property lookup.
+    auto widths = array<uint8_t, 64> {};
+    for (size_t offset = 0; offset < _chars.size(); offset += widths.size())
+    {
+        auto const batch = _chars.substr(offset, widths.size());
+        codepointWidths(batch, widths.data());
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            _state.instructionCounter++;
+            writeTextInternal<Simple>(batch[i], widths[i]);
+            _state.precedingGraphicCharacter = batch[i];
+        }
+    }
+}
+
+template <typename Cell, ScreenType TheScreenType>
+bool Screen<Cell, TheScreenType>::isSimpleWriteConfiguration() const noexcept
+{
+    // Horizontal margins are reset whenever DECLRMM is, so only the vertical ones need checking.
+    return _state.cursor.autoWrap && !_terminal.isModeEnabled(DECMode::LeftRightMargin)
+           && *_state.margin.vertical.from == 0
+           && *_state.margin.vertical.to + 1 == *_state.pageSize.lines;
+}
+
+template <typename Cell, ScreenType TheScreenType>
+void Screen<Cell, TheScreenType>::writeTextInternal(char32_t _char, optional<uint8_t> _width)
+{
+    if (isSimpleWriteConfiguration())
+        writeTextInternal<true>(_char, _width);
+    else
+        writeTextInternal<false>(_char, _width);
+}
+
+template <typename Cell, ScreenType TheScreenType>
+template <bool Simple>
+void Screen<Cell, TheScreenType>::writeTextInternal(char32_t _char, optional<uint8_t> _width)
+{
+    crlfIfWrapPending<Simple>();
 
     char32_t const codepoint = _state.cursor.charsets.map(_char);
 
@@ -459,15 +652,19 @@ void Screen<Cell, TheScreenType>::writeTextInternal(char32_t _char)
     auto const isAsciiBreakable = lastChar < 128 && codepoint < 128;
     // NB: This is an optimization for US-ASCII text versus grapheme cluster segmentation.
 
-    if (isAsciiBreakable || !lastChar || unicode::grapheme_segmenter::breakable(lastChar, codepoint))
+    if (isAsciiBreakable || !lastChar || GraphemeClusterTable::breakable(lastChar, codepoint))
     {
-        writeCharToCurrentAndAdvance(codepoint);
+        // A width looked up in advance is that of the codepoint prior to the charset mapping.
+        auto const width = _width && codepoint == _char
+                               ? *_width
+                               : static_cast<uint8_t>(CodepointProperties::width(codepoint));
+        writeCharToCurrentAndAdvance<Simple>(codepoint, width);
     }
     else
     {
         auto const extendedWidth = usePreviousCell().appendCharacter(codepoint);
         if (extendedWidth > 0)
-            clearAndAdvance(extendedWidth);
+            clearAndAdvance<Simple>(extendedWidth);
         _terminal.markCellDirty(_state.lastCursorPosition);
     }
 
@@ -475,27 +672,33 @@ void Screen<Cell, TheScreenType>::writeTextInternal(char32_t _char)
 }
 
 template <typename Cell, ScreenType TheScreenType>
-void Screen<Cell, TheScreenType>::writeCharToCurrentAndAdvance(char32_t _character) noexcept
+template <bool Simple>
+void Screen<Cell, TheScreenType>::writeCharToCurrentAndAdvance(char32_t _character,
+                                                               uint8_t _width) noexcept
 {
     Line<Cell>& line = currentLine();
 
-    Cell& cell = line.useCellAt(_state.cursor.position.column);
+    if (!line.holdsCharacter(_state.cursor.position.column,
+                             _state.cursor.graphicsRendition,
+                             _character,
+                             _width,
+                             _state.cursor.hyperlink))
+    {
+        Cell& cell = line.useCellAt(_state.cursor.position.column);
 
 #if defined(LINE_AVOID_CELL_RESET)
-    bool const consecutiveTextWrite = _state.sequencer.instructionCounter() == 1;
-    if (!consecutiveTextWrite)
-        cell.reset();
+        bool const consecutiveTextWrite = _state.sequencer.instructionCounter() == 1;
+        if (!consecutiveTextWrite)
+            cell.reset();
 #endif
 
-    cell.write(_state.cursor.graphicsRendition,
-               _character,
-               (uint8_t) unicode::width(_character),
-               _state.cursor.hyperlink);
+        cell.write(_state.cursor.graphicsRendition, _character, _width, _state.cursor.hyperlink);
+    }
 
     _state.lastCursorPosition = _state.cursor.position;
 
 #if 1
-    clearAndAdvance(cell.width());
+    clearAndAdvance<Simple>(_width);
 #else
     bool const cursorInsideMargin =
         _terminal.isModeEnabled(DECMode::LeftRightMargin) && _terminal.isCursorInsideMargins();
@@ -528,13 +731,14 @@ void Screen<Cell, TheScreenType>::writeCharToCurrentAndAdvance(char32_t _charact
 }
 
 template <typename Cell, ScreenType TheScreenType>
+template <bool Simple>
 void Screen<Cell, TheScreenType>::clearAndAdvance(int _graphemeClusterWidth) noexcept
 {
     if (_graphemeClusterWidth == 0)
         return;
 
     bool const cursorInsideMargin =
-        _terminal.isModeEnabled(DECMode::LeftRightMargin) && _terminal.isCursorInsideMargins();
+        !Simple && _terminal.isModeEnabled(DECMode::LeftRightMargin) && _terminal.isCursorInsideMargins();
     auto const cellsAvailable = cursorInsideMargin
                                     ? *(_state.margin.horizontal.to - _state.cursor.position.column) - 1
                                     : *_state.pageSize.columns - *_state.cursor.position.column - 1;
@@ -546,12 +750,17 @@ void Screen<Cell, TheScreenType>::clearAndAdvance(int _graphemeClusterWidth) noe
         auto& line = currentLine();
         for (int i = 1; i < n; ++i) // XXX It's not even clear if other TEs are doing that, too.
         {
-            line.useCellAt(_state.cursor.position.column)
-                .reset(_state.cursor.graphicsRendition, _state.cursor.hyperlink);
+            if (!line.holdsCharacter(_state.cursor.position.column,
+                                     _state.cursor.graphicsRendition,
+                                     0,
+                                     1,
+                                     _state.cursor.hyperlink))
+                line.useCellAt(_state.cursor.position.column)
+                    .reset(_state.cursor.graphicsRendition, _state.cursor.hyperlink);
             _state.cursor.position.column++;
         }
     }
-    else if (_state.cursor.autoWrap)
+    else if (Simple || _state.cursor.autoWrap)
     {
         _state.wrapPending = true;
     }
@@ -574,6 +783,39 @@ std::string Screen<Cell, TheScreenType>::screenshot(function<string(LineOffset)>
     return result.str();
 }
 
+template <typename Cell, ScreenType TheScreenType>
+std::string Screen<Cell, TheScreenType>::snapshot() const
+{
+    auto result = std::stringstream {};
+    auto writer = VTWriter(result);
+
+    // The lines that do not fit into the page scroll into the history on replay.
+    // Wrapped lines continue their predecessor instead, so that they can still be reflowed after replay.
+    auto const topLine = -unbox<int>(historyLineCount());
+    for (int const line: ranges::views::iota(topLine, *_state.pageSize.lines))
+    {
+        auto const& current = grid().lineAt(LineOffset(line));
+        if (line != topLine && !current.wrapped())
+            writer.crlf();
+        writer.write(current);
+
+        // A line only wraps into its successor on replay if it is written up to its last column.
+        auto const nextLine = line + 1;
+        if (nextLine < *_state.pageSize.lines && grid().lineAt(LineOffset(nextLine)).wrapped()
+            && lastColumnOmitted(current))
+        {
+            writer.setBackgroundColor(DefaultColor());
+            writer.write("\033[{}G ", unbox<int>(current.size()));
+        }
+    }
+    writer.sgrFlush();
+
+    auto const cursor = realCursorPosition();
+    writer.write("\033[{};{}H", *cursor.line + 1, *cursor.column + 1);
+
+    return result.str();
+}
+
 template <typename Cell, ScreenType TheScreenType>
 optional<LineOffset> Screen<Cell, TheScreenType>::findMarkerUpwards(LineOffset _startLine) const
 {
@@ -585,11 +827,7 @@ optional<LineOffset> Screen<Cell, TheScreenType>::findMarkerUpwards(LineOffset _
 
     _startLine = min(_startLine, boxed_cast<LineOffset>(_state.pageSize.lines - 1));
 
-    for (LineOffset i = _startLine - 1; i >= -boxed_cast<LineOffset>(historyLineCount()); --i)
-        if (grid().lineAt(i).marked())
-            return { i };
-
-    return nullopt;
+    return grid().findMarkerUpwards(_startLine);
 }
 
 template <typename Cell, ScreenType TheScreenType>
@@ -604,11 +842,7 @@ optional<LineOffset> Screen<Cell, TheScreenType>::findMarkerDownwards(LineOffset
 
     auto const bottom = LineOffset(0);
 
-    for (LineOffset i = top + 1; i <= bottom; ++i)
-        if (grid().lineAt(i).marked())
-            return { i };
-
-    return nullopt;
+    return grid().findMarkerDownwards(top, bottom);
 }
 
 // {{{ tabs related
@@ -665,6 +899,13 @@ void Screen<Cell, TheScreenType>::moveCursorTo(LineOffset _line, ColumnOffset _c
 
 template <typename Cell, ScreenType TheScreenType>
 void Screen<Cell, TheScreenType>::linefeed(ColumnOffset _newColumn)
+{
+    linefeed<false>(_newColumn);
+}
+
+template <typename Cell, ScreenType TheScreenType>
+template <bool Simple>
+void Screen<Cell, TheScreenType>::linefeed(ColumnOffset _newColumn)
 {
     _state.wrapPending = false;
     _state.cursor.position.column = _newColumn;
@@ -677,7 +918,15 @@ void Screen<Cell, TheScreenType>::linefeed(ColumnOffset _newColumn)
         // and make sure the subsequent text write will
         // possibly also reset remaining grid cells in that line
         // if the incoming text did not write to the full line
-        scrollUp(LineCount(1), {}, _state.margin);
+        if constexpr (Simple)
+        {
+            // Scrolls the full page without telling so from the margins first.
+            auto const scrollCount = grid().scrollUp(LineCount(1));
+            updateCursorIterator();
+            _terminal.onBufferScrolled(scrollCount);
+        }
+        else
+            scrollUp(LineCount(1), {}, _state.margin);
     }
     else
     {
@@ -869,9 +1118,8 @@ void Screen<Cell, TheScreenType>::eraseCharacters(ColumnCount _n)
         _state.pageSize.columns - boxed_cast<ColumnCount>(realCursorPosition().column);
     auto const n = unbox<long>(clamp(_n, ColumnCount(1), columnsAvailable));
 
-    auto& line = currentLine();
-    for (int i = 0; i < n; ++i)
-        line.useCellAt(_state.cursor.position.column + i).reset(_state.cursor.graphicsRendition);
+    currentLine().erase(
+        _state.cursor.position.column, ColumnCount::cast_from(n), _state.cursor.graphicsRendition);
 }
 
 template <typename Cell, ScreenType TheScreenType>
@@ -883,13 +1131,9 @@ void Screen<Cell, TheScreenType>::clearToEndOfLine()
         return;
     }
 
-    Cell* i = &at(_state.cursor.position);
-    Cell* e = i + unbox<int>(_state.pageSize.columns) - unbox<int>(_state.cursor.position.column);
-    while (i != e)
-    {
-        i->reset(_state.cursor.graphicsRendition);
-        ++i;
-    }
+    currentLine().erase(_state.cursor.position.column,
+                        _state.pageSize.columns - boxed_cast<ColumnCount>(_state.cursor.position.column),
+                        _state.cursor.graphicsRendition);
 
     auto const line = _state.cursor.position.line;
     auto const left = _state.cursor.position.column;
@@ -901,13 +1145,9 @@ void Screen<Cell, TheScreenType>::clearToEndOfLine()
 template <typename Cell, ScreenType TheScreenType>
 void Screen<Cell, TheScreenType>::clearToBeginOfLine()
 {
-    Cell* i = &at(_state.cursor.position.line, ColumnOffset(0));
-    Cell* e = i + unbox<int>(_state.cursor.position.column) + 1;
-    while (i != e)
-    {
-        i->reset(_state.cursor.graphicsRendition);
-        ++i;
-    }
+    currentLine().erase(ColumnOffset(0),
+                        boxed_cast<ColumnCount>(_state.cursor.position.column) + ColumnCount(1),
+                        _state.cursor.graphicsRendition);
 
     auto const line = _state.cursor.position.line;
     auto const left = ColumnOffset(0);
@@ -1145,19 +1385,24 @@ template <typename Cell, ScreenType TheScreenType>
 void Screen<Cell, TheScreenType>::hyperlink(string _id, string _uri)
 {
     if (_uri.empty())
+    {
         _state.cursor.hyperlink = {};
-    else if (!_id.empty())
-        _state.cursor.hyperlink = _state.hyperlinks.hyperlinkIdByUserId(_id);
-    else
+        return;
+    }
+
+    if (_state.hyperlinks.needsCollection())
     {
-        _state.cursor.hyperlink = _state.hyperlinks.nextHyperlinkId++;
-        _state.hyperlinks.cache.emplace(_state.cursor.hyperlink,
-                                        make_shared<HyperlinkInfo>(HyperlinkInfo { move(_id), move(_uri) }));
+        // Hyperlinks are kept alive by the cells (and cursors) referring to them.
+        _state.hyperlinks.collectGarbage([&](auto _markUsed) {
+            _state.primaryBuffer.forEachHyperlink(_markUsed);
+            _state.alternateBuffer.forEachHyperlink(_markUsed);
+            _markUsed(_state.cursor.hyperlink);
+            _markUsed(_state.savedCursor.hyperlink);
+            _markUsed(_state.savedPrimaryCursor.hyperlink);
+        });
     }
-    // TODO:
-    // Care about eviction.
-    // Move hyperlink store into ScreenBuffer, so it gets reset upon every switch into
-    // alternate screen (not for main screen!)
+
+    _state.cursor.hyperlink = _state.hyperlinks.intern(_id, _uri);
 }
 
 template <typename Cell, ScreenType TheScreenType>
@@ -1283,8 +1528,6 @@ void Screen<Cell, TheScreenType>::captureBuffer(LineCount _lineCount, bool _logi
 {
     // TODO: Unit test case! (for ensuring line numbering and limits are working as expected)
 
-    auto capturedBuffer = std::string();
-
     // TODO: when capturing _lineCount < screenSize.lines, start at the lowest non-empty line.
     auto const relativeStartLine =
         _logicalLines ? grid().computeLogicalLineNumberFromBottom(LineCount::cast_from(_lineCount))
@@ -1294,53 +1537,62 @@ void Screen<Cell, TheScreenType>::captureBuffer(LineCount _lineCount, bool _logi
 
     VTCaptureBufferLog()("Capture buffer: {} lines {}", _lineCount, _logicalLines ? "logical" : "actual");
 
+    // The text is collected into chunks that are replied as a whole, preferably split at line
+    // boundaries, so that the reply does not need to be assembled cell by cell.
     size_t constexpr MaxChunkSize = 4096;
-    size_t currentChunkSize = 0;
-    auto const pushContent = [&](auto const data) -> void {
-        if (data.empty())
+    auto chunk = std::string();
+    auto const flushChunk = [&]() {
+        if (chunk.empty())
             return;
-        if (currentChunkSize == 0) // initiate chunk
-            _terminal.reply("\033^{};", CaptureBufferCode);
-        else if (currentChunkSize + data.size() >= MaxChunkSize)
+        VTCaptureBufferLog()("Transferred chunk of {} bytes.", chunk.size());
+        _terminal.reply("\033^{};{}\033\\", CaptureBufferCode, chunk);
+        chunk.clear();
+    };
+    auto const pushContent = [&](string_view data) {
+        if (chunk.size() + data.size() > MaxChunkSize)
+            flushChunk();
+        while (data.size() > MaxChunkSize)
         {
-            VTCaptureBufferLog()("Transferred chunk of {} bytes.", currentChunkSize);
-            _terminal.reply("\033\\"); // ST
-            _terminal.reply("\033^{};", CaptureBufferCode);
-            currentChunkSize = 0;
-        }
-        _terminal.reply(data);
-        currentChunkSize += data.size();
+            // Never split a UTF-8 sequence across chunks.
+            auto n = MaxChunkSize;
+            while (n > 0 && (static_cast<uint8_t>(data[n]) & 0xC0) == 0x80)
+                --n;
+            chunk.append(data.substr(0, n));
+            flushChunk();
+            data.remove_prefix(n);
+        }
+        chunk.append(data);
     };
+
     LineOffset const bottomLine = boxed_cast<LineOffset>(_state.pageSize.lines - 1);
     VTCaptureBufferLog()("Capturing buffer. top: {}, bottom: {}", relativeStartLine, bottomLine);
 
+    auto lineText = std::string();
+    auto newlinePending = false;
     for (LineOffset line = startLine; line <= bottomLine; ++line)
     {
-        if (_logicalLines && grid().lineAt(line).wrapped() && !capturedBuffer.empty())
-            capturedBuffer.pop_back();
-
         auto const& lineBuffer = grid().lineAt(line);
-        auto lineCellsTrimmed = lineBuffer.trim_blank_right();
+        auto const lineCellsTrimmed = lineBuffer.trim_blank_right();
         if (lineCellsTrimmed.empty())
         {
             VTCaptureBufferLog()("Skipping blank line {}", line);
             continue;
         }
-        auto const tl = lineCellsTrimmed.size();
-        while (!lineCellsTrimmed.empty())
-        {
-            auto const available = MaxChunkSize - currentChunkSize;
-            auto const n = min(available, lineCellsTrimmed.size());
-            for (auto const& cell: lineCellsTrimmed.subspan(0, n))
-                pushContent(cell.toUtf8());
-            lineCellsTrimmed = lineCellsTrimmed.subspan(n);
-        }
-        VTCaptureBufferLog()("NL ({} len)", tl);
-        pushContent("\n"sv);
-    }
 
-    if (currentChunkSize != 0)
-        _terminal.reply("\033\\"); // ST
+        // Logical lines are joined with their wrapped continuation lines.
+        lineText.clear();
+        if (newlinePending && !(_logicalLines && lineBuffer.wrapped()))
+            lineText += '\n';
+        for (auto const& cell: lineCellsTrimmed)
+            lineText += cell.toUtf8();
+        newlinePending = true;
+
+        VTCaptureBufferLog()("Line {} ({} len)", line, lineCellsTrimmed.size());
+        pushContent(lineText);
+    }
+    if (newlinePending)
+        pushContent("\n"sv);
+    flushChunk();
 
     VTCaptureBufferLog()("Capturing buffer finished.");
     _terminal.reply("\033^{};\033\\", CaptureBufferCode); // mark the end
@@ -1561,7 +1813,8 @@ void Screen<Cell, TheScreenType>::singleShiftSelect(CharsetTable _table)
 }
 
 template <typename Cell, ScreenType TheScreenType>
-void Screen<Cell, TheScreenType>::sixelImage(ImageSize _pixelSize, Image::Data&& _data)
+shared_ptr<RasterizedImage> Screen<Cell, TheScreenType>::sixelImage(ImageSize _pixelSize,
+                                                                     Image::Data&& _data)
 {
     auto const columnCount =
         ColumnCount::cast_from(ceilf(float(*_pixelSize.width) / float(*_state.cellPixelSize.width)));
@@ -1579,17 +1832,19 @@ void Screen<Cell, TheScreenType>::sixelImage(ImageSize _pixelSize, Image::Data&&
     auto const imageSize = _pixelSize;
 
     shared_ptr<Image const> imageRef = uploadImage(ImageFormat::RGBA, _pixelSize, move(_data));
-    renderImage(imageRef,
-                topLeft,
-                extent,
-                imageOffset,
-                imageSize,
-                alignmentPolicy,
-                resizePolicy,
-                autoScrollAtBottomMargin);
+    auto rasterizedImage = renderImage(imageRef,
+                                       topLeft,
+                                       extent,
+                                       imageOffset,
+                                       imageSize,
+                                       alignmentPolicy,
+                                       resizePolicy,
+                                       autoScrollAtBottomMargin);
 
     if (!_terminal.isModeEnabled(DECMode::SixelCursorNextToGraphic))
         linefeed(topLeft.column);
+
+    return rasterizedImage;
 }
 
 template <typename Cell, ScreenType TheScreenType>
@@ -1601,14 +1856,14 @@ shared_ptr<Image const> Screen<Cell, TheScreenType>::uploadImage(ImageFormat _fo
 }
 
 template <typename Cell, ScreenType TheScreenType>
-void Screen<Cell, TheScreenType>::renderImage(shared_ptr<Image const> _image,
-                                              CellLocation _topLeft,
-                                              GridSize _gridSize,
-                                              PixelCoordinate _imageOffset,
-                                              ImageSize _imageSize,
-                                              ImageAlignment _alignmentPolicy,
-                                              ImageResize _resizePolicy,
-                                              bool _autoScroll)
+shared_ptr<RasterizedImage> Screen<Cell, TheScreenType>::renderImage(shared_ptr<Image const> _image,
+                                                                     CellLocation _topLeft,
+                                                                     GridSize _gridSize,
+                                                                     PixelCoordinate _imageOffset,
+                                                                     ImageSize _imageSize,
+                                                                     ImageAlignment _alignmentPolicy,
+                                                                     ImageResize _resizePolicy,
+                                                                     bool _autoScroll)
 {
     // TODO: make use of _imageOffset and _imageSize
     (void) _imageOffset;
@@ -1657,6 +1912,206 @@ void Screen<Cell, TheScreenType>::renderImage(shared_ptr<Image const> _image,
     }
     // move ansi text cursor to position of the sixel cursor
     moveCursorToColumn(_topLeft.column + _gridSize.columns.as<ColumnOffset>());
+
+    return rasterizedImage;
+}
+
+template <typename Cell, ScreenType TheScreenType>
+bool Screen<Cell, TheScreenType>::replaceImageFragments(RasterizedImage const& _placeholder,
+                                                        shared_ptr<RasterizedImage> const& _image,
+                                                        LineOffset _firstLine)
+{
+    auto const lastLine = _firstLine + boxed_cast<LineOffset>(_image->cellSpan().lines);
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    auto const cellCount =
+        unbox<size_t>(_image->cellSpan().lines) * unbox<size_t>(_placeholder.cellSpan().columns);
+    auto replaced = size_t { 0 };
+    auto found = false;
+
+    // All cells of a grid line hold the same line of an image, so the search is over once the grid line
+    // holding the first of the replaced lines of the image is done, or all of its cells are replaced.
+    for (auto line = boxed_cast<LineOffset>(_state.pageSize.lines) - 1; line >= top && replaced < cellCount;
+         --line)
+    {
+        Line<Cell>& gridLine = grid().lineAt(line);
+        if (gridLine.isTrivialBuffer())
+            continue;
+
+        auto reachedFirstLine = false;
+        auto const cells = gridLine.cells();
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            auto const fragment = cells[i].imageFragment();
+            if (!fragment || &fragment->rasterizedImage() != &_placeholder)
+                continue;
+
+            found = true;
+            auto offset = fragment->offset();
+            reachedFirstLine = offset.line <= _firstLine;
+            if (offset.line < _firstLine || offset.line >= lastLine)
+                continue;
+
+            offset.line -= _firstLine;
+            gridLine.useCellAt(ColumnOffset::cast_from(i)).setImageFragment(_image, offset);
+            ++replaced;
+        }
+        if (reachedFirstLine)
+            break;
+    }
+
+    return found;
+}
+
+template <typename Cell, ScreenType TheScreenType>
+void Screen<Cell, TheScreenType>::applicationProgramCommand(string_view _data)
+{
+    if (_data.empty() || _data.front() != 'G')
+        return;
+
+    auto command = KittyGraphicsCommand::parse(_data.substr(1));
+    if (!command)
+    {
+        VTParserLog()("Invalid kitty graphics command: {}", _data.substr(0, 64));
+        return;
+    }
+
+    // Payloads may be split across multiple commands, with only the first one carrying
+    // the full control data.
+    if (auto& pending = _state.pendingKittyGraphicsCommand; pending)
+    {
+        // The payload is dropped once it grows too large, and the command fails when complete.
+        if (pending->oversized
+            || pending->payload.size() + command->payload.size() > maxKittyPayloadSize(_state.maxImageSize))
+        {
+            pending->oversized = true;
+            pending->payload = string();
+        }
+        else
+            pending->payload += command->payload;
+        if (command->more)
+            return;
+        command = move(pending);
+        pending.reset();
+    }
+    else if (command->more)
+    {
+        pending = move(command);
+        return;
+    }
+
+    kittyGraphics(*command);
+}
+
+template <typename Cell, ScreenType TheScreenType>
+void Screen<Cell, TheScreenType>::kittyGraphics(KittyGraphicsCommand const& _command)
+{
+    using Action = KittyGraphicsCommand::Action;
+
+    auto const respond = [&](string_view _status) {
+        auto const ok = _status == "OK";
+        if (!_command.imageId || (ok && _command.quiet >= 1) || _command.quiet >= 2)
+            return;
+        _terminal.reply("\033_Gi={};{}\033\\", _command.imageId, _status);
+    };
+    auto const imageName = fmt::format("kitty:{}", _command.imageId);
+
+    switch (_command.action)
+    {
+        case Action::Transmit:
+        case Action::TransmitAndDisplay:
+        case Action::Query: {
+            auto loaded = loadKittyImage(_command, _state.maxImageSize, _state.kittyGraphicsFileAccess);
+            if (auto const* error = std::get_if<string>(&loaded))
+            {
+                respond(*error);
+                return;
+            }
+            if (_command.action == Action::Query)
+            {
+                respond("OK");
+                return;
+            }
+            auto& loadedImage = std::get<KittyImage>(loaded);
+            auto const png = string_view(reinterpret_cast<char const*>(loadedImage.data.data()),
+                                         loadedImage.data.size());
+
+            if (loadedImage.png && _command.action == Action::TransmitAndDisplay && !_command.imageId
+                && png.size() >= SixelDecoder::AsyncThreshold)
+            {
+                // Reserve the grid cells right away and let the image be decoded off the terminal
+                // thread. Images that are referred to by ID later on need to be decoded already.
+                // The placeholder takes the size from the PNG header, but has no pixels yet.
+                auto const size = loadedImage.size;
+                auto placeholder =
+                    placeKittyImage(uploadImage(ImageFormat::RGBA, size, Image::Data {}), _command);
+                auto job = SixelDecoder::Job { string(png), {}, placeholder };
+                job.format = SixelDecoder::Format::Png;
+                job.size = size;
+                _terminal.sixelDecoder().decode(move(job));
+                respond("OK");
+                break;
+            }
+
+            if (loadedImage.png)
+            {
+                auto pixels = decodePng(png, loadedImage.size);
+                if (!pixels)
+                {
+                    respond("EBADPNG:could not decode PNG image");
+                    return;
+                }
+                loadedImage.data = move(*pixels);
+            }
+
+            auto image = uploadImage(ImageFormat::RGBA, loadedImage.size, move(loadedImage.data));
+            if (_command.imageId)
+                _state.imagePool.link(imageName, image);
+            if (_command.action == Action::TransmitAndDisplay)
+                placeKittyImage(move(image), _command);
+            respond("OK");
+            break;
+        }
+        case Action::Put:
+            if (auto image = _state.imagePool.findImageByName(imageName))
+            {
+                placeKittyImage(move(image), _command);
+                respond("OK");
+            }
+            else
+                respond("ENOENT:image not found");
+            break;
+        case Action::Delete:
+            // Placements are ordinary grid cells and go away as they get overwritten.
+            if (_command.deleteTarget == 'i' || _command.deleteTarget == 'I')
+                _state.imagePool.unlink(imageName);
+            break;
+    }
+}
+
+template <typename Cell, ScreenType TheScreenType>
+shared_ptr<RasterizedImage> Screen<Cell, TheScreenType>::placeKittyImage(
+    shared_ptr<Image const> _image, KittyGraphicsCommand const& _command)
+{
+    auto const imageSize = _image->size();
+    auto const extent = GridSize {
+        LineCount::cast_from(ceilf(float(*imageSize.height) / float(*_state.cellPixelSize.height))),
+        ColumnCount::cast_from(ceilf(float(*imageSize.width) / float(*_state.cellPixelSize.width)))
+    };
+    auto const cursorPosition = logicalCursorPosition();
+
+    auto rasterizedImage = renderImage(move(_image),
+                                       cursorPosition,
+                                       extent,
+                                       PixelCoordinate {},
+                                       imageSize,
+                                       ImageAlignment::TopStart,
+                                       ImageResize::NoResize,
+                                       true);
+
+    if (!_command.moveCursor)
+        moveCursorTo(cursorPosition.line, cursorPosition.column);
+
+    return rasterizedImage;
 }
 
 template <typename Cell, ScreenType TheScreenType>
@@ -1970,6 +2425,14 @@ void Screen<Cell, TheScreenType>::inspect(std::string const& _message, std::ostr
     _os << fmt::format("vertical margins     : {}\n", _state.margin.vertical);
     _os << fmt::format("horizontal margins   : {}\n", _state.margin.horizontal);
     _os << gridInfoLine(grid());
+    _os << fmt::format("cold history         : {} lines compacted, {} bytes saved\n",
+                       grid().coldHistoryStats().linesCompacted,
+                       grid().coldHistoryStats().bytesSaved);
+    _os << fmt::format("PTY buffer objects   : {} live, {} peak, {} allocated, {} recycled\n",
+                       _terminal.ptyBufferPoolStats().live,
+                       _terminal.ptyBufferPoolStats().peak,
+                       _terminal.ptyBufferPoolStats().allocated,
+                       _terminal.ptyBufferPoolStats().recycled);
 
     hline();
     _os << screenshot([this](LineOffset _lineNo) -> string {
@@ -3305,6 +3768,13 @@ ApplyResult Screen<Cell, TheScreenType>::apply(FunctionDefinition const& functio
         case STP: _state.sequencer.hookParser(hookSTP(seq)); break;
         case DECRQSS: _state.sequencer.hookParser(hookDECRQSS(seq)); break;
         case XTGETTCAP: _state.sequencer.hookParser(hookXTGETTCAP(seq)); break;
+        case TMUXCC:
+            if (seq.param(0) != 1000)
+                return ApplyResult::Invalid;
+            if (!_state.tmuxControlMode)
+                return ApplyResult::Unsupported;
+            _state.sequencer.hookParser(_terminal.hookTmuxControl());
+            break;
 
         default: return ApplyResult::Unsupported;
     }
@@ -3337,7 +3807,7 @@ unique_ptr<ParserExtension> Screen<Cell, TheScreenType>::hookSixel(Sequence cons
     auto const aspectHorizontal = 1;
     auto const transparentBackground = Pb == 1;
 
-    sixelImageBuilder_ = make_unique<SixelImageBuilder>(
+    auto parameters = SixelDecoder::Parameters {
         _terminal.state().maxImageSize,
         aspectVertical,
         aspectHorizontal,
@@ -3345,13 +3815,53 @@ unique_ptr<ParserExtension> Screen<Cell, TheScreenType>::hookSixel(Sequence cons
         _terminal.state().usePrivateColorRegisters
             ? make_shared<SixelColorPalette>(_terminal.state().maxImageRegisterCount,
                                              clamp(_terminal.state().maxImageRegisterCount, 0u, 16384u))
-            : _terminal.state().imageColorPalette);
+            : _terminal.state().imageColorPalette
+    };
 
-    return make_unique<SixelParser>(*sixelImageBuilder_, [this]() {
+    // Grid cells reserved for an image that is being decoded progressively.
+    auto placeholder = make_shared<shared_ptr<RasterizedImage>>();
+
+    auto handlers = ProgressiveSixelCollector::Handlers {};
+    handlers.complete = [this, parameters](string_view _data) {
+        // Only images announcing their size can have their grid cells reserved up front.
+        auto const size = SixelDecoder::imageSize(_data, parameters.maxSize);
+        if (_data.size() < SixelDecoder::AsyncThreshold || !size || !size->area())
         {
-            sixelImage(sixelImageBuilder_->size(), move(sixelImageBuilder_->data()));
+            auto [decodedSize, pixels] = SixelDecoder::decodeNow(_data, parameters);
+            sixelImage(decodedSize, move(pixels));
+            return;
         }
-    });
+
+        // Reserve the grid cells right away and let the image be decoded off the terminal thread.
+        // The worker decodes with a copy of the color palette, which the terminal keeps on using.
+        auto jobParameters = parameters;
+        jobParameters.colorPalette = make_shared<SixelColorPalette>(*parameters.colorPalette);
+        auto placeholder = sixelImage(*size, Image::Data {});
+        _terminal.sixelDecoder().decode(
+            SixelDecoder::Job { string(_data), move(jobParameters), placeholder });
+    };
+    handlers.start = [this, placeholder](ImageSize _size) {
+        *placeholder = sixelImage(_size, Image::Data {});
+    };
+    handlers.rows = [this, placeholder](int _firstRow, ImageSize _size, Image::Data _pixels) {
+        // Nothing is left to replace once the image's cells have been overwritten or scrolled out.
+        if (placeholder->use_count() == 1)
+            return;
+
+        auto const& reserved = **placeholder;
+        auto const cellHeight = unbox<int>(reserved.cellSize().height);
+        auto const lineCount = LineCount::cast_from((unbox<int>(_size.height) + cellHeight - 1) / cellHeight);
+        auto const rows = _state.imagePool.rasterize(uploadImage(ImageFormat::RGBA, _size, move(_pixels)),
+                                                     reserved.alignmentPolicy(),
+                                                     reserved.resizePolicy(),
+                                                     reserved.defaultColor(),
+                                                     GridSize { lineCount, reserved.cellSpan().columns },
+                                                     reserved.cellSize());
+        replaceImageFragments(reserved, rows, LineOffset::cast_from(_firstRow / cellHeight));
+    };
+
+    return make_unique<ProgressiveSixelCollector>(
+        move(parameters), unbox<int>(_state.cellPixelSize.height), move(handlers));
 }
 
 template <typename Cell, ScreenType TheScreenType>
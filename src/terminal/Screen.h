@@ -19,6 +19,7 @@
 #include <terminal/Grid.h>
 #include <terminal/Hyperlink.h>
 #include <terminal/Image.h>
+#include <terminal/KittyGraphics.h>
 #include <terminal/Parser.h>
 #include <terminal/ScreenEvents.h>
 #include <terminal/TerminalState.h>
@@ -65,10 +66,13 @@ class ScreenBase: public SequenceHandler
     [[nodiscard]] virtual bool isLineEmpty(LineOffset line) const noexcept = 0;
     [[nodiscard]] virtual uint8_t cellWithAt(CellLocation position) const noexcept = 0;
     [[nodiscard]] virtual LineCount historyLineCount() const noexcept = 0;
+    [[nodiscard]] virtual LineCount scrollbackLineCount() const noexcept = 0;
     [[nodiscard]] virtual HyperlinkId hyperlinkIdAt(CellLocation position) const noexcept = 0;
-    [[nodiscard]] virtual std::shared_ptr<HyperlinkInfo const> hyperlinkAt(
-        CellLocation pos) const noexcept = 0;
+    [[nodiscard]] virtual HyperlinkInfo const* hyperlinkAt(CellLocation pos) const noexcept = 0;
     virtual void inspect(std::string const& _message, std::ostream& _os) const = 0;
+
+    /// Handles the contents of an APC (application program command), such as kitty graphics.
+    virtual void applicationProgramCommand(std::string_view _data) = 0;
 };
 
 //#define LIBTERMINAL_CURRENT_LINE_CACHE 1
@@ -102,6 +106,7 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
     // {{{ SequenceHandler overrides
     void writeText(char32_t _char) override;
     void writeText(std::string_view _chars, size_t cellCount) override;
+    void writeText(std::u32string_view _chars) override;
     void executeControlCode(char controlCode) override;
     void processSequence(Sequence const& seq) override;
     // }}}
@@ -113,6 +118,16 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
         _grid.render(std::forward<Renderer>(_render), _scrollOffset);
     }
 
+    /// Renders the screen lines [_first, _last) by passing their grid cells to the callback.
+    template <typename Renderer>
+    void renderLines(Renderer&& _render,
+                     ScrollOffset _scrollOffset,
+                     LineOffset _first,
+                     LineOffset _last) const
+    {
+        _grid.renderLines(std::forward<Renderer>(_render), _scrollOffset, _first, _last);
+    }
+
     /// Renders the full screen as text into the given string. Each line will be terminated by LF.
     [[nodiscard]] std::string renderMainPageText() const;
 
@@ -124,6 +139,10 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
     ///          including initial clear screen, and initial cursor hide.
     std::string screenshot(std::function<std::string(LineOffset)> const& _postLine = {}) const;
 
+    /// Serializes all lines, including the scrollback history, and the cursor position
+    /// into VT sequences that restore them when written to a fresh terminal of the same size.
+    [[nodiscard]] std::string snapshot() const;
+
     void crlf() { linefeed(_state.margin.horizontal.from); }
     void crlfIfWrapPending();
 
@@ -207,7 +226,7 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
     void singleShiftSelect(CharsetTable _table);
     void requestPixelSize(RequestPixelSize _area);
     void requestCharacterSize(RequestPixelSize _area);
-    void sixelImage(ImageSize _pixelSize, Image::Data&& _rgba);
+    std::shared_ptr<RasterizedImage> sixelImage(ImageSize _pixelSize, Image::Data&& _rgba);
     void requestStatusString(RequestStatusString _value);
     void requestTabStops();
     void resetDynamicColor(DynamicColorName _name);
@@ -235,18 +254,36 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
      * @p _resizePolicy render the image using the given image resize policy.
      * @p _autoScroll Boolean indicating whether or not the screen should scroll if the image cannot be fully
      * displayed otherwise.
+     *
+     * @returns the rasterized image whose fragments have been placed onto the grid.
      */
-    void renderImage(std::shared_ptr<Image const> _image,
-                     CellLocation _topLeft,
-                     GridSize _gridSize,
-                     PixelCoordinate _imageOffset,
-                     ImageSize _imageSize,
-                     ImageAlignment _alignmentPolicy,
-                     ImageResize _resizePolicy,
-                     bool _autoScroll);
+    std::shared_ptr<RasterizedImage> renderImage(std::shared_ptr<Image const> _image,
+                                                 CellLocation _topLeft,
+                                                 GridSize _gridSize,
+                                                 PixelCoordinate _imageOffset,
+                                                 ImageSize _imageSize,
+                                                 ImageAlignment _alignmentPolicy,
+                                                 ImageResize _resizePolicy,
+                                                 bool _autoScroll);
+
+    /// Replaces all image fragments of @p _placeholder in the grid (including history)
+    /// with the respective fragments of @p _image.
+    ///
+    /// If @p _image only covers the lines of @p _placeholder starting at @p _firstLine,
+    /// only those fragments are replaced.
+    ///
+    /// The grid is searched from the bottom up, where images are usually still being received,
+    /// and only until the lines above the replaced ones are reached.
+    ///
+    /// @returns whether any fragment of @p _placeholder was found.
+    bool replaceImageFragments(RasterizedImage const& _placeholder,
+                               std::shared_ptr<RasterizedImage> const& _image,
+                               LineOffset _firstLine = LineOffset(0));
 
     void inspect(std::string const& _message, std::ostream& _os) const override;
 
+    void applicationProgramCommand(std::string_view _data) override;
+
     // for DECSC and DECRC
     void saveModes(std::vector<DECMode> const& _modes);
     void restoreModes(std::vector<DECMode> const& _modes);
@@ -428,13 +465,13 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
 
     [[nodiscard]] bool isCellEmpty(CellLocation position) const noexcept override
     {
-        return grid().lineAt(position.line).cellEmptyAt(position.column);
+        return grid().scrollbackLineAt(position.line).cellEmptyAt(position.column);
     }
 
     [[nodiscard]] bool compareCellTextAt(CellLocation position, char codepoint) const noexcept override
     {
         return grid()
-            .lineAt(position.line)
+            .scrollbackLineAt(position.line)
             .inflatedBuffer()
             .at(position.column.as<size_t>())
             .compareText(codepoint);
@@ -442,28 +479,33 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
 
     [[nodiscard]] bool isLineEmpty(LineOffset line) const noexcept override
     {
-        return grid().lineAt(line).empty();
+        return grid().scrollbackLineAt(line).empty();
     }
 
     [[nodiscard]] uint8_t cellWithAt(CellLocation position) const noexcept override
     {
-        return grid().lineAt(position.line).cellWithAt(position.column);
+        return grid().scrollbackLineAt(position.line).cellWithAt(position.column);
     }
 
     [[nodiscard]] LineCount historyLineCount() const noexcept override { return grid().historyLineCount(); }
 
+    [[nodiscard]] LineCount scrollbackLineCount() const noexcept override
+    {
+        return grid().scrollbackLineCount();
+    }
+
     [[nodiscard]] HyperlinkId hyperlinkIdAt(CellLocation position) const noexcept override
     {
-        auto const& line = grid().lineAt(position.line);
+        auto const& line = grid().scrollbackLineAt(position.line);
         if (line.isTrivialBuffer())
         {
             TriviallyStyledLineBuffer const& lineBuffer = line.trivialBuffer();
             return lineBuffer.hyperlink;
         }
-        return at(position).hyperlink();
+        return line.inflatedBuffer().at(unbox<size_t>(position.column)).hyperlink();
     }
 
-    [[nodiscard]] std::shared_ptr<HyperlinkInfo const> hyperlinkAt(CellLocation pos) const noexcept override
+    [[nodiscard]] HyperlinkInfo const* hyperlinkAt(CellLocation pos) const noexcept override
     {
         return _state.hyperlinks.hyperlinkById(hyperlinkIdAt(pos));
     }
@@ -483,11 +525,37 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
     void fail(std::string const& _message) const override;
 
   private:
-    void writeTextInternal(char32_t _char);
+    /// Writes @p _char, whose width may have been looked up in advance already.
+    void writeTextInternal(char32_t _char, std::optional<uint8_t> _width = std::nullopt);
+
+    /// Tests whether text is written with auto-wrap enabled and without any margins, which is
+    /// the overwhelmingly common case.
+    ///
+    /// The write path is instantiated for it separately (Simple = true), so that margins and
+    /// auto-wrap are not re-checked for every character. As no mode can change in the middle of
+    /// a run of text, the instantiation is picked once per run.
+    [[nodiscard]] bool isSimpleWriteConfiguration() const noexcept;
+
+    template <bool Simple>
+    void writeTextRun(std::u32string_view _chars);
+    template <bool Simple>
+    void writeTextInternal(char32_t _char, std::optional<uint8_t> _width);
+    template <bool Simple>
+    void crlfIfWrapPending();
+
+    /// Writes the leading US-ASCII characters of @p _chars that fit into the current line
+    /// in one go and advances the cursor once.
+    ///
+    /// @returns the number of characters written.
+    size_t writeTextIntoCurrentLine(std::string_view _chars);
     std::string_view tryEmplaceChars(std::string_view chars, size_t cellCount) noexcept;
     std::string_view tryEmplaceContinuousChars(std::string_view chars, size_t cellCount) noexcept;
     size_t emplaceCharsIntoCurrentLine(std::string_view chars, size_t cellCount) noexcept;
     [[nodiscard]] bool canResumeEmplace(std::string_view continuationChars) const noexcept;
+    /// Tests whether text written at the cursor can be appended to the current line
+    /// while keeping it trivially styled, i.e. the cursor is right behind the line's text
+    /// and the current SGR and hyperlink match those of the line.
+    [[nodiscard]] bool canAppendToTrivialLine() const noexcept;
     void advanceCursorAfterWrite(ColumnCount n) noexcept;
 
     void clearAllTabs();
@@ -496,8 +564,12 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
 
     /// Applies LF but also moves cursor to given column @p _column.
     void linefeed(ColumnOffset _column);
+    template <bool Simple>
+    void linefeed(ColumnOffset _column);
 
-    void writeCharToCurrentAndAdvance(char32_t _codepoint) noexcept;
+    template <bool Simple>
+    void writeCharToCurrentAndAdvance(char32_t _codepoint, uint8_t _width) noexcept;
+    template <bool Simple>
     void clearAndAdvance(int _offset) noexcept;
 
     void scrollUp(LineCount n, GraphicsAttributes sgr, Margin margin);
@@ -514,6 +586,10 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
     [[nodiscard]] std::unique_ptr<ParserExtension> hookDECRQSS(Sequence const& seq);
     [[nodiscard]] std::unique_ptr<ParserExtension> hookXTGETTCAP(Sequence const& seq);
 
+    void kittyGraphics(KittyGraphicsCommand const& _command);
+    std::shared_ptr<RasterizedImage> placeKittyImage(std::shared_ptr<Image const> _image,
+                                                     KittyGraphicsCommand const& _command);
+
     Terminal& _terminal;
     TerminalState& _state;
     ScreenType const _screenType;
@@ -521,7 +597,6 @@ class Screen: public ScreenBase, public capabilities::StaticDatabase
 #if defined(LIBTERMINAL_CURRENT_LINE_CACHE)
     Line<Cell>* _currentLine = nullptr;
 #endif
-    std::unique_ptr<SixelImageBuilder> sixelImageBuilder_;
 };
 
 template <typename Cell, ScreenType TheScreenType>
@@ -102,6 +102,7 @@ struct TextRenderBuilder
 {
     std::string text;
 
+    bool tryReuseLine(LineOffset, uint64_t) { return false; }
     void startLine(LineOffset lineOffset);
     void renderCell(Cell const& cell, LineOffset lineOffset, ColumnOffset columnOffset);
     void endLine();
@@ -322,6 +323,79 @@ TEST_CASE("writeText.bulk.H", "[screen]")
     CHECK(screen.cursor().position == CellLocation { LineOffset(1), ColumnOffset(9) });
 }
 
+// Text spans multiple lines within left/right margins.
+TEST_CASE("writeText.bulk.I", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.terminal.setMode(DECMode::LeftRightMargin, true);
+    mock.terminal.setLeftRightMargin(ColumnOffset(2), ColumnOffset(5));
+    mock.writeToScreen("\033[1;3H");
+    REQUIRE(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(2) });
+
+    mock.writeToScreen("ABCDEFG");
+
+    logScreenText(screen, "final state");
+    CHECK(screen.grid().lineText(LineOffset(0)) == "  ABCD    ");
+    CHECK(screen.grid().lineText(LineOffset(1)) == "  EFG     ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(1), ColumnOffset(5) });
+}
+
+// Non-US-ASCII text wrapping inside a scroll region, then on the full page.
+TEST_CASE("writeText.unicode.scrollRegion", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(4) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+
+    mock.writeToScreen("\033[1;2r");
+    mock.writeToScreen("ÄÖÜßäöüéèê");
+    logScreenText(screen, "inside scroll region");
+    CHECK(screen.grid().lineText(LineOffset(0)) == "äöüé");
+    CHECK(screen.grid().lineText(LineOffset(1)) == "èê  ");
+    CHECK(screen.grid().lineText(LineOffset(2)) == "    ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(1), ColumnOffset(2) });
+
+    mock.writeToScreen("\033[r\033[3;1H");
+    mock.writeToScreen("ÀÁÂÃÄÅ");
+    logScreenText(screen, "full page");
+    CHECK(screen.grid().lineText(LineOffset(-1)) == "äöüé");
+    CHECK(screen.grid().lineText(LineOffset(0)) == "èê  ");
+    CHECK(screen.grid().lineText(LineOffset(1)) == "ÀÁÂÃ");
+    CHECK(screen.grid().lineText(LineOffset(2)) == "ÄÅ  ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(2), ColumnOffset(2) });
+}
+
+TEST_CASE("writeText.trivial.append", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+
+    // A redundant SGR interrupts the text, so that the second write is not contiguous
+    // to the line's text in the PTY buffer.
+    mock.writeToScreen("AB\033[mCD");
+    mock.writeToScreen("\033[mEF");
+
+    CHECK(screen.grid().lineAt(LineOffset(0)).isTrivialBuffer());
+    CHECK(screen.grid().lineText(LineOffset(0)) == "ABCDEF    ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(6) });
+
+    // Changing the SGR does inflate the line.
+    mock.writeToScreen("\033[1mG");
+    CHECK(screen.grid().lineAt(LineOffset(0)).isInflatedBuffer());
+    CHECK(screen.grid().lineText(LineOffset(0)) == "ABCDEFG   ");
+}
+
+TEST_CASE("writeText.bulk.charset", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(10) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+
+    // DEC Special Graphics maps each character, US-ASCII takes the bulk path again.
+    mock.writeToScreen("\033(0qqx\033(Bqqx");
+    CHECK(screen.grid().lineText(LineOffset(0)) == "\u2500\u2500\u2502qqx    ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(6) });
+}
+
 // TODO: Test spanning writes over all history and then reusing old lines.
 // Verify we do not leak any old cell attribs.
 
@@ -1484,30 +1558,33 @@ TEST_CASE("ScrollDown", "[screen]")
         mock.terminal.setTopBottomMargin(LineOffset { 1 }, LineOffset { 3 });
         mock.terminal.setMode(DECMode::Origin, true);
 
-        // SECTION("SD 1") {
-        //     screen.scrollDown(LineCount(1));
-        //     CHECK("12345\n6   0\nA789E\nFBCDJ\nKLMNO\n" == screen.renderMainPageText());
-        // }
-
-        // SECTION("SD 2") {
-        //     screen.scrollDown(LineCount(2));
-        //     CHECK(
-        //         "12345\n"
-        //         "6   0\n"
-        //         "A   E\n"
-        //         "F789J\n"
-        //         "KLMNO\n" == screen.renderMainPageText());
-        // }
-        //
-        // SECTION("SD 3") {
-        //     screen.scrollDown(LineCount(3));
-        //     CHECK(
-        //         "12345\n"
-        //         "6   0\n"
-        //         "A   E\n"
-        //         "F   J\n"
-        //         "KLMNO\n" == screen.renderMainPageText());
-        // }
+        SECTION("SD 1")
+        {
+            screen.scrollDown(LineCount(1));
+            CHECK("12345\n6   0\nA789E\nFBCDJ\nKLMNO\n" == screen.renderMainPageText());
+        }
+
+        SECTION("SD 2")
+        {
+            screen.scrollDown(LineCount(2));
+            CHECK("12345\n"
+                  "6   0\n"
+                  "A   E\n"
+                  "F789J\n"
+                  "KLMNO\n"
+                  == screen.renderMainPageText());
+        }
+
+        SECTION("SD 3")
+        {
+            screen.scrollDown(LineCount(3));
+            CHECK("12345\n"
+                  "6   0\n"
+                  "A   E\n"
+                  "F   J\n"
+                  "KLMNO\n"
+                  == screen.renderMainPageText());
+        }
     }
 
     SECTION("vertical margins")
@@ -2499,6 +2576,65 @@ TEST_CASE("captureBuffer", "[screen]")
     }
 }
 
+TEST_CASE("captureBuffer.logical", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) }, LineCount { 5 } };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.terminal.setMode(DECMode::AutoWrap, true);
+    mock.writeToScreen("ABCDE\r\n1234567");
+
+    SECTION("physical lines")
+    {
+        screen.captureBuffer(LineCount(3), false);
+        INFO(e(mock.terminal.peekInput()));
+        CHECK(e(mock.terminal.peekInput()) == e("\033^314;ABCDE\n12345\n67\n\033\\\033^314;\033\\"));
+    }
+    SECTION("logical lines")
+    {
+        screen.captureBuffer(LineCount(2), true);
+        INFO(e(mock.terminal.peekInput()));
+        CHECK(e(mock.terminal.peekInput()) == e("\033^314;ABCDE\n1234567\n\033\\\033^314;\033\\"));
+    }
+}
+
+TEST_CASE("snapshot", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) }, LineCount { 5 } };
+    mock.writeToScreen("12345\r\n67890\r\nAB");
+
+    auto const snapshot = mock.terminal.primaryScreen().snapshot();
+    CHECK(e(snapshot) == e("12345\r\n67890\r\nAB\033[2;3H"));
+
+    auto restored = MockTerm { PageSize { LineCount(2), ColumnCount(5) }, LineCount { 5 } };
+    restored.writeToScreen(snapshot);
+    auto& screen = restored.terminal.primaryScreen();
+    CHECK(screen.historyLineCount() == LineCount(1));
+    CHECK(screen.grid().lineText(LineOffset(-1)) == "12345");
+    CHECK(screen.renderMainPageText() == mock.terminal.primaryScreen().renderMainPageText());
+    CHECK(screen.realCursorPosition() == mock.terminal.primaryScreen().realCursorPosition());
+}
+
+TEST_CASE("snapshot.wrapped", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(4), ColumnCount(5) }, LineCount { 5 } };
+    mock.writeToScreen("ABCDEFG\r\n12345678");
+    mock.writeToScreen("\033[3;5H\033[X\033[4;4H"); // blanks the last column of a wrapping line
+
+    // Wrapped lines continue their predecessor, which is written up to its last column.
+    auto const snapshot = mock.terminal.primaryScreen().snapshot();
+    CHECK(e(snapshot) == e("ABCDEFG\r\n1234\033[5G 678\033[4;4H"));
+
+    auto restored = MockTerm { PageSize { LineCount(4), ColumnCount(5) }, LineCount { 5 } };
+    restored.writeToScreen(snapshot);
+    auto const& grid = restored.terminal.primaryScreen().grid();
+    CHECK(restored.terminal.primaryScreen().renderMainPageText()
+          == mock.terminal.primaryScreen().renderMainPageText());
+    CHECK_FALSE(grid.lineAt(LineOffset(0)).wrapped());
+    CHECK(grid.lineAt(LineOffset(1)).wrapped());
+    CHECK_FALSE(grid.lineAt(LineOffset(2)).wrapped());
+    CHECK(grid.lineAt(LineOffset(3)).wrapped());
+}
+
 TEST_CASE("render into history", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) }, LineCount { 5 } };
@@ -2533,6 +2669,22 @@ TEST_CASE("render into history", "[screen]")
     REQUIRE("12345\n67890\n" == renderedText);
 }
 
+TEST_CASE("renderLines", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount { 5 } };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("12345\r\n67890\r\nABCDE\r\nFGHIJ\r\nKLMNO");
+    REQUIRE("ABCDE\nFGHIJ\nKLMNO\n" == screen.renderMainPageText());
+
+    auto renderer = TextRenderBuilder {};
+    screen.renderLines(renderer, ScrollOffset { 0 }, LineOffset(1), LineOffset(3));
+    CHECK("FGHIJ\nKLMNO\n" == renderer.text);
+
+    renderer.text.clear();
+    screen.renderLines(renderer, ScrollOffset { 2 }, LineOffset(1), LineOffset(2));
+    CHECK("ABCDE\n" == renderer.text);
+}
+
 TEST_CASE("HorizontalTabClear.AllTabs", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) } };
@@ -3396,6 +3548,48 @@ TEST_CASE("Sixel.AutoScroll-1", "[screen]")
 
 // TODO: Sixel: image that exceeds available lines
 
+TEST_CASE("SGR.plain", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) } };
+    auto const& attributes = mock.terminal.state().cursor.graphicsRendition;
+
+    mock.writeToScreen("\033[1;3;31;42m");
+    CHECK(attributes.styles == (CellFlags::Bold | CellFlags::Italic));
+    CHECK(attributes.foregroundColor == Color(IndexedColor::Red));
+    CHECK(attributes.backgroundColor == Color(IndexedColor::Green));
+
+    mock.writeToScreen("\033[22;93;104m");
+    CHECK(attributes.styles == CellFlags::Italic);
+    CHECK(attributes.foregroundColor == Color(BrightColor::Yellow));
+    CHECK(attributes.backgroundColor == Color(BrightColor::Blue));
+
+    mock.writeToScreen("\033[38;5;200;48;2;10;20;30m");
+    CHECK(attributes.foregroundColor == Color(static_cast<IndexedColor>(200)));
+    CHECK(attributes.backgroundColor == Color(RGBColor { 10, 20, 30 }));
+
+    mock.writeToScreen("\033[39;49m");
+    CHECK(attributes.foregroundColor == DefaultColor());
+    CHECK(attributes.backgroundColor == DefaultColor());
+
+    mock.writeToScreen("\033[m");
+    CHECK(attributes == GraphicsAttributes {});
+}
+
+TEST_CASE("SGR.subparameters", "[screen]")
+{
+    // Sub-parameters are not handled by the Sequencer's SGR fast path but by Screen.
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) } };
+    auto const& attributes = mock.terminal.state().cursor.graphicsRendition;
+
+    mock.writeToScreen("\033[1;4:3;38:2::1:2:3m");
+    CHECK(attributes.styles == (CellFlags::Bold | CellFlags::CurlyUnderlined));
+    CHECK(attributes.foregroundColor == Color(RGBColor { 1, 2, 3 }));
+
+    mock.writeToScreen("\033[0;58:5:7m");
+    CHECK(attributes.styles == CellFlags {});
+    CHECK(attributes.underlineColor == Color(static_cast<IndexedColor>(7)));
+}
+
 // TODO: SetForegroundColor
 // TODO: SetBackgroundColor
 // TODO: SetGraphicsRendition
@@ -3415,3 +3609,24 @@ TEST_CASE("Sixel.AutoScroll-1", "[screen]")
 // TODO: DeviceStatusReport
 // TODO: SendDeviceAttributes
 // TODO: SendTerminalId
+
+TEST_CASE("OSC.8.hyperlinks", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(8) }, LineCount(10) };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("\033]8;;https://a\033\\A\033]8;id=x;https://b\033\\B\033]8;;\033\\C");
+    mock.writeToScreen("\033]8;id=x;https://b\033\\D\033]8;;https://a\033\\E\033]8;;\033\\");
+
+    auto const idAt = [&](int _column) {
+        return screen.hyperlinkIdAt(CellLocation { LineOffset(0), ColumnOffset(_column) });
+    };
+    REQUIRE(screen.hyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(0) }) != nullptr);
+    CHECK(screen.hyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(0) })->uri == "https://a");
+    CHECK(screen.hyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(1) })->userId == "x");
+    CHECK(screen.hyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(2) }) == nullptr);
+
+    // Re-emitted hyperlinks are shared rather than stored again.
+    CHECK(idAt(3) == idAt(1));
+    CHECK(idAt(4) == idAt(0));
+    CHECK(screen.hyperlinks().size() == 2);
+}
@@ -0,0 +1,175 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Search.h>
+
+using namespace std;
+
+namespace terminal
+{
+
+namespace
+{
+    constexpr char foldCase(char _ch) noexcept
+    {
+        return 'A' <= _ch && _ch <= 'Z' ? static_cast<char>(_ch - 'A' + 'a') : _ch;
+    }
+
+    constexpr uint32_t trigramAt(string_view _text, size_t _offset) noexcept
+    {
+        return (uint32_t(uint8_t(foldCase(_text[_offset]))) << 16)
+               | (uint32_t(uint8_t(foldCase(_text[_offset + 1]))) << 8)
+               | uint32_t(uint8_t(foldCase(_text[_offset + 2])));
+    }
+
+    vector<uint32_t> trigramsOf(string_view _text)
+    {
+        auto trigrams = vector<uint32_t> {};
+        if (_text.size() < 3)
+            return trigrams;
+        trigrams.reserve(_text.size() - 2);
+        for (size_t i = 0; i + 2 < _text.size(); ++i)
+            trigrams.push_back(trigramAt(_text, i));
+        sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+        return trigrams;
+    }
+} // namespace
+
+// {{{ TextMatcher
+TextMatcher::TextMatcher(SearchPattern _pattern): pattern_ { move(_pattern) }
+{
+    if (pattern_.regularExpression)
+    {
+        auto flags = regex::ECMAScript | regex::optimize;
+        if (!pattern_.caseSensitive)
+            flags |= regex::icase;
+        regex_.emplace(pattern_.text, flags);
+        return;
+    }
+
+    needle_ = pattern_.text;
+    if (!pattern_.caseSensitive)
+        transform(needle_.begin(), needle_.end(), needle_.begin(), foldCase);
+    trigrams_ = trigramsOf(needle_);
+}
+
+void TextMatcher::prepare(string& _text) const
+{
+    if (!regex_ && !pattern_.caseSensitive)
+        transform(_text.begin(), _text.end(), _text.begin(), foldCase);
+}
+
+optional<TextMatch> TextMatcher::findNext(string_view _text, size_t _start) const
+{
+    if (_start >= _text.size())
+        return nullopt;
+
+    if (regex_)
+    {
+        // Anchors and word boundaries must see the text preceding the search start.
+        auto const flags = _start != 0 ? regex_constants::match_prev_avail : regex_constants::match_default;
+        auto const end = cregex_iterator {};
+        for (auto i = cregex_iterator(_text.data() + _start, _text.data() + _text.size(), *regex_, flags);
+             i != end;
+             ++i)
+            if (i->length() != 0)
+                return TextMatch { _start + static_cast<size_t>(i->position()),
+                                   static_cast<size_t>(i->length()) };
+        return nullopt;
+    }
+
+    if (needle_.empty())
+        return nullopt;
+
+    if (auto const offset = _text.find(needle_, _start); offset != string_view::npos)
+        return TextMatch { offset, needle_.size() };
+
+    return nullopt;
+}
+
+optional<TextMatch> TextMatcher::findPrevious(string_view _text, size_t _end) const
+{
+    if (_end == 0)
+        return nullopt;
+
+    if (regex_)
+    {
+        // Regular expressions cannot be matched backwards, so keep the last of the leftmost-longest
+        // matches found left to right.
+        auto result = optional<TextMatch> {};
+        for (auto m = findNext(_text); m && m->offset < _end; m = findNext(_text, m->offset + m->length))
+            result = m;
+        return result;
+    }
+
+    if (needle_.empty())
+        return nullopt;
+
+    if (auto const offset = _text.rfind(needle_, _end - 1); offset != string_view::npos)
+        return TextMatch { offset, needle_.size() };
+
+    return nullopt;
+}
+// }}}
+
+// {{{ TrigramIndex
+void TrigramIndex::insert(uint64_t _key, string_view _text)
+{
+    auto const ordinal = static_cast<uint32_t>(ordinals_.size());
+    if (!ordinals_.emplace(_key, ordinal).second)
+        return;
+
+    for (auto const trigram: trigramsOf(_text))
+        postings_[trigram].push_back(ordinal);
+}
+
+vector<uint32_t> TrigramIndex::candidates(vector<uint32_t> const& _trigrams) const
+{
+    auto lists = vector<vector<uint32_t> const*> {};
+    lists.reserve(_trigrams.size());
+    for (auto const trigram: _trigrams)
+    {
+        auto const i = postings_.find(trigram);
+        if (i == postings_.end())
+            return {};
+        lists.push_back(&i->second);
+    }
+
+    if (lists.empty())
+        return {};
+
+    // Intersect starting with the shortest list, so the result only ever shrinks.
+    sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+    auto result = *lists.front();
+    for (auto i = next(lists.begin()); i != lists.end() && !result.empty(); ++i)
+    {
+        auto const& list = **i;
+        result.erase(remove_if(result.begin(),
+                               result.end(),
+                               [&](uint32_t ordinal) {
+                                   return !binary_search(list.begin(), list.end(), ordinal);
+                               }),
+                     result.end());
+    }
+    return result;
+}
+
+void TrigramIndex::clear()
+{
+    ordinals_.clear();
+    postings_.clear();
+}
+// }}}
+
+} // namespace terminal
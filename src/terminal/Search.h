@@ -0,0 +1,390 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/primitives.h>
+
+#include <crispy/FNV.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace terminal
+{
+
+/// Describes the text to search the screen's lines for.
+struct SearchPattern
+{
+    std::string text;
+    bool caseSensitive = true;
+    bool regularExpression = false;
+};
+
+enum class SearchDirection
+{
+    Forward,
+    Backward
+};
+
+/// Byte range of a match within a UTF-8 string.
+struct TextMatch
+{
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+/// Grid cells a match spans, from its first to its last cell (inclusive).
+struct SearchMatch
+{
+    CellLocation start {};
+    CellLocation end {};
+};
+
+constexpr bool operator==(SearchMatch const& a, SearchMatch const& b) noexcept
+{
+    return a.start == b.start && a.end == b.end;
+}
+
+constexpr bool operator!=(SearchMatch const& a, SearchMatch const& b) noexcept
+{
+    return !(a == b);
+}
+
+/// Finds a SearchPattern in UTF-8 text.
+///
+/// Literal patterns are located via std::string_view::find(), which scans for the pattern's
+/// first byte using memchr(). Regular expressions use the ECMAScript grammar.
+/// Empty matches are never reported.
+class TextMatcher
+{
+  public:
+    /// @throws std::regex_error if the pattern is not a valid regular expression.
+    explicit TextMatcher(SearchPattern _pattern);
+
+    [[nodiscard]] SearchPattern const& pattern() const noexcept { return pattern_; }
+
+    /// Prepares a line's text for matching, i.e. folds its case for case-insensitive literals.
+    void prepare(std::string& _text) const;
+
+    /// Finds the first match starting at or after @p _start in prepared text.
+    [[nodiscard]] std::optional<TextMatch> findNext(std::string_view _text, size_t _start = 0) const;
+
+    /// Finds the last match starting before @p _end in prepared text.
+    [[nodiscard]] std::optional<TextMatch> findPrevious(std::string_view _text, size_t _end) const;
+
+    /// Trigrams of (ASCII case-folded) text that every matching line contains.
+    ///
+    /// Empty if nothing can be told about matching lines up front, such as for regular expressions.
+    [[nodiscard]] std::vector<uint32_t> const& trigrams() const noexcept { return trigrams_; }
+
+  private:
+    SearchPattern pattern_;
+    std::string needle_;
+    std::optional<std::regex> regex_;
+    std::vector<uint32_t> trigrams_;
+};
+
+/// Inverted index from trigrams of (ASCII case-folded) text to the lines containing them.
+///
+/// Lines are identified by a key that changes whenever their contents change, so entries never
+/// go stale but merely unreachable. Each line is assigned an ordinal in insertion order, keeping
+/// posting lists sorted so that they can be intersected cheaply.
+class TrigramIndex
+{
+  public:
+    [[nodiscard]] size_t size() const noexcept { return ordinals_.size(); }
+
+    [[nodiscard]] std::optional<uint32_t> ordinal(uint64_t _key) const noexcept
+    {
+        if (auto const i = ordinals_.find(_key); i != ordinals_.end())
+            return i->second;
+        return std::nullopt;
+    }
+
+    /// Indexes the text of the line identified by @p _key, unless already indexed.
+    void insert(uint64_t _key, std::string_view _text);
+
+    /// @returns the sorted ordinals of all indexed lines that contain every one of @p _trigrams.
+    [[nodiscard]] std::vector<uint32_t> candidates(std::vector<uint32_t> const& _trigrams) const;
+
+    void clear();
+
+  private:
+    std::unordered_map<uint64_t, uint32_t> ordinals_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+};
+
+namespace detail
+{
+    /// Returns a key identifying the contents of the grid lines [_top, _bottom],
+    /// which changes whenever any of these lines changes.
+    template <typename GridT>
+    [[nodiscard]] uint64_t logicalLineKey(GridT const& _grid, LineOffset _top, LineOffset _bottom) noexcept
+    {
+        auto hash = crispy::FNV<char, uint64_t>().basis();
+        for (auto line = _top; line <= _bottom; ++line)
+        {
+            auto const generation = _grid.scrollbackLineAt(line).generation();
+            auto const bytes =
+                std::string_view(reinterpret_cast<char const*>(&generation), sizeof(generation));
+            hash = crispy::FNV<char, uint64_t>()(hash, bytes);
+        }
+        return hash;
+    }
+
+    /// UTF-8 text of a logical line, along with the grid cells its bytes originate from.
+    struct LogicalLineText
+    {
+        /// Bytes starting at @c offset originate from the cell at @c position and, if @c ascii,
+        /// each of the following bytes from the next column.
+        struct Run
+        {
+            size_t offset;
+            CellLocation position;
+            bool ascii;
+        };
+
+        std::string text;
+        std::vector<Run> runs;
+
+        void clear()
+        {
+            text.clear();
+            runs.clear();
+        }
+
+        [[nodiscard]] CellLocation locate(size_t _offset) const noexcept
+        {
+            auto const i = std::prev(std::upper_bound(
+                runs.begin(), runs.end(), _offset, [](size_t a, Run const& b) { return a < b.offset; }));
+            if (!i->ascii)
+                return i->position;
+            return { i->position.line, i->position.column + ColumnOffset::cast_from(_offset - i->offset) };
+        }
+
+        [[nodiscard]] SearchMatch locate(TextMatch _match) const noexcept
+        {
+            return { locate(_match.offset), locate(_match.offset + _match.length - 1) };
+        }
+
+        template <typename LineT>
+        void append(LineT const& _line, LineOffset _lineOffset)
+        {
+            if (_line.isTrivialBuffer())
+            {
+                // Trivial lines mostly hold US-ASCII text, at one byte per column.
+                auto const& buffer = _line.trivialBuffer();
+                auto const view = buffer.text.view();
+                if (view.size() == unbox<size_t>(buffer.usedColumns))
+                {
+                    runs.push_back(Run { text.size(), { _lineOffset, ColumnOffset(0) }, true });
+                    text.append(view.data(), view.size());
+                    if (buffer.usedColumns < buffer.displayWidth)
+                        text.append(unbox<size_t>(buffer.displayWidth - buffer.usedColumns), ' ');
+                    return;
+                }
+            }
+
+            auto const cells = _line.cells();
+            auto column = ColumnOffset(0);
+            for (size_t i = 0; i < cells.size();)
+            {
+                auto const& cell = cells[i];
+                runs.push_back(Run { text.size(), { _lineOffset, column }, false });
+                if (cell.codepointCount() == 0)
+                    text += ' ';
+                else
+                    text += cell.toUtf8();
+                auto const width = std::max(static_cast<int>(cell.width()), 1);
+                i += static_cast<size_t>(width);
+                column += ColumnOffset::cast_from(width);
+            }
+        }
+    };
+
+    /// Walks the logical lines of a grid, loading the text of those that may contain a match.
+    template <typename GridT>
+    class LogicalLineScanner
+    {
+      public:
+        LogicalLineScanner(GridT const& _grid, TextMatcher const& _matcher, TrigramIndex* _index):
+            grid_ { _grid },
+            matcher_ { _matcher },
+            index_ { _index && !_matcher.trigrams().empty() ? _index : nullptr },
+            top_ { -boxed_cast<LineOffset>(_grid.scrollbackLineCount()) },
+            bottom_ { boxed_cast<LineOffset>(_grid.pageSize().lines) - 1 }
+        {
+            if (index_)
+            {
+                candidates_ = index_->candidates(_matcher.trigrams());
+                firstNewOrdinal_ = static_cast<uint32_t>(index_->size());
+            }
+        }
+
+        [[nodiscard]] LineOffset top() const noexcept { return top_; }
+        [[nodiscard]] LineOffset bottom() const noexcept { return bottom_; }
+        [[nodiscard]] LogicalLineText const& current() const noexcept { return current_; }
+
+        [[nodiscard]] LineOffset logicalTop(LineOffset _line) const noexcept
+        {
+            return grid_.logicalLineTop(_line);
+        }
+
+        [[nodiscard]] LineOffset logicalBottom(LineOffset _line) const noexcept
+        {
+            return grid_.logicalLineBottom(_line);
+        }
+
+        /// Loads the prepared text of the logical line [_top, _bottom] into current().
+        ///
+        /// History lines are looked up in (and added to) the trigram index, if any.
+        ///
+        /// @returns false if the line cannot contain a match and thus has not been loaded.
+        bool load(LineOffset _top, LineOffset _bottom)
+        {
+            auto const indexed = index_ && _bottom < LineOffset(0);
+            auto key = uint64_t { 0 };
+            auto known = false;
+            if (indexed)
+            {
+                key = logicalLineKey(grid_, _top, _bottom);
+                if (auto const ordinal = index_->ordinal(key))
+                {
+                    known = true;
+                    if (*ordinal < firstNewOrdinal_
+                        && !std::binary_search(candidates_.begin(), candidates_.end(), *ordinal))
+                        return false;
+                }
+            }
+
+            current_.clear();
+            for (auto line = _top; line <= _bottom; ++line)
+                current_.append(grid_.scrollbackLineAt(line), line);
+
+            if (indexed && !known)
+                index_->insert(key, current_.text);
+
+            matcher_.prepare(current_.text);
+            return true;
+        }
+
+      private:
+        GridT const& grid_;
+        TextMatcher const& matcher_;
+        TrigramIndex* index_;
+        LineOffset top_;
+        LineOffset bottom_;
+        std::vector<uint32_t> candidates_;
+        uint32_t firstNewOrdinal_ = 0;
+        LogicalLineText current_;
+    };
+} // namespace detail
+
+/// Finds the match of @p _matcher closest to @p _from in the given direction.
+///
+/// The search covers the grid's archived lines, history and main page, a logical line at a time,
+/// and wraps around at either end. Matches starting at @p _from itself are found last.
+///
+/// @param _index optional trigram index, used to skip history lines that cannot match.
+template <typename GridT>
+std::optional<SearchMatch> search(GridT const& _grid,
+                                  TextMatcher const& _matcher,
+                                  CellLocation _from,
+                                  SearchDirection _direction,
+                                  TrigramIndex* _index = nullptr)
+{
+    auto scanner = detail::LogicalLineScanner<GridT> { _grid, _matcher, _index };
+    auto const first = scanner.logicalTop(std::clamp(_from.line, scanner.top(), scanner.bottom()));
+    auto const& text = scanner.current().text;
+    auto top = first;
+    auto wrapped = false;
+
+    while (true)
+    {
+        auto const bottom = scanner.logicalBottom(top);
+        if (scanner.load(top, bottom))
+        {
+            if (_direction == SearchDirection::Forward)
+            {
+                for (auto m = _matcher.findNext(text); m; m = _matcher.findNext(text, m->offset + 1))
+                    if (auto const match = scanner.current().locate(*m);
+                        wrapped || top != first || _from < match.start)
+                        return match;
+            }
+            else
+            {
+                for (auto m = _matcher.findPrevious(text, text.size()); m;
+                     m = _matcher.findPrevious(text, m->offset))
+                    if (auto const match = scanner.current().locate(*m);
+                        wrapped || top != first || match.start < _from)
+                        return match;
+            }
+        }
+
+        if (wrapped && top == first)
+            return std::nullopt;
+
+        if (_direction == SearchDirection::Forward)
+        {
+            top = bottom + 1;
+            if (top > scanner.bottom())
+            {
+                top = scanner.top();
+                wrapped = true;
+            }
+        }
+        else if (top == scanner.top())
+        {
+            top = scanner.logicalTop(scanner.bottom());
+            wrapped = true;
+        }
+        else
+            top = scanner.logicalTop(top - 1);
+    }
+}
+
+/// Invokes @p _callback with every match in the logical lines intersecting the lines [_first, _last].
+///
+/// Results can thus be streamed in chunks of lines, e.g. the viewport first, while the user types.
+/// Iteration stops as soon as @p _callback returns false.
+template <typename GridT, typename Callback>
+void forEachMatch(GridT const& _grid,
+                  TextMatcher const& _matcher,
+                  LineOffset _first,
+                  LineOffset _last,
+                  TrigramIndex* _index,
+                  Callback&& _callback)
+{
+    auto scanner = detail::LogicalLineScanner<GridT> { _grid, _matcher, _index };
+    _last = std::min(_last, scanner.bottom());
+    auto const& text = scanner.current().text;
+    for (auto top = scanner.logicalTop(std::max(_first, scanner.top())); top <= _last;)
+    {
+        auto const bottom = scanner.logicalBottom(top);
+        if (scanner.load(top, bottom))
+            for (auto m = _matcher.findNext(text); m; m = _matcher.findNext(text, m->offset + 1))
+                if (!_callback(scanner.current().locate(*m)))
+                    return;
+        top = bottom + 1;
+    }
+}
+
+} // namespace terminal
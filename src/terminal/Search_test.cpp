@@ -0,0 +1,182 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/Grid.h>
+#include <terminal/Search.h>
+#include <terminal/test_grid.h>
+
+#include <catch2/catch.hpp>
+
+#include <string_view>
+#include <vector>
+
+using namespace terminal;
+using namespace terminal::test;
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace
+{
+
+constexpr SearchMatch match(CellLocation _start, CellLocation _end) noexcept
+{
+    return SearchMatch { _start, _end };
+}
+
+optional<size_t> offsetOf(optional<TextMatch> _match)
+{
+    if (_match)
+        return _match->offset;
+    return nullopt;
+}
+
+} // namespace
+
+TEST_CASE("TextMatcher.literal", "[search]")
+{
+    auto const matcher = TextMatcher(SearchPattern { "abc" });
+    CHECK(offsetOf(matcher.findNext("xabcabc")) == 1);
+    CHECK(offsetOf(matcher.findNext("xabcabc", 2)) == 4);
+    CHECK(offsetOf(matcher.findNext("xabcabc", 5)) == nullopt);
+    CHECK(offsetOf(matcher.findNext("xABC")) == nullopt);
+    CHECK(offsetOf(matcher.findPrevious("xabcabc", 7)) == 4);
+    CHECK(offsetOf(matcher.findPrevious("xabcabc", 4)) == 1);
+    CHECK(offsetOf(matcher.findPrevious("xabcabc", 1)) == nullopt);
+    CHECK(matcher.trigrams().size() == 1);
+}
+
+TEST_CASE("TextMatcher.caseInsensitive", "[search]")
+{
+    auto const matcher = TextMatcher(SearchPattern { "HeLLo", false });
+    auto text = string("say hello, HELLO");
+    matcher.prepare(text);
+    CHECK(offsetOf(matcher.findNext(text)) == 4);
+    CHECK(offsetOf(matcher.findNext(text, 5)) == 11);
+}
+
+TEST_CASE("TextMatcher.regex", "[search]")
+{
+    auto const matcher = TextMatcher(SearchPattern { "[0-9]+", true, true });
+    auto const text = string_view("pid 42 exited with 137");
+    auto const first = matcher.findNext(text);
+    REQUIRE(first.has_value());
+    CHECK(first->offset == 4);
+    CHECK(first->length == 2);
+    CHECK(offsetOf(matcher.findNext(text, 6)) == 19);
+    CHECK(offsetOf(matcher.findPrevious(text, text.size())) == 19);
+    CHECK(matcher.trigrams().empty());
+
+    // Anchors respect the text preceding the search start.
+    auto const anchored = TextMatcher(SearchPattern { "^pid", true, true });
+    CHECK(offsetOf(anchored.findNext(text)) == 0);
+    CHECK(offsetOf(anchored.findNext(text, 1)) == nullopt);
+
+    CHECK_THROWS_AS(TextMatcher(SearchPattern { "(", true, true }), std::regex_error);
+}
+
+TEST_CASE("TrigramIndex.candidates", "[search]")
+{
+    auto index = TrigramIndex {};
+    index.insert(10, "make install");
+    index.insert(20, "make clean");
+    index.insert(30, "cmake --build");
+    index.insert(20, "ignored, as already indexed");
+    REQUIRE(index.size() == 3);
+
+    auto const ordinalsOf = [&](string_view _text) {
+        return index.candidates(TextMatcher(SearchPattern { string(_text) }).trigrams());
+    };
+    CHECK(ordinalsOf("make") == vector<uint32_t> { 0, 1, 2 });
+    CHECK(ordinalsOf("make c") == vector<uint32_t> { 1 });
+    CHECK(ordinalsOf("MAKE") == vector<uint32_t> { 0, 1, 2 });
+    CHECK(ordinalsOf("build").size() == 1);
+    CHECK(ordinalsOf("absent").empty());
+    CHECK(index.ordinal(30) == 2);
+    CHECK(index.ordinal(40) == nullopt);
+}
+
+TEST_CASE("search.forward", "[search]")
+{
+    auto const grid = setupGrid(PageSize { LineCount(2), ColumnCount(8) },
+                                { "foo one", "two foo", "three", "foo foo" });
+    // history: -2 "foo one", -1 "two foo"; page: 0 "three", 1 "foo foo"
+    auto const matcher = TextMatcher(SearchPattern { "foo" });
+
+    CHECK(search(grid, matcher, at(-2, 0), SearchDirection::Forward) == match(at(-1, 4), at(-1, 6)));
+    CHECK(search(grid, matcher, at(-1, 4), SearchDirection::Forward) == match(at(1, 0), at(1, 2)));
+    CHECK(search(grid, matcher, at(1, 0), SearchDirection::Forward) == match(at(1, 4), at(1, 6)));
+
+    // wraps around to the top of the history
+    CHECK(search(grid, matcher, at(1, 4), SearchDirection::Forward) == match(at(-2, 0), at(-2, 2)));
+}
+
+TEST_CASE("search.backward", "[search]")
+{
+    auto const grid = setupGrid(PageSize { LineCount(2), ColumnCount(8) },
+                                { "foo one", "two foo", "three", "foo foo" });
+    auto const matcher = TextMatcher(SearchPattern { "foo" });
+
+    CHECK(search(grid, matcher, at(1, 4), SearchDirection::Backward) == match(at(1, 0), at(1, 2)));
+    CHECK(search(grid, matcher, at(1, 0), SearchDirection::Backward) == match(at(-1, 4), at(-1, 6)));
+
+    // wraps around to the bottom of the main page
+    CHECK(search(grid, matcher, at(-2, 0), SearchDirection::Backward) == match(at(1, 4), at(1, 6)));
+}
+
+TEST_CASE("search.single_match_wraps_onto_itself", "[search]")
+{
+    auto const grid = setupGrid(PageSize { LineCount(2), ColumnCount(8) }, { "abc", "xyz" });
+    auto const matcher = TextMatcher(SearchPattern { "xyz" });
+    CHECK(search(grid, matcher, at(1, 0), SearchDirection::Forward) == match(at(1, 0), at(1, 2)));
+    CHECK(search(grid, matcher, at(1, 0), SearchDirection::Backward) == match(at(1, 0), at(1, 2)));
+    CHECK(!search(grid, TextMatcher(SearchPattern { "nope" }), at(0, 0), SearchDirection::Forward));
+}
+
+TEST_CASE("search.wrapped_lines", "[search]")
+{
+    auto grid = setupGrid(PageSize { LineCount(3), ColumnCount(4) }, { "xx h", "ello", "" });
+    grid.lineAt(LineOffset(1)).setFlag(LineFlags::Wrapped, true);
+
+    auto const matcher = TextMatcher(SearchPattern { "hello" });
+    CHECK(search(grid, matcher, at(2, 0), SearchDirection::Forward) == match(at(0, 3), at(1, 3)));
+    CHECK(search(grid, matcher, at(2, 0), SearchDirection::Backward) == match(at(0, 3), at(1, 3)));
+}
+
+TEST_CASE("search.index", "[search]")
+{
+    auto const grid = setupGrid(PageSize { LineCount(2), ColumnCount(8) },
+                                { "make all", "ls -l", "ctest", "make all", "ls" });
+    // history: -3 "make all", -2 "ls -l", -1 "ctest"; page: 0 "make all", 1 "ls"
+    auto index = TrigramIndex {};
+    auto const matcher = TextMatcher(SearchPattern { "make" });
+
+    // The first search indexes the history lines it passes.
+    CHECK(search(grid, matcher, at(0, 0), SearchDirection::Backward, &index) == match(at(-3, 0), at(-3, 3)));
+    CHECK(index.size() == 3);
+
+    // Later searches skip history lines ruled out by the index, with identical results.
+    CHECK(search(grid, matcher, at(-3, 0), SearchDirection::Forward, &index) == match(at(0, 0), at(0, 3)));
+    CHECK(search(grid, matcher, at(0, 0), SearchDirection::Forward, &index) == match(at(-3, 0), at(-3, 3)));
+    CHECK(index.size() == 3);
+
+    auto matches = vector<SearchMatch> {};
+    forEachMatch(grid, TextMatcher(SearchPattern { "l" }), LineOffset(-3), LineOffset(1), &index, [&](auto m) {
+        matches.push_back(m);
+        return true;
+    });
+    CHECK(matches.size() == 7);
+}
@@ -27,22 +27,12 @@ namespace terminal
 namespace // {{{ helper
 {
 
-    tuple<vector<Selection::Range>, CellLocation const, CellLocation const> prepare(
-        Selection const& _selection)
+    pair<CellLocation, CellLocation> orderedLocations(Selection const& _selection) noexcept
     {
-        vector<Selection::Range> result;
-
-        auto const [from, to] = [&]() {
-            if (_selection.from() <= _selection.to())
-                return pair { _selection.from(), _selection.to() };
-            else
-                return pair { _selection.to(), _selection.from() };
-        }();
-
-        auto const numLines = to.line - from.line + 1;
-        result.resize(numLines.as<size_t>());
-
-        return { move(result), from, to };
+        if (_selection.from() <= _selection.to())
+            return pair { _selection.from(), _selection.to() };
+        else
+            return pair { _selection.to(), _selection.from() };
     }
 
     // Constructs a top-left and bottom-right coordinate-pair from given input.
@@ -101,32 +91,31 @@ bool Selection::intersects(Rect _area) const noexcept
 
 std::vector<Selection::Range> Selection::ranges() const
 {
-    auto [result, from, to] = prepare(*this);
-    auto const rightMargin = boxed_cast<ColumnOffset>(helper_.pageSize().columns - 1);
+    vector<Range> result;
+    result.reserve(unbox<size_t>(lastLine() - firstLine()) + 1);
+    for (auto line = firstLine(); line <= lastLine(); ++line)
+        result.push_back(rangeAt(line));
+    return result;
+}
 
-    switch (result.size())
-    {
-        case 1: result[0] = Range { from.line, from.column, min(to.column, rightMargin) }; break;
-        case 2:
-            // Render first line partial from selected column to end.
-            result[0] = Range { from.line, from.column, rightMargin };
-            // Render last (second) line partial from beginning to last selected column.
-            result[1] = Range { to.line, ColumnOffset(0), min(to.column, rightMargin) };
-            break;
-        default:
-            // Render first line partial from selected column to end.
-            result[0] = Range { from.line, from.column, rightMargin };
+Selection::Range Selection::rangeAt(LineOffset _line) const noexcept
+{
+    auto const [from, to] = orderedLocations(*this);
+    auto const rightMargin = boxed_cast<ColumnOffset>(helper_.pageSize().columns - 1);
 
-            // Render inner full.
-            for (size_t n = 1; n < result.size(); ++n)
-                result[n] = Range { from.line + LineOffset::cast_from(n), ColumnOffset(0), rightMargin };
+    // The first line is selected from the selected column to the end, the last line from the beginning
+    // to the last selected column, and any inner lines in full.
+    auto const fromColumn = _line == from.line ? from.column : ColumnOffset(0);
+    auto const toColumn = _line == to.line ? min(to.column, rightMargin) : rightMargin;
+    return Range { _line, fromColumn, toColumn };
+}
 
-            // Render last (second) line partial from beginning to last selected column.
-            result[result.size() - 1] = Range { to.line, ColumnOffset(0), min(to.column, rightMargin) };
-            break;
-    }
+Selection::Range Selection::containedRangeAt(LineOffset _line) const noexcept
+{
+    if (_line < firstLine() || lastLine() < _line)
+        return Range { _line, ColumnOffset(1), ColumnOffset(0) };
 
-    return result;
+    return rangeAt(_line);
 }
 // }}}
 // {{{ LinearSelection
@@ -255,23 +244,20 @@ bool RectangularSelection::intersects(Rect _area) const noexcept
     return _area.top.as<LineOffset>() < from.line && to.line < _area.bottom.as<LineOffset>();
 }
 
-vector<Selection::Range> RectangularSelection::ranges() const
+Selection::Range RectangularSelection::rangeAt(LineOffset _line) const noexcept
 {
     auto const [from, to] = orderedPoints(from_, to_);
+    auto const right = stretchedColumn(helper_, CellLocation { _line, to.column }).column;
+    return Range { _line, from.column, right };
+}
 
-    vector<Selection::Range> result;
-    auto const numLines = to.line - from.line + 1;
-    result.resize(numLines.as<size_t>());
-
-    for (size_t i = 0; i < result.size(); ++i)
-    {
-        auto const line = from.line + LineOffset::cast_from(i);
-        auto const left = from.column;
-        auto const right = stretchedColumn(helper_, CellLocation { line, to.column }).column;
-        result[i] = Range { line, left, right };
-    }
+Selection::Range RectangularSelection::containedRangeAt(LineOffset _line) const noexcept
+{
+    auto const [from, to] = orderedPoints(from_, to_);
+    if (_line < from.line || to.line < _line)
+        return Range { _line, ColumnOffset(1), ColumnOffset(0) };
 
-    return result;
+    return Range { _line, from.column, to.column };
 }
 // }}}
 // {{{ FullLineSelection
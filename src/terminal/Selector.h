@@ -21,6 +21,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -85,6 +86,11 @@ class Selection
         {
             return boxed_cast<ColumnCount>(toColumn - fromColumn + 1);
         }
+
+        [[nodiscard]] constexpr bool contains(ColumnOffset _column) const noexcept
+        {
+            return fromColumn <= _column && _column <= toColumn;
+        }
     };
 
     Selection(SelectionHelper const& _helper, CellLocation _start):
@@ -109,7 +115,21 @@ class Selection
     virtual void extend(CellLocation _to);
 
     /// Constructs a vector of ranges for this selection.
-    [[nodiscard]] virtual std::vector<Range> ranges() const;
+    [[nodiscard]] std::vector<Range> ranges() const;
+
+    /// @returns the selected range at the given line, which must be within firstLine() and lastLine().
+    ///
+    /// This allows walking huge selections line by line without materializing all ranges at once.
+    [[nodiscard]] virtual Range rangeAt(LineOffset _line) const noexcept;
+
+    /// @returns the columns of the given line that contains() considers selected,
+    ///          which is an empty range (with fromColumn > toColumn) for lines outside the selection.
+    ///
+    /// This allows testing all cells of a line without a virtual contains() call per cell.
+    [[nodiscard]] virtual Range containedRangeAt(LineOffset _line) const noexcept;
+
+    [[nodiscard]] constexpr LineOffset firstLine() const noexcept { return std::min(from_.line, to_.line); }
+    [[nodiscard]] constexpr LineOffset lastLine() const noexcept { return std::max(from_.line, to_.line); }
 
     /// Marks the selection as completed.
     void complete();
@@ -132,7 +152,8 @@ class RectangularSelection: public Selection
     RectangularSelection(SelectionHelper const& _helper, CellLocation _start);
     bool contains(CellLocation _coord) const noexcept override;
     bool intersects(Rect _area) const noexcept override;
-    std::vector<Range> ranges() const override;
+    Range rangeAt(LineOffset _line) const noexcept override;
+    Range containedRangeAt(LineOffset _line) const noexcept override;
 };
 
 class LinearSelection: public Selection
@@ -174,9 +195,12 @@ inline void Selection::applyScroll(LineOffset _value, LineCount _historyLineCoun
 template <typename Renderer>
 void renderSelection(Selection const& _selection, Renderer&& _render)
 {
-    for (Selection::Range const& range: _selection.ranges())
+    for (auto line = _selection.firstLine(); line <= _selection.lastLine(); ++line)
+    {
+        auto const range = _selection.rangeAt(line);
         for (auto const col: crispy::times(*range.fromColumn, *range.length()))
             _render(CellLocation { range.line, ColumnOffset::cast_from(col) });
+    }
 }
 // }}}
 
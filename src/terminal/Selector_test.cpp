@@ -262,3 +262,41 @@ TEST_CASE("Selector.Rectangular", "[selector]")
 {
     // TODO
 }
+
+TEST_CASE("Selector.containedRangeAt", "[selector]")
+{
+    auto term = MockTerm(PageSize { LineCount(3), ColumnCount(11) }, LineCount(5));
+    auto& screen = term.terminal.primaryScreen();
+    auto selectionHelper = TestSelectionHelper(screen);
+
+    // The precomputed per-line ranges must agree with contains() for every cell, within and around
+    // the selected lines.
+    auto const checkAgainstContains = [&](Selection const& _selection) {
+        for (auto line = LineOffset(-1); line <= LineOffset(3); ++line)
+        {
+            auto const range = _selection.containedRangeAt(line);
+            for (auto column = ColumnOffset(0); column < ColumnOffset(11); ++column)
+            {
+                INFO(fmt::format("line {}, column {}", line, column));
+                CHECK(range.contains(column) == _selection.contains(CellLocation { line, column }));
+            }
+        }
+    };
+
+    SECTION("linear")
+    {
+        auto selector = LinearSelection(selectionHelper, CellLocation { LineOffset(2), ColumnOffset(2) });
+        selector.extend(CellLocation { LineOffset(0), ColumnOffset(8) });
+        selector.complete();
+        checkAgainstContains(selector);
+    }
+
+    SECTION("rectangular")
+    {
+        auto selector =
+            RectangularSelection(selectionHelper, CellLocation { LineOffset(2), ColumnOffset(2) });
+        selector.extend(CellLocation { LineOffset(0), ColumnOffset(8) });
+        selector.complete();
+        checkAgainstContains(selector);
+    }
+}
@@ -284,6 +284,7 @@ class Sequence
     // accessors
     //
     [[nodiscard]] FunctionCategory category() const noexcept { return category_; }
+    [[nodiscard]] char leaderSymbol() const noexcept { return leaderSymbol_; }
     [[nodiscard]] Intermediaries const& intermediateCharacters() const noexcept
     {
         return intermediateCharacters_;
@@ -358,6 +359,7 @@ class SequenceHandler
     virtual void processSequence(Sequence const& sequence) = 0;
     virtual void writeText(char32_t codepoint) = 0;
     virtual void writeText(std::string_view codepoints, size_t cellCount) = 0;
+    virtual void writeText(std::u32string_view codepoints) = 0;
 };
 
 } // namespace terminal
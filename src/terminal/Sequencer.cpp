@@ -11,6 +11,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <terminal/Metrics.h>
 #include <terminal/Screen.h>
 #include <terminal/Sequencer.h>
 #include <terminal/SixelParser.h>
@@ -24,6 +25,7 @@
 using std::get;
 using std::holds_alternative;
 using std::string_view;
+using std::u32string_view;
 
 using namespace std::string_view_literals;
 
@@ -74,6 +76,26 @@ void Sequencer::print(string_view _chars, size_t cellCount)
                                             - terminal_.state().cursor.position.column.as<size_t>();
 }
 
+void Sequencer::print(u32string_view _codepoints)
+{
+    assert(!_codepoints.empty());
+
+    // Decoded text interrupts the UTF-8 sequence that the previous input has left incomplete.
+    if (decodingUtf8())
+    {
+        static constexpr char32_t ReplacementCharacter { 0xFFFD };
+        resetUtf8DecoderState();
+        terminal_.state().instructionCounter++;
+        terminal_.currentScreen().writeText(ReplacementCharacter);
+        terminal_.state().precedingGraphicCharacter = ReplacementCharacter;
+    }
+
+    terminal_.currentScreen().writeText(_codepoints);
+
+    terminal_.state().parser.maxCharCount = terminal_.state().pageSize.columns.as<size_t>()
+                                            - terminal_.state().cursor.position.column.as<size_t>();
+}
+
 void Sequencer::execute(char controlCode)
 {
     terminal_.currentScreen().executeControlCode(controlCode);
@@ -120,6 +142,23 @@ void Sequencer::dispatchCSI(char _finalChar)
 {
     sequence_.setCategory(FunctionCategory::CSI);
     sequence_.setFinalChar(_finalChar);
+
+    if (_finalChar == 'm' && !sequence_.leaderSymbol() && sequence_.intermediateCharacters().empty())
+    {
+        // SGR is by far the most frequent sequence in colorized output, so
+        // try to apply it right away without going through the generic function dispatch.
+        Metrics* const metrics = terminal_.sequenceMetrics();
+        auto const start = metrics ? cycleCount() : 0;
+
+        parameterBuilder_.fixiate();
+        if (!tryApplyPlainSGR())
+            terminal_.currentScreen().processSequence(sequence_);
+
+        if (metrics)
+            metrics->record(SGR, cycleCount() - start);
+        return;
+    }
+
     handleSequence();
 }
 
@@ -134,6 +173,13 @@ void Sequencer::putOSC(char _char)
         sequence_.intermediateCharacters().push_back(_char);
 }
 
+void Sequencer::putOSC(string_view _chars)
+{
+    auto& payload = sequence_.intermediateCharacters();
+    if (payload.size() + 1 < Sequence::MaxOscLength)
+        payload.append(_chars.substr(0, Sequence::MaxOscLength - 1 - payload.size()));
+}
+
 void Sequencer::dispatchOSC()
 {
     auto const [code, skipCount] = parser::extractCodePrefix(sequence_.intermediateCharacters());
@@ -143,6 +189,23 @@ void Sequencer::dispatchOSC()
     clear();
 }
 
+void Sequencer::startAPC()
+{
+    apcData_.clear();
+}
+
+void Sequencer::putAPC(char _char)
+{
+    if (apcData_.size() < MaxApcLength)
+        apcData_.push_back(_char);
+}
+
+void Sequencer::dispatchAPC()
+{
+    terminal_.currentScreen().applicationProgramCommand(apcData_);
+    apcData_.clear();
+}
+
 void Sequencer::hook(char _finalChar)
 {
     terminal_.state().instructionCounter++;
@@ -158,6 +221,12 @@ void Sequencer::put(char _char)
         hookedParser_->pass(_char);
 }
 
+void Sequencer::put(string_view _chars)
+{
+    if (hookedParser_)
+        hookedParser_->pass(_chars);
+}
+
 void Sequencer::unhook()
 {
     if (hookedParser_)
@@ -169,8 +238,154 @@ void Sequencer::unhook()
 
 void Sequencer::handleSequence()
 {
+    Metrics* const metrics = terminal_.sequenceMetrics();
+    auto const start = metrics ? cycleCount() : 0;
+
     parameterBuilder_.fixiate();
     terminal_.currentScreen().processSequence(sequence_);
+
+    if (metrics)
+        if (FunctionDefinition const* function = sequence_.functionDefinition())
+            metrics->record(*function, cycleCount() - start);
+}
+
+namespace
+{
+    constexpr bool isPlainSGRStyle(unsigned _value) noexcept
+    {
+        // Those SGR values map 1:1 onto GraphicsRendition.
+        switch (_value)
+        {
+            case 1:
+            case 2:
+            case 3:
+            case 4:
+            case 5:
+            case 7:
+            case 8:
+            case 9:
+            case 21:
+            case 22:
+            case 23:
+            case 24:
+            case 25:
+            case 27:
+            case 28:
+            case 29:
+            case 51:
+            case 53:
+            case 54:
+            case 55: return true;
+            default: return false;
+        }
+    }
+
+    constexpr bool isPlainSGRColor(unsigned _value) noexcept
+    {
+        return (30 <= _value && _value <= 37) || _value == 39 || (40 <= _value && _value <= 47)
+               || _value == 49 || (90 <= _value && _value <= 97) || (100 <= _value && _value <= 107);
+    }
+
+    /// Tests for the semicolon-delimited extended color forms "5;P" and "2;R;G;B" at parameter @p i.
+    ///
+    /// @returns the number of parameters following the 38/48 that make up the color, or 0 if unsupported.
+    size_t plainExtendedColorLength(Sequence const& _seq, size_t i) noexcept
+    {
+        auto const count = _seq.parameterCount();
+        if (i + 2 < count && _seq.param(i + 1) == 5 && _seq.param(i + 2) <= 255)
+            return 2;
+        if (i + 4 < count && _seq.param(i + 1) == 2 && _seq.param(i + 2) <= 255 && _seq.param(i + 3) <= 255
+            && _seq.param(i + 4) <= 255)
+            return 4;
+        return 0;
+    }
+
+    Color plainExtendedColor(Sequence const& _seq, size_t i) noexcept
+    {
+        if (_seq.param(i + 1) == 5)
+            return Color { static_cast<IndexedColor>(_seq.param(i + 2)) };
+        return Color { RGBColor { static_cast<uint8_t>(_seq.param(i + 2)),
+                                  static_cast<uint8_t>(_seq.param(i + 3)),
+                                  static_cast<uint8_t>(_seq.param(i + 4)) } };
+    }
+
+    Color plainSGRColor(unsigned _value) noexcept
+    {
+        if (_value == 39 || _value == 49)
+            return DefaultColor();
+        if (_value >= 90)
+            return static_cast<BrightColor>((_value - (_value >= 100 ? 100 : 90)));
+        return static_cast<IndexedColor>(_value % 10);
+    }
+} // namespace
+
+/// Applies a plain SGR sequence (no leader, no intermediates, no sub-parameters) directly
+/// onto the cursor's graphics rendition, bypassing the generic function dispatch.
+///
+/// @returns true if the sequence has been applied, false if it contains anything
+///          that requires to be handled by Screen.
+bool Sequencer::tryApplyPlainSGR()
+{
+    auto const& seq = sequence_;
+    auto const count = seq.parameterCount();
+
+    // Validate first, so that the sequence is either fully applied here or not at all.
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (seq.isSubParameter(i) || seq.subParameterCount(i) != 0)
+            return false;
+        auto const value = seq.param(i);
+        if (value == 38 || value == 48)
+        {
+            auto const length = plainExtendedColorLength(seq, i);
+            if (!length)
+                return false;
+            i += length;
+        }
+        else if (value != 0 && !isPlainSGRStyle(value) && !isPlainSGRColor(value))
+            return false;
+    }
+
+#if defined(LIBTERMINAL_LOG_TRACE)
+    if (VTTraceSequenceLog)
+        VTTraceSequenceLog()("Handle VT sequence: {}", seq);
+#endif
+
+    terminal_.state().instructionCounter++;
+
+    if (count == 0)
+    {
+        terminal_.setGraphicsRendition(GraphicsRendition::Reset);
+        return true;
+    }
+
+    auto& attributes = terminal_.state().cursor.graphicsRendition;
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto const value = seq.param(i);
+        switch (value)
+        {
+            case 0: terminal_.setGraphicsRendition(GraphicsRendition::Reset); break;
+            case 38:
+                attributes.foregroundColor = plainExtendedColor(seq, i);
+                i += plainExtendedColorLength(seq, i);
+                break;
+            case 48:
+                attributes.backgroundColor = plainExtendedColor(seq, i);
+                i += plainExtendedColorLength(seq, i);
+                break;
+            default:
+                if (isPlainSGRStyle(value))
+                    terminal_.setGraphicsRendition(static_cast<GraphicsRendition>(value));
+                else if (value < 40 || (90 <= value && value < 100))
+                    attributes.foregroundColor = plainSGRColor(value);
+                else
+                    attributes.backgroundColor = plainSGRColor(value);
+                break;
+        }
+    }
+
+    return true;
 }
 
 } // namespace terminal
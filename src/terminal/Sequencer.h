@@ -138,6 +138,7 @@ class Sequencer
     void error(std::string_view _errorString);
     void print(char _text);
     void print(std::string_view _chars, size_t cellCount);
+    void print(std::u32string_view _codepoints);
     void execute(char _controlCode);
     void clear() noexcept;
     void collect(char _char);
@@ -146,21 +147,27 @@ class Sequencer
     void paramDigit(char _char) noexcept;
     void paramSeparator() noexcept;
     void paramSubSeparator() noexcept;
+    void params(std::string_view _parameters) noexcept;
     void dispatchESC(char _function);
     void dispatchCSI(char _function);
     void startOSC();
     void putOSC(char _char);
+    void putOSC(std::string_view _chars);
     void dispatchOSC();
     void hook(char _function);
     void put(char _char);
+    void put(std::string_view _chars);
     void unhook();
-    void startAPC() {}
-    void putAPC(char) {}
-    void dispatchAPC() {}
+    void startAPC();
+    void putAPC(char _char);
+    void dispatchAPC();
     void startPM() {}
     void putPM(char) {}
     void dispatchPM() {}
 
+    /// Tests whether a UTF-8 sequence has been started but not completed yet.
+    [[nodiscard]] bool decodingUtf8() const noexcept { return utf8DecoderState_.expectedLength != 0; }
+
     void hookParser(std::unique_ptr<ParserExtension> parserExtension) noexcept
     {
         hookedParser_ = std::move(parserExtension);
@@ -169,6 +176,7 @@ class Sequencer
   private:
     void resetUtf8DecoderState() noexcept;
     void handleSequence();
+    bool tryApplyPlainSGR();
 
     // private data
     //
@@ -179,6 +187,10 @@ class Sequencer
 
     std::unique_ptr<ParserExtension> hookedParser_;
     std::unique_ptr<SixelImageBuilder> sixelImageBuilder_;
+
+    /// Maximum number of bytes collected for a single APC, such as a kitty graphics command.
+    static constexpr size_t MaxApcLength = 16 * 1024 * 1024;
+    std::string apcData_;
 };
 
 // {{{ inlines
@@ -208,6 +220,19 @@ inline void Sequencer::paramSubSeparator() noexcept
 {
     parameterBuilder_.nextSubParameter();
 }
+
+inline void Sequencer::params(std::string_view _parameters) noexcept
+{
+    for (char const ch: _parameters)
+    {
+        if (ch == ';')
+            parameterBuilder_.nextParameter();
+        else if (ch == ':')
+            parameterBuilder_.nextSubParameter();
+        else
+            parameterBuilder_.multiplyBy10AndAdd(static_cast<uint8_t>(ch - '0'));
+    }
+}
 // }}}
 
 } // namespace terminal
@@ -0,0 +1,257 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/PngDecoder.h>
+#include <terminal/SixelDecoder.h>
+
+#include <algorithm>
+#include <array>
+
+using std::array;
+using std::clamp;
+using std::lock_guard;
+using std::move;
+using std::nullopt;
+using std::optional;
+using std::pair;
+using std::string_view;
+using std::unique_lock;
+using std::vector;
+
+using std::chrono::steady_clock;
+
+namespace terminal
+{
+
+namespace
+{
+    optional<pair<ImageSize, Image::Data>> decodeJob(SixelDecoder::Job const& _job)
+    {
+        if (_job.format == SixelDecoder::Format::Sixel)
+            return SixelDecoder::decodeNow(_job.data, _job.parameters);
+
+        if (auto pixels = decodePng(_job.data, _job.size))
+            return pair { _job.size, move(*pixels) };
+
+        return nullopt; // A broken image leaves its placeholder blank.
+    }
+} // namespace
+
+SixelDecoder::SixelDecoder(std::function<void()> _onDecoded): onDecoded_ { move(_onDecoded) }
+{
+}
+
+SixelDecoder::~SixelDecoder()
+{
+    {
+        auto const _l = lock_guard { mutex_ };
+        stopping_ = true;
+    }
+    condition_.notify_one();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+void SixelDecoder::decode(Job _job)
+{
+    {
+        auto const _l = lock_guard { mutex_ };
+        jobs_.emplace_back(move(_job));
+        if (!worker_.joinable())
+            worker_ = std::thread { [this]() { run(); } };
+    }
+    condition_.notify_one();
+}
+
+vector<SixelDecoder::Result> SixelDecoder::fetchResults()
+{
+    auto const _l = lock_guard { mutex_ };
+    resultsAvailable_ = false;
+    return move(results_);
+}
+
+void SixelDecoder::run()
+{
+    for (;;)
+    {
+        auto lock = unique_lock { mutex_ };
+        condition_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+        if (stopping_)
+            return;
+
+        auto job = move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+
+        // Don't bother decoding images that have been scrolled out or erased meanwhile.
+        if (job.placeholder.expired())
+            continue;
+
+        auto decoded = decodeJob(job);
+        if (!decoded)
+            continue;
+
+        lock.lock();
+        results_.emplace_back(Result { move(job.placeholder), decoded->first, move(decoded->second) });
+        resultsAvailable_ = true;
+        lock.unlock();
+
+        if (onDecoded_)
+            onDecoded_();
+    }
+}
+
+pair<ImageSize, Image::Data> SixelDecoder::decodeNow(string_view _data, Parameters const& _parameters)
+{
+    auto builder = SixelImageBuilder(_parameters.maxSize,
+                                     _parameters.aspectVertical,
+                                     _parameters.aspectHorizontal,
+                                     _parameters.backgroundColor,
+                                     _parameters.colorPalette);
+    SixelParser::parse(_data, builder);
+    return { builder.size(), move(builder.data()) };
+}
+
+optional<ImageSize> SixelDecoder::imageSize(string_view _data, ImageSize _maxSize) noexcept
+{
+    // Raster attributes: '"' Pan ';' Pad ';' Ph ';' Pv
+    if (_data.empty() || _data.front() != '"')
+        return nullopt;
+
+    auto params = array<unsigned, 4> {};
+    auto count = size_t { 1 };
+    for (auto const ch: _data.substr(1))
+    {
+        if (ch >= '0' && ch <= '9')
+            params[count - 1] = params[count - 1] * 10 + static_cast<unsigned>(ch - '0');
+        else if (ch == ';')
+        {
+            if (count == params.size())
+                return nullopt; // Not a valid raster attribute, thus ignored by the parser, too.
+            ++count;
+        }
+        else
+            break;
+    }
+
+    if (count != params.size())
+        return nullopt;
+
+    return ImageSize { clamp(Width(params[2]), Width(0), _maxSize.width),
+                       clamp(Height(params[3]), Height(0), _maxSize.height) };
+}
+
+ProgressiveSixelCollector::ProgressiveSixelCollector(SixelDecoder::Parameters _parameters,
+                                                     int _rowGranularity,
+                                                     Handlers _handlers,
+                                                     std::chrono::milliseconds _progressiveDelay):
+    parameters_ { move(_parameters) },
+    rowGranularity_ { std::max(1, _rowGranularity) },
+    handlers_ { move(_handlers) },
+    progressiveDelay_ { _progressiveDelay },
+    startTime_ { steady_clock::now() }
+{
+}
+
+void ProgressiveSixelCollector::pass(char _char)
+{
+    if (parser_)
+    {
+        parser_->parse(_char);
+        if (_char == '-')
+            publishRows(unbox<int>(builder_->sixelCursor().line));
+        return;
+    }
+
+    data_.push_back(_char);
+
+    // Only check the clock at the end of each sixel band.
+    if (_char != '-' || data_.front() != '"' || steady_clock::now() - startTime_ < progressiveDelay_)
+        return;
+
+    auto const size = SixelDecoder::imageSize(data_, parameters_.maxSize);
+    if (size && size->area() != 0)
+        startProgressive(*size);
+}
+
+void ProgressiveSixelCollector::pass(string_view _chars)
+{
+    // Only the ends of sixel bands need to be looked at individually.
+    while (!_chars.empty())
+    {
+        auto const bandEnd = _chars.find('-');
+        auto const fragment = _chars.substr(0, bandEnd);
+        if (parser_)
+            parser_->parseFragment(fragment);
+        else
+            data_.append(fragment);
+
+        if (bandEnd == string_view::npos)
+            return;
+
+        pass('-');
+        _chars.remove_prefix(bandEnd + 1);
+    }
+}
+
+void ProgressiveSixelCollector::startProgressive(ImageSize _size)
+{
+    builder_.emplace(parameters_.maxSize,
+                     parameters_.aspectVertical,
+                     parameters_.aspectHorizontal,
+                     parameters_.backgroundColor,
+                     parameters_.colorPalette);
+    parser_.emplace(*builder_);
+    parser_->parseFragment(data_);
+    data_.clear();
+    data_.shrink_to_fit();
+
+    if (handlers_.start)
+        handlers_.start(_size);
+
+    publishRows(unbox<int>(builder_->sixelCursor().line));
+}
+
+void ProgressiveSixelCollector::publishRows(int _completedRows)
+{
+    auto const height = unbox<int>(builder_->size().height);
+    auto const rows = std::min(_completedRows, height) / rowGranularity_ * rowGranularity_;
+    auto const last = _completedRows >= height ? height : rows;
+    if (last <= publishedRows_)
+        return;
+
+    auto const stride = unbox<size_t>(builder_->size().width) * 4;
+    auto const& buffer = builder_->data();
+    auto pixels = Image::Data(buffer.begin() + static_cast<ptrdiff_t>(size_t(publishedRows_) * stride),
+                              buffer.begin() + static_cast<ptrdiff_t>(size_t(last) * stride));
+    auto const size = ImageSize { builder_->size().width, Height::cast_from(last - publishedRows_) };
+
+    if (handlers_.rows)
+        handlers_.rows(publishedRows_, size, move(pixels));
+    publishedRows_ = last;
+}
+
+void ProgressiveSixelCollector::finalize()
+{
+    if (parser_)
+    {
+        parser_->done();
+        publishRows(unbox<int>(builder_->size().height));
+    }
+    else if (handlers_.complete)
+        handlers_.complete(data_);
+
+    data_.clear();
+}
+
+} // namespace terminal
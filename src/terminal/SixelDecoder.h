@@ -0,0 +1,174 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/Color.h>
+#include <terminal/Image.h>
+#include <terminal/ParserExtension.h>
+#include <terminal/SixelParser.h>
+#include <terminal/primitives.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace terminal
+{
+
+/// Decodes Sixel images on a worker thread.
+///
+/// Large Sixel payloads are handed over here once their DCS is complete, so that
+/// decoding them does not block the terminal thread (and thus input and rendering).
+/// The same goes for large PNG images of the kitty graphics protocol.
+/// The screen reserves the image's grid cells with a placeholder RasterizedImage that is
+/// replaced once the decoded pixels are fetched via fetchResults().
+class SixelDecoder
+{
+  public:
+    /// Sixel payloads of at least this many bytes are decoded on the worker thread.
+    static constexpr size_t AsyncThreshold = 256 * 1024;
+
+    struct Parameters
+    {
+        ImageSize maxSize;
+        int aspectVertical;
+        int aspectHorizontal;
+        RGBAColor backgroundColor;
+        std::shared_ptr<SixelColorPalette> colorPalette;
+    };
+
+    enum class Format
+    {
+        Sixel,
+        Png,
+    };
+
+    struct Job
+    {
+        std::string data;
+        Parameters parameters;
+        std::weak_ptr<RasterizedImage const> placeholder;
+        Format format = Format::Sixel;
+        ImageSize size {}; // PNG only: the size announced by the image header
+    };
+
+    struct Result
+    {
+        std::weak_ptr<RasterizedImage const> placeholder;
+        ImageSize size;
+        Image::Data pixels;
+    };
+
+    /// @param _onDecoded invoked on the worker thread whenever a new result is available.
+    explicit SixelDecoder(std::function<void()> _onDecoded);
+    ~SixelDecoder();
+
+    SixelDecoder(SixelDecoder const&) = delete;
+    SixelDecoder& operator=(SixelDecoder const&) = delete;
+
+    /// Enqueues a Sixel payload or PNG image for decoding. The worker thread is started on first use.
+    void decode(Job _job);
+
+    [[nodiscard]] bool hasResults() const noexcept { return resultsAvailable_.load(); }
+
+    /// Returns and removes all results that were decoded so far.
+    [[nodiscard]] std::vector<Result> fetchResults();
+
+    /// Decodes a Sixel payload right away on the calling thread.
+    ///
+    /// @returns the image size and its RGBA pixels.
+    static std::pair<ImageSize, Image::Data> decodeNow(std::string_view _data,
+                                                       Parameters const& _parameters);
+
+    /// Determines the size the image that is described by @p _data is going to have, without
+    /// decoding it, by looking at the raster attributes leading the payload.
+    ///
+    /// @returns the announced size, or nothing if the payload does not start with raster attributes.
+    static std::optional<ImageSize> imageSize(std::string_view _data, ImageSize _maxSize) noexcept;
+
+  private:
+    void run();
+
+    std::function<void()> onDecoded_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Job> jobs_;
+    std::vector<Result> results_;
+    std::atomic<bool> resultsAvailable_ = false;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+/// Collects a Sixel payload, decoding it progressively if it arrives slowly.
+///
+/// Payloads are collected as a whole and handed to Handlers::complete, unless they are still
+/// arriving after the progressive delay (e.g. on slow remote links) and announce their size
+/// via raster attributes. Then the collected data is decoded right away, and so is any data
+/// that follows, while completed pixel rows are published as they become available.
+class ProgressiveSixelCollector: public ParserExtension
+{
+  public:
+    static constexpr auto DefaultProgressiveDelay = std::chrono::milliseconds(100);
+
+    struct Handlers
+    {
+        /// Invoked with the whole payload if it has not been decoded progressively.
+        std::function<void(std::string_view)> complete;
+
+        /// Invoked once when progressive decoding starts, with the size of the image.
+        std::function<void(ImageSize)> start;
+
+        /// Invoked with the RGBA pixels of the rows starting at the given row that got completed.
+        std::function<void(int /*_firstRow*/, ImageSize /*_size*/, Image::Data /*_pixels*/)> rows;
+    };
+
+    /// @param _rowGranularity publish completed rows in multiples of this many rows
+    ///                        (except for the last ones), e.g. the grid cell height.
+    ProgressiveSixelCollector(SixelDecoder::Parameters _parameters,
+                              int _rowGranularity,
+                              Handlers _handlers,
+                              std::chrono::milliseconds _progressiveDelay = DefaultProgressiveDelay);
+
+    void pass(char _char) override;
+    void pass(std::string_view _chars) override;
+    void finalize() override;
+
+    [[nodiscard]] bool progressive() const noexcept { return parser_.has_value(); }
+
+  private:
+    void startProgressive(ImageSize _size);
+    void publishRows(int _completedRows);
+
+    SixelDecoder::Parameters parameters_;
+    int rowGranularity_;
+    Handlers handlers_;
+    std::chrono::milliseconds progressiveDelay_;
+    std::chrono::steady_clock::time_point startTime_;
+    std::string data_;
+    std::optional<SixelImageBuilder> builder_;
+    std::optional<SixelParser> parser_;
+    int publishedRows_ = 0;
+};
+
+} // namespace terminal
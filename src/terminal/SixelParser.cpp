@@ -14,6 +14,13 @@
 #include <terminal/SixelParser.h>
 
 #include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+    #include <immintrin.h>
+#elif defined(__aarch64__)
+    #include <crispy/sse2neon.h>
+#endif
 
 using std::clamp;
 using std::fill;
@@ -38,6 +45,18 @@ namespace
     }
 
     constexpr RGBColor rgb(uint8_t r, uint8_t g, uint8_t b) { return RGBColor { r, g, b }; }
+
+    /// Fills @p _count consecutive RGBA pixels starting at @p _target with @p _pixel.
+    void fillPixels(uint8_t* _target, uint32_t _pixel, unsigned _count) noexcept
+    {
+#if defined(__SSE2__) || defined(__aarch64__)
+        auto const pattern = _mm_set1_epi32(static_cast<int>(_pixel));
+        for (; _count >= 4; _count -= 4, _target += 16)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(_target), pattern);
+#endif
+        for (; _count != 0; --_count, _target += 4)
+            std::memcpy(_target, &_pixel, sizeof(_pixel));
+    }
 } // namespace
 
 // VT 340 default color palette (https://www.vt100.net/docs/vt3xx-gp/chapter2.html#S2.4)
@@ -120,9 +139,7 @@ void SixelParser::parse(char _value)
                 paramShiftAndAddDigit(toDigit(_value));
             else if (isSixel(_value))
             {
-                auto const sixel = toSixel(_value);
-                for (unsigned i = 0; i < params_[0]; ++i)
-                    events_.render(sixel);
+                events_.render(toSixel(_value), params_[0]);
                 transitionTo(State::Ground);
             }
             else
@@ -183,7 +200,7 @@ void SixelParser::fallback(char _value)
             transitionTo(State::Ground);
 
         if (isSixel(_value))
-            events_.render(toSixel(_value));
+            events_.render(toSixel(_value), 1);
     }
 
     // ignore any other input value
@@ -327,20 +344,6 @@ RGBAColor SixelImageBuilder::at(CellLocation _coord) const noexcept
     return RGBAColor { color[0], color[1], color[2], color[3] };
 }
 
-void SixelImageBuilder::write(CellLocation const& _coord, RGBColor const& _value) noexcept
-{
-    if (unbox<int>(_coord.line) >= 0 && unbox<int>(_coord.line) < unbox<int>(size_.height)
-        && unbox<int>(_coord.column) >= 0 && unbox<int>(_coord.column) < unbox<int>(size_.width))
-    {
-        auto const base = unbox<unsigned>(_coord.line) * unbox<unsigned>(size_.width) * 4
-                          + unbox<unsigned>(_coord.column) * 4;
-        buffer_[base + 0] = _value.red;
-        buffer_[base + 1] = _value.green;
-        buffer_[base + 2] = _value.blue;
-        buffer_[base + 3] = 0xFF;
-    }
-}
-
 void SixelImageBuilder::setColor(unsigned _index, RGBColor const& _color)
 {
     colors_->setColor(_index, _color);
@@ -374,23 +377,33 @@ void SixelImageBuilder::setRaster(int _pan, int _pad, ImageSize _imageSize)
     buffer_.resize(size_.area() * 4);
 }
 
-void SixelImageBuilder::render(int8_t _sixel)
+void SixelImageBuilder::render(int8_t _sixel, unsigned _repeatCount)
 {
     // TODO: respect aspect ratio!
-    auto const x = sixelCursor_.column;
-    if (unbox<int>(x) < unbox<int>(size_.width))
+    auto const width = unbox<unsigned>(size_.width);
+    auto const height = unbox<unsigned>(size_.height);
+    auto const x = unbox<unsigned>(sixelCursor_.column);
+    if (x >= width)
+        return;
+
+    // A sixel and its repetitions form a 6 pixel high span, of which
+    // each pinned row is filled at once.
+    auto const count = min(_repeatCount, width - x);
+    auto const top = unbox<unsigned>(sixelCursor_.line);
+    if (_sixel != 0 && top < height)
     {
-        for (int i = 0; i < 6; ++i)
-        {
-            auto const y = sixelCursor_.line + i;
-            auto const pos = CellLocation { y, x };
-            auto const pin = 1 << i;
-            auto const pinned = (_sixel & pin) != 0;
-            if (pinned)
-                write(pos, currentColor());
-        }
-        sixelCursor_.column++;
+        auto const color = currentColor();
+        auto const rgba = std::array<uint8_t, 4> { color.red, color.green, color.blue, 0xFF };
+        auto pixel = uint32_t {};
+        std::memcpy(&pixel, rgba.data(), sizeof(pixel));
+
+        auto const rows = min(6u, height - top);
+        for (unsigned i = 0; i < rows; ++i)
+            if (_sixel & (1 << i))
+                fillPixels(&buffer_[((top + i) * width + x) * 4], pixel, count);
     }
+
+    sixelCursor_.column += ColumnOffset::cast_from(count);
 }
 
 } // namespace terminal
@@ -73,8 +73,9 @@ class SixelParser: public ParserExtension
         /// the upcoming pixel data.
         virtual void setRaster(int _pan, int _pad, ImageSize _imageSize) = 0;
 
-        /// renders a given sixel at the current sixel-cursor position.
-        virtual void render(int8_t _sixel) = 0;
+        /// Renders the given sixel @p _repeatCount times, starting at the current sixel-cursor
+        /// position, advancing the sixel-cursor accordingly.
+        virtual void render(int8_t _sixel, unsigned _repeatCount) = 0;
     };
 
     using OnFinalize = std::function<void()>;
@@ -105,6 +106,7 @@ class SixelParser: public ParserExtension
 
     // ParserExtension overrides
     void pass(char _char) override;
+    void pass(std::string_view _chars) override { parseFragment(_chars); }
     void finalize() override;
 
   private:
@@ -146,7 +148,7 @@ class SixelColorPalette
 /// Sixel Image Builder API
 ///
 /// Implements the SixelParser::Events event listener to construct a Sixel image.
-class SixelImageBuilder: public SixelParser::Events
+class SixelImageBuilder final: public SixelParser::Events
 {
   public:
     using Buffer = std::vector<uint8_t>;
@@ -175,13 +177,10 @@ class SixelImageBuilder: public SixelParser::Events
     void rewind() override;
     void newline() override;
     void setRaster(int _pan, int _pad, ImageSize _imageSize) override;
-    void render(int8_t _sixel) override;
+    void render(int8_t _sixel, unsigned _repeatCount) override;
 
     [[nodiscard]] CellLocation const& sixelCursor() const noexcept { return sixelCursor_; }
 
-  private:
-    void write(CellLocation const& _coord, RGBColor const& _value) noexcept;
-
   private:
     ImageSize const maxSize_;
     std::shared_ptr<SixelColorPalette> colors_;
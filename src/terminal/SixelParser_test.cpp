@@ -11,6 +11,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <terminal/SixelDecoder.h>
 #include <terminal/SixelParser.h>
 
 #include <crispy/times.h>
@@ -243,6 +244,33 @@ TEST_CASE("SixelParser.rep", "[sixel]")
     }
 }
 
+TEST_CASE("SixelParser.rep_clipped", "[sixel]")
+{
+    auto constexpr defaultColor = RGBAColor { 0, 0, 0, 0xFF };
+    auto constexpr pinColor = RGBColor { 0x10, 0x20, 0x30 };
+    auto ib = sixelImageBuilder(ImageSize { Width(7), Height(4) }, defaultColor);
+    auto sp = SixelParser { ib };
+
+    ib.setColor(0, pinColor);
+
+    sp.parseFragment("?!100~");
+
+    CHECK(ib.sixelCursor() == CellLocation { LineOffset(0), ColumnOffset(7) });
+
+    for (int x = 0; x < ib.size().width.as<int>(); ++x)
+    {
+        for (int y = 0; y < ib.size().height.as<int>(); ++y)
+        {
+            auto const& actualColor = ib.at(CellLocation { LineOffset(y), ColumnOffset(x) });
+            INFO(fmt::format("x={}, y={}", x, y));
+            if (x >= 1)
+                CHECK(actualColor.rgb() == pinColor);
+            else
+                CHECK(actualColor == defaultColor);
+        }
+    }
+}
+
 TEST_CASE("SixelParser.setAndUseColor", "[sixel]")
 {
     auto constexpr pinColors = std::array<RGBAColor, 4> { RGBAColor { 255, 0, 0, 255 },
@@ -351,3 +379,145 @@ TEST_CASE("SixelParser.newline", "[sixel]")
         }
     }
 }
+
+TEST_CASE("SixelDecoder.imageSize", "[sixel]")
+{
+    auto constexpr maxSize = ImageSize { Width(100), Height(50) };
+
+    CHECK(SixelDecoder::imageSize("\"1;1;20;10#0~", maxSize) == ImageSize { Width(20), Height(10) });
+    CHECK(SixelDecoder::imageSize("\"1;1;200;10~", maxSize) == ImageSize { Width(100), Height(10) });
+    CHECK_FALSE(SixelDecoder::imageSize("\"1;1;20~", maxSize).has_value());
+    CHECK_FALSE(SixelDecoder::imageSize("\"1;1;20;10;5~", maxSize).has_value());
+    CHECK_FALSE(SixelDecoder::imageSize("#0~", maxSize).has_value());
+
+    // The decoded image is sized exactly as announced up front.
+    auto const data = std::string_view("\"1;1;20;10#0!20~");
+    auto const [size, pixels] = SixelDecoder::decodeNow(
+        data,
+        SixelDecoder::Parameters {
+            maxSize, 1, 1, RGBAColor { 0, 0, 0, 0 }, std::make_shared<SixelColorPalette>(16, 256) });
+    CHECK(size == SixelDecoder::imageSize(data, maxSize));
+    CHECK(pixels.size() == size.area() * 4);
+}
+
+namespace
+{
+struct PublishedRows
+{
+    int firstRow;
+    ImageSize size;
+    Image::Data pixels;
+};
+
+void passAll(ParserExtension& _collector, std::string_view _data, size_t _chunkSize = 1)
+{
+    if (_chunkSize == 1)
+        for (auto const ch: _data)
+            _collector.pass(ch);
+    else
+        for (size_t i = 0; i < _data.size(); i += _chunkSize)
+            _collector.pass(_data.substr(i, _chunkSize));
+    _collector.finalize();
+}
+} // namespace
+
+TEST_CASE("ProgressiveSixelCollector.progressive", "[sixel]")
+{
+    auto constexpr maxSize = ImageSize { Width(100), Height(50) };
+    auto const parameters = SixelDecoder::Parameters {
+        maxSize, 1, 1, RGBAColor { 0, 0, 0, 0 }, std::make_shared<SixelColorPalette>(16, 256)
+    };
+
+    auto started = std::optional<ImageSize> {};
+    auto published = std::vector<PublishedRows> {};
+    auto handlers = ProgressiveSixelCollector::Handlers {};
+    handlers.complete = [](std::string_view) { FAIL("Payload was expected to be decoded progressively."); };
+    handlers.start = [&](ImageSize _size) { started = _size; };
+    handlers.rows = [&](int _firstRow, ImageSize _size, Image::Data _pixels) {
+        published.emplace_back(PublishedRows { _firstRow, _size, std::move(_pixels) });
+    };
+
+    // Two bands of 2x6 red pixels each.
+    auto collector =
+        ProgressiveSixelCollector(parameters, 6, std::move(handlers), std::chrono::milliseconds(0));
+    passAll(collector, "\"1;1;2;12#0;2;100;0;0#0~~-~~");
+
+    CHECK(collector.progressive());
+    REQUIRE(started.has_value());
+    CHECK(*started == ImageSize { Width(2), Height(12) });
+
+    REQUIRE(published.size() == 2);
+    CHECK(published[0].firstRow == 0);
+    CHECK(published[0].size == ImageSize { Width(2), Height(6) });
+    CHECK(published[1].firstRow == 6);
+    CHECK(published[1].size == ImageSize { Width(2), Height(6) });
+    for (auto const& rows: published)
+    {
+        REQUIRE(rows.pixels.size() == 2 * 6 * 4);
+        CHECK(rows.pixels[0] == 0xFF);
+        CHECK(rows.pixels[1] == 0x00);
+        CHECK(rows.pixels[3] == 0xFF);
+    }
+}
+
+TEST_CASE("ProgressiveSixelCollector.progressive.chunked", "[sixel]")
+{
+    auto constexpr maxSize = ImageSize { Width(100), Height(50) };
+
+    for (auto const chunkSize: { size_t { 3 }, size_t { 64 } })
+    {
+        INFO(fmt::format("chunk size: {}", chunkSize));
+        auto const parameters = SixelDecoder::Parameters {
+            maxSize, 1, 1, RGBAColor { 0, 0, 0, 0 }, std::make_shared<SixelColorPalette>(16, 256)
+        };
+        auto published = std::vector<PublishedRows> {};
+        auto handlers = ProgressiveSixelCollector::Handlers {};
+        handlers.rows = [&](int _firstRow, ImageSize _size, Image::Data _pixels) {
+            published.emplace_back(PublishedRows { _firstRow, _size, std::move(_pixels) });
+        };
+
+        auto collector =
+            ProgressiveSixelCollector(parameters, 6, std::move(handlers), std::chrono::milliseconds(0));
+        passAll(collector, "\"1;1;2;12#0;2;100;0;0#0~~-~~", chunkSize);
+
+        CHECK(collector.progressive());
+        REQUIRE(published.size() == 2);
+        CHECK(published[0].firstRow == 0);
+        CHECK(published[1].firstRow == 6);
+        REQUIRE(published[1].pixels.size() == 2 * 6 * 4);
+        CHECK(published[1].pixels[0] == 0xFF);
+    }
+}
+
+TEST_CASE("ProgressiveSixelCollector.complete", "[sixel]")
+{
+    auto constexpr maxSize = ImageSize { Width(100), Height(50) };
+    auto const parameters = SixelDecoder::Parameters {
+        maxSize, 1, 1, RGBAColor { 0, 0, 0, 0 }, std::make_shared<SixelColorPalette>(16, 256)
+    };
+    auto constexpr data = std::string_view("\"1;1;2;12#0~~-~~");
+
+    SECTION("fast")
+    {
+        auto completed = std::string {};
+        auto handlers = ProgressiveSixelCollector::Handlers {};
+        handlers.complete = [&](std::string_view _data) { completed = _data; };
+        handlers.rows = [](int, ImageSize, Image::Data) { FAIL("Payload was expected to be collected."); };
+        auto collector = ProgressiveSixelCollector(parameters, 6, std::move(handlers), std::chrono::hours(1));
+        passAll(collector, data);
+        CHECK(!collector.progressive());
+        CHECK(completed == data);
+    }
+
+    SECTION("without raster attributes")
+    {
+        auto completed = std::string {};
+        auto handlers = ProgressiveSixelCollector::Handlers {};
+        handlers.complete = [&](std::string_view _data) { completed = _data; };
+        auto collector =
+            ProgressiveSixelCollector(parameters, 6, std::move(handlers), std::chrono::milliseconds(0));
+        passAll(collector, data.substr(9));
+        CHECK(!collector.progressive());
+        CHECK(completed == data.substr(9));
+    }
+}
@@ -13,21 +13,30 @@
  */
 #include <terminal/ControlCode.h>
 #include <terminal/InputGenerator.h>
+#include <terminal/InputPreprocessor.h>
 #include <terminal/RenderBuffer.h>
 #include <terminal/RenderBufferBuilder.h>
 #include <terminal/Terminal.h>
+#include <terminal/TmuxControl.h>
 #include <terminal/logging.h>
 #include <terminal/pty/MockPty.h>
 
+#include <crispy/PerfTrace.h>
+#include <crispy/WorkerPool.h>
 #include <crispy/escape.h>
 #include <crispy/stdfs.h>
 #include <crispy/utils.h>
 
 #include <fmt/chrono.h>
 
+#include <unicode/width.h>
+
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <csignal>
 #include <iostream>
+#include <thread>
 #include <utility>
 
 #include <sys/types.h>
@@ -45,24 +54,72 @@ namespace terminal
 
 namespace // {{{ helpers
 {
+    /// Minimum size of a PTY read to be pre-processed in parallel, if enabled at all.
+    constexpr size_t ParallelParsingThreshold = 64 * 1024;
+
+    constexpr size_t MaxParsingThreads = 4;
+
     void trimSpaceRight(string& value)
     {
         while (!value.empty() && value.back() == ' ')
             value.pop_back();
     }
 
+    /// Appends the text of the selected range @p _range of @p _line to @p _text.
+    template <typename Cell>
+    void appendSelectedText(string& _text, Line<Cell> const& _line, Selection::Range _range)
+    {
+        if (_line.isTrivialBuffer())
+        {
+            // With as many bytes as used columns, the text is plain US-ASCII,
+            // so the selected columns can be copied straight from the line's text buffer.
+            auto const& buffer = _line.trivialBuffer();
+            auto const text = buffer.text.view();
+            if (text.size() == unbox<size_t>(buffer.usedColumns))
+            {
+                auto const from = min(unbox<size_t>(_range.fromColumn), text.size());
+                auto const to = min(unbox<size_t>(_range.toColumn) + 1, text.size());
+                _text.append(text.data() + from, to - from);
+                return;
+            }
+        }
+
+        auto const cells = _line.cells();
+        auto const to = min(unbox<size_t>(_range.toColumn) + 1, cells.size());
+        for (auto i = unbox<size_t>(_range.fromColumn); i < to; ++i)
+            _text += cells[i].toUtf8();
+    }
+
 #if defined(CONTOUR_PERF_STATS)
-    void logRenderBufferSwap(bool _success, uint64_t _frameID)
+    void logRenderBufferSwap(bool _success, uint64_t _frameID, uint64_t _skippedFrames)
     {
         if (!RenderBufferLog)
             return;
 
         if (_success)
-            RenderBufferLog()("Render buffer {} swapped.", _frameID);
+            RenderBufferLog()("Render buffer {} swapped ({} skipped frames).", _frameID, _skippedFrames);
         else
             RenderBufferLog()("Render buffer {} swapping failed.", _frameID);
     }
 #endif
+
+    /// Passes the contents of the DCS tmux -CC wraps its output in on to the tmux session.
+    class TmuxControlExtension: public ParserExtension
+    {
+      public:
+        TmuxControlExtension(TmuxSession& _session, std::function<void()> _done):
+            session_ { _session }, done_ { std::move(_done) }
+        {
+        }
+
+        void pass(char _char) override { session_.parse(string_view(&_char, 1)); }
+        void pass(string_view _chars) override { session_.parse(_chars); }
+        void finalize() override { done_(); }
+
+      private:
+        TmuxSession& session_;
+        std::function<void()> done_;
+    };
 } // namespace
 // }}}
 
@@ -84,7 +141,7 @@ Terminal::Terminal(unique_ptr<Pty> _pty,
                    bool _allowReflowOnResize):
     changes_ { 0 },
     eventListener_ { _eventListener },
-    refreshInterval_ { static_cast<long long>(1000.0 / _refreshRate) },
+    frameScheduler_ { _refreshRate },
     renderBuffer_ {},
     pty_ { move(_pty) },
     startTime_ { _now },
@@ -107,7 +164,8 @@ Terminal::Terminal(unique_ptr<Pty> _pty,
              move(_colorPalette),
              _allowReflowOnResize },
     // clang-format on
-    ptyBufferPool_ { crispy::nextPowerOfTwo(ptyBufferObjectSize) },
+    ptyBufferPool_ { crispy::nextPowerOfTwo(ptyBufferObjectSize),
+                     ptyBufferObjectSize >= crispy::HugePageSize },
     currentPtyBuffer_ { ptyBufferPool_.allocateBufferObject() },
     ptyReadBufferSize_ { crispy::nextPowerOfTwo(_ptyReadBufferSize) },
     primaryScreen_ { state_, ScreenType::Primary, state_.primaryBuffer },
@@ -117,7 +175,10 @@ Terminal::Terminal(unique_ptr<Pty> _pty,
                 [this]() {
                     breakLoopAndRefreshRenderBuffer();
                 } },
-    selectionHelper_ { this }
+    selectionHelper_ { this },
+    sixelDecoder_ { [this]() {
+        pty_->wakeupReader();
+    } }
 {
 #if 0
     hardReset();
@@ -126,11 +187,14 @@ Terminal::Terminal(unique_ptr<Pty> _pty,
     setMode(DECMode::TextReflow, true);
     setMode(DECMode::SixelCursorNextToGraphic, state_.sixelCursorConformance);
 #endif
+    state_.imagePool.setVisibleImages([this]() { return visibleImages(); });
 }
 
+Terminal::~Terminal() = default;
+
 void Terminal::setRefreshRate(double _refreshRate)
 {
-    refreshInterval_ = std::chrono::milliseconds(static_cast<long long>(1000.0 / _refreshRate));
+    frameScheduler_.setRefreshRate(_refreshRate);
 }
 
 void Terminal::setLastMarkRangeOffset(LineOffset _value) noexcept
@@ -140,10 +204,32 @@ void Terminal::setLastMarkRangeOffset(LineOffset _value) noexcept
 
 bool Terminal::processInputOnce()
 {
-    auto const timeout = renderBuffer_.state == RenderBufferState::WaitingForRefresh && !screenDirty_
-                             ? std::chrono::seconds(4)
-                             //: refreshInterval_ : std::chrono::seconds(0)
-                             : std::chrono::seconds(30);
+    // An idle terminal sleeps until the PTY has data or wakeupReader() is invoked,
+    // so that idle sessions cause no periodic wakeups at all.
+    if (synchronizedOutputStart_)
+        expireSynchronizedOutput(chrono::steady_clock::now());
+    if (alternateScreenLeft_)
+        expireAlternateScreen(chrono::steady_clock::now());
+
+    // A pending synchronized update must wake up the reader in time to end it implicitly.
+    auto const timeout = [&]() -> chrono::milliseconds {
+        if (synchronizedOutputStart_)
+            return chrono::ceil<chrono::milliseconds>(
+                max(*synchronizedOutputStart_ + synchronizedOutputTimeout_ - chrono::steady_clock::now(),
+                    chrono::steady_clock::duration::zero()));
+#if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
+        // A refresh deferred by the frame pacing is caught up by this thread once the frame interval passed.
+        if (renderBuffer_.state != RenderBufferState::WaitingForRefresh || screenDirty_)
+            return chrono::ceil<chrono::milliseconds>(frameScheduler_.frameInterval());
+#endif
+        // The render thread refreshes its buffer on its own, so nothing else needs a wakeup,
+        // except for releasing an unused alternate screen buffer.
+        if (alternateScreenLeft_)
+            return chrono::ceil<chrono::milliseconds>(
+                max(*alternateScreenLeft_ + alternateScreenReleaseTimeout_ - chrono::steady_clock::now(),
+                    chrono::steady_clock::duration::zero()));
+        return Pty::NoTimeout;
+    }();
 
     // Request a new Buffer Object if the current one cannot sufficiently
     // store a single text line.
@@ -155,10 +241,28 @@ bool Terminal::processInputOnce()
         currentPtyBuffer_ = ptyBufferPool_.allocateBufferObject();
     }
 
+    auto const readLimit = std::min(ptyReadBufferSize_, currentPtyBuffer_->bytesAvailable());
     auto const readResult = pty_->read(*currentPtyBuffer_, timeout, ptyReadBufferSize_);
+
+    if (sixelDecoder_.hasResults())
+    {
+        auto const _l = std::lock_guard { *this };
+        applyDecodedImages();
+    }
+
     if (!readResult)
     {
-        if (errno != EINTR && errno != EAGAIN)
+        if (errno == EINTR && inputBacklogged_)
+        {
+            flushInput();
+            errno = EINTR;
+        }
+        if (errno == ECHILD)
+        {
+            TerminalLog()("PTY child process exited. Closing PTY.");
+            pty_->close();
+        }
+        else if (errno != EINTR && errno != EAGAIN)
         {
             TerminalLog()("PTY read failed (timeout: {}). {}", timeout, strerror(errno));
             pty_->close();
@@ -175,15 +279,51 @@ bool Terminal::processInputOnce()
         return true;
     }
 
-    {
-        auto const _l = std::lock_guard { *this };
-        state_.parser.maxCharCount =
-            static_cast<size_t>(state_.pageSize.columns.value - state_.cursor.position.column.value);
-        state_.parser.parseFragment(buf);
-    }
+    CONTOUR_PERF_TRACE("Terminal::processInputOnce");
+
+    if (outputRecorder_)
+        outputRecorder_->output(buf, chrono::steady_clock::now());
+
+    statistics_.bytesParsed.fetch_add(buf.size(), std::memory_order_relaxed);
+
+    // The parser is resumable at any byte boundary, so the input is applied in bounded slices,
+    // giving the render thread and input handling a chance to acquire the lock in between.
+    if (parallelParsing_ && buf.size() >= ParallelParsingThreshold)
+        parseInParallel(buf);
+    else
+        for (auto pending = buf; !pending.empty();)
+        {
+            auto const slice = pending.substr(0, inputSliceSize_);
+            {
+                auto const _l = std::lock_guard { *this };
+                state_.parser.maxCharCount =
+                    static_cast<size_t>(state_.pageSize.columns.value - state_.cursor.position.column.value);
+                state_.parser.parseFragment(slice);
+                reconcilePredictedEcho(chrono::steady_clock::now());
+            }
+            pending.remove_prefix(slice.size());
+        }
+
+    if (inputBacklogged_)
+        flushInput();
+    else
+        flushReplies();
+
+    if (inputLatency_.enabled())
+        inputLatency_.outputParsed(chrono::steady_clock::now());
+
+    // A read filling the whole buffer means the application produces output faster than it is parsed.
+    frameScheduler_.outputParsed(chrono::steady_clock::now(), buf.size() >= readLimit);
+
+#if defined(CONTOUR_PERF_TRACING)
+    // Links the first output not yet presented to the render buffer refresh that picks it up.
+    if (auto expected = uint64_t { 0 };
+        perfTraceFlow_.compare_exchange_strong(expected, perfTraceFlowCounter_ + 1))
+        CONTOUR_PERF_TRACE_FLOW_BEGIN("PTY output to render buffer", ++perfTraceFlowCounter_);
+#endif
 
     if (!state_.modes.enabled(DECMode::BatchedRendering))
-        screenUpdated();
+        outputUpdated();
 
 #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
     ensureFreshRenderBuffer();
@@ -192,10 +332,103 @@ bool Terminal::processInputOnce()
     return true;
 }
 
+void Terminal::parseInParallel(string_view _input)
+{
+    // Validating and decoding does not depend on the terminal's state and is done concurrently,
+    // without holding the lock. Only committing the segments to the screen is serial.
+    auto const segments = preprocessInput(_input, inputSliceSize_, MaxParsingThreads);
+
+    for (InputSegment const& segment: segments)
+    {
+        auto const _l = std::lock_guard { *this };
+        state_.parser.maxCharCount =
+            static_cast<size_t>(state_.pageSize.columns.value - state_.cursor.position.column.value);
+
+        // Segments with escape sequences (or following an incomplete one) are parsed as usual.
+        if (!segment.plain || state_.parser.state() != parser::State::Ground
+            || state_.sequencer.decodingUtf8())
+            state_.parser.parseFragment(segment.bytes);
+        else
+            for (InputSegment::Run const& run: segment.runs)
+            {
+                if (run.decoded)
+                    state_.sequencer.print(u32string_view(segment.codepoints).substr(run.offset, run.length));
+                else
+                    state_.parser.parseFragment(segment.bytes.substr(run.offset, run.length));
+            }
+
+        reconcilePredictedEcho(chrono::steady_clock::now());
+    }
+}
+
+unique_ptr<ParserExtension> Terminal::hookTmuxControl()
+{
+    tmuxSession_ = make_unique<TmuxSession>(
+        [this](string_view _command) {
+            sendRaw(_command);
+            flushInput();
+        },
+        maxHistoryLineCount());
+
+    // tmux lays out its windows for the size of the client, which is sent once the session is started.
+    tmuxSession_->resize(state_.pageSize);
+    eventListener_.tmuxControlModeChanged(tmuxSession_.get());
+
+    return make_unique<TmuxControlExtension>(*tmuxSession_, [this]() {
+        eventListener_.tmuxControlModeChanged(nullptr);
+        tmuxSession_.reset();
+    });
+}
+
+void Terminal::setSequenceProfiling(bool _enabled)
+{
+    if (_enabled)
+        sequenceMetrics_ = std::make_unique<Metrics>();
+    else
+        sequenceMetrics_.reset();
+}
+
+void Terminal::applyDecodedImages()
+{
+    for (auto& result: sixelDecoder_.fetchResults())
+    {
+        auto const placeholder = result.placeholder.lock();
+        if (!placeholder)
+            continue; // The image has been erased or scrolled out meanwhile.
+
+        auto image = state_.imagePool.create(ImageFormat::RGBA, result.size, move(result.pixels));
+        auto const rasterizedImage = state_.imagePool.rasterize(move(image),
+                                                                placeholder->alignmentPolicy(),
+                                                                placeholder->resizePolicy(),
+                                                                placeholder->defaultColor(),
+                                                                placeholder->cellSpan(),
+                                                                placeholder->cellSize());
+        // The image is most likely on the screen that is still active.
+        if (isPrimaryScreen())
+        {
+            if (!primaryScreen_.replaceImageFragments(*placeholder, rasterizedImage))
+                alternateScreen_.replaceImageFragments(*placeholder, rasterizedImage);
+        }
+        else if (!alternateScreen_.replaceImageFragments(*placeholder, rasterizedImage))
+            primaryScreen_.replaceImageFragments(*placeholder, rasterizedImage);
+    }
+
+    screenUpdated();
+}
+
 // {{{ RenderBuffer synchronization
 void Terminal::breakLoopAndRefreshRenderBuffer()
 {
     changes_++;
+    viewChanged_ = true;
+
+    if (hidden_)
+    {
+        // Nothing gets rendered while hidden. Remember to refresh once shown again.
+        screenDirty_ = true;
+        return;
+    }
+
     renderBuffer_.state = RenderBufferState::RefreshBuffersAndTrySwap;
 
     // if (this_thread::get_id() == mainLoopThreadID_)
@@ -206,21 +439,32 @@ void Terminal::breakLoopAndRefreshRenderBuffer()
 
 bool Terminal::refreshRenderBuffer(bool _locked)
 {
+    CONTOUR_PERF_TRACE("Terminal::refreshRenderBuffer");
     renderBuffer_.state = RenderBufferState::RefreshBuffersAndTrySwap;
     ensureFreshRenderBuffer(_locked);
     return renderBuffer_.state == RenderBufferState::WaitingForRefresh;
 }
 
+void Terminal::setHidden(bool _hidden)
+{
+    if (hidden_.exchange(_hidden) == _hidden || _hidden)
+        return;
+
+    // Catch up with everything that happened while being hidden in a single refresh.
+    breakLoopAndRefreshRenderBuffer();
+    eventListener_.screenUpdated();
+}
+
 bool Terminal::ensureFreshRenderBuffer(bool _locked)
 {
-    if (!renderBufferUpdateEnabled_)
+    if (!renderBufferUpdateEnabled_ || hidden_)
     {
         // renderBuffer_.state = RenderBufferState::WaitingForRefresh;
         return false;
     }
 
     auto const elapsed = currentTime_ - renderBuffer_.lastUpdate;
-    auto const avoidRefresh = elapsed < refreshInterval_;
+    auto const avoidRefresh = elapsed < frameScheduler_.frameInterval();
 
     switch (renderBuffer_.state)
     {
@@ -230,17 +474,30 @@ bool Terminal::ensureFreshRenderBuffer(bool _locked)
             renderBuffer_.state = RenderBufferState::RefreshBuffersAndTrySwap;
             [[fallthrough]];
         case RenderBufferState::RefreshBuffersAndTrySwap:
+            if (renderedHistoryUnchanged(_locked))
+            {
+                // The output only moved along underneath the history lines being read.
+                statistics_.renderBufferSkips.fetch_add(1, std::memory_order_relaxed);
+                screenDirty_ = false;
+                renderBuffer_.state = RenderBufferState::WaitingForRefresh;
+                break;
+            }
             if (!_locked)
                 refreshRenderBuffer(renderBuffer_.backBuffer());
             else
                 refreshRenderBufferInternal(renderBuffer_.backBuffer());
+            statistics_.renderBufferRefreshes.fetch_add(1, std::memory_order_relaxed);
             renderBuffer_.state = RenderBufferState::TrySwapBuffers;
             [[fallthrough]];
         case RenderBufferState::TrySwapBuffers: {
-            [[maybe_unused]] auto const success = renderBuffer_.swapBuffers(currentTime_);
+            auto const success = renderBuffer_.swapBuffers(currentTime_);
+            if (success)
+                statistics_.renderBufferSwaps.fetch_add(1, std::memory_order_relaxed);
+            if (success && inputLatency_.enabled())
+                inputLatency_.frameSwapped(lastFrameID_, chrono::steady_clock::now());
 
 #if defined(CONTOUR_PERF_STATS)
-            logRenderBufferSwap(success, lastFrameID_);
+            logRenderBufferSwap(success, lastFrameID_, renderBuffer_.skippedFrames.load());
 #endif
 
 #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
@@ -254,34 +511,60 @@ bool Terminal::ensureFreshRenderBuffer(bool _locked)
     return true;
 }
 
-void Terminal::refreshRenderBuffer(RenderBuffer& _output)
-{
-    auto const _l = lock_guard { *this };
-    refreshRenderBufferInternal(_output);
-}
-
 PageSize Terminal::SelectionHelper::pageSize() const noexcept
 {
     return terminal->pageSize();
 }
 
-bool Terminal::SelectionHelper::wordDelimited(CellLocation _pos) const noexcept
+template <typename Cell>
+vector<bool> const& Terminal::SelectionHelper::wordDelimitersAt(Grid<Cell> const& _grid,
+                                                               LineOffset _line) const
 {
-    // Word selection may be off by one
-    _pos.column = min(_pos.column, boxed_cast<ColumnOffset>(terminal->pageSize().columns - 1));
+    auto const& line = _grid.scrollbackLineAt(_line);
+
+    // Lines are keyed by offset, which shifts as the screen scrolls, so the cache never outgrows
+    // a few pages' worth of lines.
+    if (wordDelimiterLines.size() > 4 * unbox<size_t>(_grid.pageSize().lines))
+        wordDelimiterLines.clear();
+
+    auto& entry = wordDelimiterLines[unbox<int>(_line)];
+    auto const columns = unbox<size_t>(_grid.pageSize().columns);
+    if (entry.generation == line.generation() && entry.delimited.size() == columns)
+        return entry.delimited;
+
+    auto const& delimiters = terminal->wordDelimiters_;
+    auto const isDelimiter = [&](char32_t _codepoint) {
+        return delimiters.find(_codepoint) != delimiters.npos;
+    };
 
-    if (terminal->isPrimaryScreen())
+    entry.generation = line.generation();
+    entry.delimited.assign(columns, true);
+    if (line.isTrivialBuffer()
+        && line.trivialBuffer().text.size() == unbox<size_t>(line.trivialBuffer().usedColumns))
     {
-        auto const& cell = terminal->primaryScreen().at(_pos);
-        return cell.empty()
-               || terminal->wordDelimiters_.find(cell.codepoint(0)) != terminal->wordDelimiters_.npos;
+        // Plain ASCII text can be classified without inflating the line.
+        auto const text = line.trivialBuffer().text.view();
+        for (size_t i = 0; i < min(columns, text.size()); ++i)
+            entry.delimited[i] = text[i] == 0x20 || isDelimiter(static_cast<uint8_t>(text[i]));
     }
     else
     {
-        auto const& cell = terminal->alternateScreen().at(_pos);
-        return cell.empty()
-               || terminal->wordDelimiters_.find(cell.codepoint(0)) != terminal->wordDelimiters_.npos;
+        auto const& cells = line.inflatedBuffer();
+        for (size_t i = 0; i < min(columns, cells.size()); ++i)
+            entry.delimited[i] = cells[i].empty() || isDelimiter(cells[i].codepoint(0));
     }
+    return entry.delimited;
+}
+
+bool Terminal::SelectionHelper::wordDelimited(CellLocation _pos) const noexcept
+{
+    // Word selection may be off by one
+    _pos.column = min(_pos.column, boxed_cast<ColumnOffset>(terminal->pageSize().columns - 1));
+
+    auto const& delimited = terminal->isPrimaryScreen()
+                                ? wordDelimitersAt(terminal->primaryScreen().grid(), _pos.line)
+                                : wordDelimitersAt(terminal->alternateScreen().grid(), _pos.line);
+    return delimited[unbox<size_t>(_pos.column)];
 }
 
 bool Terminal::SelectionHelper::wrappedLine(LineOffset _line) const noexcept
@@ -305,47 +588,224 @@ int Terminal::SelectionHelper::cellWidth(CellLocation _pos) const noexcept
     return terminal->currentScreen().cellWithAt(_pos);
 }
 
-/**
- * Sets the hyperlink into hovering state if mouse is currently hovering it
- * and unsets the state when the object is being destroyed.
- */
-struct ScopedHyperlinkHover
+namespace
 {
-    shared_ptr<HyperlinkInfo const> const href;
+    /// Minimum number of page cells for a frame to be split across multiple render threads.
+    constexpr auto ParallelRenderCellThreshold = 16384;
 
-    ScopedHyperlinkHover(Terminal const& terminal, ScreenBase const& /*screen*/):
-        href { terminal.tryGetHoveringHyperlink() }
-    {
-        if (href)
-            href->state = HyperlinkState::Hover; // TODO: Left-Ctrl pressed?
-    }
+    /// Minimum number of screen lines per slice, keeping thread handoff cheap in relation to work.
+    constexpr auto MinRenderSliceLines = 16;
 
-    ~ScopedHyperlinkHover()
+    constexpr auto MaxRenderSlices = 8;
+
+    /// Renders the page captured by @p _builder.
+    ///
+    /// Large pages are split into ranges of lines that are rendered concurrently (on the threads of
+    /// the shared worker pool) into slices of their own and then merged in page order, so the output
+    /// is identical to a sequential render.
+    void renderPage(RenderBufferBuilder<Cell>& _builder)
     {
-        if (href)
-            href->state = HyperlinkState::Inactive;
+        auto& workers = crispy::WorkerPool::shared();
+        auto const lineCount = unbox<int>(_builder.renderedLineCount());
+        auto const columnCount = unbox<int>(_builder.columnCount());
+        auto const sliceCount = min({ static_cast<int>(workers.threadCount()) + 1,
+                                      lineCount / MinRenderSliceLines,
+                                      MaxRenderSlices });
+
+        if (lineCount * columnCount < ParallelRenderCellThreshold || sliceCount < 2)
+        {
+            _builder.renderLines(LineOffset(0), LineOffset(lineCount));
+            _builder.finish();
+            return;
+        }
+
+        auto const sliceBegin = [=](int _slice) {
+            return LineOffset(lineCount * _slice / sliceCount);
+        };
+        auto const renderSlice = [&](RenderBufferSlice& _slice, int _index) {
+            auto const first = sliceBegin(_index);
+            auto const last = sliceBegin(_index + 1);
+            _slice.cells.reserve(unbox<size_t>(last - first) * static_cast<size_t>(columnCount));
+            auto sliceBuilder = RenderBufferBuilder<Cell> { _builder, _slice };
+            sliceBuilder.renderLines(first, last);
+        };
+
+        auto slices = vector<RenderBufferSlice>(static_cast<size_t>(sliceCount));
+        workers.parallelFor(slices.size(), [&](size_t i) { renderSlice(slices[i], static_cast<int>(i)); });
+
+        for (int i = 0; i < sliceCount; ++i)
+            _builder.appendSlice(move(slices[static_cast<size_t>(i)]), sliceBegin(i), sliceBegin(i + 1));
+        _builder.finish();
     }
-};
+} // namespace
+
+void Terminal::refreshRenderBuffer(RenderBuffer& _output)
+{
+    // Only capturing the frame requires the lock. Its lines are rendered while the parser moves on.
+    auto builder = [&]() {
+        auto const _l = lock_guard { *this };
+        return captureRenderBuffer(_output);
+    }();
+    renderPage(builder);
+
+    auto const _l = lock_guard { *this };
+    builder.releaseLines();
+}
 
 void Terminal::refreshRenderBufferInternal(RenderBuffer& _output)
+{
+    auto builder = captureRenderBuffer(_output);
+    renderPage(builder);
+    builder.releaseLines();
+}
+
+RenderBufferBuilder<Cell> Terminal::captureRenderBuffer(RenderBuffer& _output)
 {
     verifyState();
 
+#if defined(CONTOUR_PERF_TRACING)
+    if (auto const flow = perfTraceFlow_.exchange(0))
+        CONTOUR_PERF_TRACE_FLOW_END("PTY output to render buffer", flow);
+#endif
+
     changes_.store(0);
     screenDirty_ = false;
+    captureRenderedHistory();
+    reconcilePredictedEcho(currentTime_);
     ++lastFrameID_;
+    inputLatency_.frameBuilt(lastFrameID_);
 
 #if defined(CONTOUR_PERF_STATS)
     if (TerminalLog)
         TerminalLog()("{}: Refreshing render buffer.\n", lastFrameID_.load());
 #endif
 
-    auto const hoveringHyperlinkGuard = ScopedHyperlinkHover { *this, currentScreen_ };
+    capturePrefetchLines(_output);
 
     if (isPrimaryScreen())
-        primaryScreen_.render(RenderBufferBuilder<Cell> { *this, _output }, viewport_.scrollOffset());
+        return RenderBufferBuilder<Cell> { *this, primaryScreen_.grid(), _output };
     else
-        alternateScreen_.render(RenderBufferBuilder<Cell> { *this, _output }, viewport_.scrollOffset());
+        return RenderBufferBuilder<Cell> { *this, alternateScreen_.grid(), _output };
+}
+
+void Terminal::capturePrefetchLines(RenderBuffer& _output)
+{
+    // How far ahead of the viewport lines are prefetched, in terms of scrolling time.
+    auto constexpr Lookahead = 0.2; // seconds
+
+    _output.prefetchText.clear();
+    _output.prefetchRuns.clear();
+
+    auto const velocity = viewport_.scrollVelocity();
+    if (velocity == 0.0 || !isPrimaryScreen())
+        return;
+
+    auto const& grid = primaryScreen_.grid();
+    auto const pageLines = unbox<int>(pageSize().lines);
+    auto const count = std::clamp(static_cast<int>(std::abs(velocity) * Lookahead), 1, pageLines);
+    auto const top = -unbox<int>(viewport_.scrollOffset());
+    auto const bottom = top + pageLines + (viewport_.pixelOffset() ? 1 : 0); // first line below the view
+    auto const first = velocity > 0 ? std::max(top - count, -unbox<int>(grid.scrollbackLineCount())) : bottom;
+    auto const last = velocity > 0 ? top : std::min(bottom + count, pageLines);
+
+    auto const startRun = [&](CellFlags _flags) {
+        _output.prefetchRuns.emplace_back(PrefetchRun { _output.prefetchText.size(), 0, _flags });
+    };
+
+    for (auto line = first; line < last; ++line)
+    {
+        auto const& gridLine = grid.scrollbackLineAt(LineOffset(line));
+        if (gridLine.isTrivialBuffer())
+        {
+            // Only plain ASCII text is known to take one column per codepoint.
+            auto const& buffer = gridLine.trivialBuffer();
+            if (buffer.text.size() != unbox<size_t>(buffer.usedColumns))
+                continue;
+            startRun(buffer.attributes.styles);
+            for (char const ch: buffer.text.view())
+                _output.prefetchText.push_back(static_cast<char32_t>(static_cast<uint8_t>(ch)));
+            _output.prefetchRuns.back().textLength = buffer.text.size();
+            continue;
+        }
+
+        auto flags = optional<CellFlags> {};
+        for (auto const& cell: gridLine.inflatedBuffer())
+        {
+            if (flags != cell.styles())
+            {
+                flags = cell.styles();
+                startRun(*flags);
+            }
+            _output.prefetchText.push_back(cell.codepointCount() == 1 ? cell.codepoint(0) : U' ');
+            ++_output.prefetchRuns.back().textLength;
+        }
+    }
+}
+
+void Terminal::captureRenderedHistory()
+{
+    viewChanged_ = false;
+
+    // Only history lines can be shown unchanged while output is processed. The cursor is never among
+    // them, except for the vi mode's, which does not move along with the lines.
+    auto const lineCount = pageSize().lines + LineCount(viewport_.pixelOffset() ? 1 : 0);
+    if (!isPrimaryScreen() || inputHandler().mode() != ViMode::Insert
+        || unbox<int>(viewport_.scrollOffset()) < unbox<int>(lineCount))
+    {
+        renderedHistory_.reset();
+        return;
+    }
+
+    auto& history = renderedHistory_.emplace();
+    auto const top = -boxed_cast<LineOffset>(viewport_.scrollOffset());
+    history.lineGenerations.reserve(unbox<size_t>(lineCount));
+    for (auto line = top; line < top + boxed_cast<LineOffset>(lineCount); ++line)
+        history.lineGenerations.push_back(primaryScreen_.grid().scrollbackLineAt(line).generation());
+    history.pageSize = pageSize();
+    history.pixelOffset = viewport_.pixelOffset();
+    history.reverseVideo = isModeEnabled(DECMode::ReverseVideo);
+    history.hoveringHyperlink = hoveringHyperlinkId();
+    history.colorPalette = state_.colorPalette;
+}
+
+bool Terminal::renderedHistoryUnchanged(bool _locked) const
+{
+    // The latest render buffer still shows what the viewport shows if it shows history lines only,
+    // the viewport followed these since, and the output processed meanwhile left them alone.
+    auto const test = [&]() {
+        if (!renderedHistory_ || viewChanged_ || !isPrimaryScreen()
+            || inputHandler().mode() != ViMode::Insert)
+            return false;
+
+        auto const& history = *renderedHistory_;
+        auto const lineCount = history.lineGenerations.size();
+        if (unbox<size_t>(viewport_.scrollOffset()) < lineCount || history.pageSize != pageSize()
+            || history.pixelOffset != viewport_.pixelOffset()
+            || history.reverseVideo != isModeEnabled(DECMode::ReverseVideo)
+            || history.hoveringHyperlink != hoveringHyperlinkId()
+            || !(history.colorPalette == state_.colorPalette))
+            return false;
+
+        auto const top = -boxed_cast<LineOffset>(viewport_.scrollOffset());
+        for (size_t i = 0; i < lineCount; ++i)
+            if (primaryScreen_.grid().scrollbackLineAt(top + LineOffset::cast_from(i)).generation()
+                != history.lineGenerations[i])
+                return false;
+        return true;
+    };
+
+    if (_locked)
+        return test();
+
+    auto const _l = std::lock_guard { *this };
+    return test();
+}
+
+HyperlinkId Terminal::hoveringHyperlinkId() const noexcept
+{
+    if (auto const gridPosition = currentMouseGridPosition())
+        return currentScreen().hyperlinkIdAt(*gridPosition);
+    return {};
 }
 // }}}
 
@@ -354,6 +814,10 @@ bool Terminal::sendKeyPressEvent(Key _key, Modifier _modifier, Timestamp _now)
     cursorBlinkState_ = 1;
     lastCursorBlink_ = _now;
 
+    // Keys other than characters do not pick hints, but must not reach the application either.
+    if (auto const _l = lock_guard { *this }; hintMode_)
+        return true;
+
     if (state_.inputHandler.sendKeyPressEvent(_key, _modifier))
         return true;
 
@@ -362,9 +826,18 @@ bool Terminal::sendKeyPressEvent(Key _key, Modifier _modifier, Timestamp _now)
         return true;
 
     viewport_.scrollToBottom();
+    inputLatency_.keyPressed(_now);
     bool const success = state_.inputGenerator.generate(_key, _modifier);
     flushInput();
     viewport_.scrollToBottom();
+
+    // The echo of keys such as Enter or cursor movement cannot be predicted.
+    if (predictiveEcho_.enabled())
+    {
+        auto const _l = lock_guard { *this };
+        predictiveEcho_.newEpoch();
+    }
+
     return success;
 }
 
@@ -373,6 +846,9 @@ bool Terminal::sendCharPressEvent(char32_t _value, Modifier _modifier, Timestamp
     cursorBlinkState_ = 1;
     lastCursorBlink_ = _now;
 
+    if (sendHintModeInput(_value))
+        return true;
+
     if (state_.inputHandler.sendCharPressEvent(_value, _modifier))
         return true;
 
@@ -380,34 +856,89 @@ bool Terminal::sendCharPressEvent(char32_t _value, Modifier _modifier, Timestamp
     if (isModeEnabled(AnsiMode::KeyboardAction))
         return true;
 
+    inputLatency_.keyPressed(_now);
     auto const success = state_.inputGenerator.generate(_value, _modifier);
 
     flushInput();
     viewport_.scrollToBottom();
+
+    if (predictiveEcho_.enabled() && predictEcho(_value, _modifier, _now))
+        screenUpdated();
+
     return success;
 }
 
+bool Terminal::predictEcho(char32_t _value, Modifier _modifier, Timestamp _now)
+{
+    auto const _l = lock_guard { *this };
+
+    if (pty_->echoDisabled() || !isPrimaryScreen())
+    {
+        predictiveEcho_.reset();
+        return false;
+    }
+
+    // Only plain text typed at the end of the line is predicted, as the application may
+    // insert or overwrite characters anywhere else.
+    auto const cursor = realCursorPosition();
+    auto const predictable =
+        _modifier.without(Modifier::Shift).none() && _value >= 0x20 && _value != 0x7F
+        && unicode::width(_value) == 1
+        && primaryScreen_.grid().lineAt(cursor.line).usedColumns() <= boxed_cast<ColumnCount>(cursor.column);
+    if (!predictable)
+    {
+        predictiveEcho_.newEpoch();
+        return false;
+    }
+
+    return predictiveEcho_.predict(_value, cursor, pageSize().columns, _now)
+           && predictiveEcho_.visible(predictiveEcho_.predictions().back());
+}
+
+void Terminal::reconcilePredictedEcho(Timestamp _now)
+{
+    if (predictiveEcho_.predictions().empty())
+        return;
+
+    if (!isPrimaryScreen())
+    {
+        predictiveEcho_.reset();
+        return;
+    }
+
+    auto const& grid = primaryScreen_.grid();
+    predictiveEcho_.reconcile(
+        [&](CellLocation _pos) -> char32_t {
+            if (_pos.line >= boxed_cast<LineOffset>(grid.pageSize().lines)
+                || _pos.column >= boxed_cast<ColumnOffset>(grid.pageSize().columns))
+                return 0;
+            return grid.at(_pos.line, _pos.column).codepoint(0);
+        },
+        _now);
+}
+
 bool Terminal::sendMousePressEvent(Modifier _modifier,
                                    MouseButton _button,
                                    PixelCoordinate _pixelPosition,
-                                   Timestamp /*_now*/)
+                                   Timestamp _now)
 {
     verifyState();
 
     respectMouseProtocol_ =
         mouseProtocolBypassModifier_ == Modifier::None || !_modifier.contains(mouseProtocolBypassModifier_);
 
-    if (respectMouseProtocol_
-        && state_.inputGenerator.generateMousePress(
-            _modifier, _button, currentMousePosition_, _pixelPosition))
-    {
-        // TODO: Ctrl+(Left)Click's should still be catched by the terminal iff there's a hyperlink
-        // under the current position
-        flushInput();
-        return true;
-    }
+    if (!respectMouseProtocol_)
+        return false;
 
-    return false;
+    auto const _l = std::lock_guard { inputLock_ };
+    if (!state_.inputGenerator.generateMousePress(
+            _modifier, _button, currentMousePosition_, _pixelPosition, _now))
+        return false;
+
+    // TODO: Ctrl+(Left)Click's should still be catched by the terminal iff there's a hyperlink
+    // under the current position
+    writeInput();
+    return true;
 }
 
 bool Terminal::handleMouseSelection(Modifier _modifier, Timestamp _now)
@@ -458,7 +989,7 @@ void Terminal::clearSelection()
 bool Terminal::sendMouseMoveEvent(Modifier _modifier,
                                   CellLocation newPosition,
                                   PixelCoordinate _pixelPosition,
-                                  Timestamp /*_now*/)
+                                  Timestamp _now)
 {
     speedClicks_ = 0;
 
@@ -475,11 +1006,15 @@ bool Terminal::sendMouseMoveEvent(Modifier _modifier,
     bool changed = updateCursorHoveringState();
 
     // Do not handle mouse-move events in sub-cell dimensions.
-    if (respectMouseProtocol_
-        && state_.inputGenerator.generateMouseMove(_modifier, currentMousePosition_, _pixelPosition))
+    if (respectMouseProtocol_)
     {
-        flushInput();
-        return true;
+        // Coalesced motion is reported from tick() on the render thread, hence the lock.
+        auto const _l = std::lock_guard { inputLock_ };
+        if (state_.inputGenerator.generateMouseMove(_modifier, currentMousePosition_, _pixelPosition, _now))
+        {
+            writeInput();
+            return true;
+        }
     }
 
     if (leftMouseButtonPressed_ && !selectionAvailable())
@@ -509,12 +1044,15 @@ bool Terminal::sendMouseReleaseEvent(Modifier _modifier,
 {
     verifyState();
 
-    if (respectMouseProtocol_
-        && state_.inputGenerator.generateMouseRelease(
-            _modifier, _button, currentMousePosition_, _pixelPosition))
+    if (respectMouseProtocol_)
     {
-        flushInput();
-        return true;
+        auto const _l = std::lock_guard { inputLock_ };
+        if (state_.inputGenerator.generateMouseRelease(
+                _modifier, _button, currentMousePosition_, _pixelPosition))
+        {
+            writeInput();
+            return true;
+        }
     }
     respectMouseProtocol_ = true;
 
@@ -541,6 +1079,8 @@ bool Terminal::sendMouseReleaseEvent(Modifier _modifier,
 bool Terminal::sendFocusInEvent()
 {
     state_.focused = true;
+    cursorBlinkState_ = 1;
+    lastCursorBlink_ = currentTime_;
     breakLoopAndRefreshRenderBuffer();
 
     if (state_.inputGenerator.generateFocusInEvent())
@@ -579,7 +1119,8 @@ void Terminal::sendRaw(string_view _text)
 
 bool Terminal::hasInput() const noexcept
 {
-    return !state_.inputGenerator.peek().empty();
+    auto const _l = std::lock_guard { inputLock_ };
+    return !state_.inputGenerator.peek().empty() || !pendingReplies_.empty();
 }
 
 size_t Terminal::pendingInputBytes() const noexcept
@@ -589,14 +1130,44 @@ size_t Terminal::pendingInputBytes() const noexcept
 
 void Terminal::flushInput()
 {
+    auto const _l = std::lock_guard { inputLock_ };
+    writeInput();
+}
+
+void Terminal::writeInput()
+{
+    if (!state_.inputGenerator.peek().empty())
+    {
+        auto const input = state_.inputGenerator.peek();
+        auto const rv = pty_->write(input.data(), input.size());
+        if (rv > 0)
+            state_.inputGenerator.consume(rv);
+
+        if (inputLatency_.enabled() && state_.inputGenerator.peek().empty())
+            inputLatency_.inputWritten(chrono::steady_clock::now());
+    }
+
     if (state_.inputGenerator.peek().empty())
+        writePendingReplies();
+    inputBacklogged_ = !state_.inputGenerator.peek().empty() || !pendingReplies_.empty();
+}
+
+void Terminal::flushReplies()
+{
+    auto const _l = std::lock_guard { inputLock_ };
+    if (state_.inputGenerator.peek().empty())
+        writePendingReplies();
+    inputBacklogged_ = !state_.inputGenerator.peek().empty() || !pendingReplies_.empty();
+}
+
+void Terminal::writePendingReplies()
+{
+    if (pendingReplies_.empty())
         return;
 
-    // XXX Should be the only location that does write to the PTY's stdin to avoid race conditions.
-    auto const input = state_.inputGenerator.peek();
-    auto const rv = pty_->write(input.data(), input.size());
+    auto const rv = pty_->write(pendingReplies_.data(), pendingReplies_.size());
     if (rv > 0)
-        state_.inputGenerator.consume(rv);
+        pendingReplies_.erase(0, static_cast<size_t>(rv));
 }
 
 void Terminal::writeToScreen(string_view _data)
@@ -614,15 +1185,58 @@ void Terminal::writeToScreen(string_view _data)
         }
     }
 
+    flushReplies();
+
     if (!state_.modes.enabled(DECMode::BatchedRendering))
     {
-        screenUpdated();
+        outputUpdated();
+    }
+}
+
+void Terminal::ingest(string_view _data)
+{
+    statistics_.bytesParsed.fetch_add(_data.size(), std::memory_order_relaxed);
+
+    // Lines refer to their text within the PTY buffer objects, so the data is copied into these.
+    while (!_data.empty())
+    {
+        if (currentPtyBuffer_->bytesAvailable() < 64 && currentPtyBuffer_->bytesAvailable() < _data.size())
+            currentPtyBuffer_ = ptyBufferPool_.allocateBufferObject();
+        auto const chunk = _data.substr(0, std::min(_data.size(), currentPtyBuffer_->bytesAvailable()));
+        _data.remove_prefix(chunk.size());
+        state_.parser.maxCharCount =
+            static_cast<size_t>(state_.pageSize.columns.value - state_.cursor.position.column.value);
+        state_.parser.parseFragment(currentPtyBuffer_->writeAtEnd(chunk));
     }
+
+    pendingReplies_.clear();
+}
+
+crispy::BufferFragment Terminal::appendLineText(crispy::BufferFragment const& _text, string_view _tail)
+{
+    if (lineTextBuffer_ && _text.owner() == lineTextBuffer_ && _text.view().end() == lineTextBuffer_->hotEnd()
+        && lineTextBuffer_->bytesAvailable() >= _tail.size())
+    {
+        // The text is the most recently stored one, so it can be extended in-place.
+        lineTextBuffer_->advance(lineTextBuffer_->writeAtEnd(_tail).size());
+        auto text = _text;
+        text.growBy(_tail.size());
+        return text;
+    }
+
+    auto const head = _text.view();
+    if (!lineTextBuffer_ || lineTextBuffer_->bytesAvailable() < head.size() + _tail.size())
+        lineTextBuffer_ = ptyBufferPool_.allocateBufferObject();
+
+    auto const start = lineTextBuffer_->hotEnd();
+    lineTextBuffer_->advance(lineTextBuffer_->writeAtEnd(head).size());
+    lineTextBuffer_->advance(lineTextBuffer_->writeAtEnd(_tail).size());
+    return crispy::BufferFragment { lineTextBuffer_, string_view(start, head.size() + _tail.size()) };
 }
 
 void Terminal::updateCursorVisibilityState() const
 {
-    if (cursorDisplay_ == CursorDisplay::Steady)
+    if (cursorDisplay_ == CursorDisplay::Steady || !state_.focused)
         return;
 
     auto const passed = chrono::duration_cast<chrono::milliseconds>(currentTime_ - lastCursorBlink_);
@@ -652,17 +1266,47 @@ bool Terminal::updateCursorHoveringState()
 
 optional<chrono::milliseconds> Terminal::nextRender() const
 {
-    if (!state_.cursor.visible)
-        return nullopt;
+    auto const earliest = [](optional<chrono::milliseconds> a, optional<chrono::milliseconds> b) {
+        return a && b ? optional { min(*a, *b) } : a ? a : b;
+    };
 
-    if (cursorDisplay_ != CursorDisplay::Blink)
+    // Coalesced mouse events as well as throttled window title and notification updates are reported
+    // from within tick(), so the next frame must not be later.
+    auto throttledEvents = optional<chrono::milliseconds> {};
+    if (throttledEventsPending_)
+        throttledEvents = chrono::ceil<chrono::milliseconds>(frameScheduler_.frameInterval());
+    auto const nextMouseReport = [&]() {
+        auto const _l = std::lock_guard { inputLock_ };
+        return state_.inputGenerator.nextMouseReport(currentTime_);
+    }();
+    auto const tickTimeout = earliest(nextMouseReport, throttledEvents);
+
+    // Predictions whose echo did not show up in time are rolled back on the next render buffer refresh.
+    auto const predictionTimeout = [&]() -> optional<chrono::milliseconds> {
+        if (!predictiveEcho_.enabled())
+            return nullopt;
+        auto const _l = lock_guard { *this };
+        if (auto const timeout = predictiveEcho_.nextTimeout(currentTime_))
+            return chrono::ceil<chrono::milliseconds>(*timeout);
         return nullopt;
+    }();
+
+    // The inactive cursor does not blink, so that an unfocused window does not wake up periodically.
+    if (!state_.cursor.visible || cursorDisplay_ != CursorDisplay::Blink || !state_.focused)
+        return earliest(tickTimeout, predictionTimeout);
 
     auto const passed = chrono::duration_cast<chrono::milliseconds>(currentTime_ - lastCursorBlink_);
-    if (passed <= cursorBlinkInterval_)
-        return cursorBlinkInterval_ - passed;
-    else
-        return chrono::milliseconds::min();
+    auto const cursorBlink =
+        passed <= cursorBlinkInterval_ ? cursorBlinkInterval_ - passed : chrono::milliseconds::min();
+    return earliest(tickTimeout ? min(*tickTimeout, cursorBlink) : cursorBlink, predictionTimeout);
+}
+
+void Terminal::flushCoalescedInput(Timestamp _now)
+{
+    // Called on the render thread, while mouse events are generated on the GUI thread.
+    auto const _l = std::lock_guard { inputLock_ };
+    if (state_.inputGenerator.tick(_now))
+        writeInput();
 }
 
 void Terminal::resizeScreen(PageSize _cells, optional<ImageSize> _pixels)
@@ -685,6 +1329,12 @@ void Terminal::resizeScreen(PageSize _cells, optional<ImageSize> _pixels)
 
     pty_->resizeScreen(_cells, _pixels);
 
+    if (outputRecorder_)
+        outputRecorder_->resize(_cells, chrono::steady_clock::now());
+
+    if (tmuxSession_)
+        tmuxSession_->resize(_cells);
+
     verifyState();
 }
 
@@ -759,38 +1409,109 @@ void Terminal::setCursorShape(CursorShape _shape)
 void Terminal::setWordDelimiters(string const& _wordDelimiters)
 {
     wordDelimiters_ = unicode::from_utf8(_wordDelimiters);
+    selectionHelper_.invalidateWordDelimiters();
 }
 
 string Terminal::extractSelectionText() const
 {
-    using namespace terminal;
-    ColumnOffset lastColumn = {};
-    string text;
-    string currentLine;
+    auto text = string {};
+    extractSelectionText([&](string_view _chunk) { text += _chunk; });
+    return text;
+}
 
+Terminal::SelectionSnapshot Terminal::snapshotSelection() const
+{
     auto const _lock = scoped_lock { *this };
+    auto snapshot = SelectionSnapshot {};
+    snapshot.screenType = state_.screenType;
+    snapshot.pageSize = pageSize();
+    snapshot.scrolledLines = scrolledLines_;
+    if (!selection_)
+        return snapshot;
+
+    auto const& selection = *selection_;
     auto const rightPage = pageSize().columns.as<ColumnOffset>() - 1;
-    renderSelection([&](CellLocation const& _pos, Cell const& _cell) {
-        auto const isNewLine = _pos.column < lastColumn || (_pos.column == lastColumn && !text.empty());
-        bool const touchesRightPage = isSelected({ _pos.line, rightPage });
-        if (isNewLine && (!isLineWrapped(_pos.line) || !touchesRightPage))
+    snapshot.lines.reserve(unbox<size_t>(selection.lastLine() - selection.firstLine()) + 1);
+    for (auto line = selection.firstLine(); line <= selection.lastLine(); ++line)
+        snapshot.lines.push_back({ selection.rangeAt(line), isSelected({ line, rightPage }) });
+    snapshot.fullLines = dynamic_cast<FullLineSelection const*>(&selection) != nullptr;
+    return snapshot;
+}
+
+void Terminal::extractSelectionText(function<void(string_view)> const& _sink, size_t _chunkSize) const
+{
+    extractSelectionText(snapshotSelection(), _sink, _chunkSize);
+}
+
+void Terminal::extractSelectionText(SelectionSnapshot const& _snapshot,
+                                    function<void(string_view)> const& _sink,
+                                    size_t _chunkSize) const
+{
+    // Number of lines to extract before giving others a chance to take the lock.
+    constexpr size_t BatchSize = 1024;
+
+    auto chunk = string {};
+    chunk.reserve(_chunkSize + unbox<size_t>(_snapshot.pageSize.columns));
+
+    // The sink may block (e.g. on a pipe), so the chunks completed while holding the lock
+    // are passed on only after releasing it.
+    auto completed = vector<string> {};
+
+    // Trailing spaces are held back, as they are to be trimmed should the logical line end right there.
+    auto const flush = [&]() {
+        auto const end = chunk.find_last_not_of(' ');
+        if (end == string::npos)
+            return;
+        completed.emplace_back(chunk, 0, end + 1);
+        chunk.erase(0, end + 1);
+    };
+
+    auto const extract = [&](auto const& _screen, size_t _begin, size_t _end) {
+        auto const& grid = _screen.grid();
+        auto const scrolled = LineOffset::cast_from(scrolledLines_ - _snapshot.scrolledLines);
+        auto const top = -boxed_cast<LineOffset>(grid.scrollbackLineCount());
+        auto const bottom = boxed_cast<LineOffset>(_snapshot.pageSize.lines) - 1;
+        for (auto i = _begin; i < _end; ++i)
         {
-            // TODO: handle logical line in word-selection (don't include LF in wrapped lines)
-            trimSpaceRight(currentLine);
-            text += currentLine;
-            text += '\n';
-            currentLine.clear();
+            auto range = _snapshot.lines[i].range;
+            range.line -= scrolled;
+            if (range.line < top || range.line > bottom)
+                continue;
+
+            if (i != 0 && (!isLineWrapped(range.line) || !_snapshot.lines[i].touchesRightPage))
+            {
+                // TODO: handle logical line in word-selection (don't include LF in wrapped lines)
+                trimSpaceRight(chunk);
+                chunk += '\n';
+                if (chunk.size() >= _chunkSize)
+                    flush();
+            }
+            appendSelectedText(chunk, grid.scrollbackLineAt(range.line), range);
         }
-        currentLine += _cell.toUtf8();
-        lastColumn = _pos.column;
-    });
+    };
 
-    trimSpaceRight(currentLine);
-    text += currentLine;
+    for (size_t begin = 0; begin < _snapshot.lines.size(); begin += BatchSize)
+    {
+        auto const end = min(begin + BatchSize, _snapshot.lines.size());
+        {
+            auto const _lock = scoped_lock { *this };
+            if (state_.screenType != _snapshot.screenType || pageSize() != _snapshot.pageSize)
+                break;
+            if (isPrimaryScreen())
+                extract(primaryScreen_, begin, end);
+            else
+                extract(alternateScreen_, begin, end);
+        }
+        for (auto const& text: completed)
+            _sink(text);
+        completed.clear();
+    }
 
-    if (dynamic_cast<FullLineSelection const*>(selector()))
-        text += '\n';
-    return text;
+    trimSpaceRight(chunk);
+    if (_snapshot.fullLines)
+        chunk += '\n';
+    if (!chunk.empty())
+        _sink(chunk);
 }
 
 string Terminal::extractLastMarkRange() const
@@ -822,6 +1543,178 @@ string Terminal::extractLastMarkRange() const
     return text;
 }
 
+string Terminal::extractText(CellLocation _from, CellLocation _to) const
+{
+    auto const _l = std::lock_guard { *this };
+
+    auto const extract = [&](auto const& _grid) {
+        string text;
+        for (auto line = _from.line; line <= _to.line; ++line)
+        {
+            auto const cells = _grid.scrollbackLineAt(line).cells();
+            auto const first = line == _from.line ? unbox<size_t>(_from.column) : 0;
+            auto const last = line == _to.line ? unbox<size_t>(_to.column) + 1 : cells.size();
+            for (auto i = first; i < min(last, cells.size()); ++i)
+                text += cells[i].codepointCount() != 0 ? cells[i].toUtf8() : " ";
+        }
+        return text;
+    };
+
+    return isPrimaryScreen() ? extract(primaryScreen_.grid()) : extract(alternateScreen_.grid());
+}
+
+// {{{ search
+void Terminal::setSearchPattern(optional<SearchPattern> _pattern)
+{
+    if (_pattern && !_pattern->text.empty())
+        searchMatcher_.emplace(move(*_pattern));
+    else
+        searchMatcher_.reset();
+}
+
+void Terminal::setSearchIndexEnabled(bool _enabled)
+{
+    if (!_enabled)
+        searchIndex_.reset();
+    else if (!searchIndex_)
+        searchIndex_ = make_unique<TrigramIndex>();
+}
+
+TrigramIndex* Terminal::searchIndex() noexcept
+{
+    if (!searchIndex_)
+        return nullptr;
+
+    // Lines that changed or left the history are never looked up again, so start over
+    // once they make up most of the index.
+    auto const historyLines = unbox<size_t>(primaryScreen_.historyLineCount())
+                              + unbox<size_t>(alternateScreen_.historyLineCount());
+    if (searchIndex_->size() > 2 * historyLines + 1024)
+        searchIndex_->clear();
+
+    return searchIndex_.get();
+}
+
+optional<SearchMatch> Terminal::searchNext(CellLocation _from, SearchDirection _direction)
+{
+    if (!searchMatcher_)
+        return nullopt;
+
+    auto const _l = std::lock_guard { *this };
+    if (isPrimaryScreen())
+        return terminal::search(primaryScreen_.grid(), *searchMatcher_, _from, _direction, searchIndex());
+    else
+        return terminal::search(alternateScreen_.grid(), *searchMatcher_, _from, _direction, searchIndex());
+}
+
+vector<SearchMatch> Terminal::searchMatches(LineOffset _first, LineOffset _last)
+{
+    auto matches = vector<SearchMatch> {};
+    if (!searchMatcher_)
+        return matches;
+
+    auto const collect = [&](SearchMatch const& _match) {
+        matches.push_back(_match);
+        return true;
+    };
+
+    auto const _l = std::lock_guard { *this };
+    if (isPrimaryScreen())
+        forEachMatch(primaryScreen_.grid(), *searchMatcher_, _first, _last, searchIndex(), collect);
+    else
+        forEachMatch(alternateScreen_.grid(), *searchMatcher_, _first, _last, searchIndex(), collect);
+    return matches;
+}
+// }}}
+
+vector<Hint> Terminal::hints(LineOffset _first, LineOffset _last)
+{
+    auto const _l = std::lock_guard { *this };
+    if (!hintMatcher_)
+        hintMatcher_ = make_unique<HintMatcher>();
+
+    // Lines that changed or left the screen are never looked up again, so drop them
+    // once they make up most of the cache.
+    if (hintCache_.size() > 2 * unbox<size_t>(pageSize().lines) + 1024)
+        hintCache_.sweep();
+
+    if (isPrimaryScreen())
+        return collectHints(primaryScreen_.grid(), *hintMatcher_, _first, _last, hintCache_);
+    else
+        return collectHints(alternateScreen_.grid(), *hintMatcher_, _first, _last, hintCache_);
+}
+
+bool Terminal::startHintMode()
+{
+    auto const top = -boxed_cast<LineOffset>(viewport_.scrollOffset());
+    auto found = hints(top, top + boxed_cast<LineOffset>(pageSize().lines) - 1);
+    if (found.empty())
+        return false;
+
+    {
+        auto const _l = std::lock_guard { *this };
+        auto labels = hintLabels(found.size());
+        hintMode_ = HintMode { std::move(found), std::move(labels), {} };
+    }
+    breakLoopAndRefreshRenderBuffer();
+    eventListener_.screenUpdated();
+    return true;
+}
+
+void Terminal::stopHintMode()
+{
+    {
+        auto const _l = std::lock_guard { *this };
+        if (!hintMode_)
+            return;
+        hintMode_.reset();
+    }
+    breakLoopAndRefreshRenderBuffer();
+    eventListener_.screenUpdated();
+}
+
+bool Terminal::sendHintModeInput(char32_t _value)
+{
+    auto picked = optional<Hint> {};
+    {
+        auto const _l = std::lock_guard { *this };
+        if (!hintMode_)
+            return false;
+
+        auto& typed = hintMode_->typed;
+        auto const& labels = hintMode_->labels;
+        if (_value == 0x1B)
+            hintMode_.reset();
+        else if (_value == 0x08 || _value == 0x7F)
+        {
+            if (!typed.empty())
+                typed.pop_back();
+        }
+        else if (_value < 0x80)
+        {
+            // Characters that no label continues with are ignored rather than cancelling hint mode.
+            auto const candidate = typed + static_cast<char>(_value);
+            auto const label = std::find_if(labels.begin(), labels.end(), [&](string const& _label) {
+                return string_view(_label).substr(0, candidate.size()) == candidate;
+            });
+            if (label == labels.end())
+                return true;
+            typed = candidate;
+            if (*label == typed)
+            {
+                picked = std::move(hintMode_->hints.at(static_cast<size_t>(label - labels.begin())));
+                hintMode_.reset();
+            }
+        }
+    }
+    breakLoopAndRefreshRenderBuffer();
+    eventListener_.screenUpdated();
+
+    if (picked)
+        eventListener_.hintPicked(*picked);
+    return true;
+}
+
 // {{{ ScreenEvents overrides
 void Terminal::requestCaptureBuffer(LineCount lines, bool logical)
 {
@@ -836,6 +1729,7 @@ void Terminal::bell()
 void Terminal::bufferChanged(ScreenType _type)
 {
     selection_.reset();
+    hintMode_.reset();
     viewport_.forceScrollToBottom();
     eventListener_.bufferChanged(_type);
 }
@@ -848,17 +1742,31 @@ void Terminal::scrollbackBufferCleared()
 }
 
 void Terminal::screenUpdated()
+{
+    viewChanged_ = true;
+    outputUpdated();
+}
+
+void Terminal::outputUpdated()
 {
     if (!renderBufferUpdateEnabled_)
         return;
 
+    if (hidden_)
+    {
+        screenDirty_ = true;
+        return;
+    }
+
     if (renderBuffer_.state == RenderBufferState::TrySwapBuffers)
     {
-        renderBuffer_.swapBuffers(renderBuffer_.lastUpdate);
+        if (renderBuffer_.swapBuffers(renderBuffer_.lastUpdate) && inputLatency_.enabled())
+            inputLatency_.frameSwapped(lastFrameID_, chrono::steady_clock::now());
         return;
     }
 
     screenDirty_ = true;
+    frameScheduler_.contentChanged(chrono::steady_clock::now());
     eventListener_.screenUpdated();
 }
 
@@ -882,18 +1790,110 @@ void Terminal::inspect()
     eventListener_.inspect();
 }
 
+void Terminal::inspectMemoryUsage(std::ostream& _os) const
+{
+    auto const _l = std::lock_guard { *this };
+
+    auto const gridUsage = [&](string_view _name, GridMemoryUsage const& _usage) {
+        _os << fmt::format("{:<21}: {} lines ({} trivial, {} inflated), {} cells, {} cell extras\n",
+                           _name,
+                           _usage.lines,
+                           _usage.trivialLines,
+                           _usage.inflatedLines,
+                           _usage.cells,
+                           _usage.cellExtras);
+        _os << fmt::format("{:<21}: {} (trivial line text: {}, held by PTY buffer objects)\n",
+                           "",
+                           crispy::humanReadableBytes(_usage.bytes),
+                           crispy::humanReadableBytes(_usage.textBytes));
+        _os << fmt::format("{:<21}: {} reserved by the cell slab pool\n",
+                           "",
+                           crispy::humanReadableBytes(_usage.cellPoolBytes));
+    };
+
+    auto const primary = primaryScreen_.grid().memoryUsage();
+    auto const alternate = alternateScreen_.grid().memoryUsage();
+    auto const& poolStats = ptyBufferPool_.stats();
+    auto const ptyBufferBytes =
+        (poolStats.live + ptyBufferPool_.unusedBuffers()) * ptyBufferPool_.bufferSize();
+    auto const imageBytes = state_.imagePool.residentBytes();
+    auto const hyperlinkBytes = state_.hyperlinks.memoryUsage();
+
+    _os << fmt::format("Terminal memory usage\n");
+    _os << fmt::format("------------------------\n");
+    gridUsage("primary grid", primary);
+    gridUsage("alternate grid", alternate);
+    _os << fmt::format("{:<21}: {} ({} live, {} unused, {} each)\n",
+                       "PTY buffer objects",
+                       crispy::humanReadableBytes(ptyBufferBytes),
+                       poolStats.live,
+                       ptyBufferPool_.unusedBuffers(),
+                       crispy::humanReadableBytes(ptyBufferPool_.bufferSize()));
+    _os << fmt::format("{:<21}: {} (limit {})\n",
+                       "images",
+                       crispy::humanReadableBytes(imageBytes),
+                       state_.imagePool.memoryLimit()
+                           ? crispy::humanReadableBytes(state_.imagePool.memoryLimit())
+                           : "none"s);
+    _os << fmt::format("{:<21}: {} ({} hyperlinks)\n",
+                       "hyperlinks",
+                       crispy::humanReadableBytes(hyperlinkBytes),
+                       state_.hyperlinks.size());
+    auto const totalBytes = primary.bytes + alternate.bytes + ptyBufferBytes + imageBytes + hyperlinkBytes;
+    _os << fmt::format("{:<21}: {}\n", "total", crispy::humanReadableBytes(totalBytes));
+    _os << '\n';
+}
+
+void Terminal::inspectLocks(std::ostream& _os) const
+{
+    _os << fmt::format("Terminal lock contention\n");
+    _os << fmt::format("------------------------\n");
+    outerLock_.inspect("terminal lock", _os);
+    renderBuffer_.readerLock.inspect("render buffer reader", _os);
+    _os << '\n';
+}
+
 void Terminal::notify(string_view _title, string_view _body)
 {
-    eventListener_.notify(_title, _body);
+    pendingNotification_ = { string(_title), string(_body) };
+    throttledEventsPending_ = true;
+    flushThrottledEvents(currentTime_);
+}
+
+void Terminal::flushThrottledEvents(Timestamp _now)
+{
+    // Applications may update these with every prompt or progress tick. Forwarding them at most
+    // once per frame interval, and only the latest value, spares the display the updates no one sees.
+    auto const due = [&](optional<Timestamp> const& _lastUpdate) {
+        return !_lastUpdate || _now - *_lastUpdate >= frameScheduler_.frameInterval();
+    };
+
+    if (windowTitlePending_ && due(lastWindowTitleUpdate_))
+    {
+        windowTitlePending_ = false;
+        lastWindowTitleUpdate_ = _now;
+        if (reportedWindowTitle_ != state_.windowTitle)
+        {
+            reportedWindowTitle_ = state_.windowTitle;
+            eventListener_.setWindowTitle(reportedWindowTitle_);
+        }
+    }
+
+    if (pendingNotification_ && due(lastNotification_))
+    {
+        lastNotification_ = _now;
+        auto const [title, body] = std::move(*pendingNotification_);
+        pendingNotification_.reset();
+        eventListener_.notify(title, body);
+    }
+
+    throttledEventsPending_ = windowTitlePending_ || pendingNotification_;
 }
 
 void Terminal::reply(string_view _reply)
 {
-    // this is invoked from within the terminal thread.
-    // most likely that's not the main thread, which will however write
-    // the actual input events.
-    // TODO: introduce new mutex to guard terminal writes.
-    sendRaw(_reply);
+    auto const _l = std::lock_guard { inputLock_ };
+    pendingReplies_ += _reply;
 }
 
 void Terminal::resizeWindow(PageSize _size)
@@ -949,8 +1949,13 @@ void Terminal::setMouseWheelMode(InputGenerator::MouseWheelMode _mode)
 
 void Terminal::setWindowTitle(string_view _title)
 {
+    if (state_.windowTitle == _title && !windowTitlePending_)
+        return;
+
     state_.windowTitle = _title;
-    eventListener_.setWindowTitle(_title);
+    windowTitlePending_ = true;
+    throttledEventsPending_ = true;
+    flushThrottledEvents(currentTime_);
 }
 
 std::string const& Terminal::windowTitle() const noexcept
@@ -967,9 +1972,9 @@ void Terminal::restoreWindowTitle()
 {
     if (!state_.savedWindowTitles.empty())
     {
-        state_.windowTitle = state_.savedWindowTitles.top();
+        auto const title = std::move(state_.savedWindowTitles.top());
         state_.savedWindowTitles.pop();
-        setWindowTitle(state_.windowTitle);
+        setWindowTitle(title);
     }
 }
 
@@ -1107,9 +2112,12 @@ void Terminal::setMode(DECMode _mode, bool _enable)
         case DECMode::ExtendedAltScreen:
             if (_enable)
             {
+                // A freshly allocated alternate screen is blank already.
+                auto const allocated = state_.alternateBufferAllocated;
                 state_.savedPrimaryCursor = cursor();
                 setMode(DECMode::UseAlternateScreen, true);
-                clearScreen();
+                if (allocated)
+                    clearScreen();
             }
             else
             {
@@ -1321,7 +2329,7 @@ void Terminal::hardReset()
     setMode(DECMode::SixelCursorNextToGraphic, state_.sixelCursorConformance);
 
     state_.primaryBuffer.reset();
-    state_.alternateBuffer.reset();
+    releaseAlternateBuffer();
 
     state_.imagePool.clear();
 
@@ -1343,6 +2351,7 @@ void Terminal::hardReset()
 
     primaryScreen_.verifyState();
 
+    auto const _l = std::lock_guard { inputLock_ };
     state_.inputGenerator.reset();
 }
 
@@ -1356,8 +2365,16 @@ void Terminal::setScreen(ScreenType _type)
         case ScreenType::Primary:
             currentScreen_ = primaryScreen_;
             setMouseWheelMode(InputGenerator::MouseWheelMode::Default);
+            if (alternateScreenReleaseTimeout_ != chrono::milliseconds::zero())
+                alternateScreenLeft_ = chrono::steady_clock::now();
             break;
         case ScreenType::Alternate:
+            if (!state_.alternateBufferAllocated)
+            {
+                state_.alternateBuffer = Grid<Cell>(state_.pageSize, false, LineCount(0));
+                state_.alternateBufferAllocated = true;
+            }
+            alternateScreenLeft_.reset();
             currentScreen_ = alternateScreen_;
             if (isModeEnabled(DECMode::MouseAlternateScroll))
                 setMouseWheelMode(InputGenerator::MouseWheelMode::ApplicationCursorKeys);
@@ -1439,33 +2456,94 @@ void Terminal::markRegionDirty(Rect _area) noexcept
 
 void Terminal::synchronizedOutput(bool _enabled)
 {
+    auto const now = steady_clock::now();
+
+    // Render buffer refreshes are suppressed entirely while the update is pending.
     renderBufferUpdateEnabled_ = !_enabled;
     if (_enabled)
+    {
+        synchronizedOutputStart_ = now;
+        synchronizedOutputBytes_ = statistics_.bytesParsed.load(std::memory_order_relaxed);
         return;
+    }
 
-    tick(steady_clock::now());
+    if (synchronizedOutputStart_)
+    {
+        auto const duration = chrono::duration_cast<chrono::microseconds>(now - *synchronizedOutputStart_);
+        auto const bytes = statistics_.bytesParsed.load(std::memory_order_relaxed) - synchronizedOutputBytes_;
+        statistics_.synchronizedUpdates.fetch_add(1, std::memory_order_relaxed);
+        statistics_.synchronizedUpdateBytes.fetch_add(bytes, std::memory_order_relaxed);
+        statistics_.synchronizedUpdateTime.fetch_add(static_cast<uint64_t>(duration.count()),
+                                                     std::memory_order_relaxed);
+        synchronizedOutputStart_.reset();
+    }
 
-    auto const diff = currentTime_ - renderBuffer_.lastUpdate;
-    if (diff < refreshInterval_)
+    // Presents the whole update as exactly one frame, regardless of when the previous one was.
+    screenDirty_ = true;
+    renderBuffer_.state = RenderBufferState::RefreshBuffersAndTrySwap;
+    outputUpdated();
+}
+
+void Terminal::expireSynchronizedOutput(Timestamp _now)
+{
+    auto const _l = std::lock_guard { *this };
+    if (!synchronizedOutputStart_ || _now - *synchronizedOutputStart_ < synchronizedOutputTimeout_)
         return;
 
-    if (renderBuffer_.state == RenderBufferState::TrySwapBuffers)
+    TerminalLog()("Synchronized update timed out after {}.",
+                  chrono::duration_cast<chrono::milliseconds>(_now - *synchronizedOutputStart_));
+    statistics_.synchronizedUpdateTimeouts.fetch_add(1, std::memory_order_relaxed);
+    setMode(DECMode::BatchedRendering, false);
+}
+
+void Terminal::expireAlternateScreen(Timestamp _now)
+{
+    auto const _l = std::lock_guard { *this };
+    if (!alternateScreenLeft_ || _now - *alternateScreenLeft_ < alternateScreenReleaseTimeout_)
         return;
 
-    refreshRenderBuffer(true);
-    eventListener_.screenUpdated();
+    releaseAlternateBuffer();
+}
+
+void Terminal::releaseAlternateScreen()
+{
+    auto const _l = std::lock_guard { *this };
+    releaseAlternateBuffer();
+}
+
+void Terminal::releaseAlternateBuffer()
+{
+    if (!isPrimaryScreen())
+        return;
+
+    alternateScreenLeft_.reset();
+    if (!state_.alternateBufferAllocated)
+        return;
+
+    TerminalLog()("Releasing unused alternate screen buffer.");
+    state_.alternateBuffer = Grid<Cell>(UnallocatedAlternateBufferSize, false, LineCount(0));
+    state_.alternateBufferAllocated = false;
 }
 
 void Terminal::onBufferScrolled(LineCount _n) noexcept
 {
+    // Keep showing the history lines being read instead of drifting along with the output.
+    if (isPrimaryScreen())
+        viewport_.followScrolledLines(_n);
+
+    scrolledLines_ += unbox<uint64_t>(_n);
+
     if (!selection_)
         return;
 
-    auto const top = -boxed_cast<LineOffset>(primaryScreen_.historyLineCount());
+    auto const top = -boxed_cast<LineOffset>(primaryScreen_.scrollbackLineCount());
     if (selection_->from().line > top && selection_->to().line > top)
-        selection_->applyScroll(boxed_cast<LineOffset>(_n), primaryScreen_.historyLineCount());
+        selection_->applyScroll(boxed_cast<LineOffset>(_n), primaryScreen_.scrollbackLineCount());
     else
+    {
         selection_.reset();
+        viewChanged_ = true;
+    }
 }
 // }}}
 
@@ -1474,6 +2552,82 @@ void Terminal::setMaxHistoryLineCount(LineCount _maxHistoryLineCount)
     primaryScreen_.grid().setMaxHistoryLineCount(_maxHistoryLineCount);
 }
 
+void Terminal::enableHistoryArchive(FileSystem::path _path)
+{
+    primaryScreen_.grid().setHistoryArchive(std::make_shared<HistoryArchive>(std::move(_path)));
+}
+
+bool Terminal::hasHistoryArchive() const
+{
+    auto const _l = std::lock_guard { *this };
+    return primaryScreen_.grid().historyArchive() != nullptr;
+}
+
+size_t Terminal::historyMemoryUsage() const
+{
+    auto const _l = std::lock_guard { *this };
+    return primaryScreen_.grid().estimatedMemoryUsage();
+}
+
+size_t Terminal::compactHistory()
+{
+    auto const _l = std::lock_guard { *this };
+    return primaryScreen_.grid().compactHistory();
+}
+
+LineCount Terminal::spillHistory(LineCount _keep)
+{
+    auto const _l = std::lock_guard { *this };
+    auto const historyLineCount = primaryScreen_.historyLineCount();
+    if (viewport_.scrolled() || historyLineCount <= _keep)
+        return LineCount(0);
+
+    auto const count = primaryScreen_.grid().spillHistory(historyLineCount - _keep);
+    if (*count != 0)
+    {
+        TerminalLog()("Spilled {} history lines into the history archive.", count);
+        auto const top = -boxed_cast<LineOffset>(_keep);
+        if (selection_ && (selection_->from().line < top || selection_->to().line < top))
+            clearSelection();
+        else
+            breakLoopAndRefreshRenderBuffer();
+    }
+    return count;
+}
+
+std::vector<ImageId> Terminal::visibleImages() const
+{
+    auto const& grid = isPrimaryScreen() ? primaryScreen_.grid() : alternateScreen_.grid();
+    auto const pageLines = unbox<int>(pageSize().lines);
+    auto const top = isPrimaryScreen() ? -unbox<int>(viewport_.scrollOffset()) : 0;
+    auto const bottom = std::min(top + pageLines + (viewport_.pixelOffset() ? 1 : 0), pageLines);
+
+    auto images = std::vector<ImageId> {};
+    for (auto line = top; line < bottom; ++line)
+    {
+        auto const& gridLine = grid.scrollbackLineAt(LineOffset(line));
+        if (gridLine.isTrivialBuffer())
+            continue;
+        for (auto const& cell: gridLine.inflatedBuffer())
+            if (auto const fragment = cell.imageFragment())
+                if (auto const id = fragment->rasterizedImage().image().id();
+                    images.empty() || images.back() != id)
+                    images.push_back(id);
+    }
+    return images;
+}
+
+void Terminal::trimMemory()
+{
+    auto const _l = std::lock_guard { *this };
+    state_.imagePool.trim(0);
+}
+
+void Terminal::startOutputRecording(FileSystem::path const& _path)
+{
+    outputRecorder_ = std::make_unique<OutputRecorder>(_path, state_.pageSize);
+}
+
 LineCount Terminal::maxHistoryLineCount() const noexcept
 {
     return primaryScreen_.grid().maxHistoryLineCount();
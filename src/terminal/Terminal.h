@@ -13,27 +13,41 @@
  */
 #pragma once
 
+#include <terminal/FrameScheduler.h>
 #include <terminal/InputGenerator.h>
 #include <terminal/InputHandler.h>
+#include <terminal/InputLatency.h>
+#include <terminal/Metrics.h>
+#include <terminal/OutputRecording.h>
+#include <terminal/PredictiveEcho.h>
 #include <terminal/RenderBuffer.h>
 #include <terminal/ScreenEvents.h>
+#include <terminal/Hints.h>
+#include <terminal/Search.h>
 #include <terminal/Selector.h>
 #include <terminal/Sequence.h>
+#include <terminal/SixelDecoder.h>
 #include <terminal/TerminalState.h>
 #include <terminal/ViInputHandler.h>
 #include <terminal/Viewport.h>
 #include <terminal/primitives.h>
 #include <terminal/pty/Pty.h>
 
+#include <crispy/InstrumentedMutex.h>
+#include <crispy/stdfs.h>
+
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <iosfwd>
 #include <memory>
 #include <mutex>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace terminal
@@ -42,6 +56,12 @@ namespace terminal
 template <typename Cell, ScreenType TheScreenType>
 class Screen;
 
+template <typename Cell>
+class RenderBufferBuilder;
+
+class ParserExtension;
+class TmuxSession;
+
 /// Terminal API to manage input and output devices of a pseudo terminal, such as keyboard, mouse, and screen.
 ///
 /// With a terminal being attached to a Process, the terminal's screen
@@ -75,6 +95,14 @@ class Terminal
         virtual void setTerminalProfile(std::string const& /*_configProfileName*/) {}
         virtual void discardImage(Image const&) {}
         virtual void inputModeChanged(ViMode /*mode*/) {}
+
+        /// Invoked with the hint the user picked by typing its label in hint mode.
+        virtual void hintPicked(Hint const& /*_hint*/) {}
+
+        /// Invoked with the tmux session when the application enters tmux control mode (tmux -CC),
+        /// and with nullptr right before the session is destroyed, when control mode is left.
+        /// Only happens if permitted by setTmuxControlMode().
+        virtual void tmuxControlModeChanged(TmuxSession* /*_session*/) {}
     };
 
     Terminal(std::unique_ptr<Pty> _pty,
@@ -93,20 +121,81 @@ class Terminal
              ColorPalette _colorPalette = {},
              double _refreshRate = 30.0,
              bool _allowReflowOnResize = true);
-    ~Terminal() = default;
+    ~Terminal();
 
     void start();
 
     void setRefreshRate(double _refreshRate);
+
+    /// Decides when the display renders its next frame (see FrameScheduler).
+    FrameScheduler& frameScheduler() noexcept { return frameScheduler_; }
+    FrameScheduler const& frameScheduler() const noexcept { return frameScheduler_; }
+
+    /// Sets the maximum number of bytes of PTY input to be processed while holding the terminal lock.
+    ///
+    /// Larger reads are processed in multiple slices, releasing the lock in between,
+    /// so that rendering and user input are not blocked for the duration of a whole read.
+    void setInputSliceSize(size_t _bytes) noexcept { inputSliceSize_ = std::max(_bytes, size_t { 1 }); }
+    [[nodiscard]] size_t inputSliceSize() const noexcept { return inputSliceSize_; }
+
+    /// Enables validating and decoding large PTY reads on multiple threads ahead of parsing them.
+    ///
+    /// Reads are split into segments at line feeds, and segments made of text and C0 controls only
+    /// are committed to the screen with their UTF-8 decoded already. Any other segment is parsed
+    /// as usual. This only pays off with a large PTY read buffer size.
+    void setParallelParsing(bool _enabled) noexcept { parallelParsing_ = _enabled; }
+    [[nodiscard]] bool parallelParsing() const noexcept { return parallelParsing_; }
+
     void setLastMarkRangeOffset(LineOffset _value) noexcept;
 
     void setMaxHistoryLineCount(LineCount _maxHistoryLineCount);
+
+    /// Spills history lines evicted from the primary screen's scrollback into
+    /// an append-only archive file at @p _path, rather than dropping them.
+    ///
+    /// @throws std::runtime_error if the archive file could not be created.
+    void enableHistoryArchive(FileSystem::path _path);
+    [[nodiscard]] bool hasHistoryArchive() const;
+
+    /// Estimates the memory held by the primary screen's lines, including the scrollback,
+    /// in constant time (see Grid::estimatedMemoryUsage()).
+    [[nodiscard]] size_t historyMemoryUsage() const;
+
+    /// Compacts the primary screen's history lines, as would be done in the cold history tier.
+    ///
+    /// @returns the number of bytes saved.
+    size_t compactHistory();
+
+    /// Spills all but the @p _keep newest history lines of the primary screen into the history archive,
+    /// unless the viewport is scrolled into the history.
+    ///
+    /// @returns the number of lines spilled.
+    LineCount spillHistory(LineCount _keep);
+
+    /// Releases memory that is not needed for rendering the screen, such as the pixels
+    /// of images that have been rasterized already.
+    void trimMemory();
+
+    /// Records all output read from the PTY, along with its timing, into the file at @p _path.
+    ///
+    /// @throws std::runtime_error if the recording file could not be created.
+    void startOutputRecording(FileSystem::path const& _path);
     LineCount maxHistoryLineCount() const noexcept;
 
     void setTerminalId(VTType _id) noexcept { state_.terminalId = _id; }
     void setSixelCursorConformance(bool _value) noexcept { state_.sixelCursorConformance = _value; }
 
     void setMaxImageSize(ImageSize size) noexcept { state_.maxImageSize = size; }
+    void setMaxImageMemory(size_t _bytes) { state_.imagePool.setMemoryLimit(_bytes); }
+
+    /// Permits the kitty graphics protocol to read images from (temporary) files and shared memory.
+    void setKittyGraphicsFileAccess(bool _allowed) noexcept { state_.kittyGraphicsFileAccess = _allowed; }
+
+    /// Permits applications to enter tmux control mode (tmux -CC), which is ignored otherwise.
+    ///
+    /// Only to be enabled by frontends displaying the panes of the session passed to
+    /// Events::tmuxControlModeChanged(), which are to start() that session then.
+    void setTmuxControlMode(bool _allowed) noexcept { state_.tmuxControlMode = _allowed; }
 
     void setMaxImageSize(ImageSize _effective, ImageSize _limit)
     {
@@ -252,16 +341,112 @@ class Terminal
     bool applicationCursorKeys() const noexcept { return state_.inputGenerator.applicationCursorKeys(); }
     bool applicationKeypad() const noexcept { return state_.inputGenerator.applicationKeypad(); }
 
+    /// Whether there is input (or are replies to the application) waiting to be written.
     bool hasInput() const noexcept;
     size_t pendingInputBytes() const noexcept;
+
+    /// Writes the pending input to the PTY, followed by the pending replies.
     void flushInput();
 
+    /// Reports due coalesced mouse events to the application, see InputGenerator::tick().
+    void flushCoalescedInput(Timestamp _now);
+
+    /// Sets the window within which mouse motion and wheel events are coalesced, 0 disables it.
+    void setMouseCoalescingWindow(std::chrono::milliseconds _window) noexcept
+    {
+        state_.inputGenerator.setMouseCoalescingWindow(_window);
+    }
+
+    /// Sets the time after which a synchronized update (DEC mode 2026) is ended implicitly,
+    /// guarding against applications that never finish it.
+    void setSynchronizedOutputTimeout(std::chrono::milliseconds _timeout) noexcept
+    {
+        synchronizedOutputTimeout_ = _timeout;
+    }
+
+    /// Sets the time after which the alternate screen buffer is released once the primary screen
+    /// is in use again, or zero to keep it for the lifetime of the terminal.
+    void setAlternateScreenReleaseTimeout(std::chrono::milliseconds _timeout) noexcept
+    {
+        alternateScreenReleaseTimeout_ = _timeout;
+        if (_timeout == std::chrono::milliseconds::zero())
+            alternateScreenLeft_.reset();
+    }
+
+    /// Releases the memory of the alternate screen buffer unless it is currently in use,
+    /// such as when the system runs low on memory.
+    ///
+    /// The buffer is allocated again (blank) when the application switches to it next time.
+    void releaseAlternateScreen();
+
     std::string_view peekInput() const noexcept { return state_.inputGenerator.peek(); }
+
+    /// Keypress-to-photon latency measurement, stamped by the terminal and its frontend.
+    InputLatency& inputLatency() noexcept { return inputLatency_; }
+    InputLatency const& inputLatency() const noexcept { return inputLatency_; }
+
+    /// Predictive local echo of typed text, shown while the application's echo is on its way.
+    ///
+    /// Predictions are made and reconciled with the terminal lock held.
+    PredictiveEcho& predictiveEcho() noexcept { return predictiveEcho_; }
+    PredictiveEcho const& predictiveEcho() const noexcept { return predictiveEcho_; }
     // }}}
 
+    /// Running totals for live performance diagnostics, such as the frontend's metrics overlay.
+    struct Statistics
+    {
+        std::atomic<uint64_t> bytesParsed = 0;           // PTY output fed into the parser
+        std::atomic<uint64_t> renderBufferRefreshes = 0; // render buffer (back buffer) refreshes
+        std::atomic<uint64_t> renderBufferSwaps = 0;     // refreshed render buffers that got swapped in
+        std::atomic<uint64_t> renderBufferSkips = 0;     // refreshes spared, see renderedHistoryUnchanged()
+
+        // Synchronized updates (DEC mode 2026), each presented as a single frame.
+        std::atomic<uint64_t> synchronizedUpdates = 0;        // finished synchronized updates
+        std::atomic<uint64_t> synchronizedUpdateTimeouts = 0; // of those, ended by the timeout
+        std::atomic<uint64_t> synchronizedUpdateBytes = 0;    // PTY output read during synchronized updates
+        std::atomic<uint64_t> synchronizedUpdateTime = 0;     // total duration, in microseconds
+    };
+
+    Statistics const& statistics() const noexcept { return statistics_; }
+
+    /// Acquisitions of and contention on the terminal lock.
+    crispy::LockStats lockStats() const noexcept { return outerLock_.stats(); }
+
+    /// Acquisitions of and contention on the lock of the render buffer's reader (front buffer).
+    crispy::LockStats renderBufferLockStats() const noexcept { return renderBuffer_.readerLock.stats(); }
+
+    /// Writes the contention statistics of the terminal's locks, per owner thread, into @p _os.
+    ///
+    /// Must not be called with the terminal locked.
+    void inspectLocks(std::ostream& _os) const;
+
+    /// Enables or disables (and clears) collecting per VT function invocation counts and costs.
+    ///
+    /// The metrics are updated with the terminal lock held.
+    void setSequenceProfiling(bool _enabled);
+
+    /// @returns the collected VT function metrics, or nullptr if sequence profiling is disabled.
+    Metrics* sequenceMetrics() noexcept { return sequenceMetrics_.get(); }
+    Metrics const* sequenceMetrics() const noexcept { return sequenceMetrics_.get(); }
+
+    /// The tmux session while the application is in tmux control mode, or nullptr otherwise.
+    ///
+    /// Output of tmux panes is routed into terminals of their own then (see TmuxSession).
+    TmuxSession* tmuxSession() noexcept { return tmuxSession_.get(); }
+
+    /// Enters tmux control mode, returning the parser extension receiving the tmux client's output.
+    std::unique_ptr<ParserExtension> hookTmuxControl();
+
     /// Writes a given VT-sequence to screen.
     void writeToScreen(std::string_view _text);
 
+    /// Writes the given output to the screen, as if read from the PTY, for terminals that are
+    /// used by a single thread only (see HeadlessTerminal).
+    ///
+    /// Unlike writeToScreen(), this neither acquires the terminal lock nor notifies about
+    /// screen updates, and replies to the application are discarded.
+    void ingest(std::string_view _data);
+
     // viewport management
     Viewport& viewport() noexcept { return viewport_; }
     Viewport const& viewport() const noexcept { return viewport_; }
@@ -274,6 +459,12 @@ class Terminal
         auto const changes = changes_.exchange(0);
         currentTime_ = _now;
         updateCursorVisibilityState();
+        flushCoalescedInput(_now);
+        if (throttledEventsPending_)
+        {
+            auto const _l = std::lock_guard { *this };
+            flushThrottledEvents(_now);
+        }
         return changes;
     }
     // }}}
@@ -320,14 +511,39 @@ class Terminal
 
     /// Aquuires read-access handle to front render buffer.
     ///
-    /// This also acquires the reader lock and releases it automatically
-    /// upon RenderBufferRef destruction.
+    /// This picks up the most recently published frame, if any,
+    /// and holds the reader lock until RenderBufferRef destruction.
+    /// The reader lock is never contended by the terminal thread.
     ///
     /// @see ensureFreshRenderBuffer()
     /// @see refreshRenderBuffer()
     RenderBufferRef renderBuffer() const { return renderBuffer_.frontBuffer(); }
 
     RenderBufferState renderBufferState() const noexcept { return renderBuffer_.state; }
+
+    /// Puts the terminal into or out of hidden mode, e.g. when its display is not visible.
+    ///
+    /// While hidden, PTY input is still processed into the screen, but render buffers are not
+    /// refreshed and screen update notifications are coalesced. When shown again, the render buffer
+    /// is refreshed and a single screen update is reported.
+    void setHidden(bool _hidden);
+    [[nodiscard]] bool hidden() const noexcept { return hidden_.load(); }
+
+    [[nodiscard]] crispy::BufferObjectPoolStats const& ptyBufferPoolStats() const noexcept
+    {
+        return ptyBufferPool_.stats();
+    }
+
+    /// Writes a breakdown of the memory held by both screens' grids, the PTY buffer pool,
+    /// images and hyperlinks into @p _os.
+    void inspectMemoryUsage(std::ostream& _os) const;
+
+    /// Number of frames that have been handed over to the render thread.
+    uint64_t publishedFrameCount() const noexcept { return renderBuffer_.publishedFrames.load(); }
+
+    /// Number of handed over frames that got replaced by a newer one before the
+    /// render thread picked them up.
+    uint64_t skippedFrameCount() const noexcept { return renderBuffer_.skippedFrames.load(); }
     // }}}
 
     void lock() const
@@ -384,7 +600,8 @@ class Terminal
 
     bool cursorCurrentlyVisible() const noexcept
     {
-        return state_.cursor.visible && (cursorDisplay_ == CursorDisplay::Steady || cursorBlinkState_);
+        return state_.cursor.visible
+               && (cursorDisplay_ == CursorDisplay::Steady || !state_.focused || cursorBlinkState_);
     }
 
     std::chrono::steady_clock::time_point lastCursorBlink() const noexcept { return lastCursorBlink_; }
@@ -448,19 +665,112 @@ class Terminal
     bool selectionAvailable() const noexcept { return !!selection_; }
     // }}}
 
+    /// The cells selected at one point in time, to extract their text later on (e.g. on another thread),
+    /// regardless of how the selection is changed or cleared in between.
+    struct SelectionSnapshot
+    {
+        struct Line
+        {
+            Selection::Range range;
+            bool touchesRightPage;
+        };
+
+        ScreenType screenType = ScreenType::Primary;
+        PageSize pageSize {};
+        uint64_t scrolledLines = 0; // scrolledLines_ at the time of taking the snapshot
+        std::vector<Line> lines;
+        bool fullLines = false;
+    };
+
+    /// @returns the currently selected cells, or an empty snapshot if nothing is selected.
+    SelectionSnapshot snapshotSelection() const;
+
     std::string extractSelectionText() const;
+
+    /// Extracts the selected text and passes it to @p _sink in chunks of roughly @p _chunkSize bytes.
+    ///
+    /// Unlike the overload above, at most about one chunk of the selection is held in memory,
+    /// so that huge selections can be fed into the clipboard or into a pipe incrementally.
+    /// Chunks always end on a character boundary.
+    void extractSelectionText(std::function<void(std::string_view)> const& _sink,
+                              size_t _chunkSize = 64 * 1024) const;
+
+    /// Extracts the text of the cells in @p _snapshot, following them as they are scrolled
+    /// into the history since. The terminal is locked for a batch of lines at a time only,
+    /// so that the screen keeps being updated while extracting huge selections.
+    ///
+    /// Lines that have been scrolled out of the history are left out, and nothing further is
+    /// extracted once the screen has been switched or resized since taking the snapshot.
+    void extractSelectionText(SelectionSnapshot const& _snapshot,
+                              std::function<void(std::string_view)> const& _sink,
+                              size_t _chunkSize = 64 * 1024) const;
+
     std::string extractLastMarkRange() const;
 
+    /// Extracts the text of the current screen's cells from @p _from to @p _to (inclusive).
+    std::string extractText(CellLocation _from, CellLocation _to) const;
+
+    // {{{ search
+    /// Sets the pattern to search the screen's history and main page for, or clears it.
+    ///
+    /// @throws std::regex_error if the pattern is not a valid regular expression.
+    void setSearchPattern(std::optional<SearchPattern> _pattern);
+    [[nodiscard]] TextMatcher const* searchMatcher() const noexcept
+    {
+        return searchMatcher_ ? &*searchMatcher_ : nullptr;
+    }
+
+    /// Enables maintaining a trigram index of the history's text, speeding up repeated searches.
+    ///
+    /// History lines are indexed lazily, as searches pass them for the first time.
+    void setSearchIndexEnabled(bool _enabled);
+    [[nodiscard]] bool searchIndexEnabled() const noexcept { return !!searchIndex_; }
+
+    /// Finds the match of the search pattern closest to @p _from in the given direction.
+    [[nodiscard]] std::optional<SearchMatch> searchNext(CellLocation _from, SearchDirection _direction);
+
+    /// Collects the matches of the search pattern in the lines [_first, _last] of the current screen.
+    ///
+    /// Matches can thus be fetched incrementally while the user types, e.g. the viewport first.
+    [[nodiscard]] std::vector<SearchMatch> searchMatches(LineOffset _first, LineOffset _last);
+    // }}}
+
+    /// Collects the URLs, paths and git hashes in the lines [_first, _last] of the current screen,
+    /// e.g. the viewport, for the user to pick one of them by keyboard.
+    ///
+    /// Logical lines are only scanned again after they changed.
+    [[nodiscard]] std::vector<Hint> hints(LineOffset _first, LineOffset _last);
+
+    /// The hints being picked from in hint mode, and the characters of their labels typed so far.
+    struct HintMode
+    {
+        std::vector<Hint> hints;
+        std::vector<std::string> labels; //!< labels[i] picks hints[i]
+        std::string typed;
+    };
+
+    /// Labels the hints in the viewport, for the user to pick one of them by typing its label.
+    ///
+    /// Keyboard input then goes to hint mode rather than to the application, until a hint
+    /// is picked (see Events::hintPicked()) or Escape is pressed.
+    ///
+    /// @returns false if there is no hint in the viewport to pick.
+    bool startHintMode();
+    void stopHintMode();
+
+    /// @returns the state of hint mode if active, or nullptr otherwise.
+    [[nodiscard]] HintMode const* hintMode() const noexcept { return hintMode_ ? &*hintMode_ : nullptr; }
+
     /// Tests whether or not the mouse is currently hovering a hyperlink.
     bool isMouseHoveringHyperlink() const noexcept { return hoveringHyperlink_.load(); }
 
     /// Retrieves the HyperlinkInfo that is currently behing hovered by the mouse, if so,
     /// or a nothing otherwise.
-    std::shared_ptr<HyperlinkInfo const> tryGetHoveringHyperlink() const noexcept
+    HyperlinkInfo const* tryGetHoveringHyperlink() const noexcept
     {
         if (auto const gridPosition = currentMouseGridPosition())
             return currentScreen_.get().hyperlinkAt(*gridPosition);
-        return {};
+        return nullptr;
     }
 
     bool processInputOnce();
@@ -482,12 +792,17 @@ class Terminal
     void copyToClipboard(std::string_view _data);
     void inspect();
     void notify(std::string_view _title, std::string_view _body);
+    /// Queues a reply to the application, such as a device attributes or status report.
+    ///
+    /// Replies are written to the PTY at once, after the chunk of output containing the requests
+    /// has been parsed (see flushReplies()), rather than one write per reply.
     void reply(std::string_view _response);
 
     template <typename... T>
     void reply(fmt::format_string<T...> fmt, T&&... args)
     {
-        reply(fmt::vformat(fmt, fmt::make_format_args(args...)));
+        auto const _l = std::lock_guard { inputLock_ };
+        fmt::vformat_to(std::back_inserter(pendingReplies_), fmt, fmt::make_format_args(args...));
     }
 
     void resizeWindow(PageSize);
@@ -524,10 +839,20 @@ class Terminal
     TerminalState& state() noexcept { return state_; }
     TerminalState const& state() const noexcept { return state_; }
 
+    SixelDecoder& sixelDecoder() noexcept { return sixelDecoder_; }
+
     void applyPageSizeToCurrentBuffer();
 
     crispy::BufferObjectPtr currentPtyBuffer() const noexcept { return currentPtyBuffer_; }
 
+    /// Appends @p _tail to the text of a trivially styled line, @p _text.
+    ///
+    /// The resulting text is kept in a terminal-owned line text buffer rather than in the PTY buffer,
+    /// so that the line does not need to be inflated when its text is not contiguous in the PTY input.
+    ///
+    /// @returns a fragment referencing the concatenation of @p _text and @p _tail.
+    crispy::BufferFragment appendLineText(crispy::BufferFragment const& _text, std::string_view _tail);
+
     terminal::SelectionHelper& selectionHelper() noexcept { return selectionHelper_; }
 
     ViInputHandler& inputHandler() noexcept { return state_.inputHandler; }
@@ -537,8 +862,31 @@ class Terminal
     void mainLoop();
     void refreshRenderBuffer(RenderBuffer& _output); // <- acquires the lock
     void refreshRenderBufferInternal(RenderBuffer& _output);
+    RenderBufferBuilder<Cell> captureRenderBuffer(RenderBuffer& _output); // <- requires the lock
+    void captureRenderedHistory();                                         // <- requires the lock
+    void capturePrefetchLines(RenderBuffer& _output);                      // <- requires the lock
+    void flushThrottledEvents(Timestamp _now);                             // <- requires the lock
+    bool renderedHistoryUnchanged(bool _locked) const;
+    HyperlinkId hoveringHyperlinkId() const noexcept;
+    void outputUpdated();
     void updateCursorVisibilityState() const;
     bool updateCursorHoveringState();
+    void applyDecodedImages();
+    std::vector<ImageId> visibleImages() const; // <- requires terminal lock
+
+    /// Writes the pending replies to the PTY, unless user input is still waiting to be written,
+    /// which they must not overtake (flushInput() writes them after it then).
+    void flushReplies();
+    void writePendingReplies(); // <- requires inputLock_
+    void writeInput();          // <- requires inputLock_
+    TrigramIndex* searchIndex() noexcept;
+    bool predictEcho(char32_t _value, Modifier _modifier, Timestamp _now);
+    bool sendHintModeInput(char32_t _value);
+    void expireSynchronizedOutput(Timestamp _now);
+    void expireAlternateScreen(Timestamp _now);
+    void releaseAlternateBuffer();
+    void reconcilePredictedEcho(Timestamp _now);
+    void parseInParallel(std::string_view _input); // <- acquires the lock
 
     // private data
     //
@@ -548,10 +896,34 @@ class Terminal
 
     Events& eventListener_;
 
-    std::chrono::milliseconds refreshInterval_;
+    FrameScheduler frameScheduler_;
     bool screenDirty_ = false;
     RenderDoubleBuffer renderBuffer_ {};
 
+    // Whether anything but the application's output changed since the latest render buffer refresh,
+    // such as the viewport, the selection, or the vi mode.
+    std::atomic<bool> viewChanged_ = true;
+
+    // What the latest render buffer shows, if that is history lines only (see captureRenderedHistory()).
+    struct RenderedHistory
+    {
+        std::vector<uint64_t> lineGenerations; // of the lines shown, from top to bottom
+        PageSize pageSize {};
+        int pixelOffset = 0;
+        bool reverseVideo = false;
+        HyperlinkId hoveringHyperlink {};
+        ColorPalette colorPalette;
+    };
+    std::optional<RenderedHistory> renderedHistory_;
+
+    // Window title and notification updates not forwarded yet (see flushThrottledEvents()).
+    std::atomic<bool> throttledEventsPending_ = false;
+    bool windowTitlePending_ = false;
+    std::string reportedWindowTitle_;
+    std::optional<Timestamp> lastWindowTitleUpdate_;
+    std::optional<std::pair<std::string, std::string>> pendingNotification_;
+    std::optional<Timestamp> lastNotification_;
+
     std::unique_ptr<Pty> pty_;
 
     std::chrono::steady_clock::time_point startTime_;
@@ -580,19 +952,54 @@ class Terminal
     TerminalState state_;
     crispy::BufferObjectPool ptyBufferPool_;
     crispy::BufferObjectPtr currentPtyBuffer_;
+    crispy::BufferObjectPtr lineTextBuffer_;
     size_t ptyReadBufferSize_;
+    size_t inputSliceSize_ = 4096;
+    std::atomic<bool> parallelParsing_ = false;
+
+    std::chrono::milliseconds synchronizedOutputTimeout_ { 1000 };
+    std::optional<Timestamp> synchronizedOutputStart_; // start of the pending synchronized update
+    uint64_t synchronizedOutputBytes_ = 0;             // statistics_.bytesParsed at its start
+    std::chrono::milliseconds alternateScreenReleaseTimeout_ { 60000 };
+    std::optional<Timestamp> alternateScreenLeft_; // time the allocated alternate screen was left
     Screen<Cell, ScreenType::Primary> primaryScreen_;
     Screen<Cell, ScreenType::Alternate> alternateScreen_;
     std::reference_wrapper<ScreenBase> currentScreen_;
 
-    std::mutex mutable outerLock_;
+    crispy::InstrumentedMutex mutable outerLock_; // counts the contention between PTY and render thread
     std::mutex mutable innerLock_;
+
+    // Guards writing to the PTY and the replies, which are produced by the PTY thread and
+    // may be flushed by the GUI thread along with the user's input.
+    std::mutex mutable inputLock_;
+    std::string pendingReplies_;
+    // Whether input or replies are left over from a write the PTY did not fully accept. These are
+    // written again by the PTY thread, which wakes up once the PTY accepts input again.
+    std::atomic<bool> inputBacklogged_ = false;
     Viewport viewport_;
     std::unique_ptr<Selection> selection_;
+    uint64_t scrolledLines_ = 0; // total number of lines the screens have been scrolled up by
+    std::optional<TextMatcher> searchMatcher_;
+    std::unique_ptr<TrigramIndex> searchIndex_;
+    std::unique_ptr<HintMatcher> hintMatcher_;
+    HintCache hintCache_;
+    std::optional<HintMode> hintMode_;
     std::atomic<bool> hoveringHyperlink_ = false;
     std::atomic<bool> renderBufferUpdateEnabled_ = true;
+    std::atomic<bool> hidden_ = false;
 
     std::atomic<uint64_t> lastFrameID_ = 0;
+    InputLatency inputLatency_;
+    PredictiveEcho predictiveEcho_;
+    std::unique_ptr<OutputRecorder> outputRecorder_;
+    Statistics statistics_;
+    std::unique_ptr<Metrics> sequenceMetrics_;
+    std::unique_ptr<TmuxSession> tmuxSession_;
+
+#if defined(CONTOUR_PERF_TRACING)
+    std::atomic<uint64_t> perfTraceFlow_ = 0; // flow ID of the output awaiting a render buffer refresh
+    uint64_t perfTraceFlowCounter_ = 0;
+#endif
 
     struct SelectionHelper: public terminal::SelectionHelper
     {
@@ -603,8 +1010,29 @@ class Terminal
         [[nodiscard]] bool wrappedLine(LineOffset _line) const noexcept override;
         [[nodiscard]] bool cellEmpty(CellLocation _pos) const noexcept override;
         [[nodiscard]] int cellWidth(CellLocation _pos) const noexcept override;
+
+        /// Drops all cached word delimiter tables, e.g. when the delimiters or the screen change.
+        void invalidateWordDelimiters() noexcept { wordDelimiterLines.clear(); }
+
+      private:
+        /// Word delimiting state of each cell of a line, valid as long as the line's generation matches.
+        struct WordDelimiterLine
+        {
+            uint64_t generation = 0;
+            std::vector<bool> delimited;
+        };
+
+        template <typename Cell>
+        std::vector<bool> const& wordDelimitersAt(Grid<Cell> const& _grid, LineOffset _line) const;
+
+        /// Classified lines recently hit-tested by word-wise selection, keyed by line offset,
+        /// so that extending a selection on every mouse move does not classify each cell again.
+        mutable std::unordered_map<int, WordDelimiterLine> wordDelimiterLines;
     };
     SelectionHelper selectionHelper_;
+
+    // Must be destroyed before the PTY, as its worker thread wakes up the PTY reader.
+    SixelDecoder sixelDecoder_;
 };
 
 } // namespace terminal
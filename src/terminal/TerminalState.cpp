@@ -45,10 +45,9 @@ TerminalState::TerminalState(Terminal& _terminal,
     sixelCursorConformance { _sixelCursorConformance },
     allowReflowOnResize { _allowReflowOnResize },
     primaryBuffer { Grid<Cell>(_pageSize, _allowReflowOnResize, _maxHistoryLineCount) },
-    alternateBuffer { Grid<Cell>(_pageSize, false, LineCount(0)) },
+    alternateBuffer { Grid<Cell>(UnallocatedAlternateBufferSize, false, LineCount(0)) },
     cursor {},
     lastCursorPosition {},
-    hyperlinks { HyperlinkCache { 1024 } },
     sequencer { _terminal },
     parser { std::ref(sequencer) },
     viCommands { terminal },
@@ -21,6 +21,7 @@
 #include <terminal/Hyperlink.h>
 #include <terminal/InputGenerator.h>
 #include <terminal/InputHandler.h>
+#include <terminal/KittyGraphics.h>
 #include <terminal/Parser.h>
 #include <terminal/ScreenEvents.h> // ScreenType
 #include <terminal/Sequencer.h>
@@ -35,6 +36,7 @@
 #include <bitset>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <stack>
 #include <vector>
 
@@ -108,6 +110,9 @@ struct Cursor
 };
 // }}}
 
+/// Size of the alternate screen buffer while not in use, as most sessions never switch to it.
+constexpr PageSize UnallocatedAlternateBufferSize { LineCount(1), ColumnCount(1) };
+
 /**
  * Defines the state of a terminal.
  * All those data members used to live in Screen, but are moved
@@ -150,6 +155,9 @@ struct TerminalState
     ImageSize maxImageSizeLimit;
     std::shared_ptr<SixelColorPalette> imageColorPalette;
     ImagePool imagePool;
+    std::optional<KittyGraphicsCommand> pendingKittyGraphicsCommand; //!< awaiting more payload chunks
+    bool kittyGraphicsFileAccess = false; //!< whether images may be read from files or shared memory
+    bool tmuxControlMode = false;         //!< whether applications may enter tmux control mode
 
     bool sixelCursorConformance = true;
 
@@ -159,7 +167,8 @@ struct TerminalState
 
     ScreenType screenType = ScreenType::Primary;
     Grid<Cell> primaryBuffer;
-    Grid<Cell> alternateBuffer;
+    Grid<Cell> alternateBuffer; //!< a placeholder of UnallocatedAlternateBufferSize until first used
+    bool alternateBufferAllocated = false;
 
     // cursor related
     //
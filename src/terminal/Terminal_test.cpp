@@ -25,6 +25,7 @@
 #include <iostream>
 #include <iterator>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -49,23 +50,33 @@ vector<string> textScreenshot(terminal::Terminal const& _terminal)
 {
     terminal::RenderBufferRef renderBuffer = _terminal.renderBuffer();
 
+    // While scrolled by a fraction of a line, the line below the page is rendered, too.
     vector<string> lines;
-    lines.resize(_terminal.pageSize().lines.as<size_t>());
-
-    terminal::CellLocation lastPos = {};
-    size_t lastCount = 0;
-    for (terminal::RenderCell const& cell: renderBuffer.buffer.cells)
+    lines.resize(max(_terminal.pageSize().lines.as<size_t>(), renderBuffer.buffer.lines.size()));
+
+    // The number of columns filled in each line so far.
+    vector<int> widths(lines.size());
+    auto const put = [&](terminal::CellLocation _position, u32string_view _codepoints) {
+        auto const row = unbox<size_t>(_position.line);
+        auto& currentLine = lines.at(row);
+        auto const gap = unbox<int>(_position.column) - widths.at(row);
+        if (gap > 0) // Did we jump?
+            currentLine.insert(currentLine.end(), static_cast<size_t>(gap), ' ');
+
+        currentLine += unicode::convert_to<char>(_codepoints);
+        widths[row] = max(widths[row], unbox<int>(_position.column)) + 1;
+    };
+
+    for (terminal::RenderRun const& run: renderBuffer.buffer.runs)
     {
-        auto const gap = (cell.position.column + static_cast<int>(lastCount) - 1) - lastPos.column;
-        auto& currentLine = lines.at(unbox<size_t>(cell.position.line));
-        if (*gap > 0) // Did we jump?
-            currentLine.insert(currentLine.end(), unbox<size_t>(gap) - 1, ' ');
-
-        currentLine += unicode::convert_to<char>(u32string_view(cell.codepoints));
-        lastPos = cell.position;
-        lastCount = 1;
+        auto position = run.start;
+        for (size_t i = 0; i < run.text.size(); ++i, ++position.column)
+            put(position, run.text.substr(i, 1));
     }
 
+    for (terminal::RenderCell const& cell: renderBuffer.buffer.cells)
+        put(cell.position, u32string_view(cell.codepoints));
+
     return lines;
 }
 
@@ -128,11 +139,24 @@ class MockTerm: public terminal::Terminal::Events
 
     string const& replyData() const noexcept { return pty_.stdinBuffer(); }
 
+    void setWindowTitle(std::string_view _title) override
+    {
+        windowTitle = _title;
+        ++windowTitleUpdates;
+    }
+
+    string windowTitle;
+    int windowTitleUpdates = 0;
+
     void requestCaptureBuffer(LineCount lines, bool logical) override
     {
         terminal_.primaryScreen().captureBuffer(lines, logical);
     }
 
+    void hintPicked(terminal::Hint const& _hint) override { pickedHints.push_back(_hint); }
+
+    vector<terminal::Hint> pickedHints;
+
     void logScreenText(std::string const& headline = "")
     {
         if (headline.empty())
@@ -211,6 +235,22 @@ TEST_CASE("Terminal.BlinkingCursor", "[terminal]")
         terminal.ensureFreshRenderBuffer();
         CHECK(terminal.cursorCurrentlyVisible());
     }
+
+    SECTION("steady while unfocused")
+    {
+        terminal.sendFocusOutEvent();
+        CHECK(!terminal.nextRender().has_value());
+
+        auto const clockAfterTurn = clockBase + BlinkInterval + chrono::milliseconds(1);
+        terminal.tick(clockAfterTurn);
+        terminal.ensureFreshRenderBuffer();
+        CHECK(terminal.cursorCurrentlyVisible());
+
+        // blinking starts over, visible, when regaining focus
+        terminal.sendFocusInEvent();
+        CHECK(terminal.nextRender() == BlinkInterval);
+        CHECK(terminal.cursorCurrentlyVisible());
+    }
 }
 
 TEST_CASE("Terminal.DECCARA", "[terminal]")
@@ -298,6 +338,34 @@ TEST_CASE("Terminal.CaptureScreenBuffer")
     // But here we test the full cycle.
 }
 
+TEST_CASE("Terminal.Replies.Batched", "[terminal]")
+{
+    auto mock = MockTerm { ColumnCount(10), LineCount(2) };
+
+    // DA1, DSR and DA2 in one chunk of output are answered with a single write.
+    mock.writeToStdout("\033[c\033[5n\033[>c");
+    CHECK(mock.pty().writeCount() == 1);
+    CHECK(mock.replyData().find("\033[0n") != string::npos);
+    CHECK(mock.replyData().find("\033[?") == 0);
+    CHECK(mock.replyData().find("\033[>") > mock.replyData().find("\033[0n"));
+    CHECK_FALSE(mock.terminal().hasInput());
+}
+
+TEST_CASE("Terminal.Replies.AfterPendingInput", "[terminal]")
+{
+    auto mock = MockTerm { ColumnCount(10), LineCount(2) };
+
+    // Replies do not overtake user input that has not been written yet.
+    mock.terminal().sendRaw("abc");
+    mock.writeToStdout("\033[5n");
+    CHECK(mock.pty().writeCount() == 0);
+    CHECK(mock.terminal().hasInput());
+
+    mock.terminal().flushInput();
+    CHECK(e(mock.replyData()) == e("abc\033[0n"));
+    CHECK_FALSE(mock.terminal().hasInput());
+}
+
 TEST_CASE("Terminal.SynchronizedOutput", "[terminal]")
 {
     constexpr auto BatchOn = "\033[?2026h"sv;
@@ -321,6 +389,57 @@ TEST_CASE("Terminal.SynchronizedOutput", "[terminal]")
     mc.terminal().tick(now);
     mc.terminal().ensureFreshRenderBuffer();
     CHECK("Hello  World" == trimmedTextScreenshot(mc));
+
+    auto const& statistics = mc.terminal().statistics();
+    CHECK(statistics.synchronizedUpdates == 1);
+    CHECK(statistics.synchronizedUpdateTimeouts == 0);
+    CHECK(statistics.synchronizedUpdateBytes == "Hello  World"sv.size() + BatchOff.size());
+}
+
+TEST_CASE("Terminal.SynchronizedOutput.Timeout", "[terminal]")
+{
+    auto mc = MockTerm { ColumnCount(20), LineCount(1) };
+    mc.terminal().setSynchronizedOutputTimeout(chrono::milliseconds(1));
+
+    mc.writeToStdout("\033[?2026hHello");
+    mc.terminal().tick(chrono::steady_clock::now());
+    mc.terminal().ensureFreshRenderBuffer();
+    CHECK("" == trimmedTextScreenshot(mc));
+
+    // An application that never ends its update gets it ended implicitly.
+    this_thread::sleep_for(chrono::milliseconds(2));
+    mc.writeToStdout("!");
+    CHECK_FALSE(mc.terminal().isModeEnabled(terminal::DECMode::BatchedRendering));
+    CHECK(mc.terminal().statistics().synchronizedUpdateTimeouts == 1);
+
+    mc.terminal().tick(chrono::steady_clock::now());
+    mc.terminal().ensureFreshRenderBuffer();
+    CHECK("Hello!" == trimmedTextScreenshot(mc));
+}
+
+TEST_CASE("Terminal.AlternateScreen.LazyAllocation", "[terminal]")
+{
+    auto const pageSize = PageSize { LineCount(3), ColumnCount(10) };
+    auto mc = MockTerm { pageSize.columns, pageSize.lines };
+    auto const& grid = mc.terminal().alternateScreen().grid();
+    CHECK(grid.pageSize() == terminal::UnallocatedAlternateBufferSize);
+
+    mc.writeToStdout("\033[?1049hAlt");
+    CHECK(grid.pageSize() == pageSize);
+    CHECK(grid.lineTextTrimmed(LineOffset(0)) == "Alt");
+
+    // The released buffer is allocated again (blank) when switched to.
+    mc.writeToStdout("\033[?1049l");
+    mc.terminal().releaseAlternateScreen();
+    CHECK(grid.pageSize() == terminal::UnallocatedAlternateBufferSize);
+
+    mc.writeToStdout("\033[?1049h");
+    CHECK(grid.pageSize() == pageSize);
+    CHECK(grid.lineTextTrimmed(LineOffset(0)).empty());
+
+    // The buffer in use is never released.
+    mc.terminal().releaseAlternateScreen();
+    CHECK(grid.pageSize() == pageSize);
 }
 
 TEST_CASE("Terminal.CurlyUnderline", "[terminal]")
@@ -345,3 +464,425 @@ TEST_CASE("Terminal.CurlyUnderline", "[terminal]")
     CHECK(!screen.at(LineOffset(0), ColumnOffset(2)).isFlagEnabled(CellFlags::Italic));
     CHECK(!screen.at(LineOffset(0), ColumnOffset(3)).isFlagEnabled(CellFlags::Italic));
 }
+
+TEST_CASE("Terminal.RenderBuffer.ReuseUnchangedLines", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(5), LineCount(3) };
+    mock.writeToStdout("abc\r\ndef\r\nghi");
+
+    // Render enough frames for both render buffers to hold the current page.
+    for (auto i = 1; i <= 3; ++i)
+    {
+        mock.terminal().tick(ClockBase + chrono::seconds(i));
+        mock.terminal().ensureFreshRenderBuffer();
+        CHECK("abc\ndef\nghi" == trimmedTextScreenshot(mock));
+    }
+
+    // Changing a single line must still render the other lines as before.
+    mock.writeToStdout("\033[1;1HX");
+    for (auto i = 4; i <= 5; ++i)
+    {
+        mock.terminal().tick(ClockBase + chrono::seconds(i));
+        mock.terminal().ensureFreshRenderBuffer();
+        CHECK("Xbc\ndef\nghi" == trimmedTextScreenshot(mock));
+    }
+
+    mock.writeToStdout("\033[3;1HY");
+    mock.terminal().tick(ClockBase + chrono::seconds(6));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK("Xbc\ndef\nYhi" == trimmedTextScreenshot(mock));
+}
+
+TEST_CASE("Terminal.RenderBuffer.SelectionKeysLines", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(5), LineCount(3) };
+    mock.writeToStdout("\033[?25labc\r\ndef\r\nghi");
+
+    auto const renderKeys = [&](int _second) {
+        mock.terminal().tick(ClockBase + chrono::seconds(_second));
+        mock.terminal().ensureFreshRenderBuffer();
+        auto keys = vector<uint64_t> {};
+        for (terminal::RenderLine const& line: mock.terminal().renderBuffer().get().lines)
+            keys.push_back(line.generation);
+        return keys;
+    };
+    renderKeys(1);
+    auto const unselected = renderKeys(2);
+
+    // Selecting within a line changes that line's key only, so the other lines remain reusable.
+    auto const at = [](int _line, int _column) {
+        return terminal::CellLocation { LineOffset(_line), ColumnOffset(_column) };
+    };
+    auto selection = make_unique<terminal::LinearSelection>(mock.terminal().selectionHelper(), at(1, 0));
+    selection->extend(at(1, 2));
+    selection->complete();
+    mock.terminal().setSelector(move(selection));
+
+    auto const selected = renderKeys(3);
+    REQUIRE(selected.size() == 3);
+    CHECK(selected[0] == unselected[0]);
+    CHECK(selected[1] != unselected[1]);
+    CHECK(selected[2] == unselected[2]);
+    CHECK("abc\ndef\nghi" == trimmedTextScreenshot(mock));
+}
+
+TEST_CASE("Terminal.RenderBuffer.CodepointStorage", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(6), LineCount(2) };
+    mock.writeToStdout("\033[1mAB\033[mCD\r\n\033[4mEä\033[m");
+    mock.terminal().tick(ClockBase + chrono::seconds(1));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK("ABCD\nEä" == trimmedTextScreenshot(mock));
+
+    // All runs and grapheme clusters are stored consecutively, line by line,
+    // in the render buffer's shared codepoint storage.
+    terminal::RenderBufferRef renderBuffer = mock.terminal().renderBuffer();
+    auto const& buffer = renderBuffer.get();
+    auto expectedOffset = size_t { 0 };
+    for (terminal::RenderLine const& line: buffer.lines)
+    {
+        for (size_t i = line.runOffset; i < line.runOffset + line.runCount; ++i)
+        {
+            auto const& run = buffer.runs.at(i);
+            CHECK(run.codepointOffset == expectedOffset);
+            CHECK(run.text.data() == buffer.codepoints.data() + run.codepointOffset);
+            expectedOffset += run.text.size();
+        }
+        for (size_t i = line.cellOffset; i < line.cellOffset + line.cellCount; ++i)
+        {
+            auto const& cell = buffer.cells.at(i);
+            CHECK(cell.codepointOffset == expectedOffset);
+            CHECK(cell.codepoints.data() == buffer.codepoints.data() + cell.codepointOffset);
+            expectedOffset += cell.codepoints.size();
+        }
+    }
+    CHECK(expectedOffset == buffer.codepoints.size());
+}
+
+TEST_CASE("Terminal.RenderBuffer.PixelScrolling", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto constexpr LineHeight = 16;
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+    mock.writeToStdout("111\r\n222\r\n333\r\n444");
+    auto& viewport = mock.terminal().viewport();
+
+    auto const render = [&](int _second) {
+        mock.terminal().tick(ClockBase + chrono::seconds(_second));
+        mock.terminal().ensureFreshRenderBuffer();
+        return trimmedTextScreenshot(mock);
+    };
+
+    // A fraction of a line exposes the line above the page and keeps the bottom line partially visible.
+    CHECK(viewport.scrollPixels(10, LineHeight));
+    CHECK(viewport.scrollOffset() == terminal::ScrollOffset(1));
+    CHECK(viewport.pixelOffset() == 6);
+    CHECK("222\n333\n444" == render(1));
+    CHECK(mock.terminal().renderBuffer().get().pixelOffset == 6);
+
+    // Completing the line scrolls by whole lines again.
+    CHECK(viewport.scrollPixels(6, LineHeight));
+    CHECK(viewport.scrollOffset() == terminal::ScrollOffset(1));
+    CHECK(viewport.pixelOffset() == 0);
+    CHECK("222\n333" == render(2));
+
+    // Scrolling is bounded by the history.
+    CHECK(viewport.scrollPixels(10 * LineHeight, LineHeight));
+    CHECK(viewport.scrollOffset() == terminal::ScrollOffset(2));
+    CHECK(viewport.pixelOffset() == 0);
+    CHECK_FALSE(viewport.scrollPixels(1, LineHeight));
+
+    CHECK(viewport.scrollPixels(-100 * LineHeight, LineHeight));
+    CHECK(viewport.scrollOffset() == terminal::ScrollOffset(0));
+    CHECK(viewport.pixelOffset() == 0);
+    CHECK("333\n444" == render(3));
+}
+
+TEST_CASE("Terminal.RenderBuffer.PrefetchWhileScrolling", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+    mock.writeToStdout("111\r\n222\r\n333\r\n444\r\n555\r\n666");
+    auto& viewport = mock.terminal().viewport();
+
+    auto const prefetched = [&]() {
+        mock.terminal().tick(ClockBase);
+        mock.terminal().ensureFreshRenderBuffer();
+        auto const buffer = mock.terminal().renderBuffer();
+        auto text = u32string {};
+        for (auto const& run: buffer.get().prefetchRuns)
+            text += buffer.get().prefetchText.substr(run.textOffset, run.textLength) + U'|';
+        return text;
+    };
+
+    CHECK(prefetched().empty());
+
+    // The lines above the viewport are prefetched while scrolling up, ...
+    CHECK(viewport.scrollTo(terminal::ScrollOffset(2)));
+    auto const above = prefetched();
+    CHECK(above.find(U"111") != u32string::npos);
+    CHECK(above.find(U"222") != u32string::npos);
+    CHECK(above.find(U"333") == u32string::npos);
+
+    // ... and the ones below while scrolling down.
+    CHECK(viewport.scrollTo(terminal::ScrollOffset(1)));
+    auto const below = prefetched();
+    CHECK(below.find(U"666") != u32string::npos);
+    CHECK(below.find(U"222") == u32string::npos);
+}
+
+TEST_CASE("Terminal.RenderBuffer.ScrolledBackOutput", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+    mock.writeToStdout("111\r\n222\r\n333\r\n444");
+    auto& viewport = mock.terminal().viewport();
+    auto const& statistics = mock.terminal().statistics();
+
+    auto const render = [&](int _second) {
+        mock.terminal().tick(ClockBase + chrono::seconds(_second));
+        mock.terminal().ensureFreshRenderBuffer();
+        return trimmedTextScreenshot(mock);
+    };
+
+    CHECK(viewport.scrollTo(terminal::ScrollOffset(2)));
+    CHECK("111\n222" == render(1));
+    auto const refreshes = statistics.renderBufferRefreshes.load();
+
+    // The viewport stays on the history lines being read, which need not be rendered again.
+    mock.writeToStdout("\r\n555\r\n666");
+    CHECK(viewport.scrollOffset() == terminal::ScrollOffset(4));
+    CHECK("111\n222" == render(2));
+    CHECK(statistics.renderBufferRefreshes.load() == refreshes);
+    CHECK(statistics.renderBufferSkips.load() != 0);
+
+    CHECK(viewport.scrollToBottom());
+    CHECK("555\n666" == render(3));
+    CHECK(statistics.renderBufferRefreshes.load() == refreshes + 1);
+}
+
+TEST_CASE("Terminal.WindowTitle.Throttled", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+
+    // The first update is forwarded right away, the ones following within the frame interval
+    // are held back, and only the latest of them is forwarded by the next tick.
+    mock.writeToStdout("\033]2;1%\033\\");
+    CHECK(mock.windowTitle == "1%");
+    mock.writeToStdout("\033]2;2%\033\\\033]2;3%\033\\");
+    CHECK(mock.windowTitle == "1%");
+    CHECK(mock.terminal().windowTitle() == "3%");
+    CHECK(mock.terminal().nextRender().has_value());
+
+    mock.terminal().tick(ClockBase + chrono::seconds(1));
+    CHECK(mock.windowTitle == "3%");
+    CHECK(mock.windowTitleUpdates == 2);
+
+    // Setting the same title again is not forwarded at all.
+    mock.writeToStdout("\033]2;3%\033\\");
+    mock.terminal().tick(ClockBase + chrono::seconds(2));
+    CHECK(mock.windowTitleUpdates == 2);
+}
+
+TEST_CASE("Terminal.RenderBuffer.SkippedFrames", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+
+    mock.writeToStdout("A");
+    mock.terminal().tick(ClockBase + chrono::seconds(1));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK(mock.terminal().publishedFrameCount() == 1);
+    CHECK(mock.terminal().skippedFrameCount() == 0);
+
+    // Publish two more frames without the reader picking up the first one.
+    mock.writeToStdout("B");
+    mock.terminal().tick(ClockBase + chrono::seconds(2));
+    mock.terminal().ensureFreshRenderBuffer();
+    mock.writeToStdout("C");
+    mock.terminal().tick(ClockBase + chrono::seconds(3));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK(mock.terminal().publishedFrameCount() == 3);
+    CHECK(mock.terminal().skippedFrameCount() == 2);
+
+    // The reader always gets the latest frame.
+    CHECK("ABC" == trimmedTextScreenshot(mock));
+
+    mock.writeToStdout("D");
+    mock.terminal().tick(ClockBase + chrono::seconds(4));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK("ABCD" == trimmedTextScreenshot(mock));
+    CHECK(mock.terminal().skippedFrameCount() == 2);
+}
+
+TEST_CASE("Terminal.InputSlices", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(10), LineCount(2) };
+
+    // Slice boundaries may split escape sequences as well as UTF-8 sequences.
+    mock.terminal().setInputSliceSize(3);
+    mock.writeToStdout("Hello\033[1;31m\r\nWörld\033[m");
+
+    mock.terminal().tick(ClockBase + chrono::seconds(1));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK("Hello\nWörld" == trimmedTextScreenshot(mock));
+    CHECK(mock.terminal().primaryScreen().at(LineOffset(1), ColumnOffset(0)).isFlagEnabled(CellFlags::Bold));
+}
+
+TEST_CASE("Terminal.Hidden", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+    mock.writeToStdout("A");
+    mock.terminal().tick(ClockBase + chrono::seconds(1));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK("A" == trimmedTextScreenshot(mock));
+
+    // Input is still processed while hidden, but no frames are rendered.
+    mock.terminal().setHidden(true);
+    mock.writeToStdout("B");
+    mock.terminal().tick(ClockBase + chrono::seconds(2));
+    CHECK_FALSE(mock.terminal().ensureFreshRenderBuffer());
+    CHECK(mock.terminal().publishedFrameCount() == 1);
+    CHECK("A" == trimmedTextScreenshot(mock));
+    CHECK(mock.terminal().primaryScreen().grid().lineTextTrimmed(LineOffset(0)) == "AB");
+
+    mock.terminal().setHidden(false);
+    mock.terminal().tick(ClockBase + chrono::seconds(3));
+    mock.terminal().ensureFreshRenderBuffer();
+    CHECK(mock.terminal().publishedFrameCount() == 2);
+    CHECK("AB" == trimmedTextScreenshot(mock));
+}
+
+TEST_CASE("Terminal.ExtractSelectionText.Chunked", "[terminal]")
+{
+    auto mock = MockTerm { ColumnCount(10), LineCount(3) };
+    mock.writeToStdout("Hello\r\nW\033[1mö\033[mrld   x\r\nfoo   ");
+
+    auto const at = [](int _line, int _column) {
+        return terminal::CellLocation { LineOffset(_line), ColumnOffset(_column) };
+    };
+    auto selection = make_unique<terminal::LinearSelection>(mock.terminal().selectionHelper(), at(0, 1));
+    selection->extend(at(2, 5));
+    selection->complete();
+    mock.terminal().setSelector(move(selection));
+
+    auto const expectedText = "ello\nWörld   x\nfoo"s;
+    CHECK(mock.terminal().extractSelectionText() == expectedText);
+
+    // Tiny chunks are split in between lines and characters, but never within trailing spaces.
+    auto chunks = vector<string> {};
+    mock.terminal().extractSelectionText([&](string_view _chunk) { chunks.emplace_back(_chunk); }, 1);
+    CHECK(chunks == vector<string> { "ello\n", "Wörld   x\n", "foo" });
+}
+
+TEST_CASE("Terminal.ExtractSelectionText.Snapshot", "[terminal]")
+{
+    auto mock = MockTerm { ColumnCount(10), LineCount(3) };
+    mock.writeToStdout("one\r\ntwo\r\nthree");
+
+    auto const at = [](int _line, int _column) {
+        return terminal::CellLocation { LineOffset(_line), ColumnOffset(_column) };
+    };
+    auto selection = make_unique<terminal::LinearSelection>(mock.terminal().selectionHelper(), at(1, 0));
+    selection->extend(at(2, 9));
+    selection->complete();
+    mock.terminal().setSelector(move(selection));
+    auto const snapshot = mock.terminal().snapshotSelection();
+
+    auto const extract = [&]() {
+        auto text = string {};
+        mock.terminal().extractSelectionText(snapshot, [&](string_view _chunk) { text += _chunk; });
+        return text;
+    };
+
+    // The snapshot follows the selected lines into the history, and outlives the selection.
+    mock.terminal().setSelector(nullptr);
+    mock.writeToStdout("\r\nfour\r\nfive");
+    CHECK(!mock.terminal().selectionAvailable());
+    CHECK(extract() == "two\nthree");
+
+    // Nothing is extracted from another screen.
+    mock.writeToStdout("\033[?1049h");
+    CHECK(extract().empty());
+}
+
+TEST_CASE("Terminal.WordDelimited", "[terminal]")
+{
+    auto mock = MockTerm { ColumnCount(12), LineCount(2) };
+    mock.terminal().setWordDelimiters(" ,");
+    mock.writeToStdout("foo,bar baz");
+
+    auto const& helper = mock.terminal().selectionHelper();
+    auto const delimited = [&](int _column) {
+        return helper.wordDelimited(terminal::CellLocation { LineOffset(0), ColumnOffset(_column) });
+    };
+    CHECK(!delimited(0));
+    CHECK(delimited(3));
+    CHECK(!delimited(4));
+    CHECK(delimited(7));
+    CHECK(delimited(11));
+
+    auto selection = make_unique<terminal::WordWiseSelection>(
+        helper, terminal::CellLocation { LineOffset(0), ColumnOffset(5) });
+    selection->complete();
+    mock.terminal().setSelector(move(selection));
+    CHECK(mock.terminal().extractSelectionText() == "bar");
+
+    // Cached classifications follow changes to the line and to the delimiters.
+    mock.writeToStdout("\rfoobar");
+    CHECK(!delimited(3));
+    mock.terminal().setWordDelimiters("b ");
+    CHECK(delimited(3));
+}
+
+TEST_CASE("Terminal.HintMode", "[terminal]")
+{
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    auto mock = MockTerm { ColumnCount(20), LineCount(2) };
+    mock.writeToStdout("see https://a.io\r\nrev 51e4743");
+    auto& terminal = mock.terminal();
+
+    // The label's characters yet to be typed are drawn on top of the start of each hint.
+    auto const labelAt = [&](int _second, int _line, int _column) {
+        terminal.tick(ClockBase + chrono::seconds(_second));
+        terminal.ensureFreshRenderBuffer();
+        auto text = u32string {};
+        for (terminal::RenderCell const& cell: terminal.renderBuffer().get().cells)
+            if (cell.position == terminal::CellLocation { LineOffset(_line), ColumnOffset(_column) }
+                && cell.backgroundColor == terminal.colorPalette().normalColor(3))
+                text = cell.codepoints;
+        return unicode::convert_to<char>(u32string_view(text));
+    };
+
+    REQUIRE(terminal.startHintMode());
+    REQUIRE(terminal.hintMode());
+    CHECK(terminal.hintMode()->labels == vector<string> { "a", "s" });
+    CHECK(labelAt(1, 0, 4) == "a");
+    CHECK(labelAt(2, 1, 4) == "s");
+
+    // Input that picks no hint goes nowhere, neither to the application.
+    terminal.sendCharPressEvent('x', terminal::Modifier {}, ClockBase);
+    terminal.sendKeyPressEvent(terminal::Key::DownArrow, terminal::Modifier {}, ClockBase);
+    REQUIRE(terminal.hintMode());
+    CHECK(terminal.hintMode()->typed.empty());
+
+    terminal.sendCharPressEvent('s', terminal::Modifier {}, ClockBase);
+    CHECK(!terminal.hintMode());
+    REQUIRE(mock.pickedHints.size() == 1);
+    CHECK(mock.pickedHints[0].kind == terminal::HintKind::GitHash);
+    CHECK(mock.pickedHints[0].text == "51e4743");
+    CHECK(labelAt(3, 1, 4).empty());
+
+    // Escape leaves hint mode without picking a hint.
+    REQUIRE(terminal.startHintMode());
+    terminal.sendCharPressEvent(0x1B, terminal::Modifier {}, ClockBase);
+    CHECK(!terminal.hintMode());
+    CHECK(mock.pickedHints.size() == 1);
+    CHECK(mock.replyData().empty());
+}
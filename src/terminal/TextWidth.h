@@ -0,0 +1,55 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/CodepointProperties.h>
+
+#include <cstdint>
+#include <string_view>
+
+namespace terminal
+{
+
+namespace detail
+{
+    /// Tests whether @p _codepoint is of the most common wide scripts: CJK ideographs,
+    /// Hangul syllables, Hiragana or Katakana.
+    constexpr bool isCommonWide(char32_t _codepoint) noexcept
+    {
+        return (0x4E00 <= _codepoint && _codepoint <= 0x9FA5)
+               || (0xAC00 <= _codepoint && _codepoint <= 0xD7A3)
+               || (0x3041 <= _codepoint && _codepoint <= 0x3096)
+               || (0x30A1 <= _codepoint && _codepoint <= 0x30FA);
+    }
+} // namespace detail
+
+/// Looks up the width in grid cells of each of @p _codepoints into @p _widths,
+/// which must have room for as many, just as unicode::width() does.
+///
+/// Printable US-ASCII and the most common wide scripts are recognized by their ranges,
+/// and anything else is looked up in the CodepointProperties table.
+inline void codepointWidths(std::u32string_view _codepoints, uint8_t* _widths)
+{
+    for (char32_t const codepoint: _codepoints)
+    {
+        if (0x20 <= codepoint && codepoint < 0x7F)
+            *_widths++ = 1;
+        else if (detail::isCommonWide(codepoint))
+            *_widths++ = 2;
+        else
+            *_widths++ = static_cast<uint8_t>(CodepointProperties::width(codepoint));
+    }
+}
+
+} // namespace terminal
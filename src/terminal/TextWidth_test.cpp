@@ -0,0 +1,46 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/TextWidth.h>
+
+#include <unicode/width.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace terminal;
+
+TEST_CASE("codepointWidths.agrees_with_libunicode", "[unicode]")
+{
+    // All codepoints recognized by their ranges and their surroundings, and some others.
+    auto text = std::u32string {};
+    for (auto const [first, last]: { std::pair { 0x20, 0x100 },
+                                     std::pair { 0x3000, 0x3100 },
+                                     std::pair { 0x4DF0, 0x9FB0 },
+                                     std::pair { 0xABF0, 0xD7B0 } })
+        for (auto codepoint = first; codepoint < last; ++codepoint)
+            text += static_cast<char32_t>(codepoint);
+    text += U"\u0301\u200D\u2764\U0001F600";
+
+    auto widths = std::vector<uint8_t>(text.size());
+    codepointWidths(text, widths.data());
+
+    auto mismatches = std::vector<uint32_t> {};
+    for (size_t i = 0; i < text.size(); ++i)
+        if (widths[i] != static_cast<uint8_t>(unicode::width(text[i])))
+            mismatches.push_back(static_cast<uint32_t>(text[i]));
+    CHECK(mismatches.empty());
+}
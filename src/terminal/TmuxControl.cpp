@@ -0,0 +1,487 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/TmuxControl.h>
+#include <terminal/logging.h>
+
+#include <crispy/utils.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <set>
+
+using namespace std;
+
+namespace terminal
+{
+
+namespace
+{
+    /// Parses an unsigned decimal number off the front of @p _text.
+    optional<unsigned> consumeNumber(string_view& _text) noexcept
+    {
+        auto value = 0u;
+        auto const [end, ec] = std::from_chars(_text.data(), _text.data() + _text.size(), value);
+        if (ec != std::errc {})
+            return nullopt;
+        _text.remove_prefix(static_cast<size_t>(end - _text.data()));
+        return value;
+    }
+
+    bool consume(string_view& _text, char _ch) noexcept
+    {
+        if (_text.empty() || _text.front() != _ch)
+            return false;
+        _text.remove_prefix(1);
+        return true;
+    }
+
+    /// Parses an ID such as "%3" (pane), "@1" (window), or "$0" (session).
+    optional<unsigned> parseId(string_view _text, char _sigil) noexcept
+    {
+        if (!consume(_text, _sigil))
+            return nullopt;
+        return consumeNumber(_text);
+    }
+
+    /// Splits off the first space separated word of @p _text.
+    string_view nextWord(string_view& _text) noexcept
+    {
+        auto const end = _text.find(' ');
+        auto const word = _text.substr(0, end);
+        _text.remove_prefix(end == string_view::npos ? _text.size() : end + 1);
+        return word;
+    }
+
+    /// @returns the command setting the size of the tmux client.
+    string refreshClientCommand(PageSize _size)
+    {
+        return fmt::format("refresh-client -C {},{}\n", unbox<int>(_size.columns), unbox<int>(_size.lines));
+    }
+
+    /// Largest width or height of a window tmux supports.
+    constexpr unsigned MaxLayoutExtent = 10000;
+
+    /// Parses a width, height, or position of a layout cell off the front of @p _text.
+    optional<unsigned> consumeExtent(string_view& _text) noexcept
+    {
+        auto const value = consumeNumber(_text);
+        if (!value || *value > MaxLayoutExtent)
+            return nullopt;
+        return value;
+    }
+
+    // cell := WxH,X,Y(,ID | {cells} | [cells])
+    optional<TmuxLayout> parseLayoutCell(string_view& _text)
+    {
+        auto layout = TmuxLayout {};
+        auto const width = consumeExtent(_text);
+        if (!width || !*width || !consume(_text, 'x'))
+            return nullopt;
+        auto const height = consumeExtent(_text);
+        if (!height || !*height || !consume(_text, ','))
+            return nullopt;
+        auto const x = consumeExtent(_text);
+        if (!x || !consume(_text, ','))
+            return nullopt;
+        auto const y = consumeExtent(_text);
+        if (!y)
+            return nullopt;
+
+        layout.size = PageSize { LineCount::cast_from(*height), ColumnCount::cast_from(*width) };
+        layout.column = ColumnOffset::cast_from(*x);
+        layout.line = LineOffset::cast_from(*y);
+
+        if (consume(_text, ','))
+        {
+            auto const pane = consumeNumber(_text);
+            if (!pane)
+                return nullopt;
+            layout.pane = *pane;
+            return layout;
+        }
+
+        auto const close = consume(_text, '{') ? '}' : consume(_text, '[') ? ']' : '\0';
+        if (!close)
+            return nullopt;
+        layout.split = close == '}' ? TmuxLayout::Split::Horizontal : TmuxLayout::Split::Vertical;
+        do
+        {
+            auto child = parseLayoutCell(_text);
+            if (!child)
+                return nullopt;
+            layout.children.emplace_back(move(*child));
+        } while (consume(_text, ','));
+
+        if (!consume(_text, close))
+            return nullopt;
+        return layout;
+    }
+} // namespace
+
+optional<TmuxLayout> parseTmuxLayout(string_view _text)
+{
+    // The layout is preceded by a checksum of four hex digits.
+    auto const comma = _text.find(',');
+    if (comma == string_view::npos)
+        return nullopt;
+    _text.remove_prefix(comma + 1);
+
+    auto layout = parseLayoutCell(_text);
+    if (!layout || !_text.empty())
+        return nullopt;
+    return layout;
+}
+
+// {{{ TmuxControlParser
+void TmuxControlParser::parse(string_view _data)
+{
+    while (!_data.empty())
+    {
+        auto const lineFeed = _data.find('\n');
+        if (lineFeed == string_view::npos)
+        {
+            line_.append(_data);
+            return;
+        }
+
+        auto line = _data.substr(0, lineFeed);
+        _data.remove_prefix(lineFeed + 1);
+        if (!line_.empty())
+        {
+            line_.append(line);
+            line = line_;
+        }
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        parseLine(line);
+        line_.clear();
+    }
+}
+
+void TmuxControlParser::parseLine(string_view _line)
+{
+    if (inBlock_)
+    {
+        // Output of commands is passed as is, only lines starting with %end or %error end it.
+        auto const word = _line.substr(0, _line.find(' '));
+        auto const end = word == "%end";
+        if (!end && word != "%error")
+        {
+            block_.append(_line);
+            block_ += '\n';
+            return;
+        }
+
+        inBlock_ = false;
+        events_.commandCompleted(block_, end);
+        block_.clear();
+        return;
+    }
+
+    auto const name = nextWord(_line);
+    if (name == "%begin")
+    {
+        inBlock_ = true;
+        block_.clear();
+    }
+    else if (name == "%output")
+    {
+        if (auto const pane = parseId(nextWord(_line), '%'))
+            events_.paneOutput(*pane, unescape(_line));
+    }
+    else if (name == "%extended-output")
+    {
+        // %extended-output %pane age ... : data
+        auto const pane = parseId(nextWord(_line), '%');
+        auto const separator = _line.find(" : ");
+        if (pane && separator != string_view::npos)
+            events_.paneOutput(*pane, unescape(_line.substr(separator + 3)));
+    }
+    else if (name == "%window-add")
+    {
+        if (auto const window = parseId(nextWord(_line), '@'))
+            events_.windowAdded(*window);
+    }
+    else if (name == "%window-close" || name == "%unlinked-window-close")
+    {
+        if (auto const window = parseId(nextWord(_line), '@'))
+            events_.windowClosed(*window);
+    }
+    else if (name == "%window-renamed")
+    {
+        if (auto const window = parseId(nextWord(_line), '@'))
+            events_.windowRenamed(*window, _line);
+    }
+    else if (name == "%layout-change")
+    {
+        auto const window = parseId(nextWord(_line), '@');
+        auto const layout = parseTmuxLayout(nextWord(_line));
+        if (window && layout)
+            events_.layoutChanged(*window, *layout);
+    }
+    else if (name == "%session-changed")
+    {
+        if (auto const session = parseId(nextWord(_line), '$'))
+            events_.sessionChanged(*session, _line);
+    }
+    else if (name == "%exit")
+        events_.exited(_line);
+}
+
+string_view TmuxControlParser::unescape(string_view _text)
+{
+    // Pane output escapes backslashes and characters below 0x20 in octal (\ooo).
+    if (_text.find('\\') == string_view::npos)
+        return _text;
+
+    unescaped_.clear();
+    for (size_t i = 0; i < _text.size(); ++i)
+    {
+        if (_text[i] == '\\' && _text.size() - i > 3)
+        {
+            auto const digits = _text.substr(i + 1, 3);
+            if (all_of(digits.begin(), digits.end(), [](char ch) { return '0' <= ch && ch <= '7'; }))
+            {
+                unescaped_ += static_cast<char>(((digits[0] - '0') << 6) | ((digits[1] - '0') << 3)
+                                                | (digits[2] - '0'));
+                i += 3;
+                continue;
+            }
+        }
+        unescaped_ += _text[i];
+    }
+    return unescaped_;
+}
+// }}}
+
+// {{{ TmuxSession
+TmuxSession::TmuxSession(Writer _writer, LineCount _maxHistoryLineCount):
+    writer_ { move(_writer) }, maxHistoryLineCount_ { _maxHistoryLineCount }, parser_ { *this }
+{
+}
+
+TmuxSession::~TmuxSession() = default;
+
+void TmuxSession::start()
+{
+    auto const _l = lock_guard { commandLock_ };
+    if (started_)
+        return;
+
+    started_ = true;
+    send(refreshClientCommand(size_), {});
+    for (auto& [line, done]: heldBackCommands_)
+        send(move(line), move(done));
+    heldBackCommands_.clear();
+}
+
+void TmuxSession::command(string_view _command, CommandCallback _done)
+{
+    // Commands are sent by the terminal thread, and by whichever thread writes input to a pane.
+    auto const _l = lock_guard { commandLock_ };
+    if (started_)
+        send(fmt::format("{}\n", _command), move(_done));
+    else
+        heldBackCommands_.emplace_back(fmt::format("{}\n", _command), move(_done));
+}
+
+void TmuxSession::send(string _line, CommandCallback _done)
+{
+    pendingCommands_.emplace_back(move(_done));
+    writer_(_line);
+}
+
+void TmuxSession::sendInput(unsigned _pane, string_view _input)
+{
+    // Nothing can have been typed into panes not displayed yet, so this would only be the replies
+    // of the panes' terminals to their output, which has been answered by tmux already.
+    {
+        auto const _l = lock_guard { commandLock_ };
+        if (!started_)
+            return;
+    }
+
+    // Keys are sent as hexadecimal bytes (send-keys -H), which need no quoting whatsoever.
+    auto constexpr MaxBytesPerCommand = size_t { 256 };
+    while (!_input.empty())
+    {
+        auto const chunk = _input.substr(0, MaxBytesPerCommand);
+        _input.remove_prefix(chunk.size());
+
+        auto line = fmt::format("send-keys -t %{} -H", _pane);
+        for (char const ch: chunk)
+            line += fmt::format(" {:02x}", static_cast<uint8_t>(ch));
+        command(line);
+    }
+}
+
+void TmuxSession::resize(PageSize _size)
+{
+    auto const _l = lock_guard { commandLock_ };
+    size_ = _size;
+    if (started_)
+        send(refreshClientCommand(_size), {});
+}
+
+Terminal* TmuxSession::pane(unsigned _pane) noexcept
+{
+    auto const i = panes_.find(_pane);
+    return i != panes_.end() ? i->second.get() : nullptr;
+}
+
+vector<unsigned> TmuxSession::panes() const
+{
+    auto result = vector<unsigned> {};
+    for (auto const& [id, _]: panes_)
+        result.push_back(id);
+    return result;
+}
+
+void TmuxSession::paneOutput(unsigned _pane, string_view _data)
+{
+    if (auto* terminal = pane(_pane))
+        terminal->writeToScreen(_data);
+}
+
+void TmuxSession::commandCompleted(string_view _output, bool _success)
+{
+    // Blocks not answering any of our commands (such as the initial one of tmux -CC) are ignored.
+    auto done = CommandCallback {};
+    {
+        auto const _l = lock_guard { commandLock_ };
+        if (pendingCommands_.empty())
+            return;
+        done = move(pendingCommands_.front());
+        pendingCommands_.pop_front();
+    }
+    if (done)
+        done(_output, _success);
+}
+
+void TmuxSession::windowClosed(unsigned _window)
+{
+    windows_.erase(_window);
+    removeUnusedPanes();
+}
+
+void TmuxSession::layoutChanged(unsigned _window, TmuxLayout const& _layout)
+{
+    applyLayout(_window, _layout);
+    removeUnusedPanes();
+}
+
+void TmuxSession::sessionChanged(unsigned /*_session*/, string_view /*_name*/)
+{
+    windows_.clear();
+    command("list-windows -F \"#{window_id} #{window_layout}\"", [this](string_view _output, bool _success) {
+        if (!_success)
+            return;
+        for (auto const line: crispy::split(_output, '\n'))
+        {
+            auto rest = line;
+            auto const window = parseId(nextWord(rest), '@');
+            auto const layout = parseTmuxLayout(rest);
+            if (window && layout)
+                applyLayout(*window, *layout);
+        }
+        removeUnusedPanes();
+    });
+}
+
+void TmuxSession::exited(string_view _reason)
+{
+    TerminalLog()("tmux control mode exited. {}", _reason);
+    exited_ = true;
+}
+
+void TmuxSession::applyLayout(unsigned _window, TmuxLayout _layout)
+{
+    _layout.forEachPane([this](TmuxLayout const& _pane) {
+        // tmux lays out its windows for the size of the client, which the panes are kept within.
+        auto const size = PageSize { max(LineCount(1), min(_pane.size.lines, size_.lines)),
+                                     max(ColumnCount(1), min(_pane.size.columns, size_.columns)) };
+        if (auto* terminal = pane(_pane.pane))
+        {
+            if (terminal->pageSize() != size)
+                terminal->resizeScreen(size);
+        }
+        else
+            addPane(_pane.pane, size);
+    });
+    windows_[_window] = move(_layout);
+}
+
+void TmuxSession::addPane(unsigned _pane, PageSize _size)
+{
+    auto constexpr BufferObjectSize = size_t { 64 * 1024 };
+    auto& terminal = panes_[_pane];
+    terminal = make_unique<Terminal>(make_unique<PanePty>(*this, _pane, _size),
+                                     BufferObjectSize,
+                                     BufferObjectSize,
+                                     static_cast<Terminal::Events&>(*this),
+                                     maxHistoryLineCount_);
+
+    // The pane's history and screen are fetched once, as physical lines along with their SGRs.
+    // Any output following is reported by tmux after the command's output.
+    command(fmt::format("capture-pane -p -e -S - -t %{}", _pane), [this, _pane](string_view _output, bool) {
+        if (auto* terminal = pane(_pane))
+        {
+            if (!_output.empty() && _output.back() == '\n')
+                _output.remove_suffix(1);
+            auto screen = string {};
+            for (auto const line: crispy::split(_output, '\n'))
+            {
+                if (!screen.empty())
+                    screen += "\r\n";
+                screen.append(line.data(), line.size());
+            }
+            terminal->writeToScreen(screen);
+        }
+    });
+    command(fmt::format("display-message -p -t %{} \"#{{cursor_y}} #{{cursor_x}}\"", _pane),
+            [this, _pane](string_view _output, bool _success) {
+                auto* terminal = pane(_pane);
+                auto const line = consumeNumber(_output);
+                auto const column = consume(_output, ' ') ? consumeNumber(_output) : nullopt;
+                if (terminal && _success && line && column)
+                    terminal->writeToScreen(fmt::format("\033[{};{}H", *line + 1, *column + 1));
+            });
+}
+
+void TmuxSession::removeUnusedPanes()
+{
+    auto used = set<unsigned> {};
+    for (auto const& [_, layout]: windows_)
+        layout.forEachPane([&](TmuxLayout const& _pane) { used.insert(_pane.pane); });
+
+    for (auto i = panes_.begin(); i != panes_.end();)
+    {
+        if (used.count(i->first))
+            ++i;
+        else
+            i = panes_.erase(i);
+    }
+}
+
+int TmuxSession::PanePty::write(char const* _buf, size_t _size)
+{
+    session_.sendInput(pane_, string_view(_buf, _size));
+    return static_cast<int>(_size);
+}
+// }}}
+
+} // namespace terminal
@@ -0,0 +1,199 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/ParserExtension.h>
+#include <terminal/Terminal.h>
+#include <terminal/primitives.h>
+#include <terminal/pty/MockPty.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace terminal
+{
+
+/// The arrangement of a tmux window's panes, as reported by tmux (e.g. `b25d,80x24,0,0,1`).
+struct TmuxLayout
+{
+    enum class Split
+    {
+        None,       ///< A single pane.
+        Horizontal, ///< Children side by side, left to right.
+        Vertical,   ///< Children stacked, top to bottom.
+    };
+
+    PageSize size {};
+    ColumnOffset column {};
+    LineOffset line {};
+    Split split = Split::None;
+    unsigned pane = 0; ///< The pane's ID, if this is a single pane.
+    std::vector<TmuxLayout> children {};
+
+    /// Invokes @p _callback with every single pane of this layout.
+    template <typename Callback>
+    void forEachPane(Callback&& _callback) const
+    {
+        if (split == Split::None)
+            _callback(*this);
+        for (TmuxLayout const& child: children)
+            child.forEachPane(_callback);
+    }
+};
+
+/// Parses a tmux layout string, including its leading checksum.
+std::optional<TmuxLayout> parseTmuxLayout(std::string_view _text);
+
+/// Incrementally parses the output of a tmux client in control mode (tmux -CC).
+///
+/// Output is line based: notifications start with a '%', and the output of commands
+/// is enclosed in %begin and %end (or %error) lines.
+class TmuxControlParser
+{
+  public:
+    class Events
+    {
+      public:
+        virtual ~Events() = default;
+
+        /// Output of a pane, with tmux's escaping undone.
+        virtual void paneOutput(unsigned _pane, std::string_view _data) = 0;
+
+        /// The output of a command, in the order the commands were sent.
+        virtual void commandCompleted(std::string_view /*_output*/, bool /*_success*/) {}
+
+        virtual void windowAdded(unsigned /*_window*/) {}
+        virtual void windowClosed(unsigned /*_window*/) {}
+        virtual void windowRenamed(unsigned /*_window*/, std::string_view /*_name*/) {}
+        virtual void layoutChanged(unsigned /*_window*/, TmuxLayout const& /*_layout*/) {}
+        virtual void sessionChanged(unsigned /*_session*/, std::string_view /*_name*/) {}
+        virtual void exited(std::string_view /*_reason*/) {}
+    };
+
+    explicit TmuxControlParser(Events& _events): events_ { _events } {}
+
+    void parse(std::string_view _data);
+
+  private:
+    void parseLine(std::string_view _line);
+    std::string_view unescape(std::string_view _text);
+
+    Events& events_;
+    std::string line_;
+    std::string block_;
+    std::string unescaped_;
+    bool inBlock_ = false;
+};
+
+/// A tmux client in control mode, routing the output of each tmux pane into a Terminal of its own.
+///
+/// Panes are created and resized as tmux reports the layouts of its windows. When a pane is
+/// created, its history and screen contents are fetched from tmux once, so that scrolling
+/// is served by the pane's Grid rather than tmux's copy mode. Input to the panes is sent to tmux
+/// as commands.
+///
+/// No commands are sent to tmux before start() is called by whoever displays the panes.
+class TmuxSession: private TmuxControlParser::Events, private Terminal::Events
+{
+  public:
+    /// Sends a command line to tmux, i.e. writes it to the application side of the controlling terminal.
+    using Writer = std::function<void(std::string_view)>;
+    using CommandCallback = std::function<void(std::string_view /*output*/, bool /*success*/)>;
+
+    TmuxSession(Writer _writer, LineCount _maxHistoryLineCount);
+    ~TmuxSession() override;
+
+    TmuxSession(TmuxSession const&) = delete;
+    TmuxSession& operator=(TmuxSession const&) = delete;
+
+    /// Processes output of the tmux client.
+    void parse(std::string_view _data) { parser_.parse(_data); }
+
+    /// Starts talking to tmux, sending the client's size and the commands issued so far.
+    void start();
+
+    /// Sends a command to tmux, invoking @p _done with its output once completed.
+    ///
+    /// Commands issued before start() are held back until then.
+    void command(std::string_view _command, CommandCallback _done = {});
+
+    /// Sends the given input to a pane, as if typed. Input before start() is discarded.
+    void sendInput(unsigned _pane, std::string_view _input);
+
+    /// Sets the size of the tmux client, which all windows are laid out for.
+    ///
+    /// Panes never exceed this size, regardless of the layouts reported by tmux.
+    void resize(PageSize _size);
+
+    /// @returns the terminal of the given pane, or nullptr if there is no such pane.
+    [[nodiscard]] Terminal* pane(unsigned _pane) noexcept;
+
+    [[nodiscard]] std::vector<unsigned> panes() const;
+
+    /// The layout of each window, by window ID.
+    [[nodiscard]] std::map<unsigned, TmuxLayout> const& windows() const noexcept { return windows_; }
+
+    [[nodiscard]] bool exited() const noexcept { return exited_; }
+
+  private:
+    // TmuxControlParser::Events
+    void paneOutput(unsigned _pane, std::string_view _data) override;
+    void commandCompleted(std::string_view _output, bool _success) override;
+    void windowClosed(unsigned _window) override;
+    void layoutChanged(unsigned _window, TmuxLayout const& _layout) override;
+    void sessionChanged(unsigned _session, std::string_view _name) override;
+    void exited(std::string_view _reason) override;
+
+    void send(std::string _line, CommandCallback _done);
+    void applyLayout(unsigned _window, TmuxLayout _layout);
+    void addPane(unsigned _pane, PageSize _size);
+    void removeUnusedPanes();
+
+    /// Forwards the input written by the pane's terminal to tmux.
+    class PanePty: public MockPty
+    {
+      public:
+        PanePty(TmuxSession& _session, unsigned _pane, PageSize _size):
+            MockPty { _size }, session_ { _session }, pane_ { _pane }
+        {
+        }
+
+        int write(char const* _buf, size_t _size) override;
+
+      private:
+        TmuxSession& session_;
+        unsigned pane_;
+    };
+
+    Writer writer_;
+    LineCount maxHistoryLineCount_;
+    TmuxControlParser parser_;
+    std::mutex commandLock_;
+    bool started_ = false;
+    PageSize size_ { LineCount(1), ColumnCount(1) };
+    std::vector<std::pair<std::string, CommandCallback>> heldBackCommands_; // issued before start()
+    std::deque<CommandCallback> pendingCommands_;
+    std::map<unsigned, TmuxLayout> windows_;
+    std::map<unsigned, std::unique_ptr<Terminal>> panes_;
+    bool exited_ = false;
+};
+
+} // namespace terminal
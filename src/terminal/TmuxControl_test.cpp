@@ -0,0 +1,149 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/TmuxControl.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace terminal;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace
+{
+
+struct RecordingEvents: TmuxControlParser::Events
+{
+    vector<string> events;
+
+    void paneOutput(unsigned _pane, string_view _data) override
+    {
+        events.emplace_back("output " + std::to_string(_pane) + ": " + string(_data));
+    }
+
+    void commandCompleted(string_view _output, bool _success) override
+    {
+        events.emplace_back((_success ? "done: " : "failed: ") + string(_output));
+    }
+
+    void layoutChanged(unsigned _window, TmuxLayout const& _layout) override
+    {
+        events.emplace_back("layout " + std::to_string(_window) + ": "
+                            + std::to_string(_layout.children.size()));
+    }
+
+    void exited(string_view _reason) override { events.emplace_back("exit: " + string(_reason)); }
+};
+
+} // namespace
+
+TEST_CASE("TmuxLayout.parse", "[tmux]")
+{
+    auto const layout = parseTmuxLayout("b25d,80x24,0,0{40x24,0,0,1,39x24,41,0[39x12,41,0,2,39x11,41,13,3]}");
+    REQUIRE(layout.has_value());
+    CHECK(layout->split == TmuxLayout::Split::Horizontal);
+    CHECK(layout->size == PageSize { LineCount(24), ColumnCount(80) });
+    REQUIRE(layout->children.size() == 2);
+    CHECK(layout->children[1].split == TmuxLayout::Split::Vertical);
+
+    auto panes = vector<unsigned> {};
+    layout->forEachPane([&](TmuxLayout const& _pane) { panes.push_back(_pane.pane); });
+    CHECK(panes == vector<unsigned> { 1, 2, 3 });
+
+    auto const& bottomRight = layout->children[1].children[1];
+    CHECK(bottomRight.size == PageSize { LineCount(11), ColumnCount(39) });
+    CHECK(bottomRight.column == ColumnOffset(41));
+    CHECK(bottomRight.line == LineOffset(13));
+
+    CHECK(parseTmuxLayout("a0b1,80x24,0,0,7")->pane == 7);
+    CHECK(!parseTmuxLayout("b25d,80x24,0,0{40x24,0,0,1"));
+    CHECK(!parseTmuxLayout("80x24"));
+
+    // Sizes are within what tmux supports.
+    CHECK(!parseTmuxLayout("a0b1,0x24,0,0,7"));
+    CHECK(!parseTmuxLayout("a0b1,80x4294967295,0,0,7"));
+    CHECK(!parseTmuxLayout("a0b1,80x24,10001,0,7"));
+}
+
+TEST_CASE("TmuxControlParser", "[tmux]")
+{
+    auto events = RecordingEvents {};
+    auto parser = TmuxControlParser(events);
+
+    // Lines may be split anywhere, and end in CR LF when passed through a TTY.
+    parser.parse("%begin 1 1 0\r\n%end 1 1 0\r\n%output %1 a\\033[1mb\\134c\\015");
+    parser.parse("\\012\r\n%begin 1 2 1\nfirst\n%error 1 2 1\n%begin 1 3 1\n%output in block\n%end 1 3 1\n");
+    parser.parse("%layout-change @2 b25d,80x24,0,0{40x24,0,0,1,39x24,41,0,2} b25d,80x24,0,0,1 *\n");
+    parser.parse("%unknown-notification\n%exit detached\n");
+
+    CHECK(events.events
+          == vector<string> {
+              "done: ",
+              "output 1: a\033[1mb\\c\r\n",
+              "failed: first\n",
+              "done: %output in block\n",
+              "layout 2: 2",
+              "exit: detached",
+          });
+}
+
+TEST_CASE("TmuxSession", "[tmux]")
+{
+    auto commands = vector<string> {};
+    auto session =
+        TmuxSession([&](string_view _command) { commands.emplace_back(_command); }, LineCount(100));
+    session.resize(PageSize { LineCount(10), ColumnCount(40) });
+
+    // The block answering the attach command of tmux -CC itself is ignored.
+    session.parse("%begin 1 1 0\n%end 1 1 0\n%session-changed $0 main\n");
+
+    // Nothing is sent until the session is started.
+    session.sendInput(1, "x");
+    CHECK(commands.empty());
+    session.start();
+    REQUIRE(commands
+            == vector<string> {
+                "refresh-client -C 40,10\n",
+                "list-windows -F \"#{window_id} #{window_layout}\"\n",
+            });
+    session.parse("%begin 1 2 1\n%end 1 2 1\n");
+
+    session.parse("%begin 1 3 1\n@1 a0b1,20x5,0,0,3\n%end 1 3 1\n");
+    REQUIRE(session.panes() == vector<unsigned> { 3 });
+    auto* pane = session.pane(3);
+    REQUIRE(pane != nullptr);
+    CHECK(pane->pageSize() == PageSize { LineCount(5), ColumnCount(20) });
+    REQUIRE(commands.size() == 4);
+    CHECK(commands[2] == "capture-pane -p -e -S - -t %3\n");
+    CHECK(commands[3] == "display-message -p -t %3 \"#{cursor_y} #{cursor_x}\"\n");
+
+    // The captured contents, the cursor position, and the pane's output following these.
+    session.parse("%begin 1 4 1\nhello\n%end 1 4 1\n%begin 1 5 1\n0 5\n%end 1 5 1\n");
+    session.parse("%output %3 \\033[1mworld\\015\\012\n");
+    CHECK(pane->primaryScreen().grid().lineTextTrimmed(LineOffset(0)) == "helloworld");
+
+    session.sendInput(3, "ls\r");
+    CHECK(commands.back() == "send-keys -t %3 -H 6c 73 0d\n");
+
+    // Panes are kept within the client's size.
+    session.parse("%layout-change @1 a0b1,90x50,0,0,3\n");
+    CHECK(pane->pageSize() == PageSize { LineCount(10), ColumnCount(40) });
+
+    session.parse("%window-close @1\n");
+    CHECK(session.panes().empty());
+    CHECK(session.pane(3) == nullptr);
+}
@@ -13,6 +13,7 @@
  */
 #include <terminal/VTWriter.h>
 
+#include <algorithm>
 #include <numeric>
 
 using std::string;
@@ -22,8 +23,6 @@ using std::vector;
 namespace terminal
 {
 
-// TODO: compare with old sgr value set instead to be more generic in reusing stuff
-
 VTWriter::VTWriter(Writer writer): writer_ { std::move(writer) }
 {
 }
@@ -63,8 +62,7 @@ void VTWriter::sgrFlush()
         return;
 
     auto const f = sgrFlush(sgr_);
-    if (sgr_ != lastSGR_)
-        writer_(f.data(), f.size());
+    writer_(f.data(), f.size());
 
     sgrRewind();
 }
@@ -89,6 +87,7 @@ void VTWriter::sgrAddExplicit(unsigned n)
 {
     if (n == 0)
     {
+        currentBold_ = false;
         currentForegroundColor_ = DefaultColor();
         currentBackgroundColor_ = DefaultColor();
         currentUnderlineColor_ = DefaultColor();
@@ -103,6 +102,7 @@ void VTWriter::sgrAdd(unsigned n)
     {
         sgr_.clear();
         sgr_.push_back(n);
+        currentBold_ = false;
         currentForegroundColor_ = DefaultColor();
         currentBackgroundColor_ = DefaultColor();
         currentUnderlineColor_ = DefaultColor();
@@ -121,7 +121,6 @@ void VTWriter::sgrAdd(unsigned n)
 
 void VTWriter::sgrRewind()
 {
-    swap(lastSGR_, sgr_);
     sgr_.clear();
 }
 
@@ -132,8 +131,8 @@ void VTWriter::sgrAdd(GraphicsRendition m)
 
 void VTWriter::setForegroundColor(Color _color)
 {
-    // if (_color == currentForegroundColor_)
-    //     return;
+    if (_color == currentForegroundColor_)
+        return;
 
     currentForegroundColor_ = _color;
     switch (_color.type())
@@ -165,8 +164,8 @@ void VTWriter::setForegroundColor(Color _color)
 
 void VTWriter::setBackgroundColor(Color _color)
 {
-    // if (_color == currentBackgroundColor_)
-    //     return;
+    if (_color == currentBackgroundColor_)
+        return;
 
     currentBackgroundColor_ = _color;
     switch (_color.type())
@@ -176,22 +175,18 @@ void VTWriter::setBackgroundColor(Color _color)
             if (static_cast<unsigned>(_color.index()) < 8)
                 sgrAdd(40 + static_cast<unsigned>(_color.index()));
             else
-            {
-                sgrAdd(48);
-                sgrAdd(5);
-                sgrAdd(static_cast<unsigned>(_color.index()));
-            }
+                sgrAdd(48, 5, static_cast<unsigned>(_color.index()));
             break;
         case ColorType::Bright:
             //.
             sgrAdd(100 + static_cast<unsigned>(getBrightColor(_color)));
             break;
         case ColorType::RGB:
-            sgrAdd(48);
-            sgrAdd(2);
-            sgrAdd(static_cast<unsigned>(_color.rgb().red));
-            sgrAdd(static_cast<unsigned>(_color.rgb().green));
-            sgrAdd(static_cast<unsigned>(_color.rgb().blue));
+            // clang-format off
+            sgrAdd(48, 2, static_cast<unsigned>(_color.rgb().red),
+                          static_cast<unsigned>(_color.rgb().green),
+                          static_cast<unsigned>(_color.rgb().blue));
+            // clang-format on
             break;
         case ColorType::Undefined:
             //.
@@ -199,38 +194,89 @@ void VTWriter::setBackgroundColor(Color _color)
     }
 }
 
+void VTWriter::setBold(bool _enabled)
+{
+    if (_enabled == currentBold_)
+        return;
+
+    currentBold_ = _enabled;
+    sgrAdd(_enabled ? GraphicsRendition::Bold : GraphicsRendition::Normal);
+}
+
+void VTWriter::writeRepeated(string_view text, size_t count)
+{
+    if (count >= MinRepeatCount)
+    {
+        write(text);
+        write("\033[{}b", count - 1);
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+            write(text);
+    }
+}
+
 template <typename Cell>
 void VTWriter::write(Line<Cell> const& line)
 {
     if (line.isTrivialBuffer())
     {
         TriviallyStyledLineBuffer const& lineBuffer = line.trivialBuffer();
+        setBold(lineBuffer.attributes.styles & CellFlags::Bold);
         setForegroundColor(lineBuffer.attributes.foregroundColor);
         setBackgroundColor(lineBuffer.attributes.backgroundColor);
         // TODO: hyperlinks, underlineColor and other styles (curly underline etc.)
-        write(line.toUtf8());
+        write(string_view(lineBuffer.text.data(), lineBuffer.text.size()));
+
+        // Trailing blanks only need to be written when they are visible.
+        if (!isDefaultColor(lineBuffer.attributes.backgroundColor))
+            writeRepeated(" ", unbox<size_t>(lineBuffer.displayWidth - lineBuffer.usedColumns));
     }
     else
     {
-        for (Cell const& cell: line.inflatedBuffer())
-        {
-            if (cell.styles() & CellFlags::Bold)
-                sgrAdd(GraphicsRendition::Bold);
-            else
-                sgrAdd(GraphicsRendition::Normal);
+        auto const& cells = line.inflatedBuffer();
+
+        auto const isInvisible = [](Cell const& cell) {
+            return !cell.codepointCount() && isDefaultColor(cell.backgroundColor());
+        };
+        auto end = cells.size();
+        while (end > 0 && isInvisible(cells[end - 1]))
+            --end;
 
+        for (size_t i = 0; i < end;)
+        {
+            Cell const& cell = cells[i];
+            setBold(cell.styles() & CellFlags::Bold);
             setForegroundColor(cell.foregroundColor());
             setBackgroundColor(cell.backgroundColor());
             // TODO: other styles (such as underline), hyperlinks, image fragments.
 
-            if (!cell.codepointCount())
-                write(' ');
-            else
+            if (cell.codepointCount() > 1 || cell.width() > 1)
+            {
                 write(cell.toUtf8());
+                i += std::max(size_t { 1 }, size_t { cell.width() });
+                continue;
+            }
+
+            // Runs of identical cells are written once and repeated (REP).
+            auto const sameCell = [&](Cell const& other) {
+                return other.codepointCount() == cell.codepointCount()
+                       && (!cell.codepointCount() || other.codepoint(0) == cell.codepoint(0))
+                       && other.styles() == cell.styles() && other.foregroundColor() == cell.foregroundColor()
+                       && other.backgroundColor() == cell.backgroundColor();
+            };
+            auto n = size_t { 1 };
+            while (i + n < end && sameCell(cells[i + n]))
+                ++n;
+
+            writeRepeated(cell.codepointCount() ? cell.toUtf8() : string(" "), n);
+            i += n;
         }
     }
 
-    sgrAdd(GraphicsRendition::Reset);
+    if (currentBold_ || !isDefaultColor(currentForegroundColor_) || !isDefaultColor(currentBackgroundColor_))
+        sgrAdd(GraphicsRendition::Reset);
 }
 
 } // namespace terminal
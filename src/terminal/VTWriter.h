@@ -30,6 +30,10 @@ namespace terminal
 {
 
 // Serializes text and SGR attributes into a valid VT stream.
+//
+// SGR attributes are only written when they differ from the ones written last,
+// runs of identical characters are written once and repeated (REP),
+// and trailing blanks of a line are omitted unless they have a background color.
 class VTWriter
 {
   public:
@@ -37,6 +41,9 @@ class VTWriter
 
     static constexpr inline auto MaxParameterCount = 16;
 
+    // Minimal number of identical characters to be written using REP rather than one by one.
+    static constexpr inline size_t MinRepeatCount = 6;
+
     explicit VTWriter(Writer writer);
     explicit VTWriter(std::ostream& output);
     explicit VTWriter(std::vector<char>& output);
@@ -52,6 +59,9 @@ class VTWriter
     void write(std::string_view s);
     void write(char32_t v);
 
+    // Writes the given text @p count times, using REP for longer repetitions.
+    void writeRepeated(std::string_view text, size_t count);
+
     void sgrFlush();
     std::string sgrFlush(std::vector<unsigned> const& sgr);
     void sgrAdd(unsigned n);
@@ -59,6 +69,7 @@ class VTWriter
     void sgrAdd(GraphicsRendition m);
     void setForegroundColor(Color color);
     void setBackgroundColor(Color color);
+    void setBold(bool enabled);
 
     void sgrAddExplicit(unsigned n);
 
@@ -76,7 +87,7 @@ class VTWriter
     Writer writer_;
     std::vector<unsigned> sgr_;
     std::stringstream sstr;
-    std::vector<unsigned> lastSGR_;
+    bool currentBold_ = false;
     Color currentForegroundColor_ = DefaultColor();
     Color currentUnderlineColor_ = DefaultColor();
     Color currentBackgroundColor_ = DefaultColor();
@@ -0,0 +1,87 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/Cell.h>
+#include <terminal/Grid.h>
+#include <terminal/VTWriter.h>
+#include <terminal/test_grid.h>
+
+#include <crispy/escape.h>
+
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace terminal;
+using namespace terminal::test;
+using crispy::escape;
+
+namespace
+{
+
+auto makeGrid()
+{
+    return Grid<Cell>(PageSize { LineCount(1), ColumnCount(12) }, false, LineCount(0));
+}
+
+string serialize(Grid<Cell> const& grid)
+{
+    auto output = std::stringstream {};
+    auto writer = VTWriter(output);
+    writer.write(grid.lineAt(LineOffset(0)));
+    writer.sgrFlush();
+    return escape(output.str());
+}
+
+} // namespace
+
+TEST_CASE("VTWriter.trailingBlanks", "[VTWriter]")
+{
+    auto grid = makeGrid();
+    writeText(grid, 0, "ab");
+    CHECK(serialize(grid) == "ab");
+
+    auto attributes = GraphicsAttributes {};
+    attributes.backgroundColor = Color::Indexed(IndexedColor::Blue);
+    writeText(grid, 10, "  ", attributes);
+    CHECK(serialize(grid) == escape("ab" " \033[7b" "\033[44m  \033[m"));
+}
+
+TEST_CASE("VTWriter.repeat", "[VTWriter]")
+{
+    auto grid = makeGrid();
+    writeText(grid, 0, "--------x");
+    CHECK(serialize(grid) == escape("-\033[7bx"));
+
+    writeText(grid, 0, "-----");
+    writeText(grid, 5, "xxxx");
+    CHECK(serialize(grid) == "-----xxxx");
+}
+
+TEST_CASE("VTWriter.sgrDelta", "[VTWriter]")
+{
+    auto grid = makeGrid();
+    auto red = GraphicsAttributes {};
+    red.foregroundColor = Color::Indexed(IndexedColor::Red);
+    red.styles |= CellFlags::Bold;
+    writeText(grid, 0, "ab", red);
+    writeText(grid, 2, "c");
+    CHECK(serialize(grid) == escape("\033[1;31mab\033[22;39mc"));
+
+    auto gray = GraphicsAttributes {};
+    gray.backgroundColor = RGBColor(0x808080);
+    writeText(grid, 2, "c", gray);
+    CHECK(serialize(grid) == escape("\033[1;31mab\033[22;39;48;2;128;128;128mc\033[m"));
+}
@@ -24,10 +24,78 @@ namespace terminal
 
 using namespace std;
 
-ViCommands::ViCommands(Terminal& theTerminal): terminal { theTerminal }
+ViCommands::ViCommands(Terminal& theTerminal):
+    terminal { theTerminal }, motionText { theTerminal }, motions { motionText }
 {
 }
 
+namespace
+{
+    template <typename Cell>
+    void copyLineText(Line<Cell> const& line, u32string& text)
+    {
+        text.clear();
+        if (line.isTrivialBuffer()
+            && line.trivialBuffer().text.size() == unbox<size_t>(line.trivialBuffer().usedColumns))
+        {
+            // Plain ASCII text can be copied without inflating the line.
+            auto const ascii = line.trivialBuffer().text.view();
+            text.assign(ascii.begin(), ascii.end());
+            text.resize(unbox<size_t>(line.size()), U' ');
+            return;
+        }
+
+        // The cells covered by a wide character take its codepoint, so it is not split into two words.
+        auto codepoint = U' ';
+        auto covered = 0;
+        for (auto const& cell: line.inflatedBuffer())
+        {
+            if (covered > 0)
+                --covered;
+            else
+            {
+                codepoint = cell.empty() ? U' ' : cell.codepoint(0);
+                covered = max(0, cell.width() - 1);
+            }
+            text.push_back(codepoint);
+        }
+    }
+} // namespace
+
+LineOffset ViCommands::MotionText::topLine() const noexcept
+{
+    return -terminal.currentScreen().scrollbackLineCount().as<LineOffset>();
+}
+
+LineOffset ViCommands::MotionText::bottomLine() const noexcept
+{
+    return terminal.pageSize().lines.as<LineOffset>() - 1;
+}
+
+uint64_t ViCommands::MotionText::lineGeneration(LineOffset line) const noexcept
+{
+    return terminal.isPrimaryScreen() ? terminal.primaryScreen().grid().scrollbackLineAt(line).generation()
+                                      : terminal.alternateScreen().grid().scrollbackLineAt(line).generation();
+}
+
+bool ViCommands::MotionText::lineWrapped(LineOffset line) const noexcept
+{
+    return terminal.isLineWrapped(line);
+}
+
+void ViCommands::MotionText::lineText(LineOffset line, u32string& text) const
+{
+    if (terminal.isPrimaryScreen())
+        copyLineText(terminal.primaryScreen().grid().scrollbackLineAt(line), text);
+    else
+        copyLineText(terminal.alternateScreen().grid().scrollbackLineAt(line), text);
+}
+
+u32string const& ViCommands::MotionText::wordDelimiters() const noexcept
+{
+    return terminal.wordDelimiters();
+}
+
 void ViCommands::scrollViewport(ScrollOffset delta)
 {
     if (delta.value < 0)
@@ -91,7 +159,17 @@ void ViCommands::modeChanged(ViMode mode)
 
 void ViCommands::reverseSearchCurrentWord()
 {
-    // TODO
+    auto const [from, to] = translateToCellRange(TextObjectScope::Inner, TextObject::Word);
+    auto word = terminal.extractText(from, to);
+    while (!word.empty() && word.back() == ' ')
+        word.pop_back();
+    if (word.empty())
+        return;
+
+    // Start searching at the word's beginning, so that the word under the cursor is found last.
+    terminal.setSearchPattern(SearchPattern { move(word) });
+    cursorPosition = from;
+    moveCursor(ViMotion::SearchResultBackward, 1);
 }
 
 void ViCommands::executeYank(ViMotion motion, unsigned count)
@@ -208,7 +286,7 @@ CellLocationRange ViCommands::expandMatchingPair(TextObjectScope scope, char lef
 CellLocationRange ViCommands::translateToCellRange(TextObjectScope scope,
                                                    TextObject textObject) const noexcept
 {
-    auto const gridTop = -terminal.currentScreen().historyLineCount().as<LineOffset>();
+    auto const gridTop = -terminal.currentScreen().scrollbackLineCount().as<LineOffset>();
     auto const gridBottom = terminal.pageSize().lines.as<LineOffset>() - 1;
     auto const rightMargin = terminal.pageSize().columns.as<ColumnOffset>() - 1;
     auto a = cursorPosition;
@@ -268,7 +346,7 @@ CellLocation ViCommands::translateToCellLocation(ViMotion motion, unsigned count
                      min(ColumnOffset::cast_from(count),
                          terminal.pageSize().columns.as<ColumnOffset>() - 1) };
         case ViMotion::FileBegin: // gg
-            return { LineOffset::cast_from(-terminal.currentScreen().historyLineCount().as<int>()),
+            return { LineOffset::cast_from(-terminal.currentScreen().scrollbackLineCount().as<int>()),
                      ColumnOffset(0) };
         case ViMotion::FileEnd: // G
             return { terminal.pageSize().lines.as<LineOffset>() - 1, ColumnOffset(0) };
@@ -290,7 +368,7 @@ CellLocation ViCommands::translateToCellLocation(ViMotion motion, unsigned count
             return { cursorPosition.line, terminal.pageSize().columns.as<ColumnOffset>() - 1 };
         case ViMotion::LineUp: // k
             return { max(cursorPosition.line - LineOffset::cast_from(count),
-                         -terminal.currentScreen().historyLineCount().as<LineOffset>()),
+                         -terminal.currentScreen().scrollbackLineCount().as<LineOffset>()),
                      cursorPosition.column };
         case ViMotion::PageDown:
             return { min(cursorPosition.line + LineOffset::cast_from(terminal.pageSize().lines / 2),
@@ -298,13 +376,13 @@ CellLocation ViCommands::translateToCellLocation(ViMotion motion, unsigned count
                      cursorPosition.column };
         case ViMotion::PageUp:
             return { max(cursorPosition.line - LineOffset::cast_from(terminal.pageSize().lines / 2),
-                         -terminal.currentScreen().historyLineCount().as<LineOffset>()),
+                         -terminal.currentScreen().scrollbackLineCount().as<LineOffset>()),
                      cursorPosition.column };
             return cursorPosition
                    - min(cursorPosition.line, LineOffset::cast_from(terminal.pageSize().lines) / 2);
         case ViMotion::ParagraphBackward: // {
         {
-            auto const pageTop = -terminal.currentScreen().historyLineCount().as<LineOffset>();
+            auto const pageTop = -terminal.currentScreen().scrollbackLineCount().as<LineOffset>();
             auto prev = CellLocation { cursorPosition.line, ColumnOffset(0) };
             if (prev.line.value > 0)
                 prev.line--;
@@ -334,57 +412,29 @@ CellLocation ViCommands::translateToCellLocation(ViMotion motion, unsigned count
             }
             return current;
         }
-        case ViMotion::ParenthesisMatching:  // % TODO
-        case ViMotion::SearchResultBackward: // N TODO
-        case ViMotion::SearchResultForward:  // n TODO
-        case ViMotion::WordBackward: {       // b
-            auto prev = cursorPosition;
-            if (prev.column.value > 0)
-                prev.column--;
-            auto current = prev;
-
-            while (current.column.value > 0
-                   && (!terminal.currentScreen().isCellEmpty(current)
-                       || terminal.currentScreen().isCellEmpty(prev)))
-            {
-                prev.column = current.column;
-                current.column--;
-            }
-            if (current.column.value == 0)
-                return current;
-            else
-                return prev;
-        }
-        case ViMotion::WordEndForward: { // e
-            auto const rightMargin = terminal.pageSize().columns.as<ColumnOffset>();
-            auto prev = cursorPosition;
-            if (prev.column + 1 < rightMargin)
-                prev.column++;
-            auto current = prev;
-            while (current.column + 1 < rightMargin
-                   && (!terminal.currentScreen().isCellEmpty(current)
-                       || terminal.currentScreen().isCellEmpty(prev)))
-            {
-                prev.column = current.column;
-                current.column++;
-            }
-            return prev;
-        }
-        case ViMotion::WordForward: { // w
-            auto const rightMargin = terminal.pageSize().columns.as<ColumnOffset>();
-            auto prev = cursorPosition;
-            if (prev.column + 1 < rightMargin)
-                prev.column++;
-            auto current = prev;
-            while (current.column + 1 < rightMargin
-                   && (terminal.currentScreen().isCellEmpty(current)
-                       || !terminal.currentScreen().isCellEmpty(prev)))
+        case ViMotion::SearchResultBackward: // N
+        case ViMotion::SearchResultForward:  // n
+        {
+            auto const direction = motion == ViMotion::SearchResultForward ? SearchDirection::Forward
+                                                                           : SearchDirection::Backward;
+            auto result = cursorPosition;
+            for (unsigned i = 0; i < count; ++i)
             {
-                prev = current;
-                current.column++;
+                if (auto const match = terminal.searchNext(result, direction))
+                    result = match->start;
+                else
+                    break;
             }
-            return current;
+            return result;
         }
+        case ViMotion::ParenthesisMatching: // %
+            return motions.matchingBracket(cursorPosition).value_or(cursorPosition);
+        case ViMotion::WordBackward: // b
+            return motions.wordBackward(cursorPosition, count);
+        case ViMotion::WordEndForward: // e
+            return motions.wordEndForward(cursorPosition, count);
+        case ViMotion::WordForward: // w
+            return motions.wordForward(cursorPosition, count);
         case ViMotion::Explicit:  // <special for explicit operations>
         case ViMotion::Selection: // <special for visual modes>
         case ViMotion::FullLine:  // <special for full-line operations>
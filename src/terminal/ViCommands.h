@@ -14,6 +14,7 @@
 #pragma once
 
 #include <terminal/ViInputHandler.h>
+#include <terminal/ViMotionEngine.h>
 
 #include <utility>
 
@@ -55,9 +56,25 @@ class ViCommands: public ViInputHandler::Executor
     CellLocation cursorPosition {};
 
   private:
+    /// Provides the lines of the terminal's current screen to the motion engine.
+    struct MotionText: public ViMotionText
+    {
+        Terminal& terminal;
+        explicit MotionText(Terminal& theTerminal): terminal { theTerminal } {}
+        [[nodiscard]] LineOffset topLine() const noexcept override;
+        [[nodiscard]] LineOffset bottomLine() const noexcept override;
+        [[nodiscard]] uint64_t lineGeneration(LineOffset line) const noexcept override;
+        [[nodiscard]] bool lineWrapped(LineOffset line) const noexcept override;
+        void lineText(LineOffset line, std::u32string& text) const override;
+        [[nodiscard]] std::u32string const& wordDelimiters() const noexcept override;
+    };
+
     ViMode lastMode = ViMode::Insert;
     CursorShape lastCursorShape = CursorShape::Block;
     bool lastCursorVisible = true;
+
+    MotionText motionText;
+    mutable ViMotionEngine motions;
 };
 
 } // namespace terminal
@@ -0,0 +1,249 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/ViMotionEngine.h>
+
+#include <algorithm>
+#include <string_view>
+
+using std::nullopt;
+using std::optional;
+using std::u32string_view;
+
+namespace terminal
+{
+
+namespace
+{
+    // Lines are only dropped from the cache all at once, before a motion, when exceeding this.
+    constexpr size_t MaxCachedLines = 2048;
+
+    constexpr auto OpeningBrackets = u32string_view { U"([{" };
+    constexpr auto ClosingBrackets = u32string_view { U")]}" };
+} // namespace
+
+/// Walks the cells of the lines, one at a time.
+///
+/// The end of a logical line is walked over as an extra blank cell behind the line's last one,
+/// so that words never continue across it.
+class ViMotionEngine::Cursor
+{
+  public:
+    Cursor(ViMotionEngine& _engine, CellLocation _location):
+        engine_ { &_engine },
+        line_ { _location.line },
+        text_ { &_engine.lineAt(_location.line) },
+        column_ { std::min(unbox<size_t>(_location.column), lastColumn()) }
+    {
+    }
+
+    [[nodiscard]] CellLocation location() const noexcept
+    {
+        return { line_, ColumnOffset::cast_from(std::min(column_, lastColumn())) };
+    }
+
+    [[nodiscard]] ViCharClass charClass() const noexcept
+    {
+        return column_ < text_->classes.size() ? text_->classes[column_] : ViCharClass::Blank;
+    }
+
+    [[nodiscard]] char32_t codepoint() const noexcept
+    {
+        return column_ < text_->text.size() ? text_->text[column_] : U'\n';
+    }
+
+    /// Moves to the next cell of the current line, if any.
+    bool nextOnLine() noexcept
+    {
+        if (column_ + 1 >= text_->text.size())
+            return false;
+        ++column_;
+        return true;
+    }
+
+    bool next()
+    {
+        if (column_ + 1 < text_->text.size())
+        {
+            ++column_;
+            return true;
+        }
+
+        auto const bottom = engine_->text_.bottomLine();
+        if (column_ < text_->text.size() && line_ < bottom && !engine_->text_.lineWrapped(line_ + 1))
+        {
+            column_ = text_->text.size(); // end of the logical line
+            return true;
+        }
+
+        if (line_ >= bottom)
+            return false;
+
+        ++line_;
+        text_ = &engine_->lineAt(line_);
+        column_ = 0;
+        return true;
+    }
+
+    bool previous()
+    {
+        if (column_ > 0)
+        {
+            --column_;
+            return true;
+        }
+
+        if (line_ <= engine_->text_.topLine())
+            return false;
+
+        auto const wrapped = engine_->text_.lineWrapped(line_);
+        --line_;
+        text_ = &engine_->lineAt(line_);
+        column_ = wrapped ? lastColumn() : text_->text.size();
+        return true;
+    }
+
+  private:
+    [[nodiscard]] size_t lastColumn() const noexcept
+    {
+        return text_->text.empty() ? 0 : text_->text.size() - 1;
+    }
+
+    ViMotionEngine* engine_;
+    LineOffset line_;
+    CachedLine const* text_;
+    size_t column_;
+};
+
+void ViMotionEngine::beginMotion()
+{
+    // Character classes depend on the word delimiters.
+    if (text_.wordDelimiters() != wordDelimiters_)
+    {
+        wordDelimiters_ = text_.wordDelimiters();
+        lines_.clear();
+    }
+    else if (lines_.size() > MaxCachedLines)
+        lines_.clear();
+}
+
+ViMotionEngine::CachedLine const& ViMotionEngine::lineAt(LineOffset _line)
+{
+    auto const generation = text_.lineGeneration(_line);
+    if (auto const i = lines_.find(generation); i != lines_.end())
+        return i->second;
+
+    auto& entry = lines_[generation];
+    text_.lineText(_line, entry.text);
+    entry.classes.resize(entry.text.size());
+    for (size_t i = 0; i < entry.text.size(); ++i)
+    {
+        auto const codepoint = entry.text[i];
+        if (codepoint == 0x20 || codepoint == 0x09 || codepoint == 0)
+            entry.classes[i] = ViCharClass::Blank;
+        else if (wordDelimiters_.find(codepoint) != std::u32string::npos)
+            entry.classes[i] = ViCharClass::Punctuation;
+        else
+            entry.classes[i] = ViCharClass::Word;
+    }
+    return entry;
+}
+
+CellLocation ViMotionEngine::wordForward(CellLocation _from, unsigned _count)
+{
+    beginMotion();
+    auto cursor = Cursor(*this, _from);
+    for (unsigned i = 0; i < _count; ++i)
+    {
+        // Skip the rest of the current word, then the blanks behind it.
+        if (auto const current = cursor.charClass(); current != ViCharClass::Blank)
+            while (cursor.charClass() == current)
+                if (!cursor.next())
+                    return cursor.location();
+
+        while (cursor.charClass() == ViCharClass::Blank)
+            if (!cursor.next())
+                return cursor.location();
+    }
+    return cursor.location();
+}
+
+CellLocation ViMotionEngine::wordBackward(CellLocation _from, unsigned _count)
+{
+    beginMotion();
+    auto cursor = Cursor(*this, _from);
+    for (unsigned i = 0; i < _count; ++i)
+    {
+        if (!cursor.previous())
+            break;
+
+        while (cursor.charClass() == ViCharClass::Blank)
+            if (!cursor.previous())
+                return cursor.location();
+
+        // Move to the beginning of the word.
+        auto const current = cursor.charClass();
+        for (auto previous = cursor; previous.previous() && previous.charClass() == current;)
+            cursor = previous;
+    }
+    return cursor.location();
+}
+
+CellLocation ViMotionEngine::wordEndForward(CellLocation _from, unsigned _count)
+{
+    beginMotion();
+    auto cursor = Cursor(*this, _from);
+    for (unsigned i = 0; i < _count; ++i)
+    {
+        if (!cursor.next())
+            break;
+
+        while (cursor.charClass() == ViCharClass::Blank)
+            if (!cursor.next())
+                return cursor.location();
+
+        // Move to the end of the word.
+        auto const current = cursor.charClass();
+        for (auto next = cursor; next.next() && next.charClass() == current;)
+            cursor = next;
+    }
+    return cursor.location();
+}
+
+optional<CellLocation> ViMotionEngine::matchingBracket(CellLocation _from)
+{
+    beginMotion();
+    auto cursor = Cursor(*this, _from);
+    while (OpeningBrackets.find(cursor.codepoint()) == u32string_view::npos
+           && ClosingBrackets.find(cursor.codepoint()) == u32string_view::npos)
+        if (!cursor.nextOnLine())
+            return nullopt;
+
+    auto const bracket = cursor.codepoint();
+    auto const opening = OpeningBrackets.find(bracket);
+    auto const forward = opening != u32string_view::npos;
+    auto const counterpart =
+        forward ? ClosingBrackets[opening] : OpeningBrackets[ClosingBrackets.find(bracket)];
+
+    auto depth = 0;
+    while (forward ? cursor.next() : cursor.previous())
+    {
+        if (cursor.codepoint() == bracket)
+            ++depth;
+        else if (cursor.codepoint() == counterpart && depth-- == 0)
+            return cursor.location();
+    }
+    return nullopt;
+}
+
+} // namespace terminal
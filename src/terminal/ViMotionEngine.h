@@ -0,0 +1,108 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <terminal/primitives.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace terminal
+{
+
+/// Provides the lines of a screen (including its history) to ViMotionEngine.
+class ViMotionText
+{
+  public:
+    virtual ~ViMotionText() = default;
+
+    /// Offset of the top most history line.
+    [[nodiscard]] virtual LineOffset topLine() const noexcept = 0;
+
+    /// Offset of the last line of the page.
+    [[nodiscard]] virtual LineOffset bottomLine() const noexcept = 0;
+
+    /// Generation stamp of the given line, which changes whenever the line's contents do.
+    [[nodiscard]] virtual uint64_t lineGeneration(LineOffset _line) const noexcept = 0;
+
+    /// Whether the given line continues the line above it, i.e. both form one logical line.
+    [[nodiscard]] virtual bool lineWrapped(LineOffset _line) const noexcept = 0;
+
+    /// Replaces @p _text with the text of the given line, one codepoint per cell,
+    /// and U+0020 for empty cells.
+    virtual void lineText(LineOffset _line, std::u32string& _text) const = 0;
+
+    /// Codepoints delimiting words besides whitespace.
+    [[nodiscard]] virtual std::u32string const& wordDelimiters() const noexcept = 0;
+};
+
+/// Character classes vi distinguishes for word motions.
+enum class ViCharClass : uint8_t
+{
+    Blank,
+    Punctuation,
+    Word,
+};
+
+/// Computes vi's word and bracket motions on the text of the screen's lines.
+///
+/// Lines are fetched once and kept along with their character classes, keyed by their generation
+/// stamp, so that subsequent motions, including over lines that scrolled in between, do not inspect
+/// the grid's cells again. A motion with a count (e.g. 100w) is computed in a single pass.
+///
+/// Wrapped lines are moved over as one logical line, i.e. a word may continue on the next line,
+/// while the end of a logical line delimits words like a blank does.
+class ViMotionEngine
+{
+  public:
+    explicit ViMotionEngine(ViMotionText const& _text): text_ { _text } {}
+
+    [[nodiscard]] CellLocation wordForward(CellLocation _from, unsigned _count);    // w
+    [[nodiscard]] CellLocation wordBackward(CellLocation _from, unsigned _count);   // b
+    [[nodiscard]] CellLocation wordEndForward(CellLocation _from, unsigned _count); // e
+
+    /// Returns the location of the bracket matching the first bracket at or behind @p _from
+    /// on its line, or std::nullopt if there is none.
+    [[nodiscard]] std::optional<CellLocation> matchingBracket(CellLocation _from); // %
+
+    /// Drops all cached lines.
+    void clearCache() noexcept { lines_.clear(); }
+
+    [[nodiscard]] size_t cachedLineCount() const noexcept { return lines_.size(); }
+
+  private:
+    struct CachedLine
+    {
+        std::u32string text;
+        std::vector<ViCharClass> classes;
+    };
+
+    class Cursor;
+
+    /// Prepares the cache for the next motion.
+    void beginMotion();
+
+    [[nodiscard]] CachedLine const& lineAt(LineOffset _line);
+
+    ViMotionText const& text_;
+    std::u32string wordDelimiters_;
+
+    // Lines keyed by generation stamp, which is unique to the contents of a line.
+    std::unordered_map<uint64_t, CachedLine> lines_;
+};
+
+} // namespace terminal
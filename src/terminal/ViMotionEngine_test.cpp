@@ -0,0 +1,154 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/ViMotionEngine.h>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace terminal;
+
+namespace
+{
+
+/// Lines of text, with the history lines at negative offsets.
+struct TextLines: public ViMotionText
+{
+    struct Line
+    {
+        u32string text;
+        bool wrapped = false;
+        uint64_t generation = 0;
+    };
+
+    vector<Line> lines;
+    int historyLineCount = 0;
+    u32string delimiters = U"()[]{}.,;";
+    mutable int fetchCount = 0;
+
+    TextLines(vector<u32string> _lines, int _historyLineCount = 0): historyLineCount { _historyLineCount }
+    {
+        for (auto& text: _lines)
+            lines.push_back(Line { move(text), false, lines.size() + 1 });
+    }
+
+    [[nodiscard]] Line const& at(LineOffset _line) const
+    {
+        return lines.at(static_cast<size_t>(unbox<int>(_line) + historyLineCount));
+    }
+
+    LineOffset topLine() const noexcept override { return LineOffset(-historyLineCount); }
+    LineOffset bottomLine() const noexcept override
+    {
+        return LineOffset::cast_from(static_cast<int>(lines.size()) - historyLineCount - 1);
+    }
+    uint64_t lineGeneration(LineOffset _line) const noexcept override { return at(_line).generation; }
+    bool lineWrapped(LineOffset _line) const noexcept override { return at(_line).wrapped; }
+    void lineText(LineOffset _line, u32string& _text) const override
+    {
+        ++fetchCount;
+        _text = at(_line).text;
+    }
+    u32string const& wordDelimiters() const noexcept override { return delimiters; }
+};
+
+CellLocation at(int _line, int _column)
+{
+    return CellLocation { LineOffset(_line), ColumnOffset(_column) };
+}
+
+} // namespace
+
+TEST_CASE("ViMotionEngine.words", "[vi]")
+{
+    auto text = TextLines({ U"foo bar.baz  ", U"  qux        " });
+    auto motions = ViMotionEngine(text);
+
+    CHECK(motions.wordForward(at(0, 0), 1) == at(0, 4));
+    CHECK(motions.wordForward(at(0, 4), 1) == at(0, 7)); // punctuation is a word of its own
+    CHECK(motions.wordForward(at(0, 0), 4) == at(1, 2));
+    CHECK(motions.wordForward(at(1, 2), 5) == at(1, 12));
+
+    CHECK(motions.wordBackward(at(1, 2), 1) == at(0, 8));
+    CHECK(motions.wordBackward(at(1, 2), 3) == at(0, 4));
+    CHECK(motions.wordBackward(at(0, 5), 1) == at(0, 4));
+    CHECK(motions.wordBackward(at(0, 2), 10) == at(0, 0));
+
+    CHECK(motions.wordEndForward(at(0, 0), 1) == at(0, 2));
+    CHECK(motions.wordEndForward(at(0, 2), 1) == at(0, 6));
+    CHECK(motions.wordEndForward(at(0, 6), 3) == at(1, 4));
+}
+
+TEST_CASE("ViMotionEngine.wrapped_lines", "[vi]")
+{
+    auto text = TextLines({ U"one tw", U"o three", U"four" });
+    text.lines[1].wrapped = true;
+    auto motions = ViMotionEngine(text);
+
+    // "two" continues on the wrapped line, whereas the end of a logical line delimits words.
+    CHECK(motions.wordForward(at(0, 4), 1) == at(1, 2));
+    CHECK(motions.wordEndForward(at(0, 4), 1) == at(1, 0));
+    CHECK(motions.wordBackward(at(1, 0), 1) == at(0, 4));
+    CHECK(motions.wordForward(at(1, 2), 1) == at(2, 0));
+    CHECK(motions.wordEndForward(at(1, 6), 1) == at(2, 3));
+}
+
+TEST_CASE("ViMotionEngine.history", "[vi]")
+{
+    auto text = TextLines({ U"alpha", U"beta", U"gamma" }, 2);
+    auto motions = ViMotionEngine(text);
+
+    CHECK(motions.wordBackward(at(0, 0), 2) == at(-2, 0));
+    CHECK(motions.wordForward(at(-2, 0), 2) == at(0, 0));
+}
+
+TEST_CASE("ViMotionEngine.matchingBracket", "[vi]")
+{
+    auto text = TextLines({ U"if (a[1] == (b)) {", U"  x;", U"}" });
+    auto motions = ViMotionEngine(text);
+
+    CHECK(motions.matchingBracket(at(0, 0)) == at(0, 15));
+    CHECK(motions.matchingBracket(at(0, 15)) == at(0, 3));
+    CHECK(motions.matchingBracket(at(0, 5)) == at(0, 7));
+    CHECK(motions.matchingBracket(at(0, 17)) == at(2, 0));
+    CHECK(motions.matchingBracket(at(2, 0)) == at(0, 17));
+    CHECK_FALSE(motions.matchingBracket(at(1, 0)).has_value());
+}
+
+TEST_CASE("ViMotionEngine.cache", "[vi]")
+{
+    auto text = TextLines({ U"a b c d e", U"f g h i j" });
+    auto motions = ViMotionEngine(text);
+
+    (void) motions.wordForward(at(0, 0), 100);
+    CHECK(text.fetchCount == 2);
+    CHECK(motions.cachedLineCount() == 2);
+
+    // Unchanged lines are not fetched again.
+    (void) motions.wordBackward(at(1, 8), 100);
+    CHECK(text.fetchCount == 2);
+
+    // Changed lines are.
+    text.lines[1].text = U"f.g h i j";
+    text.lines[1].generation = 42;
+    CHECK(motions.wordForward(at(1, 0), 1) == at(1, 1));
+    CHECK(text.fetchCount == 3);
+
+    // As are all lines, if the word delimiters change.
+    text.delimiters = U"";
+    CHECK(motions.wordForward(at(1, 0), 1) == at(1, 4));
+    CHECK(text.fetchCount == 4);
+}
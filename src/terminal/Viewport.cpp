@@ -23,19 +23,42 @@
 namespace terminal
 {
 
+namespace
+{
+    // Scroll events closer to each other than this are taken as that far apart, as are the first
+    // ones after a pause, which then has the velocity of a scroll per frame.
+    constexpr auto MinScrollInterval = std::chrono::milliseconds(16);
+
+    // The viewport is considered to stand still if not scrolled for this long.
+    constexpr auto ScrollVelocityTimeout = std::chrono::milliseconds(250);
+} // namespace
+
 bool Viewport::scrollUp(LineCount _numLines)
 {
-    scrollOffset_ =
+    auto const offset =
         std::min(scrollOffset_ + _numLines.as<ScrollOffset>(), boxed_cast<ScrollOffset>(historyLineCount()));
+    trackScrollVelocity(offset.as<double>() - scrollOffset_.as<double>());
+    scrollOffset_ = offset;
     return scrollTo(scrollOffset_);
 }
 
 bool Viewport::scrollDown(LineCount _numLines)
 {
-    scrollOffset_ = std::max(scrollOffset_ - _numLines.as<ScrollOffset>(), ScrollOffset(0));
+    auto const offset = std::max(scrollOffset_ - _numLines.as<ScrollOffset>(), ScrollOffset(0));
+    trackScrollVelocity(offset.as<double>() - scrollOffset_.as<double>());
+    scrollOffset_ = offset;
     return scrollTo(scrollOffset_);
 }
 
+void Viewport::followScrolledLines(LineCount _numLines) noexcept
+{
+    if (!scrolled())
+        return;
+
+    scrollOffset_ =
+        std::min(scrollOffset_ + _numLines.as<ScrollOffset>(), boxed_cast<ScrollOffset>(historyLineCount()));
+}
+
 bool Viewport::scrollToTop()
 {
     return scrollTo(boxed_cast<ScrollOffset>(historyLineCount()));
@@ -57,7 +80,9 @@ bool Viewport::forceScrollToBottom()
 #if defined(CONTOUR_LOG_VIEWPORT)
     Log()("forcing scroll to bottom from {}", scrollOffset_);
 #endif
+    trackScrollVelocity(-scrollOffset_.as<double>());
     scrollOffset_ = ScrollOffset(0);
+    pixelOffset_ = 0;
     modified_();
     return true;
 }
@@ -83,7 +108,7 @@ bool Viewport::scrollTo(ScrollOffset _offset)
     if (scrollingDisabled())
         return false;
 
-    if (_offset == scrollOffset_)
+    if (_offset == scrollOffset_ && !pixelOffset_)
         return false;
 
     if (0 <= *_offset && _offset <= boxed_cast<ScrollOffset>(historyLineCount()))
@@ -91,7 +116,9 @@ bool Viewport::scrollTo(ScrollOffset _offset)
 #if defined(CONTOUR_LOG_VIEWPORT)
         Log()("Scroll to offset {}", _offset);
 #endif
+        trackScrollVelocity(_offset.as<double>() - scrollOffset_.as<double>());
         scrollOffset_ = _offset;
+        pixelOffset_ = 0;
         modified_();
         return true;
     }
@@ -99,6 +126,31 @@ bool Viewport::scrollTo(ScrollOffset _offset)
     return false;
 }
 
+bool Viewport::scrollPixels(int _pixels, int _lineHeight)
+{
+    if (scrollingDisabled() || _lineHeight <= 0)
+        return false;
+
+    // The scroll position in pixels above the main page, rounded up to whole lines.
+    auto const maxPosition = unbox<int>(historyLineCount()) * _lineHeight;
+    auto const position =
+        std::clamp(scrollOffset_.as<int>() * _lineHeight - pixelOffset_ + _pixels, 0, maxPosition);
+    auto const offset = ScrollOffset::cast_from((position + _lineHeight - 1) / _lineHeight);
+    auto const pixelOffset = offset.as<int>() * _lineHeight - position;
+
+    if (offset == scrollOffset_ && pixelOffset == pixelOffset_)
+        return false;
+
+#if defined(CONTOUR_LOG_VIEWPORT)
+    Log()("Scroll to offset {} (+{} pixels)", offset, pixelOffset);
+#endif
+    trackScrollVelocity(static_cast<double>(_pixels) / _lineHeight);
+    scrollOffset_ = offset;
+    pixelOffset_ = pixelOffset;
+    modified_();
+    return true;
+}
+
 bool Viewport::scrollMarkUp()
 {
     if (scrollingDisabled())
@@ -127,9 +179,41 @@ bool Viewport::scrollMarkDown()
     return true;
 }
 
+void Viewport::trackScrollVelocity(double _lines) noexcept
+{
+    using std::chrono::duration;
+    using std::chrono::steady_clock;
+
+    if (_lines == 0.0)
+        return;
+
+    auto const now = steady_clock::now();
+    auto interval = now - lastScrollTime_;
+    auto const paused = interval > ScrollVelocityTimeout;
+    if (paused || interval < MinScrollInterval)
+        interval = MinScrollInterval;
+    lastScrollTime_ = now;
+
+    auto const velocity = _lines / duration<double>(interval).count();
+
+    // Starts over after a pause or when reversing, and smooths out the jitter of the events otherwise.
+    if (paused || velocity * scrollVelocity_ < 0.0)
+        scrollVelocity_ = velocity;
+    else
+        scrollVelocity_ = (scrollVelocity_ + velocity) / 2.0;
+}
+
+double Viewport::scrollVelocity() const noexcept
+{
+    if (std::chrono::steady_clock::now() - lastScrollTime_ > ScrollVelocityTimeout)
+        return 0.0;
+    return scrollVelocity_;
+}
+
 LineCount Viewport::historyLineCount() const noexcept
 {
-    return terminal_.currentScreen().historyLineCount();
+    // Lines spilled into the history archive can still be scrolled back to.
+    return terminal_.currentScreen().scrollbackLineCount();
 }
 
 LineCount Viewport::screenLineCount() const noexcept
@@ -19,6 +19,7 @@
 #include <crispy/logstore.h>
 
 #include <algorithm>
+#include <chrono>
 #include <optional>
 
 namespace terminal
@@ -43,6 +44,12 @@ class Viewport
 
     [[nodiscard]] ScrollOffset scrollOffset() const noexcept { return scrollOffset_; }
 
+    /// Number of pixels the page is scrolled back down from scrollOffset(),
+    /// exposing the top part of the line right below the page.
+    ///
+    /// This is non-zero only when scrolled smoothly, and then less than a line's height.
+    [[nodiscard]] int pixelOffset() const noexcept { return pixelOffset_; }
+
     /// Tests if the viewport has been moved(/scrolled) off its main view position.
     ///
     /// @retval true viewport has been moved/scrolled off its main view position.
@@ -66,6 +73,22 @@ class Viewport
     bool scrollMarkUp();
     bool scrollMarkDown();
 
+    /// Scrolls by the given number of pixels, upwards into the history if positive,
+    /// e.g. to follow a touchpad's movement.
+    bool scrollPixels(int _pixels, int _lineHeight);
+
+    /// Returns the number of lines per second the viewport is being scrolled by, estimated from
+    /// the recent scroll events, positive when scrolling up into the history,
+    /// or 0 if it has not been scrolled for a moment.
+    [[nodiscard]] double scrollVelocity() const noexcept;
+
+    /// Keeps a scrolled viewport on the lines it shows while @p _numLines lines scroll into the history,
+    /// as far as the history keeps them.
+    ///
+    /// Unlike the scrolling functions, this does not notify about the modification, as the
+    /// viewport's contents stay the same.
+    void followScrolledLines(LineCount _numLines) noexcept;
+
     /// Ensures given line is visible by optionally scrolling the
     /// screen's viewport up or down in order to make that line visible.
     ///
@@ -87,12 +110,19 @@ class Viewport
     [[nodiscard]] LineCount screenLineCount() const noexcept;
     [[nodiscard]] bool scrollingDisabled() const noexcept;
 
+    /// Accounts a scroll by the given number of lines (upwards if positive) to the scroll velocity.
+    void trackScrollVelocity(double _lines) noexcept;
+
     // private fields
     //
     Terminal& terminal_;
     ModifyEvent modified_;
     //!< scroll offset relative to scroll top (0) or nullopt if not scrolled into history
     ScrollOffset scrollOffset_;
+    int pixelOffset_ = 0;
+
+    double scrollVelocity_ = 0.0; // lines per second
+    std::chrono::steady_clock::time_point lastScrollTime_ {};
 };
 
 } // namespace terminal
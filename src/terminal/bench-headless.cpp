@@ -12,21 +12,38 @@
  * limitations under the License.
  */
 
+#include <terminal/Functions.h>
 #include <terminal/MockTerm.h>
+#include <terminal/OutputRecording.h>
+#include <terminal/SixelParser.h>
 #include <terminal/Terminal.h>
 #include <terminal/logging.h>
 #include <terminal/pty/MockViewPty.h>
 
+#include <terminal_renderer/Renderer.h>
+
 #include <crispy/App.h>
 #include <crispy/CLI.h>
 #include <crispy/utils.h>
 
+#include <unicode/convert.h>
+
+#include <fmt/chrono.h>
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <random>
+#include <regex>
+#include <sstream>
 #include <thread>
+#include <vector>
 
 #include <libtermbench/termbench.h>
 
@@ -47,6 +64,304 @@ std::string createText(size_t bytes)
     return text;
 }
 
+/// Creates a sixel image stream (excluding DCS and ST) of the given size in pixels, alike
+/// the output of plotting tools: a few colors per band, mostly in repeated runs.
+std::string createSixelImage(unsigned _width, unsigned _height)
+{
+    auto constexpr ColorCount = 4;
+    auto image = fmt::format("\"1;1;{};{}", _width, _height);
+    for (unsigned i = 0; i < ColorCount; ++i)
+        image += fmt::format("#{};2;{};{};{}", i, rand() % 101, rand() % 101, rand() % 101);
+
+    for (unsigned band = 0; band < (_height + 5) / 6; ++band)
+    {
+        for (unsigned color = 0; color < ColorCount; ++color)
+        {
+            image += fmt::format("#{}", color);
+            for (unsigned x = 0; x < _width;)
+            {
+                auto const sixel = char(63 + (rand() % 64));
+                auto const runLength = 1 + static_cast<unsigned>(rand()) % 24;
+                if (runLength > 3)
+                    image += fmt::format("!{}{}", runLength, sixel);
+                else
+                    image += std::string(runLength, sixel);
+                x += runLength;
+            }
+            image += '$';
+        }
+        image += '-';
+    }
+    return image;
+}
+
+/// Returns @p _length random lower case letters, with a blank every few of them.
+std::string createWords(size_t _length)
+{
+    auto text = std::string {};
+    text.reserve(_length);
+    while (text.size() < _length)
+        text += rand() % 6 == 0 ? ' ' : char('a' + (rand() % 26));
+    return text;
+}
+
+/// Test writing a pregenerated stream of output over and over again.
+class GeneratedStream: public contour::termbench::Test
+{
+  public:
+    using Test::Test;
+
+    void run(contour::termbench::Buffer& _terminal) noexcept override
+    {
+        while (_terminal.good())
+            _terminal.write(text);
+    }
+
+  protected:
+    static constexpr size_t StreamSize = 4 * 1024 * 1024;
+
+    std::string text;
+};
+
+/// Mimics colorized compiler or `git log --color` output, with an SGR every few characters.
+class SgrHeavyLines: public GeneratedStream
+{
+  public:
+    SgrHeavyLines(): GeneratedStream("sgr_heavy_lines", "") {}
+
+    void setup(size_t _width, size_t _height) override
+    {
+        (void) _height;
+
+        // clang-format off
+        auto constexpr Tokens = std::array<std::string_view, 12> {
+            "\033[1m", "\033[0m", "\033[31m", "\033[32;1m", "\033[39m", "\033[22;33m",
+            "\033[38;5;208m", "\033[48;5;17m", "\033[38;2;200;100;50m", "\033[49m", "\033[3;36m", "\033[m",
+        };
+        // clang-format on
+
+        text.clear();
+        while (text.size() < StreamSize)
+        {
+            for (size_t column = 0; column + 6 < _width;)
+            {
+                text += Tokens[static_cast<size_t>(rand()) % Tokens.size()];
+                auto const wordLength = 2 + static_cast<size_t>(rand()) % 5;
+                for (size_t i = 0; i < wordLength; ++i)
+                    text += char('a' + (rand() % 26));
+                text += ' ';
+                column += wordLength + 1;
+            }
+            text += "\033[m\r\n";
+        }
+    }
+};
+
+/// Mimics full-screen applications repainting parts of the screen, i.e. lots of cursor positioning
+/// with short runs of text in between, and a status line.
+class CursorMotion: public GeneratedStream
+{
+  public:
+    CursorMotion(): GeneratedStream("cursor_motion", "") {}
+
+    void setup(size_t _width, size_t _height) override
+    {
+        text.clear();
+        while (text.size() < StreamSize)
+        {
+            text += "\033[?25l";
+            for (size_t i = 0; i < _height; ++i)
+            {
+                auto const line = 1 + static_cast<size_t>(rand()) % (_height - 1);
+                auto const column = 1 + static_cast<size_t>(rand()) % (_width - 12);
+                text += fmt::format("\033[{};{}H\033[3{}m", line, column, rand() % 8);
+                text += createWords(4 + static_cast<size_t>(rand()) % 8);
+                if (rand() % 4 == 0)
+                    text += "\033[K";
+            }
+            text += fmt::format("\033[{};1H\033[7m{:<{}}\033[m", _height, createWords(20), _width);
+            text += fmt::format("\033[{};{}H\033[?25h", 1 + rand() % _height, 1 + rand() % _width);
+        }
+    }
+};
+
+/// Mimics pagers and editors scrolling a region of the screen between a fixed header and
+/// status line (DECSTBM), in both directions.
+class ScrollRegion: public GeneratedStream
+{
+  public:
+    ScrollRegion(): GeneratedStream("scroll_region", "") {}
+
+    void setup(size_t _width, size_t _height) override
+    {
+        text.clear();
+        while (text.size() < StreamSize)
+        {
+            text += fmt::format("\033[2;{}r\033[{};1H", _height - 1, _height - 1);
+            for (size_t i = 0; i < 2 * _height; ++i)
+                text += "\r\n" + createWords(_width - 1);
+
+            text += "\033[2;1H";
+            for (size_t i = 0; i < _height / 2; ++i)
+                text += "\033M\r" + createWords(_width - 1);
+
+            text += fmt::format("\033[r\033[{};1H\033[7m{:<{}}\033[m", _height, createWords(20), _width);
+        }
+    }
+};
+
+/// Mimics text in east asian scripts mixed with emoji and latin text with combining marks,
+/// i.e. lots of wide characters and grapheme clusters.
+class WideCharacters: public GeneratedStream
+{
+  public:
+    WideCharacters(): GeneratedStream("unicode_wide", "") {}
+
+    void setup(size_t _width, size_t _height) override
+    {
+        (void) _height;
+
+        auto constexpr CombiningMarks = std::array<char32_t, 4> { 0x0301, 0x0308, 0x0323, 0x0332 };
+
+        text.clear();
+        while (text.size() < StreamSize)
+        {
+            for (size_t column = 0; column + 2 < _width;)
+            {
+                switch (rand() % 4)
+                {
+                    case 0: // CJK ideograph
+                        text += unicode::convert_to<char>(static_cast<char32_t>(0x4E00 + rand() % 0x5000));
+                        column += 2;
+                        break;
+                    case 1: // emoji, sometimes with skin tone modifier
+                        text += unicode::convert_to<char>(static_cast<char32_t>(0x1F600 + rand() % 0x50));
+                        if (rand() % 3 == 0)
+                            text += unicode::convert_to<char>(static_cast<char32_t>(0x1F3FB + rand() % 5));
+                        column += 2;
+                        break;
+                    case 2: // latin letter with combining mark
+                        text += char('a' + (rand() % 26));
+                        text += unicode::convert_to<char>(
+                            CombiningMarks[static_cast<size_t>(rand()) % CombiningMarks.size()]);
+                        column += 1;
+                        break;
+                    default:
+                        text += char('a' + (rand() % 26));
+                        text += ' ';
+                        column += 2;
+                        break;
+                }
+            }
+            text += "\r\n";
+        }
+    }
+};
+
+/// Mimics output of `ls --hyperlink` or compilers linking their diagnostics, with a hyperlink
+/// (OSC 8) every few words.
+class Hyperlinks: public GeneratedStream
+{
+  public:
+    Hyperlinks(): GeneratedStream("hyperlinks", "") {}
+
+    void setup(size_t _width, size_t _height) override
+    {
+        (void) _height;
+
+        auto linkCount = 0u;
+        text.clear();
+        while (text.size() < StreamSize)
+        {
+            for (size_t column = 0; column + 16 < _width;)
+            {
+                auto const word = createWords(4 + static_cast<size_t>(rand()) % 10);
+                if (rand() % 3 == 0)
+                    text += fmt::format("\033]8;id={0};file:///home/user/src/file{0}.cpp\033\\"
+                                        "{1}\033]8;;\033\\",
+                                        ++linkCount % 1000,
+                                        word);
+                else
+                    text += word;
+                text += ' ';
+                column += word.size() + 1;
+            }
+            text += "\r\n";
+        }
+    }
+};
+
+/// Mimics plotting tools, i.e. Sixel images interleaved with a few lines of text.
+class SixelImages: public GeneratedStream
+{
+  public:
+    SixelImages(): GeneratedStream("sixel_images", "") {}
+
+    void setup(size_t _width, size_t _height) override
+    {
+        (void) _height;
+
+        text.clear();
+        while (text.size() < StreamSize)
+        {
+            text += "\033Pq" + createSixelImage(320, 120) + "\033\\\r\n";
+            for (int i = 0; i < 4; ++i)
+                text += createWords(_width - 1) + "\r\n";
+        }
+    }
+};
+
+/// Render target that executes nothing, but counts what would have been sent to the GPU.
+class NullRenderTarget: public terminal::renderer::RenderTarget,
+                        public terminal::renderer::atlas::AtlasBackend
+{
+  public:
+    using ImageSize = terminal::ImageSize;
+
+    uint64_t drawCalls = 0;
+    uint64_t atlasUploads = 0;
+    uint64_t atlasUploadBytes = 0;
+    uint64_t atlasConfigurations = 0;
+
+    // AtlasBackend
+    [[nodiscard]] ImageSize atlasSize() const noexcept override { return atlasSize_; }
+    void configureAtlas(terminal::renderer::atlas::ConfigureAtlas _atlas) override
+    {
+        atlasSize_ = _atlas.size;
+        ++atlasConfigurations;
+    }
+    void uploadTile(terminal::renderer::atlas::UploadTile _tile) override
+    {
+        ++atlasUploads;
+        atlasUploadBytes += _tile.bitmap.size();
+    }
+    void renderTile(terminal::renderer::atlas::RenderTile) override { ++drawCalls; }
+
+    // RenderTarget
+    void setRenderSize(ImageSize) override {}
+    void setMargin(terminal::renderer::PageMargin) override {}
+    terminal::renderer::atlas::AtlasBackend& textureScheduler() override { return *this; }
+    void setBackgroundImage(std::shared_ptr<terminal::BackgroundImage const> const&) override {}
+    void renderRectangle(int, int, Width, Height, RGBAColor) override { ++drawCalls; }
+    void renderImage(std::shared_ptr<terminal::Image const> const&,
+                     terminal::renderer::PixelRect,
+                     terminal::renderer::PixelRect) override
+    {
+        ++drawCalls;
+    }
+    void discardImage(terminal::ImageId) override {}
+    void scheduleScreenshot(ScreenshotCallback) override {}
+    void clear(terminal::RGBAColor) override {}
+    void setDamage(std::optional<terminal::renderer::PixelRect>) override {}
+    void execute() override {}
+    void clearCache() override {}
+    std::optional<terminal::renderer::AtlasTextureScreenshot> readAtlas() override { return std::nullopt; }
+    void inspect(std::ostream&) const override {}
+
+  private:
+    ImageSize atlasSize_ {};
+};
+
 } // namespace
 
 class NullParserEvents
@@ -55,6 +370,7 @@ class NullParserEvents
     void error(std::string_view /*_errorString*/) {}
     void print(char /*_text*/) {}
     void print(std::string_view /*chars*/, size_t /*cellCount*/) {}
+    void print(std::u32string_view /*chars*/) {}
     void execute(char /*_controlCode*/) {}
     void clear() {}
     void collect(char /*_char*/) {}
@@ -63,13 +379,16 @@ class NullParserEvents
     void paramDigit(char /*_char*/) {}
     void paramSeparator() {}
     void paramSubSeparator() {}
+    void params(std::string_view /*_parameters*/) {}
     void dispatchESC(char /*_function*/) {}
     void dispatchCSI(char /*_function*/) {}
     void startOSC() {}
     void putOSC(char /*_char*/) {}
+    void putOSC(std::string_view /*_chars*/) {}
     void dispatchOSC() {}
     void hook(char /*_function*/) {}
     void put(char /*_char*/) {}
+    void put(std::string_view /*_chars*/) {}
     void unhook() {}
     void startAPC() {}
     void putAPC(char) {}
@@ -85,13 +404,225 @@ struct BenchOptions
     bool manyLines = false;
     bool longLines = false;
     bool sgr = false;
+    bool sgrHeavy = false;
     bool binary = false;
+    bool cursorMotion = false;
+    bool scrollRegion = false;
+    bool wideCharacters = false;
+    bool hyperlinks = false;
+    bool sixelImages = false;
+
+    std::string jsonOutputPath {};  //!< Writes machine readable results to this file if not empty.
+    std::string baselinePath {};    //!< Compares results against this JSON report if not empty.
+    unsigned maxRegressionPercent = 5;
 };
 
+namespace
+{
+
+/// Throughput of a single termbench test, as seen by the writer under test.
+struct BenchResult
+{
+    std::string name;
+    uint64_t bytes = 0;
+    std::chrono::steady_clock::duration duration {};
+
+    [[nodiscard]] double megabytesPerSecond() const noexcept
+    {
+        auto const secs = std::chrono::duration<double>(duration).count();
+        return secs > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / secs : 0.0;
+    }
+};
+
+std::string jsonEscape(std::string_view _text)
+{
+    auto result = std::string {};
+    result.reserve(_text.size());
+    for (char const ch: _text)
+    {
+        switch (ch)
+        {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20)
+                    result += fmt::format("\\u{:04x}", static_cast<unsigned>(ch));
+                else
+                    result += ch;
+                break;
+        }
+    }
+    return result;
+}
+
+std::string compilerVersion()
+{
+#if defined(__clang__)
+    return fmt::format("Clang {}.{}.{}", __clang_major__, __clang_minor__, __clang_patchlevel__);
+#elif defined(__GNUC__)
+    return fmt::format("GCC {}.{}.{}", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
+#elif defined(_MSC_VER)
+    return fmt::format("MSVC {}", _MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+std::string cpuModelName()
+{
+#if defined(__linux__)
+    auto cpuinfo = std::ifstream("/proc/cpuinfo");
+    auto line = std::string {};
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.rfind("model name", 0) != 0)
+            continue;
+        if (auto const i = line.find(':'); i != std::string::npos)
+            return line.substr(line.find_first_not_of(' ', i + 1));
+    }
+#endif
+    return "unknown";
+}
+
+std::string operatingSystemName()
+{
+#if defined(__linux__)
+    return "Linux";
+#elif defined(__APPLE__)
+    return "macOS";
+#elif defined(_WIN32)
+    return "Windows";
+#elif defined(__FreeBSD__)
+    return "FreeBSD";
+#else
+    return "unknown";
+#endif
+}
+
+/// Writes the results as JSON, along with the environment they were measured in,
+/// such that they can be used as baseline for later runs.
+bool writeJsonReport(std::string const& _path,
+                     std::string_view _title,
+                     BenchOptions const& _options,
+                     std::vector<BenchResult> const& _results)
+{
+    auto out = std::ofstream(_path, std::ios::trunc);
+    if (!out)
+    {
+        cerr << fmt::format("Could not open JSON output file: {}\n", _path);
+        return false;
+    }
+
+    auto const now = std::time(nullptr);
+    out << "{\n";
+    out << fmt::format("  \"title\": \"{}\",\n", jsonEscape(_title));
+    out << "  \"environment\": {\n";
+    out << fmt::format("    \"version\": \"{}\",\n", jsonEscape(CONTOUR_VERSION_STRING));
+    out << fmt::format("    \"compiler\": \"{}\",\n", jsonEscape(compilerVersion()));
+#if defined(NDEBUG)
+    out << "    \"buildType\": \"release\",\n";
+#else
+    out << "    \"buildType\": \"debug\",\n";
+#endif
+    out << fmt::format("    \"os\": \"{}\",\n", operatingSystemName());
+    out << fmt::format("    \"cpu\": \"{}\",\n", jsonEscape(cpuModelName()));
+    out << fmt::format("    \"hardwareThreads\": {},\n", std::thread::hardware_concurrency());
+    out << fmt::format("    \"timestamp\": \"{:%Y-%m-%dT%H:%M:%SZ}\",\n", fmt::gmtime(now));
+    out << fmt::format("    \"testSizeMB\": {}\n", _options.testSizeMB);
+    out << "  },\n";
+    out << "  \"tests\": [\n";
+    for (size_t i = 0; i < _results.size(); ++i)
+    {
+        auto const& result = _results[i];
+        out << fmt::format(
+            "    {{ \"name\": \"{}\", \"bytes\": {}, \"seconds\": {:.6f}, \"MBps\": {:.3f} }}{}\n",
+            jsonEscape(result.name),
+            result.bytes,
+            std::chrono::duration<double>(result.duration).count(),
+            result.megabytesPerSecond(),
+            i + 1 < _results.size() ? "," : "");
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return static_cast<bool>(out);
+}
+
+/// Loads the per-test throughput from a JSON report previously written by writeJsonReport().
+std::optional<std::vector<std::pair<std::string, double>>> loadBaseline(std::string const& _path)
+{
+    auto in = std::ifstream(_path);
+    if (!in)
+        return std::nullopt;
+
+    auto contents = std::stringstream {};
+    contents << in.rdbuf();
+    auto const text = contents.str();
+
+    auto const pattern = std::regex(R"re("name"\s*:\s*"((?:[^"\\]|\\.)*)"[^}]*"MBps"\s*:\s*([0-9.eE+-]+))re");
+    auto baseline = std::vector<std::pair<std::string, double>> {};
+    for (auto i = std::sregex_iterator(text.begin(), text.end(), pattern); i != std::sregex_iterator(); ++i)
+    {
+        auto name = std::string {};
+        auto const escapedName = (*i)[1].str();
+        for (size_t k = 0; k < escapedName.size(); ++k)
+            name += escapedName[k] == '\\' && k + 1 < escapedName.size() ? escapedName[++k] : escapedName[k];
+        baseline.emplace_back(std::move(name), std::stod((*i)[2].str()));
+    }
+    return baseline;
+}
+
+/// Compares the results against the given baseline report.
+///
+/// @returns false if any test's throughput dropped by more than the configured threshold.
+bool compareWithBaseline(std::vector<BenchResult> const& _results, BenchOptions const& _options)
+{
+    auto const baseline = loadBaseline(_options.baselinePath);
+    if (!baseline)
+    {
+        cerr << fmt::format("Could not read baseline file: {}\n", _options.baselinePath);
+        return false;
+    }
+
+    cout << fmt::format("Comparison against baseline (max regression: {}%)\n", _options.maxRegressionPercent);
+    cout << "-----------------------------------------------\n";
+
+    auto passed = true;
+    for (auto const& result: _results)
+    {
+        auto const i = std::find_if(baseline->begin(), baseline->end(), [&](auto const& entry) {
+            return entry.first == result.name;
+        });
+        if (i == baseline->end())
+        {
+            cout << fmt::format(
+                "{:>20}: {:10.2f} MB/s (not in baseline)\n", result.name, result.megabytesPerSecond());
+            continue;
+        }
+
+        auto const current = result.megabytesPerSecond();
+        auto const expected = i->second;
+        auto const change = expected > 0.0 ? (current - expected) / expected * 100.0 : 0.0;
+        auto const regressed = change < -static_cast<double>(_options.maxRegressionPercent);
+        cout << fmt::format("{:>20}: {:10.2f} MB/s (baseline {:10.2f} MB/s, {:+6.1f}%){}\n",
+                            result.name,
+                            current,
+                            expected,
+                            change,
+                            regressed ? " REGRESSION" : "");
+        passed = passed && !regressed;
+    }
+    cout << '\n';
+    return passed;
+}
+
+} // namespace
+
 template <typename Writer>
 int baseBenchmark(Writer&& _writer, BenchOptions _options, string_view _title)
 {
-    if (!(_options.binary || _options.longLines || _options.manyLines || _options.sgr))
+    if (!(_options.binary || _options.longLines || _options.manyLines || _options.sgr || _options.sgrHeavy
+          || _options.cursorMotion || _options.scrollRegion || _options.wideCharacters || _options.hyperlinks
+          || _options.sixelImages))
     {
         cout << "No test cases specified. Defaulting to: cat, long, sgr.\n";
         _options.manyLines = true;
@@ -104,13 +635,30 @@ int baseBenchmark(Writer&& _writer, BenchOptions _options, string_view _title)
 
     cout << titleText << '\n' << string(titleText.size(), '=') << '\n';
 
-    auto tbp = contour::termbench::Benchmark { std::forward<Writer>(_writer),
-                                               _options.testSizeMB,
-                                               80,
-                                               24,
-                                               [&](contour::termbench::Test const& _test) {
-                                                   cout << fmt::format("Running test {} ...\n", _test.name);
-                                               } };
+    // Measures each test's throughput on our own, as seen by the writer, for the JSON report.
+    auto results = vector<BenchResult> {};
+    auto testStartTime = chrono::steady_clock::now();
+    auto const finishTest = [&]() {
+        if (!results.empty())
+            results.back().duration = chrono::steady_clock::now() - testStartTime;
+    };
+
+    auto tbp = contour::termbench::Benchmark {
+        [&](char const* a, size_t b) -> bool {
+            if (!results.empty())
+                results.back().bytes += b;
+            return _writer(a, b);
+        },
+        _options.testSizeMB,
+        80,
+        24,
+        [&](contour::termbench::Test const& _test) {
+            cout << fmt::format("Running test {} ...\n", _test.name);
+            finishTest();
+            results.emplace_back(BenchResult { fmt::format("{}", _test.name) });
+            testStartTime = chrono::steady_clock::now();
+        }
+    };
 
     if (_options.manyLines)
         tbp.add(contour::termbench::tests::many_lines());
@@ -124,10 +672,29 @@ int baseBenchmark(Writer&& _writer, BenchOptions _options, string_view _title)
         tbp.add(contour::termbench::tests::sgr_fgbg_lines());
     }
 
+    if (_options.sgrHeavy)
+        tbp.add(std::make_unique<SgrHeavyLines>());
+
     if (_options.binary)
         tbp.add(contour::termbench::tests::binary());
 
+    if (_options.cursorMotion)
+        tbp.add(std::make_unique<CursorMotion>());
+
+    if (_options.scrollRegion)
+        tbp.add(std::make_unique<ScrollRegion>());
+
+    if (_options.wideCharacters)
+        tbp.add(std::make_unique<WideCharacters>());
+
+    if (_options.hyperlinks)
+        tbp.add(std::make_unique<Hyperlinks>());
+
+    if (_options.sixelImages)
+        tbp.add(std::make_unique<SixelImages>());
+
     tbp.runAll();
+    finishTest();
 
     cout << '\n';
     cout << "Results\n";
@@ -135,6 +702,13 @@ int baseBenchmark(Writer&& _writer, BenchOptions _options, string_view _title)
     tbp.summarize(cout);
     cout << '\n';
 
+    if (!_options.jsonOutputPath.empty()
+        && !writeJsonReport(_options.jsonOutputPath, _title, _options, results))
+        return EXIT_FAILURE;
+
+    if (!_options.baselinePath.empty() && !compareWithBaseline(results, _options))
+        return EXIT_FAILURE;
+
     return EXIT_SUCCESS;
 }
 
@@ -156,9 +730,14 @@ class ContourHeadlessBench: public crispy::App
             Project { "termbench-pro", "Apache-2.0", "https://github.com/contour-terminal/termbench-pro" },
             Project { "fmt", "MIT", "https://github.com/fmtlib/fmt" });
         link("bench-headless.parser", bind(&ContourHeadlessBench::benchParserOnly, this));
+        link("bench-headless.parser-scan", bind(&ContourHeadlessBench::benchParserScanner, this));
         link("bench-headless.grid", bind(&ContourHeadlessBench::benchGrid, this));
         link("bench-headless.pty", bind(&ContourHeadlessBench::benchPTY, this));
         link("bench-headless.meta", bind(&ContourHeadlessBench::showMetaInfo, this));
+        link("bench-headless.functions", bind(&ContourHeadlessBench::benchFunctionSelect, this));
+        link("bench-headless.sixel", bind(&ContourHeadlessBench::benchSixel, this));
+        link("bench-headless.render", bind(&ContourHeadlessBench::benchRender, this));
+        link("bench-headless.replay", bind(&ContourHeadlessBench::benchReplay, this));
 
         char const* logFilterString = getenv("LOG");
         if (logFilterString)
@@ -175,9 +754,48 @@ class ContourHeadlessBench: public crispy::App
             CLI::Option { "cat", CLI::Value { false }, "Enable cat-style short-line ASCII stream test." },
             CLI::Option { "long", CLI::Value { false }, "Enable long-line ASCII stream test." },
             CLI::Option { "sgr", CLI::Value { false }, "Enable SGR stream test." },
+            CLI::Option { "sgr-heavy",
+                          CLI::Value { false },
+                          "Enable SGR-heavy stream test (colorized compiler output alike)." },
             CLI::Option { "binary", CLI::Value { false }, "Enable binary stream test." },
+            CLI::Option { "cursor",
+                          CLI::Value { false },
+                          "Enable cursor motion test (full-screen application repaints alike)." },
+            CLI::Option {
+                "scroll-region", CLI::Value { false }, "Enable scrolling within margins (DECSTBM) test." },
+            CLI::Option { "unicode",
+                          CLI::Value { false },
+                          "Enable wide character test (CJK, emoji and combining marks)." },
+            CLI::Option { "hyperlink", CLI::Value { false }, "Enable hyperlink (OSC 8) test." },
+            CLI::Option { "sixel", CLI::Value { false }, "Enable Sixel image test." },
+            CLI::Option { "json",
+                          CLI::Value { ""s },
+                          "Writes per-test throughput and environment information as JSON to the given file.",
+                          "FILE" },
+            CLI::Option { "baseline",
+                          CLI::Value { ""s },
+                          "Compares per-test throughput against the given JSON report and fails on "
+                          "regressions.",
+                          "FILE" },
+            CLI::Option { "max-regression",
+                          CLI::Value { 5u },
+                          "Maximum throughput drop tolerated against the baseline.",
+                          "PERCENT" },
         };
 
+        auto gridOptions = perfOptions;
+        gridOptions.emplace_back(CLI::Option { "profile",
+                                               CLI::Value { false },
+                                               "Reports the 20 most expensive VT functions." });
+
+        auto renderOptions = perfOptions;
+        renderOptions.emplace_back(CLI::Option { "file",
+                                                 CLI::Value { ""s },
+                                                 "Replays the given output recording instead of the tests.",
+                                                 "FILE" });
+        renderOptions.emplace_back(
+            CLI::Option { "font", CLI::Value { "monospace"s }, "Font family to render text with.", "NAME" });
+
         return CLI::Command {
             "bench-headless",
             "Contour Terminal Emulator " CONTOUR_VERSION_STRING
@@ -191,12 +809,51 @@ class ContourHeadlessBench: public crispy::App
                                "Shows the license, and project URL of the used projects and Contour." },
                 CLI::Command { "grid",
                                "Performs performance tests utilizing the full grid including VT parser.",
-                               perfOptions },
+                               gridOptions },
                 CLI::Command {
                     "parser", "Performs performance tests utilizing the VT parser only.", perfOptions },
+                CLI::Command { "parser-scan",
+                               "Compares VT parser throughput with the vectorized byte scanner turned off "
+                               "and on.",
+                               perfOptions },
+                CLI::Command {
+                    "functions",
+                    "Compares VT function lookup via direct-indexed table against binary search.",
+                    CLI::OptionList {
+                        CLI::Option {
+                            "rounds", CLI::Value { 100000u }, "Number of rounds over all known functions." },
+                    } },
+                CLI::Command {
+                    "sixel",
+                    "Performs performance tests decoding Sixel images only.",
+                    CLI::OptionList {
+                        CLI::Option { "size", CLI::Value { 32u }, "Number of megabyte to decode.", "MB" },
+                    } },
                 CLI::Command {
                     "pty",
                     "Performs performance tests utilizing the underlying operating system's PTY only." },
+                CLI::Command { "render",
+                               "Performs performance tests utilizing the full render path into a render "
+                               "target that does not draw.",
+                               renderOptions },
+                CLI::Command {
+                    "replay",
+                    "Replays an output recording (see contour --record-output) through the parser or "
+                    "terminal.",
+                    CLI::OptionList {
+                        CLI::Option { "grid",
+                                      CLI::Value { false },
+                                      "Replays into the full terminal instead of the parser only." },
+                        CLI::Option { "realtime",
+                                      CLI::Value { false },
+                                      "Replays with the recorded delays between reads." },
+                        CLI::Option { "profile",
+                                      CLI::Value { false },
+                                      "Reports the 20 most expensive VT functions (implies grid)." },
+                    },
+                    CLI::CommandList {},
+                    CLI::CommandSelect::Explicit,
+                    CLI::Verbatim { "FILE", "Output recording to replay." } },
             }
         };
     }
@@ -219,7 +876,16 @@ class ContourHeadlessBench: public crispy::App
         opts.manyLines = parameters().boolean(prefix + "cat");
         opts.longLines = parameters().boolean(prefix + "long");
         opts.sgr = parameters().boolean(prefix + "sgr");
+        opts.sgrHeavy = parameters().boolean(prefix + "sgr-heavy");
         opts.binary = parameters().boolean(prefix + "binary");
+        opts.cursorMotion = parameters().boolean(prefix + "cursor");
+        opts.scrollRegion = parameters().boolean(prefix + "scroll-region");
+        opts.wideCharacters = parameters().boolean(prefix + "unicode");
+        opts.hyperlinks = parameters().boolean(prefix + "hyperlink");
+        opts.sixelImages = parameters().boolean(prefix + "sixel");
+        opts.jsonOutputPath = parameters().str(prefix + "json");
+        opts.baselinePath = parameters().str(prefix + "baseline");
+        opts.maxRegressionPercent = parameters().uint(prefix + "max-regression");
         return opts;
     }
 
@@ -231,6 +897,7 @@ class ContourHeadlessBench: public crispy::App
         auto vt = terminal::MockTerm<terminal::MockViewPty>(pageSize, maxHistoryLineCount, ptyReadBufferSize);
         auto* pty = dynamic_cast<terminal::MockViewPty*>(&vt.terminal.device());
         vt.terminal.setMode(terminal::DECMode::AutoWrap, true);
+        vt.terminal.setSequenceProfiling(parameters().boolean("bench-headless.grid.profile"));
 
         auto const rv = baseBenchmark(
             [&](char const* a, size_t b) -> bool {
@@ -248,9 +915,40 @@ class ContourHeadlessBench: public crispy::App
             "terminal with screen buffer");
         if (rv == EXIT_SUCCESS)
             cout << fmt::format("{:>12}: {}\n\n", "history size", *vt.terminal.maxHistoryLineCount());
+        if (rv == EXIT_SUCCESS && vt.terminal.sequenceMetrics())
+            printSequenceProfile(*vt.terminal.sequenceMetrics());
         return rv;
     }
 
+    static void printSequenceProfile(terminal::Metrics const& _metrics, size_t _limit = 20)
+    {
+        auto const unit = terminal::cycleCountUnit();
+        auto const totalCycles = max(_metrics.totalCycles(), uint64_t { 1 });
+        auto const entries = _metrics.mostExpensive();
+
+        fmt::print("Top {} most expensive VT functions\n", min(_limit, entries.size()));
+        fmt::print("{:>3}  {:<12} {:>12} {:>16} {:>7} {:>12}\n",
+                   "#",
+                   "function",
+                   "calls",
+                   fmt::format("total {}", unit),
+                   "share",
+                   fmt::format("{}/call", unit));
+        for (size_t i = 0; i < min(_limit, entries.size()); ++i)
+        {
+            auto const& entry = entries[i];
+            auto const calls = max(entry.count, uint64_t { 1 });
+            fmt::print("{:>3}  {:<12} {:>12} {:>16} {:>6.2f}% {:>12.1f}\n",
+                       i + 1,
+                       entry.function->mnemonic,
+                       entry.count,
+                       entry.cycles,
+                       100.0 * static_cast<double>(entry.cycles) / static_cast<double>(totalCycles),
+                       static_cast<double>(entry.cycles) / static_cast<double>(calls));
+        }
+        fmt::print("\n");
+    }
+
     int benchPTY()
     {
         using std::chrono::steady_clock;
@@ -334,6 +1032,308 @@ class ContourHeadlessBench: public crispy::App
         return EXIT_SUCCESS;
     }
 
+    int benchFunctionSelect()
+    {
+        using std::chrono::steady_clock;
+        using terminal::FunctionCategory;
+        using terminal::FunctionSelector;
+
+        auto const rounds = parameters().uint("bench-headless.functions.rounds");
+
+        // Select every known function, just like the Sequencer would when dispatching it.
+        auto selectors = std::vector<FunctionSelector> {};
+        for (auto const& f: terminal::functions())
+        {
+            if (f.category == FunctionCategory::OSC)
+                selectors.emplace_back(FunctionSelector { f.category, 0, f.maximumParameters, 0, 0 });
+            else
+                selectors.emplace_back(FunctionSelector {
+                    f.category, f.leader, f.minimumParameters, f.intermediate, f.finalSymbol });
+        }
+
+        auto const measure = [&](string_view _title, auto _select) {
+            auto matches = size_t { 0 };
+            auto const startTime = steady_clock::now();
+            for (unsigned i = 0; i < rounds; ++i)
+                for (auto const& selector: selectors)
+                    matches += _select(selector) != nullptr;
+            auto const elapsed = steady_clock::now() - startTime;
+            auto const nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            auto const lookups = static_cast<double>(rounds) * static_cast<double>(selectors.size());
+            fmt::print("{:<14}: {:>8.2f} ns per lookup ({} lookups, {} matches)\n",
+                       _title,
+                       static_cast<double>(nsecs) / lookups,
+                       static_cast<size_t>(lookups),
+                       matches);
+        };
+
+        fmt::print("Function lookup benchmark ({} functions, {} rounds)\n\n", selectors.size(), rounds);
+        measure("binary search", [](FunctionSelector const& s) { return terminal::selectBySearch(s); });
+        measure("direct index", [](FunctionSelector const& s) { return terminal::select(s); });
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchSixel()
+    {
+        using std::chrono::steady_clock;
+        using terminal::Height;
+        using terminal::ImageSize;
+        using terminal::Width;
+
+        auto constexpr ImageWidth = 1280u;
+        auto constexpr ImageHeight = 720u;
+        auto const testSize = uint64_t { parameters().uint("bench-headless.sixel.size") } * 1024 * 1024;
+
+        auto const image = createSixelImage(ImageWidth, ImageHeight);
+        auto builder = terminal::SixelImageBuilder(ImageSize { Width(ImageWidth), Height(ImageHeight) },
+                                                   1,
+                                                   1,
+                                                   terminal::RGBAColor { 0, 0, 0, 0xFF },
+                                                   std::make_shared<terminal::SixelColorPalette>(16, 256));
+
+        fmt::print("Running Sixel benchmark ({}x{} pixels, {} per image) ...\n",
+                   ImageWidth,
+                   ImageHeight,
+                   crispy::humanReadableBytes(image.size()));
+
+        auto bytesDecoded = uint64_t { 0 };
+        auto imageCount = uint64_t { 0 };
+        auto const startTime = steady_clock::now();
+        while (bytesDecoded < testSize)
+        {
+            builder.clear(terminal::RGBAColor { 0, 0, 0, 0xFF });
+            terminal::SixelParser::parse(image, builder);
+            bytesDecoded += image.size();
+            ++imageCount;
+        }
+        auto const elapsed = steady_clock::now() - startTime;
+        auto const usecs = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        auto const secs = static_cast<double>(max(usecs, decltype(usecs) { 1 })) / 1'000'000.0;
+
+        fmt::print("\n");
+        fmt::print("Images decoded : {}\n", imageCount);
+        fmt::print("Data decoded   : {}\n", crispy::humanReadableBytes(bytesDecoded));
+        fmt::print("Test time      : {:.3f} seconds\n", secs);
+        fmt::print("Decode speed   : {:.2f} MB/s, {:.1f} images/s\n",
+                   static_cast<double>(bytesDecoded) / secs / (1024.0 * 1024.0),
+                   static_cast<double>(imageCount) / secs);
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchRender()
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::steady_clock;
+
+        auto const pageSize = terminal::PageSize { terminal::LineCount(24), terminal::ColumnCount(80) };
+        auto vt = terminal::MockTerm<terminal::MockViewPty>(pageSize, terminal::LineCount(4000), 1'000'000);
+        auto* pty = dynamic_cast<terminal::MockViewPty*>(&vt.terminal.device());
+        vt.terminal.setMode(terminal::DECMode::AutoWrap, true);
+
+        auto fonts = terminal::renderer::FontDescriptions {};
+        fonts.dpi = text::DPI { 96, 96 };
+        fonts.size = text::font_size { 12.0 };
+        fonts.regular = text::font_description::parse(parameters().str("bench-headless.render.font"));
+        fonts.regular.spacing = text::font_spacing::mono;
+        fonts.bold = fonts.regular;
+        fonts.bold.weight = text::font_weight::bold;
+        fonts.italic = fonts.regular;
+        fonts.italic.slant = text::font_slant::italic;
+        fonts.boldItalic = fonts.bold;
+        fonts.boldItalic.slant = text::font_slant::italic;
+        fonts.emoji.familyName = "emoji";
+        fonts.emoji.spacing = text::font_spacing::mono;
+
+        auto renderTarget = NullRenderTarget {};
+        auto renderer = terminal::renderer::Renderer { pageSize,
+                                                       fonts,
+                                                       vt.terminal.colorPalette(),
+                                                       terminal::Opacity::Opaque,
+                                                       crispy::StrongHashtableSize { 4096 },
+                                                       crispy::LRUCapacity { 4000 },
+                                                       true,
+                                                       terminal::renderer::Decorator::DottedUnderline,
+                                                       terminal::renderer::Decorator::Underline };
+        renderer.setRenderTarget(renderTarget);
+
+        auto frames = uint64_t { 0 };
+        auto timings = terminal::renderer::Renderer::FrameTimings {};
+        auto parseTime = steady_clock::duration {};
+
+        // Renders one frame per chunk of output, alike the GUI rendering once per PTY read.
+        auto const writeAndRender = [&](string_view _chunk) {
+            auto const parseStart = steady_clock::now();
+            pty->setReadData(_chunk);
+            do
+                vt.terminal.processInputOnce();
+            while (!pty->isClosed() && !pty->stdoutBuffer().empty());
+            parseTime += steady_clock::now() - parseStart;
+
+            renderer.render(vt.terminal, false);
+            auto const& frameTimings = renderer.lastFrameTimings();
+            timings.renderBuffer += frameTimings.renderBuffer;
+            timings.cells += frameTimings.cells;
+            timings.execute += frameTimings.execute;
+            ++frames;
+        };
+
+        auto const startTime = steady_clock::now();
+        if (auto const& fileName = parameters().str("bench-headless.render.file"); !fileName.empty())
+        {
+            auto const recording = loadRecording(fileName);
+            if (!recording)
+                return EXIT_FAILURE;
+            vt.terminal.resizeScreen(recording->pageSize(), std::nullopt);
+            for (auto const& record: recording->records())
+            {
+                if (record.pageSize)
+                    vt.terminal.resizeScreen(*record.pageSize, std::nullopt);
+                else
+                    writeAndRender(record.data);
+            }
+        }
+        else
+        {
+            auto const rv = baseBenchmark(
+                [&](char const* a, size_t b) -> bool {
+                    if (pty->isClosed())
+                        return false;
+                    writeAndRender(string_view(a, b));
+                    return true;
+                },
+                benchOptionsFor("render"),
+                "terminal with renderer");
+            if (rv != EXIT_SUCCESS)
+                return rv;
+        }
+        auto const elapsed = steady_clock::now() - startTime;
+
+        auto const usecs = duration_cast<microseconds>(elapsed).count();
+        auto const secs = static_cast<double>(max(usecs, decltype(usecs) { 1 })) / 1'000'000.0;
+        auto const frameCount = static_cast<double>(max(frames, uint64_t { 1 }));
+        auto const perFrame = [&](steady_clock::duration _time) {
+            return static_cast<double>(duration_cast<microseconds>(_time).count()) / frameCount;
+        };
+
+        fmt::print("Render pipeline ({} frames in {:.3f} seconds)\n", frames, secs);
+        fmt::print("-------------------------------------------\n");
+        fmt::print("Frames per second     : {:.1f}\n", static_cast<double>(frames) / secs);
+        fmt::print("Parse                 : {:>9.2f} us/frame\n", perFrame(parseTime));
+        fmt::print("Render buffer         : {:>9.2f} us/frame\n", perFrame(timings.renderBuffer));
+        fmt::print("Render cells          : {:>9.2f} us/frame\n", perFrame(timings.cells));
+        fmt::print("Execute               : {:>9.2f} us/frame\n", perFrame(timings.execute));
+        fmt::print("Draw calls            : {} ({:.1f} per frame)\n",
+                   renderTarget.drawCalls,
+                   static_cast<double>(renderTarget.drawCalls) / frameCount);
+        fmt::print("Atlas uploads         : {} ({})\n",
+                   renderTarget.atlasUploads,
+                   crispy::humanReadableBytes(renderTarget.atlasUploadBytes));
+        fmt::print("Atlas configurations  : {}\n", renderTarget.atlasConfigurations);
+
+        return EXIT_SUCCESS;
+    }
+
+    static std::optional<terminal::OutputRecording> loadRecording(std::string const& _fileName)
+    {
+        try
+        {
+            return terminal::OutputRecording::load(_fileName);
+        }
+        catch (std::exception const& e)
+        {
+            fmt::print("{}\n", e.what());
+            return std::nullopt;
+        }
+    }
+
+    int benchReplay()
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        using std::chrono::steady_clock;
+
+        if (parameters().verbatim.size() != 1)
+        {
+            fmt::print("Expected exactly one output recording file to replay.\n");
+            return EXIT_FAILURE;
+        }
+
+        auto const recording = loadRecording(std::string(parameters().verbatim.front()));
+        if (!recording)
+            return EXIT_FAILURE;
+
+        auto const profile = parameters().boolean("bench-headless.replay.profile");
+        auto const useGrid = profile || parameters().boolean("bench-headless.replay.grid");
+        auto const realtime = parameters().boolean("bench-headless.replay.realtime");
+
+        auto po = NullParserEvents {};
+        auto parser = terminal::parser::Parser { po };
+        auto vt = terminal::MockTerm<terminal::MockViewPty>(
+            recording->pageSize(), terminal::LineCount(4000), 1'000'000);
+        auto* pty = dynamic_cast<terminal::MockViewPty*>(&vt.terminal.device());
+        vt.terminal.setMode(terminal::DECMode::AutoWrap, true);
+        vt.terminal.setSequenceProfiling(profile);
+
+        fmt::print("Replaying {} ({} reads, {} recorded in {:.3f} seconds) into the {} ...\n",
+                   parameters().verbatim.front(),
+                   recording->records().size(),
+                   crispy::humanReadableBytes(recording->outputSize()),
+                   static_cast<double>(recording->duration().count()) / 1'000'000.0,
+                   useGrid ? "terminal" : "parser");
+
+        auto reads = uint64_t { 0 };
+        auto busyTime = steady_clock::duration {};
+        auto maxReadTime = steady_clock::duration {};
+        for (auto const& record: recording->records())
+        {
+            if (realtime)
+                std::this_thread::sleep_for(record.delay);
+
+            auto const readStart = steady_clock::now();
+            if (record.pageSize)
+            {
+                if (useGrid)
+                    vt.terminal.resizeScreen(*record.pageSize, std::nullopt);
+            }
+            else if (useGrid)
+            {
+                pty->setReadData(record.data);
+                do
+                    vt.terminal.processInputOnce();
+                while (!pty->isClosed() && !pty->stdoutBuffer().empty());
+            }
+            else
+                parser.parseFragment(record.data);
+            auto const readTime = steady_clock::now() - readStart;
+
+            busyTime += readTime;
+            maxReadTime = max(maxReadTime, readTime);
+            reads += record.data.empty() ? 0 : 1;
+        }
+
+        auto const usecs = duration_cast<microseconds>(busyTime).count();
+        auto const secs = static_cast<double>(max(usecs, decltype(usecs) { 1 })) / 1'000'000.0;
+
+        fmt::print("\n");
+        fmt::print("Processing time : {:.3f} seconds\n", secs);
+        fmt::print("Throughput      : {:.2f} MB/s\n",
+                   static_cast<double>(recording->outputSize()) / secs / (1024.0 * 1024.0));
+        fmt::print("Time per read   : {:.2f} us (max: {} us)\n",
+                   static_cast<double>(usecs) / static_cast<double>(max(reads, uint64_t { 1 })),
+                   duration_cast<microseconds>(maxReadTime).count());
+
+        if (profile)
+        {
+            fmt::print("\n");
+            printSequenceProfile(*vt.terminal.sequenceMetrics());
+        }
+
+        return EXIT_SUCCESS;
+    }
+
     int benchParserOnly()
     {
         auto po = NullParserEvents {};
@@ -346,6 +1346,36 @@ class ContourHeadlessBench: public crispy::App
             benchOptionsFor("parser"),
             "Parser only");
     }
+
+    int benchParserScanner()
+    {
+        auto const options = benchOptionsFor("parser-scan");
+        for (bool const vectorizedScan: { false, true })
+        {
+            auto po = NullParserEvents {};
+            auto parser = terminal::parser::Parser { po };
+            parser.vectorizedScan = vectorizedScan;
+            parser.maxCharCount = 80;
+            // Only the vectorized run, being the production configuration, is reported and compared.
+            auto runOptions = options;
+            if (!vectorizedScan)
+            {
+                runOptions.jsonOutputPath.clear();
+                runOptions.baselinePath.clear();
+            }
+            auto const rv = baseBenchmark(
+                [&](char const* a, size_t b) -> bool {
+                    parser.parseFragment(string_view(a, b));
+                    return true;
+                },
+                runOptions,
+                vectorizedScan ? "Parser only, vectorized scanner ON"
+                               : "Parser only, vectorized scanner OFF");
+            if (rv != EXIT_SUCCESS)
+                return rv;
+        }
+        return EXIT_SUCCESS;
+    }
 };
 
 int main(int argc, char const* argv[])
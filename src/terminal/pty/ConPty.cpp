@@ -13,6 +13,11 @@
  */
 #include <terminal/pty/ConPty.h>
 
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <utility>
 
 #include <Windows.h>
@@ -43,6 +48,37 @@ string GetLastErrorAsString()
 
     return message;
 }
+
+std::atomic<unsigned> pipeSerial = 0;
+
+/// Creates a pipe whose read end supports overlapped I/O, which anonymous pipes do not.
+bool createOverlappedPipe(HANDLE& readEnd, HANDLE& writeEnd, DWORD bufferSize)
+{
+    auto const name =
+        fmt::format("\\\\.\\pipe\\contour-conpty-{}-{}", GetCurrentProcessId(), pipeSerial++);
+
+    readEnd = CreateNamedPipeA(name.c_str(),
+                               PIPE_ACCESS_INBOUND | FILE_FLAG_FIRST_PIPE_INSTANCE | FILE_FLAG_OVERLAPPED,
+                               PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                               1,
+                               bufferSize,
+                               bufferSize,
+                               0,
+                               nullptr);
+    if (readEnd == INVALID_HANDLE_VALUE)
+        return false;
+
+    writeEnd =
+        CreateFileA(name.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (writeEnd == INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(readEnd);
+        readEnd = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    return true;
+}
 } // anonymous namespace
 
 namespace terminal
@@ -64,21 +100,27 @@ struct ConPtySlave: public PtySlaveDummy
     }
 };
 
-ConPty::ConPty(PageSize const& _windowSize): size_ { _windowSize }
+ConPty::ConPty(PageSize const& _windowSize, size_t _pipeBufferSize): size_ { _windowSize }
 {
     master_ = INVALID_HANDLE_VALUE;
     input_ = INVALID_HANDLE_VALUE;
     output_ = INVALID_HANDLE_VALUE;
+    readEvent_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    wakeupEvent_ = CreateEventA(nullptr, FALSE, FALSE, nullptr);
     slave_ = make_unique<ConPtySlave>(output_);
 
+    if (!readEvent_ || !wakeupEvent_)
+        throw runtime_error { GetLastErrorAsString() };
+
     HANDLE hPipePTYIn { INVALID_HANDLE_VALUE };
     HANDLE hPipePTYOut { INVALID_HANDLE_VALUE };
+    auto const pipeBufferSize = static_cast<DWORD>(_pipeBufferSize);
 
     // Create the pipes to which the ConPty will connect to
-    if (!CreatePipe(&hPipePTYIn, &output_, NULL, 0))
+    if (!CreatePipe(&hPipePTYIn, &output_, NULL, pipeBufferSize))
         throw runtime_error { GetLastErrorAsString() };
 
-    if (!CreatePipe(&input_, &hPipePTYOut, NULL, 0))
+    if (!createOverlappedPipe(input_, hPipePTYOut, pipeBufferSize))
     {
         CloseHandle(hPipePTYIn);
         throw runtime_error { GetLastErrorAsString() };
@@ -99,14 +141,14 @@ ConPty::ConPty(PageSize const& _windowSize): size_ { _windowSize }
 
     if (hr != S_OK)
         throw runtime_error { GetLastErrorAsString() };
-
-    buffer_.resize(10240);
 }
 
 ConPty::~ConPty()
 {
     PtyLog()("~ConPty()");
     close();
+    CloseHandle(readEvent_);
+    CloseHandle(wakeupEvent_);
 }
 
 bool ConPty::isClosed() const noexcept
@@ -140,22 +182,44 @@ void ConPty::close()
 
 Pty::ReadResult ConPty::read(crispy::BufferObject& buffer, std::chrono::milliseconds timeout, size_t size)
 {
-    // TODO: wait for timeout time at most AND got woken up upon wakeupReader() invokcation.
-    (void) timeout;
-
     auto const n = static_cast<DWORD>(min(size, buffer.bytesAvailable()));
 
+    readOverlapped_ = OVERLAPPED {};
+    readOverlapped_.hEvent = readEvent_;
+    auto const started = ReadFile(input_, buffer.hotEnd(), n, nullptr, &readOverlapped_);
+    if (!started && GetLastError() != ERROR_IO_PENDING)
+    {
+        errno = ENODEV;
+        return nullopt;
+    }
+
+    HANDLE const events[2] = { readEvent_, wakeupEvent_ };
+    auto const waitTime = timeout == NoTimeout
+                              ? INFINITE
+                              : static_cast<DWORD>(std::clamp<int64_t>(timeout.count(), 0, INFINITE - 1));
+    auto const waitResult = WaitForMultipleObjects(2, events, FALSE, waitTime);
+    if (waitResult != WAIT_OBJECT_0)
+        CancelIoEx(input_, &readOverlapped_);
+
+    // Even if cancelled, the read may have completed already and must not lose its data.
     DWORD nread {};
-    if (!ReadFile(input_, buffer.hotEnd(), n, &nread, nullptr))
+    if (!GetOverlappedResult(input_, &readOverlapped_, &nread, TRUE))
+    {
+        if (GetLastError() != ERROR_OPERATION_ABORTED)
+            errno = ENODEV;
+        else if (waitResult == WAIT_OBJECT_0 + 1)
+            errno = EINTR;
+        else
+            errno = EAGAIN;
         return nullopt;
+    }
 
     return { tuple { string_view { buffer.hotEnd(), nread }, false } };
 }
 
 void ConPty::wakeupReader()
 {
-    // TODO: Windows ConPTY does *NOT* support non-blocking / overlapped I/O.
-    // How can we make ReadFile() return early? We could maybe WriteFile() to it?
+    SetEvent(wakeupEvent_);
 }
 
 int ConPty::write(char const* buf, size_t size)
@@ -172,6 +236,12 @@ PageSize ConPty::pageSize() const noexcept
     return size_;
 }
 
+bool ConPty::echoDisabled() const noexcept
+{
+    // The console's input mode is not observable from the pseudo console's host side.
+    return false;
+}
+
 void ConPty::resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels)
 {
     (void) _pixels; // TODO Can we pass that information, too?
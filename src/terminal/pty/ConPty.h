@@ -17,7 +17,6 @@
 
 #include <memory>
 #include <mutex>
-#include <vector>
 
 #include <Windows.h>
 
@@ -25,10 +24,16 @@ namespace terminal
 {
 
 /// ConPty implementation for newer Windows 10 versions.
+///
+/// The application's output is read through a named pipe in overlapped mode, so that read()
+/// can honor its timeout and be interrupted by wakeupReader().
 class ConPty: public Pty
 {
   public:
-    explicit ConPty(PageSize const& windowSize);
+    /// Size of the pipes' buffers, in bytes, if not explicitly given.
+    static constexpr size_t DefaultPipeBufferSize = 128 * 1024;
+
+    explicit ConPty(PageSize const& windowSize, size_t pipeBufferSize = DefaultPipeBufferSize);
     ~ConPty() override;
 
     void close() override;
@@ -40,6 +45,7 @@ class ConPty: public Pty
     void wakeupReader() override;
     int write(char const* buf, size_t size) override;
     PageSize pageSize() const noexcept override;
+    bool echoDisabled() const noexcept override;
     void resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels = std::nullopt) override;
 
     PtySlave& slave() noexcept override;
@@ -51,7 +57,9 @@ class ConPty: public Pty
     HPCON master_;
     HANDLE input_;
     HANDLE output_;
-    std::vector<char> buffer_;
+    HANDLE readEvent_;   // signaled when the pending read on input_ completed
+    HANDLE wakeupEvent_; // signaled by wakeupReader()
+    OVERLAPPED readOverlapped_ {};
     std::unique_ptr<PtySlave> slave_;
 };
 
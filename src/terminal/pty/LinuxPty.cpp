@@ -37,6 +37,7 @@
 #include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -58,6 +59,10 @@ namespace terminal
 
 namespace
 {
+    // How long the PTY master must stay quiet after the watched child process exited, until reading ends.
+    // Output written right before exiting may reach the master only after the exit has been noticed.
+    constexpr auto ChildExitLinger = std::chrono::milliseconds(20);
+
     LinuxPty::PtyHandles createLinuxPty(PageSize const& _windowSize, optional<ImageSize> _pixels)
     {
         // See https://code.woboq.org/userspace/glibc/login/forkpty.c.html
@@ -202,6 +207,7 @@ LinuxPty::LinuxPty(PtyHandles handles, PageSize pageSize):
 LinuxPty::~LinuxPty()
 {
     PtyLog()("PTY destroying master (file descriptor {}).", _masterFd);
+    detail::saveClose(&_pidFd);
     detail::saveClose(&_eventFd);
     detail::saveClose(&_epollFd);
     detail::saveClose(&_masterFd);
@@ -212,6 +218,17 @@ PtySlave& LinuxPty::slave() noexcept
     return _slave;
 }
 
+std::unique_ptr<PtySlave> LinuxPty::openSlave()
+{
+    auto const fd = detail::openSlave(_masterFd);
+    if (fd == -1)
+    {
+        PtyLog()("Failed to open PTY slave. {}", strerror(errno));
+        return nullptr;
+    }
+    return std::make_unique<Slave>(PtySlaveHandle::cast_from(fd));
+}
+
 PtyMasterHandle LinuxPty::handle() const noexcept
 {
     return PtyMasterHandle::cast_from(_masterFd);
@@ -221,6 +238,7 @@ void LinuxPty::close()
 {
     PtyLog()("PTY closing master (file descriptor {}).", _masterFd);
     detail::saveClose(&_masterFd);
+    _writeQueue.clear();
     wakeupReader();
 }
 
@@ -229,10 +247,43 @@ bool LinuxPty::isClosed() const noexcept
     return _masterFd == -1;
 }
 
+void LinuxPty::watchChildProcess(pid_t _pid) noexcept
+{
+#if defined(SYS_pidfd_open)
+    _pidFd = static_cast<int>(syscall(SYS_pidfd_open, _pid, 0));
+#else
+    errno = ENOSYS;
+#endif
+    if (_pidFd < 0)
+    {
+        PtyLog()("Cannot watch child process {} for exit. {}", _pid, strerror(errno));
+        _pidFd = -1;
+        return;
+    }
+
+    auto ev = epoll_event {};
+    ev.events = EPOLLIN;
+    ev.data.fd = _pidFd;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _pidFd, &ev) < 0)
+    {
+        PtyLog()("epoll setup failed to add pidfd. {}", strerror(errno));
+        detail::saveClose(&_pidFd);
+    }
+}
+
+void LinuxPty::unwatchChildProcess() noexcept
+{
+    PtyLog()("Child process exited.");
+    epoll_ctl(_epollFd, EPOLL_CTL_DEL, _pidFd, nullptr);
+    detail::saveClose(&_pidFd);
+    _childExited = true;
+}
+
 void LinuxPty::wakeupReader() noexcept
 {
-    uint64_t dummy {};
-    auto const rv = ::write(_eventFd, &dummy, sizeof(dummy));
+    // Adding zero would leave the eventfd unreadable.
+    uint64_t const increment = 1;
+    auto const rv = ::write(_eventFd, &increment, sizeof(increment));
     (void) rv;
 }
 
@@ -272,12 +323,26 @@ int LinuxPty::waitForReadable(std::chrono::milliseconds timeout) noexcept
 
     for (;;)
     {
-        int const rv =
-            epoll_wait(_epollFd, epollEvents.data(), epollEvents.size(), static_cast<int>(timeout.count()));
+        if (_childExited)
+            timeout = min(timeout, ChildExitLinger);
+        auto const timeoutMillis = timeout != Pty::NoTimeout ? static_cast<int>(timeout.count()) : -1;
+
+        // Watch for the master becoming writable only while there is queued input to write.
+        if (_masterWatchesWritable != _writeQueue.pending())
+        {
+            auto ev = epoll_event {};
+            ev.events = _writeQueue.pending() ? EPOLLIN | EPOLLOUT : EPOLLIN;
+            ev.data.fd = _masterFd;
+            if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, _masterFd, &ev) == 0)
+                _masterWatchesWritable = !_masterWatchesWritable;
+        }
+
+        int const rv = epoll_wait(_epollFd, epollEvents.data(), epollEvents.size(), timeoutMillis);
 
         if (rv == 0)
         {
-            errno = EAGAIN;
+            // Reading ends once the PTY stays quiet after the watched child process exited.
+            errno = _childExited && timeout == ChildExitLinger ? ECHILD : EAGAIN;
             return -1;
         }
 
@@ -288,8 +353,12 @@ int LinuxPty::waitForReadable(std::chrono::milliseconds timeout) noexcept
         }
 
         bool piped = false;
+        bool resumeWriter = false;
         for (size_t i = 0; i < static_cast<size_t>(rv); ++i)
         {
+            if (epollEvents[i].data.fd == _pidFd)
+                unwatchChildProcess();
+
             if (epollEvents[i].data.fd == _eventFd)
             {
                 uint64_t dummy {};
@@ -300,10 +369,19 @@ int LinuxPty::waitForReadable(std::chrono::milliseconds timeout) noexcept
                 return _stdoutFastPipe.reader();
 
             if (epollEvents[i].data.fd == _masterFd)
-                return _masterFd;
+            {
+                if (epollEvents[i].events & EPOLLOUT)
+                {
+                    _writeQueue.flush(_masterFd);
+                    resumeWriter = _writeQueue.writerMayResume();
+                }
+                if (epollEvents[i].events & ~EPOLLOUT)
+                    return _masterFd;
+            }
         }
 
-        if (piped)
+        // Interrupting the read gives the caller a chance to write what did not fit into the queue.
+        if (piped || resumeWriter)
         {
             errno = EINTR;
             return -1;
@@ -311,56 +389,89 @@ int LinuxPty::waitForReadable(std::chrono::milliseconds timeout) noexcept
     }
 }
 
+/// Appends what is pending on the PTY master already to the @p count bytes read into @p target,
+/// up to @p n bytes in total.
+///
+/// TIOCINQ sizes the reads, so that the drain never ends with a failing read,
+/// and the caller gets to parse bulk output in one large chunk rather than one per epoll_wait().
+string_view LinuxPty::drainMaster(char* target, size_t count, size_t n) noexcept
+{
+    while (count < n)
+    {
+        int pending = 0;
+        if (ioctl(_masterFd, TIOCINQ, &pending) < 0 || pending <= 0)
+            break;
+        auto const x = readSome(_masterFd, target + count, min(static_cast<size_t>(pending), n - count));
+        if (!x || x->empty())
+            break;
+        count += x->size();
+    }
+    return string_view { target, count };
+}
+
 Pty::ReadResult LinuxPty::read(crispy::BufferObject& sink, std::chrono::milliseconds timeout, size_t size)
 {
+    auto const n = min(size, sink.bytesAvailable());
+
+    // If the previous read filled the whole request, the application is most likely producing
+    // bulk output and more data is already pending. Read right away then, saving the wait call.
+    if (_masterSaturated && _masterFd != -1)
+    {
+        // Neither the stdout fastpipe nor wakeups are to wait for the bulk output to end,
+        // so these are checked without waiting first (all of these are non-blocking).
+        if (_stdoutFastPipe.reader() != -1)
+            if (auto x = readSome(_stdoutFastPipe.reader(), sink.hotEnd(), n))
+                return { tuple { x.value(), true } };
+
+        uint64_t dummy {};
+        if (::read(_eventFd, &dummy, sizeof(dummy)) > 0)
+        {
+            errno = EINTR;
+            return nullopt;
+        }
+
+        if (_writeQueue.pending())
+            _writeQueue.flush(_masterFd);
+        if (auto x = readSome(_masterFd, sink.hotEnd(), n))
+        {
+            auto const data = drainMaster(sink.hotEnd(), x->size(), n);
+            _masterSaturated = data.size() == n;
+            return { tuple { data, false } };
+        }
+        _masterSaturated = false;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return nullopt;
+    }
+
     if (int fd = waitForReadable(timeout); fd != -1)
-        if (auto x = readSome(fd, sink.hotEnd(), min(size, sink.bytesAvailable())))
-            return { tuple { x.value(), fd == _stdoutFastPipe.reader() } };
+        if (auto x = readSome(fd, sink.hotEnd(), n))
+        {
+            _masterSaturated = false;
+            if (fd != _masterFd)
+                return { tuple { x.value(), true } };
+            auto const data = drainMaster(sink.hotEnd(), x->size(), n);
+            _masterSaturated = data.size() == n;
+            return { tuple { data, false } };
+        }
 
     return nullopt;
 }
 
 int LinuxPty::write(char const* buf, size_t size)
 {
-    timeval tv {};
-    tv.tv_sec = 1;
-    tv.tv_usec = 0;
-
-    fd_set rfd, wfd, efd;
-    FD_ZERO(&rfd);
-    FD_ZERO(&wfd);
-    FD_ZERO(&efd);
-    FD_SET(_masterFd, &wfd);
-    FD_SET(_eventFd, &rfd);
-    auto const nfds = 1 + max(_masterFd, _eventFd);
-
-    if (select(nfds, &rfd, &wfd, &efd, &tv) < 0)
-        return -1;
-
-    if (!FD_ISSET(_masterFd, &wfd))
-    {
-        PtyOutLog()("PTY write of {} bytes timed out.\n", size);
-        return 0;
-    }
-
-    ssize_t rv = ::write(_masterFd, buf, size);
-    if (PtyOutLog)
+    if (_masterFd < 0)
     {
-        if (rv >= 0)
-            PtyOutLog()("Sending bytes: \"{}\"", crispy::escape(buf, buf + rv));
-
-        if (rv < 0)
-            // errorlog()("PTY write failed: {}", strerror(errno));
-            PtyOutLog()("PTY write of {} bytes failed. {}\n", size, strerror(errno));
-        else if (0 <= rv && static_cast<size_t>(rv) < size)
-            // clang-format off
-            PtyOutLog()("Partial write. {} bytes written and {} bytes left.",
-                        rv,
-                        size - static_cast<size_t>(rv));
-        // clang-format on
+        errno = ENODEV;
+        return -1;
     }
 
-    return static_cast<int>(rv);
+    // Never wait for the application to read its input. What the PTY does not accept right
+    // away is queued and written by the reader thread once the master becomes writable.
+    auto const wasPending = _writeQueue.pending();
+    auto const rv = _writeQueue.write(_masterFd, buf, size);
+    if (!wasPending && _writeQueue.pending())
+        wakeupReader();
+    return rv;
 }
 
 PageSize LinuxPty::pageSize() const noexcept
@@ -368,6 +479,16 @@ PageSize LinuxPty::pageSize() const noexcept
     return _pageSize;
 }
 
+bool LinuxPty::echoDisabled() const noexcept
+{
+    if (_masterFd < 0)
+        return false;
+
+    // The master side reports the line discipline settings of the slave side.
+    auto const tio = detail::getTerminalSettings(_masterFd);
+    return (tio.c_lflag & ICANON) && !(tio.c_lflag & ECHO);
+}
+
 void LinuxPty::resizeScreen(PageSize cells, std::optional<ImageSize> pixels)
 {
     if (_masterFd < 0)
@@ -15,12 +15,14 @@
 
 #include <terminal/pty/Pty.h>
 #include <terminal/pty/UnixPty.h> // UnixPipe (TODO: move somewhere else)
+#include <terminal/pty/UnixWriteQueue.h>
 
 #include <array>
 #include <optional>
 #include <vector>
 
 #include <pty.h>
+#include <sys/types.h>
 
 namespace terminal
 {
@@ -54,6 +56,7 @@ class LinuxPty: public Pty
     ~LinuxPty() override;
 
     PtySlave& slave() noexcept override;
+    [[nodiscard]] std::unique_ptr<PtySlave> openSlave() override;
 
     [[nodiscard]] PtyMasterHandle handle() const noexcept;
     void close() override;
@@ -64,20 +67,35 @@ class LinuxPty: public Pty
                                   size_t size) override;
     int write(char const* buf, size_t size) override;
     [[nodiscard]] PageSize pageSize() const noexcept override;
+    [[nodiscard]] bool echoDisabled() const noexcept override;
     void resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels = std::nullopt) override;
 
     UnixPipe& stdoutFastPipe() noexcept { return _stdoutFastPipe; }
 
+    /// Ends reading from this PTY once the given child process exited and its last output has been
+    /// read, even if other processes still hold the PTY slave open.
+    ///
+    /// The exit is noticed by the epoll loop via a pidfd, requiring no thread or signal handler.
+    /// Kernels without pidfd support leave the PTY open until its slave is closed by everyone.
+    void watchChildProcess(pid_t _pid) noexcept;
+
   private:
     std::optional<std::string_view> readSome(int fd, char* target, size_t n) noexcept;
+    std::string_view drainMaster(char* target, size_t count, size_t n) noexcept;
     int waitForReadable(std::chrono::milliseconds timeout) noexcept;
+    void unwatchChildProcess() noexcept;
 
     int _masterFd;
     int _epollFd;
     int _eventFd;
+    int _pidFd = -1;           // readable once the watched child process exited
+    bool _childExited = false; // whether the watched child process exited
     UnixPipe _stdoutFastPipe;
     PageSize _pageSize;
     Slave _slave;
+    bool _masterSaturated = false; // whether the last read from the master filled the whole request
+    UnixWriteQueue _writeQueue;
+    bool _masterWatchesWritable = false; // whether epoll reports the master becoming writable
 };
 
 } // namespace terminal
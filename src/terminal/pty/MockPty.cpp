@@ -42,6 +42,7 @@ int MockPty::write(char const* buf, size_t size)
 {
     // Writing into stdin.
     inputBuffer_ += std::string_view(buf, size);
+    ++writeCount_;
     return static_cast<int>(size);
 }
 
@@ -50,6 +51,11 @@ PageSize MockPty::pageSize() const noexcept
     return pageSize_;
 }
 
+bool MockPty::echoDisabled() const noexcept
+{
+    return echoDisabled_;
+}
+
 void MockPty::resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels)
 {
     pageSize_ = _cells;
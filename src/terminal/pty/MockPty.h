@@ -34,6 +34,7 @@ class MockPty: public Pty
     void wakeupReader() override;
     int write(char const* buf, size_t size) override;
     [[nodiscard]] PageSize pageSize() const noexcept override;
+    [[nodiscard]] bool echoDisabled() const noexcept override;
     void resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels = std::nullopt) override;
 
     void close() override;
@@ -41,6 +42,11 @@ class MockPty: public Pty
 
     std::string& stdinBuffer() noexcept { return inputBuffer_; }
 
+    /// Number of write() calls, i.e. of writes to the application's stdin.
+    [[nodiscard]] size_t writeCount() const noexcept { return writeCount_; }
+
+    void setEchoDisabled(bool _disabled) noexcept { echoDisabled_ = _disabled; }
+
     [[nodiscard]] bool isStdoutDataAvailable() const noexcept
     {
         return outputReadOffset_ < outputBuffer_.size();
@@ -63,9 +69,11 @@ class MockPty: public Pty
     PageSize pageSize_;
     std::optional<ImageSize> pixelSize_;
     std::string inputBuffer_;
+    size_t writeCount_ = 0;
     std::string outputBuffer_;
     std::size_t outputReadOffset_ = 0;
     bool closed_ = false;
+    bool echoDisabled_ = false;
     PtySlaveDummy slave_;
 };
 
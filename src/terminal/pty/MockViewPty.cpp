@@ -60,6 +60,11 @@ terminal::PageSize MockViewPty::pageSize() const noexcept
     return pageSize_;
 }
 
+bool MockViewPty::echoDisabled() const noexcept
+{
+    return false;
+}
+
 void MockViewPty::resizeScreen(terminal::PageSize _cells, std::optional<terminal::ImageSize> _pixels)
 {
     pageSize_ = _cells;
@@ -64,10 +64,19 @@ class Pty
   public:
     using ReadResult = std::optional<std::tuple<std::string_view, bool>>;
 
+    /// Timeout value for read() to wait until data is available or wakeupReader() is invoked.
+    static constexpr auto NoTimeout = std::chrono::milliseconds::max();
+
     virtual ~Pty() = default;
 
     virtual PtySlave& slave() noexcept = 0;
 
+    /// Opens another handle to the slave side, e.g. to write output into the terminal as if it was
+    /// written by the application, after slave() has been closed by the process spawning it.
+    ///
+    /// @returns the new handle, or nullptr if that is not supported.
+    [[nodiscard]] virtual std::unique_ptr<PtySlave> openSlave() { return nullptr; }
+
     /// Releases this PTY early.
     ///
     /// This is automatically invoked when the destructor is called.
@@ -80,7 +89,8 @@ class Pty
     /// of the terminal.
     ///
     /// @param storage Target buffer to store the read data to.
-    /// @param timeout Wait only for up to given timeout before giving up the blocking read attempt.
+    /// @param timeout Wait only for up to given timeout before giving up the blocking read attempt,
+    ///                or wait without a time limit if NoTimeout is given.
     /// @param size    The number of bytes to read at most, even if the storage has more bytes available.
     ///
     /// @returns A view to the consumed buffer. The boolean in the ReadResult
@@ -109,6 +119,12 @@ class Pty
     /// @returns current underlying window size in characters width and height.
     [[nodiscard]] virtual PageSize pageSize() const noexcept = 0;
 
+    /// Tests whether the line discipline reads whole lines without echoing them,
+    /// as is the case while a password is being prompted for.
+    ///
+    /// Raw mode does not count, as applications in raw mode echo input themselves (or not).
+    [[nodiscard]] virtual bool echoDisabled() const noexcept = 0;
+
     /// Resizes underlying window buffer by given character width and height.
     virtual void resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels = std::nullopt) = 0;
 };
@@ -47,6 +47,10 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#if defined(__APPLE__) || defined(__FreeBSD__)
+    #include <sys/event.h>
+#endif
+
 using crispy::BufferObject;
 using std::max;
 using std::min;
@@ -64,6 +68,10 @@ namespace terminal
 
 namespace
 {
+    // How long the PTY master must stay quiet after the watched child process exited, until reading ends.
+    // Output written right before exiting may reach the master only after the exit has been noticed.
+    constexpr auto ChildExitLinger = std::chrono::milliseconds(20);
+
     UnixPty::PtyHandles createUnixPty(PageSize const& _windowSize, optional<ImageSize> _pixels)
     {
         // See https://code.woboq.org/userspace/glibc/login/forkpty.c.html
@@ -247,6 +255,7 @@ UnixPty::UnixPty(PtyHandles handles, PageSize pageSize):
 UnixPty::~UnixPty()
 {
     PtyLog()("PTY destroying master (file descriptor {}).", _masterFd);
+    detail::saveClose(&_childWatchFd);
     detail::saveClose(&_pipe.at(0));
     detail::saveClose(&_pipe.at(1));
     detail::saveClose(&_masterFd);
@@ -257,6 +266,17 @@ PtySlave& UnixPty::slave() noexcept
     return _slave;
 }
 
+std::unique_ptr<PtySlave> UnixPty::openSlave()
+{
+    auto const fd = detail::openSlave(_masterFd);
+    if (fd == -1)
+    {
+        PtyLog()("Failed to open PTY slave. {}", strerror(errno));
+        return nullptr;
+    }
+    return std::make_unique<Slave>(PtySlaveHandle::cast_from(fd));
+}
+
 PtyMasterHandle UnixPty::handle() const noexcept
 {
     return PtyMasterHandle::cast_from(_masterFd);
@@ -266,6 +286,7 @@ void UnixPty::close()
 {
     PtyLog()("PTY closing master (file descriptor {}).", _masterFd);
     detail::saveClose(&_masterFd);
+    _writeQueue.clear();
     wakeupReader();
 }
 
@@ -274,6 +295,38 @@ bool UnixPty::isClosed() const noexcept
     return _masterFd == -1;
 }
 
+void UnixPty::watchChildProcess(pid_t _pid) noexcept
+{
+#if defined(__APPLE__) || defined(__FreeBSD__)
+    _childWatchFd = kqueue();
+    if (_childWatchFd < 0)
+    {
+        PtyLog()("Cannot watch child process {} for exit. {}", _pid, strerror(errno));
+        _childWatchFd = -1;
+        return;
+    }
+
+    struct kevent change {};
+    EV_SET(&change, _pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr);
+    if (kevent(_childWatchFd, &change, 1, nullptr, 0, nullptr) < 0)
+    {
+        // ESRCH: The process exited already.
+        _childExited = errno == ESRCH;
+        PtyLog()("Cannot watch child process {} for exit. {}", _pid, strerror(errno));
+        detail::saveClose(&_childWatchFd);
+    }
+#else
+    (void) _pid;
+#endif
+}
+
+void UnixPty::unwatchChildProcess() noexcept
+{
+    PtyLog()("Child process exited.");
+    detail::saveClose(&_childWatchFd);
+    _childExited = true;
+}
+
 void UnixPty::wakeupReader() noexcept
 {
     // TODO(Linux): Using eventfd() instead could lower potential abuse.
@@ -304,9 +357,34 @@ optional<string_view> UnixPty::readSome(int fd, char* target, size_t n) noexcept
     return string_view { target, static_cast<size_t>(rv) };
 }
 
+/// Appends what is pending on the PTY master already to the @p count bytes read into @p target,
+/// up to @p n bytes in total.
+///
+/// The pending byte count sizes the reads, so that the drain never ends with a failing read,
+/// and the caller gets to parse bulk output in one large chunk rather than one per select().
+string_view UnixPty::drainMaster(char* target, size_t count, size_t n) noexcept
+{
+    while (count < n)
+    {
+        int pending = 0;
+        if (ioctl(_masterFd, FIONREAD, &pending) < 0 || pending <= 0)
+            break;
+        auto const x = readSome(_masterFd, target + count, min(static_cast<size_t>(pending), n - count));
+        if (!x || x->empty())
+            break;
+        count += x->size();
+    }
+    return string_view { target, count };
+}
+
+/// Waits for any of the given file descriptors to become readable.
+///
+/// @p childWatch is reported only if neither the PTY master nor the stdout fastpipe is readable.
 int waitForReadable(int ptyMaster,
                     int stdoutFastPipe,
                     int wakeupPipe,
+                    int childWatch,
+                    UnixWriteQueue& writeQueue,
                     std::chrono::milliseconds timeout) noexcept
 {
     if (ptyMaster < 0)
@@ -329,12 +407,16 @@ int waitForReadable(int ptyMaster,
         FD_ZERO(&efd);
         if (ptyMaster != -1)
             FD_SET(ptyMaster, &rfd);
+        if (ptyMaster != -1 && writeQueue.pending())
+            FD_SET(ptyMaster, &wfd);
         if (stdoutFastPipe != -1)
             FD_SET(stdoutFastPipe, &rfd);
         FD_SET(wakeupPipe, &rfd);
-        auto const nfds = 1 + max(max(ptyMaster, stdoutFastPipe), wakeupPipe);
+        if (childWatch != -1)
+            FD_SET(childWatch, &rfd);
+        auto const nfds = 1 + max(max(ptyMaster, stdoutFastPipe), max(wakeupPipe, childWatch));
 
-        int rv = select(nfds, &rfd, &wfd, &efd, &tv);
+        int rv = select(nfds, &rfd, &wfd, &efd, timeout != Pty::NoTimeout ? &tv : nullptr);
         if (rv == 0)
         {
             // (Let's not be too verbose here.)
@@ -355,6 +437,13 @@ int waitForReadable(int ptyMaster,
             return -1;
         }
 
+        bool resumeWriter = false;
+        if (FD_ISSET(ptyMaster, &wfd))
+        {
+            writeQueue.flush(ptyMaster);
+            resumeWriter = writeQueue.writerMayResume();
+        }
+
         bool piped = false;
         if (FD_ISSET(wakeupPipe, &rfd))
         {
@@ -373,7 +462,11 @@ int waitForReadable(int ptyMaster,
         if (FD_ISSET(ptyMaster, &rfd))
             return ptyMaster;
 
-        if (piped)
+        if (childWatch != -1 && FD_ISSET(childWatch, &rfd))
+            return childWatch;
+
+        // Interrupting the read gives the caller a chance to write what did not fit into the queue.
+        if (piped || resumeWriter)
         {
             errno = EINTR;
             return -1;
@@ -383,54 +476,88 @@ int waitForReadable(int ptyMaster,
 
 Pty::ReadResult UnixPty::read(crispy::BufferObject& sink, std::chrono::milliseconds timeout, size_t size)
 {
-    if (int fd = waitForReadable(_masterFd, _stdoutFastPipe.reader(), _pipe[0], timeout); fd != -1)
-        if (auto x = readSome(fd, sink.hotEnd(), min(size, sink.bytesAvailable())))
-            return { tuple { x.value(), fd == _stdoutFastPipe.reader() } };
+    auto const n = min(size, sink.bytesAvailable());
 
-    return nullopt;
-}
-
-int UnixPty::write(char const* buf, size_t size)
-{
-    timeval tv {};
-    tv.tv_sec = 1;
-    tv.tv_usec = 0;
+    // If the previous read filled the whole request, the application is most likely producing
+    // bulk output and more data is already pending. Read right away then, saving the wait call.
+    if (_masterSaturated && _masterFd != -1)
+    {
+        // Neither the stdout fastpipe nor wakeups are to wait for the bulk output to end,
+        // so these are checked without waiting first (all of these are non-blocking).
+        if (_stdoutFastPipe.reader() != -1)
+            if (auto x = readSome(_stdoutFastPipe.reader(), sink.hotEnd(), n))
+                return { tuple { x.value(), true } };
+
+        auto woken = false;
+        char dummy[256];
+        while (::read(_pipe[0], dummy, sizeof(dummy)) > 0)
+            woken = true;
+        if (woken)
+        {
+            errno = EINTR;
+            return nullopt;
+        }
 
-    fd_set rfd, wfd, efd;
-    FD_ZERO(&rfd);
-    FD_ZERO(&wfd);
-    FD_ZERO(&efd);
-    FD_SET(_masterFd, &wfd);
-    FD_SET(_pipe[0], &rfd);
-    auto const nfds = 1 + max(_masterFd, _pipe[0]);
+        if (_writeQueue.pending())
+            _writeQueue.flush(_masterFd);
+        if (auto x = readSome(_masterFd, sink.hotEnd(), n))
+        {
+            auto const data = drainMaster(sink.hotEnd(), x->size(), n);
+            _masterSaturated = data.size() == n;
+            return { tuple { data, false } };
+        }
+        _masterSaturated = false;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return nullopt;
+    }
 
-    if (select(nfds, &rfd, &wfd, &efd, &tv) < 0)
-        return -1;
+    auto const wait = [&]() {
+        if (_childExited)
+            timeout = min(timeout, ChildExitLinger);
+        return terminal::waitForReadable(
+            _masterFd, _stdoutFastPipe.reader(), _pipe[0], _childWatchFd, _writeQueue, timeout);
+    };
 
-    if (!FD_ISSET(_masterFd, &wfd))
+    auto fd = wait();
+    if (fd != -1 && fd == _childWatchFd)
     {
-        PtyOutLog()("PTY write of {} bytes timed out.\n", size);
-        return 0;
+        unwatchChildProcess();
+        fd = wait();
     }
 
-    ssize_t rv = ::write(_masterFd, buf, size);
-    if (PtyOutLog)
-    {
-        if (rv >= 0)
-            PtyOutLog()("Sending bytes: \"{}\"", crispy::escape(buf, buf + rv));
+    // Reading ends once the PTY stays quiet after the watched child process exited.
+    if (fd == -1 && errno == EAGAIN && _childExited && timeout == ChildExitLinger)
+        errno = ECHILD;
 
-        if (rv < 0)
-            // errorlog()("PTY write failed: {}", strerror(errno));
-            PtyOutLog()("PTY write of {} bytes failed. {}\n", size, strerror(errno));
-        else if (0 <= rv && static_cast<size_t>(rv) < size)
-            // clang-format off
-            PtyOutLog()("Partial write. {} bytes written and {} bytes left.",
-                        rv,
-                        size - static_cast<size_t>(rv));
-        // clang-format on
+    if (fd != -1)
+        if (auto x = readSome(fd, sink.hotEnd(), n))
+        {
+            _masterSaturated = false;
+            if (fd != _masterFd)
+                return { tuple { x.value(), true } };
+            auto const data = drainMaster(sink.hotEnd(), x->size(), n);
+            _masterSaturated = data.size() == n;
+            return { tuple { data, false } };
+        }
+
+    return nullopt;
+}
+
+int UnixPty::write(char const* buf, size_t size)
+{
+    if (_masterFd < 0)
+    {
+        errno = ENODEV;
+        return -1;
     }
 
-    return static_cast<int>(rv);
+    // Never wait for the application to read its input. What the PTY does not accept right
+    // away is queued and written by the reader thread once the master becomes writable.
+    auto const wasPending = _writeQueue.pending();
+    auto const rv = _writeQueue.write(_masterFd, buf, size);
+    if (!wasPending && _writeQueue.pending())
+        wakeupReader();
+    return rv;
 }
 
 PageSize UnixPty::pageSize() const noexcept
@@ -438,6 +565,16 @@ PageSize UnixPty::pageSize() const noexcept
     return _pageSize;
 }
 
+bool UnixPty::echoDisabled() const noexcept
+{
+    if (_masterFd < 0)
+        return false;
+
+    // The master side reports the line discipline settings of the slave side.
+    auto const tio = detail::getTerminalSettings(_masterFd);
+    return (tio.c_lflag & ICANON) && !(tio.c_lflag & ECHO);
+}
+
 void UnixPty::resizeScreen(PageSize cells, std::optional<ImageSize> pixels)
 {
     if (_masterFd < 0)
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <terminal/pty/Pty.h>
+#include <terminal/pty/UnixWriteQueue.h>
 
 #include <array>
 #include <optional>
@@ -25,6 +26,8 @@
     #include <pty.h>
 #endif
 
+#include <sys/types.h>
+
 namespace terminal
 {
 
@@ -79,6 +82,7 @@ class UnixPty: public Pty
     ~UnixPty() override;
 
     PtySlave& slave() noexcept override;
+    [[nodiscard]] std::unique_ptr<PtySlave> openSlave() override;
 
     PtyMasterHandle handle() const noexcept;
     void close() override;
@@ -89,18 +93,32 @@ class UnixPty: public Pty
                                   size_t size) override;
     int write(char const* buf, size_t size) override;
     PageSize pageSize() const noexcept override;
+    bool echoDisabled() const noexcept override;
     void resizeScreen(PageSize _cells, std::optional<ImageSize> _pixels = std::nullopt) override;
 
     UnixPipe& stdoutFastPipe() noexcept { return _stdoutFastPipe; }
 
+    /// Ends reading from this PTY once the given child process exited and its last output has been
+    /// read, even if other processes still hold the PTY slave open.
+    ///
+    /// The exit is noticed by the select() loop via a kqueue (EVFILT_PROC) where available.
+    /// Elsewhere the PTY stays open until its slave is closed by everyone.
+    void watchChildProcess(pid_t _pid) noexcept;
+
   private:
     std::optional<std::string_view> readSome(int fd, char* target, size_t n) noexcept;
+    std::string_view drainMaster(char* target, size_t count, size_t n) noexcept;
+    void unwatchChildProcess() noexcept;
 
     int _masterFd;
     std::array<int, 2> _pipe;
+    int _childWatchFd = -1;    // kqueue, readable once the watched child process exited
+    bool _childExited = false; // whether the watched child process exited
     UnixPipe _stdoutFastPipe;
     PageSize _pageSize;
     Slave _slave;
+    bool _masterSaturated = false; // whether the last read from the master filled the whole request
+    UnixWriteQueue _writeQueue;
 };
 
 } // namespace terminal
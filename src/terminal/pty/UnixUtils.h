@@ -21,6 +21,10 @@
     #include <termios.h>
 #endif
 
+#include <cstdlib>
+
+#include <sys/ioctl.h>
+
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -32,6 +36,7 @@ termios constructTerminalSettings(int fd) noexcept;
 bool setFileFlags(int fd, int flags) noexcept;
 void saveClose(int* fd) noexcept;
 void saveDup2(int a, int b) noexcept;
+int openSlave(int masterFd) noexcept;
 
 // {{{ impl
 inline termios getTerminalSettings(int fd) noexcept
@@ -87,6 +92,18 @@ inline void saveDup2(int a, int b) noexcept
     while (dup2(a, b) == -1 && (errno == EBUSY || errno == EINTR))
         ;
 }
+
+/// Opens the slave side of the PTY with the given master for writing, returning -1 on failure.
+inline int openSlave(int masterFd) noexcept
+{
+#if defined(TIOCGPTPEER)
+    // Does not depend on the slave's device node being accessible.
+    if (auto const fd = ioctl(masterFd, TIOCGPTPEER, O_WRONLY | O_NOCTTY | O_CLOEXEC); fd != -1)
+        return fd;
+#endif
+    auto const* name = ptsname(masterFd);
+    return name ? ::open(name, O_WRONLY | O_NOCTTY | O_CLOEXEC) : -1;
+}
 // }}}
 
 } // namespace terminal::detail
@@ -0,0 +1,126 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <terminal/pty/Pty.h>
+#include <terminal/pty/UnixWriteQueue.h>
+
+#include <crispy/escape.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace terminal
+{
+
+int UnixWriteQueue::writeSome(int _fd, char const* _buf, size_t _size)
+{
+    auto const rv = ::write(_fd, _buf, _size);
+    if (rv < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+
+    if (PtyOutLog)
+    {
+        if (rv < 0)
+            PtyOutLog()("PTY write of {} bytes failed. {}\n", _size, strerror(errno));
+        else
+            PtyOutLog()("Sending bytes: \"{}\"", crispy::escape(_buf, _buf + rv));
+    }
+
+    return static_cast<int>(rv);
+}
+
+int UnixWriteQueue::write(int _fd, char const* _buf, size_t _size)
+{
+    auto const _ = lock_guard { mutex_ };
+
+    auto written = size_t { 0 };
+    if (!pending())
+    {
+        auto const rv = writeSome(_fd, _buf, _size);
+        if (rv < 0)
+            return -1;
+        written = static_cast<size_t>(rv);
+        if (written == _size)
+            return static_cast<int>(written);
+    }
+
+    auto const queued = min(_size - written, capacity_ - min(capacity_, queue_.size() - front_));
+    queue_.insert(queue_.end(), _buf + written, _buf + written + queued);
+    if (queued)
+    {
+        PtyOutLog()("Queued {} bytes, {} bytes pending.", queued, queue_.size() - front_);
+        pending_ = true;
+    }
+    if (written + queued < _size)
+        refused_ = true;
+
+    return static_cast<int>(written + queued);
+}
+
+bool UnixWriteQueue::flush(int _fd)
+{
+    auto const _ = lock_guard { mutex_ };
+    if (!pending())
+        return true;
+
+    auto const rv = writeSome(_fd, queue_.data() + front_, queue_.size() - front_);
+    if (rv < 0)
+    {
+        queue_.clear();
+        front_ = 0;
+        pending_ = false;
+        return false;
+    }
+
+    front_ += static_cast<size_t>(rv);
+    if (front_ == queue_.size())
+    {
+        queue_.clear();
+        front_ = 0;
+        pending_ = false;
+    }
+    else if (front_ >= queue_.size() / 2)
+    {
+        // Compact, so that writing a large paste does not keep its whole text around.
+        queue_.erase(queue_.begin(), queue_.begin() + static_cast<ptrdiff_t>(front_));
+        front_ = 0;
+    }
+    return true;
+}
+
+bool UnixWriteQueue::writerMayResume()
+{
+    auto const _ = lock_guard { mutex_ };
+    if (!refused_ || queue_.size() - front_ > capacity_ / 2)
+        return false;
+
+    refused_ = false;
+    return true;
+}
+
+void UnixWriteQueue::clear()
+{
+    auto const _ = lock_guard { mutex_ };
+    queue_.clear();
+    queue_.shrink_to_fit();
+    front_ = 0;
+    refused_ = false;
+    pending_ = false;
+}
+
+} // namespace terminal
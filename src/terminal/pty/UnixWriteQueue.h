@@ -0,0 +1,73 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace terminal
+{
+
+/**
+ * Output queue in front of a non-blocking PTY master, so that writers never wait for the
+ * application on the other end to read its input.
+ *
+ * write() writes as much as the PTY accepts right away and queues the remainder, which the
+ * PTY's reader thread flushes as soon as the master becomes writable again. The queue only
+ * accepts up to its capacity, so a stalled application pushes back on the writer instead of
+ * letting the queue grow without bounds.
+ */
+class UnixWriteQueue
+{
+  public:
+    static constexpr size_t DefaultCapacity = 4 * 1024 * 1024;
+
+    explicit UnixWriteQueue(size_t _capacity = DefaultCapacity): capacity_ { _capacity } {}
+
+    /// Writes the given bytes into @p _fd, queuing what it does not accept right away.
+    ///
+    /// @returns the number of bytes written or queued, which is less than @p _size only if
+    ///          the queue is full, or -1 on error.
+    int write(int _fd, char const* _buf, size_t _size);
+
+    /// Writes queued bytes into @p _fd, as far as it accepts them.
+    ///
+    /// @retval false the write failed and the queue has been dropped.
+    bool flush(int _fd);
+
+    /// @returns whether bytes are queued, and thus waiting for @p _fd to become writable.
+    [[nodiscard]] bool pending() const noexcept { return pending_.load(std::memory_order_acquire); }
+
+    /// @returns whether a write has been cut short for lack of capacity, and flushing has made room
+    ///          for at least half of the capacity since, so that the writer should write the
+    ///          remainder now. Returns true only once per short write.
+    [[nodiscard]] bool writerMayResume();
+
+    /// Drops all queued bytes, e.g. when the PTY gets closed.
+    void clear();
+
+  private:
+    int writeSome(int _fd, char const* _buf, size_t _size);
+
+    size_t const capacity_;
+    std::mutex mutex_;
+    std::vector<char> queue_;
+    size_t front_ = 0;     // Offset of the first byte in queue_ not yet written.
+    bool refused_ = false; // Whether a write has been cut short since the writer last resumed.
+    std::atomic<bool> pending_ = false;
+};
+
+} // namespace terminal
@@ -0,0 +1,60 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2019-2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+// Helpers shared by the tests operating on a Grid directly.
+
+#include <terminal/Cell.h>
+#include <terminal/Grid.h>
+#include <terminal/primitives.h>
+
+#include <initializer_list>
+#include <string_view>
+
+namespace terminal::test
+{
+
+/// Constructs a grid with the given lines, all but the last page full of them scrolled into history.
+inline Grid<Cell> setupGrid(PageSize _pageSize, std::initializer_list<std::string_view> _lines)
+{
+    auto grid = Grid<Cell>(_pageSize, false, LineCount(100));
+    int cursor = 0;
+    for (std::string_view line: _lines)
+    {
+        if (cursor == *_pageSize.lines)
+            grid.scrollUp(LineCount(1));
+        else
+            ++cursor;
+        grid.setLineText(LineOffset::cast_from(cursor - 1), line);
+    }
+    return grid;
+}
+
+/// Writes US-ASCII @p _text into the grid's top line, starting at @p _column.
+inline void writeText(Grid<Cell>& _grid,
+                      int _column,
+                      std::string_view _text,
+                      GraphicsAttributes _attributes = {})
+{
+    for (char const ch: _text)
+        _grid.useCellAt(LineOffset(0), ColumnOffset(_column++))
+            .write(_attributes, static_cast<char32_t>(ch), 1);
+}
+
+constexpr CellLocation at(int _line, int _column) noexcept
+{
+    return CellLocation { LineOffset(_line), ColumnOffset(_column) };
+}
+
+} // namespace terminal::test
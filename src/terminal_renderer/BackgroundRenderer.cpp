@@ -36,16 +36,54 @@ void BackgroundRenderer::setRenderTarget(RenderTarget& renderTarget,
 
 void BackgroundRenderer::renderCell(RenderCell const& _cell)
 {
-    if (_cell.backgroundColor == defaultColor_)
+    renderCells(_cell.position, 1, _cell.backgroundColor);
+}
+
+void BackgroundRenderer::renderRun(RenderRun const& _run)
+{
+    renderCells(_run.start, unbox<int>(_run.length), _run.backgroundColor);
+}
+
+void BackgroundRenderer::renderCells(CellLocation _start, int _cellCount, RGBColor _color)
+{
+    if (_color == defaultColor_)
+    {
+        flushPendingRun();
+        return;
+    }
+
+    auto const continuesRun = pendingRun_.cellCount != 0 && pendingRun_.color == _color
+                              && pendingRun_.start.line == _start.line
+                              && pendingRun_.start.column + pendingRun_.cellCount == _start.column;
+    if (continuesRun)
+    {
+        pendingRun_.cellCount += _cellCount;
         return;
+    }
 
-    auto const pos = _gridMetrics.map(_cell.position);
+    flushPendingRun();
+    pendingRun_ = BackgroundRun { _start, _cellCount, _color };
+}
+
+void BackgroundRenderer::endFrame()
+{
+    flushPendingRun();
+}
+
+void BackgroundRenderer::flushPendingRun()
+{
+    if (!pendingRun_.cellCount)
+        return;
+
+    auto const pos = _gridMetrics.map(pendingRun_.start);
 
     renderTarget().renderRectangle(pos.x,
                                    pos.y,
-                                   _gridMetrics.cellSize.width,
+                                   _gridMetrics.cellSize.width * static_cast<unsigned>(pendingRun_.cellCount),
                                    _gridMetrics.cellSize.height,
-                                   RGBAColor(_cell.backgroundColor, opacity_));
+                                   RGBAColor(pendingRun_.color, opacity_));
+
+    pendingRun_.cellCount = 0;
 }
 
 void BackgroundRenderer::inspect(std::ostream& /*output*/) const
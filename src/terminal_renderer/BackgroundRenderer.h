@@ -43,14 +43,35 @@ class BackgroundRenderer: public Renderable
     // because there is no need to detect bg/fg color more than once per grid cell!
 
     /// Queues up a render with given background
+    ///
+    /// Horizontally adjacent cells of the same background color are coalesced
+    /// into a single rectangle, which is rendered once the run ends.
     void renderCell(RenderCell const& _cell);
 
+    /// Queues up the background of a whole run of cells, coalesced like the background of single cells.
+    void renderRun(RenderRun const& _run);
+
+    /// Renders any pending background run. Must be invoked after the last cell of a frame.
+    void endFrame();
+
     void inspect(std::ostream& output) const override;
 
   private:
+    void renderCells(CellLocation _start, int _cellCount, RGBColor _color);
+    void flushPendingRun();
+
     // private data
     RGBColor const& defaultColor_;
     uint8_t opacity_ = 255;
+
+    // The currently accumulated run of same-colored cells on a single line.
+    struct BackgroundRun
+    {
+        CellLocation start {};
+        int cellCount = 0;
+        RGBColor color {};
+    };
+    BackgroundRun pendingRun_ {};
 };
 
 } // namespace terminal::renderer
@@ -24,6 +24,7 @@
 #include <range/v3/view/zip.hpp>
 
 #include <array>
+#include <thread>
 
 using namespace std::string_view_literals;
 
@@ -902,6 +903,57 @@ void BoxDrawingRenderer::clearCache()
 {
     // As we're reusing the upper layer's texture atlas, we do not need
     // to clear here anything. It's done for us already.
+    // But the grid metrics may have changed, so rasterize everything again.
+    startPrerasterization();
+}
+
+void BoxDrawingRenderer::startPrerasterization()
+{
+    if (prerasterization_)
+        prerasterization_->cancelled = true;
+    prerasterizedBitmaps_.clear();
+
+    if (!*_gridMetrics.cellSize.width || !*_gridMetrics.cellSize.height)
+        return;
+
+    auto job = std::make_shared<Prerasterization>();
+    job->gridMetrics = _gridMetrics;
+    prerasterization_ = job;
+
+    std::thread([job]() {
+        // The worker uses its own renderer instance (and grid metrics copy) purely for rasterization.
+        auto rasterizer = BoxDrawingRenderer { job->gridMetrics };
+        auto const rasterizeRange = [&](char32_t first, char32_t last) {
+            for (char32_t codepoint = first; codepoint <= last && !job->cancelled; ++codepoint)
+                if (rasterizer.renderable(codepoint))
+                    if (auto bitmap = rasterizer.rasterize(codepoint))
+                        job->bitmaps.emplace_back(codepoint, std::move(*bitmap));
+        };
+        try
+        {
+            rasterizeRange(0x2500, 0x259F);   // box drawing, block elements
+            rasterizeRange(0xE0B0, 0xE0BE);   // powerline
+            rasterizeRange(0x23A1, 0x23A6);   // mathematical square brackets
+            rasterizeRange(0xEE00, 0xEE05);   // progress bar (Fira Code)
+            rasterizeRange(0x1FB00, 0x1FBAF); // more block sextants
+            rasterizeRange(0x1FBF0, 0x1FBF9); // digits
+        }
+        catch (...)
+        {
+            job->bitmaps.clear();
+        }
+        job->finished = true;
+    }).detach();
+}
+
+void BoxDrawingRenderer::collectPrerasterization()
+{
+    if (!prerasterization_ || !prerasterization_->finished)
+        return;
+
+    for (auto& [codepoint, bitmap]: prerasterization_->bitmaps)
+        prerasterizedBitmaps_.emplace(codepoint, std::move(bitmap));
+    prerasterization_.reset();
 }
 
 bool BoxDrawingRenderer::render(LineOffset _line, ColumnOffset _column, char32_t _codepoint, RGBColor _color)
@@ -937,16 +989,31 @@ constexpr inline bool containsNonCanonicalLines(char32_t codepoint)
 auto BoxDrawingRenderer::createTileData(char32_t codepoint, atlas::TileLocation tileLocation)
     -> optional<TextureAtlas::TileCreateData>
 {
-    if (optional<atlas::Buffer> image = buildElements(codepoint))
+    optional<atlas::Buffer> pixels;
+    if (auto i = prerasterizedBitmaps_.find(codepoint); i != prerasterizedBitmaps_.end())
     {
-        return { createTileData(tileLocation,
-                                move(*image),
-                                atlas::Format::Red,
-                                _gridMetrics.cellSize,
-                                RenderTileAttributes::X { 0 },
-                                RenderTileAttributes::Y { 0 },
-                                FRAGMENT_SELECTOR_GLYPH_ALPHA) };
+        pixels = move(i->second);
+        prerasterizedBitmaps_.erase(i);
     }
+    else
+        pixels = rasterize(codepoint);
+
+    if (!pixels)
+        return nullopt;
+
+    return { createTileData(tileLocation,
+                            move(*pixels),
+                            atlas::Format::Red,
+                            _gridMetrics.cellSize,
+                            RenderTileAttributes::X { 0 },
+                            RenderTileAttributes::Y { 0 },
+                            FRAGMENT_SELECTOR_GLYPH_ALPHA) };
+}
+
+optional<atlas::Buffer> BoxDrawingRenderer::rasterize(char32_t codepoint)
+{
+    if (optional<atlas::Buffer> image = buildElements(codepoint))
+        return image;
 
     auto const antialiasing = containsNonCanonicalLines(codepoint);
     atlas::Buffer pixels;
@@ -978,17 +1045,13 @@ auto BoxDrawingRenderer::createTileData(char32_t codepoint, atlas::TileLocation
         pixels = move(*tmp);
     }
 
-    return { createTileData(tileLocation,
-                            move(pixels),
-                            atlas::Format::Red,
-                            _gridMetrics.cellSize,
-                            RenderTileAttributes::X { 0 },
-                            RenderTileAttributes::Y { 0 },
-                            FRAGMENT_SELECTOR_GLYPH_ALPHA) };
+    return pixels;
 }
 
 Renderable::AtlasTileAttributes const* BoxDrawingRenderer::getOrCreateCachedTileAttributes(char32_t codepoint)
 {
+    collectPrerasterization();
+
     return textureAtlas().get_or_try_emplace(
         crispy::StrongHash { 31, 13, 8, static_cast<uint32_t>(codepoint) },
         [this, codepoint](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
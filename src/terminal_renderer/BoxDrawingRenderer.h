@@ -22,6 +22,11 @@
 #include <crispy/point.h>
 
 #include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace terminal::renderer
 {
@@ -53,6 +58,16 @@ class BoxDrawingRenderer: public Renderable
     void inspect(std::ostream& output) const override;
 
   private:
+    /// Rasterizes all renderable codepoints for the current grid metrics on a worker thread,
+    /// so that tiles needed later on need not be rasterized in the middle of a frame.
+    void startPrerasterization();
+
+    /// Takes over the bitmaps of a finished pre-rasterization, if any.
+    void collectPrerasterization();
+
+    /// Rasterizes the given codepoint into a cell-sized alpha bitmap.
+    [[nodiscard]] std::optional<atlas::Buffer> rasterize(char32_t codepoint);
+
     AtlasTileAttributes const* getOrCreateCachedTileAttributes(char32_t codepoint);
 
     using Renderable::createTileData;
@@ -63,6 +78,20 @@ class BoxDrawingRenderer: public Renderable
                                                                 ImageSize _size,
                                                                 int _lineThickness);
     [[nodiscard]] std::optional<atlas::Buffer> buildElements(char32_t codepoint);
+
+    // State shared with the pre-rasterization worker thread.
+    struct Prerasterization
+    {
+        GridMetrics gridMetrics;
+        std::atomic<bool> cancelled { false };
+        std::atomic<bool> finished { false };
+        std::vector<std::pair<char32_t, atlas::Buffer>> bitmaps {}; // owned by the worker until finished
+    };
+
+    std::shared_ptr<Prerasterization> prerasterization_;
+
+    // Pre-rasterized bitmaps that have not been uploaded into the texture atlas yet.
+    std::unordered_map<char32_t, atlas::Buffer> prerasterizedBitmaps_;
 };
 
 } // namespace terminal::renderer
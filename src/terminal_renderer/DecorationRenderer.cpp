@@ -111,6 +111,13 @@ void DecorationRenderer::renderCell(RenderCell const& _cell)
                 mapping.second, _gridMetrics.map(_cell.position), ColumnCount(1), _cell.decorationColor);
 }
 
+void DecorationRenderer::renderRun(RenderRun const& _run)
+{
+    for (auto const& mapping: CellFlagDecorationMappings)
+        if (_run.flags & mapping.first)
+            renderDecoration(mapping.second, _gridMetrics.map(_run.start), _run.length, _run.decorationColor);
+}
+
 auto DecorationRenderer::createTileData(Decorator decoration, atlas::TileLocation tileLocation)
     -> TextureAtlas::TileCreateData
 {
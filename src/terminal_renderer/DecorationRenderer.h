@@ -50,6 +50,7 @@ class DecorationRenderer: public Renderable
     }
 
     void renderCell(RenderCell const& _cell);
+    void renderRun(RenderRun const& _run);
 
     void renderDecoration(Decorator _decoration,
                           crispy::Point _pos,
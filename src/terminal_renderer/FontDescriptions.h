@@ -38,6 +38,13 @@ struct FontDescriptions
     TextShapingEngine textShapingEngine = TextShapingEngine::OpenShaper;
     FontLocatorEngine fontLocator = FontLocatorEngine::FontConfig;
     bool builtinBoxDrawing = true;
+
+    // Renders the glyphs of the primary fonts from signed distance fields that are rasterized once
+    // at a reference size, instead of rasterizing them again for every font size.
+    bool signedDistanceFields = false;
+
+    // Keeps rasterized glyphs in an on-disk cache across restarts (OpenShaper only).
+    bool glyphCache = true;
 };
 
 inline bool operator==(FontDescriptions const& a, FontDescriptions const& b) noexcept
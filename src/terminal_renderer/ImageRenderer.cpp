@@ -45,8 +45,32 @@ void ImageRenderer::setCellSize(ImageSize _cellSize)
     // TODO: recompute rasterized images slices here?
 }
 
+void ImageRenderer::beginFrame()
+{
+    fragmentRuns_.clear();
+}
+
 void ImageRenderer::renderImage(crispy::Point _pos, ImageFragment const& fragment)
 {
+    if (textureMode_)
+    {
+        auto const width = unbox<int>(cellSize_.width);
+        if (!fragmentRuns_.empty())
+        {
+            auto& run = fragmentRuns_.back();
+            if (run.image.get() == &fragment.rasterizedImage() && run.offset.line == fragment.offset().line
+                && *run.offset.column + run.count == *fragment.offset().column
+                && run.position.y == _pos.y && run.position.x + run.count * width == _pos.x)
+            {
+                ++run.count;
+                return;
+            }
+        }
+        fragmentRuns_.emplace_back(
+            FragmentRun { fragment.rasterizedImage().shared_from_this(), _pos, fragment.offset(), 1 });
+        return;
+    }
+
     // std::cout << fmt::format("ImageRenderer.renderImage: {}\n", fragment);
 
     AtlasTileAttributes const* tileAttributes = getOrCreateCachedTileAttributes(fragment);
@@ -76,6 +100,7 @@ Renderable::AtlasTileAttributes const* ImageRenderer::getOrCreateCachedTileAttri
 
     return textureAtlas().get_or_try_emplace(
         hash, [&](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
+            ++ImageStats::get().uploads;
             return createTileData(tileLocation,
                                   fragment.data(),
                                   atlas::Format::RGBA,
@@ -87,16 +112,96 @@ Renderable::AtlasTileAttributes const* ImageRenderer::getOrCreateCachedTileAttri
         });
 }
 
-void ImageRenderer::discardImage(ImageId /*_imageId*/)
+void ImageRenderer::mergeFragmentRuns()
 {
-    // We currently don't really discard.
-    // Because the GPU texture atlas is resource-guarded by an LRU hashtable.
+    auto const targetHeight = unbox<int>(cellSize_.height);
+
+    // The runs are in the order of rendering, line by line from the top.
+    auto mergedCount = size_t { 0 };
+    for (size_t i = 0; i < fragmentRuns_.size(); ++i)
+    {
+        auto& run = fragmentRuns_[i];
+        if (auto const last = lastRunOfImage_.find(run.image.get()); last != lastRunOfImage_.end())
+        {
+            auto& above = fragmentRuns_[last->second];
+            if (above.count == run.count && above.offset.column == run.offset.column
+                && above.position.x == run.position.x
+                && *above.offset.line + above.lineCount == *run.offset.line
+                && above.position.y - above.lineCount * targetHeight == run.position.y)
+            {
+                ++above.lineCount;
+                continue;
+            }
+        }
+        lastRunOfImage_[run.image.get()] = mergedCount;
+        if (i != mergedCount)
+            fragmentRuns_[mergedCount] = std::move(run);
+        ++mergedCount;
+    }
+    fragmentRuns_.resize(mergedCount);
+    lastRunOfImage_.clear();
+}
+
+void ImageRenderer::endFrame()
+{
+    auto const targetWidth = unbox<int>(cellSize_.width);
+    auto const targetHeight = unbox<int>(cellSize_.height);
+
+    mergeFragmentRuns();
+
+    for (FragmentRun const& run: fragmentRuns_)
+    {
+        RasterizedImage const& image = *run.image;
+        auto const clipRect = PixelRect { run.position.x,
+                                          run.position.y - (run.lineCount - 1) * targetHeight,
+                                          run.count * targetWidth,
+                                          run.lineCount * targetHeight };
+
+        if (image.defaultColor().alpha() != 0)
+            renderTarget().renderRectangle(clipRect.x,
+                                           clipRect.y,
+                                           Width::cast_from(clipRect.width),
+                                           Height::cast_from(clipRect.height),
+                                           image.defaultColor());
+
+        // The image was sliced for the cell size at the time it was placed and is scaled from
+        // there to the current cell size, as it is for atlas tiles.
+        auto const cellWidth = unbox<int>(image.cellSize().width);
+        auto const cellHeight = unbox<int>(image.cellSize().height);
+        if (!cellWidth || !cellHeight)
+            continue;
+        auto const scaleX = double(targetWidth) / double(cellWidth);
+        auto const scaleY = double(targetHeight) / double(cellHeight);
+
+        // Placement is relative to the top left of the grid area, growing downwards.
+        auto const placement = image.placement();
+        auto const left = double(placement.x - *run.offset.column * cellWidth) * scaleX;
+        auto const top = double(placement.y - *run.offset.line * cellHeight) * scaleY;
+        auto const width = int(double(placement.width) * scaleX);
+        auto const height = int(double(placement.height) * scaleY);
+        auto const imageRect = PixelRect { run.position.x + int(left),
+                                           run.position.y + targetHeight - int(top) - height,
+                                           width,
+                                           height };
+
+        renderTarget().renderImage(image.imagePointer(), imageRect, clipRect);
+    }
+    fragmentRuns_.clear();
+}
+
+void ImageRenderer::discardImage(ImageId _imageId)
+{
+    // Atlas tiles are not discarded explicitly,
+    // because the GPU texture atlas is resource-guarded by an LRU hashtable.
+    if (renderTargetAvailable())
+        renderTarget().discardImage(_imageId);
 }
 
 void ImageRenderer::clearCache()
 {
     // We currently don't really clean up anything.
     // Because the GPU texture atlas is resource-guarded by an LRU hashtable.
+    fragmentRuns_.clear();
 }
 
 void ImageRenderer::inspect(std::ostream& /*output*/) const
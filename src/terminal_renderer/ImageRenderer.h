@@ -62,7 +62,14 @@ class ImageRenderer: public Renderable
     /// Reconfigures the slicing properties of existing images.
     void setCellSize(ImageSize _cellSize);
 
+    /// Selects whether images are rendered as one texture each (leaving the texture atlas
+    /// to glyphs), or as per grid cell tiles in the texture atlas (default).
+    void setTextureMode(bool _enabled) noexcept { textureMode_ = _enabled; }
+    bool textureMode() const noexcept { return textureMode_; }
+
+    void beginFrame();
     void renderImage(crispy::Point _pos, ImageFragment const& fragment);
+    void endFrame();
 
     /// notify underlying cache that this fragment is not going to be rendered anymore, maybe freeing up some
     /// GPU caches.
@@ -73,9 +80,27 @@ class ImageRenderer: public Renderable
   private:
     AtlasTileAttributes const* getOrCreateCachedTileAttributes(ImageFragment const& fragment);
 
+    /// Adjacent fragments of the same image, rendered in texture mode: a run of fragments on one
+    /// line, or a rectangle of equal runs on consecutive lines.
+    struct FragmentRun
+    {
+        std::shared_ptr<RasterizedImage const> image;
+        crispy::Point position; //!< render position of the first fragment (of the top line)
+        CellLocation offset;    //!< grid offset of the first fragment into the image
+        int count;              //!< number of fragments per line
+        int lineCount = 1;      //!< number of lines
+    };
+
+    /// Merges the runs of consecutive lines covering the same columns of an image, so that
+    /// an image is rendered by a single call, rather than by one per line.
+    void mergeFragmentRuns();
+
     // private data
     //
     ImageSize cellSize_;
+    bool textureMode_ = false;
+    std::vector<FragmentRun> fragmentRuns_;
+    std::unordered_map<RasterizedImage const*, size_t> lastRunOfImage_; // used by mergeFragmentRuns()
 };
 
 } // namespace terminal::renderer
@@ -51,8 +51,7 @@ auto Renderable::createTileData(atlas::TileLocation tileLocation,
     tileData.metadata.x = x;
     tileData.metadata.y = y;
     tileData.metadata.fragmentShaderSelector = fragmentShaderSelector;
-    tileData.metadata.normalizedLocation.x = static_cast<float>(tileLocation.x.value) / unbox<float>(atlasSize.width);
-    tileData.metadata.normalizedLocation.y = static_cast<float>(tileLocation.y.value) / unbox<float>(atlasSize.height);
+    relocateTileData(tileData, tileLocation);
     tileData.metadata.normalizedLocation.width = unbox<float>(tileData.bitmapSize.width) / unbox<float>(atlasSize.width);
     tileData.metadata.normalizedLocation.height = unbox<float>(tileData.bitmapSize.height) / unbox<float>(atlasSize.height);
     tileData.metadata.targetSize = renderBitmapSize;
@@ -60,6 +59,16 @@ auto Renderable::createTileData(atlas::TileLocation tileLocation,
     // clang-format on
 }
 
+void Renderable::relocateTileData(TextureAtlas::TileCreateData& tileData,
+                                  atlas::TileLocation tileLocation) const
+{
+    auto const atlasSize = _textureScheduler->atlasSize();
+    tileData.metadata.normalizedLocation.x =
+        static_cast<float>(tileLocation.x.value) / unbox<float>(atlasSize.width);
+    tileData.metadata.normalizedLocation.y =
+        static_cast<float>(tileLocation.y.value) / unbox<float>(atlasSize.height);
+}
+
 auto Renderable::sliceTileData(Renderable::TextureAtlas::TileCreateData const& createData,
                                TileSliceIndex sliceIndex,
                                atlas::TileLocation tileLocation) -> Renderable::TextureAtlas::TileCreateData
@@ -15,6 +15,7 @@
 
 #include <terminal/Color.h>
 #include <terminal/Grid.h> // cell attribs
+#include <terminal/Image.h>
 #include <terminal/primitives.h>
 
 #include <terminal_renderer/GridMetrics.h>
@@ -92,6 +93,15 @@ struct RenderTileAttributes
     ImageSize targetSize {};
 };
 
+/// Rectangle in render target pixel coordinates, with the origin at the bottom left.
+struct PixelRect
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
 /**
  * Terminal render target interface, for example OpenGL, DirectX, or software-rasterization.
  *
@@ -121,6 +131,18 @@ class RenderTarget
     /// Fills a rectangular area with the given solid color.
     virtual void renderRectangle(int x, int y, Width, Height, RGBAColor color) = 0;
 
+    /// Renders (part of) an image from a texture of its own rather than from the texture atlas.
+    ///
+    /// @param _image      image to render, uploaded on first use
+    /// @param _imageRect  rectangle the whole image is scaled onto
+    /// @param _clipRect   part of @p _imageRect to actually render
+    virtual void renderImage(std::shared_ptr<terminal::Image const> const& _image,
+                             PixelRect _imageRect,
+                             PixelRect _clipRect) = 0;
+
+    /// Releases the texture that has been created for the given image, if any.
+    virtual void discardImage(terminal::ImageId _imageId) = 0;
+
     using ScreenshotCallback =
         std::function<void(std::vector<uint8_t> const& /*_rgbaBuffer*/, ImageSize /*_pixelSize*/)>;
 
@@ -128,8 +150,15 @@ class RenderTarget
     virtual void scheduleScreenshot(ScreenshotCallback _callback) = 0;
 
     /// Clears the target surface with the given fill color.
+    ///
+    /// Clearing happens as part of the next execute(), so that it respects the damaged area.
     virtual void clear(terminal::RGBAColor _fillColor) = 0;
 
+    /// Restricts clearing and drawing of the next execute() to the given rectangle
+    /// (in target surface coordinates), leaving the rest of the previous frame in place,
+    /// or to the whole surface if std::nullopt.
+    virtual void setDamage(std::optional<PixelRect> _damage) = 0;
+
     /// Executes all previously scheduled render commands.
     virtual void execute() = 0;
 
@@ -180,6 +209,9 @@ class Renderable
                                                 RenderTileAttributes::Y y,
                                                 uint32_t fragmentShaderSelector);
 
+    /// Points the tile data to the given location in the texture atlas.
+    void relocateTileData(TextureAtlas::TileCreateData& tileData, atlas::TileLocation tileLocation) const;
+
     Renderable::TextureAtlas::TileCreateData sliceTileData(
         Renderable::TextureAtlas::TileCreateData const& createData,
         TileSliceIndex sliceIndex,
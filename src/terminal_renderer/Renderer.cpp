@@ -16,12 +16,18 @@
 #include <terminal_renderer/utils.h>
 
 #include <text_shaper/font_locator.h>
+#include <text_shaper/glyph_cache.h>
 #include <text_shaper/open_shaper.h>
 
 #if defined(_WIN32)
     #include <text_shaper/directwrite_shaper.h>
 #endif
 
+#include <crispy/PerfTrace.h>
+#include <crispy/StartupTrace.h>
+#include <crispy/utils.h>
+
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <memory>
@@ -31,12 +37,15 @@ using std::get;
 using std::holds_alternative;
 using std::initializer_list;
 using std::make_unique;
+using std::max;
+using std::min;
 using std::move;
 using std::nullopt;
 using std::optional;
 using std::reference_wrapper;
 using std::scoped_lock;
 using std::tuple;
+using std::u32string_view;
 using std::unique_ptr;
 using std::vector;
 using std::chrono::steady_clock;
@@ -44,6 +53,28 @@ using std::chrono::steady_clock;
 namespace terminal::renderer
 {
 
+namespace
+{
+    // Upper bound of the texture atlas' width and height in pixels when growing it on demand.
+    constexpr auto MaxAtlasTextureEdge = 8192u;
+
+    // Share of the texture atlas' area (relative to its tile count) set aside for wide glyphs,
+    // which are packed into shelves rather than sliced into tiles.
+    constexpr auto AtlasShelfTileDivisor = 4u;
+
+    // Number of DPIs besides the current one to keep the fonts loaded for, e.g. of other monitors.
+    constexpr auto MaxRetainedFontDPIs = 2u;
+
+    /// Tests whether the font descriptions differ in their DPI only.
+    bool differsInDPIOnly(FontDescriptions const& a, FontDescriptions const& b) noexcept
+    {
+        return a.dpi != b.dpi && a == b && a.dpiScale == b.dpiScale
+               && a.textShapingEngine == b.textShapingEngine && a.fontLocator == b.fontLocator
+               && a.builtinBoxDrawing == b.builtinBoxDrawing
+               && a.signedDistanceFields == b.signedDistanceFields && a.glyphCache == b.glyphCache;
+    }
+} // namespace
+
 void loadGridMetricsFromFont(text::font_key _font, GridMetrics& _gm, text::shaper& _textShaper)
 {
     auto const m = _textShaper.metrics(_font);
@@ -72,6 +103,7 @@ GridMetrics loadGridMetrics(text::font_key _font, PageSize _pageSize, text::shap
 
 FontKeys loadFontKeys(FontDescriptions const& _fd, text::shaper& _shaper)
 {
+    auto const _ = crispy::StartupTrace::Scope { "font location" };
     FontKeys output {};
     auto const regularOpt = _shaper.load_font(_fd.regular, _fd.size);
     Require(regularOpt.has_value());
@@ -86,8 +118,10 @@ FontKeys loadFontKeys(FontDescriptions const& _fd, text::shaper& _shaper)
 
 unique_ptr<text::shaper> createTextShaper(TextShapingEngine _engine,
                                           DPI _dpi,
-                                          unique_ptr<text::font_locator> _locator)
+                                          unique_ptr<text::font_locator> _locator,
+                                          bool _glyphCache)
 {
+    auto const _ = crispy::StartupTrace::Scope { "shaper init" };
     switch (_engine)
     {
         case TextShapingEngine::DWrite:
@@ -113,7 +147,10 @@ unique_ptr<text::shaper> createTextShaper(TextShapingEngine _engine,
     }
 
     RendererLog()("Using OpenShaper text shaping engine.");
-    return make_unique<text::open_shaper>(_dpi, std::move(_locator));
+    auto shaper = make_unique<text::open_shaper>(_dpi, std::move(_locator));
+    if (_glyphCache)
+        shaper->set_glyph_cache(text::glyph_cache::default_path("contour"));
+    return shaper;
 }
 
 Renderer::Renderer(PageSize pageSize,
@@ -127,13 +164,21 @@ Renderer::Renderer(PageSize pageSize,
                    Decorator hyperlinkHover):
     _atlasHashtableSlotCount { crispy::nextPowerOfTwo(atlasHashtableSlotCount.value) },
     _atlasTileCount { std::max(atlasTileCount.value, static_cast<uint32_t>(pageSize.area())) },
+    _configuredAtlasHashtableSlotCount { _atlasHashtableSlotCount },
+    _configuredAtlasTileCount { _atlasTileCount },
     _atlasDirectMapping { atlasDirectMapping },
+    _atlasCapacity { _atlasTileCount.value,
+                     { _atlasTileCount.value, _atlasTileCount.value * DefaultCacheGrowthLimit } },
+    _shapingCacheCapacity { TextRenderer::DefaultShapingCacheCapacity,
+                            { TextRenderer::DefaultShapingCacheCapacity,
+                              TextRenderer::DefaultShapingCacheCapacity * DefaultCacheGrowthLimit } },
     _renderTarget { nullptr },
     //.
     fontDescriptions_ { move(fontDescriptions) },
     textShaper_ { createTextShaper(fontDescriptions_.textShapingEngine,
                                    fontDescriptions_.dpi,
-                                   createFontLocator(fontDescriptions_.fontLocator)) },
+                                   createFontLocator(fontDescriptions_.fontLocator),
+                                   fontDescriptions_.glyphCache) },
     fonts_ { loadFontKeys(fontDescriptions_, *textShaper_) },
     gridMetrics_ { loadGridMetrics(fonts_.regular, pageSize, *textShaper_) },
     //.
@@ -176,6 +221,7 @@ void Renderer::setRenderTarget(RenderTarget& renderTarget)
     textRenderer_.setRenderTarget(renderTarget, directMappingAllocator_);
 
     configureTextureAtlas();
+    invalidate();
 
     if (colorPalette_.backgroundImage)
         renderTarget.setBackgroundImage(colorPalette_.backgroundImage);
@@ -184,13 +230,15 @@ void Renderer::setRenderTarget(RenderTarget& renderTarget)
 void Renderer::configureTextureAtlas()
 {
     Require(_renderTarget);
+    auto const _ = crispy::StartupTrace::Scope { "atlas configuration" };
 
     auto atlasProperties =
         atlas::AtlasProperties { atlas::Format::RGBA,
                                  gridMetrics_.cellSize, // Cell size is used as GPU tile size.
                                  _atlasHashtableSlotCount,
                                  _atlasTileCount,
-                                 directMappingAllocator_.currentlyAllocatedCount };
+                                 directMappingAllocator_.currentlyAllocatedCount,
+                                 _atlasTileCount.value / AtlasShelfTileDivisor };
 
     Require(atlasProperties.tileCount.value > 0);
 
@@ -209,6 +257,114 @@ void Renderer::configureTextureAtlas()
         renderable.get().setTextureAtlas(*textureAtlas_);
 }
 
+void Renderer::updateCacheCapacities()
+{
+    if (!textureAtlas_)
+        return;
+
+    auto const atlasStats = textureAtlas_->fetchAndClearStats();
+    atlasStats_.hits += atlasStats.hits;
+    atlasStats_.misses += atlasStats.misses;
+    atlasStats_.recycles += atlasStats.recycles;
+    if (auto const tileCount = _atlasCapacity.update(atlasStats))
+    {
+        RendererLog()("Resizing texture atlas from {} to {} tiles ({}).",
+                      _atlasTileCount.value,
+                      *tileCount,
+                      atlasStats);
+        resizeTextureAtlas(*tileCount);
+    }
+
+    auto const shapingStats = textRenderer_.fetchAndClearShapingStats();
+    shapingStats_.hits += shapingStats.hits;
+    shapingStats_.misses += shapingStats.misses;
+    shapingStats_.recycles += shapingStats.recycles;
+    if (auto const capacity = _shapingCacheCapacity.update(shapingStats))
+    {
+        RendererLog()("Resizing text shaping cache to {} entries ({}).", *capacity, shapingStats);
+        textRenderer_.setShapingCacheCapacity(crispy::LRUCapacity { *capacity });
+    }
+}
+
+void Renderer::resizeTextureAtlas(uint32_t _tileCount)
+{
+    // The hashtable grows and shrinks along with the tiles, staying a power of two.
+    auto const tileCount = crispy::LRUCapacity { _tileCount };
+    auto const slotCount = crispy::StrongHashtableSize { crispy::nextPowerOfTwo(
+        static_cast<uint32_t>(uint64_t { _configuredAtlasHashtableSlotCount.value } * _tileCount
+                              / _configuredAtlasTileCount.value)) };
+
+    auto const atlasSize = atlas::computeAtlasSize(
+        atlas::AtlasProperties { atlas::Format::RGBA,
+                                 gridMetrics_.cellSize,
+                                 slotCount,
+                                 tileCount,
+                                 directMappingAllocator_.currentlyAllocatedCount,
+                                 tileCount.value / AtlasShelfTileDivisor });
+    if (unbox<uint32_t>(atlasSize.width) > MaxAtlasTextureEdge
+        || unbox<uint32_t>(atlasSize.height) > MaxAtlasTextureEdge)
+    {
+        RendererLog()("Not resizing texture atlas to {} pixels, exceeding the maximum.", atlasSize);
+        _atlasCapacity.limit(_atlasTileCount.value);
+        return;
+    }
+
+    _atlasTileCount = tileCount;
+    _atlasHashtableSlotCount = slotCount;
+
+    if (!_renderTarget)
+        return;
+
+    configureTextureAtlas();
+    clearCache();
+}
+
+void Renderer::setCacheGrowthLimit(unsigned _factor)
+{
+    auto const factor = std::max(_factor, 1u);
+    auto const minimumTileCount = _configuredAtlasTileCount.value;
+    _atlasCapacity = crispy::AdaptiveCapacity(_atlasTileCount.value,
+                                              { minimumTileCount, minimumTileCount * factor });
+    if (_atlasCapacity.capacity() != _atlasTileCount.value)
+        resizeTextureAtlas(_atlasCapacity.capacity());
+
+    auto const shapingCapacity = _shapingCacheCapacity.capacity();
+    auto constexpr MinimumShapingCapacity = TextRenderer::DefaultShapingCacheCapacity;
+    _shapingCacheCapacity = crispy::AdaptiveCapacity(
+        shapingCapacity, { MinimumShapingCapacity, MinimumShapingCapacity * factor });
+    if (_shapingCacheCapacity.capacity() != shapingCapacity)
+        textRenderer_.setShapingCacheCapacity(crispy::LRUCapacity { _shapingCacheCapacity.capacity() });
+}
+
+void Renderer::releaseGrownCaches()
+{
+    if (auto const capacity = _shapingCacheCapacity.release())
+    {
+        RendererLog()("Shrinking text shaping cache back to {} entries.", *capacity);
+        textRenderer_.setShapingCacheCapacity(crispy::LRUCapacity { *capacity });
+    }
+
+    if (auto const tileCount = _atlasCapacity.release())
+    {
+        RendererLog()("Shrinking texture atlas back to {} tiles.", *tileCount);
+        resizeTextureAtlas(*tileCount);
+    }
+}
+
+Renderer::CacheMetrics Renderer::fetchAndClearCacheMetrics()
+{
+    auto metrics = CacheMetrics {};
+    metrics.atlas = std::exchange(atlasStats_, crispy::LRUHashtableStats {});
+    metrics.shaping = std::exchange(shapingStats_, crispy::LRUHashtableStats {});
+    if (textureAtlas_)
+    {
+        metrics.atlasTiles = textureAtlas_->cachedTileCount();
+        metrics.atlasCapacity = _atlasTileCount.value;
+        metrics.atlasOccupancy = textureAtlas_->occupancy().ratio();
+    }
+    return metrics;
+}
+
 void Renderer::discardImage(Image const& _image)
 {
     // Defer rendering into the renderer thread & render stage, as this call might have
@@ -240,9 +396,36 @@ void Renderer::clearCache()
         renderable.get().clearCache();
 }
 
+void Renderer::trimMemory()
+{
+    if (!_renderTarget)
+        return;
+
+    RendererLog()("Trimming texture atlas and caches.");
+    retainedFonts_.clear();
+    (void) _atlasCapacity.release();
+    if (auto const capacity = _shapingCacheCapacity.release())
+        textRenderer_.setShapingCacheCapacity(crispy::LRUCapacity { *capacity });
+    _atlasTileCount = _configuredAtlasTileCount;
+    _atlasHashtableSlotCount = _configuredAtlasHashtableSlotCount;
+    configureTextureAtlas();
+    clearCache();
+    invalidate();
+}
+
 void Renderer::setFonts(FontDescriptions _fontDescriptions)
 {
-    if (fontDescriptions_.textShapingEngine == _fontDescriptions.textShapingEngine)
+    if (differsInDPIOnly(_fontDescriptions, fontDescriptions_))
+    {
+        setFontDPI(_fontDescriptions.dpi);
+        return;
+    }
+
+    // The fonts retained for other DPIs are of the previous font descriptions.
+    retainedFonts_.clear();
+
+    if (fontDescriptions_.textShapingEngine == _fontDescriptions.textShapingEngine
+        && fontDescriptions_.glyphCache == _fontDescriptions.glyphCache)
     {
         textShaper_->clear_cache();
         textShaper_->set_dpi(_fontDescriptions.dpi);
@@ -250,9 +433,13 @@ void Renderer::setFonts(FontDescriptions _fontDescriptions)
             textShaper_->set_locator(createFontLocator(_fontDescriptions.fontLocator));
     }
     else
+    {
         textShaper_ = createTextShaper(_fontDescriptions.textShapingEngine,
                                        _fontDescriptions.dpi,
-                                       createFontLocator(_fontDescriptions.fontLocator));
+                                       createFontLocator(_fontDescriptions.fontLocator),
+                                       _fontDescriptions.glyphCache);
+        textRenderer_.setTextShaper(*textShaper_);
+    }
 
     fontDescriptions_ = move(_fontDescriptions);
     fonts_ = loadFontKeys(fontDescriptions_, *textShaper_);
@@ -268,12 +455,54 @@ bool Renderer::setFontSize(text::font_size _fontSize)
         return false;
 
     fontDescriptions_.size = _fontSize;
+    retainedFonts_.clear();
     fonts_ = loadFontKeys(fontDescriptions_, *textShaper_);
     updateFontMetrics();
 
     return true;
 }
 
+void Renderer::setFontDPI(DPI _dpi)
+{
+    auto retained = RetainedFonts { fontDescriptions_.dpi,
+                                    move(textShaper_),
+                                    fonts_,
+                                    textRenderer_.exchangeShapingCache(nullptr) };
+
+    auto shapingCache = TextRenderer::ShapingResultCachePtr {};
+    auto const i = std::find_if(retainedFonts_.begin(), retainedFonts_.end(), [&](auto const& _fonts) {
+        return _fonts.dpi == _dpi;
+    });
+    fontDescriptions_.dpi = _dpi;
+    if (i != retainedFonts_.end())
+    {
+        RendererLog()("Reusing fonts retained for DPI {}.", _dpi);
+        textShaper_ = move(i->textShaper);
+        fonts_ = i->fonts;
+        shapingCache = move(i->shapingCache);
+        retainedFonts_.erase(i);
+    }
+    else
+    {
+        textShaper_ = createTextShaper(fontDescriptions_.textShapingEngine,
+                                       _dpi,
+                                       createFontLocator(fontDescriptions_.fontLocator),
+                                       fontDescriptions_.glyphCache);
+        fonts_ = loadFontKeys(fontDescriptions_, *textShaper_);
+    }
+
+    retainedFonts_.emplace_front(move(retained));
+    if (retainedFonts_.size() > MaxRetainedFontDPIs)
+        retainedFonts_.pop_back();
+
+    textRenderer_.setTextShaper(*textShaper_);
+    updateFontMetrics();
+
+    // Restored only now, as updating the font metrics clears the text shaping cache.
+    if (shapingCache)
+        textRenderer_.exchangeShapingCache(move(shapingCache));
+}
+
 void Renderer::updateFontMetrics()
 {
     RendererLog()("Updating grid metrics: {}", gridMetrics_);
@@ -291,27 +520,41 @@ void Renderer::updateFontMetrics()
 
 uint64_t Renderer::render(Terminal& _terminal, bool _pressure)
 {
+    CONTOUR_PERF_TRACE("Renderer::render");
+
     gridMetrics_.pageSize = _terminal.pageSize();
 
     auto const changes = _terminal.tick(steady_clock::now());
 
     executeImageDiscards();
 
+    auto const renderBufferStart = steady_clock::now();
 #if !defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE) // {{{
     // Windows 10 (ConPTY) workaround. ConPTY can't handle non-blocking I/O,
     // so we have to explicitly refresh the render buffer
     // from within the render (reader) thread instead ofthe terminal (writer) thread.
     _terminal.refreshRenderBuffer();
 #endif // }}}
+    auto const cellsStart = steady_clock::now();
 
     optional<terminal::RenderCursor> cursorOpt;
+    auto pixelOffset = 0;
     textRenderer_.beginFrame();
+    imageRenderer_.beginFrame();
     textRenderer_.setPressure(_pressure && _terminal.isPrimaryScreen());
     {
         RenderBufferRef const renderBuffer = _terminal.renderBuffer();
         cursorOpt = renderBuffer.get().cursor;
-        renderCells(renderBuffer.get().cells);
+
+        // Scrolling by a fraction of a line moves the whole page up, leaving the lines as they are.
+        pixelOffset = renderBuffer.get().pixelOffset;
+        gridMetrics_.pageMargin.bottom += pixelOffset;
+
+        _renderTarget->setDamage(trackDamage(renderBuffer.get()));
+        renderCells(renderBuffer.get());
     }
+    backgroundRenderer_.endFrame();
+    imageRenderer_.endFrame();
     textRenderer_.endFrame();
 
     if (cursorOpt && cursorOpt.value().shape != CursorShape::Block)
@@ -330,11 +573,105 @@ uint64_t Renderer::render(Terminal& _terminal, bool _pressure)
         cursorRenderer_.render(gridMetrics_.map(cursor.position), cursor.width, cursorColor);
     }
 
+    gridMetrics_.pageMargin.bottom -= pixelOffset;
+
+    auto const executeStart = steady_clock::now();
     _renderTarget->execute();
+    auto const executeEnd = steady_clock::now();
+
+    lastFrameTimings_.renderBuffer = cellsStart - renderBufferStart;
+    lastFrameTimings_.cells = executeStart - cellsStart;
+    lastFrameTimings_.execute = executeEnd - executeStart;
+
+    updateCacheCapacities();
+
+    // Lines with glyphs left blank must be drawn again once these got rasterized.
+    if (hasDeferredGlyphs())
+        invalidate();
+
+    // Done while the GPU draws this frame, so that the lines do not stall the frames they scroll in with.
+    prefetchLines(_terminal);
 
     return changes;
 }
 
+void Renderer::prefetchLines(Terminal& _terminal)
+{
+    RenderBufferRef const renderBuffer = _terminal.renderBuffer();
+    auto const text = u32string_view(renderBuffer.get().prefetchText);
+    for (PrefetchRun const& run: renderBuffer.get().prefetchRuns)
+        textRenderer_.prefetch(text.substr(run.textOffset, run.textLength), run.flags);
+}
+
+optional<PixelRect> Renderer::trackDamage(RenderBuffer const& _renderBuffer)
+{
+    auto& presented = presentedFrame_;
+    auto const lineCount = unbox<size_t>(gridMetrics_.pageSize.lines);
+
+    // Anything that affects all lines alike, or a line layout not covering the page, redraws the frame.
+    bool const fullRedraw = presented.lines.size() != lineCount || _renderBuffer.lines.size() != lineCount
+                            || !_renderBuffer.contextFingerprint
+                            || presented.contextFingerprint != _renderBuffer.contextFingerprint
+                            || presented.pageSize != gridMetrics_.pageSize
+                            || presented.cellSize != gridMetrics_.cellSize
+                            || presented.pageMargin.left != gridMetrics_.pageMargin.left
+                            || presented.pageMargin.bottom != gridMetrics_.pageMargin.bottom;
+
+    presented.pageSize = gridMetrics_.pageSize;
+    presented.cellSize = gridMetrics_.cellSize;
+    presented.pageMargin = gridMetrics_.pageMargin;
+    presented.contextFingerprint = _renderBuffer.contextFingerprint;
+    presented.lines.resize(lineCount);
+
+    auto firstDamaged = lineCount;
+    auto lastDamaged = size_t { 0 };
+    auto const damage = [&](size_t row) {
+        firstDamaged = min(firstDamaged, row);
+        lastDamaged = max(lastDamaged, row);
+    };
+
+    size_t lineCellCount = 0;
+    for (size_t row = 0; row < min(lineCount, _renderBuffer.lines.size()); ++row)
+    {
+        auto const generation = _renderBuffer.lines[row].generation;
+        if (!generation || presented.lines[row] != generation)
+            damage(row);
+        presented.lines[row] = generation;
+        lineCellCount += _renderBuffer.lines[row].cellCount;
+    }
+
+    // Cells drawn on top of the lines (e.g. predicted local echo) and the cursor
+    // damage their line in this frame as well as in the next one.
+    auto const overdraw = [&](LineOffset line) {
+        auto const row = unbox<size_t>(line);
+        if (row >= lineCount)
+            return;
+        damage(row);
+        presented.lines[row] = 0;
+    };
+    for (size_t i = lineCellCount; i < _renderBuffer.cells.size(); ++i)
+        overdraw(_renderBuffer.cells[i].position.line);
+    if (_renderBuffer.cursor)
+        overdraw(_renderBuffer.cursor->position.line);
+
+    if (fullRedraw)
+        return nullopt;
+
+    if (firstDamaged > lastDamaged)
+        return PixelRect { 0, 0, 0, 0 };
+
+    // Glyphs may slightly overflow their line, so the adjacent lines are included.
+    auto const top = firstDamaged > 0 ? firstDamaged - 1 : firstDamaged;
+    auto const bottom = min(lastDamaged + 1, lineCount - 1);
+    auto const bottomLeft = gridMetrics_.map(LineOffset::cast_from(bottom), ColumnOffset(0));
+    return PixelRect { 0,
+                       bottomLeft.y,
+                       2 * gridMetrics_.pageMargin.left
+                           + unbox<int>(gridMetrics_.pageSize.columns)
+                                 * unbox<int>(gridMetrics_.cellSize.width),
+                       static_cast<int>(bottom - top + 1) * unbox<int>(gridMetrics_.cellSize.height) };
+}
+
 tuple<RGBColor, RGBColor> makeColors(ColorPalette const& _colorPalette,
                                      Cell const& _cell,
                                      bool _reverseVideo,
@@ -366,7 +703,35 @@ constexpr CellFlags toCellStyle(Decorator _decorator)
     return CellFlags {};
 }
 
-void Renderer::renderCells(vector<RenderCell> const& _renderableCells)
+void Renderer::renderCells(RenderBuffer const& _renderBuffer)
+{
+    auto const cells = gsl::span<RenderCell const>(_renderBuffer.cells);
+    auto const runs = gsl::span<RenderRun const>(_renderBuffer.runs);
+
+    // Render line by line where the line layout is known, so that the text renderer
+    // can reuse the shaping results of lines that did not change since the last frame.
+    size_t renderedCellCount = 0;
+    for (RenderLine const& line: _renderBuffer.lines)
+    {
+        if (line.cellOffset != renderedCellCount || line.cellOffset + line.cellCount > cells.size()
+            || line.runOffset + line.runCount > runs.size())
+            break;
+        textRenderer_.beginLine(line.generation, _renderBuffer.contextFingerprint);
+        for (RenderRun const& run: runs.subspan(line.runOffset, line.runCount))
+        {
+            backgroundRenderer_.renderRun(run);
+            decorationRenderer_.renderRun(run);
+            textRenderer_.renderRun(run);
+        }
+        renderCells(cells.subspan(line.cellOffset, line.cellCount));
+        textRenderer_.endLine();
+        renderedCellCount += line.cellCount;
+    }
+
+    renderCells(cells.subspan(renderedCellCount));
+}
+
+void Renderer::renderCells(gsl::span<RenderCell const> _renderableCells)
 {
     for (RenderCell const& cell: _renderableCells)
     {
@@ -383,6 +748,31 @@ void Renderer::inspect(std::ostream& _textOutput) const
     textureAtlas_->inspect(_textOutput);
     for (auto const& renderable: renderables())
         renderable.get().inspect(_textOutput);
+    if (_renderTarget)
+        _renderTarget->inspect(_textOutput);
+    imageDiscardLock_.inspect("image discard lock", _textOutput);
+}
+
+void Renderer::inspectMemoryUsage(std::ostream& _textOutput) const
+{
+    _textOutput << fmt::format("Renderer memory usage\n");
+    _textOutput << fmt::format("------------------------\n");
+    _textOutput << fmt::format("{:<21}: {} ({} pixels, {})\n",
+                               "atlas texture",
+                               crispy::humanReadableBytes(textureAtlas_->textureBytes()),
+                               textureAtlas_->atlasSize(),
+                               textureAtlas_->format());
+    _textOutput << fmt::format("{:<21}: {} of {} tiles, {} hashtable\n",
+                               "atlas tiles",
+                               textureAtlas_->cachedTileCount(),
+                               textureAtlas_->capacity(),
+                               crispy::humanReadableBytes(textureAtlas_->tileCacheStorageSize()));
+    _textOutput << fmt::format("{:<21}: {} of {} entries, {} hashtable\n",
+                               "text shaping cache",
+                               textRenderer_.shapingCacheSize(),
+                               _shapingCacheCapacity.capacity(),
+                               crispy::humanReadableBytes(textRenderer_.shapingCacheStorageSize()));
+    _textOutput << '\n';
 }
 
 } // namespace terminal::renderer
@@ -26,11 +26,16 @@
 #include <terminal_renderer/RenderTarget.h>
 #include <terminal_renderer/TextRenderer.h>
 
+#include <crispy/AdaptiveCapacity.h>
+#include <crispy/InstrumentedMutex.h>
 #include <crispy/size.h>
 
 #include <fmt/format.h>
 
+#include <gsl/span>
+
 #include <chrono>
+#include <list>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -101,6 +106,14 @@ class Renderer
         gridMetrics_.pageMargin = _margin;
     }
 
+    /// Time spent in each stage of rendering a frame.
+    struct FrameTimings
+    {
+        std::chrono::steady_clock::duration renderBuffer {}; // refreshing the terminal's render buffer
+        std::chrono::steady_clock::duration cells {};        // turning render cells into render commands
+        std::chrono::steady_clock::duration execute {};      // executing the commands on the render target
+    };
+
     /**
      * Renders the given @p _terminal to the current OpenGL context.
      *
@@ -108,12 +121,69 @@ class Renderer
      */
     uint64_t render(Terminal& _terminal, bool _pressure);
 
+    /// @returns the stage timings of the most recently rendered frame.
+    [[nodiscard]] FrameTimings const& lastFrameTimings() const noexcept { return lastFrameTimings_; }
+
+    /// Cache statistics for live performance diagnostics.
+    struct CacheMetrics
+    {
+        crispy::LRUHashtableStats atlas {};   // texture atlas tile lookups since the last fetch
+        crispy::LRUHashtableStats shaping {}; // text shaping cache lookups since the last fetch
+        size_t atlasTiles = 0;                // tiles currently held by the texture atlas
+        size_t atlasCapacity = 0;             // tiles the texture atlas can hold
+        double atlasOccupancy = 0.0;          // share of the texture atlas' area in use
+    };
+
+    /// @returns the cache statistics gathered since the last call.
+    CacheMetrics fetchAndClearCacheMetrics();
+
     void discardImage(Image const& _image);
 
+    /// Acquisitions of and contention on the lock of the queue of images to be discarded.
+    crispy::LockStats imageDiscardLockStats() const noexcept { return imageDiscardLock_.stats(); }
+
+    /// Limits the number of glyphs to be rasterized per frame (0 for no limit).
+    void setGlyphRasterizationBudget(unsigned _glyphsPerFrame) noexcept
+    {
+        textRenderer_.setRasterizationBudget(_glyphsPerFrame);
+    }
+
+    /// Default of setCacheGrowthLimit().
+    static constexpr unsigned DefaultCacheGrowthLimit = 8;
+
+    /// Limits the texture atlas' tile count and the text shaping cache's capacity, which grow while
+    /// their working set does not fit (e.g. heavy Unicode output), to @p _factor times their
+    /// configured size. A factor of 1 keeps them at their configured size.
+    void setCacheGrowthLimit(unsigned _factor);
+
+    /// Shrinks the texture atlas and the text shaping cache back to their configured size,
+    /// if they have grown, e.g. when the terminal went idle.
+    void releaseGrownCaches();
+
+    /// Enables rendering images from one texture each instead of atlas tiles.
+    void setImageTextureMode(bool _enabled) noexcept { imageRenderer_.setTextureMode(_enabled); }
+
+    /// Forces the next frame to be rendered in full, e.g. because the render target's previous contents
+    /// are lost or have been painted over.
+    void invalidate() noexcept { presentedFrame_.lines.clear(); }
+
+    /// Tests whether the last rendered frame left glyphs blank that must be rendered
+    /// with one of the next frames.
+    [[nodiscard]] bool hasDeferredGlyphs() const noexcept { return textRenderer_.deferredGlyphCount() != 0; }
+
     void clearCache();
 
+    /// Releases the texture atlas' tiles and the text shaping caches, such as when the system
+    /// runs low on memory, shrinking the atlas back to its configured size if it was grown.
+    ///
+    /// Everything is recreated on demand with the next frames.
+    void trimMemory();
+
     void inspect(std::ostream& _textOutput) const;
 
+    /// Writes the memory held by the texture atlas and the text shaping cache into @p _textOutput.
+    void inspectMemoryUsage(std::ostream& _textOutput) const;
+
     std::array<std::reference_wrapper<Renderable>, 5> renderables()
     {
         return std::array<std::reference_wrapper<Renderable>, 5> {
@@ -130,12 +200,29 @@ class Renderer
 
   private:
     void configureTextureAtlas();
-    void renderCells(std::vector<RenderCell> const& _renderableCells);
+    /// Adapts the capacities of the texture atlas and the text shaping cache to the lookups
+    /// of the frame just rendered, see crispy::AdaptiveCapacity.
+    void updateCacheCapacities();
+    void resizeTextureAtlas(uint32_t _tileCount);
+
+    /// Switches the fonts over to the given DPI, e.g. when the window moved to another monitor,
+    /// reusing the fonts, glyphs and text shaping results retained from when it was used last.
+    void setFontDPI(DPI _dpi);
+    std::optional<PixelRect> trackDamage(RenderBuffer const& _renderBuffer);
+    void renderCells(RenderBuffer const& _renderBuffer);
+    void renderCells(gsl::span<RenderCell const> _renderableCells);
+
+    /// Shapes the text of the lines the viewport is being scrolled towards, see RenderBuffer::prefetchRuns.
+    void prefetchLines(Terminal& _terminal);
     void executeImageDiscards();
 
     crispy::StrongHashtableSize _atlasHashtableSlotCount;
     crispy::LRUCapacity _atlasTileCount;
+    crispy::StrongHashtableSize _configuredAtlasHashtableSlotCount; // before growing due to thrashing
+    crispy::LRUCapacity _configuredAtlasTileCount;
     bool _atlasDirectMapping;
+    crispy::AdaptiveCapacity _atlasCapacity;        // in tiles
+    crispy::AdaptiveCapacity _shapingCacheCapacity; // in text shaping results
 
     RenderTarget* _renderTarget;
 
@@ -146,19 +233,46 @@ class Renderer
     std::unique_ptr<text::shaper> textShaper_;
     FontKeys fonts_;
 
+    // The fonts as loaded for DPIs other than the current one, most recently used first,
+    // including their rasterized glyphs (held by the text shaper) and text shaping results.
+    struct RetainedFonts
+    {
+        DPI dpi;
+        std::unique_ptr<text::shaper> textShaper;
+        FontKeys fonts;
+        TextRenderer::ShapingResultCachePtr shapingCache;
+    };
+    std::list<RetainedFonts> retainedFonts_;
+
     GridMetrics gridMetrics_;
 
     ColorPalette const& colorPalette_;
     Opacity backgroundOpacity_;
 
-    std::mutex imageDiscardLock_;            //!< Lock guard for accessing discardImageQueue_.
-    std::vector<ImageId> discardImageQueue_; //!< List of images to be discarded.
+    crispy::InstrumentedMutex mutable imageDiscardLock_; //!< Lock guard for accessing discardImageQueue_.
+    std::vector<ImageId> discardImageQueue_;             //!< List of images to be discarded.
 
     BackgroundRenderer backgroundRenderer_;
     ImageRenderer imageRenderer_;
     TextRenderer textRenderer_;
     DecorationRenderer decorationRenderer_;
     CursorRenderer cursorRenderer_;
+
+    FrameTimings lastFrameTimings_;
+
+    // What the render target currently shows, so that a frame only needs to redraw the lines
+    // whose generation differs. A generation of 0 marks a line that must be redrawn next frame.
+    struct
+    {
+        PageSize pageSize {};
+        ImageSize cellSize {};
+        PageMargin pageMargin {};
+        uint64_t contextFingerprint = 0;
+        std::vector<uint64_t> lines {};
+    } presentedFrame_;
+    // Lookups since the last fetchAndClearCacheMetrics().
+    crispy::LRUHashtableStats atlasStats_ {};
+    crispy::LRUHashtableStats shapingStats_ {};
 };
 
 } // namespace terminal::renderer
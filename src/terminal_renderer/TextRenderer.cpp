@@ -140,6 +140,7 @@ Making use of reserved glyph slots
     #include <text_shaper/coretext_locator.h>
 #endif
 
+#include <crispy/PerfTrace.h>
 #include <crispy/algorithm.h>
 #include <crispy/assert.h>
 #include <crispy/indexed.h>
@@ -153,6 +154,7 @@ Making use of reserved glyph slots
 #include <range/v3/algorithm/copy.hpp>
 
 #include <algorithm>
+#include <utility>
 
 using crispy::Point;
 using crispy::StrongHash;
@@ -187,6 +189,9 @@ namespace
     constexpr auto LastReservedChar = char32_t { 0x7E };
     constexpr auto DirectMappedCharsCount = LastReservedChar - FirstReservedChar + 1;
 
+    // The number of font styles (regular, bold, italic, bold-italic) that get direct-mapped.
+    constexpr auto DirectMappedStyleCount = uint32_t { 4 };
+
     StrongHash hashGlyphKeyAndPresentation(text::glyph_key const& glyphKey,
                                            unicode::PresentationStyle presentation) noexcept
     {
@@ -255,6 +260,26 @@ namespace
             return TextStyle::Italic;
         return TextStyle::Regular;
     }
+
+    /// Tests whether the given codepoint separates words, which no font ligates across.
+    ///
+    /// Text cluster groups are split at these, so that editing a word only reshapes that word.
+    constexpr bool isWordSeparator(char32_t codepoint) noexcept
+    {
+        switch (codepoint)
+        {
+            case 0x09:   // CHARACTER TABULATION
+            case 0x20:   // SPACE
+            case 0xA0:   // NO-BREAK SPACE
+            case 0x1680: // OGHAM SPACE MARK
+            case 0x202F: // NARROW NO-BREAK SPACE
+            case 0x205F: // MEDIUM MATHEMATICAL SPACE
+            case 0x3000: // IDEOGRAPHIC SPACE
+                return true;
+            default:
+                return 0x2000 <= codepoint && codepoint <= 0x200A; // EN QUAD .. HAIR SPACE
+        }
+    }
 } // namespace
 
 unique_ptr<text::font_locator> createFontLocator(FontLocatorEngine _engine)
@@ -271,7 +296,7 @@ unique_ptr<text::font_locator> createFontLocator(FontLocatorEngine _engine)
             break;
         case FontLocatorEngine::CoreText:
 #if defined(__APPLE__)
-            return make_unique<text::coretext_locator>();
+            return make_unique<text::coretext_locator>(text::cache_file_path("contour", "fontchains.cache"));
 #else
             LocatorLog()("Font locator CoreText not supported on this platform.");
 #endif
@@ -283,12 +308,12 @@ unique_ptr<text::font_locator> createFontLocator(FontLocatorEngine _engine)
     }
 
     LocatorLog()("Using font locator: fontconfig.");
-    return make_unique<text::fontconfig_locator>();
+    return make_unique<text::fontconfig_locator>(text::cache_file_path("contour", "fontchains.cache"));
 }
 
 // TODO: What's a good value here? Or do we want to make that configurable,
 // or even computed based on memory resources available?
-constexpr uint32_t TextShapingCacheSize = 4000;
+constexpr size_t EmojiGlyphCacheSize = 512;
 
 TextRenderer::TextRenderer(GridMetrics const& gridMetrics,
                            text::shaper& _textShaper,
@@ -297,10 +322,9 @@ TextRenderer::TextRenderer(GridMetrics const& gridMetrics,
     Renderable { gridMetrics },
     fontDescriptions_ { _fontDescriptions },
     fonts_ { _fonts },
-    textShapingCache_ { ShapingResultCache::create(crispy::StrongHashtableSize { 16384 },
-                                                   crispy::LRUCapacity { TextShapingCacheSize },
-                                                   "Text shaping cache") },
-    textShaper_ { _textShaper },
+    textShapingCache_ { ShapingResultCache::create(shapingCacheCapacity_, "Text shaping cache") },
+    textShaper_ { &_textShaper },
+    emojiGlyphs_ { EmojiGlyphCacheSize },
     boxDrawingRenderer_ { _gridMetrics }
 {
 }
@@ -315,7 +339,7 @@ void TextRenderer::inspect(ostream& _textOutput) const
 void TextRenderer::setRenderTarget(
     RenderTarget& renderTarget, atlas::DirectMappingAllocator<RenderTileAttributes>& directMappingAllocator)
 {
-    _directMapping = directMappingAllocator.allocate(DirectMappedCharsCount);
+    _directMapping = directMappingAllocator.allocate(DirectMappedCharsCount * DirectMappedStyleCount);
     Renderable::setRenderTarget(renderTarget, directMappingAllocator);
     boxDrawingRenderer_.setRenderTarget(renderTarget, directMappingAllocator);
     clearCache();
@@ -336,6 +360,9 @@ void TextRenderer::clearCache()
         initializeDirectMapping();
 
     textShapingCache_->clear();
+    lineShapingCache_.clear();
+    currentLineShaping_ = nullptr;
+    emojiGlyphs_.clear();
 
     boxDrawingRenderer_.clearCache();
 }
@@ -343,25 +370,33 @@ void TextRenderer::clearCache()
 void TextRenderer::initializeDirectMapping()
 {
     Require(_textureAtlas);
-    Require(_directMapping.count == DirectMappedCharsCount);
+    Require(_directMapping.count == DirectMappedCharsCount * DirectMappedStyleCount);
 
+    auto const fonts = directMappedFonts();
+    for (uint32_t styleIndex = 0; styleIndex < DirectMappedStyleCount; ++styleIndex)
+        initializeDirectMapping(styleIndex, fonts[styleIndex]);
+}
+
+void TextRenderer::initializeDirectMapping(uint32_t styleIndex, text::font_key font)
+{
     auto constexpr presentation = unicode::PresentationStyle::Text;
 
-    _directMappedGlyphKeyToTileIndex.clear();
-    _directMappedGlyphKeyToTileIndex.resize(LastReservedChar + 1);
+    auto& glyphToTileIndex = _directMappedGlyphKeyToTileIndex[styleIndex];
+    glyphToTileIndex.clear();
+    glyphToTileIndex.resize(LastReservedChar + 1);
 
     for (char32_t codepoint = FirstReservedChar; codepoint <= LastReservedChar; ++codepoint)
     {
-        optional<text::glyph_position> gposOpt = textShaper_.shape(fonts_.regular, codepoint);
+        optional<text::glyph_position> gposOpt = textShaper_->shape(font, codepoint);
         if (!gposOpt)
             continue;
         text::glyph_position& gpos = *gposOpt;
 
-        if (gpos.glyph.index.value >= _directMappedGlyphKeyToTileIndex.size())
-            _directMappedGlyphKeyToTileIndex.resize(gpos.glyph.index.value
-                                                    + (LastReservedChar - codepoint + 1));
+        if (gpos.glyph.index.value >= glyphToTileIndex.size())
+            glyphToTileIndex.resize(gpos.glyph.index.value + (LastReservedChar - codepoint + 1));
 
-        auto const tileIndex = _directMapping.toTileIndex(codepoint - FirstReservedChar);
+        auto const tileIndex =
+            _directMapping.toTileIndex(styleIndex * DirectMappedCharsCount + (codepoint - FirstReservedChar));
         auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
         auto tileCreateData = createRasterizedGlyph(tileLocation, gpos.glyph, presentation);
         if (!tileCreateData)
@@ -378,12 +413,33 @@ void TextRenderer::initializeDirectMapping()
         //            tileCreateData->metadata);
 
         _textureAtlas->setDirectMapping(tileIndex, move(*tileCreateData));
-        _directMappedGlyphKeyToTileIndex[gpos.glyph.index.value] = tileIndex;
+        glyphToTileIndex[gpos.glyph.index.value] = tileIndex;
     }
 }
 
+TextRenderer::ShapingResultCachePtr TextRenderer::exchangeShapingCache(ShapingResultCachePtr _shapingCache)
+{
+    if (!_shapingCache)
+        _shapingCache = ShapingResultCache::create(shapingCacheCapacity_, "Text shaping cache");
+
+    lineShapingCache_.clear();
+    currentLineShaping_ = nullptr;
+    return std::exchange(textShapingCache_, std::move(_shapingCache));
+}
+
+void TextRenderer::setShapingCacheCapacity(crispy::LRUCapacity _capacity)
+{
+    shapingCacheCapacity_ = _capacity;
+    exchangeShapingCache(nullptr);
+}
+
 void TextRenderer::updateFontMetrics()
 {
+    // The font keys got possibly invalidated along with the font change,
+    // and the cell size that emoji are scaled to possibly changed.
+    sdfFonts_.reset();
+    emojiGlyphs_.clear();
+
     if (!renderTargetAvailable())
         return;
 
@@ -399,6 +455,37 @@ void TextRenderer::beginFrame()
     auto constexpr DefaultColor = RGBColor {};
     textClusterGroup_.style = TextStyle::Invalid;
     textClusterGroup_.color = DefaultColor;
+
+    ++frameCount_;
+    rasterizedGlyphCount_ = 0;
+    deferredGlyphCount_ = 0;
+}
+
+void TextRenderer::beginLine(uint64_t generation, uint64_t contextFingerprint)
+{
+    flushTextClusterGroup();
+    currentLineGroup_ = 0;
+    currentLineShaping_ = nullptr;
+
+    // A fingerprint of 0 means that the render context (e.g. the selection) cannot be compared,
+    // in which case the text cluster groups of the line may differ from frame to frame.
+    if (!generation || !contextFingerprint)
+        return;
+
+    auto& entry = lineShapingCache_[generation];
+    if (entry.contextFingerprint != contextFingerprint)
+    {
+        entry.contextFingerprint = contextFingerprint;
+        entry.groups.clear();
+    }
+    entry.lastUsedFrame = frameCount_;
+    currentLineShaping_ = &entry;
+}
+
+void TextRenderer::endLine()
+{
+    flushTextClusterGroup();
+    currentLineShaping_ = nullptr;
 }
 
 void TextRenderer::renderCell(RenderCell const& cell)
@@ -412,6 +499,17 @@ void TextRenderer::renderCell(RenderCell const& cell)
         flushTextClusterGroup();
 }
 
+void TextRenderer::renderRun(RenderRun const& run)
+{
+    // Columns past the end of the run's text are blank and have no glyphs to shape.
+    updateInitialPenPosition_ = true;
+    auto const textStyle = makeTextStyle(run.flags);
+    auto position = run.start;
+    for (size_t i = 0; i < run.text.size(); ++i, ++position.column)
+        renderCell(position, run.text.substr(i, 1), textStyle, run.foregroundColor);
+    flushTextClusterGroup();
+}
+
 void TextRenderer::renderCell(CellLocation position,
                               std::u32string_view codepoints,
                               TextStyle textStyle,
@@ -445,6 +543,62 @@ void TextRenderer::renderCell(CellLocation position,
 void TextRenderer::endFrame()
 {
     flushTextClusterGroup();
+    currentLineShaping_ = nullptr;
+
+    // Forget about lines that have not been rendered in this frame.
+    for (auto i = lineShapingCache_.begin(); i != lineShapingCache_.end();)
+    {
+        if (i->second.lastUsedFrame != frameCount_)
+            i = lineShapingCache_.erase(i);
+        else
+            ++i;
+    }
+}
+
+void TextRenderer::prefetch(u32string_view _text, CellFlags _flags)
+{
+    Require(textClusterGroup_.codepoints.empty());
+
+    // Words are grouped just like when rendering them (see appendCellTextToClusterGroup()),
+    // so that they are shaped into the same cache entries.
+    textClusterGroup_.style = makeTextStyle(_flags);
+    for (char32_t const codepoint: _text)
+    {
+        if (isWordSeparator(codepoint)
+            || (fontDescriptions_.builtinBoxDrawing && boxDrawingRenderer_.renderable(codepoint)))
+        {
+            prefetchTextClusterGroup();
+            continue;
+        }
+        textClusterGroup_.codepoints.emplace_back(codepoint);
+        textClusterGroup_.clusters.emplace_back(textClusterGroup_.cellCount++);
+    }
+    prefetchTextClusterGroup();
+}
+
+void TextRenderer::prefetchTextClusterGroup()
+{
+    if (!textClusterGroup_.codepoints.empty())
+    {
+        auto const hash = hashTextAndStyle(
+            u32string_view(textClusterGroup_.codepoints.data(), textClusterGroup_.codepoints.size()),
+            textClusterGroup_.style);
+        for (text::glyph_position const& glyphPosition: getOrCreateCachedGlyphPositions(hash))
+        {
+            if (rasterizationBudget_ && rasterizedGlyphCount_ >= rasterizationBudget_)
+                break;
+            if (directMappedTileIndex(glyphPosition.glyph))
+                continue;
+            (void) getOrCreateRasterizedMetadata(
+                hashGlyphKeyAndPresentation(glyphPosition.glyph, glyphPosition.presentation),
+                glyphPosition.glyph,
+                glyphPosition.presentation);
+        }
+    }
+
+    textClusterGroup_.codepoints.clear();
+    textClusterGroup_.clusters.clear();
+    textClusterGroup_.cellCount = 0;
 }
 
 Point TextRenderer::applyGlyphPositionToPen(Point pen,
@@ -512,7 +666,7 @@ void TextRenderer::renderRasterizedGlyph(crispy::Point pen,
 void TextRenderer::appendCellTextToClusterGroup(u32string_view _codepoints, TextStyle _style, RGBColor _color)
 {
     bool const attribsChanged = _color != textClusterGroup_.color || _style != textClusterGroup_.style;
-    bool const hasText = !_codepoints.empty() && _codepoints[0] != 0x20;
+    bool const hasText = !_codepoints.empty() && !isWordSeparator(_codepoints[0]);
     bool const noText = !hasText;
     bool const textStartFound = !textStartFound_ && hasText;
     if (noText)
@@ -543,19 +697,14 @@ void TextRenderer::flushTextClusterGroup()
         //            _gridMetrics.cellSize.width,
         //            textClusterGroup_.codepoints.size());
 
-        auto hash = hashTextAndStyle(
-            u32string_view(textClusterGroup_.codepoints.data(), textClusterGroup_.codepoints.size()),
-            textClusterGroup_.style);
-        text::shape_result const& glyphPositions = getOrCreateCachedGlyphPositions(hash);
+        text::shape_result const& glyphPositions = getOrCreateLineGlyphPositions();
         crispy::Point pen = textClusterGroup_.initialPenPosition;
         auto const advanceX = *_gridMetrics.cellSize.width;
 
         for (text::glyph_position const& glyphPosition: glyphPositions)
         {
-            if (isGlyphDirectMapped(glyphPosition.glyph))
+            if (auto const directMappingIndex = directMappedTileIndex(glyphPosition.glyph))
             {
-                auto const directMappingIndex =
-                    _directMappedGlyphKeyToTileIndex[glyphPosition.glyph.index.value];
                 AtlasTileAttributes const& attributes = _textureAtlas->directMapped(directMappingIndex);
                 auto const pen1 = applyGlyphPositionToPen(pen, attributes, glyphPosition);
                 renderRasterizedGlyph(pen1, textClusterGroup_.color, attributes);
@@ -573,14 +722,18 @@ void TextRenderer::flushTextClusterGroup()
                 auto const pen1 = applyGlyphPositionToPen(pen, *attributes, glyphPosition);
                 renderRasterizedGlyph(pen1, textClusterGroup_.color, *attributes);
 
+                // Only the head tiles of glyphs sliced into the grid are followed by more tiles.
                 auto xOffset = unbox<uint32_t>(textureAtlas().tileSize().width);
-                while (AtlasTileAttributes const* subAttribs = textureAtlas().try_get(hash * xOffset))
+                if (attributes->bitmapSize.width == textureAtlas().tileSize().width)
                 {
-                    renderTile(atlas::RenderTile::X { pen1.x + int(xOffset) },
-                               atlas::RenderTile::Y { pen1.y },
-                               textClusterGroup_.color,
-                               *subAttribs);
-                    xOffset += unbox<uint32_t>(textureAtlas().tileSize().width);
+                    while (AtlasTileAttributes const* subAttribs = textureAtlas().try_get(hash * xOffset))
+                    {
+                        renderTile(atlas::RenderTile::X { pen1.x + int(xOffset) },
+                                   atlas::RenderTile::Y { pen1.y },
+                                   textClusterGroup_.color,
+                                   *subAttribs);
+                        xOffset += unbox<uint32_t>(textureAtlas().tileSize().width);
+                    }
                 }
             }
 
@@ -602,16 +755,33 @@ void TextRenderer::flushTextClusterGroup()
 Renderable::AtlasTileAttributes const* TextRenderer::getOrCreateRasterizedMetadata(
     StrongHash const& hash, text::glyph_key const& glyphKey, unicode::PresentationStyle presentationStyle)
 {
+    // Wide glyphs live in the shelves of the atlas, unless they did not fit there.
+    if (textureAtlas().shelfTileCount() != 0)
+        if (auto const attributes = textureAtlas().try_get_sized(hash))
+            return attributes;
+
+    if (rasterizationBudget_ && rasterizedGlyphCount_ >= rasterizationBudget_)
+    {
+        // Budget exhausted: render cached glyphs only and leave the others blank for this frame.
+        auto const attributes = textureAtlas().try_get(hash);
+        if (!attributes)
+            ++deferredGlyphCount_;
+        return attributes;
+    }
+
     // clang-format off
-    return textureAtlas().get_or_try_emplace(
-        hash,
-        [&](atlas::TileLocation tileLocation)
-        -> optional<TextureAtlas::TileCreateData>
-        {
-            return createSlicedRasterizedGlyph(tileLocation, glyphKey, presentationStyle, hash);
-        }
-    );
+    if (auto const attributes = textureAtlas().get_or_try_emplace(
+            hash,
+            [&](atlas::TileLocation tileLocation)
+            -> optional<TextureAtlas::TileCreateData>
+            {
+                ++rasterizedGlyphCount_;
+                return createSlicedRasterizedGlyph(tileLocation, glyphKey, presentationStyle, hash);
+            }))
+        return attributes;
     // clang-format on
+
+    return textureAtlas().try_get_sized(hash);
 }
 
 auto TextRenderer::createSlicedRasterizedGlyph(atlas::TileLocation tileLocation,
@@ -630,6 +800,16 @@ auto TextRenderer::createSlicedRasterizedGlyph(atlas::TileLocation tileLocation,
         // standard (narrow) rasterization
         return result;
 
+    // Wide glyphs are preferably kept in one piece in the shelves of the atlas,
+    // in which case the tile of the grid is not needed.
+    if (textureAtlas().hasShelfArea()
+        && textureAtlas().get_or_try_emplace_sized(
+            hash, createData.bitmapSize, [&](atlas::TileLocation shelfLocation) {
+                relocateTileData(createData, shelfLocation);
+                return optional<TextureAtlas::TileCreateData> { move(createData) };
+            }))
+        return nullopt;
+
     // Now, slice wide glyph into smaller fitting tiles,
     // upload all but the head-tile explicitly and then return the head-tile
     // to the caller.
@@ -696,7 +876,23 @@ auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
                                          unicode::PresentationStyle presentation)
     -> optional<TextureAtlas::TileCreateData>
 {
-    auto theGlyphOpt = textShaper_.rasterize(glyphKey, fontDescriptions_.renderMode);
+    CONTOUR_PERF_TRACE("TextRenderer::rasterize");
+
+    if (fontDescriptions_.signedDistanceFields && presentation != unicode::PresentationStyle::Emoji)
+        if (auto tileCreateData = createSdfGlyph(tileLocation, glyphKey); tileCreateData)
+            return tileCreateData;
+
+    auto const isEmoji = presentation == unicode::PresentationStyle::Emoji;
+    if (auto const* cachedGlyph = isEmoji ? emojiGlyphs_.try_get(glyphKey) : nullptr)
+        return { createTileData(tileLocation,
+                                cachedGlyph->bitmap,
+                                toAtlasFormat(cachedGlyph->format),
+                                cachedGlyph->bitmapSize,
+                                RenderTileAttributes::X { cachedGlyph->position.x },
+                                RenderTileAttributes::Y { cachedGlyph->position.y },
+                                toFragmentShaderSelector(cachedGlyph->format)) };
+
+    auto theGlyphOpt = textShaper_->rasterize(glyphKey, fontDescriptions_.renderMode);
     if (!theGlyphOpt.has_value())
         return nullopt;
 
@@ -724,6 +920,8 @@ auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
             glyph = move(scaledGlyph);
             // glyph.position.y = unbox<int>(glyph.bitmapSize.height) - _gridMetrics.underline.position;
         }
+        if (!emojiGlyphs_.contains(glyphKey))
+            emojiGlyphs_.emplace(glyphKey, text::rasterized_glyph(glyph));
     }
 
     // y-position relative to cell-bottom of glyphs top.
@@ -772,11 +970,91 @@ auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
                             toFragmentShaderSelector(glyph.format)) };
 }
 
+auto TextRenderer::createSdfGlyph(atlas::TileLocation tileLocation, text::glyph_key const& glyphKey)
+    -> optional<TextureAtlas::TileCreateData>
+{
+    auto const fonts = directMappedFonts();
+    auto const style = std::find(fonts.begin(), fonts.end(), glyphKey.font);
+    if (style == fonts.end())
+        return nullopt; // fallback fonts are rasterized at the actual size
+
+    auto const* referenceSdf =
+        getOrCreateReferenceSdf(static_cast<size_t>(std::distance(fonts.begin(), style)), glyphKey.index);
+    if (!referenceSdf)
+        return nullopt;
+
+    auto const pixelSize = fontDescriptions_.size.pt * fontDescriptions_.dpi.y / 72.0;
+    auto glyph =
+        text::scale_sdf(*referenceSdf, SdfReferenceSpread, pixelSize / SdfReferenceSize, GLYPH_SDF_SPREAD);
+
+    return { createTileData(tileLocation,
+                            move(glyph.bitmap),
+                            atlas::Format::Red,
+                            glyph.bitmapSize,
+                            RenderTileAttributes::X { glyph.position.x },
+                            RenderTileAttributes::Y { glyph.position.y },
+                            FRAGMENT_SELECTOR_GLYPH_SDF) };
+}
+
+text::rasterized_glyph const* TextRenderer::getOrCreateReferenceSdf(size_t styleIndex,
+                                                                    text::glyph_index index)
+{
+    if (!sdfFonts_)
+    {
+        auto const descriptions = std::array { fontDescriptions_.regular,
+                                               fontDescriptions_.bold,
+                                               fontDescriptions_.italic,
+                                               fontDescriptions_.boldItalic };
+        if (descriptions != sdfFontDescriptions_)
+        {
+            sdfGlyphs_.clear();
+            sdfFontDescriptions_ = descriptions;
+        }
+
+        // The reference size is given in pixels, so that it does not depend on the DPI.
+        auto referenceFonts = fontDescriptions_;
+        referenceFonts.size = text::font_size { SdfReferenceSize * 72.0 / fontDescriptions_.dpi.y };
+        sdfFonts_ = loadFontKeys(referenceFonts, textShaper_);
+    }
+
+    auto const key = (uint64_t(styleIndex) << 32) | index.value;
+    if (auto const i = sdfGlyphs_.find(key); i != sdfGlyphs_.end())
+        return i->second ? &*i->second : nullptr;
+
+    auto const referenceFonts =
+        std::array { sdfFonts_->regular, sdfFonts_->bold, sdfFonts_->italic, sdfFonts_->boldItalic };
+    auto const referenceSize = text::font_size { SdfReferenceSize * 72.0 / fontDescriptions_.dpi.y };
+    auto glyph = textShaper_->rasterize(text::glyph_key { referenceSize, referenceFonts[styleIndex], index },
+                                       text::render_mode::gray);
+
+    // Colored and LCD glyphs cannot be turned into a distance field.
+    auto& sdf = sdfGlyphs_[key];
+    if (glyph && glyph->format == text::bitmap_format::alpha_mask)
+        sdf = text::make_sdf(*glyph, SdfReferenceSpread);
+    return sdf ? &*sdf : nullptr;
+}
+
 text::shape_result const& TextRenderer::getOrCreateCachedGlyphPositions(StrongHash hash)
 {
     return textShapingCache_->get_or_emplace(hash, [this](auto) { return createTextShapedGlyphPositions(); });
 }
 
+text::shape_result const& TextRenderer::getOrCreateLineGlyphPositions()
+{
+    if (currentLineShaping_ && currentLineGroup_ < currentLineShaping_->groups.size())
+        return currentLineShaping_->groups[currentLineGroup_++];
+
+    auto const hash = hashTextAndStyle(
+        u32string_view(textClusterGroup_.codepoints.data(), textClusterGroup_.codepoints.size()),
+        textClusterGroup_.style);
+    text::shape_result const& glyphPositions = getOrCreateCachedGlyphPositions(hash);
+    if (!currentLineShaping_)
+        return glyphPositions;
+
+    ++currentLineGroup_;
+    return currentLineShaping_->groups.emplace_back(glyphPositions);
+}
+
 text::shape_result TextRenderer::createTextShapedGlyphPositions()
 {
     auto glyphPositions = text::shape_result {};
@@ -801,6 +1079,8 @@ text::shape_result TextRenderer::createTextShapedGlyphPositions()
  */
 text::shape_result TextRenderer::shapeTextRun(unicode::run_segmenter::range const& _run)
 {
+    CONTOUR_PERF_TRACE("TextRenderer::shapeTextRun");
+
     bool const isEmojiPresentation =
         get<unicode::PresentationStyle>(_run.properties) == unicode::PresentationStyle::Emoji;
 
@@ -813,7 +1093,7 @@ text::shape_result TextRenderer::shapeTextRun(unicode::run_segmenter::range cons
 
     text::shape_result glyphPosition;
     glyphPosition.reserve(clusters.size());
-    textShaper_.shape(font,
+    textShaper_->shape(font,
                       codepoints,
                       clusters,
                       get<unicode::Script>(_run.properties),
@@ -27,6 +27,7 @@
 
 #include <crispy/FNV.h>
 #include <crispy/LRUCache.h>
+#include <crispy/StrongSetAssociativeHashtable.h>
 #include <crispy/point.h>
 #include <crispy/size.h>
 
@@ -36,6 +37,7 @@
 #include <gsl/span>
 #include <gsl/span_ext>
 
+#include <array>
 #include <functional>
 #include <list>
 #include <memory>
@@ -56,6 +58,8 @@ struct FontKeys
     text::font_key emoji;
 };
 
+FontKeys loadFontKeys(FontDescriptions const& _fd, text::shaper& _shaper);
+
 /// Text Rendering Pipeline
 class TextRenderer: public Renderable
 {
@@ -74,8 +78,50 @@ class TextRenderer: public Renderable
 
     void updateFontMetrics();
 
+    using ShapingResultCache = crispy::StrongSetAssociativeHashtable<text::shape_result>;
+    using ShapingResultCachePtr = ShapingResultCache::Ptr;
+
+    /// Number of text shaping results cached unless changed with setShapingCacheCapacity().
+    static constexpr uint32_t DefaultShapingCacheCapacity = 4000;
+
+    /// Replaces the text shaper, which must be followed by updateFontMetrics().
+    void setTextShaper(text::shaper& _shaper) noexcept { textShaper_ = &_shaper; }
+
+    /// Replaces the text shaping cache, e.g. to keep the shaping results of a text shaper
+    /// that is being replaced, as they refer to the fonts of that shaper.
+    ///
+    /// @param _shapingCache  a shaping cache previously taken, or nullptr for an empty one.
+    ///
+    /// @returns the current shaping cache.
+    ShapingResultCachePtr exchangeShapingCache(ShapingResultCachePtr _shapingCache);
+
+    /// Replaces the text shaping cache with an empty one holding up to @p _capacity results.
+    void setShapingCacheCapacity(crispy::LRUCapacity _capacity);
+
     void setPressure(bool _pressure) noexcept { pressure_ = _pressure; }
 
+    /// Limits the number of glyphs to be rasterized per frame (0 for no limit).
+    ///
+    /// Glyphs beyond that budget are left blank for the current frame
+    /// and rasterized in one of the next frames.
+    void setRasterizationBudget(unsigned _glyphsPerFrame) noexcept { rasterizationBudget_ = _glyphsPerFrame; }
+
+    /// Returns the number of glyphs that have been left blank in the last frame due to the
+    /// rasterization budget.
+    [[nodiscard]] unsigned deferredGlyphCount() const noexcept { return deferredGlyphCount_; }
+
+    /// Returns the text shaping cache's hit statistics gathered since the last call.
+    crispy::LRUHashtableStats fetchAndClearShapingStats() noexcept
+    {
+        return textShapingCache_->fetchAndClearStats();
+    }
+
+    /// Returns the number of text shaping results currently cached.
+    [[nodiscard]] size_t shapingCacheSize() const noexcept { return textShapingCache_->size(); }
+
+    /// Returns the number of bytes allocated by the text shaping cache's hashtable.
+    [[nodiscard]] size_t shapingCacheStorageSize() const noexcept { return textShapingCache_->storageSize(); }
+
     /// Must be invoked before a new terminal frame is rendered.
     void beginFrame();
 
@@ -83,16 +129,41 @@ class TextRenderer: public Renderable
     /// transformed into a RenderCell.
     void renderCell(RenderCell const& _cell);
 
+    /// Renders the text of a run of cells, as a text cluster group of its own.
+    void renderRun(RenderRun const& _run);
+
     void renderCell(CellLocation position,
                     std::u32string_view graphemeCluster,
                     TextStyle textStyle,
                     RGBColor foregroundColor);
 
+    /// Must be invoked before the render cells of a single screen line are rendered.
+    ///
+    /// @param generation          the RenderLine::generation of that line, or 0 if unknown.
+    /// @param contextFingerprint  the RenderBuffer::contextFingerprint of the current frame.
+    ///
+    /// Lines with a known generation remember the shaping results of their text cluster groups,
+    /// so that rendering the unchanged line again in a later frame reuses them without hashing
+    /// or segmenting the line's text again.
+    void beginLine(uint64_t generation, uint64_t contextFingerprint);
+
+    /// Must be invoked after the render cells of a single screen line have been rendered.
+    void endLine();
+
     /// Must be invoked when rendering the terminal's text has finished for this frame.
     void endFrame();
 
+    /// Shapes the words of @p _text (one codepoint per column) into the text shaping cache and
+    /// rasterizes their glyphs, ahead of rendering them, e.g. for the lines the viewport is about
+    /// to scroll to (see RenderBuffer::prefetchRuns).
+    ///
+    /// Must be invoked between frames. Glyphs are only rasterized as far as the last frame left
+    /// the rasterization budget.
+    void prefetch(std::u32string_view _text, CellFlags _flags);
+
   private:
     void initializeDirectMapping();
+    void initializeDirectMapping(uint32_t styleIndex, text::font_key font);
 
     /// Puts a sequence of codepoints that belong to the same grid cell at @p _pos
     /// at the end of the currently filled line.
@@ -100,9 +171,11 @@ class TextRenderer: public Renderable
 
     /// Gets the text shaping result of the current text cluster group
     text::shape_result const& getOrCreateCachedGlyphPositions(crispy::StrongHash hash);
+    text::shape_result const& getOrCreateLineGlyphPositions();
     text::shape_result createTextShapedGlyphPositions();
     text::shape_result shapeTextRun(unicode::run_segmenter::range const& _run);
     void flushTextClusterGroup();
+    void prefetchTextClusterGroup();
 
     AtlasTileAttributes const* getOrCreateRasterizedMetadata(crispy::StrongHash const& hash,
                                                              text::glyph_key const& glyphKey,
@@ -121,6 +194,14 @@ class TextRenderer: public Renderable
     std::optional<TextureAtlas::TileCreateData> createRasterizedGlyph(
         atlas::TileLocation tileLocation, text::glyph_key const& id, unicode::PresentationStyle presentation);
 
+    /// Creates the tile of a glyph of the primary fonts from its signed distance field,
+    /// or returns std::nullopt if that glyph cannot be rendered from one.
+    std::optional<TextureAtlas::TileCreateData> createSdfGlyph(atlas::TileLocation tileLocation,
+                                                               text::glyph_key const& id);
+
+    /// Returns the signed distance field of the given glyph at the reference size, or nullptr.
+    text::rasterized_glyph const* getOrCreateReferenceSdf(size_t styleIndex, text::glyph_index index);
+
     crispy::Point applyGlyphPositionToPen(crispy::Point pen,
                                           AtlasTileAttributes const& tileAttributes,
                                           text::glyph_position const& gpos) const noexcept;
@@ -138,26 +219,64 @@ class TextRenderer: public Renderable
     //
     bool pressure_ = false;
 
-    using ShapingResultCache = crispy::StrongLRUHashtable<text::shape_result>;
-    using ShapingResultCachePtr = ShapingResultCache::Ptr;
+    unsigned rasterizationBudget_ = 0;
+    unsigned rasterizedGlyphCount_ = 0; // number of glyphs rasterized in the current frame
+    unsigned deferredGlyphCount_ = 0;   // number of glyphs deferred in the current frame
 
+    crispy::LRUCapacity shapingCacheCapacity_ { DefaultShapingCacheCapacity };
     ShapingResultCachePtr textShapingCache_;
     // TODO: make unique_ptr, get owned, export cref for other users in Renderer impl.
-    text::shaper& textShaper_;
+    text::shaper* textShaper_;
 
     DirectMapping _directMapping {};
 
-    // Maps from glyph index to tile index.
-    std::vector<uint32_t> _directMappedGlyphKeyToTileIndex {};
+    // Maps from glyph index to tile index, one table per direct-mapped font style
+    // (regular, bold, italic, bold-italic). These tiles are never evicted from the atlas.
+    std::array<std::vector<uint32_t>, 4> _directMappedGlyphKeyToTileIndex {};
 
-    bool isGlyphDirectMapped(text::glyph_key const& glyph) const noexcept
+    std::array<text::font_key, 4> directMappedFonts() const noexcept
     {
-        return _directMapping                  // Is direct mapping enabled?
-               && glyph.font == fonts_.regular // Only regular font is direct-mapped for now.
-               && glyph.index.value < _directMappedGlyphKeyToTileIndex.size()
-               && _directMappedGlyphKeyToTileIndex[glyph.index.value] != 0;
+        return { fonts_.regular, fonts_.bold, fonts_.italic, fonts_.boldItalic };
+    }
+
+    /// Returns the direct-mapped tile index for the given glyph, or 0 if it is not direct-mapped.
+    uint32_t directMappedTileIndex(text::glyph_key const& glyph) const noexcept
+    {
+        if (!_directMapping) // Is direct mapping enabled?
+            return 0;
+
+        auto const fonts = directMappedFonts();
+        for (size_t styleIndex = 0; styleIndex < fonts.size(); ++styleIndex)
+        {
+            if (!(glyph.font == fonts[styleIndex]))
+                continue;
+            auto const& glyphToTileIndex = _directMappedGlyphKeyToTileIndex[styleIndex];
+            return glyph.index.value < glyphToTileIndex.size() ? glyphToTileIndex[glyph.index.value] : 0;
+        }
+        return 0;
     }
 
+    // {{{ signed distance field rendering
+    // The em size (in pixels) that the signed distance fields are rasterized at,
+    // and the distance (in pixels) that they span around the glyph outlines.
+    static constexpr double SdfReferenceSize = 64.0;
+    static constexpr int SdfReferenceSpread = 8;
+
+    // The primary fonts at the reference size, reloaded after any font change.
+    std::optional<FontKeys> sdfFonts_;
+
+    // The primary fonts that the reference signed distance fields have been rasterized from.
+    std::array<text::font_description, 4> sdfFontDescriptions_ {};
+
+    // Reference signed distance fields, by style index (high 32 bits) and glyph index (low 32 bits).
+    // These survive font size and DPI changes.
+    std::unordered_map<uint64_t, std::optional<text::rasterized_glyph>> sdfGlyphs_;
+    // }}}
+
+    // Color emoji glyphs, already scaled down from the font's fixed strike size to the cells,
+    // as their tiles get evicted from the atlas and recreated frequently when scrolling.
+    crispy::LRUCache<text::glyph_key, text::rasterized_glyph> emojiGlyphs_;
+
     // sub-renderer
     //
     BoxDrawingRenderer boxDrawingRenderer_;
@@ -194,6 +313,20 @@ class TextRenderer: public Renderable
     };
     TextClusterGroup textClusterGroup_ {};
 
+    // Shaping results of all text cluster groups of a single screen line, in render order.
+    struct LineShapingResult
+    {
+        uint64_t contextFingerprint = 0;
+        uint64_t lastUsedFrame = 0;
+        std::vector<text::shape_result> groups;
+    };
+
+    // Maps from line generation to the shaping results of that line.
+    std::unordered_map<uint64_t, LineShapingResult> lineShapingCache_ {};
+    LineShapingResult* currentLineShaping_ = nullptr;
+    size_t currentLineGroup_ = 0;
+    uint64_t frameCount_ = 0;
+
     bool textStartFound_ = false;
     bool updateInitialPenPosition_ = false;
 };
@@ -16,6 +16,8 @@
 #include <terminal/Color.h>
 #include <terminal/primitives.h> // ImageSize
 
+#include <crispy/LRUCache.h>
+#include <crispy/ShelfPacker.h>
 #include <crispy/StrongHash.h>
 #include <crispy/StrongLRUHashtable.h>
 #include <crispy/assert.h>
@@ -23,6 +25,9 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <variant> // monostate
 #include <vector>
 
@@ -126,6 +131,10 @@ struct AtlasProperties
     // This can be for example [A-Za-z0-9], characters that are most often
     // used and least likely part of a ligature.
     uint32_t directMappingCount {};
+
+    // Number of tiles worth of atlas area to set aside for tiles of individual sizes,
+    // such as wide glyphs, which are packed into shelves below the grid of tiles.
+    uint32_t shelfTileCount {};
 };
 
 // -----------------------------------------------------------------------
@@ -221,6 +230,18 @@ struct TileAttributes
     Metadata metadata;
 };
 
+/// Space usage of a texture atlas.
+struct AtlasOccupancy
+{
+    size_t usedArea = 0;  // pixels covered by tiles, direct mapped ones included
+    size_t totalArea = 0; // pixels of the atlas texture
+
+    [[nodiscard]] double ratio() const noexcept
+    {
+        return totalArea ? static_cast<double>(usedArea) / static_cast<double>(totalArea) : 0.0;
+    }
+};
+
 /**
  * Manages the tiles of a single texture atlas.
  *
@@ -234,6 +255,9 @@ struct TileAttributes
  * The metadata can be for example the render offset relative to the
  * target render base position and the actual tile size
  * (which must be smaller or equal to the tile size).
+ *
+ * Tiles of individual sizes, such as wide glyphs, are packed into shelves
+ * below the grid of tiles, if AtlasProperties::shelfTileCount sets aside space for them.
  */
 template <typename Metadata = std::monostate>
 class TextureAtlas
@@ -250,6 +274,13 @@ class TextureAtlas
 
     [[nodiscard]] ImageSize atlasSize() const noexcept { return _atlasSize; }
     [[nodiscard]] ImageSize tileSize() const noexcept { return _atlasProperties.tileSize; }
+    [[nodiscard]] Format format() const noexcept { return _atlasProperties.format; }
+
+    /// Number of bytes of the atlas texture in the backend.
+    [[nodiscard]] size_t textureBytes() const noexcept
+    {
+        return _atlasSize.area() * element_count(_atlasProperties.format);
+    }
 
     // Tests in LRU-cache if the tile
     [[nodiscard]] constexpr bool contains(crispy::StrongHash const& _id) const noexcept;
@@ -279,6 +310,27 @@ class TextureAtlas
     template <typename CreateTileDataFn>
     void emplace(crispy::StrongHash const& key, CreateTileDataFn constructValue);
 
+    /// Retrieves a tile of individual size, see get_or_try_emplace_sized().
+    [[nodiscard]] TileAttributes<Metadata> const* try_get_sized(crispy::StrongHash const& key);
+
+    /// Returns the tile of individual size by the given key, creating it by invoking constructValue()
+    /// if not present yet.
+    ///
+    /// Unlike the grid's tiles, these tiles can be of any size up to the shelf area's.
+    /// The least recently used of them are evicted until the new tile fits.
+    ///
+    /// @returns nullptr if the tile does not fit the shelf area or could not be created.
+    template <typename CreateTileDataFn>
+    [[nodiscard]] TileAttributes<Metadata> const* get_or_try_emplace_sized(crispy::StrongHash const& key,
+                                                                           ImageSize size,
+                                                                           CreateTileDataFn constructValue);
+
+    /// Tests whether tiles of individual sizes can be stored, see get_or_try_emplace_sized().
+    [[nodiscard]] bool hasShelfArea() const noexcept { return _shelves.height() != 0; }
+
+    // Retrieves the number of tiles of individual sizes currently held.
+    [[nodiscard]] size_t shelfTileCount() const noexcept { return _shelfTiles.size(); }
+
     void remove(crispy::StrongHash key);
 
     // Uploads tile data to a direct-mapped slot in the texture atlas
@@ -292,6 +344,24 @@ class TextureAtlas
     // The index must be between 0 and number of direct-mapped tiles minus 1.
     TileAttributes<Metadata> const& directMapped(uint32_t index) const;
 
+    /// Returns the tile cache statistics gathered since the last call and starts counting anew.
+    crispy::LRUHashtableStats fetchAndClearStats() noexcept
+    {
+        auto stats = _tileCache->fetchAndClearStats();
+        stats.hits += _shelfStats.hits;
+        stats.misses += _shelfStats.misses;
+        stats.recycles += _shelfStats.recycles;
+        _shelfStats = {};
+        return stats;
+    }
+
+    [[nodiscard]] AtlasOccupancy occupancy() const noexcept
+    {
+        auto const tileCount = _tileCache->size() + _atlasProperties.directMappingCount;
+        return AtlasOccupancy { tileCount * _atlasProperties.tileSize.area() + _shelves.usedArea(),
+                                _atlasSize.area() };
+    }
+
     [[nodiscard]] bool isDirectMappingEnabled() const noexcept { return !_directMapping.empty(); }
 
     [[nodiscard]] TileLocation tileLocation(uint32_t tileIndex) const { return _tileLocations[tileIndex]; }
@@ -299,6 +369,12 @@ class TextureAtlas
     // Retrieves the number of total tiles that can be stored.
     [[nodiscard]] size_t capacity() const noexcept { return _tileLocations.size(); }
 
+    // Retrieves the number of tiles currently held by the LRU cache (excluding direct mapped tiles).
+    [[nodiscard]] size_t cachedTileCount() const noexcept { return _tileCache->size(); }
+
+    // Retrieves the number of bytes allocated by the LRU cache's hashtable.
+    [[nodiscard]] size_t tileCacheStorageSize() const noexcept { return _tileCache->storageSize(); }
+
     void inspect(std::ostream& output) const;
 
     [[nodiscard]] uint32_t tilesInX() const noexcept { return _tilesInX; }
@@ -308,6 +384,12 @@ class TextureAtlas
     using TileCache = crispy::StrongLRUHashtable<TileAttributes<Metadata>>;
     using TileCachePtr = typename TileCache::Ptr;
 
+    struct ShelfTile
+    {
+        TileAttributes<Metadata> attributes;
+        crispy::ShelfPacker::Region region;
+    };
+
     template <typename CreateTileDataFn>
     std::optional<TileAttributes<Metadata>> constructTile(CreateTileDataFn fn, uint32_t entryIndex);
 
@@ -324,6 +406,11 @@ class TextureAtlas
     // A vector of precomputed mappings from entry index to TileLocation.
     std::vector<TileLocation> _tileLocations;
 
+    // The area below the grid of tiles, holding the tiles of individual sizes.
+    crispy::ShelfPacker _shelves;
+    crispy::LRUCache<crispy::StrongHash, ShelfTile> _shelfTiles;
+    crispy::LRUHashtableStats _shelfStats {};
+
     // A vector holding the tile meta data for the direct mapped textures.
     std::vector<TileAttributes<Metadata>> _directTileMapping;
 
@@ -448,7 +535,9 @@ inline ImageSize computeAtlasSize(AtlasProperties const& atlasProperties) noexce
     using std::sqrt;
 
     // clang-format off
-    auto const totalTileCount = crispy::nextPowerOfTwo(1 + atlasProperties.tileCount.value + atlasProperties.directMappingCount);
+    auto const totalTileCount = crispy::nextPowerOfTwo(1 + atlasProperties.tileCount.value
+                                                       + atlasProperties.directMappingCount
+                                                       + atlasProperties.shelfTileCount);
     //auto const totalTileCount = atlasProperties.tileCount.value + atlasProperties.directMappingCount;
     auto const squareEdgeCount = static_cast<uint32_t>(ceil(sqrt(totalTileCount)));
     auto const width = Width::cast_from(crispy::nextPowerOfTwo(static_cast<uint32_t>(
@@ -485,7 +574,12 @@ TextureAtlas<Metadata>::TextureAtlas(AtlasBackend& backend, AtlasProperties atla
         auto const tilesInY =
             unbox<uint32_t>(_atlasSize.height) / unbox<uint32_t>(_atlasProperties.tileSize.height);
         Require(tilesInY != 0);
-        return tilesInY;
+        if (!_atlasProperties.shelfTileCount)
+            return tilesInY;
+
+        // The grid takes just the rows it needs, leaving the others to the shelves.
+        auto const gridTileCount = 1 + _atlasProperties.tileCount.value + _atlasProperties.directMappingCount;
+        return std::min(tilesInY, (gridTileCount + _tilesInX - 1) / _tilesInX);
     }() },
     _tileCache { TileCache::create(
         atlasProperties.hashCount,
@@ -495,7 +589,11 @@ TextureAtlas<Metadata>::TextureAtlas(AtlasBackend& backend, AtlasProperties atla
                               // is between 1 and capacity inclusive)
                               _tilesInX * _tilesInY - _atlasProperties.directMappingCount - 1 },
         "LRU cache for texture atlas") },
-    _tileLocations { static_cast<size_t>(_tilesInX * _tilesInY) }
+    _tileLocations { static_cast<size_t>(_tilesInX * _tilesInY) },
+    _shelves { unbox<uint32_t>(_atlasSize.width),
+               unbox<uint32_t>(_atlasSize.height)
+                   - _tilesInY * unbox<uint32_t>(_atlasProperties.tileSize.height) },
+    _shelfTiles { std::numeric_limits<size_t>::max() }
 {
     Require(_atlasProperties.tileCount.value <= _tileCache->capacity());
     Require(_atlasProperties.directMappingCount + _atlasProperties.tileCount.value <= _tilesInX * _tilesInY);
@@ -619,10 +717,84 @@ void TextureAtlas<Metadata>::emplace(crispy::StrongHash const& key, CreateTileDa
     // clang-format on
 }
 
+template <typename Metadata>
+TileAttributes<Metadata> const* TextureAtlas<Metadata>::try_get_sized(crispy::StrongHash const& key)
+{
+    auto const* tile = _shelfTiles.try_get(key);
+    if (!tile)
+        return nullptr;
+
+    ++_shelfStats.hits;
+    return &tile->attributes;
+}
+
+template <typename Metadata>
+template <typename CreateTileDataFn>
+TileAttributes<Metadata> const* TextureAtlas<Metadata>::get_or_try_emplace_sized(
+    crispy::StrongHash const& key, ImageSize size, CreateTileDataFn createTileData)
+{
+    if (auto const* attributes = try_get_sized(key))
+        return attributes;
+
+    ++_shelfStats.misses;
+
+    auto const width = unbox<uint32_t>(size.width);
+    auto const height = unbox<uint32_t>(size.height);
+    if (width > _shelves.width() || height > _shelves.height())
+        return nullptr;
+
+    auto region = _shelves.allocate(width, height);
+    while (!region && _shelfTiles.size() != 0)
+    {
+        auto const leastRecentlyUsed = std::prev(_shelfTiles.end());
+        _shelves.release(leastRecentlyUsed->value.region);
+        _shelfTiles.erase(leastRecentlyUsed);
+        ++_shelfStats.recycles;
+        region = _shelves.allocate(width, height);
+    }
+    if (!region)
+        return nullptr;
+
+    auto const gridHeight = _tilesInY * unbox<uint32_t>(_atlasProperties.tileSize.height);
+    auto const tileLocation = TileLocation({ static_cast<uint16_t>(region->x) },
+                                           { static_cast<uint16_t>(gridHeight + region->y) });
+
+    std::optional<TileCreateData> tileCreateDataOpt = createTileData(tileLocation);
+    if (!tileCreateDataOpt)
+    {
+        _shelves.release(*region);
+        return nullptr;
+    }
+
+    TileCreateData& tileCreateData = *tileCreateDataOpt;
+    Require(tileCreateData.bitmapSize.width <= size.width);
+    Require(tileCreateData.bitmapSize.height <= size.height);
+
+    auto tileUpload = UploadTile {};
+    tileUpload.location = tileLocation;
+    tileUpload.bitmapSize = tileCreateData.bitmapSize;
+    tileUpload.bitmapFormat = tileCreateData.bitmapFormat;
+    tileUpload.bitmap = std::move(tileCreateData.bitmap);
+    _backend.uploadTile(std::move(tileUpload));
+
+    auto instance = TileAttributes<Metadata> {};
+    instance.location = tileLocation;
+    instance.bitmapSize = tileCreateData.bitmapSize;
+    instance.metadata = std::move(tileCreateData.metadata);
+
+    return &_shelfTiles.emplace(key, ShelfTile { std::move(instance), *region }).attributes;
+}
+
 template <typename Metadata>
 void TextureAtlas<Metadata>::remove(crispy::StrongHash key)
 {
     _tileCache->remove(key);
+
+    if (auto const* tile = _shelfTiles.try_get(key))
+    {
+        _shelves.release(tile->region);
+        _shelfTiles.erase(key);
+    }
 }
 
 template <typename Metadata>
@@ -630,6 +802,8 @@ void TextureAtlas<Metadata>::reset(AtlasProperties atlasProperties)
 {
     _atlasProperties = atlasProperties;
     _tileCache->clear();
+    _shelfTiles.clear();
+    _shelves.clear();
 }
 
 template <typename Metadata>
@@ -669,6 +843,9 @@ void TextureAtlas<Metadata>::inspect(std::ostream& output) const
     output << fmt::format("atlas size     : {}\n", _atlasSize);
     output << fmt::format("tile size      : {}\n", _atlasProperties.tileSize);
     output << fmt::format("direct mapped  : {}\n", _atlasProperties.directMappingCount);
+    output << fmt::format("shelf area     : {}x{}\n", _shelves.width(), _shelves.height());
+    output << fmt::format("shelf tiles    : {} in {} shelves\n", _shelfTiles.size(), _shelves.shelfCount());
+    output << fmt::format("occupancy      : {:.1f}%\n", occupancy().ratio() * 100.0);
     output << '\n';
     _tileCache->inspect(output);
 }
@@ -744,10 +921,11 @@ struct formatter<terminal::renderer::atlas::AtlasProperties>
     auto format(terminal::renderer::atlas::AtlasProperties const& value, FormatContext& ctx)
     {
         return format_to(ctx.out(),
-                         "tile size {}, format {}, direct-mapped {}",
+                         "tile size {}, format {}, direct-mapped {}, shelf tiles {}",
                          value.tileSize,
                          value.format,
-                         value.directMappingCount);
+                         value.directMappingCount,
+                         value.shelfTileCount);
     }
 };
 } // namespace fmt
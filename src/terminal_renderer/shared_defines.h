@@ -13,3 +13,9 @@
 
 // Render an LCD-subpixel antialiased glyph (advanced algorithm)
 #define FRAGMENT_SELECTOR_GLYPH_LCD 3
+
+// Render a glyph from its signed distance field in the red channel.
+#define FRAGMENT_SELECTOR_GLYPH_SDF 4
+
+// Distance (in pixels) that a signed distance field glyph tile encodes around the glyph's outline.
+#define GLYPH_SDF_SPREAD 1
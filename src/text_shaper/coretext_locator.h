@@ -16,18 +16,29 @@
 #include <text_shaper/font.h>
 #include <text_shaper/font_locator.h>
 
+#include <string>
+
 namespace text
 {
+/**
+ * Font locator API implementation using CoreText (macOS).
+ *
+ * Resolved font chains are persisted in the optionally given cache file, so that
+ * subsequent starts can skip descriptor matching. They are dropped when fonts are
+ * (un)installed or (un)registered.
+ */
 class coretext_locator: public font_locator
 {
   public:
-    coretext_locator();
+    explicit coretext_locator(std::string _cacheFilePath = {});
 
     font_source_list locate(font_description const& description) override;
     font_source_list all() override;
     font_source_list resolve(gsl::span<const char32_t> codepoints) override;
 
   private:
+    font_source_list locateUncached(font_description const& description);
+
     struct Private;
     std::unique_ptr<Private, void (*)(Private*)> d;
 };
@@ -15,8 +15,17 @@
 
 #include <text_shaper/coretext_locator.h>
 #include <text_shaper/font.h>
+#include <text_shaper/font_chain_cache.h>
 #include <text_shaper/font_locator.h>
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #import <AppKit/AppKit.h>
 #import <CoreText/CoreText.h>
 #import <Foundation/Foundation.h>
@@ -30,6 +39,7 @@ namespace text
             auto const fontRef = CTFontDescriptorCreateWithNameAndSize((CFStringRef)_name, 16.0);
 
             CFURLRef const url = (CFURLRef)CTFontDescriptorCopyAttribute(fontRef, kCTFontURLAttribute);
+            CFRelease(fontRef);
             NSString const* fontPath = [NSString stringWithString: [(NSURL const*)CFBridgingRelease(url) path]];
 
             return font_path{[fontPath cStringUsingEncoding: [NSString defaultCStringEncoding]]};
@@ -65,25 +75,85 @@ namespace text
 
             return font_slant::normal;
         }
+
+        // First line of the font chain cache file, followed by the font directories stamp.
+        constexpr auto CacheFileMagic = std::string_view("contour-coretext-chains 1");
+
+        /// Returns the newest modification time of the font directories,
+        /// which changes whenever fonts are (un)installed.
+        int64_t fontDirectoriesStamp()
+        {
+            auto directories = std::vector<std::string> { "/System/Library/Fonts", "/Library/Fonts" };
+            if (auto const* home = getenv("HOME"); home && *home)
+                directories.emplace_back(std::string(home) + "/Library/Fonts");
+
+            auto stamp = int64_t { 0 };
+            for (auto const& directory: directories)
+            {
+                struct stat st = {};
+                if (stat(directory.c_str(), &st) == 0)
+                    stamp = std::max(stamp, static_cast<int64_t>(st.st_mtime));
+            }
+            return stamp;
+        }
     }
 
     struct coretext_locator::Private
     {
         NSFontManager* fm = [NSFontManager sharedFontManager];
 
+        // Resolved font chains, persisted in the cache file.
+        font_chain_cache chains;
+
+        explicit Private(std::string _cacheFilePath):
+            chains { CacheFileMagic, std::move(_cacheFilePath), fontDirectoriesStamp() }
+        {
+            // Fonts may also be (un)registered by applications at runtime.
+            CFNotificationCenterAddObserver(CFNotificationCenterGetLocalCenter(),
+                                            this,
+                                            &Private::registeredFontsChanged,
+                                            kCTFontManagerRegisteredFontsChangedNotification,
+                                            nullptr,
+                                            CFNotificationSuspensionBehaviorDeliverImmediately);
+        }
+
         ~Private()
         {
+            CFNotificationCenterRemoveEveryObserver(CFNotificationCenterGetLocalCenter(), this);
             [fm release];
         }
+
+        static void registeredFontsChanged(CFNotificationCenterRef /*_center*/,
+                                           void* _observer,
+                                           CFStringRef /*_name*/,
+                                           void const* /*_object*/,
+                                           CFDictionaryRef /*_userInfo*/)
+        {
+            static_cast<Private*>(_observer)->chains.clear(fontDirectoriesStamp());
+        }
     };
 
 
-    coretext_locator::coretext_locator() :
-        d{ new Private(), [](Private* p) { delete p; } }
+    coretext_locator::coretext_locator(std::string _cacheFilePath) :
+        d{ new Private(std::move(_cacheFilePath)), [](Private* p) { delete p; } }
     {
     }
 
     font_source_list coretext_locator::locate(font_description const& _fd)
+    {
+        if (auto chain = d->chains.find(_fd))
+        {
+            LocatorLog()("Using cached font chain for: {}", _fd);
+            return std::move(*chain);
+        }
+
+        auto output = locateUncached(_fd);
+        if (!output.empty())
+            d->chains.store(_fd, output);
+        return output;
+    }
+
+    font_source_list coretext_locator::locateUncached(font_description const& _fd)
     {
         LocatorLog()("Locating font chain for: {}", _fd);
 
@@ -113,7 +183,6 @@ namespace text
             {
                 for (NSArray* object in fonts)
                 {
-                    auto path = ctFontPath([object objectAtIndex: 0]);
                     auto const weight = ctFontWeight([[object objectAtIndex: 2] intValue]);
 
                     if (forceWeight && weight != _fd.weight)
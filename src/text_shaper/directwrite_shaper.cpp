@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <string>
+#include <unordered_map>
 
 // {{{ TODO: replace with libunicode
 #include <codecvt>
@@ -29,6 +30,7 @@ using std::optional;
 using std::pair;
 using std::string;
 using std::u32string;
+using std::unordered_map;
 using std::vector;
 using std::wstring;
 using std::wstring_convert;
@@ -41,12 +43,12 @@ namespace
                                 const RECT& _textureBounds,
                                 const DWRITE_COLOR_F& runColor,
                                 bitmap_format _targetFormat,
+                                std::vector<uint8_t>& tmp,
                                 std::vector<uint8_t>::iterator& _it)
     {
         const auto width = _textureBounds.right - _textureBounds.left;
         const auto height = _textureBounds.bottom - _textureBounds.top;
 
-        std::vector<uint8_t> tmp;
         tmp.resize(height * width * 3);
 
         auto hr = _glyphAnalysis->CreateAlphaTexture(
@@ -103,15 +105,17 @@ struct DxFontInfo
     font_size size;
     font_metrics metrics;
     int fontUnitsPerEm;
+    DWRITE_RENDERING_MODE renderingMode;
 
-    // Owning pointer
-    IDWriteFontFace5* fontFace;
+    ComPtr<IDWriteFontFace5> fontFace;
 };
 
 struct directwrite_shaper::Private
 {
     ComPtr<IDWriteFactory7> factory;
+    ComPtr<IDWriteFactory2> factory2;
     ComPtr<IDWriteTextAnalyzer1> textAnalyzer;
+    ComPtr<IDWriteRenderingParams> renderingParams;
     std::unique_ptr<font_locator> locator_;
 
     DPI dpi_;
@@ -119,6 +123,16 @@ struct directwrite_shaper::Private
     std::unordered_map<font_key, DxFontInfo> fonts;
     std::unordered_map<font_key, bool> fontsHasColor;
 
+    // Font keys by font file path and font size, so that fonts (such as fallback fonts
+    // resolved while shaping) are set up only once.
+    unordered_map<wstring, font_key> fontPathAndSizeToKeyMapping;
+
+    // Font faces by font file path. They do not depend on the font size nor the DPI.
+    unordered_map<wstring, ComPtr<IDWriteFontFace5>> fontFaces;
+
+    // Scratch buffer for the alpha textures of glyphs being rasterized.
+    std::vector<uint8_t> alphaTexture;
+
     font_key nextFontKey;
 
     Private(DPI dpi, std::unique_ptr<font_locator> _locator): dpi_ { dpi }, locator_ { move(_locator) }
@@ -129,6 +143,8 @@ struct directwrite_shaper::Private
         ComPtr<IDWriteTextAnalyzer> analyzer;
         hr = factory->CreateTextAnalyzer(&analyzer);
         analyzer.As(&textAnalyzer);
+        factory.As(&factory2);
+        factory->CreateRenderingParams(&renderingParams);
 
         wchar_t locale[LOCALE_NAME_MAX_LENGTH];
         GetUserDefaultLocaleName(locale, sizeof(locale));
@@ -156,31 +172,18 @@ struct directwrite_shaper::Private
         std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> wStringConverter;
         std::wstring wSourcePath = wStringConverter.from_bytes(sourcePath.value);
 
-        ComPtr<IDWriteFontFile> fontFile;
-        auto hr = factory->CreateFontFileReference(wSourcePath.c_str(), NULL, &fontFile);
-        if (FAILED(hr))
-        {
-            return nullopt;
-        }
+        auto const pathAndSize = wSourcePath + L'@' + std::to_wstring(_size.pt);
+        if (auto i = fontPathAndSizeToKeyMapping.find(pathAndSize); i != fontPathAndSizeToKeyMapping.end())
+            return i->second;
 
-        BOOL isSupported {};
-        DWRITE_FONT_FILE_TYPE fileType {};
-        DWRITE_FONT_FACE_TYPE fontFaceType {};
-        UINT32 numFaces {};
-        IDWriteFontFace* fontFace {};
-        fontFile->Analyze(&isSupported, &fileType, &fontFaceType, &numFaces);
-        hr = factory->CreateFontFace(
-            fontFaceType, 1, fontFile.GetAddressOf(), 0, DWRITE_FONT_SIMULATIONS_NONE, &fontFace);
-        if (FAILED(hr))
+        auto fontFace = getOrCreateFontFace(wSourcePath);
+        if (!fontFace)
         {
             return nullopt;
         }
 
-        IDWriteFontFace3* fontFace3 {};
-        fontFace->QueryInterface(&fontFace3);
-
         ComPtr<IDWriteLocalizedStrings> familyNames {};
-        fontFace3->GetFamilyNames(&familyNames);
+        fontFace->GetFamilyNames(&familyNames);
 
         BOOL localeExists = FALSE;
         unsigned index {};
@@ -213,12 +216,8 @@ struct directwrite_shaper::Private
 
         familyNames->GetString(index, resolvedFamilyName.data(), length + 1);
 
-        for (auto&& [fontKey, fontInfo]: fonts)
-            if (_description == fontInfo.description && fontInfo.fontFace->Equals(fontFace))
-                return fontKey;
-
-        auto dwMetrics = DWRITE_FONT_METRICS {};
-        fontFace3->GetMetrics(&dwMetrics);
+        auto dwMetrics = DWRITE_FONT_METRICS1 {};
+        fontFace->GetMetrics(&dwMetrics);
 
         auto const dipScalar = ptToEm(_size.pt) / dwMetrics.designUnitsPerEm * pixelPerDip();
         auto const lineHeight = dwMetrics.ascent + dwMetrics.descent + dwMetrics.lineGap;
@@ -233,16 +232,62 @@ struct directwrite_shaper::Private
         fontInfo.metrics.descender = int(ceil(dwMetrics.descent * dipScalar));
         fontInfo.metrics.underline_position = int(ceil(dwMetrics.underlinePosition * dipScalar));
         fontInfo.metrics.underline_thickness = int(ceil(dwMetrics.underlineThickness * dipScalar));
-        fontInfo.metrics.advance = int(ceil(computeAverageAdvance(fontFace) * dipScalar));
+        fontInfo.metrics.advance = int(ceil(computeAverageAdvance(fontFace.Get()) * dipScalar));
 
-        fontFace->QueryInterface(&fontInfo.fontFace);
+        auto hr = fontFace->GetRecommendedRenderingMode(ptToEm(_size.pt),
+                                                        pixelPerDip(),
+                                                        DWRITE_MEASURING_MODE::DWRITE_MEASURING_MODE_NATURAL,
+                                                        renderingParams.Get(),
+                                                        &fontInfo.renderingMode);
+        if (FAILED(hr))
+        {
+            fontInfo.renderingMode = DWRITE_RENDERING_MODE_NATURAL_SYMMETRIC;
+        }
+
+        fontInfo.fontFace = move(fontFace);
 
         auto key = create_font_key();
+        fontPathAndSizeToKeyMapping.emplace(pair { pathAndSize, key });
         fonts.emplace(pair { key, move(fontInfo) });
         fontsHasColor.emplace(pair { key, false });
         return key;
     }
 
+    ComPtr<IDWriteFontFace5> getOrCreateFontFace(std::wstring const& _path)
+    {
+        if (auto i = fontFaces.find(_path); i != fontFaces.end())
+            return i->second;
+
+        ComPtr<IDWriteFontFile> fontFile;
+        auto hr = factory->CreateFontFileReference(_path.c_str(), NULL, &fontFile);
+        if (FAILED(hr))
+        {
+            return nullptr;
+        }
+
+        BOOL isSupported {};
+        DWRITE_FONT_FILE_TYPE fileType {};
+        DWRITE_FONT_FACE_TYPE fontFaceType {};
+        UINT32 numFaces {};
+        ComPtr<IDWriteFontFace> fontFace;
+        fontFile->Analyze(&isSupported, &fileType, &fontFaceType, &numFaces);
+        hr = factory->CreateFontFace(
+            fontFaceType, 1, fontFile.GetAddressOf(), 0, DWRITE_FONT_SIMULATIONS_NONE, &fontFace);
+        if (FAILED(hr))
+        {
+            return nullptr;
+        }
+
+        ComPtr<IDWriteFontFace5> fontFace5;
+        if (FAILED(fontFace.As(&fontFace5)))
+        {
+            return nullptr;
+        }
+
+        fontFaces.emplace(pair { _path, fontFace5 });
+        return fontFace5;
+    }
+
     int computeAverageAdvance(IDWriteFontFace* _fontFace)
     {
         auto constexpr firstCharIndex = UINT16 { 32 };
@@ -307,8 +352,8 @@ void directwrite_shaper::shape(font_key _font,
 
     WCHAR const* textString = wText.c_str();
     UINT32 textLength = wText.size();
-    DxFontInfo fontInfo = d->fonts.at(_font);
-    IDWriteFontFace5* fontFace = fontInfo.fontFace;
+    DxFontInfo const* fontInfo = &d->fonts.at(_font);
+    IDWriteFontFace5* fontFace = fontInfo->fontFace.Get();
 
     vector<UINT16> glyphIndices;
     vector<INT32> glyphDesignUnitAdvances;
@@ -343,10 +388,10 @@ void directwrite_shaper::shape(font_key _font,
         for (size_t i = glyphStart; i < textLength; i++)
         {
             const auto cellWidth = static_cast<double>((float) glyphDesignUnitAdvances.at(i))
-                                   / designUnitsPerEm * ptToEm(fontInfo.size.pt) * d->pixelPerDip();
+                                   / designUnitsPerEm * ptToEm(fontInfo->size.pt) * d->pixelPerDip();
             glyph_position gpos {};
             gpos.presentation = _presentation;
-            gpos.glyph = glyph_key { fontInfo.size, _font, glyph_index { glyphIndices.at(i) } };
+            gpos.glyph = glyph_key { fontInfo->size, _font, glyph_index { glyphIndices.at(i) } };
             gpos.advance.x = static_cast<int>(cellWidth);
             _result.emplace_back(gpos);
         }
@@ -396,12 +441,12 @@ void directwrite_shaper::shape(font_key _font,
                 if (sources.size() > 0)
                 {
                     optional<font_key> fontKeyOpt =
-                        d->add_font(sources[0], fontInfo.description, fontInfo.size);
+                        d->add_font(sources[0], fontInfo->description, fontInfo->size);
                     if (fontKeyOpt.has_value())
                     {
                         _font = fontKeyOpt.value();
-                        fontInfo = d->fonts.at(_font);
-                        fontFace = fontInfo.fontFace;
+                        fontInfo = &d->fonts.at(_font);
+                        fontFace = fontInfo->fontFace.Get();
                     }
                 }
                 continue;
@@ -432,7 +477,7 @@ void directwrite_shaper::shape(font_key _font,
                                                       &glyphProps.at(0),
                                                       actualGlyphCount,
                                                       fontFace,
-                                                      fontInfo.size.pt,
+                                                      fontInfo->size.pt,
                                                       0, // isSideways,
                                                       0, // isRightToLeft
                                                       &analysisWrapper.script,
@@ -446,7 +491,7 @@ void directwrite_shaper::shape(font_key _font,
         for (size_t i = glyphStart; i < actualGlyphCount; i++)
         {
             glyph_position gpos {};
-            gpos.glyph = glyph_key { fontInfo.size, _font, glyph_index { glyphIndices.at(i) } };
+            gpos.glyph = glyph_key { fontInfo->size, _font, glyph_index { glyphIndices.at(i) } };
             gpos.offset.x = static_cast<int>(glyphOffsets.at(i).advanceOffset);
             // gpos.offset.y = static_cast<int>(static_cast<double>(pos[i].y_offset) / 64.0f);
 
@@ -460,7 +505,7 @@ void directwrite_shaper::shape(font_key _font,
 std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph, render_mode _mode)
 {
     DxFontInfo const& fontInfo = d->fonts.at(_glyph.font);
-    IDWriteFontFace5* fontFace = fontInfo.fontFace;
+    IDWriteFontFace5* fontFace = fontInfo.fontFace.Get();
     float const fontEmSize = ptToEm(_glyph.size.pt);
 
     UINT16 const glyphIndex = static_cast<UINT16>(_glyph.index.value);
@@ -477,19 +522,7 @@ std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph,
     glyphRun.isSideways = false;
     glyphRun.bidiLevel = 0;
 
-    ComPtr<IDWriteRenderingParams> renderingParams;
-    d->factory->CreateRenderingParams(&renderingParams);
-
-    DWRITE_RENDERING_MODE renderingMode;
-    auto hr = fontFace->GetRecommendedRenderingMode(fontEmSize,
-                                                    d->pixelPerDip(),
-                                                    DWRITE_MEASURING_MODE::DWRITE_MEASURING_MODE_NATURAL,
-                                                    renderingParams.Get(),
-                                                    &renderingMode);
-    if (FAILED(hr))
-    {
-        renderingMode = DWRITE_RENDERING_MODE_NATURAL_SYMMETRIC;
-    }
+    auto const renderingMode = fontInfo.renderingMode;
 
     ComPtr<IDWriteGlyphRunAnalysis> glyphAnalysis;
     rasterized_glyph output {};
@@ -513,11 +546,10 @@ std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph,
 
     auto const [width, height] = output.bitmapSize;
 
-    IDWriteFactory2* factory2;
-    IDWriteColorGlyphRunEnumerator* glyphRunEnumerator;
-    if (SUCCEEDED(d->factory->QueryInterface(IID_PPV_ARGS(&factory2))))
+    ComPtr<IDWriteColorGlyphRunEnumerator> glyphRunEnumerator;
+    if (d->factory2)
     {
-        hr = factory2->TranslateColorGlyphRun(0.0f,
+        auto hr = d->factory2->TranslateColorGlyphRun(0.0f,
                                               0.0f,
                                               &glyphRun,
                                               nullptr,
@@ -533,7 +565,8 @@ std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph,
 
             auto t = output.bitmap.begin();
 
-            renderGlyphRunToBitmap(glyphAnalysis.Get(), textureBounds, DWRITE_COLOR_F {}, output.format, t);
+            renderGlyphRunToBitmap(
+                glyphAnalysis.Get(), textureBounds, DWRITE_COLOR_F {}, output.format, d->alphaTexture, t);
 
             return output;
         }
@@ -570,7 +603,8 @@ std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph,
 
                 auto t = output.bitmap.begin();
                 auto const color = colorRun->paletteIndex == 0xFFFF ? DWRITE_COLOR_F {} : colorRun->runColor;
-                renderGlyphRunToBitmap(colorGlyphsAnalysis.Get(), textureBounds, color, output.format, t);
+                renderGlyphRunToBitmap(
+                    colorGlyphsAnalysis.Get(), textureBounds, color, output.format, d->alphaTexture, t);
             }
 
             return output;
@@ -593,7 +627,10 @@ void directwrite_shaper::set_locator(std::unique_ptr<font_locator> _locator)
 
 void directwrite_shaper::clear_cache()
 {
-    // TODO: clear the cache
+    d->fontPathAndSizeToKeyMapping.clear();
+    d->fonts.clear();
+    d->fontsHasColor.clear();
+    // The created font faces are kept, as they do not depend on the font size nor the DPI.
 }
 
 optional<glyph_position> directwrite_shaper::shape(font_key _font, char32_t _codepoint)
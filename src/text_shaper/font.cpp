@@ -15,6 +15,8 @@
 
 #include <fmt/format.h>
 
+#include <cstdlib>
+
 using std::string;
 using std::string_view;
 
@@ -48,4 +50,18 @@ font_description font_description::parse(string_view _pattern)
     return fd;
 }
 
+string cache_file_path(string_view _programName, string_view _fileName)
+{
+#if defined(_WIN32)
+    if (auto const* value = getenv("LOCALAPPDATA"); value && *value)
+        return fmt::format("{}\\{}\\{}", value, _programName, _fileName);
+#else
+    if (auto const* value = getenv("XDG_CACHE_HOME"); value && *value)
+        return fmt::format("{}/{}/{}", value, _programName, _fileName);
+    if (auto const* value = getenv("HOME"); value && *value)
+        return fmt::format("{}/.cache/{}/{}", value, _programName, _fileName);
+#endif
+    return {};
+}
+
 } // namespace text
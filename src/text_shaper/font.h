@@ -282,6 +282,10 @@ enum class render_mode
     color   //!< embedded color bitmaps are preferred
 };
 
+/// Returns the path of the given file in the given program's per-user cache directory,
+/// or an empty string if no such directory is known.
+std::string cache_file_path(std::string_view _programName, std::string_view _fileName);
+
 } // namespace text
 
 // {{{ std::hash<>
@@ -0,0 +1,135 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <text_shaper/font_chain_cache.h>
+
+#include <fmt/format.h>
+
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+    #include <direct.h>
+#endif
+
+#include <fstream>
+
+using std::lock_guard;
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::string_view;
+
+namespace text
+{
+
+namespace
+{
+    /// Builds the key a font description's resolved font chain is cached by.
+    string chainCacheKey(font_description const& _fd)
+    {
+        return fmt::format("{}:{}:{}:{}:{}",
+                           _fd.familyName,
+                           static_cast<int>(_fd.weight),
+                           static_cast<int>(_fd.slant),
+                           static_cast<int>(_fd.spacing),
+                           _fd.strict_spacing ? 1 : 0);
+    }
+} // namespace
+
+font_chain_cache::font_chain_cache(string_view _magic, string _filePath, int64_t _stamp):
+    magic_ { _magic }, filePath_ { std::move(_filePath) }, stamp_ { _stamp }
+{
+    load();
+}
+
+optional<font_source_list> font_chain_cache::find(font_description const& _fd) const
+{
+    auto const _l = lock_guard { mutex_ };
+    if (auto const i = chains_.find(chainCacheKey(_fd)); i != chains_.end())
+        return i->second;
+    return nullopt;
+}
+
+void font_chain_cache::store(font_description const& _fd, font_source_list _chain)
+{
+    auto const _l = lock_guard { mutex_ };
+    chains_[chainCacheKey(_fd)] = std::move(_chain);
+    save();
+}
+
+void font_chain_cache::clear(int64_t _stamp)
+{
+    auto const _l = lock_guard { mutex_ };
+    LocatorLog()("Clearing {} cached font chains.", chains_.size());
+    chains_.clear();
+    stamp_ = _stamp;
+    save();
+}
+
+size_t font_chain_cache::size() const
+{
+    auto const _l = lock_guard { mutex_ };
+    return chains_.size();
+}
+
+void font_chain_cache::load()
+{
+    if (filePath_.empty())
+        return;
+
+    auto file = std::ifstream(filePath_);
+    auto line = string {};
+    if (!std::getline(file, line) || line != fmt::format("{} {}", magic_, stamp_))
+        return; // missing or outdated
+
+    font_source_list* chain = nullptr;
+    while (std::getline(file, line))
+    {
+        if (line.empty())
+            continue;
+        if (line[0] == '@')
+            chain = &chains_[line.substr(1)];
+        else if (chain)
+            chain->emplace_back(font_path { line });
+    }
+    LocatorLog()("Loaded {} cached font chains from {}", chains_.size(), filePath_);
+}
+
+void font_chain_cache::save()
+{
+    if (filePath_.empty())
+        return;
+
+    auto const parentEnd = filePath_.find_last_of("/\\");
+    if (parentEnd != string::npos)
+    {
+        // Best effort creation of the parent directory (one level, e.g. ~/.cache/contour).
+#if defined(_WIN32)
+        (void) _mkdir(filePath_.substr(0, parentEnd).c_str());
+#else
+        (void) mkdir(filePath_.substr(0, parentEnd).c_str(), 0700);
+#endif
+    }
+
+    auto file = std::ofstream(filePath_, std::ios::trunc);
+    file << magic_ << ' ' << stamp_ << '\n';
+    for (auto const& [key, chain]: chains_)
+    {
+        file << '@' << key << '\n';
+        for (font_source const& source: chain)
+            if (auto const* path = std::get_if<font_path>(&source))
+                file << path->value << '\n';
+    }
+}
+
+} // namespace text
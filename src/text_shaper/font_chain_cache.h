@@ -0,0 +1,71 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <text_shaper/font.h>
+#include <text_shaper/font_locator.h>
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace text
+{
+
+/**
+ * Font chains resolved by a font locator, keyed by font description, and
+ * persisted in an (optional) cache file across process restarts.
+ *
+ * The cache file is only valid for the stamp it was written with, which the
+ * font locator derives from whatever changes when fonts are (un)installed.
+ * Chains are written through immediately, so that other windows created
+ * meanwhile can reuse them, too.
+ */
+class font_chain_cache
+{
+  public:
+    /// @param _magic    identifies the locator (and format version) that wrote the cache file.
+    /// @param _filePath path to the cache file, or empty to not persist the chains.
+    /// @param _stamp    the cache file's contents are discarded unless written with this stamp.
+    font_chain_cache(std::string_view _magic, std::string _filePath, int64_t _stamp);
+
+    font_chain_cache(font_chain_cache const&) = delete;
+    font_chain_cache& operator=(font_chain_cache const&) = delete;
+
+    [[nodiscard]] std::optional<font_source_list> find(font_description const& _fd) const;
+
+    void store(font_description const& _fd, font_source_list _chain);
+
+    /// Drops all chains (including the persisted ones), e.g. after fonts got (un)installed,
+    /// and continues with the given stamp.
+    void clear(int64_t _stamp);
+
+    [[nodiscard]] size_t size() const;
+
+  private:
+    void load();
+    void save();
+
+    std::string magic_;
+    std::string filePath_;
+    int64_t stamp_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, font_source_list> chains_;
+};
+
+} // namespace text
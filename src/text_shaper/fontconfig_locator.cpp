@@ -12,12 +12,16 @@
  * limitations under the License.
  */
 #include <text_shaper/font.h>
+#include <text_shaper/font_chain_cache.h>
 #include <text_shaper/fontconfig_locator.h>
 
 #include <range/v3/view/iota.hpp>
 
 #include <fontconfig/fontconfig.h>
 
+#include <sys/stat.h>
+
+#include <algorithm>
 #include <string_view>
 
 using std::nullopt;
@@ -116,17 +120,41 @@ namespace
         }
     }
 
+    // First line of the font chain cache file, followed by the fontconfig cache stamp.
+    constexpr auto CacheFileMagic = "contour-fontconfig-chains 1"sv;
+
+    /// Returns the newest modification time of fontconfig's cache directories,
+    /// which changes whenever fontconfig (re)scans installed fonts.
+    int64_t fcCacheStamp(FcConfig* _config)
+    {
+        auto stamp = int64_t { 0 };
+        FcStrList* cacheDirs = FcConfigGetCacheDirs(_config);
+        if (!cacheDirs)
+            return stamp;
+
+        while (FcChar8 const* dir = FcStrListNext(cacheDirs))
+        {
+            struct stat st = {};
+            if (stat((char const*) dir, &st) == 0)
+                stamp = std::max(stamp, static_cast<int64_t>(st.st_mtime));
+        }
+        FcStrListDone(cacheDirs);
+        return stamp;
+    }
+
 } // namespace
 
 struct fontconfig_locator::Private
 {
-    // currently empty, maybe later something (such as caching)?
     FcConfig* ftConfig = nullptr;
+    bool fontsLoaded = false;
 
-    Private()
+    // Only load the configuration here, the (potentially many) fonts are
+    // loaded lazily once a font chain actually needs to be resolved.
+    explicit Private(string _cacheFilePath):
+        ftConfig { FcInitLoadConfig() },
+        chains { CacheFileMagic, std::move(_cacheFilePath), fcCacheStamp(ftConfig) }
     {
-        FcInit();
-        ftConfig = FcInitLoadConfigAndFonts(); // Most convenient of all the alternatives
     }
 
     ~Private()
@@ -135,10 +163,21 @@ struct fontconfig_locator::Private
         FcConfigDestroy(ftConfig);
         FcFini();
     }
+
+    void ensureFontsLoaded()
+    {
+        if (fontsLoaded)
+            return;
+        fontsLoaded = true;
+        FcConfigBuildFonts(ftConfig);
+    }
+
+    // Resolved font chains, persisted in the cache file.
+    font_chain_cache chains;
 };
 
-fontconfig_locator::fontconfig_locator():
-    d { new Private(), [](Private* p) {
+fontconfig_locator::fontconfig_locator(string _cacheFilePath):
+    d { new Private(std::move(_cacheFilePath)), [](Private* p) {
            delete p;
        } }
 {
@@ -150,6 +189,22 @@ fontconfig_locator::~fontconfig_locator()
 
 font_source_list fontconfig_locator::locate(font_description const& _fd)
 {
+    if (auto chain = d->chains.find(_fd))
+    {
+        LocatorLog()("Using cached font chain for: {}", _fd);
+        return std::move(*chain);
+    }
+
+    auto output = locateUncached(_fd);
+    if (!output.empty())
+        d->chains.store(_fd, output);
+    return output;
+}
+
+font_source_list fontconfig_locator::locateUncached(font_description const& _fd)
+{
+    d->ensureFontsLoaded();
+
     LocatorLog()("Locating font chain for: {}", _fd);
     auto pat =
         unique_ptr<FcPattern, void (*)(FcPattern*)>(FcPatternCreate(), [](auto p) { FcPatternDestroy(p); });
@@ -285,6 +340,8 @@ font_source_list fontconfig_locator::locate(font_description const& _fd)
 
 font_source_list fontconfig_locator::all()
 {
+    d->ensureFontsLoaded();
+
     FcPattern* pat = FcPatternCreate();
     FcObjectSet* os = FcObjectSetBuild(
 #if defined(FC_COLOR)
@@ -17,6 +17,8 @@
 #include <text_shaper/font.h>
 #include <text_shaper/font_locator.h>
 
+#include <string>
+
 namespace text
 {
 
@@ -25,12 +27,17 @@ namespace text
  *
  * This should be available on all platforms.
  *
+ * Fonts are only loaded into fontconfig once a font chain needs to be resolved,
+ * and resolved font chains are persisted in the optionally given cache file,
+ * so that subsequent starts can skip font matching entirely as long as
+ * fontconfig's caches did not change.
+ *
  * @note on Windows, fontconfig still can NOT find user installed fonts.
  */
 class fontconfig_locator: public font_locator
 {
   public:
-    fontconfig_locator();
+    explicit fontconfig_locator(std::string _cacheFilePath = {});
     ~fontconfig_locator() override;
 
     font_source_list locate(font_description const& description) override;
@@ -38,6 +45,8 @@ class fontconfig_locator: public font_locator
     font_source_list resolve(gsl::span<const char32_t> codepoints) override;
 
   private:
+    font_source_list locateUncached(font_description const& description);
+
     struct Private;
     std::unique_ptr<Private, void (*)(Private*)> d;
 };
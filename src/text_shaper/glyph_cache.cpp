@@ -0,0 +1,353 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <text_shaper/glyph_cache.h>
+
+#include <crispy/stdfs.h>
+
+#include <fmt/format.h>
+
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::string_view;
+
+namespace text
+{
+
+namespace
+{
+    // File layout: header, followed by a sequence of records (RecordHeader + bitmap).
+    constexpr char FileMagic[8] = { 'C', 'G', 'L', 'Y', 'P', 'H', 'S', '2' };
+
+    // Upper bound of the cache file's size. Beyond, the least recently used glyphs are evicted,
+    // down to a size leaving room for a while, so that evicting is not needed again right away.
+    constexpr size_t MaxFileSize = 64 * 1024 * 1024;
+    constexpr size_t CompactedFileSize = MaxFileSize / 4 * 3;
+
+    // Glyphs not used for as many days are dropped when writing the file.
+    constexpr uint32_t MaxUnusedDays = 60;
+
+    struct RecordHeader
+    {
+        uint64_t key;
+        uint32_t width;
+        uint32_t height;
+        int32_t x;
+        int32_t y;
+        uint32_t format;
+        uint32_t bitmapSize;
+        uint32_t lastUsed; // days since the epoch
+        uint32_t reserved;
+    };
+
+    RecordHeader recordHeaderAt(std::vector<uint8_t> const& _records, size_t _offset) noexcept
+    {
+        RecordHeader header {};
+        std::memcpy(&header, _records.data() + _offset, sizeof(header));
+        return header;
+    }
+
+    uint32_t daysSinceEpoch() noexcept
+    {
+        using namespace std::chrono;
+        auto const hoursSinceEpoch = duration_cast<hours>(system_clock::now().time_since_epoch());
+        return static_cast<uint32_t>(hoursSinceEpoch.count() / 24);
+    }
+
+    constexpr uint64_t FNV64Basis = 14695981039346656037llu;
+    constexpr uint64_t FNV64Prime = 1099511628211llu;
+
+    constexpr uint64_t fnv64(uint64_t _memory, void const* _data, size_t _size) noexcept
+    {
+        auto const bytes = static_cast<uint8_t const*>(_data);
+        for (size_t i = 0; i < _size; ++i)
+        {
+            _memory ^= bytes[i];
+            _memory *= FNV64Prime;
+        }
+        return _memory;
+    }
+
+    template <typename T>
+    uint64_t fnv64(uint64_t _memory, T const& _value) noexcept
+    {
+        return fnv64(_memory, &_value, sizeof(_value));
+    }
+
+    int getProcessId() noexcept
+    {
+#if defined(_WIN32)
+        return _getpid();
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+} // namespace
+
+glyph_cache::glyph_cache(string _filePath): filePath_ { std::move(_filePath) }, today_ { daysSinceEpoch() }
+{
+    load();
+}
+
+glyph_cache::~glyph_cache()
+{
+    flush();
+}
+
+std::shared_ptr<glyph_cache> glyph_cache::shared(string const& _filePath)
+{
+    static auto instancesLock = std::mutex {};
+    static auto instances = std::unordered_map<string, std::weak_ptr<glyph_cache>> {};
+
+    auto const _l = std::lock_guard { instancesLock };
+    auto& instance = instances[_filePath];
+    if (auto cache = instance.lock())
+        return cache;
+
+    auto cache = std::make_shared<glyph_cache>(_filePath);
+    instance = cache;
+    return cache;
+}
+
+string glyph_cache::default_path(string_view _programName)
+{
+    return cache_file_path(_programName, "glyphs.cache");
+}
+
+uint64_t glyph_cache::fingerprint(string_view _fontIdentifier)
+{
+    auto hash = fnv64(FNV64Basis, _fontIdentifier.data(), _fontIdentifier.size());
+
+    struct stat st = {};
+    if (stat(string(_fontIdentifier).c_str(), &st) == 0)
+    {
+        hash = fnv64(hash, static_cast<uint64_t>(st.st_size));
+        hash = fnv64(hash, static_cast<int64_t>(st.st_mtime));
+    }
+
+    return hash;
+}
+
+uint64_t glyph_cache::make_key(
+    uint64_t _fontFingerprint, font_size _size, DPI _dpi, render_mode _mode, glyph_index _glyph) noexcept
+{
+    auto hash = fnv64(FNV64Basis, _fontFingerprint);
+    hash = fnv64(hash, _size.pt);
+    hash = fnv64(hash, _dpi.x);
+    hash = fnv64(hash, _dpi.y);
+    hash = fnv64(hash, static_cast<uint32_t>(_mode));
+    hash = fnv64(hash, _glyph.value);
+    return hash;
+}
+
+void glyph_cache::load()
+{
+    if (filePath_.empty())
+        return;
+
+    auto file = std::ifstream(filePath_, std::ios::binary);
+    if (!file.good())
+        return;
+
+    char magic[sizeof(FileMagic)] {};
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, FileMagic, sizeof(FileMagic)) != 0)
+        return; // Unknown or outdated file format. It will be recreated upon the next flush.
+
+    records_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    auto const fileRecordsSize = records_.size();
+
+    // Index all complete records; a truncated tail (e.g. after a crash) is dropped.
+    size_t offset = 0;
+    while (offset + sizeof(RecordHeader) <= records_.size())
+    {
+        auto const header = recordHeaderAt(records_, offset);
+        if (offset + sizeof(RecordHeader) + header.bitmapSize > records_.size())
+            break;
+        index_[header.key] = offset;
+        offset += sizeof(RecordHeader) + header.bitmapSize;
+    }
+    records_.resize(offset);
+
+    // Rewrite the file upon the next flush if its tail got dropped.
+    modified_ = offset != fileRecordsSize;
+}
+
+void glyph_cache::compact(size_t _maxSize, uint32_t _minLastUsed)
+{
+    struct Entry
+    {
+        size_t offset;
+        size_t size;
+        uint32_t lastUsed;
+    };
+
+    auto entries = std::vector<Entry> {};
+    entries.reserve(index_.size());
+    for (auto const& [_, offset]: index_)
+    {
+        auto const header = recordHeaderAt(records_, offset);
+        if (header.lastUsed >= _minLastUsed)
+            entries.push_back(Entry { offset, sizeof(RecordHeader) + header.bitmapSize, header.lastUsed });
+    }
+
+    // Of records last used on the same day, the ones rasterized most recently are kept.
+    std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) {
+        return a.lastUsed > b.lastUsed || (a.lastUsed == b.lastUsed && a.offset > b.offset);
+    });
+    auto totalSize = size_t { 0 };
+    auto kept = size_t { 0 };
+    while (kept < entries.size() && totalSize + entries[kept].size <= _maxSize)
+        totalSize += entries[kept++].size;
+    entries.resize(kept);
+
+    // Records keep their order, which is the order they have been rasterized in.
+    std::sort(
+        entries.begin(), entries.end(), [](Entry const& a, Entry const& b) { return a.offset < b.offset; });
+    auto records = std::vector<uint8_t> {};
+    records.reserve(totalSize);
+    index_.clear();
+    for (Entry const& entry: entries)
+    {
+        index_[recordHeaderAt(records_, entry.offset).key] = records.size();
+        records.insert(records.end(),
+                       records_.begin() + static_cast<ptrdiff_t>(entry.offset),
+                       records_.begin() + static_cast<ptrdiff_t>(entry.offset + entry.size));
+    }
+
+    modified_ = modified_ || records.size() != records_.size();
+    records_ = std::move(records);
+}
+
+size_t glyph_cache::size() const
+{
+    auto const _l = std::lock_guard { lock_ };
+    return index_.size();
+}
+
+optional<rasterized_glyph> glyph_cache::get(uint64_t _key)
+{
+    auto const _l = std::lock_guard { lock_ };
+    auto const i = index_.find(_key);
+    if (i == index_.end())
+        return nullopt;
+
+    auto* record = records_.data() + i->second;
+
+    auto header = recordHeaderAt(records_, i->second);
+    if (header.lastUsed != today_)
+    {
+        header.lastUsed = today_;
+        std::memcpy(record, &header, sizeof(header));
+        modified_ = true;
+    }
+
+    auto glyph = rasterized_glyph {};
+    glyph.bitmapSize = crispy::ImageSize { crispy::Width(header.width), crispy::Height(header.height) };
+    glyph.position = crispy::Point { header.x, header.y };
+    glyph.format = static_cast<bitmap_format>(header.format);
+    glyph.bitmap.assign(record + sizeof(header), record + sizeof(header) + header.bitmapSize);
+    if (!glyph.valid())
+        return nullopt;
+
+    return glyph;
+}
+
+void glyph_cache::put(uint64_t _key, rasterized_glyph const& _glyph)
+{
+    auto const _l = std::lock_guard { lock_ };
+    if (filePath_.empty() || index_.count(_key))
+        return;
+
+    auto const recordSize = sizeof(RecordHeader) + _glyph.bitmap.size();
+    if (recordSize > CompactedFileSize)
+        return;
+    if (records_.size() + recordSize > MaxFileSize)
+        compact(CompactedFileSize - recordSize, 0);
+
+    auto const header = RecordHeader { _key,
+                                       unbox<uint32_t>(_glyph.bitmapSize.width),
+                                       unbox<uint32_t>(_glyph.bitmapSize.height),
+                                       static_cast<int32_t>(_glyph.position.x),
+                                       static_cast<int32_t>(_glyph.position.y),
+                                       static_cast<uint32_t>(_glyph.format),
+                                       static_cast<uint32_t>(_glyph.bitmap.size()),
+                                       today_,
+                                       0 };
+
+    auto const offset = records_.size();
+    auto const headerBytes = reinterpret_cast<uint8_t const*>(&header);
+    records_.insert(records_.end(), headerBytes, headerBytes + sizeof(header));
+    records_.insert(records_.end(), _glyph.bitmap.begin(), _glyph.bitmap.end());
+    index_[_key] = offset;
+    modified_ = true;
+}
+
+void glyph_cache::flush()
+{
+    auto const _l = std::lock_guard { lock_ };
+    if (filePath_.empty() || !modified_)
+        return;
+
+    // Records of previous runs may have been left behind by font files or sizes no longer in use.
+    compact(MaxFileSize, today_ > MaxUnusedDays ? today_ - MaxUnusedDays : 0);
+
+    auto const filePath = FileSystem::path(filePath_);
+    auto ec = FileSystemError {};
+    if (filePath.has_parent_path())
+        FileSystem::create_directories(filePath.parent_path(), ec);
+
+    // The whole file is written anew and then renamed over the old one, so that neither a crash
+    // nor another process flushing at the same time leaves a corrupt cache file behind.
+    auto const tempFilePath = FileSystem::path(fmt::format("{}.{}.tmp", filePath_, getProcessId()));
+    {
+        auto file = std::ofstream(tempFilePath.string(), std::ios::binary | std::ios::trunc);
+        file.write(FileMagic, sizeof(FileMagic));
+        file.write(reinterpret_cast<char const*>(records_.data()),
+                   static_cast<std::streamsize>(records_.size()));
+        file.close();
+        if (!file)
+        {
+            FileSystem::remove(tempFilePath, ec);
+            return;
+        }
+    }
+
+    FileSystem::rename(tempFilePath, filePath, ec);
+    if (ec)
+    {
+        FileSystem::remove(tempFilePath, ec);
+        return;
+    }
+
+    modified_ = false;
+}
+
+} // namespace text
@@ -0,0 +1,104 @@
+/**
+ * This file is part of the "libterminal" project
+ *   Copyright (c) 2021 Christian Parpart <christian@parpart.family>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <text_shaper/font.h>
+#include <text_shaper/shaper.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace text
+{
+
+/**
+ * On-disk cache of rasterized glyphs that persists across process restarts.
+ *
+ * The cache file is read once when opened and written anew when flushed, if glyphs have been
+ * rasterized since (at the latest upon destruction), so that glyphs rasterized by a previous run
+ * need not be rasterized again.
+ *
+ * Entries are identified by a key that is built from the font file's identity
+ * (path, size, and modification time), the font size, DPI, render mode and glyph index.
+ *
+ * Entries record the day they were last used on. Those not used for a long time (e.g. of
+ * replaced font files, or font sizes no longer used) are dropped when the file is written,
+ * and the least recently used ones are evicted whenever the cache outgrows its size limit.
+ *
+ * All member functions are thread-safe, as the cache is shared by the render threads of all windows.
+ */
+class glyph_cache
+{
+  public:
+    /// Opens (or creates) the glyph cache at the given file path.
+    explicit glyph_cache(std::string _filePath);
+    ~glyph_cache();
+
+    glyph_cache(glyph_cache const&) = delete;
+    glyph_cache& operator=(glyph_cache const&) = delete;
+
+    /// Returns the process-wide glyph cache for the given file path, opening it if not yet open.
+    ///
+    /// This way all shapers (i.e. all windows) of a process share the glyphs any of them rasterized.
+    static std::shared_ptr<glyph_cache> shared(std::string const& _filePath);
+
+    /// Returns the platform specific default location of the glyph cache file of the given program.
+    static std::string default_path(std::string_view _programName);
+
+    /// Builds a fingerprint of the given font source, that changes whenever the font file changes.
+    static uint64_t fingerprint(std::string_view _fontIdentifier);
+
+    /// Builds the cache key for a glyph of a font (identified by its fingerprint).
+    static uint64_t make_key(
+        uint64_t _fontFingerprint, font_size _size, DPI _dpi, render_mode _mode, glyph_index _glyph) noexcept;
+
+    [[nodiscard]] std::optional<rasterized_glyph> get(uint64_t _key);
+
+    void put(uint64_t _key, rasterized_glyph const& _glyph);
+
+    /// Writes the cache file, if glyphs have been added or used since the last flush.
+    ///
+    /// The file is replaced atomically, creating its parent directories as needed.
+    void flush();
+
+    [[nodiscard]] size_t size() const;
+
+  private:
+    void load();
+
+    /// Keeps the most recently used records that fit into @p _maxSize bytes,
+    /// of those used on day @p _minLastUsed or later.
+    void compact(size_t _maxSize, uint32_t _minLastUsed);
+
+    std::string filePath_;
+    uint32_t today_; // days since the epoch, which records are stamped with when used
+
+    // Guards all of the below.
+    mutable std::mutex lock_;
+
+    // Serialized records of the file contents, followed by records not yet written to disk.
+    std::vector<uint8_t> records_;
+    bool modified_ = false; // whether records_ differs from the file's contents
+
+    // Maps from glyph key to the offset of its record in records_.
+    std::unordered_map<uint64_t, size_t> index_;
+};
+
+} // namespace text
@@ -13,6 +13,7 @@
  */
 #include <text_shaper/font.h>
 #include <text_shaper/font_locator.h>
+#include <text_shaper/glyph_cache.h>
 #include <text_shaper/open_shaper.h>
 
 #include <crispy/algorithm.h>
@@ -31,11 +32,13 @@
 #include FT_ERRORS_H
 #include FT_FREETYPE_H
 #include FT_LCD_FILTER_H
+#include FT_SIZES_H
 // clang-format on
 
 #include <fontconfig/fontconfig.h>
 
 #include <harfbuzz/hb-ft.h>
+#include <harfbuzz/hb-ot.h>
 #include <harfbuzz/hb.h>
 
 #include <algorithm>
@@ -108,7 +111,8 @@ namespace text
 
 using HbBufferPtr = unique_ptr<hb_buffer_t, void (*)(hb_buffer_t*)>;
 using HbFontPtr = unique_ptr<hb_font_t, void (*)(hb_font_t*)>;
-using FtFacePtr = unique_ptr<FT_FaceRec_, void (*)(FT_FaceRec_*)>;
+using FtFacePtr = std::shared_ptr<FT_FaceRec_>;
+using FtSizePtr = unique_ptr<FT_SizeRec_, void (*)(FT_SizeRec_*)>;
 
 auto constexpr MissingGlyphId = 0xFFFDu;
 
@@ -117,10 +121,21 @@ struct HbFontInfo
     font_source primary;
     font_source_list fallbacks;
     font_size size;
-    FtFacePtr ftFace;
+    FtFacePtr ftFace; // shared by all sizes of the same font source
+    FtSizePtr ftSize; // must be activated on ftFace before anything size dependent
     HbFontPtr hbFont;
     std::optional<font_metrics> metrics {};
     font_description description {};
+    std::optional<uint64_t> glyphCacheFingerprint {}; // lazily computed identity of the font file
+
+    // Memoizes, per codepoint, the first fallback font whose character map covers it
+    // (or std::nullopt if none does).
+    std::unordered_map<char32_t, std::optional<font_key>> fallbackCoverage {};
+
+    // Shaped glyphs of printable US-ASCII (U+20..U+7E), used to bypass harfbuzz for pure ASCII text,
+    // or empty if the font is missing any of them or its active features may substitute or position them.
+    bool asciiGlyphsProbed = false;
+    std::vector<glyph_position> asciiGlyphs {};
 };
 
 namespace
@@ -151,6 +166,49 @@ namespace
         return _gp.glyph.index.value == 0;
     }
 
+    /// Tests whether the given codepoint does not need to be covered by a font's character map
+    /// for the text to be shapeable (joiners, variation selectors and tags).
+    constexpr bool isDefaultIgnorable(char32_t _codepoint) noexcept
+    {
+        return _codepoint == 0x200C || _codepoint == 0x200D || (0xFE00 <= _codepoint && _codepoint <= 0xFE0F)
+               || (0xE0000 <= _codepoint && _codepoint <= 0xE0FFF);
+    }
+
+    constexpr char32_t FirstPrintableAscii = 0x20;
+    constexpr char32_t LastPrintableAscii = 0x7E;
+
+    bool isPrintableAscii(u32string_view _codepoints) noexcept
+    {
+        for (char32_t const codepoint: _codepoints)
+            if (codepoint < FirstPrintableAscii || codepoint > LastPrintableAscii)
+                return false;
+        return true;
+    }
+
+    /// Tests whether any lookup of the given features in the given layout table (GSUB or GPOS)
+    /// takes any of the given glyphs as input.
+    bool lookupsAffectGlyphs(hb_face_t* _face,
+                             hb_tag_t _tableTag,
+                             vector<hb_tag_t> const& _features,
+                             hb_set_t* _glyphs)
+    {
+        hb_set_t* lookups = hb_set_create();
+        hb_set_t* inputGlyphs = hb_set_create();
+
+        hb_ot_layout_collect_lookups(_face, _tableTag, nullptr, nullptr, _features.data(), lookups);
+        hb_codepoint_t lookupIndex = HB_SET_VALUE_INVALID;
+        while (hb_set_next(lookups, &lookupIndex))
+            hb_ot_layout_lookup_collect_glyphs(
+                _face, _tableTag, lookupIndex, nullptr, inputGlyphs, nullptr, nullptr);
+
+        hb_set_intersect(inputGlyphs, _glyphs);
+        bool const affected = !hb_set_is_empty(inputGlyphs);
+
+        hb_set_destroy(inputGlyphs);
+        hb_set_destroy(lookups);
+        return affected;
+    }
+
     constexpr int ftRenderFlag(render_mode _mode) noexcept
     {
         switch (_mode)
@@ -231,12 +289,13 @@ namespace
         return best;
     }
 
-    optional<FtFacePtr> loadFace(font_source const& _source, font_size _fontSize, DPI _dpi, FT_Library _ft)
+    optional<FtFacePtr> openFace(font_source const& _source, FT_Library _ft)
     {
         FT_Face ftFace = nullptr;
 
         if (holds_alternative<font_path>(_source))
         {
+            // FreeType memory-maps the file where the platform supports it.
             auto const& sourcePath = get<font_path>(_source);
             FT_Error ec = FT_New_Face(_ft, sourcePath.value.c_str(), 0, &ftFace);
             if (!ftFace)
@@ -268,12 +327,27 @@ namespace
         if (FT_Error const ec = FT_Select_Charmap(ftFace, FT_ENCODING_UNICODE); ec != FT_Err_Ok)
             errorlog()("FT_Select_Charmap failed. Ignoring; {}", ftErrorStr(ec));
 
-        if (FT_HAS_COLOR(ftFace))
+        return FtFacePtr(ftFace, [](FT_Face p) { FT_Done_Face(p); });
+    }
+
+    /// Creates a new size object on the given face, and leaves it activated.
+    optional<FtSizePtr> createSize(FT_Face _ftFace, font_source const& _source, font_size _fontSize, DPI _dpi)
+    {
+        FT_Size ftSize = nullptr;
+        if (FT_Error const ec = FT_New_Size(_ftFace, &ftSize); ec != FT_Err_Ok)
+        {
+            errorlog()("Failed to FT_New_Size(source {}): {}", _source, ftErrorStr(ec));
+            return nullopt;
+        }
+        auto sizePtr = FtSizePtr(ftSize, [](FT_Size p) { FT_Done_Size(p); });
+        FT_Activate_Size(ftSize);
+
+        if (FT_HAS_COLOR(_ftFace))
         {
             auto const strikeIndex =
-                ftBestStrikeIndex(ftFace, int(_fontSize.pt)); // TODO: should be font width (not height)
+                ftBestStrikeIndex(_ftFace, int(_fontSize.pt)); // TODO: should be font width (not height)
 
-            FT_Error const ec = FT_Select_Size(ftFace, strikeIndex);
+            FT_Error const ec = FT_Select_Size(_ftFace, strikeIndex);
             if (ec != FT_Err_Ok)
                 errorlog()("Failed to FT_Select_Size(index={}, source {}): {}",
                            strikeIndex,
@@ -285,7 +359,7 @@ namespace
             auto const size = static_cast<FT_F26Dot6>(ceil(_fontSize.pt * 64.0));
 
             if (FT_Error const ec = FT_Set_Char_Size(
-                    ftFace, 0, size, static_cast<FT_UInt>(_dpi.x), static_cast<FT_UInt>(_dpi.y));
+                    _ftFace, 0, size, static_cast<FT_UInt>(_dpi.x), static_cast<FT_UInt>(_dpi.y));
                 ec != FT_Err_Ok)
             {
                 errorlog()("Failed to FT_Set_Char_Size(size={}, dpi {}, source {}): {}\n",
@@ -300,7 +374,14 @@ namespace
             }
         }
 
-        return optional<FtFacePtr> { FtFacePtr(ftFace, [](FT_Face p) { FT_Done_Face(p); }) };
+        return sizePtr;
+    }
+
+    /// Activates the given font's size on its (shared) face and returns that face.
+    FT_Face activate(HbFontInfo const& _fontInfo) noexcept
+    {
+        FT_Activate_Size(_fontInfo.ftSize.get());
+        return _fontInfo.ftFace.get();
     }
 
     void replaceMissingGlyphs(FT_Face _ftFace, shape_result& _result)
@@ -344,6 +425,7 @@ namespace
         assert(_hbFont != nullptr);
         assert(_hbBuf != nullptr);
 
+        activate(_fontInfo);
         prepareBuffer(_hbBuf, _codepoints, _clusters, _script);
 
         vector<hb_feature_t> hbFeatures;
@@ -397,6 +479,10 @@ struct open_shaper::Private // {{{
     unordered_map<FontPathAndSize, font_key> fontPathAndSizeToKeyMapping;
     unordered_map<font_key, HbFontInfo> fontKeyToHbFontInfoMapping; // from font_key to FontInfo struct
 
+    // Opened font faces by source identifier, shared by all sizes (and DPIs) of a font source,
+    // so that changing the font size does not re-open and re-parse the font files.
+    unordered_map<string, FtFacePtr> sourceToFtFaceMapping;
+
     // Blacklisted font files as we tried them already and failed.
     std::vector<std::string> blacklistedSources;
 
@@ -404,6 +490,7 @@ struct open_shaper::Private // {{{
     // (file_path, file_mtime, font_weight, font_slant, pixel_size)
 
     unordered_map<glyph_key, rasterized_glyph> glyphs_;
+    std::shared_ptr<glyph_cache> glyphCache_;
     HbBufferPtr hb_buf_;
     font_key nextFontKey_;
 
@@ -429,18 +516,25 @@ struct open_shaper::Private // {{{
         if (ranges::any_of(blacklistedSources, [&](auto const& a) { return a == sourceId; }))
             return nullopt;
 
-        auto ftFacePtrOpt = loadFace(source, _fontSize, dpi_, ft_);
-        if (!ftFacePtrOpt.has_value())
+        auto ftFacePtr = getOrOpenFace(source, sourceId);
+        if (!ftFacePtr)
+            return nullopt;
+
+        auto ftSizePtrOpt = createSize(ftFacePtr.get(), source, _fontSize, dpi_);
+        if (!ftSizePtrOpt.has_value())
         {
             blacklistedSources.emplace_back(sourceId);
+            sourceToFtFaceMapping.erase(sourceId);
             return nullopt;
         }
 
-        auto ftFacePtr = move(ftFacePtrOpt.value());
+        // The harfbuzz font takes over the scale of the face's size that is currently activated.
         auto hbFontPtr =
             HbFontPtr(hb_ft_font_create_referenced(ftFacePtr.get()), [](auto p) { hb_font_destroy(p); });
 
-        auto fontInfo = HbFontInfo { source, {}, _fontSize, move(ftFacePtr), move(hbFontPtr) };
+        auto fontInfo = HbFontInfo {
+            source, {}, _fontSize, move(ftFacePtr), move(ftSizePtrOpt.value()), move(hbFontPtr)
+        };
 
         auto key = create_font_key();
         fontPathAndSizeToKeyMapping.emplace(pair { FontPathAndSize { sourceId, _fontSize }, key });
@@ -454,10 +548,26 @@ struct open_shaper::Private // {{{
         return key;
     }
 
+    FtFacePtr getOrOpenFace(font_source const& _source, string const& _sourceId)
+    {
+        if (auto i = sourceToFtFaceMapping.find(_sourceId); i != sourceToFtFaceMapping.end())
+            return i->second;
+
+        auto ftFacePtrOpt = openFace(_source, ft_);
+        if (!ftFacePtrOpt.has_value())
+        {
+            blacklistedSources.emplace_back(_sourceId);
+            return nullptr;
+        }
+
+        sourceToFtFaceMapping.emplace(_sourceId, ftFacePtrOpt.value());
+        return move(ftFacePtrOpt.value());
+    }
+
     font_metrics metrics(font_key _key)
     {
         Require(fontKeyToHbFontInfoMapping.count(_key) == 1);
-        auto ftFace = fontKeyToHbFontInfoMapping.at(_key).ftFace.get();
+        auto ftFace = activate(fontKeyToHbFontInfoMapping.at(_key));
 
         font_metrics output {};
 
@@ -492,6 +602,124 @@ struct open_shaper::Private // {{{
 #endif
     }
 
+    /// Returns the shaped glyphs of printable US-ASCII for the given font,
+    /// or nullptr if text in this font must be shaped by harfbuzz.
+    ///
+    /// This is probed only once per font.
+    vector<glyph_position> const* asciiGlyphsOf(font_key _font, HbFontInfo& _fontInfo)
+    {
+        if (!_fontInfo.asciiGlyphsProbed)
+        {
+            _fontInfo.asciiGlyphsProbed = true;
+            _fontInfo.asciiGlyphs = createAsciiGlyphs(_font, _fontInfo);
+            TextShapingLog()("ASCII shaping bypass for font key {}: {}",
+                             _font,
+                             _fontInfo.asciiGlyphs.empty() ? "disabled" : "enabled");
+        }
+        return _fontInfo.asciiGlyphs.empty() ? nullptr : &_fontInfo.asciiGlyphs;
+    }
+
+    vector<glyph_position> createAsciiGlyphs(font_key _font, HbFontInfo& _fontInfo)
+    {
+        auto glyphs = vector<glyph_position> {};
+        hb_set_t* glyphSet = hb_set_create();
+        for (char32_t codepoint = FirstPrintableAscii; codepoint <= LastPrintableAscii; ++codepoint)
+        {
+            auto const glyphIndex = FT_Get_Char_Index(_fontInfo.ftFace.get(), codepoint);
+            if (!glyphIndex)
+                break;
+            hb_set_add(glyphSet, glyphIndex);
+
+            glyph_position gpos {};
+            gpos.glyph = glyph_key { _fontInfo.size, _font, glyph_index { glyphIndex } };
+#if defined(GLYPH_KEY_DEBUG)
+            gpos.glyph.text = std::u32string(1, codepoint);
+#endif
+            auto const advance = hb_font_get_glyph_h_advance(_fontInfo.hbFont.get(), glyphIndex);
+            gpos.advance.x = static_cast<int>(static_cast<double>(advance) / 64.0f);
+            glyphs.emplace_back(gpos);
+        }
+
+        // Features that harfbuzz (or the user) enables that could alter a run of plain ASCII glyphs.
+        auto features = vector<hb_tag_t> {
+            HB_TAG('c', 'a', 'l', 't'), HB_TAG('c', 'l', 'i', 'g'), HB_TAG('l', 'i', 'g', 'a'),
+            HB_TAG('r', 'l', 'i', 'g'), HB_TAG('k', 'e', 'r', 'n'), HB_TAG('d', 'i', 's', 't'),
+        };
+        for (font_feature const feature: _fontInfo.description.features)
+            features.emplace_back(HB_TAG(feature.name[0], feature.name[1], feature.name[2], feature.name[3]));
+        features.emplace_back(HB_TAG_NONE);
+
+        hb_face_t* hbFace = hb_font_get_face(_fontInfo.hbFont.get());
+        auto const complete = glyphs.size() == LastPrintableAscii - FirstPrintableAscii + 1;
+        if (!complete || lookupsAffectGlyphs(hbFace, HB_OT_TAG_GSUB, features, glyphSet)
+            || lookupsAffectGlyphs(hbFace, HB_OT_TAG_GPOS, features, glyphSet))
+            glyphs.clear();
+
+        hb_set_destroy(glyphSet);
+        return glyphs;
+    }
+
+    /// Tests whether the given fallback font may be used in place of the primary font.
+    bool isAcceptableFallback(HbFontInfo const& _fontInfo, font_key _fallback) const
+    {
+        // Skip if main font is monospace but fallbacks font is not.
+        if (!_fontInfo.description.strict_spacing
+            || _fontInfo.description.spacing == font_spacing::proportional)
+            return true;
+
+        Require(fontKeyToHbFontInfoMapping.count(_fallback) == 1);
+        HbFontInfo const& fallbackFontInfo = fontKeyToHbFontInfoMapping.at(_fallback);
+        return (fallbackFontInfo.ftFace->face_flags & FT_FACE_FLAG_FIXED_WIDTH) != 0;
+    }
+
+    /// Returns the first fallback font of the given font whose character map covers the codepoint.
+    ///
+    /// The result is memoized per font, so that the fallback chain is walked only once per codepoint.
+    optional<font_key> fallbackFontFor(HbFontInfo& _fontInfo, char32_t _codepoint)
+    {
+        if (auto i = _fontInfo.fallbackCoverage.find(_codepoint); i != _fontInfo.fallbackCoverage.end())
+            return i->second;
+
+        auto result = optional<font_key> {};
+        for (font_source const& fallbackFont: _fontInfo.fallbacks)
+        {
+            optional<font_key> fallbackKeyOpt = getOrCreateKeyForFont(fallbackFont, _fontInfo.size);
+            if (!fallbackKeyOpt.has_value() || !isAcceptableFallback(_fontInfo, fallbackKeyOpt.value()))
+                continue;
+
+            FT_Face const ftFace = fontKeyToHbFontInfoMapping.at(fallbackKeyOpt.value()).ftFace.get();
+            if (FT_Get_Char_Index(ftFace, _codepoint) != 0)
+            {
+                result = fallbackKeyOpt;
+                break;
+            }
+        }
+
+        _fontInfo.fallbackCoverage.emplace(_codepoint, result);
+        return result;
+    }
+
+    /// Returns the fallback font that covers all (non-ignorable) codepoints of the given text,
+    /// or std::nullopt if no single fallback font is known to do so.
+    optional<font_key> findCoveringFallback(HbFontInfo& _fontInfo, u32string_view _codepoints)
+    {
+        auto const first = std::find_if(
+            _codepoints.begin(), _codepoints.end(), [](char32_t c) { return !isDefaultIgnorable(c); });
+        if (first == _codepoints.end())
+            return nullopt;
+
+        optional<font_key> const keyOpt = fallbackFontFor(_fontInfo, *first);
+        if (!keyOpt.has_value())
+            return nullopt;
+
+        FT_Face const ftFace = fontKeyToHbFontInfoMapping.at(keyOpt.value()).ftFace.get();
+        for (char32_t const codepoint: _codepoints)
+            if (!isDefaultIgnorable(codepoint) && FT_Get_Char_Index(ftFace, codepoint) == 0)
+                return nullopt;
+
+        return keyOpt;
+    }
+
     bool tryShapeWithFallback(font_key _font,
                               HbFontInfo& _fontInfo,
                               hb_buffer_t* _hbBuf,
@@ -508,24 +736,37 @@ struct open_shaper::Private // {{{
                 _font, _fontInfo, _hbBuf, _hbFont, _script, _presentation, _codepoints, _clusters, _result))
             return true;
 
+        // Go straight to the fallback font whose character map covers the text, if any.
+        optional<font_key> const coveringKeyOpt = findCoveringFallback(_fontInfo, _codepoints);
+        if (coveringKeyOpt.has_value())
+        {
+            _result.resize(initialResultOffset); // rollback to initial size
+            HbFontInfo& coveringFontInfo = fontKeyToHbFontInfoMapping.at(coveringKeyOpt.value());
+            TextShapingLog()("Try covering fallback font key:{}, source: {}",
+                             coveringKeyOpt.value(),
+                             coveringFontInfo.primary);
+            if (tryShape(coveringKeyOpt.value(),
+                         coveringFontInfo,
+                         _hbBuf,
+                         coveringFontInfo.hbFont.get(),
+                         _script,
+                         _presentation,
+                         _codepoints,
+                         _clusters,
+                         _result))
+                return true;
+        }
+
         for (font_source const& fallbackFont: _fontInfo.fallbacks)
         {
             _result.resize(initialResultOffset); // rollback to initial size
 
             optional<font_key> fallbackKeyOpt = getOrCreateKeyForFont(fallbackFont, _fontInfo.size);
-            if (!fallbackKeyOpt.has_value())
+            if (!fallbackKeyOpt.has_value() || fallbackKeyOpt == coveringKeyOpt)
                 continue;
 
-            // Skip if main font is monospace but fallbacks font is not.
-            if (_fontInfo.description.strict_spacing
-                && _fontInfo.description.spacing != font_spacing::proportional)
-            {
-                Require(fontKeyToHbFontInfoMapping.count(fallbackKeyOpt.value()) == 1);
-                HbFontInfo const& fallbackFontInfo = fontKeyToHbFontInfoMapping.at(fallbackKeyOpt.value());
-                bool const fontIsMonospace = fallbackFontInfo.ftFace->face_flags & FT_FACE_FLAG_FIXED_WIDTH;
-                if (!fontIsMonospace)
-                    continue;
-            }
+            if (!isAcceptableFallback(_fontInfo, fallbackKeyOpt.value()))
+                continue;
 
             Require(fontKeyToHbFontInfoMapping.count(fallbackKeyOpt.value()) == 1);
             HbFontInfo& fallbackFontInfo = fontKeyToHbFontInfoMapping.at(fallbackKeyOpt.value());
@@ -575,6 +816,7 @@ void open_shaper::clear_cache()
                  d->fontKeyToHbFontInfoMapping.size());
     d->fontPathAndSizeToKeyMapping.clear();
     d->fontKeyToHbFontInfoMapping.clear();
+    // The opened faces are kept, as they do not depend on the font size nor the DPI.
 }
 
 optional<font_key> open_shaper::load_font(font_description const& _description, font_size _size)
@@ -616,16 +858,10 @@ optional<glyph_position> open_shaper::shape(font_key _font, char32_t _codepoint)
     glyph_index glyphIndex { FT_Get_Char_Index(fontInfo.ftFace.get(), _codepoint) };
     if (!glyphIndex.value)
     {
-        for (font_source const& fallbackFont: fontInfo.fallbacks)
+        if (optional<font_key> const fallbackKeyOpt = d->fallbackFontFor(fontInfo, _codepoint))
         {
-            optional<font_key> fallbackKeyOpt = d->getOrCreateKeyForFont(fallbackFont, fontInfo.size);
-            if (!fallbackKeyOpt.has_value())
-                continue;
-            Require(d->fontKeyToHbFontInfoMapping.count(fallbackKeyOpt.value()) == 1);
             HbFontInfo const& fallbackFontInfo = d->fontKeyToHbFontInfoMapping.at(fallbackKeyOpt.value());
             glyphIndex = glyph_index { FT_Get_Char_Index(fallbackFontInfo.ftFace.get(), _codepoint) };
-            if (glyphIndex.value)
-                break;
         }
     }
     if (!glyphIndex.value)
@@ -657,9 +893,26 @@ void open_shaper::shape(font_key _font,
 
     Require(d->fontKeyToHbFontInfoMapping.count(_font) == 1);
     HbFontInfo& fontInfo = d->fontKeyToHbFontInfoMapping.at(_font);
+    activate(fontInfo);
     hb_font_t* hbFont = fontInfo.hbFont.get();
     hb_buffer_t* hbBuf = d->hb_buf_.get();
 
+    // Fast path: plain ASCII text in a font without any ligatures or kerning for it
+    // maps one codepoint to one precomputed glyph.
+    if (isPrintableAscii(_codepoints))
+    {
+        if (auto const* asciiGlyphs = d->asciiGlyphsOf(_font, fontInfo))
+        {
+            for (char32_t const codepoint: _codepoints)
+            {
+                glyph_position gpos = (*asciiGlyphs)[codepoint - FirstPrintableAscii];
+                gpos.presentation = _presentation;
+                _result.emplace_back(move(gpos));
+            }
+            return;
+        }
+    }
+
     if (TextShapingLog)
     {
         auto logMessage = TextShapingLog();
@@ -715,10 +968,44 @@ void open_shaper::shape(font_key _font,
     replaceMissingGlyphs(fontInfo.ftFace.get(), _result);
 }
 
+void open_shaper::set_glyph_cache(string _filePath)
+{
+    if (_filePath.empty())
+        d->glyphCache_.reset();
+    else
+    {
+        d->glyphCache_ = glyph_cache::shared(_filePath);
+        LocatorLog()("Using glyph cache with {} glyphs.", d->glyphCache_->size());
+    }
+}
+
 optional<rasterized_glyph> open_shaper::rasterize(glyph_key _glyph, render_mode _mode)
+{
+    if (!d->glyphCache_)
+        return rasterize_uncached(_glyph, _mode);
+
+    auto& fontInfo = d->fontKeyToHbFontInfoMapping.at(_glyph.font);
+    if (!fontInfo.glyphCacheFingerprint)
+        fontInfo.glyphCacheFingerprint = glyph_cache::fingerprint(identifierOf(fontInfo.primary));
+
+    auto const key =
+        glyph_cache::make_key(*fontInfo.glyphCacheFingerprint, fontInfo.size, d->dpi_, _mode, _glyph.index);
+    if (auto cached = d->glyphCache_->get(key))
+    {
+        cached->index = _glyph.index;
+        return cached;
+    }
+
+    auto output = rasterize_uncached(_glyph, _mode);
+    if (output)
+        d->glyphCache_->put(key, *output);
+    return output;
+}
+
+optional<rasterized_glyph> open_shaper::rasterize_uncached(glyph_key _glyph, render_mode _mode)
 {
     auto const font = _glyph.font;
-    auto ftFace = d->fontKeyToHbFontInfoMapping.at(font).ftFace.get();
+    auto ftFace = activate(d->fontKeyToHbFontInfoMapping.at(font));
     auto const glyphIndex = _glyph.index;
     auto const flags =
         static_cast<FT_Int32>(ftRenderFlag(_mode) | (FT_HAS_COLOR(ftFace) ? FT_LOAD_COLOR : 0));
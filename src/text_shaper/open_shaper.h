@@ -17,6 +17,7 @@
 #include <text_shaper/shaper.h>
 
 #include <memory>
+#include <string>
 
 namespace text
 {
@@ -53,7 +54,16 @@ class open_shaper: public shaper
 
     std::optional<rasterized_glyph> rasterize(glyph_key _glyph, render_mode _mode) override;
 
+    /// Enables persisting rasterized glyphs in the given cache file across restarts.
+    ///
+    /// The cache is shared with all other shapers in this process using the same file.
+    ///
+    /// An empty path disables the glyph cache.
+    void set_glyph_cache(std::string _filePath);
+
   private:
+    std::optional<rasterized_glyph> rasterize_uncached(glyph_key _glyph, render_mode _mode);
+
     struct Private;
     std::unique_ptr<Private, void (*)(Private*)> d;
 };
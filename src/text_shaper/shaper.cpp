@@ -18,11 +18,17 @@
 
 #include <range/v3/view/iota.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <utility>
 #include <vector>
 
+using std::clamp;
+using std::lround;
 using std::max;
 using std::min;
+using std::sqrt;
 using std::tuple;
 using std::vector;
 
@@ -53,33 +59,37 @@ tuple<rasterized_glyph, float> scale(rasterized_glyph const& _bitmap, crispy::Im
                     ratio,
                     factor);
 
+    // Box filter, first summing up the source rows of each destination row (which the compiler
+    // vectorizes), and then the columns of each destination pixel within that sum.
+    auto const sourceWidth = _bitmap.bitmapSize.width.as<unsigned>();
+    auto const sourceHeight = _bitmap.bitmapSize.height.as<unsigned>();
+    vector<unsigned> rowSum(sourceWidth * 4);
     uint8_t* d = dest.data();
     for (unsigned i = 0, sr = 0; i < *_newSize.height; i++, sr += factor)
     {
+        auto const rowCount = sr < sourceHeight ? min(factor, sourceHeight - sr) : 0;
+        std::fill(rowSum.begin(), rowSum.end(), 0u);
+        for (unsigned y = sr; y < sr + rowCount; y++)
+        {
+            uint8_t const* p = _bitmap.bitmap.data() + y * sourceWidth * 4;
+            for (unsigned x = 0; x < sourceWidth * 4; x++)
+                rowSum[x] += p[x];
+        }
+
         for (unsigned j = 0, sc = 0; j < *_newSize.width; j++, sc += factor, d += 4)
         {
-            // calculate area average
-            unsigned int r = 0, g = 0, b = 0, a = 0, count = 0;
-            for (unsigned y = sr; y < min(sr + factor, _bitmap.bitmapSize.height.as<unsigned>()); y++)
-            {
-                uint8_t const* p = _bitmap.bitmap.data() + (y * *_bitmap.bitmapSize.width * 4) + sc * 4;
-                for (unsigned x = sc; x < min(sc + factor, _bitmap.bitmapSize.width.as<unsigned>());
-                     x++, count++)
-                {
-                    b += *(p++);
-                    g += *(p++);
-                    r += *(p++);
-                    a += *(p++);
-                }
-            }
+            auto const columnCount = sc < sourceWidth ? min(factor, sourceWidth - sc) : 0;
+            auto const count = rowCount * columnCount;
+            if (!count)
+                continue;
 
-            if (count)
-            {
-                d[0] = static_cast<uint8_t>(b / count);
-                d[1] = static_cast<uint8_t>(g / count);
-                d[2] = static_cast<uint8_t>(r / count);
-                d[3] = static_cast<uint8_t>(a / count);
-            }
+            // calculate area average
+            unsigned sum[4] = { 0, 0, 0, 0 };
+            for (unsigned x = sc; x < sc + columnCount; x++)
+                for (unsigned c = 0; c < 4; c++)
+                    sum[c] += rowSum[x * 4 + c];
+            for (unsigned c = 0; c < 4; c++)
+                d[c] = static_cast<uint8_t>(sum[c] / count);
         }
     }
 
@@ -94,4 +104,148 @@ tuple<rasterized_glyph, float> scale(rasterized_glyph const& _bitmap, crispy::Im
     return { output, factor };
 }
 
+rasterized_glyph make_sdf(rasterized_glyph const& _glyph, int _spread)
+{
+    assert(_glyph.format == bitmap_format::alpha_mask);
+
+    // 8-point sequential signed Euclidean distance transform (8SSEDT), computing the offset to the
+    // nearest pixel of the other side, once for the outside and once for the inside pixels.
+    struct Offset
+    {
+        int dx;
+        int dy;
+        [[nodiscard]] int distanceSquared() const noexcept { return dx * dx + dy * dy; }
+    };
+    auto constexpr Far = Offset { 0x3FFF, 0x3FFF };
+
+    auto const glyphWidth = unbox<int>(_glyph.bitmapSize.width);
+    auto const glyphHeight = unbox<int>(_glyph.bitmapSize.height);
+    auto const width = glyphWidth + 2 * _spread;
+    auto const height = glyphHeight + 2 * _spread;
+
+    auto const inside = [&](int x, int y) {
+        x -= _spread;
+        y -= _spread;
+        return 0 <= x && x < glyphWidth && 0 <= y && y < glyphHeight
+               && _glyph.bitmap[static_cast<size_t>(y * glyphWidth + x)] >= 0x80;
+    };
+
+    auto const transform = [&](bool insidePixels) {
+        auto grid = vector<Offset>(static_cast<size_t>(width * height));
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                grid[static_cast<size_t>(y * width + x)] = inside(x, y) == insidePixels ? Offset {} : Far;
+
+        auto const compare = [&](int x, int y, int ox, int oy) {
+            auto const nx = x + ox;
+            auto const ny = y + oy;
+            auto other = 0 <= nx && nx < width && 0 <= ny && ny < height
+                             ? grid[static_cast<size_t>(ny * width + nx)]
+                             : Far;
+            other.dx += ox;
+            other.dy += oy;
+            auto& current = grid[static_cast<size_t>(y * width + x)];
+            if (other.distanceSquared() < current.distanceSquared())
+                current = other;
+        };
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                compare(x, y, -1, 0);
+                compare(x, y, 0, -1);
+                compare(x, y, -1, -1);
+                compare(x, y, 1, -1);
+            }
+            for (int x = width - 1; x >= 0; --x)
+                compare(x, y, 1, 0);
+        }
+        for (int y = height - 1; y >= 0; --y)
+        {
+            for (int x = width - 1; x >= 0; --x)
+            {
+                compare(x, y, 1, 0);
+                compare(x, y, 0, 1);
+                compare(x, y, -1, 1);
+                compare(x, y, 1, 1);
+            }
+            for (int x = 0; x < width; ++x)
+                compare(x, y, -1, 0);
+        }
+        return grid;
+    };
+
+    // Distances to the nearest inside pixel (for outside pixels) and vice versa.
+    auto const toInside = transform(true);
+    auto const toOutside = transform(false);
+
+    auto output = rasterized_glyph {};
+    output.index = _glyph.index;
+    output.format = bitmap_format::alpha_mask;
+    output.bitmapSize =
+        crispy::ImageSize { crispy::Width::cast_from(width), crispy::Height::cast_from(height) };
+    output.position = crispy::Point { _glyph.position.x - _spread, _glyph.position.y + _spread };
+    output.bitmap.resize(static_cast<size_t>(width * height));
+    for (size_t i = 0; i < output.bitmap.size(); ++i)
+    {
+        auto const distance = sqrt(static_cast<double>(toOutside[i].distanceSquared()))
+                              - sqrt(static_cast<double>(toInside[i].distanceSquared()));
+        auto const value = clamp(0.5 + distance / (2.0 * _spread), 0.0, 1.0);
+        output.bitmap[i] = static_cast<uint8_t>(lround(value * 255.0));
+    }
+    return output;
+}
+
+rasterized_glyph scale_sdf(rasterized_glyph const& _sdf, int _spread, double _factor, int _targetSpread)
+{
+    assert(_sdf.format == bitmap_format::alpha_mask);
+
+    auto const sourceWidth = unbox<int>(_sdf.bitmapSize.width);
+    auto const sourceHeight = unbox<int>(_sdf.bitmapSize.height);
+    auto const coreWidth = max(1, static_cast<int>(lround((sourceWidth - 2 * _spread) * _factor)));
+    auto const coreHeight = max(1, static_cast<int>(lround((sourceHeight - 2 * _spread) * _factor)));
+    auto const width = coreWidth + 2 * _targetSpread;
+    auto const height = coreHeight + 2 * _targetSpread;
+
+    // Bilinearly samples the source's distance at the given source pixel coordinates.
+    auto const sample = [&](double x, double y) {
+        auto const x0 = clamp(static_cast<int>(std::floor(x)), 0, sourceWidth - 1);
+        auto const y0 = clamp(static_cast<int>(std::floor(y)), 0, sourceHeight - 1);
+        auto const x1 = min(x0 + 1, sourceWidth - 1);
+        auto const y1 = min(y0 + 1, sourceHeight - 1);
+        auto const fx = clamp(x - x0, 0.0, 1.0);
+        auto const fy = clamp(y - y0, 0.0, 1.0);
+        auto const at = [&](int sx, int sy) {
+            return static_cast<double>(_sdf.bitmap[static_cast<size_t>(sy * sourceWidth + sx)]) / 255.0;
+        };
+        auto const top = at(x0, y0) * (1.0 - fx) + at(x1, y0) * fx;
+        auto const bottom = at(x0, y1) * (1.0 - fx) + at(x1, y1) * fx;
+        return ((top * (1.0 - fy) + bottom * fy) - 0.5) * 2.0 * _spread; // in source pixels
+    };
+
+    auto output = rasterized_glyph {};
+    output.index = _sdf.index;
+    output.format = bitmap_format::alpha_mask;
+    output.bitmapSize =
+        crispy::ImageSize { crispy::Width::cast_from(width), crispy::Height::cast_from(height) };
+    output.position =
+        crispy::Point { static_cast<int>(lround((_sdf.position.x + _spread) * _factor)) - _targetSpread,
+                        static_cast<int>(lround((_sdf.position.y - _spread) * _factor)) + _targetSpread };
+    output.bitmap.resize(static_cast<size_t>(width * height));
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            // Maps the target pixel's center into the source, relative to both bitmaps' padding.
+            auto const sx = (x - _targetSpread + 0.5) / _factor - 0.5 + _spread;
+            auto const sy = (y - _targetSpread + 0.5) / _factor - 0.5 + _spread;
+            auto const distance = sample(sx, sy) * _factor; // in target pixels
+            auto const value = clamp(0.5 + distance / (2.0 * _targetSpread), 0.0, 1.0);
+            output.bitmap[static_cast<size_t>(y * width + x)] = static_cast<uint8_t>(lround(value * 255.0));
+        }
+    }
+    return output;
+}
+
 } // namespace text
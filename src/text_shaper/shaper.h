@@ -79,6 +79,17 @@ struct rasterized_glyph
 
 std::tuple<rasterized_glyph, float> scale(rasterized_glyph const& _bitmap, crispy::ImageSize _newSize);
 
+/// Computes the signed distance field of an alpha mask glyph, padded by @p _spread pixels on each side.
+///
+/// Each pixel encodes the distance of its center to the glyph's outline, mapping the range
+/// [-_spread, +_spread] (outside to inside) onto [0, 255], so that the outline is at 128.
+rasterized_glyph make_sdf(rasterized_glyph const& _glyph, int _spread);
+
+/// Resamples a signed distance field made by make_sdf() with the given @p _spread by @p _factor.
+///
+/// The result is padded by @p _targetSpread pixels, and encodes its distances relative to that.
+rasterized_glyph scale_sdf(rasterized_glyph const& _sdf, int _spread, double _factor, int _targetSpread);
+
 struct glyph_position
 {
     glyph_key glyph;